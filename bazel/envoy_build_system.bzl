@@ -261,6 +261,40 @@ def envoy_cc_test_library(name,
         linkstatic = 1,
     )
 
+# Envoy C++ benchmark binaries (google benchmark) should be specified with this function. These
+# link against //test/benchmark:main, which provides the benchmark runner entry point.
+def envoy_cc_benchmark_binary(name,
+                              srcs = [],
+                              data = [],
+                              external_deps = [],
+                              deps = [],
+                              repository = ""):
+    native.cc_binary(
+        name = name,
+        srcs = srcs,
+        data = data,
+        copts = envoy_copts(repository, test = True),
+        linkopts = envoy_test_linkopts(),
+        linkstatic = 1,
+        testonly = 1,
+        malloc = tcmalloc_external_dep(repository),
+        deps = deps + [envoy_external_dep_path(dep) for dep in external_deps] + [
+            repository + "//test/benchmark:main",
+            envoy_external_dep_path("benchmark"),
+        ],
+    )
+
+# Runs a benchmark binary built with envoy_cc_benchmark_binary() as a test with a minimal
+# iteration budget. This does not measure anything; it exists so that benchmarks keep compiling
+# and running as the code they exercise changes.
+def envoy_benchmark_test(name, benchmark_binary, data = [], repository = ""):
+    native.sh_test(
+        name = name,
+        srcs = [repository + "//bazel:test_for_benchmark_wrapper.sh"],
+        data = [":" + benchmark_binary] + data,
+        args = ["%s/%s" % (PACKAGE_NAME, benchmark_binary)],
+    )
+
 # Envoy Python test binaries should be specified with this function.
 def envoy_py_test_binary(name,
                          external_deps = [],
@@ -235,6 +235,7 @@ def envoy_dependencies(path = "@envoy_deps//", skip_targets = []):
     _com_github_fmtlib_fmt()
     _com_github_gabime_spdlog()
     _com_github_gcovr_gcovr()
+    _com_github_google_benchmark()
     _com_github_lightstep_lightstep_tracer_cpp()
     _com_github_nodejs_http_parser()
     _com_github_tencent_rapidjson()
@@ -309,6 +310,13 @@ def _com_github_gcovr_gcovr():
         actual = "@com_github_gcovr_gcovr//:gcovr",
     )
 
+def _com_github_google_benchmark():
+    _repository_impl("com_github_google_benchmark")
+    native.bind(
+        name = "benchmark",
+        actual = "@com_github_google_benchmark//:benchmark",
+    )
+
 def _com_github_lightstep_lightstep_tracer_cpp():
     location = REPOSITORY_LOCATIONS[
         "com_github_lightstep_lightstep_tracer_cpp"]
@@ -29,6 +29,10 @@ REPOSITORY_LOCATIONS = dict(
         commit = "c0d77201039c7b119b18bc7fb991564c602dd75d",
         remote = "https://github.com/gcovr/gcovr",
     ),
+    com_github_google_benchmark = dict(
+        commit = "505be96ab23056580a3a2315abba048f4428b04e",
+        remote = "https://github.com/google/benchmark",
+    ),
     com_github_lightstep_lightstep_tracer_cpp = dict(
         sha256 = "f7477e67eca65f904c0b90a6bfec46d58cccfc998a8e75bc3259b6e93157ff84",
         strip_prefix = "lightstep-tracer-cpp-0.36",
@@ -3,6 +3,7 @@
 # ci/build_container/build_recipes.
 TARGET_RECIPES = {
     "ares": "cares",
+    "brotli": "brotli",
     "event": "libevent",
     "event_pthreads": "libevent",
     "tcmalloc_and_profiler": "gperftools",
@@ -11,4 +12,5 @@ TARGET_RECIPES = {
     "ssl": "boringssl",
     "yaml_cpp": "yaml-cpp",
     "zlib": "zlib",
+    "zstd": "zstd",
 }
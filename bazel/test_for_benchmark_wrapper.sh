@@ -0,0 +1,5 @@
+#!/bin/bash
+
+# Set the benchmark time to 0 to just verify that the benchmark runs to completion. We're interested
+# in catching bit rot here, not in measuring anything.
+"${TEST_SRCDIR}/${TEST_WORKSPACE}/$1" --benchmark_min_time=0
@@ -169,6 +169,13 @@ public:
    * Get the downstream address.
    */
   virtual const std::string& getDownstreamAddress() const PURE;
+
+  /**
+   * @return const std::string& the time spent in each HTTP filter when filter timing is enabled,
+   *         or else empty. Filters are listed in filter chain order, decoder filters first, as
+   *         comma separated <d|e><index>:<callback microseconds>:<held microseconds>.
+   */
+  virtual const std::string& filterTimings() const PURE;
 };
 
 /**
@@ -217,6 +224,15 @@ public:
   virtual std::string format(const Http::HeaderMap& request_headers,
                              const Http::HeaderMap& response_headers,
                              const RequestInfo& request_info) const PURE;
+
+  /**
+   * Append the formatted output to a string, without building intermediate strings. This allows
+   * a log line to be built in a buffer which is reused across requests.
+   * @param output supplies the string to append to.
+   */
+  virtual void formatInto(const Http::HeaderMap& request_headers,
+                          const Http::HeaderMap& response_headers,
+                          const RequestInfo& request_info, std::string& output) const PURE;
 };
 
 typedef std::unique_ptr<Formatter> FormatterPtr;
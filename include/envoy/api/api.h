@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -43,6 +44,24 @@ public:
    * @return file content.
    */
   virtual std::string fileReadToEnd(const std::string& path) PURE;
+
+  /**
+   * Run blocking or CPU heavy work on a small pool of threads shared by the process, so that it
+   * does not stall a dispatcher.
+   * @param work supplies the work to run on one of the pool's threads.
+   * @param dispatcher supplies the dispatcher to run on_complete on once work has run.
+   * @param on_complete supplies the callback to post to dispatcher once work has run. It may be
+   *        empty.
+   */
+  virtual void runOnThreadPool(std::function<void()> work, Event::Dispatcher& dispatcher,
+                               std::function<void()> on_complete) PURE;
+
+  /**
+   * Stop the thread pool. This waits for the work being run to complete, and drops the work which
+   * has not started yet. No completion is posted once this returns, so this must be called before
+   * the dispatchers that completions are posted to are destroyed.
+   */
+  virtual void shutdownThreadPool() PURE;
 };
 
 typedef std::unique_ptr<Api> ApiPtr;
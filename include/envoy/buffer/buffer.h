@@ -18,6 +18,62 @@ struct RawSlice {
   size_t len_ = 0;
 };
 
+/**
+ * A wrapper class to facilitate passing in externally owned data to a buffer via
+ * addBufferFragment(). When the buffer no longer needs the data passed in through a fragment, it
+ * calls done() on it.
+ */
+class BufferFragment {
+public:
+  /**
+   * @return const void* a pointer to the referenced data.
+   */
+  virtual const void* data() const PURE;
+
+  /**
+   * @return size_t the size of the referenced data.
+   */
+  virtual size_t size() const PURE;
+
+  /**
+   * Called by a buffer when the referenced data is no longer needed.
+   */
+  virtual void done() PURE;
+
+protected:
+  virtual ~BufferFragment() {}
+};
+
+/**
+ * Accounts for the bytes held by a group of buffers, such as those of the connections accepted by
+ * a listener. A buffer attached to an account charges it as it grows and credits it as it shrinks
+ * or is destroyed, so the balance is the number of bytes the group holds. Buffers may be charged
+ * and credited from any thread.
+ */
+class Account {
+public:
+  virtual ~Account() {}
+
+  /**
+   * Add bytes newly held by a buffer to the balance.
+   * @param bytes supplies the number of bytes.
+   */
+  virtual void charge(uint64_t bytes) PURE;
+
+  /**
+   * Remove bytes no longer held by a buffer from the balance.
+   * @param bytes supplies the number of bytes, which were previously charged.
+   */
+  virtual void credit(uint64_t bytes) PURE;
+
+  /**
+   * @return uint64_t the number of bytes currently held by the buffers attached to the account.
+   */
+  virtual uint64_t balance() const PURE;
+};
+
+typedef std::shared_ptr<Account> AccountSharedPtr;
+
 /**
  * A basic buffer abstraction.
  */
@@ -32,6 +88,15 @@ public:
    */
   virtual void add(const void* data, uint64_t size) PURE;
 
+  /**
+   * Add externally owned data into the buffer. No copying is done. fragment is not owned. When
+   * fragment.data() is no longer needed, fragment.done() is called. This happens at the latest once
+   * all of the data of the fragment has been drained, including from any buffers it was moved to,
+   * and may happen earlier if the buffer copies the data.
+   * @param fragment supplies the fragment, which must remain valid until done() is called on it.
+   */
+  virtual void addBufferFragment(BufferFragment& fragment) PURE;
+
   /**
    * Copy a string into the buffer.
    * @param data supplies the string to copy.
@@ -132,6 +197,13 @@ public:
    */
   virtual ssize_t search(const void* data, uint64_t size, size_t start) const PURE;
 
+  /**
+   * Attach the buffer to an account, which is charged with the bytes the buffer holds from then
+   * on. The bytes held are credited to the previous account, if any.
+   * @param account supplies the account, or nullptr to detach the buffer from its account.
+   */
+  virtual void setAccount(AccountSharedPtr account) PURE;
+
   /**
    * Write the buffer out to a file descriptor.
    * @param fd supplies the descriptor to write to.
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+
 #include "envoy/buffer/buffer.h"
 
 namespace Envoy {
@@ -18,7 +20,23 @@ public:
    * @param output_buffer supplies the buffer to output compressed data.
    */
   virtual void compress(const Buffer::Instance& input_buffer, Buffer::Instance& output_buffer) PURE;
+
+  /**
+   * Finish should be called once all the data of a stream has been compressed. It compresses any
+   * remaining input and writes the end of the stream to the output buffer. No more data can be
+   * compressed until reset() is called.
+   * @param output_buffer supplies the buffer to output compressed data.
+   */
+  virtual void finish(Buffer::Instance& output_buffer) PURE;
+
+  /**
+   * Reset prepares the compressor to compress a new stream with the same parameters. Any data which
+   * has not been finished is discarded. This is cheaper than creating a new compressor.
+   */
+  virtual void reset() PURE;
 };
 
+typedef std::unique_ptr<Compressor> CompressorPtr;
+
 } // namespace Compressor
 } // namespace Envoy
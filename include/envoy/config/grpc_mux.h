@@ -72,7 +72,8 @@ public:
   /**
    * Pause discovery requests for a given API type. This is useful when we're processing an update
    * for LDS or CDS and don't want a flood of updates for RDS or EDS respectively. Discovery
-   * requests may later be resumed with resume().
+   * requests may later be resumed with resume(). Pauses nest, so requests are only resumed once
+   * resume() has been called for each call to pause().
    * @param type_url type URL corresponding to xDS API, e.g.
    * type.googleapis.com/envoy.api.v2.Cluster.
    */
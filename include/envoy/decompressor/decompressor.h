@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+
 #include "envoy/buffer/buffer.h"
 
 namespace Envoy {
@@ -19,7 +21,21 @@ public:
    */
   virtual void decompress(const Buffer::Instance& input_buffer,
                           Buffer::Instance& output_buffer) PURE;
+
+  /**
+   * @return bool whether the input isn't a valid compressed stream. Once this is the case, no more
+   * input is decompressed.
+   */
+  virtual bool failed() const PURE;
+
+  /**
+   * @return bool whether the end of the compressed stream has been read. Any input after the end
+   * of the stream is ignored.
+   */
+  virtual bool finished() const PURE;
 };
 
+typedef std::unique_ptr<Decompressor> DecompressorPtr;
+
 } // namespace Decompressor
 } // namespace Envoy
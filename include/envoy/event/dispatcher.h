@@ -6,6 +6,7 @@
 #include <string>
 #include <vector>
 
+#include "envoy/common/time.h"
 #include "envoy/event/file_event.h"
 #include "envoy/event/signal.h"
 #include "envoy/event/timer.h"
@@ -116,12 +117,31 @@ public:
                     Network::ListenSocket& socket, Network::ListenerCallbacks& cb,
                     Stats::Scope& scope, const Network::ListenerOptions& listener_options) PURE;
 
+  /**
+   * Create a listener on a datagram socket.
+   * @param socket supplies the bound datagram socket to read from and write to.
+   * @param cb supplies the callbacks to invoke for received datagrams.
+   * @param scope supplies the Stats::Scope to use.
+   * @return Network::UdpListenerPtr a new listener that is owned by the caller.
+   */
+  virtual Network::UdpListenerPtr createUdpListener(Network::ListenSocket& socket,
+                                                    Network::UdpListenerCallbacks& cb,
+                                                    Stats::Scope& scope) PURE;
+
   /**
    * Allocate a timer. @see Event::Timer for docs on how to use the timer.
    * @param cb supplies the callback to invoke when the timer fires.
    */
   virtual TimerPtr createTimer(TimerCb cb) PURE;
 
+  /**
+   * Allocate a coarse timer. Coarse timers are cheaper to enable and disable than the timers
+   * returned by createTimer(), but may fire up to a tick (10ms) late. They are meant for timeouts
+   * which are frequently reset and rarely fire, such as idle and request timeouts.
+   * @param cb supplies the callback to invoke when the timer fires.
+   */
+  virtual TimerPtr createCoarseTimer(TimerCb cb) PURE;
+
   /**
    * Submit an item for deferred delete. @see DeferredDeletable.
    */
@@ -153,16 +173,41 @@ public:
    * or from a different thread.
    * @param type specifies whether to run in blocking mode (run() will not return until exit() is
    *              called) or non-blocking mode where only active events will be executed and then
-   *              run() will return.
+   *              run() will return. In blocking mode run() also returns when there are no events
+   *              left to wait for, unless RunUntilExit is used.
    */
-  enum class RunType { Block, NonBlock };
+  enum class RunType { Block, NonBlock, RunUntilExit };
   virtual void run(RunType type) PURE;
 
+  /**
+   * Record the duration, the poll delay and the number of events of each iteration of the event
+   * loop in histograms. This must be called before run().
+   * @param scope supplies the scope to create the histograms in.
+   * @param prefix supplies the prefix of the histogram names, e.g. "server.worker_0.".
+   */
+  virtual void initializeStats(Stats::Scope& scope, const std::string& prefix) PURE;
+
   /**
    * Returns a factory which connections may use for watermark buffer creation.
    * @return the watermark buffer factory for this dispatcher.
    */
   virtual Buffer::WatermarkFactory& getWatermarkFactory() PURE;
+
+  /**
+   * Returns the monotonic time, read once per event callback run by the dispatcher, for timings
+   * which don't need to be more precise than the event they are taken in (e.g. the duration of a
+   * request). Outside of the dispatcher's event callbacks this is the current time. This must be
+   * called from the dispatcher's thread.
+   * @return MonotonicTime the approximate monotonic time.
+   */
+  virtual MonotonicTime approximateMonotonicTime() PURE;
+
+  /**
+   * Returns the system time, read once per event callback run by the dispatcher. @see
+   * approximateMonotonicTime().
+   * @return SystemTime the approximate system time.
+   */
+  virtual SystemTime approximateSystemTime() PURE;
 };
 
 typedef std::unique_ptr<Dispatcher> DispatcherPtr;
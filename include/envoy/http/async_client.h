@@ -78,6 +78,18 @@ public:
      * Called when the async HTTP stream is reset.
      */
     virtual void onReset() PURE;
+
+    /**
+     * Called when the upstream of the async HTTP stream backs up, so that data sent with
+     * Stream.sendData() is being buffered rather than written.
+     */
+    virtual void onAboveWriteBufferHighWatermark() PURE;
+
+    /**
+     * Called when the upstream of the async HTTP stream has drained after
+     * onAboveWriteBufferHighWatermark().
+     */
+    virtual void onBelowWriteBufferLowWatermark() PURE;
   };
 
   /**
@@ -181,6 +181,9 @@ struct Http1Settings {
   // Enable codec to parse absolute uris. This enables forward/explicit proxy support for non TLS
   // traffic
   bool allow_absolute_url_{false};
+  // Parse complete bodyless request heads with a fast path parser where possible, falling back to
+  // http_parser for everything else.
+  bool fast_request_head_parsing_{false};
 };
 
 /**
@@ -192,6 +195,9 @@ struct Http2Settings {
   uint32_t max_concurrent_streams_{DEFAULT_MAX_CONCURRENT_STREAMS};
   uint32_t initial_stream_window_size_{DEFAULT_INITIAL_STREAM_WINDOW_SIZE};
   uint32_t initial_connection_window_size_{DEFAULT_INITIAL_CONNECTION_WINDOW_SIZE};
+  // start both windows at the HTTP/2 spec initial size and grow them up to the sizes above as the
+  // bandwidth-delay product measured on the connection requires
+  bool window_auto_tuning_{false};
 
   // disable HPACK compression
   static const uint32_t MIN_HPACK_TABLE_SIZE = 0;
@@ -311,7 +317,15 @@ public:
 /**
  * A server side HTTP connection.
  */
-class ServerConnection : public virtual Connection {};
+class ServerConnection : public virtual Connection {
+public:
+  /**
+   * @return bool whether the connection holds no state for a partially received or sent message,
+   *         so that it could be destroyed and a new one created in its place for the next message
+   *         without any difference to the remote.
+   */
+  virtual bool idle() PURE;
+};
 
 typedef std::unique_ptr<ServerConnection> ServerConnectionPtr;
 
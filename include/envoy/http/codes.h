@@ -1,5 +1,8 @@
 #pragma once
 
+#include "envoy/common/pure.h"
+#include "envoy/stats/stats.h"
+
 namespace Envoy {
 namespace Http {
 
@@ -53,6 +56,7 @@ enum class Code {
   UnprocessableEntity           = 422,
   Locked                        = 423,
   FailedDependency              = 424,
+  TooEarly                      = 425,
   UpgradeRequired               = 426,
   PreconditionRequired          = 428,
   TooManyRequests               = 429,
@@ -72,5 +76,34 @@ enum class Code {
   // clang-format on
 };
 
+/**
+ * The response code stats of an upstream, i.e. the upstream_rq_<code> and upstream_rq_<group>
+ * counters and their prefixed variants. Implementations resolve each counter once, so that
+ * charging a response doesn't have to build and look up its stat names.
+ */
+class CodeStats {
+public:
+  virtual ~CodeStats() {}
+
+  /**
+   * The variants of the response code counters, each being named with a prefix of its own.
+   */
+  enum class Prefix { None, Canary, Internal, External, Retry };
+
+  /**
+   * @param prefix supplies the variant of the counter.
+   * @param code supplies the response code.
+   * @return Stats::Counter& the counter of the response code, e.g. upstream_rq_503.
+   */
+  virtual Stats::Counter& codeCounter(Prefix prefix, Code code) PURE;
+
+  /**
+   * @param prefix supplies the variant of the counter.
+   * @param code supplies the response code.
+   * @return Stats::Counter& the counter of the group of the response code, e.g. upstream_rq_5xx.
+   */
+  virtual Stats::Counter& groupCounter(Prefix prefix, Code code) PURE;
+};
+
 } // namespace Http
 } // namespace Envoy
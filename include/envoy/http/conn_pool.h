@@ -105,6 +105,15 @@ public:
    *                      should be done by resetting the stream.
    */
   virtual Cancellable* newStream(Http::StreamDecoder& response_decoder, Callbacks& callbacks) PURE;
+
+  /**
+   * Create a new stream on the pool for a request without a body and with a safe method, such as
+   * GET or HEAD. An HTTP/1.1 pool may pipeline such a request behind others awaiting their
+   * response on a connection, rather than queue it for a connection of its own.
+   * @see newStream() for the parameters and the return value.
+   */
+  virtual Cancellable* newPipelinableStream(Http::StreamDecoder& response_decoder,
+                                            Callbacks& callbacks) PURE;
 };
 
 typedef std::unique_ptr<Instance> InstancePtr;
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -65,6 +67,11 @@ enum class ConnectionCloseType {
   NoFlush     // Do not flush any pending data and immediately raise ConnectionEvent::LocalClose
 };
 
+/**
+ * Callback invoked with the number of bytes moved each time data is spliced between connections.
+ */
+typedef std::function<void(uint64_t bytes)> SpliceCb;
+
 /**
  * An abstract raw connection. Free the connection or call close() to disconnect.
  */
@@ -79,6 +86,12 @@ public:
     Stats::Gauge& write_current_;
     // Counter* as this is an optional counter. Bind errors will not be tracked if this is nullptr.
     Stats::Counter* bind_errors_;
+    // Optional counter of read system calls. Together with read_total_ this gives the number of
+    // bytes read per system call.
+    Stats::Counter* read_syscalls_;
+    // Optional counter of write system calls. Together with write_total_ this gives the number of
+    // bytes written per system call.
+    Stats::Counter* write_syscalls_;
   };
 
   virtual ~Connection() {}
@@ -195,6 +208,19 @@ public:
    */
   virtual uint32_t bufferLimit() const PURE;
 
+  /**
+   * Attach the read and write buffers of the connection to an account, which is then charged with
+   * the bytes the connection holds.
+   * @param account supplies the account, or nullptr to detach the buffers from their account.
+   */
+  virtual void setBufferAccount(Buffer::AccountSharedPtr account) PURE;
+
+  /**
+   * @return const Buffer::AccountSharedPtr& the account set with setBufferAccount, if any. Filters
+   *         which hold data on behalf of the connection can charge it to the same account.
+   */
+  virtual const Buffer::AccountSharedPtr& bufferAccount() const PURE;
+
   /**
    * @return boolean telling if the connection's local address is an original destination address,
    * rather than the listener's address.
@@ -205,6 +231,21 @@ public:
    * @return boolean telling if the connection is currently above the high watermark.
    */
   virtual bool aboveHighWatermark() const PURE;
+
+  /**
+   * Move all data read from this connection from now on straight into the socket of peer with
+   * splice(2), without copying it through user space. The read filters of this connection and the
+   * write filters of peer are bypassed, so splicing only starts if the caller's filter is the only
+   * read filter of this connection, peer has no write filters, and neither connection uses a
+   * transport socket other than the raw buffer socket. Reads are disabled while the spliced data
+   * waiting to be written to peer fills the pipe between the connections, and enabled again once
+   * peer has written some of it. Once peer closes, data read from this connection goes through its
+   * read filters again.
+   * @param peer supplies the connection to move the data to.
+   * @param cb supplies the callback invoked with the number of bytes moved.
+   * @return bool whether splicing started. If it did not, neither connection has changed.
+   */
+  virtual bool spliceTo(Connection& peer, SpliceCb cb) PURE;
 };
 
 typedef std::unique_ptr<Connection> ConnectionPtr;
@@ -219,6 +260,17 @@ public:
    * registered via setConnectionEventCb().
    */
   virtual void connect() PURE;
+
+  /**
+   * Set an address to connect to should connecting to the remote address fail, or not complete
+   * within a delay. Both connects then race and the first to complete is kept, as happy eyeballs
+   * (RFC 8305) does for hosts with both IPv6 and IPv4 addresses. This must be called before
+   * connect().
+   * @param address supplies the fallback address.
+   * @param delay supplies the time after which the fallback connect starts.
+   */
+  virtual void setFallbackAddress(Address::InstanceConstSharedPtr address,
+                                  std::chrono::milliseconds delay) PURE;
 };
 
 typedef std::unique_ptr<ClientConnection> ClientConnectionPtr;
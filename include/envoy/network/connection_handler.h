@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 
 #include "envoy/network/connection.h"
@@ -64,6 +65,15 @@ public:
    */
   virtual void removeListeners(uint64_t listener_tag) PURE;
 
+  /**
+   * Stop listeners using the listener tag as a key, and remove them once all connections owned by
+   * them have closed on their own. No connections are closed or drained by the handler.
+   * @param listener_tag supplies the tag passed to addListener().
+   * @param completion supplies the completion to be called once the listeners have been removed.
+   */
+  virtual void removeListenersWhenIdle(uint64_t listener_tag,
+                                       std::function<void()> completion) PURE;
+
   /**
    * Stop listeners using the listener tag as a key. This will not close any connections and is used
    * for draining.
@@ -24,7 +24,11 @@ public:
   virtual void cancel() PURE;
 };
 
-enum class DnsLookupFamily { V4Only, V6Only, Auto };
+/**
+ * The IP versions to look up. Auto returns the IPv6 addresses, or the IPv4 ones if there are
+ * none. All returns the IPv6 addresses followed by the IPv4 ones.
+ */
+enum class DnsLookupFamily { V4Only, V6Only, Auto, All };
 
 /**
  * An asynchronous DNS resolver.
@@ -3,13 +3,84 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "envoy/buffer/buffer.h"
 #include "envoy/common/exception.h"
+#include "envoy/network/address.h"
 #include "envoy/network/connection.h"
 
 namespace Envoy {
 namespace Network {
 
+/**
+ * Distributes the connections accepted by a listener between the copies of the listener that each
+ * worker owns. All methods are thread safe.
+ */
+class ConnectionBalancer {
+public:
+  virtual ~ConnectionBalancer() {}
+
+  /**
+   * The copy of a listener owned by one worker.
+   */
+  class Target {
+  public:
+    virtual ~Target() {}
+
+    /**
+     * @return uint64_t the number of connections owned by the target, including those that have
+     *         been handed to it but not created yet.
+     */
+    virtual uint64_t numConnections() const PURE;
+
+    /**
+     * Count a connection that has been handed to the target.
+     */
+    virtual void incNumConnections() PURE;
+
+    /**
+     * Hand an accepted socket to the target, which creates the connection on its own thread. This
+     * is called on the thread that accepted the socket.
+     * @param fd supplies the accepted socket, which is owned by the target from now on.
+     * @param remote_address supplies the remote address of the connection.
+     * @param local_address supplies the local address of the connection.
+     * @param using_original_dst supplies whether the local address is the original destination.
+     */
+    virtual void post(int fd, Address::InstanceConstSharedPtr remote_address,
+                      Address::InstanceConstSharedPtr local_address, bool using_original_dst) PURE;
+  };
+
+  /**
+   * Add a target to the set that connections are distributed between.
+   */
+  virtual void registerTarget(Target& target) PURE;
+
+  /**
+   * Remove a target. It is not handed any connection once this returns. Removing a target that is
+   * not registered does nothing.
+   */
+  virtual void unregisterTarget(Target& target) PURE;
+
+  /**
+   * Pick the target that owns a newly accepted connection and count the connection against it.
+   * If another target is picked the socket is posted to it.
+   * @param current supplies the target that accepted the connection.
+   * @param fd supplies the accepted socket.
+   * @param remote_address supplies the remote address of the connection.
+   * @param local_address supplies the local address of the connection.
+   * @param using_original_dst supplies whether the local address is the original destination.
+   * @return bool true if the socket was posted to another target, false if current should create
+   *         the connection.
+   */
+  virtual bool balanceConnection(Target& current, int fd,
+                                 Address::InstanceConstSharedPtr remote_address,
+                                 Address::InstanceConstSharedPtr local_address,
+                                 bool using_original_dst) PURE;
+};
+
+typedef std::shared_ptr<ConnectionBalancer> ConnectionBalancerSharedPtr;
+
 /**
  * Listener configurations options.
  */
@@ -25,6 +96,17 @@ struct ListenerOptions {
   bool use_original_dst_;
   // Soft limit on size of the listener's new connection read and write buffers.
   uint32_t per_connection_buffer_limit_bytes_;
+  // If set, accepted connections are balanced between all the workers' copies of the listener
+  // that share the balancer.
+  ConnectionBalancerSharedPtr connection_balancer_;
+  // If set, the buffers of accepted connections are charged to the account.
+  Buffer::AccountSharedPtr buffer_account_;
+  // Maximum number of connections accepted each time the socket is ready, the others being
+  // accepted after the events of the established connections, or 0 for no limit.
+  uint32_t max_accepts_per_wakeup_;
+  // Maximum rate at which connections are accepted, with bursts of up to a second's worth, or 0
+  // for no limit.
+  uint32_t max_accepts_per_second_;
 
   /**
    * Factory for ListenerOptions with bind_to_port_ set.
@@ -34,7 +116,11 @@ struct ListenerOptions {
     return {.bind_to_port_ = true,
             .use_proxy_proto_ = false,
             .use_original_dst_ = false,
-            .per_connection_buffer_limit_bytes_ = 0};
+            .per_connection_buffer_limit_bytes_ = 0,
+            .connection_balancer_ = nullptr,
+            .buffer_account_ = nullptr,
+            .max_accepts_per_wakeup_ = 0,
+            .max_accepts_per_second_ = 0};
   }
 };
 
@@ -45,6 +131,19 @@ class ListenerCallbacks {
 public:
   virtual ~ListenerCallbacks() {}
 
+  /**
+   * Called when a socket is accepted, before a connection is created for it.
+   * @param fd supplies the accepted socket.
+   * @param remote_address supplies the remote address of the connection.
+   * @param local_address supplies the local address of the connection.
+   * @param using_original_dst supplies whether the local address is the original destination.
+   * @return bool true if the callee took ownership of the socket, in which case the listener does
+   *         not create a connection for it.
+   */
+  virtual bool onAccept(int fd, Address::InstanceConstSharedPtr remote_address,
+                        Address::InstanceConstSharedPtr local_address,
+                        bool using_original_dst) PURE;
+
   /**
    * Called when a new connection is accepted.
    * @param new_connection supplies the new connection that is moved into the callee.
@@ -58,10 +157,78 @@ public:
 class Listener {
 public:
   virtual ~Listener() {}
+
+  /**
+   * Create a connection for an accepted socket without calling ListenerCallbacks::onAccept(), and
+   * pass it to ListenerCallbacks::onNewConnection(). This must be called on the listener's thread.
+   * @param fd supplies the accepted socket.
+   * @param remote_address supplies the remote address of the connection.
+   * @param local_address supplies the local address of the connection.
+   * @param using_original_dst supplies whether the local address is the original destination.
+   */
+  virtual void createConnection(int fd, Address::InstanceConstSharedPtr remote_address,
+                                Address::InstanceConstSharedPtr local_address,
+                                bool using_original_dst) PURE;
 };
 
 typedef std::unique_ptr<Listener> ListenerPtr;
 
+/**
+ * A datagram received by a UDP listener.
+ */
+struct UdpRecvData {
+  // The address of the peer that sent the datagram.
+  Address::InstanceConstSharedPtr peer_address_;
+  // The payload of the datagram, which the callee may take.
+  Buffer::InstancePtr buffer_;
+};
+
+/**
+ * A datagram to be sent by a UDP listener.
+ */
+struct UdpSendData {
+  // The IP address of the peer to send the datagram to.
+  Address::InstanceConstSharedPtr peer_address_;
+  // The payload of the datagram, which is left as is.
+  const Buffer::Instance& buffer_;
+};
+
+/**
+ * Callbacks invoked by a UDP listener.
+ */
+class UdpListenerCallbacks {
+public:
+  virtual ~UdpListenerCallbacks() {}
+
+  /**
+   * Called for each datagram received on the listener's socket. Datagrams larger than the
+   * listener's receive size are dropped rather than passed truncated.
+   * @param data supplies the datagram.
+   */
+  virtual void onData(UdpRecvData& data) PURE;
+};
+
+/**
+ * A listener on a datagram socket, which reads and writes the datagrams in batches. Free the
+ * listener to stop reading from the socket.
+ */
+class UdpListener {
+public:
+  virtual ~UdpListener() {}
+
+  /**
+   * Send datagrams from the listener's socket, in as few syscalls as possible. Where the kernel
+   * supports it, runs of datagrams to the same peer are sent as a single segmentation offloaded
+   * message. Sending stops at the first datagram which the socket can't take without blocking, or
+   * fails to send. This must be called on the listener's thread.
+   * @param datagrams supplies the datagrams to send, in order.
+   * @return uint64_t the number of datagrams sent, which are the first ones.
+   */
+  virtual uint64_t send(const std::vector<UdpSendData>& datagrams) PURE;
+};
+
+typedef std::unique_ptr<UdpListener> UdpListenerPtr;
+
 /**
  * Thrown when there is a runtime error creating/binding a listener.
  */
@@ -27,6 +27,12 @@ struct IoResult {
    * Number of bytes processed by the I/O event.
    */
   uint64_t bytes_processed_;
+
+  /**
+   * Number of read or write system calls made by the I/O event, or 0 if the transport socket does
+   * not track them.
+   */
+  uint64_t num_syscalls_;
 };
 
 /**
@@ -22,8 +22,14 @@ enum class RespType { Null, SimpleString, BulkString, Integer, Error, Array };
 class RespValue {
 public:
   RespValue() : type_(RespType::Null) {}
+  RespValue(const RespValue& other) : type_(RespType::Null) { *this = other; }
   ~RespValue() { cleanup(); }
 
+  /**
+   * Deep copy of the value, except that a bulk string held in a buffer shares the buffer.
+   */
+  RespValue& operator=(const RespValue& other);
+
   /**
    * Convert a RESP value to a string for debugging purposes.
    */
@@ -40,6 +46,17 @@ public:
   int64_t& asInteger();
   int64_t asInteger() const;
 
+  /**
+   * A bulk string can hold its contents in a buffer rather than a string, so that large values are
+   * passed from the decoder input to the encoder output as slices rather than copied. The buffer
+   * is shared with the encoded output and must not be modified. The contents are copied into the
+   * string when asString() is first used, and the non-const asString() releases the buffer.
+   * @return const std::shared_ptr<const Buffer::Instance>& the buffer holding the contents of the
+   *         bulk string, or nullptr if they are held in the string.
+   */
+  const std::shared_ptr<const Buffer::Instance>& asBuffer() const;
+  void asBuffer(std::shared_ptr<const Buffer::Instance>&& buffer);
+
   /**
    * Get/set the type of the RespValue. A RespValue can only be a single type at a time. Each time
    * type() is called the type is changed and then the type specific as* methods can be used.
@@ -50,11 +67,15 @@ public:
 private:
   union {
     std::vector<RespValue> array_;
-    std::string string_;
+    // Mutable so that the contents of buffer_ can be copied into it on demand.
+    mutable std::string string_;
     int64_t integer_;
   };
+  std::shared_ptr<const Buffer::Instance> buffer_;
+  mutable bool buffer_copied_{};
 
   void cleanup();
+  void copyBuffer() const;
 
   RespType type_;
 };
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 #include <memory>
 #include <string>
 
+#include "envoy/common/optional.h"
 #include "envoy/redis/codec.h"
 #include "envoy/upstream/cluster_manager.h"
 
@@ -68,6 +70,12 @@ public:
    *         for some reason.
    */
   virtual PoolRequest* makeRequest(const RespValue& request, PoolCallbacks& callbacks) PURE;
+
+  /**
+   * @return uint64_t the number of requests made which have not been responded to yet, including
+   *         the cancelled ones.
+   */
+  virtual uint64_t outstandingRequests() const PURE;
 };
 
 typedef std::unique_ptr<Client> ClientPtr;
@@ -91,6 +99,13 @@ public:
    * passive healthcheck operations.
    */
   virtual bool disableOutlierEvents() const PURE;
+
+  /**
+   * @return uint32_t the size in bytes of the encoded requests at which they are written to the
+   *         connection right away. Below it, the requests made during an iteration of the event
+   *         loop are written together at the end of it.
+   */
+  virtual uint32_t maxBufferSizeBeforeFlush() const PURE;
 };
 
 /**
@@ -129,6 +144,33 @@ public:
    */
   virtual PoolRequest* makeRequest(const std::string& hash_key, const RespValue& request,
                                    PoolCallbacks& callbacks) PURE;
+
+  /**
+   * Choose the upstream host for a key, so that requests for several keys which hash to the same
+   * host can be combined.
+   * @param hash_key supplies the key to use for consistent hashing.
+   * @return Upstream::HostConstSharedPtr the host, or nullptr if there is no host available.
+   */
+  virtual Upstream::HostConstSharedPtr chooseHost(const std::string& hash_key) PURE;
+
+  /**
+   * A Redis Cluster only serves a request for several keys if they are all in the same hash slot.
+   * @param hash_key supplies a key.
+   * @return Optional<uint16_t> the slot of the key if the upstream is a Redis Cluster, in which
+   *         case keys can only be combined with keys in the same slot.
+   */
+  virtual Optional<uint16_t> hashSlot(const std::string& hash_key) PURE;
+
+  /**
+   * Makes a redis request to a host returned by chooseHost().
+   * @param host supplies the host.
+   * @param request supplies the request to make.
+   * @param callbacks supplies the request completion callbacks.
+   * @return PoolRequest* a handle to the active request or nullptr if the request could not be made
+   *         for some reason.
+   */
+  virtual PoolRequest* makeRequestToHost(const Upstream::HostConstSharedPtr& host,
+                                         const RespValue& request, PoolCallbacks& callbacks) PURE;
 };
 
 typedef std::unique_ptr<Instance> InstancePtr;
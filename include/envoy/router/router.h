@@ -7,6 +7,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "envoy/access_log/access_log.h"
 #include "envoy/common/optional.h"
@@ -84,6 +85,18 @@ public:
    * @return bool Whether CORS is enabled for the route or virtual host.
    */
   virtual bool enabled() const PURE;
+
+  /**
+   * @param origin supplies the origin of a request.
+   * @return bool whether the origin is in allowOrigins(), or allowOrigins() has the "*" wildcard.
+   */
+  virtual bool allowsOrigin(const Http::HeaderString& origin) const PURE;
+
+  /**
+   * @return const Http::HeaderMap& the headers of the response to a preflight request, with an
+   *         empty access-control-allow-origin to be set to the origin of the request.
+   */
+  virtual const Http::HeaderMap& preflightHeaders() const PURE;
 };
 
 /**
@@ -276,6 +289,12 @@ public:
    */
   virtual const std::vector<MetadataMatchCriterionConstSharedPtr>&
   metadataMatchCriteria() const PURE;
+
+  /*
+   * @return std::size_t a hash of the names and values of the criteria, which is computed once
+   * when the criteria are created. Equal criteria have equal hashes.
+   */
+  virtual std::size_t hash() const PURE;
 };
 
 /**
@@ -290,6 +309,12 @@ public:
    */
   virtual const std::string& clusterName() const PURE;
 
+  /**
+   * @return Optional<uint32_t> the handle of the upstream cluster, if it was resolved when the
+   *         route was loaded. @see Upstream::ClusterManager::clusterHandle().
+   */
+  virtual Optional<uint32_t> clusterHandle() const PURE;
+
   /**
    * Returns the HTTP status code to use when configured cluster is not found.
    * @return Http::Code to use when configured cluster is not found.
@@ -463,6 +488,14 @@ public:
    * (RFC1918) source.
    */
   virtual const std::list<Http::LowerCaseString>& internalOnlyHeaders() const PURE;
+
+  /**
+   * @return const std::vector<Http::LowerCaseString>* the request headers which route() depends
+   *         on besides the host and the path, so that requests with the same values of these are
+   *         given the same route, or nullptr if routes also depend on runtime values or on the
+   *         random value.
+   */
+  virtual const std::vector<Http::LowerCaseString>* routeKeyHeaders() const PURE;
 };
 
 typedef std::shared_ptr<const Config> ConfigConstSharedPtr;
@@ -1,18 +1,49 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 #include <memory>
 #include <string>
 
+#include "envoy/buffer/buffer.h"
+#include "envoy/http/header_map.h"
 #include "envoy/http/message.h"
 
 namespace Envoy {
 namespace Router {
 
 /**
- * Interface used to shadow complete requests to an alternate upstream cluster in a "fire and
- * forget" fashion. Right now this interface takes a fully buffered request and cannot be used for
- * streaming. This is sufficient for current use cases.
+ * A request which is shadowed while it streams. The body and trailers are copied to the shadow as
+ * they are sent, and the primary request never waits for the shadow.
+ */
+class ShadowStream {
+public:
+  virtual ~ShadowStream() {}
+
+  /**
+   * Send body data to the shadow. The data is copied and left unchanged.
+   * @param data supplies the data to send.
+   * @param end_stream supplies whether this is the last data of the request. The stream must not
+   *        be used afterwards if it is.
+   */
+  virtual void sendData(const Buffer::Instance& data, bool end_stream) PURE;
+
+  /**
+   * Send trailers to the shadow, which ends the request. The stream must not be used afterwards.
+   * @param trailers supplies the trailers to send.
+   */
+  virtual void sendTrailers(const Http::HeaderMap& trailers) PURE;
+
+  /**
+   * Reset the shadow, as the request will not be completed. The stream must not be used
+   * afterwards.
+   */
+  virtual void reset() PURE;
+};
+
+/**
+ * Interface used to shadow requests to an alternate upstream cluster in a "fire and forget"
+ * fashion, either fully buffered or while they stream.
  */
 class ShadowWriter {
 public:
@@ -26,6 +57,21 @@ public:
    */
   virtual void shadow(const std::string& cluster, Http::MessagePtr&& request,
                       std::chrono::milliseconds timeout) PURE;
+
+  /**
+   * Start shadowing a request whose body is still to come.
+   * @param cluster supplies the cluster name to shadow to.
+   * @param headers supplies the request headers, which are copied.
+   * @param timeout supplies the shadowed request timeout.
+   * @param buffer_limit supplies the most body data to hold while the shadow upstream is backed
+   *        up, past which the shadow is reset. 0 means no limit.
+   * @return ShadowStream* the stream to send the rest of the request to, or nullptr if the shadow
+   *         could not be started. The stream deletes itself once the request has been ended or
+   *         reset and the shadow is done with.
+   */
+  virtual ShadowStream* streamShadow(const std::string& cluster, const Http::HeaderMap& headers,
+                                     std::chrono::milliseconds timeout,
+                                     uint32_t buffer_limit) PURE;
 };
 
 typedef std::unique_ptr<ShadowWriter> ShadowWriterPtr;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -26,10 +27,42 @@ public:
    * for example, 7c25513b-0466-4558-a64c-12c6704f37ed
    */
   virtual std::string uuid() PURE;
+
+  /**
+   * Write a uuid4 without allocating, e.g. straight into the inline storage of a header.
+   * @param buffer supplies the buffer to write the UUID_LENGTH chars of the uuid to. The uuid is
+   *        not null terminated.
+   */
+  virtual void uuid(char* buffer) PURE;
+
+  static const size_t UUID_LENGTH = 36;
 };
 
 typedef std::unique_ptr<RandomGenerator> RandomGeneratorPtr;
 
+/**
+ * A runtime key resolved to a dense index, which snapshots look up with an array load rather than
+ * by hashing the key. Keys are resolved once, when the code or config using them is set up.
+ */
+class Key {
+public:
+  Key(const std::string& name, uint32_t index) : name_(name), index_(index) {}
+
+  /**
+   * @return const std::string& the name of the key.
+   */
+  const std::string& name() const { return name_; }
+
+  /**
+   * @return uint32_t the index of the key, which is the same for every snapshot.
+   */
+  uint32_t index() const { return index_; }
+
+private:
+  std::string name_;
+  uint32_t index_;
+};
+
 /**
  * A snapshot of runtime data.
  */
@@ -96,6 +129,24 @@ public:
    * @return uint64_t the runtime value or the default value.
    */
   virtual uint64_t getInteger(const std::string& key, uint64_t default_value) const PURE;
+
+  /**
+   * Variants of featureEnabled() and getInteger() which take a resolved key. They behave like the
+   * variants taking the name of the key, and are the ones to use on a per request path.
+   */
+  virtual bool featureEnabled(const Key& key, uint64_t default_value) const PURE;
+  virtual bool featureEnabled(const Key& key, uint64_t default_value,
+                              uint64_t random_value) const PURE;
+  virtual bool featureEnabled(const Key& key, uint64_t default_value, uint64_t random_value,
+                              uint16_t num_buckets) const PURE;
+  virtual uint64_t getInteger(const Key& key, uint64_t default_value) const PURE;
+
+  /**
+   * @return uint64_t the version of the snapshot. Each snapshot taken by a loader has a greater
+   *         version than the ones before it, so values derived from a snapshot can be cached
+   *         until the version changes.
+   */
+  virtual uint64_t version() const PURE;
 };
 
 /**
@@ -39,9 +39,12 @@ public:
    * Retrieve a listening socket on the specified address from the parent process. The socket will
    * be duplicated across process boundaries.
    * @param address supplies the address of the socket to duplicate, e.g. tcp://127.0.0.1:5000.
+   * @param worker_index supplies the index of the worker the socket is for. This selects between
+   *        the per worker sockets of a listener using SO_REUSEPORT, and is ignored for listeners
+   *        with a single socket shared by all workers.
    * @return int the fd or -1 if there is no bound listen port in the parent.
    */
-  virtual int duplicateParentListenSocket(const std::string& address) PURE;
+  virtual int duplicateParentListenSocket(const std::string& address, uint32_t worker_index) PURE;
 
   /**
    * Retrieve stats from our parent process.
@@ -16,6 +16,7 @@
 #include "envoy/server/hot_restart.h"
 #include "envoy/server/listener_manager.h"
 #include "envoy/server/options.h"
+#include "envoy/server/overload_manager.h"
 #include "envoy/ssl/context_manager.h"
 #include "envoy/thread_local/thread_local.h"
 #include "envoy/tracing/http_tracer.h"
@@ -118,6 +119,11 @@ public:
    */
   virtual Options& options() PURE;
 
+  /**
+   * @return OverloadManager& the server-wide overload manager.
+   */
+  virtual OverloadManager& overloadManager() PURE;
+
   /**
    * @return RandomGenerator& the random generator for the server.
    */
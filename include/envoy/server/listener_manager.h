@@ -1,5 +1,6 @@
 #pragma once
 
+#include "envoy/buffer/buffer.h"
 #include "envoy/network/filter.h"
 #include "envoy/network/listen_socket.h"
 #include "envoy/server/drain_manager.h"
@@ -25,10 +26,15 @@ public:
    * Creates a socket.
    * @param address supplies the socket's address.
    * @param bind_to_port supplies whether to actually bind the socket.
+   * @param reuse_port supplies whether the socket is one of a set of SO_REUSEPORT sockets bound to
+   *        the same address, one for each worker.
+   * @param worker_index supplies the index of the worker the socket is for when reuse_port is
+   *        true.
    * @return Network::ListenSocketSharedPtr an initialized and potentially bound socket.
    */
   virtual Network::ListenSocketSharedPtr
-  createListenSocket(Network::Address::InstanceConstSharedPtr address, bool bind_to_port) PURE;
+  createListenSocket(Network::Address::InstanceConstSharedPtr address, bool bind_to_port,
+                     bool reuse_port, uint32_t worker_index) PURE;
 
   /**
    * Creates a list of filter factories.
@@ -71,6 +77,15 @@ public:
    */
   virtual Network::ListenSocket& socket() PURE;
 
+  /**
+   * @param worker_index supplies the index of a worker.
+   * @return Network::ListenSocket* the socket the worker accepts connections on, or nullptr if
+   *         the listener has no socket for the worker. This is always socket() unless the listener
+   *         has a separate SO_REUSEPORT socket for each worker, in which case socket() is the one
+   *         for worker 0.
+   */
+  virtual Network::ListenSocket* workerSocket(uint32_t worker_index) PURE;
+
   /**
    * @return Ssl::ServerContext* the default SSL context.
    */
@@ -101,6 +116,31 @@ public:
    */
   virtual uint32_t perConnectionBufferLimitBytes() PURE;
 
+  /**
+   * @return Network::ConnectionBalancerSharedPtr the balancer shared by all the workers' copies of
+   *         the listener, or nullptr if each worker keeps the connections it accepts.
+   */
+  virtual Network::ConnectionBalancerSharedPtr connectionBalancer() PURE;
+
+  /**
+   * @return const Buffer::AccountSharedPtr& the account charged with the bytes buffered by the
+   *         listener's connections on all the workers, including the request and response bodies
+   *         buffered by their filters.
+   */
+  virtual const Buffer::AccountSharedPtr& bufferAccount() PURE;
+
+  /**
+   * @return uint32_t the maximum number of connections each worker's copy of the listener accepts
+   *         each time its socket is ready, or 0 for no limit.
+   */
+  virtual uint32_t maxAcceptsPerWakeup() PURE;
+
+  /**
+   * @return uint32_t the maximum number of connections each worker's copy of the listener accepts
+   *         per second, or 0 for no limit.
+   */
+  virtual uint32_t maxAcceptsPerSecond() PURE;
+
   /**
    * @return Stats::Scope& the stats scope to use for all listener specific stats.
    */
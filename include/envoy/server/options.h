@@ -3,6 +3,7 @@
 #include <chrono>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "envoy/common/pure.h"
 #include "envoy/network/address.h"
@@ -90,6 +91,12 @@ public:
    */
   virtual const std::string& logPath() PURE;
 
+  /**
+   * @return bool whether log lines are queued by the threads logging them and written by a
+   *         background thread, rather than written by those threads.
+   */
+  virtual bool asyncLog() PURE;
+
   /**
    * @return the number of seconds that envoy will wait before shutting down the parent envoy during
    *         a host restart. Generally this will be longer than the drainTime() option.
@@ -128,7 +135,8 @@ public:
   virtual const std::string& serviceZone() PURE;
 
   /**
-   * @return uint64_t the maximum number of stats gauges and counters.
+   * @return uint64_t the number of stats gauges and counters in each segment of the shared memory
+   *         stats region.
    */
   virtual uint64_t maxStats() PURE;
 
@@ -137,6 +145,164 @@ public:
    * router/cluster/listener.
    */
   virtual uint64_t maxObjNameLength() PURE;
+
+  /**
+   * @return bool whether buffers use the original libevent evbuffer implementation rather than the
+   *         native slice based implementation.
+   */
+  virtual bool libeventBuffersEnabled() PURE;
+
+  /**
+   * @return bool whether each worker accepts connections on its own SO_REUSEPORT listen socket,
+   *         rather than all workers sharing a single listen socket per listener.
+   */
+  virtual bool reusePort() PURE;
+
+  /**
+   * @return bool whether connections accepted by a listener are handed to the worker owning the
+   *         fewest connections of that listener, rather than kept by the accepting worker.
+   */
+  virtual bool balanceConnections() PURE;
+
+  /**
+   * @return uint32_t the maximum number of connections a listener accepts on a worker each time its
+   *         socket is ready, or 0 for no limit. The others are accepted after the events of the
+   *         established connections.
+   */
+  virtual uint32_t maxAcceptsPerWakeup() PURE;
+
+  /**
+   * @return uint32_t the maximum number of connections a listener accepts per second on a worker,
+   *         or 0 for no limit.
+   */
+  virtual uint32_t maxAcceptsPerSecond() PURE;
+
+  /**
+   * @return bool whether dispatchers batch event registration changes with libevent's epoll
+   *         changelist.
+   */
+  virtual bool epollChangelistEnabled() PURE;
+
+  /**
+   * @return uint32_t the maximum number of deferred deletions run by a dispatcher in a loop
+   *         iteration, or 0 for no limit. The rest are carried over to the next iteration.
+   */
+  virtual uint32_t maxDeferredDeletesPerIteration() PURE;
+
+  /**
+   * @return bool whether connections flush writes at the end of the event loop iteration, so that
+   *         small writes made while handling events are coalesced.
+   */
+  virtual bool coalesceWrites() PURE;
+
+  /**
+   * @return uint32_t the TCP_NOTSENT_LOWAT to set on TCP connections, or 0 to leave the system
+   *         default.
+   */
+  virtual uint32_t tcpNotSentLowat() PURE;
+
+  /**
+   * @return uint32_t the number of threads which run the private key operations of TLS server
+   *         handshakes, or 0 to run them on the worker handling the handshake.
+   */
+  virtual uint32_t privateKeyThreads() PURE;
+
+  /**
+   * @return uint64_t the maximum number of TLS sessions in the session cache shared by all server
+   *         contexts, or 0 for each context to use its own internal cache.
+   */
+  virtual uint64_t sslSessionCacheSize() PURE;
+
+  /**
+   * @return uint32_t the maximum size of the TLS records written at the start of a connection and
+   *         after it has been idle, or 0 to always write records as large as possible.
+   */
+  virtual uint32_t tlsInitialRecordSize() PURE;
+
+  /**
+   * @return bool whether to hand the write keys of TLS connections to the kernel after their
+   *         handshake, where supported.
+   */
+  virtual bool kernelTlsEnabled() PURE;
+
+  /**
+   * @return bool whether TLS server contexts selected by SNI only load their certificate chain
+   *         and private key once they are first selected.
+   */
+  virtual bool lazyTlsCertificates() PURE;
+
+  /**
+   * @return bool whether TLS server contexts accept TLS 1.3 early data on resumed connections.
+   */
+  virtual bool tlsEarlyData() PURE;
+
+  /**
+   * @return bool whether workers increment counters in thread local slots, which are added to the
+   *         shared counter values when stats are flushed.
+   */
+  virtual bool threadLocalCounters() PURE;
+
+  /**
+   * @return uint32_t the maximum size of the datagrams which UDP statsd sinks batch counters and
+   *         gauges into, or 0 to send each of them in its own datagram.
+   */
+  virtual uint32_t statsdUdpMaxDatagramSize() PURE;
+
+  /**
+   * @return uint32_t the number of stats flushes per flush of every used counter and gauge to the
+   *         sinks which only need the stats which changed since the previous flush, or 0 to flush
+   *         every used stat to every sink each time.
+   */
+  virtual uint32_t statsFullFlushEvery() PURE;
+
+  /**
+   * @return std::chrono::milliseconds how long the addresses resolved for DNS clusters are reused
+   *         for further resolutions of the same name, or 0 to resolve each time.
+   */
+  virtual std::chrono::milliseconds dnsCacheDuration() PURE;
+
+  /**
+   * @return uint32_t the number of hits each worker leases from the rate limit service for the
+   *         descriptors of a request, and spends on later requests with the same descriptors
+   *         without calling the service, or 0 to call the service for each request.
+   */
+  virtual uint32_t ratelimitLeaseSize() PURE;
+
+  /**
+   * @return std::chrono::milliseconds how long the hits leased from the rate limit service may be
+   *         spent.
+   */
+  virtual std::chrono::milliseconds ratelimitLeaseDuration() PURE;
+
+  /**
+   * @return bool whether cluster health checks run on a thread of their own rather than on the
+   *         main thread.
+   */
+  virtual bool dedicatedHealthCheckThread() PURE;
+
+  /**
+   * @return bool whether the ADS stream, and the decoding of its responses, run on a thread of
+   *         their own rather than on the main thread, which still applies the updates.
+   */
+  virtual bool dedicatedXdsThread() PURE;
+
+  /**
+   * @return const std::vector<uint32_t>& the CPUs to pin the workers to, worker i being pinned to
+   *         the i-th CPU modulo their number, or empty to leave the workers unpinned.
+   */
+  virtual const std::vector<uint32_t>& workerCpus() PURE;
+
+  /**
+   * @return const std::string& the directory in which the last accepted LDS and CDS updates are
+   *         kept, to be applied straight away on the next start, or empty to keep none.
+   */
+  virtual const std::string& xdsCachePath() PURE;
+
+  /**
+   * @return uint32_t the number of threads validating the listeners of the config concurrently in
+   *         validate mode. With 1, the config is validated on the main thread.
+   */
+  virtual uint32_t validationThreads() PURE;
 };
 
 } // namespace Server
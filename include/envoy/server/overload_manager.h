@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+
+#include "envoy/common/pure.h"
+
+namespace Envoy {
+namespace Server {
+
+/**
+ * The actions the server takes to shed load when it is overloaded. The actions are ordered from
+ * the least to the most disruptive, and by default a more disruptive action only becomes active
+ * at a higher resource pressure than a less disruptive one.
+ */
+enum class OverloadActionType {
+  // Close downstream HTTP connections after their current response, as if they were draining.
+  DisableHttpKeepAlive,
+  // Close newly accepted downstream connections before any filter runs on them.
+  StopAcceptingConnections,
+  // Reply to new HTTP requests with a 503 without proxying them.
+  StopAcceptingRequests,
+};
+
+/**
+ * Samples the resources the server uses on the main thread and decides which overload actions
+ * are active.
+ */
+class OverloadManager {
+public:
+  virtual ~OverloadManager() {}
+
+  /**
+   * Start sampling resources. This must be called on the main thread once runtime and thread
+   * local storage are available, and before the workers are started.
+   */
+  virtual void start() PURE;
+
+  /**
+   * @param action supplies the overload action to check.
+   * @return TRUE if the action is active. No action is active before start() is called. This can
+   *         be called on any thread which is registered for thread local updates.
+   */
+  virtual bool isActive(OverloadActionType action) PURE;
+};
+
+typedef std::unique_ptr<OverloadManager> OverloadManagerPtr;
+
+} // namespace Server
+} // namespace Envoy
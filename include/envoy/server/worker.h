@@ -54,6 +54,15 @@ public:
    */
   virtual void removeListener(Listener& listener, std::function<void()> completion) PURE;
 
+  /**
+   * Stop a listener from accepting new connections, and remove it from the worker once all of its
+   * connections have closed on their own. The connections are not drained.
+   * @param listener supplies the listener to remove.
+   * @param completion supplies the completion to be called when the listener has been removed.
+   *        This completion is called on the worker thread. No locking is performed by the worker.
+   */
+  virtual void removeListenerWhenIdle(Listener& listener, std::function<void()> completion) PURE;
+
   /**
    * Stop a listener from accepting new connections. This is used for server draining.
    * @param listener supplies the listener to stop.
@@ -80,9 +89,11 @@ public:
   virtual ~WorkerFactory() {}
 
   /**
+   * @param index supplies the index of the worker, which selects its socket for listeners with a
+   *        socket per worker. Workers are numbered from 0.
    * @return WorkerPtr a new worker.
    */
-  virtual WorkerPtr createWorker() PURE;
+  virtual WorkerPtr createWorker(uint32_t index) PURE;
 };
 
 } // namespace Server
@@ -8,7 +8,8 @@ namespace Envoy {
 namespace Ssl {
 
 /**
- * Base connection interface for all SSL connections.
+ * Base connection interface for all SSL connections. The certificate details are computed once the
+ * handshake completes, so they are cheap to read for every request of the connection.
  */
 class Connection {
 public:
@@ -42,6 +43,13 @@ public:
    *         certificate, or no SAN field, or no URI.
    **/
   virtual std::string uriSanPeerCertificate() PURE;
+
+  /**
+   * @return whether some of the data of the last read was TLS 1.3 early data, which an attacker
+   *         may have replayed. Requests completed by that read should only be acted upon if
+   *         replaying them is harmless.
+   **/
+  virtual bool lastReadEarlyData() const PURE;
 };
 
 } // namespace Ssl
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -73,6 +74,12 @@ public:
    * @return The maximum TLS protocol version to negotiate.
    */
   virtual unsigned maxProtocolVersion() const PURE;
+
+  /**
+   * @return The maximum size of the TLS records written at the start of a connection and after it
+   * has been idle, or 0 to always write records as large as possible.
+   */
+  virtual uint32_t initialRecordSize() const PURE;
 };
 
 class ClientContextConfig : public virtual ContextConfig {
@@ -92,6 +99,11 @@ public:
     std::array<uint8_t, 256 / 8> aes_key_; // AES256 key size, in bytes
   };
 
+  struct CertificateFiles {
+    std::string cert_chain_file_;
+    std::string private_key_file_;
+  };
+
   /**
    * @return True if client certificate is required, false otherwise.
    */
@@ -103,6 +115,13 @@ public:
    * are candidates for decrypting received tickets.
    */
   virtual const std::vector<SessionTicketKey>& sessionTicketKeys() const PURE;
+
+  /**
+   * @return The certificate chain and private key files of all the certificates to serve, the
+   * first being certChainFile() and privateKeyFile(). With both an ECDSA and an RSA certificate,
+   * clients supporting ECDSA are served the ECDSA one.
+   */
+  virtual const std::vector<CertificateFiles>& tlsCertificates() const PURE;
 };
 
 } // namespace Ssl
@@ -99,7 +99,8 @@ public:
 typedef std::shared_ptr<Counter> CounterSharedPtr;
 
 /**
- * A gauge that can both increment and decrement.
+ * A gauge that can both increment and decrement. It also records whether it was modified since
+ * latchChanged() was last called, so that stats flushes can skip unchanged gauges.
  */
 class Gauge : public virtual Metric {
 public:
@@ -108,6 +109,7 @@ public:
   virtual void add(uint64_t amount) PURE;
   virtual void dec() PURE;
   virtual void inc() PURE;
+  virtual bool latchChanged() PURE;
   virtual void set(uint64_t value) PURE;
   virtual void sub(uint64_t amount) PURE;
   virtual bool used() const PURE;
@@ -135,6 +137,62 @@ public:
 
 typedef std::shared_ptr<Histogram> HistogramSharedPtr;
 
+/**
+ * Quantiles of the values recorded by a histogram.
+ */
+class HistogramStatistics {
+public:
+  virtual ~HistogramStatistics() {}
+
+  /**
+   * @return std::string a human readable summary of the quantiles.
+   */
+  virtual std::string quantileSummary() const PURE;
+
+  /**
+   * @return const std::vector<double>& the quantiles which are computed, in increasing order.
+   */
+  virtual const std::vector<double>& supportedQuantiles() const PURE;
+
+  /**
+   * @return const std::vector<double>& the value of each of the supportedQuantiles(). The values
+   *         are NaN if no values have been recorded.
+   */
+  virtual const std::vector<double>& computedQuantiles() const PURE;
+
+  /**
+   * @return uint64_t the number of values which have been recorded.
+   */
+  virtual uint64_t sampleCount() const PURE;
+};
+
+/**
+ * A histogram which aggregates the values recorded on all threads. Values are recorded by each
+ * thread without synchronization, and are merged on the main thread when stats are flushed.
+ */
+class ParentHistogram : public Histogram {
+public:
+  virtual ~ParentHistogram() {}
+
+  /**
+   * Merge the values which all threads have recorded since the last merge. This must be called on
+   * the main thread.
+   */
+  virtual void merge() PURE;
+
+  /**
+   * @return const HistogramStatistics& the statistics of the values merged by the last merge().
+   */
+  virtual const HistogramStatistics& intervalStatistics() const PURE;
+
+  /**
+   * @return const HistogramStatistics& the statistics of all of the values which have been merged.
+   */
+  virtual const HistogramStatistics& cumulativeStatistics() const PURE;
+};
+
+typedef std::shared_ptr<ParentHistogram> ParentHistogramSharedPtr;
+
 /**
  * A sink for stats. Each sink is responsible for writing stats to a backing store.
  */
@@ -143,11 +201,18 @@ public:
   virtual ~Sink() {}
 
   /**
-   * This will be called before a sequence of flushCounter() and flushGauge() calls. Sinks can
-   * choose to optimize writing if desired with a paired endFlush() call.
+   * This will be called before a sequence of flushCounter(), flushGauge() and flushHistogram()
+   * calls. Sinks can choose to optimize writing if desired with a paired endFlush() call.
    */
   virtual void beginFlush() PURE;
 
+  /**
+   * @return bool whether the sink only needs the counters and gauges which changed since the
+   *         previous flush, as for a backend which keeps the last value of each stat. Every used
+   *         stat is still flushed to the sink periodically.
+   */
+  virtual bool changedStatsOnly() const PURE;
+
   /**
    * Flush a counter delta.
    */
@@ -159,8 +224,14 @@ public:
   virtual void flushGauge(const Gauge& gauge, uint64_t value) PURE;
 
   /**
-   * This will be called after beginFlush(), some number of flushCounter(), and some number of
-   * flushGauge(). Sinks can use this to optimize writing if desired.
+   * Flush the statistics of a histogram, which has just been merged.
+   */
+  virtual void flushHistogram(const ParentHistogram& histogram) PURE;
+
+  /**
+   * This will be called after beginFlush(), some number of flushCounter(), some number of
+   * flushGauge() and some number of flushHistogram(). Sinks can use this to optimize writing if
+   * desired.
    */
   virtual void endFlush() PURE;
 
@@ -226,6 +297,11 @@ public:
    * @return a list of all known gauges.
    */
   virtual std::list<GaugeSharedPtr> gauges() const PURE;
+
+  /**
+   * @return a list of all known histograms which aggregate their values.
+   */
+  virtual std::list<ParentHistogramSharedPtr> histograms() const PURE;
 };
 
 typedef std::unique_ptr<Store> StorePtr;
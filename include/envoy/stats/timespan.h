@@ -18,6 +18,11 @@ public:
   Timespan(Histogram& histogram)
       : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
 
+  /**
+   * Start the timespan at a time already read, e.g. Event::Dispatcher::approximateMonotonicTime().
+   */
+  Timespan(Histogram& histogram, MonotonicTime start) : histogram_(histogram), start_(start) {}
+
   /**
    * Complete the timespan and send the time to the histogram.
    */
@@ -99,6 +99,21 @@ public:
    * called on the thread that is shutting down.
    */
   virtual void shutdownThread() PURE;
+
+  /**
+   * Start batching the updates made through slots on the main thread. Until the matching
+   * endBatch(), set(), runOnAllThreads() and slot removals still run immediately on the main
+   * thread, but are only queued for the other threads. endBatch() then posts all of them to each
+   * thread as a single callback, which runs them in order. This bounds the number of posts made by
+   * large updates such as a CDS response with thousands of clusters. Batches can be nested, and
+   * only the outermost endBatch() posts. Both must be called on the main thread.
+   */
+  virtual void startBatch() PURE;
+
+  /**
+   * End the batch started by the matching startBatch().
+   */
+  virtual void endBatch() PURE;
 };
 
 } // namespace ThreadLocal
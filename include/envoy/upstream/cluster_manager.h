@@ -8,6 +8,7 @@
 
 #include "envoy/access_log/access_log.h"
 #include "envoy/config/grpc_mux.h"
+#include "envoy/event/dispatcher.h"
 #include "envoy/http/async_client.h"
 #include "envoy/http/conn_pool.h"
 #include "envoy/local_info/local_info.h"
@@ -22,6 +23,19 @@
 namespace Envoy {
 namespace Upstream {
 
+/**
+ * How long each phase of the cluster manager's initialization took. Phases which haven't completed
+ * yet, or which aren't used (such as CDS when it isn't configured), are zero.
+ */
+struct ClusterManagerInitTimes {
+  // Loading and initializing the statically configured clusters.
+  std::chrono::milliseconds static_clusters_{};
+  // Waiting for the first CDS response.
+  std::chrono::milliseconds cds_{};
+  // Initializing the clusters in the first CDS response.
+  std::chrono::milliseconds cds_clusters_{};
+};
+
 /**
  * Manages connection pools and load balancing for upstream clusters. The cluster manager is
  * persistent and shared among multiple ongoing requests/connections.
@@ -65,6 +79,22 @@ public:
    */
   virtual ThreadLocalCluster* get(const std::string& cluster) PURE;
 
+  /**
+   * Get the small integer handle of a cluster name, with which the thread local cluster and its
+   * connection pools can be found by index rather than by hashing the name. A handle is allocated
+   * the first time a name is seen, whether or not a cluster of that name exists yet, and is never
+   * reused, so config can resolve handles once when it is loaded. This may only be called on the
+   * main thread.
+   * @param cluster supplies the cluster name.
+   * @return uint32_t the handle of the cluster name.
+   */
+  virtual uint32_t clusterHandle(const std::string& cluster) PURE;
+
+  /**
+   * Like get(), for a cluster handle. @see clusterHandle().
+   */
+  virtual ThreadLocalCluster* getByHandle(uint32_t handle) PURE;
+
   /**
    * Allocate a load balanced HTTP connection pool for a cluster. This is *per-thread* so that
    * callers do not need to worry about per thread synchronization. The load balancing policy that
@@ -77,6 +107,13 @@ public:
                                                                  ResourcePriority priority,
                                                                  LoadBalancerContext* context) PURE;
 
+  /**
+   * Like httpConnPoolForCluster(), for a cluster handle. @see clusterHandle().
+   */
+  virtual Http::ConnectionPool::Instance*
+  httpConnPoolForClusterHandle(uint32_t handle, ResourcePriority priority,
+                               LoadBalancerContext* context) PURE;
+
   /**
    * Allocate a load balanced TCP connection for a cluster. The created connection is already
    * bound to the correct *per-thread* dispatcher, so no further synchronization is needed. The
@@ -134,6 +171,25 @@ public:
    *                     or "static" if CDS is not in use.
    */
   virtual const std::string versionInfo() const PURE;
+
+  /**
+   * @return const ClusterManagerInitTimes& how long each phase of initialization took.
+   */
+  virtual const ClusterManagerInitTimes& initTimes() const PURE;
+
+  /**
+   * Create a cluster which CDS delivered while the upstream.on_demand_cds runtime key was set, and
+   * which hasn't been used yet. Only the config of such clusters is kept until they are first
+   * needed. This may be called from any thread.
+   * @param cluster supplies the name of the cluster.
+   * @param dispatcher supplies the dispatcher of the calling thread, which the callback is posted
+   *        to.
+   * @param callback supplies the callback invoked once the cluster has been created and
+   *        initialized and can be found with get() on the calling thread, or once it is known that
+   *        there is no such cluster to create.
+   */
+  virtual void loadOnDemandCluster(const std::string& cluster, Event::Dispatcher& dispatcher,
+                                   std::function<void()> callback) PURE;
 };
 
 typedef std::unique_ptr<ClusterManager> ClusterManagerPtr;
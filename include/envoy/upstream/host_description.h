@@ -1,8 +1,10 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <string>
 
+#include "envoy/common/time.h"
 #include "envoy/network/address.h"
 #include "envoy/stats/stats_macros.h"
 #include "envoy/upstream/health_check_host_monitor.h"
@@ -39,6 +41,30 @@ struct HostStats {
   ALL_HOST_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
 };
 
+/**
+ * Estimate of the response latency of a host, for latency aware load balancing. Shared by all the
+ * workers.
+ */
+class LatencyEstimator {
+public:
+  virtual ~LatencyEstimator() {}
+
+  /**
+   * Add the latency of a response from the host.
+   * @param latency supplies the time from the end of the request to the end of the response.
+   * @param now supplies the current time.
+   */
+  virtual void putLatency(std::chrono::microseconds latency, MonotonicTime now) PURE;
+
+  /**
+   * @param now supplies the current time.
+   * @return double the peak sensitive exponentially weighted moving average of the latencies of
+   *         the host in microseconds, decayed towards 0 since the last response, or 0 if the host
+   *         has not responded yet.
+   */
+  virtual double peakEwma(MonotonicTime now) const PURE;
+};
+
 class ClusterInfo;
 
 /**
@@ -73,6 +99,11 @@ public:
    */
   virtual HealthCheckHostMonitor& healthChecker() const PURE;
 
+  /**
+   * @return the host's response latency estimate.
+   */
+  virtual LatencyEstimator& latencyEstimator() const PURE;
+
   /**
    * @return the hostname associated with the host if any.
    * Empty string "" indicates that hostname is not a DNS name.
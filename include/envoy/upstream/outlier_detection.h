@@ -123,7 +123,7 @@ public:
 
 typedef std::shared_ptr<Detector> DetectorSharedPtr;
 
-enum class EjectionType { Consecutive5xx, SuccessRate, ConsecutiveGatewayFailure };
+enum class EjectionType { Consecutive5xx, SuccessRate, ConsecutiveGatewayFailure, SlowResponse };
 
 /**
  * Sink for outlier detection event logs.
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 
@@ -73,6 +74,13 @@ public:
    * @return Resource& active retries.
    */
   virtual Resource& retries() PURE;
+
+  /**
+   * Called when a request to the cluster completes, so that limits which adapt to the latency of
+   * the upstream can be adjusted.
+   * @param latency supplies the time the request took to complete.
+   */
+  virtual void onRequestComplete(std::chrono::microseconds latency) PURE;
 };
 
 } // namespace Upstream
@@ -10,7 +10,9 @@
 
 #include "envoy/common/callback.h"
 #include "envoy/common/optional.h"
+#include "envoy/common/time.h"
 #include "envoy/http/codec.h"
+#include "envoy/http/codes.h"
 #include "envoy/network/connection.h"
 #include "envoy/ssl/context.h"
 #include "envoy/upstream/health_check_host_monitor.h"
@@ -114,6 +116,26 @@ public:
    * @param new_used supplies the new value of host being in use to be stored.
    */
   virtual void used(bool new_used) PURE;
+
+  /**
+   * @return MonotonicTime when the host was added, or last recovered from an outlier ejection or
+   *         from failing active health checks. Load balancers ramp up the share of requests they
+   *         send to the host over their slow start window from then on.
+   */
+  virtual MonotonicTime slowStartTime() const PURE;
+
+  /**
+   * Restart the slow start of the host, e.g. when it recovers.
+   * @param time supplies the time from which the host is ramped up.
+   */
+  virtual void slowStartTime(MonotonicTime time) PURE;
+
+  /**
+   * @return uint32_t a small integer index of the host, which is unique among the hosts which
+   *         currently exist and is reused once the host is destroyed. Per host data can be kept in
+   *         a vector indexed by it, as long as the data keeps the host alive.
+   */
+  virtual uint32_t index() const PURE;
 };
 
 typedef std::shared_ptr<const Host> HostConstSharedPtr;
@@ -126,6 +148,7 @@ class HostSet {
 public:
   typedef std::shared_ptr<const std::vector<HostSharedPtr>> HostVectorConstSharedPtr;
   typedef std::shared_ptr<const std::vector<std::vector<HostSharedPtr>>> HostListsConstSharedPtr;
+  typedef std::shared_ptr<const std::vector<uint32_t>> LocalityWeightsConstSharedPtr;
 
   virtual ~HostSet() {}
 
@@ -175,6 +198,13 @@ public:
    */
   virtual const std::vector<std::vector<HostSharedPtr>>& healthyHostsPerLocality() const PURE;
 
+  /**
+   * @return the load balancing weights of the localities in hostsPerLocality(), in the same order,
+   *         or nullptr if the localities are not weighted. In that case index 0 of
+   *         hostsPerLocality() need not be the local locality.
+   */
+  virtual LocalityWeightsConstSharedPtr localityWeights() const PURE;
+
   /**
    * Updates the hosts in a given host set.
    *
@@ -182,12 +212,15 @@ public:
    * @param healthy hosts supplies the subset of hosts which are healthy.
    * @param hosts_per_locality supplies the hosts subdivided by locality.
    * @param hosts_per_locality supplies the healthy hosts subdivided by locality.
+   * @param locality_weights supplies the weights of the localities, or nullptr if they are not
+   *        weighted.
    * @param hosts_added supplies the hosts added since the last update.
    * @param hosts_removed supplies the hosts removed since the last update.
    */
   virtual void updateHosts(HostVectorConstSharedPtr hosts, HostVectorConstSharedPtr healthy_hosts,
                            HostListsConstSharedPtr hosts_per_locality,
                            HostListsConstSharedPtr healthy_hosts_per_locality,
+                           LocalityWeightsConstSharedPtr locality_weights,
                            const std::vector<HostSharedPtr>& hosts_added,
                            const std::vector<HostSharedPtr>& hosts_removed) PURE;
 
@@ -261,6 +294,8 @@ public:
   COUNTER  (upstream_cx_connect_timeout)                                                           \
   COUNTER  (upstream_cx_connect_attempts_exceeded)                                                 \
   COUNTER  (upstream_cx_overflow)                                                                  \
+  COUNTER  (upstream_cx_prefetched)                                                                \
+  COUNTER  (upstream_cx_idle_timeout)                                                              \
   HISTOGRAM(upstream_cx_connect_ms)                                                                \
   HISTOGRAM(upstream_cx_length_ms)                                                                 \
   COUNTER  (upstream_cx_destroy)                                                                   \
@@ -272,13 +307,16 @@ public:
   COUNTER  (upstream_cx_close_notify)                                                              \
   COUNTER  (upstream_cx_rx_bytes_total)                                                            \
   GAUGE    (upstream_cx_rx_bytes_buffered)                                                         \
+  COUNTER  (upstream_cx_rx_syscalls_total)                                                         \
   COUNTER  (upstream_cx_tx_bytes_total)                                                            \
   GAUGE    (upstream_cx_tx_bytes_buffered)                                                         \
+  COUNTER  (upstream_cx_tx_syscalls_total)                                                         \
   COUNTER  (upstream_cx_protocol_error)                                                            \
   COUNTER  (upstream_cx_max_requests)                                                              \
   COUNTER  (upstream_cx_none_healthy)                                                              \
   COUNTER  (upstream_rq_total)                                                                     \
   GAUGE    (upstream_rq_active)                                                                    \
+  COUNTER  (upstream_rq_pipelined)                                                                 \
   COUNTER  (upstream_rq_pending_total)                                                             \
   COUNTER  (upstream_rq_pending_overflow)                                                          \
   COUNTER  (upstream_rq_pending_failure_eject)                                                     \
@@ -292,6 +330,7 @@ public:
   COUNTER  (upstream_rq_retry)                                                                     \
   COUNTER  (upstream_rq_retry_success)                                                             \
   COUNTER  (upstream_rq_retry_overflow)                                                            \
+  COUNTER  (upstream_rq_shadow_overflow)                                                           \
   COUNTER  (upstream_flow_control_paused_reading_total)                                            \
   COUNTER  (upstream_flow_control_resumed_reading_total)                                           \
   COUNTER  (upstream_flow_control_backed_up_total)                                                 \
@@ -341,6 +380,9 @@ public:
   struct Features {
     // Whether the upstream supports HTTP2. This is used when creating connection pools.
     static const uint64_t HTTP2 = 0x1;
+    // Whether the upstream supports gzip compressed gRPC messages. This is used by the gRPC
+    // streams Envoy originates to the cluster.
+    static const uint64_t GRPC_COMPRESSION = 0x2;
   };
 
   virtual ~ClusterInfo() {}
@@ -397,6 +439,40 @@ public:
    */
   virtual uint64_t maxRequestsPerConnection() const PURE;
 
+  /**
+   * @return uint32_t the number of connections that an HTTP/2 connection pool spreads its streams
+   *         over. New streams go to the connection with the fewest active streams. This is at
+   *         least 1.
+   */
+  virtual uint32_t http2ConnectionsPerHost() const PURE;
+
+  /**
+   * @return uint32_t the number of connections that an HTTP/1.1 connection pool keeps open or
+   *         connecting for every 100 active and pending requests. Values above 100 open
+   *         connections ahead of demand. This is at least 100.
+   */
+  virtual uint32_t http1PrefetchPercent() const PURE;
+
+  /**
+   * @return uint32_t the number of idle connections that an HTTP/1.1 connection pool keeps open or
+   *         connecting on top of those serving its active and pending requests.
+   */
+  virtual uint32_t http1MinIdleConnections() const PURE;
+
+  /**
+   * @return std::chrono::milliseconds how long an HTTP/1.1 connection pool keeps a connection idle
+   *         before closing it, unless the pool is down to http1MinIdleConnections() idle
+   *         connections. 0 means that idle connections are not closed.
+   */
+  virtual std::chrono::milliseconds http1IdleTimeout() const PURE;
+
+  /**
+   * @return uint32_t the number of requests that an HTTP/1.1 connection pool may have in flight
+   *         on a connection, by pipelining requests without a body and with a safe method behind
+   *         those awaiting their response. 1 means that requests are not pipelined.
+   */
+  virtual uint32_t http1MaxPipelinedRequests() const PURE;
+
   /**
    * @return the human readable name of the cluster.
    */
@@ -424,6 +500,11 @@ public:
    */
   virtual Stats::Scope& statsScope() const PURE;
 
+  /**
+   * @return Http::CodeStats& the response code stats of the cluster, which are in statsScope().
+   */
+  virtual Http::CodeStats& codeStats() const PURE;
+
   /**
    * @return ClusterLoadReportStats& strongly named load report stats for this cluster.
    */
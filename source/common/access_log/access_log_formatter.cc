@@ -1,6 +1,8 @@
 #include "common/access_log/access_log_formatter.h"
 
+#include <chrono>
 #include <cstdint>
+#include <ctime>
 #include <string>
 #include <vector>
 
@@ -28,66 +30,74 @@ const std::string ResponseFlagUtils::DELAY_INJECTED = "DI";
 const std::string ResponseFlagUtils::FAULT_INJECTED = "FI";
 const std::string ResponseFlagUtils::RATE_LIMITED = "RL";
 
-void ResponseFlagUtils::appendString(std::string& result, const std::string& append) {
-  if (result.empty()) {
-    result = append;
-  } else {
-    result += "," + append;
+void ResponseFlagUtils::appendString(std::string& result, size_t start,
+                                     const std::string& append) {
+  if (result.size() > start) {
+    result += ',';
   }
+  result += append;
 }
 
 const std::string ResponseFlagUtils::toShortString(const RequestInfo& request_info) {
   std::string result;
+  appendShortString(request_info, result);
+  return result;
+}
+
+void ResponseFlagUtils::appendShortString(const RequestInfo& request_info, std::string& output) {
+  const size_t start = output.size();
 
   if (request_info.getResponseFlag(ResponseFlag::FailedLocalHealthCheck)) {
-    appendString(result, FAILED_LOCAL_HEALTH_CHECK);
+    appendString(output, start, FAILED_LOCAL_HEALTH_CHECK);
   }
 
   if (request_info.getResponseFlag(ResponseFlag::NoHealthyUpstream)) {
-    appendString(result, NO_HEALTHY_UPSTREAM);
+    appendString(output, start, NO_HEALTHY_UPSTREAM);
   }
 
   if (request_info.getResponseFlag(ResponseFlag::UpstreamRequestTimeout)) {
-    appendString(result, UPSTREAM_REQUEST_TIMEOUT);
+    appendString(output, start, UPSTREAM_REQUEST_TIMEOUT);
   }
 
   if (request_info.getResponseFlag(ResponseFlag::LocalReset)) {
-    appendString(result, LOCAL_RESET);
+    appendString(output, start, LOCAL_RESET);
   }
 
   if (request_info.getResponseFlag(ResponseFlag::UpstreamRemoteReset)) {
-    appendString(result, UPSTREAM_REMOTE_RESET);
+    appendString(output, start, UPSTREAM_REMOTE_RESET);
   }
 
   if (request_info.getResponseFlag(ResponseFlag::UpstreamConnectionFailure)) {
-    appendString(result, UPSTREAM_CONNECTION_FAILURE);
+    appendString(output, start, UPSTREAM_CONNECTION_FAILURE);
   }
 
   if (request_info.getResponseFlag(ResponseFlag::UpstreamConnectionTermination)) {
-    appendString(result, UPSTREAM_CONNECTION_TERMINATION);
+    appendString(output, start, UPSTREAM_CONNECTION_TERMINATION);
   }
 
   if (request_info.getResponseFlag(ResponseFlag::UpstreamOverflow)) {
-    appendString(result, UPSTREAM_OVERFLOW);
+    appendString(output, start, UPSTREAM_OVERFLOW);
   }
 
   if (request_info.getResponseFlag(ResponseFlag::NoRouteFound)) {
-    appendString(result, NO_ROUTE_FOUND);
+    appendString(output, start, NO_ROUTE_FOUND);
   }
 
   if (request_info.getResponseFlag(ResponseFlag::DelayInjected)) {
-    appendString(result, DELAY_INJECTED);
+    appendString(output, start, DELAY_INJECTED);
   }
 
   if (request_info.getResponseFlag(ResponseFlag::FaultInjected)) {
-    appendString(result, FAULT_INJECTED);
+    appendString(output, start, FAULT_INJECTED);
   }
 
   if (request_info.getResponseFlag(ResponseFlag::RateLimited)) {
-    appendString(result, RATE_LIMITED);
+    appendString(output, start, RATE_LIMITED);
   }
 
-  return result.empty() ? NONE : result;
+  if (output.size() == start) {
+    output += NONE;
+  }
 }
 
 const std::string AccessLogFormatUtils::DEFAULT_FORMAT =
@@ -132,12 +142,18 @@ std::string FormatterImpl::format(const Http::HeaderMap& request_headers,
                                   const RequestInfo& request_info) const {
   std::string log_line;
   log_line.reserve(256);
+  formatInto(request_headers, response_headers, request_info, log_line);
+  return log_line;
+}
 
+void FormatterImpl::formatInto(const Http::HeaderMap& request_headers,
+                               const Http::HeaderMap& response_headers,
+                               const RequestInfo& request_info, std::string& output) const {
+  // The format string is parsed once into formatters which each append their field in place, so
+  // no string is built per field.
   for (const FormatterPtr& formatter : formatters_) {
-    log_line += formatter->format(request_headers, response_headers, request_info);
+    formatter->formatInto(request_headers, response_headers, request_info, output);
   }
-
-  return log_line;
 }
 
 void AccessLogFormatParser::parseCommand(const std::string& token, const size_t start,
@@ -232,85 +248,120 @@ std::vector<FormatterPtr> AccessLogFormatParser::parse(const std::string& format
   return formatters;
 }
 
+namespace {
+
+void appendInteger(uint64_t value, std::string& output) {
+  char buf[32];
+  output.append(buf, StringUtil::itoa(buf, sizeof(buf), value));
+}
+
+void appendMilliseconds(const Optional<std::chrono::microseconds>& duration,
+                        std::string& output) {
+  if (duration.valid()) {
+    appendInteger(
+        std::chrono::duration_cast<std::chrono::milliseconds>(duration.value()).count(), output);
+  } else {
+    output += UnspecifiedValueString;
+  }
+}
+
+void appendStartTime(const SystemTime& time, std::string& output) {
+  // Requests logged by a worker mostly start within the same second, so the formatted seconds are
+  // cached and only the milliseconds are formatted for each request.
+  static thread_local time_t cached_seconds = -1;
+  static thread_local std::string cached_date;
+  const time_t seconds = std::chrono::system_clock::to_time_t(time);
+  if (seconds != cached_seconds) {
+    static DateFormatter date_format("%Y-%m-%dT%H:%M:%S");
+    cached_date = date_format.fromTime(time);
+    cached_seconds = seconds;
+  }
+
+  const uint64_t milliseconds =
+      std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count() %
+      1000;
+  output += cached_date;
+  output += '.';
+  output += static_cast<char>('0' + milliseconds / 100);
+  output += static_cast<char>('0' + milliseconds / 10 % 10);
+  output += static_cast<char>('0' + milliseconds % 10);
+  output += 'Z';
+}
+
+} // namespace
+
 RequestInfoFormatter::RequestInfoFormatter(const std::string& field_name) {
   if (field_name == "START_TIME") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return AccessLogDateTimeFormatter::fromTime(request_info.startTime());
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
+      appendStartTime(request_info.startTime(), output);
     };
   } else if (field_name == "REQUEST_DURATION") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      Optional<std::chrono::microseconds> duration = request_info.requestReceivedDuration();
-      if (duration.valid()) {
-        return std::to_string(
-            std::chrono::duration_cast<std::chrono::milliseconds>(duration.value()).count());
-      } else {
-        return UnspecifiedValueString;
-      }
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
+      appendMilliseconds(request_info.requestReceivedDuration(), output);
     };
   } else if (field_name == "RESPONSE_DURATION") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      Optional<std::chrono::microseconds> duration = request_info.responseReceivedDuration();
-      if (duration.valid()) {
-        return std::to_string(
-            std::chrono::duration_cast<std::chrono::milliseconds>(duration.value()).count());
-      } else {
-        return UnspecifiedValueString;
-      }
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
+      appendMilliseconds(request_info.responseReceivedDuration(), output);
     };
   } else if (field_name == "BYTES_RECEIVED") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return std::to_string(request_info.bytesReceived());
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
+      appendInteger(request_info.bytesReceived(), output);
     };
   } else if (field_name == "PROTOCOL") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return AccessLogFormatUtils::protocolToString(request_info.protocol());
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
+      output += AccessLogFormatUtils::protocolToString(request_info.protocol());
     };
   } else if (field_name == "RESPONSE_CODE") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return request_info.responseCode().valid()
-                 ? std::to_string(request_info.responseCode().value())
-                 : "0";
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
+      appendInteger(request_info.responseCode().valid() ? request_info.responseCode().value() : 0,
+                    output);
     };
   } else if (field_name == "BYTES_SENT") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return std::to_string(request_info.bytesSent());
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
+      appendInteger(request_info.bytesSent(), output);
     };
   } else if (field_name == "DURATION") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return std::to_string(
-          std::chrono::duration_cast<std::chrono::milliseconds>(request_info.duration()).count());
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
+      appendInteger(
+          std::chrono::duration_cast<std::chrono::milliseconds>(request_info.duration()).count(),
+          output);
     };
   } else if (field_name == "RESPONSE_FLAGS") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return ResponseFlagUtils::toShortString(request_info);
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
+      ResponseFlagUtils::appendShortString(request_info, output);
     };
   } else if (field_name == "UPSTREAM_HOST") {
-    field_extractor_ = [](const RequestInfo& request_info) {
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
       if (request_info.upstreamHost()) {
-        return request_info.upstreamHost()->address()->asString();
+        output += request_info.upstreamHost()->address()->asString();
       } else {
-        return UnspecifiedValueString;
+        output += UnspecifiedValueString;
       }
     };
   } else if (field_name == "UPSTREAM_CLUSTER") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      std::string upstream_cluster_name;
-      if (nullptr != request_info.upstreamHost()) {
-        upstream_cluster_name = request_info.upstreamHost()->cluster().name();
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
+      if (nullptr != request_info.upstreamHost() &&
+          !request_info.upstreamHost()->cluster().name().empty()) {
+        output += request_info.upstreamHost()->cluster().name();
+      } else {
+        output += UnspecifiedValueString;
       }
-
-      return upstream_cluster_name.empty() ? UnspecifiedValueString : upstream_cluster_name;
     };
   } else if (field_name == "UPSTREAM_LOCAL_ADDRESS") {
-    field_extractor_ = [](const RequestInfo& request_info) {
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
       const Optional<std::string>& upstream_local_address = request_info.upstreamLocalAddress();
-      return upstream_local_address.valid() ? upstream_local_address.value()
-                                            : UnspecifiedValueString;
+      output += upstream_local_address.valid() ? upstream_local_address.value()
+                                               : UnspecifiedValueString;
     };
   } else if (field_name == "DOWNSTREAM_ADDRESS") {
-    field_extractor_ = [](const RequestInfo& request_info) {
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
       const std::string& downstream_address = request_info.getDownstreamAddress();
-      return downstream_address.empty() ? UnspecifiedValueString : downstream_address;
+      output += downstream_address.empty() ? UnspecifiedValueString : downstream_address;
+    };
+  } else if (field_name == "FILTER_TIMINGS") {
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
+      const std::string& filter_timings = request_info.filterTimings();
+      output += filter_timings.empty() ? UnspecifiedValueString : filter_timings;
     };
   } else {
     throw EnvoyException(fmt::format("Not supported field in RequestInfo: {}", field_name));
@@ -319,7 +370,14 @@ RequestInfoFormatter::RequestInfoFormatter(const std::string& field_name) {
 
 std::string RequestInfoFormatter::format(const Http::HeaderMap&, const Http::HeaderMap&,
                                          const RequestInfo& request_info) const {
-  return field_extractor_(request_info);
+  std::string output;
+  field_extractor_(request_info, output);
+  return output;
+}
+
+void RequestInfoFormatter::formatInto(const Http::HeaderMap&, const Http::HeaderMap&,
+                                      const RequestInfo& request_info, std::string& output) const {
+  field_extractor_(request_info, output);
 }
 
 PlainStringFormatter::PlainStringFormatter(const std::string& str) : str_(str) {}
@@ -329,30 +387,41 @@ std::string PlainStringFormatter::format(const Http::HeaderMap&, const Http::Hea
   return str_;
 }
 
+void PlainStringFormatter::formatInto(const Http::HeaderMap&, const Http::HeaderMap&,
+                                      const RequestInfo&, std::string& output) const {
+  output += str_;
+}
+
 HeaderFormatter::HeaderFormatter(const std::string& main_header,
                                  const std::string& alternative_header,
                                  const Optional<size_t>& max_length)
     : main_header_(main_header), alternative_header_(alternative_header), max_length_(max_length) {}
 
 std::string HeaderFormatter::format(const Http::HeaderMap& headers) const {
+  std::string output;
+  formatInto(headers, output);
+  return output;
+}
+
+void HeaderFormatter::formatInto(const Http::HeaderMap& headers, std::string& output) const {
   const Http::HeaderEntry* header = headers.get(main_header_);
 
   if (!header && !alternative_header_.get().empty()) {
     header = headers.get(alternative_header_);
   }
 
-  std::string header_value_string;
-  if (!header) {
-    header_value_string = UnspecifiedValueString;
-  } else {
-    header_value_string = header->value().c_str();
+  const char* value = UnspecifiedValueString.c_str();
+  size_t length = UnspecifiedValueString.length();
+  if (header) {
+    value = header->value().c_str();
+    length = header->value().size();
   }
 
-  if (max_length_.valid() && header_value_string.length() > max_length_.value()) {
-    return header_value_string.substr(0, max_length_.value());
+  if (max_length_.valid() && length > max_length_.value()) {
+    length = max_length_.value();
   }
 
-  return header_value_string;
+  output.append(value, length);
 }
 
 ResponseHeaderFormatter::ResponseHeaderFormatter(const std::string& main_header,
@@ -366,6 +435,12 @@ std::string ResponseHeaderFormatter::format(const Http::HeaderMap&,
   return HeaderFormatter::format(response_headers);
 }
 
+void ResponseHeaderFormatter::formatInto(const Http::HeaderMap&,
+                                         const Http::HeaderMap& response_headers,
+                                         const RequestInfo&, std::string& output) const {
+  HeaderFormatter::formatInto(response_headers, output);
+}
+
 RequestHeaderFormatter::RequestHeaderFormatter(const std::string& main_header,
                                                const std::string& alternative_header,
                                                const Optional<size_t>& max_length)
@@ -376,5 +451,11 @@ std::string RequestHeaderFormatter::format(const Http::HeaderMap& request_header
   return HeaderFormatter::format(request_headers);
 }
 
+void RequestHeaderFormatter::formatInto(const Http::HeaderMap& request_headers,
+                                        const Http::HeaderMap&, const RequestInfo&,
+                                        std::string& output) const {
+  HeaderFormatter::formatInto(request_headers, output);
+}
+
 } // namespace AccessLog
 } // namespace Envoy
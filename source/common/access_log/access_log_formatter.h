@@ -16,9 +16,14 @@ class ResponseFlagUtils {
 public:
   static const std::string toShortString(const RequestInfo& request_info);
 
+  /**
+   * Append the short string of the response flags to a string.
+   */
+  static void appendShortString(const RequestInfo& request_info, std::string& output);
+
 private:
   ResponseFlagUtils();
-  static void appendString(std::string& result, const std::string& append);
+  static void appendString(std::string& result, size_t start, const std::string& append);
 
   const static std::string NONE;
   const static std::string FAILED_LOCAL_HEALTH_CHECK;
@@ -72,6 +77,8 @@ public:
   std::string format(const Http::HeaderMap& request_headers,
                      const Http::HeaderMap& response_headers,
                      const RequestInfo& request_info) const override;
+  void formatInto(const Http::HeaderMap& request_headers, const Http::HeaderMap& response_headers,
+                  const RequestInfo& request_info, std::string& output) const override;
 
 private:
   std::vector<FormatterPtr> formatters_;
@@ -88,6 +95,8 @@ public:
   // Formatter::format
   std::string format(const Http::HeaderMap&, const Http::HeaderMap&,
                      const RequestInfo&) const override;
+  void formatInto(const Http::HeaderMap&, const Http::HeaderMap&, const RequestInfo&,
+                  std::string& output) const override;
 
 private:
   std::string str_;
@@ -99,6 +108,7 @@ public:
                   const Optional<size_t>& max_length);
 
   std::string format(const Http::HeaderMap& headers) const;
+  void formatInto(const Http::HeaderMap& headers, std::string& output) const;
 
 private:
   Http::LowerCaseString main_header_;
@@ -117,6 +127,8 @@ public:
   // Formatter::format
   std::string format(const Http::HeaderMap& request_headers, const Http::HeaderMap&,
                      const RequestInfo&) const override;
+  void formatInto(const Http::HeaderMap& request_headers, const Http::HeaderMap&,
+                  const RequestInfo&, std::string& output) const override;
 };
 
 /**
@@ -130,6 +142,8 @@ public:
   // Formatter::format
   std::string format(const Http::HeaderMap&, const Http::HeaderMap& response_headers,
                      const RequestInfo&) const override;
+  void formatInto(const Http::HeaderMap&, const Http::HeaderMap& response_headers,
+                  const RequestInfo&, std::string& output) const override;
 };
 
 /**
@@ -142,9 +156,11 @@ public:
   // Formatter::format
   std::string format(const Http::HeaderMap&, const Http::HeaderMap&,
                      const RequestInfo& request_info) const override;
+  void formatInto(const Http::HeaderMap&, const Http::HeaderMap&, const RequestInfo& request_info,
+                  std::string& output) const override;
 
 private:
-  std::function<std::string(const RequestInfo&)> field_extractor_;
+  std::function<void(const RequestInfo&, std::string&)> field_extractor_;
 };
 
 } // namespace AccessLog
@@ -15,6 +15,7 @@
 #include "common/http/header_map_impl.h"
 #include "common/http/headers.h"
 #include "common/http/utility.h"
+#include "common/runtime/key_registry.h"
 #include "common/runtime/uuid_util.h"
 #include "common/tracing/http_tracer_impl.h"
 
@@ -86,18 +87,38 @@ bool DurationFilter::evaluate(const RequestInfo& info, const Http::HeaderMap&) {
 
 RuntimeFilter::RuntimeFilter(const envoy::api::v2::filter::accesslog::RuntimeFilter& config,
                              Runtime::Loader& runtime)
-    : runtime_(runtime), runtime_key_(config.runtime_key()) {}
+    : runtime_(runtime), runtime_key_(Runtime::KeyRegistry::registerKey(config.runtime_key())),
+      keep_errors_key_(Runtime::KeyRegistry::registerKey(config.runtime_key() + ".keep_errors")),
+      keep_duration_key_(
+          Runtime::KeyRegistry::registerKey(config.runtime_key() + ".keep_duration_ms")) {}
+
+bool RuntimeFilter::keep(const Runtime::Snapshot& snapshot, const RequestInfo& info) const {
+  if (snapshot.getInteger(keep_errors_key_, 0) != 0 &&
+      (!info.responseCode().valid() || info.responseCode().value() >= 500)) {
+    return true;
+  }
+  const uint64_t keep_duration_ms = snapshot.getInteger(keep_duration_key_, 0);
+  return keep_duration_ms > 0 &&
+         static_cast<uint64_t>(
+             std::chrono::duration_cast<std::chrono::milliseconds>(info.duration()).count()) >=
+             keep_duration_ms;
+}
+
+bool RuntimeFilter::evaluate(const RequestInfo& info, const Http::HeaderMap& request_header) {
+  const Runtime::Snapshot& snapshot = runtime_.snapshot();
+  if (keep(snapshot, info)) {
+    return true;
+  }
 
-bool RuntimeFilter::evaluate(const RequestInfo&, const Http::HeaderMap& request_header) {
   const Http::HeaderEntry* uuid = request_header.RequestId();
   uint16_t sampled_value;
-  if (uuid && UuidUtils::uuidModBy(uuid->value().c_str(), sampled_value, 100)) {
-    uint64_t runtime_value =
-        std::min<uint64_t>(runtime_.snapshot().getInteger(runtime_key_, 0), 100);
+  if (uuid && UuidUtils::uuidModBy(uuid->value().c_str(), uuid->value().size(), sampled_value,
+                                   100)) {
+    uint64_t runtime_value = std::min<uint64_t>(snapshot.getInteger(runtime_key_, 0), 100);
 
     return sampled_value < static_cast<uint16_t>(runtime_value);
   } else {
-    return runtime_.snapshot().featureEnabled(runtime_key_, 0);
+    return snapshot.featureEnabled(runtime_key_, 0);
   }
 }
 
@@ -186,8 +207,10 @@ void FileAccessLog::log(const Http::HeaderMap* request_headers,
     }
   }
 
-  std::string access_log_line =
-      formatter_->format(*request_headers, *response_headers, request_info);
+  // The line is built in a string owned by the worker, which keeps its capacity across requests.
+  static thread_local std::string access_log_line;
+  access_log_line.clear();
+  formatter_->formatInto(*request_headers, *response_headers, request_info, access_log_line);
   log_file_->write(access_log_line);
 }
 
@@ -123,7 +123,10 @@ public:
 };
 
 /**
- * Filter that uses a runtime feature key to check if the log should be written.
+ * Filter that uses a runtime feature key to check if the log should be written. The sampling can
+ * be biased towards interesting requests with two more runtime keys: errors (requests with no
+ * response or a 5xx response) are always written when <key>.keep_errors is set, and requests
+ * taking at least <key>.keep_duration_ms when it is set.
  */
 class RuntimeFilter : public Filter {
 public:
@@ -134,8 +137,13 @@ public:
   bool evaluate(const RequestInfo& info, const Http::HeaderMap& request_headers) override;
 
 private:
+  bool keep(const Runtime::Snapshot& snapshot, const RequestInfo& info) const;
+
   Runtime::Loader& runtime_;
-  const std::string runtime_key_;
+  // Evaluated for every request, so resolved up front.
+  const Runtime::Key runtime_key_;
+  const Runtime::Key keep_errors_key_;
+  const Runtime::Key keep_duration_key_;
 };
 
 /**
@@ -0,0 +1,62 @@
+#include "common/access_log/binary_access_log_impl.h"
+
+#include <string>
+
+#include "common/access_log/grpc_access_log_impl.h"
+#include "common/http/header_map_impl.h"
+
+namespace Envoy {
+namespace AccessLog {
+
+void BinaryAccessLogFormat::append(const envoy::access_log::HTTPAccessLogEntry& entry,
+                                   std::string& output) {
+  const uint32_t size = entry.ByteSize();
+  const size_t offset = output.size();
+  output.resize(offset + Protobuf::io::CodedOutputStream::VarintSize32(size) + size);
+  uint8_t* target = reinterpret_cast<uint8_t*>(&output[offset]);
+  target = Protobuf::io::CodedOutputStream::WriteVarint32ToArray(size, target);
+  entry.SerializeWithCachedSizesToArray(target);
+}
+
+bool BinaryAccessLogFormat::read(Protobuf::io::CodedInputStream& input,
+                                 envoy::access_log::HTTPAccessLogEntry& entry) {
+  uint32_t size;
+  if (!input.ReadVarint32(&size)) {
+    return false;
+  }
+  const Protobuf::io::CodedInputStream::Limit limit = input.PushLimit(size);
+  entry.Clear();
+  const bool parsed = entry.MergeFromCodedStream(&input) && input.ConsumedEntireMessage();
+  input.PopLimit(limit);
+  return parsed;
+}
+
+BinaryFileAccessLog::BinaryFileAccessLog(const std::string& access_log_path, FilterPtr&& filter,
+                                         AccessLogManager& log_manager)
+    : filter_(std::move(filter)) {
+  log_file_ = log_manager.createAccessLog(access_log_path);
+}
+
+void BinaryFileAccessLog::log(const Http::HeaderMap* request_headers, const Http::HeaderMap*,
+                              const RequestInfo& request_info) {
+  static Http::HeaderMapImpl empty_headers;
+  if (!request_headers) {
+    request_headers = &empty_headers;
+  }
+
+  if (filter_ && !filter_->evaluate(request_info, *request_headers)) {
+    return;
+  }
+
+  // The entry and its encoding are owned by the worker, and keep their allocations across requests.
+  static thread_local envoy::access_log::HTTPAccessLogEntry entry;
+  static thread_local std::string record;
+  entry.Clear();
+  HttpGrpcAccessLog::populateEntry(*request_headers, request_info, entry);
+  record.clear();
+  BinaryAccessLogFormat::append(entry, record);
+  log_file_->write(record);
+}
+
+} // namespace AccessLog
+} // namespace Envoy
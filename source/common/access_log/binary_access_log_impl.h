@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+
+#include "envoy/access_log/access_log.h"
+#include "envoy/filesystem/filesystem.h"
+
+#include "common/protobuf/protobuf.h"
+
+#include "source/common/access_log/grpc_access_log.pb.h"
+
+namespace Envoy {
+namespace AccessLog {
+
+/**
+ * Framing of the entries of a binary access log file. Each entry is written with its size as a
+ * varint before it, as in a delimited protobuf stream, so a file is read without an index and with
+ * no escaping.
+ */
+class BinaryAccessLogFormat {
+public:
+  /**
+   * Append an entry to a buffer.
+   * @param entry supplies the entry.
+   * @param output supplies the buffer.
+   */
+  static void append(const envoy::access_log::HTTPAccessLogEntry& entry, std::string& output);
+
+  /**
+   * Read the next entry of a binary access log.
+   * @param input supplies the stream to read from.
+   * @param entry supplies the entry to fill.
+   * @return bool whether an entry was read, false if the input is truncated or corrupt.
+   */
+  static bool read(Protobuf::io::CodedInputStream& input,
+                   envoy::access_log::HTTPAccessLogEntry& entry);
+};
+
+/**
+ * Access log Instance that writes the entries of the gRPC access log to a file in binary form,
+ * which is smaller and cheaper to produce than a formatted line.
+ */
+class BinaryFileAccessLog : public Instance {
+public:
+  BinaryFileAccessLog(const std::string& access_log_path, FilterPtr&& filter,
+                      AccessLogManager& log_manager);
+
+  // AccessLog::Instance
+  void log(const Http::HeaderMap* request_headers, const Http::HeaderMap* response_headers,
+           const RequestInfo& request_info) override;
+
+private:
+  Filesystem::FileSharedPtr log_file_;
+  FilterPtr filter_;
+};
+
+} // namespace AccessLog
+} // namespace Envoy
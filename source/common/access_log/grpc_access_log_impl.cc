@@ -0,0 +1,168 @@
+#include "common/access_log/grpc_access_log_impl.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "common/access_log/access_log_formatter.h"
+#include "common/http/header_map_impl.h"
+
+namespace Envoy {
+namespace AccessLog {
+
+GrpcAccessLogStreamer::GrpcAccessLogStreamer(AccessLogServiceAsyncClientPtr&& client,
+                                             const std::string& log_name,
+                                             const LocalInfo::LocalInfo& local_info,
+                                             Event::Dispatcher& dispatcher,
+                                             std::chrono::milliseconds flush_interval,
+                                             uint64_t buffer_size_bytes,
+                                             const GrpcAccessLogStats& stats)
+    : client_(std::move(client)),
+      service_method_(*Protobuf::DescriptorPool::generated_pool()->FindMethodByName(
+          "envoy.access_log.AccessLogService.StreamAccessLogs")),
+      flush_interval_(flush_interval), buffer_size_bytes_(buffer_size_bytes), stats_(stats),
+      flush_timer_(dispatcher.createTimer([this]() -> void {
+        flush();
+        flush_timer_->enableTimer(flush_interval_);
+      })) {
+  identifier_.set_node(local_info.nodeName());
+  identifier_.set_cluster(local_info.clusterName());
+  identifier_.set_log_name(log_name);
+  flush_timer_->enableTimer(flush_interval_);
+}
+
+GrpcAccessLogStreamer::~GrpcAccessLogStreamer() {
+  if (stream_ != nullptr) {
+    stream_->resetStream();
+  }
+}
+
+void GrpcAccessLogStreamer::log(envoy::access_log::HTTPAccessLogEntry&& entry) {
+  buffered_bytes_ += entry.ByteSize();
+  message_.mutable_http_logs()->Add()->Swap(&entry);
+  if (buffered_bytes_ >= buffer_size_bytes_) {
+    flush();
+  }
+}
+
+void GrpcAccessLogStreamer::flush() {
+  if (message_.http_logs().empty()) {
+    return;
+  }
+
+  if (stream_ == nullptr) {
+    stream_ = client_->start(service_method_, *this);
+    if (stream_ == nullptr) {
+      ENVOY_LOG(debug, "unable to start access log stream");
+      stats_.logs_dropped_.add(message_.http_logs_size());
+      clearBuffered();
+      return;
+    }
+
+    // The service learns who is logging from the first message of each stream.
+    *message_.mutable_identifier() = identifier_;
+  }
+
+  stream_->sendMessage(message_, false);
+  stats_.logs_sent_.add(message_.http_logs_size());
+  stats_.batches_sent_.inc();
+  clearBuffered();
+}
+
+void GrpcAccessLogStreamer::clearBuffered() {
+  message_.Clear();
+  buffered_bytes_ = 0;
+}
+
+void GrpcAccessLogStreamer::onRemoteClose(Grpc::Status::GrpcStatus status,
+                                          const std::string& message) {
+  ENVOY_LOG(debug, "access log stream closed: {}, {}", status, message);
+  stats_.streams_closed_.inc();
+  stream_ = nullptr;
+}
+
+HttpGrpcAccessLog::HttpGrpcAccessLog(FilterPtr&& filter,
+                                     const envoy::access_log::HttpGrpcAccessLogConfig& config,
+                                     ThreadLocal::SlotAllocator& tls,
+                                     AccessLogServiceAsyncClientFactory client_factory,
+                                     const LocalInfo::LocalInfo& local_info, Stats::Scope& scope)
+    : filter_(std::move(filter)),
+      stats_{ALL_GRPC_ACCESS_LOG_STATS(POOL_COUNTER_PREFIX(scope, "access_log.grpc."))},
+      tls_slot_(tls.allocateSlot()) {
+  const std::string log_name = config.log_name();
+  const std::chrono::milliseconds flush_interval(
+      config.flush_interval_ms() > 0 ? config.flush_interval_ms() : DEFAULT_FLUSH_INTERVAL_MS);
+  const uint64_t buffer_size_bytes =
+      config.buffer_size_bytes() > 0 ? config.buffer_size_bytes() : DEFAULT_BUFFER_SIZE_BYTES;
+  GrpcAccessLogStats stats = stats_;
+  tls_slot_->set([client_factory, log_name, &local_info, flush_interval, buffer_size_bytes,
+                  stats](Event::Dispatcher& dispatcher) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<GrpcAccessLogStreamer>(client_factory(), log_name, local_info,
+                                                   dispatcher, flush_interval, buffer_size_bytes,
+                                                   stats);
+  });
+}
+
+void HttpGrpcAccessLog::populateEntry(const Http::HeaderMap& request_headers,
+                                      const RequestInfo& request_info,
+                                      envoy::access_log::HTTPAccessLogEntry& entry) {
+  entry.set_start_time_unix_us(std::chrono::duration_cast<std::chrono::microseconds>(
+                                   request_info.startTime().time_since_epoch())
+                                   .count());
+  entry.set_duration_us(request_info.duration().count());
+  if (request_info.protocol().valid()) {
+    entry.set_protocol(AccessLogFormatUtils::protocolToString(request_info.protocol()));
+  }
+
+  if (request_headers.Method() != nullptr) {
+    entry.set_method(request_headers.Method()->value().c_str());
+  }
+  if (request_headers.EnvoyOriginalPath() != nullptr) {
+    entry.set_path(request_headers.EnvoyOriginalPath()->value().c_str());
+  } else if (request_headers.Path() != nullptr) {
+    entry.set_path(request_headers.Path()->value().c_str());
+  }
+  if (request_headers.Host() != nullptr) {
+    entry.set_authority(request_headers.Host()->value().c_str());
+  }
+  if (request_headers.UserAgent() != nullptr) {
+    entry.set_user_agent(request_headers.UserAgent()->value().c_str());
+  }
+  if (request_headers.ForwardedFor() != nullptr) {
+    entry.set_forwarded_for(request_headers.ForwardedFor()->value().c_str());
+  }
+  if (request_headers.RequestId() != nullptr) {
+    entry.set_request_id(request_headers.RequestId()->value().c_str());
+  }
+
+  if (request_info.responseCode().valid()) {
+    entry.set_response_code(request_info.responseCode().value());
+  }
+  entry.set_response_flags(ResponseFlagUtils::toShortString(request_info));
+  entry.set_bytes_received(request_info.bytesReceived());
+  entry.set_bytes_sent(request_info.bytesSent());
+  if (request_info.upstreamHost() != nullptr) {
+    entry.set_upstream_host(request_info.upstreamHost()->address()->asString());
+    entry.set_upstream_cluster(request_info.upstreamHost()->cluster().name());
+  }
+  entry.set_downstream_address(request_info.getDownstreamAddress());
+}
+
+void HttpGrpcAccessLog::log(const Http::HeaderMap* request_headers, const Http::HeaderMap*,
+                            const RequestInfo& request_info) {
+  static Http::HeaderMapImpl empty_headers;
+  if (!request_headers) {
+    request_headers = &empty_headers;
+  }
+
+  if (filter_ && !filter_->evaluate(request_info, *request_headers)) {
+    return;
+  }
+
+  envoy::access_log::HTTPAccessLogEntry entry;
+  populateEntry(*request_headers, request_info, entry);
+  tls_slot_->getTyped<GrpcAccessLogStreamer>().log(std::move(entry));
+}
+
+} // namespace AccessLog
+} // namespace Envoy
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "envoy/access_log/access_log.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/grpc/async_client.h"
+#include "envoy/local_info/local_info.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/common/logger.h"
+#include "common/protobuf/protobuf.h"
+
+#include "source/common/access_log/grpc_access_log.pb.h"
+
+namespace Envoy {
+namespace AccessLog {
+
+/**
+ * All gRPC access log stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_GRPC_ACCESS_LOG_STATS(COUNTER)                                                         \
+  COUNTER(logs_sent)                                                                               \
+  COUNTER(logs_dropped)                                                                            \
+  COUNTER(batches_sent)                                                                            \
+  COUNTER(streams_closed)
+// clang-format on
+
+/**
+ * Struct definition for all gRPC access log stats. @see stats_macros.h
+ */
+struct GrpcAccessLogStats {
+  ALL_GRPC_ACCESS_LOG_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+typedef Grpc::AsyncClient<envoy::access_log::StreamAccessLogsMessage,
+                          envoy::access_log::StreamAccessLogsResponse>
+    AccessLogServiceAsyncClient;
+typedef std::unique_ptr<AccessLogServiceAsyncClient> AccessLogServiceAsyncClientPtr;
+
+/**
+ * Creates the client used by a worker to talk to the access log service.
+ */
+typedef std::function<AccessLogServiceAsyncClientPtr()> AccessLogServiceAsyncClientFactory;
+
+/**
+ * Buffers the entries logged by one worker, and sends them in batches on a long lived stream to
+ * the access log service. A batch is sent once its approximate size reaches the buffer size, or
+ * when the flush timer fires. The stream is opened when the first batch is sent and reopened by
+ * the next batch if it is closed. A batch which can't be sent is dropped.
+ */
+class GrpcAccessLogStreamer
+    : public ThreadLocal::ThreadLocalObject,
+      public Grpc::AsyncStreamCallbacks<envoy::access_log::StreamAccessLogsResponse>,
+      Logger::Loggable<Logger::Id::upstream> {
+public:
+  GrpcAccessLogStreamer(AccessLogServiceAsyncClientPtr&& client, const std::string& log_name,
+                        const LocalInfo::LocalInfo& local_info, Event::Dispatcher& dispatcher,
+                        std::chrono::milliseconds flush_interval, uint64_t buffer_size_bytes,
+                        const GrpcAccessLogStats& stats);
+  ~GrpcAccessLogStreamer();
+
+  /**
+   * Buffer an entry, and send the batch if it is big enough.
+   */
+  void log(envoy::access_log::HTTPAccessLogEntry&& entry);
+
+  /**
+   * Send the buffered entries, if any.
+   */
+  void flush();
+
+  // Grpc::AsyncStreamCallbacks
+  void onCreateInitialMetadata(Http::HeaderMap&) override {}
+  void onReceiveInitialMetadata(Http::HeaderMapPtr&&) override {}
+  void onReceiveMessage(std::unique_ptr<envoy::access_log::StreamAccessLogsResponse>&&) override {}
+  void onReceiveTrailingMetadata(Http::HeaderMapPtr&&) override {}
+  void onRemoteClose(Grpc::Status::GrpcStatus status, const std::string& message) override;
+
+private:
+  void clearBuffered();
+
+  AccessLogServiceAsyncClientPtr client_;
+  Grpc::AsyncStream<envoy::access_log::StreamAccessLogsMessage>* stream_{};
+  const Protobuf::MethodDescriptor& service_method_;
+  envoy::access_log::StreamAccessLogsMessage::Identifier identifier_;
+  envoy::access_log::StreamAccessLogsMessage message_;
+  uint64_t buffered_bytes_{};
+  const std::chrono::milliseconds flush_interval_;
+  const uint64_t buffer_size_bytes_;
+  GrpcAccessLogStats stats_;
+  Event::TimerPtr flush_timer_;
+};
+
+/**
+ * Access log Instance that streams HTTP access logs to a gRPC access log service. Each worker
+ * batches its entries with its own GrpcAccessLogStreamer, so logging takes no lock.
+ */
+class HttpGrpcAccessLog : public Instance {
+public:
+  HttpGrpcAccessLog(FilterPtr&& filter, const envoy::access_log::HttpGrpcAccessLogConfig& config,
+                    ThreadLocal::SlotAllocator& tls,
+                    AccessLogServiceAsyncClientFactory client_factory,
+                    const LocalInfo::LocalInfo& local_info, Stats::Scope& scope);
+
+  /**
+   * Fill an entry from a request.
+   */
+  static void populateEntry(const Http::HeaderMap& request_headers, const RequestInfo& request_info,
+                            envoy::access_log::HTTPAccessLogEntry& entry);
+
+  // AccessLog::Instance
+  void log(const Http::HeaderMap* request_headers, const Http::HeaderMap* response_headers,
+           const RequestInfo& request_info) override;
+
+private:
+  static const uint32_t DEFAULT_FLUSH_INTERVAL_MS = 1000;
+  static const uint64_t DEFAULT_BUFFER_SIZE_BYTES = 16384;
+
+  FilterPtr filter_;
+  GrpcAccessLogStats stats_;
+  ThreadLocal::SlotPtr tls_slot_;
+};
+
+} // namespace AccessLog
+} // namespace Envoy
@@ -15,6 +15,12 @@ struct RequestInfoImpl : public RequestInfo {
 
   RequestInfoImpl(Http::Protocol protocol) : RequestInfoImpl() { protocol_ = protocol; }
 
+  RequestInfoImpl(Http::Protocol protocol, SystemTime start_time,
+                  MonotonicTime start_time_monotonic)
+      : start_time_(start_time), start_time_monotonic_(start_time_monotonic) {
+    protocol_ = protocol;
+  }
+
   // AccessLog::RequestInfo
   SystemTime startTime() const override { return start_time_; }
 
@@ -70,6 +76,8 @@ struct RequestInfoImpl : public RequestInfo {
 
   const std::string& getDownstreamAddress() const override { return downstream_address_; };
 
+  const std::string& filterTimings() const override { return filter_timings_; }
+
   Optional<Http::Protocol> protocol_;
   const SystemTime start_time_;
   const MonotonicTime start_time_monotonic_;
@@ -83,6 +91,7 @@ struct RequestInfoImpl : public RequestInfo {
   Optional<std::string> upstream_local_address_{};
   bool hc_request_{};
   std::string downstream_address_;
+  std::string filter_timings_;
 };
 
 } // namespace AccessLog
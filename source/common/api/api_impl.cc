@@ -16,6 +16,8 @@ Event::DispatcherPtr Impl::allocateDispatcher() {
 Impl::Impl(std::chrono::milliseconds file_flush_interval_msec)
     : file_flush_interval_msec_(file_flush_interval_msec) {}
 
+Impl::~Impl() { shutdownThreadPool(); }
+
 Filesystem::FileSharedPtr Impl::createFile(const std::string& path, Event::Dispatcher& dispatcher,
                                            Thread::BasicLockable& lock, Stats::Store& stats_store) {
   return std::make_shared<Filesystem::FileImpl>(path, dispatcher, lock, stats_store,
@@ -26,5 +28,61 @@ bool Impl::fileExists(const std::string& path) { return Filesystem::fileExists(p
 
 std::string Impl::fileReadToEnd(const std::string& path) { return Filesystem::fileReadToEnd(path); }
 
+void Impl::runOnThreadPool(std::function<void()> work, Event::Dispatcher& dispatcher,
+                           std::function<void()> on_complete) {
+  {
+    std::unique_lock<std::mutex> lock(pool_lock_);
+    if (pool_shutdown_) {
+      return;
+    }
+
+    if (pool_threads_.empty()) {
+      for (uint32_t i = 0; i < THREAD_POOL_SIZE; i++) {
+        pool_threads_.emplace_back(new Thread::Thread([this]() -> void { threadPoolRoutine(); }));
+      }
+    }
+
+    pool_work_.push_back({std::move(work), &dispatcher, std::move(on_complete)});
+  }
+
+  pool_cv_.notify_one();
+}
+
+void Impl::shutdownThreadPool() {
+  std::vector<Thread::ThreadPtr> threads;
+  {
+    std::unique_lock<std::mutex> lock(pool_lock_);
+    pool_shutdown_ = true;
+    pool_work_.clear();
+    threads = std::move(pool_threads_);
+  }
+
+  pool_cv_.notify_all();
+  for (Thread::ThreadPtr& thread : threads) {
+    thread->join();
+  }
+}
+
+void Impl::threadPoolRoutine() {
+  while (true) {
+    PoolWork work;
+    {
+      std::unique_lock<std::mutex> lock(pool_lock_);
+      pool_cv_.wait(lock, [this]() -> bool { return pool_shutdown_ || !pool_work_.empty(); });
+      if (pool_shutdown_) {
+        return;
+      }
+
+      work = std::move(pool_work_.front());
+      pool_work_.pop_front();
+    }
+
+    work.work_();
+    if (work.on_complete_) {
+      work.dispatcher_->post(std::move(work.on_complete_));
+    }
+  }
+}
+
 } // namespace Api
 } // namespace Envoy
@@ -1,11 +1,18 @@
 #pragma once
 
 #include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "envoy/api/api.h"
 #include "envoy/filesystem/filesystem.h"
 
+#include "common/common/thread.h"
+
 namespace Envoy {
 namespace Api {
 
@@ -15,6 +22,7 @@ namespace Api {
 class Impl : public Api::Api {
 public:
   Impl(std::chrono::milliseconds file_flush_interval_msec);
+  ~Impl();
 
   // Api::Api
   Event::DispatcherPtr allocateDispatcher() override;
@@ -23,9 +31,29 @@ public:
                                        Stats::Store& stats_store) override;
   bool fileExists(const std::string& path) override;
   std::string fileReadToEnd(const std::string& path) override;
+  void runOnThreadPool(std::function<void()> work, Event::Dispatcher& dispatcher,
+                       std::function<void()> on_complete) override;
+  void shutdownThreadPool() override;
 
 private:
+  // The pool only runs occasional blocking work such as file reads and config parsing, so a couple
+  // of threads are enough. They are started on first use.
+  static const uint32_t THREAD_POOL_SIZE = 2;
+
+  struct PoolWork {
+    std::function<void()> work_;
+    Event::Dispatcher* dispatcher_{};
+    std::function<void()> on_complete_;
+  };
+
+  void threadPoolRoutine();
+
   std::chrono::milliseconds file_flush_interval_msec_;
+  std::mutex pool_lock_;
+  std::condition_variable pool_cv_;
+  std::list<PoolWork> pool_work_;
+  bool pool_shutdown_{};
+  std::vector<Thread::ThreadPtr> pool_threads_;
 };
 
 } // namespace Api
@@ -2,6 +2,7 @@
 
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 namespace Envoy {
@@ -21,6 +22,10 @@ ssize_t OsSysCallsImpl::write(int fd, const void* buffer, size_t num_bytes) {
   return ::write(fd, buffer, num_bytes);
 }
 
+ssize_t OsSysCallsImpl::writev(int fd, const iovec* iov, int iovcnt) {
+  return ::writev(fd, iov, iovcnt);
+}
+
 int OsSysCallsImpl::shmOpen(const char* name, int oflag, mode_t mode) {
   return ::shm_open(name, oflag, mode);
 }
@@ -1,5 +1,7 @@
 #include "common/buffer/buffer_impl.h"
 
+#include <sys/uio.h>
+
 #include <cstdint>
 #include <string>
 
@@ -19,12 +21,58 @@ static_assert(offsetof(RawSlice, mem_) == offsetof(evbuffer_iovec, iov_base),
 static_assert(offsetof(RawSlice, len_) == offsetof(evbuffer_iovec, iov_len),
               "RawSlice != evbuffer_iovec");
 
-void OwnedImpl::add(const void* data, uint64_t size) { evbuffer_add(buffer_.get(), data, size); }
+// The native implementation passes RawSlice arrays directly to readv() and writev().
+static_assert(sizeof(RawSlice) == sizeof(iovec), "RawSlice != iovec");
+static_assert(offsetof(RawSlice, mem_) == offsetof(iovec, iov_base), "RawSlice != iovec");
+static_assert(offsetof(RawSlice, len_) == offsetof(iovec, iov_len), "RawSlice != iovec");
+
+const uint64_t OwnedSlice::DEFAULT_SIZE;
 
-void OwnedImpl::add(const std::string& data) {
-  evbuffer_add(buffer_.get(), data.c_str(), data.size());
+OwnedSlice::OwnedSlice(uint64_t size) : Slice(allocate(size), size) {}
+
+OwnedSlice::~OwnedSlice() {
+  if (size_ == DEFAULT_SIZE) {
+    SlabAllocator::deallocate(base_, size_);
+  } else {
+    delete[] base_;
+  }
+}
+
+uint8_t* OwnedSlice::allocate(uint64_t size) {
+  if (size == DEFAULT_SIZE) {
+    return static_cast<uint8_t*>(SlabAllocator::allocate(size));
+  }
+  return new uint8_t[size];
 }
 
+bool OwnedImpl::use_old_impl_ = true;
+const uint64_t OwnedImpl::MAX_IOVECS;
+const uint64_t OwnedImpl::COPY_THRESHOLD;
+
+void OwnedImpl::useOldImpl(bool use_old_impl) { use_old_impl_ = use_old_impl; }
+
+void OwnedImpl::add(const void* data, uint64_t size) {
+  const AccountUpdate account_update(*this);
+  if (old_impl_) {
+    evbuffer_add(buffer_.get(), data, size);
+    return;
+  }
+
+  const uint8_t* src = static_cast<const uint8_t*>(data);
+  uint64_t slice_index = firstReservableSlice();
+  while (size > 0) {
+    if (slice_index == slices_.size()) {
+      slices_.emplace_back(OwnedSlice::create(size));
+    }
+    const uint64_t copied = slices_[slice_index++]->append(src, size);
+    src += copied;
+    size -= copied;
+    length_ += copied;
+  }
+}
+
+void OwnedImpl::add(const std::string& data) { OwnedImpl::add(data.c_str(), data.size()); }
+
 void OwnedImpl::add(const Instance& data) {
   uint64_t num_slices = data.getRawSlices(nullptr, 0);
   RawSlice slices[num_slices];
@@ -34,90 +82,420 @@ void OwnedImpl::add(const Instance& data) {
   }
 }
 
+void OwnedImpl::addBufferFragment(BufferFragment& fragment) {
+  const AccountUpdate account_update(*this);
+  if (fragment.size() == 0) {
+    fragment.done();
+    return;
+  }
+
+  if (old_impl_) {
+    evbuffer_add_reference(
+        buffer_.get(), fragment.data(), fragment.size(),
+        [](const void*, size_t, void* arg) { static_cast<BufferFragment*>(arg)->done(); },
+        &fragment);
+    return;
+  }
+
+  length_ += fragment.size();
+  slices_.emplace(slices_.begin() + dataEnd(), SlicePtr{new UnownedSlice(fragment)});
+}
+
 void OwnedImpl::commit(RawSlice* iovecs, uint64_t num_iovecs) {
-  int rc =
-      evbuffer_commit_space(buffer_.get(), reinterpret_cast<evbuffer_iovec*>(iovecs), num_iovecs);
-  ASSERT(rc == 0);
-  UNREFERENCED_PARAMETER(rc);
+  const AccountUpdate account_update(*this);
+  if (old_impl_) {
+    int rc =
+        evbuffer_commit_space(buffer_.get(), reinterpret_cast<evbuffer_iovec*>(iovecs), num_iovecs);
+    ASSERT(rc == 0);
+    UNREFERENCED_PARAMETER(rc);
+    return;
+  }
+
+  if (num_iovecs == 0) {
+    return;
+  }
+
+  // The reservations are in consecutive slices at the end of the buffer. Find the slice holding
+  // the first one.
+  uint64_t slice_index = slices_.size();
+  while (slice_index > 0 && !slices_[slice_index - 1]->isReservation(iovecs[0])) {
+    slice_index--;
+  }
+  ASSERT(slice_index > 0);
+  slice_index--;
+
+  for (uint64_t i = 0; i < num_iovecs; i++) {
+    ASSERT(slice_index + i < slices_.size());
+    slices_[slice_index + i]->commit(iovecs[i]);
+    length_ += iovecs[i].len_;
+  }
 }
 
 void OwnedImpl::copyOut(size_t start, uint64_t size, void* data) const {
   ASSERT(start + size <= length());
 
-  evbuffer_ptr start_ptr;
-  int rc = evbuffer_ptr_set(buffer_.get(), &start_ptr, start, EVBUFFER_PTR_SET);
-  ASSERT(rc != -1);
-  UNREFERENCED_PARAMETER(rc);
+  if (old_impl_) {
+    evbuffer_ptr start_ptr;
+    int rc = evbuffer_ptr_set(buffer_.get(), &start_ptr, start, EVBUFFER_PTR_SET);
+    ASSERT(rc != -1);
+    UNREFERENCED_PARAMETER(rc);
 
-  ev_ssize_t copied = evbuffer_copyout_from(buffer_.get(), &start_ptr, data, size);
-  ASSERT(static_cast<uint64_t>(copied) == size);
-  UNREFERENCED_PARAMETER(copied);
+    ev_ssize_t copied = evbuffer_copyout_from(buffer_.get(), &start_ptr, data, size);
+    ASSERT(static_cast<uint64_t>(copied) == size);
+    UNREFERENCED_PARAMETER(copied);
+    return;
+  }
+
+  uint8_t* dest = static_cast<uint8_t*>(data);
+  for (const SlicePtr& slice : slices_) {
+    if (size == 0) {
+      break;
+    }
+    const uint64_t data_size = slice->dataSize();
+    if (start >= data_size) {
+      start -= data_size;
+      continue;
+    }
+    const uint64_t copy_size = std::min(data_size - start, size);
+    memcpy(dest, slice->data() + start, copy_size);
+    dest += copy_size;
+    size -= copy_size;
+    start = 0;
+  }
 }
 
 void OwnedImpl::drain(uint64_t size) {
+  const AccountUpdate account_update(*this);
   ASSERT(size <= length());
-  int rc = evbuffer_drain(buffer_.get(), size);
-  ASSERT(rc == 0);
-  UNREFERENCED_PARAMETER(rc);
+
+  if (old_impl_) {
+    int rc = evbuffer_drain(buffer_.get(), size);
+    ASSERT(rc == 0);
+    UNREFERENCED_PARAMETER(rc);
+    return;
+  }
+
+  length_ -= size;
+  while (size > 0) {
+    Slice& front = *slices_.front();
+    const uint64_t data_size = front.dataSize();
+    if (data_size <= size) {
+      // Fully drained slices are freed. Owned slices go back to the per thread free lists, so
+      // keeping them around would not save much.
+      size -= data_size;
+      slices_.pop_front();
+    } else {
+      front.drain(size);
+      size = 0;
+    }
+  }
 }
 
 uint64_t OwnedImpl::getRawSlices(RawSlice* out, uint64_t out_size) const {
-  return evbuffer_peek(buffer_.get(), -1, nullptr, reinterpret_cast<evbuffer_iovec*>(out),
-                       out_size);
+  if (old_impl_) {
+    return evbuffer_peek(buffer_.get(), -1, nullptr, reinterpret_cast<evbuffer_iovec*>(out),
+                         out_size);
+  }
+
+  // Unlike evbuffer_peek(), empty slices are never returned.
+  uint64_t num_slices = 0;
+  for (const SlicePtr& slice : slices_) {
+    if (slice->dataSize() == 0) {
+      continue;
+    }
+    if (num_slices < out_size) {
+      out[num_slices].mem_ = slice->data();
+      out[num_slices].len_ = slice->dataSize();
+    }
+    num_slices++;
+  }
+  return num_slices;
 }
 
-uint64_t OwnedImpl::length() const { return evbuffer_get_length(buffer_.get()); }
+uint64_t OwnedImpl::length() const {
+  if (old_impl_) {
+    return evbuffer_get_length(buffer_.get());
+  }
+  return length_;
+}
 
 void* OwnedImpl::linearize(uint32_t size) {
   ASSERT(size <= length());
-  return evbuffer_pullup(buffer_.get(), size);
+
+  if (old_impl_) {
+    return evbuffer_pullup(buffer_.get(), size);
+  }
+
+  if (slices_.empty()) {
+    return nullptr;
+  }
+  if (slices_.front()->dataSize() >= size) {
+    return slices_.front()->data();
+  }
+
+  // Copy the data into a new slice which replaces the slices it was copied from.
+  SlicePtr linearized = OwnedSlice::create(size);
+  uint64_t remaining = size;
+  while (remaining > 0) {
+    Slice& front = *slices_.front();
+    const uint64_t copy_size = std::min(front.dataSize(), remaining);
+    linearized->append(front.data(), copy_size);
+    remaining -= copy_size;
+    if (copy_size == front.dataSize()) {
+      slices_.pop_front();
+    } else {
+      front.drain(copy_size);
+    }
+  }
+  slices_.emplace_front(std::move(linearized));
+  return slices_.front()->data();
 }
 
 void OwnedImpl::move(Instance& rhs) {
-  // We do the static cast here because in practice we only have one buffer implementation right
-  // now and this is safe. Using the evbuffer move routines require having access to both evbuffers.
-  // This is a reasonable compromise in a high performance path where we want to maintain an
-  // abstraction in case we get rid of evbuffer later.
-  int rc = evbuffer_add_buffer(buffer_.get(), static_cast<LibEventInstance&>(rhs).buffer().get());
-  ASSERT(rc == 0);
-  UNREFERENCED_PARAMETER(rc);
-  static_cast<LibEventInstance&>(rhs).postProcess();
+  const AccountUpdate account_update(*this);
+  // We do the static cast here because in practice OwnedImpl is the only buffer implementation and
+  // this is safe. Moving without copying requires access to the evbuffers or slices of both
+  // buffers. This is a reasonable compromise in a high performance path where we want to maintain
+  // an abstraction.
+  OwnedImpl& other = static_cast<OwnedImpl&>(rhs);
+  ASSERT(old_impl_ == other.old_impl_);
+
+  if (old_impl_) {
+    int rc = evbuffer_add_buffer(buffer_.get(), other.buffer().get());
+    ASSERT(rc == 0);
+    UNREFERENCED_PARAMETER(rc);
+  } else {
+    while (!other.slices_.empty()) {
+      moveSlice(std::move(other.slices_.front()));
+      other.slices_.pop_front();
+    }
+    other.length_ = 0;
+  }
+  other.postProcess();
 }
 
 void OwnedImpl::move(Instance& rhs, uint64_t length) {
+  const AccountUpdate account_update(*this);
   // See move() above for why we do the static cast.
-  int rc = evbuffer_remove_buffer(static_cast<LibEventInstance&>(rhs).buffer().get(), buffer_.get(),
-                                  length);
-  ASSERT(static_cast<uint64_t>(rc) == length);
-  UNREFERENCED_PARAMETER(rc);
-  static_cast<LibEventInstance&>(rhs).postProcess();
+  OwnedImpl& other = static_cast<OwnedImpl&>(rhs);
+  ASSERT(old_impl_ == other.old_impl_);
+
+  if (old_impl_) {
+    int rc = evbuffer_remove_buffer(other.buffer().get(), buffer_.get(), length);
+    ASSERT(static_cast<uint64_t>(rc) == length);
+    UNREFERENCED_PARAMETER(rc);
+  } else {
+    ASSERT(length <= other.length_);
+    while (length > 0) {
+      SlicePtr& front = other.slices_.front();
+      const uint64_t data_size = front->dataSize();
+      if (data_size <= length) {
+        moveSlice(std::move(front));
+        other.slices_.pop_front();
+        other.length_ -= data_size;
+        length -= data_size;
+      } else {
+        // Only part of this slice is moved, so copy that part.
+        OwnedImpl::add(front->data(), length);
+        front->drain(length);
+        other.length_ -= length;
+        length = 0;
+      }
+    }
+  }
+  other.postProcess();
 }
 
 int OwnedImpl::read(int fd, uint64_t max_length) {
-  return evbuffer_read(buffer_.get(), fd, max_length);
+  const AccountUpdate account_update(*this);
+  if (old_impl_) {
+    return evbuffer_read(buffer_.get(), fd, max_length);
+  }
+
+  if (max_length == 0) {
+    return 0;
+  }
+
+  RawSlice iovecs[MAX_IOVECS];
+  const uint64_t num_iovecs = OwnedImpl::reserve(max_length, iovecs, MAX_IOVECS);
+  // The reservation may be larger than requested, so trim it to max_length.
+  uint64_t num_bytes_to_read = 0;
+  for (uint64_t i = 0; i < num_iovecs; i++) {
+    iovecs[i].len_ = std::min(iovecs[i].len_, max_length - num_bytes_to_read);
+    num_bytes_to_read += iovecs[i].len_;
+  }
+
+  const ssize_t rc = ::readv(fd, reinterpret_cast<const iovec*>(iovecs), num_iovecs);
+  if (rc <= 0) {
+    // Nothing is committed. The reserved slices are left empty at the end of the buffer, from
+    // where they are reused by the next reservation.
+    return rc;
+  }
+
+  uint64_t remaining = rc;
+  for (uint64_t i = 0; i < num_iovecs; i++) {
+    iovecs[i].len_ = std::min(iovecs[i].len_, remaining);
+    remaining -= iovecs[i].len_;
+  }
+  OwnedImpl::commit(iovecs, num_iovecs);
+  return rc;
 }
 
 uint64_t OwnedImpl::reserve(uint64_t length, RawSlice* iovecs, uint64_t num_iovecs) {
-  uint64_t ret = evbuffer_reserve_space(buffer_.get(), length,
-                                        reinterpret_cast<evbuffer_iovec*>(iovecs), num_iovecs);
-  ASSERT(ret >= 1);
-  return ret;
+  if (old_impl_) {
+    uint64_t ret = evbuffer_reserve_space(buffer_.get(), length,
+                                          reinterpret_cast<evbuffer_iovec*>(iovecs), num_iovecs);
+    ASSERT(ret >= 1);
+    return ret;
+  }
+
+  // Reserve the free space of the last slice and then of the empty slices after it, allocating
+  // new slices as needed. As with evbuffer, the total size of the reservations is at least length,
+  // so the last reservation must be large enough to hold everything that is left.
+  uint64_t slice_index = firstReservableSlice();
+  uint64_t reserved = 0;
+  uint64_t num_reserved = 0;
+  while (reserved < length && num_reserved < num_iovecs) {
+    const uint64_t remaining = length - reserved;
+    const bool last = num_reserved + 1 == num_iovecs;
+    if (slice_index < slices_.size() && last &&
+        slices_[slice_index]->reservableSize() < remaining) {
+      if (slices_[slice_index]->dataSize() > 0) {
+        slice_index++;
+      }
+      slices_.emplace(slices_.begin() + slice_index, OwnedSlice::create(remaining));
+    } else if (slice_index == slices_.size()) {
+      slices_.emplace_back(
+          OwnedSlice::create(last ? remaining : std::min(remaining, OwnedSlice::DEFAULT_SIZE)));
+    }
+
+    iovecs[num_reserved] = slices_[slice_index++]->reserve();
+    reserved += iovecs[num_reserved++].len_;
+  }
+
+  ASSERT(num_reserved >= 1);
+  return num_reserved;
 }
 
 ssize_t OwnedImpl::search(const void* data, uint64_t size, size_t start) const {
-  evbuffer_ptr start_ptr;
-  if (-1 == evbuffer_ptr_set(buffer_.get(), &start_ptr, start, EVBUFFER_PTR_SET)) {
+  if (old_impl_) {
+    evbuffer_ptr start_ptr;
+    if (-1 == evbuffer_ptr_set(buffer_.get(), &start_ptr, start, EVBUFFER_PTR_SET)) {
+      return -1;
+    }
+
+    evbuffer_ptr result_ptr =
+        evbuffer_search(buffer_.get(), static_cast<const char*>(data), size, &start_ptr);
+    return result_ptr.pos;
+  }
+
+  if (start > length_) {
     return -1;
   }
+  if (size == 0) {
+    return start;
+  }
+
+  const uint8_t* needle = static_cast<const uint8_t*>(data);
+  uint64_t slice_start = 0;
+  for (uint64_t i = 0; i < slices_.size(); i++) {
+    const Slice& slice = *slices_[i];
+    const uint64_t data_size = slice.dataSize();
+    if (start >= slice_start + data_size) {
+      slice_start += data_size;
+      continue;
+    }
 
-  evbuffer_ptr result_ptr =
-      evbuffer_search(buffer_.get(), static_cast<const char*>(data), size, &start_ptr);
-  return result_ptr.pos;
+    // Look for the first byte of the needle with memchr() and then compare the rest of it, which
+    // may span the following slices.
+    uint64_t offset = start > slice_start ? start - slice_start : 0;
+    while (offset < data_size) {
+      if (length_ - (slice_start + offset) < size) {
+        return -1;
+      }
+      const void* match = memchr(slice.data() + offset, needle[0], data_size - offset);
+      if (match == nullptr) {
+        break;
+      }
+      offset = static_cast<const uint8_t*>(match) - slice.data();
+      if (matchesAt(i, offset, needle, size)) {
+        return slice_start + offset;
+      }
+      offset++;
+    }
+    slice_start += data_size;
+  }
+  return -1;
 }
 
-int OwnedImpl::write(int fd) { return evbuffer_write(buffer_.get(), fd); }
+int OwnedImpl::write(int fd) {
+  const AccountUpdate account_update(*this);
+  if (old_impl_) {
+    return evbuffer_write(buffer_.get(), fd);
+  }
 
-OwnedImpl::OwnedImpl() : buffer_(evbuffer_new()) {}
+  RawSlice iovecs[MAX_IOVECS];
+  const uint64_t num_iovecs = std::min(getRawSlices(iovecs, MAX_IOVECS), MAX_IOVECS);
+  if (num_iovecs == 0) {
+    return 0;
+  }
+
+  const ssize_t rc = ::writev(fd, reinterpret_cast<const iovec*>(iovecs), num_iovecs);
+  if (rc > 0) {
+    OwnedImpl::drain(rc);
+  }
+  return rc;
+}
+
+uint64_t OwnedImpl::dataEnd() const {
+  uint64_t slice_index = slices_.size();
+  while (slice_index > 0 && slices_[slice_index - 1]->dataSize() == 0) {
+    slice_index--;
+  }
+  return slice_index;
+}
+
+uint64_t OwnedImpl::firstReservableSlice() const {
+  const uint64_t data_end = dataEnd();
+  if (data_end > 0 && slices_[data_end - 1]->reservableSize() > 0) {
+    return data_end - 1;
+  }
+  return data_end;
+}
+
+void OwnedImpl::moveSlice(SlicePtr&& slice) {
+  const uint64_t data_size = slice->dataSize();
+  if (data_size == 0) {
+    return;
+  }
+
+  length_ += data_size;
+  const uint64_t slice_index = firstReservableSlice();
+  if (data_size < COPY_THRESHOLD && slice_index < slices_.size() &&
+      slices_[slice_index]->reservableSize() >= data_size) {
+    slices_[slice_index]->append(slice->data(), data_size);
+  } else {
+    // Take the slice, ahead of any empty slices left at the end by reserve().
+    slices_.emplace(slices_.begin() + dataEnd(), std::move(slice));
+  }
+}
+
+bool OwnedImpl::matchesAt(uint64_t slice_index, uint64_t offset, const uint8_t* data,
+                          uint64_t size) const {
+  for (; size > 0 && slice_index < slices_.size(); slice_index++) {
+    const Slice& slice = *slices_[slice_index];
+    const uint64_t compare_size = std::min(slice.dataSize() - offset, size);
+    if (memcmp(slice.data() + offset, data, compare_size) != 0) {
+      return false;
+    }
+    data += compare_size;
+    size -= compare_size;
+    offset = 0;
+  }
+  return size == 0;
+}
+
+OwnedImpl::OwnedImpl() : buffer_(old_impl_ ? evbuffer_new() : nullptr) {}
 
 OwnedImpl::OwnedImpl(const std::string& data) : OwnedImpl() { add(data); }
 
@@ -125,5 +503,26 @@ OwnedImpl::OwnedImpl(const Instance& data) : OwnedImpl() { add(data); }
 
 OwnedImpl::OwnedImpl(const void* data, uint64_t size) : OwnedImpl() { add(data, size); }
 
+OwnedImpl::~OwnedImpl() { setAccount(nullptr); }
+
+void OwnedImpl::setAccount(AccountSharedPtr account) {
+  if (account_) {
+    account_->credit(charged_);
+  }
+  charged_ = 0;
+  account_ = std::move(account);
+  updateAccount();
+}
+
+void OwnedImpl::updateAccountSlow() {
+  const uint64_t current_length = length();
+  if (current_length > charged_) {
+    account_->charge(current_length - charged_);
+  } else if (current_length < charged_) {
+    account_->credit(charged_ - current_length);
+  }
+  charged_ = current_length;
+}
+
 } // namespace Buffer
 } // namespace Envoy
@@ -1,15 +1,220 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <string>
 
 #include "envoy/buffer/buffer.h"
 
+#include "common/common/assert.h"
+#include "common/common/non_copyable.h"
+#include "common/common/slab_allocator.h"
 #include "common/event/libevent.h"
 
 namespace Envoy {
 namespace Buffer {
 
+/**
+ * A contiguous piece of memory used by the native buffer implementation. The memory is laid out
+ * as:
+ *
+ *   |<- drained ->|<- data ->|<- reservable ->|
+ *   0           data_   reservable_        size_
+ *
+ * Data is appended by writing into the reservable section and then committing it, and drained
+ * from the front.
+ */
+class Slice : NonCopyable {
+public:
+  virtual ~Slice() {}
+
+  /**
+   * @return a pointer to the start of the data in the slice.
+   */
+  uint8_t* data() { return base_ + data_; }
+  const uint8_t* data() const { return base_ + data_; }
+
+  /**
+   * @return the number of bytes of data in the slice.
+   */
+  uint64_t dataSize() const { return reservable_ - data_; }
+
+  /**
+   * Remove data from the front of the slice.
+   * @param size supplies the number of bytes to remove, which must be <= dataSize().
+   */
+  void drain(uint64_t size) {
+    ASSERT(size <= dataSize());
+    data_ += size;
+  }
+
+  /**
+   * @return the number of bytes that can be appended to the slice.
+   */
+  uint64_t reservableSize() const { return size_ - reservable_; }
+
+  /**
+   * Reserve the reservable section of the slice. The reservation must be committed for the data
+   * written into it to become part of the slice.
+   * @return RawSlice the reservation, which is empty if the slice is full.
+   */
+  RawSlice reserve() {
+    RawSlice reservation;
+    reservation.mem_ = base_ + reservable_;
+    reservation.len_ = reservableSize();
+    return reservation;
+  }
+
+  /**
+   * @return whether a reservation was obtained from this slice by reserve().
+   */
+  bool isReservation(const RawSlice& reservation) const {
+    return reservableSize() > 0 && reservation.mem_ == base_ + reservable_;
+  }
+
+  /**
+   * Commit data written into a reservation. The length of the reservation may have been reduced.
+   * @param reservation supplies a reservation for which isReservation() is true.
+   */
+  void commit(const RawSlice& reservation) {
+    ASSERT(isReservation(reservation));
+    ASSERT(reservation.len_ <= reservableSize());
+    reservable_ += reservation.len_;
+  }
+
+  /**
+   * Copy as much data as fits into the reservable section of the slice.
+   * @param data supplies the data to copy.
+   * @param size supplies the size of the data.
+   * @return uint64_t the number of bytes copied.
+   */
+  uint64_t append(const void* data, uint64_t size) {
+    const uint64_t copy_size = std::min(size, reservableSize());
+    memcpy(base_ + reservable_, data, copy_size);
+    reservable_ += copy_size;
+    return copy_size;
+  }
+
+protected:
+  Slice(uint8_t* base, uint64_t size) : base_(base), size_(size) {}
+
+  uint8_t* const base_;
+  uint64_t data_{0};
+  uint64_t reservable_{0};
+  const uint64_t size_;
+};
+
+typedef std::unique_ptr<Slice> SlicePtr;
+
+/**
+ * A slice which owns its memory. Slices of up to DEFAULT_SIZE bytes, which is what socket reads and
+ * most small appends use, all come from the same SlabAllocator size class so that they are
+ * recycled through the per thread free lists rather than going back to malloc. Larger slices are
+ * allocated with new.
+ */
+class OwnedSlice final : public Slice, public SlabAllocated {
+public:
+  /**
+   * Create an empty slice.
+   * @param capacity supplies the minimum number of bytes the slice must be able to hold.
+   * @return SlicePtr the slice.
+   */
+  static SlicePtr create(uint64_t capacity) {
+    return SlicePtr{new OwnedSlice(sliceSize(capacity))};
+  }
+
+  ~OwnedSlice();
+
+  static const uint64_t DEFAULT_SIZE = SlabAllocator::MAX_BLOCK_SIZE;
+
+private:
+  OwnedSlice(uint64_t size);
+
+  /**
+   * @return the size of the slice to allocate to hold capacity bytes. Sizes are rounded up to a
+   *         multiple of DEFAULT_SIZE.
+   */
+  static uint64_t sliceSize(uint64_t capacity) {
+    return std::max<uint64_t>(1, (capacity + DEFAULT_SIZE - 1) / DEFAULT_SIZE) * DEFAULT_SIZE;
+  }
+
+  static uint8_t* allocate(uint64_t size);
+};
+
+/**
+ * A slice which references the memory of a BufferFragment, and calls done() on the fragment when
+ * the slice is destroyed. The slice is full, so data can't be appended to it.
+ */
+class UnownedSlice final : public Slice, public SlabAllocated {
+public:
+  UnownedSlice(BufferFragment& fragment)
+      : Slice(static_cast<uint8_t*>(const_cast<void*>(fragment.data())), fragment.size()),
+        fragment_(fragment) {
+    reservable_ = size_;
+  }
+
+  ~UnownedSlice() { fragment_.done(); }
+
+private:
+  BufferFragment& fragment_;
+};
+
+/**
+ * An implementation of BufferFragment where a releasor callback is called when the data is no
+ * longer needed.
+ */
+class BufferFragmentImpl : NonCopyable, public BufferFragment {
+public:
+  /**
+   * Creates a new wrapper around the externally owned data.
+   * @param data supplies the data.
+   * @param size supplies the size of the data.
+   * @param releasor supplies a callback to invoke when the data is no longer needed. It is passed
+   *        the data, the size and the fragment, and may delete the fragment.
+   */
+  BufferFragmentImpl(
+      const void* data, size_t size,
+      const std::function<void(const void*, size_t, const BufferFragmentImpl*)>& releasor)
+      : data_(data), size_(size), releasor_(releasor) {}
+
+  // Buffer::BufferFragment
+  const void* data() const override { return data_; }
+  size_t size() const override { return size_; }
+  void done() override {
+    if (releasor_) {
+      releasor_(data_, size_, this);
+    }
+  }
+
+private:
+  const void* const data_;
+  const size_t size_;
+  const std::function<void(const void*, size_t, const BufferFragmentImpl*)> releasor_;
+};
+
+/**
+ * An account whose balance is kept in an atomic, so that buffers on any thread can be attached to
+ * it.
+ */
+class AccountImpl : public Account {
+public:
+  // Buffer::Account
+  void charge(uint64_t bytes) override { balance_.fetch_add(bytes, std::memory_order_relaxed); }
+  void credit(uint64_t bytes) override {
+    ASSERT(bytes <= balance());
+    balance_.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+  uint64_t balance() const override { return balance_.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<uint64_t> balance_{0};
+};
+
 class LibEventInstance : public Instance {
 public:
   // Allows access into the underlying buffer for move() optimizations.
@@ -19,10 +224,12 @@ public:
 };
 
 /**
- * Wraps an allocated and owned evbuffer.
+ * Wraps an allocated and owned evbuffer, or when the native implementation is selected with
+ * useOldImpl(false), a deque of slices.
  *
- * Note that due to the internals of move() accessing buffer(), OwnedImpl is not
- * compatible with non-LibEventInstance buffers.
+ * Note that due to the internals of move() accessing buffer() and the slices of the source buffer,
+ * OwnedImpl is not compatible with non-OwnedImpl buffers, or with OwnedImpl buffers using the other
+ * implementation.
  */
 class OwnedImpl : public LibEventInstance {
 public:
@@ -30,11 +237,13 @@ public:
   OwnedImpl(const std::string& data);
   OwnedImpl(const Instance& data);
   OwnedImpl(const void* data, uint64_t size);
+  ~OwnedImpl();
 
   // LibEventInstance
   void add(const void* data, uint64_t size) override;
   void add(const std::string& data) override;
   void add(const Instance& data) override;
+  void addBufferFragment(BufferFragment& fragment) override;
   void commit(RawSlice* iovecs, uint64_t num_iovecs) override;
   void copyOut(size_t start, uint64_t size, void* data) const override;
   void drain(uint64_t size) override;
@@ -46,13 +255,90 @@ public:
   int read(int fd, uint64_t max_length) override;
   uint64_t reserve(uint64_t length, RawSlice* iovecs, uint64_t num_iovecs) override;
   ssize_t search(const void* data, uint64_t size, size_t start) const override;
+  void setAccount(AccountSharedPtr account) override;
   int write(int fd) override;
-  void postProcess() override {}
+  void postProcess() override { updateAccount(); }
 
+  // Only valid when the buffer uses the libevent implementation.
   Event::Libevent::BufferPtr& buffer() override { return buffer_; }
 
+  /**
+   * Select the implementation used by buffers created after this call. This is intended to be
+   * called once at startup, before any buffers exist.
+   * @param use_old_impl supplies whether to use the libevent evbuffer implementation (true) or the
+   *        native slice based implementation (false).
+   */
+  static void useOldImpl(bool use_old_impl);
+
+  /**
+   * @return bool whether this buffer uses the libevent evbuffer implementation.
+   */
+  bool usesOldImpl() const { return old_impl_; }
+
+  // Most iovecs passed to readv() or writev() for a single read() or write().
+  static const uint64_t MAX_IOVECS = 16;
+  // Slices smaller than this are copied rather than moved by move(), so that moving many small
+  // buffers into one does not create a long chain of mostly empty slices.
+  static const uint64_t COPY_THRESHOLD = 512;
+
 private:
+  /**
+   * Updates the account of the buffer, if any, when it goes out of scope. It is declared first in
+   * the methods which change the length of the buffer, so that all of their return paths are
+   * covered.
+   */
+  class AccountUpdate {
+  public:
+    AccountUpdate(OwnedImpl& buffer) : buffer_(buffer) {}
+    ~AccountUpdate() { buffer_.updateAccount(); }
+
+  private:
+    OwnedImpl& buffer_;
+  };
+
+  /**
+   * Charge or credit the account with the change in length since it was last updated.
+   */
+  void updateAccount() {
+    if (account_) {
+      updateAccountSlow();
+    }
+  }
+  void updateAccountSlow();
+
+  /**
+   * @return uint64_t the index following the last slice which holds data. Any slices after it are
+   *         empty slices left behind by reserve().
+   */
+  uint64_t dataEnd() const;
+
+  /**
+   * @return uint64_t the index of the first slice that can be appended to, which is the last slice
+   *         holding data if it is not full, or else the first empty slice after it. slices_.size()
+   *         if there is no such slice.
+   */
+  uint64_t firstReservableSlice() const;
+
+  /**
+   * Append the data of a slice taken from another buffer, either by taking ownership of it or by
+   * copying its data if it is small.
+   */
+  void moveSlice(SlicePtr&& slice);
+
+  /**
+   * @return whether the buffer contents starting at the given offset of the given slice match data.
+   */
+  bool matchesAt(uint64_t slice_index, uint64_t offset, const uint8_t* data, uint64_t size) const;
+
+  static bool use_old_impl_;
+
+  const bool old_impl_{use_old_impl_};
   Event::Libevent::BufferPtr buffer_;
+  std::deque<SlicePtr> slices_;
+  uint64_t length_{0};
+  AccountSharedPtr account_;
+  // The number of bytes last charged to account_.
+  uint64_t charged_{0};
 };
 
 } // namespace Buffer
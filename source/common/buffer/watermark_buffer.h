@@ -24,6 +24,7 @@ public:
   void add(const void* data, uint64_t size) override;
   void add(const std::string& data) override;
   void add(const Instance& data) override;
+  void addBufferFragment(BufferFragment& fragment) override;
   void commit(RawSlice* iovecs, uint64_t num_iovecs) override;
   void drain(uint64_t size) override;
   void move(Instance& rhs) override;
@@ -31,7 +32,10 @@ public:
   int read(int fd, uint64_t max_length) override;
   uint64_t reserve(uint64_t length, RawSlice* iovecs, uint64_t num_iovecs) override;
   int write(int fd) override;
-  void postProcess() override { checkLowWatermark(); }
+  void postProcess() override {
+    OwnedImpl::postProcess();
+    checkLowWatermark();
+  }
 
   void setWatermarks(uint32_t watermark) { setWatermarks(watermark / 2, watermark); }
   void setWatermarks(uint32_t low_watermark, uint32_t high_watermark);
@@ -1,8 +1,11 @@
 #include "common/common/base64.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <string>
 
+#include "common/common/assert.h"
 #include "common/common/empty_string.h"
 
 namespace Envoy {
@@ -24,160 +27,223 @@ static const unsigned char REVERSE_LOOKUP_TABLE[256] = {
     64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
     64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64};
 
+namespace {
+
+// Decoded values are between 0 and 63 for valid characters, and 64 otherwise, so OR-ing the values
+// of a group tells whether any of them is invalid.
+constexpr uint32_t INVALID = 64;
+
+/**
+ * Decode groups of 4 characters without padding into groups of 3 bytes.
+ * @return false if the input contains an invalid character.
+ */
+bool decodeGroups(const uint8_t* input, uint64_t groups, char* output) {
+  for (uint64_t i = 0; i < groups; ++i, input += 4, output += 3) {
+    const uint32_t a = REVERSE_LOOKUP_TABLE[input[0]];
+    const uint32_t b = REVERSE_LOOKUP_TABLE[input[1]];
+    const uint32_t c = REVERSE_LOOKUP_TABLE[input[2]];
+    const uint32_t d = REVERSE_LOOKUP_TABLE[input[3]];
+    if ((a | b | c | d) & INVALID) {
+      return false;
+    }
+    const uint32_t value = a << 18 | b << 12 | c << 6 | d;
+    output[0] = static_cast<char>(value >> 16);
+    output[1] = static_cast<char>(value >> 8);
+    output[2] = static_cast<char>(value);
+  }
+  return true;
+}
+
+/**
+ * Decode the last group of 4 characters of the input, which may end with padding.
+ * @return false if the group is not valid.
+ */
+bool decodeLastGroup(const uint8_t* input, std::string& result) {
+  const uint32_t a = REVERSE_LOOKUP_TABLE[input[0]];
+  const uint32_t b = REVERSE_LOOKUP_TABLE[input[1]];
+  const uint32_t c = REVERSE_LOOKUP_TABLE[input[2]];
+  const uint32_t d = REVERSE_LOOKUP_TABLE[input[3]];
+  if ((a | b) & INVALID) {
+    return false;
+  }
+  result.push_back(static_cast<char>(a << 2 | b >> 4));
+
+  // Decoded value 64 means invalid character unless it is padding, in which case the following
+  // characters are all padding. Also we should check there are no unused bits.
+  if (c == INVALID) {
+    return input[2] == '=' && input[3] == '=' && (b & 0b1111) == 0;
+  }
+  result.push_back(static_cast<char>(b << 4 | c >> 2));
+
+  if (d == INVALID) {
+    return input[3] == '=' && (c & 0b11) == 0;
+  }
+  result.push_back(static_cast<char>(c << 6 | d));
+  return true;
+}
+
+/**
+ * Encode groups of 3 bytes into groups of 4 characters.
+ */
+void encodeGroups(const uint8_t* input, uint64_t groups, char* output) {
+  for (uint64_t i = 0; i < groups; ++i, input += 3, output += 4) {
+    const uint32_t value = input[0] << 16 | input[1] << 8 | input[2];
+    output[0] = CHAR_TABLE[value >> 18];
+    output[1] = CHAR_TABLE[(value >> 12) & 0x3f];
+    output[2] = CHAR_TABLE[(value >> 6) & 0x3f];
+    output[3] = CHAR_TABLE[value & 0x3f];
+  }
+}
+
+/**
+ * Encode the last 1 or 2 bytes of the input, and the padding.
+ */
+void encodeLastGroup(const uint8_t* input, uint64_t length, char* output) {
+  ASSERT(length == 1 || length == 2);
+  const uint32_t value = input[0] << 16 | (length == 2 ? input[1] << 8 : 0);
+  output[0] = CHAR_TABLE[value >> 18];
+  output[1] = CHAR_TABLE[(value >> 12) & 0x3f];
+  output[2] = length == 2 ? CHAR_TABLE[(value >> 6) & 0x3f] : '=';
+  output[3] = '=';
+}
+
+} // namespace
+
 std::string Base64::decode(const std::string& input) {
   if (input.length() % 4 || input.empty()) {
     return EMPTY_STRING;
   }
 
-  // First position of "valid" padding character.
-  uint64_t first_padding_index = input.length();
-  int max_length = input.length() / 4 * 3;
-  // At most last two chars can be '='.
-  if (input[input.length() - 1] == '=') {
-    max_length--;
-    first_padding_index = input.length() - 1;
-    if (input[input.length() - 2] == '=') {
-      max_length--;
-      first_padding_index = input.length() - 2;
-    }
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(input.data());
+  const uint64_t groups = input.length() / 4 - 1;
+  std::string result;
+  result.reserve(input.length() / 4 * 3);
+  result.resize(groups * 3);
+  if (!decodeGroups(data, groups, &result[0]) ||
+      !decodeLastGroup(data + groups * 4, result)) {
+    return EMPTY_STRING;
+  }
+  return result;
+}
+
+std::string Base64::decode(const Buffer::Instance& input) {
+  const uint64_t length = input.length();
+  if (length % 4 || length == 0) {
+    return EMPTY_STRING;
   }
+
   std::string result;
-  result.reserve(max_length);
-
-  uint64_t bytes_left = input.length();
-  uint64_t cur_read = 0;
-
-  // Read input string by group of 4 chars, length of input string must be divided evenly by 4.
-  // Decode 4 chars 6 bits each into 3 chars 8 bits each.
-  while (bytes_left > 0) {
-    // Take first 6 bits from 1st converted char and first 2 bits from 2nd converted char,
-    // make 8 bits char from it.
-    // Use conversion table to map char to decoded value (value is between 0 and 63 inclusive for a
-    // valid character).
-    const unsigned char a = REVERSE_LOOKUP_TABLE[static_cast<uint32_t>(input[cur_read])];
-    const unsigned char b = REVERSE_LOOKUP_TABLE[static_cast<uint32_t>(input[cur_read + 1])];
-    if (a == 64 || b == 64) {
-      // Input contains an invalid character.
-      return EMPTY_STRING;
-    }
-    result.push_back(a << 2 | b >> 4);
-    const unsigned char c = REVERSE_LOOKUP_TABLE[static_cast<uint32_t>(input[cur_read + 2])];
-
-    // Decoded value 64 means invalid character unless we already know it is a valid padding.
-    // If so, following characters are all padding.
-    // Also we should check there are no unused bits.
-    if (c == 64) {
-      if (first_padding_index != cur_read + 2) {
-        // Input contains an invalid character.
-        return EMPTY_STRING;
-      } else if (b & 0b1111) {
-        // There are unused bits at tail.
-        return EMPTY_STRING;
-      } else {
-        return result;
+  result.reserve(length / 4 * 3);
+  // All the groups but the last one, which may hold padding.
+  uint64_t groups_left = length / 4 - 1;
+  result.resize(groups_left * 3);
+  char* output = &result[0];
+
+  // A group split between slices, or the last group, is gathered here.
+  uint8_t group[4];
+  uint64_t group_length = 0;
+
+  const uint64_t num_slices = input.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  input.getRawSlices(slices, num_slices);
+  for (const Buffer::RawSlice& slice : slices) {
+    const uint8_t* data = static_cast<const uint8_t*>(slice.mem_);
+    uint64_t slice_left = slice.len_;
+    while (slice_left > 0) {
+      if (group_length > 0 || groups_left == 0 || slice_left < 4) {
+        const uint64_t copied = std::min(4 - group_length, slice_left);
+        memcpy(group + group_length, data, copied);
+        group_length += copied;
+        data += copied;
+        slice_left -= copied;
+        if (group_length == 4 && groups_left > 0) {
+          if (!decodeGroups(group, 1, output)) {
+            return EMPTY_STRING;
+          }
+          output += 3;
+          groups_left--;
+          group_length = 0;
+        }
+        continue;
       }
-    }
-    // Take last 4 bits from 2nd converted char and 4 first bits from 3rd converted char.
-    result.push_back(b << 4 | c >> 2);
 
-    const unsigned char d = REVERSE_LOOKUP_TABLE[static_cast<uint32_t>(input[cur_read + 3])];
-    if (d == 64) {
-      if (first_padding_index != cur_read + 3) {
-        // Input contains an invalid character.
-        return EMPTY_STRING;
-      } else if (c & 0b11) {
-        // There are unused bits at tail.
+      const uint64_t groups = std::min(slice_left / 4, groups_left);
+      if (!decodeGroups(data, groups, output)) {
         return EMPTY_STRING;
-      } else {
-        return result;
       }
+      output += groups * 3;
+      data += groups * 4;
+      slice_left -= groups * 4;
+      groups_left -= groups;
     }
-    // Take last 2 bits from 3rd converted char and all(6) bits from 4th converted char.
-    result.push_back(c << 6 | d);
-
-    cur_read += 4;
-    bytes_left -= 4;
   }
 
-  return result;
-}
-
-void Base64::encodeBase(const uint8_t cur_char, uint64_t pos, uint8_t& next_c, std::string& ret) {
-  switch (pos % 3) {
-  case 0:
-    ret.push_back(CHAR_TABLE[cur_char >> 2]);
-    next_c = (cur_char & 0x03) << 4;
-    break;
-  case 1:
-    ret.push_back(CHAR_TABLE[next_c | (cur_char >> 4)]);
-    next_c = (cur_char & 0x0f) << 2;
-    break;
-  case 2:
-    ret.push_back(CHAR_TABLE[next_c | (cur_char >> 6)]);
-    ret.push_back(CHAR_TABLE[cur_char & 0x3f]);
-    next_c = 0;
-    break;
-  }
-}
-
-void Base64::encodeLast(uint64_t pos, uint8_t last_char, std::string& ret) {
-  switch (pos % 3) {
-  case 1:
-    ret.push_back(CHAR_TABLE[last_char]);
-    ret.push_back('=');
-    ret.push_back('=');
-    break;
-  case 2:
-    ret.push_back(CHAR_TABLE[last_char]);
-    ret.push_back('=');
-    break;
-  default:
-    break;
+  ASSERT(groups_left == 0 && group_length == 4);
+  if (!decodeLastGroup(group, result)) {
+    return EMPTY_STRING;
   }
+  return result;
 }
 
 std::string Base64::encode(const Buffer::Instance& buffer, uint64_t length) {
-  uint64_t output_length = (std::min(length, buffer.length()) + 2) / 3 * 4;
+  length = std::min(length, buffer.length());
   std::string ret;
-  ret.reserve(output_length);
+  ret.resize((length + 2) / 3 * 4);
+  char* output = &ret[0];
+
+  // Bytes of a group split between slices.
+  uint8_t group[3];
+  uint64_t group_length = 0;
 
   uint64_t num_slices = buffer.getRawSlices(nullptr, 0);
   Buffer::RawSlice slices[num_slices];
   buffer.getRawSlices(slices, num_slices);
-
-  uint64_t j = 0;
-  uint8_t next_c = 0;
-  for (Buffer::RawSlice& slice : slices) {
-    const uint8_t* slice_mem = static_cast<const uint8_t*>(slice.mem_);
-
-    for (uint64_t i = 0; i < slice.len_ && j < length; ++i, ++j) {
-      encodeBase(slice_mem[i], j, next_c, ret);
+  for (const Buffer::RawSlice& slice : slices) {
+    if (length == 0) {
+      break;
     }
 
-    if (j == length) {
-      break;
+    const uint8_t* data = static_cast<const uint8_t*>(slice.mem_);
+    uint64_t slice_left = std::min<uint64_t>(slice.len_, length);
+    length -= slice_left;
+
+    if (group_length > 0) {
+      const uint64_t copied = std::min(3 - group_length, slice_left);
+      memcpy(group + group_length, data, copied);
+      group_length += copied;
+      data += copied;
+      slice_left -= copied;
+      if (group_length < 3) {
+        continue;
+      }
+      encodeGroups(group, 1, output);
+      output += 4;
+      group_length = 0;
     }
-  }
 
-  encodeLast(j, next_c, ret);
+    const uint64_t groups = slice_left / 3;
+    encodeGroups(data, groups, output);
+    output += groups * 4;
+    group_length = slice_left - groups * 3;
+    memcpy(group, data + groups * 3, group_length);
+  }
 
+  if (group_length > 0) {
+    encodeLastGroup(group, group_length, output);
+  }
   return ret;
 }
 
 std::string Base64::encode(const char* input, uint64_t length) {
-  uint64_t output_length = (length + 2) / 3 * 4;
   std::string ret;
-  ret.reserve(output_length);
+  ret.resize((length + 2) / 3 * 4);
 
-  uint64_t pos = 0;
-  uint8_t next_c = 0;
-
-  for (uint64_t i = 0; i < length; ++i) {
-    encodeBase(input[i], pos++, next_c, ret);
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(input);
+  const uint64_t groups = length / 3;
+  encodeGroups(data, groups, &ret[0]);
+  if (length % 3) {
+    encodeLastGroup(data + groups * 3, length % 3, &ret[groups * 4]);
   }
-
-  encodeLast(pos, next_c, ret);
-
   return ret;
 }
 } // namespace Envoy
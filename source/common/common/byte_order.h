@@ -6,6 +6,8 @@
 
 #include <libkern/OSByteOrder.h>
 
+#define htobe16(x) OSSwapHostToBigInt16((x))
+#define be16toh(x) OSSwapBigToHostInt16((x))
 #define htole32(x) OSSwapHostToLittleInt32((x))
 #define htole64(x) OSSwapHostToLittleInt64((x))
 #define le32toh(x) OSSwapLittleToHostInt32((x))
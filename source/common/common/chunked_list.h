@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+
+/**
+ * A doubly linked list whose elements are allocated in contiguous chunks of ChunkSize elements
+ * owned by the list, rather than one heap allocation per element like std::list. Elements never
+ * move, so pointers and references to them stay valid until they are erased, and the slots of
+ * erased elements are reused by later insertions. Elements inserted in order are laid out next to
+ * each other, so iteration mostly walks memory sequentially.
+ *
+ * Only the operations needed for append-mostly usage are supported: emplace_back(), erase() by
+ * iterator or by element, and forward and reverse iteration in insertion order. Chunks are only
+ * released when the list is destroyed. The list is movable, which keeps the elements in place, but
+ * not copyable.
+ */
+template <class T, size_t ChunkSize = 8> class ChunkedList {
+private:
+  struct Link {
+    Link* prev_;
+    Link* next_;
+  };
+
+  struct Node {
+    // Must be the first member so that a Link* to a node can be converted to the node.
+    Link link_;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage_;
+
+    T& value() { return *reinterpret_cast<T*>(&storage_); }
+  };
+
+  struct Chunk {
+    Node nodes_[ChunkSize];
+  };
+
+  template <class V> class IteratorImpl : public std::iterator<std::bidirectional_iterator_tag, V> {
+  public:
+    IteratorImpl() : link_(nullptr) {}
+    // Allow conversion from iterator to const_iterator.
+    template <class U>
+    IteratorImpl(const IteratorImpl<U>& other,
+                 typename std::enable_if<std::is_convertible<U*, V*>::value>::type* = nullptr)
+        : link_(other.link_) {}
+
+    V& operator*() const { return reinterpret_cast<Node*>(link_)->value(); }
+    V* operator->() const { return &operator*(); }
+    IteratorImpl& operator++() {
+      link_ = link_->next_;
+      return *this;
+    }
+    IteratorImpl operator++(int) {
+      IteratorImpl ret = *this;
+      link_ = link_->next_;
+      return ret;
+    }
+    IteratorImpl& operator--() {
+      link_ = link_->prev_;
+      return *this;
+    }
+    IteratorImpl operator--(int) {
+      IteratorImpl ret = *this;
+      link_ = link_->prev_;
+      return ret;
+    }
+    bool operator==(const IteratorImpl& rhs) const { return link_ == rhs.link_; }
+    bool operator!=(const IteratorImpl& rhs) const { return link_ != rhs.link_; }
+
+  private:
+    explicit IteratorImpl(Link* link) : link_(link) {}
+
+    Link* link_;
+
+    friend class ChunkedList;
+    template <class U> friend class IteratorImpl;
+  };
+
+public:
+  typedef IteratorImpl<T> iterator;
+  typedef IteratorImpl<const T> const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+  ChunkedList() {
+    static_assert(ChunkSize > 0, "chunks must hold at least one element");
+    head_.prev_ = &head_;
+    head_.next_ = &head_;
+  }
+
+  ChunkedList(ChunkedList&& other) : ChunkedList() { take(other); }
+
+  ChunkedList& operator=(ChunkedList&& other) {
+    if (this != &other) {
+      destroyElements();
+      chunks_.clear();
+      take(other);
+    }
+    return *this;
+  }
+
+  ~ChunkedList() { destroyElements(); }
+
+  /**
+   * Construct a new element at the end of the list.
+   * @return T& the new element.
+   */
+  template <class... Args> T& emplace_back(Args&&... args) {
+    if (!free_) {
+      addChunk();
+    }
+
+    Node* node = reinterpret_cast<Node*>(free_);
+    new (&node->storage_) T(std::forward<Args>(args)...);
+    free_ = free_->next_;
+
+    node->link_.prev_ = head_.prev_;
+    node->link_.next_ = &head_;
+    head_.prev_->next_ = &node->link_;
+    head_.prev_ = &node->link_;
+    size_++;
+    return node->value();
+  }
+
+  /**
+   * Erase an element.
+   * @param position supplies the element to erase.
+   * @return iterator the element following the erased element.
+   */
+  iterator erase(const_iterator position) {
+    ASSERT(position.link_ != &head_);
+    Link* link = position.link_;
+    Link* next = link->next_;
+    link->prev_->next_ = next;
+    next->prev_ = link->prev_;
+    reinterpret_cast<Node*>(link)->value().~T();
+
+    link->next_ = free_;
+    free_ = link;
+    size_--;
+    return iterator(next);
+  }
+
+  /**
+   * Erase an element given a reference to it. The element must belong to this list.
+   * @param value supplies the element to erase.
+   */
+  void erase(const T& value) {
+    const char* storage = reinterpret_cast<const char*>(&value);
+    erase(const_iterator(
+        reinterpret_cast<Link*>(const_cast<char*>(storage - offsetof(Node, storage_)))));
+  }
+
+  iterator begin() { return iterator(head_.next_); }
+  iterator end() { return iterator(&head_); }
+  const_iterator begin() const { return const_iterator(head_.next_); }
+  const_iterator end() const { return const_iterator(const_cast<Link*>(&head_)); }
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+private:
+  void destroyElements() {
+    for (Link* link = head_.next_; link != &head_;) {
+      Link* next = link->next_;
+      reinterpret_cast<Node*>(link)->value().~T();
+      link = next;
+    }
+    head_.prev_ = &head_;
+    head_.next_ = &head_;
+    free_ = nullptr;
+    size_ = 0;
+  }
+
+  // Take over the elements and chunks of another list, leaving the other list empty. This list must
+  // be empty and own no chunks.
+  void take(ChunkedList& other) {
+    if (!other.empty()) {
+      head_ = other.head_;
+      head_.next_->prev_ = &head_;
+      head_.prev_->next_ = &head_;
+    }
+    free_ = other.free_;
+    size_ = other.size_;
+    chunks_ = std::move(other.chunks_);
+
+    other.head_.prev_ = &other.head_;
+    other.head_.next_ = &other.head_;
+    other.free_ = nullptr;
+    other.size_ = 0;
+    other.chunks_.clear();
+  }
+
+  void addChunk() {
+    chunks_.emplace_back(new Chunk);
+    Chunk& chunk = *chunks_.back();
+    // Thread the free list through the chunk in address order, so that consecutive insertions are
+    // laid out consecutively in memory.
+    for (size_t i = ChunkSize; i > 0; i--) {
+      chunk.nodes_[i - 1].link_.next_ = free_;
+      free_ = &chunk.nodes_[i - 1].link_;
+    }
+  }
+
+  // Sentinel of the circular list of live elements.
+  Link head_;
+  // Singly linked (via next_) list of unused nodes.
+  Link* free_{};
+  size_t size_{};
+  std::vector<std::unique_ptr<Chunk>> chunks_;
+};
+
+} // namespace Envoy
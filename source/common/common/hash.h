@@ -1,6 +1,9 @@
 #pragma once
 
 #include <string>
+#include <vector>
+
+#include "envoy/buffer/buffer.h"
 
 #include "xxhash.h"
 
@@ -9,11 +12,34 @@ namespace Envoy {
 class HashUtil {
 public:
   /**
-   * Return 64-bit hash with seed of 0 from the xxHash algorithm.
+   * Return 64-bit hash from the xxHash algorithm.
    * See https://github.com/Cyan4973/xxHash for details.
+   * @param input supplies the string to hash.
+   * @param seed supplies the hash seed which defaults to 0.
+   */
+  static uint64_t xxHash64(const std::string& input, uint64_t seed = 0) {
+    return XXH64(input.c_str(), input.size(), seed);
+  }
+
+  /**
+   * Return 64-bit hash from the xxHash algorithm of the contents of a buffer. This is the hash of
+   * the contents as a string, without copying them into one.
+   * @param input supplies the buffer to hash.
+   * @param seed supplies the hash seed which defaults to 0.
    */
-  static uint64_t xxHash64(const std::string& input) {
-    return XXH64(input.c_str(), input.size(), 0);
+  static uint64_t xxHash64(const Buffer::Instance& input, uint64_t seed = 0) {
+    const uint64_t num_slices = input.getRawSlices(nullptr, 0);
+    std::vector<Buffer::RawSlice> slices(num_slices);
+    input.getRawSlices(slices.data(), num_slices);
+
+    XXH64_state_t* state = XXH64_createState();
+    XXH64_reset(state, seed);
+    for (const Buffer::RawSlice& slice : slices) {
+      XXH64_update(state, slice.mem_, slice.len_);
+    }
+    const uint64_t hash = XXH64_digest(state);
+    XXH64_freeState(state);
+    return hash;
   }
 };
 
@@ -1,5 +1,6 @@
 #include "common/common/logger.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <iostream>
 #include <string>
@@ -7,6 +8,7 @@
 
 #include "envoy/thread/thread.h"
 
+#include "fmt/format.h"
 #include "spdlog/spdlog.h"
 
 namespace Envoy {
@@ -23,11 +25,146 @@ Logger::Logger(const std::string& name) {
   logger_->flush_on(spdlog::level::critical);
 }
 
-void LockingStderrOrFileSink::logToStdErr() { log_file_.reset(); }
+bool AsyncLogBuffer::push(const char* data, size_t size) {
+  const uint64_t pushed = pushed_.load(std::memory_order_relaxed);
+  if (pushed - drained_.load(std::memory_order_acquire) == lines_.size()) {
+    return false;
+  }
+  lines_[pushed % lines_.size()].assign(data, size);
+  pushed_.store(pushed + 1, std::memory_order_release);
+  return true;
+}
+
+void AsyncLogBuffer::drain(std::string& output) {
+  const uint64_t pushed = pushed_.load(std::memory_order_acquire);
+  uint64_t drained = drained_.load(std::memory_order_relaxed);
+  for (; drained != pushed; drained++) {
+    output.append(lines_[drained % lines_.size()]);
+  }
+  drained_.store(drained, std::memory_order_release);
+}
+
+constexpr size_t LockingStderrOrFileSink::ASYNC_BUFFER_LINES;
+constexpr std::chrono::milliseconds LockingStderrOrFileSink::ASYNC_WRITE_INTERVAL;
+
+void LockingStderrOrFileSink::logToStdErr() {
+  std::unique_lock<std::mutex> lock(write_lock_);
+  if (async_) {
+    writeQueuedLines();
+  }
+  log_file_.reset();
+}
 
 void LockingStderrOrFileSink::logToFile(const std::string& log_path,
                                         AccessLog::AccessLogManager& log_manager) {
-  log_file_ = log_manager.createAccessLog(log_path);
+  Filesystem::FileSharedPtr log_file = log_manager.createAccessLog(log_path);
+  std::unique_lock<std::mutex> lock(write_lock_);
+  if (async_) {
+    writeQueuedLines();
+  }
+  log_file_ = log_file;
+}
+
+void LockingStderrOrFileSink::startAsync() {
+  if (async_) {
+    return;
+  }
+  async_exit_ = false;
+  dropped_lines_ = 0;
+  reported_dropped_lines_ = 0;
+  async_thread_.reset(new std::thread([this]() -> void { asyncThreadRoutine(); }));
+  async_ = true;
+}
+
+void LockingStderrOrFileSink::stopAsync() {
+  if (!async_) {
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> lock(async_lock_);
+    async_exit_ = true;
+  }
+  async_event_.notify_one();
+  async_thread_->join();
+  async_thread_.reset();
+
+  std::unique_lock<std::mutex> lock(write_lock_);
+  writeQueuedLines();
+  async_ = false;
+}
+
+void LockingStderrOrFileSink::asyncThreadRoutine() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(async_lock_);
+      async_event_.wait_for(lock, ASYNC_WRITE_INTERVAL, [this]() -> bool { return async_exit_; });
+      if (async_exit_) {
+        return;
+      }
+    }
+
+    std::unique_lock<std::mutex> lock(write_lock_);
+    writeQueuedLines();
+  }
+}
+
+AsyncLogBuffer& LockingStderrOrFileSink::threadBuffer() {
+  // Lets the thread's buffer be forgotten once it has been drained after the thread exits.
+  struct ThreadBuffer {
+    ~ThreadBuffer() {
+      if (buffer_ != nullptr) {
+        buffer_->thread_exited_.store(true, std::memory_order_release);
+      }
+    }
+
+    AsyncLogBufferSharedPtr buffer_;
+  };
+  static thread_local ThreadBuffer thread_buffer;
+
+  if (thread_buffer.buffer_ == nullptr) {
+    thread_buffer.buffer_ = std::make_shared<AsyncLogBuffer>(ASYNC_BUFFER_LINES);
+    std::unique_lock<std::mutex> lock(buffers_lock_);
+    buffers_.push_back(thread_buffer.buffer_);
+  }
+  return *thread_buffer.buffer_;
+}
+
+void LockingStderrOrFileSink::writeQueuedLines() {
+  std::vector<AsyncLogBufferSharedPtr> buffers;
+  {
+    std::unique_lock<std::mutex> lock(buffers_lock_);
+    buffers = buffers_;
+    // Buffers whose thread has exited are drained a last time below.
+    buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(),
+                                  [](const AsyncLogBufferSharedPtr& buffer) -> bool {
+                                    return buffer->thread_exited_.load(std::memory_order_acquire);
+                                  }),
+                   buffers_.end());
+  }
+
+  for (const AsyncLogBufferSharedPtr& buffer : buffers) {
+    buffer->drain(queued_lines_);
+  }
+  const uint64_t dropped_lines = dropped_lines_;
+  if (dropped_lines != reported_dropped_lines_) {
+    queued_lines_.append(
+        fmt::format("[{} log lines dropped]\n", dropped_lines - reported_dropped_lines_));
+    reported_dropped_lines_ = dropped_lines;
+  }
+
+  if (!queued_lines_.empty()) {
+    write(queued_lines_);
+    queued_lines_.clear();
+  }
+}
+
+void LockingStderrOrFileSink::write(const std::string& data) {
+  if (log_file_) {
+    log_file_->write(data);
+  } else {
+    Thread::OptionalLockGuard<Thread::BasicLockable> guard(lock_);
+    std::cerr << data;
+  }
 }
 
 std::vector<Logger>& Registry::allLoggers() {
@@ -37,6 +174,13 @@ std::vector<Logger>& Registry::allLoggers() {
 }
 
 void LockingStderrOrFileSink::log(const spdlog::details::log_msg& msg) {
+  if (async_.load(std::memory_order_relaxed)) {
+    if (!threadBuffer().push(msg.formatted.data(), msg.formatted.size())) {
+      dropped_lines_++;
+    }
+    return;
+  }
+
   if (log_file_) {
     // Logfiles have internal locking to ensure serial, non-interleaved
     // writes, so no additional locking needed here.
@@ -48,6 +192,11 @@ void LockingStderrOrFileSink::log(const spdlog::details::log_msg& msg) {
 }
 
 void LockingStderrOrFileSink::flush() {
+  if (async_.load(std::memory_order_relaxed)) {
+    std::unique_lock<std::mutex> lock(write_lock_);
+    writeQueuedLines();
+  }
+
   if (log_file_) {
     // Logfiles have internal locking to ensure serial, non-interleaved
     // writes, so no additional locking needed here.
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "envoy/access_log/access_log.h"
@@ -62,6 +67,40 @@ private:
   friend class Registry;
 };
 
+/**
+ * A bounded queue of log lines written by a single thread and drained by another, without locks.
+ * The slots keep their strings once drained, so that lines no longer than the ones before them are
+ * queued without allocating.
+ */
+class AsyncLogBuffer {
+public:
+  AsyncLogBuffer(size_t capacity) : lines_(capacity) {}
+
+  /**
+   * Queue a line. Only called by the thread owning the buffer.
+   * @return bool whether the line was queued, or the buffer was full.
+   */
+  bool push(const char* data, size_t size);
+
+  /**
+   * Append the queued lines to a string and remove them from the buffer. Only called by one thread
+   * at a time.
+   * @param output supplies the string to append the lines to.
+   */
+  void drain(std::string& output);
+
+  // Set once the thread owning the buffer has exited and will queue no more lines.
+  std::atomic<bool> thread_exited_{};
+
+private:
+  std::vector<std::string> lines_;
+  // The number of lines ever queued and drained, only written by the owning and draining threads.
+  std::atomic<uint64_t> pushed_{};
+  std::atomic<uint64_t> drained_{};
+};
+
+typedef std::shared_ptr<AsyncLogBuffer> AsyncLogBufferSharedPtr;
+
 /**
  * An optionally locking stderr or file logging sink.
  *
@@ -90,13 +129,60 @@ public:
    */
   void logToFile(const std::string& log_path, AccessLog::AccessLogManager& log_manager);
 
+  /**
+   * Queue the lines logged by each thread in a buffer of its own, which a background thread writes
+   * to stderr or the file periodically, so that threads logging don't contend on the lock or wait
+   * on the write. Lines logged while a thread's buffer is full are dropped, and their number is
+   * logged once there is room. flush() writes the queued lines before returning.
+   *
+   * @note This method is not thread-safe and can only be called when no other threads
+   * are logging.
+   */
+  void startAsync();
+
+  /**
+   * Write the queued lines and go back to writing lines as they are logged.
+   *
+   * @note This method is not thread-safe and can only be called when no other threads
+   * are logging.
+   */
+  void stopAsync();
+
+  /**
+   * @return uint64_t the number of lines dropped since startAsync() because their thread's buffer
+   *         was full.
+   */
+  uint64_t droppedLines() const { return dropped_lines_; }
+
   // spdlog::sinks::sink
   void log(const spdlog::details::log_msg& msg) override;
   void flush() override;
 
+  static constexpr size_t ASYNC_BUFFER_LINES = 4096;
+  static constexpr std::chrono::milliseconds ASYNC_WRITE_INTERVAL{10};
+
 private:
+  AsyncLogBuffer& threadBuffer();
+  void asyncThreadRoutine();
+  void writeQueuedLines();
+  void write(const std::string& data);
+
   Thread::BasicLockable* lock_{};
   Filesystem::FileSharedPtr log_file_;
+
+  std::atomic<bool> async_{};
+  // The logger library can't depend on the thread library, whose assertions log.
+  std::unique_ptr<std::thread> async_thread_;
+  std::mutex async_lock_;
+  std::condition_variable async_event_;
+  bool async_exit_{};
+  std::mutex buffers_lock_;
+  std::vector<AsyncLogBufferSharedPtr> buffers_;
+  // Held while queued lines are written, and while the destination changes.
+  std::mutex write_lock_;
+  std::string queued_lines_;
+  std::atomic<uint64_t> dropped_lines_{};
+  uint64_t reported_dropped_lines_{};
 };
 
 /**
@@ -196,6 +282,12 @@ protected:
  */
 #define ENVOY_LOG(LEVEL, ...) ENVOY_LOG_TO_LOGGER(ENVOY_LOGGER(), LEVEL, ##__VA_ARGS__)
 
+/**
+ * Convenience macro to check whether the class' logger logs at a level, for arguments which are
+ * expensive to compute since they are evaluated even when the message is not logged.
+ */
+#define ENVOY_LOG_CHECK_LEVEL(LEVEL) ENVOY_LOGGER().should_log(spdlog::level::LEVEL)
+
 /**
  * Convenience macro to log to the misc logger, which allows for logging without of direct access to
  * a logger.
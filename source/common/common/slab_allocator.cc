@@ -0,0 +1,124 @@
+#include "common/common/slab_allocator.h"
+
+#include <array>
+#include <cstddef>
+#include <new>
+
+namespace Envoy {
+
+const size_t SlabAllocator::SIZE_CLASS_GRANULARITY;
+const size_t SlabAllocator::MAX_BLOCK_SIZE;
+const size_t SlabAllocator::MAX_CACHED_BLOCKS_PER_CLASS;
+
+namespace {
+
+const size_t NUM_SIZE_CLASSES =
+    SlabAllocator::MAX_BLOCK_SIZE / SlabAllocator::SIZE_CLASS_GRANULARITY;
+
+// Free blocks are chained through their first bytes.
+struct FreeBlock {
+  FreeBlock* next_;
+};
+
+struct FreeList {
+  FreeBlock* head_{};
+  size_t size_{};
+};
+
+class FreeLists {
+public:
+  ~FreeLists() {
+    for (FreeList& free_list : free_lists_) {
+      while (free_list.head_ != nullptr) {
+        FreeBlock* block = free_list.head_;
+        free_list.head_ = block->next_;
+        ::operator delete(block);
+      }
+    }
+  }
+
+  FreeList& freeList(size_t size_class) { return free_lists_[size_class]; }
+
+private:
+  std::array<FreeList, NUM_SIZE_CLASSES> free_lists_;
+};
+
+enum class State { Uninitialized, Alive, Destroyed };
+
+// The state is trivially destructible, so it remains usable while thread local objects are being
+// destroyed at thread exit, after which blocks are passed straight to the global allocator.
+thread_local State state = State::Uninitialized;
+
+struct ThreadFreeLists {
+  ThreadFreeLists() { state = State::Alive; }
+  ~ThreadFreeLists() { state = State::Destroyed; }
+
+  FreeLists free_lists_;
+};
+
+FreeLists* threadFreeLists() {
+  if (state == State::Destroyed) {
+    return nullptr;
+  }
+  static thread_local ThreadFreeLists thread_free_lists;
+  return &thread_free_lists.free_lists_;
+}
+
+// Size class c holds blocks of (c + 1) * SIZE_CLASS_GRANULARITY bytes.
+size_t sizeClass(size_t size) {
+  return size == 0 ? 0 : (size - 1) / SlabAllocator::SIZE_CLASS_GRANULARITY;
+}
+
+} // namespace
+
+void* SlabAllocator::allocate(size_t size) {
+  if (size > MAX_BLOCK_SIZE) {
+    return ::operator new(size);
+  }
+
+  const size_t size_class = sizeClass(size);
+  FreeLists* free_lists = threadFreeLists();
+  if (free_lists != nullptr) {
+    FreeList& free_list = free_lists->freeList(size_class);
+    if (free_list.head_ != nullptr) {
+      FreeBlock* block = free_list.head_;
+      free_list.head_ = block->next_;
+      free_list.size_--;
+      return block;
+    }
+  }
+
+  return ::operator new((size_class + 1) * SIZE_CLASS_GRANULARITY);
+}
+
+void SlabAllocator::deallocate(void* block, size_t size) {
+  if (block == nullptr) {
+    return;
+  }
+
+  if (size <= MAX_BLOCK_SIZE) {
+    FreeLists* free_lists = threadFreeLists();
+    if (free_lists != nullptr) {
+      FreeList& free_list = free_lists->freeList(sizeClass(size));
+      if (free_list.size_ < MAX_CACHED_BLOCKS_PER_CLASS) {
+        FreeBlock* free_block = static_cast<FreeBlock*>(block);
+        free_block->next_ = free_list.head_;
+        free_list.head_ = free_block;
+        free_list.size_++;
+        return;
+      }
+    }
+  }
+
+  ::operator delete(block);
+}
+
+size_t SlabAllocator::cachedBlocks(size_t size) {
+  FreeLists* free_lists = threadFreeLists();
+  if (size > MAX_BLOCK_SIZE || free_lists == nullptr) {
+    return 0;
+  }
+  return free_lists->freeList(sizeClass(size)).size_;
+}
+
+} // namespace Envoy
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Envoy {
+
+/**
+ * Per thread caches of memory blocks for objects that are allocated and freed at a high rate on
+ * the worker threads, such as the state of each HTTP stream. Block sizes are rounded up to a
+ * multiple of SIZE_CLASS_GRANULARITY, and freed blocks are kept on a free list per size class for
+ * the current thread rather than being returned to malloc. In steady state allocations are then
+ * served from the free list without taking any locks. Each free list holds at most
+ * MAX_CACHED_BLOCKS_PER_CLASS blocks, and blocks larger than MAX_BLOCK_SIZE are not cached.
+ *
+ * A block may be freed on a different thread than the one it was allocated on, in which case it
+ * is cached by the freeing thread.
+ */
+class SlabAllocator {
+public:
+  /**
+   * Allocate a block.
+   * @param size supplies the size of the block.
+   * @return void* the block. Never nullptr, std::bad_alloc is thrown on failure.
+   */
+  static void* allocate(size_t size);
+
+  /**
+   * Free a block allocated by allocate().
+   * @param block supplies the block.
+   * @param size supplies the size that was passed to allocate().
+   */
+  static void deallocate(void* block, size_t size);
+
+  /**
+   * @param size supplies a block size.
+   * @return size_t the number of blocks of the size class of size cached by the current thread.
+   */
+  static size_t cachedBlocks(size_t size);
+
+  static const size_t SIZE_CLASS_GRANULARITY = 64;
+  static const size_t MAX_BLOCK_SIZE = 4096;
+  static const size_t MAX_CACHED_BLOCKS_PER_CLASS = 128;
+};
+
+/**
+ * Mixin for classes whose instances should be allocated with the SlabAllocator. Instances of
+ * derived classes must be deleted through a pointer to their own type, or through a base class
+ * with a virtual destructor, so that the size passed to operator delete is correct.
+ */
+class SlabAllocated {
+public:
+  static void* operator new(size_t size) { return SlabAllocator::allocate(size); }
+  static void operator delete(void* block, size_t size) {
+    SlabAllocator::deallocate(block, size);
+  }
+};
+
+} // namespace Envoy
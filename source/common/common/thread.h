@@ -24,6 +24,14 @@ public:
    */
   static ThreadId currentThreadId();
 
+  /**
+   * Pin the calling thread to a CPU. On Linux, memory the thread allocates afterwards is then
+   * taken from the NUMA node of the CPU by the default first touch policy.
+   * @param cpu supplies the index of the CPU.
+   * @return bool whether the thread was pinned. Pinning is only supported on Linux.
+   */
+  static bool pinCurrentThread(uint32_t cpu);
+
   /**
    * Join on thread exit.
    */
@@ -1,6 +1,7 @@
 #include "common/common/utility.h"
 
 #include <array>
+#include <cctype>
 #include <chrono>
 #include <cstdint>
 #include <iterator>
@@ -203,4 +204,53 @@ std::string StringUtil::toUpper(const std::string& s) {
   return upper_s;
 }
 
+std::string RegexUtil::literalPrefix(const std::string& pattern) {
+  // Alternatives outside of any group can each start differently.
+  uint32_t depth = 0;
+  bool in_class = false;
+  for (size_t i = 0; i < pattern.size(); i++) {
+    const char c = pattern[i];
+    if (c == '\\') {
+      i++;
+    } else if (in_class) {
+      in_class = c != ']';
+    } else if (c == '[') {
+      in_class = true;
+    } else if (c == '(') {
+      depth++;
+    } else if (c == ')' && depth > 0) {
+      depth--;
+    } else if (c == '|' && depth == 0) {
+      return "";
+    }
+  }
+
+  static const std::string special_chars = "^$\\.*+?()[]{}|";
+  static const std::string quantifiers = "*+?{";
+  std::string prefix;
+  size_t i = pattern.size() > 0 && pattern[0] == '^' ? 1 : 0;
+  while (i < pattern.size()) {
+    char literal = pattern[i];
+    size_t next = i + 1;
+    if (literal == '\\') {
+      // Only escaped punctuation is a literal, while escapes such as \d are character classes.
+      if (next == pattern.size() || isalnum(pattern[next])) {
+        break;
+      }
+      literal = pattern[next++];
+    } else if (special_chars.find(literal) != std::string::npos) {
+      break;
+    }
+
+    // A quantified character may not be present, or be present more than once.
+    if (next < pattern.size() && quantifiers.find(pattern[next]) != std::string::npos) {
+      break;
+    }
+    prefix.push_back(literal);
+    i = next;
+  }
+
+  return prefix;
+}
+
 } // namespace Envoy
@@ -189,4 +189,20 @@ public:
   static std::string toUpper(const std::string& s);
 };
 
+/**
+ * Utilities for regular expressions.
+ */
+class RegexUtil {
+public:
+  /**
+   * Find the literal text which every string fully matched by an ECMAScript regular expression
+   * starts with, for example "/api/v" for "^/api/v[0-9]+/.*". Comparing it with a string is much
+   * cheaper than running the regular expression, and rules out most strings which don't match.
+   * @param pattern supplies the regular expression.
+   * @return std::string the literal prefix, which is empty if the expression starts with anything
+   *         other than literal characters or has top level alternatives.
+   */
+  static std::string literalPrefix(const std::string& pattern);
+};
+
 } // namespace Envoy
@@ -0,0 +1,92 @@
+#include "common/compressor/brotli_compressor_impl.h"
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Compressor {
+
+BrotliCompressorImpl::BrotliCompressorImpl() : BrotliCompressorImpl(4096) {}
+
+BrotliCompressorImpl::BrotliCompressorImpl(uint64_t chunk_size)
+    : chunk_size_{chunk_size}, chunk_char_ptr_(new uint8_t[chunk_size]), avail_out_{chunk_size},
+      next_out_{chunk_char_ptr_.get()},
+      state_ptr_(nullptr, [](BrotliEncoderState* state) { BrotliEncoderDestroyInstance(state); }) {}
+
+void BrotliCompressorImpl::init(uint32_t quality, uint32_t window_bits) {
+  ASSERT(initialized_ == false);
+  quality_ = quality;
+  window_bits_ = window_bits;
+  createEncoder();
+  initialized_ = true;
+}
+
+void BrotliCompressorImpl::createEncoder() {
+  state_ptr_.reset(BrotliEncoderCreateInstance(nullptr, nullptr, nullptr));
+  RELEASE_ASSERT(state_ptr_ != nullptr);
+  RELEASE_ASSERT(BrotliEncoderSetParameter(state_ptr_.get(), BROTLI_PARAM_QUALITY, quality_));
+  RELEASE_ASSERT(BrotliEncoderSetParameter(state_ptr_.get(), BROTLI_PARAM_LGWIN, window_bits_));
+}
+
+void BrotliCompressorImpl::flush(Buffer::Instance& output_buffer) {
+  process(output_buffer, nullptr, 0, BROTLI_OPERATION_FLUSH);
+}
+
+void BrotliCompressorImpl::finish(Buffer::Instance& output_buffer) {
+  process(output_buffer, nullptr, 0, BROTLI_OPERATION_FINISH);
+}
+
+void BrotliCompressorImpl::reset() {
+  ASSERT(initialized_);
+  createEncoder();
+  avail_out_ = chunk_size_;
+  next_out_ = chunk_char_ptr_.get();
+}
+
+void BrotliCompressorImpl::compress(const Buffer::Instance& input_buffer,
+                                    Buffer::Instance& output_buffer) {
+  ASSERT(initialized_);
+  const uint64_t num_slices = input_buffer.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  input_buffer.getRawSlices(slices, num_slices);
+
+  for (const Buffer::RawSlice& input_slice : slices) {
+    process(output_buffer, static_cast<const uint8_t*>(input_slice.mem_), input_slice.len_,
+            BROTLI_OPERATION_PROCESS);
+  }
+}
+
+void BrotliCompressorImpl::process(Buffer::Instance& output_buffer, const uint8_t* input,
+                                   size_t length, BrotliEncoderOperation operation) {
+  size_t avail_in = length;
+  const uint8_t* next_in = input;
+  while (true) {
+    const BROTLI_BOOL result = BrotliEncoderCompressStream(
+        state_ptr_.get(), operation, &avail_in, &next_in, &avail_out_, &next_out_, nullptr);
+    RELEASE_ASSERT(result == BROTLI_TRUE);
+    if (avail_out_ == 0) {
+      updateOutput(output_buffer);
+    }
+
+    // The encoder may hold back output which didn't fit, and finishing may take several calls.
+    if (avail_in == 0 && !BrotliEncoderHasMoreOutput(state_ptr_.get()) &&
+        (operation != BROTLI_OPERATION_FINISH || BrotliEncoderIsFinished(state_ptr_.get()))) {
+      break;
+    }
+  }
+
+  if (operation != BROTLI_OPERATION_PROCESS) {
+    updateOutput(output_buffer);
+  }
+}
+
+void BrotliCompressorImpl::updateOutput(Buffer::Instance& output_buffer) {
+  const uint64_t n_output = chunk_size_ - avail_out_;
+  if (n_output > 0) {
+    output_buffer.add(static_cast<void*>(chunk_char_ptr_.get()), n_output);
+  }
+  avail_out_ = chunk_size_;
+  next_out_ = chunk_char_ptr_.get();
+}
+
+} // namespace Compressor
+} // namespace Envoy
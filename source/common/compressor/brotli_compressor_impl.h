@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "envoy/compressor/compressor.h"
+
+#include "brotli/encode.h"
+
+namespace Envoy {
+namespace Compressor {
+
+/**
+ * Implementation of compressor's interface with Brotli (RFC 7932).
+ */
+class BrotliCompressorImpl : public Compressor {
+public:
+  BrotliCompressorImpl();
+
+  /**
+   * Constructor that allows setting the size of compressor's output buffer. It should be called
+   * whenever a buffer size different than the 4096 bytes, normally set by the default constructor,
+   * is desired.
+   * @param chunk_size amount of memory reserved for the compressor output.
+   */
+  BrotliCompressorImpl(uint64_t chunk_size);
+
+  /**
+   * Init must be called in order to initialize the compressor. Once compressor is initialized, it
+   * cannot be initialized again. Init should run before compressing any data.
+   * @param quality sets the compression quality, from 0 (fastest) to 11 (smallest output). Levels
+   * from 4 to 6 suit dynamic content best.
+   * @param window_bits sets the base two logarithm of the window size, from 10 to 24. Larger
+   * values result in better compression, but will use more memory.
+   */
+  void init(uint32_t quality, uint32_t window_bits);
+
+  /**
+   * Flush should be called when the data compressed so far needs to be output. Note that forcing
+   * flush frequently degrades the compression ratio, so this should only be called when necessary.
+   * @param output_buffer supplies the buffer to output compressed data.
+   */
+  void flush(Buffer::Instance& output_buffer);
+
+  // Compressor
+  void compress(const Buffer::Instance& input_buffer, Buffer::Instance& output_buffer) override;
+  void finish(Buffer::Instance& output_buffer) override;
+  // Brotli has no way of resetting an encoder, so a new one is created. Only the output buffer is
+  // kept.
+  void reset() override;
+
+private:
+  void createEncoder();
+  void process(Buffer::Instance& output_buffer, const uint8_t* input, size_t length,
+               BrotliEncoderOperation operation);
+  void updateOutput(Buffer::Instance& output_buffer);
+
+  const uint64_t chunk_size_;
+  bool initialized_{};
+  uint32_t quality_{};
+  uint32_t window_bits_{};
+
+  std::unique_ptr<uint8_t[]> chunk_char_ptr_;
+  size_t avail_out_;
+  uint8_t* next_out_;
+  std::unique_ptr<BrotliEncoderState, std::function<void(BrotliEncoderState*)>> state_ptr_;
+};
+
+} // namespace Compressor
+} // namespace Envoy
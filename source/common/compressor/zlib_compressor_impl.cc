@@ -35,6 +35,18 @@ void ZlibCompressorImpl::flush(Buffer::Instance& output_buffer) {
   process(output_buffer, Z_SYNC_FLUSH);
 }
 
+void ZlibCompressorImpl::finish(Buffer::Instance& output_buffer) {
+  process(output_buffer, Z_FINISH);
+}
+
+void ZlibCompressorImpl::reset() {
+  ASSERT(initialized_);
+  const int result = deflateReset(zstream_ptr_.get());
+  RELEASE_ASSERT(result == Z_OK);
+  zstream_ptr_->avail_out = chunk_size_;
+  zstream_ptr_->next_out = chunk_char_ptr_.get();
+}
+
 uint64_t ZlibCompressorImpl::checksum() { return zstream_ptr_->adler; }
 
 void ZlibCompressorImpl::compress(const Buffer::Instance& input_buffer,
@@ -56,6 +68,10 @@ bool ZlibCompressorImpl::deflateNext(int64_t flush_state) {
     return false; // This means that zlib needs more input, so stop here.
   }
 
+  if (result == Z_STREAM_END) {
+    return false; // The stream has been finished, so there is nothing more to output.
+  }
+
   RELEASE_ASSERT(result == Z_OK);
   return true;
 }
@@ -67,7 +83,7 @@ void ZlibCompressorImpl::process(Buffer::Instance& output_buffer, int64_t flush_
     }
   }
 
-  if (flush_state == Z_SYNC_FLUSH) {
+  if (flush_state == Z_SYNC_FLUSH || flush_state == Z_FINISH) {
     updateOutput(output_buffer);
   }
 }
@@ -77,7 +93,6 @@ void ZlibCompressorImpl::updateOutput(Buffer::Instance& output_buffer) {
   if (n_output > 0) {
     output_buffer.add(static_cast<void*>(chunk_char_ptr_.get()), n_output);
   }
-  chunk_char_ptr_.reset(new unsigned char[chunk_size_]);
   zstream_ptr_->avail_out = chunk_size_;
   zstream_ptr_->next_out = chunk_char_ptr_.get();
 }
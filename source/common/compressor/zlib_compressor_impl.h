@@ -1,5 +1,8 @@
 #pragma once
 
+#include <functional>
+#include <memory>
+
 #include "envoy/compressor/compressor.h"
 
 #include "zlib.h"
@@ -82,6 +85,10 @@ public:
 
   // Compressor
   void compress(const Buffer::Instance& input_buffer, Buffer::Instance& output_buffer) override;
+  // The end of the stream written by finish() is the gzip trailer or the zlib checksum, and reset()
+  // keeps the memory allocated by init().
+  void finish(Buffer::Instance& output_buffer) override;
+  void reset() override;
 
 private:
   bool deflateNext(int64_t flush_state);
@@ -95,5 +102,7 @@ private:
   std::unique_ptr<z_stream, std::function<void(z_stream*)>> zstream_ptr_;
 };
 
+typedef std::unique_ptr<ZlibCompressorImpl> ZlibCompressorImplPtr;
+
 } // namespace Compressor
 } // namespace Envoy
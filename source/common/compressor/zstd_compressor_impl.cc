@@ -0,0 +1,82 @@
+#include "common/compressor/zstd_compressor_impl.h"
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Compressor {
+
+ZstdCompressorImpl::ZstdCompressorImpl() : ZstdCompressorImpl(4096) {}
+
+ZstdCompressorImpl::ZstdCompressorImpl(uint64_t chunk_size)
+    : chunk_size_{chunk_size}, chunk_char_ptr_(new uint8_t[chunk_size]),
+      output_{chunk_char_ptr_.get(), chunk_size, 0},
+      cctx_ptr_(ZSTD_createCCtx(), [](ZSTD_CCtx* cctx) { ZSTD_freeCCtx(cctx); }) {
+  RELEASE_ASSERT(cctx_ptr_ != nullptr);
+}
+
+void ZstdCompressorImpl::init(int32_t level) {
+  ASSERT(initialized_ == false);
+  const size_t result = ZSTD_CCtx_setParameter(cctx_ptr_.get(), ZSTD_c_compressionLevel, level);
+  RELEASE_ASSERT(!ZSTD_isError(result));
+  initialized_ = true;
+}
+
+void ZstdCompressorImpl::flush(Buffer::Instance& output_buffer) {
+  process(output_buffer, nullptr, 0, ZSTD_e_flush);
+}
+
+void ZstdCompressorImpl::finish(Buffer::Instance& output_buffer) {
+  process(output_buffer, nullptr, 0, ZSTD_e_end);
+}
+
+void ZstdCompressorImpl::reset() {
+  ASSERT(initialized_);
+  const size_t result = ZSTD_CCtx_reset(cctx_ptr_.get(), ZSTD_reset_session_only);
+  RELEASE_ASSERT(!ZSTD_isError(result));
+  output_.pos = 0;
+}
+
+void ZstdCompressorImpl::compress(const Buffer::Instance& input_buffer,
+                                  Buffer::Instance& output_buffer) {
+  ASSERT(initialized_);
+  const uint64_t num_slices = input_buffer.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  input_buffer.getRawSlices(slices, num_slices);
+
+  for (const Buffer::RawSlice& input_slice : slices) {
+    process(output_buffer, input_slice.mem_, input_slice.len_, ZSTD_e_continue);
+  }
+}
+
+void ZstdCompressorImpl::process(Buffer::Instance& output_buffer, const void* input, size_t length,
+                                 ZSTD_EndDirective directive) {
+  ZSTD_inBuffer input_zstd{input, length, 0};
+  while (true) {
+    // The result is the number of bytes still to be flushed, which only matters when flushing or
+    // ending the frame.
+    const size_t remaining =
+        ZSTD_compressStream2(cctx_ptr_.get(), &output_, &input_zstd, directive);
+    RELEASE_ASSERT(!ZSTD_isError(remaining));
+    if (output_.pos == output_.size) {
+      updateOutput(output_buffer);
+    }
+
+    if (directive == ZSTD_e_continue ? input_zstd.pos == input_zstd.size : remaining == 0) {
+      break;
+    }
+  }
+
+  if (directive != ZSTD_e_continue) {
+    updateOutput(output_buffer);
+  }
+}
+
+void ZstdCompressorImpl::updateOutput(Buffer::Instance& output_buffer) {
+  if (output_.pos > 0) {
+    output_buffer.add(static_cast<void*>(chunk_char_ptr_.get()), output_.pos);
+  }
+  output_.pos = 0;
+}
+
+} // namespace Compressor
+} // namespace Envoy
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "envoy/compressor/compressor.h"
+
+#include "zstd.h"
+
+namespace Envoy {
+namespace Compressor {
+
+/**
+ * Implementation of compressor's interface with Zstandard (RFC 8478).
+ */
+class ZstdCompressorImpl : public Compressor {
+public:
+  ZstdCompressorImpl();
+
+  /**
+   * Constructor that allows setting the size of compressor's output buffer. It should be called
+   * whenever a buffer size different than the 4096 bytes, normally set by the default constructor,
+   * is desired.
+   * @param chunk_size amount of memory reserved for the compressor output.
+   */
+  ZstdCompressorImpl(uint64_t chunk_size);
+
+  /**
+   * Init must be called in order to initialize the compressor. Once compressor is initialized, it
+   * cannot be initialized again. Init should run before compressing any data.
+   * @param level sets the compression level, from 1 (fastest) to 19 (smallest output). The zstd
+   * default is 3.
+   */
+  void init(int32_t level);
+
+  /**
+   * Flush should be called when the data compressed so far needs to be output. Note that forcing
+   * flush frequently degrades the compression ratio, so this should only be called when necessary.
+   * @param output_buffer supplies the buffer to output compressed data.
+   */
+  void flush(Buffer::Instance& output_buffer);
+
+  // Compressor
+  void compress(const Buffer::Instance& input_buffer, Buffer::Instance& output_buffer) override;
+  void finish(Buffer::Instance& output_buffer) override;
+  // The compression context, and the memory allocated for it, is kept.
+  void reset() override;
+
+private:
+  void process(Buffer::Instance& output_buffer, const void* input, size_t length,
+               ZSTD_EndDirective directive);
+  void updateOutput(Buffer::Instance& output_buffer);
+
+  const uint64_t chunk_size_;
+  bool initialized_{};
+
+  std::unique_ptr<uint8_t[]> chunk_char_ptr_;
+  ZSTD_outBuffer output_;
+  std::unique_ptr<ZSTD_CCtx, std::function<void(ZSTD_CCtx*)>> cctx_ptr_;
+};
+
+} // namespace Compressor
+} // namespace Envoy
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/config/subscription.h"
+
+#include "common/common/logger.h"
+#include "common/config/utility.h"
+#include "common/filesystem/filesystem_impl.h"
+#include "common/protobuf/protobuf.h"
+#include "common/protobuf/utility.h"
+
+#include "api/base.pb.h"
+
+namespace Envoy {
+namespace Config {
+
+/**
+ * Subscription which keeps the last update accepted from another subscription in a file, as a
+ * binary envoy::api::v2::DiscoveryResponse, and applies the update in the file when started. A
+ * restarted server can so become ready with its previous configuration before the management
+ * server responds, which then replaces it as usual. An update in the file which is rejected is
+ * ignored.
+ */
+template <class ResourceType>
+class CachedSubscriptionImpl : public Subscription<ResourceType>,
+                               SubscriptionCallbacks<ResourceType>,
+                               Logger::Loggable<Logger::Id::config> {
+public:
+  typedef typename SubscriptionCallbacks<ResourceType>::ResourceVector ResourceVector;
+
+  /**
+   * @param subscription supplies the subscription to cache the updates of.
+   * @param path supplies the file to keep the updates in. It must end in .pb.
+   */
+  CachedSubscriptionImpl(std::unique_ptr<Subscription<ResourceType>>&& subscription,
+                         const std::string& path)
+      : subscription_(std::move(subscription)), path_(path) {}
+
+  // Config::Subscription
+  void start(const std::vector<std::string>& resources,
+             SubscriptionCallbacks<ResourceType>& callbacks) override {
+    callbacks_ = &callbacks;
+    loadCache();
+    subscription_->start(resources, *this);
+  }
+
+  void updateResources(const std::vector<std::string>& resources) override {
+    subscription_->updateResources(resources);
+  }
+
+  const std::string versionInfo() const override { return subscription_->versionInfo(); }
+
+  // Config::SubscriptionCallbacks
+  void onConfigUpdate(const ResourceVector& resources) override {
+    // A rejected update throws, and so is never cached.
+    callbacks_->onConfigUpdate(resources);
+    storeCache(resources);
+  }
+
+  void onConfigUpdateFailed(const EnvoyException* e) override {
+    callbacks_->onConfigUpdateFailed(e);
+  }
+
+private:
+  void loadCache() {
+    if (!Filesystem::fileExists(path_)) {
+      return;
+    }
+    try {
+      envoy::api::v2::DiscoveryResponse message;
+      MessageUtil::loadFromFile(path_, message);
+      callbacks_->onConfigUpdate(Config::Utility::getTypedResources<ResourceType>(message));
+      ENVOY_LOG(info, "applied cached config update from {}", path_);
+    } catch (const EnvoyException& e) {
+      ENVOY_LOG(warn, "cached config update from {} rejected: {}", path_, e.what());
+    }
+  }
+
+  void storeCache(const ResourceVector& resources) {
+    envoy::api::v2::DiscoveryResponse message;
+    for (const auto& resource : resources) {
+      message.add_resources()->PackFrom(resource);
+    }
+
+    // Write a temporary file which is then renamed over the cache, so that the cache is never left
+    // half written.
+    const std::string temp_path = path_ + ".tmp";
+    bool written;
+    {
+      std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+      written = message.SerializeToOstream(&file);
+    }
+    if (!written || std::rename(temp_path.c_str(), path_.c_str()) != 0) {
+      ENVOY_LOG(warn, "unable to cache config update in {}", path_);
+      std::remove(temp_path.c_str());
+    }
+  }
+
+  std::unique_ptr<Subscription<ResourceType>> subscription_;
+  const std::string path_;
+  SubscriptionCallbacks<ResourceType>* callbacks_{};
+};
+
+} // namespace Config
+} // namespace Envoy
@@ -3,6 +3,7 @@
 #include <unordered_set>
 
 #include "common/config/utility.h"
+#include "common/http/headers.h"
 #include "common/protobuf/protobuf.h"
 
 namespace Envoy {
@@ -46,6 +47,11 @@ void GrpcMuxImpl::setRetryTimer() {
 
 void GrpcMuxImpl::establishNewStream() {
   ENVOY_LOG(debug, "Establishing new gRPC bidi stream for {}", service_method_.DebugString());
+  // The management server has no state for a new stream, so it starts over with every resource.
+  incremental_ = false;
+  for (auto& api_state : api_state_) {
+    api_state.second.resources_.clear();
+  }
   stream_ = async_client_->start(service_method_, *this);
   if (stream_ == nullptr) {
     ENVOY_LOG(warn, "Unable to establish new stream");
@@ -85,6 +91,16 @@ void GrpcMuxImpl::sendDiscoveryRequest(const std::string& type_url) {
     }
   }
 
+  // Forget resources which are no longer watched, so that they are not mistaken for the current
+  // version should they be watched again.
+  for (auto it = api_state.resources_.begin(); it != api_state.resources_.end();) {
+    if (resources.count(it->first) == 0) {
+      it = api_state.resources_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
   ENVOY_LOG(trace, "Sending DiscoveryRequest for {}: {}", type_url, request.DebugString());
   stream_->sendMessage(request, false);
 }
@@ -127,16 +143,17 @@ GrpcMuxWatchPtr GrpcMuxImpl::subscribe(const std::string& type_url,
 void GrpcMuxImpl::pause(const std::string& type_url) {
   ENVOY_LOG(debug, "Pausing discovery requests for {}", type_url);
   ApiState& api_state = api_state_[type_url];
-  ASSERT(!api_state.paused_);
-  ASSERT(!api_state.pending_);
-  api_state.paused_ = true;
+  ASSERT(api_state.paused_ > 0 || !api_state.pending_);
+  ++api_state.paused_;
 }
 
 void GrpcMuxImpl::resume(const std::string& type_url) {
   ENVOY_LOG(debug, "Resuming discovery requests for {}", type_url);
   ApiState& api_state = api_state_[type_url];
-  ASSERT(api_state.paused_);
-  api_state.paused_ = false;
+  ASSERT(api_state.paused_ > 0);
+  if (--api_state.paused_ > 0) {
+    return;
+  }
 
   if (api_state.pending_) {
     ASSERT(api_state.subscribed_);
@@ -146,11 +163,15 @@ void GrpcMuxImpl::resume(const std::string& type_url) {
 }
 
 void GrpcMuxImpl::onCreateInitialMetadata(Http::HeaderMap& metadata) {
-  UNREFERENCED_PARAMETER(metadata);
+  metadata.addReference(Http::Headers::get().EnvoyIncrementalXds,
+                        Http::Headers::get().EnvoyIncrementalXdsValues.True);
 }
 
 void GrpcMuxImpl::onReceiveInitialMetadata(Http::HeaderMapPtr&& metadata) {
-  UNREFERENCED_PARAMETER(metadata);
+  const Http::HeaderEntry* incremental = metadata->get(Http::Headers::get().EnvoyIncrementalXds);
+  const std::string& incremental_true = Http::Headers::get().EnvoyIncrementalXdsValues.True;
+  incremental_ = incremental != nullptr && incremental->value() == incremental_true.c_str();
+  ENVOY_LOG(debug, "gRPC config stream is {}", incremental_ ? "incremental" : "state of the world");
 }
 
 void GrpcMuxImpl::onReceiveMessage(std::unique_ptr<envoy::api::v2::DiscoveryResponse>&& message) {
@@ -160,6 +181,12 @@ void GrpcMuxImpl::onReceiveMessage(std::unique_ptr<envoy::api::v2::DiscoveryResp
     ENVOY_LOG(warn, "Ignoring unknown type URL {}", type_url);
     return;
   }
+  ApiState& api_state = api_state_[type_url];
+  // On an incremental stream, the cached versions of the resources in the response which were
+  // replaced, and the resources which were added to the cache, so that a rejected update can be
+  // taken back.
+  std::unordered_map<std::string, ProtobufWkt::Any> replaced_resources;
+  std::unordered_set<std::string> added_resources;
   try {
     // To avoid O(n^2) explosion (e.g. when we have 1000s of EDS watches), we
     // build a map here from resource name to resource and then walk watches_.
@@ -174,28 +201,64 @@ void GrpcMuxImpl::onReceiveMessage(std::unique_ptr<envoy::api::v2::DiscoveryResp
       const std::string resource_name = Utility::resourceName(resource);
       resources.emplace(resource_name, resource);
     }
-    for (auto watch : api_state_[type_url].watches_) {
+    for (auto watch : api_state.watches_) {
       if (watch->resources_.empty()) {
         watch->callbacks_.onConfigUpdate(message->resources(), message->version_info());
         continue;
       }
       Protobuf::RepeatedPtrField<ProtobufWkt::Any> found_resources;
-      for (auto watched_resource_name : watch->resources_) {
-        auto it = resources.find(watched_resource_name);
-        if (it != resources.end()) {
-          found_resources.Add()->MergeFrom(it->second);
+      if (incremental_) {
+        // Only the resources which changed are sent, so watches on none of them are left as they
+        // are, and the other watches get their unchanged resources from the cache.
+        bool changed = false;
+        for (const auto& watched_resource_name : watch->resources_) {
+          auto it = resources.find(watched_resource_name);
+          if (it == resources.end()) {
+            continue;
+          }
+          changed = true;
+          auto cached = api_state.resources_.find(watched_resource_name);
+          if (cached == api_state.resources_.end()) {
+            added_resources.emplace(watched_resource_name);
+            api_state.resources_.emplace(watched_resource_name, it->second);
+          } else if (added_resources.count(watched_resource_name) == 0) {
+            replaced_resources.emplace(watched_resource_name, cached->second);
+            cached->second = it->second;
+          }
+        }
+        if (!changed) {
+          continue;
+        }
+        for (const auto& watched_resource_name : watch->resources_) {
+          auto it = api_state.resources_.find(watched_resource_name);
+          if (it != api_state.resources_.end()) {
+            found_resources.Add()->MergeFrom(it->second);
+          }
+        }
+      } else {
+        for (auto watched_resource_name : watch->resources_) {
+          auto it = resources.find(watched_resource_name);
+          if (it != resources.end()) {
+            found_resources.Add()->MergeFrom(it->second);
+          }
         }
       }
       watch->callbacks_.onConfigUpdate(found_resources, message->version_info());
     }
-    api_state_[type_url].request_.set_version_info(message->version_info());
+    api_state.request_.set_version_info(message->version_info());
   } catch (const EnvoyException& e) {
     ENVOY_LOG(warn, "gRPC config for {} update rejected: {}", message->type_url(), e.what());
-    for (auto watch : api_state_[type_url].watches_) {
+    for (const auto& resource_name : added_resources) {
+      api_state.resources_.erase(resource_name);
+    }
+    for (const auto& resource : replaced_resources) {
+      api_state.resources_[resource.first] = resource.second;
+    }
+    for (auto watch : api_state.watches_) {
       watch->callbacks_.onConfigUpdateFailed(&e);
     }
   }
-  api_state_[type_url].request_.set_response_nonce(message->nonce());
+  api_state.request_.set_response_nonce(message->nonce());
   sendDiscoveryRequest(type_url);
 }
 
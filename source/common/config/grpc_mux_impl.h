@@ -15,6 +15,12 @@ namespace Config {
 
 /**
  * ADS API implementation that fetches via gRPC.
+ *
+ * Envoy offers an incremental variant of the protocol with the "x-envoy-incremental-xds: true"
+ * request header of the stream, which the management server accepts by sending the same header in
+ * its response headers. On an incremental stream, responses to requests with resource names only
+ * carry the resources that changed since the last response, and only the watches on those
+ * resources are updated. Responses to wildcard requests still carry every resource.
  */
 class GrpcMuxImpl : public GrpcMux,
                     Grpc::AsyncStreamCallbacks<envoy::api::v2::DiscoveryResponse>,
@@ -80,12 +86,14 @@ private:
     std::list<GrpcMuxWatchImpl*> watches_;
     // Current DiscoveryRequest for API.
     envoy::api::v2::DiscoveryRequest request_;
-    // Paused via pause()?
-    bool paused_{};
+    // Number of pause() calls which haven't been resumed yet.
+    uint32_t paused_{};
     // Was a DiscoveryRequest elided during a pause?
     bool pending_{};
     // Has this API been tracked in subscriptions_?
     bool subscribed_{};
+    // On an incremental stream, the last received version of each watched resource, by name.
+    std::unordered_map<std::string, ProtobufWkt::Any> resources_;
   };
 
   envoy::api::v2::Node node_;
@@ -98,6 +106,8 @@ private:
   // Envoy's dependendency ordering.
   std::list<std::string> subscriptions_;
   Event::TimerPtr retry_timer_;
+  // Whether the management server accepted the incremental protocol on the current stream.
+  bool incremental_{};
 };
 
 class NullGrpcMuxImpl : public GrpcMux {
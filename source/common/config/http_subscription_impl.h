@@ -71,11 +71,12 @@ public:
     request.body().reset(new Buffer::OwnedImpl(MessageUtil::getJsonStringFromMessage(request_)));
   }
 
-  void parseResponse(const Http::Message& response) override {
+  void parseResponse(Http::Message& response) override {
     envoy::api::v2::DiscoveryResponse message;
-    const auto status = Protobuf::util::JsonStringToMessage(response.bodyAsString(), &message);
-    if (!status.ok()) {
-      ENVOY_LOG(warn, "REST config JSON conversion error: {}", status.ToString());
+    try {
+      MessageUtil::loadFromJson(*response.body(), message);
+    } catch (const EnvoyException& e) {
+      ENVOY_LOG(warn, "REST config JSON conversion error: {}", e.what());
       handleFailure(nullptr);
       return;
     }
@@ -0,0 +1,110 @@
+#include "common/config/threaded_grpc_mux_impl.h"
+
+namespace Envoy {
+namespace Config {
+
+ThreadedGrpcMuxImpl::ThreadedGrpcMuxImpl(Event::Dispatcher& main_dispatcher,
+                                         Event::Dispatcher& mux_dispatcher,
+                                         std::function<GrpcMuxPtr()> mux_factory)
+    : main_dispatcher_(main_dispatcher), mux_dispatcher_(mux_dispatcher),
+      state_(std::make_shared<SharedState>()) {
+  SharedStateSharedPtr state = state_;
+  mux_dispatcher_.post([state, mux_factory]() -> void { state->mux_ = mux_factory(); });
+}
+
+ThreadedGrpcMuxImpl::~ThreadedGrpcMuxImpl() {
+  {
+    std::unique_lock<std::mutex> lock(state_->mutex_);
+    state_->shutdown_ = true;
+  }
+  state_->applied_event_.notify_all();
+  SharedStateSharedPtr state = state_;
+  mux_dispatcher_.post([state]() -> void { state->mux_.reset(); });
+}
+
+void ThreadedGrpcMuxImpl::start() {
+  SharedStateSharedPtr state = state_;
+  mux_dispatcher_.post([state]() -> void { state->mux_->start(); });
+}
+
+GrpcMuxWatchPtr ThreadedGrpcMuxImpl::subscribe(const std::string& type_url,
+                                               const std::vector<std::string>& resources,
+                                               GrpcMuxCallbacks& callbacks) {
+  WatchCallbacksSharedPtr watch_callbacks =
+      std::make_shared<WatchCallbacks>(callbacks, main_dispatcher_, state_);
+  SharedStateSharedPtr state = state_;
+  mux_dispatcher_.post([state, watch_callbacks, type_url, resources]() -> void {
+    watch_callbacks->watch_ = state->mux_->subscribe(type_url, resources, *watch_callbacks);
+  });
+  return GrpcMuxWatchPtr{new WatchImpl(watch_callbacks, mux_dispatcher_)};
+}
+
+void ThreadedGrpcMuxImpl::pause(const std::string& type_url) {
+  SharedStateSharedPtr state = state_;
+  mux_dispatcher_.post([state, type_url]() -> void { state->mux_->pause(type_url); });
+}
+
+void ThreadedGrpcMuxImpl::resume(const std::string& type_url) {
+  SharedStateSharedPtr state = state_;
+  mux_dispatcher_.post([state, type_url]() -> void { state->mux_->resume(type_url); });
+}
+
+void ThreadedGrpcMuxImpl::WatchCallbacks::onConfigUpdate(
+    const Protobuf::RepeatedPtrField<ProtobufWkt::Any>& resources,
+    const std::string& version_info) {
+  // The resources are read on the main thread while this thread waits, so they are not copied.
+  // Once the mux is deleted, this thread only waits for an update which is being applied.
+  bool applied = false;
+  std::unique_ptr<EnvoyException> rejection;
+  WatchCallbacksSharedPtr self = shared_from_this();
+  main_dispatcher_.post([self, &resources, &version_info, &applied, &rejection]() -> void {
+    std::unique_lock<std::mutex> lock(self->state_->mutex_);
+    if (self->state_->shutdown_) {
+      return;
+    }
+    if (!self->cancelled_) {
+      // The lock is not held while the update is applied, which may delete the mux.
+      self->state_->applying_ = true;
+      lock.unlock();
+      try {
+        self->callbacks_.onConfigUpdate(resources, version_info);
+      } catch (const EnvoyException& e) {
+        rejection.reset(new EnvoyException(e.what()));
+      }
+      lock.lock();
+      self->state_->applying_ = false;
+    }
+    applied = true;
+    self->state_->applied_event_.notify_all();
+  });
+
+  std::unique_lock<std::mutex> lock(state_->mutex_);
+  state_->applied_event_.wait(lock, [this, &applied]() {
+    return applied || (state_->shutdown_ && !state_->applying_);
+  });
+  if (applied && rejection) {
+    throw *rejection;
+  }
+}
+
+void ThreadedGrpcMuxImpl::WatchCallbacks::onConfigUpdateFailed(const EnvoyException* e) {
+  std::shared_ptr<EnvoyException> failure;
+  if (e != nullptr) {
+    failure = std::make_shared<EnvoyException>(e->what());
+  }
+  WatchCallbacksSharedPtr self = shared_from_this();
+  main_dispatcher_.post([self, failure]() -> void {
+    if (!self->cancelled_) {
+      self->callbacks_.onConfigUpdateFailed(failure.get());
+    }
+  });
+}
+
+ThreadedGrpcMuxImpl::WatchImpl::~WatchImpl() {
+  callbacks_->cancelled_ = true;
+  WatchCallbacksSharedPtr callbacks = callbacks_;
+  mux_dispatcher_.post([callbacks]() -> void { callbacks->watch_.reset(); });
+}
+
+} // namespace Config
+} // namespace Envoy
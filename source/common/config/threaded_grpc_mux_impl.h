@@ -0,0 +1,101 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "envoy/config/grpc_mux.h"
+#include "envoy/event/dispatcher.h"
+
+namespace Envoy {
+namespace Config {
+
+/**
+ * GrpcMux which runs another GrpcMux on a thread of its own, so that the stream I/O and the
+ * decoding of large responses do not hold up the main thread. Starting, subscriptions, pauses and
+ * resumes are posted to that thread, in order. The watch callbacks are posted back to the main
+ * thread, where the resources are applied, the mux thread waiting for each update to be accepted
+ * or rejected so that it is acknowledged as usual. The wrapped mux is created and deleted on its
+ * thread.
+ */
+class ThreadedGrpcMuxImpl : public GrpcMux {
+public:
+  /**
+   * @param main_dispatcher supplies the dispatcher of the thread which uses the mux.
+   * @param mux_dispatcher supplies the dispatcher of the thread to run the wrapped mux on, which
+   *        must keep running until the mux is deleted.
+   * @param mux_factory supplies the function creating the wrapped mux, called on its thread.
+   */
+  ThreadedGrpcMuxImpl(Event::Dispatcher& main_dispatcher, Event::Dispatcher& mux_dispatcher,
+                      std::function<GrpcMuxPtr()> mux_factory);
+  ~ThreadedGrpcMuxImpl();
+
+  // Config::GrpcMux
+  void start() override;
+  GrpcMuxWatchPtr subscribe(const std::string& type_url, const std::vector<std::string>& resources,
+                            GrpcMuxCallbacks& callbacks) override;
+  void pause(const std::string& type_url) override;
+  void resume(const std::string& type_url) override;
+
+private:
+  // State shared with the callbacks posted to either thread, which may run after the deletion of
+  // the mux.
+  struct SharedState {
+    // Only accessed on the mux thread.
+    GrpcMuxPtr mux_;
+    std::mutex mutex_;
+    std::condition_variable applied_event_;
+    // Set when the mux is deleted, so that the mux thread stops waiting for the main thread.
+    bool shutdown_{};
+    // Whether the main thread is applying an update, which the mux thread waits for regardless.
+    bool applying_{};
+  };
+
+  typedef std::shared_ptr<SharedState> SharedStateSharedPtr;
+
+  /**
+   * Callbacks of a watch on the wrapped mux, called on the mux thread, which call the callbacks of
+   * the subscription on the main thread.
+   */
+  struct WatchCallbacks : public GrpcMuxCallbacks,
+                          public std::enable_shared_from_this<WatchCallbacks> {
+    WatchCallbacks(GrpcMuxCallbacks& callbacks, Event::Dispatcher& main_dispatcher,
+                   SharedStateSharedPtr state)
+        : callbacks_(callbacks), main_dispatcher_(main_dispatcher), state_(state) {}
+
+    // Config::GrpcMuxCallbacks
+    void onConfigUpdate(const Protobuf::RepeatedPtrField<ProtobufWkt::Any>& resources,
+                        const std::string& version_info) override;
+    void onConfigUpdateFailed(const EnvoyException* e) override;
+
+    GrpcMuxCallbacks& callbacks_;
+    Event::Dispatcher& main_dispatcher_;
+    SharedStateSharedPtr state_;
+    // Only accessed on the main thread. Set when the watch is deleted, after which the callbacks
+    // of the subscription may be gone.
+    bool cancelled_{};
+    // Only accessed on the mux thread.
+    GrpcMuxWatchPtr watch_;
+  };
+
+  typedef std::shared_ptr<WatchCallbacks> WatchCallbacksSharedPtr;
+
+  struct WatchImpl : public GrpcMuxWatch {
+    WatchImpl(WatchCallbacksSharedPtr callbacks, Event::Dispatcher& mux_dispatcher)
+        : callbacks_(callbacks), mux_dispatcher_(mux_dispatcher) {}
+    ~WatchImpl();
+
+    WatchCallbacksSharedPtr callbacks_;
+    Event::Dispatcher& mux_dispatcher_;
+  };
+
+  Event::Dispatcher& main_dispatcher_;
+  Event::Dispatcher& mux_dispatcher_;
+  SharedStateSharedPtr state_;
+};
+
+} // namespace Config
+} // namespace Envoy
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "envoy/buffer/buffer.h"
 #include "envoy/config/grpc_mux.h"
 #include "envoy/config/subscription.h"
 #include "envoy/json/json_object.h"
@@ -61,7 +62,7 @@ public:
 
   /**
    * Legacy APIs uses JSON and do not have an explicit version.
-   * @param input the input to hash.
+   * @param input the input to hash, either as a string or in a buffer, which gives the same hash.
    * @return std::pair<std::string, uint64_t> the string is the hash converted into
    *         a hex string, pre-pended by a user friendly prefix. The uint64_t is the
    *         raw hash.
@@ -70,6 +71,10 @@ public:
     uint64_t hash = HashUtil::xxHash64(input);
     return std::make_pair("hash_" + Hex::uint64ToHex(hash), hash);
   }
+  static std::pair<std::string, uint64_t> computeHashedVersion(const Buffer::Instance& input) {
+    uint64_t hash = HashUtil::xxHash64(input);
+    return std::make_pair("hash_" + Hex::uint64ToHex(hash), hash);
+  }
 
   /**
    * Extract refresh_delay as a std::chrono::milliseconds from envoy::api::v2::ApiConfigSource.
@@ -58,6 +58,8 @@ public:
   const std::string ECHO = "envoy.echo";
   // HTTP connection manager filter
   const std::string HTTP_CONNECTION_MANAGER = "envoy.http_connection_manager";
+  // Local rate limit filter
+  const std::string LOCAL_RATE_LIMIT = "envoy.local_ratelimit";
   // Mongo proxy filter
   const std::string MONGO_PROXY = "envoy.mongo_proxy";
   // Rate limit filter
@@ -71,8 +73,8 @@ public:
   const V1Converter v1_converter_;
 
   NetworkFilterNameValues()
-      : v1_converter_({CLIENT_SSL_AUTH, ECHO, HTTP_CONNECTION_MANAGER, MONGO_PROXY, RATE_LIMIT,
-                       REDIS_PROXY, TCP_PROXY}) {}
+      : v1_converter_({CLIENT_SSL_AUTH, ECHO, HTTP_CONNECTION_MANAGER, LOCAL_RATE_LIMIT,
+                       MONGO_PROXY, RATE_LIMIT, REDIS_PROXY, TCP_PROXY}) {}
 };
 
 typedef ConstSingleton<NetworkFilterNameValues> NetworkFilterNames;
@@ -95,8 +97,14 @@ class HttpFilterNameValues {
 public:
   // Buffer filter
   const std::string BUFFER = "envoy.buffer";
+  // Cache filter
+  const std::string CACHE = "envoy.cache";
+  // Compression filter
+  const std::string COMPRESSION = "envoy.compression";
   // CORS filter
   const std::string CORS = "envoy.cors";
+  // Decompression filter
+  const std::string DECOMPRESSION = "envoy.decompression";
   // Dynamo filter
   const std::string DYNAMO = "envoy.http_dynamo_filter";
   // Fault filter
@@ -109,6 +117,10 @@ public:
   const std::string GRPC_WEB = "envoy.grpc_web";
   // IP tagging filter
   const std::string IP_TAGGING = "envoy.ip_tagging";
+  // Local rate limit filter
+  const std::string LOCAL_RATE_LIMIT = "envoy.local_rate_limit";
+  // On-demand cluster filter
+  const std::string ON_DEMAND = "envoy.on_demand";
   // Rate limit filter
   const std::string RATE_LIMIT = "envoy.rate_limit";
   // Router filter
@@ -122,8 +134,9 @@ public:
   const V1Converter v1_converter_;
 
   HttpFilterNameValues()
-      : v1_converter_({BUFFER, CORS, DYNAMO, FAULT, GRPC_HTTP1_BRIDGE, GRPC_JSON_TRANSCODER,
-                       GRPC_WEB, HEALTH_CHECK, IP_TAGGING, RATE_LIMIT, ROUTER, LUA}) {}
+      : v1_converter_({BUFFER, CACHE, COMPRESSION, CORS, DECOMPRESSION, DYNAMO, FAULT,
+                       GRPC_HTTP1_BRIDGE, GRPC_JSON_TRANSCODER, GRPC_WEB, HEALTH_CHECK, IP_TAGGING,
+                       LOCAL_RATE_LIMIT, ON_DEMAND, RATE_LIMIT, ROUTER, LUA}) {}
 };
 
 typedef ConstSingleton<HttpFilterNameValues> HttpFilterNames;
@@ -159,6 +172,10 @@ class AccessLogNameValues {
 public:
   // File access log
   const std::string FILE = "envoy.file_access_log";
+  // Binary file access log
+  const std::string BINARY_FILE = "envoy.binary_file_access_log";
+  // HTTP gRPC access log
+  const std::string HTTP_GRPC = "envoy.http_grpc_access_log";
 };
 
 typedef ConstSingleton<AccessLogNameValues> AccessLogNames;
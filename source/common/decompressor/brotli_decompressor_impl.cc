@@ -0,0 +1,56 @@
+#include "common/decompressor/brotli_decompressor_impl.h"
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Decompressor {
+
+BrotliDecompressorImpl::BrotliDecompressorImpl() : BrotliDecompressorImpl(4096) {}
+
+BrotliDecompressorImpl::BrotliDecompressorImpl(uint64_t chunk_size)
+    : chunk_size_{chunk_size}, chunk_char_ptr_(new uint8_t[chunk_size]), avail_out_{chunk_size},
+      next_out_{chunk_char_ptr_.get()},
+      state_ptr_(BrotliDecoderCreateInstance(nullptr, nullptr, nullptr),
+                 [](BrotliDecoderState* state) { BrotliDecoderDestroyInstance(state); }) {
+  RELEASE_ASSERT(state_ptr_ != nullptr);
+}
+
+void BrotliDecompressorImpl::decompress(const Buffer::Instance& input_buffer,
+                                        Buffer::Instance& output_buffer) {
+  const uint64_t num_slices = input_buffer.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  input_buffer.getRawSlices(slices, num_slices);
+
+  for (const Buffer::RawSlice& input_slice : slices) {
+    size_t avail_in = input_slice.len_;
+    const uint8_t* next_in = static_cast<const uint8_t*>(input_slice.mem_);
+    while (!failed_ && !finished_) {
+      const BrotliDecoderResult result = BrotliDecoderDecompressStream(
+          state_ptr_.get(), &avail_in, &next_in, &avail_out_, &next_out_, nullptr);
+      if (result == BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT) {
+        updateOutput(output_buffer);
+      } else if (result == BROTLI_DECODER_RESULT_SUCCESS) {
+        finished_ = true; // The last meta-block of the stream has been read.
+      } else if (result == BROTLI_DECODER_RESULT_ERROR) {
+        failed_ = true; // The input is corrupt.
+      } else {
+        ASSERT(result == BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT);
+        break;
+      }
+    }
+  }
+
+  updateOutput(output_buffer);
+}
+
+void BrotliDecompressorImpl::updateOutput(Buffer::Instance& output_buffer) {
+  const uint64_t n_output = chunk_size_ - avail_out_;
+  if (n_output > 0) {
+    output_buffer.add(static_cast<void*>(chunk_char_ptr_.get()), n_output);
+  }
+  avail_out_ = chunk_size_;
+  next_out_ = chunk_char_ptr_.get();
+}
+
+} // namespace Decompressor
+} // namespace Envoy
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "envoy/decompressor/decompressor.h"
+
+#include "brotli/decode.h"
+
+namespace Envoy {
+namespace Decompressor {
+
+/**
+ * Implementation of decompressor's interface with Brotli (RFC 7932).
+ */
+class BrotliDecompressorImpl : public Decompressor {
+public:
+  BrotliDecompressorImpl();
+
+  /**
+   * Constructor that allows setting the size of decompressor's output buffer. It should be called
+   * whenever a buffer size different than the 4096 bytes, normally set by the default constructor,
+   * is desired.
+   * @param chunk_size amount of memory reserved for the decompressor output.
+   */
+  BrotliDecompressorImpl(uint64_t chunk_size);
+
+  // Decompressor
+  void decompress(const Buffer::Instance& input_buffer, Buffer::Instance& output_buffer) override;
+  bool failed() const override { return failed_; }
+  bool finished() const override { return finished_; }
+
+private:
+  void updateOutput(Buffer::Instance& output_buffer);
+
+  const uint64_t chunk_size_;
+  bool failed_{};
+  bool finished_{};
+
+  std::unique_ptr<uint8_t[]> chunk_char_ptr_;
+  size_t avail_out_;
+  uint8_t* next_out_;
+  std::unique_ptr<BrotliDecoderState, std::function<void(BrotliDecoderState*)>> state_ptr_;
+};
+
+} // namespace Decompressor
+} // namespace Envoy
@@ -38,23 +38,20 @@ void ZlibDecompressorImpl::decompress(const Buffer::Instance& input_buffer,
   input_buffer.getRawSlices(slices, num_slices);
 
   for (const Buffer::RawSlice& input_slice : slices) {
+    if (failed_ || finished_) {
+      break;
+    }
+
     zstream_ptr_->avail_in = input_slice.len_;
     zstream_ptr_->next_in = static_cast<Bytef*>(input_slice.mem_);
     while (inflateNext()) {
       if (zstream_ptr_->avail_out == 0) {
-        output_buffer.add(static_cast<void*>(chunk_char_ptr_.get()),
-                          chunk_size_ - zstream_ptr_->avail_out);
-        chunk_char_ptr_.reset(new unsigned char[chunk_size_]);
-        zstream_ptr_->avail_out = chunk_size_;
-        zstream_ptr_->next_out = chunk_char_ptr_.get();
+        updateOutput(output_buffer);
       }
     }
   }
 
-  const uint64_t n_output{chunk_size_ - zstream_ptr_->avail_out};
-  if (n_output > 0) {
-    output_buffer.add(static_cast<void*>(chunk_char_ptr_.get()), n_output);
-  }
+  updateOutput(output_buffer);
 }
 
 bool ZlibDecompressorImpl::inflateNext() {
@@ -63,9 +60,28 @@ bool ZlibDecompressorImpl::inflateNext() {
     return false; // This means that zlib needs more input, so stop here.
   }
 
+  if (result == Z_STREAM_END) {
+    finished_ = true; // The end of the compressed stream, such as the gzip trailer, has been read.
+    return false;
+  }
+
+  if (result == Z_DATA_ERROR || result == Z_NEED_DICT) {
+    failed_ = true; // The input is corrupt, or needs a preset dictionary which isn't supported.
+    return false;
+  }
+
   RELEASE_ASSERT(result == Z_OK);
   return true;
 }
 
+void ZlibDecompressorImpl::updateOutput(Buffer::Instance& output_buffer) {
+  const uint64_t n_output = chunk_size_ - zstream_ptr_->avail_out;
+  if (n_output > 0) {
+    output_buffer.add(static_cast<void*>(chunk_char_ptr_.get()), n_output);
+  }
+  zstream_ptr_->avail_out = chunk_size_;
+  zstream_ptr_->next_out = chunk_char_ptr_.get();
+}
+
 } // namespace Decompressor
 } // namespace Envoy
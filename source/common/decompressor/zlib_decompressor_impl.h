@@ -1,5 +1,8 @@
 #pragma once
 
+#include <functional>
+#include <memory>
+
 #include "envoy/decompressor/decompressor.h"
 
 #include "zlib.h"
@@ -42,16 +45,24 @@ public:
 
   // Decompressor
   void decompress(const Buffer::Instance& input_buffer, Buffer::Instance& output_buffer) override;
+  bool failed() const override { return failed_; }
+  // The end of the stream is the gzip trailer or the zlib checksum.
+  bool finished() const override { return finished_; }
 
 private:
   bool inflateNext();
+  void updateOutput(Buffer::Instance& output_buffer);
 
   uint64_t chunk_size_;
   bool initialized_;
+  bool failed_{};
+  bool finished_{};
 
   std::unique_ptr<unsigned char[]> chunk_char_ptr_;
   std::unique_ptr<z_stream, std::function<void(z_stream*)>> zstream_ptr_;
 };
 
+typedef std::unique_ptr<ZlibDecompressorImpl> ZlibDecompressorImplPtr;
+
 } // namespace Decompressor
 } // namespace Envoy
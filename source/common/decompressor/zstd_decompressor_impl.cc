@@ -0,0 +1,49 @@
+#include "common/decompressor/zstd_decompressor_impl.h"
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Decompressor {
+
+ZstdDecompressorImpl::ZstdDecompressorImpl() : ZstdDecompressorImpl(4096) {}
+
+ZstdDecompressorImpl::ZstdDecompressorImpl(uint64_t chunk_size)
+    : chunk_char_ptr_(new uint8_t[chunk_size]), output_{chunk_char_ptr_.get(), chunk_size, 0},
+      dctx_ptr_(ZSTD_createDCtx(), [](ZSTD_DCtx* dctx) { ZSTD_freeDCtx(dctx); }) {
+  RELEASE_ASSERT(dctx_ptr_ != nullptr);
+}
+
+void ZstdDecompressorImpl::decompress(const Buffer::Instance& input_buffer,
+                                      Buffer::Instance& output_buffer) {
+  const uint64_t num_slices = input_buffer.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  input_buffer.getRawSlices(slices, num_slices);
+
+  for (const Buffer::RawSlice& input_slice : slices) {
+    ZSTD_inBuffer input{input_slice.mem_, input_slice.len_, 0};
+    while (!failed_ && !finished_) {
+      const size_t result = ZSTD_decompressStream(dctx_ptr_.get(), &output_, &input);
+      if (ZSTD_isError(result)) {
+        failed_ = true; // The input is corrupt.
+      } else if (result == 0) {
+        finished_ = true; // The frame has been read and all of its output flushed.
+      } else if (output_.pos == output_.size) {
+        updateOutput(output_buffer); // The decoder may have more output for this input.
+      } else if (input.pos == input.size) {
+        break; // This means that zstd needs more input, so stop here.
+      }
+    }
+  }
+
+  updateOutput(output_buffer);
+}
+
+void ZstdDecompressorImpl::updateOutput(Buffer::Instance& output_buffer) {
+  if (output_.pos > 0) {
+    output_buffer.add(static_cast<void*>(chunk_char_ptr_.get()), output_.pos);
+  }
+  output_.pos = 0;
+}
+
+} // namespace Decompressor
+} // namespace Envoy
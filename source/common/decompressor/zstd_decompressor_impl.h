@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "envoy/decompressor/decompressor.h"
+
+#include "zstd.h"
+
+namespace Envoy {
+namespace Decompressor {
+
+/**
+ * Implementation of decompressor's interface with Zstandard (RFC 8478). Only the first frame of the
+ * input is decompressed.
+ */
+class ZstdDecompressorImpl : public Decompressor {
+public:
+  ZstdDecompressorImpl();
+
+  /**
+   * Constructor that allows setting the size of decompressor's output buffer. It should be called
+   * whenever a buffer size different than the 4096 bytes, normally set by the default constructor,
+   * is desired.
+   * @param chunk_size amount of memory reserved for the decompressor output.
+   */
+  ZstdDecompressorImpl(uint64_t chunk_size);
+
+  // Decompressor
+  void decompress(const Buffer::Instance& input_buffer, Buffer::Instance& output_buffer) override;
+  bool failed() const override { return failed_; }
+  bool finished() const override { return finished_; }
+
+private:
+  void updateOutput(Buffer::Instance& output_buffer);
+
+  bool failed_{};
+  bool finished_{};
+
+  std::unique_ptr<uint8_t[]> chunk_char_ptr_;
+  ZSTD_outBuffer output_;
+  std::unique_ptr<ZSTD_DCtx, std::function<void(ZSTD_DCtx*)>> dctx_ptr_;
+};
+
+} // namespace Decompressor
+} // namespace Envoy
@@ -5,152 +5,131 @@
 #include <string>
 #include <vector>
 
-#include "common/buffer/buffer_impl.h"
 #include "common/common/assert.h"
 #include "common/dynamo/dynamo_request_parser.h"
 #include "common/dynamo/dynamo_utility.h"
 #include "common/http/codes.h"
 #include "common/http/exception.h"
 #include "common/http/utility.h"
-#include "common/json/json_loader.h"
 
 #include "fmt/format.h"
 
 namespace Envoy {
 namespace Dynamo {
 
-Http::FilterHeadersStatus DynamoFilter::decodeHeaders(Http::HeaderMap& headers, bool) {
+Http::FilterHeadersStatus DynamoFilter::decodeHeaders(Http::HeaderMap& headers, bool end_stream) {
   if (enabled_) {
     start_decode_ = std::chrono::steady_clock::now();
     operation_ = RequestParser::parseOperation(headers);
-    return Http::FilterHeadersStatus::StopIteration;
-  } else {
-    return Http::FilterHeadersStatus::Continue;
+    if (!end_stream) {
+      request_parser_.reset(new RequestBodyParser(operation_));
+    }
   }
+
+  return Http::FilterHeadersStatus::Continue;
 }
 
 Http::FilterDataStatus DynamoFilter::decodeData(Buffer::Instance& data, bool end_stream) {
-  if (enabled_ && end_stream) {
-    onDecodeComplete(data);
+  if (request_parser_) {
+    if (data.length() > 0) {
+      // Once the body is found to be invalid the rest of it is skipped.
+      request_body_ = true;
+      request_parser_->parse(data);
+    }
+    if (end_stream) {
+      onDecodeComplete();
+    }
   }
 
-  if (!enabled_ || end_stream) {
-    return Http::FilterDataStatus::Continue;
-  } else {
-    // Buffer until the complete request has been processed.
-    return Http::FilterDataStatus::StopIterationAndBuffer;
-  }
+  return Http::FilterDataStatus::Continue;
 }
 
 Http::FilterTrailersStatus DynamoFilter::decodeTrailers(Http::HeaderMap&) {
-  if (enabled_) {
-    Buffer::OwnedImpl empty;
-    onDecodeComplete(empty);
+  if (request_parser_) {
+    onDecodeComplete();
   }
 
   return Http::FilterTrailersStatus::Continue;
 }
 
-void DynamoFilter::onDecodeComplete(const Buffer::Instance& data) {
-  std::string body = buildBody(decoder_callbacks_->decodingBuffer(), data);
-  if (!body.empty()) {
-    try {
-      Json::ObjectSharedPtr json_body = Json::Factory::loadFromString(body);
-      table_descriptor_ = RequestParser::parseTable(operation_, *json_body);
-    } catch (const Json::Exception& jsonEx) {
+void DynamoFilter::onDecodeComplete() {
+  if (request_body_) {
+    if (request_parser_->finish()) {
+      table_descriptor_ = request_parser_->table();
+    } else {
       // Body parsing failed. This should not happen, just put a stat for that.
       scope_.counter(fmt::format("{}invalid_req_body", stat_prefix_)).inc();
     }
   }
+
+  request_parser_.reset();
 }
 
-void DynamoFilter::onEncodeComplete(const Buffer::Instance& data) {
+void DynamoFilter::onEncodeComplete() {
   ASSERT(enabled_);
   uint64_t status = Http::Utility::getResponseStatus(*response_headers_);
   chargeBasicStats(status);
 
-  std::string body = buildBody(encoder_callbacks_->encodingBuffer(), data);
-  if (!body.empty()) {
-    try {
-      Json::ObjectSharedPtr json_body = Json::Factory::loadFromString(body);
-      chargeTablePartitionIdStats(*json_body);
+  if (response_body_) {
+    if (response_parser_->finish()) {
+      chargeTablePartitionIdStats(*response_parser_);
 
       if (Http::CodeUtility::is4xx(status)) {
-        chargeFailureSpecificStats(*json_body);
+        chargeFailureSpecificStats(*response_parser_);
       }
       // Batch Operations will always return status 200 for a partial or full success. Check
       // unprocessed keys to determine partial success.
       // http://docs.aws.amazon.com/amazondynamodb/latest/developerguide/Programming.Errors.html#Programming.Errors.BatchOperations
       if (RequestParser::isBatchOperation(operation_)) {
-        chargeUnProcessedKeysStats(*json_body);
+        chargeUnProcessedKeysStats(*response_parser_);
       }
-    } catch (const Json::Exception&) {
+    } else {
       // Body parsing failed. This should not happen, just put a stat for that.
       scope_.counter(fmt::format("{}invalid_resp_body", stat_prefix_)).inc();
     }
   }
+
+  response_parser_.reset();
 }
 
 Http::FilterHeadersStatus DynamoFilter::encodeHeaders(Http::HeaderMap& headers, bool end_stream) {
-  Http::FilterHeadersStatus status = Http::FilterHeadersStatus::Continue;
   if (enabled_) {
     response_headers_ = &headers;
 
     if (end_stream) {
-      Buffer::OwnedImpl empty;
-      onEncodeComplete(empty);
+      onEncodeComplete();
     } else {
-      status = Http::FilterHeadersStatus::StopIteration;
+      response_parser_.reset(new ResponseBodyParser());
+      response_body_ = false;
     }
   }
 
-  return status;
+  return Http::FilterHeadersStatus::Continue;
 }
 
 Http::FilterDataStatus DynamoFilter::encodeData(Buffer::Instance& data, bool end_stream) {
-  if (enabled_ && end_stream) {
-    onEncodeComplete(data);
+  if (response_parser_) {
+    if (data.length() > 0) {
+      // Once the body is found to be invalid the rest of it is skipped.
+      response_body_ = true;
+      response_parser_->parse(data);
+    }
+    if (end_stream) {
+      onEncodeComplete();
+    }
   }
 
-  if (!enabled_ || end_stream) {
-    return Http::FilterDataStatus::Continue;
-  } else {
-    // Buffer until the complete response has been processed.
-    return Http::FilterDataStatus::StopIterationAndBuffer;
-  }
+  return Http::FilterDataStatus::Continue;
 }
 
 Http::FilterTrailersStatus DynamoFilter::encodeTrailers(Http::HeaderMap&) {
-  if (enabled_) {
-    Buffer::OwnedImpl empty;
-    onEncodeComplete(empty);
+  if (response_parser_) {
+    onEncodeComplete();
   }
 
   return Http::FilterTrailersStatus::Continue;
 }
 
-std::string DynamoFilter::buildBody(const Buffer::Instance* buffered,
-                                    const Buffer::Instance& last) {
-  std::string body;
-  if (buffered) {
-    uint64_t num_slices = buffered->getRawSlices(nullptr, 0);
-    Buffer::RawSlice slices[num_slices];
-    buffered->getRawSlices(slices, num_slices);
-    for (Buffer::RawSlice& slice : slices) {
-      body.append(static_cast<const char*>(slice.mem_), slice.len_);
-    }
-  }
-
-  uint64_t num_slices = last.getRawSlices(nullptr, 0);
-  Buffer::RawSlice slices[num_slices];
-  last.getRawSlices(slices, num_slices);
-  for (Buffer::RawSlice& slice : slices) {
-    body.append(static_cast<const char*>(slice.mem_), slice.len_);
-  }
-
-  return body;
-}
-
 void DynamoFilter::chargeBasicStats(uint64_t status) {
   if (!operation_.empty()) {
     chargeStatsPerEntity(operation_, "operation", status);
@@ -197,11 +176,10 @@ void DynamoFilter::chargeStatsPerEntity(const std::string& entity, const std::st
       .recordValue(latency.count());
 }
 
-void DynamoFilter::chargeUnProcessedKeysStats(const Json::Object& json_body) {
+void DynamoFilter::chargeUnProcessedKeysStats(const ResponseBodyParser& parser) {
   // The unprocessed keys block contains a list of tables and keys for that table that did not
   // complete apart of the batch operation. Only the table names will be logged for errors.
-  std::vector<std::string> unprocessed_tables = RequestParser::parseBatchUnProcessedKeys(json_body);
-  for (const std::string& unprocessed_table : unprocessed_tables) {
+  for (const std::string& unprocessed_table : parser.unprocessedTables()) {
     scope_
         .counter(
             fmt::format("{}error.{}.BatchFailureUnprocessedKeys", stat_prefix_, unprocessed_table))
@@ -209,8 +187,8 @@ void DynamoFilter::chargeUnProcessedKeysStats(const Json::Object& json_body) {
   }
 }
 
-void DynamoFilter::chargeFailureSpecificStats(const Json::Object& json_body) {
-  std::string error_type = RequestParser::parseErrorType(json_body);
+void DynamoFilter::chargeFailureSpecificStats(const ResponseBodyParser& parser) {
+  std::string error_type = parser.errorType();
 
   if (!error_type.empty()) {
     if (table_descriptor_.table_name.empty()) {
@@ -226,14 +204,12 @@ void DynamoFilter::chargeFailureSpecificStats(const Json::Object& json_body) {
   }
 }
 
-void DynamoFilter::chargeTablePartitionIdStats(const Json::Object& json_body) {
+void DynamoFilter::chargeTablePartitionIdStats(const ResponseBodyParser& parser) {
   if (table_descriptor_.table_name.empty() || operation_.empty()) {
     return;
   }
 
-  std::vector<RequestParser::PartitionDescriptor> partitions =
-      RequestParser::parsePartitions(json_body);
-  for (const RequestParser::PartitionDescriptor& partition : partitions) {
+  for (const RequestParser::PartitionDescriptor& partition : parser.partitions()) {
     std::string scope_string = Utility::buildPartitionStatString(
         stat_prefix_, table_descriptor_.table_name, operation_, partition.partition_id_);
     scope_.counter(scope_string).add(partition.capacity_);
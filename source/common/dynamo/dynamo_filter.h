@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <string>
 
 #include "envoy/http/filter.h"
@@ -8,13 +9,13 @@
 #include "envoy/stats/stats.h"
 
 #include "common/dynamo/dynamo_request_parser.h"
-#include "common/json/json_loader.h"
 
 namespace Envoy {
 namespace Dynamo {
 
 /**
  * DynamoDb filter to process egress request to dynamo and capture comprehensive stats
+ * The request and response bodies are parsed incrementally as they are proxied, without buffering.
  * It captures RPS/latencies:
  *  1) Per table per response code (and group of response codes, e.g., 2xx/3xx/etc)
  *  2) Per operation per response code (and group of response codes, e.g., 2xx/3xx/etc)
@@ -46,15 +47,14 @@ public:
   }
 
 private:
-  void onDecodeComplete(const Buffer::Instance& data);
-  void onEncodeComplete(const Buffer::Instance& data);
-  std::string buildBody(const Buffer::Instance* buffered, const Buffer::Instance& last);
+  void onDecodeComplete();
+  void onEncodeComplete();
   void chargeBasicStats(uint64_t status);
   void chargeStatsPerEntity(const std::string& entity, const std::string& entity_type,
                             uint64_t status);
-  void chargeFailureSpecificStats(const Json::Object& json_body);
-  void chargeUnProcessedKeysStats(const Json::Object& json_body);
-  void chargeTablePartitionIdStats(const Json::Object& json_body);
+  void chargeFailureSpecificStats(const ResponseBodyParser& parser);
+  void chargeUnProcessedKeysStats(const ResponseBodyParser& parser);
+  void chargeTablePartitionIdStats(const ResponseBodyParser& parser);
 
   Runtime::Loader& runtime_;
   std::string stat_prefix_;
@@ -66,6 +66,11 @@ private:
   std::string error_type_{};
   MonotonicTime start_decode_;
   Http::HeaderMap* response_headers_;
+  // The bodies are parsed as they go through, and are not buffered.
+  std::unique_ptr<RequestBodyParser> request_parser_;
+  bool request_body_{};
+  std::unique_ptr<ResponseBodyParser> response_parser_;
+  bool response_body_{};
   Http::StreamDecoderFilterCallbacks* decoder_callbacks_{};
   Http::StreamEncoderFilterCallbacks* encoder_callbacks_{};
 };
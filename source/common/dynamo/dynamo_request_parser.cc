@@ -2,6 +2,7 @@
 
 #include <cmath>
 #include <cstdint>
+#include <initializer_list>
 #include <string>
 #include <vector>
 
@@ -65,51 +66,13 @@ std::string RequestParser::parseOperation(const Http::HeaderMap& headerMap) {
   return operation;
 }
 
-RequestParser::TableDescriptor RequestParser::parseTable(const std::string& operation,
-                                                         const Json::Object& json_data) {
-  TableDescriptor table{"", true};
-
-  // Simple operations on a single table, have "TableName" explicitly specified.
-  if (find(SINGLE_TABLE_OPERATIONS.begin(), SINGLE_TABLE_OPERATIONS.end(), operation) !=
-      SINGLE_TABLE_OPERATIONS.end()) {
-    table.table_name = json_data.getString("TableName", "");
-  } else if (find(BATCH_OPERATIONS.begin(), BATCH_OPERATIONS.end(), operation) !=
-             BATCH_OPERATIONS.end()) {
-    Json::ObjectSharedPtr tables = json_data.getObject("RequestItems", true);
-    tables->iterate([&table](const std::string& key, const Json::Object&) {
-      if (table.table_name.empty()) {
-        table.table_name = key;
-      } else {
-        if (table.table_name != key) {
-          table.table_name = "";
-          table.is_single_table = false;
-          return false;
-        }
-      }
-      return true;
-    });
-  }
-
-  return table;
-}
-std::vector<std::string> RequestParser::parseBatchUnProcessedKeys(const Json::Object& json_data) {
-  std::vector<std::string> unprocessed_tables;
-  Json::ObjectSharedPtr tables = json_data.getObject("UnprocessedKeys", true);
-  tables->iterate([&unprocessed_tables](const std::string& key, const Json::Object&) {
-    unprocessed_tables.emplace_back(key);
-    return true;
-  });
-
-  return unprocessed_tables;
-}
-std::string RequestParser::parseErrorType(const Json::Object& json_data) {
-  std::string error_type = json_data.getString("__type", "");
-  if (error_type.empty()) {
+std::string RequestParser::parseErrorType(const std::string& type) {
+  if (type.empty()) {
     return "";
   }
 
   for (const std::string& supported_error_type : SUPPORTED_ERROR_TYPES) {
-    if (StringUtil::endsWith(error_type, supported_error_type)) {
+    if (StringUtil::endsWith(type, supported_error_type)) {
       return supported_error_type;
     }
   }
@@ -117,29 +80,96 @@ std::string RequestParser::parseErrorType(const Json::Object& json_data) {
   return "";
 }
 
+bool RequestParser::isSingleTableOperation(const std::string& operation) {
+  return find(SINGLE_TABLE_OPERATIONS.begin(), SINGLE_TABLE_OPERATIONS.end(), operation) !=
+         SINGLE_TABLE_OPERATIONS.end();
+}
+
 bool RequestParser::isBatchOperation(const std::string& operation) {
   return find(BATCH_OPERATIONS.begin(), BATCH_OPERATIONS.end(), operation) !=
          BATCH_OPERATIONS.end();
 }
 
-std::vector<RequestParser::PartitionDescriptor>
-RequestParser::parsePartitions(const Json::Object& json_data) {
-  std::vector<RequestParser::PartitionDescriptor> partition_descriptors;
-
-  Json::ObjectSharedPtr partitions =
-      json_data.getObject("ConsumedCapacity", true)->getObject("Partitions", true);
-  partitions->iterate([&partition_descriptors, &partitions](const std::string& key,
-                                                            const Json::Object&) {
-    // For a given partition id, the amount of capacity used is returned in the body as a double.
-    // A stat will be created to track the capacity consumed for the operation, table and partition.
-    // Stats counter only increments by whole numbers, capacity is round up to the nearest integer
-    // to account for this.
-    uint64_t capacity_integer = static_cast<uint64_t>(std::ceil(partitions->getDouble(key, 0.0)));
-    partition_descriptors.emplace_back(key, capacity_integer);
-    return true;
-  });
-
-  return partition_descriptors;
+bool BodyParser::parse(const Buffer::Instance& data) {
+  uint64_t num_slices = data.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  data.getRawSlices(slices, num_slices);
+  for (const Buffer::RawSlice& slice : slices) {
+    if (!parser_.parse(static_cast<const char*>(slice.mem_), slice.len_)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool BodyParser::inObjectAt(std::initializer_list<const char*> keys) const {
+  if (path_.size() != keys.size() + 1) {
+    return false;
+  }
+
+  auto level = path_.begin();
+  for (const char* key : keys) {
+    if (!level->object_ || level->key_ != key) {
+      return false;
+    }
+    level++;
+  }
+
+  return level->object_;
+}
+
+void RequestBodyParser::onKey(const std::string& key) {
+  BodyParser::onKey(key);
+
+  // Batch operations list the tables they use as the keys of "RequestItems".
+  if (batch_operation_ && table_.is_single_table && inObjectAt({"RequestItems"})) {
+    if (table_.table_name.empty()) {
+      table_.table_name = key;
+    } else if (table_.table_name != key) {
+      table_.table_name = "";
+      table_.is_single_table = false;
+    }
+  }
+}
+
+bool RequestBodyParser::captureString() {
+  // Simple operations on a single table, have "TableName" explicitly specified.
+  return single_table_operation_ && inObjectAt({}) && key() == "TableName";
+}
+
+void RequestBodyParser::onString(const std::string& value) {
+  if (single_table_operation_ && inObjectAt({}) && key() == "TableName") {
+    table_.table_name = value;
+  }
+}
+
+void ResponseBodyParser::onKey(const std::string& key) {
+  BodyParser::onKey(key);
+
+  // The unprocessed keys block contains a list of tables and keys for that table that did not
+  // complete apart of the batch operation. Only the table names are kept.
+  if (inObjectAt({"UnprocessedKeys"})) {
+    unprocessed_tables_.emplace_back(key);
+  }
+}
+
+bool ResponseBodyParser::captureString() { return inObjectAt({}) && key() == "__type"; }
+
+void ResponseBodyParser::onString(const std::string& value) {
+  if (inObjectAt({}) && key() == "__type") {
+    type_ = value;
+  }
+}
+
+void ResponseBodyParser::onNumber(double value) {
+  // For a given partition id, the amount of capacity used is returned in the body as a double.
+  // A stat will be created to track the capacity consumed for the operation, table and partition.
+  // Stats counter only increments by whole numbers, capacity is round up to the nearest integer
+  // to account for this.
+  if (inObjectAt({"ConsumedCapacity", "Partitions"})) {
+    partitions_.emplace_back(key(), static_cast<uint64_t>(std::ceil(value)));
+  }
 }
 
 } // namespace Dynamo
@@ -1,12 +1,14 @@
 #pragma once
 
 #include <cstdint>
+#include <initializer_list>
 #include <string>
 #include <vector>
 
+#include "envoy/buffer/buffer.h"
 #include "envoy/http/header_map.h"
 
-#include "common/json/json_loader.h"
+#include "common/json/streaming_parser.h"
 
 namespace Envoy {
 namespace Dynamo {
@@ -39,56 +41,25 @@ public:
   static std::string parseOperation(const Http::HeaderMap& headerMap);
 
   /**
-   * Parse table name out of data, based on the operation.
-   * @return empty string as TableDescriptor.table_name if table name cannot be parsed out of valid
-   *json data
-   * or if operation is not in the list of operations that we support.
-   *
-   * For simple operations on single table, e.g., GetItem, PutItem, Query etc @return table
-   * name in TableDescriptor.table_name.
-   *
-   * For batch operations, e.g. BatchGetItem/BatchWriteItem, @return table name in
-   *TableDescriptor.table_name if it's only one
-   * table used in all operations, @return empty string in TableDescriptor.table_name and
-   *TableDescriptor.is_single_table=false in case of multiple.
-   *
-   * @throw Json::Exception if data is not in valid Json format.
-   */
-  static TableDescriptor parseTable(const std::string& operation, const Json::Object& json_data);
-
-  /**
-   * Parse error details which might be provided for a given response code.
-   * @return empty string if cannot get error details.
+   * Match the error type which might be provided in the "__type" field of a response.
+   * @return empty string if the error type is not one of the supported ones.
    * For the full list of errors, see
    * http://docs.aws.amazon.com/amazondynamodb/latest/APIReference/CommonErrors.html
    * Operation specific errors, for example, error section of
    * http://docs.aws.amazon.com/amazondynamodb/latest/APIReference/API_UpdateItem.html
-   *
-   * @throw Json::Exception if data is not in valid Json format.
    */
-  static std::string parseErrorType(const Json::Object& json_data);
+  static std::string parseErrorType(const std::string& type);
 
   /**
-   * Parse unprocessed keys for batch operation results.
-   * @return empty set if there are no unprocessed keys or a set of table names that did not get
-   * processed in the batch operation.
+   * @return true if the operation is in the set of supported SINGLE_TABLE_OPERATIONS
    */
-  static std::vector<std::string> parseBatchUnProcessedKeys(const Json::Object& json_data);
+  static bool isSingleTableOperation(const std::string& operation);
 
   /**
    * @return true if the operation is in the set of supported BATCH_OPERATIONS
    */
   static bool isBatchOperation(const std::string& operation);
 
-  /**
-   * Parse the Partition ids and the consumed capacity from the body.
-   * @return empty set if there is no partition data or a set of partition data containing
-   * the partition id as a string and the capacity consumed as an integer.
-   *
-   * @throw Json::Exception if data is not in valid Json format.
-   */
-  static std::vector<PartitionDescriptor> parsePartitions(const Json::Object& json_data);
-
 private:
   static const Http::LowerCaseString X_AMZ_TARGET;
   static const std::vector<std::string> SINGLE_TABLE_OPERATIONS;
@@ -100,5 +71,127 @@ private:
   RequestParser() {}
 };
 
+/**
+ * Base of the incremental parsers of request and response bodies. The bodies are parsed as they
+ * arrive and only the keys leading to the current value, and the values which are needed, are kept.
+ */
+class BodyParser : protected Json::StreamingParser::Callbacks {
+public:
+  virtual ~BodyParser() {}
+
+  /**
+   * Parse the next chunk of the body.
+   * @return false if the body is not valid json.
+   */
+  bool parse(const Buffer::Instance& data);
+
+  /**
+   * Signal the end of the body.
+   * @return false if the body is not valid json.
+   */
+  bool finish() { return parser_.finish(); }
+
+protected:
+  BodyParser() : parser_(*this) {}
+
+  /**
+   * @return true if the current value is a member of the object which is the value of the given
+   *         chain of keys, starting from the root object.
+   */
+  bool inObjectAt(std::initializer_list<const char*> keys) const;
+
+  /**
+   * @return the key of the current value in its object.
+   */
+  const std::string& key() const { return path_.back().key_; }
+
+  // Json::StreamingParser::Callbacks
+  void onStartObject() override { path_.push_back({true, ""}); }
+  void onEndObject() override { path_.pop_back(); }
+  void onStartArray() override { path_.push_back({false, ""}); }
+  void onEndArray() override { path_.pop_back(); }
+  void onKey(const std::string& key) override { path_.back().key_ = key; }
+  bool captureString() override { return false; }
+  void onString(const std::string&) override {}
+  void onNumber(double) override {}
+  void onBool(bool) override {}
+  void onNull() override {}
+
+private:
+  struct Level {
+    bool object_;
+    std::string key_;
+  };
+
+  // The enclosing containers of the current value, and the key of each of them which leads to it.
+  std::vector<Level> path_;
+  Json::StreamingParser parser_;
+};
+
+/**
+ * Incremental parser of a request body, which extracts the table name(s).
+ *
+ * For simple operations on single table, e.g., GetItem, PutItem, Query etc the table name is
+ * the "TableName" field.
+ *
+ * For batch operations, e.g. BatchGetItem/BatchWriteItem, the table name is the key of the
+ * "RequestItems" object if it's the only one table used in all operations. In case of multiple, the
+ * table name is empty and is_single_table is false.
+ *
+ * The table name is empty for operations which are not in the lists of supported operations.
+ */
+class RequestBodyParser : public BodyParser {
+public:
+  RequestBodyParser(const std::string& operation)
+      : single_table_operation_(RequestParser::isSingleTableOperation(operation)),
+        batch_operation_(RequestParser::isBatchOperation(operation)) {}
+
+  const RequestParser::TableDescriptor& table() const { return table_; }
+
+private:
+  // BodyParser
+  void onKey(const std::string& key) override;
+  bool captureString() override;
+  void onString(const std::string& value) override;
+
+  const bool single_table_operation_;
+  const bool batch_operation_;
+  RequestParser::TableDescriptor table_{"", true};
+};
+
+/**
+ * Incremental parser of a response body, which extracts the error type, the unprocessed tables of
+ * batch operations and the capacity consumed in each partition.
+ */
+class ResponseBodyParser : public BodyParser {
+public:
+  /**
+   * @return the error type if it's one of the supported ones, or an empty string.
+   */
+  std::string errorType() const { return RequestParser::parseErrorType(type_); }
+
+  /**
+   * @return the table names in "UnprocessedKeys", which did not get processed in the batch
+   *         operation.
+   */
+  const std::vector<std::string>& unprocessedTables() const { return unprocessed_tables_; }
+
+  /**
+   * @return the partition ids in "ConsumedCapacity.Partitions", with the capacity consumed in each.
+   */
+  const std::vector<RequestParser::PartitionDescriptor>& partitions() const { return partitions_; }
+
+private:
+  // BodyParser
+  void onKey(const std::string& key) override;
+  bool captureString() override;
+  void onString(const std::string& value) override;
+  void onNumber(double value) override;
+
+  std::string type_;
+  std::vector<std::string> unprocessed_tables_;
+  std::vector<RequestParser::PartitionDescriptor> partitions_;
+};
+
 } // namespace Dynamo
 } // namespace Envoy
@@ -1,5 +1,6 @@
 #include "common/event/dispatcher_impl.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <functional>
@@ -11,6 +12,7 @@
 #include "envoy/network/listener.h"
 
 #include "common/buffer/buffer_impl.h"
+#include "common/common/utility.h"
 #include "common/event/file_event_impl.h"
 #include "common/event/signal_impl.h"
 #include "common/event/timer_impl.h"
@@ -18,6 +20,7 @@
 #include "common/network/connection_impl.h"
 #include "common/network/dns_impl.h"
 #include "common/network/listener_impl.h"
+#include "common/network/udp_listener_impl.h"
 #include "common/ssl/connection_impl.h"
 
 #include "event2/event.h"
@@ -29,43 +32,96 @@ DispatcherImpl::DispatcherImpl()
     : DispatcherImpl(Buffer::WatermarkFactoryPtr{new Buffer::WatermarkBufferFactory}) {}
 
 DispatcherImpl::DispatcherImpl(Buffer::WatermarkFactoryPtr&& factory)
-    : buffer_factory_(std::move(factory)), base_(event_base_new()),
-      deferred_delete_timer_(createTimer([this]() -> void { clearDeferredDeleteList(); })),
+    : buffer_factory_(std::move(factory)), base_(createBase()),
+      deferred_delete_timer_(createTimer([this]() -> void { onDeferredDeleteTimer(); })),
       post_timer_(createTimer([this]() -> void { runPostCallbacks(); })),
-      current_to_delete_(&to_delete_1_) {}
+      coarse_timers_([this](TimerCb cb) -> TimerPtr { return createTimer(cb); },
+                     ProdMonotonicTimeSource::instance_),
+      max_deletes_per_iteration_(max_deferred_deletes_per_iteration_) {}
 
 DispatcherImpl::~DispatcherImpl() {}
 
+bool DispatcherImpl::use_epoll_changelist_ = false;
+uint32_t DispatcherImpl::max_deferred_deletes_per_iteration_ = 0;
+
+void DispatcherImpl::useEpollChangelist(bool use_epoll_changelist) {
+  use_epoll_changelist_ = use_epoll_changelist;
+}
+
+void DispatcherImpl::maxDeferredDeletesPerIteration(uint32_t max_deletes) {
+  max_deferred_deletes_per_iteration_ = max_deletes;
+}
+
+Libevent::BasePtr DispatcherImpl::createBase() {
+  if (!use_epoll_changelist_) {
+    return Libevent::BasePtr{event_base_new()};
+  }
+
+  CSmartPtr<event_config, event_config_free> config(event_config_new());
+  event_config_set_flag(config.get(), EVENT_BASE_FLAG_EPOLL_USE_CHANGELIST);
+  return Libevent::BasePtr{event_base_new_with_config(config.get())};
+}
+
 void DispatcherImpl::clearDeferredDeleteList() {
   ASSERT(isThreadSafe());
-  std::vector<DeferredDeletablePtr>* to_delete = current_to_delete_;
+  if (deferred_deleting_) {
+    return;
+  }
+
+  // Finish any deletions carried over from a limited iteration before the queued ones, so that
+  // everything queued before this call is destroyed.
+  if (!deleting_.empty()) {
+    deleteDeferred(deleting_.size());
+  }
+  deleteDeferred(to_delete_.size());
+}
+
+void DispatcherImpl::onDeferredDeleteTimer() {
+  if (stats_ != nullptr) {
+    stats_->deferred_delete_queue_depth_.recordValue(deleting_.size() - deleting_position_ +
+                                                     to_delete_.size());
+  }
 
-  size_t num_to_delete = to_delete->size();
-  if (deferred_deleting_ || !num_to_delete) {
+  if (max_deletes_per_iteration_ == 0) {
+    clearDeferredDeleteList();
     return;
   }
 
-  ENVOY_LOG(trace, "clearing deferred deletion list (size={})", num_to_delete);
+  deleteDeferred(max_deletes_per_iteration_);
+  if (!deleting_.empty() || !to_delete_.empty()) {
+    deferred_delete_timer_->enableTimer(std::chrono::milliseconds(0));
+  }
+}
 
-  // Swap the current deletion vector so that if we do deferred delete while we are deleting, we
-  // use the other vector. We will get another callback to delete that vector.
-  if (current_to_delete_ == &to_delete_1_) {
-    current_to_delete_ = &to_delete_2_;
-  } else {
-    current_to_delete_ = &to_delete_1_;
+void DispatcherImpl::deleteDeferred(size_t max_to_delete) {
+  if (deferred_deleting_) {
+    return;
   }
 
-  deferred_deleting_ = true;
+  // Objects deferred while we are deleting are queued in to_delete_, and get deleted by a later
+  // call.
+  if (deleting_.empty()) {
+    if (to_delete_.empty()) {
+      return;
+    }
+    deleting_.swap(to_delete_);
+  }
+
+  const size_t end = std::min(deleting_.size(), deleting_position_ + max_to_delete);
+  ENVOY_LOG(trace, "clearing deferred deletion list (size={})", end - deleting_position_);
 
   // Calling clear() on the vector does not specify which order destructors run in. We want to
-  // destroy in FIFO order so just do it manually. This required 2 passes over the vector which is
-  // not optimal but can be cleaned up later if needed.
-  for (size_t i = 0; i < num_to_delete; i++) {
-    (*to_delete)[i].reset();
+  // destroy in FIFO order so just do it manually.
+  deferred_deleting_ = true;
+  while (deleting_position_ < end) {
+    deleting_[deleting_position_++].reset();
   }
-
-  to_delete->clear();
   deferred_deleting_ = false;
+
+  if (deleting_position_ == deleting_.size()) {
+    deleting_.clear();
+    deleting_position_ = 0;
+  }
 }
 
 Network::ClientConnectionPtr
@@ -122,16 +178,28 @@ DispatcherImpl::createSslListener(Network::ConnectionHandler& conn_handler,
                                                            scope, listener_options)};
 }
 
+Network::UdpListenerPtr DispatcherImpl::createUdpListener(Network::ListenSocket& socket,
+                                                          Network::UdpListenerCallbacks& cb,
+                                                          Stats::Scope& scope) {
+  ASSERT(isThreadSafe());
+  return Network::UdpListenerPtr{new Network::UdpListenerImpl(*this, socket, cb, scope)};
+}
+
 TimerPtr DispatcherImpl::createTimer(TimerCb cb) {
   ASSERT(isThreadSafe());
   return TimerPtr{new TimerImpl(*this, cb)};
 }
 
+TimerPtr DispatcherImpl::createCoarseTimer(TimerCb cb) {
+  ASSERT(isThreadSafe());
+  return coarse_timers_.createTimer(cb);
+}
+
 void DispatcherImpl::deferredDelete(DeferredDeletablePtr&& to_delete) {
   ASSERT(isThreadSafe());
-  current_to_delete_->emplace_back(std::move(to_delete));
-  ENVOY_LOG(trace, "item added to deferred deletion list (size={})", current_to_delete_->size());
-  if (1 == current_to_delete_->size()) {
+  to_delete_.emplace_back(std::move(to_delete));
+  ENVOY_LOG(trace, "item added to deferred deletion list (size={})", to_delete_.size());
+  if (1 == to_delete_.size()) {
     deferred_delete_timer_->enableTimer(std::chrono::milliseconds(0));
   }
 }
@@ -148,7 +216,7 @@ void DispatcherImpl::post(std::function<void()> callback) {
   {
     std::unique_lock<std::mutex> lock(post_lock_);
     do_post = post_callbacks_.empty();
-    post_callbacks_.push_back(callback);
+    post_callbacks_.push_back(std::move(callback));
   }
 
   if (do_post) {
@@ -165,18 +233,97 @@ void DispatcherImpl::run(RunType type) {
   // event_base_once() before some other event, the other event might get called first.
   runPostCallbacks();
 
-  event_base_loop(base_.get(), type == RunType::NonBlock ? EVLOOP_NONBLOCK : 0);
+  if (stats_ != nullptr && type != RunType::NonBlock) {
+    runIterations(type);
+    return;
+  }
+
+  switch (type) {
+  case RunType::Block:
+    event_base_loop(base_.get(), 0);
+    break;
+  case RunType::NonBlock:
+    event_base_loop(base_.get(), EVLOOP_NONBLOCK);
+    break;
+  case RunType::RunUntilExit:
+    event_base_loop(base_.get(), EVLOOP_NO_EXIT_ON_EMPTY);
+    break;
+  }
+}
+
+void DispatcherImpl::initializeStats(Stats::Scope& scope, const std::string& prefix) {
+  ASSERT(run_tid_ == 0);
+  stats_.reset(new DispatcherStats{ALL_DISPATCHER_STATS(POOL_HISTOGRAM_PREFIX(scope, prefix))});
+}
+
+void DispatcherImpl::runIterations(RunType type) {
+  // libevent has no hooks around the iterations of its loop, so the loop is run one iteration at a
+  // time. EVLOOP_ONCE waits for events once and returns after running all of the active events.
+  // The poll delay ends and the iteration starts when the first event runs.
+  const int flags = EVLOOP_ONCE | (type == RunType::RunUntilExit ? EVLOOP_NO_EXIT_ON_EMPTY : 0);
+  while (true) {
+    events_in_iteration_ = 0;
+    const MonotonicTime start = ProdMonotonicTimeSource::instance_.currentTime();
+    const int rc = event_base_loop(base_.get(), flags);
+    if (events_in_iteration_ > 0) {
+      const MonotonicTime end = ProdMonotonicTimeSource::instance_.currentTime();
+      stats_->poll_delay_us_.recordValue(
+          std::chrono::duration_cast<std::chrono::microseconds>(first_event_time_ - start)
+              .count());
+      stats_->loop_duration_us_.recordValue(
+          std::chrono::duration_cast<std::chrono::microseconds>(end - first_event_time_).count());
+      stats_->events_per_iteration_.recordValue(events_in_iteration_);
+    }
+
+    // A non zero return means there are no events left to wait for, or an error.
+    if (rc != 0 || event_base_got_exit(base_.get()) || event_base_got_break(base_.get())) {
+      return;
+    }
+  }
+}
+
+MonotonicTime DispatcherImpl::approximateMonotonicTime() {
+  ASSERT(isThreadSafe());
+  if (!in_event_) {
+    return ProdMonotonicTimeSource::instance_.currentTime();
+  }
+  if (!monotonic_time_valid_) {
+    monotonic_time_ = ProdMonotonicTimeSource::instance_.currentTime();
+    monotonic_time_valid_ = true;
+  }
+  return monotonic_time_;
+}
+
+SystemTime DispatcherImpl::approximateSystemTime() {
+  ASSERT(isThreadSafe());
+  if (!in_event_) {
+    return ProdSystemTimeSource::instance_.currentTime();
+  }
+  if (!system_time_valid_) {
+    system_time_ = ProdSystemTimeSource::instance_.currentTime();
+    system_time_valid_ = true;
+  }
+  return system_time_;
 }
 
 void DispatcherImpl::runPostCallbacks() {
-  std::unique_lock<std::mutex> lock(post_lock_);
-  while (!post_callbacks_.empty()) {
-    std::function<void()> callback = post_callbacks_.front();
-    post_callbacks_.pop_front();
-
-    lock.unlock();
-    callback();
-    lock.lock();
+  // The pending callbacks are taken in batches, so that the lock is only held to swap the list and
+  // threads which post while the callbacks run don't contend with them. Callbacks posted by the
+  // callbacks run in the next batch.
+  std::list<std::function<void()>> callbacks;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(post_lock_);
+      callbacks.swap(post_callbacks_);
+    }
+    if (callbacks.empty()) {
+      return;
+    }
+
+    for (const std::function<void()>& callback : callbacks) {
+      callback();
+    }
+    callbacks.clear();
   }
 }
 
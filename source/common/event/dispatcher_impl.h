@@ -3,20 +3,43 @@
 #include <cstdint>
 #include <functional>
 #include <list>
+#include <memory>
 #include <mutex>
+#include <string>
 #include <vector>
 
 #include "envoy/event/deferred_deletable.h"
 #include "envoy/event/dispatcher.h"
 #include "envoy/network/connection_handler.h"
+#include "envoy/stats/stats_macros.h"
 
 #include "common/common/logger.h"
 #include "common/common/thread.h"
+#include "common/common/utility.h"
 #include "common/event/libevent.h"
+#include "common/event/timer_wheel.h"
 
 namespace Envoy {
 namespace Event {
 
+/**
+ * All dispatcher stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_DISPATCHER_STATS(HISTOGRAM)                                                            \
+  HISTOGRAM(loop_duration_us)                                                                      \
+  HISTOGRAM(poll_delay_us)                                                                         \
+  HISTOGRAM(events_per_iteration)                                                                  \
+  HISTOGRAM(deferred_delete_queue_depth)
+// clang-format on
+
+/**
+ * Struct definition for all dispatcher stats. @see stats_macros.h
+ */
+struct DispatcherStats {
+  ALL_DISPATCHER_STATS(GENERATE_HISTOGRAM_STRUCT)
+};
+
 /**
  * libevent implementation of Event::Dispatcher.
  */
@@ -31,6 +54,46 @@ public:
    */
   event_base& base() { return *base_; }
 
+  /**
+   * Select whether dispatchers created after this call use libevent's epoll changelist. With the
+   * changelist, event additions and removals made while handling events are coalesced and applied
+   * when the loop next waits, instead of with one epoll_ctl() each. The changelist is only used
+   * when libevent picks the epoll backend. This is intended to be called once at startup, before
+   * any dispatchers exist.
+   * @param use_epoll_changelist supplies whether to use the epoll changelist.
+   */
+  static void useEpollChangelist(bool use_epoll_changelist);
+
+  /**
+   * Set the maximum number of deferred deletions run in each iteration of the event loop of
+   * dispatchers created after this call. When more are pending, the rest are carried over to the
+   * next iteration so that tearing down a large number of objects does not stall the loop.
+   * Explicit calls to clearDeferredDeleteList() are not limited. This is intended to be called once
+   * at startup.
+   * @param max_deletes supplies the maximum number of deletions per iteration, or 0 for no limit.
+   */
+  static void maxDeferredDeletesPerIteration(uint32_t max_deletes);
+
+  /**
+   * Called by the events of the dispatcher before they run their callback, to track the events run
+   * by each iteration of the event loop once stats are initialized.
+   */
+  void onEventActive() {
+    in_event_ = true;
+    monotonic_time_valid_ = false;
+    system_time_valid_ = false;
+    if (stats_ != nullptr && events_in_iteration_++ == 0) {
+      first_event_time_ = ProdMonotonicTimeSource::instance_.currentTime();
+      monotonic_time_ = first_event_time_;
+      monotonic_time_valid_ = true;
+    }
+  }
+
+  /**
+   * Called by the events of the dispatcher once their callback has run.
+   */
+  void onEventDone() { in_event_ = false; }
+
   // Event::Dispatcher
   void clearDeferredDeleteList() override;
   Network::ClientConnectionPtr
@@ -53,16 +116,27 @@ public:
                                          Ssl::ServerContext& ssl_ctx, Network::ListenSocket& socket,
                                          Network::ListenerCallbacks& cb, Stats::Scope& scope,
                                          const Network::ListenerOptions& listener_options) override;
+  Network::UdpListenerPtr createUdpListener(Network::ListenSocket& socket,
+                                            Network::UdpListenerCallbacks& cb,
+                                            Stats::Scope& scope) override;
   TimerPtr createTimer(TimerCb cb) override;
+  TimerPtr createCoarseTimer(TimerCb cb) override;
   void deferredDelete(DeferredDeletablePtr&& to_delete) override;
   void exit() override;
   SignalEventPtr listenForSignal(int signal_num, SignalCb cb) override;
   void post(std::function<void()> callback) override;
   void run(RunType type) override;
+  void initializeStats(Stats::Scope& scope, const std::string& prefix) override;
   Buffer::WatermarkFactory& getWatermarkFactory() override { return *buffer_factory_; }
+  MonotonicTime approximateMonotonicTime() override;
+  SystemTime approximateSystemTime() override;
 
 private:
+  static Libevent::BasePtr createBase();
   void runPostCallbacks();
+  void runIterations(RunType type);
+  void onDeferredDeleteTimer();
+  void deleteDeferred(size_t max_to_delete);
 #ifndef NDEBUG
   // Validate that an operation is thread safe, i.e. it's invoked on the same thread that the
   // dispatcher run loop is executing on. We allow run_tid_ == 0 for tests where we don't invoke
@@ -72,17 +146,33 @@ private:
   }
 #endif
 
+  static bool use_epoll_changelist_;
+  static uint32_t max_deferred_deletes_per_iteration_;
+
   Thread::ThreadId run_tid_{};
   Buffer::WatermarkFactoryPtr buffer_factory_;
   Libevent::BasePtr base_;
   TimerPtr deferred_delete_timer_;
   TimerPtr post_timer_;
-  std::vector<DeferredDeletablePtr> to_delete_1_;
-  std::vector<DeferredDeletablePtr> to_delete_2_;
-  std::vector<DeferredDeletablePtr>* current_to_delete_;
+  TimerWheel coarse_timers_;
+  // Objects are queued in to_delete_, and destroyed in FIFO order from deleting_, which is only
+  // refilled once it has been fully destroyed.
+  std::vector<DeferredDeletablePtr> to_delete_;
+  std::vector<DeferredDeletablePtr> deleting_;
+  size_t deleting_position_{};
   std::mutex post_lock_;
   std::list<std::function<void()>> post_callbacks_;
   bool deferred_deleting_{};
+  const uint32_t max_deletes_per_iteration_;
+  std::unique_ptr<DispatcherStats> stats_;
+  uint64_t events_in_iteration_{};
+  MonotonicTime first_event_time_;
+  // The approximate times are read on first use in each event callback.
+  bool in_event_{};
+  bool monotonic_time_valid_{};
+  bool system_time_valid_{};
+  MonotonicTime monotonic_time_;
+  SystemTime system_time_;
 };
 
 } // namespace Event
@@ -12,7 +12,7 @@ namespace Event {
 
 FileEventImpl::FileEventImpl(DispatcherImpl& dispatcher, int fd, FileReadyCb cb,
                              FileTriggerType trigger, uint32_t events)
-    : cb_(cb), base_(&dispatcher.base()), fd_(fd), trigger_(trigger) {
+    : cb_(cb), dispatcher_(dispatcher), fd_(fd), trigger_(trigger) {
   assignEvents(events);
   event_add(&raw_event_, nullptr);
 }
@@ -36,7 +36,7 @@ void FileEventImpl::activate(uint32_t events) {
 }
 
 void FileEventImpl::assignEvents(uint32_t events) {
-  event_assign(&raw_event_, base_, fd_,
+  event_assign(&raw_event_, &dispatcher_.base(), fd_,
                EV_PERSIST | (trigger_ == FileTriggerType::Level ? 0 : EV_ET) |
                    (events & FileReadyType::Read ? EV_READ : 0) |
                    (events & FileReadyType::Write ? EV_WRITE : 0) |
@@ -57,7 +57,11 @@ void FileEventImpl::assignEvents(uint32_t events) {
                  }
 
                  ASSERT(events);
+                 // The callback may destroy the event.
+                 DispatcherImpl& dispatcher = event->dispatcher_;
+                 dispatcher.onEventActive();
                  event->cb_(events);
+                 dispatcher.onEventDone();
                },
                this);
 }
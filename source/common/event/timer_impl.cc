@@ -10,11 +10,18 @@
 namespace Envoy {
 namespace Event {
 
-TimerImpl::TimerImpl(DispatcherImpl& dispatcher, TimerCb cb) : cb_(cb) {
+TimerImpl::TimerImpl(DispatcherImpl& dispatcher, TimerCb cb) : cb_(cb), dispatcher_(dispatcher) {
   ASSERT(cb_);
-  evtimer_assign(
-      &raw_event_, &dispatcher.base(),
-      [](evutil_socket_t, short, void* arg) -> void { static_cast<TimerImpl*>(arg)->cb_(); }, this);
+  evtimer_assign(&raw_event_, &dispatcher.base(),
+                 [](evutil_socket_t, short, void* arg) -> void {
+                   TimerImpl* timer = static_cast<TimerImpl*>(arg);
+                   // The callback may destroy the timer.
+                   DispatcherImpl& dispatcher = timer->dispatcher_;
+                   dispatcher.onEventActive();
+                   timer->cb_();
+                   dispatcher.onEventDone();
+                 },
+                 this);
 }
 
 void TimerImpl::disableTimer() { event_del(&raw_event_); }
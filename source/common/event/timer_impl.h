@@ -23,6 +23,7 @@ public:
 
 private:
   TimerCb cb_;
+  DispatcherImpl& dispatcher_;
 };
 
 } // namespace Event
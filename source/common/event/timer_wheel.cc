@@ -0,0 +1,192 @@
+#include "common/event/timer_wheel.h"
+
+#include <algorithm>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Event {
+
+const uint64_t TimerWheel::TICK_MS;
+const uint32_t TimerWheel::SLOT_BITS;
+const uint64_t TimerWheel::SLOTS;
+const uint32_t TimerWheel::LEVELS;
+
+/**
+ * A timer on the wheel. While pending, the timer is linked into a slot of the wheel.
+ */
+class TimerWheel::WheelTimer : public Timer, public TimerWheel::Node {
+public:
+  WheelTimer(TimerWheel& wheel, TimerCb cb) : wheel_(wheel), cb_(cb) { ASSERT(cb_); }
+  ~WheelTimer() { disableTimer(); }
+
+  // Event::Timer
+  void disableTimer() override { wheel_.disable(*this); }
+  void enableTimer(const std::chrono::milliseconds& d) override { wheel_.enable(*this, d); }
+
+  TimerWheel& wheel_;
+  const TimerCb cb_;
+  uint64_t expiry_tick_{};
+  bool pending_{};
+};
+
+TimerWheel::TimerWheel(const TimerFactory& timer_factory, MonotonicTimeSource& time_source)
+    : time_source_(time_source), start_(time_source.currentTime()),
+      tick_timer_(timer_factory([this]() -> void { onTick(); })) {}
+
+TimerPtr TimerWheel::createTimer(TimerCb cb) { return TimerPtr{new WheelTimer(*this, cb)}; }
+
+uint64_t TimerWheel::elapsedMs() const {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(time_source_.currentTime() - start_)
+      .count();
+}
+
+uint64_t TimerWheel::currentTick() const { return elapsedMs() / TICK_MS; }
+
+uint64_t TimerWheel::expiryTick(const std::chrono::milliseconds& d) const {
+  // Round up so that the timer never fires before d has passed.
+  static const uint64_t tick_ns = TICK_MS * 1000 * 1000;
+  const std::chrono::nanoseconds expiry = time_source_.currentTime() - start_ + d;
+  return std::max((expiry.count() + tick_ns - 1) / tick_ns, next_tick_);
+}
+
+void TimerWheel::enable(WheelTimer& timer, const std::chrono::milliseconds& d) {
+  disable(timer);
+  if (num_pending_ == 0) {
+    // Nothing is pending, so there is no need to go through the ticks that passed since the wheel
+    // was last used.
+    next_tick_ = std::max(next_tick_, currentTick());
+  }
+
+  timer.expiry_tick_ = expiryTick(d);
+  timer.pending_ = true;
+  num_pending_++;
+  insert(timer);
+
+  if (!scheduled_ || timer.expiry_tick_ < scheduled_tick_) {
+    schedule();
+  }
+}
+
+void TimerWheel::disable(WheelTimer& timer) {
+  if (!timer.pending_) {
+    return;
+  }
+
+  // The wheel isn't rescheduled. If the timer was the next to expire, the wheel wakes up for
+  // nothing once and then reschedules.
+  timer.unlink();
+  timer.pending_ = false;
+  ASSERT(num_pending_ > 0);
+  num_pending_--;
+}
+
+void TimerWheel::insert(WheelTimer& timer) {
+  ASSERT(timer.expiry_tick_ >= next_tick_);
+  static const uint64_t max_delta = (1ULL << (SLOT_BITS * LEVELS)) - 1;
+
+  // Timers beyond the range of the wheel are put in the top level, and cascaded back into it until
+  // they are in range.
+  const uint64_t placement_tick = next_tick_ + std::min(timer.expiry_tick_ - next_tick_, max_delta);
+  uint32_t level = 0;
+  while (level < LEVELS - 1 && placement_tick - next_tick_ >= 1ULL << (SLOT_BITS * (level + 1))) {
+    level++;
+  }
+  slots_[level][(placement_tick >> (SLOT_BITS * level)) & (SLOTS - 1)].pushBack(timer);
+}
+
+void TimerWheel::cascade(uint32_t level, uint64_t slot) {
+  Node timers;
+  slots_[level][slot].moveTo(timers);
+  while (!timers.empty()) {
+    WheelTimer& timer = static_cast<WheelTimer&>(*timers.next_);
+    timer.unlink();
+    insert(timer);
+  }
+}
+
+void TimerWheel::processTick() {
+  // When a level wraps, bring the next span of the level above down, and so on up the levels.
+  if ((next_tick_ & (SLOTS - 1)) == 0) {
+    for (uint32_t level = 1; level < LEVELS; level++) {
+      const uint64_t slot = (next_tick_ >> (SLOT_BITS * level)) & (SLOTS - 1);
+      cascade(level, slot);
+      if (slot != 0) {
+        break;
+      }
+    }
+  }
+
+  // Timers enabled by the callbacks expire at the next tick at the earliest, so they are not run
+  // by this loop.
+  Node expired;
+  slots_[0][next_tick_ & (SLOTS - 1)].moveTo(expired);
+  next_tick_++;
+  while (!expired.empty()) {
+    WheelTimer& timer = static_cast<WheelTimer&>(*expired.next_);
+    disable(timer);
+    timer.cb_();
+  }
+}
+
+void TimerWheel::onTick() {
+  scheduled_ = false;
+  const uint64_t current_tick = currentTick();
+  while (num_pending_ > 0 && next_tick_ <= current_tick) {
+    processTick();
+  }
+  schedule();
+}
+
+uint64_t TimerWheel::nextEventTick() const {
+  // The lowest level holds the timers expiring in the next SLOTS ticks. The only other event in
+  // that window is the tick where the lowest level wraps, if it cascades timers down.
+  const uint64_t wrap_tick = (next_tick_ + SLOTS - 1) & ~(SLOTS - 1);
+  for (uint64_t tick = next_tick_; tick < next_tick_ + SLOTS; tick++) {
+    if ((tick == wrap_tick && cascades(wrap_tick)) || !slots_[0][tick & (SLOTS - 1)].empty()) {
+      return tick;
+    }
+  }
+
+  // Nothing happens in the window, so the next tick that may cascade timers is the next wrap.
+  return wrap_tick + SLOTS;
+}
+
+bool TimerWheel::cascades(uint64_t tick) const {
+  ASSERT((tick & (SLOTS - 1)) == 0);
+  for (uint32_t level = 1; level < LEVELS; level++) {
+    const uint64_t slot = (tick >> (SLOT_BITS * level)) & (SLOTS - 1);
+    if (!slots_[level][slot].empty()) {
+      return true;
+    }
+    if (slot != 0) {
+      break;
+    }
+  }
+  return false;
+}
+
+void TimerWheel::schedule() {
+  if (num_pending_ == 0) {
+    if (scheduled_) {
+      tick_timer_->disableTimer();
+      scheduled_ = false;
+    }
+    return;
+  }
+
+  const uint64_t tick = nextEventTick();
+  if (scheduled_ && scheduled_tick_ == tick) {
+    return;
+  }
+
+  const uint64_t tick_ms = tick * TICK_MS;
+  const uint64_t elapsed_ms = elapsedMs();
+  tick_timer_->enableTimer(
+      std::chrono::milliseconds(tick_ms > elapsed_ms ? tick_ms - elapsed_ms : 0));
+  scheduled_ = true;
+  scheduled_tick_ = tick;
+}
+
+} // namespace Event
+} // namespace Envoy
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+#include "envoy/common/time.h"
+#include "envoy/event/timer.h"
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Event {
+
+/**
+ * A hierarchical timer wheel for timeouts that tolerate firing up to a tick late, such as idle and
+ * request timeouts. Enabling and disabling a timer is O(1) and allocation free, compared with
+ * O(log n) for the libevent timer heap, and the whole wheel is driven by a single timer which is
+ * only armed while timers are pending.
+ *
+ * The wheel has LEVELS levels of SLOTS slots. A slot of level n holds the timers expiring in one
+ * span of SLOTS^n ticks. A timer is put in the lowest level whose range covers its expiry, and
+ * whenever a level wraps, the next slot of the level above is cascaded down into the lower levels.
+ * Timeouts longer than the range of the top level are cascaded through it again until they are in
+ * range. Timers never fire early.
+ */
+class TimerWheel : NonCopyable {
+public:
+  typedef std::function<TimerPtr(TimerCb cb)> TimerFactory;
+
+  /**
+   * @param timer_factory supplies the factory for the timer that drives the wheel.
+   * @param time_source supplies the time source used to compute expiry ticks.
+   */
+  TimerWheel(const TimerFactory& timer_factory, MonotonicTimeSource& time_source);
+
+  /**
+   * Allocate a timer on the wheel. The timer must be destroyed before the wheel.
+   * @param cb supplies the callback to invoke when the timer fires.
+   */
+  TimerPtr createTimer(TimerCb cb);
+
+  /**
+   * @return uint64_t the number of pending timers.
+   */
+  uint64_t numPendingTimers() const { return num_pending_; }
+
+  static const uint64_t TICK_MS = 10;
+  static const uint32_t SLOT_BITS = 6;
+  static const uint64_t SLOTS = 1 << SLOT_BITS;
+  static const uint32_t LEVELS = 4;
+
+private:
+  class WheelTimer;
+
+  /**
+   * Node of the intrusive circular lists that hold the timers of a slot.
+   */
+  struct Node {
+    Node() : prev_(this), next_(this) {}
+
+    bool empty() const { return next_ == this; }
+    void unlink() {
+      prev_->next_ = next_;
+      next_->prev_ = prev_;
+      prev_ = next_ = this;
+    }
+    void pushBack(Node& node) {
+      node.prev_ = prev_;
+      node.next_ = this;
+      prev_->next_ = &node;
+      prev_ = &node;
+    }
+    // Move all the nodes of this list to the empty list other.
+    void moveTo(Node& other) {
+      if (empty()) {
+        return;
+      }
+      other.next_ = next_;
+      other.prev_ = prev_;
+      next_->prev_ = &other;
+      prev_->next_ = &other;
+      prev_ = next_ = this;
+    }
+
+    Node* prev_;
+    Node* next_;
+  };
+
+  uint64_t elapsedMs() const;
+  uint64_t currentTick() const;
+  uint64_t expiryTick(const std::chrono::milliseconds& d) const;
+  void enable(WheelTimer& timer, const std::chrono::milliseconds& d);
+  void disable(WheelTimer& timer);
+  void insert(WheelTimer& timer);
+  void cascade(uint32_t level, uint64_t slot);
+  void processTick();
+  void onTick();
+  uint64_t nextEventTick() const;
+  bool cascades(uint64_t tick) const;
+  void schedule();
+
+  MonotonicTimeSource& time_source_;
+  const MonotonicTime start_;
+  TimerPtr tick_timer_;
+  Node slots_[LEVELS][SLOTS];
+  // The next tick to process. Every pending timer expires at or after it.
+  uint64_t next_tick_{};
+  uint64_t num_pending_{};
+  // The tick tick_timer_ is armed for, if it is armed.
+  bool scheduled_{};
+  uint64_t scheduled_tick_{};
+};
+
+} // namespace Event
+} // namespace Envoy
@@ -1,8 +1,11 @@
 #include "common/filesystem/filesystem_impl.h"
 
 #include <dirent.h>
+#include <sys/uio.h>
 
+#include <algorithm>
 #include <chrono>
+#include <climits>
 #include <cstdint>
 #include <fstream>
 #include <iostream>
@@ -53,12 +56,77 @@ std::string fileReadToEnd(const std::string& path) {
   return file_string.str();
 }
 
+FileFlusher::FileFlusher() : thread_(new Thread::Thread([this]() -> void { flushThreadFunc(); })) {}
+
+FileFlusher::~FileFlusher() {
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    exit_ = true;
+  }
+
+  work_event_.notify_one();
+  thread_->join();
+}
+
+std::shared_ptr<FileFlusher> FileFlusher::get() {
+  static std::mutex* lock = new std::mutex();
+  static std::weak_ptr<FileFlusher>* flusher = new std::weak_ptr<FileFlusher>();
+
+  std::unique_lock<std::mutex> guard(*lock);
+  std::shared_ptr<FileFlusher> shared = flusher->lock();
+  if (shared == nullptr) {
+    shared.reset(new FileFlusher());
+    *flusher = shared;
+  }
+
+  return shared;
+}
+
+void FileFlusher::schedule(FileImpl& file) {
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    if (std::find(pending_.begin(), pending_.end(), &file) != pending_.end()) {
+      return;
+    }
+
+    pending_.push_back(&file);
+  }
+
+  work_event_.notify_one();
+}
+
+void FileFlusher::cancel(FileImpl& file) {
+  std::unique_lock<std::mutex> lock(lock_);
+  pending_.remove(&file);
+  flushed_event_.wait(lock, [this, &file]() -> bool { return flushing_ != &file; });
+}
+
+void FileFlusher::flushThreadFunc() {
+  while (true) {
+    FileImpl* file;
+    {
+      std::unique_lock<std::mutex> lock(lock_);
+      flushing_ = nullptr;
+      flushed_event_.notify_all();
+      work_event_.wait(lock, [this]() -> bool { return exit_ || !pending_.empty(); });
+      if (exit_) {
+        return;
+      }
+
+      file = flushing_ = pending_.front();
+      pending_.pop_front();
+    }
+
+    file->flushBuffered();
+  }
+}
+
 FileImpl::FileImpl(const std::string& path, Event::Dispatcher& dispatcher,
                    Thread::BasicLockable& lock, Stats::Store& stats_store,
                    std::chrono::milliseconds flush_interval_msec)
     : path_(path), file_lock_(lock), flush_timer_(dispatcher.createTimer([this]() -> void {
         stats_.flushed_by_timer_.inc();
-        flush_event_.notify_one();
+        flusher_->schedule(*this);
         flush_timer_->enableTimer(flush_interval_msec_);
       })),
       os_sys_calls_(Api::OsSysCallsSingleton::get()), flush_interval_msec_(flush_interval_msec),
@@ -79,14 +147,8 @@ void FileImpl::open() {
 void FileImpl::reopen() { reopen_file_ = true; }
 
 FileImpl::~FileImpl() {
-  {
-    std::unique_lock<std::mutex> lock(write_lock_);
-    flush_thread_exit_ = true;
-    flush_event_.notify_one();
-  }
-
-  if (flush_thread_ != nullptr) {
-    flush_thread_->join();
+  if (flusher_ != nullptr) {
+    flusher_->cancel(*this);
   }
 
   // Flush any remaining data. If file was not opened for some reason, skip flushing part.
@@ -104,6 +166,10 @@ void FileImpl::doWrite(Buffer::Instance& buffer) {
   Buffer::RawSlice slices[num_slices];
   buffer.getRawSlices(slices, num_slices);
 
+  // The whole buffer is gathered into as few writev() calls as possible, rather than
+  // written a slice at a time.
+  iovec iov[std::min<uint64_t>(num_slices, IOV_MAX)];
+
   // We must do the actual writes to disk under lock, so that we don't intermix chunks from
   // different FileImpl pointing to the same underlying file. This can happen either via hot
   // restart or if calling code opens the same underlying file into a different FileImpl in the
@@ -114,9 +180,17 @@ void FileImpl::doWrite(Buffer::Instance& buffer) {
   //            process lock or had multiple locks.
   {
     std::lock_guard<Thread::BasicLockable> lock(file_lock_);
-    for (Buffer::RawSlice& slice : slices) {
-      ssize_t rc = os_sys_calls_.write(fd_, slice.mem_, slice.len_);
-      ASSERT(rc == static_cast<ssize_t>(slice.len_));
+    for (uint64_t i = 0; i < num_slices; i += IOV_MAX) {
+      const uint64_t num_iov = std::min<uint64_t>(num_slices - i, IOV_MAX);
+      size_t num_bytes = 0;
+      for (uint64_t j = 0; j < num_iov; j++) {
+        iov[j].iov_base = slices[i + j].mem_;
+        iov[j].iov_len = slices[i + j].len_;
+        num_bytes += slices[i + j].len_;
+      }
+
+      ssize_t rc = os_sys_calls_.writev(fd_, iov, num_iov);
+      ASSERT(rc == static_cast<ssize_t>(num_bytes));
       UNREFERENCED_PARAMETER(rc);
       stats_.write_completed_.inc();
     }
@@ -126,43 +200,35 @@ void FileImpl::doWrite(Buffer::Instance& buffer) {
   buffer.drain(buffer.length());
 }
 
-void FileImpl::flushThreadFunc() {
+void FileImpl::flushBuffered() {
+  std::unique_lock<std::mutex> flush_lock;
 
-  while (true) {
-    std::unique_lock<std::mutex> flush_lock;
+  {
+    std::unique_lock<std::mutex> write_lock(write_lock_);
 
-    {
-      std::unique_lock<std::mutex> write_lock(write_lock_);
+    // A flush can be scheduled both by the timer and by a large enough flush buffer, so the
+    // buffer may have already been flushed.
+    if (flush_buffer_.length() == 0) {
+      return;
+    }
 
-      // flush_event_ can be woken up either by large enough flush_buffer or by timer.
-      // In case it was timer, flush_buffer_ can be empty.
-      while (flush_buffer_.length() == 0 && !flush_thread_exit_) {
-        flush_event_.wait(write_lock);
-      }
+    flush_lock = std::unique_lock<std::mutex>(flush_lock_);
+    about_to_write_buffer_.move(flush_buffer_);
+    ASSERT(flush_buffer_.length() == 0);
+  }
 
-      if (flush_thread_exit_) {
-        return;
+  // if we failed to open file before (-1 == fd_), then simply ignore
+  if (fd_ != -1) {
+    try {
+      if (reopen_file_) {
+        reopen_file_ = false;
+        os_sys_calls_.close(fd_);
+        open();
       }
 
-      flush_lock = std::unique_lock<std::mutex>(flush_lock_);
-      ASSERT(flush_buffer_.length() > 0);
-      about_to_write_buffer_.move(flush_buffer_);
-      ASSERT(flush_buffer_.length() == 0);
-    }
-
-    // if we failed to open file before (-1 == fd_), then simply ignore
-    if (fd_ != -1) {
-      try {
-        if (reopen_file_) {
-          reopen_file_ = false;
-          os_sys_calls_.close(fd_);
-          open();
-        }
-
-        doWrite(about_to_write_buffer_);
-      } catch (const EnvoyException&) {
-        stats_.reopen_failed_.inc();
-      }
+      doWrite(about_to_write_buffer_);
+    } catch (const EnvoyException&) {
+      stats_.reopen_failed_.inc();
     }
   }
 }
@@ -174,7 +240,7 @@ void FileImpl::flush() {
     std::lock_guard<std::mutex> write_lock(write_lock_);
 
     // flush_lock_ must be held while checking this or else it is
-    // possible that flushThreadFunc() has already moved data from
+    // possible that flushBuffered() has already moved data from
     // flush_buffer_ to about_to_write_buffer_, has unlocked write_lock_,
     // but has not yet completed doWrite(). This would allow flush() to
     // return before the pending data has actually been written to disk.
@@ -194,7 +260,7 @@ void FileImpl::flush() {
 void FileImpl::write(const std::string& data) {
   std::lock_guard<std::mutex> lock(write_lock_);
 
-  if (flush_thread_ == nullptr) {
+  if (flusher_ == nullptr) {
     createFlushStructures();
   }
 
@@ -202,12 +268,12 @@ void FileImpl::write(const std::string& data) {
   stats_.write_total_buffered_.add(data.length());
   flush_buffer_.add(data);
   if (flush_buffer_.length() > MIN_FLUSH_SIZE) {
-    flush_event_.notify_one();
+    flusher_->schedule(*this);
   }
 }
 
 void FileImpl::createFlushStructures() {
-  flush_thread_.reset(new Thread::Thread([this]() -> void { flushThreadFunc(); }));
+  flusher_ = FileFlusher::get();
   flush_timer_->enableTimer(flush_interval_msec_);
 }
 
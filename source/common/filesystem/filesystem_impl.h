@@ -4,6 +4,8 @@
 #include <chrono>
 #include <condition_variable>
 #include <cstdint>
+#include <list>
+#include <memory>
 #include <mutex>
 #include <string>
 
@@ -47,12 +49,53 @@ bool directoryExists(const std::string& path);
  */
 std::string fileReadToEnd(const std::string& path);
 
+class FileImpl;
+
+/**
+ * A thread which flushes the buffered data of all files, so that the number of threads does not
+ * grow with the number of access logs. Files are flushed one at a time, which costs little since
+ * disk writes are serialized by the cross process file lock anyway.
+ */
+class FileFlusher {
+public:
+  ~FileFlusher();
+
+  /**
+   * @return std::shared_ptr<FileFlusher> the flusher shared by all files. It is created when first
+   *         needed and destroyed along with the last file using it.
+   */
+  static std::shared_ptr<FileFlusher> get();
+
+  /**
+   * Ask for the buffered data of a file to be flushed. This may be called from any thread.
+   * @param file supplies the file to flush.
+   */
+  void schedule(FileImpl& file);
+
+  /**
+   * Stop flushing a file. If the file is being flushed, this waits for the flush to complete.
+   * @param file supplies the file which is going away.
+   */
+  void cancel(FileImpl& file);
+
+private:
+  FileFlusher();
+
+  void flushThreadFunc();
+
+  std::mutex lock_;
+  std::condition_variable work_event_;
+  std::condition_variable flushed_event_;
+  std::list<FileImpl*> pending_;
+  FileImpl* flushing_{};
+  bool exit_{};
+  Thread::ThreadPtr thread_;
+};
+
 /**
  * This is a file implementation geared for writing out access logs. It turn out that in certain
  * cases even if a standard file is opened with O_NONBLOCK, the kernel can still block when writing.
- * This implementation uses a flush thread per file, with the idea there there aren't that many
- * files. If this turns out to be a good implementation we can potentially have a single flush
- * thread that flushes all files, but we will start with this.
+ * Writes are buffered, and written to disk by a flush thread which is shared by all files.
  */
 class FileImpl : public File {
 public:
@@ -75,8 +118,10 @@ public:
   void flush() override;
 
 private:
+  friend class FileFlusher;
+
   void doWrite(Buffer::Instance& buffer);
-  void flushThreadFunc();
+  void flushBuffered();
   void open();
   void createFlushStructures();
 
@@ -102,14 +147,12 @@ private:
   std::mutex write_lock_;            // The lock is used when filling the flush buffer. It allows
                                      // multiple threads to write to the same file at relatively
                                      // high performance. It is always local to the process.
-  Thread::ThreadPtr flush_thread_;
-  std::condition_variable_any flush_event_;
-  std::atomic<bool> flush_thread_exit_{};
+  std::shared_ptr<FileFlusher> flusher_;
   std::atomic<bool> reopen_file_{};
   Buffer::OwnedImpl flush_buffer_; // This buffer is used by multiple threads. It gets filled and
                                    // then flushed either when max size is reached or when a timer
                                    // fires.
-  Buffer::OwnedImpl about_to_write_buffer_; // This buffer is used only by the flush thread. Data
+  Buffer::OwnedImpl about_to_write_buffer_; // This buffer is used only when flushing. Data
                                             // is moved from flush_buffer_ under lock, and then
                                             // the lock is released so that flush_buffer_ can
                                             // continue to fill. This buffer is then used for the
@@ -57,9 +57,9 @@ GlobalStats Config::generateStats(Stats::Scope& scope, const std::string& prefix
   return stats;
 }
 
-void Config::parseResponse(const Http::Message& message) {
+void Config::parseResponse(Http::Message& message) {
   AllowedPrincipalsSharedPtr new_principals(new AllowedPrincipals());
-  Json::ObjectSharedPtr loader = Json::Factory::loadFromString(message.bodyAsString());
+  Json::ObjectSharedPtr loader = Json::Factory::loadFromBuffer(*message.body());
   for (const Json::ObjectSharedPtr& certificate : loader->getObjectArray("certificates")) {
     new_principals->add(certificate->getString("fingerprint_sha256"));
   }
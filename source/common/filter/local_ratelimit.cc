@@ -0,0 +1,36 @@
+#include "common/filter/local_ratelimit.h"
+
+#include <string>
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace RateLimit {
+namespace TcpFilter {
+
+LocalRateLimitConfig::LocalRateLimitConfig(std::chrono::milliseconds fill_interval,
+                                           const TokenBucket& bucket,
+                                           const std::string& stat_prefix, Stats::Scope& scope,
+                                           ThreadLocal::SlotAllocator& tls)
+    : rate_limiter_(fill_interval, bucket, {}, tls), stats_(generateStats(stat_prefix, scope)) {}
+
+LocalRateLimitStats LocalRateLimitConfig::generateStats(const std::string& name,
+                                                        Stats::Scope& scope) {
+  std::string final_prefix = fmt::format("local_ratelimit.{}.", name);
+  return {ALL_TCP_LOCAL_RATE_LIMIT_STATS(POOL_COUNTER_PREFIX(scope, final_prefix))};
+}
+
+Network::FilterStatus LocalRateLimitFilter::onNewConnection() {
+  if (!config_->rateLimiter().requestAllowed({})) {
+    config_->stats().rate_limited_.inc();
+    filter_callbacks_->connection().close(Network::ConnectionCloseType::NoFlush);
+    return Network::FilterStatus::StopIteration;
+  }
+
+  config_->stats().ok_.inc();
+  return Network::FilterStatus::Continue;
+}
+
+} // namespace TcpFilter
+} // namespace RateLimit
+} // namespace Envoy
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "envoy/network/connection.h"
+#include "envoy/network/filter.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/ratelimit/local_ratelimit_impl.h"
+
+namespace Envoy {
+namespace RateLimit {
+namespace TcpFilter {
+
+/**
+ * All tcp local rate limit stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_TCP_LOCAL_RATE_LIMIT_STATS(COUNTER)                                                    \
+  COUNTER(ok)                                                                                      \
+  COUNTER(rate_limited)
+// clang-format on
+
+/**
+ * Struct definition for all tcp local rate limit stats. @see stats_macros.h
+ */
+struct LocalRateLimitStats {
+  ALL_TCP_LOCAL_RATE_LIMIT_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Global configuration for the TCP local rate limit filter.
+ */
+class LocalRateLimitConfig {
+public:
+  LocalRateLimitConfig(std::chrono::milliseconds fill_interval, const TokenBucket& bucket,
+                       const std::string& stat_prefix, Stats::Scope& scope,
+                       ThreadLocal::SlotAllocator& tls);
+
+  LocalRateLimiterImpl& rateLimiter() { return rate_limiter_; }
+  const LocalRateLimitStats& stats() { return stats_; }
+
+private:
+  static LocalRateLimitStats generateStats(const std::string& name, Stats::Scope& scope);
+
+  LocalRateLimiterImpl rate_limiter_;
+  const LocalRateLimitStats stats_;
+};
+
+typedef std::shared_ptr<LocalRateLimitConfig> LocalRateLimitConfigSharedPtr;
+
+/**
+ * TCP local rate limit filter instance. Each new connection takes a token from the local token
+ * bucket of its worker, and is closed before any further filters are called if there is none.
+ */
+class LocalRateLimitFilter : public Network::ReadFilter {
+public:
+  LocalRateLimitFilter(LocalRateLimitConfigSharedPtr config) : config_(config) {}
+
+  // Network::ReadFilter
+  Network::FilterStatus onData(Buffer::Instance&) override {
+    return Network::FilterStatus::Continue;
+  }
+  Network::FilterStatus onNewConnection() override;
+  void initializeReadFilterCallbacks(Network::ReadFilterCallbacks& callbacks) override {
+    filter_callbacks_ = &callbacks;
+  }
+
+private:
+  LocalRateLimitConfigSharedPtr config_;
+  Network::ReadFilterCallbacks* filter_callbacks_{};
+};
+
+} // namespace TcpFilter
+} // namespace RateLimit
+} // namespace Envoy
@@ -1,5 +1,6 @@
 #include "common/filter/tcp_proxy.h"
 
+#include <chrono>
 #include <cstdint>
 #include <string>
 
@@ -39,7 +40,8 @@ TcpProxyConfig::Route::Route(
 TcpProxyConfig::TcpProxyConfig(const envoy::api::v2::filter::network::TcpProxy& config,
                                Server::Configuration::FactoryContext& context)
     : stats_(generateStats(config.stat_prefix(), context.scope())),
-      max_connect_attempts_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_connect_attempts, 1)) {
+      max_connect_attempts_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_connect_attempts, 1)),
+      runtime_(context.runtime()), upstream_pool_slot_(context.threadLocal().allocateSlot()) {
 
   if (config.has_deprecated_v1()) {
     for (const envoy::api::v2::filter::network::TcpProxy::DeprecatedV1::TCPRoute& route_desc :
@@ -61,6 +63,15 @@ TcpProxyConfig::TcpProxyConfig(const envoy::api::v2::filter::network::TcpProxy&
   for (const envoy::api::v2::filter::accesslog::AccessLog& log_config : config.access_log()) {
     access_logs_.emplace_back(AccessLog::AccessLogFactory::fromProto(log_config, context));
   }
+
+  Upstream::ClusterManager& cluster_manager = context.clusterManager();
+  Runtime::Loader& runtime = context.runtime();
+  const TcpProxyStats stats = stats_;
+  upstream_pool_slot_->set(
+      [&cluster_manager, &runtime,
+       stats](Event::Dispatcher& dispatcher) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+        return std::make_shared<TcpProxyUpstreamPool>(cluster_manager, runtime, dispatcher, stats);
+      });
 }
 
 const std::string& TcpProxyConfig::getRouteFromEntries(Network::Connection& connection) {
@@ -93,6 +104,164 @@ const std::string& TcpProxyConfig::getRouteFromEntries(Network::Connection& conn
   return EMPTY_STRING;
 }
 
+TcpProxyUpstreamPool::TcpProxyUpstreamPool(Upstream::ClusterManager& cluster_manager,
+                                           Runtime::Loader& runtime, Event::Dispatcher& dispatcher,
+                                           const TcpProxyStats& stats)
+    : cluster_manager_(cluster_manager), runtime_(runtime), dispatcher_(dispatcher),
+      stats_(stats) {}
+
+TcpProxyUpstreamPool::~TcpProxyUpstreamPool() {
+  for (auto& cluster : idle_connections_) {
+    for (const IdleConnectionSharedPtr& idle : cluster.second) {
+      close(*idle);
+      // Destroying the connection releases its reference to the idle connection.
+      idle->connection_.reset();
+    }
+  }
+}
+
+Upstream::Host::CreateConnectionData
+TcpProxyUpstreamPool::claim(const std::string& cluster_name) {
+  Upstream::Host::CreateConnectionData conn_info;
+  const uint64_t pool_size = runtime_.snapshot().getInteger("tcp_proxy.upstream_pool_size", 0);
+  if (pool_size == 0) {
+    return conn_info;
+  }
+
+  std::list<IdleConnectionSharedPtr>& idle_connections = idle_connections_[cluster_name];
+  for (auto it = idle_connections.begin(); it != idle_connections.end(); ++it) {
+    IdleConnection& idle = **it;
+    if (!idle.connected_) {
+      continue;
+    }
+
+    ENVOY_CONN_LOG(debug, "claiming idle upstream connection", *idle.connection_);
+    idle.parent_ = nullptr;
+    idle.timer_.reset();
+    conn_info.connection_ = std::move(idle.connection_);
+    conn_info.host_description_ = idle.host_;
+    idle_connections.erase(it);
+    stats_.upstream_cx_prewarm_claimed_.inc();
+    break;
+  }
+
+  fill(cluster_name, pool_size);
+  return conn_info;
+}
+
+void TcpProxyUpstreamPool::fill(const std::string& cluster_name, uint64_t pool_size) {
+  Upstream::ThreadLocalCluster* thread_local_cluster = cluster_manager_.get(cluster_name);
+  if (thread_local_cluster == nullptr) {
+    return;
+  }
+
+  // The host of an original destination cluster depends on the downstream connection.
+  Upstream::ClusterInfoConstSharedPtr cluster = thread_local_cluster->info();
+  if (cluster->lbType() == Upstream::LoadBalancerType::OriginalDst) {
+    return;
+  }
+
+  std::list<IdleConnectionSharedPtr>& idle_connections = idle_connections_[cluster_name];
+  while (idle_connections.size() < pool_size &&
+         cluster->resourceManager(Upstream::ResourcePriority::Default).connections().canCreate()) {
+    Upstream::Host::CreateConnectionData conn_info =
+        cluster_manager_.tcpConnForCluster(cluster_name, nullptr);
+    if (!conn_info.connection_) {
+      break;
+    }
+
+    IdleConnectionSharedPtr idle = std::make_shared<IdleConnection>(*this, cluster_name);
+    idle->connection_ = std::move(conn_info.connection_);
+    idle->host_ = conn_info.host_description_;
+    const Upstream::ClusterInfo& info = idle->host_->cluster();
+    info.resourceManager(Upstream::ResourcePriority::Default).connections().inc();
+    idle->connection_->addReadFilter(idle);
+    idle->connection_->addConnectionCallbacks(*idle);
+    idle->connection_->setConnectionStats(
+        {info.stats().upstream_cx_rx_bytes_total_, info.stats().upstream_cx_rx_bytes_buffered_,
+         info.stats().upstream_cx_tx_bytes_total_, info.stats().upstream_cx_tx_bytes_buffered_,
+         &info.stats().bind_errors_, &info.stats().upstream_cx_rx_syscalls_total_,
+         &info.stats().upstream_cx_tx_syscalls_total_});
+    idle->connection_->connect();
+    idle->connection_->noDelay(true);
+
+    IdleConnection* raw_idle = idle.get();
+    idle->timer_ = dispatcher_.createTimer([this, raw_idle]() -> void { onTimeout(*raw_idle); });
+    idle->timer_->enableTimer(cluster->connectTimeout());
+
+    info.stats().upstream_cx_total_.inc();
+    info.stats().upstream_cx_active_.inc();
+    idle->host_->stats().cx_total_.inc();
+    idle->host_->stats().cx_active_.inc();
+    idle->connect_timespan_.reset(new Stats::Timespan(info.stats().upstream_cx_connect_ms_));
+    stats_.upstream_cx_prewarm_total_.inc();
+    idle_connections.push_back(idle);
+  }
+}
+
+void TcpProxyUpstreamPool::IdleConnection::onEvent(Network::ConnectionEvent event) {
+  if (parent_ == nullptr) {
+    return;
+  }
+
+  if (event == Network::ConnectionEvent::Connected) {
+    connected_ = true;
+    connect_timespan_->complete();
+    host_->outlierDetector().putResult(Upstream::Outlier::Result::SUCCESS);
+    connection_->readDisable(true);
+    timer_->enableTimer(std::chrono::milliseconds(parent_->runtime_.snapshot().getInteger(
+        "tcp_proxy.upstream_pool_max_idle_ms", 60000)));
+    return;
+  }
+
+  if (event == Network::ConnectionEvent::RemoteClose) {
+    host_->cluster().stats().upstream_cx_destroy_remote_.inc();
+    if (!connected_) {
+      host_->outlierDetector().putResult(Upstream::Outlier::Result::CONNECT_FAILED);
+      host_->cluster().stats().upstream_cx_connect_fail_.inc();
+      host_->stats().cx_connect_fail_.inc();
+    }
+  }
+  parent_->remove(*this);
+}
+
+void TcpProxyUpstreamPool::onTimeout(IdleConnection& idle) {
+  if (idle.connected_) {
+    ENVOY_CONN_LOG(debug, "upstream connection idle timeout", *idle.connection_);
+    stats_.upstream_cx_prewarm_idle_timeout_.inc();
+  } else {
+    ENVOY_CONN_LOG(debug, "upstream connect timeout", *idle.connection_);
+    idle.host_->outlierDetector().putResult(Upstream::Outlier::Result::TIMEOUT);
+    idle.host_->cluster().stats().upstream_cx_connect_timeout_.inc();
+  }
+  idle.host_->cluster().stats().upstream_cx_destroy_local_.inc();
+  remove(idle);
+}
+
+void TcpProxyUpstreamPool::close(IdleConnection& idle) {
+  idle.parent_ = nullptr;
+  idle.host_->cluster().stats().upstream_cx_destroy_.inc();
+  idle.host_->cluster().stats().upstream_cx_active_.dec();
+  idle.host_->stats().cx_active_.dec();
+  idle.host_->cluster().resourceManager(Upstream::ResourcePriority::Default).connections().dec();
+  idle.connection_->close(Network::ConnectionCloseType::NoFlush);
+}
+
+void TcpProxyUpstreamPool::remove(IdleConnection& idle) {
+  close(idle);
+  idle.timer_.reset();
+  dispatcher_.deferredDelete(std::move(idle.connection_));
+
+  // The connection still holds on to the idle connection until it's deleted.
+  std::list<IdleConnectionSharedPtr>& idle_connections = idle_connections_[idle.cluster_name_];
+  for (auto it = idle_connections.begin(); it != idle_connections.end(); ++it) {
+    if (it->get() == &idle) {
+      idle_connections.erase(it);
+      break;
+    }
+  }
+}
+
 // TODO(ggreenway): refactor this and websocket code so that config_ is always non-null.
 TcpProxy::TcpProxy(TcpProxyConfigSharedPtr config, Upstream::ClusterManager& cluster_manager)
     : config_(config), cluster_manager_(cluster_manager), downstream_callbacks_(*this),
@@ -154,7 +323,9 @@ void TcpProxy::initializeReadFilterCallbacks(Network::ReadFilterCallbacks& callb
       {config_->stats().downstream_cx_rx_bytes_total_,
        config_->stats().downstream_cx_rx_bytes_buffered_,
        config_->stats().downstream_cx_tx_bytes_total_,
-       config_->stats().downstream_cx_tx_bytes_buffered_, nullptr});
+       config_->stats().downstream_cx_tx_bytes_buffered_, nullptr,
+       &config_->stats().downstream_cx_rx_syscalls_total_,
+       &config_->stats().downstream_cx_tx_syscalls_total_});
 }
 
 void TcpProxy::readDisableUpstream(bool disable) {
@@ -238,6 +409,15 @@ Network::FilterStatus TcpProxy::initializeUpstreamConnection() {
     return Network::FilterStatus::StopIteration;
   }
 
+  // A pre-warmed connection is already counted against the resource limits.
+  if (config_ != nullptr) {
+    Upstream::Host::CreateConnectionData conn_info = config_->upstreamPool().claim(cluster_name);
+    if (conn_info.connection_) {
+      onUpstreamConnectionClaimed(std::move(conn_info));
+      return Network::FilterStatus::Continue;
+    }
+  }
+
   Upstream::ClusterInfoConstSharedPtr cluster = thread_local_cluster->info();
   if (!cluster->resourceManager(Upstream::ResourcePriority::Default).connections().canCreate()) {
     request_info_.setResponseFlag(AccessLog::ResponseFlag::UpstreamOverflow);
@@ -274,7 +454,9 @@ Network::FilterStatus TcpProxy::initializeUpstreamConnection() {
        read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_rx_bytes_buffered_,
        read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_tx_bytes_total_,
        read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_tx_bytes_buffered_,
-       &read_callbacks_->upstreamHost()->cluster().stats().bind_errors_});
+       &read_callbacks_->upstreamHost()->cluster().stats().bind_errors_,
+       &read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_rx_syscalls_total_,
+       &read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_tx_syscalls_total_});
   upstream_connection_->connect();
   upstream_connection_->noDelay(true);
   request_info_.onUpstreamHostSelected(conn_info.host_description_);
@@ -297,6 +479,25 @@ Network::FilterStatus TcpProxy::initializeUpstreamConnection() {
   return Network::FilterStatus::Continue;
 }
 
+void TcpProxy::onUpstreamConnectionClaimed(Upstream::Host::CreateConnectionData&& conn_info) {
+  upstream_connection_ = std::move(conn_info.connection_);
+  read_callbacks_->upstreamHost(conn_info.host_description_);
+  ENVOY_CONN_LOG(debug, "using pre-warmed upstream connection {}", read_callbacks_->connection(),
+                 upstream_connection_->id());
+
+  connect_attempts_++;
+  upstream_connection_->addReadFilter(upstream_callbacks_);
+  upstream_connection_->addConnectionCallbacks(*upstream_callbacks_);
+  request_info_.onUpstreamHostSelected(conn_info.host_description_);
+  request_info_.upstream_local_address_ = upstream_connection_->localAddress().asString();
+  connected_timespan_.reset(new Stats::Timespan(
+      read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_length_ms_));
+
+  // The pool left the reads disabled so that nothing the upstream sent is consumed before now.
+  upstream_connection_->readDisable(false);
+  onUpstreamConnected();
+}
+
 void TcpProxy::onConnectTimeout() {
   ENVOY_CONN_LOG(debug, "connect timeout", read_callbacks_->connection());
   read_callbacks_->upstreamHost()->outlierDetector().putResult(Upstream::Outlier::Result::TIMEOUT);
@@ -362,14 +563,40 @@ void TcpProxy::onUpstreamEvent(Network::ConnectionEvent event) {
     read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_destroy_local_.inc();
   } else if (event == Network::ConnectionEvent::Connected) {
     connect_timespan_->complete();
-
-    // Re-enable downstream reads now that the upstream connection is established
-    // so we have a place to send downstream data to.
-    read_callbacks_->connection().readDisable(false);
-
     read_callbacks_->upstreamHost()->outlierDetector().putResult(
         Upstream::Outlier::Result::SUCCESS);
-    onConnectionSuccess();
+    onUpstreamConnected();
+  }
+}
+
+void TcpProxy::onUpstreamConnected() {
+  // Re-enable downstream reads now that the upstream connection is established
+  // so we have a place to send downstream data to.
+  read_callbacks_->connection().readDisable(false);
+
+  startSplicing();
+  onConnectionSuccess();
+}
+
+void TcpProxy::startSplicing() {
+  if (!spliceEnabled()) {
+    return;
+  }
+
+  // Each direction is spliced independently, so if the connections only allow one of them the
+  // other keeps going through onData() and onUpstreamData().
+  Network::Connection& downstream = read_callbacks_->connection();
+  const bool downstream_spliced =
+      downstream.spliceTo(*upstream_connection_, [this](uint64_t bytes) -> void {
+        request_info_.bytes_received_ += bytes;
+      });
+  const bool upstream_spliced = upstream_connection_->spliceTo(
+      downstream, [this](uint64_t bytes) -> void { request_info_.bytes_sent_ += bytes; });
+  ENVOY_CONN_LOG(debug, "splicing downstream={} upstream={}", downstream, downstream_spliced,
+                 upstream_spliced);
+  // The WsHandlerImpl class uses TCP Proxy code with a null config.
+  if ((downstream_spliced || upstream_spliced) && config_) {
+    config_->stats().downstream_cx_splice_total_.inc();
   }
 }
 
@@ -1,17 +1,21 @@
 #pragma once
 
 #include <cstdint>
+#include <list>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "envoy/access_log/access_log.h"
 #include "envoy/event/timer.h"
 #include "envoy/network/connection.h"
 #include "envoy/network/filter.h"
+#include "envoy/runtime/runtime.h"
 #include "envoy/server/filter_config.h"
 #include "envoy/stats/stats_macros.h"
 #include "envoy/stats/timespan.h"
+#include "envoy/thread_local/thread_local.h"
 #include "envoy/upstream/cluster_manager.h"
 #include "envoy/upstream/upstream.h"
 
@@ -33,12 +37,18 @@ namespace Filter {
 #define ALL_TCP_PROXY_STATS(COUNTER, GAUGE)                                                        \
   COUNTER(downstream_cx_rx_bytes_total)                                                            \
   GAUGE  (downstream_cx_rx_bytes_buffered)                                                         \
+  COUNTER(downstream_cx_rx_syscalls_total)                                                         \
   COUNTER(downstream_cx_tx_bytes_total)                                                            \
   GAUGE  (downstream_cx_tx_bytes_buffered)                                                         \
+  COUNTER(downstream_cx_tx_syscalls_total)                                                         \
   COUNTER(downstream_cx_total)                                                                     \
   COUNTER(downstream_cx_no_route)                                                                  \
+  COUNTER(downstream_cx_splice_total)                                                              \
   COUNTER(downstream_flow_control_paused_reading_total)                                            \
-  COUNTER(downstream_flow_control_resumed_reading_total)
+  COUNTER(downstream_flow_control_resumed_reading_total)                                           \
+  COUNTER(upstream_cx_prewarm_total)                                                               \
+  COUNTER(upstream_cx_prewarm_claimed)                                                             \
+  COUNTER(upstream_cx_prewarm_idle_timeout)
 // clang-format on
 
 /**
@@ -48,6 +58,72 @@ struct TcpProxyStats {
   ALL_TCP_PROXY_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
 };
 
+/**
+ * Per worker pool of upstream connections which are established ahead of time, so that a TcpProxy
+ * can claim one instead of waiting for a connect. The pool of a cluster is filled the first time
+ * the cluster is used on the worker and topped up whenever a connection is claimed from it, up to
+ * the "tcp_proxy.upstream_pool_size" runtime key, which defaults to 0 and so disables the pool.
+ * Idle connections are read disabled, leaving whatever the upstream sends first in the socket for
+ * the downstream, and are closed after "tcp_proxy.upstream_pool_max_idle_ms".
+ */
+class TcpProxyUpstreamPool : public ThreadLocal::ThreadLocalObject,
+                             Logger::Loggable<Logger::Id::filter> {
+public:
+  TcpProxyUpstreamPool(Upstream::ClusterManager& cluster_manager, Runtime::Loader& runtime,
+                       Event::Dispatcher& dispatcher, const TcpProxyStats& stats);
+  ~TcpProxyUpstreamPool();
+
+  /**
+   * Claim an established idle connection to a cluster, and top up the pool of the cluster.
+   * @param cluster_name supplies the cluster.
+   * @return Upstream::Host::CreateConnectionData the connection with its host, or no connection if
+   *         none is established yet. The connection is read disabled and already counted in the
+   *         connection stats of the cluster and host.
+   */
+  Upstream::Host::CreateConnectionData claim(const std::string& cluster_name);
+
+private:
+  struct IdleConnection : public Network::ConnectionCallbacks, public Network::ReadFilterBaseImpl {
+    IdleConnection(TcpProxyUpstreamPool& parent, const std::string& cluster_name)
+        : parent_(&parent), cluster_name_(cluster_name) {}
+
+    // Network::ConnectionCallbacks
+    void onEvent(Network::ConnectionEvent event) override;
+    void onAboveWriteBufferHighWatermark() override {}
+    void onBelowWriteBufferLowWatermark() override {}
+
+    // Network::ReadFilter
+    Network::FilterStatus onData(Buffer::Instance&) override {
+      // Reads are disabled until the connection is claimed, and it then belongs to the TcpProxy.
+      return Network::FilterStatus::Continue;
+    }
+
+    // Cleared once the connection is claimed or closed. The connection holds on to this object as
+    // a read filter, as it may not give up its callbacks.
+    TcpProxyUpstreamPool* parent_;
+    const std::string cluster_name_;
+    Network::ClientConnectionPtr connection_;
+    Upstream::HostDescriptionConstSharedPtr host_;
+    // Times out the connect, and then the idle period.
+    Event::TimerPtr timer_;
+    Stats::TimespanPtr connect_timespan_;
+    bool connected_{};
+  };
+
+  typedef std::shared_ptr<IdleConnection> IdleConnectionSharedPtr;
+
+  void fill(const std::string& cluster_name, uint64_t pool_size);
+  void onTimeout(IdleConnection& idle);
+  void close(IdleConnection& idle);
+  void remove(IdleConnection& idle);
+
+  Upstream::ClusterManager& cluster_manager_;
+  Runtime::Loader& runtime_;
+  Event::Dispatcher& dispatcher_;
+  TcpProxyStats stats_;
+  std::unordered_map<std::string, std::list<IdleConnectionSharedPtr>> idle_connections_;
+};
+
 /**
  * Filter configuration.
  */
@@ -70,6 +146,22 @@ public:
   const std::vector<AccessLog::InstanceSharedPtr>& accessLogs() { return access_logs_; }
   uint32_t maxConnectAttempts() const { return max_connect_attempts_; }
 
+  /**
+   * @return bool whether to splice data between the downstream and upstream connections rather
+   *         than copying it through user space, if the connections allow it.
+   */
+  bool spliceEnabled() const {
+    return runtime_.snapshot().featureEnabled("tcp_proxy.splice_enabled", 0);
+  }
+
+  /**
+   * @return TcpProxyUpstreamPool& the pool of established upstream connections of the current
+   *         worker.
+   */
+  TcpProxyUpstreamPool& upstreamPool() {
+    return upstream_pool_slot_->getTyped<TcpProxyUpstreamPool>();
+  }
+
 private:
   struct Route {
     Route(const envoy::api::v2::filter::network::TcpProxy::DeprecatedV1::TCPRoute& config);
@@ -87,6 +179,8 @@ private:
   const TcpProxyStats stats_;
   std::vector<AccessLog::InstanceSharedPtr> access_logs_;
   const uint32_t max_connect_attempts_;
+  Runtime::Loader& runtime_;
+  ThreadLocal::SlotPtr upstream_pool_slot_;
 };
 
 typedef std::shared_ptr<TcpProxyConfig> TcpProxyConfigSharedPtr;
@@ -170,11 +264,20 @@ protected:
 
   virtual void onConnectionSuccess() {}
 
+  /**
+   * @return bool whether to try splicing data between the connections once the upstream
+   *         connection is established.
+   */
+  virtual bool spliceEnabled() { return config_->spliceEnabled(); }
+
   Network::FilterStatus initializeUpstreamConnection();
+  void onUpstreamConnectionClaimed(Upstream::Host::CreateConnectionData&& conn_info);
+  void onUpstreamConnected();
   void onConnectTimeout();
   void onDownstreamEvent(Network::ConnectionEvent event);
   void onUpstreamData(Buffer::Instance& data);
   void onUpstreamEvent(Network::ConnectionEvent event);
+  void startSplicing();
   void finalizeUpstreamConnectionStats();
   void closeUpstreamConnection();
 
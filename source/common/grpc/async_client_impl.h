@@ -100,6 +100,16 @@ public:
     headers_message_ =
         Common::prepareHeaders(parent_.remote_cluster_name_, service_method_.service()->full_name(),
                                service_method_.name());
+    Upstream::ThreadLocalCluster* cluster = parent_.cm_.get(parent_.remote_cluster_name_);
+    if (cluster != nullptr &&
+        (cluster->info()->features() & Upstream::ClusterInfo::Features::GRPC_COMPRESSION)) {
+      // Larger messages are sent compressed, and the server may compress its messages too.
+      compressor_ = Common::createGzipCompressor();
+      headers_message_->headers().addReference(Http::Headers::get().GrpcEncoding,
+                                               Http::Headers::get().GrpcEncodingValues.Gzip);
+      headers_message_->headers().insertGrpcAcceptEncoding().value().setReference(
+          Http::Headers::get().GrpcAcceptEncodingValues.Gzip);
+    }
     callbacks_.onCreateInitialMetadata(headers_message_->headers());
     stream_->sendHeaders(headers_message_->headers(), false);
   }
@@ -122,6 +132,9 @@ public:
       onTrailers(std::move(headers));
       return;
     }
+    const Http::HeaderEntry* grpc_encoding = headers->get(Http::Headers::get().GrpcEncoding);
+    remote_gzip_ = compressor_ != nullptr && grpc_encoding != nullptr &&
+                   grpc_encoding->value() == Http::Headers::get().GrpcEncodingValues.Gzip.c_str();
     callbacks_.onReceiveInitialMetadata(std::move(headers));
   }
 
@@ -140,8 +153,15 @@ public:
 
     for (auto& frame : decoded_frames_) {
       std::unique_ptr<ResponseType> response(new ResponseType());
-      // TODO(htuch): Need to add support for compressed responses as well here.
       if (frame.length_ > 0) {
+        if (frame.flags_ == GRPC_FH_COMPRESSED && remote_gzip_) {
+          frame.data_ = Common::decompressBody(*frame.data_);
+          if (frame.data_ == nullptr) {
+            streamError(Status::GrpcStatus::Internal);
+            return;
+          }
+          frame.flags_ = GRPC_FH_DEFAULT;
+        }
         Buffer::ZeroCopyInputStreamImpl stream(std::move(frame.data_));
 
         if (frame.flags_ != GRPC_FH_DEFAULT || !response->ParseFromZeroCopyStream(&stream)) {
@@ -180,9 +200,14 @@ public:
     streamError(Status::GrpcStatus::Internal);
   }
 
+  void onAboveWriteBufferHighWatermark() override {}
+  void onBelowWriteBufferLowWatermark() override {}
+
   // Grpc::AsyncStream
   void sendMessage(const RequestType& request, bool end_stream) override {
-    stream_->sendData(*Common::serializeBody(request), end_stream);
+    stream_->sendData(compressor_ ? *Common::serializeBody(request, *compressor_)
+                                  : *Common::serializeBody(request),
+                      end_stream);
     if (end_stream) {
       closeLocal();
     }
@@ -254,6 +279,10 @@ private:
   bool http_reset_{};
   Http::AsyncClient::Stream* stream_{};
   Decoder decoder_;
+  // Set when the cluster supports gzip compressed messages.
+  Compressor::CompressorPtr compressor_;
+  // Whether the server compresses its messages with gzip.
+  bool remote_gzip_{};
   // This is a member to avoid reallocation on every onData().
   std::vector<Frame> decoded_frames_;
 
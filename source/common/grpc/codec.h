@@ -39,7 +39,9 @@ public:
   // Decodes the given buffer with GRPC data frame. Drains the input buffer when
   // decoding succeeded (returns true). If the input is not sufficient to make a
   // complete GRPC data frame, it will be buffered in the decoder. If a decoding
-  // error happened, the input buffer remains unchanged.
+  // error happened, the input buffer is left with the bytes from the invalid
+  // frame header on. The data of the frames is moved out of the input buffer
+  // rather than copied, so it shares the slices of the input.
   // @param input supplies the binary octets wrapped in a GRPC data frame.
   // @param output supplies the buffer to store the decoded data.
   // @return bool whether the decoding succeeded or not.
@@ -51,6 +53,8 @@ public:
   uint32_t length() const { return frame_.length_; }
 
 private:
+  void onHeaderComplete(std::vector<Frame>& output);
+
   // Wire format (http://www.grpc.io/docs/guides/wire.html) of GRPC data frame
   // header:
   //
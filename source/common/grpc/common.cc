@@ -2,6 +2,7 @@
 
 #include <arpa/inet.h>
 
+#include <array>
 #include <cstdint>
 #include <cstring>
 #include <string>
@@ -12,6 +13,9 @@
 #include "common/common/enum_to_int.h"
 #include "common/common/macros.h"
 #include "common/common/utility.h"
+#include "common/compressor/zlib_compressor_impl.h"
+#include "common/decompressor/zlib_decompressor_impl.h"
+#include "common/grpc/codec.h"
 #include "common/http/headers.h"
 #include "common/http/message_impl.h"
 #include "common/http/utility.h"
@@ -218,6 +222,47 @@ Buffer::InstancePtr Common::serializeBody(const Protobuf::Message& message) {
   return body;
 }
 
+const uint32_t Common::MIN_COMPRESSED_MESSAGE_SIZE;
+
+Buffer::InstancePtr Common::serializeBody(const Protobuf::Message& message,
+                                          Compressor::Compressor& compressor) {
+  Buffer::InstancePtr uncompressed = serializeBody(message);
+  if (uncompressed->length() - 5 < MIN_COMPRESSED_MESSAGE_SIZE) {
+    return uncompressed;
+  }
+  uncompressed->drain(5);
+
+  Buffer::OwnedImpl compressed;
+  compressor.compress(*uncompressed, compressed);
+  compressor.finish(compressed);
+  compressor.reset();
+
+  std::array<uint8_t, 5> header;
+  Encoder().newFrame(GRPC_FH_COMPRESSED, compressed.length(), header);
+  Buffer::InstancePtr body(new Buffer::OwnedImpl(header.data(), header.size()));
+  body->move(compressed);
+  return body;
+}
+
+Compressor::CompressorPtr Common::createGzipCompressor() {
+  std::unique_ptr<Compressor::ZlibCompressorImpl> compressor(new Compressor::ZlibCompressorImpl());
+  compressor->init(Compressor::ZlibCompressorImpl::CompressionLevel::Standard,
+                   Compressor::ZlibCompressorImpl::CompressionStrategy::Standard, 31, 8);
+  return std::move(compressor);
+}
+
+Buffer::InstancePtr Common::decompressBody(Buffer::Instance& data) {
+  Decompressor::ZlibDecompressorImpl decompressor;
+  decompressor.init(31);
+  Buffer::InstancePtr message(new Buffer::OwnedImpl());
+  decompressor.decompress(data, *message);
+  data.drain(data.length());
+  if (decompressor.failed() || !decompressor.finished()) {
+    return nullptr;
+  }
+  return message;
+}
+
 Http::MessagePtr Common::prepareHeaders(const std::string& upstream_cluster,
                                         const std::string& service_full_name,
                                         const std::string& method_name) {
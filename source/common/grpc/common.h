@@ -5,6 +5,7 @@
 
 #include "envoy/common/exception.h"
 #include "envoy/common/optional.h"
+#include "envoy/compressor/compressor.h"
 #include "envoy/grpc/status.h"
 #include "envoy/http/filter.h"
 #include "envoy/http/header_map.h"
@@ -112,6 +113,30 @@ public:
    */
   static Buffer::InstancePtr serializeBody(const Protobuf::Message& message);
 
+  /**
+   * Serialize protobuf message, compressing it when it is at least MIN_COMPRESSED_MESSAGE_SIZE
+   * bytes long.
+   * @param message supplies the message.
+   * @param compressor supplies a gzip compressor, which is reset for the next message.
+   */
+  static Buffer::InstancePtr serializeBody(const Protobuf::Message& message,
+                                           Compressor::Compressor& compressor);
+
+  /**
+   * @return Compressor::CompressorPtr a compressor for serializeBody().
+   */
+  static Compressor::CompressorPtr createGzipCompressor();
+
+  /**
+   * Decompress the data of a compressed message.
+   * @param data supplies the gzip data of the message, which is drained.
+   * @return Buffer::InstancePtr the message, or nullptr if the data is not a complete gzip stream.
+   */
+  static Buffer::InstancePtr decompressBody(Buffer::Instance& data);
+
+  // Smaller messages are sent uncompressed, the gzip framing costing more than it saves.
+  static const uint32_t MIN_COMPRESSED_MESSAGE_SIZE = 1024;
+
   /**
    * Prepare headers for protobuf service.
    */
@@ -101,9 +101,7 @@ Http::FilterDataStatus GrpcWebFilter::decodeData(Buffer::Instance& data, bool en
 
   const uint64_t needed = available / 4 * 4 - decoding_buffer_.length();
   decoding_buffer_.move(data, needed);
-  const std::string decoded = Base64::decode(
-      std::string(static_cast<const char*>(decoding_buffer_.linearize(decoding_buffer_.length())),
-                  decoding_buffer_.length()));
+  const std::string decoded = Base64::decode(decoding_buffer_);
   if (decoded.empty()) {
     // Error happened when decoding base64.
     Http::Utility::sendLocalReply(*decoder_callbacks_, stream_destroyed_, Http::Code::BadRequest,
@@ -165,7 +163,7 @@ Http::FilterDataStatus GrpcWebFilter::encodeData(Buffer::Instance& data, bool) {
     const uint32_t length = htonl(frame.length_);
     temp.add(&length, 4);
     if (frame.length_ > 0) {
-      temp.add(*frame.data_);
+      temp.move(*frame.data_);
     }
     data.add(Base64::encode(temp, temp.length()));
   }
@@ -255,6 +255,13 @@ Http::FilterDataStatus JsonTranscoderFilter::decodeData(Buffer::Instance& data,
 
     return Http::FilterDataStatus::StopIterationNoBuffer;
   }
+
+  // A request message which is not streamed is only output once the request is complete, so until
+  // then the transcoder holds all of it.
+  if (!end_stream && !method_->client_streaming() &&
+      decoderBufferLimitReached(request_in_.ByteCount() + request_in_.BytesAvailable())) {
+    return Http::FilterDataStatus::StopIterationNoBuffer;
+  }
   return Http::FilterDataStatus::Continue;
 }
 
@@ -317,12 +324,17 @@ Http::FilterDataStatus JsonTranscoderFilter::encodeData(Buffer::Instance& data,
 
   readToBuffer(*transcoder_->ResponseOutput(), data);
 
+  if (encoderBufferLimitReached(response_in_.BytesAvailable())) {
+    return Http::FilterDataStatus::StopIterationNoBuffer;
+  }
+
   if (!method_->server_streaming()) {
     // Buffer until the response is complete.
     return Http::FilterDataStatus::StopIterationAndBuffer;
   }
   // TODO(lizan): Check ResponseStatus
 
+  // Each message is sent on as soon as its frame is complete.
   return Http::FilterDataStatus::Continue;
 }
 
@@ -368,7 +380,6 @@ void JsonTranscoderFilter::setEncoderFilterCallbacks(
   encoder_callbacks_ = &callbacks;
 }
 
-// TODO(lizan): Incorporate watermarks to bound buffer sizes
 bool JsonTranscoderFilter::readToBuffer(Protobuf::io::ZeroCopyInputStream& stream,
                                         Buffer::Instance& data) {
   const void* out;
@@ -383,5 +394,34 @@ bool JsonTranscoderFilter::readToBuffer(Protobuf::io::ZeroCopyInputStream& strea
   return false;
 }
 
+bool JsonTranscoderFilter::decoderBufferLimitReached(uint64_t buffer_length) {
+  const uint32_t limit = decoder_callbacks_->decoderBufferLimit();
+  if (limit == 0 || buffer_length <= limit) {
+    return false;
+  }
+
+  ENVOY_LOG(debug, "Request rejected, transcoder buffer of {} bytes is over the limit of {}",
+            buffer_length, limit);
+  error_ = true;
+  Http::Utility::sendLocalReply(*decoder_callbacks_, stream_reset_, Http::Code::PayloadTooLarge,
+                                "Request message is too large to transcode");
+  return true;
+}
+
+bool JsonTranscoderFilter::encoderBufferLimitReached(uint64_t buffer_length) {
+  const uint32_t limit = encoder_callbacks_->encoderBufferLimit();
+  if (limit == 0 || buffer_length <= limit) {
+    return false;
+  }
+
+  // The response headers may already be gone for a streaming response, so there is no way to
+  // report the error to the client other than resetting the stream.
+  ENVOY_LOG(debug, "Response reset, transcoder buffer of {} bytes is over the limit of {}",
+            buffer_length, limit);
+  error_ = true;
+  encoder_callbacks_->resetStream();
+  return true;
+}
+
 } // namespace Grpc
 } // namespace Envoy
@@ -102,6 +102,16 @@ public:
 private:
   bool readToBuffer(Protobuf::io::ZeroCopyInputStream& stream, Buffer::Instance& data);
 
+  /**
+   * The transcoder holds partially received messages outside of the connection manager buffers,
+   * so they are bounded by the buffer limits here. A stream whose pending input exceeds the limit
+   * fails: the request with a 413 response, and the response with a reset.
+   * @param buffer_length supplies the number of bytes the transcoder holds.
+   * @return whether the limit was reached and the stream failed.
+   */
+  bool decoderBufferLimitReached(uint64_t buffer_length);
+  bool encoderBufferLimitReached(uint64_t buffer_length);
+
   JsonTranscoderConfig& config_;
   std::unique_ptr<google::grpc::transcoding::Transcoder> transcoder_;
   TranscoderInputStreamImpl request_in_;
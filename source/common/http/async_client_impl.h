@@ -142,6 +142,7 @@ private:
 
     // Router::RouteEntry
     const std::string& clusterName() const override { return cluster_name_; }
+    Optional<uint32_t> clusterHandle() const override { return Optional<uint32_t>(); }
     Http::Code clusterNotFoundResponseCode() const override {
       return Http::Code::InternalServerError;
     }
@@ -218,8 +219,12 @@ private:
   void encodeHeaders(HeaderMapPtr&& headers, bool end_stream) override;
   void encodeData(Buffer::Instance& data, bool end_stream) override;
   void encodeTrailers(HeaderMapPtr&& trailers) override;
-  void onDecoderFilterAboveWriteBufferHighWatermark() override {}
-  void onDecoderFilterBelowWriteBufferLowWatermark() override {}
+  void onDecoderFilterAboveWriteBufferHighWatermark() override {
+    stream_callbacks_.onAboveWriteBufferHighWatermark();
+  }
+  void onDecoderFilterBelowWriteBufferLowWatermark() override {
+    stream_callbacks_.onBelowWriteBufferLowWatermark();
+  }
   void addDownstreamWatermarkCallbacks(DownstreamWatermarkCallbacks&) override {}
   void removeDownstreamWatermarkCallbacks(DownstreamWatermarkCallbacks&) override {}
   void setDecoderBufferLimit(uint32_t) override {}
@@ -257,6 +262,8 @@ private:
   void onData(Buffer::Instance& data, bool end_stream) override;
   void onTrailers(HeaderMapPtr&& trailers) override;
   void onReset() override;
+  void onAboveWriteBufferHighWatermark() override {}
+  void onBelowWriteBufferLowWatermark() override {}
 
   // Http::StreamDecoderFilterCallbacks
   const Buffer::Instance* decodingBuffer() override { return request_->body().get(); }
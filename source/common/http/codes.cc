@@ -1,11 +1,13 @@
 #include "common/http/codes.h"
 
 #include <cstdint>
+#include <memory>
 #include <string>
 
 #include "envoy/http/header_map.h"
 #include "envoy/stats/stats.h"
 
+#include "common/common/assert.h"
 #include "common/common/enum_to_int.h"
 #include "common/common/utility.h"
 #include "common/http/headers.h"
@@ -16,6 +18,82 @@
 namespace Envoy {
 namespace Http {
 
+const uint64_t CodeStatsImpl::MIN_CODE;
+const uint64_t CodeStatsImpl::MAX_CODE;
+const size_t CodeStatsImpl::NUM_PREFIXES;
+const size_t CodeStatsImpl::NUM_CLASSES;
+const size_t CodeStatsImpl::CODES_PER_CLASS;
+
+CodeStatsImpl::~CodeStatsImpl() {
+  for (auto& classes : classes_) {
+    for (auto& class_counters : classes) {
+      delete class_counters.load();
+    }
+  }
+}
+
+Stats::Counter& CodeStatsImpl::codeCounter(Prefix prefix, Code code) {
+  const uint64_t value = enumToInt(code);
+  if (value < MIN_CODE || value > MAX_CODE) {
+    return scope_.counter(fmt::format("{}upstream_rq_{}", prefixString(prefix), value));
+  }
+
+  return counter(classCounters(prefix, value).codes_[value % CODES_PER_CLASS], prefix,
+                 std::to_string(value));
+}
+
+Stats::Counter& CodeStatsImpl::groupCounter(Prefix prefix, Code code) {
+  const uint64_t value = enumToInt(code);
+  if (value < MIN_CODE || value > MAX_CODE) {
+    return scope_.counter(fmt::format("{}upstream_rq_{}", prefixString(prefix),
+                                      CodeUtility::groupStringForResponseCode(code)));
+  }
+
+  return counter(classCounters(prefix, value).group_, prefix,
+                 CodeUtility::groupStringForResponseCode(code));
+}
+
+const char* CodeStatsImpl::prefixString(Prefix prefix) {
+  switch (prefix) {
+  case Prefix::None:
+    return "";
+  case Prefix::Canary:
+    return "canary.";
+  case Prefix::Internal:
+    return "internal.";
+  case Prefix::External:
+    return "external.";
+  case Prefix::Retry:
+    return "retry.";
+  }
+
+  NOT_REACHED;
+}
+
+CodeStatsImpl::ClassCounters& CodeStatsImpl::classCounters(Prefix prefix, uint64_t code) {
+  std::atomic<ClassCounters*>& slot = classes_[enumToInt(prefix)][code / CODES_PER_CLASS - 1];
+  ClassCounters* class_counters = slot.load(std::memory_order_acquire);
+  if (class_counters == nullptr) {
+    // A table allocated by a concurrent first use wins and ours is freed.
+    std::unique_ptr<ClassCounters> new_class_counters(new ClassCounters());
+    if (slot.compare_exchange_strong(class_counters, new_class_counters.get(),
+                                     std::memory_order_acq_rel)) {
+      class_counters = new_class_counters.release();
+    }
+  }
+  return *class_counters;
+}
+
+Stats::Counter& CodeStatsImpl::counter(std::atomic<Stats::Counter*>& slot, Prefix prefix,
+                                       const std::string& suffix) {
+  Stats::Counter* counter = slot.load(std::memory_order_acquire);
+  if (counter == nullptr) {
+    counter = &scope_.counter(fmt::format("{}upstream_rq_{}", prefixString(prefix), suffix));
+    slot.store(counter, std::memory_order_release);
+  }
+  return *counter;
+}
+
 void CodeUtility::chargeBasicResponseStat(Stats::Scope& scope, const std::string& prefix,
                                           Code response_code) {
   // Build a dynamic stat for the response code and increment it.
@@ -24,35 +102,61 @@ void CodeUtility::chargeBasicResponseStat(Stats::Scope& scope, const std::string
   scope.counter(fmt::format("{}upstream_rq_{}", prefix, enumToInt(response_code))).inc();
 }
 
+void CodeUtility::chargeBasicResponseStat(CodeStats& code_stats, CodeStats::Prefix prefix,
+                                          Code response_code) {
+  code_stats.groupCounter(prefix, response_code).inc();
+  code_stats.codeCounter(prefix, response_code).inc();
+}
+
 void CodeUtility::chargeResponseStat(const ResponseStatInfo& info) {
   const uint64_t response_code = info.response_status_code_;
-  chargeBasicResponseStat(info.cluster_scope_, info.prefix_, static_cast<Code>(response_code));
-
   std::string group_string = groupStringForResponseCode(static_cast<Code>(response_code));
 
-  // If the response is from a canary, also create canary stats.
-  if (info.upstream_canary_) {
-    info.cluster_scope_.counter(fmt::format("{}canary.upstream_rq_{}", info.prefix_, group_string))
-        .inc();
-    info.cluster_scope_.counter(fmt::format("{}canary.upstream_rq_{}", info.prefix_, response_code))
-        .inc();
-  }
+  if (info.cluster_code_stats_ != nullptr) {
+    ASSERT(info.prefix_.empty());
+    CodeStats& code_stats = *info.cluster_code_stats_;
+    const Code code = static_cast<Code>(response_code);
+    chargeBasicResponseStat(code_stats, CodeStats::Prefix::None, code);
 
-  // Split stats into external vs. internal.
-  if (info.internal_request_) {
-    info.cluster_scope_
-        .counter(fmt::format("{}internal.upstream_rq_{}", info.prefix_, group_string))
-        .inc();
-    info.cluster_scope_
-        .counter(fmt::format("{}internal.upstream_rq_{}", info.prefix_, response_code))
-        .inc();
+    // If the response is from a canary, also charge canary stats.
+    if (info.upstream_canary_) {
+      chargeBasicResponseStat(code_stats, CodeStats::Prefix::Canary, code);
+    }
+
+    // Split stats into external vs. internal.
+    chargeBasicResponseStat(code_stats,
+                            info.internal_request_ ? CodeStats::Prefix::Internal
+                                                   : CodeStats::Prefix::External,
+                            code);
   } else {
-    info.cluster_scope_
-        .counter(fmt::format("{}external.upstream_rq_{}", info.prefix_, group_string))
-        .inc();
-    info.cluster_scope_
-        .counter(fmt::format("{}external.upstream_rq_{}", info.prefix_, response_code))
-        .inc();
+    chargeBasicResponseStat(info.cluster_scope_, info.prefix_, static_cast<Code>(response_code));
+
+    // If the response is from a canary, also create canary stats.
+    if (info.upstream_canary_) {
+      info.cluster_scope_
+          .counter(fmt::format("{}canary.upstream_rq_{}", info.prefix_, group_string))
+          .inc();
+      info.cluster_scope_
+          .counter(fmt::format("{}canary.upstream_rq_{}", info.prefix_, response_code))
+          .inc();
+    }
+
+    // Split stats into external vs. internal.
+    if (info.internal_request_) {
+      info.cluster_scope_
+          .counter(fmt::format("{}internal.upstream_rq_{}", info.prefix_, group_string))
+          .inc();
+      info.cluster_scope_
+          .counter(fmt::format("{}internal.upstream_rq_{}", info.prefix_, response_code))
+          .inc();
+    } else {
+      info.cluster_scope_
+          .counter(fmt::format("{}external.upstream_rq_{}", info.prefix_, group_string))
+          .inc();
+      info.cluster_scope_
+          .counter(fmt::format("{}external.upstream_rq_{}", info.prefix_, response_code))
+          .inc();
+    }
   }
 
   // Handle request virtual cluster.
@@ -177,6 +281,7 @@ const char* CodeUtility::toString(Code code) {
   case Code::UnprocessableEntity:           return "Unprocessable Entity";
   case Code::Locked:                        return "Locked";
   case Code::FailedDependency:              return "Failed Dependency";
+  case Code::TooEarly:                      return "Too Early";
   case Code::UpgradeRequired:               return "Upgrade Required";
   case Code::PreconditionRequired:          return "Precondition Required";
   case Code::TooManyRequests:               return "Too Many Requests";
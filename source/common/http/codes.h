@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <string>
@@ -11,6 +13,43 @@
 namespace Envoy {
 namespace Http {
 
+/**
+ * Response code stats of a scope, whose counters are looked up in tables indexed by the class and
+ * the value of the response code. The table of a class is allocated when one of its codes is first
+ * charged, and its counters when they are first used. Filling the tables isn't synchronized, as
+ * concurrent first uses are given the same counter by the scope. Codes outside of 100-599 aren't
+ * kept in the tables and are looked up by name.
+ */
+class CodeStatsImpl : public CodeStats {
+public:
+  CodeStatsImpl(Stats::Scope& scope) : scope_(scope) {}
+  ~CodeStatsImpl();
+
+  // Http::CodeStats
+  Stats::Counter& codeCounter(Prefix prefix, Code code) override;
+  Stats::Counter& groupCounter(Prefix prefix, Code code) override;
+
+private:
+  static const uint64_t MIN_CODE = 100;
+  static const uint64_t MAX_CODE = 599;
+  static const size_t NUM_PREFIXES = 5;
+  static const size_t NUM_CLASSES = 5;
+  static const size_t CODES_PER_CLASS = 100;
+
+  struct ClassCounters {
+    std::atomic<Stats::Counter*> group_{};
+    std::array<std::atomic<Stats::Counter*>, CODES_PER_CLASS> codes_{};
+  };
+
+  static const char* prefixString(Prefix prefix);
+  ClassCounters& classCounters(Prefix prefix, uint64_t code);
+  Stats::Counter& counter(std::atomic<Stats::Counter*>& slot, Prefix prefix,
+                          const std::string& suffix);
+
+  Stats::Scope& scope_;
+  std::array<std::array<std::atomic<ClassCounters*>, NUM_CLASSES>, NUM_PREFIXES> classes_{};
+};
+
 /**
  * General utility routines for HTTP codes.
  */
@@ -22,6 +61,12 @@ public:
   static void chargeBasicResponseStat(Stats::Scope& scope, const std::string& prefix,
                                       Code response_code);
 
+  /**
+   * Charge a simple response stat to an upstream through its pre-resolved response code stats.
+   */
+  static void chargeBasicResponseStat(CodeStats& code_stats, CodeStats::Prefix prefix,
+                                      Code response_code);
+
   struct ResponseStatInfo {
     Stats::Scope& global_scope_;
     Stats::Scope& cluster_scope_;
@@ -33,6 +78,9 @@ public:
     const std::string& from_zone_;
     const std::string& to_zone_;
     bool upstream_canary_;
+    // The response code stats of cluster_scope_, through which the cluster stats are charged if
+    // set. Only used when prefix_ is empty.
+    CodeStats* cluster_code_stats_;
   };
 
   /**
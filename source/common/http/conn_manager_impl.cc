@@ -58,12 +58,14 @@ ConnectionManagerImpl::ConnectionManagerImpl(ConnectionManagerConfig& config,
                                              Runtime::RandomGenerator& random_generator,
                                              Tracing::HttpTracer& tracer, Runtime::Loader& runtime,
                                              const LocalInfo::LocalInfo& local_info,
-                                             Upstream::ClusterManager& cluster_manager)
+                                             Upstream::ClusterManager& cluster_manager,
+                                             Server::OverloadManager& overload_manager)
     : config_(config), stats_(config_.stats()),
       conn_length_(new Stats::Timespan(stats_.named_.downstream_cx_length_ms_)),
       drain_close_(drain_close), random_generator_(random_generator), tracer_(tracer),
       runtime_(runtime), local_info_(local_info), cluster_manager_(cluster_manager),
-      listener_stats_(config_.listenerStats()) {}
+      overload_manager_(overload_manager), listener_stats_(config_.listenerStats()),
+      route_cache_size_(runtime_.snapshot().getInteger("http.route_cache_size", 0)) {}
 
 void ConnectionManagerImpl::initializeReadFilterCallbacks(Network::ReadFilterCallbacks& callbacks) {
   read_callbacks_ = &callbacks;
@@ -77,7 +79,7 @@ void ConnectionManagerImpl::initializeReadFilterCallbacks(Network::ReadFilterCal
   read_callbacks_->connection().addConnectionCallbacks(*this);
 
   if (config_.idleTimeout().valid()) {
-    idle_timer_ = read_callbacks_->connection().dispatcher().createTimer(
+    idle_timer_ = read_callbacks_->connection().dispatcher().createCoarseTimer(
         [this]() -> void { onIdleTimeout(); });
     idle_timer_->enableTimer(config_.idleTimeout().value());
   }
@@ -85,7 +87,8 @@ void ConnectionManagerImpl::initializeReadFilterCallbacks(Network::ReadFilterCal
   read_callbacks_->connection().setConnectionStats(
       {stats_.named_.downstream_cx_rx_bytes_total_, stats_.named_.downstream_cx_rx_bytes_buffered_,
        stats_.named_.downstream_cx_tx_bytes_total_, stats_.named_.downstream_cx_tx_bytes_buffered_,
-       nullptr});
+       nullptr, &stats_.named_.downstream_cx_rx_syscalls_total_,
+       &stats_.named_.downstream_cx_tx_syscalls_total_});
 }
 
 ConnectionManagerImpl::~ConnectionManagerImpl() {
@@ -95,8 +98,8 @@ ConnectionManagerImpl::~ConnectionManagerImpl() {
     stats_.named_.downstream_cx_ssl_active_.dec();
   }
 
-  if (codec_) {
-    if (codec_->protocol() == Protocol::Http2) {
+  if (codec_ || codec_released_) {
+    if (codec_ && codec_->protocol() == Protocol::Http2) {
       stats_.named_.downstream_cx_http2_active_.dec();
     } else {
       if (isWebSocketConnection()) {
@@ -112,7 +115,8 @@ ConnectionManagerImpl::~ConnectionManagerImpl() {
 }
 
 void ConnectionManagerImpl::checkForDeferredClose() {
-  if (drain_state_ == DrainState::Closing && streams_.empty() && !codec_->wantsToWrite()) {
+  if (drain_state_ == DrainState::Closing && streams_.empty() &&
+      (!codec_ || !codec_->wantsToWrite())) {
     read_callbacks_->connection().close(Network::ConnectionCloseType::FlushWrite);
   }
 }
@@ -155,6 +159,24 @@ void ConnectionManagerImpl::doEndStream(ActiveStream& stream) {
   if (idle_timer_ && streams_.empty()) {
     idle_timer_->enableTimer(config_.idleTimeout().value());
   }
+
+  if (!codec_dispatching_) {
+    maybeReleaseIdleCodec();
+  }
+}
+
+void ConnectionManagerImpl::maybeReleaseIdleCodec() {
+  // Keep-alive HTTP/1 connections spend most of their life waiting for the next request, while the
+  // codec holds parser and header buffers which are only needed once it arrives.
+  if (!codec_ || !streams_.empty() || drain_state_ != DrainState::NotDraining ||
+      !codec_->idle() || !runtime_.snapshot().featureEnabled("http.http1.release_idle_codec", 0)) {
+    return;
+  }
+
+  ENVOY_CONN_LOG(trace, "releasing idle codec", read_callbacks_->connection());
+  codec_.reset();
+  codec_released_ = true;
+  stats_.named_.downstream_cx_idle_codec_released_.inc();
 }
 
 void ConnectionManagerImpl::doDeferredStreamDestroy(ActiveStream& stream) {
@@ -204,7 +226,15 @@ Network::FilterStatus ConnectionManagerImpl::onData(Buffer::Instance& data) {
 
   if (!codec_) {
     codec_ = config_.createCodec(read_callbacks_->connection(), data, *this);
-    if (codec_->protocol() == Protocol::Http2) {
+    if (codec_released_) {
+      // The connection was counted when its first codec was created, as HTTP/1.
+      codec_released_ = false;
+      if (codec_->protocol() == Protocol::Http2) {
+        stats_.named_.downstream_cx_http1_active_.dec();
+        stats_.named_.downstream_cx_http2_total_.inc();
+        stats_.named_.downstream_cx_http2_active_.inc();
+      }
+    } else if (codec_->protocol() == Protocol::Http2) {
       stats_.named_.downstream_cx_http2_total_.inc();
       stats_.named_.downstream_cx_http2_active_.inc();
     } else {
@@ -218,8 +248,11 @@ Network::FilterStatus ConnectionManagerImpl::onData(Buffer::Instance& data) {
     redispatch = false;
 
     try {
+      codec_dispatching_ = true;
       codec_->dispatch(data);
+      codec_dispatching_ = false;
     } catch (const CodecProtocolException& e) {
+      codec_dispatching_ = false;
       // HTTP/1.1 codec has already sent a 400 response if possible. HTTP/2 codec has already sent
       // GOAWAY.
       ENVOY_CONN_LOG(debug, "dispatch error: {}", read_callbacks_->connection(), e.what());
@@ -254,6 +287,7 @@ Network::FilterStatus ConnectionManagerImpl::onData(Buffer::Instance& data) {
     }
   } while (redispatch);
 
+  maybeReleaseIdleCodec();
   return Network::FilterStatus::StopIteration;
 }
 
@@ -317,11 +351,61 @@ void ConnectionManagerImpl::onIdleTimeout() {
 
 void ConnectionManagerImpl::onDrainTimeout() {
   ASSERT(drain_state_ != DrainState::NotDraining);
-  codec_->goAway();
+  if (codec_) {
+    codec_->goAway();
+  }
   drain_state_ = DrainState::Closing;
   checkForDeferredClose();
 }
 
+Router::RouteConstSharedPtr
+ConnectionManagerImpl::route(const Router::ConfigConstSharedPtr& route_config,
+                             const HeaderMap& headers, uint64_t random_value) {
+  const std::vector<LowerCaseString>* key_headers =
+      route_cache_size_ > 0 ? route_config->routeKeyHeaders() : nullptr;
+  if (key_headers == nullptr || headers.Host() == nullptr || headers.Path() == nullptr) {
+    return route_config->route(headers, random_value);
+  }
+
+  // The routes are dropped once the streams have snapped a new configuration.
+  if (route_config != route_cache_config_) {
+    route_cache_config_ = route_config;
+    route_cache_.clear();
+    route_cache_next_ = 0;
+  }
+
+  // Header values have no NUL, which separates the values of the key. An absent header is
+  // distinguished from an empty one by the character preceding the value.
+  route_cache_key_.assign(headers.Host()->value().c_str(), headers.Host()->value().size());
+  route_cache_key_.push_back('\0');
+  route_cache_key_.append(headers.Path()->value().c_str(), headers.Path()->value().size());
+  for (const LowerCaseString& key_header : *key_headers) {
+    const HeaderEntry* header = headers.get(key_header);
+    route_cache_key_.push_back('\0');
+    if (header != nullptr) {
+      route_cache_key_.push_back('=');
+      route_cache_key_.append(header->value().c_str(), header->value().size());
+    }
+  }
+
+  for (const RouteCacheEntry& entry : route_cache_) {
+    if (entry.key_ == route_cache_key_) {
+      stats_.named_.downstream_rq_route_cache_hit_.inc();
+      return entry.route_;
+    }
+  }
+
+  Router::RouteConstSharedPtr route = route_config->route(headers, random_value);
+  if (route_cache_.size() < route_cache_size_) {
+    route_cache_.push_back({route_cache_key_, route});
+  } else {
+    route_cache_[route_cache_next_].key_ = route_cache_key_;
+    route_cache_[route_cache_next_].route_ = route;
+    route_cache_next_ = (route_cache_next_ + 1) % route_cache_.size();
+  }
+  return route;
+}
+
 void ConnectionManagerImpl::chargeTracingStats(const Tracing::Reason& tracing_reason,
                                                ConnectionManagerTracingStats& tracing_stats) {
   switch (tracing_reason) {
@@ -347,8 +431,18 @@ ConnectionManagerImpl::ActiveStream::ActiveStream(ConnectionManagerImpl& connect
     : connection_manager_(connection_manager),
       snapped_route_config_(connection_manager.config_.routeConfigProvider().config()),
       stream_id_(connection_manager.random_generator_.random()),
-      request_timer_(new Stats::Timespan(connection_manager_.stats_.named_.downstream_rq_time_)),
-      request_info_(connection_manager_.codec_->protocol()) {
+      request_timer_(new Stats::Timespan(connection_manager_.stats_.named_.downstream_rq_time_,
+                                         connection_manager_.read_callbacks_->connection()
+                                             .dispatcher()
+                                             .approximateMonotonicTime())),
+      request_info_(
+          connection_manager_.codec_->protocol(),
+          connection_manager_.read_callbacks_->connection().dispatcher().approximateSystemTime(),
+          connection_manager_.read_callbacks_->connection()
+              .dispatcher()
+              .approximateMonotonicTime()),
+      filter_timing_(connection_manager_.runtime_.snapshot().featureEnabled(
+          "http.filter_timing.enabled", 0)) {
   connection_manager_.stats_.named_.downstream_rq_total_.inc();
   connection_manager_.stats_.named_.downstream_rq_active_.inc();
   if (connection_manager_.codec_->protocol() == Protocol::Http2) {
@@ -360,6 +454,9 @@ ConnectionManagerImpl::ActiveStream::ActiveStream(ConnectionManagerImpl& connect
 
 ConnectionManagerImpl::ActiveStream::~ActiveStream() {
   connection_manager_.stats_.named_.downstream_rq_active_.dec();
+  if (filter_timing_) {
+    recordFilterTimings();
+  }
   for (const AccessLog::InstanceSharedPtr& access_log : connection_manager_.config_.accessLogs()) {
     access_log->log(request_headers_.get(), response_headers_.get(), request_info_);
   }
@@ -380,6 +477,11 @@ ConnectionManagerImpl::ActiveStream::~ActiveStream() {
 void ConnectionManagerImpl::ActiveStream::addStreamDecoderFilterWorker(
     StreamDecoderFilterSharedPtr filter, bool dual_filter) {
   ActiveStreamDecoderFilterPtr wrapper(new ActiveStreamDecoderFilter(*this, filter, dual_filter));
+  // The encoder half of a dual filter is added next, and takes the same index.
+  wrapper->index_ = dual_filter ? next_filter_index_ : next_filter_index_++;
+  if (filter_timing_) {
+    wrapper->timing_.reset(new ActiveStreamFilterBase::Timing());
+  }
   filter->setDecoderFilterCallbacks(*wrapper);
   wrapper->moveIntoListBack(std::move(wrapper), decoder_filters_);
 }
@@ -387,10 +489,24 @@ void ConnectionManagerImpl::ActiveStream::addStreamDecoderFilterWorker(
 void ConnectionManagerImpl::ActiveStream::addStreamEncoderFilterWorker(
     StreamEncoderFilterSharedPtr filter, bool dual_filter) {
   ActiveStreamEncoderFilterPtr wrapper(new ActiveStreamEncoderFilter(*this, filter, dual_filter));
+  wrapper->index_ = next_filter_index_++;
+  if (filter_timing_) {
+    wrapper->timing_.reset(new ActiveStreamFilterBase::Timing());
+  }
   filter->setEncoderFilterCallbacks(*wrapper);
   wrapper->moveIntoListBack(std::move(wrapper), encoder_filters_);
 }
 
+void ConnectionManagerImpl::ActiveStream::recordFilterTimings() {
+  std::string& timings = request_info_.filter_timings_;
+  for (const auto& filter : decoder_filters_) {
+    filter->recordTiming("decoder", timings);
+  }
+  for (const auto& filter : encoder_filters_) {
+    filter->recordTiming("encoder", timings);
+  }
+}
+
 void ConnectionManagerImpl::ActiveStream::addAccessLogHandler(
     AccessLog::InstanceSharedPtr handler) {
   access_log_handlers_.push_back(handler);
@@ -450,6 +566,16 @@ void ConnectionManagerImpl::ActiveStream::decodeHeaders(HeaderMapPtr&& headers,
   connection_manager_.user_agent_.initializeFromHeaders(
       *request_headers_, connection_manager_.stats_.prefix_, connection_manager_.stats_.scope_);
 
+  // Shed the request before doing any work for it if the server is overloaded.
+  if (connection_manager_.overload_manager_.isActive(
+          Server::OverloadActionType::StopAcceptingRequests)) {
+    connection_manager_.stats_.named_.downstream_rq_overload_reject_.inc();
+    HeaderMapImpl headers{
+        {Headers::get().Status, std::to_string(enumToInt(Code::ServiceUnavailable))}};
+    encodeHeaders(nullptr, headers, true);
+    return;
+  }
+
   // Make sure we are getting a codec version we support.
   Protocol protocol = connection_manager_.codec_->protocol();
   if (protocol == Protocol::Http10) {
@@ -501,13 +627,28 @@ void ConnectionManagerImpl::ActiveStream::decodeHeaders(HeaderMapPtr&& headers,
     state_.saw_connection_close_ = true;
   }
 
+  // Requests read from TLS 1.3 early data may be replays, so only idempotent ones are accepted.
+  // They are marked for routes and upstreams, which may still ask for them to be sent again once
+  // the handshake has completed. https://tools.ietf.org/html/rfc8470
+  const Ssl::Connection* ssl = connection_manager_.read_callbacks_->connection().ssl();
+  if (ssl != nullptr && ssl->lastReadEarlyData()) {
+    if (!Utility::isIdempotentRequest(*request_headers_)) {
+      connection_manager_.stats_.named_.downstream_rq_too_early_.inc();
+      HeaderMapImpl headers{{Headers::get().Status, std::to_string(enumToInt(Code::TooEarly))}};
+      encodeHeaders(nullptr, headers, true);
+      return;
+    }
+    request_headers_->setReference(Headers::get().EarlyData, Headers::get().EarlyDataValues.True);
+  }
+
   ConnectionManagerUtility::mutateRequestHeaders(
       *request_headers_, protocol, connection_manager_.read_callbacks_->connection(),
       connection_manager_.config_, *snapped_route_config_, connection_manager_.random_generator_,
       connection_manager_.runtime_, connection_manager_.local_info_);
 
   ASSERT(!cached_route_.valid());
-  cached_route_.value(snapped_route_config_->route(*request_headers_, stream_id_));
+  cached_route_.value(
+      connection_manager_.route(snapped_route_config_, *request_headers_, stream_id_));
 
   // Check for WebSocket upgrade request if the route exists, and supports WebSockets.
   // TODO if there are no filters when starting a filter iteration, the connection manager
@@ -522,7 +663,9 @@ void ConnectionManagerImpl::ActiveStream::decodeHeaders(HeaderMapPtr&& headers,
 
       connection_manager_.ws_connection_.reset(new WebSocket::WsHandlerImpl(
           *request_headers_, request_info_, *route_entry, *this,
-          connection_manager_.cluster_manager_, connection_manager_.read_callbacks_));
+          connection_manager_.cluster_manager_, connection_manager_.read_callbacks_,
+          connection_manager_.runtime_.snapshot().featureEnabled(
+              "http_connection_manager.websocket_splice_enabled", 0)));
       connection_manager_.ws_connection_->onNewConnection();
       connection_manager_.stats_.named_.downstream_cx_websocket_active_.inc();
       connection_manager_.stats_.named_.downstream_cx_http1_active_.dec();
@@ -615,8 +758,10 @@ void ConnectionManagerImpl::ActiveStream::decodeHeaders(ActiveStreamDecoderFilte
   for (; entry != decoder_filters_.end(); entry++) {
     ASSERT(!(state_.filter_call_state_ & FilterCallState::DecodeHeaders));
     state_.filter_call_state_ |= FilterCallState::DecodeHeaders;
-    FilterHeadersStatus status = (*entry)->handle_->decodeHeaders(
-        headers, end_stream && continue_data_entry == decoder_filters_.end());
+    FilterHeadersStatus status = (*entry)->timedCallback([&]() -> FilterHeadersStatus {
+      return (*entry)->handle_->decodeHeaders(
+          headers, end_stream && continue_data_entry == decoder_filters_.end());
+    });
     state_.filter_call_state_ &= ~FilterCallState::DecodeHeaders;
     ENVOY_STREAM_LOG(trace, "decode headers called: filter={} status={}", *this,
                      static_cast<const void*>((*entry).get()), static_cast<uint64_t>(status));
@@ -673,7 +818,8 @@ void ConnectionManagerImpl::ActiveStream::decodeData(ActiveStreamDecoderFilter*
   for (; entry != decoder_filters_.end(); entry++) {
     ASSERT(!(state_.filter_call_state_ & FilterCallState::DecodeData));
     state_.filter_call_state_ |= FilterCallState::DecodeData;
-    FilterDataStatus status = (*entry)->handle_->decodeData(data, end_stream);
+    FilterDataStatus status = (*entry)->timedCallback(
+        [&]() -> FilterDataStatus { return (*entry)->handle_->decodeData(data, end_stream); });
     state_.filter_call_state_ &= ~FilterCallState::DecodeData;
     ENVOY_STREAM_LOG(trace, "decode data called: filter={} status={}", *this,
                      static_cast<const void*>((*entry).get()), static_cast<uint64_t>(status));
@@ -728,7 +874,8 @@ void ConnectionManagerImpl::ActiveStream::decodeTrailers(ActiveStreamDecoderFilt
   for (; entry != decoder_filters_.end(); entry++) {
     ASSERT(!(state_.filter_call_state_ & FilterCallState::DecodeTrailers));
     state_.filter_call_state_ |= FilterCallState::DecodeTrailers;
-    FilterTrailersStatus status = (*entry)->handle_->decodeTrailers(trailers);
+    FilterTrailersStatus status = (*entry)->timedCallback(
+        [&]() -> FilterTrailersStatus { return (*entry)->handle_->decodeTrailers(trailers); });
     state_.filter_call_state_ &= ~FilterCallState::DecodeTrailers;
     ENVOY_STREAM_LOG(trace, "decode trailers called: filter={} status={}", *this,
                      static_cast<const void*>((*entry).get()), static_cast<uint64_t>(status));
@@ -758,7 +905,9 @@ ConnectionManagerImpl::ActiveStream::commonEncodePrefix(ActiveStreamEncoderFilte
 void ConnectionManagerImpl::startDrainSequence() {
   ASSERT(drain_state_ == DrainState::NotDraining);
   drain_state_ = DrainState::Draining;
-  codec_->shutdownNotice();
+  if (codec_) {
+    codec_->shutdownNotice();
+  }
   drain_timer_ = read_callbacks_->connection().dispatcher().createTimer(
       [this]() -> void { onDrainTimeout(); });
   drain_timer_->enableTimer(config_.drainTimeout());
@@ -772,8 +921,10 @@ void ConnectionManagerImpl::ActiveStream::encodeHeaders(ActiveStreamEncoderFilte
   for (; entry != encoder_filters_.end(); entry++) {
     ASSERT(!(state_.filter_call_state_ & FilterCallState::EncodeHeaders));
     state_.filter_call_state_ |= FilterCallState::EncodeHeaders;
-    FilterHeadersStatus status = (*entry)->handle_->encodeHeaders(
-        headers, end_stream && continue_data_entry == encoder_filters_.end());
+    FilterHeadersStatus status = (*entry)->timedCallback([&]() -> FilterHeadersStatus {
+      return (*entry)->handle_->encodeHeaders(
+          headers, end_stream && continue_data_entry == encoder_filters_.end());
+    });
     state_.filter_call_state_ &= ~FilterCallState::EncodeHeaders;
     ENVOY_STREAM_LOG(trace, "encode headers called: filter={} status={}", *this,
                      static_cast<const void*>((*entry).get()), static_cast<uint64_t>(status));
@@ -795,9 +946,11 @@ void ConnectionManagerImpl::ActiveStream::encodeHeaders(ActiveStreamEncoderFilte
   ConnectionManagerUtility::mutateResponseHeaders(headers, *request_headers_);
 
   // See if we want to drain/close the connection. Send the go away frame prior to encoding the
-  // header block.
+  // header block. Keep alive is disabled under overload by draining the same way.
   if (connection_manager_.drain_state_ == DrainState::NotDraining &&
-      connection_manager_.drain_close_.drainClose()) {
+      (connection_manager_.drain_close_.drainClose() ||
+       connection_manager_.overload_manager_.isActive(
+           Server::OverloadActionType::DisableHttpKeepAlive))) {
 
     // This doesn't really do anything for HTTP/1.1 other then give the connection another boost
     // of time to race with incoming requests. It mainly just keeps the logic the same between
@@ -909,7 +1062,8 @@ void ConnectionManagerImpl::ActiveStream::encodeData(ActiveStreamEncoderFilter*
   for (; entry != encoder_filters_.end(); entry++) {
     ASSERT(!(state_.filter_call_state_ & FilterCallState::EncodeData));
     state_.filter_call_state_ |= FilterCallState::EncodeData;
-    FilterDataStatus status = (*entry)->handle_->encodeData(data, end_stream);
+    FilterDataStatus status = (*entry)->timedCallback(
+        [&]() -> FilterDataStatus { return (*entry)->handle_->encodeData(data, end_stream); });
     state_.filter_call_state_ &= ~FilterCallState::EncodeData;
     ENVOY_STREAM_LOG(trace, "encode data called: filter={} status={}", *this,
                      static_cast<const void*>((*entry).get()), static_cast<uint64_t>(status));
@@ -932,7 +1086,8 @@ void ConnectionManagerImpl::ActiveStream::encodeTrailers(ActiveStreamEncoderFilt
   for (; entry != encoder_filters_.end(); entry++) {
     ASSERT(!(state_.filter_call_state_ & FilterCallState::EncodeTrailers));
     state_.filter_call_state_ |= FilterCallState::EncodeTrailers;
-    FilterTrailersStatus status = (*entry)->handle_->encodeTrailers(trailers);
+    FilterTrailersStatus status = (*entry)->timedCallback(
+        [&]() -> FilterTrailersStatus { return (*entry)->handle_->encodeTrailers(trailers); });
     state_.filter_call_state_ &= ~FilterCallState::EncodeTrailers;
     ENVOY_STREAM_LOG(trace, "encode trailers called: filter={} status={}", *this,
                      static_cast<const void*>((*entry).get()), static_cast<uint64_t>(status));
@@ -1029,6 +1184,7 @@ void ConnectionManagerImpl::ActiveStreamFilterBase::commonContinue() {
                    static_cast<const void*>(this));
   ASSERT(stopped_);
   stopped_ = false;
+  onIterationResumed();
 
   // Make sure that we handle the zero byte data frame case. We make no effort to optimize this
   // case in terms of merging it into a header only request/response. This could be done in the
@@ -1057,6 +1213,7 @@ bool ConnectionManagerImpl::ActiveStreamFilterBase::commonHandleAfterHeadersCall
 
   if (status == FilterHeadersStatus::StopIteration) {
     stopped_ = true;
+    onIterationHeld();
     return false;
   } else {
     ASSERT(status == FilterHeadersStatus::Continue);
@@ -1095,6 +1252,7 @@ bool ConnectionManagerImpl::ActiveStreamFilterBase::commonHandleAfterDataCallbac
     }
   } else {
     stopped_ = true;
+    onIterationHeld();
     if (status == FilterDataStatus::StopIterationAndBuffer ||
         status == FilterDataStatus::StopIterationAndWatermark) {
       buffer_was_streaming = status == FilterDataStatus::StopIterationAndWatermark;
@@ -1118,12 +1276,46 @@ bool ConnectionManagerImpl::ActiveStreamFilterBase::commonHandleAfterTrailersCal
       ASSERT(headers_continued_);
     }
   } else {
+    onIterationHeld();
     return false;
   }
 
   return true;
 }
 
+void ConnectionManagerImpl::ActiveStreamFilterBase::onIterationHeld() {
+  if (timing_ != nullptr && !timing_->held_since_.valid()) {
+    timing_->held_since_.value(std::chrono::steady_clock::now());
+  }
+}
+
+void ConnectionManagerImpl::ActiveStreamFilterBase::onIterationResumed() {
+  if (timing_ != nullptr && timing_->held_since_.valid()) {
+    timing_->held_time_ += std::chrono::steady_clock::now() - timing_->held_since_.value();
+    timing_->held_since_ = Optional<MonotonicTime>();
+  }
+}
+
+void ConnectionManagerImpl::ActiveStreamFilterBase::recordTiming(const std::string& direction,
+                                                                 std::string& timings) {
+  // A filter still holding iteration, e.g. when the stream is reset, held it until now.
+  onIterationResumed();
+  const uint64_t callback_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(timing_->callback_time_).count();
+  const uint64_t held_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(timing_->held_time_).count();
+
+  const ConnectionManagerStats& stats = parent_.connection_manager_.stats_;
+  const std::string prefix = fmt::format("{}filter.{}.{}.", stats.prefix_, index_, direction);
+  stats.scope_.histogram(prefix + "callback_us").recordValue(callback_us);
+  stats.scope_.histogram(prefix + "held_us").recordValue(held_us);
+
+  if (!timings.empty()) {
+    timings += ',';
+  }
+  timings += fmt::format("{}{}:{}:{}", direction[0], index_, callback_us, held_us);
+}
+
 const Network::Connection* ConnectionManagerImpl::ActiveStreamFilterBase::connection() {
   return parent_.connection();
 }
@@ -1148,8 +1340,8 @@ Tracing::Config& ConnectionManagerImpl::ActiveStreamFilterBase::tracingConfig()
 
 Router::RouteConstSharedPtr ConnectionManagerImpl::ActiveStreamFilterBase::route() {
   if (!parent_.cached_route_.valid()) {
-    parent_.cached_route_.value(
-        parent_.snapped_route_config_->route(*parent_.request_headers_, parent_.stream_id_));
+    parent_.cached_route_.value(parent_.connection_manager_.route(
+        parent_.snapped_route_config_, *parent_.request_headers_, parent_.stream_id_));
   }
 
   return parent_.cached_route_.value();
@@ -1164,6 +1356,8 @@ Buffer::WatermarkBufferPtr ConnectionManagerImpl::ActiveStreamDecoderFilter::cre
       new Buffer::WatermarkBuffer([this]() -> void { this->requestDataDrained(); },
                                   [this]() -> void { this->requestDataTooLarge(); })};
   buffer->setWatermarks(parent_.buffer_limit_);
+  // Bodies held by the filters are charged to the listener along with the connection's buffers.
+  buffer->setAccount(connection()->bufferAccount());
   return buffer;
 }
 
@@ -1243,6 +1437,7 @@ Buffer::WatermarkBufferPtr ConnectionManagerImpl::ActiveStreamEncoderFilter::cre
   auto buffer = new Buffer::WatermarkBuffer([this]() -> void { this->responseDataDrained(); },
                                             [this]() -> void { this->responseDataTooLarge(); });
   buffer->setWatermarks(parent_.buffer_limit_);
+  buffer->setAccount(connection()->bufferAccount());
   return Buffer::WatermarkBufferPtr{buffer};
 }
 
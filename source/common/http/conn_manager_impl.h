@@ -18,6 +18,7 @@
 #include "envoy/network/filter.h"
 #include "envoy/router/rds.h"
 #include "envoy/runtime/runtime.h"
+#include "envoy/server/overload_manager.h"
 #include "envoy/ssl/connection.h"
 #include "envoy/stats/stats_macros.h"
 #include "envoy/tracing/http_tracer.h"
@@ -26,6 +27,7 @@
 #include "common/access_log/request_info_impl.h"
 #include "common/buffer/watermark_buffer.h"
 #include "common/common/linked_object.h"
+#include "common/common/slab_allocator.h"
 #include "common/http/date_provider.h"
 #include "common/http/user_agent.h"
 #include "common/http/websocket/ws_handler_impl.h"
@@ -59,10 +61,13 @@ namespace Http {
   HISTOGRAM(downstream_cx_length_ms)                                                               \
   COUNTER  (downstream_cx_rx_bytes_total)                                                          \
   GAUGE    (downstream_cx_rx_bytes_buffered)                                                       \
+  COUNTER  (downstream_cx_rx_syscalls_total)                                                       \
   COUNTER  (downstream_cx_tx_bytes_total)                                                          \
   GAUGE    (downstream_cx_tx_bytes_buffered)                                                       \
+  COUNTER  (downstream_cx_tx_syscalls_total)                                                       \
   COUNTER  (downstream_cx_drain_close)                                                             \
   COUNTER  (downstream_cx_idle_timeout)                                                            \
+  COUNTER  (downstream_cx_idle_codec_released)                                                     \
   COUNTER  (downstream_flow_control_paused_reading_total)                                          \
   COUNTER  (downstream_flow_control_resumed_reading_total)                                         \
   COUNTER  (downstream_rq_total)                                                                   \
@@ -75,6 +80,9 @@ namespace Http {
   COUNTER  (downstream_rq_non_relative_path)                                                       \
   COUNTER  (downstream_rq_ws_on_non_ws_route)                                                      \
   COUNTER  (downstream_rq_too_large)                                                               \
+  COUNTER  (downstream_rq_overload_reject)                                                         \
+  COUNTER  (downstream_rq_too_early)                                                               \
+  COUNTER  (downstream_rq_route_cache_hit)                                                         \
   COUNTER  (downstream_rq_2xx)                                                                     \
   COUNTER  (downstream_rq_3xx)                                                                     \
   COUNTER  (downstream_rq_4xx)                                                                     \
@@ -290,7 +298,8 @@ public:
   ConnectionManagerImpl(ConnectionManagerConfig& config, const Network::DrainDecision& drain_close,
                         Runtime::RandomGenerator& random_generator, Tracing::HttpTracer& tracer,
                         Runtime::Loader& runtime, const LocalInfo::LocalInfo& local_info,
-                        Upstream::ClusterManager& cluster_manager);
+                        Upstream::ClusterManager& cluster_manager,
+                        Server::OverloadManager& overload_manager);
   ~ConnectionManagerImpl();
 
   static ConnectionManagerStats generateStats(const std::string& prefix, Stats::Scope& scope);
@@ -315,11 +324,16 @@ public:
   // Network::ConnectionCallbacks
   void onEvent(Network::ConnectionEvent event) override;
   // Pass connection watermark events on to all the streams associated with that connection.
+  // There are no streams to tell if the codec has been released.
   void onAboveWriteBufferHighWatermark() override {
-    codec_->onUnderlyingConnectionAboveWriteBufferHighWatermark();
+    if (codec_) {
+      codec_->onUnderlyingConnectionAboveWriteBufferHighWatermark();
+    }
   }
   void onBelowWriteBufferLowWatermark() override {
-    codec_->onUnderlyingConnectionBelowWriteBufferLowWatermark();
+    if (codec_) {
+      codec_->onUnderlyingConnectionBelowWriteBufferLowWatermark();
+    }
   }
 
 private:
@@ -328,7 +342,7 @@ private:
   /**
    * Base class wrapper for both stream encoder and decoder filters.
    */
-  struct ActiveStreamFilterBase : public virtual StreamFilterCallbacks {
+  struct ActiveStreamFilterBase : public virtual StreamFilterCallbacks, public SlabAllocated {
     ActiveStreamFilterBase(ActiveStream& parent, bool dual_filter)
         : parent_(parent), headers_continued_(false), stopped_(false), dual_filter_(dual_filter) {}
 
@@ -360,7 +374,43 @@ private:
     Tracing::Config& tracingConfig() override;
     const std::string& downstreamAddress() override;
 
+    /**
+     * Time spent in the callbacks of a filter, and while it held iteration. Only allocated when
+     * filter timing is enabled for the stream.
+     */
+    struct Timing {
+      std::chrono::nanoseconds callback_time_{};
+      std::chrono::nanoseconds held_time_{};
+      Optional<MonotonicTime> held_since_;
+    };
+
+    /**
+     * Call a filter callback, charging the time spent in it to the filter if timing is enabled.
+     */
+    template <class Callback> auto timedCallback(Callback callback) -> decltype(callback()) {
+      if (timing_ == nullptr) {
+        return callback();
+      }
+      const MonotonicTime start = std::chrono::steady_clock::now();
+      const auto status = callback();
+      timing_->callback_time_ += std::chrono::steady_clock::now() - start;
+      return status;
+    }
+
+    void onIterationHeld();
+    void onIterationResumed();
+
+    /**
+     * Record the timing of the filter in histograms, and append it to a list of filter timings.
+     * @param direction supplies "decoder" or "encoder".
+     * @param timings supplies the list.
+     */
+    void recordTiming(const std::string& direction, std::string& timings);
+
     ActiveStream& parent_;
+    std::unique_ptr<Timing> timing_;
+    // The position of the filter in the filter chain configuration.
+    uint32_t index_{};
     bool headers_continued_ : 1;
     bool stopped_ : 1;
     const bool dual_filter_ : 1;
@@ -468,9 +518,11 @@ private:
 
   /**
    * Wraps a single active stream on the connection. These are either full request/response pairs
-   * or pushes.
+   * or pushes. Streams and their filter wrappers are allocated for every request, so they come
+   * from the per thread slab allocator.
    */
   struct ActiveStream : LinkedObject<ActiveStream>,
+                        public SlabAllocated,
                         public Event::DeferredDeletable,
                         public StreamCallbacks,
                         public StreamDecoder,
@@ -483,6 +535,7 @@ private:
     void addStreamDecoderFilterWorker(StreamDecoderFilterSharedPtr filter, bool dual_filter);
     void addStreamEncoderFilterWorker(StreamEncoderFilterSharedPtr filter, bool dual_filter);
     void chargeStats(HeaderMap& headers);
+    void recordFilterTimings();
     std::list<ActiveStreamEncoderFilterPtr>::iterator
     commonEncodePrefix(ActiveStreamEncoderFilter* filter, bool end_stream);
     uint64_t connectionId();
@@ -593,6 +646,11 @@ private:
     uint32_t buffer_limit_{0};
     uint32_t high_watermark_count_{0};
     const std::string* decorated_operation_{nullptr};
+    // The index in the filter chain configuration of the next filter added.
+    uint32_t next_filter_index_{0};
+    // Whether the time spent in each filter is recorded, per the http.filter_timing.enabled
+    // runtime key.
+    const bool filter_timing_;
   };
 
   typedef std::unique_ptr<ActiveStream> ActiveStreamPtr;
@@ -619,14 +677,41 @@ private:
   void onDrainTimeout();
   void startDrainSequence();
 
+  /**
+   * Destroy the codec if the connection is idle and releasing idle codecs is enabled. It is
+   * created again when the next data is read.
+   */
+  void maybeReleaseIdleCodec();
+
   bool isWebSocketConnection() const { return ws_connection_ != nullptr; }
 
+  /**
+   * Find the route of a request, in the routes of the last requests on the connection if the
+   * route cache is enabled and the routes of the configuration only depend on the request headers.
+   * @param route_config supplies the route configuration snapped by the stream.
+   * @param headers supplies the request headers.
+   * @param random_value supplies the random value passed to the route configuration.
+   * @return Router::RouteConstSharedPtr the route or nullptr if there is none.
+   */
+  Router::RouteConstSharedPtr route(const Router::ConfigConstSharedPtr& route_config,
+                                    const HeaderMap& headers, uint64_t random_value);
+
+  struct RouteCacheEntry {
+    // The host, path and route key headers of the request.
+    std::string key_;
+    Router::RouteConstSharedPtr route_;
+  };
+
   enum class DrainState { NotDraining, Draining, Closing };
 
   ConnectionManagerConfig& config_;
   ConnectionManagerStats& stats_; // We store a reference here to avoid an extra stats() call on the
                                   // config in the hot path.
   ServerConnectionPtr codec_;
+  // Whether codec_ has been released while the connection was idle. Only HTTP/1 codecs are.
+  bool codec_released_{};
+  // Whether codec_ is dispatching data, during which it must not be released.
+  bool codec_dispatching_{};
   std::list<ActiveStreamPtr> streams_;
   Stats::TimespanPtr conn_length_;
   const Network::DrainDecision& drain_close_;
@@ -639,9 +724,20 @@ private:
   Runtime::Loader& runtime_;
   const LocalInfo::LocalInfo& local_info_;
   Upstream::ClusterManager& cluster_manager_;
+  Server::OverloadManager& overload_manager_;
   WebSocket::WsHandlerImplPtr ws_connection_{};
   Network::ReadFilterCallbacks* read_callbacks_{};
   ConnectionManagerListenerStats& listener_stats_;
+  // The maximum number of routes cached, per the http.route_cache_size runtime key, or 0 if the
+  // route cache is disabled.
+  const uint64_t route_cache_size_;
+  // The configuration the cached routes belong to, which is kept alive by the cache.
+  Router::ConfigConstSharedPtr route_cache_config_;
+  std::vector<RouteCacheEntry> route_cache_;
+  // The entry replaced by the next route added to the full cache.
+  size_t route_cache_next_{};
+  // Reused to build the key of each request.
+  std::string route_cache_key_;
 };
 
 } // Http
@@ -122,10 +122,10 @@ void ConnectionManagerUtility::mutateRequestHeaders(
 
   // Generate x-request-id for all edge requests, or if there is none.
   if (config.generateRequestId() && (edge_request || !request_headers.RequestId())) {
-    // TODO(PiotrSikora) PERF: Write UUID directly to the header map.
-    const std::string uuid = random.uuid();
-    ASSERT(!uuid.empty());
-    request_headers.insertRequestId().value(uuid);
+    // The uuid fits in the inline storage of the header, so generating it allocates nothing.
+    char uuid[Runtime::RandomGenerator::UUID_LENGTH];
+    random.uuid(uuid);
+    request_headers.insertRequestId().value(uuid, Runtime::RandomGenerator::UUID_LENGTH);
   }
 
   if (config.tracingConfig()) {
@@ -161,11 +161,14 @@ void ConnectionManagerUtility::mutateXfccRequestHeader(Http::HeaderMap& request_
   // the XFCC header.
   if (config.forwardClientCert() == Http::ForwardClientCertType::AppendForward ||
       config.forwardClientCert() == Http::ForwardClientCertType::SanitizeSet) {
-    if (!connection.ssl()->uriSanLocalCertificate().empty()) {
-      client_cert_details.push_back("By=" + connection.ssl()->uriSanLocalCertificate());
+    const std::string uri_san_local_certificate = connection.ssl()->uriSanLocalCertificate();
+    if (!uri_san_local_certificate.empty()) {
+      client_cert_details.push_back("By=" + uri_san_local_certificate);
     }
-    if (!connection.ssl()->sha256PeerCertificateDigest().empty()) {
-      client_cert_details.push_back("Hash=" + connection.ssl()->sha256PeerCertificateDigest());
+    const std::string sha256_peer_certificate_digest =
+        connection.ssl()->sha256PeerCertificateDigest();
+    if (!sha256_peer_certificate_digest.empty()) {
+      client_cert_details.push_back("Hash=" + sha256_peer_certificate_digest);
     }
     for (const auto& detail : config.setCurrentClientCertDetails()) {
       switch (detail) {
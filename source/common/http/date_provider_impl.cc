@@ -1,6 +1,8 @@
 #include "common/http/date_provider_impl.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <string>
 
 namespace Envoy {
@@ -8,25 +10,71 @@ namespace Http {
 
 DateFormatter DateProviderImplBase::date_formatter_("%a, %d %b %Y %H:%M:%S GMT");
 
-TlsCachingDateProviderImpl::TlsCachingDateProviderImpl(Event::Dispatcher& dispatcher,
-                                                       ThreadLocal::SlotAllocator& tls)
-    : tls_(tls.allocateSlot()),
-      refresh_timer_(dispatcher.createTimer([this]() -> void { onRefreshDate(); })) {
-
+TlsCachingDateProviderImpl::TlsCachingDateProviderImpl(Event::Dispatcher& dispatcher)
+    : refresh_timer_(dispatcher.createTimer([this]() -> void { onRefreshDate(); })) {
+  for (std::atomic<uint64_t>& word : date_words_) {
+    word.store(0, std::memory_order_relaxed);
+  }
   onRefreshDate();
 }
 
 void TlsCachingDateProviderImpl::onRefreshDate() {
-  std::string new_date_string = date_formatter_.now();
-  tls_->set([new_date_string](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
-    return std::make_shared<ThreadLocalCachedDate>(new_date_string);
-  });
+  const auto now = std::chrono::system_clock::now();
+  const std::string new_date_string = date_formatter_.fromTime(now);
+  uint64_t words[DATE_WORDS] = {};
+  const size_t length = std::min(new_date_string.size(), sizeof(words));
+  memcpy(words, new_date_string.data(), length);
+
+  const uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+  sequence_.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (size_t i = 0; i < DATE_WORDS; i++) {
+    date_words_[i].store(words[i], std::memory_order_relaxed);
+  }
+  date_length_.store(length, std::memory_order_relaxed);
+  sequence_.store(sequence + 2, std::memory_order_release);
 
-  refresh_timer_->enableTimer(std::chrono::milliseconds(500));
+  // The date only changes at second boundaries, so the next refresh is timed for the next one.
+  const auto since_second =
+      std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) %
+      std::chrono::seconds(1);
+  refresh_timer_->enableTimer(std::chrono::seconds(1) - since_second);
 }
 
 void TlsCachingDateProviderImpl::setDateHeader(HeaderMap& headers) {
-  headers.insertDate().value(tls_->getTyped<ThreadLocalCachedDate>().date_string_);
+  // The cache is only refreshed when the sequence changes, which is once a second. The date keeps
+  // the same length, so refreshing it does not move the memory referenced by earlier headers.
+  struct CachedDate {
+    const TlsCachingDateProviderImpl* provider_{};
+    uint64_t sequence_{};
+    std::string date_string_;
+  };
+  static thread_local CachedDate cached_date;
+
+  uint64_t sequence = sequence_.load(std::memory_order_acquire);
+  if (cached_date.provider_ != this || cached_date.sequence_ != sequence) {
+    uint64_t words[DATE_WORDS];
+    uint64_t length;
+    while (true) {
+      for (size_t i = 0; i < DATE_WORDS; i++) {
+        words[i] = date_words_[i].load(std::memory_order_relaxed);
+      }
+      length = date_length_.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      const uint64_t sequence_after = sequence_.load(std::memory_order_relaxed);
+      if (sequence % 2 == 0 && sequence == sequence_after) {
+        break;
+      }
+      sequence = sequence_.load(std::memory_order_acquire);
+    }
+
+    cached_date.provider_ = this;
+    cached_date.sequence_ = sequence;
+    cached_date.date_string_.reserve(sizeof(words));
+    cached_date.date_string_.assign(reinterpret_cast<const char*>(words), length);
+  }
+
+  headers.insertDate().value().setReference(cached_date.date_string_);
 }
 
 void SlowDateProviderImpl::setDateHeader(HeaderMap& headers) {
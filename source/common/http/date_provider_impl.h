@@ -1,11 +1,11 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <string>
 
 #include "envoy/event/dispatcher.h"
 #include "envoy/singleton/instance.h"
-#include "envoy/thread_local/thread_local.h"
 
 #include "common/common/utility.h"
 
@@ -23,26 +23,31 @@ protected:
 };
 
 /**
- * A caching thread local provider. This implementation updates the date string every 500ms and
- * caches on each thread.
+ * A caching thread local provider. The dispatcher's thread formats the date at each second
+ * boundary into a buffer shared with the other threads, which copy it into a thread local cache
+ * when it changes and set the date header as a reference to their cache. A date header set this
+ * way must not outlive the thread, and may be updated in place to a later date by the next call
+ * on the thread.
  */
 class TlsCachingDateProviderImpl : public DateProviderImplBase, public Singleton::Instance {
 public:
-  TlsCachingDateProviderImpl(Event::Dispatcher& dispatcher, ThreadLocal::SlotAllocator& tls);
+  TlsCachingDateProviderImpl(Event::Dispatcher& dispatcher);
 
   // Http::DateProvider
   void setDateHeader(HeaderMap& headers) override;
 
 private:
-  struct ThreadLocalCachedDate : public ThreadLocal::ThreadLocalObject {
-    ThreadLocalCachedDate(const std::string& date_string) : date_string_(date_string) {}
-
-    const std::string date_string_;
-  };
+  // Enough words for the 29 characters of an IMF-fixdate.
+  static const size_t DATE_WORDS = 4;
 
   void onRefreshDate();
 
-  ThreadLocal::SlotPtr tls_;
+  // The date is shared as a seqlock: sequence_ is odd while the date is being written, and readers
+  // retry until they see the same even sequence before and after reading the date. The date is
+  // kept in atomic words so that a read which overlaps a write is not a data race.
+  std::atomic<uint64_t> sequence_{0};
+  std::atomic<uint64_t> date_words_[DATE_WORDS];
+  std::atomic<uint64_t> date_length_{0};
   Event::TimerPtr refresh_timer_;
 };
 
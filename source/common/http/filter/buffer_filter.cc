@@ -1,5 +1,11 @@
 #include "common/http/filter/buffer_filter.h"
 
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
 #include <string>
 
 #include "envoy/event/dispatcher.h"
@@ -34,7 +40,23 @@ FilterHeadersStatus BufferFilter::decodeHeaders(HeaderMap&, bool end_stream) {
   }
 }
 
-FilterDataStatus BufferFilter::decodeData(Buffer::Instance&, bool end_stream) {
+FilterDataStatus BufferFilter::decodeData(Buffer::Instance& data, bool end_stream) {
+  if (spill_fd_ == -1 && !end_stream && shouldSpill(data.length())) {
+    openSpillFile();
+  }
+
+  if (spill_fd_ != -1) {
+    if (!spill(data)) {
+      return FilterDataStatus::StopIterationNoBuffer;
+    }
+    if (!end_stream) {
+      return FilterDataStatus::StopIterationNoBuffer;
+    }
+    if (!addSpilledData()) {
+      return FilterDataStatus::StopIterationNoBuffer;
+    }
+  }
+
   if (end_stream) {
     resetInternalState();
     return FilterDataStatus::Continue;
@@ -45,6 +67,19 @@ FilterDataStatus BufferFilter::decodeData(Buffer::Instance&, bool end_stream) {
 }
 
 FilterTrailersStatus BufferFilter::decodeTrailers(HeaderMap&) {
+  if (spill_fd_ != -1) {
+    // Data can't be buffered from the trailers callback, so the spilled data is added right after
+    // it returns.
+    spill_timer_ = callbacks_->dispatcher().createTimer([this]() -> void {
+      if (addSpilledData()) {
+        resetInternalState();
+        callbacks_->continueDecoding();
+      }
+    });
+    spill_timer_->enableTimer(std::chrono::milliseconds(0));
+    return FilterTrailersStatus::StopIteration;
+  }
+
   resetInternalState();
   return FilterTrailersStatus::Continue;
 }
@@ -56,6 +91,11 @@ BufferFilterStats BufferFilter::generateStats(const std::string& prefix, Stats::
 
 void BufferFilter::onDestroy() {
   resetInternalState();
+  spill_timer_.reset();
+  if (spill_fd_ != -1) {
+    ::close(spill_fd_);
+    spill_fd_ = -1;
+  }
   stream_destroyed_ = true;
 }
 
@@ -67,6 +107,103 @@ void BufferFilter::onRequestTimeout() {
 
 void BufferFilter::resetInternalState() { request_timeout_.reset(); }
 
+bool BufferFilter::shouldSpill(uint64_t length) {
+  const uint64_t threshold =
+      config_->runtime_.snapshot().getInteger("buffer.spill_threshold_bytes", 0);
+  if (threshold == 0) {
+    return false;
+  }
+
+  const Buffer::Instance* buffered = callbacks_->decodingBuffer();
+  return (buffered != nullptr ? buffered->length() : 0) + length > threshold;
+}
+
+void BufferFilter::openSpillFile() {
+  const std::string& directory = config_->runtime_.snapshot().get("buffer.spill_path");
+  std::string path = (directory.empty() ? "/tmp" : directory) + "/envoy_buffer_XXXXXX";
+  spill_fd_ = ::mkstemp(&path[0]);
+  if (spill_fd_ == -1) {
+    // Keep buffering in memory.
+    ENVOY_LOG(warn, "unable to create buffer spill file {}: {}", path, strerror(errno));
+    return;
+  }
+
+  ::unlink(path.c_str());
+  config_->stats_.rq_spilled_.inc();
+}
+
+bool BufferFilter::spill(Buffer::Instance& data) {
+  // The data buffered in memory before the spill stays in front of the spilled data.
+  const Buffer::Instance* buffered = callbacks_->decodingBuffer();
+  spilled_bytes_ += data.length();
+  if ((buffered != nullptr ? buffered->length() : 0) + spilled_bytes_ >
+      config_->max_request_bytes_) {
+    Http::Utility::sendLocalReply(*callbacks_, stream_destroyed_, Http::Code::PayloadTooLarge,
+                                  CodeUtility::toString(Http::Code::PayloadTooLarge));
+    return false;
+  }
+
+  uint64_t num_slices = data.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  data.getRawSlices(slices, num_slices);
+  for (uint64_t i = 0; i < num_slices; i++) {
+    const uint8_t* mem = static_cast<const uint8_t*>(slices[i].mem_);
+    uint64_t remaining = slices[i].len_;
+    while (remaining > 0) {
+      const ssize_t rc = ::write(spill_fd_, mem, remaining);
+      if (rc == -1 && errno == EINTR) {
+        continue;
+      }
+      if (rc == -1) {
+        ENVOY_LOG(warn, "unable to write buffer spill file: {}", strerror(errno));
+        onSpillFailure();
+        return false;
+      }
+      mem += rc;
+      remaining -= rc;
+    }
+  }
+
+  data.drain(data.length());
+  return true;
+}
+
+bool BufferFilter::addSpilledData() {
+  void* mem = MAP_FAILED;
+  if (spilled_bytes_ > 0) {
+    mem = ::mmap(nullptr, spilled_bytes_, PROT_READ, MAP_PRIVATE, spill_fd_, 0);
+  }
+  // The mapping outlives the descriptor.
+  ::close(spill_fd_);
+  spill_fd_ = -1;
+
+  if (spilled_bytes_ == 0) {
+    return true;
+  }
+  if (mem == MAP_FAILED) {
+    ENVOY_LOG(warn, "unable to map buffer spill file: {}", strerror(errno));
+    onSpillFailure();
+    return false;
+  }
+
+  // The mapping is released once the data has been sent upstream, or the request is reset.
+  Buffer::BufferFragmentImpl* fragment = new Buffer::BufferFragmentImpl(
+      mem, spilled_bytes_,
+      [](const void* data, size_t size, const Buffer::BufferFragmentImpl* fragment) -> void {
+        ::munmap(const_cast<void*>(data), size);
+        delete fragment;
+      });
+  Buffer::OwnedImpl spilled;
+  spilled.addBufferFragment(*fragment);
+  callbacks_->addDecodedData(spilled, false);
+  return true;
+}
+
+void BufferFilter::onSpillFailure() {
+  Http::Utility::sendLocalReply(*callbacks_, stream_destroyed_, Http::Code::InternalServerError,
+                                "buffer spill failure");
+}
+
 void BufferFilter::setDecoderFilterCallbacks(StreamDecoderFilterCallbacks& callbacks) {
   callbacks_ = &callbacks;
   callbacks_->setDecoderBufferLimit(config_->max_request_bytes_);
@@ -6,9 +6,11 @@
 #include <string>
 
 #include "envoy/http/filter.h"
+#include "envoy/runtime/runtime.h"
 #include "envoy/stats/stats_macros.h"
 
 #include "common/buffer/buffer_impl.h"
+#include "common/common/logger.h"
 
 namespace Envoy {
 namespace Http {
@@ -18,7 +20,8 @@ namespace Http {
  */
 // clang-format off
 #define ALL_BUFFER_FILTER_STATS(COUNTER)                                                           \
-  COUNTER(rq_timeout)
+  COUNTER(rq_timeout)                                                                              \
+  COUNTER(rq_spilled)
 // clang-format on
 
 /**
@@ -35,14 +38,21 @@ struct BufferFilterConfig {
   BufferFilterStats stats_;
   uint64_t max_request_bytes_;
   std::chrono::seconds max_request_time_;
+  Runtime::Loader& runtime_;
 };
 
 typedef std::shared_ptr<const BufferFilterConfig> BufferFilterConfigConstSharedPtr;
 
 /**
  * A filter that is capable of buffering an entire request before dispatching it upstream.
+ *
+ * When the buffer.spill_threshold_bytes runtime key is set, the part of a request body beyond that
+ * many bytes is written to a temporary file in the buffer.spill_path directory (/tmp by default)
+ * instead of being held in memory. Once the request is complete, the file is mapped and its pages
+ * are sent upstream from the page cache. The file is unlinked as soon as it is created, so it goes
+ * away with the request.
  */
-class BufferFilter : public StreamDecoderFilter {
+class BufferFilter : public StreamDecoderFilter, Logger::Loggable<Logger::Id::filter> {
 public:
   BufferFilter(BufferFilterConfigConstSharedPtr config);
   ~BufferFilter();
@@ -61,10 +71,18 @@ public:
 private:
   void onRequestTimeout();
   void resetInternalState();
+  bool shouldSpill(uint64_t length);
+  void openSpillFile();
+  bool spill(Buffer::Instance& data);
+  bool addSpilledData();
+  void onSpillFailure();
 
   BufferFilterConfigConstSharedPtr config_;
   StreamDecoderFilterCallbacks* callbacks_{};
   Event::TimerPtr request_timeout_;
+  Event::TimerPtr spill_timer_;
+  int spill_fd_{-1};
+  uint64_t spilled_bytes_{};
   bool stream_destroyed_{};
 };
 
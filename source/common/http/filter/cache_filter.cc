@@ -0,0 +1,365 @@
+#include "common/http/filter/cache_filter.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+#include "envoy/http/codes.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/assert.h"
+#include "common/common/enum_to_int.h"
+#include "common/common/utility.h"
+#include "common/http/headers.h"
+#include "common/http/utility.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Http {
+namespace {
+
+/**
+ * A fragment referencing the body of a cached response, which keeps the response alive until the
+ * buffer holding the fragment is done with it.
+ */
+class CachedBodyFragment : public Buffer::BufferFragment {
+public:
+  CachedBodyFragment(CachedResponseConstSharedPtr response) : response_(std::move(response)) {}
+
+  // Buffer::BufferFragment
+  const void* data() const override { return response_->body_.data(); }
+  size_t size() const override { return response_->body_.size(); }
+  void done() override { delete this; }
+
+private:
+  const CachedResponseConstSharedPtr response_;
+};
+
+} // namespace
+
+uint64_t CachedResponse::byteSize() const {
+  uint64_t size = sizeof(CachedResponse) + headers_.byteSize() + body_.size();
+  for (const auto& vary : vary_) {
+    size += vary.first.get().size() + vary.second.size();
+  }
+  return size;
+}
+
+CacheUtility::CacheControl CacheUtility::parseCacheControl(const HeaderMap& headers) {
+  CacheControl cache_control;
+  auto parse_directive = [&](const std::string& directive) {
+    const size_t equals = directive.find('=');
+    const std::string name = directive.substr(0, equals);
+    auto is = [&name](const std::string& value) -> bool {
+      return StringUtil::caseInsensitiveCompare(name.c_str(), value.c_str()) == 0;
+    };
+
+    const auto& values = Headers::get().CacheControlValues;
+    if (is(values.NoCache)) {
+      cache_control.no_cache_ = true;
+    } else if (is(values.NoStore)) {
+      cache_control.no_store_ = true;
+    } else if (is(values.Private)) {
+      cache_control.private_ = true;
+    } else if (equals != std::string::npos) {
+      std::string value = directive.substr(equals + 1);
+      value.erase(std::remove(value.begin(), value.end(), '"'), value.end());
+      uint64_t seconds;
+      if (!StringUtil::atoul(value.c_str(), seconds)) {
+        return;
+      }
+
+      if (is(values.MaxAge)) {
+        cache_control.max_age_.value(std::chrono::seconds(seconds));
+      } else if (is(values.SMaxAge)) {
+        cache_control.s_maxage_.value(std::chrono::seconds(seconds));
+      }
+    }
+  };
+  Utility::forEachHeaderElement(headers, Headers::get().CacheControl, parse_directive);
+
+  return cache_control;
+}
+
+bool CacheUtility::requestCacheable(const HeaderMap& headers, bool end_stream) {
+  if (!end_stream || !headers.Method() || !headers.Host() || !headers.Path() ||
+      headers.Method()->value() != Headers::get().MethodValues.Get.c_str() ||
+      headers.Authorization()) {
+    return false;
+  }
+
+  return !parseCacheControl(headers).no_store_;
+}
+
+Optional<std::chrono::seconds> CacheUtility::freshnessLifetime(const HeaderMap& headers) {
+  Optional<std::chrono::seconds> lifetime;
+  if (Utility::getResponseStatus(headers) != enumToInt(Code::OK) ||
+      headers.get(Headers::get().SetCookie)) {
+    return lifetime;
+  }
+
+  const CacheControl cache_control = parseCacheControl(headers);
+  if (cache_control.no_cache_ || cache_control.no_store_ || cache_control.private_) {
+    return lifetime;
+  }
+
+  // A shared cache prefers s-maxage to max-age.
+  std::chrono::seconds max_age;
+  if (cache_control.s_maxage_.valid()) {
+    max_age = cache_control.s_maxage_.value();
+  } else if (cache_control.max_age_.valid()) {
+    max_age = cache_control.max_age_.value();
+  } else {
+    return lifetime;
+  }
+
+  // The response may already have spent some of its lifetime in other caches.
+  const HeaderEntry* age_header = headers.get(Headers::get().Age);
+  uint64_t age = 0;
+  if (age_header && StringUtil::atoul(age_header->value().c_str(), age) &&
+      std::chrono::seconds(age) >= max_age) {
+    return lifetime;
+  }
+
+  if (max_age.count() > 0) {
+    lifetime.value(max_age - std::chrono::seconds(age));
+  }
+  return lifetime;
+}
+
+bool CacheUtility::varyHeaders(const HeaderMap& headers, std::vector<LowerCaseString>& vary) {
+  bool cacheable = true;
+  Utility::forEachHeaderElement(headers, Headers::get().Vary, [&](const std::string& name) {
+    if (name == "*") {
+      cacheable = false;
+    } else {
+      vary.emplace_back(name);
+    }
+  });
+
+  return cacheable;
+}
+
+std::string CacheUtility::cacheKey(const HeaderMap& headers) {
+  return fmt::format("{}\n{}", headers.Host()->value().c_str(), headers.Path()->value().c_str());
+}
+
+HttpCache::HttpCache(uint64_t max_bytes, uint32_t num_shards, const CacheFilterStats& stats)
+    : max_bytes_per_shard_(max_bytes / num_shards), stats_(stats) {
+  ASSERT(num_shards > 0);
+  for (uint32_t i = 0; i < num_shards; i++) {
+    shards_.emplace_back(new Shard());
+  }
+}
+
+HttpCache::Shard& HttpCache::shardFor(const std::string& key) {
+  return *shards_[std::hash<std::string>()(key) % shards_.size()];
+}
+
+void HttpCache::removeEntry(Shard& shard, EntryList::iterator entry, EntryList& removed) {
+  const uint64_t size = entrySize(entry->first, *entry->second);
+  shard.bytes_ -= size;
+  stats_.size_bytes_.sub(size);
+  shard.index_.erase(entry->first);
+  removed.splice(removed.end(), shard.entries_, entry);
+}
+
+CachedResponseConstSharedPtr HttpCache::lookup(const std::string& key,
+                                               const HeaderMap& request_headers,
+                                               MonotonicTime now) {
+  // Responses removed below are freed once the lock has been released.
+  EntryList removed;
+
+  Shard& shard = shardFor(key);
+  std::unique_lock<std::mutex> lock(shard.lock_);
+  auto entry = shard.index_.find(key);
+  if (entry == shard.index_.end()) {
+    return nullptr;
+  }
+
+  const CachedResponseConstSharedPtr& response = entry->second->second;
+  if (now >= response->expiry_time_) {
+    removeEntry(shard, entry->second, removed);
+    return nullptr;
+  }
+
+  for (const auto& vary : response->vary_) {
+    const HeaderEntry* header = request_headers.get(vary.first);
+    if (vary.second != (header ? header->value().c_str() : "")) {
+      return nullptr;
+    }
+  }
+
+  shard.entries_.splice(shard.entries_.begin(), shard.entries_, entry->second);
+  return response;
+}
+
+void HttpCache::insert(const std::string& key, CachedResponseConstSharedPtr response) {
+  const uint64_t size = entrySize(key, *response);
+  if (size > max_bytes_per_shard_) {
+    return;
+  }
+
+  // Responses replaced or evicted below are freed once the lock has been released.
+  EntryList removed;
+
+  Shard& shard = shardFor(key);
+  std::unique_lock<std::mutex> lock(shard.lock_);
+  auto existing = shard.index_.find(key);
+  if (existing != shard.index_.end()) {
+    removeEntry(shard, existing->second, removed);
+  }
+
+  while (shard.bytes_ + size > max_bytes_per_shard_) {
+    removeEntry(shard, std::prev(shard.entries_.end()), removed);
+    stats_.evict_.inc();
+  }
+
+  shard.entries_.emplace_front(key, std::move(response));
+  shard.index_[key] = shard.entries_.begin();
+  shard.bytes_ += size;
+  stats_.size_bytes_.add(size);
+  stats_.insert_.inc();
+}
+
+uint64_t HttpCache::size() {
+  uint64_t size = 0;
+  for (std::unique_ptr<Shard>& shard : shards_) {
+    std::unique_lock<std::mutex> lock(shard->lock_);
+    size += shard->entries_.size();
+  }
+  return size;
+}
+
+CacheFilterConfig::CacheFilterConfig(uint64_t max_bytes, uint64_t max_entry_bytes, bool shared,
+                                     uint32_t num_shards, const std::string& stats_prefix,
+                                     Stats::Scope& scope, ThreadLocal::SlotAllocator& tls,
+                                     MonotonicTimeSource& time_source)
+    : stats_(generateStats(stats_prefix, scope)), max_entry_bytes_(max_entry_bytes),
+      time_source_(time_source) {
+  if (shared) {
+    shared_cache_ = std::make_shared<HttpCache>(max_bytes, num_shards, stats_);
+    return;
+  }
+
+  CacheFilterStats stats = stats_;
+  tls_slot_ = tls.allocateSlot();
+  tls_slot_->set([max_bytes, stats](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<HttpCache>(max_bytes, 1, stats);
+  });
+}
+
+CacheFilterStats CacheFilterConfig::generateStats(const std::string& prefix, Stats::Scope& scope) {
+  const std::string final_prefix = prefix + "cache.";
+  return {ALL_CACHE_FILTER_STATS(POOL_COUNTER_PREFIX(scope, final_prefix),
+                                 POOL_GAUGE_PREFIX(scope, final_prefix))};
+}
+
+CacheFilter::CacheFilter(CacheFilterConfigSharedPtr config) : config_(config) {}
+
+FilterHeadersStatus CacheFilter::decodeHeaders(HeaderMap& headers, bool end_stream) {
+  if (!CacheUtility::requestCacheable(headers, end_stream)) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  const MonotonicTime now = config_->timeSource().currentTime();
+  std::string key = CacheUtility::cacheKey(headers);
+  if (!CacheUtility::parseCacheControl(headers).no_cache_) {
+    CachedResponseConstSharedPtr response = config_->cache().lookup(key, headers, now);
+    if (response) {
+      config_->stats().hit_.inc();
+      serveCachedResponse(std::move(response), now);
+      return FilterHeadersStatus::StopIteration;
+    }
+  }
+
+  config_->stats().miss_.inc();
+  request_headers_ = &headers;
+  key_ = std::move(key);
+  return FilterHeadersStatus::Continue;
+}
+
+void CacheFilter::serveCachedResponse(CachedResponseConstSharedPtr response, MonotonicTime now) {
+  HeaderMapPtr headers{new HeaderMapImpl(response->headers_)};
+  const std::chrono::seconds age =
+      std::chrono::duration_cast<std::chrono::seconds>(now - response->response_time_);
+  headers->remove(Headers::get().Age);
+  headers->addCopy(Headers::get().Age, age.count());
+
+  const bool has_body = !response->body_.empty();
+  decoder_callbacks_->encodeHeaders(std::move(headers), !has_body);
+  if (!has_body || stream_destroyed_) {
+    return;
+  }
+
+  Buffer::OwnedImpl body;
+  body.addBufferFragment(*new CachedBodyFragment(std::move(response)));
+  decoder_callbacks_->encodeData(body, true);
+}
+
+FilterHeadersStatus CacheFilter::encodeHeaders(HeaderMap& headers, bool end_stream) {
+  if (key_.empty()) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  const Optional<std::chrono::seconds> lifetime = CacheUtility::freshnessLifetime(headers);
+  std::vector<LowerCaseString> vary;
+  if (!lifetime.valid() || !CacheUtility::varyHeaders(headers, vary)) {
+    key_.clear();
+    return FilterHeadersStatus::Continue;
+  }
+
+  response_.reset(new CachedResponse(headers));
+  for (LowerCaseString& name : vary) {
+    const HeaderEntry* header = request_headers_->get(name);
+    response_->vary_.emplace_back(std::move(name), header ? header->value().c_str() : "");
+  }
+  response_->response_time_ = config_->timeSource().currentTime();
+  response_->expiry_time_ = response_->response_time_ + lifetime.value();
+
+  if (end_stream) {
+    insertResponse();
+  }
+  return FilterHeadersStatus::Continue;
+}
+
+FilterDataStatus CacheFilter::encodeData(Buffer::Instance& data, bool end_stream) {
+  if (!response_) {
+    return FilterDataStatus::Continue;
+  }
+
+  // The data is passed on, so copy it into the cached body.
+  if (response_->body_.size() + data.length() > config_->maxEntryBytes()) {
+    response_.reset();
+    key_.clear();
+    return FilterDataStatus::Continue;
+  }
+
+  uint64_t num_slices = data.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  data.getRawSlices(slices, num_slices);
+  for (Buffer::RawSlice& slice : slices) {
+    response_->body_.append(static_cast<const char*>(slice.mem_), slice.len_);
+  }
+
+  if (end_stream) {
+    insertResponse();
+  }
+  return FilterDataStatus::Continue;
+}
+
+FilterTrailersStatus CacheFilter::encodeTrailers(HeaderMap&) {
+  // Responses with trailers aren't cached.
+  response_.reset();
+  key_.clear();
+  return FilterTrailersStatus::Continue;
+}
+
+void CacheFilter::insertResponse() {
+  config_->cache().insert(key_, std::move(response_));
+  key_.clear();
+}
+
+} // namespace Http
+} // namespace Envoy
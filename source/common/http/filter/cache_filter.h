@@ -0,0 +1,267 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "envoy/common/optional.h"
+#include "envoy/common/time.h"
+#include "envoy/http/filter.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/http/header_map_impl.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * All stats for the cache filter. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_CACHE_FILTER_STATS(COUNTER, GAUGE)                                                     \
+  COUNTER(hit)                                                                                     \
+  COUNTER(miss)                                                                                    \
+  COUNTER(insert)                                                                                  \
+  COUNTER(evict)                                                                                   \
+  GAUGE  (size_bytes)
+// clang-format on
+
+/**
+ * Wrapper struct for cache filter stats. @see stats_macros.h
+ */
+struct CacheFilterStats {
+  ALL_CACHE_FILTER_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * A cached response. It is immutable once it has been inserted into a cache, so that hits can
+ * reference the body from buffers without copying it.
+ */
+struct CachedResponse {
+  CachedResponse(const HeaderMap& headers) : headers_(headers) {}
+
+  /**
+   * @return uint64_t the memory charged to the cache for the response.
+   */
+  uint64_t byteSize() const;
+
+  HeaderMapImpl headers_;
+  std::string body_;
+  // The request headers named by the Vary header of the response, with their request values.
+  std::vector<std::pair<LowerCaseString, std::string>> vary_;
+  MonotonicTime response_time_;
+  MonotonicTime expiry_time_;
+};
+
+typedef std::shared_ptr<const CachedResponse> CachedResponseConstSharedPtr;
+
+/**
+ * Cache utility routines.
+ */
+class CacheUtility {
+public:
+  struct CacheControl {
+    bool no_cache_{};
+    bool no_store_{};
+    bool private_{};
+    Optional<std::chrono::seconds> max_age_;
+    Optional<std::chrono::seconds> s_maxage_;
+  };
+
+  /**
+   * Parse the Cache-Control headers of a request or response. Unknown directives are ignored.
+   * @param headers supplies the headers.
+   * @return CacheControl the directives.
+   */
+  static CacheControl parseCacheControl(const HeaderMap& headers);
+
+  /**
+   * @param headers supplies the request headers.
+   * @param end_stream supplies whether the request has no body.
+   * @return bool whether the response to the request may be served from, or stored in, a cache.
+   *         This is the case for GET requests without a body or credentials, which don't forbid
+   *         storing the response.
+   */
+  static bool requestCacheable(const HeaderMap& headers, bool end_stream);
+
+  /**
+   * Determine how long a response may be served from a cache.
+   * @param headers supplies the response headers.
+   * @return Optional<std::chrono::seconds> the remaining freshness lifetime of the response, which
+   *         is not valid if the response must not be cached. Only 200 responses without cookies
+   *         which have an explicit max-age or s-maxage are cached.
+   */
+  static Optional<std::chrono::seconds> freshnessLifetime(const HeaderMap& headers);
+
+  /**
+   * Parse the Vary headers of a response.
+   * @param headers supplies the response headers.
+   * @param vary supplies the list to fill in with the names of the request headers.
+   * @return bool false if the response varies on "*", and so can't be cached.
+   */
+  static bool varyHeaders(const HeaderMap& headers, std::vector<LowerCaseString>& vary);
+
+  /**
+   * @param headers supplies the request headers.
+   * @return std::string the cache key of the request.
+   */
+  static std::string cacheKey(const HeaderMap& headers);
+};
+
+/**
+ * A least recently used response cache with a memory limit. The cache is split into shards, each
+ * with its own lock and limit, so that it can be shared by all workers. A cache used by a single
+ * worker has one shard, whose lock is never contended.
+ */
+class HttpCache : public ThreadLocal::ThreadLocalObject {
+public:
+  /**
+   * @param max_bytes supplies the memory limit of the cache.
+   * @param num_shards supplies the number of independently locked shards.
+   * @param stats supplies the stats to update.
+   */
+  HttpCache(uint64_t max_bytes, uint32_t num_shards, const CacheFilterStats& stats);
+
+  /**
+   * Find a fresh response for a request. Expired responses are removed.
+   * @param key supplies the cache key of the request.
+   * @param request_headers supplies the request headers, to be matched against the Vary headers of
+   *        the response.
+   * @param now supplies the current time.
+   * @return CachedResponseConstSharedPtr the response, or nullptr if there is none.
+   */
+  CachedResponseConstSharedPtr lookup(const std::string& key, const HeaderMap& request_headers,
+                                      MonotonicTime now);
+
+  /**
+   * Add a response to the cache, replacing any response with the same key and evicting the least
+   * recently used responses to make room for it.
+   * @param key supplies the cache key of the request.
+   * @param response supplies the response.
+   */
+  void insert(const std::string& key, CachedResponseConstSharedPtr response);
+
+  /**
+   * @return uint64_t the number of responses in the cache.
+   */
+  uint64_t size();
+
+private:
+  typedef std::list<std::pair<std::string, CachedResponseConstSharedPtr>> EntryList;
+
+  struct Shard {
+    std::mutex lock_;
+    // Most recently used first.
+    EntryList entries_;
+    std::unordered_map<std::string, EntryList::iterator> index_;
+    uint64_t bytes_{};
+  };
+
+  static uint64_t entrySize(const std::string& key, const CachedResponse& response) {
+    return key.size() + response.byteSize();
+  }
+
+  Shard& shardFor(const std::string& key);
+  void removeEntry(Shard& shard, EntryList::iterator entry, EntryList& removed);
+
+  const uint64_t max_bytes_per_shard_;
+  CacheFilterStats stats_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+typedef std::shared_ptr<HttpCache> HttpCacheSharedPtr;
+
+/**
+ * Configuration for the cache filter.
+ */
+class CacheFilterConfig {
+public:
+  /**
+   * @param max_bytes supplies the memory limit of each worker's cache, or of the shared cache.
+   * @param max_entry_bytes supplies the size limit of a cached response body.
+   * @param shared supplies whether all workers share one cache.
+   * @param num_shards supplies the number of shards of the shared cache.
+   * @param stats_prefix supplies the prefix of the filter stats.
+   * @param scope supplies the scope of the filter stats.
+   * @param tls supplies the slot allocator for the per worker caches.
+   * @param time_source supplies the time source for freshness lifetimes.
+   */
+  CacheFilterConfig(uint64_t max_bytes, uint64_t max_entry_bytes, bool shared, uint32_t num_shards,
+                    const std::string& stats_prefix, Stats::Scope& scope,
+                    ThreadLocal::SlotAllocator& tls, MonotonicTimeSource& time_source);
+
+  /**
+   * @return HttpCache& the cache to use on this thread.
+   */
+  HttpCache& cache() {
+    return shared_cache_ ? *shared_cache_ : tls_slot_->getTyped<HttpCache>();
+  }
+
+  CacheFilterStats& stats() { return stats_; }
+  uint64_t maxEntryBytes() const { return max_entry_bytes_; }
+  MonotonicTimeSource& timeSource() { return time_source_; }
+
+private:
+  static CacheFilterStats generateStats(const std::string& prefix, Stats::Scope& scope);
+
+  CacheFilterStats stats_;
+  const uint64_t max_entry_bytes_;
+  MonotonicTimeSource& time_source_;
+  HttpCacheSharedPtr shared_cache_;
+  ThreadLocal::SlotPtr tls_slot_;
+};
+
+typedef std::shared_ptr<CacheFilterConfig> CacheFilterConfigSharedPtr;
+
+/**
+ * A filter which serves GET requests from an in-memory cache of upstream responses. Responses are
+ * stored if their Cache-Control headers give them an explicit freshness lifetime, and are served
+ * with an Age header until they expire. Cached bodies are added to response buffers by reference.
+ */
+class CacheFilter : public StreamFilter {
+public:
+  CacheFilter(CacheFilterConfigSharedPtr config);
+
+  // Http::StreamFilterBase
+  void onDestroy() override { stream_destroyed_ = true; }
+
+  // Http::StreamDecoderFilter
+  FilterHeadersStatus decodeHeaders(HeaderMap& headers, bool end_stream) override;
+  FilterDataStatus decodeData(Buffer::Instance&, bool) override {
+    return FilterDataStatus::Continue;
+  }
+  FilterTrailersStatus decodeTrailers(HeaderMap&) override {
+    return FilterTrailersStatus::Continue;
+  }
+  void setDecoderFilterCallbacks(StreamDecoderFilterCallbacks& callbacks) override {
+    decoder_callbacks_ = &callbacks;
+  }
+
+  // Http::StreamEncoderFilter
+  FilterHeadersStatus encodeHeaders(HeaderMap& headers, bool end_stream) override;
+  FilterDataStatus encodeData(Buffer::Instance& data, bool end_stream) override;
+  FilterTrailersStatus encodeTrailers(HeaderMap& trailers) override;
+  void setEncoderFilterCallbacks(StreamEncoderFilterCallbacks&) override {}
+
+private:
+  void serveCachedResponse(CachedResponseConstSharedPtr response, MonotonicTime now);
+  void insertResponse();
+
+  CacheFilterConfigSharedPtr config_;
+  StreamDecoderFilterCallbacks* decoder_callbacks_{};
+  const HeaderMap* request_headers_{};
+  // Set while the response may be stored.
+  std::string key_;
+  std::unique_ptr<CachedResponse> response_;
+  bool stream_destroyed_{};
+};
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,350 @@
+#include "common/http/filter/compression_filter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <map>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/assert.h"
+#include "common/common/utility.h"
+#include "common/compressor/brotli_compressor_impl.h"
+#include "common/compressor/zstd_compressor_impl.h"
+#include "common/http/headers.h"
+#include "common/http/utility.h"
+
+namespace Envoy {
+namespace Http {
+namespace {
+
+std::string toLower(std::string value) {
+  std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+  return value;
+}
+
+std::string trim(std::string value) {
+  value.erase(0, value.find_first_not_of(" \t"));
+  StringUtil::rtrim(value);
+  return value;
+}
+
+/**
+ * @return double the quality value of an Accept-Encoding element such as "gzip;q=0.5", which is
+ *         1 if it has no q parameter and 0 if the parameter is invalid.
+ */
+double qualityValue(const std::vector<std::string>& params) {
+  for (size_t i = 1; i < params.size(); i++) {
+    const std::string param = trim(params[i]);
+    if (param.size() < 2 || ::tolower(param[0]) != 'q' || param[1] != '=') {
+      continue;
+    }
+
+    char* end;
+    const double q = std::strtod(param.c_str() + 2, &end);
+    if (*end != '\0' || !(q >= 0 && q <= 1)) {
+      return 0;
+    }
+    return q;
+  }
+  return 1;
+}
+
+/**
+ * @return CompressionUtility::Encoding the coding named by a lower case Accept-Encoding element, or
+ *         Identity if it isn't one which the filter can compress with.
+ */
+CompressionUtility::Encoding encodingFromName(const std::string& coding) {
+  if (coding == Headers::get().ContentEncodingValues.Gzip || coding == "x-gzip") {
+    return CompressionUtility::Encoding::Gzip;
+  } else if (coding == Headers::get().ContentEncodingValues.Deflate) {
+    return CompressionUtility::Encoding::Deflate;
+  } else if (coding == Headers::get().ContentEncodingValues.Brotli) {
+    return CompressionUtility::Encoding::Brotli;
+  } else if (coding == Headers::get().ContentEncodingValues.Zstd) {
+    return CompressionUtility::Encoding::Zstd;
+  }
+  return CompressionUtility::Encoding::Identity;
+}
+
+/**
+ * Add "Accept-Encoding" to the Vary headers of a response which may be compressed, unless it
+ * already varies on it or on everything.
+ */
+void addVaryAcceptEncoding(HeaderMap& headers) {
+  const std::string& accept_encoding = Headers::get().AcceptEncoding.get();
+  bool present = false;
+  Utility::forEachHeaderElement(headers, Headers::get().Vary, [&](const std::string& name) {
+    if (name == "*" ||
+        StringUtil::caseInsensitiveCompare(name.c_str(), accept_encoding.c_str()) == 0) {
+      present = true;
+    }
+  });
+  if (!present) {
+    headers.addReferenceKey(Headers::get().Vary, accept_encoding);
+  }
+}
+
+/**
+ * A compressed body is a different representation, so a strong ETag of the uncompressed body
+ * becomes a weak one.
+ */
+void weakenEtag(HeaderMap& headers) {
+  const HeaderEntry* etag = headers.get(Headers::get().Etag);
+  if (etag == nullptr || StringUtil::startsWith(etag->value().c_str(), "W/")) {
+    return;
+  }
+
+  const std::string weak_etag = std::string("W/") + etag->value().c_str();
+  headers.remove(Headers::get().Etag);
+  headers.addCopy(Headers::get().Etag, weak_etag);
+}
+
+} // namespace
+
+CompressionUtility::Encoding
+CompressionUtility::selectEncoding(const HeaderMap& request_headers,
+                                   const std::vector<Encoding>& encodings) {
+  // The quality values of the listed codings, and of "*" if it is listed.
+  std::map<Encoding, double> coding_q;
+  double any_q = -1;
+  Utility::forEachHeaderElement(
+      request_headers, Headers::get().AcceptEncoding, [&](const std::string& element) {
+        const std::vector<std::string> params = StringUtil::split(element, ';');
+        if (params.empty()) {
+          return;
+        }
+
+        const std::string coding = toLower(trim(params[0]));
+        const double q = qualityValue(params);
+        const Encoding encoding = encodingFromName(coding);
+        if (encoding != Encoding::Identity) {
+          double& encoding_q = coding_q.emplace(encoding, q).first->second;
+          encoding_q = std::max(encoding_q, q);
+        } else if (coding == "*") {
+          any_q = std::max(any_q, q);
+        }
+      });
+
+  Encoding selected = Encoding::Identity;
+  double selected_q = 0;
+  for (const Encoding encoding : encodings) {
+    const auto it = coding_q.find(encoding);
+    const double q = it != coding_q.end() ? it->second : any_q;
+    if (q > selected_q) {
+      selected = encoding;
+      selected_q = q;
+    }
+  }
+  return selected;
+}
+
+const std::string& CompressionUtility::contentEncoding(Encoding encoding) {
+  switch (encoding) {
+  case Encoding::Gzip:
+    return Headers::get().ContentEncodingValues.Gzip;
+  case Encoding::Deflate:
+    return Headers::get().ContentEncodingValues.Deflate;
+  case Encoding::Brotli:
+    return Headers::get().ContentEncodingValues.Brotli;
+  case Encoding::Zstd:
+    return Headers::get().ContentEncodingValues.Zstd;
+  case Encoding::Identity:
+    break;
+  }
+  NOT_REACHED;
+}
+
+CompressionFilterConfig::CompressionFilterConfig(
+    Compressor::ZlibCompressorImpl::CompressionLevel level,
+    Compressor::ZlibCompressorImpl::CompressionStrategy strategy, uint64_t window_bits,
+    uint64_t memory_level, uint32_t brotli_quality, int32_t zstd_level,
+    const std::vector<CompressionUtility::Encoding>& encodings, uint64_t min_content_length,
+    const std::vector<std::string>& content_types, const std::string& stats_prefix,
+    Stats::Scope& scope, ThreadLocal::SlotAllocator& tls)
+    : level_(level), strategy_(strategy), window_bits_(window_bits), memory_level_(memory_level),
+      brotli_quality_(brotli_quality), zstd_level_(zstd_level), encodings_(encodings),
+      min_content_length_(min_content_length), stats_(generateStats(stats_prefix, scope)),
+      tls_slot_(tls.allocateSlot()) {
+  for (const std::string& content_type : content_types) {
+    content_types_.insert(toLower(content_type));
+  }
+
+  tls_slot_->set([](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<CompressorPool>();
+  });
+}
+
+CompressionFilterStats CompressionFilterConfig::generateStats(const std::string& prefix,
+                                                              Stats::Scope& scope) {
+  const std::string final_prefix = prefix + "compression.";
+  return {ALL_COMPRESSION_FILTER_STATS(POOL_COUNTER_PREFIX(scope, final_prefix))};
+}
+
+bool CompressionFilterConfig::compressible(const HeaderMap& headers) const {
+  if (headers.get(Headers::get().ContentEncoding) != nullptr) {
+    return false;
+  }
+
+  const std::string& no_transform_value = Headers::get().CacheControlValues.NoTransform;
+  bool no_transform = false;
+  auto check_directive = [&](const std::string& directive) {
+    if (StringUtil::caseInsensitiveCompare(directive.c_str(), no_transform_value.c_str()) == 0) {
+      no_transform = true;
+    }
+  };
+  Utility::forEachHeaderElement(headers, Headers::get().CacheControl, check_directive);
+  if (no_transform) {
+    return false;
+  }
+
+  if (headers.ContentType() == nullptr) {
+    return false;
+  }
+  const std::string content_type = headers.ContentType()->value().c_str();
+  if (content_types_.count(toLower(trim(content_type.substr(0, content_type.find(';'))))) == 0) {
+    return false;
+  }
+
+  if (headers.ContentLength() != nullptr) {
+    uint64_t length;
+    if (StringUtil::atoul(headers.ContentLength()->value().c_str(), length) &&
+        length < min_content_length_) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+std::vector<Compressor::CompressorPtr>&
+CompressionFilterConfig::pooledCompressors(CompressionUtility::Encoding encoding) {
+  CompressorPool& pool = tls_slot_->getTyped<CompressorPool>();
+  switch (encoding) {
+  case CompressionUtility::Encoding::Gzip:
+    return pool.gzip_;
+  case CompressionUtility::Encoding::Deflate:
+    return pool.deflate_;
+  case CompressionUtility::Encoding::Brotli:
+    return pool.brotli_;
+  case CompressionUtility::Encoding::Zstd:
+    return pool.zstd_;
+  case CompressionUtility::Encoding::Identity:
+    break;
+  }
+  NOT_REACHED;
+}
+
+Compressor::CompressorPtr
+CompressionFilterConfig::acquireCompressor(CompressionUtility::Encoding encoding) {
+  std::vector<Compressor::CompressorPtr>& pool = pooledCompressors(encoding);
+  if (!pool.empty()) {
+    Compressor::CompressorPtr compressor = std::move(pool.back());
+    pool.pop_back();
+    return compressor;
+  }
+
+  if (encoding == CompressionUtility::Encoding::Brotli) {
+    std::unique_ptr<Compressor::BrotliCompressorImpl> compressor(
+        new Compressor::BrotliCompressorImpl());
+    compressor->init(brotli_quality_, BROTLI_WINDOW_BITS);
+    return std::move(compressor);
+  }
+
+  if (encoding == CompressionUtility::Encoding::Zstd) {
+    std::unique_ptr<Compressor::ZstdCompressorImpl> compressor(
+        new Compressor::ZstdCompressorImpl());
+    compressor->init(zstd_level_);
+    return std::move(compressor);
+  }
+
+  Compressor::ZlibCompressorImplPtr compressor(new Compressor::ZlibCompressorImpl());
+  // zlib wraps the stream in the zlib format of the deflate content coding, or in a gzip header and
+  // trailer if 16 is added to the window bits.
+  compressor->init(level_, strategy_,
+                   encoding == CompressionUtility::Encoding::Gzip ? window_bits_ + 16
+                                                                  : window_bits_,
+                   memory_level_);
+  return std::move(compressor);
+}
+
+void CompressionFilterConfig::releaseCompressor(CompressionUtility::Encoding encoding,
+                                                Compressor::CompressorPtr compressor) {
+  std::vector<Compressor::CompressorPtr>& pool = pooledCompressors(encoding);
+  if (pool.size() < MAX_POOLED_COMPRESSORS) {
+    compressor->reset();
+    pool.push_back(std::move(compressor));
+  }
+}
+
+CompressionFilter::CompressionFilter(CompressionFilterConfigSharedPtr config) : config_(config) {}
+
+FilterHeadersStatus CompressionFilter::decodeHeaders(HeaderMap& headers, bool) {
+  encoding_ = CompressionUtility::selectEncoding(headers, config_->encodings());
+  if (encoding_ == CompressionUtility::Encoding::Identity) {
+    config_->stats().no_accept_header_.inc();
+  }
+  return FilterHeadersStatus::Continue;
+}
+
+FilterHeadersStatus CompressionFilter::encodeHeaders(HeaderMap& headers, bool end_stream) {
+  if (end_stream || !config_->compressible(headers)) {
+    config_->stats().not_compressed_.inc();
+    return FilterHeadersStatus::Continue;
+  }
+
+  // Caches must not serve this response to clients which accept a different coding, even if this
+  // client gets it uncompressed.
+  addVaryAcceptEncoding(headers);
+  if (encoding_ == CompressionUtility::Encoding::Identity) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  compressor_ = config_->acquireCompressor(encoding_);
+  headers.removeContentLength();
+  headers.addReferenceKey(Headers::get().ContentEncoding,
+                          CompressionUtility::contentEncoding(encoding_));
+  weakenEtag(headers);
+  config_->stats().compressed_.inc();
+  return FilterHeadersStatus::Continue;
+}
+
+FilterDataStatus CompressionFilter::encodeData(Buffer::Instance& data, bool end_stream) {
+  if (!compressor_) {
+    return FilterDataStatus::Continue;
+  }
+
+  config_->stats().total_uncompressed_bytes_.add(data.length());
+  Buffer::OwnedImpl compressed;
+  compressor_->compress(data, compressed);
+  if (end_stream) {
+    compressor_->finish(compressed);
+    releaseCompressor();
+  }
+
+  data.drain(data.length());
+  data.move(compressed);
+  config_->stats().total_compressed_bytes_.add(data.length());
+  return FilterDataStatus::Continue;
+}
+
+FilterTrailersStatus CompressionFilter::encodeTrailers(HeaderMap&) {
+  if (!compressor_) {
+    return FilterTrailersStatus::Continue;
+  }
+
+  Buffer::OwnedImpl compressed;
+  compressor_->finish(compressed);
+  releaseCompressor();
+  config_->stats().total_compressed_bytes_.add(compressed.length());
+  encoder_callbacks_->addEncodedData(compressed, true);
+  return FilterTrailersStatus::Continue;
+}
+
+void CompressionFilter::releaseCompressor() {
+  if (compressor_) {
+    config_->releaseCompressor(encoding_, std::move(compressor_));
+  }
+}
+
+} // namespace Http
+} // namespace Envoy
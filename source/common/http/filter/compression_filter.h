@@ -0,0 +1,199 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "envoy/http/filter.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "envoy/compressor/compressor.h"
+
+#include "common/compressor/zlib_compressor_impl.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * All stats for the compression filter. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_COMPRESSION_FILTER_STATS(COUNTER)                                                      \
+  COUNTER(compressed)                                                                              \
+  COUNTER(not_compressed)                                                                          \
+  COUNTER(no_accept_header)                                                                        \
+  COUNTER(total_uncompressed_bytes)                                                                \
+  COUNTER(total_compressed_bytes)
+// clang-format on
+
+/**
+ * Wrapper struct for compression filter stats. @see stats_macros.h
+ */
+struct CompressionFilterStats {
+  ALL_COMPRESSION_FILTER_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Compression utility routines.
+ */
+class CompressionUtility {
+public:
+  enum class Encoding { Identity, Gzip, Deflate, Brotli, Zstd };
+
+  /**
+   * Choose the content coding of a response from the Accept-Encoding headers of the request.
+   * @param request_headers supplies the request headers.
+   * @param encodings supplies the codings which may be used, in order of preference.
+   * @return Encoding the accepted coding with the highest quality value, the earliest of the
+   *         encodings being preferred among codings accepted with the same quality, or Identity if
+   *         none of the encodings is accepted.
+   */
+  static Encoding selectEncoding(const HeaderMap& request_headers,
+                                 const std::vector<Encoding>& encodings);
+
+  /**
+   * @param encoding supplies a coding other than Identity.
+   * @return const std::string& the Content-Encoding value of the coding.
+   */
+  static const std::string& contentEncoding(Encoding encoding);
+};
+
+/**
+ * Configuration for the compression filter.
+ */
+class CompressionFilterConfig {
+public:
+  /**
+   * @param level supplies the zlib compression level.
+   * @param strategy supplies the zlib compression strategy.
+   * @param window_bits supplies the base two logarithm of the zlib window size.
+   * @param memory_level supplies how much memory zlib uses for its internal state.
+   * @param brotli_quality supplies the Brotli compression quality.
+   * @param zstd_level supplies the zstd compression level.
+   * @param encodings supplies the codings which may be used, in order of preference.
+   * @param min_content_length supplies the smallest Content-Length of a response to compress.
+   * @param content_types supplies the media types of the responses to compress.
+   * @param stats_prefix supplies the prefix of the filter stats.
+   * @param scope supplies the scope of the filter stats.
+   * @param tls supplies the slot allocator for the per worker compressor pools.
+   */
+  CompressionFilterConfig(Compressor::ZlibCompressorImpl::CompressionLevel level,
+                          Compressor::ZlibCompressorImpl::CompressionStrategy strategy,
+                          uint64_t window_bits, uint64_t memory_level, uint32_t brotli_quality,
+                          int32_t zstd_level,
+                          const std::vector<CompressionUtility::Encoding>& encodings,
+                          uint64_t min_content_length,
+                          const std::vector<std::string>& content_types,
+                          const std::string& stats_prefix, Stats::Scope& scope,
+                          ThreadLocal::SlotAllocator& tls);
+
+  /**
+   * @param headers supplies the response headers.
+   * @return bool whether the response may be compressed. Responses which are already encoded, are
+   *         marked no-transform, have a media type which isn't configured or are shorter than
+   *         the minimum length are not compressed.
+   */
+  bool compressible(const HeaderMap& headers) const;
+
+  /**
+   * @return const std::vector<CompressionUtility::Encoding>& the codings which may be used, in
+   *         order of preference.
+   */
+  const std::vector<CompressionUtility::Encoding>& encodings() const { return encodings_; }
+
+  /**
+   * Take a compressor from the pool of this worker, or initialize a new one if the pool is empty.
+   * @param encoding supplies the coding to compress with, which must not be Identity.
+   * @return Compressor::CompressorPtr the compressor.
+   */
+  Compressor::CompressorPtr acquireCompressor(CompressionUtility::Encoding encoding);
+
+  /**
+   * Reset a compressor and return it to the pool of this worker, or free it if the pool is full.
+   * @param encoding supplies the coding which the compressor was acquired for.
+   * @param compressor supplies the compressor.
+   */
+  void releaseCompressor(CompressionUtility::Encoding encoding,
+                         Compressor::CompressorPtr compressor);
+
+  CompressionFilterStats& stats() { return stats_; }
+
+  // Initialized compressors hold a few hundred KiB each with the default window and memory level,
+  // so only a bounded number of them are kept by each worker for each coding.
+  static const uint32_t MAX_POOLED_COMPRESSORS = 16;
+
+  // The window of the Brotli compressors, 4MiB, as used by default by the Brotli library.
+  static const uint32_t BROTLI_WINDOW_BITS = 22;
+
+private:
+  struct CompressorPool : public ThreadLocal::ThreadLocalObject {
+    std::vector<Compressor::CompressorPtr> gzip_;
+    std::vector<Compressor::CompressorPtr> deflate_;
+    std::vector<Compressor::CompressorPtr> brotli_;
+    std::vector<Compressor::CompressorPtr> zstd_;
+  };
+
+  static CompressionFilterStats generateStats(const std::string& prefix, Stats::Scope& scope);
+  std::vector<Compressor::CompressorPtr>& pooledCompressors(CompressionUtility::Encoding encoding);
+
+  const Compressor::ZlibCompressorImpl::CompressionLevel level_;
+  const Compressor::ZlibCompressorImpl::CompressionStrategy strategy_;
+  const uint64_t window_bits_;
+  const uint64_t memory_level_;
+  const uint32_t brotli_quality_;
+  const int32_t zstd_level_;
+  const std::vector<CompressionUtility::Encoding> encodings_;
+  const uint64_t min_content_length_;
+  std::unordered_set<std::string> content_types_;
+  CompressionFilterStats stats_;
+  ThreadLocal::SlotPtr tls_slot_;
+};
+
+typedef std::shared_ptr<CompressionFilterConfig> CompressionFilterConfigSharedPtr;
+
+/**
+ * A filter which compresses response bodies with gzip, deflate, Brotli or zstd, as accepted by the
+ * client and configured. Each data frame is compressed as it passes through the filter, so bodies
+ * are never buffered in full. The compressor of a finished stream is reset and reused by a later
+ * stream on the same worker.
+ */
+class CompressionFilter : public StreamFilter {
+public:
+  CompressionFilter(CompressionFilterConfigSharedPtr config);
+
+  // Http::StreamFilterBase
+  void onDestroy() override { releaseCompressor(); }
+
+  // Http::StreamDecoderFilter
+  FilterHeadersStatus decodeHeaders(HeaderMap& headers, bool end_stream) override;
+  FilterDataStatus decodeData(Buffer::Instance&, bool) override {
+    return FilterDataStatus::Continue;
+  }
+  FilterTrailersStatus decodeTrailers(HeaderMap&) override {
+    return FilterTrailersStatus::Continue;
+  }
+  void setDecoderFilterCallbacks(StreamDecoderFilterCallbacks&) override {}
+
+  // Http::StreamEncoderFilter
+  FilterHeadersStatus encodeHeaders(HeaderMap& headers, bool end_stream) override;
+  FilterDataStatus encodeData(Buffer::Instance& data, bool end_stream) override;
+  FilterTrailersStatus encodeTrailers(HeaderMap& trailers) override;
+  void setEncoderFilterCallbacks(StreamEncoderFilterCallbacks& callbacks) override {
+    encoder_callbacks_ = &callbacks;
+  }
+
+private:
+  void releaseCompressor();
+
+  CompressionFilterConfigSharedPtr config_;
+  StreamEncoderFilterCallbacks* encoder_callbacks_{};
+  CompressionUtility::Encoding encoding_{CompressionUtility::Encoding::Identity};
+  // Set while the response is being compressed.
+  Compressor::CompressorPtr compressor_;
+};
+
+} // namespace Http
+} // namespace Envoy
@@ -1,16 +1,12 @@
 #include "common/http/filter/cors_filter.h"
 
-#include "envoy/http/codes.h"
-
-#include "common/common/empty_string.h"
-#include "common/common/enum_to_int.h"
 #include "common/http/header_map_impl.h"
 #include "common/http/headers.h"
 
 namespace Envoy {
 namespace Http {
 
-CorsFilter::CorsFilter() : policies_({{nullptr, nullptr}}), is_cors_request_(false) {}
+CorsFilter::CorsFilter() : is_cors_request_(false) {}
 
 // This handles the CORS preflight request as described in #6.2
 // https://www.w3.org/TR/cors/
@@ -20,12 +16,13 @@ FilterHeadersStatus CorsFilter::decodeHeaders(HeaderMap& headers, bool) {
     return FilterHeadersStatus::Continue;
   }
 
-  policies_ = {{
-      decoder_callbacks_->route()->routeEntry()->corsPolicy(),
-      decoder_callbacks_->route()->routeEntry()->virtualHost().corsPolicy(),
-  }};
+  const Router::RouteEntry* route_entry = decoder_callbacks_->route()->routeEntry();
+  policy_ = route_entry->corsPolicy();
+  if (policy_ == nullptr) {
+    policy_ = route_entry->virtualHost().corsPolicy();
+  }
 
-  if (!enabled()) {
+  if (policy_ == nullptr || !policy_->enabled()) {
     return FilterHeadersStatus::Continue;
   }
 
@@ -34,7 +31,7 @@ FilterHeadersStatus CorsFilter::decodeHeaders(HeaderMap& headers, bool) {
     return FilterHeadersStatus::Continue;
   }
 
-  if (!isOriginAllowed(origin_->value())) {
+  if (!policy_->allowsOrigin(origin_->value())) {
     return FilterHeadersStatus::Continue;
   }
 
@@ -50,32 +47,8 @@ FilterHeadersStatus CorsFilter::decodeHeaders(HeaderMap& headers, bool) {
     return FilterHeadersStatus::Continue;
   }
 
-  HeaderMapPtr response_headers{
-      new HeaderMapImpl{{Headers::get().Status, std::to_string(enumToInt(Http::Code::OK))}}};
-
+  HeaderMapPtr response_headers{new HeaderMapImpl(policy_->preflightHeaders())};
   response_headers->insertAccessControlAllowOrigin().value(*origin_);
-
-  if (allowCredentials()) {
-    response_headers->insertAccessControlAllowCredentials().value(
-        Http::Headers::get().CORSValues.True);
-  }
-
-  if (!allowMethods().empty()) {
-    response_headers->insertAccessControlAllowMethods().value(allowMethods());
-  }
-
-  if (!allowHeaders().empty()) {
-    response_headers->insertAccessControlAllowHeaders().value(allowHeaders());
-  }
-
-  if (!exposeHeaders().empty()) {
-    response_headers->insertAccessControlExposeHeaders().value(exposeHeaders());
-  }
-
-  if (!maxAge().empty()) {
-    response_headers->insertAccessControlMaxAge().value(maxAge());
-  }
-
   decoder_callbacks_->encodeHeaders(std::move(response_headers), true);
 
   return FilterHeadersStatus::StopIteration;
@@ -100,79 +73,8 @@ void CorsFilter::setDecoderFilterCallbacks(StreamDecoderFilterCallbacks& callbac
   decoder_callbacks_ = &callbacks;
 };
 
-bool CorsFilter::isOriginAllowed(const Http::HeaderString& origin) {
-  if (allowOrigins() == nullptr) {
-    return false;
-  }
-  for (const auto& o : *allowOrigins()) {
-    if (o == "*" || origin == o.c_str()) {
-      return true;
-    }
-  }
-  return false;
-}
-
-const std::list<std::string>* CorsFilter::allowOrigins() {
-  for (const auto policy : policies_) {
-    if (policy && !policy->allowOrigins().empty()) {
-      return &policy->allowOrigins();
-    }
-  }
-  return nullptr;
-}
-
-const std::string& CorsFilter::allowMethods() {
-  for (const auto policy : policies_) {
-    if (policy && !policy->allowMethods().empty()) {
-      return policy->allowMethods();
-    }
-  }
-  return EMPTY_STRING;
-}
-
-const std::string& CorsFilter::allowHeaders() {
-  for (const auto policy : policies_) {
-    if (policy && !policy->allowHeaders().empty()) {
-      return policy->allowHeaders();
-    }
-  }
-  return EMPTY_STRING;
-}
-
-const std::string& CorsFilter::exposeHeaders() {
-  for (const auto policy : policies_) {
-    if (policy && !policy->exposeHeaders().empty()) {
-      return policy->exposeHeaders();
-    }
-  }
-  return EMPTY_STRING;
-}
-
-const std::string& CorsFilter::maxAge() {
-  for (const auto policy : policies_) {
-    if (policy && !policy->maxAge().empty()) {
-      return policy->maxAge();
-    }
-  }
-  return EMPTY_STRING;
-}
-
 bool CorsFilter::allowCredentials() {
-  for (const auto policy : policies_) {
-    if (policy && policy->allowCredentials().valid()) {
-      return policy->allowCredentials().value();
-    }
-  }
-  return false;
-}
-
-bool CorsFilter::enabled() {
-  for (const auto policy : policies_) {
-    if (policy) {
-      return policy->enabled();
-    }
-  }
-  return false;
+  return policy_->allowCredentials().valid() && policy_->allowCredentials().value();
 }
 
 } // namespace Http
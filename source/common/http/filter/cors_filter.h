@@ -39,18 +39,12 @@ public:
 private:
   friend class CorsFilterTest;
 
-  const std::list<std::string>* allowOrigins();
-  const std::string& allowMethods();
-  const std::string& allowHeaders();
-  const std::string& exposeHeaders();
-  const std::string& maxAge();
   bool allowCredentials();
-  bool enabled();
-  bool isOriginAllowed(const Http::HeaderString& origin);
 
   StreamDecoderFilterCallbacks* decoder_callbacks_{};
   StreamEncoderFilterCallbacks* encoder_callbacks_{};
-  std::array<const Envoy::Router::CorsPolicy*, 2> policies_;
+  // The route policy, which is already merged with the virtual host one, or else the latter.
+  const Envoy::Router::CorsPolicy* policy_{};
   bool is_cors_request_{};
   const Http::HeaderEntry* origin_{};
 };
@@ -0,0 +1,113 @@
+#include "common/http/filter/decompression_filter.h"
+
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/utility.h"
+#include "common/decompressor/brotli_decompressor_impl.h"
+#include "common/decompressor/zlib_decompressor_impl.h"
+#include "common/decompressor/zstd_decompressor_impl.h"
+#include "common/http/headers.h"
+#include "common/http/utility.h"
+
+namespace Envoy {
+namespace Http {
+
+DecompressionFilterConfig::DecompressionFilterConfig(uint64_t max_decompressed_bytes,
+                                                     const std::string& stats_prefix,
+                                                     Stats::Scope& scope)
+    : max_decompressed_bytes_(max_decompressed_bytes),
+      stats_(generateStats(stats_prefix, scope)) {}
+
+DecompressionFilterStats DecompressionFilterConfig::generateStats(const std::string& prefix,
+                                                                  Stats::Scope& scope) {
+  const std::string final_prefix = prefix + "decompression.";
+  return {ALL_DECOMPRESSION_FILTER_STATS(POOL_COUNTER_PREFIX(scope, final_prefix))};
+}
+
+DecompressionFilter::DecompressionFilter(DecompressionFilterConfigSharedPtr config)
+    : config_(config) {}
+
+FilterHeadersStatus DecompressionFilter::decodeHeaders(HeaderMap& headers, bool end_stream) {
+  if (end_stream || headers.get(Headers::get().ContentEncoding) == nullptr) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  std::vector<std::string> codings;
+  Utility::forEachHeaderElement(headers, Headers::get().ContentEncoding,
+                                [&codings](const std::string& coding) {
+                                  codings.push_back(coding);
+                                });
+  auto is = [&codings](const std::string& value) -> bool {
+    return StringUtil::caseInsensitiveCompare(codings[0].c_str(), value.c_str()) == 0;
+  };
+
+  // Only a single coding is decoded. Bodies with several codings are passed through unchanged.
+  if (codings.size() == 1 && (is(Headers::get().ContentEncodingValues.Gzip) || is("x-gzip"))) {
+    Decompressor::ZlibDecompressorImplPtr decompressor(new Decompressor::ZlibDecompressorImpl());
+    // Adding 16 to the window bits makes zlib read a gzip header and trailer.
+    decompressor->init(15 + 16);
+    decompressor_ = std::move(decompressor);
+  } else if (codings.size() == 1 && is(Headers::get().ContentEncodingValues.Deflate)) {
+    Decompressor::ZlibDecompressorImplPtr decompressor(new Decompressor::ZlibDecompressorImpl());
+    decompressor->init(15);
+    decompressor_ = std::move(decompressor);
+  } else if (codings.size() == 1 && is(Headers::get().ContentEncodingValues.Brotli)) {
+    decompressor_.reset(new Decompressor::BrotliDecompressorImpl());
+  } else if (codings.size() == 1 && is(Headers::get().ContentEncodingValues.Zstd)) {
+    decompressor_.reset(new Decompressor::ZstdDecompressorImpl());
+  } else {
+    config_->stats().not_decompressed_.inc();
+    return FilterHeadersStatus::Continue;
+  }
+
+  headers.remove(Headers::get().ContentEncoding);
+  headers.removeContentLength();
+  config_->stats().decompressed_.inc();
+  return FilterHeadersStatus::Continue;
+}
+
+FilterDataStatus DecompressionFilter::decodeData(Buffer::Instance& data, bool end_stream) {
+  if (!decompressor_) {
+    return FilterDataStatus::Continue;
+  }
+
+  config_->stats().total_compressed_bytes_.add(data.length());
+  Buffer::OwnedImpl decompressed;
+  decompressor_->decompress(data, decompressed);
+  data.drain(data.length());
+
+  if (decompressor_->failed() || (end_stream && !decompressor_->finished())) {
+    resetStream(config_->stats().decompression_error_);
+    return FilterDataStatus::StopIterationNoBuffer;
+  }
+
+  decompressed_bytes_ += decompressed.length();
+  if (config_->maxDecompressedBytes() > 0 &&
+      decompressed_bytes_ > config_->maxDecompressedBytes()) {
+    resetStream(config_->stats().too_large_);
+    return FilterDataStatus::StopIterationNoBuffer;
+  }
+
+  config_->stats().total_decompressed_bytes_.add(decompressed.length());
+  data.move(decompressed);
+  return FilterDataStatus::Continue;
+}
+
+FilterTrailersStatus DecompressionFilter::decodeTrailers(HeaderMap&) {
+  if (decompressor_ && !decompressor_->finished()) {
+    resetStream(config_->stats().decompression_error_);
+    return FilterTrailersStatus::StopIteration;
+  }
+  return FilterTrailersStatus::Continue;
+}
+
+void DecompressionFilter::resetStream(Stats::Counter& counter) {
+  counter.inc();
+  decompressor_.reset();
+  decoder_callbacks_->resetStream();
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "envoy/http/filter.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "envoy/decompressor/decompressor.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * All stats for the decompression filter. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_DECOMPRESSION_FILTER_STATS(COUNTER)                                                    \
+  COUNTER(decompressed)                                                                            \
+  COUNTER(not_decompressed)                                                                        \
+  COUNTER(decompression_error)                                                                     \
+  COUNTER(too_large)                                                                               \
+  COUNTER(total_compressed_bytes)                                                                  \
+  COUNTER(total_decompressed_bytes)
+// clang-format on
+
+/**
+ * Wrapper struct for decompression filter stats. @see stats_macros.h
+ */
+struct DecompressionFilterStats {
+  ALL_DECOMPRESSION_FILTER_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Configuration for the decompression filter.
+ */
+class DecompressionFilterConfig {
+public:
+  /**
+   * @param max_decompressed_bytes supplies the size limit of a decompressed request body, or 0 for
+   *        no limit.
+   * @param stats_prefix supplies the prefix of the filter stats.
+   * @param scope supplies the scope of the filter stats.
+   */
+  DecompressionFilterConfig(uint64_t max_decompressed_bytes, const std::string& stats_prefix,
+                            Stats::Scope& scope);
+
+  DecompressionFilterStats& stats() { return stats_; }
+  uint64_t maxDecompressedBytes() const { return max_decompressed_bytes_; }
+
+private:
+  static DecompressionFilterStats generateStats(const std::string& prefix, Stats::Scope& scope);
+
+  const uint64_t max_decompressed_bytes_;
+  DecompressionFilterStats stats_;
+};
+
+typedef std::shared_ptr<DecompressionFilterConfig> DecompressionFilterConfigSharedPtr;
+
+/**
+ * A filter which decompresses request bodies with a gzip, deflate, br or zstd Content-Encoding, so
+ * that upstreams receive them in plain text. Each data frame is decompressed as it passes through
+ * the filter, so the body is never buffered in full and the usual flow control of the upstream
+ * request applies. Since the request headers have already been sent upstream by then, a corrupt,
+ * truncated or oversized body resets the stream.
+ */
+class DecompressionFilter : public StreamDecoderFilter {
+public:
+  DecompressionFilter(DecompressionFilterConfigSharedPtr config);
+
+  // Http::StreamFilterBase
+  void onDestroy() override {}
+
+  // Http::StreamDecoderFilter
+  FilterHeadersStatus decodeHeaders(HeaderMap& headers, bool end_stream) override;
+  FilterDataStatus decodeData(Buffer::Instance& data, bool end_stream) override;
+  FilterTrailersStatus decodeTrailers(HeaderMap& trailers) override;
+  void setDecoderFilterCallbacks(StreamDecoderFilterCallbacks& callbacks) override {
+    decoder_callbacks_ = &callbacks;
+  }
+
+private:
+  void resetStream(Stats::Counter& counter);
+
+  DecompressionFilterConfigSharedPtr config_;
+  StreamDecoderFilterCallbacks* decoder_callbacks_{};
+  // Set while the request body is being decompressed.
+  Decompressor::DecompressorPtr decompressor_;
+  uint64_t decompressed_bytes_{};
+};
+
+} // namespace Http
+} // namespace Envoy
@@ -18,22 +18,27 @@
 #include "common/http/utility.h"
 #include "common/protobuf/utility.h"
 #include "common/router/config_impl.h"
+#include "common/runtime/key_registry.h"
 
 #include "fmt/format.h"
 
 namespace Envoy {
 namespace Http {
 
-const std::string FaultFilter::DELAY_PERCENT_KEY = "fault.http.delay.fixed_delay_percent";
-const std::string FaultFilter::ABORT_PERCENT_KEY = "fault.http.abort.abort_percent";
-const std::string FaultFilter::DELAY_DURATION_KEY = "fault.http.delay.fixed_duration_ms";
-const std::string FaultFilter::ABORT_HTTP_STATUS_KEY = "fault.http.abort.http_status";
+const Runtime::Key FaultFilterConfig::DELAY_PERCENT_KEY =
+    Runtime::KeyRegistry::registerKey("fault.http.delay.fixed_delay_percent");
+const Runtime::Key FaultFilterConfig::ABORT_PERCENT_KEY =
+    Runtime::KeyRegistry::registerKey("fault.http.abort.abort_percent");
+const Runtime::Key FaultFilterConfig::DELAY_DURATION_KEY =
+    Runtime::KeyRegistry::registerKey("fault.http.delay.fixed_duration_ms");
+const Runtime::Key FaultFilterConfig::ABORT_HTTP_STATUS_KEY =
+    Runtime::KeyRegistry::registerKey("fault.http.abort.http_status");
 
 FaultFilterConfig::FaultFilterConfig(const envoy::api::v2::filter::http::HTTPFault& fault,
                                      Runtime::Loader& runtime, const std::string& stats_prefix,
-                                     Stats::Scope& scope)
+                                     Stats::Scope& scope, ThreadLocal::SlotAllocator& tls)
     : runtime_(runtime), stats_(generateStats(stats_prefix, scope)), stats_prefix_(stats_prefix),
-      scope_(scope) {
+      scope_(scope), tls_(tls.allocateSlot()) {
 
   if (!fault.has_abort() && !fault.has_delay()) {
     throw EnvoyException("fault filter must have at least abort or delay specified in the config.");
@@ -59,6 +64,44 @@ FaultFilterConfig::FaultFilterConfig(const envoy::api::v2::filter::http::HTTPFau
   for (const auto& node : fault.downstream_nodes()) {
     downstream_nodes_.insert(node);
   }
+
+  tls_->set([](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<ThreadLocalState>();
+  });
+}
+
+bool FaultFilterConfig::inactive(const std::string& downstream_cluster) {
+  ThreadLocalState& state = tls_->getTyped<ThreadLocalState>();
+  const Runtime::Snapshot& snapshot = runtime_.snapshot();
+  if (!state.loaded_ || snapshot.version() != state.snapshot_version_) {
+    state.loaded_ = true;
+    state.snapshot_version_ = snapshot.version();
+    state.inactive_.clear();
+  }
+
+  auto it = state.inactive_.find(downstream_cluster);
+  if (it != state.inactive_.end()) {
+    return it->second;
+  }
+
+  // A percentage of 0 never enables a fault, and the downstream cluster keys apply on top of the
+  // global ones.
+  bool inactive = snapshot.getInteger(DELAY_PERCENT_KEY, fixed_delay_percent_) == 0 &&
+                  snapshot.getInteger(ABORT_PERCENT_KEY, abort_percent_) == 0;
+  if (inactive && !downstream_cluster.empty()) {
+    inactive = snapshot.getInteger(
+                   fmt::format("fault.http.{}.delay.fixed_delay_percent", downstream_cluster),
+                   fixed_delay_percent_) == 0 &&
+               snapshot.getInteger(
+                   fmt::format("fault.http.{}.abort.abort_percent", downstream_cluster),
+                   abort_percent_) == 0;
+  }
+
+  if (state.inactive_.size() >= MAX_CACHED_DOWNSTREAM_CLUSTERS) {
+    state.inactive_.clear();
+  }
+  state.inactive_.emplace(downstream_cluster, inactive);
+  return inactive;
 }
 
 FaultFilter::FaultFilter(FaultFilterConfigSharedPtr config) : config_(config) {}
@@ -70,6 +113,13 @@ FaultFilter::~FaultFilter() { ASSERT(!delay_timer_); }
 // if we inject a delay, then we will inject the abort in the delay timer
 // callback.
 FilterHeadersStatus FaultFilter::decodeHeaders(HeaderMap& headers, bool) {
+  // Most requests see no fault at all, so find that out before any matching.
+  if (config_->inactive(headers.EnvoyDownstreamServiceCluster()
+                            ? headers.EnvoyDownstreamServiceCluster()->value().c_str()
+                            : EMPTY_STRING)) {
+    return FilterHeadersStatus::Continue;
+  }
+
   if (!matchesTargetUpstreamCluster()) {
     return FilterHeadersStatus::Continue;
   }
@@ -114,8 +164,8 @@ FilterHeadersStatus FaultFilter::decodeHeaders(HeaderMap& headers, bool) {
 }
 
 bool FaultFilter::isDelayEnabled() {
-  bool enabled =
-      config_->runtime().snapshot().featureEnabled(DELAY_PERCENT_KEY, config_->delayPercent());
+  bool enabled = config_->runtime().snapshot().featureEnabled(
+      FaultFilterConfig::DELAY_PERCENT_KEY, config_->delayPercent());
 
   if (!downstream_cluster_delay_percent_key_.empty()) {
     enabled |= config_->runtime().snapshot().featureEnabled(downstream_cluster_delay_percent_key_,
@@ -126,8 +176,8 @@ bool FaultFilter::isDelayEnabled() {
 }
 
 bool FaultFilter::isAbortEnabled() {
-  bool enabled =
-      config_->runtime().snapshot().featureEnabled(ABORT_PERCENT_KEY, config_->abortPercent());
+  bool enabled = config_->runtime().snapshot().featureEnabled(
+      FaultFilterConfig::ABORT_PERCENT_KEY, config_->abortPercent());
 
   if (!downstream_cluster_abort_percent_key_.empty()) {
     enabled |= config_->runtime().snapshot().featureEnabled(downstream_cluster_abort_percent_key_,
@@ -144,8 +194,8 @@ Optional<uint64_t> FaultFilter::delayDuration() {
     return ret;
   }
 
-  uint64_t duration =
-      config_->runtime().snapshot().getInteger(DELAY_DURATION_KEY, config_->delayDuration());
+  uint64_t duration = config_->runtime().snapshot().getInteger(
+      FaultFilterConfig::DELAY_DURATION_KEY, config_->delayDuration());
   if (!downstream_cluster_delay_duration_key_.empty()) {
     duration =
         config_->runtime().snapshot().getInteger(downstream_cluster_delay_duration_key_, duration);
@@ -161,8 +211,8 @@ Optional<uint64_t> FaultFilter::delayDuration() {
 
 uint64_t FaultFilter::abortHttpStatus() {
   // TODO(mattklein123): check http status codes obtained from runtime.
-  uint64_t http_status =
-      config_->runtime().snapshot().getInteger(ABORT_HTTP_STATUS_KEY, config_->abortCode());
+  uint64_t http_status = config_->runtime().snapshot().getInteger(
+      FaultFilterConfig::ABORT_HTTP_STATUS_KEY, config_->abortCode());
 
   if (!downstream_cluster_abort_http_status_key_.empty()) {
     http_status = config_->runtime().snapshot().getInteger(
@@ -3,12 +3,14 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 #include "envoy/http/filter.h"
 #include "envoy/runtime/runtime.h"
 #include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
 
 #include "common/router/config_impl.h"
 
@@ -40,7 +42,17 @@ struct FaultFilterStats {
 class FaultFilterConfig {
 public:
   FaultFilterConfig(const envoy::api::v2::filter::http::HTTPFault& fault, Runtime::Loader& runtime,
-                    const std::string& stats_prefix, Stats::Scope& scope);
+                    const std::string& stats_prefix, Stats::Scope& scope,
+                    ThreadLocal::SlotAllocator& tls);
+
+  /**
+   * @param downstream_cluster supplies the downstream cluster of a request, or empty if unknown.
+   * @return bool whether no fault can apply to the request, as both the delay and the abort
+   *         percentages resolve to 0 in the current runtime snapshot. This is cached per worker
+   *         until the snapshot changes, so that a filter with no fault to inject costs next to
+   *         nothing.
+   */
+  bool inactive(const std::string& downstream_cluster);
 
   const std::vector<Router::ConfigUtility::HeaderData>& filterHeaders() {
     return fault_filter_headers_;
@@ -56,7 +68,23 @@ public:
   const std::string& statsPrefix() { return stats_prefix_; }
   Stats::Scope& scope() { return scope_; }
 
+  const static Runtime::Key DELAY_PERCENT_KEY;
+  const static Runtime::Key ABORT_PERCENT_KEY;
+  const static Runtime::Key DELAY_DURATION_KEY;
+  const static Runtime::Key ABORT_HTTP_STATUS_KEY;
+
 private:
+  struct ThreadLocalState : public ThreadLocal::ThreadLocalObject {
+    bool loaded_{};
+    uint64_t snapshot_version_{};
+    // Whether no fault can apply, by downstream cluster, the empty name being for requests
+    // without one.
+    std::unordered_map<std::string, bool> inactive_;
+  };
+
+  // The downstream cluster comes from a request header, so the number cached is bounded.
+  static const size_t MAX_CACHED_DOWNSTREAM_CLUSTERS = 1024;
+
   static FaultFilterStats generateStats(const std::string& prefix, Stats::Scope& scope);
 
   uint64_t abort_percent_{};       // 0-100
@@ -71,6 +99,7 @@ private:
   FaultFilterStats stats_;
   const std::string stats_prefix_;
   Stats::Scope& scope_;
+  ThreadLocal::SlotPtr tls_;
 };
 
 typedef std::shared_ptr<FaultFilterConfig> FaultFilterConfigSharedPtr;
@@ -116,11 +145,6 @@ private:
   std::string downstream_cluster_abort_percent_key_{};
   std::string downstream_cluster_delay_duration_key_{};
   std::string downstream_cluster_abort_http_status_key_{};
-
-  const static std::string DELAY_PERCENT_KEY;
-  const static std::string ABORT_PERCENT_KEY;
-  const static std::string DELAY_DURATION_KEY;
-  const static std::string ABORT_HTTP_STATUS_KEY;
 };
 
 } // Http
@@ -1,15 +1,69 @@
 #include "common/http/filter/ip_tagging_filter.h"
 
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "envoy/common/exception.h"
+
+#include "common/common/utility.h"
+#include "common/http/headers.h"
+
+#include "fmt/format.h"
+
 namespace Envoy {
 namespace Http {
 
+IpTaggingFilterConfig::IpTaggingFilterConfig(const Json::Object& json_config)
+    : Json::Validator(json_config, Json::Schema::IP_TAGGING_HTTP_FILTER_SCHEMA),
+      request_type_(stringToType(json_config.getString("request_type", "both"))),
+      trie_(parseTags(json_config)) {}
+
+std::vector<std::pair<std::string, std::vector<Network::Address::CidrRange>>>
+IpTaggingFilterConfig::parseTags(const Json::Object& json_config) {
+  std::vector<std::pair<std::string, std::vector<Network::Address::CidrRange>>> tags;
+  if (!json_config.hasObject("ip_tags")) {
+    return tags;
+  }
+
+  for (const Json::ObjectSharedPtr& ip_tag : json_config.getObjectArray("ip_tags")) {
+    std::vector<Network::Address::CidrRange> ranges;
+    for (const std::string& entry : ip_tag->getStringArray("ip_list")) {
+      // A bare address is a range of its own.
+      Network::Address::CidrRange range =
+          entry.find('/') == std::string::npos
+              ? Network::Address::CidrRange::create(entry, 128)
+              : Network::Address::CidrRange::create(entry);
+      if (!range.isValid()) {
+        throw EnvoyException(
+            fmt::format("invalid ip/mask combo '{}' (format is <ip>/<# mask bits>)", entry));
+      }
+      ranges.push_back(range);
+    }
+    tags.emplace_back(ip_tag->getString("ip_tag_name"), std::move(ranges));
+  }
+  return tags;
+}
+
 IpTaggingFilter::IpTaggingFilter(IpTaggingFilterConfigSharedPtr config) : config_(config) {}
 
 IpTaggingFilter::~IpTaggingFilter() {}
 
 void IpTaggingFilter::onDestroy() {}
 
-FilterHeadersStatus IpTaggingFilter::decodeHeaders(HeaderMap&, bool) {
+FilterHeadersStatus IpTaggingFilter::decodeHeaders(HeaderMap& headers, bool) {
+  const bool is_internal = headers.EnvoyInternalRequest() != nullptr &&
+                           headers.EnvoyInternalRequest()->value() ==
+                               Headers::get().EnvoyInternalRequestValues.True.c_str();
+  if ((is_internal && config_->requestType() == FilterRequestType::External) ||
+      (!is_internal && config_->requestType() == FilterRequestType::Internal)) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  const std::vector<std::string>& tags = config_->trie().getTags(callbacks_->downstreamAddress());
+  if (!tags.empty()) {
+    headers.addCopy(Headers::get().EnvoyIpTags, StringUtil::join(tags, ","));
+  }
   return FilterHeadersStatus::Continue;
 }
 
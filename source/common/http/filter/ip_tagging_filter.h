@@ -11,6 +11,7 @@
 #include "common/common/assert.h"
 #include "common/json/config_schemas.h"
 #include "common/json/json_validator.h"
+#include "common/network/lc_trie.h"
 
 namespace Envoy {
 namespace Http {
@@ -25,11 +26,10 @@ enum class FilterRequestType { Internal, External, Both };
  */
 class IpTaggingFilterConfig : Json::Validator {
 public:
-  IpTaggingFilterConfig(const Json::Object& json_config)
-      : Json::Validator(json_config, Json::Schema::IP_TAGGING_HTTP_FILTER_SCHEMA),
-        request_type_(stringToType(json_config.getString("request_type", "both"))) {}
+  IpTaggingFilterConfig(const Json::Object& json_config);
 
   FilterRequestType requestType() const { return request_type_; }
+  const Network::LcTrie& trie() const { return trie_; }
 
 private:
   static FilterRequestType stringToType(const std::string& request_type) {
@@ -43,7 +43,11 @@ private:
     }
   }
 
+  static std::vector<std::pair<std::string, std::vector<Network::Address::CidrRange>>>
+  parseTags(const Json::Object& json_config);
+
   const FilterRequestType request_type_;
+  const Network::LcTrie trie_;
 };
 
 typedef std::shared_ptr<IpTaggingFilterConfig> IpTaggingFilterConfigSharedPtr;
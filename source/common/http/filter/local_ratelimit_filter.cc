@@ -0,0 +1,73 @@
+#include "common/http/filter/local_ratelimit_filter.h"
+
+#include <string>
+#include <vector>
+
+#include "envoy/http/codes.h"
+#include "envoy/router/router.h"
+#include "envoy/router/router_ratelimit.h"
+
+#include "common/common/enum_to_int.h"
+#include "common/http/header_map_impl.h"
+#include "common/http/headers.h"
+
+namespace Envoy {
+namespace Http {
+
+LocalRateLimitFilterConfig::LocalRateLimitFilterConfig(
+    std::chrono::milliseconds fill_interval, const RateLimit::TokenBucket& default_bucket,
+    const std::vector<std::pair<RateLimit::Descriptor, RateLimit::TokenBucket>>& descriptors,
+    uint32_t stage, const std::string& stats_prefix, Stats::Scope& scope,
+    const LocalInfo::LocalInfo& local_info, ThreadLocal::SlotAllocator& tls)
+    : rate_limiter_(fill_interval, default_bucket, descriptors, tls),
+      stats_(generateStats(stats_prefix, scope)), stage_(stage), local_info_(local_info) {}
+
+LocalRateLimitStats LocalRateLimitFilterConfig::generateStats(const std::string& prefix,
+                                                              Stats::Scope& scope) {
+  const std::string final_prefix = prefix + "local_rate_limit.";
+  return {ALL_LOCAL_RATE_LIMIT_STATS(POOL_COUNTER_PREFIX(scope, final_prefix))};
+}
+
+FilterHeadersStatus LocalRateLimitFilter::decodeHeaders(HeaderMap& headers, bool) {
+  std::vector<RateLimit::Descriptor> descriptors;
+  if (config_->rateLimiter().hasDescriptors()) {
+    populateDescriptors(headers, descriptors);
+  }
+
+  if (config_->rateLimiter().requestAllowed(descriptors)) {
+    config_->stats().ok_.inc();
+    return FilterHeadersStatus::Continue;
+  }
+
+  config_->stats().rate_limited_.inc();
+  callbacks_->requestInfo().setResponseFlag(AccessLog::ResponseFlag::RateLimited);
+  HeaderMapPtr response_headers{new HeaderMapImpl{
+      {Headers::get().Status, std::to_string(enumToInt(Code::TooManyRequests))}}};
+  callbacks_->encodeHeaders(std::move(response_headers), true);
+  return FilterHeadersStatus::StopIteration;
+}
+
+void LocalRateLimitFilter::populateDescriptors(const HeaderMap& headers,
+                                               std::vector<RateLimit::Descriptor>& descriptors) {
+  Router::RouteConstSharedPtr route = callbacks_->route();
+  if (!route || !route->routeEntry()) {
+    return;
+  }
+
+  const Router::RouteEntry& route_entry = *route->routeEntry();
+  for (const Router::RateLimitPolicyEntry& rate_limit :
+       route_entry.rateLimitPolicy().getApplicableRateLimit(config_->stage())) {
+    rate_limit.populateDescriptors(route_entry, descriptors, config_->localInfo().clusterName(),
+                                   headers, callbacks_->downstreamAddress());
+  }
+  if (route_entry.includeVirtualHostRateLimits()) {
+    for (const Router::RateLimitPolicyEntry& rate_limit :
+         route_entry.virtualHost().rateLimitPolicy().getApplicableRateLimit(config_->stage())) {
+      rate_limit.populateDescriptors(route_entry, descriptors, config_->localInfo().clusterName(),
+                                     headers, callbacks_->downstreamAddress());
+    }
+  }
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "envoy/http/filter.h"
+#include "envoy/local_info/local_info.h"
+#include "envoy/ratelimit/ratelimit.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/ratelimit/local_ratelimit_impl.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * All stats for the local rate limit filter. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_LOCAL_RATE_LIMIT_STATS(COUNTER)                                                        \
+  COUNTER(ok)                                                                                      \
+  COUNTER(rate_limited)
+// clang-format on
+
+/**
+ * Wrapper struct for local rate limit filter stats. @see stats_macros.h
+ */
+struct LocalRateLimitStats {
+  ALL_LOCAL_RATE_LIMIT_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Configuration for the local rate limit filter.
+ */
+class LocalRateLimitFilterConfig {
+public:
+  /**
+   * @param fill_interval supplies the interval at which the buckets are refilled.
+   * @param default_bucket supplies the bucket of the requests without a configured descriptor.
+   * @param descriptors supplies the descriptors with their own buckets. The descriptors of a
+   *        request are the ones of the rate limit actions of its route, as for the rate limit
+   *        filter.
+   * @param stage supplies the stage of the rate limit actions to use.
+   * @param stats_prefix supplies the prefix of the filter stats.
+   * @param scope supplies the scope of the filter stats.
+   * @param local_info supplies the local info used by the rate limit actions.
+   * @param tls supplies the slot allocator for the per worker buckets.
+   */
+  LocalRateLimitFilterConfig(
+      std::chrono::milliseconds fill_interval, const RateLimit::TokenBucket& default_bucket,
+      const std::vector<std::pair<RateLimit::Descriptor, RateLimit::TokenBucket>>& descriptors,
+      uint32_t stage, const std::string& stats_prefix, Stats::Scope& scope,
+      const LocalInfo::LocalInfo& local_info, ThreadLocal::SlotAllocator& tls);
+
+  RateLimit::LocalRateLimiterImpl& rateLimiter() { return rate_limiter_; }
+  LocalRateLimitStats& stats() { return stats_; }
+  uint32_t stage() const { return stage_; }
+  const LocalInfo::LocalInfo& localInfo() const { return local_info_; }
+
+private:
+  static LocalRateLimitStats generateStats(const std::string& prefix, Stats::Scope& scope);
+
+  RateLimit::LocalRateLimiterImpl rate_limiter_;
+  LocalRateLimitStats stats_;
+  const uint32_t stage_;
+  const LocalInfo::LocalInfo& local_info_;
+};
+
+typedef std::shared_ptr<LocalRateLimitFilterConfig> LocalRateLimitFilterConfigSharedPtr;
+
+/**
+ * HTTP filter which rejects the requests over the limits of its local token buckets with a 429,
+ * without calling a rate limit service.
+ */
+class LocalRateLimitFilter : public StreamDecoderFilter {
+public:
+  LocalRateLimitFilter(LocalRateLimitFilterConfigSharedPtr config) : config_(config) {}
+
+  // Http::StreamFilterBase
+  void onDestroy() override {}
+
+  // Http::StreamDecoderFilter
+  FilterHeadersStatus decodeHeaders(HeaderMap& headers, bool end_stream) override;
+  FilterDataStatus decodeData(Buffer::Instance&, bool) override {
+    return FilterDataStatus::Continue;
+  }
+  FilterTrailersStatus decodeTrailers(HeaderMap&) override {
+    return FilterTrailersStatus::Continue;
+  }
+  void setDecoderFilterCallbacks(StreamDecoderFilterCallbacks& callbacks) override {
+    callbacks_ = &callbacks;
+  }
+
+private:
+  void populateDescriptors(const HeaderMap& headers,
+                           std::vector<RateLimit::Descriptor>& descriptors);
+
+  LocalRateLimitFilterConfigSharedPtr config_;
+  StreamDecoderFilterCallbacks* callbacks_{};
+};
+
+} // namespace Http
+} // namespace Envoy
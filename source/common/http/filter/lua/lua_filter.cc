@@ -26,7 +26,8 @@ FilterHeadersStatus StreamHandleWrapper::start(int function_ref) {
   // We are on the top of the stack.
   coroutine_->start(function_ref, 1, yield_callback_);
   FilterHeadersStatus status =
-      (state_ == State::WaitForBody || state_ == State::HttpCall || state_ == State::Responded)
+      (state_ == State::WaitForBody || state_ == State::WaitForBodyPrefix ||
+       state_ == State::HttpCall || state_ == State::Responded)
           ? FilterHeadersStatus::StopIteration
           : FilterHeadersStatus::Continue;
 
@@ -53,13 +54,25 @@ FilterDataStatus StreamHandleWrapper::onData(Buffer::Instance& data, bool end_st
     callbacks_.addData(data);
     state_ = State::Running;
     coroutine_->resume(luaBody(coroutine_->luaState()), yield_callback_);
+  } else if (state_ == State::WaitForBodyPrefix) {
+    const Buffer::Instance* buffered_body = callbacks_.bufferedBody();
+    const uint64_t buffered_length = buffered_body == nullptr ? 0 : buffered_body->length();
+    if (end_stream_ || buffered_length + data.length() >= body_prefix_size_) {
+      ENVOY_LOG(debug, "resuming body prefix");
+      callbacks_.addData(data);
+      // Unless the body is complete, the rest of it is streamed so it can't be asked for again.
+      buffered_body_ = end_stream_;
+      state_ = State::Running;
+      coroutine_->resume(pushBufferedBody(coroutine_->luaState()), yield_callback_);
+    }
   } else if (state_ == State::WaitForTrailers && end_stream_) {
     ENVOY_LOG(debug, "resuming nil trailers due to end stream");
     state_ = State::Running;
     coroutine_->resume(0, yield_callback_);
   }
 
-  if (state_ == State::HttpCall || state_ == State::WaitForBody) {
+  if (state_ == State::HttpCall || state_ == State::WaitForBody ||
+      state_ == State::WaitForBodyPrefix) {
     ENVOY_LOG(trace, "buffering body");
     return FilterDataStatus::StopIterationAndBuffer;
   } else if (state_ == State::Responded) {
@@ -83,6 +96,10 @@ FilterTrailersStatus StreamHandleWrapper::onTrailers(HeaderMap& trailers) {
     ENVOY_LOG(debug, "resuming body due to trailers");
     state_ = State::Running;
     coroutine_->resume(luaBody(coroutine_->luaState()), yield_callback_);
+  } else if (state_ == State::WaitForBodyPrefix) {
+    ENVOY_LOG(debug, "resuming body prefix due to trailers");
+    state_ = State::Running;
+    coroutine_->resume(pushBufferedBody(coroutine_->luaState()), yield_callback_);
   }
 
   if (state_ == State::WaitForTrailers) {
@@ -287,17 +304,8 @@ int StreamHandleWrapper::luaBody(lua_State* state) {
   if (end_stream_) {
     if (!buffered_body_ && saw_body_) {
       return luaL_error(state, "cannot call body() after body has been streamed");
-    } else if (callbacks_.bufferedBody() == nullptr) {
-      ENVOY_LOG(debug, "end stream. no body");
-      return 0;
     } else {
-      if (body_wrapper_.get() != nullptr) {
-        body_wrapper_.pushStack();
-      } else {
-        body_wrapper_.reset(Envoy::Lua::BufferWrapper::create(state, *callbacks_.bufferedBody()),
-                            true);
-      }
-      return 1;
+      return pushBufferedBody(state);
     }
   } else if (saw_body_) {
     return luaL_error(state, "cannot call body() after body streaming has started");
@@ -309,6 +317,45 @@ int StreamHandleWrapper::luaBody(lua_State* state) {
   }
 }
 
+int StreamHandleWrapper::luaBodyPrefix(lua_State* state) {
+  ASSERT(state_ == State::Running);
+
+  const lua_Integer size = luaL_checkinteger(state, 2);
+  if (size <= 0) {
+    return luaL_error(state, "bodyPrefix() size must be greater than 0");
+  }
+
+  if (end_stream_) {
+    if (!buffered_body_ && saw_body_) {
+      return luaL_error(state, "cannot call bodyPrefix() after body has been streamed");
+    }
+    return pushBufferedBody(state);
+  } else if (saw_body_) {
+    return luaL_error(state, "cannot call bodyPrefix() after body streaming has started");
+  } else {
+    ENVOY_LOG(debug, "yielding for body prefix of {} bytes", size);
+    state_ = State::WaitForBodyPrefix;
+    body_prefix_size_ = size;
+    buffered_body_ = true;
+    return lua_yield(state, 0);
+  }
+}
+
+int StreamHandleWrapper::pushBufferedBody(lua_State* state) {
+  if (callbacks_.bufferedBody() == nullptr) {
+    ENVOY_LOG(debug, "end stream. no body");
+    return 0;
+  }
+
+  if (body_wrapper_.get() != nullptr) {
+    body_wrapper_.pushStack();
+  } else {
+    body_wrapper_.reset(Envoy::Lua::BufferWrapper::create(state, *callbacks_.bufferedBody()),
+                        true);
+  }
+  return 1;
+}
+
 int StreamHandleWrapper::luaBodyChunks(lua_State* state) {
   ASSERT(state_ == State::Running);
 
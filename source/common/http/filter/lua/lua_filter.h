@@ -72,6 +72,8 @@ public:
     WaitForBodyChunk,
     // Lua script is blocked waiting for the full body.
     WaitForBody,
+    // Lua script is blocked waiting for the first bytes of the body.
+    WaitForBodyPrefix,
     // Lua script is blocked waiting for trailers.
     WaitForTrailers,
     // Lua script is blocked waiting for the result of an HTTP call.
@@ -95,12 +97,13 @@ public:
   }
 
   static ExportedFunctions exportedFunctions() {
-    return {{"headers", static_luaHeaders},       {"body", static_luaBody},
-            {"bodyChunks", static_luaBodyChunks}, {"trailers", static_luaTrailers},
-            {"logTrace", static_luaLogTrace},     {"logDebug", static_luaLogDebug},
-            {"logInfo", static_luaLogInfo},       {"logWarn", static_luaLogWarn},
-            {"logErr", static_luaLogErr},         {"logCritical", static_luaLogCritical},
-            {"httpCall", static_luaHttpCall},     {"respond", static_luaRespond}};
+    return {{"headers", static_luaHeaders},         {"body", static_luaBody},
+            {"bodyPrefix", static_luaBodyPrefix},   {"bodyChunks", static_luaBodyChunks},
+            {"trailers", static_luaTrailers},       {"logTrace", static_luaLogTrace},
+            {"logDebug", static_luaLogDebug},       {"logInfo", static_luaLogInfo},
+            {"logWarn", static_luaLogWarn},         {"logErr", static_luaLogErr},
+            {"logCritical", static_luaLogCritical}, {"httpCall", static_luaHttpCall},
+            {"respond", static_luaRespond}};
   }
 
 private:
@@ -136,6 +139,15 @@ private:
    */
   DECLARE_LUA_FUNCTION(StreamHandleWrapper, luaBody);
 
+  /**
+   * @param 1 (int): The number of bytes of the body the script needs.
+   * @return a handle to the body received so far, which holds at least the requested number of
+   *         bytes unless the body is shorter, or nil if there is no body. This call will cause
+   *         the script to yield until enough of the body is received. Envoy buffers the body
+   *         until then, and streams the rest of it through without buffering.
+   */
+  DECLARE_LUA_FUNCTION(StreamHandleWrapper, luaBodyPrefix);
+
   /**
    * @return an iterator that allows the script to iterate through all body chunks as they are
    *         received. The iterator will yield between body chunks. Envoy *will not* buffer
@@ -166,6 +178,7 @@ private:
   DECLARE_LUA_CLOSURE(StreamHandleWrapper, luaBodyIterator);
 
   static HeaderMapPtr buildHeadersFromTable(lua_State* state, int table_index);
+  int pushBufferedBody(lua_State* state);
 
   // Envoy::Lua::BaseLuaObject
   void onMarkDead() override {
@@ -186,6 +199,7 @@ private:
   bool headers_continued_{};
   bool buffered_body_{};
   bool saw_body_{};
+  uint64_t body_prefix_size_{};
   Filter& filter_;
   FilterCallbacks& callbacks_;
   HeaderMap* trailers_{};
@@ -0,0 +1,48 @@
+#include "common/http/filter/on_demand_filter.h"
+
+#include <string>
+
+#include "envoy/router/router.h"
+
+namespace Envoy {
+namespace Http {
+
+FilterHeadersStatus OnDemandClusterFilter::decodeHeaders(HeaderMap&, bool) {
+  Router::RouteConstSharedPtr route = callbacks_->route();
+  if (route == nullptr || route->routeEntry() == nullptr) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  const std::string& cluster_name = route->routeEntry()->clusterName();
+  if (cm_.get(cluster_name) != nullptr) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  // If there is no such cluster to create, the request continues to the router, which responds
+  // that the cluster wasn't found.
+  loading_cluster_ = true;
+  std::shared_ptr<bool> destroyed = destroyed_;
+  cm_.loadOnDemandCluster(cluster_name, callbacks_->dispatcher(), [this, destroyed]() -> void {
+    if (!*destroyed) {
+      onClusterLoaded();
+    }
+  });
+  return FilterHeadersStatus::StopIteration;
+}
+
+FilterDataStatus OnDemandClusterFilter::decodeData(Buffer::Instance&, bool) {
+  return loading_cluster_ ? FilterDataStatus::StopIterationAndWatermark
+                          : FilterDataStatus::Continue;
+}
+
+FilterTrailersStatus OnDemandClusterFilter::decodeTrailers(HeaderMap&) {
+  return loading_cluster_ ? FilterTrailersStatus::StopIteration : FilterTrailersStatus::Continue;
+}
+
+void OnDemandClusterFilter::onClusterLoaded() {
+  loading_cluster_ = false;
+  callbacks_->continueDecoding();
+}
+
+} // namespace Http
+} // namespace Envoy
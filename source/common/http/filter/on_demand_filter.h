@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+
+#include "envoy/http/filter.h"
+#include "envoy/upstream/cluster_manager.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * A decoder filter which creates the cluster of a request's route the first time it's used, and
+ * holds the request until the cluster has initialized. It goes before the router filter, and is
+ * only needed when CDS clusters are created on demand. @see
+ * Upstream::ClusterManager::loadOnDemandCluster().
+ */
+class OnDemandClusterFilter : public StreamDecoderFilter {
+public:
+  OnDemandClusterFilter(Upstream::ClusterManager& cm) : cm_(cm) {}
+
+  // Http::StreamFilterBase
+  void onDestroy() override { *destroyed_ = true; }
+
+  // Http::StreamDecoderFilter
+  FilterHeadersStatus decodeHeaders(HeaderMap& headers, bool end_stream) override;
+  FilterDataStatus decodeData(Buffer::Instance& data, bool end_stream) override;
+  FilterTrailersStatus decodeTrailers(HeaderMap& trailers) override;
+  void setDecoderFilterCallbacks(StreamDecoderFilterCallbacks& callbacks) override {
+    callbacks_ = &callbacks;
+  }
+
+private:
+  void onClusterLoaded();
+
+  Upstream::ClusterManager& cm_;
+  StreamDecoderFilterCallbacks* callbacks_{};
+  bool loading_cluster_{};
+  // Shared with the callback of a pending cluster load, which runs on this filter's thread and
+  // does nothing once the filter has been destroyed.
+  std::shared_ptr<bool> destroyed_{std::make_shared<bool>(false)};
+};
+
+} // namespace Http
+} // namespace Envoy
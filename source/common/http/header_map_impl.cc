@@ -1,7 +1,8 @@
 #include "common/http/header_map_impl.h"
 
+#include <algorithm>
 #include <cstdint>
-#include <list>
+#include <cstring>
 #include <string>
 
 #include "common/common/assert.h"
@@ -213,7 +214,7 @@ void HeaderMapImpl::HeaderEntryImpl::value(const HeaderEntry& header) {
 }
 
 #define INLINE_HEADER_STATIC_MAP_ENTRY(name)                                                       \
-  add(Headers::get().name.get().c_str(), [](HeaderMapImpl& h) -> StaticLookupResponse {            \
+  add(Headers::get().name.get(), [](HeaderMapImpl& h) -> StaticLookupResponse {                   \
     return {&h.inline_headers_.name##_, &Headers::get().name};                                     \
   });
 
@@ -221,38 +222,66 @@ HeaderMapImpl::StaticLookupTable::StaticLookupTable() {
   ALL_INLINE_HEADERS(INLINE_HEADER_STATIC_MAP_ENTRY)
 
   // Special case where we map a legacy host header to :authority.
-  add(Headers::get().HostLegacy.get().c_str(), [](HeaderMapImpl& h) -> StaticLookupResponse {
+  add(Headers::get().HostLegacy.get(), [](HeaderMapImpl& h) -> StaticLookupResponse {
     return {&h.inline_headers_.Host_, &Headers::get().Host};
   });
+  RELEASE_ASSERT(entries_.size() < 256);
+
+  // Odd seeds are tried in turn until every entry hashes to a slot of its own.
+  for (seed_ = 0x9e3779b97f4a7c15;; seed_ += 2) {
+    slots_.fill(0);
+    bool collision = false;
+    for (size_t i = 0; i < entries_.size() && !collision; i++) {
+      uint8_t& occupant = slots_[slot(entries_[i].key_->data(), entries_[i].key_->size())];
+      collision = occupant != 0;
+      occupant = i + 1;
+    }
+    if (!collision) {
+      break;
+    }
+  }
 }
 
-void HeaderMapImpl::StaticLookupTable::add(const char* key, StaticLookupEntry::EntryCb cb) {
-  StaticLookupEntry* current = &root_;
-  while (uint8_t c = *key) {
-    if (!current->entries_[c]) {
-      current->entries_[c].reset(new StaticLookupEntry());
-    }
+void HeaderMapImpl::StaticLookupTable::add(const std::string& key, StaticLookupCb cb) {
+  entries_.push_back({&key, cb});
+}
 
-    current = current->entries_[c].get();
-    key++;
-  }
+namespace {
 
-  current->cb_ = cb;
+// Load up to 8 bytes of a key into a word, zero filling the rest.
+inline uint64_t loadWord(const char* data, size_t size) {
+  uint64_t word = 0;
+  memcpy(&word, data, std::min<size_t>(size, sizeof(word)));
+  return word;
 }
 
-HeaderMapImpl::StaticLookupEntry::EntryCb
-HeaderMapImpl::StaticLookupTable::find(const char* key) const {
-  const StaticLookupEntry* current = &root_;
-  while (uint8_t c = *key) {
-    current = current->entries_[c].get();
-    if (current) {
-      key++;
-    } else {
-      return nullptr;
-    }
+} // namespace
+
+size_t HeaderMapImpl::StaticLookupTable::slot(const char* key, size_t size) const {
+  // The first, middle and last words of the key distinguish the inline headers, many of which
+  // share a prefix, a suffix or a length. Shorter keys fit in the first word.
+  uint64_t hash = size;
+  if (size >= 8) {
+    hash ^= loadWord(key, 8) * 0xff51afd7ed558ccd;
+    hash ^= loadWord(key + size / 2 - 4, 8) * 0xc4ceb9fe1a85ec53;
+    hash ^= loadWord(key + size - 8, 8) * 0x94d049bb133111eb;
+  } else {
+    hash ^= loadWord(key, size) * 0xff51afd7ed558ccd;
   }
+  return (hash * seed_) >> (64 - SLOT_BITS);
+}
 
-  return current->cb_;
+HeaderMapImpl::StaticLookupCb HeaderMapImpl::StaticLookupTable::find(const char* key,
+                                                                     size_t size) const {
+  const uint8_t index = slots_[slot(key, size)];
+  if (index == 0) {
+    return nullptr;
+  }
+  const Entry& entry = entries_[index - 1];
+  if (entry.key_->size() != size || memcmp(entry.key_->data(), key, size) != 0) {
+    return nullptr;
+  }
+  return entry.cb_;
 }
 
 HeaderMapImpl::HeaderMapImpl() { memset(&inline_headers_, 0, sizeof(inline_headers_)); }
@@ -300,7 +329,7 @@ bool HeaderMapImpl::operator==(const HeaderMapImpl& rhs) const {
 }
 
 void HeaderMapImpl::insertByKey(HeaderString&& key, HeaderString&& value) {
-  StaticLookupEntry::EntryCb cb = ConstSingleton<StaticLookupTable>::get().find(key.c_str());
+  StaticLookupCb cb = ConstSingleton<StaticLookupTable>::get().find(key.c_str(), key.size());
   if (cb) {
     // TODO(mattklein123): Currently, for all of the inline headers, we don't support appending. The
     // only inline header where we should be converting multiple headers into a comma delimited
@@ -311,9 +340,7 @@ void HeaderMapImpl::insertByKey(HeaderString&& key, HeaderString&& value) {
     StaticLookupResponse ref_lookup_response = cb(*this);
     maybeCreateInline(ref_lookup_response.entry_, *ref_lookup_response.key_, std::move(value));
   } else {
-    std::list<HeaderEntryImpl>::iterator i =
-        headers_.emplace(headers_.end(), std::move(key), std::move(value));
-    i->entry_ = i;
+    headers_.emplace_back(std::move(key), std::move(value));
   }
 }
 
@@ -416,7 +443,8 @@ void HeaderMapImpl::iterateReverse(ConstIterateCb cb, void* context) const {
 }
 
 void HeaderMapImpl::remove(const LowerCaseString& key) {
-  StaticLookupEntry::EntryCb cb = ConstSingleton<StaticLookupTable>::get().find(key.get().c_str());
+  StaticLookupCb cb =
+      ConstSingleton<StaticLookupTable>::get().find(key.get().c_str(), key.get().size());
   if (cb) {
     StaticLookupResponse ref_lookup_response = cb(*this);
     removeInline(ref_lookup_response.entry_);
@@ -437,9 +465,7 @@ HeaderMapImpl::HeaderEntryImpl& HeaderMapImpl::maybeCreateInline(HeaderEntryImpl
     return **entry;
   }
 
-  std::list<HeaderEntryImpl>::iterator i = headers_.emplace(headers_.end(), key);
-  i->entry_ = i;
-  *entry = &(*i);
+  *entry = &headers_.emplace_back(key);
   return **entry;
 }
 
@@ -451,9 +477,7 @@ HeaderMapImpl::HeaderEntryImpl& HeaderMapImpl::maybeCreateInline(HeaderEntryImpl
     return **entry;
   }
 
-  std::list<HeaderEntryImpl>::iterator i = headers_.emplace(headers_.end(), key, std::move(value));
-  i->entry_ = i;
-  *entry = &(*i);
+  *entry = &headers_.emplace_back(key, std::move(value));
   return **entry;
 }
 
@@ -464,7 +488,7 @@ void HeaderMapImpl::removeInline(HeaderEntryImpl** ptr_to_entry) {
 
   HeaderEntryImpl* entry = *ptr_to_entry;
   *ptr_to_entry = nullptr;
-  headers_.erase(entry->entry_);
+  headers_.erase(*entry);
 }
 
 } // namespace Http
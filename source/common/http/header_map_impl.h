@@ -2,13 +2,15 @@
 
 #include <array>
 #include <cstdint>
-#include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "envoy/http/header_map.h"
 
+#include "common/common/chunked_list.h"
 #include "common/common/non_copyable.h"
+#include "common/common/slab_allocator.h"
 #include "common/http/headers.h"
 
 namespace Envoy {
@@ -33,9 +35,11 @@ public:
  * headers are added to the map, we do a hash lookup to see if it's one of the O(1) headers.
  * If it is, we store a reference to it that can be accessed later directly. Most high performance
  * paths use O(1) direct access. In general, we try to copy as little as possible and allocate as
- * little as possible in any of the paths.
+ * little as possible in any of the paths. Header maps are allocated and freed for every request
+ * and response, so heap allocated maps come from the per thread slab allocator, and the entries of
+ * a map are allocated in chunks rather than one at a time.
  */
-class HeaderMapImpl : public HeaderMap {
+class HeaderMapImpl : public HeaderMap, public SlabAllocated {
 public:
   HeaderMapImpl();
   HeaderMapImpl(const std::initializer_list<std::pair<LowerCaseString, std::string>>& values);
@@ -86,7 +90,6 @@ protected:
 
     HeaderString key_;
     HeaderString value_;
-    std::list<HeaderEntryImpl>::iterator entry_;
   };
 
   struct StaticLookupResponse {
@@ -94,23 +97,41 @@ protected:
     const LowerCaseString* key_;
   };
 
-  struct StaticLookupEntry {
-    typedef StaticLookupResponse (*EntryCb)(HeaderMapImpl&);
-
-    EntryCb cb_{};
-    std::array<std::unique_ptr<StaticLookupEntry>, 256> entries_;
-  };
+  typedef StaticLookupResponse (*StaticLookupCb)(HeaderMapImpl&);
 
   /**
    * This is the static lookup table that is used to determine whether a header is one of the O(1)
-   * headers. This uses a trie for lookup time at most equal to the size of the incoming string.
+   * headers. It is a perfect hash table: when the table is built, a seed is searched for which
+   * gives every header a slot of its own, so that a lookup hashes a few words of the key and then
+   * compares the key with at most one candidate.
    */
-  struct StaticLookupTable {
+  class StaticLookupTable {
+  public:
     StaticLookupTable();
-    void add(const char* key, StaticLookupEntry::EntryCb cb);
-    StaticLookupEntry::EntryCb find(const char* key) const;
 
-    StaticLookupEntry root_;
+    /**
+     * @return StaticLookupCb the callback resolving the inline header of the key, or nullptr if
+     *         the key is not an inline header.
+     */
+    StaticLookupCb find(const char* key, size_t size) const;
+
+  private:
+    struct Entry {
+      const std::string* key_;
+      StaticLookupCb cb_;
+    };
+
+    // Enough slots for a seed without collisions to be found in a few attempts.
+    static const size_t SLOT_BITS = 10;
+    static const size_t SLOTS = 1 << SLOT_BITS;
+
+    void add(const std::string& key, StaticLookupCb cb);
+    size_t slot(const char* key, size_t size) const;
+
+    std::vector<Entry> entries_;
+    // The index of the entry in each slot plus one, or zero for an empty slot.
+    std::array<uint8_t, SLOTS> slots_;
+    uint64_t seed_{};
   };
 
   struct AllInlineHeaders {
@@ -124,7 +145,9 @@ protected:
   void removeInline(HeaderEntryImpl** entry);
 
   AllInlineHeaders inline_headers_;
-  std::list<HeaderEntryImpl> headers_;
+  // Headers in insertion order. Entries are allocated in contiguous chunks rather than one list
+  // node per header, and never move, so the inline header pointers stay valid.
+  ChunkedList<HeaderEntryImpl> headers_;
 
   ALL_INLINE_HEADERS(DEFINE_INLINE_HEADER_FUNCS)
 };
@@ -15,6 +15,7 @@ namespace Http {
 class HeaderValues {
 public:
   const LowerCaseString Accept{"accept"};
+  const LowerCaseString AcceptEncoding{"accept-encoding"};
   const LowerCaseString AccessControlRequestHeaders{"access-control-request-headers"};
   const LowerCaseString AccessControlRequestMethod{"access-control-request-method"};
   const LowerCaseString AccessControlAllowOrigin{"access-control-allow-origin"};
@@ -23,19 +24,25 @@ public:
   const LowerCaseString AccessControlExposeHeaders{"access-control-expose-headers"};
   const LowerCaseString AccessControlMaxAge{"access-control-max-age"};
   const LowerCaseString AccessControlAllowCredentials{"access-control-allow-credentials"};
+  const LowerCaseString Age{"age"};
   const LowerCaseString Authorization{"authorization"};
+  const LowerCaseString CacheControl{"cache-control"};
   const LowerCaseString ClientTraceId{"x-client-trace-id"};
   const LowerCaseString Connection{"connection"};
+  const LowerCaseString ContentEncoding{"content-encoding"};
   const LowerCaseString ContentLength{"content-length"};
   const LowerCaseString ContentType{"content-type"};
   const LowerCaseString Cookie{"cookie"};
   const LowerCaseString Date{"date"};
+  const LowerCaseString EarlyData{"early-data"};
   const LowerCaseString EnvoyDownstreamServiceCluster{"x-envoy-downstream-service-cluster"};
   const LowerCaseString EnvoyDownstreamServiceNode{"x-envoy-downstream-service-node"};
   const LowerCaseString EnvoyExternalAddress{"x-envoy-external-address"};
   const LowerCaseString EnvoyForceTrace{"x-envoy-force-trace"};
   const LowerCaseString EnvoyImmediateHealthCheckFail{"x-envoy-immediate-health-check-fail"};
+  const LowerCaseString EnvoyIncrementalXds{"x-envoy-incremental-xds"};
   const LowerCaseString EnvoyInternalRequest{"x-envoy-internal"};
+  const LowerCaseString EnvoyIpTags{"x-envoy-ip-tags"};
   const LowerCaseString EnvoyMaxRetries{"x-envoy-max-retries"};
   const LowerCaseString EnvoyOriginalPath{"x-envoy-original-path"};
   const LowerCaseString EnvoyOverloaded{"x-envoy-overloaded"};
@@ -52,6 +59,7 @@ public:
   const LowerCaseString EnvoyUpstreamServiceTime{"x-envoy-upstream-service-time"};
   const LowerCaseString EnvoyUpstreamHealthCheckedCluster{"x-envoy-upstream-healthchecked-cluster"};
   const LowerCaseString EnvoyDecoratorOperation{"x-envoy-decorator-operation"};
+  const LowerCaseString Etag{"etag"};
   const LowerCaseString Expect{"expect"};
   const LowerCaseString ForwardedClientCert{"x-forwarded-client-cert"};
   const LowerCaseString ForwardedFor{"x-forwarded-for"};
@@ -59,6 +67,7 @@ public:
   const LowerCaseString GrpcMessage{"grpc-message"};
   const LowerCaseString GrpcStatus{"grpc-status"};
   const LowerCaseString GrpcAcceptEncoding{"grpc-accept-encoding"};
+  const LowerCaseString GrpcEncoding{"grpc-encoding"};
   const LowerCaseString Host{":authority"};
   const LowerCaseString HostLegacy{"host"};
   const LowerCaseString KeepAlive{"keep-alive"};
@@ -77,6 +86,7 @@ public:
   const LowerCaseString TE{"te"};
   const LowerCaseString Upgrade{"upgrade"};
   const LowerCaseString UserAgent{"user-agent"};
+  const LowerCaseString Vary{"vary"};
   const LowerCaseString XB3TraceId{"x-b3-traceid"};
   const LowerCaseString XB3SpanId{"x-b3-spanid"};
   const LowerCaseString XB3ParentSpanId{"x-b3-parentspanid"};
@@ -92,6 +102,13 @@ public:
     const std::string WebSocket{"websocket"};
   } UpgradeValues;
 
+  struct {
+    const std::string Brotli{"br"};
+    const std::string Deflate{"deflate"};
+    const std::string Gzip{"gzip"};
+    const std::string Zstd{"zstd"};
+  } ContentEncodingValues;
+
   struct {
     const std::string Text{"text/plain"};
     const std::string Grpc{"application/grpc"};
@@ -102,10 +119,18 @@ public:
     const std::string Json{"application/json"};
   } ContentTypeValues;
 
+  struct {
+    const std::string True{"1"};
+  } EarlyDataValues;
+
   struct {
     const std::string True{"true"};
   } EnvoyImmediateHealthCheckFailValues;
 
+  struct {
+    const std::string True{"true"};
+  } EnvoyIncrementalXdsValues;
+
   struct {
     const std::string True{"true"};
   } EnvoyInternalRequestValues;
@@ -132,10 +157,13 @@ public:
   } ExpectValues;
 
   struct {
+    const std::string Delete{"DELETE"};
     const std::string Get{"GET"};
     const std::string Head{"HEAD"};
     const std::string Post{"POST"};
+    const std::string Put{"PUT"};
     const std::string Options{"OPTIONS"};
+    const std::string Trace{"TRACE"};
   } MethodValues;
 
   struct {
@@ -153,8 +181,13 @@ public:
 
   struct {
     const std::string Default{"identity,deflate,gzip"};
+    const std::string Gzip{"identity,gzip"};
   } GrpcAcceptEncodingValues;
 
+  struct {
+    const std::string Gzip{"gzip"};
+  } GrpcEncodingValues;
+
   struct {
     const std::string Trailers{"trailers"};
   } TEValues;
@@ -162,6 +195,15 @@ public:
   struct {
     const std::string True{"true"};
   } CORSValues;
+
+  struct {
+    const std::string MaxAge{"max-age"};
+    const std::string NoCache{"no-cache"};
+    const std::string NoStore{"no-store"};
+    const std::string NoTransform{"no-transform"};
+    const std::string Private{"private"};
+    const std::string SMaxAge{"s-maxage"};
+  } CacheControlValues;
 };
 
 typedef ConstSingleton<HeaderValues> Headers;
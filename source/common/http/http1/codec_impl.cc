@@ -251,7 +251,7 @@ http_parser_settings ConnectionImpl::settings_{
       return 0;
     },
     [](http_parser* parser) -> int {
-      static_cast<ConnectionImpl*>(parser->data)->onMessageComplete();
+      static_cast<ConnectionImpl*>(parser->data)->onMessageCompleteBase();
       return 0;
     },
     nullptr, // on_chunk_header
@@ -296,6 +296,15 @@ void ConnectionImpl::dispatch(Buffer::Instance& data) {
     uint64_t num_slices = data.getRawSlices(nullptr, 0);
     Buffer::RawSlice slices[num_slices];
     data.getRawSlices(slices, num_slices);
+    total_parsed = dispatchRequestHead(static_cast<const char*>(slices[0].mem_), slices[0].len_);
+    if (total_parsed > 0) {
+      // The complete message was dispatched by the fast path. Like http_parser, stop after a
+      // complete message so that the caller can process one request at a time.
+      ENVOY_CONN_LOG(trace, "parsed {} bytes via fast path", connection_, total_parsed);
+      data.drain(total_parsed);
+      return;
+    }
+
     for (Buffer::RawSlice& slice : slices) {
       total_parsed += dispatchSlice(static_cast<const char*>(slice.mem_), slice.len_);
     }
@@ -318,6 +327,35 @@ size_t ConnectionImpl::dispatchSlice(const char* slice, size_t len) {
   return rc;
 }
 
+size_t ConnectionImpl::dispatchRequestHead(const char* slice, size_t len) {
+  if (!fast_request_head_parsing_ || !at_message_start_) {
+    return 0;
+  }
+
+  const size_t head_length = request_head_parser_.parse(slice, len);
+  if (head_length == 0) {
+    return 0;
+  }
+
+  // Set up the parser state that the callbacks look at, as http_parser would have for this
+  // request: an HTTP/1.1 request without a body.
+  parser_.http_major = 1;
+  parser_.http_minor = 1;
+  parser_.method = request_head_parser_.method();
+  parser_.flags = 0;
+  parser_.content_length = ULLONG_MAX;
+
+  onMessageBeginBase();
+  onUrl(request_head_parser_.url().data_, request_head_parser_.url().length_);
+  for (const RequestHeadParser::Header& header : request_head_parser_.headers()) {
+    onHeaderField(header.name_.data_, header.name_.length_);
+    onHeaderValue(header.value_.data_, header.value_.length_);
+  }
+  onHeadersCompleteBase();
+  onMessageCompleteBase();
+  return head_length;
+}
+
 void ConnectionImpl::onHeaderField(const char* data, size_t length) {
   if (header_parsing_state_ == HeaderParsingState::Done) {
     // Ignore trailers.
@@ -358,11 +396,19 @@ int ConnectionImpl::onHeadersCompleteBase() {
 
 void ConnectionImpl::onMessageBeginBase() {
   ASSERT(!current_header_map_);
+  at_message_start_ = false;
   current_header_map_.reset(new HeaderMapImpl());
   header_parsing_state_ = HeaderParsingState::Field;
   onMessageBegin();
 }
 
+void ConnectionImpl::onMessageCompleteBase() {
+  // After a message, http_parser either waits for the next message, or rejects any further data
+  // if the connection is not persistent.
+  at_message_start_ = http_should_keep_alive(&parser_);
+  onMessageComplete();
+}
+
 void ConnectionImpl::onResetStreamBase(StreamResetReason reason) {
   ASSERT(!reset_stream_called_);
   reset_stream_called_ = true;
@@ -372,7 +418,14 @@ void ConnectionImpl::onResetStreamBase(StreamResetReason reason) {
 ServerConnectionImpl::ServerConnectionImpl(Network::Connection& connection,
                                            ServerConnectionCallbacks& callbacks,
                                            Http1Settings settings)
-    : ConnectionImpl(connection, HTTP_REQUEST), callbacks_(callbacks), codec_settings_(settings) {}
+    : ConnectionImpl(connection, HTTP_REQUEST), callbacks_(callbacks), codec_settings_(settings) {
+  fast_request_head_parsing_ = codec_settings_.fast_request_head_parsing_;
+}
+
+bool ServerConnectionImpl::idle() {
+  return !active_request_ && atMessageStart() && !resetStreamCalled() &&
+         buffer().length() == 0;
+}
 
 void ServerConnectionImpl::onEncodeComplete() {
   ASSERT(active_request_);
@@ -600,12 +653,18 @@ StreamEncoder& ClientConnectionImpl::newStream(StreamDecoder& response_decoder)
   if (resetStreamCalled()) {
     throw CodecClientException("cannot create new streams after calling reset");
   }
-  // Streams are responsible for unwinding any outstanding readDisable(true)
-  // calls done on the underlying connection as they are destroyed. As this is
-  // the only place a HTTP/1 stream is destroyed where the Network::Connection is
-  // reused, unwind any outstanding readDisable() calls here.
-  while (!connection_.readEnabled()) {
-    connection_.readDisable(false);
+  if (pending_responses_.empty()) {
+    // Streams are responsible for unwinding any outstanding readDisable(true)
+    // calls done on the underlying connection as they are destroyed. As this is
+    // the only place a HTTP/1 stream is destroyed where the Network::Connection is
+    // reused, unwind any outstanding readDisable() calls here.
+    while (!connection_.readEnabled()) {
+      connection_.readDisable(false);
+    }
+  } else {
+    // The request is pipelined, and the previous request's encoder lives as long as its response
+    // is pending. Reads stay disabled if the previous response's consumer disabled them.
+    pending_responses_.back().encoder_ = std::move(request_encoder_);
   }
   request_encoder_.reset(new RequestStreamEncoderImpl(*this));
   pending_responses_.emplace_back(&response_decoder);
@@ -650,7 +709,7 @@ void ClientConnectionImpl::onBody(const char* data, size_t length) {
 void ClientConnectionImpl::onMessageComplete() {
   if (!pending_responses_.empty()) {
     // After calling decodeData() with end stream set to true, we should no longer be able to reset.
-    PendingResponse response = pending_responses_.front();
+    PendingResponse response = std::move(pending_responses_.front());
     pending_responses_.pop_front();
 
     if (deferred_end_stream_headers_) {
@@ -664,10 +723,11 @@ void ClientConnectionImpl::onMessageComplete() {
 }
 
 void ClientConnectionImpl::onResetStream(StreamResetReason reason) {
-  // Only raise reset if we did not already dispatch a complete response.
-  if (!pending_responses_.empty()) {
-    pending_responses_.clear();
-    request_encoder_->runResetCallbacks(reason);
+  // Only raise reset for the requests which did not already dispatch a complete response.
+  std::list<PendingResponse> pending_responses(std::move(pending_responses_));
+  pending_responses_.clear();
+  for (PendingResponse& response : pending_responses) {
+    (response.encoder_ ? *response.encoder_ : *request_encoder_).runResetCallbacks(reason);
   }
 }
 
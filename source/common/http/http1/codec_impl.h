@@ -17,6 +17,7 @@
 #include "common/http/codec_helper.h"
 #include "common/http/codes.h"
 #include "common/http/header_map_impl.h"
+#include "common/http/http1/request_head_parser.h"
 
 namespace Envoy {
 namespace Http {
@@ -153,11 +154,14 @@ protected:
   ConnectionImpl(Network::Connection& connection, http_parser_type type);
 
   bool resetStreamCalled() { return reset_stream_called_; }
+  bool atMessageStart() { return at_message_start_; }
 
   Network::Connection& connection_;
   http_parser parser_;
   HeaderMapPtr deferred_end_stream_headers_;
   Http::Code error_code_{Http::Code::BadRequest};
+  // Whether to try RequestHeadParser before http_parser. Only valid for request parsing.
+  bool fast_request_head_parsing_{};
 
 private:
   enum class HeaderParsingState { Field, Value, Done };
@@ -174,6 +178,16 @@ private:
    */
   size_t dispatchSlice(const char* slice, size_t len);
 
+  /**
+   * Try to dispatch a complete bodyless request head with RequestHeadParser, bypassing
+   * http_parser. This drives the same callbacks that http_parser would.
+   * @param slice supplies the start address.
+   * @param len supplies the length of the span.
+   * @return size_t the number of bytes dispatched, or 0 if the span must be dispatched via
+   *         http_parser.
+   */
+  size_t dispatchRequestHead(const char* slice, size_t len);
+
   /**
    * Called when a request/response is beginning. A base routine happens first then a virtual
    * dispatch is invoked.
@@ -218,8 +232,10 @@ private:
   virtual void onBody(const char* data, size_t length) PURE;
 
   /**
-   * Called when the request/response is complete.
+   * Called when the request/response is complete. A base routine happens first then a virtual
+   * dispatch is invoked.
    */
+  void onMessageCompleteBase();
   virtual void onMessageComplete() PURE;
 
   /**
@@ -251,6 +267,10 @@ private:
   HeaderParsingState header_parsing_state_{HeaderParsingState::Field};
   HeaderString current_header_field_;
   HeaderString current_header_value_;
+  RequestHeadParser request_head_parser_;
+  // Whether http_parser is waiting for the start of a new message, as opposed to being in the
+  // middle of a message or done with the connection.
+  bool at_message_start_{true};
   bool reset_stream_called_{};
   Buffer::WatermarkBuffer output_buffer_;
   Buffer::RawSlice reserved_iovec_;
@@ -266,6 +286,9 @@ public:
   ServerConnectionImpl(Network::Connection& connection, ServerConnectionCallbacks& callbacks,
                        Http1Settings settings);
 
+  // Http::ServerConnection
+  bool idle() override;
+
 private:
   /**
    * An active HTTP/1.1 request.
@@ -321,6 +344,8 @@ private:
     PendingResponse(StreamDecoder* decoder) : decoder_(decoder) {}
 
     StreamDecoder* decoder_;
+    // The encoder of the request, once request_encoder_ is replaced by a request pipelined behind.
+    std::unique_ptr<RequestStreamEncoderImpl> encoder_;
     bool head_request_{};
   };
 
@@ -338,6 +363,7 @@ private:
   void onAboveHighWatermark() override;
   void onBelowLowWatermark() override;
 
+  // The encoder of the last request, whose response may still be pending.
   std::unique_ptr<RequestStreamEncoderImpl> request_encoder_;
   std::list<PendingResponse> pending_responses_;
 };
@@ -1,5 +1,7 @@
 #include "common/http/http1/conn_pool.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <list>
 
@@ -43,10 +45,9 @@ void ConnPoolImpl::addDrainedCallback(DrainedCb cb) {
 }
 
 void ConnPoolImpl::attachRequestToClient(ActiveClient& client, StreamDecoder& response_decoder,
-                                         ConnectionPool::Callbacks& callbacks) {
-  ASSERT(!client.stream_wrapper_);
-  client.stream_wrapper_.reset(new StreamWrapper(response_decoder, client));
-  callbacks.onPoolReady(*client.stream_wrapper_, client.real_host_description_);
+                                         ConnectionPool::Callbacks& callbacks, bool pipelinable) {
+  client.stream_wrappers_.emplace_back(new StreamWrapper(response_decoder, client, pipelinable));
+  callbacks.onPoolReady(*client.stream_wrappers_.back(), client.real_host_description_);
 }
 
 void ConnPoolImpl::checkForDrained() {
@@ -65,20 +66,48 @@ void ConnPoolImpl::createNewConnection() {
   ENVOY_LOG(debug, "creating a new connection");
   ActiveClientPtr client(new ActiveClient(*this));
   client->moveIntoList(std::move(client), busy_clients_);
+  connecting_clients_++;
 }
 
 ConnectionPool::Cancellable* ConnPoolImpl::newStream(StreamDecoder& response_decoder,
                                                      ConnectionPool::Callbacks& callbacks) {
+  return newStream(response_decoder, callbacks, false);
+}
+
+ConnectionPool::Cancellable*
+ConnPoolImpl::newPipelinableStream(StreamDecoder& response_decoder,
+                                   ConnectionPool::Callbacks& callbacks) {
+  return newStream(response_decoder, callbacks, true);
+}
+
+ConnectionPool::Cancellable* ConnPoolImpl::newStream(StreamDecoder& response_decoder,
+                                                     ConnectionPool::Callbacks& callbacks,
+                                                     bool pipelinable) {
   if (!ready_clients_.empty()) {
+    // Use the most recently used connection. See processIdleClient().
+    if (ready_clients_.front()->idle_timer_) {
+      ready_clients_.front()->idle_timer_->disableTimer();
+    }
     ready_clients_.front()->moveBetweenLists(ready_clients_, busy_clients_);
     ENVOY_CONN_LOG(debug, "using existing connection", *busy_clients_.front()->codec_client_);
-    attachRequestToClient(*busy_clients_.front(), response_decoder, callbacks);
+    attachRequestToClient(*busy_clients_.front(), response_decoder, callbacks, pipelinable);
+    prefetchConnections();
     return nullptr;
   }
 
+  const bool can_create_connection =
+      host_->cluster().resourceManager(priority_).connections().canCreate();
+  if (pipelinable && !can_create_connection) {
+    ActiveClient* client = pipeliningClient();
+    if (client) {
+      ENVOY_CONN_LOG(debug, "pipelining request", *client->codec_client_);
+      host_->cluster().stats().upstream_rq_pipelined_.inc();
+      attachRequestToClient(*client, response_decoder, callbacks, true);
+      return nullptr;
+    }
+  }
+
   if (host_->cluster().resourceManager(priority_).pendingRequests().canCreate()) {
-    bool can_create_connection =
-        host_->cluster().resourceManager(priority_).connections().canCreate();
     if (!can_create_connection) {
       host_->cluster().stats().upstream_cx_overflow_.inc();
     }
@@ -89,9 +118,12 @@ ConnectionPool::Cancellable* ConnPoolImpl::newStream(StreamDecoder& response_dec
     }
 
     ENVOY_LOG(debug, "queueing request due to no available connections");
-    PendingRequestPtr pending_request(new PendingRequest(*this, response_decoder, callbacks));
+    PendingRequestPtr pending_request(
+        new PendingRequest(*this, response_decoder, callbacks, pipelinable));
     pending_request->moveIntoList(std::move(pending_request), pending_requests_);
-    return pending_requests_.front().get();
+    PendingRequest* handle = pending_requests_.front().get();
+    prefetchConnections();
+    return handle;
   } else {
     ENVOY_LOG(debug, "max pending requests overflow");
     callbacks.onPoolFailure(ConnectionPool::PoolFailureReason::Overflow, nullptr);
@@ -105,10 +137,14 @@ void ConnPoolImpl::onConnectionEvent(ActiveClient& client, Network::ConnectionEv
       event == Network::ConnectionEvent::LocalClose) {
     // The client died.
     ENVOY_CONN_LOG(debug, "client disconnected", *client.codec_client_);
+    if (client.idle_timer_) {
+      client.idle_timer_->disableTimer();
+    }
     ActiveClientPtr removed;
     bool check_for_drained = true;
-    if (client.stream_wrapper_) {
-      if (!client.stream_wrapper_->decode_complete_) {
+    if (!client.stream_wrappers_.empty()) {
+      if (std::any_of(client.stream_wrappers_.begin(), client.stream_wrappers_.end(),
+                      [](const StreamWrapperPtr& wrapper) { return !wrapper->decode_complete_; })) {
         if (event == Network::ConnectionEvent::LocalClose) {
           host_->cluster().stats().upstream_cx_destroy_local_with_active_rq_.inc();
         }
@@ -118,8 +154,8 @@ void ConnPoolImpl::onConnectionEvent(ActiveClient& client, Network::ConnectionEv
         host_->cluster().stats().upstream_cx_destroy_with_active_rq_.inc();
       }
 
-      // There is an active request attached to this client. The underlying codec client will
-      // already have "reset" the stream to fire the reset callback. All we do here is just
+      // There are active requests attached to this client. The underlying codec client will
+      // already have "reset" the streams to fire the reset callbacks. All we do here is just
       // destroy the client.
       removed = client.removeFromList(busy_clients_);
     } else if (!client.connect_timer_) {
@@ -164,6 +200,8 @@ void ConnPoolImpl::onConnectionEvent(ActiveClient& client, Network::ConnectionEv
   if (client.connect_timer_) {
     client.connect_timer_->disableTimer();
     client.connect_timer_.reset();
+    ASSERT(connecting_clients_ > 0);
+    connecting_clients_--;
   }
 
   // Note that the order in this function is important. Concretely, we must destroy the connect
@@ -181,6 +219,19 @@ void ConnPoolImpl::onDownstreamReset(ActiveClient& client) {
   client.codec_client_->close();
 }
 
+void ConnPoolImpl::onIdleTimeout(ActiveClient& client) {
+  // Keep the connection if closing it would leave fewer idle connections than wanted. As idle
+  // connections are reused most recently used first, those which time out are the ones that have
+  // gone unused the longest.
+  if (ready_clients_.size() <= host_->cluster().http1MinIdleConnections()) {
+    return;
+  }
+
+  ENVOY_CONN_LOG(debug, "idle timeout", *client.codec_client_);
+  host_->cluster().stats().upstream_cx_idle_timeout_.inc();
+  client.codec_client_->close();
+}
+
 void ConnPoolImpl::onPendingRequestCancel(PendingRequest& request) {
   ENVOY_LOG(debug, "cancelling pending request");
   request.removeFromList(pending_requests_);
@@ -190,10 +241,13 @@ void ConnPoolImpl::onPendingRequestCancel(PendingRequest& request) {
 
 void ConnPoolImpl::onResponseComplete(ActiveClient& client) {
   ENVOY_CONN_LOG(debug, "response complete", *client.codec_client_);
-  if (!client.stream_wrapper_->encode_complete_) {
+  // Closing the connection resets the requests pipelined behind, which have yet to get a response
+  // and can be retried.
+  const StreamWrapper& stream_wrapper = *client.stream_wrappers_.front();
+  if (!stream_wrapper.encode_complete_) {
     ENVOY_CONN_LOG(debug, "response before request complete", *client.codec_client_);
     onDownstreamReset(client);
-  } else if (client.stream_wrapper_->saw_close_header_ || client.codec_client_->remoteClosed()) {
+  } else if (stream_wrapper.saw_close_header_ || client.codec_client_->remoteClosed()) {
     ENVOY_CONN_LOG(debug, "saw upstream connection: close", *client.codec_client_);
     onDownstreamReset(client);
   } else if (client.remaining_requests_ > 0 && --client.remaining_requests_ == 0) {
@@ -201,31 +255,82 @@ void ConnPoolImpl::onResponseComplete(ActiveClient& client) {
     host_->cluster().stats().upstream_cx_max_requests_.inc();
     onDownstreamReset(client);
   } else {
-    processIdleClient(client);
+    client.reused_ = true;
+    client.stream_wrappers_.pop_front();
+    if (client.stream_wrappers_.empty()) {
+      processIdleClient(client);
+    }
+  }
+}
+
+ConnPoolImpl::ActiveClient* ConnPoolImpl::pipeliningClient() {
+  const uint64_t max_requests = host_->cluster().http1MaxPipelinedRequests();
+  if (max_requests <= 1) {
+    return nullptr;
+  }
+
+  ActiveClient* pipelining_client = nullptr;
+  for (const ActiveClientPtr& client : busy_clients_) {
+    if (client->canPipeline(max_requests) &&
+        (!pipelining_client ||
+         client->stream_wrappers_.size() < pipelining_client->stream_wrappers_.size())) {
+      pipelining_client = client.get();
+    }
+  }
+  return pipelining_client;
+}
+
+void ConnPoolImpl::prefetchConnections() {
+  const uint64_t prefetch_percent = host_->cluster().http1PrefetchPercent();
+  const uint64_t min_idle_connections = host_->cluster().http1MinIdleConnections();
+  if (prefetch_percent <= 100 && min_idle_connections == 0) {
+    return;
+  }
+
+  // Prefetching only happens as requests arrive, so that a host which fails to connect isn't
+  // reconnected to in a loop.
+  const uint64_t requests = busy_clients_.size() - connecting_clients_ + pending_requests_.size();
+  const uint64_t wanted_connections =
+      std::max((requests * prefetch_percent + 99) / 100, requests + min_idle_connections);
+  while (ready_clients_.size() + busy_clients_.size() < wanted_connections &&
+         host_->cluster().resourceManager(priority_).connections().canCreate()) {
+    host_->cluster().stats().upstream_cx_prefetched_.inc();
+    createNewConnection();
   }
 }
 
 void ConnPoolImpl::processIdleClient(ActiveClient& client) {
-  client.stream_wrapper_.reset();
+  ASSERT(client.stream_wrappers_.empty());
   if (pending_requests_.empty()) {
-    // There is nothing to service so just move the connection into the ready list.
+    // There is nothing to service so just move the connection into the front of the ready list,
+    // where it is picked first by newStream().
     ENVOY_CONN_LOG(debug, "moving to ready", *client.codec_client_);
     client.moveBetweenLists(busy_clients_, ready_clients_);
+    const std::chrono::milliseconds idle_timeout = host_->cluster().http1IdleTimeout();
+    if (idle_timeout.count() > 0) {
+      if (!client.idle_timer_) {
+        client.idle_timer_ =
+            dispatcher_.createCoarseTimer([&client]() -> void { client.onIdleTimeout(); });
+      }
+      client.idle_timer_->enableTimer(idle_timeout);
+    }
   } else {
     // There is work to do so bind a request to the client and move it to the busy list. Pending
     // requests are pushed onto the front, so pull from the back.
     ENVOY_CONN_LOG(debug, "attaching to next request", *client.codec_client_);
     attachRequestToClient(client, pending_requests_.back()->decoder_,
-                          pending_requests_.back()->callbacks_);
+                          pending_requests_.back()->callbacks_,
+                          pending_requests_.back()->pipelinable_);
     pending_requests_.pop_back();
   }
 
   checkForDrained();
 }
 
-ConnPoolImpl::StreamWrapper::StreamWrapper(StreamDecoder& response_decoder, ActiveClient& parent)
+ConnPoolImpl::StreamWrapper::StreamWrapper(StreamDecoder& response_decoder, ActiveClient& parent,
+                                           bool pipelinable)
     : StreamEncoderWrapper(parent.codec_client_->newStream(*this)),
-      StreamDecoderWrapper(response_decoder), parent_(parent) {
+      StreamDecoderWrapper(response_decoder), parent_(parent), pipelinable_(pipelinable) {
 
   StreamEncoderWrapper::inner_.getStream().addCallbacks(*this);
   parent_.parent_.host_->cluster().stats().upstream_rq_total_.inc();
@@ -258,8 +363,8 @@ void ConnPoolImpl::StreamWrapper::onDecodeComplete() {
 }
 
 ConnPoolImpl::PendingRequest::PendingRequest(ConnPoolImpl& parent, StreamDecoder& decoder,
-                                             ConnectionPool::Callbacks& callbacks)
-    : parent_(parent), decoder_(decoder), callbacks_(callbacks) {
+                                             ConnectionPool::Callbacks& callbacks, bool pipelinable)
+    : parent_(parent), decoder_(decoder), callbacks_(callbacks), pipelinable_(pipelinable) {
   parent_.host_->cluster().stats().upstream_rq_pending_total_.inc();
   parent_.host_->cluster().stats().upstream_rq_pending_active_.inc();
   parent_.host_->cluster().resourceManager(parent_.priority_).pendingRequests().inc();
@@ -296,7 +401,9 @@ ConnPoolImpl::ActiveClient::ActiveClient(ConnPoolImpl& parent)
        parent_.host_->cluster().stats().upstream_cx_rx_bytes_buffered_,
        parent_.host_->cluster().stats().upstream_cx_tx_bytes_total_,
        parent_.host_->cluster().stats().upstream_cx_tx_bytes_buffered_,
-       &parent_.host_->cluster().stats().bind_errors_});
+       &parent_.host_->cluster().stats().bind_errors_,
+       &parent_.host_->cluster().stats().upstream_cx_rx_syscalls_total_,
+       &parent_.host_->cluster().stats().upstream_cx_tx_syscalls_total_});
 }
 
 ConnPoolImpl::ActiveClient::~ActiveClient() {
@@ -306,6 +413,21 @@ ConnPoolImpl::ActiveClient::~ActiveClient() {
   parent_.host_->cluster().resourceManager(parent_.priority_).connections().dec();
 }
 
+bool ConnPoolImpl::ActiveClient::canPipeline(uint64_t max_requests) const {
+  // Only pipeline on a connection which has kept alive across a response, behind requests which
+  // have all been sent and can be retried, and without going over the requests left for it.
+  if (!reused_ || stream_wrappers_.empty() || stream_wrappers_.size() >= max_requests ||
+      (remaining_requests_ > 0 && stream_wrappers_.size() >= remaining_requests_) ||
+      codec_client_->remoteClosed()) {
+    return false;
+  }
+  return std::all_of(stream_wrappers_.begin(), stream_wrappers_.end(),
+                     [](const StreamWrapperPtr& wrapper) {
+                       return wrapper->pipelinable_ && wrapper->encode_complete_ &&
+                              !wrapper->saw_close_header_;
+                     });
+}
+
 void ConnPoolImpl::ActiveClient::onConnectTimeout() {
   // We just close the client at this point. This will result in both a timeout and a connect
   // failure and will fold into all the normal connect failure logic.
@@ -21,7 +21,15 @@ namespace Http {
 namespace Http1 {
 
 /**
- * A connection pool implementation for HTTP/1.1 connections.
+ * A connection pool implementation for HTTP/1.1 connections. Besides the connections needed by its
+ * active and pending requests, the pool may open connections ahead of demand so that bursts of
+ * requests don't wait for connects. See ClusterInfo::http1PrefetchPercent() and
+ * ClusterInfo::http1MinIdleConnections(). Idle connections are reused most recently used first, so
+ * that the least recently used ones stay idle and can be closed after
+ * ClusterInfo::http1IdleTimeout(). When no connection is idle and no more connections may be
+ * opened, requests without a body and with a safe method may be pipelined behind such requests,
+ * on a connection which has already kept alive across a response. See
+ * ClusterInfo::http1MaxPipelinedRequests().
  * NOTE: The connection pool does NOT do DNS resolution. It assumes it is being given a numeric IP
  *       address. Higher layer code should handle resolving DNS on error and creating a new pool
  *       bound to a different IP address.
@@ -40,6 +48,8 @@ public:
   void closeConnections() override;
   ConnectionPool::Cancellable* newStream(StreamDecoder& response_decoder,
                                          ConnectionPool::Callbacks& callbacks) override;
+  ConnectionPool::Cancellable* newPipelinableStream(StreamDecoder& response_decoder,
+                                                    ConnectionPool::Callbacks& callbacks) override;
 
 protected:
   struct ActiveClient;
@@ -47,7 +57,7 @@ protected:
   struct StreamWrapper : public StreamEncoderWrapper,
                          public StreamDecoderWrapper,
                          public StreamCallbacks {
-    StreamWrapper(StreamDecoder& response_decoder, ActiveClient& parent);
+    StreamWrapper(StreamDecoder& response_decoder, ActiveClient& parent, bool pipelinable);
     ~StreamWrapper();
 
     // StreamEncoderWrapper
@@ -64,6 +74,7 @@ protected:
     void onBelowWriteBufferLowWatermark() override {}
 
     ActiveClient& parent_;
+    const bool pipelinable_;
     bool encode_complete_{};
     bool saw_close_header_{};
     bool decode_complete_{};
@@ -77,7 +88,9 @@ protected:
     ActiveClient(ConnPoolImpl& parent);
     ~ActiveClient();
 
+    bool canPipeline(uint64_t max_requests) const;
     void onConnectTimeout();
+    void onIdleTimeout() { parent_.onIdleTimeout(*this); }
 
     // Network::ConnectionCallbacks
     void onEvent(Network::ConnectionEvent event) override {
@@ -89,17 +102,22 @@ protected:
     ConnPoolImpl& parent_;
     CodecClientPtr codec_client_;
     Upstream::HostDescriptionConstSharedPtr real_host_description_;
-    StreamWrapperPtr stream_wrapper_;
+    // The requests in flight, oldest first. There is more than one when requests are pipelined.
+    std::list<StreamWrapperPtr> stream_wrappers_;
     Event::TimerPtr connect_timer_;
+    // Only created once the client first becomes idle with an idle timeout configured.
+    Event::TimerPtr idle_timer_;
     Stats::TimespanPtr conn_length_;
     uint64_t remaining_requests_;
+    // Whether the connection has been kept alive across a response.
+    bool reused_{};
   };
 
   typedef std::unique_ptr<ActiveClient> ActiveClientPtr;
 
   struct PendingRequest : LinkedObject<PendingRequest>, public ConnectionPool::Cancellable {
     PendingRequest(ConnPoolImpl& parent, StreamDecoder& decoder,
-                   ConnectionPool::Callbacks& callbacks);
+                   ConnectionPool::Callbacks& callbacks, bool pipelinable);
     ~PendingRequest();
 
     // Cancellable
@@ -108,19 +126,25 @@ protected:
     ConnPoolImpl& parent_;
     StreamDecoder& decoder_;
     ConnectionPool::Callbacks& callbacks_;
+    const bool pipelinable_;
   };
 
   typedef std::unique_ptr<PendingRequest> PendingRequestPtr;
 
   void attachRequestToClient(ActiveClient& client, StreamDecoder& response_decoder,
-                             ConnectionPool::Callbacks& callbacks);
+                             ConnectionPool::Callbacks& callbacks, bool pipelinable);
   virtual CodecClientPtr createCodecClient(Upstream::Host::CreateConnectionData& data) PURE;
   void checkForDrained();
   void createNewConnection();
+  ConnectionPool::Cancellable* newStream(StreamDecoder& response_decoder,
+                                         ConnectionPool::Callbacks& callbacks, bool pipelinable);
   void onConnectionEvent(ActiveClient& client, Network::ConnectionEvent event);
   void onDownstreamReset(ActiveClient& client);
+  void onIdleTimeout(ActiveClient& client);
   void onPendingRequestCancel(PendingRequest& request);
   void onResponseComplete(ActiveClient& client);
+  ActiveClient* pipeliningClient();
+  void prefetchConnections();
   void processIdleClient(ActiveClient& client);
 
   Stats::TimespanPtr conn_connect_ms_;
@@ -131,6 +155,8 @@ protected:
   std::list<PendingRequestPtr> pending_requests_;
   std::list<DrainedCb> drained_callbacks_;
   Upstream::ResourcePriority priority_;
+  // Clients which are still connecting. They are in busy_clients_ without a request.
+  uint64_t connecting_clients_{};
 };
 
 /**
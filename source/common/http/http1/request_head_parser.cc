@@ -0,0 +1,200 @@
+#include "common/http/http1/request_head_parser.h"
+
+#include <strings.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+namespace {
+
+/**
+ * Character classes accepted by the fast path. Each class is a subset of what http_parser accepts
+ * in the same position.
+ */
+struct CharTables {
+  CharTables() {
+    for (int c = 0; c < 256; c++) {
+      // RFC 7230 tchar.
+      token_[c] = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                  (c != 0 && strchr("!#$%&'*+-.^_`|~", c) != nullptr);
+      // Visible ASCII, without the fragment delimiter.
+      url_[c] = c > 0x20 && c < 0x7f && c != '#';
+      // Visible ASCII, space, tab and obs-text.
+      value_[c] = (c >= 0x20 && c != 0x7f) || c == '\t';
+    }
+  }
+
+  bool token_[256];
+  bool url_[256];
+  bool value_[256];
+};
+
+const CharTables& charTables() {
+  static CharTables* tables = new CharTables();
+  return *tables;
+}
+
+struct Method {
+  const char* prefix_;
+  size_t length_;
+  http_method method_;
+};
+
+// Methods which are handled by the fast path, including the space which follows them. These are
+// the methods which are commonly sent without a body.
+const Method METHODS[] = {
+    {"GET ", 4, HTTP_GET},
+    {"HEAD ", 5, HTTP_HEAD},
+    {"DELETE ", 7, HTTP_DELETE},
+    {"OPTIONS ", 8, HTTP_OPTIONS},
+};
+
+const char VERSION[] = "HTTP/1.1\r\n";
+
+bool equalsIgnoreCase(const RequestHeadParser::Span& span, const char* str, size_t length) {
+  return span.length_ == length && strncasecmp(span.data_, str, length) == 0;
+}
+
+/**
+ * @return whether http_parser gives special meaning to a header, in which case the request is left
+ *         to http_parser. Supporting these would mean replicating http_parser's handling of message
+ *         framing and connection persistence.
+ */
+bool isSpecialHeader(const RequestHeadParser::Header& header) {
+  static const char CONNECTION[] = "connection";
+  static const char KEEP_ALIVE[] = "keep-alive";
+  static const char CONTENT_LENGTH[] = "content-length";
+  static const char PROXY_CONNECTION[] = "proxy-connection";
+  static const char TRANSFER_ENCODING[] = "transfer-encoding";
+  static const char UPGRADE[] = "upgrade";
+
+  if (equalsIgnoreCase(header.name_, CONNECTION, sizeof(CONNECTION) - 1)) {
+    // Keep-alive is the default for HTTP/1.1, so this is the only value that changes nothing.
+    return !equalsIgnoreCase(header.value_, KEEP_ALIVE, sizeof(KEEP_ALIVE) - 1);
+  }
+
+  return equalsIgnoreCase(header.name_, CONTENT_LENGTH, sizeof(CONTENT_LENGTH) - 1) ||
+         equalsIgnoreCase(header.name_, PROXY_CONNECTION, sizeof(PROXY_CONNECTION) - 1) ||
+         equalsIgnoreCase(header.name_, TRANSFER_ENCODING, sizeof(TRANSFER_ENCODING) - 1) ||
+         equalsIgnoreCase(header.name_, UPGRADE, sizeof(UPGRADE) - 1);
+}
+
+} // namespace
+
+size_t RequestHeadParser::parse(const char* data, size_t length) {
+  // http_parser rejects heads longer than HTTP_MAX_HEADER_SIZE. Never look further than that, and
+  // leave the error for overly long heads to http_parser.
+  length = std::min<size_t>(length, HTTP_MAX_HEADER_SIZE);
+  headers_.clear();
+
+  size_t offset = parseRequestLine(data, length);
+  if (offset == 0) {
+    return 0;
+  }
+
+  while (true) {
+    if (length - offset >= 2 && data[offset] == '\r' && data[offset + 1] == '\n') {
+      return offset + 2;
+    }
+
+    const size_t line_length = parseHeaderLine(data + offset, length - offset);
+    if (line_length == 0) {
+      return 0;
+    }
+    offset += line_length;
+  }
+}
+
+size_t RequestHeadParser::parseRequestLine(const char* data, size_t length) {
+  const Method* method = nullptr;
+  for (const Method& candidate : METHODS) {
+    if (length >= candidate.length_ && memcmp(data, candidate.prefix_, candidate.length_) == 0) {
+      method = &candidate;
+      break;
+    }
+  }
+  if (method == nullptr) {
+    return 0;
+  }
+
+  // Only origin form targets. Absolute URLs, CONNECT authorities and OPTIONS * take the slow path.
+  const char* url = data + method->length_;
+  const char* end = data + length;
+  if (url == end || *url != '/') {
+    return 0;
+  }
+
+  const char* url_end = static_cast<const char*>(memchr(url, ' ', end - url));
+  if (url_end == nullptr) {
+    return 0;
+  }
+
+  const CharTables& tables = charTables();
+  for (const char* c = url; c != url_end; c++) {
+    if (!tables.url_[static_cast<uint8_t>(*c)]) {
+      return 0;
+    }
+  }
+
+  const char* version = url_end + 1;
+  if (static_cast<size_t>(end - version) < sizeof(VERSION) - 1 ||
+      memcmp(version, VERSION, sizeof(VERSION) - 1) != 0) {
+    return 0;
+  }
+
+  method_ = method->method_;
+  url_ = {url, static_cast<size_t>(url_end - url)};
+  return version + sizeof(VERSION) - 1 - data;
+}
+
+size_t RequestHeadParser::parseHeaderLine(const char* data, size_t length) {
+  const char* end = data + length;
+  const char* cr = static_cast<const char*>(memchr(data, '\r', length));
+  if (cr == nullptr || cr + 1 == end || cr[1] != '\n') {
+    // Either the head is incomplete, or the line ends in a bare CR.
+    return 0;
+  }
+
+  // A line starting with whitespace (obs-fold) is not a token and is declined here.
+  const CharTables& tables = charTables();
+  const char* name_end = data;
+  while (name_end != cr && tables.token_[static_cast<uint8_t>(*name_end)]) {
+    name_end++;
+  }
+  if (name_end == data || name_end == cr || *name_end != ':') {
+    return 0;
+  }
+
+  const char* value = name_end + 1;
+  while (value != cr && (*value == ' ' || *value == '\t')) {
+    value++;
+  }
+  // http_parser does not call back for empty values, and keeps trailing whitespace in values.
+  // Leave both to http_parser rather than depend on those details.
+  if (value == cr || cr[-1] == ' ' || cr[-1] == '\t') {
+    return 0;
+  }
+  for (const char* c = value; c != cr; c++) {
+    if (!tables.value_[static_cast<uint8_t>(*c)]) {
+      return 0;
+    }
+  }
+
+  const Header header{{data, static_cast<size_t>(name_end - data)},
+                      {value, static_cast<size_t>(cr - value)}};
+  if (isSpecialHeader(header)) {
+    return 0;
+  }
+
+  headers_.push_back(header);
+  return cr + 2 - data;
+}
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <http_parser.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+/**
+ * A fast path parser for the common shape of HTTP/1.1 request: a complete, bodyless request head
+ * (GET, HEAD, DELETE or OPTIONS with an origin form path) contained in a single buffer. Rather than
+ * running http_parser's byte at a time state machine, lines are delimited with memchr() (which is
+ * vectorized by the C library) and validated against small lookup tables.
+ *
+ * The parser is deliberately conservative: it only accepts input that http_parser would parse
+ * identically, and declines anything else (partial input, bodies, chunked encoding, upgrades,
+ * connection close, HTTP/1.0, obsolete line folding, bare LF line endings, unusual characters,
+ * etc.) so that the caller falls back to http_parser, which then produces exactly the same result
+ * or error as it always did.
+ */
+class RequestHeadParser {
+public:
+  struct Span {
+    const char* data_;
+    size_t length_;
+  };
+
+  struct Header {
+    Span name_;
+    Span value_;
+  };
+
+  /**
+   * Parse a request head.
+   * @param data supplies the start of the input, which must start at the beginning of a request.
+   * @param length supplies the length of the input.
+   * @return size_t the length of the request head including the terminating empty line, or 0 if
+   *         the input was declined and must be parsed by http_parser.
+   */
+  size_t parse(const char* data, size_t length);
+
+  /**
+   * Accessors for the last successfully parsed request head. Spans point into the parsed input.
+   */
+  http_method method() const { return method_; }
+  const Span& url() const { return url_; }
+  const std::vector<Header>& headers() const { return headers_; }
+
+private:
+  size_t parseRequestLine(const char* data, size_t length);
+  size_t parseHeaderLine(const char* data, size_t length);
+
+  http_method method_{HTTP_GET};
+  Span url_{};
+  // Reused across requests to avoid allocating per request.
+  std::vector<Header> headers_;
+};
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
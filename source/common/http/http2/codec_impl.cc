@@ -1,6 +1,9 @@
 #include "common/http/http2/codec_impl.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <vector>
 
@@ -39,6 +42,8 @@ bool Utility::reconstituteCrumbledCookies(const HeaderString& key, const HeaderS
 
 ConnectionImpl::Http2Callbacks ConnectionImpl::http2_callbacks_;
 ConnectionImpl::Http2Options ConnectionImpl::http2_options_;
+const uint8_t ConnectionImpl::BDP_PING_DATA[8] = {'e', 'n', 'v', 'o', 'y', 'b', 'd', 'p'};
+
 const std::unique_ptr<const Http::HeaderMap> ConnectionImpl::CONTINUE_HEADER{
     new Http::HeaderMapImpl{
         {Http::Headers::get().Status, std::to_string(enumToInt(Code::Continue))}}};
@@ -62,48 +67,53 @@ ConnectionImpl::StreamImpl::StreamImpl(ConnectionImpl& parent, uint32_t buffer_l
   }
 }
 
-static void insertHeader(std::vector<nghttp2_nv>& headers, const HeaderEntry& header) {
-  uint8_t flags = 0;
-  if (header.key().type() == HeaderString::Type::Reference) {
-    flags |= NGHTTP2_NV_FLAG_NO_COPY_NAME;
-  }
-  if (header.value().type() == HeaderString::Type::Reference) {
-    flags |= NGHTTP2_NV_FLAG_NO_COPY_VALUE;
-  }
-  headers.push_back({remove_const<uint8_t>(header.key().c_str()),
-                     remove_const<uint8_t>(header.value().c_str()), header.key().size(),
-                     header.value().size(), flags});
-}
-
 void ConnectionImpl::StreamImpl::buildHeaders(std::vector<nghttp2_nv>& final_headers,
-                                              const HeaderMap& headers) {
-  // nghttp2 requires that all ':' headers come before all other headers. To avoid making higher
-  // layers understand that we do two passes here to build the final header list to encode.
+                                              const HeaderMap& headers, bool reference_all) {
+  struct BuildContext {
+    std::vector<nghttp2_nv>& final_headers_;
+    const bool reference_all_;
+    size_t num_pseudo_headers_;
+  } context{final_headers, reference_all, 0};
+
+  final_headers.clear();
   final_headers.reserve(headers.size());
+  // nghttp2 requires that all ':' headers come before all other headers. To avoid making higher
+  // layers understand that, the ':' headers are inserted after the previous ones, which is the end
+  // of the list unless a ':' header follows other headers in the map.
   headers.iterate(
       [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
-        std::vector<nghttp2_nv>* final_headers = static_cast<std::vector<nghttp2_nv>*>(context);
-        if (header.key().c_str()[0] == ':') {
-          insertHeader(*final_headers, header);
+        BuildContext& build_context = *static_cast<BuildContext*>(context);
+        uint8_t flags = 0;
+        if (build_context.reference_all_ || header.key().type() == HeaderString::Type::Reference) {
+          flags |= NGHTTP2_NV_FLAG_NO_COPY_NAME;
         }
-        return HeaderMap::Iterate::Continue;
-      },
-      &final_headers);
+        if (build_context.reference_all_ ||
+            header.value().type() == HeaderString::Type::Reference) {
+          flags |= NGHTTP2_NV_FLAG_NO_COPY_VALUE;
+        }
+        const nghttp2_nv nv{remove_const<uint8_t>(header.key().c_str()),
+                            remove_const<uint8_t>(header.value().c_str()), header.key().size(),
+                            header.value().size(), flags};
 
-  headers.iterate(
-      [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
-        std::vector<nghttp2_nv>* final_headers = static_cast<std::vector<nghttp2_nv>*>(context);
+        std::vector<nghttp2_nv>& final_headers = build_context.final_headers_;
         if (header.key().c_str()[0] != ':') {
-          insertHeader(*final_headers, header);
+          final_headers.push_back(nv);
+        } else if (build_context.num_pseudo_headers_++ == final_headers.size()) {
+          final_headers.push_back(nv);
+        } else {
+          final_headers.insert(final_headers.begin() + build_context.num_pseudo_headers_ - 1, nv);
         }
         return HeaderMap::Iterate::Continue;
       },
-      &final_headers);
+      &context);
 }
 
 void ConnectionImpl::StreamImpl::encodeHeaders(const HeaderMap& headers, bool end_stream) {
-  std::vector<nghttp2_nv> final_headers;
-  buildHeaders(final_headers, headers);
+  // Unless the codec is dispatching, the frames submitted here are serialized by the
+  // sendPendingFrames() below, so headers which are serialized as soon as they are submitted can
+  // be referenced by nghttp2 rather than copied.
+  std::vector<nghttp2_nv>& final_headers = parent_.final_headers_;
+  buildHeaders(final_headers, headers, !parent_.dispatching_ && headersSerializedOnSubmit());
 
   nghttp2_data_provider provider;
   if (!end_stream) {
@@ -185,8 +195,10 @@ void ConnectionImpl::StreamImpl::saveHeader(HeaderString&& name, HeaderString&&
 }
 
 void ConnectionImpl::StreamImpl::submitTrailers(const HeaderMap& trailers) {
-  std::vector<nghttp2_nv> final_headers;
-  buildHeaders(final_headers, trailers);
+  // Trailers may be submitted while nghttp2 is sending, and pending trailers are destroyed right
+  // after, so only their reference headers are referenced.
+  std::vector<nghttp2_nv>& final_headers = parent_.final_headers_;
+  buildHeaders(final_headers, trailers, false);
   int rc =
       nghttp2_submit_trailer(parent_.session_, stream_id_, &final_headers[0], final_headers.size());
   ASSERT(rc == 0);
@@ -220,9 +232,8 @@ int ConnectionImpl::StreamImpl::onDataSourceSend(const uint8_t* framehd, size_t
   // https://nghttp2.org/documentation/types.html#c.nghttp2_send_data_callback
   static const uint64_t FRAME_HEADER_SIZE = 9;
 
-  Buffer::OwnedImpl output(framehd, FRAME_HEADER_SIZE);
-  output.move(pending_send_data_, length);
-  parent_.connection_.write(output);
+  parent_.output_buffer_.add(framehd, FRAME_HEADER_SIZE);
+  parent_.output_buffer_.move(pending_send_data_, length);
   return 0;
 }
 
@@ -318,6 +329,20 @@ ConnectionImpl::StreamImpl* ConnectionImpl::getStream(int32_t stream_id) {
 }
 
 int ConnectionImpl::onData(int32_t stream_id, const uint8_t* data, size_t len) {
+  if (window_auto_tuning_) {
+    // Count the bytes delivered over the round trip of a PING, sent with the first DATA received
+    // after the previous one is acknowledged.
+    if (!bdp_ping_outstanding_) {
+      int rc = nghttp2_submit_ping(session_, NGHTTP2_FLAG_NONE, BDP_PING_DATA);
+      ASSERT(rc == 0);
+      UNREFERENCED_PARAMETER(rc);
+      bdp_ping_outstanding_ = true;
+      bdp_ping_sent_ = ProdMonotonicTimeSource::instance_.currentTime();
+      bdp_bytes_ = 0;
+    }
+    bdp_bytes_ += len;
+  }
+
   StreamImpl* stream = getStream(stream_id);
   // If this results in buffering too much data, the watermark buffer will call
   // pendingRecvBufferHighWatermark, resulting in ++read_disable_count_
@@ -332,6 +357,65 @@ int ConnectionImpl::onData(int32_t stream_id, const uint8_t* data, size_t len) {
   return 0;
 }
 
+void ConnectionImpl::onBdpPingAck() {
+  bdp_ping_outstanding_ = false;
+  const std::chrono::microseconds rtt = std::chrono::duration_cast<std::chrono::microseconds>(
+      ProdMonotonicTimeSource::instance_.currentTime() - bdp_ping_sent_);
+  ENVOY_CONN_LOG(trace, "{} bytes received over a round trip of {}us", connection_, bdp_bytes_,
+                 rtt.count());
+
+  // While a consumer has disabled reads on a stream, the watermark buffers rather than the windows
+  // are limiting the throughput, and the bytes delivered say nothing about the link.
+  for (const StreamImplPtr& stream : active_streams_) {
+    if (stream->buffers_overrun()) {
+      return;
+    }
+  }
+
+  // The windows only limit the throughput when most of them is in flight over a round trip, in
+  // which case they are grown to twice the bandwidth-delay product, as the product may itself be
+  // capped by the current windows.
+  if (bdp_bytes_ * 3 >= std::min(stream_window_size_, connection_window_size_) * 2ULL) {
+    growWindows(2 * bdp_bytes_);
+  }
+}
+
+void ConnectionImpl::growWindows(uint64_t bdp) {
+  const uint32_t stream_window_size =
+      std::max<uint64_t>(stream_window_size_, std::min<uint64_t>(bdp, max_stream_window_size_));
+  const uint32_t connection_window_size = std::max<uint64_t>(
+      connection_window_size_, std::min<uint64_t>(bdp, max_connection_window_size_));
+  if (stream_window_size == stream_window_size_ &&
+      connection_window_size == connection_window_size_) {
+    return;
+  }
+
+  ENVOY_CONN_LOG(debug, "growing stream window to {} and connection window to {}", connection_,
+                 stream_window_size, connection_window_size);
+  stats_.window_size_increased_.inc();
+  if (stream_window_size != stream_window_size_) {
+    // The new initial window size applies to the windows of all the open streams as well.
+    nghttp2_settings_entry iv{NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE, stream_window_size};
+    int rc = nghttp2_submit_settings(session_, NGHTTP2_FLAG_NONE, &iv, 1);
+    ASSERT(rc == 0);
+    UNREFERENCED_PARAMETER(rc);
+    stream_window_size_ = stream_window_size;
+
+    // The watermarks of the stream buffers follow the window, which bounds what the peer can send.
+    per_stream_buffer_limit_ = stream_window_size_;
+    for (const StreamImplPtr& stream : active_streams_) {
+      stream->setWriteBufferWatermarks(per_stream_buffer_limit_ / 2, per_stream_buffer_limit_);
+    }
+  }
+  if (connection_window_size != connection_window_size_) {
+    int rc = nghttp2_submit_window_update(session_, NGHTTP2_FLAG_NONE, 0,
+                                          connection_window_size - connection_window_size_);
+    ASSERT(rc == 0);
+    UNREFERENCED_PARAMETER(rc);
+    connection_window_size_ = connection_window_size;
+  }
+}
+
 void ConnectionImpl::goAway() {
   int rc = nghttp2_submit_goaway(session_, NGHTTP2_FLAG_NONE,
                                  nghttp2_session_get_last_proc_stream_id(session_),
@@ -362,6 +446,13 @@ int ConnectionImpl::onFrameReceived(const nghttp2_frame* frame) {
     return 0;
   }
 
+  if (frame->hd.type == NGHTTP2_PING && (frame->hd.flags & NGHTTP2_FLAG_ACK) &&
+      bdp_ping_outstanding_ &&
+      memcmp(frame->ping.opaque_data, BDP_PING_DATA, sizeof(BDP_PING_DATA)) == 0) {
+    onBdpPingAck();
+    return 0;
+  }
+
   StreamImpl* stream = getStream(frame->hd.stream_id);
   if (!stream) {
     return 0;
@@ -380,10 +471,10 @@ int ConnectionImpl::onFrameReceived(const nghttp2_frame* frame) {
                                                 Headers::get().ExpectValues._100Continue.c_str())) {
       // Deal with expect: 100-continue here since higher layers are never going to do anything
       // other than say to continue so that we can respond before request complete if necessary.
-      std::vector<nghttp2_nv> final_headers;
-      StreamImpl::buildHeaders(final_headers, *CONTINUE_HEADER);
-      int rc = nghttp2_submit_headers(session_, 0, stream->stream_id_, nullptr, &final_headers[0],
-                                      final_headers.size(), nullptr);
+      // The 100-continue headers are static, so nghttp2 can reference them.
+      StreamImpl::buildHeaders(final_headers_, *CONTINUE_HEADER, true);
+      int rc = nghttp2_submit_headers(session_, 0, stream->stream_id_, nullptr,
+                                      &final_headers_[0], final_headers_.size(), nullptr);
       ASSERT(rc == 0);
       UNREFERENCED_PARAMETER(rc);
 
@@ -505,8 +596,7 @@ int ConnectionImpl::onInvalidFrame(int error_code) {
 
 ssize_t ConnectionImpl::onSend(const uint8_t* data, size_t length) {
   ENVOY_CONN_LOG(trace, "send data: bytes={}", connection_, length);
-  Buffer::OwnedImpl buffer(data, length);
-  connection_.write(buffer);
+  output_buffer_.add(data, length);
   return length;
 }
 
@@ -564,6 +654,15 @@ void ConnectionImpl::sendPendingFrames() {
   }
 
   int rc = nghttp2_session_send(session_);
+  // Frames are gathered into output_buffer_ while nghttp2 serializes them, so that a whole send
+  // pass reaches the connection in one write. This happens before checking for errors so that a
+  // GOAWAY frame sent because of a protocol error still goes out. The frames are moved out first,
+  // as writing may dispatch back into this codec.
+  if (output_buffer_.length() > 0) {
+    Buffer::OwnedImpl output;
+    output.move(output_buffer_);
+    connection_.write(output);
+  }
   if (rc != 0) {
     ASSERT(rc == NGHTTP2_ERR_CALLBACK_FAILURE);
     throw CodecProtocolException(fmt::format("{}", nghttp2_strerror(rc)));
@@ -618,11 +717,11 @@ void ConnectionImpl::sendSettings(const Http2Settings& http2_settings, bool disa
                    http2_settings.max_concurrent_streams_);
   }
 
-  if (http2_settings.initial_stream_window_size_ != NGHTTP2_INITIAL_WINDOW_SIZE) {
-    iv.push_back(
-        {NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE, http2_settings.initial_stream_window_size_});
+  // When auto-tuning, the windows start from the spec initial sizes, not the configured ones.
+  if (stream_window_size_ != NGHTTP2_INITIAL_WINDOW_SIZE) {
+    iv.push_back({NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE, stream_window_size_});
     ENVOY_CONN_LOG(debug, "setting stream-level initial window size to {}", connection_,
-                   http2_settings.initial_stream_window_size_);
+                   stream_window_size_);
   }
 
   if (disable_push) {
@@ -644,11 +743,11 @@ void ConnectionImpl::sendSettings(const Http2Settings& http2_settings, bool disa
   }
 
   // Increase connection window size up to our default size.
-  if (http2_settings.initial_connection_window_size_ != NGHTTP2_INITIAL_CONNECTION_WINDOW_SIZE) {
+  if (connection_window_size_ != NGHTTP2_INITIAL_CONNECTION_WINDOW_SIZE) {
     ENVOY_CONN_LOG(debug, "updating connection-level initial window size to {}", connection_,
-                   http2_settings.initial_connection_window_size_);
+                   connection_window_size_);
     int rc = nghttp2_submit_window_update(session_, NGHTTP2_FLAG_NONE, 0,
-                                          http2_settings.initial_connection_window_size_ -
+                                          connection_window_size_ -
                                               NGHTTP2_INITIAL_CONNECTION_WINDOW_SIZE);
     ASSERT(rc == 0);
     UNREFERENCED_PARAMETER(rc);
@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "envoy/common/optional.h"
+#include "envoy/common/time.h"
 #include "envoy/event/deferred_deletable.h"
 #include "envoy/http/codec.h"
 #include "envoy/network/connection.h"
@@ -41,7 +42,8 @@ const std::string CLIENT_MAGIC_PREFIX = "PRI * HTTP/2";
   COUNTER(tx_reset)                                                                                \
   COUNTER(header_overflow)                                                                         \
   COUNTER(trailers)                                                                                \
-  COUNTER(headers_cb_no_stream)
+  COUNTER(headers_cb_no_stream)                                                                    \
+  COUNTER(window_size_increased)
 // clang-format on
 
 /**
@@ -73,8 +75,17 @@ public:
                  const Http2Settings& http2_settings)
       : stats_{ALL_HTTP2_CODEC_STATS(POOL_COUNTER_PREFIX(stats, "http2."))},
         connection_(connection),
-        per_stream_buffer_limit_(http2_settings.initial_stream_window_size_), dispatching_(false),
-        raised_goaway_(false), pending_deferred_reset_(false) {}
+        max_stream_window_size_(http2_settings.initial_stream_window_size_),
+        max_connection_window_size_(http2_settings.initial_connection_window_size_),
+        stream_window_size_(http2_settings.window_auto_tuning_
+                                ? Http2Settings::MIN_INITIAL_STREAM_WINDOW_SIZE
+                                : max_stream_window_size_),
+        connection_window_size_(http2_settings.window_auto_tuning_
+                                    ? Http2Settings::MIN_INITIAL_CONNECTION_WINDOW_SIZE
+                                    : max_connection_window_size_),
+        per_stream_buffer_limit_(stream_window_size_), dispatching_(false), raised_goaway_(false),
+        pending_deferred_reset_(false), window_auto_tuning_(http2_settings.window_auto_tuning_),
+        bdp_ping_outstanding_(false) {}
 
   ~ConnectionImpl();
 
@@ -140,10 +151,23 @@ protected:
     ssize_t onDataSourceRead(uint64_t length, uint32_t* data_flags);
     int onDataSourceSend(const uint8_t* framehd, size_t length);
     void resetStreamWorker(StreamResetReason reason);
-    static void buildHeaders(std::vector<nghttp2_nv>& final_headers, const HeaderMap& headers);
+    /**
+     * Convert headers into the list of name/value pairs submitted to nghttp2.
+     * @param final_headers supplies the list to fill, which is cleared first.
+     * @param headers supplies the headers.
+     * @param reference_all supplies whether nghttp2 may reference all of the names and values
+     *        rather than copy them, or only those which are references themselves.
+     */
+    static void buildHeaders(std::vector<nghttp2_nv>& final_headers, const HeaderMap& headers,
+                             bool reference_all);
     void saveHeader(HeaderString&& name, HeaderString&& value);
     virtual void submitHeaders(const std::vector<nghttp2_nv>& final_headers,
                                nghttp2_data_provider* provider) PURE;
+    /**
+     * @return bool whether nghttp2 serializes the headers of the stream on the first send after
+     *         they are submitted.
+     */
+    virtual bool headersSerializedOnSubmit() const PURE;
     void submitTrailers(const HeaderMap& trailers);
 
     // Http::StreamEncoder
@@ -214,6 +238,8 @@ protected:
     // StreamImpl
     void submitHeaders(const std::vector<nghttp2_nv>& final_headers,
                        nghttp2_data_provider* provider) override;
+    // nghttp2 holds back a request while the peer's limit of concurrent streams is reached.
+    bool headersSerializedOnSubmit() const override { return false; }
   };
 
   /**
@@ -225,6 +251,7 @@ protected:
     // StreamImpl
     void submitHeaders(const std::vector<nghttp2_nv>& final_headers,
                        nghttp2_data_provider* provider) override;
+    bool headersSerializedOnSubmit() const override { return true; }
   };
 
   ConnectionImpl* base() { return this; }
@@ -238,9 +265,19 @@ protected:
 
   std::list<StreamImplPtr> active_streams_;
   nghttp2_session* session_{};
+  // Reused to build the name/value pairs of the headers submitted to nghttp2, which copies them.
+  std::vector<nghttp2_nv> final_headers_;
   CodecStats stats_;
   Network::Connection& connection_;
+  // The configured window sizes, which are the bounds of the current ones when auto-tuning.
+  const uint32_t max_stream_window_size_;
+  const uint32_t max_connection_window_size_;
+  uint32_t stream_window_size_;
+  uint32_t connection_window_size_;
   uint32_t per_stream_buffer_limit_;
+  // Frames serialized by nghttp2 during sendPendingFrames(), which have yet to be written to the
+  // connection.
+  Buffer::OwnedImpl output_buffer_;
 
 private:
   virtual ConnectionCallbacks& callbacks() PURE;
@@ -252,12 +289,22 @@ private:
   int onInvalidFrame(int error_code);
   ssize_t onSend(const uint8_t* data, size_t length);
   int onStreamClose(int32_t stream_id, uint32_t error_code);
+  void onBdpPingAck();
+  void growWindows(uint64_t bdp);
 
   static const std::unique_ptr<const Http::HeaderMap> CONTINUE_HEADER;
+  // Opaque data of the PINGs which measure the bandwidth-delay product of the connection.
+  static const uint8_t BDP_PING_DATA[8];
 
+  // The DATA bytes received since the outstanding BDP PING was sent, i.e. over a round trip once
+  // it is acknowledged.
+  uint64_t bdp_bytes_{};
+  MonotonicTime bdp_ping_sent_;
   bool dispatching_ : 1;
   bool raised_goaway_ : 1;
   bool pending_deferred_reset_ : 1;
+  const bool window_auto_tuning_ : 1;
+  bool bdp_ping_outstanding_ : 1;
 };
 
 /**
@@ -288,6 +335,10 @@ public:
   ServerConnectionImpl(Network::Connection& connection, ServerConnectionCallbacks& callbacks,
                        Stats::Scope& scope, const Http2Settings& http2_settings);
 
+  // Http::ServerConnection
+  // The session state lives for the whole connection, so it can never be replaced.
+  bool idle() override { return false; }
+
 private:
   // ConnectionImpl
   ConnectionCallbacks& callbacks() override { return callbacks_; }
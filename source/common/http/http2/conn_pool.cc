@@ -26,12 +26,12 @@ ConnPoolImpl::~ConnPoolImpl() {
 }
 
 void ConnPoolImpl::ConnPoolImpl::closeConnections() {
-  if (primary_client_) {
-    primary_client_->client_->close();
+  while (!primary_clients_.empty()) {
+    primary_clients_.front()->client_->close();
   }
 
-  if (draining_client_) {
-    draining_client_->client_->close();
+  while (!draining_clients_.empty()) {
+    draining_clients_.front()->client_->close();
   }
 }
 
@@ -46,18 +46,20 @@ void ConnPoolImpl::checkForDrained() {
   }
 
   bool drained = true;
-  if (primary_client_) {
-    if (primary_client_->client_->numActiveRequests() == 0) {
-      primary_client_->client_->close();
-      ASSERT(!primary_client_);
+  for (auto it = primary_clients_.begin(); it != primary_clients_.end();) {
+    ActiveClient& client = **it++;
+    if (client.client_->numActiveRequests() == 0) {
+      client.client_->close();
     } else {
       drained = false;
     }
   }
 
-  ASSERT(!draining_client_ || (draining_client_->client_->numActiveRequests() > 0));
-  if (draining_client_ && draining_client_->client_->numActiveRequests() > 0) {
-    drained = false;
+  for (const ActiveClientPtr& client : draining_clients_) {
+    ASSERT(client->client_->numActiveRequests() > 0);
+    if (client->client_->numActiveRequests() > 0) {
+      drained = false;
+    }
   }
 
   if (drained) {
@@ -78,12 +80,23 @@ ConnectionPool::Cancellable* ConnPoolImpl::newStream(Http::StreamDecoder& respon
     max_streams = maxTotalStreams();
   }
 
-  if (primary_client_ && primary_client_->total_streams_ >= max_streams) {
-    movePrimaryClientToDraining();
+  ActiveClient* client = nullptr;
+  for (auto it = primary_clients_.begin(); it != primary_clients_.end();) {
+    ActiveClient& primary = **it++;
+    if (primary.total_streams_ >= max_streams) {
+      movePrimaryClientToDraining(primary);
+    } else if (!client ||
+               primary.client_->numActiveRequests() < client->client_->numActiveRequests()) {
+      client = &primary;
+    }
   }
 
-  if (!primary_client_) {
-    primary_client_.reset(new ActiveClient(*this));
+  // Only open another connection once every existing one is carrying streams.
+  if (!client || (client->client_->numActiveRequests() > 0 &&
+                  primary_clients_.size() < host_->cluster().http2ConnectionsPerHost())) {
+    ActiveClientPtr new_client(new ActiveClient(*this));
+    new_client->moveIntoList(std::move(new_client), primary_clients_);
+    client = primary_clients_.front().get();
   }
 
   if (!host_->cluster().resourceManager(priority_).requests().canCreate()) {
@@ -91,15 +104,15 @@ ConnectionPool::Cancellable* ConnPoolImpl::newStream(Http::StreamDecoder& respon
     callbacks.onPoolFailure(ConnectionPool::PoolFailureReason::Overflow, nullptr);
     host_->cluster().stats().upstream_rq_pending_overflow_.inc();
   } else {
-    ENVOY_CONN_LOG(debug, "creating stream", *primary_client_->client_);
-    primary_client_->total_streams_++;
+    ENVOY_CONN_LOG(debug, "creating stream", *client->client_);
+    client->total_streams_++;
     host_->stats().rq_total_.inc();
     host_->stats().rq_active_.inc();
     host_->cluster().stats().upstream_rq_total_.inc();
     host_->cluster().stats().upstream_rq_active_.inc();
     host_->cluster().resourceManager(priority_).requests().inc();
-    callbacks.onPoolReady(primary_client_->client_->newStream(response_decoder),
-                          primary_client_->real_host_description_);
+    callbacks.onPoolReady(client->client_->newStream(response_decoder),
+                          client->real_host_description_);
   }
 
   return nullptr;
@@ -118,12 +131,12 @@ void ConnPoolImpl::onConnectionEvent(ActiveClient& client, Network::ConnectionEv
       }
     }
 
-    if (&client == primary_client_.get()) {
+    if (!client.draining_) {
       ENVOY_CONN_LOG(debug, "destroying primary client", *client.client_);
-      dispatcher_.deferredDelete(std::move(primary_client_));
+      dispatcher_.deferredDelete(client.removeFromList(primary_clients_));
     } else {
       ENVOY_CONN_LOG(debug, "destroying draining client", *client.client_);
-      dispatcher_.deferredDelete(std::move(draining_client_));
+      dispatcher_.deferredDelete(client.removeFromList(draining_clients_));
     }
 
     if (client.connect_timer_) {
@@ -146,25 +159,17 @@ void ConnPoolImpl::onConnectionEvent(ActiveClient& client, Network::ConnectionEv
   }
 }
 
-void ConnPoolImpl::movePrimaryClientToDraining() {
-  ENVOY_CONN_LOG(debug, "moving primary to draining", *primary_client_->client_);
-  if (draining_client_) {
-    // This should pretty much never happen, but is possible if we start draining and then get
-    // a goaway for example. In this case just kill the current draining connection. It's not
-    // worth keeping a list.
-    draining_client_->client_->close();
-  }
-
-  ASSERT(!draining_client_);
-  if (primary_client_->client_->numActiveRequests() == 0) {
+void ConnPoolImpl::movePrimaryClientToDraining(ActiveClient& client) {
+  ENVOY_CONN_LOG(debug, "moving primary to draining", *client.client_);
+  ASSERT(!client.draining_);
+  if (client.client_->numActiveRequests() == 0) {
     // If we are making a new connection and the primary does not have any active requests just
     // close it now.
-    primary_client_->client_->close();
+    client.client_->close();
   } else {
-    draining_client_ = std::move(primary_client_);
+    client.draining_ = true;
+    client.moveBetweenLists(primary_clients_, draining_clients_);
   }
-
-  ASSERT(!primary_client_);
 }
 
 void ConnPoolImpl::onConnectTimeout(ActiveClient& client) {
@@ -176,8 +181,8 @@ void ConnPoolImpl::onConnectTimeout(ActiveClient& client) {
 void ConnPoolImpl::onGoAway(ActiveClient& client) {
   ENVOY_CONN_LOG(debug, "remote goaway", *client.client_);
   host_->cluster().stats().upstream_cx_close_notify_.inc();
-  if (&client == primary_client_.get()) {
-    movePrimaryClientToDraining();
+  if (!client.draining_) {
+    movePrimaryClientToDraining(client);
   }
 }
 
@@ -187,7 +192,7 @@ void ConnPoolImpl::onStreamDestroy(ActiveClient& client) {
   host_->stats().rq_active_.dec();
   host_->cluster().stats().upstream_rq_active_.dec();
   host_->cluster().resourceManager(priority_).requests().dec();
-  if (&client == draining_client_.get() && client.client_->numActiveRequests() == 0) {
+  if (client.draining_ && client.client_->numActiveRequests() == 0) {
     // Close out the draining client if we no long have active requests.
     client.client_->close();
   }
@@ -237,7 +242,9 @@ ConnPoolImpl::ActiveClient::ActiveClient(ConnPoolImpl& parent)
                                parent_.host_->cluster().stats().upstream_cx_rx_bytes_buffered_,
                                parent_.host_->cluster().stats().upstream_cx_tx_bytes_total_,
                                parent_.host_->cluster().stats().upstream_cx_tx_bytes_buffered_,
-                               &parent_.host_->cluster().stats().bind_errors_});
+                               &parent_.host_->cluster().stats().bind_errors_,
+                               &parent_.host_->cluster().stats().upstream_cx_rx_syscalls_total_,
+                               &parent_.host_->cluster().stats().upstream_cx_tx_syscalls_total_});
 }
 
 ConnPoolImpl::ActiveClient::~ActiveClient() {
@@ -10,6 +10,7 @@
 #include "envoy/stats/timespan.h"
 #include "envoy/upstream/upstream.h"
 
+#include "common/common/linked_object.h"
 #include "common/http/codec_client.h"
 
 namespace Envoy {
@@ -18,8 +19,10 @@ namespace Http2 {
 
 /**
  * Implementation of a "connection pool" for HTTP/2. This mainly handles stats as well as
- * shifting to a new connection if we reach max streams on the primary. This is a base class
- * used for both the prod implementation as well as the testing one.
+ * shifting to a new connection if we reach max streams on a primary. Streams are spread over up to
+ * ClusterInfo::http2ConnectionsPerHost() primary connections, each new stream going to the one
+ * with the fewest active streams. This is a base class used for both the prod implementation as
+ * well as the testing one.
  */
 class ConnPoolImpl : Logger::Loggable<Logger::Id::pool>, public ConnectionPool::Instance {
 public:
@@ -33,9 +36,15 @@ public:
   void closeConnections() override;
   ConnectionPool::Cancellable* newStream(Http::StreamDecoder& response_decoder,
                                          ConnectionPool::Callbacks& callbacks) override;
+  // Streams are multiplexed rather than pipelined.
+  ConnectionPool::Cancellable* newPipelinableStream(Http::StreamDecoder& response_decoder,
+                                                    ConnectionPool::Callbacks& callbacks) override {
+    return newStream(response_decoder, callbacks);
+  }
 
 protected:
-  struct ActiveClient : public Network::ConnectionCallbacks,
+  struct ActiveClient : LinkedObject<ActiveClient>,
+                        public Network::ConnectionCallbacks,
                         public CodecClientCallbacks,
                         public Event::DeferredDeletable,
                         public Http::ConnectionCallbacks {
@@ -67,6 +76,7 @@ protected:
     Event::TimerPtr connect_timer_;
     Stats::TimespanPtr conn_length_;
     bool closed_with_active_rq_{};
+    bool draining_{};
   };
 
   typedef std::unique_ptr<ActiveClient> ActiveClientPtr;
@@ -74,7 +84,7 @@ protected:
   void checkForDrained();
   virtual CodecClientPtr createCodecClient(Upstream::Host::CreateConnectionData& data) PURE;
   virtual uint32_t maxTotalStreams() PURE;
-  void movePrimaryClientToDraining();
+  void movePrimaryClientToDraining(ActiveClient& client);
   void onConnectionEvent(ActiveClient& client, Network::ConnectionEvent event);
   void onConnectTimeout(ActiveClient& client);
   void onGoAway(ActiveClient& client);
@@ -84,8 +94,8 @@ protected:
   Stats::TimespanPtr conn_connect_ms_;
   Event::Dispatcher& dispatcher_;
   Upstream::HostConstSharedPtr host_;
-  ActiveClientPtr primary_client_;
-  ActiveClientPtr draining_client_;
+  std::list<ActiveClientPtr> primary_clients_;
+  std::list<ActiveClientPtr> draining_clients_;
   std::list<DrainedCb> drained_callbacks_;
   Upstream::ResourcePriority priority_;
 };
@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <string>
 
+#include "common/buffer/buffer_impl.h"
 #include "common/common/enum_to_int.h"
 #include "common/http/message_impl.h"
 #include "common/http/utility.h"
@@ -33,6 +34,10 @@ void RestApiFetcher::onSuccess(Http::MessagePtr&& response) {
     return;
   }
 
+  if (!response->body()) {
+    response->body().reset(new Buffer::OwnedImpl());
+  }
+
   try {
     parseResponse(*response);
   } catch (EnvoyException& e) {
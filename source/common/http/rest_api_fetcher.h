@@ -33,9 +33,10 @@ protected:
   virtual void createRequest(Message& request) PURE;
 
   /**
-   * This will be called when a 200 response is returned by the API with the response message.
+   * This will be called when a 200 response is returned by the API with the response message. The
+   * body of the response is never null, and is best parsed in place rather than as a string.
    */
-  virtual void parseResponse(const Message& response) PURE;
+  virtual void parseResponse(Message& response) PURE;
 
   /**
    * This will be called either in the success case or in the failure case for each fetch. It can
@@ -12,14 +12,11 @@ namespace Envoy {
 namespace Http {
 
 void UserAgent::completeConnectionLength(Stats::Timespan& span) {
-
-  // Note: stats_ and scope_ are set together, so it's assumed that scope_ will be non-nullptr if
-  // stats_ is.
   if (!stats_) {
     return;
   }
 
-  scope_->histogram(prefix_ + "downstream_cx_length_ms").recordValue(span.getRawDuration().count());
+  stats_->downstream_cx_length_ms_.recordValue(span.getRawDuration().count());
 }
 
 void UserAgent::initializeFromHeaders(const HeaderMap& headers, const std::string& prefix,
@@ -31,23 +28,25 @@ void UserAgent::initializeFromHeaders(const HeaderMap& headers, const std::strin
 
   type_ = Type::Unknown;
 
+  std::string stat_prefix;
   const HeaderEntry* user_agent = headers.UserAgent();
   if (user_agent) {
-    prefix_ = prefix;
     if (user_agent->value().find("iOS")) {
       type_ = Type::iOS;
-      prefix_ += "user_agent.ios.";
+      stat_prefix = prefix + "user_agent.ios.";
     } else if (user_agent->value().find("android")) {
       type_ = Type::Android;
-      prefix_ += "user_agent.android.";
+      stat_prefix = prefix + "user_agent.android.";
     }
   }
 
   if (type_ != Type::Unknown) {
-    stats_.reset(new UserAgentStats{ALL_USER_AGENTS_STATS(POOL_COUNTER_PREFIX(scope, prefix_))});
+    // The connection length histogram is resolved along with the counters, so that completing
+    // the connection doesn't build its name again.
+    stats_.reset(new UserAgentStats{ALL_USER_AGENTS_STATS(
+        POOL_COUNTER_PREFIX(scope, stat_prefix), POOL_HISTOGRAM_PREFIX(scope, stat_prefix))});
     stats_->downstream_cx_total_.inc();
     stats_->downstream_rq_total_.inc();
-    scope_ = &scope;
   }
 }
 
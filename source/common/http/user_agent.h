@@ -14,17 +14,18 @@ namespace Envoy {
  * All stats for user agents. @see stats_macros.h
  */
 // clang-format off
-#define ALL_USER_AGENTS_STATS(COUNTER)                                                             \
+#define ALL_USER_AGENTS_STATS(COUNTER, HISTOGRAM)                                                  \
   COUNTER(downstream_cx_total)                                                                     \
   COUNTER(downstream_cx_destroy_remote_active_rq)                                                  \
-  COUNTER(downstream_rq_total)
+  COUNTER(downstream_rq_total)                                                                     \
+  HISTOGRAM(downstream_cx_length_ms)
 // clang-format on
 
 /**
  * Wrapper struct for user agent stats. @see stats_macros.h
  */
 struct UserAgentStats {
-  ALL_USER_AGENTS_STATS(GENERATE_COUNTER_STRUCT)
+  ALL_USER_AGENTS_STATS(GENERATE_COUNTER_STRUCT, GENERATE_HISTOGRAM_STRUCT)
 };
 
 namespace Http {
@@ -62,8 +63,6 @@ private:
 
   Type type_{Type::NotInitialized};
   std::unique_ptr<UserAgentStats> stats_;
-  std::string prefix_;
-  Stats::Scope* scope_{};
 };
 
 } // namespace Http
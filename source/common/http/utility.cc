@@ -163,6 +163,32 @@ bool Utility::hasSetCookie(const HeaderMap& headers, const std::string& key) {
   return state.ret_;
 }
 
+void Utility::forEachHeaderElement(const HeaderMap& headers, const LowerCaseString& name,
+                                   std::function<void(const std::string&)> cb) {
+  struct Context {
+    const LowerCaseString& name_;
+    std::function<void(const std::string&)>& cb_;
+  } context{name, cb};
+
+  headers.iterate(
+      [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
+        Context& ctx = *static_cast<Context*>(context);
+        if (header.key() != ctx.name_.get().c_str()) {
+          return HeaderMap::Iterate::Continue;
+        }
+
+        for (std::string element : StringUtil::split(header.value().c_str(), ',')) {
+          element.erase(0, element.find_first_not_of(" \t"));
+          StringUtil::rtrim(element);
+          if (!element.empty()) {
+            ctx.cb_(element);
+          }
+        }
+        return HeaderMap::Iterate::Continue;
+      },
+      &context);
+}
+
 uint64_t Utility::getResponseStatus(const HeaderMap& headers) {
   const HeaderEntry* header = headers.Status();
   uint64_t response_code;
@@ -194,6 +220,17 @@ bool Utility::isWebSocketUpgradeRequest(const HeaderMap& headers) {
                     Http::Headers::get().UpgradeValues.WebSocket.c_str())));
 }
 
+bool Utility::isIdempotentRequest(const HeaderMap& headers) {
+  if (!headers.Method()) {
+    return false;
+  }
+
+  const auto& methods = Headers::get().MethodValues;
+  const char* method = headers.Method()->value().c_str();
+  return methods.Get == method || methods.Head == method || methods.Options == method ||
+         methods.Trace == method || methods.Put == method || methods.Delete == method;
+}
+
 Http2Settings Utility::parseHttp2Settings(const envoy::api::v2::Http2ProtocolOptions& config) {
   Http2Settings ret;
   ret.hpack_table_size_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(
@@ -258,13 +295,19 @@ std::string Utility::getLastAddressFromXFF(const Http::HeaderMap& request_header
     return EMPTY_STRING;
   }
 
-  std::vector<std::string> xff_address_list =
-      StringUtil::split(request_headers.ForwardedFor()->value().c_str(), ", ");
-
-  if (xff_address_list.empty()) {
-    return EMPTY_STRING;
+  // This runs for every request, so scan back from the end for the last non empty address rather
+  // than splitting the whole list.
+  const HeaderString& xff = request_headers.ForwardedFor()->value();
+  const char* data = xff.c_str();
+  size_t end = xff.size();
+  while (end >= 2 && data[end - 2] == ',' && data[end - 1] == ' ') {
+    end -= 2;
+  }
+  size_t start = end;
+  while (start > 0 && !(start >= 2 && data[start - 2] == ',' && data[start - 1] == ' ')) {
+    start--;
   }
-  return xff_address_list.back();
+  return std::string(data + start, end - start);
 }
 
 } // namespace Http
@@ -2,6 +2,7 @@
 
 #include <chrono>
 #include <cstdint>
+#include <functional>
 #include <string>
 
 #include "envoy/http/codes.h"
@@ -66,6 +67,16 @@ public:
    */
   static bool hasSetCookie(const HeaderMap& headers, const std::string& key);
 
+  /**
+   * Call a function on each comma separated element of the values of a header, with surrounding
+   * whitespace removed. Empty elements are skipped.
+   * @param headers supplies the headers to search.
+   * @param name supplies the name of the header.
+   * @param cb supplies the function to call with each element.
+   */
+  static void forEachHeaderElement(const HeaderMap& headers, const LowerCaseString& name,
+                                   std::function<void(const std::string&)> cb);
+
   /**
    * Produce the value for a Set-Cookie header with the given parameters.
    * @param key is the name of the cookie that is being set.
@@ -100,6 +111,13 @@ public:
    */
   static bool isWebSocketUpgradeRequest(const HeaderMap& headers);
 
+  /**
+   * Determine whether the method of a request is idempotent, i.e. whether sending the request
+   * more than once has the same effect as sending it once.
+   * https://tools.ietf.org/html/rfc7231#section-4.2.2
+   */
+  static bool isIdempotentRequest(const HeaderMap& headers);
+
   /**
    * @return Http2Settings An Http2Settings populated from the envoy::api::v2::Http2ProtocolOptions
    *         config.
@@ -16,9 +16,10 @@ namespace WebSocket {
 WsHandlerImpl::WsHandlerImpl(HeaderMap& request_headers, const AccessLog::RequestInfo& request_info,
                              const Router::RouteEntry& route_entry, WsHandlerCallbacks& callbacks,
                              Upstream::ClusterManager& cluster_manager,
-                             Network::ReadFilterCallbacks* read_callbacks)
+                             Network::ReadFilterCallbacks* read_callbacks, bool splice_enabled)
     : Filter::TcpProxy(nullptr, cluster_manager), request_headers_(request_headers),
-      request_info_(request_info), route_entry_(route_entry), ws_callbacks_(callbacks) {
+      request_info_(request_info), route_entry_(route_entry), ws_callbacks_(callbacks),
+      splice_enabled_(splice_enabled) {
 
   initializeReadFilterCallbacks(*read_callbacks);
 }
@@ -67,6 +68,8 @@ void WsHandlerImpl::onConnectionSuccess() {
   // is supposed to allow websocket upgrades or not.
   Http1::ClientConnectionImpl upstream_http(*upstream_connection_, http_conn_callbacks_);
   Http1::RequestStreamEncoderImpl upstream_request = Http1::RequestStreamEncoderImpl(upstream_http);
+  // If splicing started, the headers are written from the upstream connection's write buffer before
+  // any spliced data, so they still go out first.
   upstream_request.encodeHeaders(request_headers_, false);
 }
 
@@ -21,20 +21,23 @@ namespace WebSocket {
  * (i.e, it is requested by client and allowed by config). This implementation will
  * instantiate a new outgoing TCP connection for the configured upstream cluster.
  * All data will be proxied back and forth between the two connections, without any
- * knowledge of the underlying WebSocket protocol.
+ * knowledge of the underlying WebSocket protocol. If splicing is enabled, data is moved between
+ * the two sockets with splice(2) once the upstream connection is established, bypassing the HTTP
+ * connection manager altogether, when the connections allow it.
  */
 class WsHandlerImpl : public Envoy::Filter::TcpProxy {
 public:
   WsHandlerImpl(HeaderMap& request_headers, const AccessLog::RequestInfo& request_info,
                 const Router::RouteEntry& route_entry, WsHandlerCallbacks& callbacks,
                 Upstream::ClusterManager& cluster_manager,
-                Network::ReadFilterCallbacks* read_callbacks);
+                Network::ReadFilterCallbacks* read_callbacks, bool splice_enabled = false);
 
 protected:
   // Filter::TcpProxy
   const std::string& getUpstreamCluster() override { return route_entry_.clusterName(); }
   void onInitFailure(UpstreamFailureReason failure_reason) override;
   void onConnectionSuccess() override;
+  bool spliceEnabled() override { return splice_enabled_; }
 
 private:
   struct NullHttpConnectionCallbacks : public ConnectionCallbacks {
@@ -47,6 +50,7 @@ private:
   const Router::RouteEntry& route_entry_;
   WsHandlerCallbacks& ws_callbacks_;
   NullHttpConnectionCallbacks http_conn_callbacks_;
+  const bool splice_enabled_;
 };
 
 typedef std::unique_ptr<WsHandlerImpl> WsHandlerImplPtr;
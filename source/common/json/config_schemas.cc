@@ -400,6 +400,21 @@ const std::string Json::Schema::MONGO_PROXY_NETWORK_FILTER_SCHEMA(R"EOF(
   }
   )EOF");
 
+const std::string Json::Schema::LOCAL_RATELIMIT_NETWORK_FILTER_SCHEMA(R"EOF(
+  {
+    "$schema": "http://json-schema.org/schema#",
+    "type" : "object",
+    "properties" : {
+      "stat_prefix" : {"type" : "string"},
+      "max_tokens" : {"type" : "integer", "minimum" : 1},
+      "tokens_per_fill" : {"type" : "integer", "minimum" : 1},
+      "fill_interval_ms" : {"type" : "integer", "minimum" : 1}
+    },
+    "required" : ["stat_prefix", "max_tokens"],
+    "additionalProperties" : false
+  }
+  )EOF");
+
 const std::string Json::Schema::RATELIMIT_NETWORK_FILTER_SCHEMA(R"EOF(
   {
     "$schema": "http://json-schema.org/schema#",
@@ -918,6 +933,65 @@ const std::string Json::Schema::BUFFER_HTTP_FILTER_SCHEMA(R"EOF(
   }
   )EOF");
 
+const std::string Json::Schema::CACHE_HTTP_FILTER_SCHEMA(R"EOF(
+  {
+    "$schema": "http://json-schema.org/schema#",
+    "type" : "object",
+    "properties" : {
+      "max_bytes" : {"type" : "integer", "minimum" : 0},
+      "max_entry_bytes" : {"type" : "integer", "minimum" : 0},
+      "shared" : {"type" : "boolean"},
+      "num_shards" : {"type" : "integer", "minimum" : 1, "maximum" : 1024}
+    },
+    "additionalProperties" : false
+  }
+  )EOF");
+
+const std::string Json::Schema::COMPRESSION_HTTP_FILTER_SCHEMA(R"EOF(
+  {
+    "$schema": "http://json-schema.org/schema#",
+    "type" : "object",
+    "properties" : {
+      "compression_level" : {
+        "type" : "string",
+        "enum" : ["best", "speed", "default"]
+      },
+      "compression_strategy" : {
+        "type" : "string",
+        "enum" : ["filtered", "huffman", "rle", "default"]
+      },
+      "window_bits" : {"type" : "integer", "minimum" : 9, "maximum" : 15},
+      "memory_level" : {"type" : "integer", "minimum" : 1, "maximum" : 9},
+      "brotli_quality" : {"type" : "integer", "minimum" : 0, "maximum" : 11},
+      "zstd_level" : {"type" : "integer", "minimum" : 1, "maximum" : 19},
+      "content_encoding" : {
+        "type" : "array",
+        "items" : {
+          "type" : "string",
+          "enum" : ["gzip", "deflate", "br", "zstd"]
+        }
+      },
+      "content_length" : {"type" : "integer", "minimum" : 0},
+      "content_type" : {
+        "type" : "array",
+        "items" : {"type" : "string"}
+      }
+    },
+    "additionalProperties" : false
+  }
+  )EOF");
+
+const std::string Json::Schema::DECOMPRESSION_HTTP_FILTER_SCHEMA(R"EOF(
+  {
+    "$schema": "http://json-schema.org/schema#",
+    "type" : "object",
+    "properties" : {
+      "max_decompressed_bytes" : {"type" : "integer", "minimum" : 0}
+    },
+    "additionalProperties" : false
+  }
+  )EOF");
+
 const std::string Json::Schema::LUA_HTTP_FILTER_SCHEMA(R"EOF(
   {
     "$schema": "http://json-schema.org/schema#",
@@ -1054,6 +1128,50 @@ const std::string Json::Schema::IP_TAGGING_HTTP_FILTER_SCHEMA(R"EOF(
   }
   )EOF");
 
+const std::string Json::Schema::LOCAL_RATE_LIMIT_HTTP_FILTER_SCHEMA(R"EOF(
+  {
+    "$schema": "http://json-schema.org/schema#",
+    "type" : "object",
+    "properties" : {
+      "max_tokens" : {"type" : "integer", "minimum" : 1},
+      "tokens_per_fill" : {"type" : "integer", "minimum" : 1},
+      "fill_interval_ms" : {"type" : "integer", "minimum" : 1},
+      "stage" : {
+        "type" : "integer",
+        "minimum" : 0,
+        "maximum" : 10
+      },
+      "descriptors" : {
+        "type" : "array",
+        "items" : {
+          "type" : "object",
+          "properties" : {
+            "entries" : {
+              "type" : "array",
+              "minItems" : 1,
+              "items" : {
+                "type" : "object",
+                "properties" : {
+                  "key" : {"type" : "string"},
+                  "value" : {"type" : "string"}
+                },
+                "required" : ["key", "value"],
+                "additionalProperties" : false
+              }
+            },
+            "max_tokens" : {"type" : "integer", "minimum" : 1},
+            "tokens_per_fill" : {"type" : "integer", "minimum" : 1}
+          },
+          "required" : ["entries", "max_tokens"],
+          "additionalProperties" : false
+        }
+      }
+    },
+    "required" : ["max_tokens"],
+    "additionalProperties" : false
+  }
+  )EOF");
+
 const std::string Json::Schema::HEALTH_CHECK_HTTP_FILTER_SCHEMA(R"EOF(
   {
     "$schema": "http://json-schema.org/schema#",
@@ -1232,7 +1350,8 @@ const std::string Json::Schema::TOP_LEVEL_CONFIG_SCHEMA(R"EOF(
             "type" : "object",
             "properties" : {
               "collector_cluster" : {"type" : "string"},
-              "collector_endpoint": {"type": "string"}
+              "collector_endpoint": {"type": "string"},
+              "collector_encoding": {"type": "string", "enum": ["json", "thrift"]}
             },
             "required": ["collector_cluster"],
             "additionalProperties" : false
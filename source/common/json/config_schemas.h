@@ -21,6 +21,7 @@ public:
   // Network Filter Schemas
   static const std::string CLIENT_SSL_NETWORK_FILTER_SCHEMA;
   static const std::string HTTP_CONN_NETWORK_FILTER_SCHEMA;
+  static const std::string LOCAL_RATELIMIT_NETWORK_FILTER_SCHEMA;
   static const std::string MONGO_PROXY_NETWORK_FILTER_SCHEMA;
   static const std::string RATELIMIT_NETWORK_FILTER_SCHEMA;
   static const std::string REDIS_PROXY_NETWORK_FILTER_SCHEMA;
@@ -36,10 +37,14 @@ public:
 
   // HTTP Filter Schemas
   static const std::string BUFFER_HTTP_FILTER_SCHEMA;
+  static const std::string CACHE_HTTP_FILTER_SCHEMA;
+  static const std::string COMPRESSION_HTTP_FILTER_SCHEMA;
+  static const std::string DECOMPRESSION_HTTP_FILTER_SCHEMA;
   static const std::string FAULT_HTTP_FILTER_SCHEMA;
   static const std::string GRPC_JSON_TRANSCODER_FILTER_SCHEMA;
   static const std::string HEALTH_CHECK_HTTP_FILTER_SCHEMA;
   static const std::string IP_TAGGING_HTTP_FILTER_SCHEMA;
+  static const std::string LOCAL_RATE_LIMIT_HTTP_FILTER_SCHEMA;
   static const std::string RATE_LIMIT_HTTP_FILTER_SCHEMA;
   static const std::string ROUTER_HTTP_FILTER_SCHEMA;
   static const std::string LUA_HTTP_FILTER_SCHEMA;
@@ -3,10 +3,12 @@
 #include <cstdint>
 #include <fstream>
 #include <limits>
+#include <mutex>
 #include <sstream>
 #include <stack>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "common/common/assert.h"
@@ -169,6 +171,12 @@ private:
   }
 
   rapidjson::Document asRapidJsonDocument() const;
+  /**
+   * Emit the field as SAX events to a rapidjson handler, such as a schema validator, without
+   * building a rapidjson document.
+   * @return bool false if the handler stopped the traversal.
+   */
+  template <class Handler> bool accept(Handler& handler) const;
   static void buildRapidJsonDocument(const Field& field, rapidjson::Value& value,
                                      rapidjson::Document::AllocatorType& allocator);
 
@@ -179,23 +187,62 @@ private:
 };
 
 /**
- * Custom stream to allow access to the line number for each object.
+ * Custom stream over the chunks of a document, such as the slices of a buffer, which are read in
+ * place. Allows access to the line number for each object.
  */
-class LineCountingStringStream : public rapidjson::StringStream {
-  // Ch is typdef in parent class to handle character encoding.
+class LineCountingStream {
 public:
-  LineCountingStringStream(const Ch* src) : rapidjson::StringStream(src), line_number_(1) {}
+  typedef char Ch;
+
+  LineCountingStream(std::vector<std::pair<const Ch*, size_t>>&& chunks)
+      : chunks_(std::move(chunks)) {
+    nextChunk();
+  }
+
+  Ch Peek() const { return current_ != end_ ? *current_ : '\0'; }
   Ch Take() {
-    Ch ret = rapidjson::StringStream::Take();
+    if (current_ == end_) {
+      return '\0';
+    }
+    const Ch ret = *current_++;
+    offset_++;
+    if (current_ == end_) {
+      nextChunk();
+    }
     if (ret == '\n') {
       line_number_++;
     }
     return ret;
   }
+  size_t Tell() const { return offset_; }
+
+  // Only used by in situ parsing, which this stream doesn't support.
+  Ch* PutBegin() { NOT_REACHED; }
+  void Put(Ch) { NOT_REACHED; }
+  void Flush() { NOT_REACHED; }
+  size_t PutEnd(Ch*) { NOT_REACHED; }
+
   uint64_t getLineNumber() const { return line_number_; }
 
 private:
-  uint64_t line_number_;
+  void nextChunk() {
+    while (next_chunk_ < chunks_.size()) {
+      const std::pair<const Ch*, size_t>& chunk = chunks_[next_chunk_++];
+      if (chunk.second > 0) {
+        current_ = chunk.first;
+        end_ = chunk.first + chunk.second;
+        return;
+      }
+    }
+    current_ = end_ = nullptr;
+  }
+
+  const std::vector<std::pair<const Ch*, size_t>> chunks_;
+  size_t next_chunk_{};
+  const Ch* current_{};
+  const Ch* end_{};
+  size_t offset_{};
+  uint64_t line_number_{1};
 };
 
 /**
@@ -203,7 +250,7 @@ private:
  */
 class ObjectHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, ObjectHandler> {
 public:
-  ObjectHandler(LineCountingStringStream& stream) : state_(expectRoot), stream_(stream){};
+  ObjectHandler(LineCountingStream& stream) : state_(expectRoot), stream_(stream){};
 
   bool StartObject();
   bool EndObject(rapidjson::SizeType);
@@ -233,7 +280,7 @@ private:
     expectFinished,
   };
   State state_;
-  LineCountingStringStream& stream_;
+  LineCountingStream& stream_;
 
   std::stack<FieldSharedPtr> stack_;
   std::string key_;
@@ -506,18 +553,91 @@ void Field::iterate(const ObjectCallback& callback) const {
   }
 }
 
-void Field::validateSchema(const std::string& schema) const {
-  rapidjson::Document schema_document;
-  if (schema_document.Parse<0>(schema.c_str()).HasParseError()) {
-    throw std::invalid_argument(fmt::format(
-        "Schema supplied to validateSchema is not valid JSON\n Error(offset {}) : {}\n",
-        schema_document.GetErrorOffset(), GetParseError_En(schema_document.GetParseError())));
+template <class Handler> bool Field::accept(Handler& handler) const {
+  switch (type_) {
+  case Type::Array:
+    if (!handler.StartArray()) {
+      return false;
+    }
+    for (const auto& element : value_.array_value_) {
+      if (!element->accept(handler)) {
+        return false;
+      }
+    }
+    return handler.EndArray(static_cast<rapidjson::SizeType>(value_.array_value_.size()));
+  case Type::Boolean:
+    return handler.Bool(value_.boolean_value_);
+  case Type::Double:
+    return handler.Double(value_.double_value_);
+  case Type::Integer:
+    return handler.Int64(value_.integer_value_);
+  case Type::Null:
+    return handler.Null();
+  case Type::Object:
+    if (!handler.StartObject()) {
+      return false;
+    }
+    for (const auto& item : value_.object_value_) {
+      if (!handler.Key(item.first.c_str(), static_cast<rapidjson::SizeType>(item.first.size()),
+                       false) ||
+          !item.second->accept(handler)) {
+        return false;
+      }
+    }
+    return handler.EndObject(static_cast<rapidjson::SizeType>(value_.object_value_.size()));
+  case Type::String:
+    return handler.String(value_.string_value_.c_str(),
+                          static_cast<rapidjson::SizeType>(value_.string_value_.size()), false);
   }
 
-  rapidjson::SchemaDocument schema_document_for_validator(schema_document);
-  rapidjson::SchemaValidator schema_validator(schema_document_for_validator);
+  NOT_REACHED;
+}
 
-  if (!asRapidJsonDocument().Accept(schema_validator)) {
+/**
+ * A schema compiled for validation, along with the document it was compiled from.
+ */
+class CompiledSchema {
+public:
+  CompiledSchema(const std::string& schema)
+      : document_(parse(schema)), schema_document_(document_) {}
+
+  /**
+   * @return const rapidjson::SchemaDocument& the compiled schema, which is shared by validators.
+   * @throw std::invalid_argument if the schema is not valid JSON.
+   */
+  static const rapidjson::SchemaDocument& get(const std::string& schema) {
+    // Schemas are constants, so compiled schemas are kept for the lifetime of the process.
+    static std::mutex lock;
+    static std::unordered_map<std::string, std::unique_ptr<CompiledSchema>> schemas;
+
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = schemas.find(schema);
+    if (it == schemas.end()) {
+      it = schemas.emplace(schema, std::unique_ptr<CompiledSchema>(new CompiledSchema(schema)))
+               .first;
+    }
+    return it->second->schema_document_;
+  }
+
+private:
+  static rapidjson::Document parse(const std::string& schema) {
+    rapidjson::Document document;
+    if (document.Parse<0>(schema.c_str()).HasParseError()) {
+      throw std::invalid_argument(fmt::format(
+          "Schema supplied to validateSchema is not valid JSON\n Error(offset {}) : {}\n",
+          document.GetErrorOffset(), GetParseError_En(document.GetParseError())));
+    }
+    return document;
+  }
+
+  rapidjson::Document document_;
+  const rapidjson::SchemaDocument schema_document_;
+};
+
+void Field::validateSchema(const std::string& schema) const {
+  rapidjson::SchemaValidator schema_validator(CompiledSchema::get(schema));
+
+  if (!accept(schema_validator)) {
     rapidjson::StringBuffer schema_string_buffer;
     rapidjson::StringBuffer document_string_buffer;
 
@@ -748,7 +868,22 @@ ObjectSharedPtr Factory::loadFromYamlString(const std::string& yaml) {
 }
 
 ObjectSharedPtr Factory::loadFromString(const std::string& json) {
-  LineCountingStringStream json_stream(json.c_str());
+  return loadFromChunks({{json.data(), json.size()}});
+}
+
+ObjectSharedPtr Factory::loadFromBuffer(const Buffer::Instance& json) {
+  const uint64_t num_slices = json.getRawSlices(nullptr, 0);
+  std::vector<Buffer::RawSlice> slices(num_slices);
+  json.getRawSlices(slices.data(), num_slices);
+  std::vector<std::pair<const char*, size_t>> chunks;
+  for (const Buffer::RawSlice& slice : slices) {
+    chunks.emplace_back(static_cast<const char*>(slice.mem_), slice.len_);
+  }
+  return loadFromChunks(std::move(chunks));
+}
+
+ObjectSharedPtr Factory::loadFromChunks(std::vector<std::pair<const char*, size_t>>&& chunks) {
+  LineCountingStream json_stream(std::move(chunks));
 
   ObjectHandler handler(json_stream);
   rapidjson::Reader reader;
@@ -2,7 +2,10 @@
 
 #include <list>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "envoy/buffer/buffer.h"
 #include "envoy/json/json_object.h"
 
 namespace Envoy {
@@ -20,12 +23,20 @@ public:
    */
   static ObjectSharedPtr loadFromString(const std::string& json);
 
+  /**
+   * Constructs a Json Object from the contents of a buffer, which are parsed in place.
+   */
+  static ObjectSharedPtr loadFromBuffer(const Buffer::Instance& json);
+
   /**
    * Constructs a Json Object from a YAML string.
    */
   static ObjectSharedPtr loadFromYamlString(const std::string& yaml);
 
   static const std::string listAsJsonString(const std::list<std::string>& items);
+
+private:
+  static ObjectSharedPtr loadFromChunks(std::vector<std::pair<const char*, size_t>>&& chunks);
 };
 
 } // namespace Json
@@ -0,0 +1,390 @@
+#include "common/json/streaming_parser.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+namespace Envoy {
+namespace Json {
+
+bool StreamingParser::parse(const char* data, uint64_t length) {
+  uint64_t i = 0;
+  while (i < length && state_ != State::Error) {
+    if (state_ == State::String && high_surrogate_ == 0) {
+      // Plain characters make up most of a string, skip or copy them in one go.
+      uint64_t end = i;
+      while (end < length && data[end] != '"' && data[end] != '\\' &&
+             static_cast<uint8_t>(data[end]) >= 0x20) {
+        end++;
+      }
+      if (capture_string_) {
+        string_.append(data + i, end - i);
+      }
+      i = end;
+      if (i == length) {
+        break;
+      }
+    }
+
+    if (consume(data[i])) {
+      i++;
+    }
+  }
+
+  return state_ != State::Error;
+}
+
+bool StreamingParser::finish() {
+  if (state_ == State::Number && containers_.empty()) {
+    // A number is only terminated by the character after it, or by the end of the document.
+    consumeNumber(' ');
+  }
+
+  return state_ == State::Done;
+}
+
+bool StreamingParser::consume(char c) {
+  switch (state_) {
+  case State::String:
+    if (high_surrogate_ != 0 && c != '\\') {
+      // A leading surrogate must be followed by a \u escape of the trailing one.
+      onError();
+    } else if (c == '"') {
+      onStringEnd();
+    } else if (c == '\\') {
+      state_ = State::Escape;
+    } else if (static_cast<uint8_t>(c) < 0x20) {
+      onError();
+    } else if (capture_string_) {
+      string_.push_back(c);
+    }
+    return true;
+  case State::Escape: {
+    char unescaped;
+    switch (c) {
+    case '"':
+    case '\\':
+    case '/':
+      unescaped = c;
+      break;
+    case 'b':
+      unescaped = '\b';
+      break;
+    case 'f':
+      unescaped = '\f';
+      break;
+    case 'n':
+      unescaped = '\n';
+      break;
+    case 'r':
+      unescaped = '\r';
+      break;
+    case 't':
+      unescaped = '\t';
+      break;
+    case 'u':
+      unicode_ = 0;
+      unicode_digits_ = 0;
+      state_ = State::Unicode;
+      return true;
+    default:
+      onError();
+      return true;
+    }
+    if (high_surrogate_ != 0) {
+      onError();
+      return true;
+    }
+    if (capture_string_) {
+      string_.push_back(unescaped);
+    }
+    state_ = State::String;
+    return true;
+  }
+  case State::Unicode:
+    consumeUnicode(c);
+    return true;
+  case State::Number:
+    return consumeNumber(c);
+  case State::Literal:
+    if (c != literal_[literal_pos_]) {
+      onError();
+    } else if (literal_[++literal_pos_] == '\0') {
+      if (literal_[0] == 'n') {
+        callbacks_.onNull();
+      } else {
+        callbacks_.onBool(literal_[0] == 't');
+      }
+      onValueEnd();
+    }
+    return true;
+  case State::Error:
+    return true;
+  default:
+    break;
+  }
+
+  if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+    return true;
+  }
+
+  switch (state_) {
+  case State::Value:
+    consumeValue(c);
+    break;
+  case State::ValueOrEndArray:
+    if (c == ']') {
+      containers_.pop_back();
+      callbacks_.onEndArray();
+      onValueEnd();
+    } else {
+      consumeValue(c);
+    }
+    break;
+  case State::KeyOrEndObject:
+  case State::Key:
+    if (c == '}' && state_ == State::KeyOrEndObject) {
+      containers_.pop_back();
+      callbacks_.onEndObject();
+      onValueEnd();
+    } else if (c == '"') {
+      string_is_key_ = true;
+      capture_string_ = true;
+      string_.clear();
+      state_ = State::String;
+    } else {
+      onError();
+    }
+    break;
+  case State::Colon:
+    if (c == ':') {
+      state_ = State::Value;
+    } else {
+      onError();
+    }
+    break;
+  case State::CommaOrEnd: {
+    const bool object = containers_.back();
+    if (c == ',') {
+      state_ = object ? State::Key : State::Value;
+    } else if (c == (object ? '}' : ']')) {
+      containers_.pop_back();
+      if (object) {
+        callbacks_.onEndObject();
+      } else {
+        callbacks_.onEndArray();
+      }
+      onValueEnd();
+    } else {
+      onError();
+    }
+    break;
+  }
+  default:
+    // Only whitespace may follow the document.
+    onError();
+    break;
+  }
+
+  return true;
+}
+
+void StreamingParser::consumeValue(char c) {
+  switch (c) {
+  case '{':
+    containers_.push_back(true);
+    callbacks_.onStartObject();
+    state_ = State::KeyOrEndObject;
+    break;
+  case '[':
+    containers_.push_back(false);
+    callbacks_.onStartArray();
+    state_ = State::ValueOrEndArray;
+    break;
+  case '"':
+    string_is_key_ = false;
+    capture_string_ = callbacks_.captureString();
+    string_.clear();
+    state_ = State::String;
+    break;
+  case 't':
+    literal_ = "true";
+    literal_pos_ = 1;
+    state_ = State::Literal;
+    break;
+  case 'f':
+    literal_ = "false";
+    literal_pos_ = 1;
+    state_ = State::Literal;
+    break;
+  case 'n':
+    literal_ = "null";
+    literal_pos_ = 1;
+    state_ = State::Literal;
+    break;
+  default:
+    if (c == '-' || (c >= '0' && c <= '9')) {
+      number_.assign(1, c);
+      number_state_ =
+          c == '-' ? NumberState::Sign : (c == '0' ? NumberState::Zero : NumberState::Integer);
+      state_ = State::Number;
+    } else {
+      onError();
+    }
+    break;
+  }
+}
+
+bool StreamingParser::consumeNumber(char c) {
+  const bool digit = c >= '0' && c <= '9';
+  bool valid = true;
+  bool end = false;
+  switch (number_state_) {
+  case NumberState::Sign:
+    if (c == '0') {
+      number_state_ = NumberState::Zero;
+    } else if (digit) {
+      number_state_ = NumberState::Integer;
+    } else {
+      valid = false;
+    }
+    break;
+  case NumberState::Zero:
+  case NumberState::Integer:
+    if (digit) {
+      // No leading zeros.
+      valid = number_state_ == NumberState::Integer;
+    } else if (c == '.') {
+      number_state_ = NumberState::FractionStart;
+    } else if (c == 'e' || c == 'E') {
+      number_state_ = NumberState::ExponentStart;
+    } else {
+      end = true;
+    }
+    break;
+  case NumberState::FractionStart:
+    if (digit) {
+      number_state_ = NumberState::Fraction;
+    } else {
+      valid = false;
+    }
+    break;
+  case NumberState::Fraction:
+    if (c == 'e' || c == 'E') {
+      number_state_ = NumberState::ExponentStart;
+    } else if (!digit) {
+      end = true;
+    }
+    break;
+  case NumberState::ExponentStart:
+    if (c == '+' || c == '-') {
+      number_state_ = NumberState::ExponentSign;
+    } else if (digit) {
+      number_state_ = NumberState::Exponent;
+    } else {
+      valid = false;
+    }
+    break;
+  case NumberState::ExponentSign:
+    if (digit) {
+      number_state_ = NumberState::Exponent;
+    } else {
+      valid = false;
+    }
+    break;
+  case NumberState::Exponent:
+    if (!digit) {
+      end = true;
+    }
+    break;
+  }
+
+  if (!valid) {
+    onError();
+    return true;
+  }
+  if (end) {
+    callbacks_.onNumber(std::strtod(number_.c_str(), nullptr));
+    onValueEnd();
+    // The character after the number belongs to what follows it.
+    return false;
+  }
+  number_.push_back(c);
+  return true;
+}
+
+void StreamingParser::consumeUnicode(char c) {
+  uint32_t digit;
+  if (c >= '0' && c <= '9') {
+    digit = c - '0';
+  } else if (c >= 'a' && c <= 'f') {
+    digit = c - 'a' + 10;
+  } else if (c >= 'A' && c <= 'F') {
+    digit = c - 'A' + 10;
+  } else {
+    onError();
+    return;
+  }
+
+  unicode_ = unicode_ << 4 | digit;
+  if (++unicode_digits_ < 4) {
+    return;
+  }
+
+  state_ = State::String;
+  const bool low_surrogate = unicode_ >= 0xDC00 && unicode_ <= 0xDFFF;
+  if (high_surrogate_ != 0) {
+    if (!low_surrogate) {
+      onError();
+      return;
+    }
+    appendCodePoint(0x10000 + ((high_surrogate_ - 0xD800) << 10) + (unicode_ - 0xDC00));
+    high_surrogate_ = 0;
+  } else if (unicode_ >= 0xD800 && unicode_ <= 0xDBFF) {
+    high_surrogate_ = unicode_;
+  } else if (low_surrogate) {
+    onError();
+  } else {
+    appendCodePoint(unicode_);
+  }
+}
+
+void StreamingParser::appendCodePoint(uint32_t code_point) {
+  if (!capture_string_) {
+    return;
+  }
+
+  // Encode as UTF-8.
+  if (code_point < 0x80) {
+    string_.push_back(static_cast<char>(code_point));
+  } else if (code_point < 0x800) {
+    string_.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+    string_.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else if (code_point < 0x10000) {
+    string_.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+    string_.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    string_.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else {
+    string_.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+    string_.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+    string_.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    string_.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  }
+}
+
+void StreamingParser::onStringEnd() {
+  if (string_is_key_) {
+    callbacks_.onKey(string_);
+    state_ = State::Colon;
+  } else {
+    callbacks_.onString(string_);
+    onValueEnd();
+  }
+}
+
+void StreamingParser::onValueEnd() {
+  state_ = containers_.empty() ? State::Done : State::CommaOrEnd;
+}
+
+} // namespace Json
+} // namespace Envoy
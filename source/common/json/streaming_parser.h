@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "envoy/common/pure.h"
+
+namespace Envoy {
+namespace Json {
+
+/**
+ * Incremental SAX style JSON parser. The document can be supplied in any number of chunks, split
+ * anywhere, and only the strings the callbacks ask for are copied, so that fields can be extracted
+ * from large documents without buffering them or building a DOM.
+ */
+class StreamingParser {
+public:
+  /**
+   * Callbacks invoked as the parts of the document are parsed.
+   */
+  class Callbacks {
+  public:
+    virtual ~Callbacks() {}
+
+    virtual void onStartObject() PURE;
+    virtual void onEndObject() PURE;
+    virtual void onStartArray() PURE;
+    virtual void onEndArray() PURE;
+
+    /**
+     * Called with the key of the next member of the current object.
+     */
+    virtual void onKey(const std::string& key) PURE;
+
+    /**
+     * Called when a string value starts.
+     * @return bool whether the value is needed. If not, onString() is called with an empty string
+     *         and the value is not copied.
+     */
+    virtual bool captureString() PURE;
+
+    virtual void onString(const std::string& value) PURE;
+    virtual void onNumber(double value) PURE;
+    virtual void onBool(bool value) PURE;
+    virtual void onNull() PURE;
+  };
+
+  StreamingParser(Callbacks& callbacks) : callbacks_(callbacks) {}
+
+  /**
+   * Parse the next chunk of the document.
+   * @param data supplies the chunk.
+   * @param length supplies the length of the chunk.
+   * @return bool false if the document is not valid JSON. Once this happens all further calls
+   *         fail as well, without invoking any callbacks.
+   */
+  bool parse(const char* data, uint64_t length);
+
+  /**
+   * Signal the end of the document.
+   * @return bool whether the whole document was a single valid JSON value.
+   */
+  bool finish();
+
+private:
+  enum class State {
+    Value,
+    ValueOrEndArray,
+    KeyOrEndObject,
+    Key,
+    Colon,
+    CommaOrEnd,
+    String,
+    Escape,
+    Unicode,
+    Number,
+    Literal,
+    Done,
+    Error,
+  };
+
+  // Parts of a number, in the order they appear.
+  enum class NumberState {
+    Sign,
+    Zero,
+    Integer,
+    FractionStart,
+    Fraction,
+    ExponentStart,
+    ExponentSign,
+    Exponent,
+  };
+
+  /**
+   * Consume one character.
+   * @return bool whether the character was consumed, or has to be consumed again in the new state.
+   */
+  bool consume(char c);
+  void consumeValue(char c);
+  bool consumeNumber(char c);
+  void consumeUnicode(char c);
+  void onStringEnd();
+  void onValueEnd();
+  void appendCodePoint(uint32_t code_point);
+  void onError() { state_ = State::Error; }
+
+  Callbacks& callbacks_;
+  State state_{State::Value};
+  // Whether each of the enclosing containers is an object (true) or an array (false).
+  std::vector<bool> containers_;
+  bool string_is_key_{};
+  bool capture_string_{};
+  std::string string_;
+  // The four hex digits of a \u escape and how many of them have been read.
+  uint32_t unicode_{};
+  uint32_t unicode_digits_{};
+  // The leading surrogate of a pair, waiting for the trailing one.
+  uint32_t high_surrogate_{};
+  NumberState number_state_{};
+  std::string number_;
+  const char* literal_{};
+  uint32_t literal_pos_{};
+};
+
+} // namespace Json
+} // namespace Envoy
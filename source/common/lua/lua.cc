@@ -7,8 +7,32 @@
 namespace Envoy {
 namespace Lua {
 
-Coroutine::Coroutine(const std::pair<lua_State*, lua_State*>& new_thread_state)
-    : coroutine_state_(new_thread_state, false) {}
+namespace {
+
+int writeChunk(lua_State*, const void* chunk, size_t size, void* bytecode) {
+  static_cast<std::string*>(bytecode)->append(static_cast<const char*>(chunk), size);
+  return 0;
+}
+
+} // namespace
+
+Coroutine::Coroutine(const std::pair<lua_State*, lua_State*>& new_thread_state,
+                     CoroutinePool* pool)
+    : coroutine_state_(new_thread_state, false), parent_state_(new_thread_state.second),
+      pool_(pool) {}
+
+Coroutine::~Coroutine() {
+  // A thread which errored is dead, and one which yielded can't be restarted, but one which
+  // returned can run a new function.
+  if (pool_ == nullptr || !reusable_ || pool_->closing_ ||
+      pool_->free_threads_.size() >= CoroutinePool::MAX_SIZE) {
+    return;
+  }
+
+  lua_settop(coroutine_state_.get(), 0);
+  coroutine_state_.pushStack();
+  pool_->free_threads_.push_back(luaL_ref(parent_state_, LUA_REGISTRYINDEX));
+}
 
 void Coroutine::start(int function_ref, int num_args, const std::function<void()>& yield_callback) {
   ASSERT(state_ == State::NotStarted);
@@ -29,6 +53,7 @@ void Coroutine::resume(int num_args, const std::function<void()>& yield_callback
 
   if (0 == rc) {
     state_ = State::Finished;
+    reusable_ = true;
     ENVOY_LOG(debug, "coroutine finished");
   } else if (LUA_YIELD == rc) {
     state_ = State::Yielded;
@@ -44,17 +69,21 @@ void Coroutine::resume(int num_args, const std::function<void()>& yield_callback
 ThreadLocalState::ThreadLocalState(const std::string& code, ThreadLocal::SlotAllocator& tls)
     : tls_slot_(tls.allocateSlot()) {
 
-  // First verify that the supplied code can be parsed.
+  // First verify that the supplied code can be parsed and run. The compiled chunk is kept so that
+  // workers only need to load it.
   CSmartPtr<lua_State, lua_close> state(lua_open());
   luaL_openlibs(state.get());
 
-  if (0 != luaL_dostring(state.get(), code.c_str())) {
+  std::string bytecode;
+  if (0 != luaL_loadstring(state.get(), code.c_str()) ||
+      0 != lua_dump(state.get(), writeChunk, &bytecode) ||
+      0 != lua_pcall(state.get(), 0, LUA_MULTRET, 0)) {
     throw LuaException(fmt::format("script load error: {}", lua_tostring(state.get(), -1)));
   }
 
   // Now initialize on all threads.
-  tls_slot_->set([code](Event::Dispatcher&) {
-    return ThreadLocal::ThreadLocalObjectSharedPtr{new LuaThreadLocal(code)};
+  tls_slot_->set([bytecode](Event::Dispatcher&) {
+    return ThreadLocal::ThreadLocalObjectSharedPtr{new LuaThreadLocal(bytecode)};
   });
 }
 
@@ -81,16 +110,30 @@ uint64_t ThreadLocalState::registerGlobal(const std::string& global) {
 }
 
 CoroutinePtr ThreadLocalState::createCoroutine() {
-  lua_State* state = tls_slot_->getTyped<LuaThreadLocal>().state_.get();
-  return CoroutinePtr{new Coroutine({lua_newthread(state), state})};
+  LuaThreadLocal& tls = tls_slot_->getTyped<LuaThreadLocal>();
+  lua_State* state = tls.state_.get();
+  CoroutinePool& pool = tls.coroutine_pool_;
+  if (pool.free_threads_.empty()) {
+    return CoroutinePtr{new Coroutine({lua_newthread(state), state}, &pool)};
+  }
+
+  const int ref = pool.free_threads_.back();
+  pool.free_threads_.pop_back();
+  lua_rawgeti(state, LUA_REGISTRYINDEX, ref);
+  luaL_unref(state, LUA_REGISTRYINDEX, ref);
+  return CoroutinePtr{new Coroutine({lua_tothread(state, -1), state}, &pool)};
 }
 
-ThreadLocalState::LuaThreadLocal::LuaThreadLocal(const std::string& code) : state_(lua_open()) {
+ThreadLocalState::LuaThreadLocal::LuaThreadLocal(const std::string& bytecode)
+    : state_(lua_open()) {
   luaL_openlibs(state_.get());
-  int rc = luaL_dostring(state_.get(), code.c_str());
+  int rc = luaL_loadbuffer(state_.get(), bytecode.data(), bytecode.size(), "script") ||
+           lua_pcall(state_.get(), 0, LUA_MULTRET, 0);
   ASSERT(rc == 0);
   UNREFERENCED_PARAMETER(rc);
 }
 
+ThreadLocalState::LuaThreadLocal::~LuaThreadLocal() { coroutine_pool_.closing_ = true; }
+
 } // namespace Lua
 } // namespace Envoy
@@ -41,7 +41,7 @@ namespace Lua {
  */
 #define DECLARE_LUA_FUNCTION_EX(Class, Name, Index)                                                \
   static int static_##Name(lua_State* state) {                                                     \
-    Class* object = static_cast<Class*>(luaL_checkudata(state, Index, typeid(Class).name()));      \
+    Class* object = Class::checkUserdata(state, Index);                                            \
     object->checkDead(state);                                                                      \
     return object->Name(state);                                                                    \
   }                                                                                                \
@@ -89,7 +89,7 @@ public:
   static std::pair<T*, lua_State*> create(lua_State* state, ConstructorArgs&&... args) {
     // Create a new user data and assign its metatable.
     void* mem = lua_newuserdata(state, sizeof(T));
-    luaL_getmetatable(state, typeid(T).name());
+    pushMetatable(state);
     ASSERT(lua_istable(state, -1));
     lua_setmetatable(state, -2);
 
@@ -116,7 +116,7 @@ public:
     // manually because the memory is raw and was allocated by Lua.
     to_register.push_back(
         {"__gc", [](lua_State* state) {
-           T* object = static_cast<T*>(luaL_checkudata(state, 1, typeid(T).name()));
+           T* object = checkUserdata(state, 1);
            ENVOY_LOG(trace, "destroying {} at {}", typeid(T).name(), static_cast<void*>(object));
            object->~T();
            return 0;
@@ -135,6 +135,34 @@ public:
     lua_pushvalue(state, -1);
     lua_setfield(state, -2, "__index");
     luaL_register(state, nullptr, to_register.data());
+
+    // Also key the metatable by the address of metatableKey() so that per object lookups don't
+    // need to hash the type name.
+    lua_pushlightuserdata(state, metatableKey());
+    lua_pushvalue(state, -2);
+    lua_rawset(state, LUA_REGISTRYINDEX);
+  }
+
+  /**
+   * Fetch an object of this type from the stack, raising a Lua error if the value is not one.
+   * This is the equivalent of luaL_checkudata() without the metatable lookup by name.
+   * @param state supplies the state to check.
+   * @param index supplies the stack index of the object.
+   * @return T* the object.
+   */
+  static T* checkUserdata(lua_State* state, int index) {
+    void* object = lua_touserdata(state, index);
+    if (object != nullptr && lua_getmetatable(state, index)) {
+      pushMetatable(state);
+      const bool matches = lua_rawequal(state, -1, -2);
+      lua_pop(state, 2);
+      if (matches) {
+        return static_cast<T*>(object);
+      }
+    }
+
+    // Let Lua raise the usual error.
+    return static_cast<T*>(luaL_checkudata(state, index, typeid(T).name()));
   }
 
   /**
@@ -185,6 +213,16 @@ protected:
   virtual void onMarkLive() {}
 
 private:
+  static void* metatableKey() {
+    static char key;
+    return &key;
+  }
+
+  static void pushMetatable(lua_State* state) {
+    lua_pushlightuserdata(state, metatableKey());
+    lua_rawget(state, LUA_REGISTRYINDEX);
+  }
+
   bool dead_{};
 };
 
@@ -292,6 +330,20 @@ public:
   }
 };
 
+/**
+ * Per worker pool of the Lua threads of finished coroutines, so that a new coroutine doesn't
+ * need to allocate a new thread and its stack.
+ */
+struct CoroutinePool {
+  // Maximum number of idle threads kept.
+  static const size_t MAX_SIZE = 1024;
+
+  // Registry references of the idle threads.
+  std::vector<int> free_threads_;
+  // Set while the owning state closes. Threads aren't pooled anymore then.
+  bool closing_{};
+};
+
 /**
  * This is a wraper for a Lua coroutine. Lua intermixes coroutine and "thread." Lua does not have
  * real threads, only cooperatively scheduled coroutines.
@@ -300,7 +352,15 @@ class Coroutine : Logger::Loggable<Logger::Id::lua> {
 public:
   enum class State { NotStarted, Yielded, Finished };
 
-  Coroutine(const std::pair<lua_State*, lua_State*>& new_thread_state);
+  /**
+   * @param new_thread_state supplies the thread of the coroutine and its owning state.
+   * @param pool supplies the pool the thread is returned to on destruction, if it finished without
+   *        error. May be nullptr.
+   */
+  Coroutine(const std::pair<lua_State*, lua_State*>& new_thread_state,
+            CoroutinePool* pool = nullptr);
+  ~Coroutine();
+
   lua_State* luaState() { return coroutine_state_.get(); }
   State state() { return state_; }
 
@@ -324,7 +384,10 @@ public:
 
 private:
   LuaRef<lua_State> coroutine_state_;
+  lua_State* parent_state_;
+  CoroutinePool* pool_;
   State state_{State::NotStarted};
+  bool reusable_{};
 };
 
 typedef std::unique_ptr<Coroutine> CoroutinePtr;
@@ -339,7 +402,7 @@ public:
   ThreadLocalState(const std::string& code, ThreadLocal::SlotAllocator& tls);
 
   /**
-   * @return CoroutinePtr a new coroutine.
+   * @return CoroutinePtr a new coroutine. Its thread may be reused from a previous coroutine.
    */
   CoroutinePtr createCoroutine();
 
@@ -368,8 +431,11 @@ public:
 
 private:
   struct LuaThreadLocal : public ThreadLocal::ThreadLocalObject {
-    LuaThreadLocal(const std::string& code);
+    LuaThreadLocal(const std::string& bytecode);
+    ~LuaThreadLocal();
 
+    // Declared before state_ so that it outlives closing the state.
+    CoroutinePool coroutine_pool_;
     CSmartPtr<lua_State, lua_close> state_;
     std::vector<int> global_slots_;
   };
@@ -1,24 +1,56 @@
 #include "common/memory/stats.h"
 
 #include <cstdint>
+#include <string>
 
 #ifdef TCMALLOC
 
+#include <vector>
+
 #include "gperftools/malloc_extension.h"
 
 namespace Envoy {
 namespace Memory {
 
-uint64_t Stats::totalCurrentlyAllocated() {
+namespace {
+
+// The heap report is truncated to this size.
+const size_t HEAP_REPORT_SIZE = 64 * 1024;
+
+uint64_t numericProperty(const char* property) {
   size_t value = 0;
-  MallocExtension::instance()->GetNumericProperty("generic.current_allocated_bytes", &value);
+  MallocExtension::instance()->GetNumericProperty(property, &value);
   return value;
 }
 
-uint64_t Stats::totalCurrentlyReserved() {
-  size_t value = 0;
-  MallocExtension::instance()->GetNumericProperty("generic.heap_size", &value);
-  return value;
+} // namespace
+
+uint64_t Stats::totalCurrentlyAllocated() {
+  return numericProperty("generic.current_allocated_bytes");
+}
+
+uint64_t Stats::totalCurrentlyReserved() { return numericProperty("generic.heap_size"); }
+
+uint64_t Stats::totalThreadCacheBytes() {
+  return numericProperty("tcmalloc.current_total_thread_cache_bytes");
+}
+
+uint64_t Stats::totalPageHeapFree() { return numericProperty("tcmalloc.pageheap_free_bytes"); }
+
+uint64_t Stats::totalPageHeapUnmapped() {
+  return numericProperty("tcmalloc.pageheap_unmapped_bytes");
+}
+
+std::string Stats::heapReport() {
+  std::vector<char> report(HEAP_REPORT_SIZE);
+  MallocExtension::instance()->GetStats(report.data(), static_cast<int>(report.size()));
+  return report.data();
+}
+
+std::string Stats::heapSample() {
+  std::string sample;
+  MallocExtension::instance()->GetHeapSample(&sample);
+  return sample;
 }
 
 } // namespace Memory
@@ -31,6 +63,11 @@ namespace Memory {
 
 uint64_t Stats::totalCurrentlyAllocated() { return 0; }
 uint64_t Stats::totalCurrentlyReserved() { return 0; }
+uint64_t Stats::totalThreadCacheBytes() { return 0; }
+uint64_t Stats::totalPageHeapFree() { return 0; }
+uint64_t Stats::totalPageHeapUnmapped() { return 0; }
+std::string Stats::heapReport() { return ""; }
+std::string Stats::heapSample() { return ""; }
 
 } // namespace Memory
 } // namespace Envoy
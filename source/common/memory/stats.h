@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
 
 namespace Envoy {
 namespace Memory {
@@ -20,6 +21,36 @@ public:
    *                  allocated.
    */
   static uint64_t totalCurrentlyReserved();
+
+  /**
+   * @return uint64_t the total memory held in the caches of the threads, which is allocated from
+   *                  the heap but not in use.
+   */
+  static uint64_t totalThreadCacheBytes();
+
+  /**
+   * @return uint64_t the total memory free in the page heap, which is mapped but not in use.
+   */
+  static uint64_t totalPageHeapFree();
+
+  /**
+   * @return uint64_t the total memory released to the system by the page heap, which is reserved
+   *                  but not mapped.
+   */
+  static uint64_t totalPageHeapUnmapped();
+
+  /**
+   * @return std::string a human readable report of the state of the heap, or an empty string if
+   *                     the heap does not provide one.
+   */
+  static std::string heapReport();
+
+  /**
+   * @return std::string a sample of the allocations live in the heap, in the pprof heap profile
+   *                     format, or an empty string if the heap does not provide one. The heap is
+   *                     only sampled if TCMALLOC_SAMPLE_PARAMETER is set in the environment.
+   */
+  static std::string heapSample();
 };
 
 } // namespace Memory
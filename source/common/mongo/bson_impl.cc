@@ -1,6 +1,7 @@
 #include "common/mongo/bson_impl.h"
 
 #include <cstdint>
+#include <cstring>
 #include <sstream>
 #include <string>
 
@@ -14,6 +15,32 @@
 namespace Envoy {
 namespace Bson {
 
+namespace {
+
+int32_t readInt32(const char* data) {
+  int32_t val;
+  std::memcpy(&val, data, sizeof(int32_t));
+  return le32toh(val);
+}
+
+int64_t readInt64(const char* data) {
+  int64_t val;
+  std::memcpy(&val, data, sizeof(int64_t));
+  return le64toh(val);
+}
+
+// The size of the C string at the start of data, without its terminating zero.
+uint64_t cStringSize(const char* data, uint64_t max_size) {
+  const void* end = std::memchr(data, '\0', max_size);
+  if (end == nullptr) {
+    throw EnvoyException("invalid CString");
+  }
+
+  return static_cast<const char*>(end) - data;
+}
+
+} // namespace
+
 int32_t BufferHelper::peakInt32(Buffer::Instance& data) {
   if (data.length() < sizeof(int32_t)) {
     throw EnvoyException("invalid buffer size");
@@ -478,7 +505,244 @@ void DocumentImpl::fromBuffer(Buffer::Instance& data) {
   }
 }
 
+DocumentSharedPtr DocumentImpl::createLazy(const std::shared_ptr<const std::string>& data,
+                                            uint64_t& offset) {
+  ASSERT(offset <= data->size());
+  if (data->size() - offset < sizeof(int32_t)) {
+    throw EnvoyException("invalid buffer size");
+  }
+
+  int32_t length = readInt32(data->data() + offset);
+  if (length < 5 || static_cast<uint64_t>(length) > data->size() - offset) {
+    throw EnvoyException("invalid BSON message length");
+  }
+  if ((*data)[offset + length - 1] != 0) {
+    throw EnvoyException("invalid document");
+  }
+
+  DocumentSharedPtr new_doc{new DocumentImpl(data, offset, length)};
+  offset += length;
+  return new_doc;
+}
+
+void DocumentImpl::index() const {
+  if (indexed_) {
+    return;
+  }
+
+  // The length and the terminating zero have been checked when the document was created.
+  const char* data = raw_->data() + raw_offset_;
+  const uint64_t end = raw_size_ - 1;
+  uint64_t offset = sizeof(int32_t);
+  while (offset < end) {
+    LazyField field;
+    uint8_t element_type = data[offset++];
+    field.type_ = static_cast<Field::Type>(element_type);
+    field.key_offset_ = raw_offset_ + offset;
+    field.key_size_ = cStringSize(data + offset, end - offset);
+    offset += field.key_size_ + 1;
+
+    const uint64_t remaining = end - offset;
+    const char* value = data + offset;
+    switch (field.type_) {
+    case Field::Type::DOUBLE:
+    case Field::Type::DATETIME:
+    case Field::Type::TIMESTAMP:
+    case Field::Type::INT64: {
+      field.value_size_ = sizeof(int64_t);
+      break;
+    }
+
+    case Field::Type::STRING:
+    case Field::Type::DOCUMENT:
+    case Field::Type::ARRAY:
+    case Field::Type::BINARY: {
+      if (remaining < sizeof(int32_t)) {
+        throw EnvoyException("invalid buffer size");
+      }
+
+      int32_t length = readInt32(value);
+      if (field.type_ == Field::Type::STRING) {
+        // The length includes the terminating zero.
+        field.value_size_ = sizeof(int32_t) + length;
+        if (length < 1 || field.value_size_ > remaining || value[field.value_size_ - 1] != 0) {
+          throw EnvoyException("invalid BSON string");
+        }
+      } else if (field.type_ == Field::Type::BINARY) {
+        // The length doesn't include the subtype.
+        field.value_size_ = sizeof(int32_t) + 1 + length;
+        if (length < 0) {
+          throw EnvoyException("invalid BSON binary");
+        }
+      } else {
+        field.value_size_ = length;
+        if (length < 5 || field.value_size_ > remaining || value[field.value_size_ - 1] != 0) {
+          throw EnvoyException("invalid document");
+        }
+      }
+      break;
+    }
+
+    case Field::Type::OBJECT_ID: {
+      field.value_size_ = sizeof(Field::ObjectId);
+      break;
+    }
+
+    case Field::Type::BOOLEAN: {
+      field.value_size_ = 1;
+      break;
+    }
+
+    case Field::Type::NULL_VALUE: {
+      field.value_size_ = 0;
+      break;
+    }
+
+    case Field::Type::REGEX: {
+      // Pattern and options.
+      const uint64_t pattern_size = cStringSize(value, remaining) + 1;
+      field.value_size_ =
+          pattern_size + cStringSize(value + pattern_size, remaining - pattern_size) + 1;
+      break;
+    }
+
+    case Field::Type::INT32: {
+      field.value_size_ = sizeof(int32_t);
+      break;
+    }
+
+    default:
+      throw EnvoyException(fmt::format("invalid BSON element type: {:#x} key: {}", element_type,
+                                       std::string(raw_->data() + field.key_offset_,
+                                                   field.key_size_)));
+    }
+
+    if (field.value_size_ > remaining) {
+      throw EnvoyException("invalid buffer size");
+    }
+
+    field.value_offset_ = raw_offset_ + offset;
+    offset += field.value_size_;
+    lazy_fields_.emplace_back(std::move(field));
+  }
+
+  indexed_ = true;
+}
+
+FieldPtr DocumentImpl::decodeField(const LazyField& field) const {
+  const std::string key(raw_->data() + field.key_offset_, field.key_size_);
+  const char* value = raw_->data() + field.value_offset_;
+  switch (field.type_) {
+  case Field::Type::DOUBLE: {
+    // See BufferHelper::removeDouble().
+    union {
+      int64_t i;
+      double d;
+    } memory;
+
+    memory.i = readInt64(value);
+    return FieldPtr{new FieldImpl(key, memory.d)};
+  }
+
+  case Field::Type::STRING:
+  case Field::Type::BINARY: {
+    // Skip the length, then the subtype of a binary, or drop the terminating zero of a string.
+    std::string string_value = field.type_ == Field::Type::STRING
+                                   ? std::string(value + 4, field.value_size_ - 5)
+                                   : std::string(value + 5, field.value_size_ - 5);
+    return FieldPtr{new FieldImpl(field.type_, key, std::move(string_value))};
+  }
+
+  case Field::Type::DOCUMENT:
+  case Field::Type::ARRAY: {
+    return FieldPtr{new FieldImpl(
+        field.type_, key, DocumentSharedPtr{new DocumentImpl(raw_, field.value_offset_,
+                                                             field.value_size_)})};
+  }
+
+  case Field::Type::OBJECT_ID: {
+    Field::ObjectId object_id;
+    std::memcpy(&object_id[0], value, object_id.size());
+    return FieldPtr{new FieldImpl(key, std::move(object_id))};
+  }
+
+  case Field::Type::BOOLEAN: {
+    return FieldPtr{new FieldImpl(key, value[0] != 0)};
+  }
+
+  case Field::Type::DATETIME:
+  case Field::Type::TIMESTAMP:
+  case Field::Type::INT64: {
+    return FieldPtr{new FieldImpl(field.type_, key, readInt64(value))};
+  }
+
+  case Field::Type::NULL_VALUE: {
+    return FieldPtr{new FieldImpl(key)};
+  }
+
+  case Field::Type::REGEX: {
+    Field::Regex regex;
+    regex.pattern_ = value;
+    regex.options_ = value + regex.pattern_.size() + 1;
+    return FieldPtr{new FieldImpl(key, std::move(regex))};
+  }
+
+  case Field::Type::INT32: {
+    return FieldPtr{new FieldImpl(key, readInt32(value))};
+  }
+  }
+
+  NOT_REACHED;
+}
+
+const Field* DocumentImpl::lazyFind(const std::string& name, const Field::Type* type) const {
+  index();
+  for (LazyField& field : lazy_fields_) {
+    if ((type && field.type_ != *type) || field.key_size_ != name.size() ||
+        name.compare(0, name.size(), raw_->data() + field.key_offset_, field.key_size_) != 0) {
+      continue;
+    }
+
+    if (!field.field_) {
+      field.field_ = decodeField(field);
+    }
+    return field.field_.get();
+  }
+
+  return nullptr;
+}
+
+void DocumentImpl::decodeAll() const {
+  if (decoded_) {
+    return;
+  }
+
+  index();
+  for (LazyField& field : lazy_fields_) {
+    // Fields which have been looked up already move over, so that pointers to them stay valid.
+    fields_.emplace_back(field.field_ ? std::move(field.field_) : decodeField(field));
+  }
+
+  lazy_fields_.clear();
+  decoded_ = true;
+}
+
+std::list<FieldPtr>& DocumentImpl::mutableFields() {
+  decodeAll();
+  raw_.reset();
+  return fields_;
+}
+
+const std::list<FieldPtr>& DocumentImpl::values() const {
+  decodeAll();
+  return fields_;
+}
+
 int32_t DocumentImpl::byteSize() const {
+  if (raw_) {
+    return raw_size_;
+  }
+
   // Minimum size is 5.
   int32_t total_size = sizeof(int32_t) + 1;
   for (const FieldPtr& field : fields_) {
@@ -489,6 +753,11 @@ int32_t DocumentImpl::byteSize() const {
 }
 
 void DocumentImpl::encode(Buffer::Instance& output) const {
+  if (raw_) {
+    output.add(raw_->data() + raw_offset_, raw_size_);
+    return;
+  }
+
   BufferHelper::writeInt32(output, byteSize());
   for (const FieldPtr& field : fields_) {
     field->encode(output);
@@ -519,7 +788,7 @@ std::string DocumentImpl::toString() const {
   out << "{";
 
   bool first = true;
-  for (const FieldPtr& field : fields_) {
+  for (const FieldPtr& field : values()) {
     if (!first) {
       out << ", ";
     }
@@ -533,6 +802,10 @@ std::string DocumentImpl::toString() const {
 }
 
 const Field* DocumentImpl::find(const std::string& name) const {
+  if (!decoded_) {
+    return lazyFind(name, nullptr);
+  }
+
   for (const FieldPtr& field : fields_) {
     if (field->key() == name) {
       return field.get();
@@ -543,6 +816,10 @@ const Field* DocumentImpl::find(const std::string& name) const {
 }
 
 const Field* DocumentImpl::find(const std::string& name, Field::Type type) const {
+  if (!decoded_) {
+    return lazyFind(name, &type);
+  }
+
   for (const FieldPtr& field : fields_) {
     if (field->key() == name && field->type() == type) {
       return field.get();
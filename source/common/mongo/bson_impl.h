@@ -3,6 +3,7 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "envoy/buffer/buffer.h"
 #include "envoy/common/exception.h"
@@ -179,69 +180,80 @@ public:
     return new_doc;
   }
 
+  /**
+   * Create a document which is decoded as it is accessed. Only the length and the termination of
+   * the document are checked here, the fields are indexed on first access and their values are
+   * decoded when they are looked up. byteSize() and encode() use the encoded bytes as they are.
+   * @param data supplies the encoded bytes, which the document (and its nested documents) keep a
+   *        reference to.
+   * @param offset supplies the offset of the document in data, and is advanced past it.
+   */
+  static DocumentSharedPtr createLazy(const std::shared_ptr<const std::string>& data,
+                                      uint64_t& offset);
+
   // Mongo::Document
   DocumentSharedPtr addDouble(const std::string& key, double value) override {
-    fields_.emplace_back(new FieldImpl(key, value));
+    mutableFields().emplace_back(new FieldImpl(key, value));
     return shared_from_this();
   }
 
   DocumentSharedPtr addString(const std::string& key, std::string&& value) override {
-    fields_.emplace_back(new FieldImpl(Field::Type::STRING, key, std::move(value)));
+    mutableFields().emplace_back(new FieldImpl(Field::Type::STRING, key, std::move(value)));
     return shared_from_this();
   }
 
   DocumentSharedPtr addDocument(const std::string& key, DocumentSharedPtr value) override {
-    fields_.emplace_back(new FieldImpl(Field::Type::DOCUMENT, key, value));
+    mutableFields().emplace_back(new FieldImpl(Field::Type::DOCUMENT, key, value));
     return shared_from_this();
   }
 
   DocumentSharedPtr addArray(const std::string& key, DocumentSharedPtr value) override {
-    fields_.emplace_back(new FieldImpl(Field::Type::ARRAY, key, value));
+    mutableFields().emplace_back(new FieldImpl(Field::Type::ARRAY, key, value));
     return shared_from_this();
   }
 
   DocumentSharedPtr addBinary(const std::string& key, std::string&& value) override {
-    fields_.emplace_back(new FieldImpl(Field::Type::BINARY, key, std::move(value)));
+    mutableFields().emplace_back(new FieldImpl(Field::Type::BINARY, key, std::move(value)));
     return shared_from_this();
   }
 
   DocumentSharedPtr addObjectId(const std::string& key, Field::ObjectId&& value) override {
-    fields_.emplace_back(new FieldImpl(key, std::move(value)));
+    mutableFields().emplace_back(new FieldImpl(key, std::move(value)));
     return shared_from_this();
   }
 
   DocumentSharedPtr addBoolean(const std::string& key, bool value) override {
-    fields_.emplace_back(new FieldImpl(key, value));
+    mutableFields().emplace_back(new FieldImpl(key, value));
     return shared_from_this();
   }
 
   DocumentSharedPtr addDatetime(const std::string& key, int64_t value) override {
-    fields_.emplace_back(new FieldImpl(Field::Type::DATETIME, key, value));
+    mutableFields().emplace_back(new FieldImpl(Field::Type::DATETIME, key, value));
     return shared_from_this();
   }
 
   DocumentSharedPtr addNull(const std::string& key) override {
-    fields_.emplace_back(new FieldImpl(key));
+    mutableFields().emplace_back(new FieldImpl(key));
     return shared_from_this();
   }
 
   DocumentSharedPtr addRegex(const std::string& key, Field::Regex&& value) override {
-    fields_.emplace_back(new FieldImpl(key, std::move(value)));
+    mutableFields().emplace_back(new FieldImpl(key, std::move(value)));
     return shared_from_this();
   }
 
   DocumentSharedPtr addInt32(const std::string& key, int32_t value) override {
-    fields_.emplace_back(new FieldImpl(key, value));
+    mutableFields().emplace_back(new FieldImpl(key, value));
     return shared_from_this();
   }
 
   DocumentSharedPtr addTimestamp(const std::string& key, int64_t value) override {
-    fields_.emplace_back(new FieldImpl(Field::Type::TIMESTAMP, key, value));
+    mutableFields().emplace_back(new FieldImpl(Field::Type::TIMESTAMP, key, value));
     return shared_from_this();
   }
 
   DocumentSharedPtr addInt64(const std::string& key, int64_t value) override {
-    fields_.emplace_back(new FieldImpl(Field::Type::INT64, key, value));
+    mutableFields().emplace_back(new FieldImpl(Field::Type::INT64, key, value));
     return shared_from_this();
   }
 
@@ -251,14 +263,42 @@ public:
   const Field* find(const std::string& name) const override;
   const Field* find(const std::string& name, Field::Type type) const override;
   std::string toString() const override;
-  const std::list<FieldPtr>& values() const override { return fields_; }
+  const std::list<FieldPtr>& values() const override;
 
 private:
+  /**
+   * A field of a lazily decoded document, as offsets into the encoded bytes.
+   */
+  struct LazyField {
+    Field::Type type_;
+    uint64_t key_offset_;
+    uint64_t key_size_;
+    uint64_t value_offset_;
+    uint64_t value_size_;
+    FieldPtr field_;
+  };
+
   DocumentImpl() {}
+  DocumentImpl(const std::shared_ptr<const std::string>& raw, uint64_t offset, uint64_t size)
+      : raw_(raw), raw_offset_(offset), raw_size_(size), decoded_(false) {}
 
   void fromBuffer(Buffer::Instance& data);
-
-  std::list<FieldPtr> fields_;
+  void index() const;
+  const Field* lazyFind(const std::string& name, const Field::Type* type) const;
+  FieldPtr decodeField(const LazyField& field) const;
+  void decodeAll() const;
+  std::list<FieldPtr>& mutableFields();
+
+  // For a lazily decoded document, the encoded bytes which are shared with its nested documents.
+  // Dropped once the document is modified.
+  std::shared_ptr<const std::string> raw_;
+  uint64_t raw_offset_{};
+  uint64_t raw_size_{};
+  mutable bool indexed_{};
+  mutable std::vector<LazyField> lazy_fields_;
+  // Whether fields_ holds all of the fields, rather than lazy_fields_.
+  mutable bool decoded_{true};
+  mutable std::list<FieldPtr> fields_;
 };
 
 } // namespace Bson
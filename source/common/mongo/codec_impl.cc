@@ -36,6 +36,25 @@ MessageImpl::documentListToString(const std::list<Bson::DocumentSharedPtr>& docu
   return out.str();
 }
 
+std::shared_ptr<const std::string> MessageImpl::removeDocuments(uint32_t message_length,
+                                                               uint64_t original_buffer_length,
+                                                               Buffer::Instance& data) {
+  const uint64_t decoded_length = original_buffer_length - data.length();
+  if (decoded_length > message_length) {
+    throw EnvoyException("invalid message length");
+  }
+
+  const uint64_t length = message_length - decoded_length;
+
+  std::shared_ptr<std::string> documents = std::make_shared<std::string>();
+  if (length > 0) {
+    documents->assign(static_cast<const char*>(data.linearize(length)), length);
+    data.drain(length);
+  }
+
+  return documents;
+}
+
 void GetMoreMessageImpl::fromBuffer(uint32_t, Buffer::Instance& data) {
   ENVOY_LOG(trace, "decoding get more message");
   Bson::BufferHelper::removeInt32(data); // "zero" (unused)
@@ -65,11 +84,16 @@ void InsertMessageImpl::fromBuffer(uint32_t message_length, Buffer::Instance& da
 
   flags_ = Bson::BufferHelper::removeInt32(data);
   full_collection_name_ = Bson::BufferHelper::removeCString(data);
-  while (data.length() - (original_buffer_length - message_length) > 0) {
-    documents_.emplace_back(Bson::DocumentImpl::create(data));
+  std::shared_ptr<const std::string> documents =
+      removeDocuments(message_length, original_buffer_length, data);
+  uint64_t offset = 0;
+  while (offset < documents->size()) {
+    documents_.emplace_back(Bson::DocumentImpl::createLazy(documents, offset));
   }
 
-  ENVOY_LOG(trace, "{}", toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(trace)) {
+    ENVOY_LOG(trace, "{}", toString(true));
+  }
 }
 
 bool InsertMessageImpl::operator==(const InsertMessage& rhs) const {
@@ -140,13 +164,18 @@ void QueryMessageImpl::fromBuffer(uint32_t message_length, Buffer::Instance& dat
   full_collection_name_ = Bson::BufferHelper::removeCString(data);
   number_to_skip_ = Bson::BufferHelper::removeInt32(data);
   number_to_return_ = Bson::BufferHelper::removeInt32(data);
-  query_ = Bson::DocumentImpl::create(data);
+  std::shared_ptr<const std::string> documents =
+      removeDocuments(message_length, original_buffer_length, data);
+  uint64_t offset = 0;
+  query_ = Bson::DocumentImpl::createLazy(documents, offset);
 
-  if (data.length() - (original_buffer_length - message_length) > 0) {
-    return_fields_selector_ = Bson::DocumentImpl::create(data);
+  if (offset < documents->size()) {
+    return_fields_selector_ = Bson::DocumentImpl::createLazy(documents, offset);
   }
 
-  ENVOY_LOG(trace, "{}", toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(trace)) {
+    ENVOY_LOG(trace, "{}", toString(true));
+  }
 }
 
 bool QueryMessageImpl::operator==(const QueryMessage& rhs) const {
@@ -181,17 +210,28 @@ std::string QueryMessageImpl::toString(bool full) const {
       return_fields_selector_ ? return_fields_selector_->toString() : "{}");
 }
 
-void ReplyMessageImpl::fromBuffer(uint32_t, Buffer::Instance& data) {
+void ReplyMessageImpl::fromBuffer(uint32_t message_length, Buffer::Instance& data) {
   ENVOY_LOG(trace, "decoding reply message");
+  uint64_t original_buffer_length = data.length();
+  ASSERT(message_length <= original_buffer_length);
+
   flags_ = Bson::BufferHelper::removeInt32(data);
   cursor_id_ = Bson::BufferHelper::removeInt64(data);
   starting_from_ = Bson::BufferHelper::removeInt32(data);
   number_returned_ = Bson::BufferHelper::removeInt32(data);
+
+  // Only the number and the size of the documents are needed for stats, so they are just split up
+  // here and only decoded if they are accessed.
+  std::shared_ptr<const std::string> documents =
+      removeDocuments(message_length, original_buffer_length, data);
+  uint64_t offset = 0;
   for (int32_t i = 0; i < number_returned_; i++) {
-    documents_.emplace_back(Bson::DocumentImpl::create(data));
+    documents_.emplace_back(Bson::DocumentImpl::createLazy(documents, offset));
   }
 
-  ENVOY_LOG(trace, "{}", toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(trace)) {
+    ENVOY_LOG(trace, "{}", toString(true));
+  }
 }
 
 bool ReplyMessageImpl::operator==(const ReplyMessage& rhs) const {
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <list>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -26,6 +27,16 @@ public:
 protected:
   std::string documentListToString(const std::list<Bson::DocumentSharedPtr>& documents) const;
 
+  /**
+   * Remove the documents which make up the rest of a message in one copy, so that they can be
+   * decoded lazily.
+   * @param message_length supplies the length of the message, without the header.
+   * @param original_buffer_length supplies the length of the buffer when the message started.
+   * @param data supplies the buffer to remove the documents from.
+   */
+  static std::shared_ptr<const std::string>
+  removeDocuments(uint32_t message_length, uint64_t original_buffer_length, Buffer::Instance& data);
+
   const int32_t request_id_;
   const int32_t response_to_;
 };
@@ -1,5 +1,6 @@
 #include "common/mongo/proxy.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <string>
@@ -10,6 +11,7 @@
 #include "envoy/runtime/runtime.h"
 
 #include "common/common/assert.h"
+#include "common/common/byte_order.h"
 #include "common/common/utility.h"
 #include "common/mongo/codec_impl.h"
 
@@ -18,6 +20,27 @@
 namespace Envoy {
 namespace Mongo {
 
+namespace {
+
+// Message length, request ID, response to and op code.
+const uint64_t MESSAGE_HEADER_SIZE = 16;
+
+// Append length bytes of data, starting at offset, to output without draining them.
+void copyBytes(const Buffer::Instance& data, uint64_t offset, uint64_t length,
+               Buffer::Instance& output) {
+  if (length == 0) {
+    return;
+  }
+
+  Buffer::RawSlice slice;
+  output.reserve(length, &slice, 1);
+  data.copyOut(offset, length, slice.mem_);
+  slice.len_ = length;
+  output.commit(&slice, 1);
+}
+
+} // namespace
+
 AccessLog::AccessLog(const std::string& file_name,
                      Envoy::AccessLog::AccessLogManager& log_manager) {
   file_ = log_manager.createAccessLog(file_name);
@@ -37,12 +60,14 @@ void AccessLog::logMessage(const Message& message, bool full,
 }
 
 ProxyFilter::ProxyFilter(const std::string& stat_prefix, Stats::Scope& scope,
-                         Runtime::Loader& runtime, AccessLogSharedPtr access_log,
-                         const FaultConfigSharedPtr& fault_config,
+                         Runtime::Loader& runtime, Runtime::RandomGenerator& random,
+                         AccessLogSharedPtr access_log, const FaultConfigSharedPtr& fault_config,
                          const Network::DrainDecision& drain_decision)
     : stat_prefix_(stat_prefix), scope_(scope), stats_(generateStats(stat_prefix, scope)),
-      runtime_(runtime), drain_decision_(drain_decision), access_log_(access_log),
-      fault_config_(fault_config) {
+      runtime_(runtime), random_(random), drain_decision_(drain_decision),
+      sample_rate_(std::max<uint64_t>(
+          1, runtime_.snapshot().getInteger(MongoRuntimeConfig::get().DecodeSampleRate, 1))),
+      access_log_(access_log), fault_config_(fault_config) {
   if (!runtime_.snapshot().featureEnabled(MongoRuntimeConfig::get().ConnectionLoggingEnabled,
                                           100)) {
     // If we are not logging at the connection level, just release the shared pointer so that we
@@ -56,7 +81,7 @@ ProxyFilter::~ProxyFilter() { ASSERT(!delay_timer_); }
 void ProxyFilter::decodeGetMore(GetMoreMessagePtr&& message) {
   tryInjectDelay();
 
-  stats_.op_get_more_.inc();
+  stats_.op_get_more_.add(sample_rate_);
   logMessage(*message, true);
   ENVOY_LOG(debug, "decoded GET_MORE: {}", message->toString(true));
 }
@@ -64,15 +89,17 @@ void ProxyFilter::decodeGetMore(GetMoreMessagePtr&& message) {
 void ProxyFilter::decodeInsert(InsertMessagePtr&& message) {
   tryInjectDelay();
 
-  stats_.op_insert_.inc();
+  stats_.op_insert_.add(sample_rate_);
   logMessage(*message, true);
-  ENVOY_LOG(debug, "decoded INSERT: {}", message->toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(debug)) {
+    ENVOY_LOG(debug, "decoded INSERT: {}", message->toString(true));
+  }
 }
 
 void ProxyFilter::decodeKillCursors(KillCursorsMessagePtr&& message) {
   tryInjectDelay();
 
-  stats_.op_kill_cursors_.inc();
+  stats_.op_kill_cursors_.add(sample_rate_);
   logMessage(*message, true);
   ENVOY_LOG(debug, "decoded KILL_CURSORS: {}", message->toString(true));
 }
@@ -80,28 +107,30 @@ void ProxyFilter::decodeKillCursors(KillCursorsMessagePtr&& message) {
 void ProxyFilter::decodeQuery(QueryMessagePtr&& message) {
   tryInjectDelay();
 
-  stats_.op_query_.inc();
+  stats_.op_query_.add(sample_rate_);
   logMessage(*message, true);
-  ENVOY_LOG(debug, "decoded QUERY: {}", message->toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(debug)) {
+    ENVOY_LOG(debug, "decoded QUERY: {}", message->toString(true));
+  }
 
   if (message->flags() & QueryMessage::Flags::TailableCursor) {
-    stats_.op_query_tailable_cursor_.inc();
+    stats_.op_query_tailable_cursor_.add(sample_rate_);
   }
   if (message->flags() & QueryMessage::Flags::NoCursorTimeout) {
-    stats_.op_query_no_cursor_timeout_.inc();
+    stats_.op_query_no_cursor_timeout_.add(sample_rate_);
   }
   if (message->flags() & QueryMessage::Flags::AwaitData) {
-    stats_.op_query_await_data_.inc();
+    stats_.op_query_await_data_.add(sample_rate_);
   }
   if (message->flags() & QueryMessage::Flags::Exhaust) {
-    stats_.op_query_exhaust_.inc();
+    stats_.op_query_exhaust_.add(sample_rate_);
   }
 
   ActiveQueryPtr active_query(new ActiveQuery(*this, *message));
   if (!active_query->query_info_.command().empty()) {
     // First field key is the operation.
     scope_.counter(fmt::format("{}cmd.{}.total", stat_prefix_, active_query->query_info_.command()))
-        .inc();
+        .add(sample_rate_);
   } else {
     // Normal query, get stats on a per collection basis first.
     std::string collection_stat_prefix =
@@ -119,12 +148,12 @@ void ProxyFilter::decodeQuery(QueryMessagePtr&& message) {
 
     // Global stats.
     if (active_query->query_info_.max_time() < 1) {
-      stats_.op_query_no_max_time_.inc();
+      stats_.op_query_no_max_time_.add(sample_rate_);
     }
     if (query_type == QueryMessageInfo::QueryType::ScatterGet) {
-      stats_.op_query_scatter_get_.inc();
+      stats_.op_query_scatter_get_.add(sample_rate_);
     } else if (query_type == QueryMessageInfo::QueryType::MultiGet) {
-      stats_.op_query_multi_get_.inc();
+      stats_.op_query_multi_get_.add(sample_rate_);
     }
   }
 
@@ -133,27 +162,29 @@ void ProxyFilter::decodeQuery(QueryMessagePtr&& message) {
 
 void ProxyFilter::chargeQueryStats(const std::string& prefix,
                                    QueryMessageInfo::QueryType query_type) {
-  scope_.counter(fmt::format("{}.query.total", prefix)).inc();
+  scope_.counter(fmt::format("{}.query.total", prefix)).add(sample_rate_);
   if (query_type == QueryMessageInfo::QueryType::ScatterGet) {
-    scope_.counter(fmt::format("{}.query.scatter_get", prefix)).inc();
+    scope_.counter(fmt::format("{}.query.scatter_get", prefix)).add(sample_rate_);
   } else if (query_type == QueryMessageInfo::QueryType::MultiGet) {
-    scope_.counter(fmt::format("{}.query.multi_get", prefix)).inc();
+    scope_.counter(fmt::format("{}.query.multi_get", prefix)).add(sample_rate_);
   }
 }
 
 void ProxyFilter::decodeReply(ReplyMessagePtr&& message) {
-  stats_.op_reply_.inc();
+  stats_.op_reply_.add(sample_rate_);
   logMessage(*message, false);
-  ENVOY_LOG(debug, "decoded REPLY: {}", message->toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(debug)) {
+    ENVOY_LOG(debug, "decoded REPLY: {}", message->toString(true));
+  }
 
   if (message->cursorId() != 0) {
-    stats_.op_reply_valid_cursor_.inc();
+    stats_.op_reply_valid_cursor_.add(sample_rate_);
   }
   if (message->flags() & ReplyMessage::Flags::CursorNotFound) {
-    stats_.op_reply_cursor_not_found_.inc();
+    stats_.op_reply_cursor_not_found_.add(sample_rate_);
   }
   if (message->flags() & ReplyMessage::Flags::QueryFailure) {
-    stats_.op_reply_query_failure_.inc();
+    stats_.op_reply_query_failure_.add(sample_rate_);
   }
 
   for (auto i = active_query_list_.begin(); i != active_query_list_.end(); i++) {
@@ -277,16 +308,88 @@ void ProxyFilter::onEvent(Network::ConnectionEvent event) {
   }
 }
 
+void ProxyFilter::doPassthrough(Buffer::Instance& data, PassthroughState& state,
+                                Buffer::Instance& decode_buffer, bool request) {
+  uint64_t offset = 0;
+  while (sniffing_ && offset < data.length()) {
+    if (state.remaining_ == 0) {
+      const uint64_t header_bytes =
+          std::min(MESSAGE_HEADER_SIZE - state.header_.length(), data.length() - offset);
+      copyBytes(data, offset, header_bytes, state.header_);
+      offset += header_bytes;
+      if (state.header_.length() == MESSAGE_HEADER_SIZE) {
+        onPassthroughHeader(state, decode_buffer, request);
+      }
+      continue;
+    }
+
+    const uint64_t message_bytes = std::min(state.remaining_, data.length() - offset);
+    if (state.sampled_) {
+      copyBytes(data, offset, message_bytes, decode_buffer);
+    }
+    offset += message_bytes;
+    state.remaining_ -= message_bytes;
+    if (state.remaining_ == 0 && state.sampled_) {
+      doDecode(decode_buffer);
+    }
+  }
+}
+
+void ProxyFilter::onPassthroughHeader(PassthroughState& state, Buffer::Instance& decode_buffer,
+                                      bool request) {
+  // Message length, request ID, response to and op code.
+  int32_t header[4];
+  state.header_.copyOut(0, sizeof(header), header);
+  const uint32_t message_length = le32toh(header[0]);
+  if (message_length < MESSAGE_HEADER_SIZE) {
+    ENVOY_LOG(info, "mongo decoding error: invalid message length {}", message_length);
+    stats_.decoding_error_.inc();
+    sniffing_ = false;
+    return;
+  }
+
+  const Message::OpCode op_code = static_cast<Message::OpCode>(le32toh(header[3]));
+  if (request) {
+    state.sampled_ = random_.random() % sample_rate_ == 0;
+    if (state.sampled_ &&
+        (op_code == Message::OpCode::OP_QUERY || op_code == Message::OpCode::OP_GET_MORE)) {
+      sampled_request_ids_.insert(le32toh(header[1]));
+    }
+  } else {
+    state.sampled_ = sampled_request_ids_.erase(le32toh(header[2])) > 0;
+  }
+
+  if (state.sampled_) {
+    decode_buffer.move(state.header_);
+  } else {
+    state.header_.drain(state.header_.length());
+  }
+
+  state.remaining_ = message_length - MESSAGE_HEADER_SIZE;
+  if (state.remaining_ == 0 && state.sampled_) {
+    doDecode(decode_buffer);
+  }
+}
+
 Network::FilterStatus ProxyFilter::onData(Buffer::Instance& data) {
-  read_buffer_.add(data);
-  doDecode(read_buffer_);
+  if (sample_rate_ > 1) {
+    doPassthrough(data, read_passthrough_, read_buffer_, true);
+  } else {
+    read_buffer_.add(data);
+    doDecode(read_buffer_);
+  }
 
   return delay_timer_ ? Network::FilterStatus::StopIteration : Network::FilterStatus::Continue;
 }
 
 Network::FilterStatus ProxyFilter::onWrite(Buffer::Instance& data) {
-  write_buffer_.add(data);
-  doDecode(write_buffer_);
+  if (sample_rate_ > 1) {
+    doPassthrough(data, write_passthrough_, write_buffer_, false);
+  } else {
+    write_buffer_.add(data);
+    doDecode(write_buffer_);
+  }
+
   return Network::FilterStatus::Continue;
 }
 
@@ -5,6 +5,7 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <unordered_set>
 
 #include "envoy/access_log/access_log.h"
 #include "envoy/common/time.h"
@@ -37,6 +38,7 @@ public:
   const std::string ProxyEnabled{"mongo.proxy_enabled"};
   const std::string ConnectionLoggingEnabled{"mongo.connection_logging_enabled"};
   const std::string DrainCloseEnabled{"mongo.drain_close_enabled"};
+  const std::string DecodeSampleRate{"mongo.decode_sample_rate"};
 };
 
 typedef ConstSingleton<MongoRuntimeConfigKeys> MongoRuntimeConfig;
@@ -113,6 +115,11 @@ typedef std::shared_ptr<const FaultConfig> FaultConfigSharedPtr;
 /**
  * A sniffing filter for mongo traffic. The current implementation makes a copy of read/written
  * data, decodes it, and generates stats.
+ *
+ * If the mongo.decode_sample_rate runtime key is set to N > 1 when the connection is created, the
+ * filter runs in passthrough mode instead: only the message headers are looked at, and one in N
+ * requests, picked at random, is copied and decoded along with its reply. Counters are scaled by N
+ * while histograms and the access log only see the sample.
  */
 class ProxyFilter : public Network::Filter,
                     public DecoderCallbacks,
@@ -120,7 +127,8 @@ class ProxyFilter : public Network::Filter,
                     Logger::Loggable<Logger::Id::mongo> {
 public:
   ProxyFilter(const std::string& stat_prefix, Stats::Scope& scope, Runtime::Loader& runtime,
-              AccessLogSharedPtr access_log, const FaultConfigSharedPtr& fault_config,
+              Runtime::RandomGenerator& random, AccessLogSharedPtr access_log,
+              const FaultConfigSharedPtr& fault_config,
               const Network::DrainDecision& drain_decision);
   ~ProxyFilter();
 
@@ -165,6 +173,18 @@ private:
 
   typedef std::unique_ptr<ActiveQuery> ActiveQueryPtr;
 
+  /**
+   * The framing of one direction of the connection in passthrough mode.
+   */
+  struct PassthroughState {
+    // The header of the next message, until all of it has been seen.
+    Buffer::OwnedImpl header_;
+    // How much of the current message is still to come.
+    uint64_t remaining_{};
+    // Whether the current message has been sampled, and is being copied to be decoded.
+    bool sampled_{};
+  };
+
   MongoProxyStats generateStats(const std::string& prefix, Stats::Scope& scope) {
     return MongoProxyStats{ALL_MONGO_PROXY_STATS(POOL_COUNTER_PREFIX(scope, prefix),
                                                  POOL_GAUGE_PREFIX(scope, prefix),
@@ -175,6 +195,9 @@ private:
   void chargeReplyStats(ActiveQuery& active_query, const std::string& prefix,
                         const ReplyMessage& message);
   void doDecode(Buffer::Instance& buffer);
+  void doPassthrough(Buffer::Instance& data, PassthroughState& state,
+                     Buffer::Instance& decode_buffer, bool request);
+  void onPassthroughHeader(PassthroughState& state, Buffer::Instance& decode_buffer, bool request);
   void logMessage(Message& message, bool full);
   void onDrainClose();
   Optional<uint64_t> delayDuration();
@@ -186,9 +209,16 @@ private:
   Stats::Scope& scope_;
   MongoProxyStats stats_;
   Runtime::Loader& runtime_;
+  Runtime::RandomGenerator& random_;
   const Network::DrainDecision& drain_decision_;
   Buffer::OwnedImpl read_buffer_;
   Buffer::OwnedImpl write_buffer_;
+  // One in how many requests is decoded, and how much the counters are charged for each of them.
+  const uint64_t sample_rate_;
+  PassthroughState read_passthrough_;
+  PassthroughState write_passthrough_;
+  // The IDs of the sampled requests which have replies, so that the replies are decoded too.
+  std::unordered_set<int32_t> sampled_request_ids_;
   bool sniffing_{true};
   std::list<ActiveQueryPtr> active_query_list_;
   AccessLogSharedPtr access_log_;
@@ -121,10 +121,6 @@ int InstanceBase::socketFromSocketType(SocketType socketType) const {
 
 Ipv4Instance::Ipv4Instance(const sockaddr_in* address) : InstanceBase(Type::Ip) {
   ip_.ipv4_.address_ = *address;
-  char str[INET_ADDRSTRLEN];
-  inet_ntop(AF_INET, &address->sin_addr, str, INET_ADDRSTRLEN);
-  friendly_name_ = fmt::format("{}:{}", str, ntohs(address->sin_port));
-  ip_.friendly_address_ = str;
 }
 
 Ipv4Instance::Ipv4Instance(const std::string& address) : Ipv4Instance(address, 0) {}
@@ -137,9 +133,6 @@ Ipv4Instance::Ipv4Instance(const std::string& address, uint32_t port) : Instance
   if (1 != rc) {
     throw EnvoyException(fmt::format("invalid ipv4 address '{}'", address));
   }
-
-  friendly_name_ = fmt::format("{}:{}", address, port);
-  ip_.friendly_address_ = address;
 }
 
 Ipv4Instance::Ipv4Instance(uint32_t port) : InstanceBase(Type::Ip) {
@@ -147,8 +140,19 @@ Ipv4Instance::Ipv4Instance(uint32_t port) : InstanceBase(Type::Ip) {
   ip_.ipv4_.address_.sin_family = AF_INET;
   ip_.ipv4_.address_.sin_port = htons(port);
   ip_.ipv4_.address_.sin_addr.s_addr = INADDR_ANY;
-  friendly_name_ = fmt::format("0.0.0.0:{}", port);
-  ip_.friendly_address_ = "0.0.0.0";
+}
+
+const std::string& Ipv4Instance::IpHelper::addressAsString() const {
+  std::call_once(friendly_address_once_, [this]() {
+    char str[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &ipv4_.address_.sin_addr, str, INET_ADDRSTRLEN);
+    friendly_address_ = str;
+  });
+  return friendly_address_;
+}
+
+std::string Ipv4Instance::formatFriendlyName() const {
+  return fmt::format("{}:{}", ip_.addressAsString(), ip_.port());
 }
 
 int Ipv4Instance::bind(int fd) const {
@@ -179,10 +183,14 @@ std::string Ipv6Instance::Ipv6Helper::makeFriendlyAddress() const {
   return ptr;
 }
 
+const std::string& Ipv6Instance::IpHelper::addressAsString() const {
+  std::call_once(friendly_address_once_,
+                 [this]() { friendly_address_ = ipv6_.makeFriendlyAddress(); });
+  return friendly_address_;
+}
+
 Ipv6Instance::Ipv6Instance(const sockaddr_in6& address) : InstanceBase(Type::Ip) {
   ip_.ipv6_.address_ = address;
-  ip_.friendly_address_ = ip_.ipv6_.makeFriendlyAddress();
-  friendly_name_ = fmt::format("[{}]:{}", ip_.friendly_address_, ip_.port());
 }
 
 Ipv6Instance::Ipv6Instance(const std::string& address) : Ipv6Instance(address, 0) {}
@@ -198,13 +206,15 @@ Ipv6Instance::Ipv6Instance(const std::string& address, uint32_t port) : Instance
   } else {
     ip_.ipv6_.address_.sin6_addr = in6addr_any;
   }
-  // Just in case address is in a non-canonical format, format from network address.
-  ip_.friendly_address_ = ip_.ipv6_.makeFriendlyAddress();
-  friendly_name_ = fmt::format("[{}]:{}", ip_.friendly_address_, ip_.port());
 }
 
 Ipv6Instance::Ipv6Instance(uint32_t port) : Ipv6Instance("", port) {}
 
+std::string Ipv6Instance::formatFriendlyName() const {
+  // Just in case the address was given in a non-canonical format, format from network address.
+  return fmt::format("[{}]:{}", ip_.addressAsString(), ip_.port());
+}
+
 int Ipv6Instance::bind(int fd) const {
   return ::bind(fd, reinterpret_cast<const sockaddr*>(&ip_.ipv6_.address_),
                 sizeof(ip_.ipv6_.address_));
@@ -229,14 +239,12 @@ PipeInstance::PipeInstance(const sockaddr_un* address) : InstanceBase(Type::Pipe
     throw EnvoyException("Abstract AF_UNIX sockets not supported.");
   }
   address_ = *address;
-  friendly_name_ = address_.sun_path;
 }
 
 PipeInstance::PipeInstance(const std::string& pipe_path) : InstanceBase(Type::Pipe) {
   memset(&address_, 0, sizeof(address_));
   address_.sun_family = AF_UNIX;
   StringUtil::strlcpy(&address_.sun_path[0], pipe_path.c_str(), sizeof(address_.sun_path));
-  friendly_name_ = address_.sun_path;
 }
 
 int PipeInstance::bind(int fd) const {
@@ -7,6 +7,7 @@
 
 #include <array>
 #include <cstdint>
+#include <mutex>
 #include <string>
 
 #include "envoy/network/address.h"
@@ -41,13 +42,17 @@ InstanceConstSharedPtr addressFromFd(int fd);
 InstanceConstSharedPtr peerAddressFromFd(int fd);
 
 /**
- * Base class for all address types.
+ * Base class for all address types. The human-readable name is only formatted the first time it
+ * is asked for, since most addresses (e.g. those of accepted connections) are never logged.
  */
 class InstanceBase : public Instance {
 public:
   // Network::Address::Instance
   bool operator==(const Instance& rhs) const override { return asString() == rhs.asString(); }
-  const std::string& asString() const override { return friendly_name_; }
+  const std::string& asString() const override {
+    std::call_once(friendly_name_once_, [this]() { friendly_name_ = formatFriendlyName(); });
+    return friendly_name_;
+  }
   // Default logical name is the human-readable name.
   const std::string& logicalName() const override { return asString(); }
   Type type() const override { return type_; }
@@ -56,10 +61,15 @@ protected:
   InstanceBase(Type type) : type_(type) {}
   int socketFromSocketType(SocketType type) const;
 
-  std::string friendly_name_;
+  /**
+   * @return std::string the human-readable name of the address.
+   */
+  virtual std::string formatFriendlyName() const PURE;
 
 private:
   const Type type_;
+  mutable std::once_flag friendly_name_once_;
+  mutable std::string friendly_name_;
 };
 
 /**
@@ -94,6 +104,10 @@ public:
   const Ip* ip() const override { return &ip_; }
   int socket(SocketType type) const override;
 
+protected:
+  // Network::Address::InstanceBase
+  std::string formatFriendlyName() const override;
+
 private:
   struct Ipv4Helper : public Ipv4 {
     uint32_t address() const override { return address_.sin_addr.s_addr; }
@@ -102,7 +116,7 @@ private:
   };
 
   struct IpHelper : public Ip {
-    const std::string& addressAsString() const override { return friendly_address_; }
+    const std::string& addressAsString() const override;
     bool isAnyAddress() const override { return ipv4_.address_.sin_addr.s_addr == INADDR_ANY; }
     bool isUnicastAddress() const override {
       return !isAnyAddress() && (ipv4_.address_.sin_addr.s_addr != INADDR_BROADCAST) &&
@@ -115,7 +129,8 @@ private:
     IpVersion version() const override { return IpVersion::v4; }
 
     Ipv4Helper ipv4_;
-    std::string friendly_address_;
+    mutable std::once_flag friendly_address_once_;
+    mutable std::string friendly_address_;
   };
 
   IpHelper ip_;
@@ -153,6 +168,10 @@ public:
   const Ip* ip() const override { return &ip_; }
   int socket(SocketType type) const override;
 
+protected:
+  // Network::Address::InstanceBase
+  std::string formatFriendlyName() const override;
+
 private:
   struct Ipv6Helper : public Ipv6 {
     std::array<uint8_t, 16> address() const override;
@@ -164,7 +183,7 @@ private:
   };
 
   struct IpHelper : public Ip {
-    const std::string& addressAsString() const override { return friendly_address_; }
+    const std::string& addressAsString() const override;
     bool isAnyAddress() const override {
       return 0 == memcmp(&ipv6_.address_.sin6_addr, &in6addr_any, sizeof(struct in6_addr));
     }
@@ -177,7 +196,8 @@ private:
     IpVersion version() const override { return IpVersion::v6; }
 
     Ipv6Helper ipv6_;
-    std::string friendly_address_;
+    mutable std::once_flag friendly_address_once_;
+    mutable std::string friendly_address_;
   };
 
   IpHelper ip_;
@@ -204,6 +224,10 @@ public:
   const Ip* ip() const override { return nullptr; }
   int socket(SocketType type) const override;
 
+protected:
+  // Network::Address::InstanceBase
+  std::string formatFriendlyName() const override { return address_.sun_path; }
+
 private:
   sockaddr_un address_;
 };
@@ -0,0 +1,86 @@
+#include "common/network/caching_dns_resolver_impl.h"
+
+#include <chrono>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Network {
+
+CachingDnsResolverImpl::CachingDnsResolverImpl(DnsResolverSharedPtr resolver,
+                                               std::chrono::milliseconds cache_duration,
+                                               MonotonicTimeSource& time_source)
+    : resolver_(resolver), cache_duration_(cache_duration), time_source_(time_source) {}
+
+CachingDnsResolverImpl::~CachingDnsResolverImpl() {
+  for (auto& resolution : resolutions_) {
+    if (resolution.second.query_ != nullptr) {
+      resolution.second.query_->cancel();
+    }
+  }
+}
+
+ActiveDnsQuery* CachingDnsResolverImpl::resolve(const std::string& dns_name,
+                                                DnsLookupFamily dns_lookup_family,
+                                                ResolveCb callback) {
+  const Key key(dns_name, dns_lookup_family);
+  auto cached = cache_.find(key);
+  if (cached != cache_.end()) {
+    if (time_source_.currentTime() < cached->second.expiry_) {
+      std::list<Address::InstanceConstSharedPtr> address_list = cached->second.addresses_;
+      callback(std::move(address_list));
+      return nullptr;
+    }
+    cache_.erase(cached);
+  }
+
+  // Join the resolution of the name which is already in progress, if there is one.
+  auto resolution = resolutions_.find(key);
+  if (resolution != resolutions_.end()) {
+    resolution->second.pending_.emplace_back(new PendingResolution(callback));
+    return resolution->second.pending_.back().get();
+  }
+
+  resolution = resolutions_.emplace(key, SharedResolution()).first;
+  resolution->second.pending_.emplace_back(new PendingResolution(callback));
+  PendingResolution* pending = resolution->second.pending_.back().get();
+  ActiveDnsQuery* query = resolver_->resolve(
+      dns_name, dns_lookup_family,
+      [this, key](std::list<Address::InstanceConstSharedPtr>&& address_list) -> void {
+        onResolved(key, std::move(address_list));
+      });
+  if (query == nullptr) {
+    // The resolution completed immediately, and the callback has already been invoked.
+    return nullptr;
+  }
+
+  resolution->second.query_ = query;
+  return pending;
+}
+
+void CachingDnsResolverImpl::onResolved(const Key& key,
+                                        std::list<Address::InstanceConstSharedPtr>&& address_list) {
+  auto resolution = resolutions_.find(key);
+  ASSERT(resolution != resolutions_.end());
+  std::list<PendingResolutionPtr> pending = std::move(resolution->second.pending_);
+  resolutions_.erase(resolution);
+
+  if (!address_list.empty() && cache_duration_.count() > 0) {
+    cache_[key] = {address_list, time_source_.currentTime() + cache_duration_};
+  }
+
+  // A callback may cancel the resolutions of other callers, so cancelled_ is checked as each
+  // callback is invoked.
+  for (const PendingResolutionPtr& caller : pending) {
+    if (!caller->cancelled_) {
+      std::list<Address::InstanceConstSharedPtr> caller_address_list = address_list;
+      caller->callback_(std::move(caller_address_list));
+    }
+  }
+}
+
+} // namespace Network
+} // namespace Envoy
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "envoy/common/time.h"
+#include "envoy/network/dns.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * DnsResolver which shares resolutions of the same name between callers. Concurrent resolutions
+ * of a name are sent to the underlying resolver once, and the addresses it resolves are reused for
+ * a fixed duration, as the underlying resolver doesn't report the TTLs of the records. Resolutions
+ * which fail aren't reused. All calls and callbacks are assumed to happen on the thread that owns
+ * the dispatcher of the underlying resolver.
+ */
+class CachingDnsResolverImpl : public DnsResolver {
+public:
+  /**
+   * @param resolver supplies the resolver which resolves names.
+   * @param cache_duration supplies how long resolved addresses are reused for, or 0 to only share
+   *        concurrent resolutions.
+   * @param time_source supplies the time source which cached addresses expire by.
+   */
+  CachingDnsResolverImpl(DnsResolverSharedPtr resolver, std::chrono::milliseconds cache_duration,
+                         MonotonicTimeSource& time_source);
+  ~CachingDnsResolverImpl();
+
+  // Network::DnsResolver
+  ActiveDnsQuery* resolve(const std::string& dns_name, DnsLookupFamily dns_lookup_family,
+                          ResolveCb callback) override;
+
+private:
+  typedef std::pair<std::string, DnsLookupFamily> Key;
+
+  struct PendingResolution : public ActiveDnsQuery {
+    PendingResolution(ResolveCb callback) : callback_(callback) {}
+
+    // Network::ActiveDnsQuery
+    void cancel() override {
+      // The shared resolution continues for the other callers, but the callback isn't invoked.
+      cancelled_ = true;
+    }
+
+    const ResolveCb callback_;
+    bool cancelled_{};
+  };
+
+  typedef std::unique_ptr<PendingResolution> PendingResolutionPtr;
+
+  struct SharedResolution {
+    ActiveDnsQuery* query_{};
+    std::list<PendingResolutionPtr> pending_;
+  };
+
+  struct CachedAddresses {
+    std::list<Address::InstanceConstSharedPtr> addresses_;
+    MonotonicTime expiry_;
+  };
+
+  void onResolved(const Key& key, std::list<Address::InstanceConstSharedPtr>&& address_list);
+
+  const DnsResolverSharedPtr resolver_;
+  const std::chrono::milliseconds cache_duration_;
+  MonotonicTimeSource& time_source_;
+  std::map<Key, SharedResolution> resolutions_;
+  std::map<Key, CachedAddresses> cache_;
+};
+
+} // namespace Network
+} // namespace Envoy
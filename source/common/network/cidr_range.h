@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -12,6 +13,9 @@
 
 namespace Envoy {
 namespace Network {
+
+class LcTrie;
+
 namespace Address {
 
 /**
@@ -120,7 +124,8 @@ private:
 
 /**
  * Class for keeping a list of CidrRanges, and then determining whether an
- * IP address is in the CidrRange list.
+ * IP address is in the CidrRange list. The ranges are indexed in an LcTrie, so that a lookup
+ * takes about the same time whatever the number of ranges.
  */
 class IpList {
 public:
@@ -130,10 +135,13 @@ public:
   IpList(){};
 
   bool contains(const Instance& address) const;
-  bool empty() const { return ip_list_.empty(); }
+  bool empty() const { return trie_ == nullptr; }
 
 private:
-  std::vector<CidrRange> ip_list_;
+  void buildTrie(const std::vector<CidrRange>& ip_list);
+
+  // Null if the list is empty. Shared by the copies of the list, as it is never modified.
+  std::shared_ptr<const LcTrie> trie_;
 };
 
 } // namespace Address
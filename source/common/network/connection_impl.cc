@@ -1,11 +1,14 @@
 #include "common/network/connection_impl.h"
 
+#include <fcntl.h>
 #include <netinet/tcp.h>
+#include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 
 #include "envoy/common/exception.h"
@@ -51,7 +54,65 @@ void ConnectionImplUtility::updateBufferStats(uint64_t delta, uint64_t new_total
   }
 }
 
+SplicePipe::SplicePipe(int read_fd, int write_fd, uint64_t capacity)
+    : read_fd_(read_fd), write_fd_(write_fd), capacity_(capacity) {}
+
+SplicePipe::~SplicePipe() {
+  ::close(read_fd_);
+  ::close(write_fd_);
+}
+
+SplicePipePtr SplicePipe::create() {
+#ifdef __linux__
+  int fds[2];
+  if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+    return nullptr;
+  }
+
+  const int capacity = fcntl(fds[1], F_GETPIPE_SZ);
+  return SplicePipePtr{new SplicePipe(fds[0], fds[1], capacity > 0 ? capacity : 65536)};
+#else
+  return nullptr;
+#endif
+}
+
+ssize_t SplicePipe::fill(int fd) {
+  ASSERT(!full());
+#ifdef __linux__
+  const ssize_t rc = splice(fd, nullptr, write_fd_, nullptr, capacity_ - length_,
+                            SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  if (rc > 0) {
+    length_ += rc;
+  }
+  return rc;
+#else
+  UNREFERENCED_PARAMETER(fd);
+  NOT_IMPLEMENTED;
+#endif
+}
+
+ssize_t SplicePipe::drain(int fd) {
+  ASSERT(length_ > 0);
+#ifdef __linux__
+  const ssize_t rc =
+      splice(read_fd_, nullptr, fd, nullptr, length_, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  if (rc > 0) {
+    length_ -= rc;
+  }
+  return rc;
+#else
+  UNREFERENCED_PARAMETER(fd);
+  NOT_IMPLEMENTED;
+#endif
+}
+
 std::atomic<uint64_t> ConnectionImpl::next_global_id_;
+bool ConnectionImpl::coalesce_writes_ = false;
+uint32_t ConnectionImpl::tcp_notsent_lowat_ = 0;
+
+void ConnectionImpl::coalesceWrites(bool coalesce_writes) { coalesce_writes_ = coalesce_writes; }
+
+void ConnectionImpl::tcpNotSentLowat(uint32_t bytes) { tcp_notsent_lowat_ = bytes; }
 
 ConnectionImpl::ConnectionImpl(Event::DispatcherImpl& dispatcher, int fd,
                                Address::InstanceConstSharedPtr remote_address,
@@ -75,7 +136,8 @@ ConnectionImpl::ConnectionImpl(Event::DispatcherImpl& dispatcher, int fd,
           dispatcher.getWatermarkFactory().create([this]() -> void { this->onLowWatermark(); },
                                                   [this]() -> void { this->onHighWatermark(); })),
       transport_socket_(std::move(transport_socket)), dispatcher_(dispatcher), fd_(fd),
-      id_(++next_global_id_), using_original_dst_(using_original_dst) {
+      id_(++next_global_id_), using_original_dst_(using_original_dst),
+      bind_to_address_(bind_to_address) {
 
   // Treat the lack of a valid fd (which in practice only happens if we run out of FDs) as an OOM
   // condition and just crash.
@@ -105,6 +167,10 @@ ConnectionImpl::ConnectionImpl(Event::DispatcherImpl& dispatcher, int fd,
     }
   }
 
+  if (tcp_notsent_lowat_ > 0) {
+    setNotSentLowat();
+  }
+
   transport_socket_->setTransportSocketCallbacks(*this);
 }
 
@@ -135,7 +201,7 @@ void ConnectionImpl::close(ConnectionCloseType type) {
     return;
   }
 
-  uint64_t data_to_write = write_buffer_->length();
+  uint64_t data_to_write = write_buffer_->length() + (splice_pipe_ ? splice_pipe_->length() : 0);
   ENVOY_CONN_LOG(debug, "closing data_to_write={} type={}", *this, data_to_write, enumToInt(type));
   if (data_to_write == 0 || type == ConnectionCloseType::NoFlush ||
       !transport_socket_->canFlushClose()) {
@@ -143,6 +209,9 @@ void ConnectionImpl::close(ConnectionCloseType type) {
       // We aren't going to wait to flush, but try to write as much as we can if there is pending
       // data.
       transport_socket_->doWrite(*write_buffer_);
+      if (splice_pipe_ && write_buffer_->length() == 0) {
+        doWriteSplicePipe();
+      }
     }
 
     closeSocket(ConnectionEvent::LocalClose);
@@ -172,6 +241,11 @@ void ConnectionImpl::closeSocket(ConnectionEvent close_type) {
 
   ENVOY_CONN_LOG(debug, "closing socket: {}", *this, static_cast<uint32_t>(close_type));
   transport_socket_->closeSocket(close_type);
+  stopSplicing();
+  cancelFallbackConnect();
+  if (write_flush_timer_) {
+    write_flush_timer_->disableTimer();
+  }
 
   // Drain input and output buffers.
   updateReadBufferStats(0, 0);
@@ -198,6 +272,8 @@ void ConnectionImpl::noDelay(bool enable) {
   if (fd_ == -1) {
     return;
   }
+  // Kept to set it again should the socket be replaced by the fallback one.
+  no_delay_ = enable;
 
   // Don't set NODELAY for unix domain sockets
   sockaddr addr;
@@ -224,6 +300,22 @@ void ConnectionImpl::noDelay(bool enable) {
   UNREFERENCED_PARAMETER(rc);
 }
 
+void ConnectionImpl::setNotSentLowat() {
+  // TCP_NOTSENT_LOWAT only applies to TCP sockets.
+  if (remote_address_->type() != Address::Type::Ip) {
+    return;
+  }
+
+#ifdef TCP_NOTSENT_LOWAT
+  int new_value = tcp_notsent_lowat_;
+  int rc = setsockopt(fd_, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &new_value, sizeof(new_value));
+  if (rc != 0) {
+    // This is an optimization, so carry on with the system default if the kernel refuses it.
+    ENVOY_CONN_LOG(debug, "unable to set TCP_NOTSENT_LOWAT: {}", *this, strerror(errno));
+  }
+#endif
+}
+
 uint64_t ConnectionImpl::id() const { return id_; }
 
 void ConnectionImpl::onRead(uint64_t read_buffer_size) {
@@ -279,8 +371,8 @@ void ConnectionImpl::readDisable(bool disable) {
     file_event_->setEnabled(Event::FileReadyType::Read | Event::FileReadyType::Write);
     // If the connection has data buffered there's no guarantee there's also data in the kernel
     // which will kick off the filter chain. Instead fake an event to make sure the buffered data
-    // gets processed regardless.
-    if (read_buffer_.length() > 0) {
+    // gets processed regardless. Spliced data stays in the kernel, so do the same while splicing.
+    if (read_buffer_.length() > 0 || splice_peer_ != nullptr) {
       file_event_->activate(Event::FileReadyType::Read);
     }
   }
@@ -324,11 +416,33 @@ void ConnectionImpl::write(Buffer::Instance& data) {
     // doWriteReady into thinking the socket is connected. On OS X, the underlying write may fail
     // with a connection error if a call to write(2) occurs before the connection is completed.
     if (!(state_ & InternalState::Connecting)) {
-      file_event_->activate(Event::FileReadyType::Write);
+      scheduleWrite();
     }
   }
 }
 
+void ConnectionImpl::scheduleWrite() {
+  if (!coalesce_writes_) {
+    file_event_->activate(Event::FileReadyType::Write);
+    return;
+  }
+
+  // A zero timeout timer runs after the events handled in this iteration of the event loop, so
+  // every write made while handling them is flushed together.
+  if (write_flush_pending_) {
+    return;
+  }
+
+  if (!write_flush_timer_) {
+    write_flush_timer_ = dispatcher_.createTimer([this]() -> void {
+      write_flush_pending_ = false;
+      onWriteReady();
+    });
+  }
+  write_flush_pending_ = true;
+  write_flush_timer_->enableTimer(std::chrono::milliseconds(0));
+}
+
 void ConnectionImpl::setBufferLimits(uint32_t limit) {
   read_buffer_limit_ = limit;
 
@@ -355,6 +469,12 @@ void ConnectionImpl::setBufferLimits(uint32_t limit) {
   }
 }
 
+void ConnectionImpl::setBufferAccount(Buffer::AccountSharedPtr account) {
+  read_buffer_.setAccount(account);
+  write_buffer_->setAccount(account);
+  buffer_account_ = std::move(account);
+}
+
 void ConnectionImpl::onLowWatermark() {
   ENVOY_CONN_LOG(debug, "onBelowWriteBufferLowWatermark", *this);
   ASSERT(above_high_watermark_);
@@ -377,6 +497,9 @@ void ConnectionImpl::onFileEvent(uint32_t events) {
   ENVOY_CONN_LOG(trace, "socket event: {}", *this, events);
 
   if (state_ & InternalState::ImmediateConnectionError) {
+    if (useFallbackOnConnectError()) {
+      return;
+    }
     ENVOY_CONN_LOG(debug, "raising immediate connect error", *this);
     closeSocket(ConnectionEvent::RemoteClose);
     return;
@@ -406,9 +529,11 @@ void ConnectionImpl::onFileEvent(uint32_t events) {
     onWriteReady();
   }
 
-  // It's possible for a write event callback to close the socket (which will cause fd_ to be -1).
-  // In this case ignore write event processing.
-  if (fd_ != -1 && (events & Event::FileReadyType::Read)) {
+  // It's possible for a write event callback to close the socket (which will cause fd_ to be -1),
+  // or to replace it with a fallback socket which is still connecting. In these cases ignore read
+  // event processing.
+  if (fd_ != -1 && !(state_ & InternalState::Connecting) &&
+      (events & Event::FileReadyType::Read)) {
     onReadReady();
   }
 }
@@ -418,9 +543,17 @@ void ConnectionImpl::onReadReady() {
 
   ASSERT(!(state_ & InternalState::Connecting));
 
+  if (splice_peer_ != nullptr) {
+    onSpliceReadReady();
+    return;
+  }
+
   IoResult result = transport_socket_->doRead(read_buffer_);
   uint64_t new_buffer_size = read_buffer_.length();
   updateReadBufferStats(result.bytes_processed_, new_buffer_size);
+  if (connection_stats_ && connection_stats_->read_syscalls_ && result.num_syscalls_ > 0) {
+    connection_stats_->read_syscalls_->add(result.num_syscalls_);
+  }
   onRead(new_buffer_size);
 
   // The read callback may have already closed the connection.
@@ -443,6 +576,7 @@ void ConnectionImpl::onWriteReady() {
     if (error == 0) {
       ENVOY_CONN_LOG(debug, "connected", *this);
       state_ &= ~InternalState::Connecting;
+      cancelFallbackConnect();
       transport_socket_->onConnected();
       // It's possible that we closed during the connect callback.
       if (state() != State::Open) {
@@ -451,14 +585,27 @@ void ConnectionImpl::onWriteReady() {
       }
     } else {
       ENVOY_CONN_LOG(debug, "delayed connection error: {}", *this, error);
+      if (useFallbackOnConnectError()) {
+        return;
+      }
       closeSocket(ConnectionEvent::RemoteClose);
       return;
     }
   }
 
   IoResult result = transport_socket_->doWrite(*write_buffer_);
-  uint64_t new_buffer_size = write_buffer_->length();
+  if (splice_pipe_ && result.action_ == PostIoAction::KeepOpen && write_buffer_->length() == 0) {
+    // Data written before splicing started goes out first.
+    IoResult splice_result = doWriteSplicePipe();
+    result.action_ = splice_result.action_;
+    result.bytes_processed_ += splice_result.bytes_processed_;
+    result.num_syscalls_ += splice_result.num_syscalls_;
+  }
+  uint64_t new_buffer_size = write_buffer_->length() + (splice_pipe_ ? splice_pipe_->length() : 0);
   updateWriteBufferStats(result.bytes_processed_, new_buffer_size);
+  if (connection_stats_ && connection_stats_->write_syscalls_ && result.num_syscalls_ > 0) {
+    connection_stats_->write_syscalls_->add(result.num_syscalls_);
+  }
 
   if (result.action_ == PostIoAction::Close) {
     // It is possible (though unlikely) for the connection to have already been closed during the
@@ -471,6 +618,164 @@ void ConnectionImpl::onWriteReady() {
   }
 }
 
+bool ConnectionImpl::spliceTo(Connection& peer, SpliceCb cb) {
+  ConnectionImpl* peer_impl = dynamic_cast<ConnectionImpl*>(&peer);
+  if (peer_impl == nullptr || peer_impl == this || splice_peer_ || peer_impl->splice_source_ ||
+      !canSplice() || !peer_impl->canSplice() || (peer_impl->state_ & InternalState::Connecting)) {
+    return false;
+  }
+
+  // The data bypasses the filters it would otherwise go through, so there must not be any other
+  // than the caller's. Data already read must go through the filters too.
+  if (filter_manager_.numReadFilters() > 1 || peer_impl->filter_manager_.hasWriteFilters() ||
+      read_buffer_.length() > 0) {
+    return false;
+  }
+
+  SplicePipePtr pipe = SplicePipe::create();
+  if (!pipe) {
+    return false;
+  }
+
+  ENVOY_CONN_LOG(debug, "splicing to [C{}]", *this, peer_impl->id());
+  peer_impl->splice_pipe_ = std::move(pipe);
+  peer_impl->splice_source_ = this;
+  splice_peer_ = peer_impl;
+  splice_cb_ = cb;
+
+  // There may be data waiting in the socket already, which won't raise another read event.
+  if (readEnabled()) {
+    file_event_->activate(Event::FileReadyType::Read);
+  }
+  return true;
+}
+
+bool ConnectionImpl::canSplice() const {
+  return state() == State::Open && ssl() == nullptr &&
+         dynamic_cast<RawBufferSocket*>(transport_socket_.get()) != nullptr;
+}
+
+void ConnectionImpl::onSpliceReadReady() {
+  // Unlike data read into the read buffer, spliced data can be left in the socket until reads are
+  // enabled again.
+  if (!(state_ & InternalState::ReadEnabled)) {
+    return;
+  }
+
+  SplicePipe& pipe = *splice_peer_->splice_pipe_;
+  uint64_t bytes_read = 0;
+  uint64_t num_syscalls = 0;
+  PostIoAction action = PostIoAction::KeepOpen;
+  while (!pipe.full()) {
+    const ssize_t rc = pipe.fill(fd_);
+    num_syscalls++;
+    if (rc == 0) {
+      action = PostIoAction::Close;
+      break;
+    }
+
+    if (rc < 0) {
+      if (errno != EAGAIN) {
+        ENVOY_CONN_LOG(trace, "splice error: {}", *this, errno);
+        action = PostIoAction::Close;
+      } else if (pipe.length() > 0) {
+        // The pipe can also fill up before it holds its capacity in bytes, in which case splice()
+        // fails with EAGAIN while the socket still has data. No further read event would be raised
+        // for that data, so wait for the pipe to drain instead.
+        int pending = 0;
+        if (ioctl(fd_, FIONREAD, &pending) == 0 && pending > 0) {
+          splice_read_paused_ = true;
+        }
+      }
+      break;
+    }
+
+    bytes_read += rc;
+  }
+
+  if (pipe.full()) {
+    splice_read_paused_ = true;
+  }
+
+  ENVOY_CONN_LOG(trace, "spliced {} bytes", *this, bytes_read);
+  updateReadBufferStats(bytes_read, read_buffer_.length());
+  if (connection_stats_ && connection_stats_->read_syscalls_) {
+    connection_stats_->read_syscalls_->add(num_syscalls);
+  }
+
+  if (bytes_read > 0) {
+    splice_cb_(bytes_read);
+    splice_peer_->file_event_->activate(Event::FileReadyType::Write);
+  }
+
+  if (action == PostIoAction::Close) {
+    ENVOY_CONN_LOG(debug, "remote close", *this);
+    closeSocket(ConnectionEvent::RemoteClose);
+  } else if (splice_read_paused_) {
+    ENVOY_CONN_LOG(trace, "splice pipe full, disabling reads", *this);
+    readDisable(true);
+  }
+}
+
+IoResult ConnectionImpl::doWriteSplicePipe() {
+  uint64_t bytes_written = 0;
+  uint64_t num_syscalls = 0;
+  PostIoAction action = PostIoAction::KeepOpen;
+  while (splice_pipe_->length() > 0) {
+    const ssize_t rc = splice_pipe_->drain(fd_);
+    num_syscalls++;
+    if (rc < 0) {
+      if (errno != EAGAIN) {
+        ENVOY_CONN_LOG(trace, "splice error: {}", *this, errno);
+        action = PostIoAction::Close;
+      }
+      break;
+    }
+
+    bytes_written += rc;
+  }
+
+  ENVOY_CONN_LOG(trace, "spliced {} bytes to socket", *this, bytes_written);
+  if (bytes_written > 0 && splice_source_ != nullptr) {
+    splice_source_->resumeSpliceReads();
+  }
+  return {action, bytes_written, num_syscalls};
+}
+
+void ConnectionImpl::resumeSpliceReads() {
+  if (!splice_read_paused_) {
+    return;
+  }
+
+  splice_read_paused_ = false;
+  if (state() != State::Open) {
+    return;
+  }
+
+  ENVOY_CONN_LOG(trace, "enabling reads paused for splicing", *this);
+  readDisable(false);
+  // The data left in the socket won't raise another read event.
+  if (readEnabled()) {
+    file_event_->activate(Event::FileReadyType::Read);
+  }
+}
+
+void ConnectionImpl::stopSplicing() {
+  if (splice_peer_ != nullptr) {
+    splice_peer_->splice_source_ = nullptr;
+    splice_peer_ = nullptr;
+  }
+
+  if (splice_source_ != nullptr) {
+    // Data read from the source goes through its read filters again.
+    ConnectionImpl& source = *splice_source_;
+    splice_source_ = nullptr;
+    source.splice_peer_ = nullptr;
+    source.resumeSpliceReads();
+  }
+  splice_pipe_.reset();
+}
+
 void ConnectionImpl::doConnect() {
   ENVOY_CONN_LOG(debug, "connecting to {}", *this, remote_address_->asString());
   int rc = remote_address_->connect(fd_);
@@ -495,6 +800,134 @@ void ConnectionImpl::doConnect() {
   if (remote_address_->type() == Address::Type::Ip) {
     local_address_ = Address::addressFromFd(fd_);
   }
+
+  if (fallback_address_ && (state_ & InternalState::Connecting)) {
+    fallback_timer_ = dispatcher_.createTimer([this]() -> void { startFallbackConnect(); });
+    fallback_timer_->enableTimer(fallback_delay_);
+  }
+}
+
+void ConnectionImpl::doSetFallbackAddress(Address::InstanceConstSharedPtr address,
+                                          std::chrono::milliseconds delay) {
+  ASSERT(state_ & InternalState::Connecting);
+  // A socket of the other IP version can't bind to the source address.
+  if (bind_to_address_ != nullptr &&
+      (bind_to_address_->type() != Address::Type::Ip || address->type() != Address::Type::Ip ||
+       bind_to_address_->ip()->version() != address->ip()->version())) {
+    ENVOY_CONN_LOG(debug, "ignoring fallback {} of another IP version than the source address",
+                   *this, address->asString());
+    return;
+  }
+  fallback_address_ = address;
+  fallback_delay_ = delay;
+}
+
+void ConnectionImpl::startFallbackConnect() {
+  ENVOY_CONN_LOG(debug, "connecting to fallback {}", *this, fallback_address_->asString());
+  const int fd = fallback_address_->socket(Address::SocketType::Stream);
+  if (fd == -1 || (bind_to_address_ != nullptr && bind_to_address_->bind(fd) < 0) ||
+      (fallback_address_->connect(fd) < 0 && errno != EINPROGRESS)) {
+    ENVOY_CONN_LOG(debug, "fallback connection error: {}", *this, errno);
+    if (fd != -1) {
+      ::close(fd);
+    }
+    fallback_address_ = nullptr;
+    return;
+  }
+
+  fallback_fd_ = fd;
+  fallback_file_event_ = dispatcher_.createFileEvent(
+      fallback_fd_, [this](uint32_t) -> void { onFallbackWriteReady(); },
+      Event::FileTriggerType::Edge, Event::FileReadyType::Write);
+}
+
+void ConnectionImpl::onFallbackWriteReady() {
+  int error;
+  socklen_t error_size = sizeof(error);
+  int rc = getsockopt(fallback_fd_, SOL_SOCKET, SO_ERROR, &error, &error_size);
+  ASSERT(0 == rc);
+  UNREFERENCED_PARAMETER(rc);
+
+  if (error != 0) {
+    ENVOY_CONN_LOG(debug, "delayed fallback connection error: {}", *this, error);
+    cancelFallbackConnect();
+    return;
+  }
+
+  // The fallback connect completed first. The socket reports it as writable once more when
+  // registered in place of the one still connecting, which completes the connect as usual.
+  ENVOY_CONN_LOG(debug, "fallback connected first", *this);
+  useFallbackSocket();
+}
+
+bool ConnectionImpl::useFallbackOnConnectError() {
+  if (fallback_address_ == nullptr) {
+    return false;
+  }
+  if (fallback_fd_ == -1) {
+    if (fallback_timer_) {
+      fallback_timer_->disableTimer();
+    }
+    startFallbackConnect();
+    if (fallback_fd_ == -1) {
+      return false;
+    }
+  }
+
+  ENVOY_CONN_LOG(debug, "connection error, continuing with fallback", *this);
+  useFallbackSocket();
+  return true;
+}
+
+void ConnectionImpl::useFallbackSocket() {
+  ASSERT(fallback_fd_ != -1);
+  // The fallback socket is duplicated onto the fd of the connection, as the transport socket may
+  // have taken note of it. This closes the socket which lost the race.
+  file_event_.reset();
+  fallback_file_event_.reset();
+  const int rc = dup2(fallback_fd_, fd_);
+  RELEASE_ASSERT(rc == fd_);
+  ::close(fallback_fd_);
+  fallback_fd_ = -1;
+  if (fallback_timer_) {
+    fallback_timer_->disableTimer();
+  }
+  remote_address_ = fallback_address_;
+  fallback_address_ = nullptr;
+
+  state_ &= ~InternalState::ImmediateConnectionError;
+  state_ |= InternalState::Connecting;
+  if (remote_address_->type() == Address::Type::Ip) {
+    local_address_ = Address::addressFromFd(fd_);
+  }
+  file_event_ = dispatcher_.createFileEvent(
+      fd_, [this](uint32_t events) -> void { onFileEvent(events); }, Event::FileTriggerType::Edge,
+      Event::FileReadyType::Read | Event::FileReadyType::Write);
+  if (!(state_ & InternalState::ReadEnabled)) {
+    if (detect_early_close_) {
+      file_event_->setEnabled(Event::FileReadyType::Write | Event::FileReadyType::Closed);
+    } else {
+      file_event_->setEnabled(Event::FileReadyType::Write);
+    }
+  }
+  if (no_delay_) {
+    noDelay(true);
+  }
+  if (tcp_notsent_lowat_ > 0) {
+    setNotSentLowat();
+  }
+}
+
+void ConnectionImpl::cancelFallbackConnect() {
+  if (fallback_timer_) {
+    fallback_timer_->disableTimer();
+  }
+  if (fallback_fd_ != -1) {
+    fallback_file_event_.reset();
+    ::close(fallback_fd_);
+    fallback_fd_ = -1;
+  }
+  fallback_address_ = nullptr;
 }
 
 void ConnectionImpl::setConnectionStats(const ConnectionStats& stats) {
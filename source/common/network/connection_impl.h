@@ -1,12 +1,14 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <list>
 #include <memory>
 #include <string>
 
 #include "envoy/common/optional.h"
+#include "envoy/event/timer.h"
 #include "envoy/network/connection.h"
 #include "envoy/network/transport_socket.h"
 
@@ -38,6 +40,54 @@ public:
                                 Stats::Counter& stat_total, Stats::Gauge& stat_current);
 };
 
+/**
+ * A non-blocking pipe which holds data spliced from one socket until it is spliced into another.
+ */
+class SplicePipe {
+public:
+  ~SplicePipe();
+
+  /**
+   * @return std::unique_ptr<SplicePipe> a new pipe, or nullptr if splicing is not supported or the
+   *         pipe could not be created.
+   */
+  static std::unique_ptr<SplicePipe> create();
+
+  /**
+   * Splice data from a socket into the free space of the pipe.
+   * @param fd supplies the socket to read from.
+   * @return ssize_t the result of splice().
+   */
+  ssize_t fill(int fd);
+
+  /**
+   * Splice data from the pipe into a socket.
+   * @param fd supplies the socket to write to.
+   * @return ssize_t the result of splice().
+   */
+  ssize_t drain(int fd);
+
+  /**
+   * @return uint64_t the number of bytes in the pipe.
+   */
+  uint64_t length() const { return length_; }
+
+  /**
+   * @return bool whether the pipe is full.
+   */
+  bool full() const { return length_ >= capacity_; }
+
+private:
+  SplicePipe(int read_fd, int write_fd, uint64_t capacity);
+
+  const int read_fd_;
+  const int write_fd_;
+  const uint64_t capacity_;
+  uint64_t length_{};
+};
+
+typedef std::unique_ptr<SplicePipe> SplicePipePtr;
+
 /**
  * Implementation of Network::Connection.
  */
@@ -61,6 +111,24 @@ public:
 
   ~ConnectionImpl();
 
+  /**
+   * Select whether connections coalesce writes. With coalescing, data written to a connection is
+   * flushed to the socket at the end of the event loop iteration instead of as soon as possible, so
+   * that several small writes made while handling events go out in one system call. This is
+   * intended to be called once at startup, before any connections exist.
+   * @param coalesce_writes supplies whether to coalesce writes.
+   */
+  static void coalesceWrites(bool coalesce_writes);
+
+  /**
+   * Set TCP_NOTSENT_LOWAT on the TCP connections created after this call. The kernel then only
+   * reports a socket as writable once less than this many bytes are waiting to be sent, so that
+   * data stays in the write buffer, where it can still be coalesced, rather than queueing in the
+   * kernel. This is intended to be called once at startup, before any connections exist.
+   * @param bytes supplies the low watermark, or 0 to leave the system default.
+   */
+  static void tcpNotSentLowat(uint32_t bytes);
+
   // Network::FilterManager
   void addWriteFilter(WriteFilterSharedPtr filter) override;
   void addFilter(FilterSharedPtr filter) override;
@@ -86,8 +154,11 @@ public:
   void write(Buffer::Instance& data) override;
   void setBufferLimits(uint32_t limit) override;
   uint32_t bufferLimit() const override { return read_buffer_limit_; }
+  void setBufferAccount(Buffer::AccountSharedPtr account) override;
+  const Buffer::AccountSharedPtr& bufferAccount() const override { return buffer_account_; }
   bool usingOriginalDst() const override { return using_original_dst_; }
   bool aboveHighWatermark() const override { return above_high_watermark_; }
+  bool spliceTo(Connection& peer, SpliceCb cb) override;
 
   // Network::BufferSource
   Buffer::Instance& getReadBuffer() override { return read_buffer_; }
@@ -111,6 +182,8 @@ public:
 protected:
   void closeSocket(ConnectionEvent close_type);
   void doConnect();
+  void doSetFallbackAddress(Address::InstanceConstSharedPtr address,
+                            std::chrono::milliseconds delay);
 
   void onLowWatermark();
   void onHighWatermark();
@@ -123,6 +196,7 @@ protected:
   // a generic pointer.
   Buffer::InstancePtr write_buffer_;
   uint32_t read_buffer_limit_ = 0;
+  Buffer::AccountSharedPtr buffer_account_;
   TransportSocketPtr transport_socket_;
 
 private:
@@ -140,10 +214,24 @@ private:
   void onRead(uint64_t read_buffer_size);
   void onReadReady();
   void onWriteReady();
+  void scheduleWrite();
+  void setNotSentLowat();
+  bool canSplice() const;
+  void onSpliceReadReady();
+  IoResult doWriteSplicePipe();
+  void resumeSpliceReads();
+  void stopSplicing();
+  void startFallbackConnect();
+  void onFallbackWriteReady();
+  bool useFallbackOnConnectError();
+  void useFallbackSocket();
+  void cancelFallbackConnect();
   void updateReadBufferStats(uint64_t num_read, uint64_t new_size);
   void updateWriteBufferStats(uint64_t num_written, uint64_t new_size);
 
   static std::atomic<uint64_t> next_global_id_;
+  static bool coalesce_writes_;
+  static uint32_t tcp_notsent_lowat_;
 
   Event::DispatcherImpl& dispatcher_;
   int fd_{-1};
@@ -162,6 +250,27 @@ private:
   const bool using_original_dst_;
   bool above_high_watermark_{false};
   bool detect_early_close_{true};
+  // Flushes coalesced writes at the end of the event loop iteration. Created on the first write.
+  Event::TimerPtr write_flush_timer_;
+  bool write_flush_pending_{};
+  // While splicing, data read from this connection is moved through the pipe of splice_peer_. The
+  // peer is cleared once either connection closes.
+  ConnectionImpl* splice_peer_{};
+  SpliceCb splice_cb_;
+  // Whether reads are disabled because the pipe to splice_peer_ is full.
+  bool splice_read_paused_{};
+  // Connection whose data is spliced to this one, and the pipe holding the data not written yet.
+  ConnectionImpl* splice_source_{};
+  SplicePipePtr splice_pipe_;
+  const Address::InstanceConstSharedPtr bind_to_address_;
+  bool no_delay_{};
+  // Address raced against remote_address_ while connecting, once fallback_timer_ fires or the
+  // first connect fails, and the socket of that connect while it is in progress.
+  Address::InstanceConstSharedPtr fallback_address_;
+  std::chrono::milliseconds fallback_delay_{};
+  Event::TimerPtr fallback_timer_;
+  int fallback_fd_{-1};
+  Event::FileEventPtr fallback_file_event_;
 };
 
 /**
@@ -175,6 +284,10 @@ public:
 
   // Network::ClientConnection
   void connect() override { doConnect(); }
+  void setFallbackAddress(Address::InstanceConstSharedPtr address,
+                          std::chrono::milliseconds delay) override {
+    doSetFallbackAddress(address, delay);
+  }
 };
 
 } // namespace Network
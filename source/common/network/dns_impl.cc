@@ -59,19 +59,21 @@ void DnsResolverImpl::initializeChannel(ares_options* options, int optmask) {
   ares_init_options(&channel_, options, optmask | ARES_OPT_SOCK_STATE_CB);
 }
 
-void DnsResolverImpl::PendingResolution::onAresHostCallback(int status, int timeouts,
-                                                            hostent* hostent) {
+void DnsResolverImpl::PendingResolution::onAresHostCallback(int family, int status,
+                                                            int timeouts, hostent* hostent) {
+  ASSERT(pending_queries_ > 0);
+  --pending_queries_;
   // We receive ARES_EDESTRUCTION when destructing with pending queries.
   if (status == ARES_EDESTRUCTION) {
     ASSERT(owned_);
-    delete this;
+    if (pending_queries_ == 0) {
+      delete this;
+    }
     return;
   }
-  if (status == ARES_SUCCESS || !fallback_if_failed_) {
-    completed_ = true;
-  }
 
-  std::list<Address::InstanceConstSharedPtr> address_list;
+  std::list<Address::InstanceConstSharedPtr>& address_list =
+      family == AF_INET ? v4_addresses_ : v6_addresses_;
   if (status == ARES_SUCCESS) {
     if (hostent->h_addrtype == AF_INET) {
       for (int i = 0; hostent->h_addr_list[i] != nullptr; ++i) {
@@ -100,23 +102,37 @@ void DnsResolverImpl::PendingResolution::onAresHostCallback(int status, int time
     ENVOY_LOG(debug, "DNS request timed out {} times", timeouts);
   }
 
-  if (completed_) {
-    if (!cancelled_) {
-      callback_(std::move(address_list));
-    }
-    if (owned_) {
+  if (completed_ || !answered()) {
+    // The last query of a resolution which completed without it.
+    if (completed_ && pending_queries_ == 0 && owned_) {
       delete this;
-      return;
     }
+    return;
   }
 
-  if (status != ARES_SUCCESS && fallback_if_failed_) {
-    fallback_if_failed_ = false;
-    getHostByName(AF_INET);
-    // Note: Nothing can follow this call to getHostByName due to deletion of this
-    // object upon synchronous resolution.
-    return;
+  completed_ = true;
+  // With a query outstanding, this is deleted once it completes, which may be during the callback
+  // if it destroys the resolver, so nothing can follow the callback.
+  const bool delete_after_callback = owned_ && pending_queries_ == 0;
+  if (!cancelled_) {
+    std::list<Address::InstanceConstSharedPtr> addresses;
+    if (dns_lookup_family_ != DnsLookupFamily::Auto || !v6_addresses_.empty()) {
+      addresses.splice(addresses.end(), v6_addresses_);
+    }
+    if (dns_lookup_family_ != DnsLookupFamily::Auto || addresses.empty()) {
+      addresses.splice(addresses.end(), v4_addresses_);
+    }
+    callback_(std::move(addresses));
   }
+  if (delete_after_callback) {
+    delete this;
+  }
+}
+
+bool DnsResolverImpl::PendingResolution::answered() const {
+  // Auto completes as soon as there are IPv6 addresses, without waiting for the IPv4 query.
+  return pending_queries_ == 0 ||
+         (dns_lookup_family_ == DnsLookupFamily::Auto && !v6_addresses_.empty());
 }
 
 void DnsResolverImpl::updateAresTimer() {
@@ -167,39 +183,62 @@ ActiveDnsQuery* DnsResolverImpl::resolve(const std::string& dns_name,
   // failed intial call to getHostbyName followed by a synchronous IPv4
   // resolution.
   std::unique_ptr<PendingResolution> pending_resolution(
-      new PendingResolution(callback, channel_, dns_name));
-  if (dns_lookup_family == DnsLookupFamily::Auto) {
-    pending_resolution->fallback_if_failed_ = true;
-  }
+      new PendingResolution(callback, channel_, dns_name, dns_lookup_family));
 
-  if (dns_lookup_family == DnsLookupFamily::V4Only) {
+  // With both IP versions, the queries go out in parallel rather than falling back to IPv4 once
+  // IPv6 fails, so that a broken IPv6 path costs no resolution latency.
+  switch (dns_lookup_family) {
+  case DnsLookupFamily::V4Only:
+    pending_resolution->pending_queries_ = 1;
     pending_resolution->getHostByName(AF_INET);
-  } else {
+    break;
+  case DnsLookupFamily::V6Only:
+    pending_resolution->pending_queries_ = 1;
     pending_resolution->getHostByName(AF_INET6);
+    break;
+  case DnsLookupFamily::Auto:
+  case DnsLookupFamily::All:
+    pending_resolution->pending_queries_ = 2;
+    pending_resolution->getHostByName(AF_INET6);
+    if (pending_resolution->completed_) {
+      // Answered synchronously, e.g. a localhost lookup.
+      pending_resolution->pending_queries_ = 0;
+    } else {
+      pending_resolution->getHostByName(AF_INET);
+    }
+    break;
   }
 
   if (pending_resolution->completed_) {
     // Resolution does not need asynchronous behavior or network events. For
     // example, localhost lookup.
     return nullptr;
-  } else {
-    // Enable timer to wake us up if the request times out.
-    updateAresTimer();
-
-    // The PendingResolution will self-delete when the request completes
-    // (including if cancelled or if ~DnsResolverImpl() happens).
-    pending_resolution->owned_ = true;
-    return pending_resolution.release();
   }
+
+  // Enable timer to wake us up if the request times out.
+  updateAresTimer();
+
+  // The PendingResolution will self-delete when the request completes
+  // (including if cancelled or if ~DnsResolverImpl() happens).
+  pending_resolution->owned_ = true;
+  return pending_resolution.release();
 }
 
 void DnsResolverImpl::PendingResolution::getHostByName(int family) {
-  ares_gethostbyname(channel_, dns_name_.c_str(), family,
-                     [](void* arg, int status, int timeouts, hostent* hostent) {
-                       static_cast<PendingResolution*>(arg)->onAresHostCallback(status, timeouts,
-                                                                                hostent);
-                     },
-                     this);
+  // The family is not in the hostent of a failed query, so each family gets its own callback.
+  ares_host_callback callback;
+  if (family == AF_INET) {
+    callback = [](void* arg, int status, int timeouts, hostent* hostent) {
+      static_cast<PendingResolution*>(arg)->onAresHostCallback(AF_INET, status, timeouts,
+                                                               hostent);
+    };
+  } else {
+    callback = [](void* arg, int status, int timeouts, hostent* hostent) {
+      static_cast<PendingResolution*>(arg)->onAresHostCallback(AF_INET6, status, timeouts,
+                                                               hostent);
+    };
+  }
+  ares_gethostbyname(channel_, dns_name_.c_str(), family, callback, this);
 }
 
 } // namespace Network
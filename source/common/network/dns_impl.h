@@ -3,6 +3,7 @@
 #include <netdb.h>
 
 #include <cstdint>
+#include <list>
 #include <string>
 #include <unordered_map>
 
@@ -39,8 +40,10 @@ private:
   friend class DnsResolverImplPeer;
   struct PendingResolution : public ActiveDnsQuery {
     // Network::ActiveDnsQuery
-    PendingResolution(ResolveCb callback, ares_channel channel, const std::string& dns_name)
-        : callback_(callback), channel_(channel), dns_name_(dns_name) {}
+    PendingResolution(ResolveCb callback, ares_channel channel, const std::string& dns_name,
+                      DnsLookupFamily dns_lookup_family)
+        : callback_(callback), channel_(channel), dns_name_(dns_name),
+          dns_lookup_family_(dns_lookup_family) {}
 
     void cancel() override {
       // c-ares only supports channel-wide cancellation, so we just allow the
@@ -50,31 +53,40 @@ private:
 
     /**
      * c-ares ares_gethostbyname() query callback.
+     * @param family the address family of the query.
      * @param status return status of call to ares_gethostbyname.
      * @param timeouts the number of times the request timed out.
      * @param hostent structure that stores information about a given host.
      */
-    void onAresHostCallback(int status, int timeouts, hostent* hostent);
+    void onAresHostCallback(int family, int status, int timeouts, hostent* hostent);
     /**
      * wrapper function of call to ares_gethostbyname.
      * @param family currently AF_INET and AF_INET6 are supported.
      */
     void getHostByName(int family);
+    /**
+     * @return bool whether the answers received so far complete the resolution.
+     */
+    bool answered() const;
 
     // Caller supplied callback to invoke on query completion or error.
     const ResolveCb callback_;
     // Does the object own itself? Resource reclamation occurs via self-deleting
     // on query completion or error.
     bool owned_ = false;
-    // Has the query completed? Only meaningful if !owned_;
+    // Has the callback been invoked, or would it have been if not cancelled? The object lives on
+    // until the queries still outstanding complete.
     bool completed_ = false;
     // Was the query cancelled via cancel()?
     bool cancelled_ = false;
-    // If dns_lookup_family is "fallback", fallback to v4 address if v6
-    // resolution failed.
-    bool fallback_if_failed_ = false;
+    // Number of ares_gethostbyname() queries outstanding. Both IP versions are queried in parallel
+    // for Auto and All.
+    uint32_t pending_queries_ = 0;
     const ares_channel channel_;
     const std::string dns_name_;
+    const DnsLookupFamily dns_lookup_family_;
+    std::list<Address::InstanceConstSharedPtr> v4_addresses_;
+    std::list<Address::InstanceConstSharedPtr> v6_addresses_;
   };
 
   // Callback for events on sockets tracked in events_.
@@ -43,6 +43,8 @@ public:
   bool initializeReadFilters();
   void onRead();
   FilterStatus onWrite();
+  uint64_t numReadFilters() const { return upstream_filters_.size(); }
+  bool hasWriteFilters() const { return !downstream_filters_.empty(); }
 
 private:
   struct ActiveReadFilter : public ReadFilterCallbacks, LinkedObject<ActiveReadFilter> {
@@ -0,0 +1,404 @@
+#include "common/network/lc_trie.h"
+
+#include <arpa/inet.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Network {
+
+namespace {
+
+const std::vector<std::string>& noTags() {
+  static const std::vector<std::string>* no_tags = new std::vector<std::string>();
+  return *no_tags;
+}
+
+} // namespace
+
+/**
+ * IPv6 address in host byte order, split in two as there is no uint128_t.
+ */
+struct LcTrie::Ipv6Key {
+  static Ipv6Key fromBytes(const uint8_t* bytes) {
+    Ipv6Key key{0, 0};
+    for (uint32_t i = 0; i < 8; i++) {
+      key.high_ = (key.high_ << 8) | bytes[i];
+      key.low_ = (key.low_ << 8) | bytes[i + 8];
+    }
+    return key;
+  }
+
+  uint64_t high_;
+  uint64_t low_;
+};
+
+/**
+ * Trie of the addresses of one IP version.
+ *
+ * The nested ranges are first pushed down a binary trie until its leaves are disjoint ranges which
+ * carry the tags of all the ranges they are in. The LC-trie is then built over the sorted leaves:
+ * each node skips the bits that all the leaves below it share, and branches on as many of the next
+ * bits as keep at least half of its children in use. A leaf shorter than the bits a node branches
+ * on is the child of all the branches it covers, and unused branches point at any leaf. A lookup
+ * thus walks down to the only leaf which may contain the address, and a final comparison with
+ * the range of that leaf tells whether it does.
+ */
+template <class IpType> class LcTrie::Trie {
+public:
+  /**
+   * @param ranges supplies the ranges, as their truncated address and length, with the index of
+   *        their tag.
+   * @param tags supplies the tags.
+   */
+  Trie(const std::vector<std::pair<std::pair<IpType, uint32_t>, uint32_t>>& ranges,
+       const std::vector<std::string>& tags);
+
+  const std::vector<std::string>& getTags(const IpType& address) const;
+
+  static uint32_t bits();
+  // The n bits of key starting at bit pos, with bit 0 the most significant one. n is between 1
+  // and 32, and pos + n is at most bits().
+  static uint32_t extractBits(const IpType& key, uint32_t pos, uint32_t n);
+  // The number of leading bits that a and b share.
+  static uint32_t commonPrefix(const IpType& a, const IpType& b);
+  static IpType setBit(const IpType& key, uint32_t pos);
+
+private:
+  // Maximum number of bits a node branches on.
+  static const uint32_t MAX_BRANCH = 16;
+
+  struct BuildNode {
+    std::unique_ptr<BuildNode> children_[2];
+    // Indices of the tags of the range ending at this node, if any.
+    std::vector<uint32_t> tags_;
+  };
+
+  struct Leaf {
+    IpType prefix_;
+    uint32_t length_;
+    uint32_t tag_set_;
+  };
+
+  struct Node {
+    // Number of bits branched on, or 0 for a leaf.
+    uint8_t branch_;
+    // Number of bits skipped before branching.
+    uint8_t skip_;
+    // Index of the first child in nodes_, or of the leaf in leaves_.
+    uint32_t address_;
+  };
+
+  void pushLeaves(const BuildNode& node, const IpType& prefix, uint32_t length,
+                  std::vector<uint32_t> tags,
+                  std::map<std::vector<uint32_t>, uint32_t>& tag_set_indices,
+                  const std::vector<std::string>& tag_names);
+  void addLeaf(const IpType& prefix, uint32_t length, const std::vector<uint32_t>& tags,
+               std::map<std::vector<uint32_t>, uint32_t>& tag_set_indices,
+               const std::vector<std::string>& tag_names);
+  void buildNode(const std::vector<uint32_t>& group, uint32_t pos, uint32_t node_index);
+  uint32_t chooseBranch(const std::vector<uint32_t>& group, uint32_t pos) const;
+  std::pair<uint32_t, uint32_t> branchRange(const Leaf& leaf, uint32_t pos,
+                                            uint32_t branch) const;
+  static bool contains(const Leaf& leaf, const IpType& address) {
+    return leaf.length_ == 0 || commonPrefix(leaf.prefix_, address) >= leaf.length_;
+  }
+
+  std::vector<Node> nodes_;
+  std::vector<Leaf> leaves_;
+  std::vector<std::vector<std::string>> tag_sets_;
+};
+
+template <> uint32_t LcTrie::Trie<uint32_t>::bits() { return 32; }
+
+template <>
+uint32_t LcTrie::Trie<uint32_t>::extractBits(const uint32_t& key, uint32_t pos, uint32_t n) {
+  ASSERT(n >= 1 && n <= 32 && pos + n <= 32);
+  return (key << pos) >> (32 - n);
+}
+
+template <> uint32_t LcTrie::Trie<uint32_t>::commonPrefix(const uint32_t& a, const uint32_t& b) {
+  return a == b ? 32 : __builtin_clz(a ^ b);
+}
+
+template <> uint32_t LcTrie::Trie<uint32_t>::setBit(const uint32_t& key, uint32_t pos) {
+  return key | (0x80000000U >> pos);
+}
+
+template <> uint32_t LcTrie::Trie<LcTrie::Ipv6Key>::bits() { return 128; }
+
+template <>
+uint32_t LcTrie::Trie<LcTrie::Ipv6Key>::extractBits(const Ipv6Key& key, uint32_t pos,
+                                                    uint32_t n) {
+  ASSERT(n >= 1 && n <= 32 && pos + n <= 128);
+  // The 64 bits starting at pos, padded with zeroes past the end of the address.
+  uint64_t window;
+  if (pos == 0) {
+    window = key.high_;
+  } else if (pos < 64) {
+    window = (key.high_ << pos) | (key.low_ >> (64 - pos));
+  } else {
+    window = key.low_ << (pos - 64);
+  }
+  return static_cast<uint32_t>(window >> (64 - n));
+}
+
+template <>
+uint32_t LcTrie::Trie<LcTrie::Ipv6Key>::commonPrefix(const Ipv6Key& a, const Ipv6Key& b) {
+  if (a.high_ != b.high_) {
+    return __builtin_clzll(a.high_ ^ b.high_);
+  }
+  return a.low_ == b.low_ ? 128 : 64 + __builtin_clzll(a.low_ ^ b.low_);
+}
+
+template <>
+LcTrie::Ipv6Key LcTrie::Trie<LcTrie::Ipv6Key>::setBit(const Ipv6Key& key, uint32_t pos) {
+  Ipv6Key result = key;
+  if (pos < 64) {
+    result.high_ |= 0x8000000000000000ULL >> pos;
+  } else {
+    result.low_ |= 0x8000000000000000ULL >> (pos - 64);
+  }
+  return result;
+}
+
+template <class IpType>
+LcTrie::Trie<IpType>::Trie(
+    const std::vector<std::pair<std::pair<IpType, uint32_t>, uint32_t>>& ranges,
+    const std::vector<std::string>& tags) {
+  BuildNode root;
+  for (const auto& range : ranges) {
+    BuildNode* node = &root;
+    for (uint32_t i = 0; i < range.first.second; i++) {
+      std::unique_ptr<BuildNode>& child = node->children_[extractBits(range.first.first, i, 1)];
+      if (child == nullptr) {
+        child.reset(new BuildNode());
+      }
+      node = child.get();
+    }
+    node->tags_.push_back(range.second);
+  }
+
+  std::map<std::vector<uint32_t>, uint32_t> tag_set_indices;
+  pushLeaves(root, IpType{}, 0, {}, tag_set_indices, tags);
+  if (leaves_.empty()) {
+    return;
+  }
+
+  std::vector<uint32_t> group(leaves_.size());
+  for (uint32_t i = 0; i < group.size(); i++) {
+    group[i] = i;
+  }
+  nodes_.resize(1);
+  buildNode(group, 0, 0);
+}
+
+template <class IpType>
+void LcTrie::Trie<IpType>::pushLeaves(const BuildNode& node, const IpType& prefix,
+                                      uint32_t length, std::vector<uint32_t> tags,
+                                      std::map<std::vector<uint32_t>, uint32_t>& tag_set_indices,
+                                      const std::vector<std::string>& tag_names) {
+  if (!node.tags_.empty()) {
+    tags.insert(tags.end(), node.tags_.begin(), node.tags_.end());
+    std::sort(tags.begin(), tags.end());
+    tags.erase(std::unique(tags.begin(), tags.end()), tags.end());
+  }
+
+  if (node.children_[0] == nullptr && node.children_[1] == nullptr) {
+    if (!tags.empty()) {
+      addLeaf(prefix, length, tags, tag_set_indices, tag_names);
+    }
+    return;
+  }
+
+  // The part of the range of this node which is not in the range of a child is a leaf of its own.
+  for (uint32_t bit = 0; bit < 2; bit++) {
+    const IpType child_prefix = bit == 0 ? prefix : setBit(prefix, length);
+    if (node.children_[bit] != nullptr) {
+      pushLeaves(*node.children_[bit], child_prefix, length + 1, tags, tag_set_indices,
+                 tag_names);
+    } else if (!tags.empty()) {
+      addLeaf(child_prefix, length + 1, tags, tag_set_indices, tag_names);
+    }
+  }
+}
+
+template <class IpType>
+void LcTrie::Trie<IpType>::addLeaf(const IpType& prefix, uint32_t length,
+                                   const std::vector<uint32_t>& tags,
+                                   std::map<std::vector<uint32_t>, uint32_t>& tag_set_indices,
+                                   const std::vector<std::string>& tag_names) {
+  auto it = tag_set_indices.find(tags);
+  if (it == tag_set_indices.end()) {
+    std::vector<std::string> tag_set;
+    for (uint32_t tag : tags) {
+      tag_set.push_back(tag_names[tag]);
+    }
+    it = tag_set_indices.emplace(tags, tag_sets_.size()).first;
+    tag_sets_.push_back(std::move(tag_set));
+  }
+  leaves_.push_back({prefix, length, it->second});
+}
+
+template <class IpType>
+void LcTrie::Trie<IpType>::buildNode(const std::vector<uint32_t>& group, uint32_t pos,
+                                     uint32_t node_index) {
+  ASSERT(!group.empty());
+  if (group.size() == 1) {
+    nodes_[node_index] = {0, 0, group[0]};
+    return;
+  }
+
+  // The leaves of a group are disjoint and sorted, so the bits shared by the first and the last
+  // one are shared by all of them, and are within the range of each of them.
+  const uint32_t skip =
+      commonPrefix(leaves_[group.front()].prefix_, leaves_[group.back()].prefix_) - pos;
+  pos += skip;
+  const uint32_t branch = chooseBranch(group, pos);
+
+  std::vector<std::vector<uint32_t>> children(1 << branch);
+  for (uint32_t leaf : group) {
+    const std::pair<uint32_t, uint32_t> range = branchRange(leaves_[leaf], pos, branch);
+    for (uint32_t child = range.first; child <= range.second; child++) {
+      children[child].push_back(leaf);
+    }
+  }
+
+  const uint32_t first_child = nodes_.size();
+  nodes_[node_index] = {static_cast<uint8_t>(branch), static_cast<uint8_t>(skip), first_child};
+  nodes_.resize(nodes_.size() + children.size());
+  for (uint32_t child = 0; child < children.size(); child++) {
+    if (children[child].empty()) {
+      // No leaf contains the addresses of this branch, so any leaf will fail the final check.
+      nodes_[first_child + child] = {0, 0, group[0]};
+    } else {
+      buildNode(children[child], pos + branch, first_child + child);
+    }
+  }
+}
+
+template <class IpType>
+uint32_t LcTrie::Trie<IpType>::chooseBranch(const std::vector<uint32_t>& group,
+                                            uint32_t pos) const {
+  uint32_t branch = 1;
+  const uint32_t max_branch = std::min(MAX_BRANCH, bits() - pos);
+  for (uint32_t candidate = 2; candidate <= max_branch; candidate++) {
+    // Count the branches which have a leaf. The leaves are sorted, so their ranges are too.
+    uint64_t used = 0;
+    int64_t last = -1;
+    for (uint32_t leaf : group) {
+      const std::pair<uint32_t, uint32_t> range = branchRange(leaves_[leaf], pos, candidate);
+      if (static_cast<int64_t>(range.second) > last) {
+        used += range.second - std::max<int64_t>(range.first, last + 1) + 1;
+        last = range.second;
+      }
+    }
+    if (used * 2 < (1ULL << candidate)) {
+      break;
+    }
+    branch = candidate;
+  }
+  return branch;
+}
+
+template <class IpType>
+std::pair<uint32_t, uint32_t> LcTrie::Trie<IpType>::branchRange(const Leaf& leaf, uint32_t pos,
+                                                                uint32_t branch) const {
+  // The prefix is zero past the length of the leaf, so a leaf shorter than pos + branch covers
+  // the branches which only differ from its own in the bits it doesn't have.
+  const uint32_t first = extractBits(leaf.prefix_, pos, branch);
+  if (leaf.length_ >= pos + branch) {
+    return {first, first};
+  }
+  ASSERT(leaf.length_ > pos);
+  return {first, first | ((1U << (pos + branch - leaf.length_)) - 1)};
+}
+
+template <class IpType>
+const std::vector<std::string>& LcTrie::Trie<IpType>::getTags(const IpType& address) const {
+  if (nodes_.empty()) {
+    return noTags();
+  }
+
+  const Node* node = &nodes_[0];
+  uint32_t pos = node->skip_;
+  while (node->branch_ != 0) {
+    const uint32_t branch = node->branch_;
+    node = &nodes_[node->address_ + extractBits(address, pos, branch)];
+    pos += branch + node->skip_;
+  }
+
+  const Leaf& leaf = leaves_[node->address_];
+  return contains(leaf, address) ? tag_sets_[leaf.tag_set_] : noTags();
+}
+
+LcTrie::LcTrie(
+    const std::vector<std::pair<std::string, std::vector<Address::CidrRange>>>& tag_data) {
+  std::vector<std::string> tags;
+  std::unordered_map<std::string, uint32_t> tag_indices;
+  std::vector<std::pair<std::pair<uint32_t, uint32_t>, uint32_t>> ipv4_ranges;
+  std::vector<std::pair<std::pair<Ipv6Key, uint32_t>, uint32_t>> ipv6_ranges;
+  for (const auto& tag : tag_data) {
+    auto it = tag_indices.find(tag.first);
+    if (it == tag_indices.end()) {
+      it = tag_indices.emplace(tag.first, tags.size()).first;
+      tags.push_back(tag.first);
+    }
+
+    for (const Address::CidrRange& range : tag.second) {
+      ASSERT(range.isValid());
+      const uint32_t length = range.length();
+      if (range.ip()->version() == Address::IpVersion::v4) {
+        ipv4_ranges.push_back({{ntohl(range.ip()->ipv4()->address()), length}, it->second});
+      } else {
+        const std::array<uint8_t, 16> bytes = range.ip()->ipv6()->address();
+        ipv6_ranges.push_back({{Ipv6Key::fromBytes(bytes.data()), length}, it->second});
+      }
+    }
+  }
+
+  ipv4_trie_.reset(new Trie<uint32_t>(ipv4_ranges, tags));
+  ipv6_trie_.reset(new Trie<Ipv6Key>(ipv6_ranges, tags));
+}
+
+LcTrie::~LcTrie() {}
+
+const std::vector<std::string>& LcTrie::getTags(const Address::Instance& address) const {
+  if (address.type() != Address::Type::Ip) {
+    return noTags();
+  }
+
+  const Address::Ip& ip = *address.ip();
+  if (ip.version() == Address::IpVersion::v4) {
+    return ipv4_trie_->getTags(ntohl(ip.ipv4()->address()));
+  }
+
+  const std::array<uint8_t, 16> bytes = ip.ipv6()->address();
+  return ipv6_trie_->getTags(Ipv6Key::fromBytes(bytes.data()));
+}
+
+const std::vector<std::string>& LcTrie::getTags(const std::string& address) const {
+  in_addr ipv4;
+  if (inet_pton(AF_INET, address.c_str(), &ipv4) == 1) {
+    return ipv4_trie_->getTags(ntohl(ipv4.s_addr));
+  }
+
+  in6_addr ipv6;
+  if (inet_pton(AF_INET6, address.c_str(), &ipv6) == 1) {
+    return ipv6_trie_->getTags(Ipv6Key::fromBytes(ipv6.s6_addr));
+  }
+  return noTags();
+}
+
+} // namespace Network
+} // namespace Envoy
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "envoy/network/address.h"
+
+#include "common/network/cidr_range.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * Level compressed trie which maps IP addresses to the tags of the CIDR ranges they are in, see
+ * "IP-address lookup using LC-tries" by S. Nilsson and G. Karlsson. The ranges may overlap or nest,
+ * in which case an address gets the tags of all the ranges it is in. Lookups take a few dependent
+ * loads, whatever the number of ranges, and don't allocate.
+ */
+class LcTrie {
+public:
+  /**
+   * @param tag_data supplies the tags, with the ranges of the addresses each of them applies to.
+   */
+  LcTrie(const std::vector<std::pair<std::string, std::vector<Address::CidrRange>>>& tag_data);
+  ~LcTrie();
+
+  /**
+   * @param address supplies the address to look up.
+   * @return const std::vector<std::string>& the tags of all the ranges the address is in, in the
+   *         order in which the tags were supplied. Addresses which are not IP addresses have no
+   *         tags.
+   */
+  const std::vector<std::string>& getTags(const Address::Instance& address) const;
+
+  /**
+   * @param address supplies the IPv4 or IPv6 address to look up, without a port.
+   * @return const std::vector<std::string>& the tags of all the ranges the address is in, or no
+   *         tags if the address is not a valid IP address.
+   */
+  const std::vector<std::string>& getTags(const std::string& address) const;
+
+private:
+  struct Ipv6Key;
+  template <class IpType> class Trie;
+
+  std::unique_ptr<Trie<uint32_t>> ipv4_trie_;
+  std::unique_ptr<Trie<Ipv6Key>> ipv6_trie_;
+};
+
+typedef std::unique_ptr<LcTrie> LcTriePtr;
+
+} // namespace Network
+} // namespace Envoy
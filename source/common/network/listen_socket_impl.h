@@ -40,11 +40,29 @@ protected:
 class TcpListenSocket : public ListenSocketImpl {
 public:
   TcpListenSocket(Address::InstanceConstSharedPtr address, bool bind_to_port);
+  /**
+   * @param reuse_port supplies whether to set SO_REUSEPORT before binding, which allows further
+   *        sockets with SO_REUSEPORT set to bind to the same address. The kernel then spreads
+   *        incoming connections over all of them.
+   */
+  TcpListenSocket(Address::InstanceConstSharedPtr address, bool bind_to_port, bool reuse_port);
   TcpListenSocket(int fd, Address::InstanceConstSharedPtr address);
 };
 
 typedef std::unique_ptr<TcpListenSocket> TcpListenSocketPtr;
 
+/**
+ * Wraps a bound datagram socket, for a UDP listener.
+ */
+class UdpListenSocket : public ListenSocketImpl {
+public:
+  /**
+   * @param reuse_port supplies whether to set SO_REUSEPORT before binding, so that each worker may
+   *        bind a socket of its own to the address. The kernel then spreads the peers over them.
+   */
+  UdpListenSocket(Address::InstanceConstSharedPtr address, bool reuse_port);
+};
+
 class UdsListenSocket : public ListenSocketImpl {
 public:
   UdsListenSocket(const std::string& uds_path);
@@ -2,10 +2,16 @@
 
 #include <sys/un.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
 #include "envoy/common/exception.h"
 #include "envoy/network/connection_handler.h"
 
 #include "common/common/empty_string.h"
+#include "common/common/utility.h"
 #include "common/event/dispatcher_impl.h"
 #include "common/event/file_event_impl.h"
 #include "common/network/address_impl.h"
@@ -20,7 +26,22 @@ namespace Envoy {
 namespace Network {
 
 Address::InstanceConstSharedPtr ListenerImpl::getLocalAddress(int fd) {
-  return Address::addressFromFd(fd);
+  sockaddr_storage ss;
+  socklen_t ss_len = sizeof ss;
+  const int rc = ::getsockname(fd, reinterpret_cast<sockaddr*>(&ss), &ss_len);
+  if (rc != 0) {
+    throw EnvoyException(fmt::format("getsockname failed for '{}': {}", fd, strerror(errno)));
+  }
+
+  // Connections to a listener on the all hosts address arrive on few local addresses, so the last
+  // one is shared by the connections to it rather than allocated for each of them.
+  if (last_local_address_ == nullptr || ss_len != last_local_sockaddr_len_ ||
+      memcmp(&ss, &last_local_sockaddr_, ss_len) != 0) {
+    last_local_address_ = Address::addressFromSockAddr(ss, ss_len);
+    last_local_sockaddr_ = ss;
+    last_local_sockaddr_len_ = ss_len;
+  }
+  return last_local_address_;
 }
 
 Address::InstanceConstSharedPtr ListenerImpl::getOriginalDst(int fd) {
@@ -89,9 +110,14 @@ ListenerImpl::ListenerImpl(Network::ConnectionHandler& conn_handler,
                            ListenerCallbacks& cb, Stats::Scope& scope,
                            const Network::ListenerOptions& listener_options)
     : connection_handler_(conn_handler), dispatcher_(dispatcher), socket_(socket), cb_(cb),
-      proxy_protocol_(scope), options_(listener_options), listener_(nullptr) {
+      proxy_protocol_(scope), options_(listener_options), listener_(nullptr),
+      accept_stats_{ALL_LISTENER_ACCEPT_STATS(POOL_COUNTER(scope))} {
 
-  if (options_.bind_to_port_) {
+  if (!options_.bind_to_port_) {
+    return;
+  }
+
+  if (options_.max_accepts_per_wakeup_ == 0 && options_.max_accepts_per_second_ == 0) {
     listener_.reset(
         evconnlistener_new(&dispatcher_.base(), listenCallback, this, 0, -1, socket.fd()));
 
@@ -101,9 +127,84 @@ ListenerImpl::ListenerImpl(Network::ConnectionHandler& conn_handler,
     }
 
     evconnlistener_set_error_cb(listener_.get(), errorCallback);
+    return;
+  }
+
+  // The same backlog as evconnlistener_new() uses by default.
+  if (::listen(socket.fd(), 128) != 0 || evutil_make_socket_nonblocking(socket.fd()) != 0) {
+    throw CreateListenerException(
+        fmt::format("cannot listen on socket: {}", socket.localAddress()->asString()));
+  }
+
+  // Level triggered, so that the connections left pending by a bounded batch are accepted on the
+  // next iteration of the event loop.
+  file_event_ = dispatcher_.createFileEvent(socket.fd(),
+                                            [this](uint32_t) -> void { acceptConnections(); },
+                                            Event::FileTriggerType::Level,
+                                            Event::FileReadyType::Read);
+  if (options_.max_accepts_per_second_ > 0) {
+    accept_tokens_ = options_.max_accepts_per_second_;
+    last_refill_ = ProdMonotonicTimeSource::instance_.currentTime();
+    accept_timer_ = dispatcher_.createTimer([this]() -> void { onAcceptTimer(); });
   }
 }
 
+void ListenerImpl::acceptConnections() {
+  uint32_t budget = options_.max_accepts_per_wakeup_ > 0 ? options_.max_accepts_per_wakeup_
+                                                         : std::numeric_limits<uint32_t>::max();
+  if (options_.max_accepts_per_second_ > 0) {
+    refillAcceptTokens();
+    budget = std::min(budget, static_cast<uint32_t>(accept_tokens_));
+  }
+
+  for (uint32_t accepted = 0; accepted < budget;) {
+    sockaddr_storage remote_addr;
+    socklen_t remote_addr_len = sizeof(remote_addr);
+    const int fd = ::accept(socket_.fd(), reinterpret_cast<sockaddr*>(&remote_addr),
+                            &remote_addr_len);
+    if (fd < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return;
+      }
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      errorCallback(nullptr, this);
+    }
+    evutil_make_socket_nonblocking(fd);
+    evutil_make_socket_closeonexec(fd);
+
+    accepted++;
+    if (options_.max_accepts_per_second_ > 0) {
+      accept_tokens_--;
+    }
+    listenCallback(nullptr, fd, reinterpret_cast<sockaddr*>(&remote_addr), remote_addr_len, this);
+  }
+
+  // The budget is spent while connections may still be pending. Without a token left, the socket is
+  // ignored until the next one is available, otherwise it is ready again on the next iteration.
+  if (options_.max_accepts_per_second_ > 0 && accept_tokens_ < 1) {
+    accept_stats_.downstream_cx_accept_rate_limited_.inc();
+    file_event_->setEnabled(0);
+    const double wait_ms = (1 - accept_tokens_) * 1000 / options_.max_accepts_per_second_;
+    accept_timer_->enableTimer(
+        std::chrono::milliseconds(std::max<int64_t>(1, static_cast<int64_t>(std::ceil(wait_ms)))));
+  } else {
+    accept_stats_.downstream_cx_accept_batch_limited_.inc();
+  }
+}
+
+void ListenerImpl::refillAcceptTokens() {
+  // Up to a second's worth of tokens is kept, which bounds the bursts.
+  const MonotonicTime now = ProdMonotonicTimeSource::instance_.currentTime();
+  const double elapsed = std::chrono::duration<double>(now - last_refill_).count();
+  accept_tokens_ = std::min<double>(options_.max_accepts_per_second_,
+                                    accept_tokens_ + elapsed * options_.max_accepts_per_second_);
+  last_refill_ = now;
+}
+
+void ListenerImpl::onAcceptTimer() { file_event_->setEnabled(Event::FileReadyType::Read); }
+
 void ListenerImpl::errorCallback(evconnlistener*, void*) {
   // We should never get an error callback. This can happen if we run out of FDs or memory. In those
   // cases just crash.
@@ -113,20 +214,31 @@ void ListenerImpl::errorCallback(evconnlistener*, void*) {
 void ListenerImpl::newConnection(int fd, Address::InstanceConstSharedPtr remote_address,
                                  Address::InstanceConstSharedPtr local_address,
                                  bool using_original_dst) {
+  if (cb_.onAccept(fd, remote_address, local_address, using_original_dst)) {
+    return;
+  }
+  createConnection(fd, remote_address, local_address, using_original_dst);
+}
+
+void ListenerImpl::createConnection(int fd, Address::InstanceConstSharedPtr remote_address,
+                                    Address::InstanceConstSharedPtr local_address,
+                                    bool using_original_dst) {
   ConnectionPtr new_connection(new ConnectionImpl(dispatcher_, fd, remote_address, local_address,
                                                   Network::Address::InstanceConstSharedPtr(),
                                                   using_original_dst, true));
   new_connection->setBufferLimits(options_.per_connection_buffer_limit_bytes_);
+  new_connection->setBufferAccount(options_.buffer_account_);
   cb_.onNewConnection(std::move(new_connection));
 }
 
-void SslListenerImpl::newConnection(int fd, Address::InstanceConstSharedPtr remote_address,
-                                    Address::InstanceConstSharedPtr local_address,
-                                    bool using_original_dst) {
+void SslListenerImpl::createConnection(int fd, Address::InstanceConstSharedPtr remote_address,
+                                       Address::InstanceConstSharedPtr local_address,
+                                       bool using_original_dst) {
   ConnectionPtr new_connection(new Ssl::ConnectionImpl(
       dispatcher_, fd, remote_address, local_address, Network::Address::InstanceConstSharedPtr(),
       using_original_dst, true, ssl_ctx_, Ssl::InitialState::Server));
   new_connection->setBufferLimits(options_.per_connection_buffer_limit_bytes_);
+  new_connection->setBufferAccount(options_.buffer_account_);
   cb_.onNewConnection(std::move(new_connection));
 }
 
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <sys/socket.h>
+
+#include "envoy/common/time.h"
+#include "envoy/event/file_event.h"
+#include "envoy/event/timer.h"
 #include "envoy/network/connection_handler.h"
 #include "envoy/network/listener.h"
+#include "envoy/stats/stats_macros.h"
 
 #include "common/event/dispatcher_impl.h"
 #include "common/event/libevent.h"
@@ -14,7 +20,25 @@ namespace Envoy {
 namespace Network {
 
 /**
- * libevent implementation of Network::Listener.
+ * All stats for the bounded accepts of a listener. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_LISTENER_ACCEPT_STATS(COUNTER)                                                         \
+  COUNTER(downstream_cx_accept_batch_limited)                                                      \
+  COUNTER(downstream_cx_accept_rate_limited)
+// clang-format on
+
+/**
+ * Definition of all stats for the bounded accepts of a listener. @see stats_macros.h
+ */
+struct ListenerAcceptStats {
+  ALL_LISTENER_ACCEPT_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * libevent implementation of Network::Listener. Without accept limits, the connections are
+ * accepted by an evconnlistener, which accepts all the pending ones each time the socket is ready.
+ * Otherwise they are accepted by the listener itself, in batches bounded by the limits.
  */
 class ListenerImpl : public Listener {
 public:
@@ -23,7 +47,8 @@ public:
                const ListenerOptions& listener_options);
 
   /**
-   * Accept/process a new connection.
+   * Accept/process a new connection. The callbacks may take the socket, otherwise a connection is
+   * created for it with createConnection().
    * @param fd supplies the new connection's fd.
    * @param remote_address supplies the remote address for the new connection.
    * @param local_address supplies the local address for the new connection.
@@ -32,6 +57,11 @@ public:
                              Address::InstanceConstSharedPtr local_address,
                              bool using_original_dst);
 
+  // Network::Listener
+  void createConnection(int fd, Address::InstanceConstSharedPtr remote_address,
+                        Address::InstanceConstSharedPtr local_address,
+                        bool using_original_dst) override;
+
   /**
    * @return the socket supplied to the listener at construction time
    */
@@ -52,8 +82,20 @@ private:
   static void errorCallback(evconnlistener* listener, void* context);
   static void listenCallback(evconnlistener*, evutil_socket_t fd, sockaddr* remote_addr,
                              int remote_addr_len, void* arg);
+  void acceptConnections();
+  void refillAcceptTokens();
+  void onAcceptTimer();
 
   Event::Libevent::ListenerPtr listener_;
+  // Used instead of listener_ when the accepts are bounded.
+  Event::FileEventPtr file_event_;
+  Event::TimerPtr accept_timer_;
+  double accept_tokens_{};
+  MonotonicTime last_refill_;
+  ListenerAcceptStats accept_stats_;
+  Address::InstanceConstSharedPtr last_local_address_;
+  sockaddr_storage last_local_sockaddr_;
+  socklen_t last_local_sockaddr_len_{};
 };
 
 class SslListenerImpl : public ListenerImpl {
@@ -64,10 +106,10 @@ public:
       : ListenerImpl(conn_handler, dispatcher, socket, cb, scope, listener_options),
         ssl_ctx_(ssl_ctx) {}
 
-  // ListenerImpl
-  void newConnection(int fd, Address::InstanceConstSharedPtr remote_address,
-                     Address::InstanceConstSharedPtr local_address,
-                     bool using_original_dst) override;
+  // Network::Listener
+  void createConnection(int fd, Address::InstanceConstSharedPtr remote_address,
+                        Address::InstanceConstSharedPtr local_address,
+                        bool using_original_dst) override;
 
 private:
   Ssl::Context& ssl_ctx_;
@@ -1,8 +1,12 @@
 #include "common/network/proxy_protocol.h"
 
+#include <netinet/in.h>
+#include <sys/socket.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
 
@@ -11,6 +15,7 @@
 #include "envoy/event/file_event.h"
 #include "envoy/stats/stats.h"
 
+#include "common/common/byte_order.h"
 #include "common/common/empty_string.h"
 #include "common/common/utility.h"
 #include "common/network/address_impl.h"
@@ -31,7 +36,7 @@ void ProxyProtocol::newConnection(Event::Dispatcher& dispatcher, int fd, Listene
 ProxyProtocol::ActiveConnection::ActiveConnection(ProxyProtocol& parent,
                                                   Event::Dispatcher& dispatcher, int fd,
                                                   ListenerImpl& listener)
-    : parent_(parent), fd_(fd), listener_(listener), search_index_(1) {
+    : parent_(parent), fd_(fd), listener_(listener) {
   file_event_ =
       dispatcher.createFileEvent(fd,
                                  [this](uint32_t events) {
@@ -57,12 +62,106 @@ void ProxyProtocol::ActiveConnection::onRead() {
   }
 }
 
+namespace {
+
+// The signature which starts a V2 header.
+const char PROXY_PROTO_V2_SIGNATURE[] = "\r\n\r\n\0\r\nQUIT\n";
+const size_t PROXY_PROTO_V2_SIGNATURE_LEN = 12;
+
+const uint8_t PROXY_PROTO_V2_VERSION = 0x2;
+const uint8_t PROXY_PROTO_V2_LOCAL = 0x0;
+const uint8_t PROXY_PROTO_V2_PROXY = 0x1;
+
+const uint8_t PROXY_PROTO_V2_AF_UNSPEC = 0x0;
+const uint8_t PROXY_PROTO_V2_AF_INET = 0x1;
+const uint8_t PROXY_PROTO_V2_AF_INET6 = 0x2;
+const uint8_t PROXY_PROTO_V2_AF_UNIX = 0x3;
+
+const uint8_t PROXY_PROTO_V2_TRANSPORT_UNSPEC = 0x0;
+const uint8_t PROXY_PROTO_V2_TRANSPORT_STREAM = 0x1;
+
+const size_t PROXY_PROTO_V2_ADDR_LEN_INET = 12;
+const size_t PROXY_PROTO_V2_ADDR_LEN_INET6 = 36;
+const size_t PROXY_PROTO_V2_TLV_HEADER_LEN = 3;
+
+uint16_t readUint16(const char* data) {
+  uint16_t value;
+  memcpy(&value, data, sizeof(value));
+  return be16toh(value);
+}
+
+} // namespace
+
 void ProxyProtocol::ActiveConnection::onReadWorker() {
-  std::string proxy_line;
-  if (!readLine(fd_, proxy_line)) {
+  // Peek at enough data for most headers at once, then consume just the header, leaving the data
+  // after it to the connection.
+  ssize_t nread = recv(fd_, buf_, MAX_PROXY_PROTO_PEEK_LEN, MSG_PEEK);
+  if (nread == -1 && errno == EAGAIN) {
+    return;
+  } else if (nread < 1) {
+    throw EnvoyException("failed to read proxy protocol");
+  }
+
+  const size_t header_len = headerLength(buf_, nread);
+  if (header_len == 0) {
+    return;
+  }
+
+  char* header = buf_;
+  if (header_len > MAX_PROXY_PROTO_PEEK_LEN) {
+    // Only V2 headers with many TLVs get here.
+    large_buf_.resize(header_len);
+    header = large_buf_.data();
+    nread = recv(fd_, header, header_len, MSG_PEEK);
+    if (nread == -1 && errno == EAGAIN) {
+      return;
+    } else if (nread < 1) {
+      throw EnvoyException("failed to read proxy protocol");
+    }
+  }
+
+  if (size_t(nread) < header_len) {
     return;
   }
 
+  // This should never fail, as we're asking only for bytes we have already seen.
+  nread = recv(fd_, header, header_len, 0);
+  ASSERT(size_t(nread) == header_len);
+
+  if (header[0] == 'P') {
+    parseV1(header, header_len);
+  } else {
+    parseV2(header, header_len);
+  }
+}
+
+size_t ProxyProtocol::ActiveConnection::headerLength(const char* data, size_t len) {
+  if (data[0] == PROXY_PROTO_V2_SIGNATURE[0]) {
+    if (memcmp(data, PROXY_PROTO_V2_SIGNATURE, std::min(len, PROXY_PROTO_V2_SIGNATURE_LEN)) != 0) {
+      throw EnvoyException("failed to read proxy protocol");
+    }
+    if (len < PROXY_PROTO_V2_HEADER_LEN) {
+      return 0;
+    }
+    return PROXY_PROTO_V2_HEADER_LEN + readUint16(data + PROXY_PROTO_V2_HEADER_LEN - 2);
+  }
+
+  // A V1 header is a line, ending with '\r\n'.
+  const size_t search_len = std::min(len, MAX_PROXY_PROTO_V1_LEN);
+  for (size_t i = 1; i < search_len; i++) {
+    if (data[i] == '\n' && data[i - 1] == '\r') {
+      return i + 1;
+    }
+  }
+  if (len >= MAX_PROXY_PROTO_V1_LEN) {
+    throw EnvoyException("failed to read proxy protocol");
+  }
+  return 0;
+}
+
+void ProxyProtocol::ActiveConnection::parseV1(const char* data, size_t len) {
+  std::string proxy_line(data, len);
+
   // Remove the line feed at the end
   StringUtil::rtrim(proxy_line);
 
@@ -128,6 +227,92 @@ void ProxyProtocol::ActiveConnection::onReadWorker() {
   finishConnection(remote_address, local_address);
 }
 
+void ProxyProtocol::ActiveConnection::parseV2(const char* data, size_t len) {
+  const uint8_t version_command = data[PROXY_PROTO_V2_SIGNATURE_LEN];
+  const uint8_t family_transport = data[PROXY_PROTO_V2_SIGNATURE_LEN + 1];
+  if ((version_command >> 4) != PROXY_PROTO_V2_VERSION) {
+    throw EnvoyException("failed to read proxy protocol");
+  }
+
+  const uint8_t command = version_command & 0xf;
+  const uint8_t family = family_transport >> 4;
+  const uint8_t transport = family_transport & 0xf;
+  const char* addrs = data + PROXY_PROTO_V2_HEADER_LEN;
+  const size_t addrs_len = len - PROXY_PROTO_V2_HEADER_LEN;
+
+  if (command == PROXY_PROTO_V2_LOCAL ||
+      (command == PROXY_PROTO_V2_PROXY &&
+       (family == PROXY_PROTO_V2_AF_UNSPEC || family == PROXY_PROTO_V2_AF_UNIX ||
+        transport == PROXY_PROTO_V2_TRANSPORT_UNSPEC))) {
+    // Health checks from the proxy itself, or connections whose addresses we can't use. Either
+    // way the connection is accepted with its real addresses and any address block is skipped.
+    finishConnection(Envoy::Network::Address::addressFromFd(fd_),
+                     Envoy::Network::Address::addressFromFd(fd_));
+    return;
+  }
+
+  if (command != PROXY_PROTO_V2_PROXY || transport != PROXY_PROTO_V2_TRANSPORT_STREAM) {
+    throw EnvoyException("failed to read proxy protocol");
+  }
+
+  Address::InstanceConstSharedPtr remote_address;
+  Address::InstanceConstSharedPtr local_address;
+  size_t tlvs_offset;
+  if (family == PROXY_PROTO_V2_AF_INET) {
+    if (addrs_len < PROXY_PROTO_V2_ADDR_LEN_INET) {
+      throw EnvoyException("failed to read proxy protocol");
+    }
+    sockaddr_in remote{};
+    sockaddr_in local{};
+    remote.sin_family = AF_INET;
+    local.sin_family = AF_INET;
+    // Addresses and ports are already in network byte order.
+    memcpy(&remote.sin_addr.s_addr, addrs, 4);
+    memcpy(&local.sin_addr.s_addr, addrs + 4, 4);
+    memcpy(&remote.sin_port, addrs + 8, 2);
+    memcpy(&local.sin_port, addrs + 10, 2);
+    remote_address = std::make_shared<Address::Ipv4Instance>(&remote);
+    local_address = std::make_shared<Address::Ipv4Instance>(&local);
+    tlvs_offset = PROXY_PROTO_V2_ADDR_LEN_INET;
+  } else if (family == PROXY_PROTO_V2_AF_INET6) {
+    if (addrs_len < PROXY_PROTO_V2_ADDR_LEN_INET6) {
+      throw EnvoyException("failed to read proxy protocol");
+    }
+    sockaddr_in6 remote{};
+    sockaddr_in6 local{};
+    remote.sin6_family = AF_INET6;
+    local.sin6_family = AF_INET6;
+    memcpy(&remote.sin6_addr, addrs, 16);
+    memcpy(&local.sin6_addr, addrs + 16, 16);
+    memcpy(&remote.sin6_port, addrs + 32, 2);
+    memcpy(&local.sin6_port, addrs + 34, 2);
+    remote_address = std::make_shared<Address::Ipv6Instance>(remote);
+    local_address = std::make_shared<Address::Ipv6Instance>(local);
+    tlvs_offset = PROXY_PROTO_V2_ADDR_LEN_INET6;
+  } else {
+    throw EnvoyException("failed to read proxy protocol");
+  }
+
+  // The TLVs after the addresses aren't used yet, but must be well formed.
+  while (tlvs_offset < addrs_len) {
+    if (addrs_len - tlvs_offset < PROXY_PROTO_V2_TLV_HEADER_LEN) {
+      throw EnvoyException("failed to read proxy protocol");
+    }
+    const size_t value_len = readUint16(addrs + tlvs_offset + 1);
+    tlvs_offset += PROXY_PROTO_V2_TLV_HEADER_LEN;
+    if (addrs_len - tlvs_offset < value_len) {
+      throw EnvoyException("failed to read proxy protocol");
+    }
+    tlvs_offset += value_len;
+  }
+
+  if (!remote_address->ip()->isUnicastAddress() || !local_address->ip()->isUnicastAddress()) {
+    throw EnvoyException("failed to read proxy protocol");
+  }
+
+  finishConnection(remote_address, local_address);
+}
+
 void ProxyProtocol::ActiveConnection::finishConnection(
     Address::InstanceConstSharedPtr remote_address, Address::InstanceConstSharedPtr local_address) {
 
@@ -146,42 +331,5 @@ void ProxyProtocol::ActiveConnection::close() {
   removeFromList(parent_.connections_);
 }
 
-bool ProxyProtocol::ActiveConnection::readLine(int fd, std::string& s) {
-  while (buf_off_ < MAX_PROXY_PROTO_LEN) {
-    ssize_t nread = recv(fd, buf_ + buf_off_, MAX_PROXY_PROTO_LEN - buf_off_, MSG_PEEK);
-
-    if (nread == -1 && errno == EAGAIN) {
-      return false;
-    } else if (nread < 1) {
-      throw EnvoyException("failed to read proxy protocol");
-    }
-
-    bool found = false;
-    // continue searching buf_ from where we left off
-    for (; search_index_ < buf_off_ + nread; search_index_++) {
-      if (buf_[search_index_] == '\n' && buf_[search_index_ - 1] == '\r') {
-        search_index_++;
-        found = true;
-        break;
-      }
-    }
-
-    // Read the data upto and including the line feed, if available, but not past it.
-    // This should never fail, as search_index_ - buf_off_ <= nread, so we're asking
-    // only for bytes we have already seen.
-    nread = recv(fd, buf_ + buf_off_, search_index_ - buf_off_, 0);
-    ASSERT(size_t(nread) == search_index_ - buf_off_);
-
-    buf_off_ += nread;
-
-    if (found) {
-      s.assign(buf_, buf_off_);
-      return true;
-    }
-  }
-
-  throw EnvoyException("failed to read proxy protocol");
-}
-
 } // namespace Network
 } // namespace Envoy
@@ -3,8 +3,10 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "envoy/event/dispatcher.h"
+#include "envoy/network/address.h"
 #include "envoy/stats/stats_macros.h"
 
 #include "common/common/linked_object.h"
@@ -30,8 +32,8 @@ struct ProxyProtocolStats {
 };
 
 /**
- * Implementation the PROXY Protocol V1
- * (http://www.haproxy.org/download/1.5/doc/proxy-protocol.txt)
+ * Implementation the PROXY Protocol V1 and V2
+ * (http://www.haproxy.org/download/1.8/doc/proxy-protocol.txt)
  */
 class ProxyProtocol {
 public:
@@ -42,17 +44,29 @@ public:
     ~ActiveConnection();
 
   private:
-    static const size_t MAX_PROXY_PROTO_LEN = 108;
+    static const size_t MAX_PROXY_PROTO_V1_LEN = 108;
+    static const size_t PROXY_PROTO_V2_HEADER_LEN = 16;
+    // Enough for a V1 header, or a V2 header with the addresses and a few TLVs, so that the header
+    // can usually be peeked at all at once.
+    static const size_t MAX_PROXY_PROTO_PEEK_LEN = 256;
 
     void onRead();
     void onReadWorker();
 
     /**
-     * Helper function that attempts to read a line (delimited by '\r\n') from the socket.
-     * throws EnvoyException on any socket errors.
-     * @return bool true if a line should be read, false if more data is needed.
+     * Find the length of the header at the start of the data.
+     * throws EnvoyException if the data does not start with a V1 or V2 header.
+     * @return size_t the length of the header, or 0 if more data is needed to tell.
      */
-    bool readLine(int fd, std::string& s);
+    static size_t headerLength(const char* data, size_t len);
+
+    /**
+     * Helper functions that parse a header consumed from the socket, and replace the current
+     * connection with one with the addresses it carries.
+     * throw EnvoyException if the header is malformed.
+     */
+    void parseV1(const char* data, size_t len);
+    void parseV2(const char* data, size_t len);
     void close();
 
     /**
@@ -66,14 +80,11 @@ public:
     ListenerImpl& listener_;
     Event::FileEventPtr file_event_;
 
-    // The offset in buf_ that has been fully read
-    size_t buf_off_{};
-
-    // The index in buf_ where the search for '\r\n' should continue from
-    size_t search_index_;
+    // Holds the data peeked at, and then the header as it is consumed.
+    char buf_[MAX_PROXY_PROTO_PEEK_LEN];
 
-    // Stores the portion of the first line that has been read so far.
-    char buf_[MAX_PROXY_PROTO_LEN];
+    // Holds V2 headers which don't fit in buf_.
+    std::vector<char> large_buf_;
   };
 
   ProxyProtocol(Stats::Scope& scope);
@@ -1,10 +1,21 @@
 #include "common/network/raw_buffer_socket.h"
 
+#include <sys/uio.h>
+
+#include <algorithm>
+
 #include "common/common/empty_string.h"
 
 namespace Envoy {
 namespace Network {
 
+const uint64_t RawBufferSocket::MIN_READ_SIZE;
+const uint64_t RawBufferSocket::DEFAULT_MAX_READ_SIZE;
+const uint64_t RawBufferSocket::MAX_READ_SLICES;
+
+RawBufferSocket::RawBufferSocket(uint64_t max_read_size)
+    : max_read_size_(std::max(max_read_size, MIN_READ_SIZE)) {}
+
 void RawBufferSocket::setTransportSocketCallbacks(TransportSocketCallbacks& callbacks) {
   callbacks_ = &callbacks;
 }
@@ -12,13 +23,13 @@ void RawBufferSocket::setTransportSocketCallbacks(TransportSocketCallbacks& call
 IoResult RawBufferSocket::doRead(Buffer::Instance& buffer) {
   PostIoAction action = PostIoAction::KeepOpen;
   uint64_t bytes_read = 0;
+  uint64_t num_syscalls = 0;
   do {
-    // 16K read is arbitrary. IIRC, libevent will currently clamp this to 4K. libevent will also
-    // use an ioctl() before every read to figure out how much data there is to read.
-    //
-    // TODO(mattklein123) PERF: Tune the read size and figure out a way of getting rid of the
-    // ioctl(). The extra syscall is not worth it.
-    int rc = buffer.read(callbacks_->fd(), 16384);
+    // Reading straight into space reserved in the buffer avoids the ioctl(FIONREAD) which
+    // evbuffer_read() makes before every read, and its clamping of the read size.
+    const uint64_t read_size = nextReadSize(buffer);
+    const ssize_t rc = readIntoBuffer(buffer, read_size);
+    num_syscalls++;
     ENVOY_CONN_LOG(trace, "read returns: {}", callbacks_->connection(), rc);
 
     // Remote close. Might need to raise data before raising close.
@@ -35,6 +46,7 @@ IoResult RawBufferSocket::doRead(Buffer::Instance& buffer) {
       break;
     } else {
       bytes_read += rc;
+      onReadComplete(read_size, rc);
       if (callbacks_->shouldDrainReadBuffer()) {
         callbacks_->setReadBufferReady();
         break;
@@ -42,18 +54,70 @@ IoResult RawBufferSocket::doRead(Buffer::Instance& buffer) {
     }
   } while (true);
 
-  return {action, bytes_read};
+  return {action, bytes_read, num_syscalls};
+}
+
+ssize_t RawBufferSocket::readIntoBuffer(Buffer::Instance& buffer, uint64_t read_size) {
+  Buffer::RawSlice slices[MAX_READ_SLICES];
+  const uint64_t num_slices = buffer.reserve(read_size, slices, MAX_READ_SLICES);
+
+  // The reservation may be larger than asked for, so trim it to the read size.
+  iovec iov[MAX_READ_SLICES];
+  uint64_t num_bytes_to_read = 0;
+  for (uint64_t i = 0; i < num_slices; i++) {
+    iov[i].iov_base = slices[i].mem_;
+    iov[i].iov_len = std::min<uint64_t>(slices[i].len_, read_size - num_bytes_to_read);
+    num_bytes_to_read += iov[i].iov_len;
+  }
+
+  const ssize_t rc = readv(callbacks_->fd(), iov, num_slices);
+  if (rc <= 0) {
+    return rc;
+  }
+
+  uint64_t num_slices_to_commit = 0;
+  uint64_t remaining = rc;
+  while (remaining > 0) {
+    slices[num_slices_to_commit].len_ = std::min<uint64_t>(iov[num_slices_to_commit].iov_len,
+                                                           remaining);
+    remaining -= slices[num_slices_to_commit].len_;
+    num_slices_to_commit++;
+  }
+  buffer.commit(slices, num_slices_to_commit);
+  return rc;
+}
+
+uint64_t RawBufferSocket::nextReadSize(const Buffer::Instance& buffer) const {
+  const uint64_t limit = callbacks_->connection().bufferLimit();
+  if (limit == 0) {
+    return read_size_;
+  }
+  if (buffer.length() >= limit) {
+    return MIN_READ_SIZE;
+  }
+  return std::min(read_size_, limit - buffer.length());
+}
+
+void RawBufferSocket::onReadComplete(uint64_t read_size, uint64_t bytes_read) {
+  if (bytes_read == read_size && read_size == read_size_) {
+    // The socket had at least as much data as asked for, so ask for more next time.
+    read_size_ = std::min(read_size_ * 2, max_read_size_);
+  } else if (bytes_read < read_size_ / 4) {
+    read_size_ = std::max(read_size_ / 2, MIN_READ_SIZE);
+  }
 }
 
 IoResult RawBufferSocket::doWrite(Buffer::Instance& buffer) {
   PostIoAction action;
   uint64_t bytes_written = 0;
+  uint64_t num_syscalls = 0;
   do {
     if (buffer.length() == 0) {
       action = PostIoAction::KeepOpen;
       break;
     }
     int rc = buffer.write(callbacks_->fd());
+    num_syscalls++;
     ENVOY_CONN_LOG(trace, "write returns: {}", callbacks_->connection(), rc);
     if (rc == -1) {
       ENVOY_CONN_LOG(trace, "write error: {}", callbacks_->connection(), errno);
@@ -69,7 +133,7 @@ IoResult RawBufferSocket::doWrite(Buffer::Instance& buffer) {
     }
   } while (true);
 
-  return {action, bytes_written};
+  return {action, bytes_written, num_syscalls};
 }
 
 std::string RawBufferSocket::protocol() const { return EMPTY_STRING; }
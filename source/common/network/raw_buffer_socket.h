@@ -10,6 +10,12 @@ namespace Network {
 
 class RawBufferSocket : public TransportSocket, protected Logger::Loggable<Logger::Id::connection> {
 public:
+  /**
+   * @param max_read_size supplies the largest size of a single read from the socket. Reads start
+   *        at MIN_READ_SIZE and grow towards it while reads keep filling the space offered.
+   */
+  RawBufferSocket(uint64_t max_read_size = DEFAULT_MAX_READ_SIZE);
+
   // Network::TransportSocket
   void setTransportSocketCallbacks(TransportSocketCallbacks& callbacks) override;
   std::string protocol() const override;
@@ -19,8 +25,34 @@ public:
   IoResult doRead(Buffer::Instance& buffer) override;
   IoResult doWrite(Buffer::Instance& buffer) override;
 
+  uint64_t readSize() const { return read_size_; }
+
+  static const uint64_t MIN_READ_SIZE = 16384;
+  static const uint64_t DEFAULT_MAX_READ_SIZE = 262144;
+  // Most slices reserved from the buffer for a single read.
+  static const uint64_t MAX_READ_SLICES = 16;
+
 private:
+  /**
+   * Read from the socket directly into space reserved in the buffer.
+   * @return the result of readv().
+   */
+  ssize_t readIntoBuffer(Buffer::Instance& buffer, uint64_t read_size);
+
+  /**
+   * @return uint64_t the size of the next read. Reads are kept within the connection's buffer
+   *         limit, so that they don't overshoot it by more than before.
+   */
+  uint64_t nextReadSize(const Buffer::Instance& buffer) const;
+
+  /**
+   * Adapt the read size to the result of a read.
+   */
+  void onReadComplete(uint64_t read_size, uint64_t bytes_read);
+
   TransportSocketCallbacks* callbacks_{};
+  const uint64_t max_read_size_;
+  uint64_t read_size_{MIN_READ_SIZE};
 };
 
 } // namespace Network
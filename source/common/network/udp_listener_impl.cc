@@ -0,0 +1,283 @@
+#include "common/network/udp_listener_impl.h"
+
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/assert.h"
+#include "common/common/macros.h"
+#include "common/network/address_impl.h"
+
+namespace Envoy {
+namespace Network {
+
+namespace {
+
+// Fill in the socket address of an IP address, which datagrams are sent to.
+socklen_t sockAddrFromIp(const Address::Instance& address, sockaddr_storage& ss) {
+  const Address::Ip* ip = address.ip();
+  ASSERT(ip != nullptr);
+  memset(&ss, 0, sizeof(ss));
+  if (ip->version() == Address::IpVersion::v4) {
+    sockaddr_in* sin = reinterpret_cast<sockaddr_in*>(&ss);
+    sin->sin_family = AF_INET;
+    sin->sin_addr.s_addr = ip->ipv4()->address();
+    sin->sin_port = htons(ip->port());
+    return sizeof(sockaddr_in);
+  }
+  sockaddr_in6* sin6 = reinterpret_cast<sockaddr_in6*>(&ss);
+  sin6->sin6_family = AF_INET6;
+  const std::array<uint8_t, 16> address6 = ip->ipv6()->address();
+  memcpy(&sin6->sin6_addr, address6.data(), address6.size());
+  sin6->sin6_port = htons(ip->port());
+  return sizeof(sockaddr_in6);
+}
+
+// Append the non-empty slices of a buffer to iovecs.
+void appendSlices(const Buffer::Instance& buffer, std::vector<iovec>& iovecs) {
+  const uint64_t num_slices = buffer.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  buffer.getRawSlices(slices, num_slices);
+  for (const Buffer::RawSlice& slice : slices) {
+    if (slice.len_ > 0) {
+      iovecs.push_back({slice.mem_, slice.len_});
+    }
+  }
+}
+
+} // namespace
+
+UdpListenerImpl::UdpListenerImpl(Event::DispatcherImpl& dispatcher, ListenSocket& socket,
+                                 UdpListenerCallbacks& cb, Stats::Scope& scope)
+    : socket_(socket), cb_(cb), stats_{ALL_UDP_LISTENER_STATS(POOL_COUNTER(scope))} {
+#ifdef UDP_SEGMENT
+  // Kernels which support segmentation offload let the segment size be read.
+  int segment_size;
+  socklen_t segment_size_len = sizeof(segment_size);
+  gso_supported_ = ::getsockopt(socket_.fd(), IPPROTO_UDP, UDP_SEGMENT, &segment_size,
+                                &segment_size_len) == 0;
+#endif
+
+  for (uint64_t i = 0; i < MAX_DATAGRAMS_PER_READ; i++) {
+    reserveRecvBuffer(i);
+  }
+
+  // Edge triggered, so all the pending datagrams are read each time the socket is ready.
+  file_event_ = dispatcher.createFileEvent(socket_.fd(),
+                                           [this](uint32_t) -> void { readDatagrams(); },
+                                           Event::FileTriggerType::Edge,
+                                           Event::FileReadyType::Read);
+}
+
+void UdpListenerImpl::readDatagrams() {
+  while (true) {
+#ifdef __linux__
+    mmsghdr messages[MAX_DATAGRAMS_PER_READ];
+    iovec iovecs[MAX_DATAGRAMS_PER_READ];
+    sockaddr_storage peers[MAX_DATAGRAMS_PER_READ];
+    memset(messages, 0, sizeof(messages));
+    for (uint64_t i = 0; i < MAX_DATAGRAMS_PER_READ; i++) {
+      iovecs[i].iov_base = recv_slices_[i].mem_;
+      iovecs[i].iov_len = MAX_RECV_DATAGRAM_SIZE;
+      messages[i].msg_hdr.msg_name = &peers[i];
+      messages[i].msg_hdr.msg_namelen = sizeof(peers[i]);
+      messages[i].msg_hdr.msg_iov = &iovecs[i];
+      messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    const int received =
+        ::recvmmsg(socket_.fd(), messages, MAX_DATAGRAMS_PER_READ, MSG_DONTWAIT, nullptr);
+    if (received < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    for (int i = 0; i < received; i++) {
+      onDatagram(i, messages[i].msg_hdr, messages[i].msg_len);
+    }
+    // A short batch drained the socket, which is ready again once another datagram arrives.
+    if (static_cast<uint64_t>(received) < MAX_DATAGRAMS_PER_READ) {
+      return;
+    }
+#else
+    msghdr header;
+    iovec iov{recv_slices_[0].mem_, MAX_RECV_DATAGRAM_SIZE};
+    sockaddr_storage peer;
+    memset(&header, 0, sizeof(header));
+    header.msg_name = &peer;
+    header.msg_namelen = sizeof(peer);
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+
+    const ssize_t received = ::recvmsg(socket_.fd(), &header, MSG_DONTWAIT);
+    if (received < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    onDatagram(0, header, received);
+#endif
+  }
+}
+
+void UdpListenerImpl::onDatagram(uint64_t index, const msghdr& header, uint64_t length) {
+  // The buffer of a dropped datagram is reused for the next one.
+  if (header.msg_flags & MSG_TRUNC) {
+    stats_.downstream_rx_datagram_truncated_.inc();
+    return;
+  }
+
+  recv_slices_[index].len_ = length;
+  recv_buffers_[index]->commit(&recv_slices_[index], 1);
+  UdpRecvData data{
+      peerAddress(*static_cast<const sockaddr_storage*>(header.msg_name), header.msg_namelen),
+      std::move(recv_buffers_[index])};
+  reserveRecvBuffer(index);
+  cb_.onData(data);
+}
+
+void UdpListenerImpl::reserveRecvBuffer(uint64_t index) {
+  recv_buffers_[index].reset(new Buffer::OwnedImpl());
+  const uint64_t num_slices =
+      recv_buffers_[index]->reserve(MAX_RECV_DATAGRAM_SIZE, &recv_slices_[index], 1);
+  ASSERT(num_slices == 1 && recv_slices_[index].len_ >= MAX_RECV_DATAGRAM_SIZE);
+  UNREFERENCED_PARAMETER(num_slices);
+}
+
+Address::InstanceConstSharedPtr UdpListenerImpl::peerAddress(const sockaddr_storage& ss,
+                                                             socklen_t ss_len) {
+  if (last_peer_address_ == nullptr || ss_len != last_peer_sockaddr_len_ ||
+      memcmp(&ss, &last_peer_sockaddr_, ss_len) != 0) {
+    last_peer_address_ = Address::addressFromSockAddr(ss, ss_len);
+    last_peer_sockaddr_ = ss;
+    last_peer_sockaddr_len_ = ss_len;
+  }
+  return last_peer_address_;
+}
+
+uint64_t UdpListenerImpl::segmentCount(const std::vector<UdpSendData>& datagrams,
+                                       uint64_t first) const {
+  // The kernel splits a message into segments of the size of the first one, only the last segment
+  // being allowed to be shorter.
+  const uint64_t segment_size = datagrams[first].buffer_.length();
+  if (!gso_supported_ || segment_size == 0) {
+    return 1;
+  }
+  uint64_t last = first + 1;
+  uint64_t total_size = segment_size;
+  while (last < datagrams.size() && last - first < MAX_SEGMENTS_PER_MESSAGE) {
+    const uint64_t size = datagrams[last].buffer_.length();
+    if (size == 0 || size > segment_size || total_size + size > MAX_SEGMENTED_MESSAGE_SIZE ||
+        *datagrams[last].peer_address_ != *datagrams[first].peer_address_) {
+      break;
+    }
+    total_size += size;
+    last++;
+    if (size < segment_size) {
+      break;
+    }
+  }
+  return last - first;
+}
+
+uint64_t UdpListenerImpl::send(const std::vector<UdpSendData>& datagrams) {
+  uint64_t sent = 0;
+#ifdef __linux__
+  while (sent < datagrams.size()) {
+    // Each message is either a single datagram or a run of datagrams to the same peer, which the
+    // kernel segments. The iovecs of all the messages are gathered before they are pointed to.
+    mmsghdr messages[MAX_MESSAGES_PER_SEND];
+    sockaddr_storage peers[MAX_MESSAGES_PER_SEND];
+    uint64_t message_datagrams[MAX_MESSAGES_PER_SEND];
+    uint64_t message_iovecs[MAX_MESSAGES_PER_SEND];
+    std::vector<iovec> iovecs;
+#ifdef UDP_SEGMENT
+    char controls[MAX_MESSAGES_PER_SEND][CMSG_SPACE(sizeof(uint16_t))];
+    memset(controls, 0, sizeof(controls));
+#endif
+    memset(messages, 0, sizeof(messages));
+
+    uint64_t num_messages = 0;
+    for (uint64_t next = sent; next < datagrams.size() && num_messages < MAX_MESSAGES_PER_SEND;
+         num_messages++) {
+      const uint64_t segments = segmentCount(datagrams, next);
+      msghdr& header = messages[num_messages].msg_hdr;
+      header.msg_name = &peers[num_messages];
+      header.msg_namelen = sockAddrFromIp(*datagrams[next].peer_address_, peers[num_messages]);
+      message_iovecs[num_messages] = iovecs.size();
+      for (uint64_t i = next; i < next + segments; i++) {
+        appendSlices(datagrams[i].buffer_, iovecs);
+      }
+      header.msg_iovlen = iovecs.size() - message_iovecs[num_messages];
+#ifdef UDP_SEGMENT
+      if (segments > 1) {
+        header.msg_control = controls[num_messages];
+        header.msg_controllen = sizeof(controls[num_messages]);
+        cmsghdr* control = CMSG_FIRSTHDR(&header);
+        control->cmsg_level = IPPROTO_UDP;
+        control->cmsg_type = UDP_SEGMENT;
+        control->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+        const uint16_t segment_size = datagrams[next].buffer_.length();
+        memcpy(CMSG_DATA(control), &segment_size, sizeof(segment_size));
+      }
+#endif
+      message_datagrams[num_messages] = segments;
+      next += segments;
+    }
+    for (uint64_t i = 0; i < num_messages; i++) {
+      messages[i].msg_hdr.msg_iov = iovecs.data() + message_iovecs[i];
+    }
+
+    const int rc = ::sendmmsg(socket_.fd(), messages, num_messages, MSG_DONTWAIT);
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EIO && gso_supported_) {
+        // The device can't checksum segmented messages, so the datagrams are sent one per message
+        // from now on.
+        gso_supported_ = false;
+        continue;
+      }
+      break;
+    }
+    for (int i = 0; i < rc; i++) {
+      sent += message_datagrams[i];
+    }
+    if (static_cast<uint64_t>(rc) < num_messages) {
+      break;
+    }
+  }
+#else
+  for (; sent < datagrams.size(); sent++) {
+    sockaddr_storage peer;
+    const socklen_t peer_len = sockAddrFromIp(*datagrams[sent].peer_address_, peer);
+    std::vector<iovec> iovecs;
+    appendSlices(datagrams[sent].buffer_, iovecs);
+    msghdr header;
+    memset(&header, 0, sizeof(header));
+    header.msg_name = &peer;
+    header.msg_namelen = peer_len;
+    header.msg_iov = iovecs.data();
+    header.msg_iovlen = iovecs.size();
+    if (::sendmsg(socket_.fd(), &header, MSG_DONTWAIT) < 0) {
+      break;
+    }
+  }
+#endif
+
+  stats_.downstream_tx_datagram_unsent_.add(datagrams.size() - sent);
+  return sent;
+}
+
+} // namespace Network
+} // namespace Envoy
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <sys/socket.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "envoy/buffer/buffer.h"
+#include "envoy/event/file_event.h"
+#include "envoy/network/listen_socket.h"
+#include "envoy/network/listener.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/event/dispatcher_impl.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * All stats for a UDP listener. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_UDP_LISTENER_STATS(COUNTER)                                                            \
+  COUNTER(downstream_rx_datagram_truncated)                                                        \
+  COUNTER(downstream_tx_datagram_unsent)
+// clang-format on
+
+/**
+ * Definition of all stats for a UDP listener. @see stats_macros.h
+ */
+struct UdpListenerStats {
+  ALL_UDP_LISTENER_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * libevent implementation of Network::UdpListener. On Linux, the datagrams are read with
+ * recvmmsg() and written with sendmmsg(), using UDP generic segmentation offload where the kernel
+ * supports it. Elsewhere they are read and written one at a time.
+ */
+class UdpListenerImpl : public UdpListener {
+public:
+  UdpListenerImpl(Event::DispatcherImpl& dispatcher, ListenSocket& socket,
+                  UdpListenerCallbacks& cb, Stats::Scope& scope);
+
+  // Network::UdpListener
+  uint64_t send(const std::vector<UdpSendData>& datagrams) override;
+
+  // The largest datagram received, which fits the payload of a packet with the usual MTU. Larger
+  // datagrams are dropped.
+  static const uint64_t MAX_RECV_DATAGRAM_SIZE = 1500;
+  // The number of datagrams read by a single recvmmsg().
+  static const uint64_t MAX_DATAGRAMS_PER_READ = 16;
+  // The number of messages written by a single sendmmsg().
+  static const uint64_t MAX_MESSAGES_PER_SEND = 64;
+  // The number of datagrams sent as the segments of a single message, and their total size, which
+  // are the kernel's limits for UDP segmentation offload.
+  static const uint64_t MAX_SEGMENTS_PER_MESSAGE = 64;
+  static const uint64_t MAX_SEGMENTED_MESSAGE_SIZE = 65507;
+
+private:
+  void readDatagrams();
+  void onDatagram(uint64_t index, const msghdr& header, uint64_t length);
+  void reserveRecvBuffer(uint64_t index);
+  Address::InstanceConstSharedPtr peerAddress(const sockaddr_storage& ss, socklen_t ss_len);
+  uint64_t segmentCount(const std::vector<UdpSendData>& datagrams, uint64_t first) const;
+
+  ListenSocket& socket_;
+  UdpListenerCallbacks& cb_;
+  UdpListenerStats stats_;
+  Event::FileEventPtr file_event_;
+  bool gso_supported_{};
+  // Buffers reserved for the next datagrams read, each replaced once its datagram is handed over.
+  Buffer::InstancePtr recv_buffers_[MAX_DATAGRAMS_PER_READ];
+  Buffer::RawSlice recv_slices_[MAX_DATAGRAMS_PER_READ];
+  // Peers send many datagrams in a row, so the last peer's address is shared by its datagrams
+  // rather than allocated for each of them.
+  Address::InstanceConstSharedPtr last_peer_address_;
+  sockaddr_storage last_peer_sockaddr_;
+  socklen_t last_peer_sockaddr_len_{};
+};
+
+} // namespace Network
+} // namespace Envoy
@@ -18,13 +18,17 @@ bool Cpu::startProfiler(const std::string& output_path) {
 
 void Cpu::stopProfiler() { ProfilerStop(); }
 
-void Heap::forceLink() {
-  // Currently this is here to force the inclusion of the heap profiler during static linking.
-  // Without this call the heap profiler will not be included and cannot be started via env
-  // variable. In the future we can add admin support.
-  HeapProfilerDump("");
+bool Heap::profilerEnabled() { return IsHeapProfilerRunning(); }
+
+bool Heap::startProfiler(const std::string& output_prefix) {
+  HeapProfilerStart(output_prefix.c_str());
+  return IsHeapProfilerRunning();
 }
 
+void Heap::dumpProfile(const std::string& reason) { HeapProfilerDump(reason.c_str()); }
+
+void Heap::stopProfiler() { HeapProfilerStop(); }
+
 } // namespace Profiler
 } // namespace Envoy
 
@@ -37,6 +41,11 @@ bool Cpu::profilerEnabled() { return false; }
 bool Cpu::startProfiler(const std::string&) { return false; }
 void Cpu::stopProfiler() {}
 
+bool Heap::profilerEnabled() { return false; }
+bool Heap::startProfiler(const std::string&) { return false; }
+void Heap::dumpProfile(const std::string&) {}
+void Heap::stopProfiler() {}
+
 } // namespace Profiler
 } // namespace Envoy
 
@@ -28,11 +28,33 @@ public:
 };
 
 /**
- * Process wide heap profiling
+ * Process wide heap profiling.
  */
 class Heap {
-private:
-  static void forceLink();
+public:
+  /**
+   * @return whether the profiler is enabled or not.
+   */
+  static bool profilerEnabled();
+
+  /**
+   * Start the profiler. Each profile is written to a file named after the prefix, with a sequence
+   * number and a .heap extension.
+   * @param output_prefix supplies the prefix of the profile files.
+   * @return bool whether the call to start the profiler succeeded.
+   */
+  static bool startProfiler(const std::string& output_prefix);
+
+  /**
+   * Write a profile of the heap as of now. The profiler must be enabled.
+   * @param reason supplies the reason for the profile, which is recorded in its file.
+   */
+  static void dumpProfile(const std::string& reason);
+
+  /**
+   * Stop the profiler.
+   */
+  static void stopProfiler();
 };
 
 } // namespace Profiler
@@ -0,0 +1,793 @@
+#include "common/protobuf/message_loader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "common/common/assert.h"
+
+// Do not let RapidJson leak outside of this file.
+#include "rapidjson/reader.h"
+#include "rapidjson/stream.h"
+
+#include "yaml-cpp/yaml.h"
+
+namespace Envoy {
+namespace {
+
+// The largest number of seconds of a google.protobuf.Duration, about 10,000 years.
+const uint64_t MAX_DURATION_SECONDS = 315576000000ULL;
+
+/**
+ * A scalar value of the document.
+ */
+struct Scalar {
+  enum class Type { Null, Bool, Int64, Uint64, Double, String };
+
+  explicit Scalar(Type type) : type_(type) {}
+
+  const Type type_;
+  bool bool_value_{};
+  int64_t int64_value_{};
+  uint64_t uint64_value_{};
+  double double_value_{};
+  std::string string_value_;
+};
+
+/**
+ * Well known types which have a JSON mapping of their own that isn't supported, so that they must
+ * not be treated as regular messages.
+ */
+const std::unordered_set<std::string>& unsupportedWellKnownTypes() {
+  static const std::unordered_set<std::string> types{
+      "google.protobuf.Any", "google.protobuf.FieldMask", "google.protobuf.Timestamp"};
+  return types;
+}
+
+/**
+ * Wrapper types, which map to the JSON value of their single "value" field.
+ */
+const std::unordered_set<std::string>& wrapperTypes() {
+  static const std::unordered_set<std::string> types{
+      "google.protobuf.BoolValue",   "google.protobuf.BytesValue",  "google.protobuf.DoubleValue",
+      "google.protobuf.FloatValue",  "google.protobuf.Int32Value",  "google.protobuf.Int64Value",
+      "google.protobuf.StringValue", "google.protobuf.UInt32Value", "google.protobuf.UInt64Value"};
+  return types;
+}
+
+bool parseInt64(const std::string& value, int64_t& out) {
+  if (value.empty() || !(std::isdigit(value[0]) || value[0] == '-')) {
+    return false;
+  }
+  char* end;
+  errno = 0;
+  out = std::strtoll(value.c_str(), &end, 10);
+  return errno == 0 && end == value.c_str() + value.size();
+}
+
+bool parseUint64(const std::string& value, uint64_t& out) {
+  if (value.empty() || !std::isdigit(value[0])) {
+    return false;
+  }
+  char* end;
+  errno = 0;
+  out = std::strtoull(value.c_str(), &end, 10);
+  return errno == 0 && end == value.c_str() + value.size();
+}
+
+/**
+ * Parse a google.protobuf.Duration, which is given in seconds with up to nine fractional digits
+ * and an "s" suffix, e.g. "1.5s".
+ */
+bool parseDuration(const std::string& value, int64_t& seconds, int32_t& nanos) {
+  if (value.size() < 2 || value.back() != 's') {
+    return false;
+  }
+  const size_t end = value.size() - 1;
+  size_t pos = 0;
+  const bool negative = value[0] == '-';
+  if (negative) {
+    pos++;
+  }
+
+  const size_t whole_start = pos;
+  uint64_t whole = 0;
+  for (; pos < end && std::isdigit(value[pos]); pos++) {
+    whole = whole * 10 + (value[pos] - '0');
+    if (whole > MAX_DURATION_SECONDS) {
+      return false;
+    }
+  }
+  if (pos == whole_start) {
+    return false;
+  }
+
+  int32_t fraction = 0;
+  uint32_t fraction_digits = 0;
+  if (pos < end && value[pos] == '.') {
+    for (pos++; pos < end && std::isdigit(value[pos]); pos++) {
+      if (++fraction_digits > 9) {
+        return false;
+      }
+      fraction = fraction * 10 + (value[pos] - '0');
+    }
+    if (fraction_digits == 0) {
+      return false;
+    }
+  }
+  if (pos != end) {
+    return false;
+  }
+  for (; fraction_digits < 9; fraction_digits++) {
+    fraction *= 10;
+  }
+
+  seconds = negative ? -static_cast<int64_t>(whole) : static_cast<int64_t>(whole);
+  nanos = negative ? -fraction : fraction;
+  return true;
+}
+
+/**
+ * Consumes parser events, in the form of rapidjson SAX callbacks, to write a message. Each callback
+ * returns false, which stops the parser, if the event can't be written.
+ */
+class MessageWriter : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, MessageWriter> {
+public:
+  MessageWriter(Protobuf::Message& root) : root_(root) {}
+
+  /**
+   * @return bool whether the whole document has been written.
+   */
+  bool done() const { return done_; }
+
+  bool Null() { return scalar(Scalar(Scalar::Type::Null)); }
+  bool Bool(bool value) {
+    Scalar scalar_value(Scalar::Type::Bool);
+    scalar_value.bool_value_ = value;
+    return scalar(scalar_value);
+  }
+  bool Int(int value) { return Int64(value); }
+  bool Uint(unsigned value) { return Int64(value); }
+  bool Int64(int64_t value) {
+    Scalar scalar_value(Scalar::Type::Int64);
+    scalar_value.int64_value_ = value;
+    return scalar(scalar_value);
+  }
+  bool Uint64(uint64_t value) {
+    if (value <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+      return Int64(static_cast<int64_t>(value));
+    }
+    Scalar scalar_value(Scalar::Type::Uint64);
+    scalar_value.uint64_value_ = value;
+    return scalar(scalar_value);
+  }
+  bool Double(double value) {
+    if (!std::isfinite(value)) {
+      return false;
+    }
+    Scalar scalar_value(Scalar::Type::Double);
+    scalar_value.double_value_ = value;
+    return scalar(scalar_value);
+  }
+  bool RawNumber(const char*, rapidjson::SizeType, bool) { return false; }
+  bool String(const char* value, rapidjson::SizeType length, bool) {
+    Scalar scalar_value(Scalar::Type::String);
+    scalar_value.string_value_.assign(value, length);
+    return scalar(scalar_value);
+  }
+  bool StartObject();
+  bool Key(const char* value, rapidjson::SizeType length, bool);
+  bool EndObject(rapidjson::SizeType);
+  bool StartArray();
+  bool EndArray(rapidjson::SizeType);
+
+private:
+  enum class FrameType {
+    // The fields of a message.
+    Message,
+    // The elements of a repeated field, or the values of a google.protobuf.ListValue.
+    Repeated,
+    // The entries of a map field, or the fields of a google.protobuf.Struct.
+    Map,
+  };
+
+  struct Frame {
+    Frame(FrameType type, Protobuf::Message& message, const Protobuf::FieldDescriptor* field)
+        : type_(type), message_(&message), field_(field) {}
+
+    const FrameType type_;
+    // The message of a Message frame, or the message with the repeated or map field.
+    Protobuf::Message* message_;
+    // The repeated or map field, or the field of a Message frame that the next value is for.
+    const Protobuf::FieldDescriptor* field_;
+    // The key that the next value of a Map frame is for.
+    std::string key_;
+    // The fields of a Message frame which have been given, to reject duplicates.
+    std::vector<const Protobuf::FieldDescriptor*> given_fields_;
+  };
+
+  /**
+   * Where the next value goes: a field of a message, to which the value is appended if add_ is set.
+   */
+  struct Target {
+    Protobuf::Message* message_;
+    const Protobuf::FieldDescriptor* field_;
+    bool add_;
+  };
+
+  bool nextTarget(Target& target);
+  void valueComplete();
+  bool scalar(const Scalar& value);
+  bool writeScalar(const Target& target, const Scalar& value);
+  bool writeWellKnown(const Target& target, const Scalar& value);
+  const Protobuf::FieldDescriptor* findField(const Protobuf::Descriptor& descriptor,
+                                             const std::string& name);
+
+  static Protobuf::Message& mutableMessage(const Target& target) {
+    const Protobuf::Reflection* reflection = target.message_->GetReflection();
+    return target.add_ ? *reflection->AddMessage(target.message_, target.field_)
+                       : *reflection->MutableMessage(target.message_, target.field_);
+  }
+  static bool setMapKey(Protobuf::Message& entry, const std::string& key);
+  static void setValue(Protobuf::Message& value, const Scalar& scalar_value);
+  static bool toInt64(const Scalar& value, int64_t& out);
+  static bool toUint64(const Scalar& value, uint64_t& out);
+  static bool toDouble(const Scalar& value, double& out);
+
+  Protobuf::Message& root_;
+  std::vector<Frame> stack_;
+  bool done_{};
+  std::unordered_map<const Protobuf::Descriptor*,
+                     std::unordered_map<std::string, const Protobuf::FieldDescriptor*>>
+      fields_by_name_;
+};
+
+bool MessageWriter::StartObject() {
+  if (stack_.empty()) {
+    const std::string& type = root_.GetDescriptor()->full_name();
+    if (done_ || type.compare(0, 16, "google.protobuf.") == 0) {
+      return false;
+    }
+    stack_.emplace_back(FrameType::Message, root_, nullptr);
+    return true;
+  }
+
+  Target target;
+  if (!nextTarget(target)) {
+    return false;
+  }
+  const Protobuf::FieldDescriptor& field = *target.field_;
+  if (!target.add_ && field.is_map()) {
+    stack_.emplace_back(FrameType::Map, *target.message_, &field);
+    return true;
+  }
+  // A single value of a repeated field is the same as a list of that value.
+  target.add_ = field.is_repeated();
+  if (field.cpp_type() != Protobuf::FieldDescriptor::CPPTYPE_MESSAGE) {
+    return false;
+  }
+
+  const std::string& type = field.message_type()->full_name();
+  if (unsupportedWellKnownTypes().count(type) > 0 || wrapperTypes().count(type) > 0 ||
+      type == "google.protobuf.Duration" || type == "google.protobuf.ListValue") {
+    return false;
+  }
+  Protobuf::Message& message = mutableMessage(target);
+  if (type == "google.protobuf.Struct") {
+    stack_.emplace_back(FrameType::Map, message,
+                        message.GetDescriptor()->FindFieldByName("fields"));
+  } else if (type == "google.protobuf.Value") {
+    const Protobuf::FieldDescriptor* struct_field =
+        message.GetDescriptor()->FindFieldByName("struct_value");
+    Protobuf::Message& struct_value =
+        *message.GetReflection()->MutableMessage(&message, struct_field);
+    stack_.emplace_back(FrameType::Map, struct_value,
+                        struct_value.GetDescriptor()->FindFieldByName("fields"));
+  } else {
+    stack_.emplace_back(FrameType::Message, message, nullptr);
+  }
+  return true;
+}
+
+bool MessageWriter::Key(const char* value, rapidjson::SizeType length, bool) {
+  if (stack_.empty()) {
+    return false;
+  }
+  Frame& frame = stack_.back();
+  if (frame.type_ == FrameType::Map) {
+    frame.key_.assign(value, length);
+    return true;
+  }
+  if (frame.type_ != FrameType::Message) {
+    return false;
+  }
+
+  const Protobuf::FieldDescriptor* field =
+      findField(*frame.message_->GetDescriptor(), std::string(value, length));
+  if (field == nullptr ||
+      std::find(frame.given_fields_.begin(), frame.given_fields_.end(), field) !=
+          frame.given_fields_.end()) {
+    return false;
+  }
+  // Only one field of a oneof may be given.
+  if (field->containing_oneof() != nullptr &&
+      frame.message_->GetReflection()->HasOneof(*frame.message_, field->containing_oneof())) {
+    return false;
+  }
+  frame.given_fields_.push_back(field);
+  frame.field_ = field;
+  return true;
+}
+
+bool MessageWriter::EndObject(rapidjson::SizeType) {
+  if (stack_.empty() || stack_.back().type_ == FrameType::Repeated) {
+    return false;
+  }
+  stack_.pop_back();
+  if (stack_.empty()) {
+    done_ = true;
+  } else {
+    valueComplete();
+  }
+  return true;
+}
+
+bool MessageWriter::StartArray() {
+  Target target;
+  if (!nextTarget(target)) {
+    return false;
+  }
+  const Protobuf::FieldDescriptor& field = *target.field_;
+  if (!target.add_ && field.is_repeated()) {
+    if (field.is_map()) {
+      return false;
+    }
+    stack_.emplace_back(FrameType::Repeated, *target.message_, &field);
+    return true;
+  }
+  if (field.cpp_type() != Protobuf::FieldDescriptor::CPPTYPE_MESSAGE) {
+    return false;
+  }
+
+  const std::string& type = field.message_type()->full_name();
+  if (type != "google.protobuf.ListValue" && type != "google.protobuf.Value") {
+    return false;
+  }
+  Protobuf::Message* list_value = &mutableMessage(target);
+  if (type == "google.protobuf.Value") {
+    list_value = list_value->GetReflection()->MutableMessage(
+        list_value, list_value->GetDescriptor()->FindFieldByName("list_value"));
+  }
+  stack_.emplace_back(FrameType::Repeated, *list_value,
+                      list_value->GetDescriptor()->FindFieldByName("values"));
+  return true;
+}
+
+bool MessageWriter::EndArray(rapidjson::SizeType) {
+  if (stack_.empty() || stack_.back().type_ != FrameType::Repeated) {
+    return false;
+  }
+  stack_.pop_back();
+  valueComplete();
+  return true;
+}
+
+bool MessageWriter::nextTarget(Target& target) {
+  if (stack_.empty()) {
+    return false;
+  }
+  Frame& frame = stack_.back();
+  switch (frame.type_) {
+  case FrameType::Message:
+    if (frame.field_ == nullptr) {
+      return false;
+    }
+    target = {frame.message_, frame.field_, false};
+    return true;
+  case FrameType::Repeated:
+    target = {frame.message_, frame.field_, true};
+    return true;
+  case FrameType::Map: {
+    // Map entries are messages with the key as field 1 and the value as field 2.
+    Protobuf::Message* entry =
+        frame.message_->GetReflection()->AddMessage(frame.message_, frame.field_);
+    if (!setMapKey(*entry, frame.key_)) {
+      return false;
+    }
+    target = {entry, entry->GetDescriptor()->FindFieldByNumber(2), false};
+    return true;
+  }
+  }
+
+  NOT_REACHED;
+}
+
+void MessageWriter::valueComplete() {
+  Frame& frame = stack_.back();
+  if (frame.type_ == FrameType::Message) {
+    frame.field_ = nullptr;
+  } else if (frame.type_ == FrameType::Map) {
+    frame.key_.clear();
+  }
+}
+
+bool MessageWriter::scalar(const Scalar& value) {
+  Target target;
+  if (!nextTarget(target)) {
+    return false;
+  }
+  const Protobuf::FieldDescriptor& field = *target.field_;
+  const bool value_field = field.cpp_type() == Protobuf::FieldDescriptor::CPPTYPE_MESSAGE &&
+                           field.message_type()->full_name() == "google.protobuf.Value";
+
+  // A null field of a message is the same as a field which isn't given, unless it is a
+  // google.protobuf.Value, which can hold a null.
+  if (value.type_ == Scalar::Type::Null && stack_.back().type_ == FrameType::Message &&
+      (field.is_repeated() || !value_field)) {
+    valueComplete();
+    return true;
+  }
+  target.add_ = field.is_repeated();
+
+  const bool written = field.cpp_type() == Protobuf::FieldDescriptor::CPPTYPE_MESSAGE
+                           ? writeWellKnown(target, value)
+                           : writeScalar(target, value);
+  if (written) {
+    valueComplete();
+  }
+  return written;
+}
+
+bool MessageWriter::writeScalar(const Target& target, const Scalar& value) {
+  const Protobuf::FieldDescriptor* field = target.field_;
+  Protobuf::Message* message = target.message_;
+  const Protobuf::Reflection* reflection = message->GetReflection();
+
+  switch (field->cpp_type()) {
+  case Protobuf::FieldDescriptor::CPPTYPE_INT32: {
+    int64_t int_value;
+    if (!toInt64(value, int_value) || int_value < std::numeric_limits<int32_t>::min() ||
+        int_value > std::numeric_limits<int32_t>::max()) {
+      return false;
+    }
+    target.add_ ? reflection->AddInt32(message, field, int_value)
+                : reflection->SetInt32(message, field, int_value);
+    return true;
+  }
+  case Protobuf::FieldDescriptor::CPPTYPE_INT64: {
+    int64_t int_value;
+    if (!toInt64(value, int_value)) {
+      return false;
+    }
+    target.add_ ? reflection->AddInt64(message, field, int_value)
+                : reflection->SetInt64(message, field, int_value);
+    return true;
+  }
+  case Protobuf::FieldDescriptor::CPPTYPE_UINT32: {
+    uint64_t uint_value;
+    if (!toUint64(value, uint_value) || uint_value > std::numeric_limits<uint32_t>::max()) {
+      return false;
+    }
+    target.add_ ? reflection->AddUInt32(message, field, uint_value)
+                : reflection->SetUInt32(message, field, uint_value);
+    return true;
+  }
+  case Protobuf::FieldDescriptor::CPPTYPE_UINT64: {
+    uint64_t uint_value;
+    if (!toUint64(value, uint_value)) {
+      return false;
+    }
+    target.add_ ? reflection->AddUInt64(message, field, uint_value)
+                : reflection->SetUInt64(message, field, uint_value);
+    return true;
+  }
+  case Protobuf::FieldDescriptor::CPPTYPE_DOUBLE: {
+    double double_value;
+    if (!toDouble(value, double_value)) {
+      return false;
+    }
+    target.add_ ? reflection->AddDouble(message, field, double_value)
+                : reflection->SetDouble(message, field, double_value);
+    return true;
+  }
+  case Protobuf::FieldDescriptor::CPPTYPE_FLOAT: {
+    double double_value;
+    if (!toDouble(value, double_value) || std::fabs(double_value) > FLT_MAX) {
+      return false;
+    }
+    target.add_ ? reflection->AddFloat(message, field, double_value)
+                : reflection->SetFloat(message, field, double_value);
+    return true;
+  }
+  case Protobuf::FieldDescriptor::CPPTYPE_BOOL:
+    if (value.type_ != Scalar::Type::Bool) {
+      return false;
+    }
+    target.add_ ? reflection->AddBool(message, field, value.bool_value_)
+                : reflection->SetBool(message, field, value.bool_value_);
+    return true;
+  case Protobuf::FieldDescriptor::CPPTYPE_STRING:
+    // Bytes are base64 encoded.
+    if (value.type_ != Scalar::Type::String ||
+        field->type() == Protobuf::FieldDescriptor::TYPE_BYTES) {
+      return false;
+    }
+    target.add_ ? reflection->AddString(message, field, value.string_value_)
+                : reflection->SetString(message, field, value.string_value_);
+    return true;
+  case Protobuf::FieldDescriptor::CPPTYPE_ENUM: {
+    const Protobuf::EnumValueDescriptor* enum_value = nullptr;
+    if (value.type_ == Scalar::Type::String) {
+      enum_value = field->enum_type()->FindValueByName(value.string_value_);
+    } else if (value.type_ == Scalar::Type::Int64 &&
+               value.int64_value_ >= std::numeric_limits<int32_t>::min() &&
+               value.int64_value_ <= std::numeric_limits<int32_t>::max()) {
+      enum_value = field->enum_type()->FindValueByNumber(value.int64_value_);
+    }
+    if (enum_value == nullptr) {
+      return false;
+    }
+    target.add_ ? reflection->AddEnum(message, field, enum_value)
+                : reflection->SetEnum(message, field, enum_value);
+    return true;
+  }
+  case Protobuf::FieldDescriptor::CPPTYPE_MESSAGE:
+    return false;
+  }
+
+  NOT_REACHED;
+}
+
+bool MessageWriter::writeWellKnown(const Target& target, const Scalar& value) {
+  const std::string& type = target.field_->message_type()->full_name();
+  if (type == "google.protobuf.Value") {
+    setValue(mutableMessage(target), value);
+    return true;
+  }
+  if (wrapperTypes().count(type) > 0) {
+    Protobuf::Message& wrapper = mutableMessage(target);
+    return writeScalar({&wrapper, wrapper.GetDescriptor()->FindFieldByNumber(1), false}, value);
+  }
+  if (type == "google.protobuf.Duration") {
+    int64_t seconds;
+    int32_t nanos;
+    if (value.type_ != Scalar::Type::String ||
+        !parseDuration(value.string_value_, seconds, nanos)) {
+      return false;
+    }
+    Protobuf::Message& duration = mutableMessage(target);
+    const Protobuf::Descriptor* descriptor = duration.GetDescriptor();
+    duration.GetReflection()->SetInt64(&duration, descriptor->FindFieldByName("seconds"), seconds);
+    duration.GetReflection()->SetInt32(&duration, descriptor->FindFieldByName("nanos"), nanos);
+    return true;
+  }
+  return false;
+}
+
+const Protobuf::FieldDescriptor* MessageWriter::findField(const Protobuf::Descriptor& descriptor,
+                                                          const std::string& name) {
+  // Fields are given by either their proto name or their JSON name.
+  auto& fields = fields_by_name_[&descriptor];
+  if (fields.empty()) {
+    for (int i = 0; i < descriptor.field_count(); i++) {
+      const Protobuf::FieldDescriptor* field = descriptor.field(i);
+      fields.emplace(field->name(), field);
+      fields.emplace(field->json_name(), field);
+    }
+  }
+  auto it = fields.find(name);
+  return it != fields.end() ? it->second : nullptr;
+}
+
+bool MessageWriter::setMapKey(Protobuf::Message& entry, const std::string& key) {
+  const Protobuf::FieldDescriptor* field = entry.GetDescriptor()->FindFieldByNumber(1);
+  const Protobuf::Reflection* reflection = entry.GetReflection();
+  int64_t int_value;
+  uint64_t uint_value;
+  switch (field->cpp_type()) {
+  case Protobuf::FieldDescriptor::CPPTYPE_STRING:
+    reflection->SetString(&entry, field, key);
+    return true;
+  case Protobuf::FieldDescriptor::CPPTYPE_INT32:
+    if (!parseInt64(key, int_value) || int_value < std::numeric_limits<int32_t>::min() ||
+        int_value > std::numeric_limits<int32_t>::max()) {
+      return false;
+    }
+    reflection->SetInt32(&entry, field, int_value);
+    return true;
+  case Protobuf::FieldDescriptor::CPPTYPE_INT64:
+    if (!parseInt64(key, int_value)) {
+      return false;
+    }
+    reflection->SetInt64(&entry, field, int_value);
+    return true;
+  case Protobuf::FieldDescriptor::CPPTYPE_UINT32:
+    if (!parseUint64(key, uint_value) || uint_value > std::numeric_limits<uint32_t>::max()) {
+      return false;
+    }
+    reflection->SetUInt32(&entry, field, uint_value);
+    return true;
+  case Protobuf::FieldDescriptor::CPPTYPE_UINT64:
+    if (!parseUint64(key, uint_value)) {
+      return false;
+    }
+    reflection->SetUInt64(&entry, field, uint_value);
+    return true;
+  case Protobuf::FieldDescriptor::CPPTYPE_BOOL:
+    if (key != "true" && key != "false") {
+      return false;
+    }
+    reflection->SetBool(&entry, field, key == "true");
+    return true;
+  default:
+    return false;
+  }
+}
+
+void MessageWriter::setValue(Protobuf::Message& value, const Scalar& scalar_value) {
+  const Protobuf::Descriptor* descriptor = value.GetDescriptor();
+  const Protobuf::Reflection* reflection = value.GetReflection();
+  switch (scalar_value.type_) {
+  case Scalar::Type::Null: {
+    const Protobuf::FieldDescriptor* field = descriptor->FindFieldByName("null_value");
+    reflection->SetEnum(&value, field, field->enum_type()->FindValueByNumber(0));
+    return;
+  }
+  case Scalar::Type::Bool:
+    reflection->SetBool(&value, descriptor->FindFieldByName("bool_value"),
+                        scalar_value.bool_value_);
+    return;
+  case Scalar::Type::Int64:
+  case Scalar::Type::Uint64:
+  case Scalar::Type::Double: {
+    double number;
+    toDouble(scalar_value, number);
+    reflection->SetDouble(&value, descriptor->FindFieldByName("number_value"), number);
+    return;
+  }
+  case Scalar::Type::String:
+    reflection->SetString(&value, descriptor->FindFieldByName("string_value"),
+                          scalar_value.string_value_);
+    return;
+  }
+
+  NOT_REACHED;
+}
+
+bool MessageWriter::toInt64(const Scalar& value, int64_t& out) {
+  switch (value.type_) {
+  case Scalar::Type::Int64:
+    out = value.int64_value_;
+    return true;
+  case Scalar::Type::String:
+    // 64 bit integers are usually given as strings, as doubles can't represent all of them.
+    return parseInt64(value.string_value_, out);
+  default:
+    return false;
+  }
+}
+
+bool MessageWriter::toUint64(const Scalar& value, uint64_t& out) {
+  switch (value.type_) {
+  case Scalar::Type::Int64:
+    if (value.int64_value_ < 0) {
+      return false;
+    }
+    out = value.int64_value_;
+    return true;
+  case Scalar::Type::Uint64:
+    out = value.uint64_value_;
+    return true;
+  case Scalar::Type::String:
+    return parseUint64(value.string_value_, out);
+  default:
+    return false;
+  }
+}
+
+bool MessageWriter::toDouble(const Scalar& value, double& out) {
+  switch (value.type_) {
+  case Scalar::Type::Int64:
+    out = value.int64_value_;
+    return true;
+  case Scalar::Type::Uint64:
+    out = value.uint64_value_;
+    return true;
+  case Scalar::Type::Double:
+    out = value.double_value_;
+    return true;
+  default:
+    return false;
+  }
+}
+
+/**
+ * Emit a YAML node as parser events to a writer. Scalars are typed like in
+ * Json::Factory::loadFromYamlString().
+ */
+bool writeYamlNode(const YAML::Node& node, MessageWriter& writer) {
+  switch (node.Type()) {
+  case YAML::NodeType::Null:
+    return writer.Null();
+  case YAML::NodeType::Scalar: {
+    const std::string value = node.as<std::string>();
+    if (node.Tag() == "!") {
+      return writer.String(value.c_str(), value.size(), true);
+    }
+    bool bool_value;
+    if (YAML::convert<bool>::decode(node, bool_value)) {
+      return writer.Bool(bool_value);
+    }
+    int64_t int_value;
+    if (YAML::convert<int64_t>::decode(node, int_value)) {
+      return writer.Int64(int_value);
+    }
+    double double_value;
+    if (YAML::convert<double>::decode(node, double_value)) {
+      return writer.Double(double_value);
+    }
+    return writer.String(value.c_str(), value.size(), true);
+  }
+  case YAML::NodeType::Sequence:
+    if (!writer.StartArray()) {
+      return false;
+    }
+    for (const auto& it : node) {
+      if (!writeYamlNode(it, writer)) {
+        return false;
+      }
+    }
+    return writer.EndArray(node.size());
+  case YAML::NodeType::Map:
+    if (!writer.StartObject()) {
+      return false;
+    }
+    for (const auto& it : node) {
+      const std::string key = it.first.as<std::string>();
+      if (!writer.Key(key.c_str(), key.size(), true) || !writeYamlNode(it.second, writer)) {
+        return false;
+      }
+    }
+    return writer.EndObject(node.size());
+  case YAML::NodeType::Undefined:
+    return false;
+  }
+
+  NOT_REACHED;
+}
+
+} // namespace
+
+bool MessageLoader::loadFromJson(const std::string& json, Protobuf::Message& message) {
+  // The stream ends at the first null character, which would hide whatever follows it.
+  if (std::strlen(json.c_str()) != json.size()) {
+    return false;
+  }
+  message.Clear();
+  MessageWriter writer(message);
+  rapidjson::Reader reader;
+  rapidjson::StringStream stream(json.c_str());
+  return !reader.Parse<rapidjson::kParseValidateEncodingFlag>(stream, writer).IsError() &&
+         writer.done();
+}
+
+bool MessageLoader::loadFromYaml(const std::string& yaml, Protobuf::Message& message) {
+  message.Clear();
+  MessageWriter writer(message);
+  try {
+    return writeYamlNode(YAML::Load(yaml), writer) && writer.done();
+  } catch (const YAML::Exception&) {
+    return false;
+  }
+}
+
+} // namespace Envoy
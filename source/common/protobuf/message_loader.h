@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+
+#include "common/protobuf/protobuf.h"
+
+namespace Envoy {
+
+/**
+ * Loads JSON and YAML into a message in a single pass, by streaming the parser events straight into
+ * the message through reflection, without an intermediate document or JSON string. Only the common
+ * subset of the proto3 JSON mapping is supported: messages, repeated fields, maps, scalars, enums
+ * by name or number, wrappers, Duration, Struct, Value and ListValue. Anything else, such as Any,
+ * bytes or integers given as doubles, makes the load fail, as does any invalid input, so that the
+ * caller can fall back on the full mapping for both the result and the error.
+ */
+class MessageLoader {
+public:
+  /**
+   * Load a JSON document into a message.
+   * @param json supplies the document.
+   * @param message supplies the message, which is cleared first.
+   * @return bool whether the document was loaded. If not, the message is left in an unspecified
+   *         state.
+   */
+  static bool loadFromJson(const std::string& json, Protobuf::Message& message);
+
+  /**
+   * Load a YAML document into a message. Scalars are typed with the same heuristics as
+   * Json::Factory::loadFromYamlString().
+   * @param yaml supplies the document.
+   * @param message supplies the message, which is cleared first.
+   * @return bool whether the document was loaded. If not, the message is left in an unspecified
+   *         state.
+   */
+  static bool loadFromYaml(const std::string& yaml, Protobuf::Message& message);
+};
+
+} // namespace Envoy
@@ -1,14 +1,30 @@
 #include "common/protobuf/utility.h"
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "common/common/assert.h"
 #include "common/filesystem/filesystem_impl.h"
 #include "common/json/json_loader.h"
+#include "common/protobuf/message_loader.h"
 #include "common/protobuf/protobuf.h"
 
 #include "fmt/format.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
 
 namespace Envoy {
 
+namespace {
+
+Protobuf::util::TypeResolver& generatedPoolTypeResolver() {
+  static Protobuf::util::TypeResolver* resolver = Protobuf::util::NewTypeResolverForDescriptorPool(
+      "type.googleapis.com", Protobuf::DescriptorPool::generated_pool());
+  return *resolver;
+}
+
+} // namespace
+
 MissingFieldException::MissingFieldException(const std::string& field_name,
                                              const Protobuf::Message& message)
     : EnvoyException(
@@ -22,13 +38,60 @@ ProtoValidationException::ProtoValidationException(const std::string& validation
 }
 
 void MessageUtil::loadFromJson(const std::string& json, Protobuf::Message& message) {
+  if (MessageLoader::loadFromJson(json, message)) {
+    return;
+  }
+  // Fall back on the full JSON mapping, which also gives the error if the JSON is invalid.
   const auto status = Protobuf::util::JsonStringToMessage(json, &message);
   if (!status.ok()) {
     throw EnvoyException("Unable to parse JSON as proto (" + status.ToString() + "): " + json);
   }
 }
 
+void MessageUtil::loadFromJson(const Buffer::Instance& json, Protobuf::Message& message) {
+  const Protobuf::Descriptor* descriptor = message.GetDescriptor();
+  if (descriptor->file()->pool() != Protobuf::DescriptorPool::generated_pool()) {
+    std::string contents(json.length(), 0);
+    json.copyOut(0, json.length(), &contents[0]);
+    loadFromJson(contents, message);
+    return;
+  }
+
+  // The slices are chained into one input stream, which is converted to the binary
+  // representation of the message as it is parsed.
+  const uint64_t num_slices = json.getRawSlices(nullptr, 0);
+  std::vector<Buffer::RawSlice> slices(num_slices);
+  json.getRawSlices(slices.data(), num_slices);
+  std::vector<std::unique_ptr<Protobuf::io::ArrayInputStream>> slice_streams;
+  std::vector<Protobuf::io::ZeroCopyInputStream*> streams;
+  for (const Buffer::RawSlice& slice : slices) {
+    slice_streams.emplace_back(
+        new Protobuf::io::ArrayInputStream(slice.mem_, static_cast<int>(slice.len_)));
+    streams.push_back(slice_streams.back().get());
+  }
+  Protobuf::io::ConcatenatingInputStream input(streams.data(), static_cast<int>(streams.size()));
+
+  ProtobufTypes::String binary;
+  Protobuf::util::Status status;
+  {
+    // For memory safety, the StringOutputStream needs to be destroyed before we read the string.
+    Protobuf::io::StringOutputStream output(&binary);
+    status = Protobuf::util::JsonToBinaryStream(
+        &generatedPoolTypeResolver(), "type.googleapis.com/" + descriptor->full_name(), &input,
+        &output);
+  }
+  if (!status.ok()) {
+    throw EnvoyException("Unable to parse JSON as proto (" + status.ToString() + ")");
+  }
+  if (!message.ParseFromString(binary)) {
+    throw EnvoyException("Unable to parse JSON as proto (type " + message.GetTypeName() + ")");
+  }
+}
+
 void MessageUtil::loadFromYaml(const std::string& yaml, Protobuf::Message& message) {
+  if (MessageLoader::loadFromYaml(yaml, message)) {
+    return;
+  }
   const std::string json = Json::Factory::loadFromYamlString(yaml)->asJsonString();
   loadFromJson(json, message);
 }
@@ -2,6 +2,7 @@
 
 #include <numeric>
 
+#include "envoy/buffer/buffer.h"
 #include "envoy/common/exception.h"
 #include "envoy/json/json_object.h"
 
@@ -113,6 +114,14 @@ public:
   }
 
   static void loadFromJson(const std::string& json, Protobuf::Message& message);
+  /**
+   * Load the JSON contents of a buffer into a message, reading the slices of the buffer in place
+   * rather than copying them into a string.
+   * @param json supplies the buffer.
+   * @param message supplies the message.
+   * @throw EnvoyException if the contents are not the JSON representation of the message.
+   */
+  static void loadFromJson(const Buffer::Instance& json, Protobuf::Message& message);
   static void loadFromYaml(const std::string& yaml, Protobuf::Message& message);
   static void loadFromFile(const std::string& path, Protobuf::Message& message);
 
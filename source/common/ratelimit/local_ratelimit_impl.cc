@@ -0,0 +1,77 @@
+#include "common/ratelimit/local_ratelimit_impl.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Envoy {
+namespace RateLimit {
+
+LocalRateLimiterImpl::LocalRateLimiterImpl(
+    std::chrono::milliseconds fill_interval, const TokenBucket& default_bucket,
+    const std::vector<std::pair<Descriptor, TokenBucket>>& descriptors,
+    ThreadLocal::SlotAllocator& tls)
+    : buckets_({default_bucket}), tls_slot_(tls.allocateSlot()) {
+  for (const auto& descriptor : descriptors) {
+    descriptors_.push_back(descriptor.first);
+    buckets_.push_back(descriptor.second);
+  }
+
+  std::vector<TokenBucket> buckets = buckets_;
+  tls_slot_->set([buckets, fill_interval](
+                     Event::Dispatcher& dispatcher) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<ThreadLocalBuckets>(buckets, fill_interval, dispatcher);
+  });
+}
+
+bool LocalRateLimiterImpl::requestAllowed(const std::vector<Descriptor>& descriptors) {
+  size_t bucket = 0;
+  for (size_t i = 0; i < descriptors_.size() && bucket == 0; i++) {
+    for (const Descriptor& descriptor : descriptors) {
+      if (descriptorsEqual(descriptors_[i], descriptor)) {
+        bucket = i + 1;
+        break;
+      }
+    }
+  }
+
+  uint32_t& tokens = tls_slot_->getTyped<ThreadLocalBuckets>().tokens_[bucket];
+  if (tokens == 0) {
+    return false;
+  }
+
+  tokens--;
+  return true;
+}
+
+bool LocalRateLimiterImpl::descriptorsEqual(const Descriptor& lhs, const Descriptor& rhs) {
+  return lhs.entries_.size() == rhs.entries_.size() &&
+         std::equal(lhs.entries_.begin(), lhs.entries_.end(), rhs.entries_.begin(),
+                    [](const DescriptorEntry& lhs, const DescriptorEntry& rhs) -> bool {
+                      return lhs.key_ == rhs.key_ && lhs.value_ == rhs.value_;
+                    });
+}
+
+LocalRateLimiterImpl::ThreadLocalBuckets::ThreadLocalBuckets(
+    const std::vector<TokenBucket>& buckets, std::chrono::milliseconds fill_interval,
+    Event::Dispatcher& dispatcher)
+    : buckets_(buckets), fill_interval_(fill_interval),
+      fill_timer_(dispatcher.createTimer([this]() -> void { refill(); })) {
+  for (const TokenBucket& bucket : buckets_) {
+    tokens_.push_back(bucket.max_tokens_);
+  }
+  fill_timer_->enableTimer(fill_interval_);
+}
+
+void LocalRateLimiterImpl::ThreadLocalBuckets::refill() {
+  for (size_t i = 0; i < buckets_.size(); i++) {
+    const uint64_t tokens = static_cast<uint64_t>(tokens_[i]) + buckets_[i].tokens_per_fill_;
+    tokens_[i] = std::min<uint64_t>(tokens, buckets_[i].max_tokens_);
+  }
+  fill_timer_->enableTimer(fill_interval_);
+}
+
+} // namespace RateLimit
+} // namespace Envoy
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
+#include "envoy/ratelimit/ratelimit.h"
+#include "envoy/thread_local/thread_local.h"
+
+namespace Envoy {
+namespace RateLimit {
+
+/**
+ * Settings of a token bucket of the local rate limiter.
+ */
+struct TokenBucket {
+  // Tokens the bucket starts with and never exceeds.
+  uint32_t max_tokens_;
+  // Tokens added to the bucket at each fill interval.
+  uint32_t tokens_per_fill_;
+};
+
+/**
+ * Rate limits requests with token buckets held by each worker, which a timer on the worker refills
+ * at a fixed interval, so that no network call is needed to make a decision. A request which has
+ * one of the configured descriptors takes a token from the bucket of the first such descriptor,
+ * and any other request takes one from the default bucket. As each worker has its own buckets, the
+ * limits are per worker.
+ */
+class LocalRateLimiterImpl {
+public:
+  /**
+   * @param fill_interval supplies the interval at which the buckets are refilled.
+   * @param default_bucket supplies the bucket of the requests without a configured descriptor.
+   * @param descriptors supplies the descriptors with their own buckets.
+   * @param tls supplies the slot allocator for the per worker buckets.
+   */
+  LocalRateLimiterImpl(std::chrono::milliseconds fill_interval, const TokenBucket& default_bucket,
+                       const std::vector<std::pair<Descriptor, TokenBucket>>& descriptors,
+                       ThreadLocal::SlotAllocator& tls);
+
+  /**
+   * Take a token for a request from the buckets of the current thread.
+   * @param descriptors supplies the descriptors of the request, which may be empty.
+   * @return bool whether the request is within the limit.
+   */
+  bool requestAllowed(const std::vector<Descriptor>& descriptors);
+
+  /**
+   * @return bool whether any descriptor has its own bucket, and so whether the descriptors of the
+   *         requests are needed.
+   */
+  bool hasDescriptors() const { return !descriptors_.empty(); }
+
+  /**
+   * @return bool whether two descriptors have the same entries, in the same order.
+   */
+  static bool descriptorsEqual(const Descriptor& lhs, const Descriptor& rhs);
+
+private:
+  struct ThreadLocalBuckets : public ThreadLocal::ThreadLocalObject {
+    ThreadLocalBuckets(const std::vector<TokenBucket>& buckets,
+                       std::chrono::milliseconds fill_interval, Event::Dispatcher& dispatcher);
+
+    void refill();
+
+    const std::vector<TokenBucket> buckets_;
+    const std::chrono::milliseconds fill_interval_;
+    // Tokens left in each bucket, in the order of buckets_.
+    std::vector<uint32_t> tokens_;
+    Event::TimerPtr fill_timer_;
+  };
+
+  // The default bucket, followed by the buckets of descriptors_.
+  std::vector<TokenBucket> buckets_;
+  std::vector<Descriptor> descriptors_;
+  ThreadLocal::SlotPtr tls_slot_;
+};
+
+} // namespace RateLimit
+} // namespace Envoy
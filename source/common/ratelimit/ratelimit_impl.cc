@@ -6,19 +6,120 @@
 #include <vector>
 
 #include "common/common/assert.h"
+#include "common/common/utility.h"
 #include "common/grpc/async_client_impl.h"
 #include "common/http/headers.h"
+#include "common/tracing/http_tracer_impl.h"
 
 #include "fmt/format.h"
 
 namespace Envoy {
 namespace RateLimit {
 
+namespace {
+
+const Protobuf::MethodDescriptor& serviceMethod() {
+  return *Protobuf::DescriptorPool::generated_pool()->FindMethodByName(
+      "pb.lyft.ratelimit.RateLimitService.ShouldRateLimit");
+}
+
+} // namespace
+
+QuotaLeaseCache::QuotaLeaseCache(const QuotaLeaseConfig& config,
+                                 RateLimitAsyncClientPtr&& async_client,
+                                 MonotonicTimeSource& time_source)
+    : config_(config), async_client_(std::move(async_client)), time_source_(time_source),
+      service_method_(serviceMethod()) {}
+
+std::string QuotaLeaseCache::leaseKey(const std::string& domain,
+                                      const std::vector<Descriptor>& descriptors) {
+  // Header values and the other sources of descriptor entries can't contain these separators.
+  std::string key = domain;
+  for (const Descriptor& descriptor : descriptors) {
+    key.push_back('\0');
+    for (const DescriptorEntry& entry : descriptor.entries_) {
+      key.append(entry.key_);
+      key.push_back('\1');
+      key.append(entry.value_);
+      key.push_back('\2');
+    }
+  }
+  return key;
+}
+
+bool QuotaLeaseCache::tryAcquire(const std::string& key) {
+  auto it = leases_.find(key);
+  if (it == leases_.end()) {
+    return false;
+  }
+
+  Lease& lease = *it->second;
+  if (lease.expiry_ <= time_source_.currentTime()) {
+    // Keep the lease if a refresh may still renew it.
+    if (lease.refresh_ == nullptr) {
+      leases_.erase(it);
+    }
+    return false;
+  }
+  if (lease.hits_ == 0) {
+    return false;
+  }
+
+  lease.hits_--;
+  if (lease.hits_ <= config_.lease_size_ / 2 && lease.refresh_ == nullptr) {
+    lease.refresh();
+  }
+  return true;
+}
+
+void QuotaLeaseCache::grant(const std::string& key,
+                            const pb::lyft::ratelimit::RateLimitRequest& request) {
+  if (!canLease(key)) {
+    return;
+  }
+
+  std::unique_ptr<Lease>& lease = leases_[key];
+  if (lease == nullptr) {
+    lease.reset(new Lease(*this, request));
+  }
+  lease->hits_ += config_.lease_size_;
+  lease->expiry_ = time_source_.currentTime() + config_.duration_;
+}
+
+QuotaLeaseCache::Lease::Lease(QuotaLeaseCache& parent,
+                              const pb::lyft::ratelimit::RateLimitRequest& request)
+    : parent_(parent), request_(request) {}
+
+QuotaLeaseCache::Lease::~Lease() {
+  if (refresh_ != nullptr) {
+    refresh_->cancel();
+  }
+}
+
+void QuotaLeaseCache::Lease::refresh() {
+  const Optional<std::chrono::milliseconds> timeout(parent_.config_.duration_);
+  refresh_ = parent_.async_client_->send(parent_.service_method_, request_, *this,
+                                         Tracing::NullSpan::instance(), timeout);
+}
+
+void QuotaLeaseCache::Lease::onSuccess(
+    std::unique_ptr<pb::lyft::ratelimit::RateLimitResponse>&& response, Tracing::Span&) {
+  refresh_ = nullptr;
+  if (response->overall_code() == pb::lyft::ratelimit::RateLimitResponse_Code_OVER_LIMIT) {
+    // The descriptors are at their limit, so stop spending the hits leased before.
+    hits_ = 0;
+    return;
+  }
+
+  hits_ += parent_.config_.lease_size_;
+  expiry_ = parent_.time_source_.currentTime() + parent_.config_.duration_;
+}
+
 GrpcClientImpl::GrpcClientImpl(RateLimitAsyncClientPtr&& async_client,
-                               const Optional<std::chrono::milliseconds>& timeout)
-    : service_method_(*Protobuf::DescriptorPool::generated_pool()->FindMethodByName(
-          "pb.lyft.ratelimit.RateLimitService.ShouldRateLimit")),
-      async_client_(std::move(async_client)), timeout_(timeout) {}
+                               const Optional<std::chrono::milliseconds>& timeout,
+                               QuotaLeaseCache* lease_cache)
+    : service_method_(serviceMethod()), async_client_(std::move(async_client)), timeout_(timeout),
+      lease_cache_(lease_cache) {}
 
 GrpcClientImpl::~GrpcClientImpl() { ASSERT(!callbacks_); }
 
@@ -45,10 +146,26 @@ void GrpcClientImpl::createRequest(pb::lyft::ratelimit::RateLimitRequest& reques
 void GrpcClientImpl::limit(RequestCallbacks& callbacks, const std::string& domain,
                            const std::vector<Descriptor>& descriptors, Tracing::Span& parent_span) {
   ASSERT(callbacks_ == nullptr);
+  leasing_ = false;
+  if (lease_cache_ != nullptr) {
+    lease_key_ = QuotaLeaseCache::leaseKey(domain, descriptors);
+    if (lease_cache_->tryAcquire(lease_key_)) {
+      callbacks.complete(LimitStatus::OK);
+      return;
+    }
+  }
+
   callbacks_ = &callbacks;
 
   pb::lyft::ratelimit::RateLimitRequest request;
   createRequest(request, domain, descriptors);
+  if (lease_cache_ != nullptr && lease_cache_->canLease(lease_key_)) {
+    // Charge the hit of this request along with the ones of the lease.
+    leasing_ = true;
+    lease_request_ = request;
+    lease_request_.set_hits_addend(lease_cache_->leaseSize());
+    request.set_hits_addend(lease_cache_->leaseSize() + 1);
+  }
 
   request_ = async_client_->send(service_method_, request, *this, parent_span, timeout_);
 }
@@ -62,6 +179,9 @@ void GrpcClientImpl::onSuccess(std::unique_ptr<pb::lyft::ratelimit::RateLimitRes
     span.setTag(Constants::get().TraceStatus, Constants::get().TraceOverLimit);
   } else {
     span.setTag(Constants::get().TraceStatus, Constants::get().TraceOk);
+    if (leasing_) {
+      lease_cache_->grant(lease_key_, lease_request_);
+    }
   }
 
   callbacks_->complete(status);
@@ -84,12 +204,36 @@ GrpcFactoryImpl::GrpcFactoryImpl(const envoy::api::v2::RateLimitServiceConfig& c
   }
 }
 
+GrpcFactoryImpl::GrpcFactoryImpl(const envoy::api::v2::RateLimitServiceConfig& config,
+                                 Upstream::ClusterManager& cm,
+                                 const QuotaLeaseConfig& lease_config,
+                                 ThreadLocal::SlotAllocator& tls)
+    : GrpcFactoryImpl(config, cm) {
+  if (lease_config.lease_size_ == 0) {
+    return;
+  }
+
+  lease_slot_ = tls.allocateSlot();
+  const std::string cluster_name = cluster_name_;
+  lease_slot_->set([lease_config, &cm, cluster_name](
+                       Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<QuotaLeaseCache>(
+        lease_config,
+        RateLimitAsyncClientPtr{
+            new Grpc::AsyncClientImpl<pb::lyft::ratelimit::RateLimitRequest,
+                                      pb::lyft::ratelimit::RateLimitResponse>(cm, cluster_name)},
+        ProdMonotonicTimeSource::instance_);
+  });
+}
+
 ClientPtr GrpcFactoryImpl::create(const Optional<std::chrono::milliseconds>& timeout) {
+  QuotaLeaseCache* lease_cache =
+      lease_slot_ != nullptr ? &lease_slot_->getTyped<QuotaLeaseCache>() : nullptr;
   return ClientPtr{new GrpcClientImpl(
       RateLimitAsyncClientPtr{
           new Grpc::AsyncClientImpl<pb::lyft::ratelimit::RateLimitRequest,
                                     pb::lyft::ratelimit::RateLimitResponse>(cm_, cluster_name_)},
-      timeout)};
+      timeout, lease_cache)};
 }
 
 } // namespace RateLimit
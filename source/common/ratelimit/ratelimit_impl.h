@@ -2,11 +2,15 @@
 
 #include <chrono>
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "envoy/common/time.h"
 #include "envoy/grpc/async_client.h"
 #include "envoy/ratelimit/ratelimit.h"
+#include "envoy/thread_local/thread_local.h"
 #include "envoy/tracing/http_tracer.h"
 #include "envoy/upstream/cluster_manager.h"
 
@@ -34,13 +38,102 @@ struct ConstantValues {
 
 typedef ConstSingleton<ConstantValues> Constants;
 
+/**
+ * Settings of the quota leases of QuotaLeaseCache.
+ */
+struct QuotaLeaseConfig {
+  // Hits leased on top of the one of the request which fetches a lease, and by each refresh.
+  uint32_t lease_size_;
+  // How long the hits of a lease may be spent after it was last granted.
+  std::chrono::milliseconds duration_;
+  // Maximum number of leases held by each worker.
+  uint32_t max_leases_;
+
+  static const uint32_t DEFAULT_MAX_LEASES = 1024;
+};
+
+/**
+ * Per worker cache of the hits leased from the rate limit service. A request whose descriptors
+ * miss the cache asks the service for lease_size_ extra hits, which are then spent on later
+ * requests with the same domain and descriptors without calling the service. Once half of the
+ * hits of a lease are spent it is refreshed in the background, so that hot descriptors far from
+ * their limits rarely wait on the service.
+ */
+class QuotaLeaseCache : public ThreadLocal::ThreadLocalObject {
+public:
+  QuotaLeaseCache(const QuotaLeaseConfig& config, RateLimitAsyncClientPtr&& async_client,
+                  MonotonicTimeSource& time_source);
+
+  /**
+   * @return std::string the key of the lease of a domain and descriptors.
+   */
+  static std::string leaseKey(const std::string& domain,
+                              const std::vector<Descriptor>& descriptors);
+
+  /**
+   * Spend a hit of a lease, refreshing the lease if it is running low.
+   * @param key supplies the key of the lease.
+   * @return bool whether the lease had a hit left to spend.
+   */
+  bool tryAcquire(const std::string& key);
+
+  /**
+   * Grant the hits of a lease, after the service accepted a request for them.
+   * @param key supplies the key of the lease.
+   * @param request supplies the request which leased the hits, reused to refresh the lease.
+   */
+  void grant(const std::string& key, const pb::lyft::ratelimit::RateLimitRequest& request);
+
+  /**
+   * @return bool whether the cache can hold the lease of a key.
+   */
+  bool canLease(const std::string& key) const {
+    return leases_.size() < config_.max_leases_ || leases_.count(key) > 0;
+  }
+
+  uint32_t leaseSize() const { return config_.lease_size_; }
+
+private:
+  struct Lease : public RateLimitAsyncCallbacks {
+    Lease(QuotaLeaseCache& parent, const pb::lyft::ratelimit::RateLimitRequest& request);
+    ~Lease();
+
+    void refresh();
+
+    // Grpc::AsyncRequestCallbacks
+    void onCreateInitialMetadata(Http::HeaderMap&) override {}
+    void onSuccess(std::unique_ptr<pb::lyft::ratelimit::RateLimitResponse>&& response,
+                   Tracing::Span& span) override;
+    void onFailure(Grpc::Status::GrpcStatus, const std::string&, Tracing::Span&) override {
+      refresh_ = nullptr;
+    }
+
+    QuotaLeaseCache& parent_;
+    pb::lyft::ratelimit::RateLimitRequest request_;
+    uint32_t hits_{};
+    MonotonicTime expiry_;
+    Grpc::AsyncRequest* refresh_{};
+  };
+
+  const QuotaLeaseConfig config_;
+  RateLimitAsyncClientPtr async_client_;
+  MonotonicTimeSource& time_source_;
+  const Protobuf::MethodDescriptor& service_method_;
+  std::unordered_map<std::string, std::unique_ptr<Lease>> leases_;
+};
+
 // TODO(htuch): We should have only one client per thread, but today we create one per filter stack.
 // This will require support for more than one outstanding request per client (limit() assumes only
 // one today).
 class GrpcClientImpl : public Client, public RateLimitAsyncCallbacks {
 public:
+  /**
+   * @param lease_cache supplies the lease cache of the worker, or nullptr to call the service for
+   *        each request.
+   */
   GrpcClientImpl(RateLimitAsyncClientPtr&& async_client,
-                 const Optional<std::chrono::milliseconds>& timeout);
+                 const Optional<std::chrono::milliseconds>& timeout,
+                 QuotaLeaseCache* lease_cache = nullptr);
   ~GrpcClientImpl();
 
   static void createRequest(pb::lyft::ratelimit::RateLimitRequest& request,
@@ -64,10 +157,23 @@ private:
   Grpc::AsyncRequest* request_{};
   Optional<std::chrono::milliseconds> timeout_;
   RequestCallbacks* callbacks_{};
+  QuotaLeaseCache* lease_cache_;
+  // Whether the inflight request also leases hits, with the key and request of the lease.
+  bool leasing_{};
+  std::string lease_key_;
+  pb::lyft::ratelimit::RateLimitRequest lease_request_;
 };
 
 class GrpcFactoryImpl : public ClientFactory {
 public:
+  /**
+   * @param lease_config supplies the settings of the quota leases, which are disabled if their
+   *        lease_size_ is 0.
+   * @param tls supplies the slot allocator for the per worker lease caches.
+   */
+  GrpcFactoryImpl(const envoy::api::v2::RateLimitServiceConfig& config,
+                  Upstream::ClusterManager& cm, const QuotaLeaseConfig& lease_config,
+                  ThreadLocal::SlotAllocator& tls);
   GrpcFactoryImpl(const envoy::api::v2::RateLimitServiceConfig& config,
                   Upstream::ClusterManager& cm);
 
@@ -77,6 +183,7 @@ public:
 private:
   const std::string cluster_name_;
   Upstream::ClusterManager& cm_;
+  ThreadLocal::SlotPtr lease_slot_;
 };
 
 class NullClientImpl : public Client {
@@ -0,0 +1,149 @@
+#include "common/redis/cluster_slots.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/common/utility.h"
+
+namespace Envoy {
+namespace Redis {
+
+namespace {
+
+// CRC16-CCITT (XMODEM), which is what Redis Cluster uses for key slots.
+std::array<uint16_t, 256> makeCrc16Table() {
+  std::array<uint16_t, 256> table;
+  for (uint32_t i = 0; i < table.size(); i++) {
+    uint16_t crc = i << 8;
+    for (uint32_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    table[i] = crc;
+  }
+  return table;
+}
+
+uint16_t crc16(const char* data, uint64_t length) {
+  static const std::array<uint16_t, 256> table = makeCrc16Table();
+  uint16_t crc = 0;
+  for (uint64_t i = 0; i < length; i++) {
+    crc = (crc << 8) ^ table[((crc >> 8) ^ static_cast<uint8_t>(data[i])) & 0xFF];
+  }
+  return crc;
+}
+
+} // namespace
+
+uint16_t ClusterSlots::keySlot(const std::string& key) {
+  // Only the part between the first '{' and the first '}' after it is hashed, if it isn't empty, so
+  // that related keys can be put in the same slot.
+  const size_t start = key.find('{');
+  if (start != std::string::npos) {
+    const size_t end = key.find('}', start + 1);
+    if (end != std::string::npos && end != start + 1) {
+      return crc16(key.data() + start + 1, end - start - 1) & (NUM_SLOTS - 1);
+    }
+  }
+
+  return crc16(key.data(), key.size()) & (NUM_SLOTS - 1);
+}
+
+bool ClusterSlots::parseSlots(const RespValue& value, std::vector<SlotRange>& ranges) {
+  if (value.type() != RespType::Array) {
+    return false;
+  }
+
+  // Each range is [start, end, [host, port, id], replicas...].
+  for (const RespValue& range : value.asArray()) {
+    if (range.type() != RespType::Array || range.asArray().size() < 3) {
+      return false;
+    }
+    const RespValue& start = range.asArray()[0];
+    const RespValue& end = range.asArray()[1];
+    const RespValue& master = range.asArray()[2];
+    if (start.type() != RespType::Integer || end.type() != RespType::Integer ||
+        start.asInteger() < 0 || start.asInteger() > end.asInteger() ||
+        end.asInteger() >= NUM_SLOTS || master.type() != RespType::Array ||
+        master.asArray().size() < 2 || master.asArray()[0].type() != RespType::BulkString ||
+        master.asArray()[1].type() != RespType::Integer || master.asArray()[1].asInteger() < 0) {
+      return false;
+    }
+
+    SlotRange slot_range{static_cast<uint16_t>(start.asInteger()),
+                         static_cast<uint16_t>(end.asInteger()), ""};
+    if (!parseAddress(master.asArray()[0].asString(), master.asArray()[1].asInteger(),
+                      slot_range.address_)) {
+      return false;
+    }
+    ranges.push_back(std::move(slot_range));
+  }
+
+  return true;
+}
+
+bool ClusterSlots::parseRedirection(const RespValue& value, Redirection& redirection) {
+  if (value.type() != RespType::Error) {
+    return false;
+  }
+
+  // The error is "MOVED <slot> <host>:<port>" or "ASK <slot> <host>:<port>".
+  const std::string& error = value.asString();
+  std::vector<std::string> parts = StringUtil::split(error, ' ');
+  if (parts.size() != 3 || (parts[0] != "MOVED" && parts[0] != "ASK")) {
+    return false;
+  }
+
+  uint64_t slot;
+  const size_t port_separator = parts[2].rfind(':');
+  uint64_t port;
+  if (!StringUtil::atoul(parts[1].c_str(), slot) || slot >= NUM_SLOTS ||
+      port_separator == std::string::npos ||
+      !StringUtil::atoul(parts[2].c_str() + port_separator + 1, port)) {
+    return false;
+  }
+
+  redirection.ask_ = parts[0] == "ASK";
+  redirection.slot_ = slot;
+  return parseAddress(parts[2].substr(0, port_separator), port, redirection.address_);
+}
+
+bool ClusterSlots::parseAddress(const std::string& host, uint64_t port, std::string& address) {
+  if (host.empty() || port > 65535) {
+    return false;
+  }
+
+  // Redis doesn't bracket IPv6 addresses.
+  if (host.find(':') != std::string::npos) {
+    address = "[" + host + "]:" + std::to_string(port);
+  } else {
+    address = host + ":" + std::to_string(port);
+  }
+  return true;
+}
+
+const RespValue& ClusterSlots::slotsRequest() {
+  static const RespValue* request = makeRequest({"CLUSTER", "SLOTS"});
+  return *request;
+}
+
+const RespValue& ClusterSlots::askingRequest() {
+  static const RespValue* request = makeRequest({"ASKING"});
+  return *request;
+}
+
+const RespValue* ClusterSlots::makeRequest(const std::vector<std::string>& args) {
+  RespValue* request = new RespValue();
+  request->type(RespType::Array);
+  std::vector<RespValue> values(args.size());
+  for (uint64_t i = 0; i < args.size(); i++) {
+    values[i].type(RespType::BulkString);
+    values[i].asString() = args[i];
+  }
+  request->asArray().swap(values);
+  return request;
+}
+
+} // namespace Redis
+} // namespace Envoy
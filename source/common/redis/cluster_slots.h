@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "envoy/redis/codec.h"
+
+namespace Envoy {
+namespace Redis {
+
+/**
+ * Helpers for Redis Cluster, which divides the keys into hash slots and assigns ranges of slots
+ * to its master nodes. See https://redis.io/topics/cluster-spec.
+ */
+class ClusterSlots {
+public:
+  static const uint32_t NUM_SLOTS = 16384;
+
+  /**
+   * A range of slots and the address of the master node which serves them.
+   */
+  struct SlotRange {
+    uint16_t start_;
+    uint16_t end_;
+    // In the form of Network::Address::Instance::asString(), e.g. "10.0.0.1:6379" or "[::1]:6379".
+    std::string address_;
+  };
+
+  /**
+   * A MOVED or ASK redirection of a request for a key in a slot which the node doesn't serve.
+   */
+  struct Redirection {
+    bool ask_;
+    uint16_t slot_;
+    // In the same form as SlotRange::address_.
+    std::string address_;
+  };
+
+  /**
+   * @param key supplies the key.
+   * @return uint16_t the slot of the key, which is the CRC16 of the key, or of its hash tag if it
+   *         has one, modulo NUM_SLOTS.
+   */
+  static uint16_t keySlot(const std::string& key);
+
+  /**
+   * Parse the response to CLUSTER SLOTS.
+   * @param value supplies the response.
+   * @param ranges supplies the vector to fill with the slot ranges.
+   * @return bool false if the response is not a slot map, e.g. because the server is not a
+   *         cluster node.
+   */
+  static bool parseSlots(const RespValue& value, std::vector<SlotRange>& ranges);
+
+  /**
+   * @param value supplies a response.
+   * @param redirection supplies the redirection to fill in.
+   * @return bool whether the response is a MOVED or ASK error.
+   */
+  static bool parseRedirection(const RespValue& value, Redirection& redirection);
+
+  /**
+   * @return const RespValue& the CLUSTER SLOTS request.
+   */
+  static const RespValue& slotsRequest();
+
+  /**
+   * @return const RespValue& the ASKING request, which lets the request following it on the same
+   *         connection be served by the node which an ASK redirection points to.
+   */
+  static const RespValue& askingRequest();
+
+private:
+  static bool parseAddress(const std::string& host, uint64_t port, std::string& address);
+  static const RespValue* makeRequest(const std::vector<std::string>& args);
+};
+
+} // namespace Redis
+} // namespace Envoy
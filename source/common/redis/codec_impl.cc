@@ -1,9 +1,12 @@
 #include "common/redis/codec_impl.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "common/buffer/buffer_impl.h"
 #include "common/common/assert.h"
 #include "common/common/utility.h"
 
@@ -50,15 +53,83 @@ const std::vector<RespValue>& RespValue::asArray() const {
 std::string& RespValue::asString() {
   ASSERT(type_ == RespType::BulkString || type_ == RespType::Error ||
          type_ == RespType::SimpleString);
+  if (buffer_) {
+    // The string may be modified, so it can no longer be encoded from the buffer.
+    copyBuffer();
+    buffer_.reset();
+    buffer_copied_ = false;
+  }
   return string_;
 }
 
 const std::string& RespValue::asString() const {
   ASSERT(type_ == RespType::BulkString || type_ == RespType::Error ||
          type_ == RespType::SimpleString);
+  copyBuffer();
   return string_;
 }
 
+const std::shared_ptr<const Buffer::Instance>& RespValue::asBuffer() const {
+  ASSERT(type_ == RespType::BulkString || type_ == RespType::Error ||
+         type_ == RespType::SimpleString);
+  return buffer_;
+}
+
+void RespValue::asBuffer(std::shared_ptr<const Buffer::Instance>&& buffer) {
+  ASSERT(type_ == RespType::BulkString);
+  string_.clear();
+  buffer_ = std::move(buffer);
+  buffer_copied_ = false;
+}
+
+RespValue& RespValue::operator=(const RespValue& other) {
+  if (&other == this) {
+    return *this;
+  }
+
+  type(other.type());
+  switch (type_) {
+  case RespType::Array: {
+    array_ = other.array_;
+    break;
+  }
+  case RespType::SimpleString:
+  case RespType::BulkString:
+  case RespType::Error: {
+    if (other.buffer_) {
+      buffer_ = other.buffer_;
+    } else {
+      string_ = other.string_;
+    }
+    break;
+  }
+  case RespType::Integer: {
+    integer_ = other.integer_;
+    break;
+  }
+  case RespType::Null: {
+    break;
+  }
+  }
+
+  return *this;
+}
+
+void RespValue::copyBuffer() const {
+  if (!buffer_ || buffer_copied_) {
+    return;
+  }
+
+  uint64_t num_slices = buffer_->getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  buffer_->getRawSlices(slices, num_slices);
+  string_.reserve(buffer_->length());
+  for (const Buffer::RawSlice& slice : slices) {
+    string_.append(static_cast<const char*>(slice.mem_), slice.len_);
+  }
+  buffer_copied_ = true;
+}
+
 int64_t& RespValue::asInteger() {
   ASSERT(type_ == RespType::Integer);
   return integer_;
@@ -70,6 +141,9 @@ int64_t RespValue::asInteger() const {
 }
 
 void RespValue::cleanup() {
+  buffer_.reset();
+  buffer_copied_ = false;
+
   // Need to manually delete because of the union.
   switch (type_) {
   case RespType::Array: {
@@ -113,17 +187,38 @@ void RespValue::type(RespType type) {
 }
 
 void DecoderImpl::decode(Buffer::Instance& data) {
-  uint64_t num_slices = data.getRawSlices(nullptr, 0);
-  Buffer::RawSlice slices[num_slices];
-  data.getRawSlices(slices, num_slices);
-  for (const Buffer::RawSlice& slice : slices) {
-    parseSlice(slice);
-  }
+  while (data.length() > 0) {
+    if (state_ == State::BulkStringBody && pending_bulk_string_) {
+      // Move the slices of a large bulk string out of the input rather than copying them.
+      const uint64_t length = std::min(pending_integer_.integer_, data.length());
+      pending_bulk_string_->move(data, length);
+      pending_integer_.integer_ -= length;
+      if (pending_integer_.integer_ == 0) {
+        ENVOY_LOG(trace, "parse slice: BulkStringBody complete: {} bytes buffered",
+                  pending_bulk_string_->length());
+        pending_value_stack_.front().value_->asBuffer(std::move(pending_bulk_string_));
+        state_ = State::CR;
+      }
+      continue;
+    }
+
+    uint64_t num_slices = data.getRawSlices(nullptr, 0);
+    Buffer::RawSlice slices[num_slices];
+    data.getRawSlices(slices, num_slices);
+    uint64_t parsed = 0;
+    for (const Buffer::RawSlice& slice : slices) {
+      const uint64_t slice_parsed = parseSlice(slice);
+      parsed += slice_parsed;
+      if (slice_parsed < slice.len_) {
+        break;
+      }
+    }
 
-  data.drain(data.length());
+    data.drain(parsed);
+  }
 }
 
-void DecoderImpl::parseSlice(const Buffer::RawSlice& slice) {
+uint64_t DecoderImpl::parseSlice(const Buffer::RawSlice& slice) {
   const char* buffer = reinterpret_cast<const char*>(slice.mem_);
   uint64_t remaining = slice.len_;
 
@@ -244,6 +339,11 @@ void DecoderImpl::parseSlice(const Buffer::RawSlice& slice) {
         if (!pending_integer_.negative_) {
           // TODO(mattklein123): reserve and define max length since we don't stream currently.
           state_ = State::BulkStringBody;
+          if (pending_integer_.integer_ >= MIN_BUFFERED_BULK_STRING_SIZE) {
+            // Stop here so that decode() can move the body out of the input.
+            pending_bulk_string_ = std::make_shared<Buffer::OwnedImpl>();
+            return slice.len_ - remaining;
+          }
         } else {
           // Null bulk string. Switch type to null and move to value complete.
           current_value.value_->type(RespType::Null);
@@ -331,6 +431,8 @@ void DecoderImpl::parseSlice(const Buffer::RawSlice& slice) {
     }
     }
   }
+
+  return slice.len_;
 }
 
 void EncoderImpl::encode(const RespValue& value, Buffer::Instance& out) {
@@ -344,7 +446,11 @@ void EncoderImpl::encode(const RespValue& value, Buffer::Instance& out) {
     break;
   }
   case RespType::BulkString: {
-    encodeBulkString(value.asString(), out);
+    if (value.asBuffer()) {
+      encodeBulkString(value.asBuffer(), out);
+    } else {
+      encodeBulkString(value.asString(), out);
+    }
     break;
   }
   case RespType::Error: {
@@ -376,15 +482,40 @@ void EncoderImpl::encodeArray(const std::vector<RespValue>& array, Buffer::Insta
 }
 
 void EncoderImpl::encodeBulkString(const std::string& string, Buffer::Instance& out) {
+  encodeBulkStringLength(string.size(), out);
+  out.add(string);
+  out.add("\r\n", 2);
+}
+
+void EncoderImpl::encodeBulkString(const std::shared_ptr<const Buffer::Instance>& string,
+                                   Buffer::Instance& out) {
+  encodeBulkStringLength(string->length(), out);
+
+  // Reference the slices of the buffer instead of copying them. Each fragment holds a reference to
+  // the buffer until the output is done with it.
+  uint64_t num_slices = string->getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  string->getRawSlices(slices, num_slices);
+  for (const Buffer::RawSlice& slice : slices) {
+    Buffer::BufferFragmentImpl* fragment = new Buffer::BufferFragmentImpl(
+        slice.mem_, slice.len_,
+        [string](const void*, size_t, const Buffer::BufferFragmentImpl* fragment) -> void {
+          delete fragment;
+        });
+    out.addBufferFragment(*fragment);
+  }
+
+  out.add("\r\n", 2);
+}
+
+void EncoderImpl::encodeBulkStringLength(uint64_t length, Buffer::Instance& out) {
   char buffer[32];
   char* current = buffer;
   *current++ = '$';
-  current += StringUtil::itoa(current, 31, string.size());
+  current += StringUtil::itoa(current, 31, length);
   *current++ = '\r';
   *current++ = '\n';
   out.add(buffer, current - buffer);
-  out.add(string);
-  out.add("\r\n", 2);
 }
 
 void EncoderImpl::encodeError(const std::string& string, Buffer::Instance& out) {
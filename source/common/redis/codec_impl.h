@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <forward_list>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -24,6 +25,10 @@ public:
   // Redis::Decoder
   void decode(Buffer::Instance& data) override;
 
+  // Bulk strings of at least this size are moved out of the input into a buffer, see
+  // RespValue::asBuffer(), rather than copied into a string.
+  static const uint64_t MIN_BUFFERED_BULK_STRING_SIZE = 16384;
+
 private:
   enum class State {
     ValueRootStart,
@@ -53,13 +58,18 @@ private:
     uint64_t current_array_element_;
   };
 
-  void parseSlice(const Buffer::RawSlice& slice);
+  /**
+   * @return uint64_t the number of bytes of the slice which were parsed. This is less than the
+   *         length of the slice if the body of a large bulk string starts within it.
+   */
+  uint64_t parseSlice(const Buffer::RawSlice& slice);
 
   DecoderCallbacks& callbacks_;
   State state_{State::ValueRootStart};
   PendingInteger pending_integer_;
   RespValuePtr pending_value_root_;
   std::forward_list<PendingValue> pending_value_stack_;
+  std::shared_ptr<Buffer::Instance> pending_bulk_string_;
 };
 
 /**
@@ -84,6 +94,9 @@ public:
 private:
   void encodeArray(const std::vector<RespValue>& array, Buffer::Instance& out);
   void encodeBulkString(const std::string& string, Buffer::Instance& out);
+  void encodeBulkString(const std::shared_ptr<const Buffer::Instance>& string,
+                        Buffer::Instance& out);
+  void encodeBulkStringLength(uint64_t length, Buffer::Instance& out);
   void encodeError(const std::string& string, Buffer::Instance& out);
   void encodeInteger(int64_t integer, Buffer::Instance& out);
   void encodeSimpleString(const std::string& string, Buffer::Instance& out);
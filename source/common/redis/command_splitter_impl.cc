@@ -1,8 +1,10 @@
 #include "common/redis/command_splitter_impl.h"
 
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "common/common/assert.h"
@@ -59,6 +61,28 @@ SplitRequestPtr SimpleRequest::create(ConnPool::Instance& conn_pool,
   return std::move(request_ptr);
 }
 
+SplitRequestPtr CachedGetRequest::create(ConnPool::Instance& conn_pool,
+                                         HotKeyCache& hot_key_cache, uint64_t generation,
+                                         const RespValue& incoming_request,
+                                         SplitCallbacks& callbacks) {
+  const std::string& key = incoming_request.asArray()[1].asString();
+  std::unique_ptr<CachedGetRequest> request_ptr{
+      new CachedGetRequest(callbacks, hot_key_cache, generation, key)};
+
+  request_ptr->handle_ = conn_pool.makeRequest(key, incoming_request, *request_ptr);
+  if (!request_ptr->handle_) {
+    request_ptr->callbacks_.onResponse(Utility::makeError("no upstream host"));
+    return nullptr;
+  }
+
+  return std::move(request_ptr);
+}
+
+void CachedGetRequest::onResponse(RespValuePtr&& response) {
+  hot_key_cache_.insert(key_, *response, generation_);
+  SingleServerRequest::onResponse(std::move(response));
+}
+
 SplitRequestPtr EvalRequest::create(ConnPool::Instance& conn_pool,
                                     const RespValue& incoming_request, SplitCallbacks& callbacks) {
 
@@ -101,65 +125,108 @@ void FragmentedRequest::onChildFailure(uint32_t index) {
   onChildResponse(Utility::makeError("upstream failure"), index);
 }
 
-SplitRequestPtr MGETRequest::create(ConnPool::Instance& conn_pool,
-                                    const RespValue& incoming_request, SplitCallbacks& callbacks) {
-  std::unique_ptr<MGETRequest> request_ptr{new MGETRequest(callbacks)};
+void FragmentedRequest::copyBulkString(const RespValue& from, RespValue& to) {
+  to.type(RespType::BulkString);
+  if (from.asBuffer()) {
+    std::shared_ptr<const Buffer::Instance> buffer = from.asBuffer();
+    to.asBuffer(std::move(buffer));
+  } else {
+    to.asString() = from.asString();
+  }
+}
+
+void FragmentedRequest::makeFragmentedRequests(ConnPool::Instance& conn_pool,
+                                               const RespValue& incoming_request,
+                                               uint32_t args_per_key) {
+  const std::vector<RespValue>& args = incoming_request.asArray();
+
+  // Group the keys by the host they hash to, and by their slot if the upstream is a Redis Cluster,
+  // in the order in which the groups are first used. Keys without a host are grouped under nullptr.
+  std::vector<std::pair<Upstream::HostConstSharedPtr, std::vector<uint32_t>>> fragments;
+  std::map<std::pair<Upstream::HostConstSharedPtr, int32_t>, uint32_t> fragment_indexes;
+  for (uint64_t i = 1; i < args.size(); i += args_per_key) {
+    const std::string& key = args[i].asString();
+    Upstream::HostConstSharedPtr host = conn_pool.chooseHost(key);
+    const Optional<uint16_t> slot = conn_pool.hashSlot(key);
+    auto fragment_index = fragment_indexes.emplace(
+        std::make_pair(host, slot.valid() ? static_cast<int32_t>(slot.value()) : -1),
+        fragments.size());
+    if (fragment_index.second) {
+      fragments.emplace_back(std::move(host), std::vector<uint32_t>());
+    }
+    fragments[fragment_index.first->second].second.push_back((i - 1) / args_per_key);
+  }
 
-  request_ptr->num_pending_responses_ = incoming_request.asArray().size() - 1;
-  request_ptr->pending_requests_.reserve(request_ptr->num_pending_responses_);
+  num_pending_responses_ = fragments.size();
+  pending_requests_.reserve(fragments.size());
+  for (uint32_t i = 0; i < fragments.size(); i++) {
+    pending_requests_.emplace_back(*this, i);
+    PendingRequest& pending_request = pending_requests_.back();
+    pending_request.key_indexes_.swap(fragments[i].second);
 
-  request_ptr->pending_response_.reset(new RespValue());
-  request_ptr->pending_response_->type(RespType::Array);
-  std::vector<RespValue> responses(request_ptr->num_pending_responses_);
-  request_ptr->pending_response_->asArray().swap(responses);
+    if (!fragments[i].first) {
+      pending_request.onResponse(Utility::makeError("no upstream host"));
+      continue;
+    }
+
+    // The request for the fragment is the incoming command with the arguments of its keys.
+    std::vector<RespValue> values(1 + pending_request.key_indexes_.size() * args_per_key);
+    values[0].type(RespType::BulkString);
+    values[0].asString() = args[0].asString();
+    uint64_t value_index = 1;
+    for (uint32_t key_index : pending_request.key_indexes_) {
+      for (uint32_t arg = 0; arg < args_per_key; arg++) {
+        copyBulkString(args[1 + key_index * args_per_key + arg], values[value_index++]);
+      }
+    }
+    RespValue fragment_request;
+    fragment_request.type(RespType::Array);
+    fragment_request.asArray().swap(values);
 
-  std::vector<RespValue> values(2);
-  values[0].type(RespType::BulkString);
-  values[0].asString() = "get";
-  values[1].type(RespType::BulkString);
-  RespValue single_mget;
-  single_mget.type(RespType::Array);
-  single_mget.asArray().swap(values);
-
-  for (uint64_t i = 1; i < incoming_request.asArray().size(); i++) {
-    request_ptr->pending_requests_.emplace_back(*request_ptr, i - 1);
-    PendingRequest& pending_request = request_ptr->pending_requests_.back();
-
-    single_mget.asArray()[1].asString() = incoming_request.asArray()[i].asString();
-    ENVOY_LOG(debug, "redis: parallel get: '{}'", single_mget.toString());
-    pending_request.handle_ = conn_pool.makeRequest(incoming_request.asArray()[i].asString(),
-                                                    single_mget, pending_request);
+    ENVOY_LOG(debug, "redis: parallel {}: '{}'", args[0].asString(), fragment_request.toString());
+    pending_request.handle_ =
+        conn_pool.makeRequestToHost(fragments[i].first, fragment_request, pending_request);
     if (!pending_request.handle_) {
       pending_request.onResponse(Utility::makeError("no upstream host"));
     }
   }
+}
+
+SplitRequestPtr MGETRequest::create(ConnPool::Instance& conn_pool,
+                                    const RespValue& incoming_request, SplitCallbacks& callbacks) {
+  std::unique_ptr<MGETRequest> request_ptr{new MGETRequest(callbacks)};
+
+  request_ptr->pending_response_.reset(new RespValue());
+  request_ptr->pending_response_->type(RespType::Array);
+  std::vector<RespValue> responses(incoming_request.asArray().size() - 1);
+  request_ptr->pending_response_->asArray().swap(responses);
 
+  request_ptr->makeFragmentedRequests(conn_pool, incoming_request, 1);
   return request_ptr->num_pending_responses_ > 0 ? std::move(request_ptr) : nullptr;
 }
 
 void MGETRequest::onChildResponse(RespValuePtr&& value, uint32_t index) {
   pending_requests_[index].handle_ = nullptr;
 
-  pending_response_->asArray()[index].type(value->type());
-  switch (value->type()) {
-  case RespType::Array:
-  case RespType::Integer:
-  case RespType::SimpleString: {
-    pending_response_->asArray()[index].type(RespType::Error);
-    pending_response_->asArray()[index].asString() = "upstream protocol error";
-    error_count_++;
-    break;
-  }
-  case RespType::Error: {
-    error_count_++;
-    FALLTHRU;
-  }
-  case RespType::BulkString: {
-    pending_response_->asArray()[index].asString().swap(value->asString());
-    break;
-  }
-  case RespType::Null:
-    break;
+  // The response holds the values of the keys of the fragment, in order.
+  const std::vector<uint32_t>& key_indexes = pending_requests_[index].key_indexes_;
+  const bool valid =
+      value->type() == RespType::Array && value->asArray().size() == key_indexes.size();
+  for (uint64_t i = 0; i < key_indexes.size(); i++) {
+    RespValue& response = pending_response_->asArray()[key_indexes[i]];
+    if (value->type() == RespType::Error) {
+      response.type(RespType::Error);
+      response.asString() = value->asString();
+      error_count_++;
+    } else if (!valid || (value->asArray()[i].type() != RespType::BulkString &&
+                          value->asArray()[i].type() != RespType::Null)) {
+      response.type(RespType::Error);
+      response.asString() = "upstream protocol error";
+      error_count_++;
+    } else if (value->asArray()[i].type() == RespType::BulkString) {
+      // Pass large values on without copying them.
+      copyBulkString(value->asArray()[i], response);
+    }
   }
 
   ASSERT(num_pending_responses_ > 0);
@@ -178,37 +245,10 @@ SplitRequestPtr MSETRequest::create(ConnPool::Instance& conn_pool,
 
   std::unique_ptr<MSETRequest> request_ptr{new MSETRequest(callbacks)};
 
-  request_ptr->num_pending_responses_ = (incoming_request.asArray().size() - 1) / 2;
-  request_ptr->pending_requests_.reserve(request_ptr->num_pending_responses_);
-
   request_ptr->pending_response_.reset(new RespValue());
   request_ptr->pending_response_->type(RespType::SimpleString);
 
-  std::vector<RespValue> values(3);
-  values[0].type(RespType::BulkString);
-  values[0].asString() = "set";
-  values[1].type(RespType::BulkString);
-  values[2].type(RespType::BulkString);
-  RespValue single_mset;
-  single_mset.type(RespType::Array);
-  single_mset.asArray().swap(values);
-
-  uint64_t fragment_index = 0;
-  for (uint64_t i = 1; i < incoming_request.asArray().size(); i += 2) {
-    request_ptr->pending_requests_.emplace_back(*request_ptr, fragment_index++);
-    PendingRequest& pending_request = request_ptr->pending_requests_.back();
-
-    single_mset.asArray()[1].asString() = incoming_request.asArray()[i].asString();
-    single_mset.asArray()[2].asString() = incoming_request.asArray()[i + 1].asString();
-
-    ENVOY_LOG(debug, "redis: parallel set: '{}'", single_mset.toString());
-    pending_request.handle_ = conn_pool.makeRequest(incoming_request.asArray()[i].asString(),
-                                                    single_mset, pending_request);
-    if (!pending_request.handle_) {
-      pending_request.onResponse(Utility::makeError("no upstream host"));
-    }
-  }
-
+  request_ptr->makeFragmentedRequests(conn_pool, incoming_request, 2);
   return request_ptr->num_pending_responses_ > 0 ? std::move(request_ptr) : nullptr;
 }
 
@@ -245,34 +285,10 @@ SplitRequestPtr SplitKeysSumResultRequest::create(ConnPool::Instance& conn_pool,
                                                   SplitCallbacks& callbacks) {
   std::unique_ptr<SplitKeysSumResultRequest> request_ptr{new SplitKeysSumResultRequest(callbacks)};
 
-  request_ptr->num_pending_responses_ = incoming_request.asArray().size() - 1;
-  request_ptr->pending_requests_.reserve(request_ptr->num_pending_responses_);
-
   request_ptr->pending_response_.reset(new RespValue());
   request_ptr->pending_response_->type(RespType::Integer);
 
-  std::vector<RespValue> values(2);
-  values[0].type(RespType::BulkString);
-  values[0].asString() = incoming_request.asArray()[0].asString();
-  values[1].type(RespType::BulkString);
-  RespValue single_fragment;
-  single_fragment.type(RespType::Array);
-  single_fragment.asArray().swap(values);
-
-  for (uint64_t i = 1; i < incoming_request.asArray().size(); i++) {
-    request_ptr->pending_requests_.emplace_back(*request_ptr, i - 1);
-    PendingRequest& pending_request = request_ptr->pending_requests_.back();
-
-    single_fragment.asArray()[1].asString() = incoming_request.asArray()[i].asString();
-    ENVOY_LOG(debug, "redis: parallel {}: '{}'", incoming_request.asArray()[0].asString(),
-              single_fragment.toString());
-    pending_request.handle_ = conn_pool.makeRequest(incoming_request.asArray()[i].asString(),
-                                                    single_fragment, pending_request);
-    if (!pending_request.handle_) {
-      pending_request.onResponse(Utility::makeError("no upstream host"));
-    }
-  }
-
+  request_ptr->makeFragmentedRequests(conn_pool, incoming_request, 1);
   return request_ptr->num_pending_responses_ > 0 ? std::move(request_ptr) : nullptr;
 }
 
@@ -303,9 +319,10 @@ void SplitKeysSumResultRequest::onChildResponse(RespValuePtr&& value, uint32_t i
 }
 
 InstanceImpl::InstanceImpl(ConnPool::InstancePtr&& conn_pool, Stats::Scope& scope,
-                           const std::string& stat_prefix)
-    : conn_pool_(std::move(conn_pool)), simple_command_handler_(*conn_pool_),
-      eval_command_handler_(*conn_pool_), mget_handler_(*conn_pool_), mset_handler_(*conn_pool_),
+                           const std::string& stat_prefix, HotKeyCachePtr&& hot_key_cache)
+    : conn_pool_(std::move(conn_pool)), hot_key_cache_(std::move(hot_key_cache)),
+      simple_command_handler_(*conn_pool_), eval_command_handler_(*conn_pool_),
+      mget_handler_(*conn_pool_), mset_handler_(*conn_pool_),
       split_keys_sum_result_handler_(*conn_pool_),
       stats_{ALL_COMMAND_SPLITTER_STATS(POOL_COUNTER_PREFIX(scope, stat_prefix + "splitter."))} {
   // TODO(mattklein123) PERF: Make this a trie (like in header_map_impl).
@@ -351,9 +368,31 @@ SplitRequestPtr InstanceImpl::makeRequest(const RespValue& request, SplitCallbac
 
   ENVOY_LOG(debug, "redis: splitting '{}'", request.toString());
   handler->second.total_.inc();
+  if (hot_key_cache_) {
+    if (to_lower_string == SupportedCommands::get() && request.asArray().size() == 2) {
+      return makeGetRequest(request, callbacks);
+    }
+    if (to_lower_string != SupportedCommands::mget()) {
+      hot_key_cache_->invalidate(request);
+    }
+  }
   return handler->second.handler_.get().startRequest(request, callbacks);
 }
 
+SplitRequestPtr InstanceImpl::makeGetRequest(const RespValue& request, SplitCallbacks& callbacks) {
+  const HotKeyCache::Lookup lookup = hot_key_cache_->lookup(request.asArray()[1].asString());
+  if (lookup.response_) {
+    callbacks.onResponse(RespValuePtr{new RespValue(*lookup.response_)});
+    return nullptr;
+  }
+
+  if (lookup.cacheable_) {
+    return CachedGetRequest::create(*conn_pool_, *hot_key_cache_, lookup.generation_, request,
+                                    callbacks);
+  }
+  return simple_command_handler_.startRequest(request, callbacks);
+}
+
 void InstanceImpl::onInvalidRequest(SplitCallbacks& callbacks) {
   stats_.invalid_request_.inc();
   callbacks.onResponse(Utility::makeError("invalid request"));
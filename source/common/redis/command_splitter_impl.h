@@ -10,6 +10,7 @@
 
 #include "common/common/logger.h"
 #include "common/common/to_lower_table.h"
+#include "common/redis/hot_key_cache.h"
 
 namespace Envoy {
 namespace Redis {
@@ -72,6 +73,29 @@ private:
   SimpleRequest(SplitCallbacks& callbacks) : SingleServerRequest(callbacks) {}
 };
 
+/**
+ * CachedGetRequest is a GET for a key whose response can be cached, which caches the response.
+ */
+class CachedGetRequest : public SingleServerRequest {
+public:
+  static SplitRequestPtr create(ConnPool::Instance& conn_pool, HotKeyCache& hot_key_cache,
+                                uint64_t generation, const RespValue& incoming_request,
+                                SplitCallbacks& callbacks);
+
+  // Redis::ConnPool::PoolCallbacks
+  void onResponse(RespValuePtr&& response) override;
+
+private:
+  CachedGetRequest(SplitCallbacks& callbacks, HotKeyCache& hot_key_cache, uint64_t generation,
+                   const std::string& key)
+      : SingleServerRequest(callbacks), hot_key_cache_(hot_key_cache), generation_(generation),
+        key_(key) {}
+
+  HotKeyCache& hot_key_cache_;
+  const uint64_t generation_;
+  const std::string key_;
+};
+
 /**
  * EvalRequest hashes the fourth argument as the key.
  */
@@ -85,11 +109,11 @@ private:
 };
 
 /**
- * FragmentedRequest is a base class for requests that contains multiple keys. An individual request
- * is sent to the appropriate server for each key. The responses from all servers are combined and
- * returned to the client.
+ * FragmentedRequest is a base class for requests that contains multiple keys. The keys are grouped
+ * by the server they hash to, and a single request with the keys of each group is sent to each
+ * server. The responses from all servers are combined and returned to the client.
  */
-class FragmentedRequest : public SplitRequestBase {
+class FragmentedRequest : public SplitRequestBase, protected Logger::Loggable<Logger::Id::redis> {
 public:
   ~FragmentedRequest();
 
@@ -111,8 +135,22 @@ protected:
     FragmentedRequest& parent_;
     const uint32_t index_;
     ConnPool::PoolRequest* handle_{};
+    // The positions in the incoming request of the keys sent in this request, in order.
+    std::vector<uint32_t> key_indexes_;
   };
 
+  /**
+   * Send the incoming command to each server, with the arguments of the keys which hash to it.
+   * @param conn_pool supplies the connection pool.
+   * @param incoming_request supplies the incoming request, whose arguments after the command are
+   *        each key followed by args_per_key - 1 other arguments.
+   * @param args_per_key supplies the number of arguments of each key, including the key.
+   */
+  void makeFragmentedRequests(ConnPool::Instance& conn_pool, const RespValue& incoming_request,
+                              uint32_t args_per_key);
+
+  static void copyBulkString(const RespValue& from, RespValue& to);
+
   virtual void onChildResponse(RespValuePtr&& value, uint32_t index) PURE;
   void onChildFailure(uint32_t index);
 
@@ -124,10 +162,10 @@ protected:
 };
 
 /**
- * MGETRequest takes each key from the command and sends a GET for each to the appropriate Redis
- * server. The response contains the result from each command.
+ * MGETRequest sends an MGET with the keys which hash to each Redis server to that server. The
+ * response contains the value of each key, in the order of the incoming request.
  */
-class MGETRequest : public FragmentedRequest, Logger::Loggable<Logger::Id::redis> {
+class MGETRequest : public FragmentedRequest {
 public:
   static SplitRequestPtr create(ConnPool::Instance& conn_pool, const RespValue& incoming_request,
                                 SplitCallbacks& callbacks);
@@ -140,12 +178,12 @@ private:
 };
 
 /**
- * SplitKeysSumResultRequest takes each key from the command and sends the same incoming command
- * with each key to the appropriate Redis server. The response from each Redis (which must be an
- * integer) is summed and returned to the user. If there is any error or failure in processing the
- * fragmented commands, an error will be returned.
+ * SplitKeysSumResultRequest sends the incoming command with the keys which hash to each Redis
+ * server to that server. The response from each Redis (which must be an integer) is summed and
+ * returned to the user. If there is any error or failure in processing the fragmented commands, an
+ * error will be returned.
  */
-class SplitKeysSumResultRequest : public FragmentedRequest, Logger::Loggable<Logger::Id::redis> {
+class SplitKeysSumResultRequest : public FragmentedRequest {
 public:
   static SplitRequestPtr create(ConnPool::Instance& conn_pool, const RespValue& incoming_request,
                                 SplitCallbacks& callbacks);
@@ -160,11 +198,10 @@ private:
 };
 
 /**
- * MSETRequest takes each key and value pair from the command and sends a SET for each to the
- * appropriate Redis server. The response is an OK if all commands succeeded or an ERR if any
- * failed.
+ * MSETRequest sends an MSET with the key and value pairs whose keys hash to each Redis server to
+ * that server. The response is an OK if all commands succeeded or an ERR if any failed.
  */
-class MSETRequest : public FragmentedRequest, Logger::Loggable<Logger::Id::redis> {
+class MSETRequest : public FragmentedRequest {
 public:
   static SplitRequestPtr create(ConnPool::Instance& conn_pool, const RespValue& incoming_request,
                                 SplitCallbacks& callbacks);
@@ -208,7 +245,7 @@ struct InstanceStats {
 class InstanceImpl : public Instance, Logger::Loggable<Logger::Id::redis> {
 public:
   InstanceImpl(ConnPool::InstancePtr&& conn_pool, Stats::Scope& scope,
-               const std::string& stat_prefix);
+               const std::string& stat_prefix, HotKeyCachePtr&& hot_key_cache = nullptr);
 
   // Redis::CommandSplitter::Instance
   SplitRequestPtr makeRequest(const RespValue& request, SplitCallbacks& callbacks) override;
@@ -222,8 +259,10 @@ private:
   void addHandler(Stats::Scope& scope, const std::string& stat_prefix, const std::string& name,
                   CommandHandler& handler);
   void onInvalidRequest(SplitCallbacks& callbacks);
+  SplitRequestPtr makeGetRequest(const RespValue& request, SplitCallbacks& callbacks);
 
   ConnPool::InstancePtr conn_pool_;
+  HotKeyCachePtr hot_key_cache_;
   CommandHandlerFactory<SimpleRequest> simple_command_handler_;
   CommandHandlerFactory<EvalRequest> eval_command_handler_;
   CommandHandlerFactory<MGETRequest> mget_handler_;
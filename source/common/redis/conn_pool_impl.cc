@@ -1,8 +1,11 @@
 #include "common/redis/conn_pool_impl.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "common/common/assert.h"
@@ -32,7 +35,12 @@ ClientImpl::ClientImpl(Upstream::HostConstSharedPtr host, Event::Dispatcher& dis
                        EncoderPtr&& encoder, DecoderFactory& decoder_factory, const Config& config)
     : host_(host), encoder_(std::move(encoder)), decoder_(decoder_factory.create(*this)),
       config_(config),
-      connect_or_op_timer_(dispatcher.createTimer([this]() -> void { onConnectOrOpTimeout(); })) {
+      connect_or_op_timer_(dispatcher.createTimer([this]() -> void { onConnectOrOpTimeout(); })),
+      flush_timer_(dispatcher.createTimer([this]() -> void { flushBufferAndResetTimer(); })),
+      commands_per_write_(
+          host->cluster().statsScope().histogram("upstream_redis_commands_per_write")),
+      outstanding_requests_(
+          host->cluster().statsScope().histogram("upstream_redis_outstanding_requests")) {
   host->cluster().stats().upstream_cx_total_.inc();
   host->cluster().stats().upstream_cx_active_.inc();
   host->stats().cx_total_.inc();
@@ -53,8 +61,18 @@ PoolRequest* ClientImpl::makeRequest(const RespValue& request, PoolCallbacks& ca
   ASSERT(connection_->state() == Network::Connection::State::Open);
 
   pending_requests_.emplace_back(*this, callbacks);
+  outstanding_requests_.recordValue(pending_requests_.size());
   encoder_->encode(request, encoder_buffer_);
-  connection_->write(encoder_buffer_);
+
+  // Batch the requests made while handling the events of this iteration of the event loop, such as
+  // the commands of many downstream clients, into a single write.
+  buffered_requests_++;
+  if (encoder_buffer_.length() >= config_.maxBufferSizeBeforeFlush()) {
+    flushBufferAndResetTimer();
+  } else if (!flush_timer_enabled_) {
+    flush_timer_enabled_ = true;
+    flush_timer_->enableTimer(std::chrono::milliseconds(0));
+  }
 
   // Only boost the op timeout if:
   // - We are not already connected. Otherwise, we are governed by the connect timeout and the timer
@@ -69,6 +87,17 @@ PoolRequest* ClientImpl::makeRequest(const RespValue& request, PoolCallbacks& ca
   return &pending_requests_.back();
 }
 
+void ClientImpl::flushBufferAndResetTimer() {
+  if (flush_timer_enabled_) {
+    flush_timer_enabled_ = false;
+    flush_timer_->disableTimer();
+  }
+
+  commands_per_write_.recordValue(buffered_requests_);
+  buffered_requests_ = 0;
+  connection_->write(encoder_buffer_);
+}
+
 void ClientImpl::onConnectOrOpTimeout() {
   putOutlierEvent(Upstream::Outlier::Result::TIMEOUT);
   if (connected_) {
@@ -121,6 +150,14 @@ void ClientImpl::onEvent(Network::ConnectionEvent event) {
     }
 
     connect_or_op_timer_->disableTimer();
+
+    // Requests which have not been written yet are failed above.
+    if (flush_timer_enabled_) {
+      flush_timer_enabled_ = false;
+      flush_timer_->disableTimer();
+    }
+    buffered_requests_ = 0;
+    encoder_buffer_.drain(encoder_buffer_.length());
   } else if (event == Network::ConnectionEvent::Connected) {
     connected_ = true;
     ASSERT(!pending_requests_.empty());
@@ -184,9 +221,13 @@ ClientPtr ClientFactoryImpl::create(Upstream::HostConstSharedPtr host,
 
 InstanceImpl::InstanceImpl(
     const std::string& cluster_name, Upstream::ClusterManager& cm, ClientFactory& client_factory,
-    ThreadLocal::SlotAllocator& tls,
+    ThreadLocal::SlotAllocator& tls, Runtime::Loader& runtime,
     const envoy::api::v2::filter::network::RedisProxy::ConnPoolSettings& config)
-    : cm_(cm), client_factory_(client_factory), tls_(tls.allocateSlot()), config_(config) {
+    : cm_(cm), client_factory_(client_factory), tls_(tls.allocateSlot()), config_(config),
+      connections_per_host_(
+          std::max<uint64_t>(1, runtime.snapshot().getInteger("redis.connections_per_host", 1))),
+      least_outstanding_requests_(
+          runtime.snapshot().getInteger("redis.least_outstanding_requests", 0) != 0) {
   tls_->set([this, cluster_name](
                 Event::Dispatcher& dispatcher) -> ThreadLocal::ThreadLocalObjectSharedPtr {
     return std::make_shared<ThreadLocalPool>(*this, dispatcher, cluster_name);
@@ -198,9 +239,23 @@ PoolRequest* InstanceImpl::makeRequest(const std::string& hash_key, const RespVa
   return tls_->getTyped<ThreadLocalPool>().makeRequest(hash_key, value, callbacks);
 }
 
+Upstream::HostConstSharedPtr InstanceImpl::chooseHost(const std::string& hash_key) {
+  return tls_->getTyped<ThreadLocalPool>().chooseHost(hash_key);
+}
+
+Optional<uint16_t> InstanceImpl::hashSlot(const std::string& hash_key) {
+  return tls_->getTyped<ThreadLocalPool>().hashSlot(hash_key);
+}
+
+PoolRequest* InstanceImpl::makeRequestToHost(const Upstream::HostConstSharedPtr& host,
+                                             const RespValue& request, PoolCallbacks& callbacks) {
+  return tls_->getTyped<ThreadLocalPool>().makeRequestToHost(host, request, callbacks);
+}
+
 InstanceImpl::ThreadLocalPool::ThreadLocalPool(InstanceImpl& parent, Event::Dispatcher& dispatcher,
                                                const std::string& cluster_name)
-    : parent_(parent), dispatcher_(dispatcher), cluster_(parent_.cm_.get(cluster_name)) {
+    : parent_(parent), dispatcher_(dispatcher), cluster_(parent_.cm_.get(cluster_name)),
+      cluster_slots_callbacks_(*this) {
 
   // TODO(mattklein123): Redis is not currently safe for use with CDS. In order to make this work
   //                     we will need to add thread local cluster removal callbacks so that we can
@@ -209,25 +264,36 @@ InstanceImpl::ThreadLocalPool::ThreadLocalPool(InstanceImpl& parent, Event::Disp
   local_host_set_member_update_cb_handle_ = cluster_->prioritySet().addMemberUpdateCb(
       [this](uint32_t, const std::vector<Upstream::HostSharedPtr>&,
              const std::vector<Upstream::HostSharedPtr>& hosts_removed) -> void {
-        onHostsRemoved(hosts_removed);
+        onHostsChanged(hosts_removed);
       });
 }
 
 InstanceImpl::ThreadLocalPool::~ThreadLocalPool() {
   local_host_set_member_update_cb_handle_->remove();
+  // Closing a connection removes it, and the host once it has no connections left.
   while (!client_map_.empty()) {
-    client_map_.begin()->second->redis_client_->close();
+    client_map_.begin()->second.clients_.front()->redis_client_->close();
   }
 }
 
-void InstanceImpl::ThreadLocalPool::onHostsRemoved(
+void InstanceImpl::ThreadLocalPool::onHostsChanged(
     const std::vector<Upstream::HostSharedPtr>& hosts_removed) {
+  // The slot map is refreshed with the next request, and in the meantime the keys of removed
+  // masters are routed by consistent hashing, to a node which redirects them.
+  if (cluster_slots_state_ == ClusterSlotsState::Known) {
+    cluster_slots_state_ = ClusterSlotsState::Unknown;
+  }
   for (const auto& host : hosts_removed) {
-    auto it = client_map_.find(host);
-    if (it != client_map_.end()) {
-      // We don't currently support any type of draining for redis connections. If a host is gone,
-      // we just close the connection. This will fail any pending requests.
-      it->second->redis_client_->close();
+    for (Upstream::HostConstSharedPtr& slot_host : slot_hosts_) {
+      if (slot_host == host) {
+        slot_host = nullptr;
+      }
+    }
+
+    // We don't currently support any type of draining for redis connections. If a host is gone,
+    // we just close its connections. This will fail any pending requests.
+    for (auto it = client_map_.find(host); it != client_map_.end(); it = client_map_.find(host)) {
+      it->second.clients_.front()->redis_client_->close();
     }
   }
 }
@@ -235,30 +301,230 @@ void InstanceImpl::ThreadLocalPool::onHostsRemoved(
 PoolRequest* InstanceImpl::ThreadLocalPool::makeRequest(const std::string& hash_key,
                                                         const RespValue& request,
                                                         PoolCallbacks& callbacks) {
-  LbContextImpl lb_context(hash_key);
-  Upstream::HostConstSharedPtr host = cluster_->loadBalancer().chooseHost(&lb_context);
+  Upstream::HostConstSharedPtr host = chooseHost(hash_key);
   if (!host) {
     return nullptr;
   }
 
-  ThreadLocalActiveClientPtr& client = client_map_[host];
-  if (!client) {
-    client.reset(new ThreadLocalActiveClient(*this));
-    client->host_ = host;
-    client->redis_client_ = parent_.client_factory_.create(host, dispatcher_, parent_.config_);
-    client->redis_client_->addConnectionCallbacks(*client);
+  return makeRequestToHost(host, request, callbacks);
+}
+
+Upstream::HostConstSharedPtr
+InstanceImpl::ThreadLocalPool::chooseHost(const std::string& hash_key) {
+  if (cluster_mode_) {
+    const uint16_t index = slots_[ClusterSlots::keySlot(hash_key)];
+    if (index != 0 && slot_hosts_[index - 1]) {
+      return slot_hosts_[index - 1];
+    }
+  }
+
+  LbContextImpl lb_context(hash_key);
+  return cluster_->loadBalancer().chooseHost(&lb_context);
+}
+
+Optional<uint16_t> InstanceImpl::ThreadLocalPool::hashSlot(const std::string& hash_key) {
+  Optional<uint16_t> slot;
+  if (cluster_mode_) {
+    slot = ClusterSlots::keySlot(hash_key);
+  }
+  return slot;
+}
+
+PoolRequest*
+InstanceImpl::ThreadLocalPool::makeRequestToHost(const Upstream::HostConstSharedPtr& host,
+                                                 const RespValue& request,
+                                                 PoolCallbacks& callbacks) {
+  if (cluster_slots_state_ == ClusterSlotsState::Unknown) {
+    refreshClusterSlots(host);
+  }
+
+  if (!cluster_mode_) {
+    return makeClientRequest(host, request, callbacks);
+  }
+
+  // The request is copied so that it can be sent again if it is redirected.
+  ClusterRequestPtr cluster_request(new ClusterRequest(*this, request, callbacks));
+  cluster_request->handle_ = makeClientRequest(host, cluster_request->request_, *cluster_request);
+  if (!cluster_request->handle_) {
+    return nullptr;
+  }
+
+  cluster_request->moveIntoList(std::move(cluster_request), cluster_requests_);
+  return cluster_requests_.front().get();
+}
+
+PoolRequest*
+InstanceImpl::ThreadLocalPool::makeClientRequest(const Upstream::HostConstSharedPtr& host,
+                                                 const RespValue& request,
+                                                 PoolCallbacks& callbacks) {
+  return chooseClient(host).redis_client_->makeRequest(request, callbacks);
+}
+
+InstanceImpl::ThreadLocalActiveClient&
+InstanceImpl::ThreadLocalPool::chooseClient(const Upstream::HostConstSharedPtr& host) {
+  ThreadLocalHostClients& host_clients = client_map_[host];
+  std::vector<ThreadLocalActiveClientPtr>& clients = host_clients.clients_;
+  const bool at_limit = clients.size() >= parent_.connections_per_host_;
+  if (parent_.least_outstanding_requests_) {
+    ThreadLocalActiveClient* least_loaded = nullptr;
+    for (const ThreadLocalActiveClientPtr& client : clients) {
+      if (least_loaded == nullptr || client->redis_client_->outstandingRequests() <
+                                         least_loaded->redis_client_->outstandingRequests()) {
+        least_loaded = client.get();
+      }
+    }
+    if (least_loaded != nullptr &&
+        (at_limit || least_loaded->redis_client_->outstandingRequests() == 0)) {
+      return *least_loaded;
+    }
+  } else if (at_limit) {
+    return *clients[host_clients.next_client_++ % clients.size()];
+  }
+
+  ThreadLocalActiveClientPtr client(new ThreadLocalActiveClient(*this));
+  client->host_ = host;
+  client->redis_client_ = parent_.client_factory_.create(host, dispatcher_, parent_.config_);
+  client->redis_client_->addConnectionCallbacks(*client);
+  clients.push_back(std::move(client));
+  return *clients.back();
+}
+
+void InstanceImpl::ThreadLocalPool::refreshClusterSlots(const Upstream::HostConstSharedPtr& host) {
+  cluster_slots_state_ = ClusterSlotsState::Refreshing;
+  if (!makeClientRequest(host, ClusterSlots::slotsRequest(), cluster_slots_callbacks_)) {
+    cluster_slots_state_ = ClusterSlotsState::Unknown;
+  }
+}
+
+void InstanceImpl::ThreadLocalPool::onClusterSlots(const RespValue& value) {
+  cluster_slots_state_ = ClusterSlotsState::Known;
+  std::vector<ClusterSlots::SlotRange> ranges;
+  if (!ClusterSlots::parseSlots(value, ranges)) {
+    // Most likely the upstream isn't a Redis Cluster. A cluster which fails to answer keeps its
+    // current slot map.
+    ENVOY_LOG(debug, "redis: no cluster slots: '{}'", value.toString());
+    return;
+  }
+
+  std::unordered_map<std::string, Upstream::HostConstSharedPtr> hosts;
+  for (const auto& host_set : cluster_->prioritySet().hostSetsPerPriority()) {
+    for (const auto& host : host_set->hosts()) {
+      hosts.emplace(host->address()->asString(), host);
+    }
+  }
+
+  std::vector<uint16_t> slots(ClusterSlots::NUM_SLOTS, 0);
+  std::vector<Upstream::HostConstSharedPtr> slot_hosts;
+  std::unordered_map<Upstream::HostConstSharedPtr, uint16_t> slot_host_indexes;
+  for (const ClusterSlots::SlotRange& range : ranges) {
+    auto host = hosts.find(range.address_);
+    if (host == hosts.end()) {
+      ENVOY_LOG(debug, "redis: cluster slots {}-{} served by unknown node {}", range.start_,
+                range.end_, range.address_);
+      continue;
+    }
+
+    auto index = slot_host_indexes.emplace(host->second, slot_hosts.size());
+    if (index.second) {
+      slot_hosts.push_back(host->second);
+    }
+    std::fill(slots.begin() + range.start_, slots.begin() + range.end_ + 1,
+              index.first->second + 1);
+  }
+
+  cluster_mode_ = true;
+  slots_.swap(slots);
+  slot_hosts_.swap(slot_hosts);
+}
+
+void InstanceImpl::ThreadLocalPool::onMoved(uint16_t slot,
+                                            const Upstream::HostConstSharedPtr& host) {
+  // Route the slot to its new master right away, and refresh the rest of the map, which has most
+  // likely changed as well.
+  auto index = std::find(slot_hosts_.begin(), slot_hosts_.end(), host);
+  if (index == slot_hosts_.end()) {
+    index = slot_hosts_.insert(slot_hosts_.end(), host);
+  }
+  slots_[slot] = index - slot_hosts_.begin() + 1;
+
+  if (cluster_slots_state_ != ClusterSlotsState::Refreshing) {
+    refreshClusterSlots(host);
+  }
+}
+
+Upstream::HostConstSharedPtr
+InstanceImpl::ThreadLocalPool::findHost(const std::string& address) {
+  for (const auto& host_set : cluster_->prioritySet().hostSetsPerPriority()) {
+    for (const auto& host : host_set->hosts()) {
+      if (host->address()->asString() == address) {
+        return host;
+      }
+    }
+  }
+  return nullptr;
+}
+
+void InstanceImpl::ClusterRequest::cancel() {
+  handle_->cancel();
+  parent_.dispatcher_.deferredDelete(removeFromList(parent_.cluster_requests_));
+}
+
+void InstanceImpl::ClusterRequest::onResponse(RespValuePtr&& value) {
+  handle_ = nullptr;
+  ClusterSlots::Redirection redirection;
+  if (!redirected_ && ClusterSlots::parseRedirection(*value, redirection)) {
+    // Only nodes which are hosts of the cluster are followed to.
+    Upstream::HostConstSharedPtr host = parent_.findHost(redirection.address_);
+    if (host) {
+      ENVOY_LOG(debug, "redis: '{}' redirected to {}", request_.toString(), redirection.address_);
+      redirected_ = true;
+      if (redirection.ask_) {
+        parent_.makeClientRequest(host, ClusterSlots::askingRequest(), parent_.asking_callbacks_);
+      } else {
+        parent_.onMoved(redirection.slot_, host);
+      }
+      handle_ = parent_.makeClientRequest(host, request_, *this);
+      if (handle_) {
+        return;
+      }
+    }
   }
 
-  return client->redis_client_->makeRequest(request, callbacks);
+  callbacks_.onResponse(std::move(value));
+  parent_.dispatcher_.deferredDelete(removeFromList(parent_.cluster_requests_));
+}
+
+void InstanceImpl::ClusterRequest::onFailure() {
+  callbacks_.onFailure();
+  parent_.dispatcher_.deferredDelete(removeFromList(parent_.cluster_requests_));
+}
+
+void InstanceImpl::ClusterSlotsCallbacks::onResponse(RespValuePtr&& value) {
+  parent_.onClusterSlots(*value);
+}
+
+void InstanceImpl::ClusterSlotsCallbacks::onFailure() {
+  // Try again with the next request.
+  parent_.cluster_slots_state_ = ClusterSlotsState::Unknown;
 }
 
 void InstanceImpl::ThreadLocalActiveClient::onEvent(Network::ConnectionEvent event) {
   if (event == Network::ConnectionEvent::RemoteClose ||
       event == Network::ConnectionEvent::LocalClose) {
-    auto client_to_delete = parent_.client_map_.find(host_);
-    ASSERT(client_to_delete != parent_.client_map_.end());
-    parent_.dispatcher_.deferredDelete(std::move(client_to_delete->second->redis_client_));
-    parent_.client_map_.erase(client_to_delete);
+    // Removing this client deletes it, so the pool is kept in a local.
+    ThreadLocalPool& parent = parent_;
+    auto host_clients = parent.client_map_.find(host_);
+    ASSERT(host_clients != parent.client_map_.end());
+    std::vector<ThreadLocalActiveClientPtr>& clients = host_clients->second.clients_;
+    auto client_to_delete = std::find_if(
+        clients.begin(), clients.end(),
+        [this](const ThreadLocalActiveClientPtr& client) -> bool { return client.get() == this; });
+    ASSERT(client_to_delete != clients.end());
+    parent.dispatcher_.deferredDelete(std::move((*client_to_delete)->redis_client_));
+    clients.erase(client_to_delete);
+    if (clients.empty()) {
+      parent.client_map_.erase(host_clients);
+    }
   }
 }
 
@@ -9,12 +9,16 @@
 #include <vector>
 
 #include "envoy/redis/conn_pool.h"
+#include "envoy/runtime/runtime.h"
 #include "envoy/thread_local/thread_local.h"
 #include "envoy/upstream/cluster_manager.h"
 
 #include "common/buffer/buffer_impl.h"
+#include "common/common/linked_object.h"
+#include "common/common/logger.h"
 #include "common/network/filter_impl.h"
 #include "common/protobuf/utility.h"
+#include "common/redis/cluster_slots.h"
 #include "common/redis/codec_impl.h"
 
 #include "api/filter/network/redis_proxy.pb.h"
@@ -32,6 +36,9 @@ public:
 
   bool disableOutlierEvents() const override { return false; }
   std::chrono::milliseconds opTimeout() const override { return op_timeout_; }
+  uint32_t maxBufferSizeBeforeFlush() const override { return MAX_BUFFER_SIZE_BEFORE_FLUSH; }
+
+  static const uint32_t MAX_BUFFER_SIZE_BEFORE_FLUSH = 16384;
 
 private:
   const std::chrono::milliseconds op_timeout_;
@@ -51,6 +58,7 @@ public:
   }
   void close() override;
   PoolRequest* makeRequest(const RespValue& request, PoolCallbacks& callbacks) override;
+  uint64_t outstandingRequests() const override { return pending_requests_.size(); }
 
 private:
   struct UpstreamReadFilter : public Network::ReadFilterBaseImpl {
@@ -81,6 +89,7 @@ private:
              DecoderFactory& decoder_factory, const Config& config);
   void onConnectOrOpTimeout();
   void onData(Buffer::Instance& data);
+  void flushBufferAndResetTimer();
   void putOutlierEvent(Upstream::Outlier::Result result);
 
   // Redis::DecoderCallbacks
@@ -100,6 +109,12 @@ private:
   std::list<PendingRequest> pending_requests_;
   Event::TimerPtr connect_or_op_timer_;
   bool connected_{};
+  // Requests are encoded into encoder_buffer_ and written together when this fires.
+  Event::TimerPtr flush_timer_;
+  bool flush_timer_enabled_{};
+  uint64_t buffered_requests_{};
+  Stats::Histogram& commands_per_write_;
+  Stats::Histogram& outstanding_requests_;
 };
 
 class ClientFactoryImpl : public ClientFactory {
@@ -114,15 +129,27 @@ private:
   DecoderFactoryImpl decoder_factory_;
 };
 
+/**
+ * Connection pool which keeps, on each worker, up to redis.connections_per_host connections to
+ * each upstream host (1 by default). Unless redis.least_outstanding_requests is set, requests go
+ * to the connections of a host in turn, the first requests opening them. Otherwise they go to the
+ * connection with the fewest outstanding requests, and another connection is only opened when
+ * all of them have some. Both runtime keys are read when the pool is created.
+ */
 class InstanceImpl : public Instance {
 public:
   InstanceImpl(const std::string& cluster_name, Upstream::ClusterManager& cm,
                ClientFactory& client_factory, ThreadLocal::SlotAllocator& tls,
+               Runtime::Loader& runtime,
                const envoy::api::v2::filter::network::RedisProxy::ConnPoolSettings& config);
 
   // Redis::ConnPool::Instance
   PoolRequest* makeRequest(const std::string& hash_key, const RespValue& request,
                            PoolCallbacks& callbacks) override;
+  Upstream::HostConstSharedPtr chooseHost(const std::string& hash_key) override;
+  Optional<uint16_t> hashSlot(const std::string& hash_key) override;
+  PoolRequest* makeRequestToHost(const Upstream::HostConstSharedPtr& host, const RespValue& request,
+                                 PoolCallbacks& callbacks) override;
 
 private:
   struct ThreadLocalPool;
@@ -142,19 +169,96 @@ private:
 
   typedef std::unique_ptr<ThreadLocalActiveClient> ThreadLocalActiveClientPtr;
 
-  struct ThreadLocalPool : public ThreadLocal::ThreadLocalObject {
+  // The connections of a worker to a host, which are removed as they close.
+  struct ThreadLocalHostClients {
+    std::vector<ThreadLocalActiveClientPtr> clients_;
+    // Index of the next connection to use, modulo the number of connections.
+    uint32_t next_client_{};
+  };
+
+  /**
+   * A request to a Redis Cluster, which is sent again to the node a MOVED or ASK redirection
+   * points to, once.
+   */
+  struct ClusterRequest : public PoolRequest,
+                          public PoolCallbacks,
+                          public Event::DeferredDeletable,
+                          public LinkedObject<ClusterRequest>,
+                          Logger::Loggable<Logger::Id::redis> {
+    ClusterRequest(ThreadLocalPool& parent, const RespValue& request, PoolCallbacks& callbacks)
+        : parent_(parent), request_(request), callbacks_(callbacks) {}
+
+    // Redis::ConnPool::PoolRequest
+    void cancel() override;
+
+    // Redis::ConnPool::PoolCallbacks
+    void onResponse(RespValuePtr&& value) override;
+    void onFailure() override;
+
+    ThreadLocalPool& parent_;
+    const RespValue request_;
+    PoolCallbacks& callbacks_;
+    PoolRequest* handle_{};
+    bool redirected_{};
+  };
+
+  typedef std::unique_ptr<ClusterRequest> ClusterRequestPtr;
+
+  struct ClusterSlotsCallbacks : public PoolCallbacks {
+    ClusterSlotsCallbacks(ThreadLocalPool& parent) : parent_(parent) {}
+
+    // Redis::ConnPool::PoolCallbacks
+    void onResponse(RespValuePtr&& value) override;
+    void onFailure() override;
+
+    ThreadLocalPool& parent_;
+  };
+
+  // The response to ASKING is of no interest, and a failure fails the redirected request as well.
+  struct AskingCallbacks : public PoolCallbacks {
+    // Redis::ConnPool::PoolCallbacks
+    void onResponse(RespValuePtr&&) override {}
+    void onFailure() override {}
+  };
+
+  struct ThreadLocalPool : public ThreadLocal::ThreadLocalObject,
+                           Logger::Loggable<Logger::Id::redis> {
     ThreadLocalPool(InstanceImpl& parent, Event::Dispatcher& dispatcher,
                     const std::string& cluster_name);
     ~ThreadLocalPool();
     PoolRequest* makeRequest(const std::string& hash_key, const RespValue& request,
                              PoolCallbacks& callbacks);
-    void onHostsRemoved(const std::vector<Upstream::HostSharedPtr>& hosts_removed);
+    Upstream::HostConstSharedPtr chooseHost(const std::string& hash_key);
+    Optional<uint16_t> hashSlot(const std::string& hash_key);
+    PoolRequest* makeRequestToHost(const Upstream::HostConstSharedPtr& host,
+                                   const RespValue& request, PoolCallbacks& callbacks);
+    PoolRequest* makeClientRequest(const Upstream::HostConstSharedPtr& host,
+                                   const RespValue& request, PoolCallbacks& callbacks);
+    ThreadLocalActiveClient& chooseClient(const Upstream::HostConstSharedPtr& host);
+    void onHostsChanged(const std::vector<Upstream::HostSharedPtr>& hosts_removed);
+    void refreshClusterSlots(const Upstream::HostConstSharedPtr& host);
+    void onClusterSlots(const RespValue& value);
+    void onMoved(uint16_t slot, const Upstream::HostConstSharedPtr& host);
+    Upstream::HostConstSharedPtr findHost(const std::string& address);
+
+    enum class ClusterSlotsState { Unknown, Refreshing, Known };
 
     InstanceImpl& parent_;
     Event::Dispatcher& dispatcher_;
     Upstream::ThreadLocalCluster* cluster_;
-    std::unordered_map<Upstream::HostConstSharedPtr, ThreadLocalActiveClientPtr> client_map_;
+    std::unordered_map<Upstream::HostConstSharedPtr, ThreadLocalHostClients> client_map_;
     Common::CallbackHandle* local_host_set_member_update_cb_handle_;
+    // Whether the upstream is a Redis Cluster is found out with the first request, by sending
+    // CLUSTER SLOTS ahead of it. Until the slot map is known keys are routed by consistent hashing.
+    ClusterSlotsState cluster_slots_state_{ClusterSlotsState::Unknown};
+    ClusterSlotsCallbacks cluster_slots_callbacks_;
+    AskingCallbacks asking_callbacks_;
+    bool cluster_mode_{};
+    // For each slot, 1 + the index in slot_hosts_ of the master which serves it, or 0 if the master
+    // isn't a host of the cluster.
+    std::vector<uint16_t> slots_;
+    std::vector<Upstream::HostConstSharedPtr> slot_hosts_;
+    std::list<ClusterRequestPtr> cluster_requests_;
   };
 
   struct LbContextImpl : public Upstream::LoadBalancerContext {
@@ -172,6 +276,8 @@ private:
   ClientFactory& client_factory_;
   ThreadLocal::SlotPtr tls_;
   ConfigImpl config_;
+  const uint32_t connections_per_host_;
+  const bool least_outstanding_requests_;
 };
 
 } // namespace ConnPool
@@ -0,0 +1,196 @@
+#include "common/redis/hot_key_cache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "common/common/hash.h"
+#include "common/common/utility.h"
+#include "common/runtime/key_registry.h"
+
+namespace Envoy {
+namespace Redis {
+
+static const Runtime::Key RuntimeCacheTtl =
+    Runtime::KeyRegistry::registerKey("redis.hot_key_cache.ttl_ms");
+static const Runtime::Key RuntimeCacheMaxEntries =
+    Runtime::KeyRegistry::registerKey("redis.hot_key_cache.max_entries");
+static const Runtime::Key RuntimeDetectionThreshold =
+    Runtime::KeyRegistry::registerKey("redis.hot_key_detection.threshold");
+
+CountMinSketch::CountMinSketch(uint32_t width, uint32_t depth)
+    : width_(width), depth_(depth), counters_(width * depth) {}
+
+template <class Function>
+void CountMinSketch::forEachCounter(const std::string& key, Function function) const {
+  // The counter of each row is picked by a hash of its own, derived from two halves of one hash.
+  const uint64_t hash = HashUtil::xxHash64(key);
+  const uint32_t hash1 = hash;
+  const uint32_t hash2 = (hash >> 32) | 1;
+  for (uint32_t row = 0; row < depth_; row++) {
+    function(counters_[row * width_ + (hash1 + row * hash2) % width_]);
+  }
+}
+
+uint32_t CountMinSketch::add(const std::string& key) {
+  uint32_t estimate = std::numeric_limits<uint32_t>::max();
+  forEachCounter(key, [&estimate](uint32_t& counter) -> void {
+    if (counter < std::numeric_limits<uint32_t>::max()) {
+      counter++;
+    }
+    estimate = std::min(estimate, counter);
+  });
+  return estimate;
+}
+
+uint32_t CountMinSketch::estimate(const std::string& key) const {
+  uint32_t estimate = std::numeric_limits<uint32_t>::max();
+  forEachCounter(key, [&estimate](uint32_t& counter) -> void {
+    estimate = std::min(estimate, counter);
+  });
+  return estimate;
+}
+
+void CountMinSketch::clear() { std::fill(counters_.begin(), counters_.end(), 0); }
+
+HotKeyCache::HotKeyCache(ThreadLocal::SlotAllocator& tls, Runtime::Loader& runtime,
+                         MonotonicTimeSource& time_source, Stats::Scope& scope,
+                         const std::string& stat_prefix)
+    : tls_(tls.allocateSlot()), runtime_(runtime), time_source_(time_source),
+      stats_{ALL_HOT_KEY_STATS(POOL_COUNTER_PREFIX(scope, stat_prefix + "hot_keys."))} {
+  tls_->set([](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<ThreadLocalCache>();
+  });
+}
+
+HotKeyCache::ThreadLocalCache& HotKeyCache::threadLocalCache() {
+  ThreadLocalCache& cache = tls_->getTyped<ThreadLocalCache>();
+  const Runtime::Snapshot& snapshot = runtime_.snapshot();
+  if (cache.settings_loaded_ && snapshot.version() == cache.settings_version_) {
+    return cache;
+  }
+
+  cache.settings_loaded_ = true;
+  cache.settings_version_ = snapshot.version();
+  cache.prefixes_ = StringUtil::split(snapshot.get("redis.hot_key_cache.prefixes"), ",");
+  cache.ttl_ = std::chrono::milliseconds(snapshot.getInteger(RuntimeCacheTtl, 100));
+  cache.max_entries_ = snapshot.getInteger(RuntimeCacheMaxEntries, 1024);
+  cache.detection_threshold_ = snapshot.getInteger(RuntimeDetectionThreshold, 0);
+
+  // Drop the responses which are no longer cacheable, or don't fit anymore.
+  for (auto entry = cache.entry_map_.begin(); entry != cache.entry_map_.end();) {
+    if (cache.cacheable(entry->first)) {
+      ++entry;
+    } else {
+      cache.erase(entry++);
+    }
+  }
+  while (cache.entry_map_.size() > cache.max_entries_) {
+    cache.erase(cache.entry_map_.find(cache.entries_.back().key_));
+  }
+  return cache;
+}
+
+HotKeyCache::Lookup HotKeyCache::lookup(const std::string& key) {
+  ThreadLocalCache& cache = threadLocalCache();
+  Lookup lookup{nullptr, cache.cacheable(key), cache.generation_};
+  if (!lookup.cacheable_ && cache.detection_threshold_ == 0) {
+    return lookup;
+  }
+
+  const MonotonicTime now = time_source_.currentTime();
+  if (cache.detection_threshold_ > 0) {
+    if (now - cache.sketch_start_ >= std::chrono::seconds(1)) {
+      cache.sketch_.clear();
+      cache.sketch_start_ = now;
+    }
+    // The estimate grows by one at a time, so each hot key is reported once a second.
+    if (cache.sketch_.add(key) == cache.detection_threshold_) {
+      stats_.detected_.inc();
+      ENVOY_LOG(debug, "redis: hot key '{}'", key);
+    }
+  }
+
+  if (!lookup.cacheable_) {
+    return lookup;
+  }
+
+  auto entry = cache.entry_map_.find(key);
+  if (entry != cache.entry_map_.end() && entry->second->expiry_ <= now) {
+    cache.erase(entry);
+    entry = cache.entry_map_.end();
+  }
+  if (entry == cache.entry_map_.end()) {
+    stats_.cache_miss_.inc();
+    return lookup;
+  }
+
+  stats_.cache_hit_.inc();
+  cache.entries_.splice(cache.entries_.begin(), cache.entries_, entry->second);
+  lookup.response_ = &entry->second->response_;
+  return lookup;
+}
+
+void HotKeyCache::insert(const std::string& key, const RespValue& response, uint64_t generation) {
+  ThreadLocalCache& cache = threadLocalCache();
+  if (generation != cache.generation_ || cache.max_entries_ == 0 || !cache.cacheable(key) ||
+      (response.type() != RespType::BulkString && response.type() != RespType::Null)) {
+    return;
+  }
+
+  auto entry = cache.entry_map_.find(key);
+  if (entry != cache.entry_map_.end()) {
+    cache.erase(entry);
+  }
+  while (cache.entry_map_.size() >= cache.max_entries_) {
+    stats_.cache_eviction_.inc();
+    cache.erase(cache.entry_map_.find(cache.entries_.back().key_));
+  }
+
+  cache.entries_.push_front({key, response, time_source_.currentTime() + cache.ttl_});
+  cache.entry_map_.emplace(key, cache.entries_.begin());
+}
+
+void HotKeyCache::invalidate(const RespValue& request) {
+  ThreadLocalCache& cache = threadLocalCache();
+  if (cache.prefixes_.empty()) {
+    return;
+  }
+
+  const std::vector<RespValue>& args = request.asArray();
+  for (uint64_t i = 1; i < args.size(); i++) {
+    const std::string& key = args[i].asString();
+    if (!cache.cacheable(key)) {
+      continue;
+    }
+
+    // Responses to GETs which are outstanding are stale as well.
+    cache.generation_++;
+    auto entry = cache.entry_map_.find(key);
+    if (entry != cache.entry_map_.end()) {
+      stats_.cache_invalidation_.inc();
+      cache.erase(entry);
+    }
+  }
+}
+
+bool HotKeyCache::ThreadLocalCache::cacheable(const std::string& key) const {
+  for (const std::string& prefix : prefixes_) {
+    if (key.compare(0, prefix.size(), prefix) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void HotKeyCache::ThreadLocalCache::erase(
+    std::unordered_map<std::string, std::list<Entry>::iterator>::iterator entry) {
+  entries_.erase(entry->second);
+  entry_map_.erase(entry);
+}
+
+} // namespace Redis
+} // namespace Envoy
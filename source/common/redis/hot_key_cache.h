@@ -0,0 +1,178 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "envoy/common/time.h"
+#include "envoy/redis/codec.h"
+#include "envoy/runtime/runtime.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/common/logger.h"
+
+namespace Envoy {
+namespace Redis {
+
+/**
+ * All hot key stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_HOT_KEY_STATS(COUNTER)                                                                 \
+  COUNTER(cache_hit)                                                                               \
+  COUNTER(cache_miss)                                                                              \
+  COUNTER(cache_eviction)                                                                          \
+  COUNTER(cache_invalidation)                                                                      \
+  COUNTER(detected)
+// clang-format on
+
+/**
+ * Struct definition for all hot key stats. @see stats_macros.h
+ */
+struct HotKeyStats {
+  ALL_HOT_KEY_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Count-min sketch, see "An Improved Data Stream Summary: The Count-Min Sketch and its
+ * Applications" by G. Cormode and S. Muthukrishnan. It estimates how often each key occurs in a
+ * fixed amount of memory. An estimate is never lower than the actual count, and is only higher
+ * than it by more than e / width of the total count with a probability of e^-depth.
+ */
+class CountMinSketch {
+public:
+  CountMinSketch(uint32_t width, uint32_t depth);
+
+  /**
+   * Count an occurrence of a key.
+   * @param key supplies the key.
+   * @return uint32_t the estimated number of occurrences of the key, including this one.
+   */
+  uint32_t add(const std::string& key);
+
+  /**
+   * @param key supplies the key.
+   * @return uint32_t the estimated number of occurrences of the key.
+   */
+  uint32_t estimate(const std::string& key) const;
+
+  /**
+   * Forget all occurrences.
+   */
+  void clear();
+
+private:
+  template <class Function> void forEachCounter(const std::string& key, Function function) const;
+
+  const uint32_t width_;
+  const uint32_t depth_;
+  // depth_ rows of width_ counters each.
+  mutable std::vector<uint32_t> counters_;
+};
+
+/**
+ * Per worker cache of the responses to GET for keys with configured prefixes, so that keys which
+ * get a large share of the reads are served without going to the single upstream host which
+ * serves them each time, and detection of keys which are read often enough to be worth caching.
+ * Both are configured with runtime, so that the keys can be changed as they are found:
+ *   redis.hot_key_cache.prefixes: comma separated prefixes of the keys to cache. Nothing is cached
+ *     if empty, which is the default.
+ *   redis.hot_key_cache.ttl_ms: how long a response is served from the cache, 100 by default.
+ *   redis.hot_key_cache.max_entries: how many responses each worker caches, 1024 by default. The
+ *     least recently used response is evicted to make room.
+ *   redis.hot_key_detection.threshold: how many times a worker sees GET for a key in a second
+ *     before the key is counted in the detected stat and logged as hot. 0, the default, turns
+ *     detection off.
+ * A write through the same worker invalidates the cached responses for its keys, writes through
+ * other workers or other clients are only seen once the response expires.
+ */
+class HotKeyCache : Logger::Loggable<Logger::Id::redis> {
+public:
+  HotKeyCache(ThreadLocal::SlotAllocator& tls, Runtime::Loader& runtime,
+              MonotonicTimeSource& time_source, Stats::Scope& scope,
+              const std::string& stat_prefix);
+
+  /**
+   * The result of looking up the response to GET for a key.
+   */
+  struct Lookup {
+    // The cached response, or nullptr.
+    const RespValue* response_;
+    // Whether the response can be cached, if there is none.
+    bool cacheable_;
+    // The number of invalidations so far, which is passed on to insert().
+    uint64_t generation_;
+  };
+
+  /**
+   * Look up the response to GET for a key, and count the key for hot key detection.
+   * @param key supplies the key.
+   * @return Lookup the result, whose response_ is valid until the cache is used again.
+   */
+  Lookup lookup(const std::string& key);
+
+  /**
+   * Cache the response to GET for a key, unless a write through this worker made the response
+   * stale while it was outstanding.
+   * @param key supplies the key.
+   * @param response supplies the response. Only bulk strings and nulls are cached.
+   * @param generation supplies the generation_ of the lookup which missed.
+   */
+  void insert(const std::string& key, const RespValue& response, uint64_t generation);
+
+  /**
+   * Invalidate the cached responses for the keys of a command which isn't a read.
+   * @param request supplies the command, all of whose arguments are bulk strings. Arguments which
+   *        aren't keys may invalidate responses needlessly, but never wrongly.
+   */
+  void invalidate(const RespValue& request);
+
+  static const uint32_t SKETCH_WIDTH = 1024;
+  static const uint32_t SKETCH_DEPTH = 4;
+
+private:
+  struct Entry {
+    std::string key_;
+    RespValue response_;
+    MonotonicTime expiry_;
+  };
+
+  struct ThreadLocalCache : public ThreadLocal::ThreadLocalObject {
+    ThreadLocalCache() : sketch_(SKETCH_WIDTH, SKETCH_DEPTH) {}
+
+    bool cacheable(const std::string& key) const;
+    void erase(std::unordered_map<std::string, std::list<Entry>::iterator>::iterator entry);
+
+    // The settings, as of the runtime snapshot with settings_version_.
+    bool settings_loaded_{};
+    uint64_t settings_version_{};
+    std::vector<std::string> prefixes_;
+    std::chrono::milliseconds ttl_{};
+    uint64_t max_entries_{};
+    uint64_t detection_threshold_{};
+
+    // Most recently used first.
+    std::list<Entry> entries_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> entry_map_;
+    uint64_t generation_{};
+    CountMinSketch sketch_;
+    MonotonicTime sketch_start_;
+  };
+
+  ThreadLocalCache& threadLocalCache();
+
+  ThreadLocal::SlotPtr tls_;
+  Runtime::Loader& runtime_;
+  MonotonicTimeSource& time_source_;
+  HotKeyStats stats_;
+};
+
+typedef std::unique_ptr<HotKeyCache> HotKeyCachePtr;
+
+} // namespace Redis
+} // namespace Envoy
@@ -42,6 +42,11 @@ struct SupportedCommands {
     CONSTRUCT_ON_FIRST_USE(std::vector<std::string>, "del", "exists", "touch", "unlink");
   }
 
+  /**
+   * @return get command
+   */
+  static const std::string& get() { CONSTRUCT_ON_FIRST_USE(std::string, "get"); }
+
   /**
    * @return mget command
    */
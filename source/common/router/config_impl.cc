@@ -9,6 +9,7 @@
 #include <string>
 #include <vector>
 
+#include "envoy/http/codes.h"
 #include "envoy/http/header_map.h"
 #include "envoy/runtime/runtime.h"
 #include "envoy/upstream/cluster_manager.h"
@@ -16,6 +17,7 @@
 
 #include "common/common/assert.h"
 #include "common/common/empty_string.h"
+#include "common/common/enum_to_int.h"
 #include "common/common/hash.h"
 #include "common/common/utility.h"
 #include "common/config/metadata.h"
@@ -47,7 +49,8 @@ RetryPolicyImpl::RetryPolicyImpl(const envoy::api::v2::RouteAction& config) {
   retry_on_ |= RetryStateImpl::parseRetryGrpcOn(config.retry_policy().retry_on());
 }
 
-CorsPolicyImpl::CorsPolicyImpl(const envoy::api::v2::CorsPolicy& config) {
+CorsPolicyImpl::CorsPolicyImpl(const envoy::api::v2::CorsPolicy& config,
+                               const CorsPolicy* fallback) {
   for (const auto& origin : config.allow_origin()) {
     allow_origin_.push_back(origin);
   }
@@ -59,6 +62,60 @@ CorsPolicyImpl::CorsPolicyImpl(const envoy::api::v2::CorsPolicy& config) {
     allow_credentials_.value(PROTOBUF_GET_WRAPPED_REQUIRED(config, allow_credentials));
   }
   enabled_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, enabled, true);
+
+  if (fallback != nullptr) {
+    if (allow_origin_.empty()) {
+      allow_origin_ = fallback->allowOrigins();
+    }
+    if (allow_methods_.empty()) {
+      allow_methods_ = fallback->allowMethods();
+    }
+    if (allow_headers_.empty()) {
+      allow_headers_ = fallback->allowHeaders();
+    }
+    if (expose_headers_.empty()) {
+      expose_headers_ = fallback->exposeHeaders();
+    }
+    if (max_age_.empty()) {
+      max_age_ = fallback->maxAge();
+    }
+    if (!allow_credentials_.valid()) {
+      allow_credentials_ = fallback->allowCredentials();
+    }
+  }
+
+  for (const auto& origin : allow_origin_) {
+    if (origin == "*") {
+      allow_any_origin_ = true;
+    } else {
+      allow_origin_set_.insert(origin);
+    }
+  }
+
+  preflight_headers_.insertStatus().value(enumToInt(Http::Code::OK));
+  // Left empty for the origin of each preflight request.
+  preflight_headers_.insertAccessControlAllowOrigin();
+  if (allow_credentials_.valid() && allow_credentials_.value()) {
+    preflight_headers_.insertAccessControlAllowCredentials().value(
+        Http::Headers::get().CORSValues.True);
+  }
+  if (!allow_methods_.empty()) {
+    preflight_headers_.insertAccessControlAllowMethods().value(allow_methods_);
+  }
+  if (!allow_headers_.empty()) {
+    preflight_headers_.insertAccessControlAllowHeaders().value(allow_headers_);
+  }
+  if (!expose_headers_.empty()) {
+    preflight_headers_.insertAccessControlExposeHeaders().value(expose_headers_);
+  }
+  if (!max_age_.empty()) {
+    preflight_headers_.insertAccessControlMaxAge().value(max_age_);
+  }
+}
+
+bool CorsPolicyImpl::allowsOrigin(const Http::HeaderString& origin) const {
+  return allow_any_origin_ ||
+         allow_origin_set_.count(std::string(origin.c_str(), origin.size())) > 0;
 }
 
 ShadowPolicyImpl::ShadowPolicyImpl(const envoy::api::v2::RouteAction& config) {
@@ -204,6 +261,16 @@ MetadataMatchCriteriaImpl::extractMetadataMatchCriteria(const MetadataMatchCrite
   return v;
 }
 
+std::size_t MetadataMatchCriteriaImpl::hashMetadataMatchCriteria(
+    const std::vector<MetadataMatchCriterionConstSharedPtr>& criteria) {
+  // The criteria are sorted by name, so equal criteria are hashed in the same order.
+  uint64_t hash = 0;
+  for (const MetadataMatchCriterionConstSharedPtr& criterion : criteria) {
+    hash = HashUtil::xxHash64(criterion->name(), hash ^ criterion->value().hash());
+  }
+  return hash;
+}
+
 DecoratorImpl::DecoratorImpl(const envoy::api::v2::Decorator& decorator)
     : operation_(decorator.operation()) {}
 
@@ -254,6 +321,7 @@ RouteEntryImplBase::RouteEntryImplBase(const VirtualHostImpl& vhost,
   // the criteria from the route.
   if (route.route().cluster_specifier_case() == envoy::api::v2::RouteAction::kWeightedClusters) {
     uint64_t total_weight = 0UL;
+    std::vector<uint64_t> configured_weights;
     const std::string& runtime_key_prefix = route.route().weighted_clusters().runtime_key_prefix();
 
     for (const auto& cluster : route.route().weighted_clusters().clusters()) {
@@ -278,6 +346,7 @@ RouteEntryImplBase::RouteEntryImplBase(const VirtualHostImpl& vhost,
                                    cluster_name, PROTOBUF_GET_WRAPPED_REQUIRED(cluster, weight),
                                    std::move(cluster_metadata_match_criteria)));
       weighted_clusters_.emplace_back(std::move(cluster_entry));
+      configured_weights.push_back(PROTOBUF_GET_WRAPPED_REQUIRED(cluster, weight));
       total_weight += weighted_clusters_.back()->clusterWeight();
     }
 
@@ -285,6 +354,13 @@ RouteEntryImplBase::RouteEntryImplBase(const VirtualHostImpl& vhost,
       throw EnvoyException(fmt::format("Sum of weights in the weighted_cluster should add up to {}",
                                        WeightedClusterEntry::MAX_CLUSTER_WEIGHT));
     }
+
+    weighted_cluster_table_.reset(new ClusterAliasTable(configured_weights));
+    runtime_weights_ = !runtime_key_prefix.empty();
+    if (runtime_weights_) {
+      runtime_weighted_cluster_table_ = buildRuntimeWeightedClusterTable();
+      runtime_weighted_cluster_table_version_ = loader_.snapshot().version();
+    }
   }
 
   for (const auto& header_map : route.match().headers()) {
@@ -302,7 +378,7 @@ RouteEntryImplBase::RouteEntryImplBase(const VirtualHostImpl& vhost,
        PROTOBUF_GET_WRAPPED_OR_DEFAULT(route.route(), include_vh_rate_limits, false));
 
   if (route.route().has_cors()) {
-    cors_policy_.reset(new CorsPolicyImpl(route.route().cors()));
+    cors_policy_.reset(new CorsPolicyImpl(route.route().cors(), vhost.corsPolicy()));
   }
 }
 
@@ -319,6 +395,19 @@ bool RouteEntryImplBase::matchRoute(const Http::HeaderMap& headers, uint64_t ran
   return matches;
 }
 
+bool RouteEntryImplBase::addRouteKeyHeaders(std::vector<Http::LowerCaseString>& headers) const {
+  if (runtime_.valid() || !weighted_clusters_.empty()) {
+    return false;
+  }
+  for (const ConfigUtility::HeaderData& header_data : config_headers_) {
+    headers.push_back(header_data.name_);
+  }
+  if (!cluster_header_name_.get().empty()) {
+    headers.push_back(cluster_header_name_);
+  }
+  return true;
+}
+
 const std::string& RouteEntryImplBase::clusterName() const { return cluster_name_; }
 
 void RouteEntryImplBase::finalizeRequestHeaders(Http::HeaderMap& headers,
@@ -327,7 +416,7 @@ void RouteEntryImplBase::finalizeRequestHeaders(Http::HeaderMap& headers,
   // virtual host level headers and finally global connection manager level headers.
   request_headers_parser_->evaluateHeaders(headers, request_info);
   vhost_.requestHeaderParser().evaluateHeaders(headers, request_info);
-  vhost_.globalRouteConfig().requestHeaderParser().evaluateHeaders(headers, request_info);
+  vhost_.globalHeaderParsers().request_headers_parser_->evaluateHeaders(headers, request_info);
   if (host_rewrite_.empty()) {
     return;
   }
@@ -338,7 +427,7 @@ void RouteEntryImplBase::finalizeResponseHeaders(Http::HeaderMap& headers,
                                                  const AccessLog::RequestInfo& request_info) const {
   response_headers_parser_->evaluateHeaders(headers, request_info);
   vhost_.responseHeaderParser().evaluateHeaders(headers, request_info);
-  vhost_.globalRouteConfig().responseHeaderParser().evaluateHeaders(headers, request_info);
+  vhost_.globalHeaderParsers().response_headers_parser_->evaluateHeaders(headers, request_info);
 }
 
 Optional<RouteEntryImplBase::RuntimeData>
@@ -456,27 +545,101 @@ RouteConstSharedPtr RouteEntryImplBase::clusterEntry(const Http::HeaderMap& head
     }
   }
 
-  uint64_t selected_value = random_value % WeightedClusterEntry::MAX_CLUSTER_WEIGHT;
-  uint64_t begin = 0UL;
-  uint64_t end = 0UL;
+  return weighted_clusters_[selectWeightedCluster(random_value)];
+}
+
+size_t RouteEntryImplBase::selectWeightedCluster(uint64_t random_value) const {
+  if (!runtime_weights_) {
+    return weighted_cluster_table_->select(random_value);
+  }
+
+  // Workers pick up a new runtime snapshot at slightly different times, so the table is only ever
+  // rebuilt for a newer snapshot. A worker still on the previous snapshot uses the newer weights
+  // rather than rebuilding the table back and forth.
+  const uint64_t version = loader_.snapshot().version();
+  ClusterAliasTableConstSharedPtr table;
+  {
+    std::lock_guard<std::mutex> guard(runtime_weighted_cluster_table_lock_);
+    if (version > runtime_weighted_cluster_table_version_) {
+      runtime_weighted_cluster_table_ = buildRuntimeWeightedClusterTable();
+      runtime_weighted_cluster_table_version_ = version;
+    }
+    table = runtime_weighted_cluster_table_;
+  }
+  return table->select(random_value);
+}
 
-  // Find the right cluster to route to based on the interval in which
-  // the selected value falls. The intervals are determined as
-  // [0, cluster1_weight), [cluster1_weight, cluster1_weight+cluster2_weight),..
+RouteEntryImplBase::ClusterAliasTableConstSharedPtr
+RouteEntryImplBase::buildRuntimeWeightedClusterTable() const {
+  std::vector<uint64_t> weights;
+  weights.reserve(weighted_clusters_.size());
   for (const WeightedClusterEntrySharedPtr& cluster : weighted_clusters_) {
-    end = begin + cluster->clusterWeight();
-    if (((selected_value >= begin) && (selected_value < end)) ||
-        (end >= WeightedClusterEntry::MAX_CLUSTER_WEIGHT)) {
-      // end > WeightedClusterEntry::MAX_CLUSTER_WEIGHT : This case can only occur
-      // with Runtimes, when the user specifies invalid weights such that
-      // sum(weights) > WeightedClusterEntry::MAX_CLUSTER_WEIGHT.
-      // In this case, terminate the search and just return the cluster
-      // whose weight cased the overflow
-      return cluster;
+    weights.push_back(cluster->clusterWeight());
+  }
+  return std::make_shared<const ClusterAliasTable>(weights);
+}
+
+RouteEntryImplBase::ClusterAliasTable::ClusterAliasTable(const std::vector<uint64_t>& weights)
+    : thresholds_(weights.size()), aliases_(weights.size()) {
+  ASSERT(!weights.empty());
+  const uint64_t n = weights.size();
+  std::vector<uint64_t> scaled_weights(weights);
+  for (uint64_t weight : weights) {
+    total_weight_ += weight;
+  }
+  if (total_weight_ == 0) {
+    std::fill(scaled_weights.begin(), scaled_weights.end(), 1);
+    total_weight_ = n;
+  }
+
+  // Scaling the weights by n makes their mean the total weight, which is the height of every
+  // column. Columns of clusters below the mean are topped up by clusters above it.
+  std::vector<size_t> small;
+  std::vector<size_t> large;
+  for (size_t i = 0; i < n; i++) {
+    scaled_weights[i] *= n;
+    aliases_[i] = i;
+    if (scaled_weights[i] < total_weight_) {
+      small.push_back(i);
+    } else {
+      large.push_back(i);
     }
-    begin = end;
   }
-  NOT_REACHED;
+
+  while (!small.empty() && !large.empty()) {
+    const size_t column = small.back();
+    small.pop_back();
+    const size_t alias = large.back();
+    thresholds_[column] = scaled_weights[column];
+    aliases_[column] = alias;
+    scaled_weights[alias] -= total_weight_ - scaled_weights[column];
+    if (scaled_weights[alias] < total_weight_) {
+      large.pop_back();
+      small.push_back(alias);
+    }
+  }
+
+  // The arithmetic is exact, so only full columns are left over.
+  ASSERT(small.empty());
+  for (size_t column : large) {
+    thresholds_[column] = total_weight_;
+  }
+}
+
+size_t RouteEntryImplBase::ClusterAliasTable::select(uint64_t random_value) const {
+  const uint64_t n = thresholds_.size();
+  const size_t column = random_value % n;
+  const uint64_t weight = (random_value / n) % total_weight_;
+  return weight < thresholds_[column] ? column : aliases_[column];
+}
+
+void RouteEntryImplBase::resolveClusterHandles(Upstream::ClusterManager& cm) {
+  if (!cluster_name_.empty()) {
+    cluster_handle_.value(cm.clusterHandle(cluster_name_));
+  }
+  for (const WeightedClusterEntrySharedPtr& cluster : weighted_clusters_) {
+    cluster->resolveClusterHandle(cm);
+  }
 }
 
 void RouteEntryImplBase::validateClusters(Upstream::ClusterManager& cm) const {
@@ -568,7 +731,8 @@ RegexRouteEntryImpl::RegexRouteEntryImpl(const VirtualHostImpl& vhost,
                                          const envoy::api::v2::Route& route,
                                          Runtime::Loader& loader)
     : RouteEntryImplBase(vhost, route, loader),
-      regex_(std::regex{route.match().regex().c_str(), std::regex::optimize}) {}
+      regex_(std::regex{route.match().regex().c_str(), std::regex::optimize}),
+      regex_prefix_(RegexUtil::literalPrefix(route.match().regex())) {}
 
 void RegexRouteEntryImpl::finalizeRequestHeaders(Http::HeaderMap& headers,
                                                  const AccessLog::RequestInfo& request_info) const {
@@ -583,8 +747,13 @@ void RegexRouteEntryImpl::finalizeRequestHeaders(Http::HeaderMap& headers,
 
 RouteConstSharedPtr RegexRouteEntryImpl::matches(const Http::HeaderMap& headers,
                                                  uint64_t random_value) const {
+  const Http::HeaderString& path = headers.Path()->value();
+  // Rule out most paths with the literal prefix before running the regex.
+  if (!StringUtil::startsWith(path.c_str(), regex_prefix_)) {
+    return nullptr;
+  }
+
   if (RouteEntryImplBase::matchRoute(headers, random_value)) {
-    const Http::HeaderString& path = headers.Path()->value();
     const char* query_string_start = Http::Utility::findQueryStringStart(path);
     if (std::regex_match(path.c_str(), query_string_start, regex_)) {
       return clusterEntry(headers, random_value);
@@ -594,10 +763,11 @@ RouteConstSharedPtr RegexRouteEntryImpl::matches(const Http::HeaderMap& headers,
 }
 
 VirtualHostImpl::VirtualHostImpl(const envoy::api::v2::VirtualHost& virtual_host,
-                                 const ConfigImpl& global_route_config, Runtime::Loader& runtime,
-                                 Upstream::ClusterManager& cm, bool validate_clusters)
+                                 GlobalHeaderParsersConstSharedPtr global_header_parsers,
+                                 Runtime::Loader& runtime, Upstream::ClusterManager& cm,
+                                 bool validate_clusters)
     : name_(virtual_host.name()), rate_limit_policy_(virtual_host.rate_limits()),
-      global_route_config_(global_route_config),
+      global_header_parsers_(global_header_parsers),
       request_headers_parser_(HeaderParser::configure(virtual_host.request_headers_to_add())),
       response_headers_parser_(HeaderParser::configure(virtual_host.response_headers_to_add(),
                                                        virtual_host.response_headers_to_remove())) {
@@ -615,42 +785,75 @@ VirtualHostImpl::VirtualHostImpl(const envoy::api::v2::VirtualHost& virtual_host
     NOT_REACHED;
   }
 
+  // The route policies are merged with this one when built.
+  if (virtual_host.has_cors()) {
+    cors_policy_.reset(new CorsPolicyImpl(virtual_host.cors(), nullptr));
+  }
+
   for (const auto& route : virtual_host.routes()) {
     const bool has_prefix =
         route.match().path_specifier_case() == envoy::api::v2::RouteMatch::kPrefix;
     const bool has_path = route.match().path_specifier_case() == envoy::api::v2::RouteMatch::kPath;
     const bool has_regex =
         route.match().path_specifier_case() == envoy::api::v2::RouteMatch::kRegex;
+    std::shared_ptr<RouteEntryImplBase> route_entry;
     if (has_prefix) {
-      routes_.emplace_back(new PrefixRouteEntryImpl(*this, route, runtime));
+      route_entry.reset(new PrefixRouteEntryImpl(*this, route, runtime));
     } else if (has_path) {
-      routes_.emplace_back(new PathRouteEntryImpl(*this, route, runtime));
+      route_entry.reset(new PathRouteEntryImpl(*this, route, runtime));
     } else {
       ASSERT(has_regex);
       UNREFERENCED_PARAMETER(has_regex);
-      routes_.emplace_back(new RegexRouteEntryImpl(*this, route, runtime));
+      route_entry.reset(new RegexRouteEntryImpl(*this, route, runtime));
     }
-
-    if (validate_clusters) {
-      routes_.back()->validateClusters(cm);
-      if (!routes_.back()->shadowPolicy().cluster().empty()) {
-        if (!cm.get(routes_.back()->shadowPolicy().cluster())) {
-          throw EnvoyException(fmt::format("route: unknown shadow cluster '{}'",
-                                           routes_.back()->shadowPolicy().cluster()));
-        }
-      }
+    route_entry->resolveClusterHandles(cm);
+    routes_.emplace_back(std::move(route_entry));
+
+    const uint32_t ordinal = routes_.size() - 1;
+    if (has_prefix && routes_.back()->matchesOnPathOnly()) {
+      path_index_.addPrefix(route.match().prefix(), ordinal);
+    } else if (has_path && routes_.back()->matchesOnPathOnly()) {
+      path_index_.addPath(route.match().path(), ordinal);
+    } else {
+      unindexed_routes_.push_back(ordinal);
     }
   }
 
+  if (validate_clusters) {
+    validateClusters(cm);
+  }
+
   for (const auto& virtual_cluster : virtual_host.virtual_clusters()) {
     virtual_clusters_.push_back(VirtualClusterEntry(virtual_cluster));
   }
 
-  if (virtual_host.has_cors()) {
-    cors_policy_.reset(new CorsPolicyImpl(virtual_host.cors()));
+}
+
+void VirtualHostImpl::validateClusters(Upstream::ClusterManager& cm) const {
+  for (const auto& route : routes_) {
+    route->validateClusters(cm);
+    if (!route->shadowPolicy().cluster().empty()) {
+      if (!cm.get(route->shadowPolicy().cluster())) {
+        throw EnvoyException(
+            fmt::format("route: unknown shadow cluster '{}'", route->shadowPolicy().cluster()));
+      }
+    }
   }
 }
 
+bool VirtualHostImpl::addRouteKeyHeaders(std::vector<Http::LowerCaseString>& headers) const {
+  if (ssl_requirements_ != SslRequirements::NONE) {
+    headers.push_back(Http::Headers::get().ForwardedProto);
+    headers.push_back(Http::Headers::get().EnvoyInternalRequest);
+  }
+  for (const auto& route : routes_) {
+    if (!route->addRouteKeyHeaders(headers)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 VirtualHostImpl::VirtualClusterEntry::VirtualClusterEntry(
     const envoy::api::v2::VirtualCluster& virtual_cluster) {
   if (virtual_cluster.method() != envoy::api::v2::RequestMethod::METHOD_UNSPECIFIED) {
@@ -659,35 +862,35 @@ VirtualHostImpl::VirtualClusterEntry::VirtualClusterEntry(
 
   const std::string pattern = virtual_cluster.pattern();
   pattern_ = std::regex{pattern, std::regex::optimize};
+  pattern_prefix_ = RegexUtil::literalPrefix(pattern);
   name_ = virtual_cluster.name();
 }
 
-const VirtualHostImpl* RouteMatcher::findWildcardVirtualHost(const std::string& host) const {
-  // We do a longest wildcard suffix match against the host that's passed in.
-  // (e.g. foo-bar.baz.com should match *-bar.baz.com before matching *.baz.com)
-  // This is done by scanning the length => wildcards map looking for every
-  // wildcard whose size is < length.
-  for (const auto& iter : wildcard_virtual_host_suffixes_) {
-    const uint32_t wildcard_length = iter.first;
-    const auto& wildcard_map = iter.second;
-    // >= because *.foo.com shouldn't match .foo.com.
-    if (wildcard_length >= host.size()) {
-      continue;
+RouteMatcher::RouteMatcher(const envoy::api::v2::RouteConfiguration& route_config,
+                           GlobalHeaderParsersConstSharedPtr global_header_parsers,
+                           Runtime::Loader& runtime, Upstream::ClusterManager& cm,
+                           bool validate_clusters, const RouteMatcher* previous) {
+  for (const auto& virtual_host_config : route_config.virtual_hosts()) {
+    const uint64_t hash = MessageUtil::hash(virtual_host_config);
+    VirtualHostSharedPtr virtual_host;
+    if (previous != nullptr) {
+      auto previous_virtual_host = previous->virtual_hosts_by_hash_.find(hash);
+      if (previous_virtual_host != previous->virtual_hosts_by_hash_.end()) {
+        virtual_host = previous_virtual_host->second;
+        // The clusters may have changed since the virtual host was built.
+        if (validate_clusters) {
+          virtual_host->validateClusters(cm);
+        }
+      }
     }
-    const auto& match = wildcard_map.find(host.substr(host.size() - wildcard_length));
-    if (match != wildcard_map.end()) {
-      return match->second.get();
+    if (!virtual_host) {
+      virtual_host.reset(new VirtualHostImpl(virtual_host_config, global_header_parsers, runtime,
+                                             cm, validate_clusters));
     }
-  }
-  return nullptr;
-}
+    virtual_hosts_by_hash_.emplace(hash, virtual_host);
+    const uint32_t ordinal = virtual_hosts_.size();
+    virtual_hosts_.push_back(virtual_host);
 
-RouteMatcher::RouteMatcher(const envoy::api::v2::RouteConfiguration& route_config,
-                           const ConfigImpl& global_route_config, Runtime::Loader& runtime,
-                           Upstream::ClusterManager& cm, bool validate_clusters) {
-  for (const auto& virtual_host_config : route_config.virtual_hosts()) {
-    VirtualHostSharedPtr virtual_host(new VirtualHostImpl(virtual_host_config, global_route_config,
-                                                          runtime, cm, validate_clusters));
     for (const std::string& domain : virtual_host_config.domains()) {
       if ("*" == domain) {
         if (default_virtual_host_) {
@@ -695,14 +898,11 @@ RouteMatcher::RouteMatcher(const envoy::api::v2::RouteConfiguration& route_confi
         }
         default_virtual_host_ = virtual_host;
       } else if (domain.size() > 0 && '*' == domain[0]) {
-        wildcard_virtual_host_suffixes_[domain.size() - 1].emplace(domain.substr(1), virtual_host);
-      } else {
-        if (virtual_hosts_.find(domain) != virtual_hosts_.end()) {
-          throw EnvoyException(fmt::format(
-              "Only unique values for domains are permitted. Duplicate entry of domain {}",
-              domain));
-        }
-        virtual_hosts_.emplace(domain, virtual_host);
+        // e.g. foo-bar.baz.com matches *-bar.baz.com before *.baz.com.
+        domain_index_.addWildcardSuffix(domain.substr(1), ordinal);
+      } else if (!domain_index_.addDomain(domain, ordinal)) {
+        throw EnvoyException(fmt::format(
+            "Only unique values for domains are permitted. Duplicate entry of domain {}", domain));
       }
     }
   }
@@ -718,37 +918,59 @@ RouteConstSharedPtr VirtualHostImpl::getRouteFromEntries(const Http::HeaderMap&
     return SSL_REDIRECT_ROUTE;
   }
 
-  // Check for a route that matches the request.
-  for (const RouteEntryImplBaseConstSharedPtr& route : routes_) {
-    RouteConstSharedPtr route_entry = route->matches(headers, random_value);
+  // Find the first indexed route that matches the path. Any unindexed route configured before it
+  // takes precedence if it matches, so those are checked in order first.
+  uint32_t indexed_ordinal = RouteIndex::NO_MATCH;
+  if (!path_index_.empty()) {
+    const Http::HeaderString& path = headers.Path()->value();
+    const char* query_string_start = Http::Utility::findQueryStringStart(path);
+    const size_t path_length =
+        query_string_start != nullptr ? query_string_start - path.c_str() : path.size();
+    indexed_ordinal = path_index_.find(path.c_str(), path.size(), path_length);
+  }
+
+  for (const uint32_t ordinal : unindexed_routes_) {
+    if (ordinal > indexed_ordinal) {
+      break;
+    }
+    RouteConstSharedPtr route_entry = routes_[ordinal]->matches(headers, random_value);
     if (nullptr != route_entry) {
       return route_entry;
     }
   }
 
+  if (indexed_ordinal != RouteIndex::NO_MATCH) {
+    RouteConstSharedPtr route_entry = routes_[indexed_ordinal]->matches(headers, random_value);
+    ASSERT(route_entry != nullptr);
+    return route_entry;
+  }
+
   return nullptr;
 }
 
 const VirtualHostImpl* RouteMatcher::findVirtualHost(const Http::HeaderMap& headers) const {
   // Fast path the case where we only have a default virtual host.
-  if (virtual_hosts_.empty() && default_virtual_host_) {
+  if (domain_index_.empty()) {
     return default_virtual_host_.get();
   }
 
   // TODO (@rshriram) Match Origin header in WebSocket
   // request with VHost, using wildcard match
-  const char* host = headers.Host()->value().c_str();
-  const auto& iter = virtual_hosts_.find(host);
-  if (iter != virtual_hosts_.end()) {
-    return iter->second.get();
+  const Http::HeaderString& host = headers.Host()->value();
+  const uint32_t ordinal = domain_index_.find(host.c_str(), host.size());
+  if (ordinal != DomainIndex::NO_MATCH) {
+    return virtual_hosts_[ordinal].get();
   }
-  if (!wildcard_virtual_host_suffixes_.empty()) {
-    const VirtualHostImpl* vhost = findWildcardVirtualHost(host);
-    if (vhost != nullptr) {
-      return vhost;
+  return default_virtual_host_.get();
+}
+
+bool RouteMatcher::addRouteKeyHeaders(std::vector<Http::LowerCaseString>& headers) const {
+  for (const VirtualHostSharedPtr& virtual_host : virtual_hosts_) {
+    if (!virtual_host->addRouteKeyHeaders(headers)) {
+      return false;
     }
   }
-  return default_virtual_host_.get();
+  return true;
 }
 
 RouteConstSharedPtr RouteMatcher::route(const Http::HeaderMap& headers,
@@ -772,7 +994,9 @@ VirtualHostImpl::virtualClusterFromEntries(const Http::HeaderMap& headers) const
     bool method_matches =
         !entry.method_.valid() || headers.Method()->value().c_str() == entry.method_.value();
 
-    if (method_matches && std::regex_match(headers.Path()->value().c_str(), entry.pattern_)) {
+    const char* path = headers.Path()->value().c_str();
+    if (method_matches && StringUtil::startsWith(path, entry.pattern_prefix_) &&
+        std::regex_match(path, entry.pattern_)) {
       return &entry;
     }
   }
@@ -785,18 +1009,52 @@ VirtualHostImpl::virtualClusterFromEntries(const Http::HeaderMap& headers) const
 }
 
 ConfigImpl::ConfigImpl(const envoy::api::v2::RouteConfiguration& config, Runtime::Loader& runtime,
-                       Upstream::ClusterManager& cm, bool validate_clusters_default) {
+                       Upstream::ClusterManager& cm, bool validate_clusters_default,
+                       const ConfigImpl* previous_config)
+    : header_parsers_hash_(headerParsersHash(config)) {
+  // Virtual hosts can only be reused if the headers they add for the whole configuration haven't
+  // changed either.
+  const RouteMatcher* previous_route_matcher = nullptr;
+  if (previous_config != nullptr && previous_config->header_parsers_hash_ == header_parsers_hash_) {
+    header_parsers_ = previous_config->header_parsers_;
+    previous_route_matcher = previous_config->route_matcher_.get();
+  } else {
+    std::shared_ptr<GlobalHeaderParsers> header_parsers(new GlobalHeaderParsers());
+    header_parsers->request_headers_parser_ =
+        HeaderParser::configure(config.request_headers_to_add());
+    header_parsers->response_headers_parser_ = HeaderParser::configure(
+        config.response_headers_to_add(), config.response_headers_to_remove());
+    header_parsers_ = header_parsers;
+  }
+
   route_matcher_.reset(new RouteMatcher(
-      config, *this, runtime, cm,
-      PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, validate_clusters, validate_clusters_default)));
+      config, header_parsers_, runtime, cm,
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, validate_clusters, validate_clusters_default),
+      previous_route_matcher));
 
   for (const std::string& header : config.internal_only_headers()) {
     internal_only_headers_.push_back(Http::LowerCaseString(header));
   }
 
-  request_headers_parser_ = HeaderParser::configure(config.request_headers_to_add());
-  response_headers_parser_ = HeaderParser::configure(config.response_headers_to_add(),
-                                                     config.response_headers_to_remove());
+  std::vector<Http::LowerCaseString> route_key_headers;
+  if (route_matcher_->addRouteKeyHeaders(route_key_headers)) {
+    std::sort(route_key_headers.begin(), route_key_headers.end(),
+              [](const Http::LowerCaseString& lhs, const Http::LowerCaseString& rhs) {
+                return lhs.get() < rhs.get();
+              });
+    route_key_headers.erase(std::unique(route_key_headers.begin(), route_key_headers.end()),
+                            route_key_headers.end());
+    route_key_headers_.value(std::move(route_key_headers));
+  }
+}
+
+uint64_t ConfigImpl::headerParsersHash(const envoy::api::v2::RouteConfiguration& config) {
+  envoy::api::v2::RouteConfiguration headers_config;
+  headers_config.mutable_request_headers_to_add()->CopyFrom(config.request_headers_to_add());
+  headers_config.mutable_response_headers_to_add()->CopyFrom(config.response_headers_to_add());
+  headers_config.mutable_response_headers_to_remove()->CopyFrom(
+      config.response_headers_to_remove());
+  return MessageUtil::hash(headers_config);
 }
 
 } // namespace Router
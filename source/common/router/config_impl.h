@@ -5,9 +5,11 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <regex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "envoy/common/optional.h"
@@ -15,9 +17,12 @@
 #include "envoy/runtime/runtime.h"
 #include "envoy/upstream/cluster_manager.h"
 
+#include "common/http/header_map_impl.h"
 #include "common/router/config_utility.h"
+#include "common/router/domain_index.h"
 #include "common/router/header_formatter.h"
 #include "common/router/header_parser.h"
+#include "common/router/route_index.h"
 #include "common/router/router_ratelimit.h"
 
 #include "api/rds.pb.h"
@@ -72,7 +77,13 @@ private:
  */
 class CorsPolicyImpl : public CorsPolicy {
 public:
-  CorsPolicyImpl(const envoy::api::v2::CorsPolicy& config);
+  /**
+   * @param config supplies the policy of a route or virtual host.
+   * @param fallback supplies the policy of the virtual host of a route, which sets whatever the
+   *        route policy leaves unset, or nullptr if there is none. The merged policy and its
+   *        preflight response are so computed once, at config load.
+   */
+  CorsPolicyImpl(const envoy::api::v2::CorsPolicy& config, const CorsPolicy* fallback);
 
   // Router::CorsPolicy
   const std::list<std::string>& allowOrigins() const override { return allow_origin_; };
@@ -82,31 +93,63 @@ public:
   const std::string& maxAge() const override { return max_age_; };
   const Optional<bool>& allowCredentials() const override { return allow_credentials_; };
   bool enabled() const override { return enabled_; };
+  bool allowsOrigin(const Http::HeaderString& origin) const override;
+  const Http::HeaderMap& preflightHeaders() const override { return preflight_headers_; }
 
 private:
   std::list<std::string> allow_origin_;
+  // allow_origin_ without the wildcard, for lookups.
+  std::unordered_set<std::string> allow_origin_set_;
+  bool allow_any_origin_{};
   std::string allow_methods_;
   std::string allow_headers_;
   std::string expose_headers_;
   std::string max_age_{};
   Optional<bool> allow_credentials_{};
   bool enabled_;
+  Http::HeaderMapImpl preflight_headers_;
 };
 
-class ConfigImpl;
+/**
+ * The header parsers of a route configuration, which apply to the routes of all of its virtual
+ * hosts. They are shared with the virtual hosts rather than owned by ConfigImpl, since a virtual
+ * host may be reused by the configurations which replace the one it was built for.
+ */
+struct GlobalHeaderParsers {
+  HeaderParserPtr request_headers_parser_;
+  HeaderParserPtr response_headers_parser_;
+};
+
+typedef std::shared_ptr<const GlobalHeaderParsers> GlobalHeaderParsersConstSharedPtr;
+
 /**
  * Holds all routing configuration for an entire virtual host.
  */
 class VirtualHostImpl : public VirtualHost {
 public:
   VirtualHostImpl(const envoy::api::v2::VirtualHost& virtual_host,
-                  const ConfigImpl& global_route_config, Runtime::Loader& runtime,
+                  GlobalHeaderParsersConstSharedPtr global_header_parsers, Runtime::Loader& runtime,
                   Upstream::ClusterManager& cm, bool validate_clusters);
 
   RouteConstSharedPtr getRouteFromEntries(const Http::HeaderMap& headers,
                                           uint64_t random_value) const;
   const VirtualCluster* virtualClusterFromEntries(const Http::HeaderMap& headers) const;
-  const ConfigImpl& globalRouteConfig() const { return global_route_config_; }
+  const GlobalHeaderParsers& globalHeaderParsers() const { return *global_header_parsers_; }
+
+  /**
+   * Check that the clusters of all routes, including their shadow clusters, exist.
+   * @param cm supplies the cluster manager to look up the clusters in.
+   * @throw EnvoyException if a cluster doesn't exist.
+   */
+  void validateClusters(Upstream::ClusterManager& cm) const;
+
+  /**
+   * Add the request headers which the routes of the virtual host depend on, besides the path.
+   * @param headers supplies the headers to add to.
+   * @return bool false if the routes also depend on runtime values or on the random value.
+   */
+  bool addRouteKeyHeaders(std::vector<Http::LowerCaseString>& headers) const;
+
   const HeaderParser& requestHeaderParser() const { return *request_headers_parser_; };
   const HeaderParser& responseHeaderParser() const { return *response_headers_parser_; };
 
@@ -125,6 +168,8 @@ private:
     const std::string& name() const override { return name_; }
 
     std::regex pattern_;
+    // Paths which don't start with this literal text can't match pattern_.
+    std::string pattern_prefix_;
     Optional<std::string> method_;
     std::string name_;
   };
@@ -141,12 +186,16 @@ private:
 
   const std::string name_;
   std::vector<RouteEntryImplBaseConstSharedPtr> routes_;
+  // Prefix and exact path routes that match on the path alone are looked up via path_index_. The
+  // ordinals (into routes_) of all other routes are kept in configuration order in
+  // unindexed_routes_ and are scanned linearly. See getRouteFromEntries().
+  RouteIndex path_index_;
+  std::vector<uint32_t> unindexed_routes_;
   std::vector<VirtualClusterEntry> virtual_clusters_;
   SslRequirements ssl_requirements_;
   const RateLimitPolicyImpl rate_limit_policy_;
   std::unique_ptr<const CorsPolicyImpl> cors_policy_;
-  const ConfigImpl& global_route_config_; // See note in RouteEntryImplBase::clusterEntry() on why
-                                          // raw ref to the top level config is currently safe.
+  const GlobalHeaderParsersConstSharedPtr global_header_parsers_;
   HeaderParserPtr request_headers_parser_;
   HeaderParserPtr response_headers_parser_;
 };
@@ -234,7 +283,8 @@ typedef std::unique_ptr<const MetadataMatchCriteriaImpl> MetadataMatchCriteriaIm
 class MetadataMatchCriteriaImpl : public MetadataMatchCriteria {
 public:
   MetadataMatchCriteriaImpl(const ProtobufWkt::Struct& metadata_matches)
-      : metadata_match_criteria_(extractMetadataMatchCriteria(nullptr, metadata_matches)){};
+      : metadata_match_criteria_(extractMetadataMatchCriteria(nullptr, metadata_matches)),
+        hash_(hashMetadataMatchCriteria(metadata_match_criteria_)){};
 
   /**
    * Creates a new MetadataMatchCriteriaImpl, merging existing
@@ -252,16 +302,20 @@ public:
   const std::vector<MetadataMatchCriterionConstSharedPtr>& metadataMatchCriteria() const override {
     return metadata_match_criteria_;
   }
+  std::size_t hash() const override { return hash_; }
 
 private:
   MetadataMatchCriteriaImpl(const std::vector<MetadataMatchCriterionConstSharedPtr>& criteria)
-      : metadata_match_criteria_(criteria){};
+      : metadata_match_criteria_(criteria), hash_(hashMetadataMatchCriteria(criteria)){};
 
   static std::vector<MetadataMatchCriterionConstSharedPtr>
   extractMetadataMatchCriteria(const MetadataMatchCriteriaImpl* parent,
                                const ProtobufWkt::Struct& metadata_matches);
+  static std::size_t
+  hashMetadataMatchCriteria(const std::vector<MetadataMatchCriterionConstSharedPtr>& criteria);
 
   const std::vector<MetadataMatchCriterionConstSharedPtr> metadata_match_criteria_;
+  const std::size_t hash_;
 };
 
 /**
@@ -296,10 +350,31 @@ public:
   bool isRedirect() const { return !host_redirect_.empty() || !path_redirect_.empty(); }
 
   bool matchRoute(const Http::HeaderMap& headers, uint64_t random_value) const;
+  /**
+   * @return bool whether the route matches on the request path alone, i.e. there are no header or
+   *         runtime constraints and matching is case sensitive. Such prefix and exact path routes
+   *         can be placed in a RouteIndex.
+   */
+  bool matchesOnPathOnly() const {
+    return case_sensitive_ && !runtime_.valid() && config_headers_.empty();
+  }
   void validateClusters(Upstream::ClusterManager& cm) const;
 
+  /**
+   * Add the request headers which the route depends on, besides the path.
+   * @param headers supplies the headers to add to.
+   * @return bool false if the route also depends on runtime values or on the random value.
+   */
+  bool addRouteKeyHeaders(std::vector<Http::LowerCaseString>& headers) const;
+  /**
+   * Resolve the handles of the cluster and weighted clusters of the route, so that requests find
+   * them by index. This must be called on the main thread.
+   */
+  void resolveClusterHandles(Upstream::ClusterManager& cm);
+
   // Router::RouteEntry
   const std::string& clusterName() const override;
+  Optional<uint32_t> clusterHandle() const override { return cluster_handle_; }
   Http::Code clusterNotFoundResponseCode() const override {
     return cluster_not_found_response_code_;
   }
@@ -362,6 +437,7 @@ private:
 
     // Router::RouteEntry
     const std::string& clusterName() const override { return cluster_name_; }
+    Optional<uint32_t> clusterHandle() const override { return cluster_handle_; }
     Http::Code clusterNotFoundResponseCode() const override {
       return parent_->clusterNotFoundResponseCode();
     }
@@ -406,6 +482,11 @@ private:
     const RouteEntry* routeEntry() const override { return this; }
     const Decorator* decorator() const override { return nullptr; }
 
+  protected:
+    // Only set for weighted clusters, as the names of cluster_header clusters aren't known until
+    // the request.
+    Optional<uint32_t> cluster_handle_;
+
   private:
     const RouteEntryImplBase* parent_;
     const std::string cluster_name_;
@@ -430,6 +511,10 @@ private:
       return loader_.snapshot().getInteger(runtime_key_, cluster_weight_);
     }
 
+    void resolveClusterHandle(Upstream::ClusterManager& cm) {
+      cluster_handle_.value(cm.clusterHandle(clusterName()));
+    }
+
     const MetadataMatchCriteria* metadataMatchCriteria() const override {
       if (cluster_metadata_match_criteria_) {
         return cluster_metadata_match_criteria_.get();
@@ -448,6 +533,49 @@ private:
 
   typedef std::shared_ptr<WeightedClusterEntry> WeightedClusterEntrySharedPtr;
 
+  /**
+   * Vose alias table over the weights of the weighted clusters, which selects a cluster in
+   * constant time however many clusters there are. Each of the n columns of the table holds its
+   * own cluster up to a threshold and an alias cluster above it, so that all columns have the
+   * same total weight.
+   */
+  class ClusterAliasTable {
+  public:
+    /**
+     * @param weights supplies the weight of each cluster. If all of the weights are 0, the
+     *        clusters are selected uniformly.
+     */
+    ClusterAliasTable(const std::vector<uint64_t>& weights);
+
+    /**
+     * @param random_value supplies the random value to select a cluster with.
+     * @return size_t the index of the selected cluster. Each cluster is selected by a share of
+     *         the range [0, n * total weight) of random values proportional to its weight.
+     */
+    size_t select(uint64_t random_value) const;
+
+  private:
+    uint64_t total_weight_{};
+    // The column of index i selects cluster i if the weight drawn from it is below thresholds_[i],
+    // and cluster aliases_[i] otherwise. Thresholds are on the scale of the total weight.
+    std::vector<uint64_t> thresholds_;
+    std::vector<size_t> aliases_;
+  };
+
+  typedef std::shared_ptr<const ClusterAliasTable> ClusterAliasTableConstSharedPtr;
+
+  /**
+   * @param random_value supplies the random value to select a weighted cluster with.
+   * @return size_t the index in weighted_clusters_ of the selected cluster.
+   */
+  size_t selectWeightedCluster(uint64_t random_value) const;
+
+  /**
+   * @return ClusterAliasTableConstSharedPtr a table of the weights of the weighted clusters in the
+   *         current runtime snapshot.
+   */
+  ClusterAliasTableConstSharedPtr buildRuntimeWeightedClusterTable() const;
+
   static Optional<RuntimeData> loadRuntimeData(const envoy::api::v2::RouteMatch& route);
 
   static std::multimap<std::string, std::string>
@@ -464,6 +592,7 @@ private:
   const bool auto_host_rewrite_;
   const bool use_websocket_;
   const std::string cluster_name_;
+  Optional<uint32_t> cluster_handle_;
   const Http::LowerCaseString cluster_header_name_;
   const Http::Code cluster_not_found_response_code_;
   const std::chrono::milliseconds timeout_;
@@ -477,6 +606,15 @@ private:
   const Upstream::ResourcePriority priority_;
   std::vector<ConfigUtility::HeaderData> config_headers_;
   std::vector<WeightedClusterEntrySharedPtr> weighted_clusters_;
+  // Selects from weighted_clusters_ by their configured weights.
+  std::unique_ptr<const ClusterAliasTable> weighted_cluster_table_;
+  // If the weights are overridden by runtime, weighted_cluster_table_ is unused and the clusters
+  // are selected from a table of the runtime weights, which is rebuilt by the first request that
+  // sees a newer runtime snapshot than the one it was built from.
+  bool runtime_weights_{};
+  mutable std::mutex runtime_weighted_cluster_table_lock_;
+  mutable ClusterAliasTableConstSharedPtr runtime_weighted_cluster_table_;
+  mutable uint64_t runtime_weighted_cluster_table_version_{};
   std::unique_ptr<const HashPolicyImpl> hash_policy_;
   MetadataMatchCriteriaImplConstPtr metadata_match_criteria_;
   HeaderParserPtr request_headers_parser_;
@@ -544,6 +682,8 @@ public:
 
 private:
   const std::regex regex_;
+  // Paths which don't start with this literal text can't match regex_.
+  const std::string regex_prefix_;
 };
 
 /**
@@ -552,29 +692,33 @@ private:
  */
 class RouteMatcher {
 public:
+  /**
+   * @param previous supplies the route matcher being replaced, if any. Its virtual hosts which
+   *        are configured identically, and were built with the same global_header_parsers, are
+   *        reused rather than built again.
+   */
   RouteMatcher(const envoy::api::v2::RouteConfiguration& config,
-               const ConfigImpl& global_http_config, Runtime::Loader& runtime,
-               Upstream::ClusterManager& cm, bool validate_clusters);
+               GlobalHeaderParsersConstSharedPtr global_header_parsers, Runtime::Loader& runtime,
+               Upstream::ClusterManager& cm, bool validate_clusters,
+               const RouteMatcher* previous);
 
   RouteConstSharedPtr route(const Http::HeaderMap& headers, uint64_t random_value) const;
 
+  /**
+   * @see VirtualHostImpl::addRouteKeyHeaders().
+   */
+  bool addRouteKeyHeaders(std::vector<Http::LowerCaseString>& headers) const;
+
 private:
   const VirtualHostImpl* findVirtualHost(const Http::HeaderMap& headers) const;
-  const VirtualHostImpl* findWildcardVirtualHost(const std::string& host) const;
-
-  std::unordered_map<std::string, VirtualHostSharedPtr> virtual_hosts_;
-  // std::greater as a minor optimization to iterate from more to less specific
-  //
-  // A note on using an unordered_map versus a vector of (string, VirtualHostSharedPtr) pairs:
-  //
-  // Based on local benchmarks, each vector entry costs around 20ns for recall and (string)
-  // comparison with a fixed cost of about 25ns. For unordered_map, the empty map costs about 65ns
-  // and climbs to about 110ns once there are any entries.
-  //
-  // The break-even is 4 entries.
-  std::map<int64_t, std::unordered_map<std::string, VirtualHostSharedPtr>, std::greater<int64_t>>
-      wildcard_virtual_host_suffixes_;
+
+  // The virtual hosts in configuration order, indexed by domain_index_.
+  std::vector<VirtualHostSharedPtr> virtual_hosts_;
+  // The exact and wildcard domains of all the virtual hosts but the default one.
+  DomainIndex domain_index_;
   VirtualHostSharedPtr default_virtual_host_;
+  // All virtual hosts, keyed by the hash of their configuration.
+  std::unordered_map<uint64_t, VirtualHostSharedPtr> virtual_hosts_by_hash_;
 };
 
 /**
@@ -582,11 +726,21 @@ private:
  */
 class ConfigImpl : public Config {
 public:
+  /**
+   * @param previous_config supplies the configuration being replaced, if any. Virtual hosts which
+   *        haven't changed since it was built are shared with it, so that an update which only
+   *        touches a few virtual hosts doesn't rebuild all the others.
+   */
   ConfigImpl(const envoy::api::v2::RouteConfiguration& config, Runtime::Loader& runtime,
-             Upstream::ClusterManager& cm, bool validate_clusters_default);
+             Upstream::ClusterManager& cm, bool validate_clusters_default,
+             const ConfigImpl* previous_config = nullptr);
 
-  const HeaderParser& requestHeaderParser() const { return *request_headers_parser_; };
-  const HeaderParser& responseHeaderParser() const { return *response_headers_parser_; };
+  const HeaderParser& requestHeaderParser() const {
+    return *header_parsers_->request_headers_parser_;
+  };
+  const HeaderParser& responseHeaderParser() const {
+    return *header_parsers_->response_headers_parser_;
+  };
 
   // Router::Config
   RouteConstSharedPtr route(const Http::HeaderMap& headers, uint64_t random_value) const override {
@@ -597,11 +751,18 @@ public:
     return internal_only_headers_;
   }
 
+  const std::vector<Http::LowerCaseString>* routeKeyHeaders() const override {
+    return route_key_headers_.valid() ? &route_key_headers_.value() : nullptr;
+  }
+
 private:
+  static uint64_t headerParsersHash(const envoy::api::v2::RouteConfiguration& config);
+
   std::unique_ptr<RouteMatcher> route_matcher_;
   std::list<Http::LowerCaseString> internal_only_headers_;
-  HeaderParserPtr request_headers_parser_;
-  HeaderParserPtr response_headers_parser_;
+  Optional<std::vector<Http::LowerCaseString>> route_key_headers_;
+  GlobalHeaderParsersConstSharedPtr header_parsers_;
+  uint64_t header_parsers_hash_;
 };
 
 /**
@@ -616,6 +777,8 @@ public:
     return internal_only_headers_;
   }
 
+  const std::vector<Http::LowerCaseString>* routeKeyHeaders() const override { return nullptr; }
+
 private:
   std::list<Http::LowerCaseString> internal_only_headers_;
 };
@@ -1,14 +1,116 @@
 #include "common/router/config_utility.h"
 
+#include <cctype>
+#include <cstring>
 #include <regex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "common/common/assert.h"
+#include "common/common/macros.h"
+#include "common/common/utility.h"
 
 namespace Envoy {
 namespace Router {
 
+namespace {
+
+typedef const Http::HeaderEntry* (Http::HeaderMap::*InlineHeaderGetter)() const;
+typedef std::unordered_map<std::string, InlineHeaderGetter> InlineHeaderGetterMap;
+
+const InlineHeaderGetterMap& inlineHeaderGetters() {
+#define INLINE_HEADER_GETTER(name) {Http::Headers::get().name.get(), &Http::HeaderMap::name},
+  CONSTRUCT_ON_FIRST_USE(InlineHeaderGetterMap, ALL_INLINE_HEADERS(INLINE_HEADER_GETTER));
+#undef INLINE_HEADER_GETTER
+}
+
+/**
+ * Unescape a regex which only matches a literal string.
+ * @param pattern supplies the regex.
+ * @param literal supplies the string to set to the literal.
+ * @return bool whether the regex only matches a literal string.
+ */
+bool regexLiteral(const std::string& pattern, std::string& literal) {
+  static const std::string special_chars = "^$\\.*+?()[]{}|";
+  literal.clear();
+  for (size_t i = 0; i < pattern.size(); i++) {
+    if (pattern[i] == '\\') {
+      // Only escaped punctuation is a literal, while escapes such as \d are character classes.
+      if (++i == pattern.size() || isalnum(pattern[i])) {
+        return false;
+      }
+    } else if (special_chars.find(pattern[i]) != std::string::npos) {
+      return false;
+    }
+    literal.push_back(pattern[i]);
+  }
+  return true;
+}
+
+bool endsWith(const Http::HeaderString& value, const std::string& suffix) {
+  return value.size() >= suffix.size() &&
+         0 == memcmp(value.c_str() + value.size() - suffix.size(), suffix.data(), suffix.size());
+}
+
+} // namespace
+
+ConfigUtility::HeaderData::HeaderData(const envoy::api::v2::HeaderMatcher& config)
+    : name_(config.name()), inline_header_(nullptr), value_(config.value()) {
+  const auto getter = inlineHeaderGetters().find(name_.get());
+  if (getter != inlineHeaderGetters().end()) {
+    inline_header_ = getter->second;
+  }
+
+  // Header values have no line terminators, so ".*" matches any of them.
+  const std::string pattern = value_;
+  std::string literal;
+  if (value_.empty()) {
+    match_type_ = MatchType::Present;
+  } else if (!PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, regex, false)) {
+    match_type_ = MatchType::Exact;
+  } else if (regexLiteral(pattern, literal)) {
+    match_type_ = MatchType::Exact;
+    value_ = literal;
+  } else if (StringUtil::endsWith(pattern, ".*") &&
+             regexLiteral(pattern.substr(0, pattern.size() - 2), literal)) {
+    match_type_ = MatchType::Prefix;
+    value_ = literal;
+  } else if (StringUtil::startsWith(pattern.c_str(), ".*") &&
+             regexLiteral(pattern.substr(2), literal)) {
+    match_type_ = MatchType::Suffix;
+    value_ = literal;
+  } else {
+    match_type_ = MatchType::Regex;
+    value_ = RegexUtil::literalPrefix(pattern);
+    regex_pattern_ = std::regex(pattern, std::regex::optimize);
+  }
+}
+
+bool ConfigUtility::HeaderData::matches(const Http::HeaderMap& request_headers) const {
+  const Http::HeaderEntry* header =
+      inline_header_ != nullptr ? (request_headers.*inline_header_)() : request_headers.get(name_);
+  if (header == nullptr) {
+    return false;
+  }
+
+  const Http::HeaderString& value = header->value();
+  switch (match_type_) {
+  case MatchType::Present:
+    return true;
+  case MatchType::Exact:
+    return value == value_.c_str();
+  case MatchType::Prefix:
+    return StringUtil::startsWith(value.c_str(), value_);
+  case MatchType::Suffix:
+    return endsWith(value, value_);
+  case MatchType::Regex:
+    return StringUtil::startsWith(value.c_str(), value_) &&
+           std::regex_match(value.c_str(), regex_pattern_);
+  }
+  NOT_REACHED;
+}
+
 Upstream::ResourcePriority
 ConfigUtility::parsePriority(const envoy::api::v2::RoutingPriority& priority) {
   switch (priority) {
@@ -23,26 +125,12 @@ ConfigUtility::parsePriority(const envoy::api::v2::RoutingPriority& priority) {
 
 bool ConfigUtility::matchHeaders(const Http::HeaderMap& request_headers,
                                  const std::vector<HeaderData>& config_headers) {
-  bool matches = true;
-
-  if (!config_headers.empty()) {
-    for (const HeaderData& cfg_header_data : config_headers) {
-      const Http::HeaderEntry* header = request_headers.get(cfg_header_data.name_);
-      if (cfg_header_data.value_.empty()) {
-        matches &= (header != nullptr);
-      } else if (!cfg_header_data.is_regex_) {
-        matches &= (header != nullptr) && (header->value() == cfg_header_data.value_.c_str());
-      } else {
-        matches &= (header != nullptr) &&
-                   std::regex_match(header->value().c_str(), cfg_header_data.regex_pattern_);
-      }
-      if (!matches) {
-        break;
-      }
+  for (const HeaderData& cfg_header_data : config_headers) {
+    if (!cfg_header_data.matches(request_headers)) {
+      return false;
     }
   }
-
-  return matches;
+  return true;
 }
 
 Http::Code ConfigUtility::parseRedirectResponseCode(
@@ -23,14 +23,17 @@ namespace Router {
  */
 class ConfigUtility {
 public:
+  /**
+   * Header matcher compiled at configuration load. Regexes which only match a literal value, or
+   * values starting or ending with one, are compared without running the regex.
+   */
   struct HeaderData {
+    enum class MatchType { Present, Exact, Prefix, Suffix, Regex };
+
     // An empty header value allows for matching to be only based on header presence.
     // Regex is an opt-in. Unless explicitly mentioned, the header values will be used for
     // exact string matching.
-    HeaderData(const envoy::api::v2::HeaderMatcher& config)
-        : name_(config.name()), value_(config.value()),
-          regex_pattern_(value_, std::regex::optimize),
-          is_regex_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, regex, false)) {}
+    HeaderData(const envoy::api::v2::HeaderMatcher& config);
     HeaderData(const Json::Object& config)
         : HeaderData([&config] {
             envoy::api::v2::HeaderMatcher header_matcher;
@@ -38,10 +41,21 @@ public:
             return header_matcher;
           }()) {}
 
+    /**
+     * @param request_headers supplies the request headers.
+     * @return bool whether the header is present in the request headers with a matching value.
+     */
+    bool matches(const Http::HeaderMap& request_headers) const;
+
     const Http::LowerCaseString name_;
-    const std::string value_;
-    const std::regex regex_pattern_;
-    const bool is_regex_;
+    // The accessor of the header if it is an inline header, which is found without scanning the
+    // request headers.
+    const Http::HeaderEntry* (Http::HeaderMap::*inline_header_)() const;
+    MatchType match_type_;
+    // The value compared with the header, or the literal prefix of the regex, which rules out most
+    // values before the regex is run.
+    std::string value_;
+    std::regex regex_pattern_;
   };
 
   /**
@@ -0,0 +1,106 @@
+#include "common/router/domain_index.h"
+
+#include <algorithm>
+
+namespace Envoy {
+namespace Router {
+
+const uint32_t DomainIndex::NO_MATCH;
+
+bool DomainIndex::addDomain(const std::string& domain, uint32_t ordinal) {
+  Node& node = insert(domain);
+  if (node.domain_ordinal_ != NO_MATCH) {
+    return false;
+  }
+  node.domain_ordinal_ = ordinal;
+  size_++;
+  return true;
+}
+
+void DomainIndex::addWildcardSuffix(const std::string& suffix, uint32_t ordinal) {
+  Node& node = insert(suffix);
+  if (node.wildcard_ordinal_ == NO_MATCH) {
+    node.wildcard_ordinal_ = ordinal;
+  }
+  size_++;
+}
+
+DomainIndex::Node& DomainIndex::insert(const std::string& domain) {
+  const std::string key(domain.rbegin(), domain.rend());
+  Node* node = root_.get();
+  size_t position = 0;
+  while (position < key.size()) {
+    auto it = std::lower_bound(node->children_.begin(), node->children_.end(), key[position],
+                               [](const NodePtr& child, char ch) { return child->label_[0] < ch; });
+    if (it == node->children_.end() || (*it)->label_[0] != key[position]) {
+      // No child shares a first character with the remainder of the key, add a new leaf.
+      NodePtr leaf(new Node());
+      leaf->label_ = key.substr(position);
+      Node& ret = *leaf;
+      node->children_.insert(it, std::move(leaf));
+      return ret;
+    }
+
+    Node& child = **it;
+    size_t common = 0;
+    while (common < child.label_.size() && position + common < key.size() &&
+           child.label_[common] == key[position + common]) {
+      common++;
+    }
+
+    if (common < child.label_.size()) {
+      // The key diverges in the middle of the child's label (or ends there). Split the child so
+      // that there is a node boundary at the divergence point.
+      NodePtr split(new Node());
+      split->label_ = child.label_.substr(0, common);
+      NodePtr old_child = std::move(*it);
+      old_child->label_ = old_child->label_.substr(common);
+      split->children_.push_back(std::move(old_child));
+      *it = std::move(split);
+    }
+
+    node = it->get();
+    position += common;
+  }
+
+  return *node;
+}
+
+const DomainIndex::Node* DomainIndex::findChild(const Node& node, char c) {
+  auto it = std::lower_bound(node.children_.begin(), node.children_.end(), c,
+                             [](const NodePtr& child, char ch) { return child->label_[0] < ch; });
+  if (it == node.children_.end() || (*it)->label_[0] != c) {
+    return nullptr;
+  }
+  return it->get();
+}
+
+uint32_t DomainIndex::find(const char* host, size_t length) const {
+  const Node* node = root_.get();
+  uint32_t best = NO_MATCH;
+  // The number of characters matched from the end of the host.
+  size_t position = 0;
+
+  while (position < length) {
+    // A wildcard only matches a longer host, e.g. "*.foo.com" does not match ".foo.com".
+    if (node->wildcard_ordinal_ != NO_MATCH) {
+      best = node->wildcard_ordinal_;
+    }
+
+    node = findChild(*node, host[length - 1 - position]);
+    if (node == nullptr || node->label_.size() > length - position) {
+      return best;
+    }
+    for (size_t i = 1; i < node->label_.size(); i++) {
+      if (node->label_[i] != host[length - 1 - position - i]) {
+        return best;
+      }
+    }
+    position += node->label_.size();
+  }
+
+  return node->domain_ordinal_ != NO_MATCH ? node->domain_ordinal_ : best;
+}
+
+} // namespace Router
+} // namespace Envoy
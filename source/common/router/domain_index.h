@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Envoy {
+namespace Router {
+
+/**
+ * Compressed trie (radix tree) over reversed virtual host domains. Each key is either an exact
+ * domain, or the suffix of a wildcard domain (e.g. ".foo.com" for "*.foo.com"), which matches any
+ * longer host ending with it. A lookup walks the host from its end once, so that it finds the exact
+ * domain or else the longest wildcard suffix without allocating, in time proportional to the length
+ * of the host rather than to the number of domains.
+ */
+class DomainIndex {
+public:
+  DomainIndex() : root_(new Node()) {}
+
+  /**
+   * Add an exact domain.
+   * @param domain supplies the domain to match.
+   * @param ordinal supplies the ordinal of the virtual host the domain belongs to.
+   * @return bool false if the domain was already added, in which case it is left unchanged.
+   */
+  bool addDomain(const std::string& domain, uint32_t ordinal);
+
+  /**
+   * Add a wildcard suffix. If the suffix was already added, the first ordinal is kept.
+   * @param suffix supplies the suffix to match, without the leading '*' of the wildcard.
+   * @param ordinal supplies the ordinal of the virtual host the suffix belongs to.
+   */
+  void addWildcardSuffix(const std::string& suffix, uint32_t ordinal);
+
+  /**
+   * Find the virtual host of a host, exact domains taking precedence over wildcard suffixes and
+   * longer suffixes over shorter ones.
+   * @param host supplies the host.
+   * @param length supplies the length of host.
+   * @return uint32_t the matching ordinal or NO_MATCH.
+   */
+  uint32_t find(const char* host, size_t length) const;
+
+  /**
+   * @return bool whether any keys have been added.
+   */
+  bool empty() const { return size_ == 0; }
+
+  static const uint32_t NO_MATCH = std::numeric_limits<uint32_t>::max();
+
+private:
+  struct Node;
+  typedef std::unique_ptr<Node> NodePtr;
+
+  struct Node {
+    // The reversed portion of the key leading from the parent to this node.
+    std::string label_;
+    uint32_t domain_ordinal_{NO_MATCH};
+    uint32_t wildcard_ordinal_{NO_MATCH};
+    // Children are kept sorted by the first character of their label. No two children share a
+    // first character.
+    std::vector<NodePtr> children_;
+  };
+
+  Node& insert(const std::string& key);
+  static const Node* findChild(const Node& node, char c);
+
+  NodePtr root_;
+  uint64_t size_{};
+};
+
+} // namespace Router
+} // namespace Envoy
@@ -12,11 +12,13 @@ namespace Router {
 RequestInfoHeaderFormatter::RequestInfoHeaderFormatter(const std::string& field_name, bool append)
     : append_(append) {
   if (field_name == "PROTOCOL") {
-    field_extractor_ = [](const Envoy::AccessLog::RequestInfo& request_info) {
+    field_extractor_ =
+        [](const Envoy::AccessLog::RequestInfo& request_info) -> const std::string& {
       return Envoy::AccessLog::AccessLogFormatUtils::protocolToString(request_info.protocol());
     };
   } else if (field_name == "CLIENT_IP") {
-    field_extractor_ = [](const Envoy::AccessLog::RequestInfo& request_info) {
+    field_extractor_ =
+        [](const Envoy::AccessLog::RequestInfo& request_info) -> const std::string& {
       return request_info.getDownstreamAddress();
     };
   } else {
@@ -24,7 +26,7 @@ RequestInfoHeaderFormatter::RequestInfoHeaderFormatter(const std::string& field_
   }
 }
 
-const std::string
+const std::string&
 RequestInfoHeaderFormatter::format(const Envoy::AccessLog::RequestInfo& request_info) const {
   return field_extractor_(request_info);
 }
@@ -16,7 +16,13 @@ class HeaderFormatter {
 public:
   virtual ~HeaderFormatter() {}
 
-  virtual const std::string format(const Envoy::AccessLog::RequestInfo& request_info) const PURE;
+  /**
+   * @param request_info supplies the request info to format the header from.
+   * @return const std::string& the header value, which is only valid as long as the formatter and
+   *         the request info. It is copied straight into the header map, so formatters return
+   *         values they already hold rather than building a string for every request.
+   */
+  virtual const std::string& format(const Envoy::AccessLog::RequestInfo& request_info) const PURE;
 
   /**
    * @return bool indicating whether the formatted header should be appended to the existing
@@ -35,11 +41,11 @@ public:
   RequestInfoHeaderFormatter(const std::string& field_name, bool append);
 
   // HeaderFormatter::format
-  const std::string format(const Envoy::AccessLog::RequestInfo& request_info) const override;
+  const std::string& format(const Envoy::AccessLog::RequestInfo& request_info) const override;
   bool append() const override { return append_; }
 
 private:
-  std::function<std::string(const Envoy::AccessLog::RequestInfo&)> field_extractor_;
+  std::function<const std::string&(const Envoy::AccessLog::RequestInfo&)> field_extractor_;
   const bool append_;
 };
 
@@ -52,7 +58,7 @@ public:
       : static_value_(static_header_value), append_(append){};
 
   // HeaderFormatter::format
-  const std::string format(const Envoy::AccessLog::RequestInfo&) const override {
+  const std::string& format(const Envoy::AccessLog::RequestInfo&) const override {
     return static_value_;
   };
   bool append() const override { return append_; }
@@ -114,7 +114,10 @@ void RdsRouteConfigProviderImpl::onConfigUpdate(const ResourceVector& resources)
   }
   const uint64_t new_hash = MessageUtil::hash(route_config);
   if (new_hash != last_config_hash_ || !initialized_) {
-    ConfigConstSharedPtr new_config(new ConfigImpl(route_config, runtime_, cm_, false));
+    // Virtual hosts which haven't changed are shared with the current configuration.
+    std::shared_ptr<const ConfigImpl> new_config(
+        new ConfigImpl(route_config, runtime_, cm_, false, current_config_.get()));
+    current_config_ = new_config;
     initialized_ = true;
     last_config_hash_ = new_hash;
     stats_.config_reload_.inc();
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -17,6 +18,7 @@
 
 #include "common/common/logger.h"
 #include "common/protobuf/utility.h"
+#include "common/router/config_impl.h"
 
 #include "api/filter/network/http_connection_manager.pb.h"
 #include "api/rds.pb.h"
@@ -140,6 +142,8 @@ private:
   RouteConfigProviderManagerImpl& route_config_provider_manager_;
   const std::string manager_identifier_;
   envoy::api::v2::RouteConfiguration route_config_proto_;
+  // The configuration most recently sent to the workers, which the next one is built from.
+  std::shared_ptr<const ConfigImpl> current_config_;
 
   friend class RouteConfigProviderManagerImpl;
 };
@@ -41,10 +41,10 @@ void RdsSubscription::createRequest(Http::Message& request) {
                                                    local_info_.nodeName()));
 }
 
-void RdsSubscription::parseResponse(const Http::Message& response) {
+void RdsSubscription::parseResponse(Http::Message& response) {
   ENVOY_LOG(debug, "rds: parsing response");
-  const std::string response_body = response.bodyAsString();
-  Json::ObjectSharedPtr response_json = Json::Factory::loadFromString(response_body);
+  const Buffer::Instance& response_body = *response.body();
+  Json::ObjectSharedPtr response_json = Json::Factory::loadFromBuffer(response_body);
   Protobuf::RepeatedPtrField<envoy::api::v2::RouteConfiguration> resources;
   Envoy::Config::RdsJson::translateRouteConfiguration(*response_json, *resources.Add());
   resources[0].set_name(route_config_name_);
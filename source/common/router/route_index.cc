@@ -0,0 +1,98 @@
+#include "common/router/route_index.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Envoy {
+namespace Router {
+
+const uint32_t RouteIndex::NO_MATCH;
+
+void RouteIndex::addPrefix(const std::string& prefix, uint32_t ordinal) {
+  Node& node = insert(prefix);
+  node.prefix_ordinal_ = std::min(node.prefix_ordinal_, ordinal);
+  size_++;
+}
+
+void RouteIndex::addPath(const std::string& path, uint32_t ordinal) {
+  Node& node = insert(path);
+  node.path_ordinal_ = std::min(node.path_ordinal_, ordinal);
+  size_++;
+}
+
+RouteIndex::Node& RouteIndex::insert(const std::string& key) {
+  Node* node = root_.get();
+  size_t position = 0;
+  while (position < key.size()) {
+    auto it = std::lower_bound(node->children_.begin(), node->children_.end(), key[position],
+                               [](const NodePtr& child, char ch) { return child->label_[0] < ch; });
+    if (it == node->children_.end() || (*it)->label_[0] != key[position]) {
+      // No child shares a first character with the remainder of the key, add a new leaf.
+      NodePtr leaf(new Node());
+      leaf->label_ = key.substr(position);
+      Node& ret = *leaf;
+      node->children_.insert(it, std::move(leaf));
+      return ret;
+    }
+
+    Node& child = **it;
+    size_t common = 0;
+    while (common < child.label_.size() && position + common < key.size() &&
+           child.label_[common] == key[position + common]) {
+      common++;
+    }
+
+    if (common < child.label_.size()) {
+      // The key diverges in the middle of the child's label (or ends there). Split the child so
+      // that there is a node boundary at the divergence point.
+      NodePtr split(new Node());
+      split->label_ = child.label_.substr(0, common);
+      NodePtr old_child = std::move(*it);
+      old_child->label_ = old_child->label_.substr(common);
+      split->children_.push_back(std::move(old_child));
+      *it = std::move(split);
+    }
+
+    node = it->get();
+    position += common;
+  }
+
+  return *node;
+}
+
+const RouteIndex::Node* RouteIndex::findChild(const Node& node, char c) {
+  auto it = std::lower_bound(node.children_.begin(), node.children_.end(), c,
+                             [](const NodePtr& child, char ch) { return child->label_[0] < ch; });
+  if (it == node.children_.end() || (*it)->label_[0] != c) {
+    return nullptr;
+  }
+  return it->get();
+}
+
+uint32_t RouteIndex::find(const char* path, size_t length, size_t path_length) const {
+  const Node* node = root_.get();
+  uint32_t best = node->prefix_ordinal_;
+  size_t position = 0;
+  if (path_length == 0) {
+    best = std::min(best, node->path_ordinal_);
+  }
+
+  while (position < length) {
+    node = findChild(*node, path[position]);
+    if (node == nullptr || node->label_.size() > length - position ||
+        0 != memcmp(node->label_.data(), path + position, node->label_.size())) {
+      break;
+    }
+
+    position += node->label_.size();
+    best = std::min(best, node->prefix_ordinal_);
+    if (position == path_length) {
+      best = std::min(best, node->path_ordinal_);
+    }
+  }
+
+  return best;
+}
+
+} // namespace Router
+} // namespace Envoy
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Envoy {
+namespace Router {
+
+/**
+ * Compressed trie (radix tree) over route path keys. Each key is either a prefix, which matches any
+ * path that starts with it, or an exact path, which matches only when the path (excluding the
+ * query string) is equal to it. Every key carries the ordinal of the route it was configured for,
+ * and a lookup returns the lowest ordinal among all matching keys. This preserves the first-match
+ * semantics of the linear route scan while only costing time proportional to the length of the
+ * path being looked up rather than to the number of routes.
+ */
+class RouteIndex {
+public:
+  RouteIndex() : root_(new Node()) {}
+
+  /**
+   * Add a prefix key.
+   * @param prefix supplies the prefix to match.
+   * @param ordinal supplies the ordinal of the route the prefix belongs to.
+   */
+  void addPrefix(const std::string& prefix, uint32_t ordinal);
+
+  /**
+   * Add an exact path key.
+   * @param path supplies the path to match.
+   * @param ordinal supplies the ordinal of the route the path belongs to.
+   */
+  void addPath(const std::string& path, uint32_t ordinal);
+
+  /**
+   * Find the lowest route ordinal matching a path.
+   * @param path supplies the full request path, including any query string. Prefix keys are
+   *        matched against all of it.
+   * @param length supplies the length of path.
+   * @param path_length supplies the length of path excluding the query string. Exact path keys are
+   *        matched against this portion only.
+   * @return uint32_t the lowest matching ordinal or NO_MATCH.
+   */
+  uint32_t find(const char* path, size_t length, size_t path_length) const;
+
+  /**
+   * @return bool whether any keys have been added.
+   */
+  bool empty() const { return size_ == 0; }
+
+  static const uint32_t NO_MATCH = std::numeric_limits<uint32_t>::max();
+
+private:
+  struct Node;
+  typedef std::unique_ptr<Node> NodePtr;
+
+  struct Node {
+    // The portion of the key leading from the parent to this node.
+    std::string label_;
+    uint32_t prefix_ordinal_{NO_MATCH};
+    uint32_t path_ordinal_{NO_MATCH};
+    // Children are kept sorted by the first character of their label. No two children share a
+    // first character.
+    std::vector<NodePtr> children_;
+  };
+
+  Node& insert(const std::string& key);
+  static const Node* findChild(const Node& node, char c);
+
+  NodePtr root_;
+  uint64_t size_{};
+};
+
+} // namespace Router
+} // namespace Envoy
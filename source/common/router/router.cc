@@ -1,5 +1,6 @@
 #include "common/router/router.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <string>
@@ -13,6 +14,7 @@
 #include "envoy/upstream/cluster_manager.h"
 #include "envoy/upstream/upstream.h"
 
+#include "common/buffer/buffer_impl.h"
 #include "common/common/assert.h"
 #include "common/common/empty_string.h"
 #include "common/common/enum_to_int.h"
@@ -25,14 +27,34 @@
 #include "common/http/utility.h"
 #include "common/router/config_impl.h"
 #include "common/router/retry_state_impl.h"
+#include "common/runtime/key_registry.h"
 #include "common/tracing/http_tracer_impl.h"
 
 namespace Envoy {
 namespace Router {
 namespace {
-uint32_t getLength(const Buffer::Instance* instance) { return instance ? instance->length() : 0; }
+
+// Reference the slices of a retained chunk of the request body instead of copying them. Each
+// fragment holds a reference to the chunk until the buffer is done with it.
+void referenceChunk(const std::shared_ptr<const Buffer::Instance>& chunk, Buffer::Instance& out) {
+  uint64_t num_slices = chunk->getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  chunk->getRawSlices(slices, num_slices);
+  for (const Buffer::RawSlice& slice : slices) {
+    Buffer::BufferFragmentImpl* fragment = new Buffer::BufferFragmentImpl(
+        slice.mem_, slice.len_,
+        [chunk](const void*, size_t, const Buffer::BufferFragmentImpl* fragment) -> void {
+          delete fragment;
+        });
+    out.addBufferFragment(*fragment);
+  }
+}
+
 } // namespace
 
+static const Runtime::Key RuntimeStreamingShadow =
+    Runtime::KeyRegistry::registerKey("router.streaming_shadow");
+
 void FilterUtility::setUpstreamScheme(Http::HeaderMap& headers,
                                       const Upstream::ClusterInfo& cluster) {
   if (cluster.sslContext()) {
@@ -98,9 +120,85 @@ FilterUtility::TimeoutData FilterUtility::finalTimeout(const RouteEntry& route,
   return timeout;
 }
 
+bool FilterUtility::collapsingKey(const RouteEntry& route, const Http::HeaderMap& request_headers,
+                                  bool end_stream, std::string& key) {
+  if (!end_stream || !request_headers.Method() ||
+      request_headers.Method()->value() != Http::Headers::get().MethodValues.Get.c_str()) {
+    return false;
+  }
+
+  const auto& opaque_config = route.opaqueConfig();
+  auto collapse_requests = opaque_config.find("collapse_requests");
+  if (collapse_requests == opaque_config.end() || collapse_requests->second != "true") {
+    return false;
+  }
+
+  std::vector<Http::LowerCaseString> key_headers;
+  auto collapse_key_headers = opaque_config.find("collapse_key_headers");
+  if (collapse_key_headers != opaque_config.end()) {
+    for (const std::string& header : StringUtil::split(collapse_key_headers->second, ',')) {
+      key_headers.emplace_back(header);
+    }
+  }
+
+  // Don't share responses between requests carrying credentials unless they are part of the key.
+  for (const Http::LowerCaseString& header :
+       {Http::Headers::get().Authorization, Http::Headers::get().Cookie}) {
+    if (request_headers.get(header) &&
+        std::find(key_headers.begin(), key_headers.end(), header) == key_headers.end()) {
+      return false;
+    }
+  }
+
+  // Requests on different routes may be sent to different clusters or rewritten differently.
+  key = fmt::format("{}\n{}\n{}", static_cast<const void*>(&route),
+                    request_headers.Host()->value().c_str(),
+                    request_headers.Path()->value().c_str());
+  for (const Http::LowerCaseString& key_header : key_headers) {
+    const Http::HeaderEntry* entry = request_headers.get(key_header);
+    key += "\n";
+    if (entry) {
+      key += entry->value().c_str();
+    }
+  }
+
+  return true;
+}
+
+std::chrono::milliseconds FilterUtility::hedgeDelay(const RouteEntry& route) {
+  const auto& opaque_config = route.opaqueConfig();
+  auto hedge_delay = opaque_config.find("hedge_delay_ms");
+  uint64_t delay_ms;
+  if (hedge_delay == opaque_config.end() || route.hashPolicy() ||
+      !StringUtil::atoul(hedge_delay->second.c_str(), delay_ms)) {
+    return std::chrono::milliseconds(0);
+  }
+
+  return std::chrono::milliseconds(delay_ms);
+}
+
+uint64_t FilterUtility::retryBufferLimit(const RouteEntry& route, uint32_t buffer_limit) {
+  const auto& opaque_config = route.opaqueConfig();
+  auto retry_buffer_limit = opaque_config.find("retry_buffer_limit_bytes");
+  uint64_t limit;
+  if (retry_buffer_limit == opaque_config.end() ||
+      !StringUtil::atoul(retry_buffer_limit->second.c_str(), limit)) {
+    return buffer_limit;
+  }
+
+  return limit;
+}
+
+bool FilterUtility::allowEarlyData(const RouteEntry& route) {
+  const auto& opaque_config = route.opaqueConfig();
+  auto allow_early_data = opaque_config.find("allow_early_data");
+  return allow_early_data == opaque_config.end() || allow_early_data->second != "false";
+}
+
 Filter::~Filter() {
   // Upstream resources should already have been cleaned.
   ASSERT(!upstream_request_);
+  ASSERT(!hedged_request_);
   ASSERT(!retry_state_);
 }
 
@@ -139,7 +237,8 @@ void Filter::chargeUpstreamCode(uint64_t response_status_code,
                                                                : EMPTY_STRING,
                                              zone_name,
                                              upstream_zone,
-                                             is_canary};
+                                             is_canary,
+                                             &cluster_->codeStats()};
 
     Http::CodeUtility::chargeResponseStat(info);
 
@@ -148,7 +247,8 @@ void Filter::chargeUpstreamCode(uint64_t response_status_code,
                                                alt_stat_prefix_, response_status_code,
                                                internal_request, EMPTY_STRING,
                                                EMPTY_STRING,     zone_name,
-                                               upstream_zone,    is_canary};
+                                               upstream_zone,    is_canary,
+                                               nullptr};
 
       Http::CodeUtility::chargeResponseStat(info);
     }
@@ -172,6 +272,9 @@ void Filter::chargeUpstreamCode(Http::Code code,
 }
 
 void Filter::sendLocalReply(Http::Code code, const std::string& body, bool overloaded) {
+  // The requests collapsed into this one won't share a local reply.
+  releaseCollapsedRequests();
+
   // This is a customized version of send local reply that allows us to set the overloaded
   // header.
   Http::Utility::sendLocalReply(
@@ -219,7 +322,22 @@ Http::FilterHeadersStatus Filter::decodeHeaders(Http::HeaderMap& headers, bool e
 
   // A route entry matches for the request.
   route_entry_ = route_->routeEntry();
-  Upstream::ThreadLocalCluster* cluster = config_.cm_.get(route_entry_->clusterName());
+  if (headers.get(Http::Headers::get().EarlyData) &&
+      !FilterUtility::allowEarlyData(*route_entry_)) {
+    config_.stats_.rq_too_early_.inc();
+    ENVOY_STREAM_LOG(debug, "early data not allowed by route", *callbacks_);
+
+    Http::HeaderMapPtr response_headers{new Http::HeaderMapImpl{
+        {Http::Headers::get().Status, std::to_string(enumToInt(Http::Code::TooEarly))}}};
+    callbacks_->encodeHeaders(std::move(response_headers), true);
+    return Http::FilterHeadersStatus::StopIteration;
+  }
+
+  // Routes which know their cluster when loaded find it by its handle rather than by its name.
+  const Optional<uint32_t> cluster_handle = route_entry_->clusterHandle();
+  Upstream::ThreadLocalCluster* cluster =
+      cluster_handle.valid() ? config_.cm_.getByHandle(cluster_handle.value())
+                             : config_.cm_.get(route_entry_->clusterName());
   if (!cluster) {
     config_.stats_.no_cluster_.inc();
     ENVOY_STREAM_LOG(debug, "unknown cluster '{}'", *callbacks_, route_entry_->clusterName());
@@ -275,6 +393,8 @@ Http::FilterHeadersStatus Filter::decodeHeaders(Http::HeaderMap& headers, bool e
                        config_.random_, callbacks_->dispatcher(), route_entry_->priority());
   do_shadowing_ = FilterUtility::shouldShadow(route_entry_->shadowPolicy(), config_.runtime_,
                                               callbacks_->streamId());
+  hedge_delay_ = FilterUtility::hedgeDelay(*route_entry_);
+  retry_buffer_limit_ = FilterUtility::retryBufferLimit(*route_entry_, buffer_limit_);
 
 #ifndef NVLOG
   headers.iterate(
@@ -295,8 +415,21 @@ Http::FilterHeadersStatus Filter::decodeHeaders(Http::HeaderMap& headers, bool e
   ASSERT(headers.Path());
 
   grpc_request_ = Grpc::Common::hasGrpcContentType(headers);
+  if (collapseRequest(headers, end_stream)) {
+    return Http::FilterHeadersStatus::StopIteration;
+  }
+
   upstream_request_.reset(new UpstreamRequest(*this, *conn_pool));
   upstream_request_->encodeHeaders(end_stream);
+  // A request with a body is shadowed as it streams, so that it need not be buffered for the
+  // shadow. The shadow has its own buffer limit, and is dropped rather than hold up the request.
+  if (do_shadowing_ && !end_stream && upstream_request_ &&
+      config_.runtime_.snapshot().featureEnabled(RuntimeStreamingShadow, 100)) {
+    do_shadowing_ = false;
+    shadow_stream_ = config_.shadowWriter().streamShadow(
+        route_entry_->shadowPolicy().cluster(), headers, timeout_.global_timeout_, buffer_limit_);
+  }
+
   if (end_stream) {
     onRequestComplete();
   }
@@ -305,10 +438,105 @@ Http::FilterHeadersStatus Filter::decodeHeaders(Http::HeaderMap& headers, bool e
 }
 
 Http::ConnectionPool::Instance* Filter::getConnPool() {
+  const Optional<uint32_t> cluster_handle = route_entry_->clusterHandle();
+  if (cluster_handle.valid()) {
+    return config_.cm_.httpConnPoolForClusterHandle(cluster_handle.value(),
+                                                    route_entry_->priority(), this);
+  }
   return config_.cm_.httpConnPoolForCluster(route_entry_->clusterName(), route_entry_->priority(),
                                             this);
 }
 
+bool Filter::collapseRequest(const Http::HeaderMap& headers, bool end_stream) {
+  CollapsedRequests* collapsed_requests = config_.collapsedRequests();
+  std::string key;
+  if (!collapsed_requests ||
+      !FilterUtility::collapsingKey(*route_entry_, headers, end_stream, key)) {
+    return false;
+  }
+
+  auto leader = collapsed_requests->leaders_.find(key);
+  if (leader == collapsed_requests->leaders_.end()) {
+    collapsed_requests->leaders_.emplace(key, this);
+    collapsed_key_ = std::move(key);
+    return false;
+  }
+
+  ENVOY_STREAM_LOG(debug, "collapsing request", *callbacks_);
+  config_.stats_.rq_collapsed_.inc();
+  collapsed_leader_ = leader->second;
+  collapsed_leader_->collapsed_followers_.push_back(this);
+  return true;
+}
+
+void Filter::startCollapsedUpstreamRequest() {
+  // The leader failed before its response started, so send the request on our own.
+  ASSERT(!upstream_request_);
+  collapsed_leader_ = nullptr;
+  Http::ConnectionPool::Instance* conn_pool = getConnPool();
+  if (!conn_pool) {
+    sendNoHealthyUpstreamResponse();
+    return;
+  }
+
+  upstream_request_.reset(new UpstreamRequest(*this, *conn_pool));
+  upstream_request_->encodeHeaders(true);
+  onRequestComplete();
+}
+
+void Filter::encodeCollapsedHeaders(const Http::HeaderMap& headers, bool end_stream) {
+  Http::HeaderMapPtr copy{new Http::HeaderMapImpl(headers)};
+  route_entry_->finalizeResponseHeaders(*copy, callbacks_->requestInfo());
+  downstream_response_started_ = true;
+  if (end_stream) {
+    leaveCollapsedRequest();
+  }
+
+  callbacks_->encodeHeaders(std::move(copy), end_stream);
+}
+
+void Filter::encodeCollapsedData(const Buffer::Instance& data, bool end_stream) {
+  Buffer::OwnedImpl copy(data);
+  if (end_stream) {
+    leaveCollapsedRequest();
+  }
+
+  callbacks_->encodeData(copy, end_stream);
+}
+
+void Filter::encodeCollapsedTrailers(const Http::HeaderMap& trailers) {
+  leaveCollapsedRequest();
+  callbacks_->encodeTrailers(Http::HeaderMapPtr{new Http::HeaderMapImpl(trailers)});
+}
+
+void Filter::leaveCollapsedRequest() {
+  if (collapsed_leader_) {
+    collapsed_leader_->collapsed_followers_.remove(this);
+    collapsed_leader_ = nullptr;
+  }
+}
+
+void Filter::releaseCollapsedRequests() {
+  unregisterCollapsedRequest();
+  std::list<Filter*> followers = std::move(collapsed_followers_);
+  collapsed_followers_.clear();
+  for (Filter* follower : followers) {
+    follower->collapsed_leader_ = nullptr;
+    if (follower->downstream_response_started_) {
+      follower->callbacks_->resetStream();
+    } else {
+      follower->startCollapsedUpstreamRequest();
+    }
+  }
+}
+
+void Filter::unregisterCollapsedRequest() {
+  if (!collapsed_key_.empty()) {
+    config_.collapsedRequests()->leaders_.erase(collapsed_key_);
+    collapsed_key_.clear();
+  }
+}
+
 void Filter::sendNoHealthyUpstreamResponse() {
   callbacks_->requestInfo().setResponseFlag(AccessLog::ResponseFlag::NoHealthyUpstream);
   chargeUpstreamCode(Http::Code::ServiceUnavailable, nullptr, false);
@@ -316,21 +544,40 @@ void Filter::sendNoHealthyUpstreamResponse() {
 }
 
 Http::FilterDataStatus Filter::decodeData(Buffer::Instance& data, bool end_stream) {
-  bool buffering = (retry_state_ && retry_state_->enabled()) || do_shadowing_;
-  if (buffering && buffer_limit_ > 0 &&
-      getLength(callbacks_->decodingBuffer()) + data.length() > buffer_limit_) {
-    // The request is larger than we should buffer. Give up on the retry/shadow
+  if (shadow_stream_) {
+    shadow_stream_->sendData(data, end_stream);
+    if (end_stream) {
+      shadow_stream_ = nullptr;
+    }
+  }
+
+  bool buffering =
+      (retry_state_ && retry_state_->enabled()) || do_shadowing_ || hedge_delay_.count() > 0;
+  if (buffering && retry_buffer_limit_ > 0 &&
+      retained_body_length_ + data.length() > retry_buffer_limit_) {
+    // The request is larger than we should buffer. Give up on the retry/shadow/hedge
     cluster_->stats().retry_or_shadow_abandoned_.inc();
     retry_state_.reset();
     buffering = false;
     do_shadowing_ = false;
+    hedge_delay_ = std::chrono::milliseconds(0);
+    retained_body_.clear();
+    retained_body_length_ = 0;
   }
 
-  // If we are going to buffer for retries or shadowing, we need to make a copy before encoding
-  // since it's all moves from here on.
+  // If we are going to retry, shadow or hedge, the data is retained as an immutable chunk, which
+  // this and every later upstream attempt reference rather than copy. The connection manager
+  // doesn't buffer the data as well.
+  request_has_body_ = true;
   if (buffering) {
-    Buffer::OwnedImpl copy(data);
-    upstream_request_->encodeData(copy, end_stream);
+    std::shared_ptr<Buffer::OwnedImpl> chunk = std::make_shared<Buffer::OwnedImpl>();
+    chunk->move(data);
+    retained_body_length_ += chunk->length();
+    retained_body_.push_back(chunk);
+
+    Buffer::OwnedImpl body;
+    referenceChunk(retained_body_.back(), body);
+    upstream_request_->encodeData(body, end_stream);
   } else {
     upstream_request_->encodeData(data, end_stream);
   }
@@ -339,15 +586,16 @@ Http::FilterDataStatus Filter::decodeData(Buffer::Instance& data, bool end_strea
     onRequestComplete();
   }
 
-  // If we are potentially going to retry or shadow this request we need to buffer.
-  // This will not cause the connection manager to 413 because before we hit the
-  // buffer limit we give up on retries and buffering.
-  return buffering ? Http::FilterDataStatus::StopIterationAndBuffer
-                   : Http::FilterDataStatus::StopIterationNoBuffer;
+  return Http::FilterDataStatus::StopIterationNoBuffer;
 }
 
 Http::FilterTrailersStatus Filter::decodeTrailers(Http::HeaderMap& trailers) {
   downstream_trailers_ = &trailers;
+  if (shadow_stream_) {
+    shadow_stream_->sendTrailers(trailers);
+    shadow_stream_ = nullptr;
+  }
+
   upstream_request_->encodeTrailers(trailers);
   onRequestComplete();
   return Http::FilterTrailersStatus::StopIteration;
@@ -363,7 +611,12 @@ void Filter::setDecoderFilterCallbacks(Http::StreamDecoderFilterCallbacks& callb
 
 void Filter::cleanup() {
   upstream_request_.reset();
+  hedged_request_.reset();
   retry_state_.reset();
+  if (hedge_timer_) {
+    hedge_timer_->disableTimer();
+    hedge_timer_.reset();
+  }
   if (response_timeout_) {
     response_timeout_->disableTimer();
     response_timeout_.reset();
@@ -378,8 +631,9 @@ void Filter::maybeDoShadowing() {
   ASSERT(!route_entry_->shadowPolicy().cluster().empty());
   Http::MessagePtr request(new Http::RequestMessageImpl(
       Http::HeaderMapPtr{new Http::HeaderMapImpl(*downstream_headers_)}));
-  if (callbacks_->decodingBuffer()) {
-    request->body().reset(new Buffer::OwnedImpl(*callbacks_->decodingBuffer()));
+  if (request_has_body_) {
+    request->body().reset(new Buffer::OwnedImpl());
+    referenceRetainedBody(*request->body());
   }
   if (downstream_trailers_) {
     request->trailers(Http::HeaderMapPtr{new Http::HeaderMapImpl(*downstream_trailers_)});
@@ -389,9 +643,15 @@ void Filter::maybeDoShadowing() {
                                 timeout_.global_timeout_);
 }
 
+void Filter::referenceRetainedBody(Buffer::Instance& body) {
+  for (const auto& chunk : retained_body_) {
+    referenceChunk(chunk, body);
+  }
+}
+
 void Filter::onRequestComplete() {
   downstream_end_stream_ = true;
-  downstream_request_complete_time_ = std::chrono::steady_clock::now();
+  downstream_request_complete_time_ = callbacks_->dispatcher().approximateMonotonicTime();
   callbacks_->requestInfo().requestReceivedDuration(downstream_request_complete_time_);
 
   // Possible that we got an immediate reset.
@@ -406,16 +666,31 @@ void Filter::onRequestComplete() {
     upstream_request_->setupPerTryTimeout();
     if (timeout_.global_timeout_.count() > 0) {
       response_timeout_ =
-          callbacks_->dispatcher().createTimer([this]() -> void { onResponseTimeout(); });
+          callbacks_->dispatcher().createCoarseTimer([this]() -> void { onResponseTimeout(); });
       response_timeout_->enableTimer(timeout_.global_timeout_);
     }
+
+    if (hedge_delay_.count() > 0) {
+      hedge_timer_ = callbacks_->dispatcher().createTimer([this]() -> void { onHedgeTimeout(); });
+      hedge_timer_->enableTimer(hedge_delay_);
+    }
   }
 }
 
 void Filter::onDestroy() {
+  leaveCollapsedRequest();
+  releaseCollapsedRequests();
+  if (shadow_stream_) {
+    shadow_stream_->reset();
+    shadow_stream_ = nullptr;
+  }
+
   if (upstream_request_) {
     upstream_request_->resetStream();
   }
+  if (hedged_request_) {
+    hedged_request_->resetStream();
+  }
   stream_destroyed_ = true;
   cleanup();
 }
@@ -424,6 +699,12 @@ void Filter::onResponseTimeout() {
   ENVOY_STREAM_LOG(debug, "upstream timeout", *callbacks_);
   cluster_->stats().upstream_rq_timeout_.inc();
 
+  // The response timeout covers all attempts, so a hedged request is given up as well.
+  if (hedged_request_) {
+    hedged_request_->resetStream();
+    hedged_request_.reset();
+  }
+
   // It's possible to timeout during a retry backoff delay when we have no upstream request. In
   // this case we fake a reset since onUpstreamReset() doesn't care.
   if (upstream_request_) {
@@ -436,6 +717,86 @@ void Filter::onResponseTimeout() {
   onUpstreamReset(UpstreamResetType::GlobalTimeout, Optional<Http::StreamResetReason>());
 }
 
+void Filter::onHedgeTimeout() {
+  // The response may have started or we may be waiting for a retry by now. Only one hedged request
+  // is sent for each downstream request.
+  if (!upstream_request_ || hedged_request_ || downstream_response_started_) {
+    return;
+  }
+
+  // Connection pools are per host, so the hedged request would go to the same host as the first
+  // one if the load balancer picks the same pool again. That is unlikely to be any faster.
+  Http::ConnectionPool::Instance* conn_pool = getConnPool();
+  if (!conn_pool || conn_pool == &upstream_request_->conn_pool_) {
+    return;
+  }
+
+  ENVOY_STREAM_LOG(debug, "sending hedged request", *callbacks_);
+  config_.stats_.rq_hedged_.inc();
+  hedged_request_.reset(new UpstreamRequest(*this, *conn_pool));
+  hedged_request_->encodeHeaders(!request_has_body_ && !downstream_trailers_);
+  // It's possible we got immediately reset.
+  if (hedged_request_) {
+    if (request_has_body_) {
+      Buffer::OwnedImpl body;
+      referenceRetainedBody(body);
+      hedged_request_->encodeData(body, !downstream_trailers_);
+    }
+
+    if (downstream_trailers_) {
+      hedged_request_->encodeTrailers(*downstream_trailers_);
+    }
+
+    hedged_request_->setupPerTryTimeout();
+  }
+}
+
+bool Filter::abandonHedgedAttempt(UpstreamRequest& attempt, UpstreamResetType type) {
+  if (!hedged_request_) {
+    return false;
+  }
+
+  // The other attempt may still succeed, so this failure doesn't affect the downstream request.
+  ENVOY_STREAM_LOG(debug, "hedged attempt failed", *callbacks_);
+  if (attempt.upstream_host_) {
+    attempt.upstream_host_->outlierDetector().putHttpResponseCode(
+        enumToInt(type == UpstreamResetType::Reset ? Http::Code::ServiceUnavailable
+                                                   : timeout_response_code_));
+  }
+
+  // This destroys the attempt.
+  if (&attempt == hedged_request_.get()) {
+    hedged_request_.reset();
+  } else {
+    ASSERT(&attempt == upstream_request_.get());
+    upstream_request_ = std::move(hedged_request_);
+  }
+  return true;
+}
+
+void Filter::resolveHedging(UpstreamRequest& winner) {
+  if (hedge_timer_) {
+    hedge_timer_->disableTimer();
+    hedge_timer_.reset();
+  }
+
+  if (!hedged_request_) {
+    return;
+  }
+
+  // Whichever attempt gets response headers first wins, and the other one is cancelled.
+  if (&winner == hedged_request_.get()) {
+    ENVOY_STREAM_LOG(debug, "hedged request won", *callbacks_);
+    config_.stats_.rq_hedge_won_.inc();
+    upstream_request_->resetStream();
+    upstream_request_ = std::move(hedged_request_);
+    callbacks_->requestInfo().onUpstreamHostSelected(upstream_request_->upstream_host_);
+  } else {
+    hedged_request_->resetStream();
+    hedged_request_.reset();
+  }
+}
+
 void Filter::onUpstreamReset(UpstreamResetType type,
                              const Optional<Http::StreamResetReason>& reset_reason) {
   ASSERT(type == UpstreamResetType::GlobalTimeout || upstream_request_);
@@ -475,6 +836,7 @@ void Filter::onUpstreamReset(UpstreamResetType type,
     }
     // This will destroy any created retry timers.
     cleanup();
+    releaseCollapsedRequests();
     callbacks_->resetStream();
   } else {
     // This will destroy any created retry timers.
@@ -566,7 +928,8 @@ void Filter::onUpstreamHeaders(const uint64_t response_code, Http::HeaderMapPtr&
     // upstream_request_.
     const auto upstream_host = upstream_request_->upstream_host_;
     if (retry_status == RetryStatus::Yes && setupRetry(end_stream)) {
-      Http::CodeUtility::chargeBasicResponseStat(cluster_->statsScope(), "retry.",
+      Http::CodeUtility::chargeBasicResponseStat(cluster_->codeStats(),
+                                                 Http::CodeStats::Prefix::Retry,
                                                  static_cast<Http::Code>(response_code));
       upstream_host->stats().rq_error_.inc();
       return;
@@ -582,7 +945,7 @@ void Filter::onUpstreamHeaders(const uint64_t response_code, Http::HeaderMapPtr&
   // Only send upstream service time if we received the complete request and this is not a
   // premature response.
   if (DateUtil::timePointValid(downstream_request_complete_time_)) {
-    MonotonicTime response_received_time = std::chrono::steady_clock::now();
+    MonotonicTime response_received_time = callbacks_->dispatcher().approximateMonotonicTime();
     std::chrono::milliseconds ms = std::chrono::duration_cast<std::chrono::milliseconds>(
         response_received_time - downstream_request_complete_time_);
     headers->insertEnvoyUpstreamServiceTime().value(ms.count());
@@ -598,6 +961,13 @@ void Filter::onUpstreamHeaders(const uint64_t response_code, Http::HeaderMapPtr&
     handleNon5xxResponseHeaders(*headers, end_stream);
   }
 
+  // Requests collapsed into this one get the response before it is finalized for this route.
+  unregisterCollapsedRequest();
+  for (auto it = collapsed_followers_.begin(); it != collapsed_followers_.end();) {
+    Filter* follower = *it++;
+    follower->encodeCollapsedHeaders(*headers, end_stream);
+  }
+
   // Append routing cookies
   for (const auto& header_value : downstream_set_cookies_) {
     headers->addReferenceKey(Http::Headers::get().SetCookie, header_value);
@@ -625,6 +995,11 @@ void Filter::onUpstreamData(Buffer::Instance& data, bool end_stream) {
     onUpstreamComplete();
   }
 
+  for (auto it = collapsed_followers_.begin(); it != collapsed_followers_.end();) {
+    Filter* follower = *it++;
+    follower->encodeCollapsedData(data, end_stream);
+  }
+
   callbacks_->encodeData(data, end_stream);
 }
 
@@ -639,6 +1014,11 @@ void Filter::onUpstreamTrailers(Http::HeaderMapPtr&& trailers) {
     }
   }
   onUpstreamComplete();
+  for (auto it = collapsed_followers_.begin(); it != collapsed_followers_.end();) {
+    Filter* follower = *it++;
+    follower->encodeCollapsedTrailers(*trailers);
+  }
+
   callbacks_->encodeTrailers(std::move(trailers));
 }
 
@@ -647,10 +1027,22 @@ void Filter::onUpstreamComplete() {
     upstream_request_->resetStream();
   }
 
+  if (!callbacks_->requestInfo().healthCheck() &&
+      DateUtil::timePointValid(downstream_request_complete_time_)) {
+    // Adaptive request limits and latency aware load balancing need the latency whether or not
+    // dynamic stats are emitted.
+    const MonotonicTime now = callbacks_->dispatcher().approximateMonotonicTime();
+    const std::chrono::microseconds latency =
+        std::chrono::duration_cast<std::chrono::microseconds>(now -
+                                                              downstream_request_complete_time_);
+    cluster_->resourceManager(route_entry_->priority()).onRequestComplete(latency);
+    upstream_request_->upstream_host_->latencyEstimator().putLatency(latency, now);
+  }
+
   if (config_.emit_dynamic_stats_ && !callbacks_->requestInfo().healthCheck() &&
       DateUtil::timePointValid(downstream_request_complete_time_)) {
     std::chrono::milliseconds response_time = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::steady_clock::now() - downstream_request_complete_time_);
+        callbacks_->dispatcher().approximateMonotonicTime() - downstream_request_complete_time_);
 
     upstream_request_->upstream_host_->outlierDetector().putResponseTime(response_time);
 
@@ -724,13 +1116,13 @@ void Filter::doRetry() {
   ASSERT(response_timeout_ || timeout_.global_timeout_.count() == 0);
   ASSERT(!upstream_request_);
   upstream_request_.reset(new UpstreamRequest(*this, *conn_pool));
-  upstream_request_->encodeHeaders(!callbacks_->decodingBuffer() && !downstream_trailers_);
+  upstream_request_->encodeHeaders(!request_has_body_ && !downstream_trailers_);
   // It's possible we got immediately reset.
   if (upstream_request_) {
-    if (callbacks_->decodingBuffer()) {
-      // If we are doing a retry we need to make a copy.
-      Buffer::OwnedImpl copy(*callbacks_->decodingBuffer());
-      upstream_request_->encodeData(copy, !downstream_trailers_);
+    if (request_has_body_) {
+      Buffer::OwnedImpl body;
+      referenceRetainedBody(body);
+      upstream_request_->encodeData(body, !downstream_trailers_);
     }
 
     if (downstream_trailers_) {
@@ -743,13 +1135,15 @@ void Filter::doRetry() {
 
 Filter::UpstreamRequest::UpstreamRequest(Filter& parent, Http::ConnectionPool::Instance& pool)
     : parent_(parent), conn_pool_(pool), grpc_rq_success_deferred_(false),
-      request_info_(pool.protocol()), calling_encode_headers_(false), upstream_canary_(false),
+      request_info_(pool.protocol(), parent.callbacks_->dispatcher().approximateSystemTime(),
+                    parent.callbacks_->dispatcher().approximateMonotonicTime()),
+      calling_encode_headers_(false), upstream_canary_(false),
       encode_complete_(false), encode_trailers_(false) {
 
   if (parent_.config_.start_child_span_) {
     span_ = parent_.callbacks_->activeSpan().spawnChild(
         parent_.callbacks_->tracingConfig(), "router " + parent.cluster_->name() + " egress",
-        ProdSystemTimeSource::instance_.currentTime());
+        parent_.callbacks_->dispatcher().approximateSystemTime());
     span_->setTag(Tracing::Tags::get().COMPONENT, Tracing::Tags::get().PROXY);
   }
 
@@ -776,6 +1170,7 @@ void Filter::UpstreamRequest::decodeHeaders(Http::HeaderMapPtr&& headers, bool e
   upstream_headers_ = headers.get();
   const uint64_t response_code = Http::Utility::getResponseStatus(*headers);
   request_info_.response_code_.value(static_cast<uint32_t>(response_code));
+  parent_.resolveHedging(*this);
   parent_.onUpstreamHeaders(response_code, std::move(headers), end_stream);
 }
 
@@ -792,10 +1187,19 @@ void Filter::UpstreamRequest::encodeHeaders(bool end_stream) {
   ASSERT(!encode_complete_);
   encode_complete_ = end_stream;
 
+  // A request without a body and with a safe method may be pipelined, as it can be retried should
+  // the connection close before its response.
+  const Http::HeaderEntry* method = parent_.downstream_headers_->Method();
+  const bool pipelinable = end_stream && method &&
+                           (method->value() == Http::Headers::get().MethodValues.Get.c_str() ||
+                            method->value() == Http::Headers::get().MethodValues.Head.c_str());
+
   // It's possible for a reset to happen inline within the newStream() call. In this case, we might
   // get deleted inline as well. Only write the returned handle out if it is not nullptr to deal
   // with this case.
-  Http::ConnectionPool::Cancellable* handle = conn_pool_.newStream(*this, *this);
+  Http::ConnectionPool::Cancellable* handle = pipelinable
+                                                  ? conn_pool_.newPipelinableStream(*this, *this)
+                                                  : conn_pool_.newStream(*this, *this);
   if (handle) {
     conn_pool_stream_handle_ = handle;
   }
@@ -839,7 +1243,10 @@ void Filter::UpstreamRequest::onResetStream(Http::StreamResetReason reason) {
   clearRequestEncoder();
   if (!calling_encode_headers_) {
     request_info_.setResponseFlag(parent_.streamResetReasonToResponseFlag(reason));
-    parent_.onUpstreamReset(UpstreamResetType::Reset, Optional<Http::StreamResetReason>(reason));
+    // Note that this may delete us.
+    if (!parent_.abandonHedgedAttempt(*this, UpstreamResetType::Reset)) {
+      parent_.onUpstreamReset(UpstreamResetType::Reset, Optional<Http::StreamResetReason>(reason));
+    }
   } else {
     deferred_reset_reason_ = reason;
   }
@@ -864,7 +1271,7 @@ void Filter::UpstreamRequest::setupPerTryTimeout() {
   ASSERT(!per_try_timeout_);
   if (parent_.timeout_.per_try_timeout_.count() > 0) {
     per_try_timeout_ =
-        parent_.callbacks_->dispatcher().createTimer([this]() -> void { onPerTryTimeout(); });
+        parent_.callbacks_->dispatcher().createCoarseTimer([this]() -> void { onPerTryTimeout(); });
     per_try_timeout_->enableTimer(parent_.timeout_.per_try_timeout_);
   }
 }
@@ -877,8 +1284,11 @@ void Filter::UpstreamRequest::onPerTryTimeout() {
   }
   resetStream();
   request_info_.setResponseFlag(AccessLog::ResponseFlag::UpstreamRequestTimeout);
-  parent_.onUpstreamReset(UpstreamResetType::PerTryTimeout,
-                          Optional<Http::StreamResetReason>(Http::StreamResetReason::LocalReset));
+  // Note that this may delete us.
+  if (!parent_.abandonHedgedAttempt(*this, UpstreamResetType::PerTryTimeout)) {
+    parent_.onUpstreamReset(UpstreamResetType::PerTryTimeout,
+                            Optional<Http::StreamResetReason>(Http::StreamResetReason::LocalReset));
+  }
 }
 
 void Filter::UpstreamRequest::onPoolFailure(Http::ConnectionPool::PoolFailureReason reason,
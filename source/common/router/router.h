@@ -2,8 +2,11 @@
 
 #include <chrono>
 #include <cstdint>
+#include <list>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "envoy/http/codec.h"
 #include "envoy/http/codes.h"
@@ -13,6 +16,7 @@
 #include "envoy/runtime/runtime.h"
 #include "envoy/server/filter_config.h"
 #include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
 #include "envoy/upstream/cluster_manager.h"
 
 #include "common/access_log/access_log_impl.h"
@@ -36,6 +40,10 @@ namespace Router {
   COUNTER(no_route)                                                                                \
   COUNTER(no_cluster)                                                                              \
   COUNTER(rq_redirect)                                                                             \
+  COUNTER(rq_collapsed)                                                                            \
+  COUNTER(rq_hedged)                                                                               \
+  COUNTER(rq_hedge_won)                                                                            \
+  COUNTER(rq_too_early)                                                                            \
   COUNTER(rq_total)
 // clang-format on
 
@@ -79,6 +87,59 @@ public:
    * @return TimeoutData for both the global and per try timeouts.
    */
   static TimeoutData finalTimeout(const RouteEntry& route, Http::HeaderMap& request_headers);
+
+  /**
+   * Determine whether a request may be collapsed with identical concurrent requests. This is the
+   * case for GET requests without a body on routes whose opaque config sets "collapse_requests" to
+   * "true". Requests with an authorization or cookie header are only collapsed if the header is
+   * listed in the comma separated "collapse_key_headers" of the opaque config.
+   * @param route supplies the request route.
+   * @param request_headers supplies the request headers.
+   * @param end_stream supplies whether the headers end the request.
+   * @param key supplies the key to fill in. Requests with the same key are identical.
+   * @return TRUE if the request may be collapsed.
+   */
+  static bool collapsingKey(const RouteEntry& route, const Http::HeaderMap& request_headers,
+                            bool end_stream, std::string& key);
+
+  /**
+   * Determine how long to wait for response headers before sending a hedged request to another
+   * host. This is the "hedge_delay_ms" of the route's opaque config. Routes with a hash policy
+   * aren't hedged, since their requests are meant to go to the host the hash selects.
+   * @param route supplies the request route.
+   * @return std::chrono::milliseconds the hedge delay, or 0 if requests aren't hedged.
+   */
+  static std::chrono::milliseconds hedgeDelay(const RouteEntry& route);
+
+  /**
+   * Determine how much of a request body may be retained for retries, shadowing and hedging before
+   * they are given up on. This is the "retry_buffer_limit_bytes" of the route's opaque config, or
+   * else the buffer limit of the request.
+   * @param route supplies the request route.
+   * @param buffer_limit supplies the buffer limit of the request.
+   * @return uint64_t the limit, or 0 if there is none.
+   */
+  static uint64_t retryBufferLimit(const RouteEntry& route, uint32_t buffer_limit);
+
+  /**
+   * Determine whether requests received in TLS 1.3 early data may be routed. This is false when
+   * the "allow_early_data" of the route's opaque config is "false", for routes whose idempotent
+   * requests still have side effects which a replay must not repeat.
+   * @param route supplies the request route.
+   * @return bool whether early data requests may be routed.
+   */
+  static bool allowEarlyData(const RouteEntry& route);
+};
+
+class Filter;
+
+/**
+ * The requests being collapsed on a worker, keyed by FilterUtility::collapsingKey(). Each maps to
+ * the filter whose upstream request is shared with the identical requests which arrived while it
+ * was waiting for response headers.
+ */
+struct CollapsedRequests : public ThreadLocal::ThreadLocalObject {
+  std::unordered_map<std::string, Filter*> leaders_;
 };
 
 /**
@@ -104,10 +165,30 @@ public:
     for (const auto& upstream_log : config.upstream_log()) {
       upstream_logs_.push_back(AccessLog::AccessLogFactory::fromProto(upstream_log, context));
     }
+    enableRequestCollapsing(context.threadLocal());
   }
 
   ShadowWriter& shadowWriter() { return *shadow_writer_; }
 
+  /**
+   * Allow requests on routes which opt in to be collapsed. @see FilterUtility::collapsingKey().
+   * @param tls supplies the slot allocator for the per worker CollapsedRequests.
+   */
+  void enableRequestCollapsing(ThreadLocal::SlotAllocator& tls) {
+    collapsed_requests_ = tls.allocateSlot();
+    collapsed_requests_->set([](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+      return std::make_shared<CollapsedRequests>();
+    });
+  }
+
+  /**
+   * @return CollapsedRequests* the requests being collapsed on this worker, or nullptr if request
+   *         collapsing isn't enabled.
+   */
+  CollapsedRequests* collapsedRequests() {
+    return collapsed_requests_ ? &collapsed_requests_->getTyped<CollapsedRequests>() : nullptr;
+  }
+
   Stats::Scope& scope_;
   const LocalInfo::LocalInfo& local_info_;
   Upstream::ClusterManager& cm_;
@@ -120,6 +201,7 @@ public:
 
 private:
   ShadowWriterPtr shadow_writer_;
+  ThreadLocal::SlotPtr collapsed_requests_;
 };
 
 typedef std::shared_ptr<FilterConfig> FilterConfigSharedPtr;
@@ -287,6 +369,13 @@ private:
   void chargeUpstreamCode(Http::Code code, Upstream::HostDescriptionConstSharedPtr upstream_host,
                           bool dropped);
   void cleanup();
+  bool collapseRequest(const Http::HeaderMap& headers, bool end_stream);
+  void encodeCollapsedHeaders(const Http::HeaderMap& headers, bool end_stream);
+  void encodeCollapsedData(const Buffer::Instance& data, bool end_stream);
+  void encodeCollapsedTrailers(const Http::HeaderMap& trailers);
+  void leaveCollapsedRequest();
+  void releaseCollapsedRequests();
+  void unregisterCollapsedRequest();
   virtual RetryStatePtr createRetryState(const RetryPolicy& policy,
                                          Http::HeaderMap& request_headers,
                                          const Upstream::ClusterInfo& cluster,
@@ -297,6 +386,9 @@ private:
   void maybeDoShadowing();
   void onRequestComplete();
   void onResponseTimeout();
+  void onHedgeTimeout();
+  bool abandonHedgedAttempt(UpstreamRequest& attempt, UpstreamResetType type);
+  void resolveHedging(UpstreamRequest& winner);
   void onUpstreamHeaders(uint64_t response_code, Http::HeaderMapPtr&& headers, bool end_stream);
   void onUpstreamData(Buffer::Instance& data, bool end_stream);
   void onUpstreamTrailers(Http::HeaderMapPtr&& trailers);
@@ -304,11 +396,13 @@ private:
   void onUpstreamReset(UpstreamResetType type,
                        const Optional<Http::StreamResetReason>& reset_reason);
   void sendNoHealthyUpstreamResponse();
+  void startCollapsedUpstreamRequest();
   bool setupRetry(bool end_stream);
   void doRetry();
   // Called immediately after a non-5xx header is received from upstream, performs stats accounting
   // and handle difference between gRPC and non-gRPC requests.
   void handleNon5xxResponseHeaders(const Http::HeaderMap& headers, bool end_stream);
+  void referenceRetainedBody(Buffer::Instance& body);
   void sendLocalReply(Http::Code code, const std::string& body, bool overloaded);
 
   FilterConfig& config_;
@@ -322,16 +416,35 @@ private:
   FilterUtility::TimeoutData timeout_;
   Http::Code timeout_response_code_ = Http::Code::GatewayTimeout;
   UpstreamRequestPtr upstream_request_;
+  // Request hedging. Once hedge_timer_ fires, hedged_request_ races upstream_request_ on another
+  // host until either of them receives response headers, and the winner becomes upstream_request_.
+  std::chrono::milliseconds hedge_delay_{0};
+  Event::TimerPtr hedge_timer_;
+  UpstreamRequestPtr hedged_request_;
   bool grpc_request_{};
+  // A shadow of the request while it streams, until the request is complete.
+  ShadowStream* shadow_stream_{};
   Http::HeaderMap* downstream_headers_{};
   Http::HeaderMap* downstream_trailers_{};
   MonotonicTime downstream_request_complete_time_;
   uint32_t buffer_limit_{0};
   bool stream_destroyed_{};
+  // The request body retained for retries, shadowing and hedging, as immutable chunks which every
+  // upstream attempt references instead of copying.
+  std::vector<std::shared_ptr<const Buffer::Instance>> retained_body_;
+  uint64_t retained_body_length_{};
+  uint64_t retry_buffer_limit_{};
+  bool request_has_body_{};
 
   // list of cookies to add to upstream headers
   std::vector<std::string> downstream_set_cookies_;
 
+  // Request collapsing. A leader is registered under collapsed_key_ until its response starts, and
+  // shares its response with collapsed_followers_. A follower waits for collapsed_leader_.
+  std::string collapsed_key_;
+  std::list<Filter*> collapsed_followers_;
+  Filter* collapsed_leader_{};
+
   bool downstream_response_started_ : 1;
   bool downstream_end_stream_ : 1;
   bool do_shadowing_ : 1;
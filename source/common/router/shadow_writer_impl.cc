@@ -4,19 +4,27 @@
 #include <string>
 
 #include "common/common/assert.h"
+#include "common/http/header_map_impl.h"
 #include "common/http/headers.h"
 
 namespace Envoy {
 namespace Router {
+namespace {
 
-void ShadowWriterImpl::shadow(const std::string& cluster, Http::MessagePtr&& request,
-                              std::chrono::milliseconds timeout) {
-  // Switch authority to add a shadow postfix. This allows upstream logging to make a more sense.
+// Switch authority to add a shadow postfix. This allows upstream logging to make a more sense.
+void addShadowPostfix(Http::HeaderMap& headers) {
   // TODO PERF: Avoid copy.
-  std::string host = request->headers().Host()->value().c_str();
+  std::string host = headers.Host()->value().c_str();
   ASSERT(!host.empty());
   host += "-shadow";
-  request->headers().Host()->value(host);
+  headers.Host()->value(host);
+}
+
+} // namespace
+
+void ShadowWriterImpl::shadow(const std::string& cluster, Http::MessagePtr&& request,
+                              std::chrono::milliseconds timeout) {
+  addShadowPostfix(request->headers());
 
   // Configuration should guarantee that cluster exists before calling here. This is basically
   // fire and forget. We don't handle cancelling.
@@ -24,5 +32,159 @@ void ShadowWriterImpl::shadow(const std::string& cluster, Http::MessagePtr&& req
                                               Optional<std::chrono::milliseconds>(timeout));
 }
 
+ShadowStream* ShadowWriterImpl::streamShadow(const std::string& cluster,
+                                             const Http::HeaderMap& headers,
+                                             std::chrono::milliseconds timeout,
+                                             uint32_t buffer_limit) {
+  Upstream::ThreadLocalCluster* thread_local_cluster = cm_.get(cluster);
+  if (thread_local_cluster == nullptr) {
+    return nullptr;
+  }
+
+  return new ShadowStreamImpl(cm_.httpAsyncClientForCluster(cluster), thread_local_cluster->info(),
+                              headers, timeout, buffer_limit);
+}
+
+ShadowStreamImpl::ShadowStreamImpl(Http::AsyncClient& client,
+                                   Upstream::ClusterInfoConstSharedPtr cluster,
+                                   const Http::HeaderMap& headers,
+                                   std::chrono::milliseconds timeout, uint32_t buffer_limit)
+    : dispatcher_(client.dispatcher()), cluster_(cluster), buffer_limit_(buffer_limit),
+      headers_(new Http::HeaderMapImpl(headers)),
+      flush_timer_(dispatcher_.createTimer([this]() -> void { flush(); })) {
+  addShadowPostfix(*headers_);
+
+  // If the stream can't be started, onReset() has already been called inline, and the stream
+  // only waits for the request to complete.
+  Http::AsyncClient::Stream* stream =
+      client.start(*this, Optional<std::chrono::milliseconds>(timeout), false);
+  if (stream != nullptr) {
+    stream_ = stream;
+    stream_->sendHeaders(*headers_, false);
+  }
+}
+
+void ShadowStreamImpl::sendData(const Buffer::Instance& data, bool end_stream) {
+  ASSERT(!request_complete_);
+  if (stream_ != nullptr) {
+    held_.add(data);
+    held_end_stream_ = end_stream;
+    if (!above_high_watermark_) {
+      flush();
+    } else if (buffer_limit_ > 0 && held_.length() > buffer_limit_) {
+      cluster_->stats().upstream_rq_shadow_overflow_.inc();
+      resetStream();
+    }
+  }
+
+  if (end_stream) {
+    onRequestComplete();
+  }
+}
+
+void ShadowStreamImpl::sendTrailers(const Http::HeaderMap& trailers) {
+  ASSERT(!request_complete_);
+  if (stream_ != nullptr) {
+    trailers_.reset(new Http::HeaderMapImpl(trailers));
+    if (!above_high_watermark_) {
+      flush();
+    }
+  }
+
+  onRequestComplete();
+}
+
+void ShadowStreamImpl::reset() {
+  ASSERT(!request_complete_);
+  resetStream();
+  onRequestComplete();
+}
+
+void ShadowStreamImpl::onHeaders(Http::HeaderMapPtr&&, bool end_stream) {
+  if (end_stream) {
+    onResponseComplete();
+  }
+}
+
+void ShadowStreamImpl::onData(Buffer::Instance&, bool end_stream) {
+  if (end_stream) {
+    onResponseComplete();
+  }
+}
+
+void ShadowStreamImpl::onReset() {
+  stream_ = nullptr;
+  held_.drain(held_.length());
+  maybeDelete();
+}
+
+void ShadowStreamImpl::onBelowWriteBufferLowWatermark() {
+  above_high_watermark_ = false;
+  flush_timer_->enableTimer(std::chrono::milliseconds(0));
+}
+
+void ShadowStreamImpl::flush() {
+  if (stream_ == nullptr) {
+    return;
+  }
+
+  // The shadow upstream has already responded, so the rest of the request is of no use to it.
+  if (response_complete_) {
+    resetStream();
+    return;
+  }
+
+  if (above_high_watermark_) {
+    return;
+  }
+
+  if (held_.length() > 0 || held_end_stream_) {
+    // Mark the end of the request before sending it, in case the response completes inline.
+    local_end_sent_ = held_end_stream_;
+    held_end_stream_ = false;
+    stream_->sendData(held_, local_end_sent_);
+    held_.drain(held_.length());
+  }
+
+  if (stream_ != nullptr && trailers_ && !local_end_sent_) {
+    local_end_sent_ = true;
+    stream_->sendTrailers(*trailers_);
+  }
+}
+
+void ShadowStreamImpl::maybeDelete() {
+  if (request_complete_ && stream_ == nullptr && !deleted_) {
+    deleted_ = true;
+    flush_timer_->disableTimer();
+    dispatcher_.deferredDelete(Event::DeferredDeletablePtr{this});
+  }
+}
+
+void ShadowStreamImpl::onRequestComplete() {
+  request_complete_ = true;
+  maybeDelete();
+}
+
+void ShadowStreamImpl::onResponseComplete() {
+  response_complete_ = true;
+  // Once both directions are complete, the async client cleans up the stream. Otherwise the
+  // stream is reset, outside of its callbacks.
+  if (local_end_sent_) {
+    stream_ = nullptr;
+    maybeDelete();
+  } else {
+    flush_timer_->enableTimer(std::chrono::milliseconds(0));
+  }
+}
+
+void ShadowStreamImpl::resetStream() {
+  if (stream_ != nullptr) {
+    Http::AsyncClient::Stream* stream = stream_;
+    stream_ = nullptr;
+    held_.drain(held_.length());
+    stream->reset();
+  }
+}
+
 } // namespace Router
 } // namespace Envoy
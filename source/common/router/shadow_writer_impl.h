@@ -1,11 +1,17 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 #include <string>
 
+#include "envoy/event/deferred_deletable.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
 #include "envoy/router/shadow_writer.h"
 #include "envoy/upstream/cluster_manager.h"
 
+#include "common/buffer/buffer_impl.h"
+
 namespace Envoy {
 namespace Router {
 
@@ -20,6 +26,8 @@ public:
   // Router::ShadowWriter
   void shadow(const std::string& cluster, Http::MessagePtr&& request,
               std::chrono::milliseconds timeout) override;
+  ShadowStream* streamShadow(const std::string& cluster, const Http::HeaderMap& headers,
+                             std::chrono::milliseconds timeout, uint32_t buffer_limit) override;
 
   // Http::AsyncClient::Callbacks
   void onSuccess(Http::MessagePtr&&) override {}
@@ -29,5 +37,57 @@ private:
   Upstream::ClusterManager& cm_;
 };
 
+/**
+ * A shadow of a streaming request over an async client stream. Body data is sent on as it arrives,
+ * and held while the shadow upstream is backed up. A shadow which holds more than its buffer limit
+ * is reset, which never affects the primary request. The stream deletes itself once the request
+ * has been ended or reset by the caller and the async client stream is done with.
+ */
+class ShadowStreamImpl : public ShadowStream,
+                         public Http::AsyncClient::StreamCallbacks,
+                         public Event::DeferredDeletable {
+public:
+  ShadowStreamImpl(Http::AsyncClient& client, Upstream::ClusterInfoConstSharedPtr cluster,
+                   const Http::HeaderMap& headers, std::chrono::milliseconds timeout,
+                   uint32_t buffer_limit);
+
+  // Router::ShadowStream
+  void sendData(const Buffer::Instance& data, bool end_stream) override;
+  void sendTrailers(const Http::HeaderMap& trailers) override;
+  void reset() override;
+
+  // Http::AsyncClient::StreamCallbacks
+  void onHeaders(Http::HeaderMapPtr&&, bool end_stream) override;
+  void onData(Buffer::Instance&, bool end_stream) override;
+  void onTrailers(Http::HeaderMapPtr&&) override { onResponseComplete(); }
+  void onReset() override;
+  void onAboveWriteBufferHighWatermark() override { above_high_watermark_ = true; }
+  void onBelowWriteBufferLowWatermark() override;
+
+private:
+  void flush();
+  void maybeDelete();
+  void onRequestComplete();
+  void onResponseComplete();
+  void resetStream();
+
+  Event::Dispatcher& dispatcher_;
+  const Upstream::ClusterInfoConstSharedPtr cluster_;
+  const uint32_t buffer_limit_;
+  // The async client stream keeps references to the headers and trailers it is sent.
+  const Http::HeaderMapPtr headers_;
+  Http::HeaderMapPtr trailers_;
+  Http::AsyncClient::Stream* stream_{};
+  Buffer::OwnedImpl held_;
+  // Flushes held data once the shadow upstream drains, outside of the stream's own callbacks.
+  Event::TimerPtr flush_timer_;
+  bool held_end_stream_{};
+  bool local_end_sent_{};
+  bool response_complete_{};
+  bool above_high_watermark_{};
+  bool request_complete_{};
+  bool deleted_{};
+};
+
 } // namespace Router
 } // namespace Envoy
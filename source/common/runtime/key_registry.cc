@@ -0,0 +1,23 @@
+#include "common/runtime/key_registry.h"
+
+#include <mutex>
+#include <string>
+
+namespace Envoy {
+namespace Runtime {
+
+Key KeyRegistry::registerKey(const std::string& name) {
+  Keys& registry = keys();
+  std::unique_lock<std::mutex> lock(registry.lock_);
+  auto result = registry.indices_.emplace(name, registry.indices_.size());
+  return Key(name, result.first->second);
+}
+
+KeyRegistry::Keys& KeyRegistry::keys() {
+  // Keys are registered during static initialization, so the registry is built on first use.
+  static Keys* registry = new Keys();
+  return *registry;
+}
+
+} // namespace Runtime
+} // namespace Envoy
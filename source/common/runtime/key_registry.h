@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "envoy/runtime/runtime.h"
+
+namespace Envoy {
+namespace Runtime {
+
+/**
+ * Process wide registry of the indices of runtime keys. Snapshots register every key they load,
+ * so a key which code registers after a snapshot is loaded is simply absent from that snapshot.
+ */
+class KeyRegistry {
+public:
+  /**
+   * @return Key the key with the given name. Registering the same name again returns the same
+   *         index.
+   */
+  static Key registerKey(const std::string& name);
+
+private:
+  struct Keys {
+    std::mutex lock_;
+    std::unordered_map<std::string, uint32_t> indices_;
+  };
+
+  static Keys& keys();
+};
+
+} // namespace Runtime
+} // namespace Envoy
@@ -21,7 +21,7 @@
 namespace Envoy {
 namespace Runtime {
 
-const size_t RandomGeneratorImpl::UUID_LENGTH = 36;
+const size_t RandomGenerator::UUID_LENGTH;
 
 uint64_t RandomGeneratorImpl::random() {
   // Prefetch 256 * sizeof(uint64_t) bytes of randomness. buffered_idx is initialized to 256,
@@ -62,6 +62,12 @@ uint64_t RandomGeneratorImpl::random() {
 }
 
 std::string RandomGeneratorImpl::uuid() {
+  char buffer[UUID_LENGTH];
+  uuid(buffer);
+  return std::string(buffer, UUID_LENGTH);
+}
+
+void RandomGeneratorImpl::uuid(char* uuid) {
   // Prefetch 2048 bytes of randomness. buffered_idx is initialized to sizeof(buffered),
   // i.e. out-of-range value, so the buffer will be filled with randomness on the first
   // call to this function.
@@ -104,7 +110,6 @@ std::string RandomGeneratorImpl::uuid() {
 
   // Convert UUID to a string representation, e.g. a121e9e1-feae-4136-9e0e-6fac343d56c9.
   static const char* const hex = "0123456789abcdef";
-  char uuid[UUID_LENGTH];
 
   for (uint8_t i = 0; i < 4; i++) {
     const uint8_t d = rand[i];
@@ -143,18 +148,18 @@ std::string RandomGeneratorImpl::uuid() {
     uuid[2 * i + 4] = hex[d >> 4];
     uuid[2 * i + 5] = hex[d & 0x0f];
   }
-
-  return std::string(uuid, UUID_LENGTH);
 }
 
 SnapshotImpl::SnapshotImpl(const std::string& root_path, const std::string& override_path,
                            RuntimeStats& stats, RandomGenerator& generator,
-                           Api::OsSysCalls& os_sys_calls)
-    : generator_(generator), os_sys_calls_(os_sys_calls) {
+                           Api::OsSysCalls& os_sys_calls, uint64_t version,
+                           const SnapshotImpl* previous)
+    : generator_(generator), os_sys_calls_(os_sys_calls), version_(version),
+      loaded_at_(time(nullptr)) {
   try {
-    walkDirectory(root_path, "");
+    walkDirectory(root_path, "", previous, stats);
     if (Filesystem::directoryExists(override_path)) {
-      walkDirectory(override_path, "");
+      walkDirectory(override_path, "", previous, stats);
       stats.override_dir_exists_.inc();
     } else {
       stats.override_dir_not_exists_.inc();
@@ -166,6 +171,14 @@ SnapshotImpl::SnapshotImpl(const std::string& root_path, const std::string& over
     ENVOY_LOG(debug, "error creating runtime snapshot: {}", e.what());
   }
 
+  for (const auto& value : values_) {
+    const uint32_t index = KeyRegistry::registerKey(value.first).index();
+    if (index >= entries_.size()) {
+      entries_.resize(index + 1);
+    }
+    entries_[index] = value.second.get();
+  }
+
   stats.num_keys_.set(values_.size());
 }
 
@@ -174,20 +187,40 @@ const std::string& SnapshotImpl::get(const std::string& key) const {
   if (entry == values_.end()) {
     return EMPTY_STRING;
   } else {
-    return entry->second.string_value_;
+    return entry->second->string_value_;
   }
 }
 
 uint64_t SnapshotImpl::getInteger(const std::string& key, uint64_t default_value) const {
   auto entry = values_.find(key);
-  if (entry == values_.end() || !entry->second.uint_value_.valid()) {
+  if (entry == values_.end() || !entry->second->uint_value_.valid()) {
     return default_value;
   } else {
-    return entry->second.uint_value_.value();
+    return entry->second->uint_value_.value();
   }
 }
 
-void SnapshotImpl::walkDirectory(const std::string& path, const std::string& prefix) {
+SnapshotImpl::EntryConstSharedPtr
+SnapshotImpl::unchangedEntry(const std::string& key, const struct stat& stat_result) const {
+  auto entry = values_.find(key);
+  if (entry == values_.end()) {
+    return nullptr;
+  }
+
+  // A file rewritten in the second this snapshot was loaded could keep its modification time, so
+  // only older files are trusted to be unchanged.
+  const Entry& previous = *entry->second;
+  if (previous.device_ != stat_result.st_dev || previous.inode_ != stat_result.st_ino ||
+      previous.size_ != stat_result.st_size || previous.modified_ != stat_result.st_mtime ||
+      stat_result.st_mtime >= loaded_at_) {
+    return nullptr;
+  }
+
+  return entry->second;
+}
+
+void SnapshotImpl::walkDirectory(const std::string& path, const std::string& prefix,
+                                 const SnapshotImpl* previous, RuntimeStats& stats) {
   ENVOY_LOG(debug, "walking directory: {}", path);
   Directory current_dir(path);
   while (true) {
@@ -217,8 +250,16 @@ void SnapshotImpl::walkDirectory(const std::string& path, const std::string& pre
 
     if (S_ISDIR(stat_result.st_mode) && std::string(entry->d_name) != "." &&
         std::string(entry->d_name) != "..") {
-      walkDirectory(full_path, full_prefix);
+      walkDirectory(full_path, full_prefix, previous, stats);
     } else if (S_ISREG(stat_result.st_mode)) {
+      EntryConstSharedPtr unchanged =
+          previous != nullptr ? previous->unchangedEntry(full_prefix, stat_result) : nullptr;
+      if (unchanged != nullptr) {
+        stats.files_reused_.inc();
+        values_[full_prefix] = unchanged;
+        continue;
+      }
+
       // Suck the file into a string. This is not very efficient but it should be good enough
       // for small files. Also, as noted elsewhere, none of this is non-blocking which could
       // theoretically lead to issues.
@@ -244,23 +285,31 @@ void SnapshotImpl::walkDirectory(const std::string& path, const std::string& pre
         entry.uint_value_.value(converted);
       }
 
-      values_[full_prefix] = entry;
+      entry.device_ = stat_result.st_dev;
+      entry.inode_ = stat_result.st_ino;
+      entry.size_ = stat_result.st_size;
+      entry.modified_ = stat_result.st_mtime;
+      stats.files_read_.inc();
+      values_[full_prefix] = std::make_shared<const Entry>(std::move(entry));
     }
   }
 }
 
 LoaderImpl::LoaderImpl(Event::Dispatcher& dispatcher, ThreadLocal::SlotAllocator& tls,
-                       const std::string& root_symlink_path, const std::string& subdir,
-                       const std::string& override_dir, Stats::Store& store,
-                       RandomGenerator& generator, Api::OsSysCallsPtr os_sys_calls)
-    : watcher_(dispatcher.createFilesystemWatcher()), tls_(tls.allocateSlot()),
-      generator_(generator), root_path_(root_symlink_path + "/" + subdir),
+                       Api::Api& api, const std::string& root_symlink_path,
+                       const std::string& subdir, const std::string& override_dir,
+                       Stats::Store& store, RandomGenerator& generator,
+                       Api::OsSysCallsPtr os_sys_calls)
+    : dispatcher_(dispatcher), api_(api), watcher_(dispatcher.createFilesystemWatcher()),
+      tls_(tls.allocateSlot()), generator_(generator),
+      root_path_(root_symlink_path + "/" + subdir),
       override_path_(root_symlink_path + "/" + override_dir), stats_(generateStats(store)),
       os_sys_calls_(std::move(os_sys_calls)) {
   watcher_->addWatch(root_symlink_path, Filesystem::Watcher::Events::MovedTo,
                      [this](uint32_t) -> void { onSymlinkSwap(); });
 
-  onSymlinkSwap();
+  // The first snapshot is needed right away, so it is loaded inline.
+  setSnapshot(loadSnapshot(++snapshot_version_, nullptr));
 }
 
 RuntimeStats LoaderImpl::generateStats(Stats::Store& store) {
@@ -270,9 +319,34 @@ RuntimeStats LoaderImpl::generateStats(Stats::Store& store) {
   return stats;
 }
 
+std::shared_ptr<SnapshotImpl> LoaderImpl::loadSnapshot(uint64_t version,
+                                                       const SnapshotImpl* previous) {
+  return std::make_shared<SnapshotImpl>(root_path_, override_path_, stats_, generator_,
+                                        *os_sys_calls_, version, previous);
+}
+
 void LoaderImpl::onSymlinkSwap() {
-  current_snapshot_.reset(
-      new SnapshotImpl(root_path_, override_path_, stats_, generator_, *os_sys_calls_));
+  // Walking the runtime tree reads many files, so it is done on the thread pool rather than on the
+  // main thread. Loads can complete out of order, and only the latest one is kept. Snapshots are
+  // immutable, so the load can share the unchanged entries of the current one.
+  const uint64_t version = ++snapshot_version_;
+  std::shared_ptr<std::shared_ptr<SnapshotImpl>> snapshot =
+      std::make_shared<std::shared_ptr<SnapshotImpl>>();
+  std::shared_ptr<SnapshotImpl> previous = current_snapshot_;
+  api_.runOnThreadPool(
+      [this, version, snapshot, previous]() -> void {
+        *snapshot = loadSnapshot(version, previous.get());
+      },
+      dispatcher_,
+      [this, snapshot]() -> void {
+        if ((*snapshot)->version() > current_snapshot_->version()) {
+          setSnapshot(*snapshot);
+        }
+      });
+}
+
+void LoaderImpl::setSnapshot(std::shared_ptr<SnapshotImpl> snapshot) {
+  current_snapshot_ = std::move(snapshot);
   ThreadLocal::ThreadLocalObjectSharedPtr ptr_copy = current_snapshot_;
   tls_->set([ptr_copy](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
     return ptr_copy;
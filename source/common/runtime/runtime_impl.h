@@ -3,10 +3,13 @@
 #include <dirent.h>
 
 #include <cstdint>
+#include <ctime>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
+#include "envoy/api/api.h"
 #include "envoy/api/os_sys_calls.h"
 #include "envoy/common/exception.h"
 #include "envoy/common/optional.h"
@@ -17,6 +20,7 @@
 #include "common/common/empty_string.h"
 #include "common/common/logger.h"
 #include "common/common/thread.h"
+#include "common/runtime/key_registry.h"
 
 #include "spdlog/spdlog.h"
 
@@ -32,8 +36,7 @@ public:
   // Runtime::RandomGenerator
   uint64_t random() override;
   std::string uuid() override;
-
-  static const size_t UUID_LENGTH;
+  void uuid(char* buffer) override;
 };
 
 /**
@@ -45,6 +48,8 @@ public:
   COUNTER(override_dir_not_exists)                                                                 \
   COUNTER(override_dir_exists)                                                                     \
   COUNTER(load_success)                                                                            \
+  COUNTER(files_read)                                                                              \
+  COUNTER(files_reused)                                                                            \
   GAUGE  (num_keys)
 // clang-format on
 
@@ -56,32 +61,25 @@ struct RuntimeStats {
 };
 
 /**
- * Implementation of Snapshot that reads from disk.
+ * Implementation of Snapshot that reads from disk. A snapshot loaded after another one shares the
+ * entries of the files which have not changed since, rather than reading them again.
  */
 class SnapshotImpl : public Snapshot,
                      public ThreadLocal::ThreadLocalObject,
                      Logger::Loggable<Logger::Id::runtime> {
 public:
   SnapshotImpl(const std::string& root_path, const std::string& override_path, RuntimeStats& stats,
-               RandomGenerator& generator, Api::OsSysCalls& os_sys_calls);
+               RandomGenerator& generator, Api::OsSysCalls& os_sys_calls, uint64_t version,
+               const SnapshotImpl* previous);
 
   // Runtime::Snapshot
   bool featureEnabled(const std::string& key, uint64_t default_value, uint64_t random_value,
                       uint16_t num_buckets) const override {
-    return random_value % static_cast<uint64_t>(num_buckets) <
-           std::min(getInteger(key, default_value), static_cast<uint64_t>(num_buckets));
+    return enabled(getInteger(key, default_value), random_value, num_buckets);
   }
 
   bool featureEnabled(const std::string& key, uint64_t default_value) const override {
-    // Avoid PNRG if we know we don't need it.
-    uint64_t cutoff = std::min(getInteger(key, default_value), static_cast<uint64_t>(100));
-    if (cutoff == 0) {
-      return false;
-    } else if (cutoff == 100) {
-      return true;
-    } else {
-      return generator_.random() % 100 < cutoff;
-    }
+    return enabled(getInteger(key, default_value));
   }
 
   bool featureEnabled(const std::string& key, uint64_t default_value,
@@ -92,6 +90,28 @@ public:
   const std::string& get(const std::string& key) const override;
   uint64_t getInteger(const std::string&, uint64_t default_value) const override;
 
+  bool featureEnabled(const Key& key, uint64_t default_value) const override {
+    return enabled(getInteger(key, default_value));
+  }
+
+  bool featureEnabled(const Key& key, uint64_t default_value,
+                      uint64_t random_value) const override {
+    return featureEnabled(key, default_value, random_value, 100);
+  }
+
+  bool featureEnabled(const Key& key, uint64_t default_value, uint64_t random_value,
+                      uint16_t num_buckets) const override {
+    return enabled(getInteger(key, default_value), random_value, num_buckets);
+  }
+
+  uint64_t getInteger(const Key& key, uint64_t default_value) const override {
+    const Entry* entry = key.index() < entries_.size() ? entries_[key.index()] : nullptr;
+    return entry == nullptr || !entry->uint_value_.valid() ? default_value
+                                                           : entry->uint_value_.value();
+  }
+
+  uint64_t version() const override { return version_; }
+
 private:
   struct Directory {
     Directory(const std::string& path) {
@@ -109,13 +129,50 @@ private:
   struct Entry {
     std::string string_value_;
     Optional<uint64_t> uint_value_;
+    // Identity of the file the entry was read from, which tells later snapshots if it changed.
+    dev_t device_{};
+    ino_t inode_{};
+    off_t size_{};
+    time_t modified_{};
   };
 
-  void walkDirectory(const std::string& path, const std::string& prefix);
+  typedef std::shared_ptr<const Entry> EntryConstSharedPtr;
 
-  std::unordered_map<std::string, Entry> values_;
+  /**
+   * @return EntryConstSharedPtr the entry of the previous snapshot for a file, if the file has
+   *         not changed since the previous snapshot was loaded, or nullptr.
+   */
+  EntryConstSharedPtr unchangedEntry(const std::string& key, const struct stat& stat_result) const;
+
+  static bool enabled(uint64_t value, uint64_t random_value, uint16_t num_buckets) {
+    return random_value % static_cast<uint64_t>(num_buckets) <
+           std::min(value, static_cast<uint64_t>(num_buckets));
+  }
+
+  bool enabled(uint64_t value) const {
+    // Avoid PNRG if we know we don't need it.
+    uint64_t cutoff = std::min(value, static_cast<uint64_t>(100));
+    if (cutoff == 0) {
+      return false;
+    } else if (cutoff == 100) {
+      return true;
+    } else {
+      return generator_.random() % 100 < cutoff;
+    }
+  }
+
+  void walkDirectory(const std::string& path, const std::string& prefix,
+                     const SnapshotImpl* previous, RuntimeStats& stats);
+
+  std::unordered_map<std::string, EntryConstSharedPtr> values_;
+  // The entries of values_ by the index of their key, or nullptr for the keys not in values_.
+  std::vector<const Entry*> entries_;
   RandomGenerator& generator_;
   Api::OsSysCalls& os_sys_calls_;
+  const uint64_t version_;
+  // Wall clock second at which loading started. Files modified during or after that second may
+  // have changed without their modification time saying so.
+  const time_t loaded_at_;
 };
 
 /**
@@ -126,7 +183,7 @@ private:
  */
 class LoaderImpl : public Loader {
 public:
-  LoaderImpl(Event::Dispatcher& dispatcher, ThreadLocal::SlotAllocator& tls,
+  LoaderImpl(Event::Dispatcher& dispatcher, ThreadLocal::SlotAllocator& tls, Api::Api& api,
              const std::string& root_symlink_path, const std::string& subdir,
              const std::string& override_dir, Stats::Store& store, RandomGenerator& generator,
              Api::OsSysCallsPtr os_sys_calls);
@@ -136,14 +193,19 @@ public:
 
 private:
   RuntimeStats generateStats(Stats::Store& store);
+  std::shared_ptr<SnapshotImpl> loadSnapshot(uint64_t version, const SnapshotImpl* previous);
   void onSymlinkSwap();
+  void setSnapshot(std::shared_ptr<SnapshotImpl> snapshot);
 
+  Event::Dispatcher& dispatcher_;
+  Api::Api& api_;
   Filesystem::WatcherPtr watcher_;
   ThreadLocal::SlotPtr tls_;
   RandomGenerator& generator_;
   std::string root_path_;
   std::string override_path_;
   std::shared_ptr<SnapshotImpl> current_snapshot_;
+  uint64_t snapshot_version_{};
   RuntimeStats stats_;
   Api::OsSysCallsPtr os_sys_calls_;
 };
@@ -190,6 +252,26 @@ private:
       return default_value;
     }
 
+    bool featureEnabled(const Key& key, uint64_t default_value) const override {
+      return featureEnabled(key.name(), default_value);
+    }
+
+    bool featureEnabled(const Key& key, uint64_t default_value,
+                        uint64_t random_value) const override {
+      return featureEnabled(key.name(), default_value, random_value);
+    }
+
+    bool featureEnabled(const Key& key, uint64_t default_value, uint64_t random_value,
+                        uint16_t num_buckets) const override {
+      return featureEnabled(key.name(), default_value, random_value, num_buckets);
+    }
+
+    uint64_t getInteger(const Key&, uint64_t default_value) const override {
+      return default_value;
+    }
+
+    uint64_t version() const override { return 0; }
+
     RandomGenerator& generator_;
   };
 
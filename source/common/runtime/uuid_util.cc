@@ -3,26 +3,38 @@
 #include <cstdint>
 #include <string>
 
-#include "common/common/utility.h"
 #include "common/runtime/runtime_impl.h"
 
 namespace Envoy {
-bool UuidUtils::uuidModBy(const std::string& uuid, uint16_t& out, uint16_t mod) {
-  if (uuid.length() < 8) {
+bool UuidUtils::uuidModBy(const char* uuid, size_t length, uint16_t& out, uint16_t mod) {
+  if (length < 8) {
     return false;
   }
 
-  uint64_t value;
-  if (!StringUtil::atoul(uuid.substr(0, 8).c_str(), value, 16)) {
-    return false;
+  // The first 8 characters are hex digits, which are decoded in place rather than through a
+  // substring, since this runs for every request when tracing or access log sampling is on.
+  uint32_t value = 0;
+  for (size_t i = 0; i < 8; i++) {
+    const char c = uuid[i];
+    uint32_t digit;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      digit = c - 'A' + 10;
+    } else {
+      return false;
+    }
+    value = (value << 4) | digit;
   }
 
   out = value % mod;
   return true;
 }
 
-UuidTraceStatus UuidUtils::isTraceableUuid(const std::string& uuid) {
-  if (uuid.length() != Runtime::RandomGeneratorImpl::UUID_LENGTH) {
+UuidTraceStatus UuidUtils::isTraceableUuid(const char* uuid, size_t length) {
+  if (length != Runtime::RandomGeneratorImpl::UUID_LENGTH) {
     return UuidTraceStatus::NoTrace;
   }
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace Envoy {
@@ -16,7 +18,17 @@ public:
    * @param out will contain the result of the operation.
    * @param mod modulo used in the operation.
    */
-  static bool uuidModBy(const std::string& uuid, uint16_t& out, uint16_t mod);
+  static bool uuidModBy(const std::string& uuid, uint16_t& out, uint16_t mod) {
+    return uuidModBy(uuid.c_str(), uuid.size(), out, mod);
+  }
+
+  /**
+   * Same as above, for a uuid which is not held in a std::string (e.g. a header value), so that
+   * no copy is made.
+   * @param uuid points to the characters of the uuid4.
+   * @param length number of characters of the uuid.
+   */
+  static bool uuidModBy(const char* uuid, size_t length, uint16_t& out, uint16_t mod);
 
   /**
    * Modify uuid in a way it can be detected if uuid is traceable or not.
@@ -29,7 +41,16 @@ public:
   /**
    * @return status of the uuid, to differentiate reason for tracing, etc.
    */
-  static UuidTraceStatus isTraceableUuid(const std::string& uuid);
+  static UuidTraceStatus isTraceableUuid(const std::string& uuid) {
+    return isTraceableUuid(uuid.c_str(), uuid.size());
+  }
+
+  /**
+   * Same as above, for a uuid which is not held in a std::string.
+   * @param uuid points to the characters of the uuid4.
+   * @param length number of characters of the uuid.
+   */
+  static UuidTraceStatus isTraceableUuid(const char* uuid, size_t length);
 
 private:
   // Byte on this position has predefined value of 4 for UUID4.
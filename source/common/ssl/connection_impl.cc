@@ -1,22 +1,75 @@
 #include "common/ssl/connection_impl.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <vector>
 
 #include "common/common/assert.h"
 #include "common/common/empty_string.h"
 #include "common/common/hex.h"
+#include "common/common/utility.h"
 #include "common/network/utility.h"
 
 #include "openssl/err.h"
+#include "openssl/mem.h"
 #include "openssl/x509v3.h"
 
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/tls.h>)
+#include <linux/tls.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#define ENVOY_KERNEL_TLS
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#endif
+#endif
+
 using Envoy::Network::PostIoAction;
 
 namespace Envoy {
 namespace Ssl {
 
+constexpr std::chrono::milliseconds SslSocket::RECORD_SIZE_IDLE_TIMEOUT;
+bool SslSocket::kernel_tls_ = false;
+
+namespace {
+
+#ifdef ENVOY_KERNEL_TLS
+// Hand the write key of a TLS 1.2 AES-GCM connection to the kernel.
+template <class CryptoInfo>
+bool setKernelTlsTx(int fd, uint16_t cipher_type, const uint8_t* key, const uint8_t* salt,
+                    uint64_t sequence) {
+  CryptoInfo info;
+  memset(&info, 0, sizeof(info));
+  info.info.version = TLS_1_2_VERSION;
+  info.info.cipher_type = cipher_type;
+  memcpy(info.key, key, sizeof(info.key));
+  memcpy(info.salt, salt, sizeof(info.salt));
+  // Both the record sequence number and the explicit nonce carry on from BoringSSL's sequence
+  // number, as BoringSSL also uses the sequence number as the explicit nonce.
+  static_assert(sizeof(info.rec_seq) == sizeof(sequence) && sizeof(info.iv) == sizeof(sequence),
+                "unexpected kernel TLS sequence size");
+  for (size_t i = 0; i < sizeof(sequence); i++) {
+    info.rec_seq[i] = info.iv[i] = static_cast<uint8_t>(sequence >> (8 * (7 - i)));
+  }
+
+  const int rc = setsockopt(fd, SOL_TLS, TLS_TX, &info, sizeof(info));
+  OPENSSL_cleanse(&info, sizeof(info));
+  return rc == 0;
+}
+#endif
+
+} // namespace
+
 SslSocket::SslSocket(Context& ctx, InitialState state)
     : ctx_(dynamic_cast<Ssl::ContextImpl&>(ctx)), ssl_(ctx_.newSsl()) {
   SSL_set_mode(ssl_.get(), SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
@@ -28,12 +81,21 @@ SslSocket::SslSocket(Context& ctx, InitialState state)
   }
 }
 
+void SslSocket::resumeSession(const std::string& session_key) {
+  dynamic_cast<ClientContextImpl&>(ctx_).resumeSession(ssl_.get(), session_key);
+}
+
 void SslSocket::setTransportSocketCallbacks(Network::TransportSocketCallbacks& callbacks) {
   ASSERT(!callbacks_);
   callbacks_ = &callbacks;
 
   BIO* bio = BIO_new_socket(callbacks_->fd(), 0);
   SSL_set_bio(ssl_.get(), bio, bio);
+
+  // The handshake is resumed from the read path once an offloaded private key operation completes.
+  private_key_operation_state_.reset(new PrivateKeyOperationState(
+      callbacks_->connection().dispatcher(), [this]() -> void { callbacks_->setReadBufferReady(); }));
+  private_key_operation_state_->attach(ssl_.get());
 }
 
 ConnectionImpl::ConnectionImpl(Event::DispatcherImpl& dispatcher, int fd,
@@ -57,27 +119,36 @@ Network::IoResult SslSocket::doRead(Buffer::Instance& read_buffer) {
   if (!handshake_complete_) {
     PostIoAction action = doHandshake();
     if (action == PostIoAction::Close || !handshake_complete_) {
-      return {action, 0};
+      return {action, 0, 0};
     }
   }
 
   bool keep_reading = true;
   PostIoAction action = PostIoAction::KeepOpen;
   uint64_t bytes_read = 0;
+  last_read_early_data_ = false;
   while (keep_reading) {
     // We use 2 slices here so that we can use the remainder of an existing buffer chain element
-    // if there is extra space. 16K read is arbitrary and can be tuned later.
+    // if there is extra space. Records are decrypted straight into the reserved space.
     Buffer::RawSlice slices[2];
     uint64_t slices_to_commit = 0;
-    uint64_t num_slices = read_buffer.reserve(16384, slices, 2);
-    for (uint64_t i = 0; i < num_slices; i++) {
-      int rc = SSL_read(ssl_.get(), slices[i].mem_, slices[i].len_);
-      ENVOY_CONN_LOG(trace, "ssl read returns: {}", callbacks_->connection(), rc);
-      if (rc > 0) {
-        slices[i].len_ = rc;
-        slices_to_commit++;
-        bytes_read += rc;
-      } else {
+    uint64_t num_slices = read_buffer.reserve(READ_RESERVATION_SIZE, slices, 2);
+    for (uint64_t i = 0; i < num_slices && keep_reading; i++) {
+      // SSL_read() returns at most one record, so keep reading into the slice until it is full.
+      // Small records would otherwise each take a slice of their own.
+      uint8_t* mem = static_cast<uint8_t*>(slices[i].mem_);
+      uint64_t slice_bytes_read = 0;
+      while (slice_bytes_read < slices[i].len_) {
+        const bool early_data = SSL_in_early_data(ssl_.get());
+        int rc = SSL_read(ssl_.get(), mem + slice_bytes_read, slices[i].len_ - slice_bytes_read);
+        ENVOY_CONN_LOG(trace, "ssl read returns: {}", callbacks_->connection(), rc);
+        if (rc > 0) {
+          last_read_early_data_ |= early_data;
+          slice_bytes_read += rc;
+          bytes_read += rc;
+          continue;
+        }
+
         keep_reading = false;
         int err = SSL_get_error(ssl_.get(), rc);
         switch (err) {
@@ -93,6 +164,11 @@ Network::IoResult SslSocket::doRead(Buffer::Instance& read_buffer) {
 
         break;
       }
+
+      if (slice_bytes_read > 0) {
+        slices[i].len_ = slice_bytes_read;
+        slices_to_commit++;
+      }
     }
 
     if (slices_to_commit > 0) {
@@ -104,7 +180,7 @@ Network::IoResult SslSocket::doRead(Buffer::Instance& read_buffer) {
     }
   }
 
-  return {action, bytes_read};
+  return {action, bytes_read, 0};
 }
 
 PostIoAction SslSocket::doHandshake() {
@@ -113,7 +189,14 @@ PostIoAction SslSocket::doHandshake() {
   if (rc == 1) {
     ENVOY_CONN_LOG(debug, "handshake complete", callbacks_->connection());
     handshake_complete_ = true;
+    cacheCertificateInfo();
     ctx_.logHandshake(ssl_.get());
+    // Connections reading early data keep writing through BoringSSL, since their handshake hasn't
+    // really completed yet.
+    if (kernel_tls_ && !SSL_in_early_data(ssl_.get()) && enableKernelTlsTx()) {
+      ENVOY_CONN_LOG(debug, "kernel TLS enabled for writes", callbacks_->connection());
+      ctx_.stats().kernel_tls_tx_.inc();
+    }
     callbacks_->raiseEvent(Network::ConnectionEvent::Connected);
 
     // It's possible that we closed during the handshake callback.
@@ -126,6 +209,7 @@ PostIoAction SslSocket::doHandshake() {
     switch (err) {
     case SSL_ERROR_WANT_READ:
     case SSL_ERROR_WANT_WRITE:
+    case SSL_ERROR_WANT_PRIVATE_KEY_OPERATION:
       return PostIoAction::KeepOpen;
     default:
       drainErrorQueue();
@@ -134,6 +218,80 @@ PostIoAction SslSocket::doHandshake() {
   }
 }
 
+bool SslSocket::enableKernelTlsTx() {
+#ifdef ENVOY_KERNEL_TLS
+  // The kernel only takes over the record layer, so only TLS 1.2 AES-GCM, whose records carry no
+  // further state, is handed over. Everything else keeps using BoringSSL.
+  const SSL_CIPHER* cipher = SSL_get_current_cipher(ssl_.get());
+  if (SSL_version(ssl_.get()) != TLS1_2_VERSION || cipher == nullptr ||
+      !SSL_CIPHER_is_AESGCM(cipher)) {
+    return false;
+  }
+
+  const size_t key_len = SSL_CIPHER_get_bits(cipher, nullptr) / 8;
+  const size_t salt_len = 4;
+  std::vector<uint8_t> key_block(SSL_get_key_block_len(ssl_.get()));
+  // AEAD key blocks are the client and server keys followed by the client and server salts.
+  if (key_block.size() != 2 * (key_len + salt_len) ||
+      !SSL_generate_key_block(ssl_.get(), key_block.data(), key_block.size())) {
+    drainErrorQueue();
+    return false;
+  }
+
+  const bool server = SSL_is_server(ssl_.get());
+  const uint8_t* key = key_block.data() + (server ? key_len : 0);
+  const uint8_t* salt = key_block.data() + 2 * key_len + (server ? salt_len : 0);
+  const int fd = callbacks_->fd();
+  bool enabled = false;
+  // The handshake has been flushed, so BoringSSL has no records waiting to be written.
+  if (setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) == 0) {
+    if (key_len == TLS_CIPHER_AES_GCM_128_KEY_SIZE) {
+      enabled = setKernelTlsTx<tls12_crypto_info_aes_gcm_128>(
+          fd, TLS_CIPHER_AES_GCM_128, key, salt, SSL_get_write_sequence(ssl_.get()));
+#ifdef TLS_CIPHER_AES_GCM_256
+    } else if (key_len == TLS_CIPHER_AES_GCM_256_KEY_SIZE) {
+      enabled = setKernelTlsTx<tls12_crypto_info_aes_gcm_256>(
+          fd, TLS_CIPHER_AES_GCM_256, key, salt, SSL_get_write_sequence(ssl_.get()));
+#endif
+    }
+  }
+  OPENSSL_cleanse(key_block.data(), key_block.size());
+
+  if (enabled) {
+    // The kernel encrypts plaintext written to the socket from now on.
+    kernel_tls_writer_.reset(new Network::RawBufferSocket());
+    kernel_tls_writer_->setTransportSocketCallbacks(*callbacks_);
+  }
+  return enabled;
+#else
+  return false;
+#endif
+}
+
+void SslSocket::sendKernelTlsCloseNotify() {
+#ifdef ENVOY_KERNEL_TLS
+  // Alerts are written as records of their own type, which the kernel takes from a control
+  // message.
+  uint8_t alert[2] = {SSL3_AL_WARNING, SSL_AD_CLOSE_NOTIFY};
+  uint8_t control[CMSG_SPACE(sizeof(uint8_t))];
+  iovec iov{alert, sizeof(alert)};
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_TLS;
+  cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(uint8_t));
+  *CMSG_DATA(cmsg) = SSL3_RT_ALERT;
+
+  const ssize_t rc = sendmsg(callbacks_->fd(), &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+  ENVOY_CONN_LOG(debug, "kernel TLS close notify: rc={}", callbacks_->connection(), rc);
+  UNREFERENCED_PARAMETER(rc);
+#endif
+}
+
 void SslSocket::drainErrorQueue() {
   bool saw_error = false;
   bool saw_counted_error = false;
@@ -162,10 +320,24 @@ Network::IoResult SslSocket::doWrite(Buffer::Instance& write_buffer) {
   if (!handshake_complete_) {
     PostIoAction action = doHandshake();
     if (action == PostIoAction::Close || !handshake_complete_) {
-      return {action, 0};
+      return {action, 0, 0};
     }
   }
 
+  if (kernel_tls_writer_) {
+    return kernel_tls_writer_->doWrite(write_buffer);
+  }
+
+  if (ctx_.initialRecordSize() > 0) {
+    // Restart with small records once the connection has been idle, as the congestion window
+    // has likely been reduced meanwhile.
+    const MonotonicTime now = ProdMonotonicTimeSource::instance_.currentTime();
+    if (now - last_write_time_ > RECORD_SIZE_IDLE_TIMEOUT) {
+      small_records_written_ = 0;
+    }
+    last_write_time_ = now;
+  }
+
   uint64_t original_buffer_length = write_buffer.length();
   uint64_t total_bytes_written = 0;
   bool keep_writing = true;
@@ -180,32 +352,44 @@ Network::IoResult SslSocket::doWrite(Buffer::Instance& write_buffer) {
     uint64_t num_slices = write_buffer.getRawSlices(slices, MAX_SLICES);
 
     uint64_t inner_bytes_written = 0;
-    for (uint64_t i = 0; (i < num_slices) && (original_buffer_length != total_bytes_written); i++) {
-      // SSL_write() requires that if a previous call returns SSL_ERROR_WANT_WRITE, we need to call
-      // it again with the same parameters. Most implementations keep track of the last write size.
-      // In our case we don't need to do that because: a) SSL_write() will not write partial
-      // buffers. b) We only move() into the write buffer, which means that it's impossible for a
-      // particular chain to increase in size. So as long as we start writing where we left off we
-      // are guaranteed to call SSL_write() with the same parameters.
-      int rc = SSL_write(ssl_.get(), slices[i].mem_, slices[i].len_);
-      ENVOY_CONN_LOG(trace, "ssl write returns: {}", callbacks_->connection(), rc);
-      if (rc > 0) {
-        inner_bytes_written += rc;
-        total_bytes_written += rc;
-      } else {
-        int err = SSL_get_error(ssl_.get(), rc);
-        switch (err) {
-        case SSL_ERROR_WANT_WRITE:
-          keep_writing = false;
+    for (uint64_t i = 0; (i < num_slices) && (original_buffer_length != total_bytes_written) &&
+                         keep_writing;
+         i++) {
+      uint8_t* mem = static_cast<uint8_t*>(slices[i].mem_);
+      uint64_t len = slices[i].len_;
+      while (len > 0) {
+        // SSL_write() requires that if a previous call returns SSL_ERROR_WANT_WRITE, we need to
+        // call it again with the same parameters. SSL_write() will not write partial buffers and
+        // we only move() into the write buffer, so as long as we start writing where we left off
+        // and with the same size, we are guaranteed to call SSL_write() with the same parameters.
+        const uint64_t write_size = nextWriteSize(len);
+        int rc = SSL_write(ssl_.get(), mem, write_size);
+        ENVOY_CONN_LOG(trace, "ssl write returns: {}", callbacks_->connection(), rc);
+        if (rc > 0) {
+          if (small_records_written_ < SMALL_RECORDS_BEFORE_RAMP) {
+            small_records_written_++;
+          }
+          blocked_write_size_ = 0;
+          mem += rc;
+          len -= rc;
+          inner_bytes_written += rc;
+          total_bytes_written += rc;
+        } else {
+          int err = SSL_get_error(ssl_.get(), rc);
+          switch (err) {
+          case SSL_ERROR_WANT_WRITE:
+            blocked_write_size_ = write_size;
+            keep_writing = false;
+            break;
+          case SSL_ERROR_WANT_READ:
+          // Renegotiation has started. We don't handle renegotiation so just fall through.
+          default:
+            drainErrorQueue();
+            return {PostIoAction::Close, total_bytes_written, 0};
+          }
+
           break;
-        case SSL_ERROR_WANT_READ:
-        // Renegotiation has started. We don't handle renegotiation so just fall through.
-        default:
-          drainErrorQueue();
-          return {PostIoAction::Close, total_bytes_written};
         }
-
-        break;
       }
     }
 
@@ -216,43 +400,45 @@ Network::IoResult SslSocket::doWrite(Buffer::Instance& write_buffer) {
     }
   }
 
-  return {PostIoAction::KeepOpen, total_bytes_written};
+  return {PostIoAction::KeepOpen, total_bytes_written, 0};
 }
 
-void SslSocket::onConnected() { ASSERT(!handshake_complete_); }
+uint64_t SslSocket::nextWriteSize(uint64_t len) const {
+  if (blocked_write_size_ > 0) {
+    ASSERT(blocked_write_size_ <= len);
+    return blocked_write_size_;
+  }
 
-bool SslSocket::peerCertificatePresented() const {
-  bssl::UniquePtr<X509> cert(SSL_get_peer_certificate(ssl_.get()));
-  return cert != nullptr;
+  // Small records can be decrypted as soon as the first packets arrive, rather than once a full
+  // 16K record has made it through slow start. Bulk transfers then switch to full records.
+  const uint32_t initial_record_size = ctx_.initialRecordSize();
+  if (initial_record_size > 0 && small_records_written_ < SMALL_RECORDS_BEFORE_RAMP) {
+    return std::min<uint64_t>(len, initial_record_size);
+  }
+
+  return len;
 }
 
-std::string SslSocket::uriSanLocalCertificate() {
+void SslSocket::onConnected() { ASSERT(!handshake_complete_); }
+
+void SslSocket::cacheCertificateInfo() {
   // The cert object is not owned.
-  X509* cert = SSL_get_certificate(ssl_.get());
-  if (!cert) {
-    return "";
+  X509* local_cert = SSL_get_certificate(ssl_.get());
+  if (local_cert) {
+    uri_san_local_certificate_ = getUriSanFromCertificate(local_cert);
   }
-  return getUriSanFromCertificate(cert);
-}
 
-std::string SslSocket::sha256PeerCertificateDigest() {
   bssl::UniquePtr<X509> cert(SSL_get_peer_certificate(ssl_.get()));
   if (!cert) {
-    return "";
+    return;
   }
+  peer_certificate_presented_ = true;
 
   std::vector<uint8_t> computed_hash(SHA256_DIGEST_LENGTH);
   unsigned int n;
   X509_digest(cert.get(), EVP_sha256(), computed_hash.data(), &n);
   RELEASE_ASSERT(n == computed_hash.size());
-  return Hex::encode(computed_hash);
-}
-
-std::string SslSocket::subjectPeerCertificate() const {
-  bssl::UniquePtr<X509> cert(SSL_get_peer_certificate(ssl_.get()));
-  if (!cert) {
-    return "";
-  }
+  sha256_peer_certificate_digest_ = Hex::encode(computed_hash);
 
   bssl::UniquePtr<BIO> buf(BIO_new(BIO_s_mem()));
   RELEASE_ASSERT(buf != nullptr);
@@ -265,15 +451,9 @@ std::string SslSocket::subjectPeerCertificate() const {
   int rc = BIO_mem_contents(buf.get(), &data, &data_len);
   ASSERT(rc == 1);
   UNREFERENCED_PARAMETER(rc);
-  return std::string(reinterpret_cast<const char*>(data), data_len);
-}
+  subject_peer_certificate_.assign(reinterpret_cast<const char*>(data), data_len);
 
-std::string SslSocket::uriSanPeerCertificate() {
-  bssl::UniquePtr<X509> cert(SSL_get_peer_certificate(ssl_.get()));
-  if (!cert) {
-    return "";
-  }
-  return getUriSanFromCertificate(cert.get());
+  uri_san_peer_certificate_ = getUriSanFromCertificate(cert.get());
 }
 
 std::string SslSocket::getUriSanFromCertificate(X509* cert) {
@@ -308,16 +488,28 @@ ClientConnectionImpl::ClientConnectionImpl(Event::DispatcherImpl& dispatcher, Co
                                            Network::Address::InstanceConstSharedPtr address,
                                            Network::Address::InstanceConstSharedPtr source_address)
     : ConnectionImpl(dispatcher, address->socket(Network::Address::SocketType::Stream), address,
-                     nullptr, source_address, false, false, ctx, InitialState::Client) {}
+                     nullptr, source_address, false, false, ctx, InitialState::Client) {
+  dynamic_cast<SslSocket&>(*transport_socket_).resumeSession(address->asString());
+}
 
 void ClientConnectionImpl::connect() { doConnect(); }
 
 void SslSocket::closeSocket(Network::ConnectionEvent) {
+  if (private_key_operation_state_) {
+    private_key_operation_state_->cancel();
+  }
+
   if (handshake_complete_ &&
       callbacks_->connection().state() != Network::Connection::State::Closed) {
     // Attempt to send a shutdown before closing the socket. It's possible this won't go out if
     // there is no room on the socket. We can extend the state machine to handle this at some point
     // if needed.
+    if (kernel_tls_writer_) {
+      // BoringSSL's write state is stale once the kernel writes the records.
+      sendKernelTlsCloseNotify();
+      return;
+    }
+
     int rc = SSL_shutdown(ssl_.get());
     ENVOY_CONN_LOG(debug, "SSL shutdown: rc={}", callbacks_->connection(), rc);
     UNREFERENCED_PARAMETER(rc);
@@ -1,12 +1,17 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
+#include <memory>
 #include <string>
 
+#include "envoy/common/time.h"
 #include "envoy/network/transport_socket.h"
 
 #include "common/network/connection_impl.h"
+#include "common/network/raw_buffer_socket.h"
 #include "common/ssl/context_impl.h"
+#include "common/ssl/private_key_method_provider.h"
 
 #include "openssl/ssl.h"
 
@@ -22,11 +27,12 @@ public:
   SslSocket(Context& ctx, InitialState state);
 
   // Ssl::Connection
-  bool peerCertificatePresented() const override;
-  std::string uriSanLocalCertificate() override;
-  std::string sha256PeerCertificateDigest() override;
-  std::string subjectPeerCertificate() const override;
-  std::string uriSanPeerCertificate() override;
+  bool peerCertificatePresented() const override { return peer_certificate_presented_; }
+  std::string uriSanLocalCertificate() override { return uri_san_local_certificate_; }
+  std::string sha256PeerCertificateDigest() override { return sha256_peer_certificate_digest_; }
+  std::string subjectPeerCertificate() const override { return subject_peer_certificate_; }
+  std::string uriSanPeerCertificate() override { return uri_san_peer_certificate_; }
+  bool lastReadEarlyData() const override { return last_read_early_data_; }
 
   // Network::TransportSocket
   void setTransportSocketCallbacks(Network::TransportSocketCallbacks& callbacks) override;
@@ -37,17 +43,65 @@ public:
   Network::IoResult doWrite(Buffer::Instance& write_buffer) override;
   void onConnected() override;
 
+  /**
+   * Offer the session the client context has cached for an upstream, and cache the session of
+   * this connection for it in turn.
+   * @param session_key supplies the key of the upstream.
+   */
+  void resumeSession(const std::string& session_key);
+
   SSL* rawSslForTest() { return ssl_.get(); }
 
+  /**
+   * Whether to hand the write keys of connections to the kernel once their handshake completes,
+   * where the kernel and the negotiated cipher support it. Reads keep going through BoringSSL.
+   */
+  static void kernelTls(bool enabled) { kernel_tls_ = enabled; }
+
+  // Number of records written with the initial record size, after which records are as large as
+  // possible. Writes after a pause of RECORD_SIZE_IDLE_TIMEOUT start over with small records.
+  static const uint32_t SMALL_RECORDS_BEFORE_RAMP = 40;
+  static constexpr std::chrono::milliseconds RECORD_SIZE_IDLE_TIMEOUT{1000};
+
 private:
+  // Space reserved in the read buffer for each round of reads. 16K is arbitrary and can be tuned
+  // later.
+  static const uint64_t READ_RESERVATION_SIZE = 16384;
+
   Network::PostIoAction doHandshake();
+  uint64_t nextWriteSize(uint64_t len) const;
+  bool enableKernelTlsTx();
+  void sendKernelTlsCloseNotify();
   void drainErrorQueue();
+  void cacheCertificateInfo();
   std::string getUriSanFromCertificate(X509* cert);
 
   Network::TransportSocketCallbacks* callbacks_{};
   ContextImpl& ctx_;
   bssl::UniquePtr<SSL> ssl_;
+  // With early data, the handshake is complete as far as reads and writes are concerned once the
+  // server has accepted the early data, before the client's Finished message.
   bool handshake_complete_{};
+  bool last_read_early_data_{};
+  // Certificate details, computed once when the handshake completes rather than for every request
+  // which reads them.
+  bool peer_certificate_presented_{};
+  std::string uri_san_local_certificate_;
+  std::string sha256_peer_certificate_digest_;
+  std::string subject_peer_certificate_;
+  std::string uri_san_peer_certificate_;
+  // Dynamic record sizing state, only used if the context has an initial record size.
+  uint32_t small_records_written_{};
+  MonotonicTime last_write_time_;
+  // Size of the last SSL_write() which returned SSL_ERROR_WANT_WRITE, as it must be retried with
+  // the same size.
+  uint64_t blocked_write_size_{};
+  // Writes plaintext to the socket once the kernel encrypts the records of this connection.
+  std::unique_ptr<Network::RawBufferSocket> kernel_tls_writer_;
+
+  static bool kernel_tls_;
+  // Tracks private key operations that the server context offloads during the handshake.
+  PrivateKeyOperationStatePtr private_key_operation_state_;
 };
 
 // TODO(lizan): Remove Ssl::ConnectionImpl entirely when factory of TransportSocket is ready.
@@ -76,6 +130,10 @@ public:
 
   // Network::ClientConnection
   void connect() override;
+  void setFallbackAddress(Network::Address::InstanceConstSharedPtr address,
+                          std::chrono::milliseconds delay) override {
+    doSetFallbackAddress(address, delay);
+  }
 };
 
 } // namespace Ssl
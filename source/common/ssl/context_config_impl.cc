@@ -34,6 +34,8 @@ const std::string ContextConfigImpl::DEFAULT_CIPHER_SUITES =
 
 const std::string ContextConfigImpl::DEFAULT_ECDH_CURVES = "X25519:P-256";
 
+uint32_t ContextConfigImpl::default_initial_record_size_ = 0;
+
 ContextConfigImpl::ContextConfigImpl(const envoy::api::v2::CommonTlsContext& config)
     : alpn_protocols_(RepeatedPtrUtil::join(config.alpn_protocols(), ",")),
       alt_alpn_protocols_(config.deprecated_v1().alt_alpn_protocols()),
@@ -56,7 +58,8 @@ ContextConfigImpl::ContextConfigImpl(const envoy::api::v2::CommonTlsContext& con
       min_protocol_version_(
           tlsVersionFromProto(config.tls_params().tls_minimum_protocol_version(), TLS1_VERSION)),
       max_protocol_version_(
-          tlsVersionFromProto(config.tls_params().tls_maximum_protocol_version(), TLS1_2_VERSION)) {
+          tlsVersionFromProto(config.tls_params().tls_maximum_protocol_version(), TLS1_2_VERSION)),
+      initial_record_size_(default_initial_record_size_) {
   // TODO(htuch): Support multiple hashes.
   ASSERT(config.validation_context().verify_certificate_hash().size() <= 1);
   if (!config.tls_certificates().empty()) {
@@ -139,8 +142,16 @@ ServerContextConfigImpl::ServerContextConfigImpl(const envoy::api::v2::Downstrea
 
         return ret;
       }()) {
-  // TODO(PiotrSikora): Support multiple TLS certificates.
-  ASSERT(config.common_tls_context().tls_certificates().size() == 1);
+  ASSERT(config.common_tls_context().tls_certificates().size() >= 1);
+  for (const auto& tls_certificate : config.common_tls_context().tls_certificates()) {
+    // TODO(htuch): Support inline cert material delivery.
+    ASSERT(tls_certificate.certificate_chain().specifier_case() ==
+           envoy::api::v2::DataSource::kFilename);
+    ASSERT(tls_certificate.private_key().specifier_case() ==
+           envoy::api::v2::DataSource::kFilename);
+    tls_certificates_.push_back(
+        {tls_certificate.certificate_chain().filename(), tls_certificate.private_key().filename()});
+  }
 }
 
 ServerContextConfigImpl::ServerContextConfigImpl(const Json::Object& config)
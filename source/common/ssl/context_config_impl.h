@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -28,6 +29,15 @@ public:
   const std::string& verifyCertificateHash() const override { return verify_certificate_hash_; };
   unsigned minProtocolVersion() const override { return min_protocol_version_; };
   unsigned maxProtocolVersion() const override { return max_protocol_version_; };
+  uint32_t initialRecordSize() const override { return initial_record_size_; }
+
+  /**
+   * Set the initial record size of contexts configured from then on. The TLS context protos have
+   * no field for it yet, so it is set for the whole server.
+   */
+  static void defaultInitialRecordSize(uint32_t initial_record_size) {
+    default_initial_record_size_ = initial_record_size;
+  }
 
 protected:
   ContextConfigImpl(const envoy::api::v2::CommonTlsContext& config);
@@ -50,6 +60,9 @@ private:
   const std::string verify_certificate_hash_;
   const unsigned min_protocol_version_;
   const unsigned max_protocol_version_;
+  const uint32_t initial_record_size_;
+
+  static uint32_t default_initial_record_size_;
 };
 
 class ClientContextConfigImpl : public ContextConfigImpl, public ClientContextConfig {
@@ -74,10 +87,14 @@ public:
   const std::vector<SessionTicketKey>& sessionTicketKeys() const override {
     return session_ticket_keys_;
   }
+  const std::vector<CertificateFiles>& tlsCertificates() const override {
+    return tls_certificates_;
+  }
 
 private:
   const bool require_client_certificate_;
   const std::vector<SessionTicketKey> session_ticket_keys_;
+  std::vector<CertificateFiles> tls_certificates_;
 
   static void validateAndAppendKey(std::vector<ServerContextConfig::SessionTicketKey>& keys,
                                    const std::string& key_data);
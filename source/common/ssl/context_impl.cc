@@ -10,14 +10,40 @@
 
 #include "common/common/assert.h"
 #include "common/common/hex.h"
+#include "common/common/logger.h"
+#include "common/common/utility.h"
 
 #include "fmt/format.h"
+#include "openssl/bio.h"
+#include "openssl/ec.h"
+#include "openssl/ec_key.h"
+#include "openssl/err.h"
+#include "openssl/evp.h"
 #include "openssl/hmac.h"
+#include "openssl/pem.h"
 #include "openssl/rand.h"
 #include "openssl/x509v3.h"
 
 namespace Envoy {
 namespace Ssl {
+namespace {
+
+bool cbsContainsU16(CBS cbs, uint16_t value) {
+  while (CBS_len(&cbs) > 0) {
+    uint16_t element;
+    if (!CBS_get_u16(&cbs, &element)) {
+      return false;
+    }
+    if (element == value) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+constexpr std::chrono::seconds ContextImpl::VERIFICATION_CACHE_TTL;
 
 int ContextImpl::sslContextIndex() {
   CONSTRUCT_ON_FIRST_USE(int, []() -> int {
@@ -27,10 +53,12 @@ int ContextImpl::sslContextIndex() {
   }());
 }
 
-ContextImpl::ContextImpl(ContextManagerImpl& parent, Stats::Scope& scope, ContextConfig& config)
+ContextImpl::ContextImpl(ContextManagerImpl& parent, Stats::Scope& scope, ContextConfig& config,
+                         bool use_certificate_chain)
     : parent_(parent), ctx_(SSL_CTX_new(TLS_method())), scope_(scope), stats_(generateStats(scope)),
       min_protocol_version_(config.minProtocolVersion()),
-      max_protocol_version_(config.maxProtocolVersion()), ecdh_curves_(config.ecdhCurves()) {
+      max_protocol_version_(config.maxProtocolVersion()), ecdh_curves_(config.ecdhCurves()),
+      initial_record_size_(config.initialRecordSize()) {
   RELEASE_ASSERT(ctx_);
 
   int rc = SSL_CTX_set_ex_data(ctx_.get(), sslContextIndex(), this);
@@ -86,6 +114,10 @@ ContextImpl::ContextImpl(ContextManagerImpl& parent, Stats::Scope& scope, Contex
   if (!config.certChainFile().empty()) {
     cert_chain_ = loadCert(config.certChainFile());
     cert_chain_file_path_ = config.certChainFile();
+    private_key_file_path_ = config.privateKeyFile();
+  }
+
+  if (!config.certChainFile().empty() && use_certificate_chain) {
     int rc = SSL_CTX_use_certificate_chain_file(ctx_.get(), config.certChainFile().c_str());
     if (0 == rc) {
       throw EnvoyException(
@@ -158,16 +190,30 @@ bssl::UniquePtr<SSL> ContextImpl::newSsl() const {
 int ContextImpl::verifyCallback(X509_STORE_CTX* store_ctx, void* arg) {
   ContextImpl* impl = reinterpret_cast<ContextImpl*>(arg);
 
+  SSL* ssl = reinterpret_cast<SSL*>(
+      X509_STORE_CTX_get_ex_data(store_ctx, SSL_get_ex_data_X509_STORE_CTX_idx()));
+  bssl::UniquePtr<X509> cert(SSL_get_peer_certificate(ssl));
+
+  std::string digest(SHA256_DIGEST_LENGTH, 0);
+  unsigned int n;
+  X509_digest(cert.get(), EVP_sha256(), reinterpret_cast<uint8_t*>(&digest[0]), &n);
+  RELEASE_ASSERT(n == digest.size());
+  if (impl->verificationCached(digest)) {
+    impl->stats_.verify_cache_hit_.inc();
+    return 1;
+  }
+
   int ret = X509_verify_cert(store_ctx);
   if (ret <= 0) {
     impl->stats_.fail_verify_error_.inc();
     return ret;
   }
 
-  SSL* ssl = reinterpret_cast<SSL*>(
-      X509_STORE_CTX_get_ex_data(store_ctx, SSL_get_ex_data_X509_STORE_CTX_idx()));
-  bssl::UniquePtr<X509> cert(SSL_get_peer_certificate(ssl));
-  return impl->verifyCertificate(cert.get());
+  ret = impl->verifyCertificate(cert.get());
+  if (ret == 1) {
+    impl->cacheVerification(digest);
+  }
+  return ret;
 }
 
 int ContextImpl::verifyCertificate(X509* cert) {
@@ -185,6 +231,43 @@ int ContextImpl::verifyCertificate(X509* cert) {
   return 1;
 }
 
+bool ContextImpl::verificationCached(const std::string& digest) {
+  std::unique_lock<std::mutex> lock(verification_lock_);
+  auto verification = verifications_.find(digest);
+  if (verification == verifications_.end()) {
+    return false;
+  }
+  if (verification->second <= ProdMonotonicTimeSource::instance_.currentTime()) {
+    verifications_.erase(verification);
+    return false;
+  }
+  return true;
+}
+
+void ContextImpl::cacheVerification(const std::string& digest) {
+  const MonotonicTime now = ProdMonotonicTimeSource::instance_.currentTime();
+  std::unique_lock<std::mutex> lock(verification_lock_);
+  if (verifications_.size() >= MAX_CACHED_VERIFICATIONS) {
+    for (auto it = verifications_.begin(); it != verifications_.end();) {
+      if (it->second <= now) {
+        it = verifications_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    if (verifications_.size() >= MAX_CACHED_VERIFICATIONS) {
+      // Dropping an arbitrary peer only costs it a full verification.
+      verifications_.erase(verifications_.begin());
+    }
+  }
+  verifications_[digest] = now + VERIFICATION_CACHE_TTL;
+}
+
+size_t ContextImpl::cachedVerifications() {
+  std::unique_lock<std::mutex> lock(verification_lock_);
+  return verifications_.size();
+}
+
 void ContextImpl::logHandshake(SSL* ssl) const {
   stats_.handshake_.inc();
 
@@ -192,6 +275,10 @@ void ContextImpl::logHandshake(SSL* ssl) const {
     stats_.session_reused_.inc();
   }
 
+  if (SSL_early_data_accepted(ssl)) {
+    stats_.early_data_accepted_.inc();
+  }
+
   const char* cipher = SSL_get_cipher_name(ssl);
   scope_.counter(fmt::format("ssl.ciphers.{}", std::string{cipher})).inc();
 
@@ -346,6 +433,76 @@ ClientContextImpl::ClientContextImpl(ContextManagerImpl& parent, Stats::Scope& s
   }
 
   server_name_indication_ = config.serverNameIndication();
+
+  // Sessions are cached per upstream, see resumeSession(), rather than in the SSL_CTX itself.
+  SSL_CTX_set_session_cache_mode(ctx_.get(), SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL);
+  SSL_CTX_sess_set_new_cb(ctx_.get(), [](SSL* ssl, SSL_SESSION* session) -> int {
+    const std::string* session_key =
+        static_cast<const std::string*>(SSL_get_ex_data(ssl, sessionKeyIndex()));
+    if (session_key == nullptr) {
+      return 0;
+    }
+
+    ClientContextImpl* context = dynamic_cast<ClientContextImpl*>(
+        static_cast<ContextImpl*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), sslContextIndex())));
+    // Returning 1 takes ownership of the session.
+    context->cacheSession(*session_key, bssl::UniquePtr<SSL_SESSION>(session));
+    return 1;
+  });
+}
+
+int ClientContextImpl::sessionKeyIndex() {
+  CONSTRUCT_ON_FIRST_USE(int, []() -> int {
+    int ssl_index = SSL_get_ex_new_index(
+        0, nullptr, nullptr, nullptr,
+        [](void*, void* ptr, CRYPTO_EX_DATA*, int, long, void*) -> void {
+          delete static_cast<std::string*>(ptr);
+        });
+    RELEASE_ASSERT(ssl_index >= 0);
+    return ssl_index;
+  }());
+}
+
+void ClientContextImpl::resumeSession(SSL* ssl, const std::string& session_key) {
+  std::string* key = new std::string(session_key);
+  int rc = SSL_set_ex_data(ssl, sessionKeyIndex(), key);
+  RELEASE_ASSERT(rc == 1);
+  UNREFERENCED_PARAMETER(rc);
+
+  std::unique_lock<std::mutex> lock(session_lock_);
+  auto session = sessions_.find(session_key);
+  if (session != sessions_.end()) {
+    // This takes its own reference. A session the upstream no longer accepts results in a full
+    // handshake, whose new session then replaces it.
+    SSL_set_session(ssl, session->second.get());
+  }
+}
+
+void ClientContextImpl::cacheSession(const std::string& session_key,
+                                     bssl::UniquePtr<SSL_SESSION> session) {
+  // Sessions replaced or evicted below are freed once the lock has been released.
+  bssl::UniquePtr<SSL_SESSION> replaced;
+  std::unique_lock<std::mutex> lock(session_lock_);
+  auto existing = sessions_.find(session_key);
+  if (existing != sessions_.end()) {
+    replaced = std::move(existing->second);
+    existing->second = std::move(session);
+    return;
+  }
+
+  if (sessions_.size() >= MAX_CACHED_SESSIONS) {
+    // Upstreams come and go, so bound the cache rather than tracking them. Dropping an arbitrary
+    // upstream only costs it a full handshake.
+    replaced = std::move(sessions_.begin()->second);
+    sessions_.erase(sessions_.begin());
+  }
+
+  sessions_.emplace(session_key, std::move(session));
+}
+
+size_t ClientContextImpl::cachedSessions() {
+  std::unique_lock<std::mutex> lock(session_lock_);
+  return sessions_.size();
 }
 
 bssl::UniquePtr<SSL> ClientContextImpl::newSsl() const {
@@ -364,9 +521,16 @@ ServerContextImpl::ServerContextImpl(ContextManagerImpl& parent, const std::stri
                                      const std::vector<std::string>& server_names,
                                      Stats::Scope& scope, ServerContextConfig& config,
                                      bool skip_context_update, Runtime::Loader& runtime)
-    : ContextImpl(parent, scope, config), listener_name_(listener_name),
-      server_names_(server_names), skip_context_update_(skip_context_update), runtime_(runtime),
-      session_ticket_keys_(config.sessionTicketKeys()) {
+    : ContextImpl(parent, scope, config,
+                  !(parent.lazyCertificateLoading() && !skip_context_update) &&
+                      config.tlsCertificates().size() <= 1),
+      listener_name_(listener_name), server_names_(server_names),
+      skip_context_update_(skip_context_update), runtime_(runtime),
+      session_ticket_keys_(config.sessionTicketKeys()),
+      certificate_files_(config.tlsCertificates()),
+      lazy_certificate_chain_(parent.lazyCertificateLoading() && !skip_context_update &&
+                              !config.certChainFile().empty()),
+      per_connection_certificates_(lazy_certificate_chain_ || certificate_files_.size() > 1) {
   SSL_CTX_set_select_certificate_cb(
       ctx_.get(), [](const SSL_CLIENT_HELLO* client_hello) -> ssl_select_cert_result_t {
         ContextImpl* context_impl = static_cast<ContextImpl*>(
@@ -413,6 +577,59 @@ ServerContextImpl::ServerContextImpl(ContextManagerImpl& parent, const std::stri
         });
   }
 
+  if (parent.earlyData()) {
+    SSL_CTX_set_early_data_enabled(ctx_.get(), 1);
+  }
+
+  private_key_method_provider_ = parent.privateKeyMethodProvider();
+  if (private_key_method_provider_ && SSL_CTX_get0_privatekey(ctx_.get()) != nullptr &&
+      !per_connection_certificates_) {
+    SSL_CTX_set_private_key_method(ctx_.get(), &private_key_method_);
+  }
+
+  if (certificate_files_.size() > 1) {
+    STACK_OF(SSL_CIPHER)* ciphers = SSL_CTX_get_ciphers(ctx_.get());
+    for (size_t i = 0; i < sk_SSL_CIPHER_num(ciphers); i++) {
+      const SSL_CIPHER* cipher = sk_SSL_CIPHER_value(ciphers, i);
+      if (SSL_CIPHER_get_auth_nid(cipher) == NID_auth_ecdsa) {
+        ecdsa_cipher_suites_.push_back(SSL_CIPHER_get_id(cipher) & 0xffff);
+      }
+    }
+
+    if (!lazy_certificate_chain_) {
+      certificates_loaded_ = true;
+      loadCertificates();
+    }
+  }
+
+  session_cache_ = parent.sessionCache();
+  if (session_cache_) {
+    SSL_CTX_set_session_cache_mode(ctx_.get(),
+                                   SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+    SSL_CTX_sess_set_new_cb(ctx_.get(), [](SSL* ssl, SSL_SESSION* session) -> int {
+      ServerContextImpl& context = fromSsl(ssl);
+      if (context.session_cache_) {
+        context.session_cache_->insert(session);
+      }
+      // The cache takes its own reference, so leave the caller's alone.
+      return 0;
+    });
+    SSL_CTX_sess_set_get_cb(ctx_.get(),
+                            [](SSL* ssl, const uint8_t* id, int id_len,
+                               int* out_copy) -> SSL_SESSION* {
+                              // The session returned carries a reference for the caller.
+                              *out_copy = 0;
+                              return fromSsl(ssl).getSession(id, id_len);
+                            });
+    SSL_CTX_sess_set_remove_cb(ctx_.get(), [](SSL_CTX* ctx, SSL_SESSION* session) -> void {
+      ServerContextImpl* context = dynamic_cast<ServerContextImpl*>(
+          static_cast<ContextImpl*>(SSL_CTX_get_ex_data(ctx, sslContextIndex())));
+      if (context != nullptr && context->session_cache_) {
+        context->session_cache_->remove(session);
+      }
+    });
+  }
+
   uint8_t session_context_buf[EVP_MAX_MD_SIZE] = {};
   unsigned session_context_len = 0;
   EVP_MD_CTX md;
@@ -422,8 +639,9 @@ ServerContextImpl::ServerContextImpl(ContextManagerImpl& parent, const std::stri
   // Hash the CommonName/SANs of the server certificate. This makes sure that
   // sessions can only be resumed to a certificate for the same name, but allows
   // resuming to unique certs in the case that different Envoy instances each have
-  // their own certs.
-  X509* cert = SSL_CTX_get0_certificate(ctx_.get());
+  // their own certs. cert_chain_ is the same certificate, and is loaded even when ctx_ doesn't have
+  // one yet.
+  X509* cert = cert_chain_.get();
   RELEASE_ASSERT(cert != nullptr);
   X509_NAME* cert_subject = X509_get_subject_name(cert);
   RELEASE_ASSERT(cert_subject != nullptr);
@@ -500,6 +718,11 @@ ServerContextImpl::ServerContextImpl(ContextManagerImpl& parent, const std::stri
 ssl_select_cert_result_t
 ServerContextImpl::processClientHello(const SSL_CLIENT_HELLO* client_hello) {
   if (skip_context_update_) {
+    // Only the certificate may depend on the client hello.
+    if (per_connection_certificates_ && !useCertificates(client_hello)) {
+      stats_.fail_load_certificate_.inc();
+      return ssl_select_cert_error;
+    }
     return ssl_select_cert_success;
   }
 
@@ -534,14 +757,78 @@ ServerContextImpl::processClientHello(const SSL_CLIENT_HELLO* client_hello) {
   }
 
   // Update context if it changed.
+  ServerContextImpl* new_impl = dynamic_cast<ServerContextImpl*>(new_ctx);
   if (new_ctx != this) {
-    ServerContextImpl* new_impl = dynamic_cast<ServerContextImpl*>(new_ctx);
     new_impl->updateConnectionContext(client_hello->ssl);
   }
 
+  if (new_impl->per_connection_certificates_ && !new_impl->useCertificates(client_hello)) {
+    new_impl->stats_.fail_load_certificate_.inc();
+    return ssl_select_cert_error;
+  }
+
   return ssl_select_cert_success;
 }
 
+const SSL_PRIVATE_KEY_METHOD ServerContextImpl::private_key_method_ = {
+    // sign
+    [](SSL* ssl, uint8_t*, size_t*, size_t, uint16_t signature_algorithm, const uint8_t* in,
+       size_t in_len) -> ssl_private_key_result_t {
+      return fromSsl(ssl).startPrivateKeyOperation(ssl, PrivateKeyOperation::Type::Sign,
+                                                   signature_algorithm, in, in_len);
+    },
+    // decrypt
+    [](SSL* ssl, uint8_t*, size_t*, size_t, const uint8_t* in,
+       size_t in_len) -> ssl_private_key_result_t {
+      return fromSsl(ssl).startPrivateKeyOperation(ssl, PrivateKeyOperation::Type::Decrypt, 0, in,
+                                                   in_len);
+    },
+    // complete
+    [](SSL* ssl, uint8_t* out, size_t* out_len, size_t max_out) -> ssl_private_key_result_t {
+      PrivateKeyOperationState* state = PrivateKeyOperationState::fromSsl(ssl);
+      return state != nullptr ? state->complete(out, out_len, max_out) : ssl_private_key_failure;
+    }};
+
+ServerContextImpl& ServerContextImpl::fromSsl(SSL* ssl) {
+  ContextImpl* context_impl =
+      static_cast<ContextImpl*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), sslContextIndex()));
+  ServerContextImpl* server_context_impl = dynamic_cast<ServerContextImpl*>(context_impl);
+  RELEASE_ASSERT(server_context_impl != nullptr);
+  return *server_context_impl;
+}
+
+ssl_private_key_result_t
+ServerContextImpl::startPrivateKeyOperation(SSL* ssl, PrivateKeyOperation::Type type,
+                                            uint16_t signature_algorithm, const uint8_t* in,
+                                            size_t in_len) {
+  ASSERT(private_key_method_provider_);
+  // The transport socket of the connection attaches the state to its SSL.
+  PrivateKeyOperationState* state = PrivateKeyOperationState::fromSsl(ssl);
+  EVP_PKEY* key = per_connection_certificates_ ? privateKey(type, signature_algorithm)
+                                               : SSL_CTX_get0_privatekey(ctx_.get());
+  if (state == nullptr || key == nullptr) {
+    return ssl_private_key_failure;
+  }
+
+  stats_.private_key_operation_offloaded_.inc();
+  return state->start(*private_key_method_provider_,
+                      std::make_shared<PrivateKeyOperation>(type, *key, signature_algorithm, in,
+                                                            in_len));
+}
+
+SSL_SESSION* ServerContextImpl::getSession(const uint8_t* id, int id_len) {
+  // With SNI, this is the context the connection was switched to. All server contexts share the
+  // same cache, so the lookup doesn't depend on which one it is.
+  bssl::UniquePtr<SSL_SESSION> session =
+      session_cache_ ? session_cache_->lookup(id, id_len) : nullptr;
+  if (session) {
+    stats_.session_cache_hit_.inc();
+  } else {
+    stats_.session_cache_miss_.inc();
+  }
+  return session.release();
+}
+
 void ServerContextImpl::updateConnectionContext(SSL* ssl) {
   ASSERT(ctx_);
 
@@ -565,6 +852,160 @@ void ServerContextImpl::updateConnectionContext(SSL* ssl) {
   UNREFERENCED_PARAMETER(rc);
 }
 
+bool ServerContextImpl::useCertificates(const SSL_CLIENT_HELLO* client_hello) {
+  if (lazy_certificate_chain_) {
+    std::unique_lock<std::mutex> lock(certificates_lock_);
+    if (!certificates_loaded_) {
+      certificates_loaded_ = true;
+      try {
+        loadCertificates();
+      } catch (const EnvoyException& e) {
+        // Only the connections selecting this context fail, and don't retry for each of them.
+        ENVOY_LOG_MISC(warn, "{}", e.what());
+        ecdsa_certificate_ = nullptr;
+        rsa_certificate_ = nullptr;
+        certificates_.clear();
+      }
+    }
+  }
+
+  const Certificate* certificate = rsa_certificate_;
+  if (ecdsa_certificate_ != nullptr &&
+      (rsa_certificate_ == nullptr || isClientEcdsaCapable(client_hello))) {
+    certificate = ecdsa_certificate_;
+  }
+  if (certificate == nullptr) {
+    return false;
+  }
+
+  std::vector<CRYPTO_BUFFER*> certs;
+  for (const bssl::UniquePtr<CRYPTO_BUFFER>& cert : certificate->chain_) {
+    certs.push_back(cert.get());
+  }
+
+  // Offloaded private key operations look the key up in startPrivateKeyOperation().
+  const bool offload = private_key_method_provider_ != nullptr;
+  return SSL_set_chain_and_key(client_hello->ssl, certs.data(), certs.size(),
+                               offload ? nullptr : certificate->private_key_.get(),
+                               offload ? &private_key_method_ : nullptr) == 1;
+}
+
+void ServerContextImpl::loadCertificates() {
+  for (const ServerContextConfig::CertificateFiles& files : certificate_files_) {
+    certificates_.emplace_back();
+    Certificate& certificate = certificates_.back();
+
+    bssl::UniquePtr<BIO> bio(BIO_new_file(files.cert_chain_file_.c_str(), "r"));
+    while (bio != nullptr) {
+      bssl::UniquePtr<X509> cert(PEM_read_bio_X509(bio.get(), nullptr, nullptr, nullptr));
+      if (cert == nullptr) {
+        break;
+      }
+
+      uint8_t* der = nullptr;
+      const int der_len = i2d_X509(cert.get(), &der);
+      bssl::UniquePtr<uint8_t> der_owner(der);
+      if (der_len <= 0) {
+        break;
+      }
+      certificate.chain_.emplace_back(CRYPTO_BUFFER_new(der, der_len, nullptr));
+    }
+    // The end of the file is reported as an error.
+    ERR_clear_error();
+
+    if (certificate.chain_.empty()) {
+      throw EnvoyException(
+          fmt::format("Failed to load certificate chain file {}", files.cert_chain_file_));
+    }
+
+    bio.reset(BIO_new_file(files.private_key_file_.c_str(), "r"));
+    if (bio != nullptr) {
+      certificate.private_key_.reset(PEM_read_bio_PrivateKey(bio.get(), nullptr, nullptr, nullptr));
+    }
+    if (certificate.private_key_ == nullptr) {
+      ERR_clear_error();
+      throw EnvoyException(
+          fmt::format("Failed to load private key file {}", files.private_key_file_));
+    }
+  }
+
+  for (const Certificate& certificate : certificates_) {
+    EVP_PKEY* key = certificate.private_key_.get();
+    const Certificate*& slot =
+        EVP_PKEY_id(key) == EVP_PKEY_EC ? ecdsa_certificate_ : rsa_certificate_;
+    if (slot != nullptr) {
+      throw EnvoyException("Only one ECDSA and one RSA certificate can be served by a context");
+    }
+    slot = &certificate;
+  }
+
+  // isClientEcdsaCapable() only looks for the P-256 curve.
+  if (ecdsa_certificate_ != nullptr && rsa_certificate_ != nullptr &&
+      EC_GROUP_get_curve_name(EC_KEY_get0_group(EVP_PKEY_get0_EC_KEY(
+          ecdsa_certificate_->private_key_.get()))) != NID_X9_62_prime256v1) {
+    throw EnvoyException("Only P-256 ECDSA certificates can be served with an RSA certificate");
+  }
+}
+
+bool ServerContextImpl::isClientEcdsaCapable(const SSL_CLIENT_HELLO* client_hello) const {
+  const uint8_t* data;
+  size_t len;
+  CBS extension, list;
+
+  // With TLS 1.3 the cipher suites are independent of the certificate type, and the signature
+  // algorithms are enough to tell.
+  const bool tls13 =
+      max_protocol_version_ >= TLS1_3_VERSION &&
+      SSL_early_callback_ctx_extension_get(client_hello, TLSEXT_TYPE_supported_versions, &data,
+                                           &len);
+
+  // Clients which don't send signature algorithms accept ECDSA with SHA-1 before TLS 1.2.
+  if (SSL_early_callback_ctx_extension_get(client_hello, TLSEXT_TYPE_signature_algorithms, &data,
+                                           &len)) {
+    CBS_init(&extension, data, len);
+    if (!CBS_get_u16_length_prefixed(&extension, &list) ||
+        !cbsContainsU16(list, SSL_SIGN_ECDSA_SECP256R1_SHA256)) {
+      return false;
+    }
+  } else if (tls13) {
+    return false;
+  }
+  if (tls13) {
+    return true;
+  }
+
+  // Before TLS 1.3, the client must support the curve of the certificate, and offer a cipher suite
+  // authenticated by ECDSA.
+  if (!SSL_early_callback_ctx_extension_get(client_hello, TLSEXT_TYPE_supported_groups, &data,
+                                            &len)) {
+    return false;
+  }
+  CBS_init(&extension, data, len);
+  if (!CBS_get_u16_length_prefixed(&extension, &list) ||
+      !cbsContainsU16(list, SSL_CURVE_SECP256R1)) {
+    return false;
+  }
+
+  CBS_init(&list, client_hello->cipher_suites, client_hello->cipher_suites_len);
+  for (uint16_t cipher_suite : ecdsa_cipher_suites_) {
+    if (cbsContainsU16(list, cipher_suite)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+EVP_PKEY* ServerContextImpl::privateKey(PrivateKeyOperation::Type type,
+                                        uint16_t signature_algorithm) const {
+  // The signature algorithm tells which of the certificates the connection was served.
+  const Certificate* certificate = rsa_certificate_;
+  if (type == PrivateKeyOperation::Type::Sign &&
+      SSL_get_signature_algorithm_key_type(signature_algorithm) == EVP_PKEY_EC) {
+    certificate = ecdsa_certificate_;
+  }
+  return certificate != nullptr ? certificate->private_key_.get() : nullptr;
+}
+
 int ServerContextImpl::sessionTicketProcess(SSL*, uint8_t* key_name, uint8_t* iv,
                                             EVP_CIPHER_CTX* ctx, HMAC_CTX* hmac_ctx, int encrypt) {
   const EVP_MD* hmac = EVP_sha256();
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <chrono>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "envoy/common/time.h"
 #include "envoy/runtime/runtime.h"
 #include "envoy/ssl/context.h"
 #include "envoy/ssl/context_config.h"
@@ -11,6 +15,7 @@
 
 #include "common/ssl/context_impl.h"
 #include "common/ssl/context_manager_impl.h"
+#include "common/ssl/private_key_method_provider.h"
 
 #include "openssl/ssl.h"
 
@@ -26,12 +31,19 @@ namespace Ssl {
   COUNTER(connection_error)                                                                        \
   COUNTER(handshake)                                                                               \
   COUNTER(session_reused)                                                                          \
+  COUNTER(early_data_accepted)                                                                     \
   COUNTER(no_certificate)                                                                          \
   COUNTER(fail_no_sni_match)                                                                       \
   COUNTER(fail_verify_no_cert)                                                                     \
   COUNTER(fail_verify_error)                                                                       \
   COUNTER(fail_verify_san)                                                                         \
-  COUNTER(fail_verify_cert_hash)
+  COUNTER(fail_verify_cert_hash)                                                                   \
+  COUNTER(fail_load_certificate)                                                                   \
+  COUNTER(kernel_tls_tx)                                                                           \
+  COUNTER(private_key_operation_offloaded)                                                         \
+  COUNTER(session_cache_hit)                                                                       \
+  COUNTER(session_cache_miss)                                                                      \
+  COUNTER(verify_cache_hit)
 // clang-format on
 
 /**
@@ -70,13 +82,35 @@ public:
 
   SslStats& stats() { return stats_; }
 
+  /**
+   * @return uint32_t the maximum size of the records written at the start of a connection and
+   * after it has been idle, or 0 if the record size isn't limited.
+   */
+  uint32_t initialRecordSize() const { return initial_record_size_; }
+
+  /**
+   * @return size_t the number of peer certificates whose successful verification is cached.
+   */
+  size_t cachedVerifications();
+
+  // Peer certificates which passed verification are trusted again without verifying their chain,
+  // SAN and hash, for up to VERIFICATION_CACHE_TTL. The cache belongs to the context, so a reload
+  // of the context starts over with an empty one.
+  static const size_t MAX_CACHED_VERIFICATIONS = 4096;
+  static constexpr std::chrono::seconds VERIFICATION_CACHE_TTL{60};
+
   // Ssl::Context
   size_t daysUntilFirstCertExpires() const override;
   std::string getCaCertInformation() const override;
   std::string getCertChainInformation() const override;
 
 protected:
-  ContextImpl(ContextManagerImpl& parent, Stats::Scope& scope, ContextConfig& config);
+  /**
+   * @param use_certificate_chain supplies whether to load the certificate chain and private key
+   *        into ctx_. Otherwise the subclass provides them to each connection.
+   */
+  ContextImpl(ContextManagerImpl& parent, Stats::Scope& scope, ContextConfig& config,
+              bool use_certificate_chain = true);
 
   /**
    * The global SSL-library index used for storing a pointer to the context
@@ -86,6 +120,8 @@ protected:
 
   static int verifyCallback(X509_STORE_CTX* store_ctx, void* arg);
   int verifyCertificate(X509* cert);
+  bool verificationCached(const std::string& digest);
+  void cacheVerification(const std::string& digest);
 
   /**
    * Verifies certificate hash for pinning. The hash is the SHA-256 has of the DER encoding of the
@@ -118,9 +154,14 @@ protected:
   bssl::UniquePtr<X509> cert_chain_;
   std::string ca_file_path_;
   std::string cert_chain_file_path_;
+  std::string private_key_file_path_;
   const uint16_t min_protocol_version_;
   const uint16_t max_protocol_version_;
   const std::string ecdh_curves_;
+  const uint32_t initial_record_size_;
+  std::mutex verification_lock_;
+  // SHA-256 digest of the peer certificate to the time its verification expires.
+  std::unordered_map<std::string, MonotonicTime> verifications_;
 };
 
 class ClientContextImpl : public ContextImpl, public ClientContext {
@@ -130,8 +171,29 @@ public:
 
   bssl::UniquePtr<SSL> newSsl() const override;
 
+  /**
+   * Offer the session cached for an upstream on a new connection to it, and cache the sessions
+   * the connection gets in turn. The server name indication is the same for all connections of the
+   * context, so the upstream address is enough to key the sessions.
+   * @param ssl supplies the new connection.
+   * @param session_key supplies the key of the upstream, e.g. its address.
+   */
+  void resumeSession(SSL* ssl, const std::string& session_key);
+
+  /**
+   * @return size_t the number of upstreams with a cached session.
+   */
+  size_t cachedSessions();
+
+  static const size_t MAX_CACHED_SESSIONS = 1024;
+
 private:
+  static int sessionKeyIndex();
+  void cacheSession(const std::string& session_key, bssl::UniquePtr<SSL_SESSION> session);
+
   std::string server_name_indication_;
+  std::mutex session_lock_;
+  std::unordered_map<std::string, bssl::UniquePtr<SSL_SESSION>> sessions_;
 };
 
 class ServerContextImpl : public ContextImpl, public ServerContext {
@@ -146,10 +208,33 @@ private:
   ssl_select_cert_result_t processClientHello(const SSL_CLIENT_HELLO* client_hello);
   void updateConnectionContext(SSL* ssl);
 
+  struct Certificate {
+    std::vector<bssl::UniquePtr<CRYPTO_BUFFER>> chain_;
+    bssl::UniquePtr<EVP_PKEY> private_key_;
+  };
+
+  /**
+   * Provide the certificate chain and private key suiting the client to a connection, loading
+   * them on first use if lazy_certificate_chain_.
+   * @return bool whether they could be loaded.
+   */
+  bool useCertificates(const SSL_CLIENT_HELLO* client_hello);
+  void loadCertificates();
+  bool isClientEcdsaCapable(const SSL_CLIENT_HELLO* client_hello) const;
+  EVP_PKEY* privateKey(PrivateKeyOperation::Type type, uint16_t signature_algorithm) const;
+
   int alpnSelectCallback(const unsigned char** out, unsigned char* outlen, const unsigned char* in,
                          unsigned int inlen);
   int sessionTicketProcess(SSL* ssl, uint8_t* key_name, uint8_t* iv, EVP_CIPHER_CTX* ctx,
                            HMAC_CTX* hmac_ctx, int encrypt);
+  ssl_private_key_result_t startPrivateKeyOperation(SSL* ssl, PrivateKeyOperation::Type type,
+                                                    uint16_t signature_algorithm,
+                                                    const uint8_t* in, size_t in_len);
+  static ServerContextImpl& fromSsl(SSL* ssl);
+  SSL_SESSION* getSession(const uint8_t* id, int id_len);
+
+  // Hands the private key operations of handshakes to private_key_method_provider_.
+  static const SSL_PRIVATE_KEY_METHOD private_key_method_;
 
   const std::string listener_name_;
   const std::vector<std::string> server_names_;
@@ -157,6 +242,25 @@ private:
   Runtime::Loader& runtime_;
   std::vector<uint8_t> parsed_alt_alpn_protocols_;
   const std::vector<ServerContextConfig::SessionTicketKey> session_ticket_keys_;
+  PrivateKeyMethodProviderSharedPtr private_key_method_provider_;
+  SessionCacheImplSharedPtr session_cache_;
+  const std::vector<ServerContextConfig::CertificateFiles> certificate_files_;
+  // Whether the certificate chain and private key are only loaded once SNI first selects this
+  // context. They are then provided to each connection instead of being part of ctx_, which other
+  // workers may be using meanwhile.
+  const bool lazy_certificate_chain_;
+  // Whether the certificates are provided to each connection rather than being part of ctx_,
+  // either since they are loaded lazily or since there is one for ECDSA and one for RSA.
+  const bool per_connection_certificates_;
+  std::mutex certificates_lock_;
+  bool certificates_loaded_{};
+  std::vector<Certificate> certificates_;
+  // Both are left alone once loaded, so they can be used without the lock. Either may be null if
+  // the context only has certificates of the other type.
+  const Certificate* ecdsa_certificate_{};
+  const Certificate* rsa_certificate_{};
+  // The cipher suites enabled in ctx_ which authenticate with ECDSA, by IANA number.
+  std::vector<uint16_t> ecdsa_cipher_suites_;
 };
 
 } // namespace Ssl
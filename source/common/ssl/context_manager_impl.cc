@@ -27,27 +27,31 @@ void ContextManagerImpl::releaseServerContext(ServerContext* context,
   std::unique_lock<std::shared_timed_mutex> lock(contexts_lock_);
 
   // Remove mappings.
-  auto& listener_map_exact = map_exact_[listener_name];
-  if (server_names.empty()) {
-    const auto ctx = listener_map_exact.find(EMPTY_STRING);
-    if (ctx != listener_map_exact.end() && ctx->second == context) {
-      listener_map_exact.erase(ctx);
+  const auto index = server_name_indexes_.find(listener_name);
+  if (index != server_name_indexes_.end()) {
+    auto remove = [context](std::unordered_map<std::string, ServerContext*>& map,
+                            const std::string& key) -> void {
+      const auto ctx = map.find(key);
+      if (ctx != map.end() && ctx->second == context) {
+        map.erase(ctx);
+      }
+    };
+
+    if (server_names.empty()) {
+      remove(index->second.exact_, EMPTY_STRING);
     }
-  } else {
-    auto& listener_map_wildcard = map_wildcard_[listener_name];
     for (const auto& name : server_names) {
       if (isWildcardServerName(name)) {
-        const auto ctx = listener_map_wildcard.find(name);
-        if (ctx != listener_map_wildcard.end() && ctx->second == context) {
-          listener_map_wildcard.erase(ctx);
-        }
+        remove(index->second.wildcard_, name.substr(1));
       } else {
-        const auto ctx = listener_map_exact.find(name);
-        if (ctx != listener_map_exact.end() && ctx->second == context) {
-          listener_map_exact.erase(ctx);
-        }
+        remove(index->second.exact_, name);
       }
     }
+
+    // Listeners come and go, so don't leave their indexes behind.
+    if (index->second.exact_.empty() && index->second.wildcard_.empty()) {
+      server_name_indexes_.erase(index);
+    }
   }
 
   // context may not be found, in the case that a subclass of Context throws
@@ -77,15 +81,15 @@ ServerContextPtr ContextManagerImpl::createSslServerContext(
   contexts_.emplace_back(context.get());
 
   // Save mappings.
+  ServerNameIndex& index = server_name_indexes_[listener_name];
   if (server_names.empty()) {
-    map_exact_[listener_name][EMPTY_STRING] = context.get();
-  } else {
-    for (const auto& name : server_names) {
-      if (isWildcardServerName(name)) {
-        map_wildcard_[listener_name][name] = context.get();
-      } else {
-        map_exact_[listener_name][name] = context.get();
-      }
+    index.exact_[EMPTY_STRING] = context.get();
+  }
+  for (const auto& name : server_names) {
+    if (isWildcardServerName(name)) {
+      index.wildcard_[name.substr(1)] = context.get();
+    } else {
+      index.exact_[name] = context.get();
     }
   }
 
@@ -104,35 +108,29 @@ ServerContext* ContextManagerImpl::findSslServerContext(const std::string& liste
   std::shared_lock<std::shared_timed_mutex> lock(contexts_lock_);
 
   // TODO(PiotrSikora): refactor and combine code with RouteMatcher::findVirtualHost().
-  const auto listener_map_exact = map_exact_.find(listener_name);
-  if (listener_map_exact != map_exact_.end()) {
-    const auto ctx = listener_map_exact->second.find(server_name);
-    if (ctx != listener_map_exact->second.end()) {
-      return ctx->second;
-    }
+  const auto index = server_name_indexes_.find(listener_name);
+  if (index == server_name_indexes_.end()) {
+    return nullptr;
   }
 
-  // Try to construct and match wildcard domain.
-  const size_t pos = server_name.find('.');
-  if (pos > 0 && pos < server_name.size() - 1) {
-    const std::string wildcard = '*' + server_name.substr(pos);
-    const auto listener_map_wildcard = map_wildcard_.find(listener_name);
-    if (listener_map_wildcard != map_wildcard_.end()) {
-      const auto ctx = listener_map_wildcard->second.find(wildcard);
-      if (ctx != listener_map_wildcard->second.end()) {
-        return ctx->second;
-      }
-    }
+  const auto& exact = index->second.exact_;
+  const auto ctx = exact.find(server_name);
+  if (ctx != exact.end()) {
+    return ctx->second;
   }
 
-  if (listener_map_exact != map_exact_.end()) {
-    const auto ctx = listener_map_exact->second.find(EMPTY_STRING);
-    if (ctx != listener_map_exact->second.end()) {
+  // Try to match the wildcard domain, by the suffix after the first label.
+  const auto& wildcard = index->second.wildcard_;
+  const size_t pos = server_name.find('.');
+  if (!wildcard.empty() && pos > 0 && pos < server_name.size() - 1) {
+    const auto ctx = wildcard.find(server_name.substr(pos));
+    if (ctx != wildcard.end()) {
       return ctx->second;
     }
   }
 
-  return nullptr;
+  const auto default_ctx = exact.find(EMPTY_STRING);
+  return default_ctx != exact.end() ? default_ctx->second : nullptr;
 }
 
 size_t ContextManagerImpl::daysUntilFirstCertExpires() const {
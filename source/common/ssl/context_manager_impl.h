@@ -8,6 +8,9 @@
 #include "envoy/runtime/runtime.h"
 #include "envoy/ssl/context_manager.h"
 
+#include "common/ssl/private_key_method_provider.h"
+#include "common/ssl/session_cache_impl.h"
+
 namespace Envoy {
 namespace Ssl {
 
@@ -32,6 +35,57 @@ public:
   void releaseServerContext(ServerContext* context, const std::string& listener_name,
                             const std::vector<std::string>& server_names);
 
+  /**
+   * Set the provider which runs the private key operations of server contexts created after this
+   * call, instead of the worker handling the handshake.
+   * @param provider supplies the provider, or nullptr to run the operations inline.
+   */
+  void setPrivateKeyMethodProvider(PrivateKeyMethodProviderSharedPtr provider) {
+    private_key_method_provider_ = provider;
+  }
+
+  /**
+   * @return PrivateKeyMethodProviderSharedPtr the provider set by setPrivateKeyMethodProvider().
+   */
+  PrivateKeyMethodProviderSharedPtr privateKeyMethodProvider() const {
+    return private_key_method_provider_;
+  }
+
+  /**
+   * Set the session cache shared by the server contexts created after this call, instead of each
+   * context using BoringSSL's internal session cache.
+   * @param session_cache supplies the cache, or nullptr to use the internal caches.
+   */
+  void setSessionCache(SessionCacheImplSharedPtr session_cache) { session_cache_ = session_cache; }
+
+  /**
+   * @return SessionCacheImplSharedPtr the cache set by setSessionCache().
+   */
+  SessionCacheImplSharedPtr sessionCache() const { return session_cache_; }
+
+  /**
+   * Set whether server contexts created after this call which are selected by SNI only load their
+   * certificate chain and private key once they are first selected. Errors in them then fail the
+   * handshakes rather than the configuration.
+   */
+  void setLazyCertificateLoading(bool lazy) { lazy_certificate_loading_ = lazy; }
+
+  /**
+   * @return bool the value set by setLazyCertificateLoading().
+   */
+  bool lazyCertificateLoading() const { return lazy_certificate_loading_; }
+
+  /**
+   * Set whether server contexts created after this call accept TLS 1.3 early data on resumed
+   * connections. Requests read from early data may be replays, see Ssl::Connection.
+   */
+  void setEarlyData(bool early_data) { early_data_ = early_data; }
+
+  /**
+   * @return bool the value set by setEarlyData().
+   */
+  bool earlyData() const { return early_data_; }
+
   // Ssl::ContextManager
   Ssl::ClientContextPtr createSslClientContext(Stats::Scope& scope,
                                                ClientContextConfig& config) override;
@@ -45,13 +99,26 @@ public:
   void iterateContexts(std::function<void(const Context&)> callback) override;
 
 private:
+  /**
+   * The server contexts of a listener, indexed by the server names they are selected for. Exact
+   * names are indexed as is, wildcard names by their suffix, e.g. ".example.com" for
+   * "*.example.com", so that selection takes at most three lookups however many names there are.
+   */
+  struct ServerNameIndex {
+    std::unordered_map<std::string, ServerContext*> exact_;
+    std::unordered_map<std::string, ServerContext*> wildcard_;
+  };
+
   static bool isWildcardServerName(const std::string& name);
 
   Runtime::Loader& runtime_;
+  PrivateKeyMethodProviderSharedPtr private_key_method_provider_;
+  SessionCacheImplSharedPtr session_cache_;
+  bool lazy_certificate_loading_{};
+  bool early_data_{};
   std::list<Context*> contexts_;
   mutable std::shared_timed_mutex contexts_lock_;
-  std::unordered_map<std::string, std::unordered_map<std::string, ServerContext*>> map_exact_;
-  std::unordered_map<std::string, std::unordered_map<std::string, ServerContext*>> map_wildcard_;
+  std::unordered_map<std::string, ServerNameIndex> server_name_indexes_;
 };
 
 } // namespace Ssl
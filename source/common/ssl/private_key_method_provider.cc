@@ -0,0 +1,204 @@
+#include "common/ssl/private_key_method_provider.h"
+
+#include <cstring>
+
+#include "common/common/assert.h"
+#include "common/common/macros.h"
+
+#include "openssl/digest.h"
+#include "openssl/err.h"
+#include "openssl/evp.h"
+#include "openssl/rsa.h"
+
+namespace Envoy {
+namespace Ssl {
+
+PrivateKeyOperation::PrivateKeyOperation(Type type, EVP_PKEY& key, uint16_t signature_algorithm,
+                                         const uint8_t* in, size_t in_len)
+    : type_(type), key_(&key), signature_algorithm_(signature_algorithm), input_(in, in + in_len) {
+  EVP_PKEY_up_ref(&key);
+}
+
+void PrivateKeyOperation::run() {
+  std::vector<uint8_t> output;
+  const bool succeeded = type_ == Type::Sign ? sign(output) : decrypt(output);
+  // Failures are reported through the result, so don't leave errors behind on this thread.
+  ERR_clear_error();
+  setResult(succeeded, std::move(output));
+}
+
+bool PrivateKeyOperation::sign(std::vector<uint8_t>& output) const {
+  const EVP_MD* md = SSL_get_signature_algorithm_digest(signature_algorithm_);
+  bssl::ScopedEVP_MD_CTX ctx;
+  EVP_PKEY_CTX* pkey_ctx;
+  if (md == nullptr || !EVP_DigestSignInit(ctx.get(), &pkey_ctx, md, nullptr, key_.get())) {
+    return false;
+  }
+
+  if (SSL_is_signature_algorithm_rsa_pss(signature_algorithm_) &&
+      (!EVP_PKEY_CTX_set_rsa_padding(pkey_ctx, RSA_PKCS1_PSS_PADDING) ||
+       !EVP_PKEY_CTX_set_rsa_pss_saltlen(pkey_ctx, -1))) {
+    return false;
+  }
+
+  size_t output_len = EVP_PKEY_size(key_.get());
+  output.resize(output_len);
+  if (!EVP_DigestSignUpdate(ctx.get(), input_.data(), input_.size()) ||
+      !EVP_DigestSignFinal(ctx.get(), output.data(), &output_len)) {
+    return false;
+  }
+
+  output.resize(output_len);
+  return true;
+}
+
+bool PrivateKeyOperation::decrypt(std::vector<uint8_t>& output) const {
+  RSA* rsa = EVP_PKEY_get0_RSA(key_.get());
+  if (rsa == nullptr) {
+    return false;
+  }
+
+  size_t output_len;
+  output.resize(RSA_size(rsa));
+  if (!RSA_decrypt(rsa, &output_len, output.data(), output.size(), input_.data(), input_.size(),
+                   RSA_NO_PADDING)) {
+    return false;
+  }
+
+  output.resize(output_len);
+  return true;
+}
+
+void PrivateKeyOperation::setResult(bool succeeded, std::vector<uint8_t>&& output) {
+  succeeded_ = succeeded;
+  output_ = std::move(output);
+
+  std::unique_lock<std::mutex> lock(lock_);
+  if (dispatcher_ == nullptr) {
+    return;
+  }
+
+  PrivateKeyOperationSharedPtr operation = shared_from_this();
+  dispatcher_->post([operation]() -> void {
+    // Cancellation happens on this thread, so on_complete_ can't be cleared while this runs.
+    if (operation->on_complete_) {
+      operation->complete_ = true;
+      operation->on_complete_();
+    }
+  });
+}
+
+ThreadPoolPrivateKeyMethodProvider::ThreadPoolPrivateKeyMethodProvider(uint32_t num_threads) {
+  ASSERT(num_threads > 0);
+  for (uint32_t i = 0; i < num_threads; i++) {
+    threads_.emplace_back(new Thread::Thread([this]() -> void { threadRoutine(); }));
+  }
+}
+
+ThreadPoolPrivateKeyMethodProvider::~ThreadPoolPrivateKeyMethodProvider() {
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    shutdown_ = true;
+  }
+
+  cv_.notify_all();
+  for (Thread::ThreadPtr& thread : threads_) {
+    thread->join();
+  }
+}
+
+void ThreadPoolPrivateKeyMethodProvider::startOperation(PrivateKeyOperationSharedPtr operation) {
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    operations_.emplace_back(std::move(operation));
+  }
+
+  cv_.notify_one();
+}
+
+void ThreadPoolPrivateKeyMethodProvider::threadRoutine() {
+  while (true) {
+    PrivateKeyOperationSharedPtr operation;
+    {
+      std::unique_lock<std::mutex> lock(lock_);
+      cv_.wait(lock, [this]() -> bool { return shutdown_ || !operations_.empty(); });
+      if (shutdown_) {
+        return;
+      }
+
+      operation = std::move(operations_.front());
+      operations_.pop_front();
+    }
+
+    operation->run();
+  }
+}
+
+PrivateKeyOperationState::PrivateKeyOperationState(Event::Dispatcher& dispatcher,
+                                                   std::function<void()> on_complete)
+    : dispatcher_(dispatcher), on_complete_(on_complete) {}
+
+int PrivateKeyOperationState::sslIndex() {
+  CONSTRUCT_ON_FIRST_USE(int, []() -> int {
+    int ssl_index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    RELEASE_ASSERT(ssl_index >= 0);
+    return ssl_index;
+  }());
+}
+
+PrivateKeyOperationState* PrivateKeyOperationState::fromSsl(SSL* ssl) {
+  return static_cast<PrivateKeyOperationState*>(SSL_get_ex_data(ssl, sslIndex()));
+}
+
+void PrivateKeyOperationState::attach(SSL* ssl) {
+  int rc = SSL_set_ex_data(ssl, sslIndex(), this);
+  RELEASE_ASSERT(rc == 1);
+  UNREFERENCED_PARAMETER(rc);
+}
+
+ssl_private_key_result_t PrivateKeyOperationState::start(PrivateKeyMethodProvider& provider,
+                                                         PrivateKeyOperationSharedPtr operation) {
+  ASSERT(!pending_);
+  // The operation isn't shared with the provider yet, so this needs no lock.
+  operation->dispatcher_ = &dispatcher_;
+  operation->on_complete_ = on_complete_;
+  pending_ = operation;
+  provider.startOperation(operation);
+  return ssl_private_key_retry;
+}
+
+ssl_private_key_result_t PrivateKeyOperationState::complete(uint8_t* out, size_t* out_len,
+                                                            size_t max_out) {
+  if (!pending_) {
+    return ssl_private_key_failure;
+  }
+
+  if (!pending_->complete_) {
+    return ssl_private_key_retry;
+  }
+
+  PrivateKeyOperationSharedPtr operation = std::move(pending_);
+  if (!operation->succeeded_ || operation->output_.size() > max_out) {
+    return ssl_private_key_failure;
+  }
+
+  memcpy(out, operation->output_.data(), operation->output_.size());
+  *out_len = operation->output_.size();
+  return ssl_private_key_success;
+}
+
+void PrivateKeyOperationState::cancel() {
+  if (!pending_) {
+    return;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(pending_->lock_);
+    pending_->dispatcher_ = nullptr;
+  }
+  pending_->on_complete_ = nullptr;
+  pending_.reset();
+}
+
+} // namespace Ssl
+} // namespace Envoy
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "envoy/common/pure.h"
+#include "envoy/event/dispatcher.h"
+
+#include "common/common/thread.h"
+
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Ssl {
+
+/**
+ * A private key operation of a TLS handshake. The result is set by a PrivateKeyMethodProvider,
+ * possibly on another thread, and then handed back to the dispatcher of the connection.
+ */
+class PrivateKeyOperation : public std::enable_shared_from_this<PrivateKeyOperation> {
+public:
+  enum class Type { Sign, Decrypt };
+
+  PrivateKeyOperation(Type type, EVP_PKEY& key, uint16_t signature_algorithm, const uint8_t* in,
+                      size_t in_len);
+
+  /**
+   * Run the operation with the BoringSSL software implementation and set its result. This may be
+   * called on any thread.
+   */
+  void run();
+
+  /**
+   * Set the result of the operation and post its completion to the dispatcher that started it,
+   * unless the operation has been cancelled. This may be called on any thread, once.
+   * @param succeeded supplies whether the operation succeeded.
+   * @param output supplies the signature or the decrypted data.
+   */
+  void setResult(bool succeeded, std::vector<uint8_t>&& output);
+
+  Type type() const { return type_; }
+  EVP_PKEY& key() const { return *key_; }
+  uint16_t signatureAlgorithm() const { return signature_algorithm_; }
+  const std::vector<uint8_t>& input() const { return input_; }
+
+private:
+  friend class PrivateKeyOperationState;
+
+  bool sign(std::vector<uint8_t>& output) const;
+  bool decrypt(std::vector<uint8_t>& output) const;
+
+  const Type type_;
+  bssl::UniquePtr<EVP_PKEY> key_;
+  const uint16_t signature_algorithm_;
+  const std::vector<uint8_t> input_;
+  std::vector<uint8_t> output_;
+  bool succeeded_{};
+
+  // Set up by PrivateKeyOperationState. The lock protects dispatcher_, which is cleared when the
+  // operation is cancelled. The other members are only used on the dispatcher's thread.
+  std::mutex lock_;
+  Event::Dispatcher* dispatcher_{};
+  std::function<void()> on_complete_;
+  bool complete_{};
+};
+
+typedef std::shared_ptr<PrivateKeyOperation> PrivateKeyOperationSharedPtr;
+
+/**
+ * Runs private key operations on behalf of TLS handshakes, so that they don't stall the worker
+ * handling the handshake. A provider may run them in software on other threads or hand them to a
+ * hardware accelerator.
+ */
+class PrivateKeyMethodProvider {
+public:
+  virtual ~PrivateKeyMethodProvider() {}
+
+  /**
+   * Start a private key operation. The provider must call setResult() on the operation once it
+   * completes, on any thread. Operations may be dropped if the provider is destroyed first.
+   * @param operation supplies the operation to run.
+   */
+  virtual void startOperation(PrivateKeyOperationSharedPtr operation) PURE;
+};
+
+typedef std::shared_ptr<PrivateKeyMethodProvider> PrivateKeyMethodProviderSharedPtr;
+
+/**
+ * PrivateKeyMethodProvider which runs the operations in software on a pool of threads.
+ */
+class ThreadPoolPrivateKeyMethodProvider : public PrivateKeyMethodProvider {
+public:
+  ThreadPoolPrivateKeyMethodProvider(uint32_t num_threads);
+  ~ThreadPoolPrivateKeyMethodProvider();
+
+  // Ssl::PrivateKeyMethodProvider
+  void startOperation(PrivateKeyOperationSharedPtr operation) override;
+
+private:
+  void threadRoutine();
+
+  std::mutex lock_;
+  std::condition_variable cv_;
+  std::list<PrivateKeyOperationSharedPtr> operations_;
+  bool shutdown_{};
+  std::vector<Thread::ThreadPtr> threads_;
+};
+
+/**
+ * The private key operation of a connection, if any. This is owned by the transport socket of the
+ * connection and attached to its SSL, so that the private key method callbacks can find it. It is
+ * only used on the connection's thread.
+ */
+class PrivateKeyOperationState {
+public:
+  /**
+   * @param dispatcher supplies the dispatcher of the connection.
+   * @param on_complete supplies the callback to resume the handshake once an operation completes.
+   */
+  PrivateKeyOperationState(Event::Dispatcher& dispatcher, std::function<void()> on_complete);
+  ~PrivateKeyOperationState() { cancel(); }
+
+  /**
+   * @return PrivateKeyOperationState* the state attached to ssl, or nullptr if there is none.
+   */
+  static PrivateKeyOperationState* fromSsl(SSL* ssl);
+
+  /**
+   * Attach the state to an SSL.
+   */
+  void attach(SSL* ssl);
+
+  /**
+   * Start an operation, to be completed with complete() once on_complete has been called.
+   * @param provider supplies the provider to run the operation.
+   * @param operation supplies the operation.
+   * @return ssl_private_key_result_t the result to return from the private key method.
+   */
+  ssl_private_key_result_t start(PrivateKeyMethodProvider& provider,
+                                 PrivateKeyOperationSharedPtr operation);
+
+  /**
+   * Copy out the result of the pending operation. This implements the complete callback of
+   * SSL_PRIVATE_KEY_METHOD.
+   */
+  ssl_private_key_result_t complete(uint8_t* out, size_t* out_len, size_t max_out);
+
+  /**
+   * Cancel the pending operation, if any. Its result is then discarded.
+   */
+  void cancel();
+
+private:
+  static int sslIndex();
+
+  Event::Dispatcher& dispatcher_;
+  std::function<void()> on_complete_;
+  PrivateKeyOperationSharedPtr pending_;
+};
+
+typedef std::unique_ptr<PrivateKeyOperationState> PrivateKeyOperationStatePtr;
+
+} // namespace Ssl
+} // namespace Envoy
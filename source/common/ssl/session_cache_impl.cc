@@ -0,0 +1,98 @@
+#include "common/ssl/session_cache_impl.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Ssl {
+
+SessionCacheImpl::SessionCacheImpl(uint64_t max_sessions, uint32_t num_shards)
+    : max_sessions_per_shard_(std::max<uint64_t>(1, max_sessions / num_shards)) {
+  ASSERT(num_shards > 0);
+  for (uint32_t i = 0; i < num_shards; i++) {
+    shards_.emplace_back(new Shard());
+  }
+}
+
+std::string SessionCacheImpl::sessionId(const SSL_SESSION* session) {
+  unsigned int id_len;
+  const uint8_t* id = SSL_SESSION_get_id(session, &id_len);
+  return std::string(reinterpret_cast<const char*>(id), id_len);
+}
+
+SessionCacheImpl::Shard& SessionCacheImpl::shardFor(const std::string& id) {
+  // Session IDs are random, but hash them anyway so that short or structured IDs spread out too.
+  return *shards_[std::hash<std::string>()(id) % shards_.size()];
+}
+
+void SessionCacheImpl::insert(SSL_SESSION* session) {
+  std::string id = sessionId(session);
+  if (id.empty()) {
+    return;
+  }
+
+  SSL_SESSION_up_ref(session);
+  bssl::UniquePtr<SSL_SESSION> reference(session);
+  // Sessions evicted below are freed once the lock has been released.
+  SessionList evicted;
+
+  Shard& shard = shardFor(id);
+  std::unique_lock<std::mutex> lock(shard.lock_);
+  auto existing = shard.index_.find(id);
+  if (existing != shard.index_.end()) {
+    evicted.splice(evicted.end(), shard.sessions_, existing->second);
+    shard.index_.erase(existing);
+  }
+
+  shard.sessions_.emplace_front(id, std::move(reference));
+  shard.index_[id] = shard.sessions_.begin();
+  while (shard.sessions_.size() > max_sessions_per_shard_) {
+    shard.index_.erase(shard.sessions_.back().first);
+    evicted.splice(evicted.end(), shard.sessions_, std::prev(shard.sessions_.end()));
+  }
+}
+
+bssl::UniquePtr<SSL_SESSION> SessionCacheImpl::lookup(const uint8_t* id, size_t id_len) {
+  const std::string key(reinterpret_cast<const char*>(id), id_len);
+  Shard& shard = shardFor(key);
+  std::unique_lock<std::mutex> lock(shard.lock_);
+  auto entry = shard.index_.find(key);
+  if (entry == shard.index_.end()) {
+    return nullptr;
+  }
+
+  shard.sessions_.splice(shard.sessions_.begin(), shard.sessions_, entry->second);
+  SSL_SESSION* session = entry->second->second.get();
+  SSL_SESSION_up_ref(session);
+  return bssl::UniquePtr<SSL_SESSION>(session);
+}
+
+void SessionCacheImpl::remove(SSL_SESSION* session) {
+  const std::string id = sessionId(session);
+  // Freed once the lock has been released.
+  SessionList removed;
+
+  Shard& shard = shardFor(id);
+  std::unique_lock<std::mutex> lock(shard.lock_);
+  auto entry = shard.index_.find(id);
+  // Only remove the session itself, not a newer session which reused its ID.
+  if (entry != shard.index_.end() && entry->second->second.get() == session) {
+    removed.splice(removed.end(), shard.sessions_, entry->second);
+    shard.index_.erase(entry);
+  }
+}
+
+uint64_t SessionCacheImpl::size() {
+  uint64_t size = 0;
+  for (std::unique_ptr<Shard>& shard : shards_) {
+    std::unique_lock<std::mutex> lock(shard->lock_);
+    size += shard->sessions_.size();
+  }
+  return size;
+}
+
+} // namespace Ssl
+} // namespace Envoy
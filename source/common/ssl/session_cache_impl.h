@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Ssl {
+
+/**
+ * Server side TLS session cache keyed by session ID, which can be shared by the server contexts of
+ * all listeners and used from all workers at once. The cache is split into shards, each with its
+ * own lock and least recently used eviction, so that workers resuming different sessions rarely
+ * contend. Sessions are only resumed if their session ID context matches the context of the
+ * connection, which BoringSSL checks after the lookup.
+ */
+class SessionCacheImpl {
+public:
+  /**
+   * @param max_sessions supplies the maximum number of sessions held by the cache.
+   * @param num_shards supplies the number of independently locked shards.
+   */
+  SessionCacheImpl(uint64_t max_sessions, uint32_t num_shards = DEFAULT_NUM_SHARDS);
+
+  /**
+   * Add a session to the cache, replacing any session with the same ID.
+   * @param session supplies the session. The cache takes its own reference.
+   */
+  void insert(SSL_SESSION* session);
+
+  /**
+   * Find a session.
+   * @param id supplies the session ID.
+   * @param id_len supplies the length of the session ID.
+   * @return bssl::UniquePtr<SSL_SESSION> a reference to the session, or nullptr if it isn't found.
+   */
+  bssl::UniquePtr<SSL_SESSION> lookup(const uint8_t* id, size_t id_len);
+
+  /**
+   * Remove a session from the cache, if it is present.
+   * @param session supplies the session.
+   */
+  void remove(SSL_SESSION* session);
+
+  /**
+   * @return uint64_t the number of sessions in the cache.
+   */
+  uint64_t size();
+
+  static const uint32_t DEFAULT_NUM_SHARDS = 16;
+
+private:
+  typedef std::list<std::pair<std::string, bssl::UniquePtr<SSL_SESSION>>> SessionList;
+
+  struct Shard {
+    std::mutex lock_;
+    // Most recently used first.
+    SessionList sessions_;
+    std::unordered_map<std::string, SessionList::iterator> index_;
+  };
+
+  static std::string sessionId(const SSL_SESSION* session);
+  Shard& shardFor(const std::string& id);
+
+  const uint64_t max_sessions_per_shard_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+typedef std::shared_ptr<SessionCacheImpl> SessionCacheImplSharedPtr;
+
+} // namespace Ssl
+} // namespace Envoy
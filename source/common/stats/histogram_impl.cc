@@ -0,0 +1,111 @@
+#include "common/stats/histogram_impl.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "common/common/assert.h"
+#include "common/common/macros.h"
+#include "common/common/utility.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Stats {
+
+size_t HistogramBuckets::index(uint64_t value) {
+  if (value < 16) {
+    return value;
+  }
+  if (value >> 32) {
+    return NUM_BUCKETS - 1;
+  }
+
+  // The bucket within a power of two range is given by the 3 bits after the most significant one.
+  const uint32_t msb = 63 - __builtin_clzll(value);
+  return 16 + (msb - 4) * 8 + ((value >> (msb - 3)) & 7);
+}
+
+uint64_t HistogramBuckets::lowerBound(size_t index) {
+  ASSERT(index < NUM_BUCKETS);
+  if (index < 16) {
+    return index;
+  }
+  const uint32_t msb = 4 + (index - 16) / 8;
+  return (8 + (index - 16) % 8) << (msb - 3);
+}
+
+uint64_t HistogramBuckets::upperBound(size_t index) {
+  ASSERT(index < NUM_BUCKETS);
+  if (index < 16) {
+    return index;
+  }
+  const uint32_t msb = 4 + (index - 16) / 8;
+  return lowerBound(index) + (1UL << (msb - 3)) - 1;
+}
+
+HistogramStatisticsImpl::HistogramStatisticsImpl()
+    : computed_quantiles_(supportedQuantiles().size(), std::nan("")) {}
+
+HistogramStatisticsImpl::HistogramStatisticsImpl(const std::vector<uint64_t>& counts)
+    : HistogramStatisticsImpl() {
+  ASSERT(counts.size() == HistogramBuckets::NUM_BUCKETS);
+  for (uint64_t count : counts) {
+    sample_count_ += count;
+  }
+  if (sample_count_ == 0) {
+    return;
+  }
+
+  // Walk the buckets once, finding the bucket of each quantile in turn.
+  const std::vector<double>& quantiles = supportedQuantiles();
+  size_t bucket = 0;
+  uint64_t below = 0;
+  for (size_t i = 0; i < quantiles.size(); i++) {
+    const double rank = quantiles[i] * sample_count_;
+    while (counts[bucket] == 0 || below + counts[bucket] < rank) {
+      below += counts[bucket];
+      bucket++;
+    }
+
+    const double lower = HistogramBuckets::lowerBound(bucket);
+    const double width = HistogramBuckets::upperBound(bucket) - lower + 1;
+    const double value = lower + width * (rank - below) / counts[bucket];
+    computed_quantiles_[i] =
+        std::min(value, static_cast<double>(HistogramBuckets::upperBound(bucket)));
+  }
+}
+
+std::string HistogramStatisticsImpl::quantileSummary() const {
+  std::vector<std::string> summary;
+  const std::vector<double>& quantiles = supportedQuantiles();
+  for (size_t i = 0; i < quantiles.size(); i++) {
+    summary.push_back(fmt::format("P{:g}: {:g}", 100 * quantiles[i], computed_quantiles_[i]));
+  }
+  return StringUtil::join(summary, ", ");
+}
+
+const std::vector<double>& HistogramStatisticsImpl::supportedQuantiles() const {
+  CONSTRUCT_ON_FIRST_USE(std::vector<double>, 0, 0.25, 0.5, 0.75, 0.9, 0.95, 0.99, 0.999, 1);
+}
+
+ThreadLocalHistogramImpl::ThreadLocalHistogramImpl() {
+  for (std::atomic<uint32_t>& count : counts_) {
+    count.store(0, std::memory_order_relaxed);
+  }
+  collected_counts_.fill(0);
+}
+
+void ThreadLocalHistogramImpl::collect(std::vector<uint64_t>& counts) {
+  ASSERT(counts.size() == HistogramBuckets::NUM_BUCKETS);
+  for (size_t i = 0; i < HistogramBuckets::NUM_BUCKETS; i++) {
+    const uint32_t count = counts_[i].load(std::memory_order_relaxed);
+    counts[i] += static_cast<uint32_t>(count - collected_counts_[i]);
+    collected_counts_[i] = count;
+  }
+}
+
+} // namespace Stats
+} // namespace Envoy
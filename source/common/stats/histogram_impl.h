@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/stats/stats.h"
+
+namespace Envoy {
+namespace Stats {
+
+/**
+ * Log-linear bucket layout of the thread local histograms. Values below 16 have a bucket each, and
+ * every power of two range above that is split into 8 buckets, so a bucket is at most 1/8th of the
+ * values in it wide. Values of 2^32 and above are counted in the last bucket.
+ */
+class HistogramBuckets {
+public:
+  static const size_t NUM_BUCKETS = 240;
+
+  /**
+   * @return size_t the index of the bucket which counts a value.
+   */
+  static size_t index(uint64_t value);
+
+  /**
+   * @return uint64_t the smallest value counted in a bucket.
+   */
+  static uint64_t lowerBound(size_t index);
+
+  /**
+   * @return uint64_t the largest value counted in a bucket.
+   */
+  static uint64_t upperBound(size_t index);
+};
+
+/**
+ * Quantiles of the values counted in a set of buckets. Values are assumed to be spread evenly
+ * within their bucket.
+ */
+class HistogramStatisticsImpl : public HistogramStatistics {
+public:
+  HistogramStatisticsImpl();
+
+  /**
+   * @param counts supplies the number of values in each of the HistogramBuckets.
+   */
+  HistogramStatisticsImpl(const std::vector<uint64_t>& counts);
+
+  // Stats::HistogramStatistics
+  std::string quantileSummary() const override;
+  const std::vector<double>& supportedQuantiles() const override;
+  const std::vector<double>& computedQuantiles() const override { return computed_quantiles_; }
+  uint64_t sampleCount() const override { return sample_count_; }
+
+private:
+  uint64_t sample_count_{};
+  std::vector<double> computed_quantiles_;
+};
+
+/**
+ * The values of a histogram recorded by one thread. Only that thread records, and the main thread
+ * collects the counts, so the counts are atomic to be read safely but are never contended.
+ */
+class ThreadLocalHistogramImpl {
+public:
+  ThreadLocalHistogramImpl();
+
+  /**
+   * Record a value. This must only be called by the thread the histogram belongs to.
+   */
+  void recordValue(uint64_t value) {
+    std::atomic<uint32_t>& count = counts_[HistogramBuckets::index(value)];
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Add the values recorded since the last call to a set of bucket counts. This must only be
+   * called by the main thread.
+   * @param counts supplies the bucket counts to add to.
+   */
+  void collect(std::vector<uint64_t>& counts);
+
+private:
+  // The counts wrap around, which is harmless as long as fewer than 2^32 values are recorded in a
+  // bucket between two collections.
+  std::array<std::atomic<uint32_t>, HistogramBuckets::NUM_BUCKETS> counts_;
+  std::array<uint32_t, HistogramBuckets::NUM_BUCKETS> collected_counts_;
+};
+
+typedef std::shared_ptr<ThreadLocalHistogramImpl> ThreadLocalHistogramImplSharedPtr;
+
+} // namespace Stats
+} // namespace Envoy
@@ -0,0 +1,38 @@
+#include "common/stats/lazy_scope.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace Envoy {
+namespace Stats {
+
+Counter& LazyScopeImpl::counter(const std::string& name) {
+  std::unique_lock<std::mutex> lock(lock_);
+  std::unique_ptr<LazyCounter>& counter = counters_[name];
+  if (!counter) {
+    counter.reset(new LazyCounter(parent_, name));
+  }
+  return *counter;
+}
+
+Gauge& LazyScopeImpl::gauge(const std::string& name) {
+  std::unique_lock<std::mutex> lock(lock_);
+  std::unique_ptr<LazyGauge>& gauge = gauges_[name];
+  if (!gauge) {
+    gauge.reset(new LazyGauge(parent_, name));
+  }
+  return *gauge;
+}
+
+Histogram& LazyScopeImpl::histogram(const std::string& name) {
+  std::unique_lock<std::mutex> lock(lock_);
+  std::unique_ptr<LazyHistogram>& histogram = histograms_[name];
+  if (!histogram) {
+    histogram.reset(new LazyHistogram(parent_, name));
+  }
+  return *histogram;
+}
+
+} // namespace Stats
+} // namespace Envoy
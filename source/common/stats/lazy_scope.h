@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "envoy/stats/stats.h"
+
+namespace Envoy {
+namespace Stats {
+
+/**
+ * A stat of a parent scope which is only created when it is first used. Creating the stat isn't
+ * synchronized, as concurrent first uses are given the same stat by the parent scope.
+ */
+template <class Base, Base& (Scope::*create)(const std::string&)>
+class LazyMetric : public Base {
+public:
+  LazyMetric(Scope& parent, const std::string& name) : parent_(parent), name_(name) {}
+
+  // Stats::Metric
+  const std::string& name() const override { return stat().name(); }
+  const std::vector<Tag>& tags() const override { return stat().tags(); }
+  const std::string& tagExtractedName() const override { return stat().tagExtractedName(); }
+
+protected:
+  /**
+   * @return Base* the stat if it has been created, or nullptr.
+   */
+  Base* created() const { return stat_.load(std::memory_order_acquire); }
+
+  /**
+   * @return Base& the stat, which is created if it hasn't been yet.
+   */
+  Base& stat() const {
+    Base* stat = created();
+    if (stat == nullptr) {
+      stat = &(parent_.*create)(name_);
+      stat_.store(stat, std::memory_order_release);
+    }
+    return *stat;
+  }
+
+private:
+  Scope& parent_;
+  const std::string name_;
+  mutable std::atomic<Base*> stat_{};
+};
+
+/**
+ * Counter which is created when it's first incremented. It reads as zero and unused until then.
+ */
+class LazyCounter : public LazyMetric<Counter, &Scope::counter> {
+public:
+  LazyCounter(Scope& parent, const std::string& name) : LazyMetric(parent, name) {}
+
+  // Stats::Counter
+  void add(uint64_t amount) override { stat().add(amount); }
+  void inc() override { stat().inc(); }
+  uint64_t latch() override { return created() ? created()->latch() : 0; }
+  void reset() override {
+    if (created()) {
+      created()->reset();
+    }
+  }
+  bool used() const override { return created() && created()->used(); }
+  uint64_t value() const override { return created() ? created()->value() : 0; }
+};
+
+/**
+ * Gauge which is created when it's first modified. It reads as zero and unused until then.
+ */
+class LazyGauge : public LazyMetric<Gauge, &Scope::gauge> {
+public:
+  LazyGauge(Scope& parent, const std::string& name) : LazyMetric(parent, name) {}
+
+  // Stats::Gauge
+  void add(uint64_t amount) override { stat().add(amount); }
+  void dec() override { stat().dec(); }
+  void inc() override { stat().inc(); }
+  bool latchChanged() override { return created() && created()->latchChanged(); }
+  void set(uint64_t value) override { stat().set(value); }
+  void sub(uint64_t amount) override { stat().sub(amount); }
+  bool used() const override { return created() && created()->used(); }
+  uint64_t value() const override { return created() ? created()->value() : 0; }
+};
+
+/**
+ * Histogram which is created when its first value is recorded.
+ */
+class LazyHistogram : public LazyMetric<Histogram, &Scope::histogram> {
+public:
+  LazyHistogram(Scope& parent, const std::string& name) : LazyMetric(parent, name) {}
+
+  // Stats::Histogram
+  void recordValue(uint64_t value) override { stat().recordValue(value); }
+};
+
+/**
+ * Scope whose stats are only created in the parent scope when they are first used, so that stats
+ * which are never used take neither memory nor a stat slot in the parent. The scope must outlive
+ * the references to its stats, and the parent scope must outlive the scope.
+ */
+class LazyScopeImpl : public Scope {
+public:
+  LazyScopeImpl(Scope& parent) : parent_(parent) {}
+
+  // Stats::Scope
+  ScopePtr createScope(const std::string& name) override { return parent_.createScope(name); }
+  void deliverHistogramToSinks(const Histogram& histogram, uint64_t value) override {
+    parent_.deliverHistogramToSinks(histogram, value);
+  }
+  Counter& counter(const std::string& name) override;
+  Gauge& gauge(const std::string& name) override;
+  Histogram& histogram(const std::string& name) override;
+
+private:
+  Scope& parent_;
+  std::mutex lock_;
+  std::unordered_map<std::string, std::unique_ptr<LazyCounter>> counters_;
+  std::unordered_map<std::string, std::unique_ptr<LazyGauge>> gauges_;
+  std::unordered_map<std::string, std::unique_ptr<LazyHistogram>> histograms_;
+};
+
+} // namespace Stats
+} // namespace Envoy
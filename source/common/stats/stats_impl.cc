@@ -1,5 +1,6 @@
 #include "common/stats/stats_impl.h"
 
+#include <ctype.h>
 #include <string.h>
 
 #include <algorithm>
@@ -62,7 +63,52 @@ std::string Utility::sanitizeStatsName(const std::string& name) {
 }
 
 TagExtractorImpl::TagExtractorImpl(const std::string& name, const std::string& regex)
-    : name_(name), regex_(regex) {}
+    : name_(name), prefix_(extractRegexPrefix(regex, prefix_anchored_)), regex_(regex) {}
+
+std::string TagExtractorImpl::extractRegexPrefix(const std::string& regex, bool& anchored) {
+  anchored = !regex.empty() && regex[0] == '^';
+
+  // An alternation outside of any group can match names which don't contain the text before it.
+  int depth = 0;
+  bool in_class = false;
+  for (size_t i = 0; i < regex.size(); i++) {
+    const char c = regex[i];
+    if (c == '\\') {
+      i++;
+    } else if (in_class) {
+      in_class = c != ']';
+    } else if (c == '[') {
+      in_class = true;
+    } else if (c == '(') {
+      depth++;
+    } else if (c == ')') {
+      depth--;
+    } else if (c == '|' && depth == 0) {
+      return "";
+    }
+  }
+
+  std::string prefix;
+  for (size_t i = anchored ? 1 : 0; i < regex.size(); i++) {
+    char c = regex[i];
+    if (c == '\\') {
+      // Escaped punctuation is literal, but escapes such as \d are character classes.
+      if (i + 1 == regex.size() || isalnum(regex[i + 1])) {
+        break;
+      }
+      c = regex[++i];
+    } else if (strchr(".[](){}*+?|^$", c) != nullptr) {
+      break;
+    }
+
+    // A character followed by a quantifier which allows zero repetitions is optional.
+    if (i + 1 < regex.size() && strchr("*?{", regex[i + 1]) != nullptr) {
+      break;
+    }
+    prefix.push_back(c);
+  }
+  return prefix;
+}
 
 TagExtractorPtr TagExtractorImpl::createTagExtractor(const std::string& name,
                                                      const std::string& regex) {
@@ -91,6 +137,13 @@ TagExtractorPtr TagExtractorImpl::createTagExtractor(const std::string& name,
 
 std::string TagExtractorImpl::extractTag(const std::string& tag_extracted_name,
                                          std::vector<Tag>& tags) const {
+  // Checking for the literal text of the regex first is much cheaper than running the regex on
+  // the names which can't match.
+  if (prefix_anchored_ ? tag_extracted_name.compare(0, prefix_.size(), prefix_) != 0
+                       : tag_extracted_name.find(prefix_) == std::string::npos) {
+    return tag_extracted_name;
+  }
+
   std::smatch match;
   // The regex must match and contain one or more subexpressions (all after the first are ignored).
   if (std::regex_search(tag_extracted_name, match, regex_) && match.size() > 1) {
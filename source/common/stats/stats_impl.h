@@ -38,8 +38,20 @@ public:
   std::string extractTag(const std::string& tag_extracted_name,
                          std::vector<Tag>& tags) const override;
 
+  /**
+   * Finds literal text which all of the names matched by a regex contain, so that names without
+   * it can be rejected without running the regex.
+   * @param regex supplies the regex.
+   * @param anchored is set to whether the regex is anchored at the start of the name, in which case
+   *        matched names start with the text.
+   * @return std::string the text, or an empty string if none was found.
+   */
+  static std::string extractRegexPrefix(const std::string& regex, bool& anchored);
+
 private:
   const std::string name_;
+  bool prefix_anchored_;
+  const std::string prefix_;
   const std::regex regex_;
 };
 
@@ -63,6 +75,8 @@ public:
 struct RawStatData {
   struct Flags {
     static const uint8_t Used = 0x1;
+    // Set by each gauge modification and cleared when the gauge is flushed.
+    static const uint8_t Changed = 0x2;
   };
 
   /**
@@ -241,18 +255,23 @@ public:
   // Stats::Gauge
   virtual void add(uint64_t amount) override {
     data_.value_ += amount;
-    data_.flags_ |= RawStatData::Flags::Used;
+    data_.flags_ |= RawStatData::Flags::Used | RawStatData::Flags::Changed;
   }
   virtual void dec() override { sub(1); }
   virtual void inc() override { add(1); }
+  virtual bool latchChanged() override {
+    const uint16_t changed = RawStatData::Flags::Changed;
+    return data_.flags_.fetch_and(~changed) & changed;
+  }
   virtual void set(uint64_t value) override {
     data_.value_ = value;
-    data_.flags_ |= RawStatData::Flags::Used;
+    data_.flags_ |= RawStatData::Flags::Used | RawStatData::Flags::Changed;
   }
   virtual void sub(uint64_t amount) override {
     ASSERT(data_.value_ >= amount);
     ASSERT(used());
     data_.value_ -= amount;
+    data_.flags_ |= RawStatData::Flags::Changed;
   }
   virtual uint64_t value() const override { return data_.value_; }
   bool used() const override { return data_.flags_ & RawStatData::Flags::Used; }
@@ -354,6 +373,10 @@ public:
   // Stats::Store
   std::list<CounterSharedPtr> counters() const override { return counters_.toList(); }
   std::list<GaugeSharedPtr> gauges() const override { return gauges_.toList(); }
+  // Histograms of the isolated store don't aggregate their values.
+  std::list<ParentHistogramSharedPtr> histograms() const override {
+    return std::list<ParentHistogramSharedPtr>{};
+  }
 
 private:
   struct ScopeImpl : public Scope {
@@ -1,5 +1,8 @@
 #include "common/stats/statsd.h"
 
+#include <string.h>
+#include <sys/socket.h>
+
 #include <chrono>
 #include <cstdint>
 #include <string>
@@ -18,7 +21,8 @@ namespace Envoy {
 namespace Stats {
 namespace Statsd {
 
-Writer::Writer(Network::Address::InstanceConstSharedPtr address) {
+Writer::Writer(Network::Address::InstanceConstSharedPtr address, uint32_t max_datagram_size)
+    : max_datagram_size_(max_datagram_size) {
   fd_ = address->socket(Network::Address::SocketType::Datagram);
   ASSERT(fd_ != -1);
 
@@ -35,12 +39,12 @@ Writer::~Writer() {
 
 void Writer::writeCounter(const std::string& name, uint64_t increment) {
   std::string message(fmt::format("envoy.{}:{}|c", name, increment));
-  send(message);
+  buffer(message);
 }
 
 void Writer::writeGauge(const std::string& name, uint64_t value) {
   std::string message(fmt::format("envoy.{}:{}|g", name, value));
-  send(message);
+  buffer(message);
 }
 
 void Writer::writeTimer(const std::string& name, const std::chrono::milliseconds& ms) {
@@ -48,15 +52,66 @@ void Writer::writeTimer(const std::string& name, const std::chrono::milliseconds
   send(message);
 }
 
+void Writer::flush() {
+  if (!current_datagram_.empty()) {
+    datagrams_.push_back(std::move(current_datagram_));
+    current_datagram_.clear();
+  }
+  sendDatagrams();
+}
+
+void Writer::buffer(const std::string& message) {
+  // statsd servers split datagrams into metrics at newlines.
+  if (!current_datagram_.empty() &&
+      current_datagram_.size() + 1 + message.size() <= max_datagram_size_) {
+    current_datagram_.push_back('\n');
+    current_datagram_.append(message);
+    return;
+  }
+
+  if (!current_datagram_.empty()) {
+    datagrams_.push_back(std::move(current_datagram_));
+    if (datagrams_.size() == MAX_DATAGRAMS_PER_SEND) {
+      sendDatagrams();
+    }
+  }
+  current_datagram_ = message;
+}
+
 void Writer::send(const std::string& message) {
   ::send(fd_, message.c_str(), message.size(), MSG_DONTWAIT);
 }
 
+void Writer::sendDatagrams() {
+  // Like send(), datagrams which the socket can't take without blocking are dropped.
+#ifdef __linux__
+  ASSERT(datagrams_.size() <= MAX_DATAGRAMS_PER_SEND);
+  mmsghdr messages[MAX_DATAGRAMS_PER_SEND];
+  iovec iovecs[MAX_DATAGRAMS_PER_SEND];
+  memset(messages, 0, sizeof(messages));
+  for (size_t i = 0; i < datagrams_.size(); i++) {
+    iovecs[i].iov_base = const_cast<char*>(datagrams_[i].data());
+    iovecs[i].iov_len = datagrams_[i].size();
+    messages[i].msg_hdr.msg_iov = &iovecs[i];
+    messages[i].msg_hdr.msg_iovlen = 1;
+  }
+  if (!datagrams_.empty()) {
+    ::sendmmsg(fd_, messages, datagrams_.size(), MSG_DONTWAIT);
+  }
+#else
+  for (const std::string& datagram : datagrams_) {
+    send(datagram);
+  }
+#endif
+  datagrams_.clear();
+}
+
 UdpStatsdSink::UdpStatsdSink(ThreadLocal::SlotAllocator& tls,
-                             Network::Address::InstanceConstSharedPtr address)
-    : tls_(tls.allocateSlot()), server_address_(address) {
+                             Network::Address::InstanceConstSharedPtr address,
+                             uint32_t max_datagram_size)
+    : tls_(tls.allocateSlot()), server_address_(address), max_datagram_size_(max_datagram_size) {
   tls_->set([this](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
-    return std::make_shared<Writer>(this->server_address_);
+    return std::make_shared<Writer>(this->server_address_, this->max_datagram_size_);
   });
 }
 
@@ -202,11 +257,14 @@ void TcpStatsdSink::TlsSink::write(Buffer::Instance& buffer) {
 
     connection_ = std::move(info.connection_);
     connection_->addConnectionCallbacks(*this);
-    connection_->setConnectionStats({parent_.cluster_info_->stats().upstream_cx_rx_bytes_total_,
-                                     parent_.cluster_info_->stats().upstream_cx_rx_bytes_buffered_,
-                                     parent_.cluster_info_->stats().upstream_cx_tx_bytes_total_,
-                                     parent_.cluster_info_->stats().upstream_cx_tx_bytes_buffered_,
-                                     &parent_.cluster_info_->stats().bind_errors_});
+    connection_->setConnectionStats(
+        {parent_.cluster_info_->stats().upstream_cx_rx_bytes_total_,
+         parent_.cluster_info_->stats().upstream_cx_rx_bytes_buffered_,
+         parent_.cluster_info_->stats().upstream_cx_tx_bytes_total_,
+         parent_.cluster_info_->stats().upstream_cx_tx_bytes_buffered_,
+         &parent_.cluster_info_->stats().bind_errors_,
+         &parent_.cluster_info_->stats().upstream_cx_rx_syscalls_total_,
+         &parent_.cluster_info_->stats().upstream_cx_tx_syscalls_total_});
     connection_->connect();
   }
 
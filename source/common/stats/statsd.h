@@ -3,6 +3,7 @@
 #include <chrono>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "envoy/local_info/local_info.h"
 #include "envoy/network/connection.h"
@@ -17,24 +18,44 @@ namespace Stats {
 namespace Statsd {
 
 /**
- * This is a simple UDP localhost writer for statsd messages.
+ * This is a simple UDP localhost writer for statsd messages. Counters and gauges are buffered
+ * until flush(), and are sent in datagrams of up to max_datagram_size bytes with as few syscalls
+ * as possible. Timers are sent as they are written.
  */
 class Writer : public ThreadLocal::ThreadLocalObject {
 public:
-  Writer(Network::Address::InstanceConstSharedPtr address);
+  /**
+   * @param address supplies the address of the statsd server.
+   * @param max_datagram_size supplies the maximum size of the datagrams which counters and gauges
+   *        are batched into, or 0 to send each of them in its own datagram.
+   */
+  Writer(Network::Address::InstanceConstSharedPtr address, uint32_t max_datagram_size);
   ~Writer();
 
   void writeCounter(const std::string& name, uint64_t increment);
   void writeGauge(const std::string& name, uint64_t value);
   void writeTimer(const std::string& name, const std::chrono::milliseconds& ms);
 
+  /**
+   * Send the buffered counters and gauges.
+   */
+  void flush();
+
   // Called in unit test to validate address.
   int getFdForTests() const { return fd_; };
 
 private:
+  void buffer(const std::string& message);
   void send(const std::string& message);
+  void sendDatagrams();
+
+  // The number of datagrams sent by a single sendmmsg().
+  static const size_t MAX_DATAGRAMS_PER_SEND = 64;
 
   int fd_;
+  const uint32_t max_datagram_size_;
+  std::string current_datagram_;
+  std::vector<std::string> datagrams_;
 };
 
 /**
@@ -42,13 +63,18 @@ private:
  */
 class UdpStatsdSink : public Sink {
 public:
-  UdpStatsdSink(ThreadLocal::SlotAllocator& tls, Network::Address::InstanceConstSharedPtr address);
+  UdpStatsdSink(ThreadLocal::SlotAllocator& tls, Network::Address::InstanceConstSharedPtr address,
+                uint32_t max_datagram_size);
 
   // Stats::Sink
   void beginFlush() override {}
+  // statsd counters are increments, and statsd servers keep the last value of each gauge.
+  bool changedStatsOnly() const override { return true; }
   void flushCounter(const Counter& counter, uint64_t delta) override;
   void flushGauge(const Gauge& gauge, uint64_t value) override;
-  void endFlush() override {}
+  // statsd computes quantiles itself from the individual values.
+  void flushHistogram(const ParentHistogram&) override {}
+  void endFlush() override { tls_->getTyped<Writer>().flush(); }
   void onHistogramComplete(const Histogram& histogram, uint64_t value) override;
 
   // Called in unit test to validate writer construction and address.
@@ -57,6 +83,7 @@ public:
 private:
   ThreadLocal::SlotPtr tls_;
   Network::Address::InstanceConstSharedPtr server_address_;
+  const uint32_t max_datagram_size_;
 };
 
 /**
@@ -71,6 +98,9 @@ public:
   // Stats::Sink
   void beginFlush() override { tls_->getTyped<TlsSink>().beginFlush(true); }
 
+  // statsd counters are increments, and statsd servers keep the last value of each gauge.
+  bool changedStatsOnly() const override { return true; }
+
   void flushCounter(const Counter& counter, uint64_t delta) override {
     tls_->getTyped<TlsSink>().flushCounter(counter.name(), delta);
   }
@@ -79,6 +109,9 @@ public:
     tls_->getTyped<TlsSink>().flushGauge(gauge.name(), value);
   }
 
+  // statsd computes quantiles itself from the individual values.
+  void flushHistogram(const ParentHistogram&) override {}
+
   void endFlush() override { tls_->getTyped<TlsSink>().endFlush(true); }
 
   void onHistogramComplete(const Histogram& histogram, uint64_t value) override {
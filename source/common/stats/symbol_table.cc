@@ -0,0 +1,82 @@
+#include "common/stats/symbol_table.h"
+
+#include <string>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Stats {
+
+std::string SymbolTable::encode(const std::string& name) {
+  std::string encoded;
+  std::unique_lock<std::mutex> lock(lock_);
+  size_t start = 0;
+  while (true) {
+    const size_t end = name.find('.', start);
+    if (end == std::string::npos) {
+      appendToken(name.substr(start), encoded);
+      return encoded;
+    }
+    appendToken(name.substr(start, end - start), encoded);
+    start = end + 1;
+  }
+}
+
+std::string SymbolTable::encodePrefix(const std::string& prefix) {
+  if (prefix.empty()) {
+    return "";
+  }
+  ASSERT(prefix.back() == '.');
+  return encode(prefix.substr(0, prefix.size() - 1));
+}
+
+std::string SymbolTable::decode(const std::string& encoded) const {
+  std::string name;
+  std::unique_lock<std::mutex> lock(lock_);
+  Symbol symbol = 0;
+  uint32_t shift = 0;
+  bool first = true;
+  for (const char c : encoded) {
+    const uint8_t byte = static_cast<uint8_t>(c);
+    symbol |= static_cast<Symbol>(byte & 0x7f) << shift;
+    shift += 7;
+    if (byte & 0x80) {
+      continue;
+    }
+
+    ASSERT(symbol < tokens_.size());
+    if (!first) {
+      name.push_back('.');
+    }
+    name.append(tokens_[symbol]);
+    first = false;
+    symbol = 0;
+    shift = 0;
+  }
+  ASSERT(shift == 0);
+  return name;
+}
+
+size_t SymbolTable::size() const {
+  std::unique_lock<std::mutex> lock(lock_);
+  return tokens_.size();
+}
+
+void SymbolTable::appendToken(const std::string& token, std::string& encoded) {
+  auto it = symbols_.find(token);
+  if (it == symbols_.end()) {
+    it = symbols_.emplace(token, tokens_.size()).first;
+    tokens_.push_back(token);
+  }
+
+  // Varint encoding, with the low 7 bits first and the high bit set on all bytes but the last.
+  Symbol symbol = it->second;
+  while (symbol >= 0x80) {
+    encoded.push_back(static_cast<char>((symbol & 0x7f) | 0x80));
+    symbol >>= 7;
+  }
+  encoded.push_back(static_cast<char>(symbol));
+}
+
+} // namespace Stats
+} // namespace Envoy
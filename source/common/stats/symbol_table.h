@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Envoy {
+namespace Stats {
+
+/**
+ * Encodes stat names as compact byte strings. A stat name is split into its dot separated tokens,
+ * and each token is replaced by the varint encoding of a symbol which the table assigns to it. A
+ * token such as a cluster name is stored once in the table however many stats it appears in, and
+ * most encoded names are short enough to be held inline by std::string without a heap allocation.
+ *
+ * The encoding of a name is prefix preserving: the encoding of a prefix which ends in '.' is a
+ * prefix of the encoding of all of the names which start with it, without the trailing '.'.
+ * Encoded names have no separators, and are equal when the names are equal.
+ *
+ * The table is safe to use from multiple threads. Symbols are never freed, so the table grows with
+ * the number of distinct tokens which have been encoded rather than with the number of stats.
+ */
+class SymbolTable {
+public:
+  typedef uint32_t Symbol;
+
+  /**
+   * @param name supplies the stat name to encode.
+   * @return std::string the encoded name. Tokens which don't have a symbol yet are assigned one.
+   */
+  std::string encode(const std::string& name);
+
+  /**
+   * @param prefix supplies a stat name prefix, which must be empty or end in '.'.
+   * @return std::string the encoding of the prefix, which can be concatenated with the encoding of
+   *         a name to give the encoding of their concatenation.
+   */
+  std::string encodePrefix(const std::string& prefix);
+
+  /**
+   * @param encoded supplies a name encoded by this table.
+   * @return std::string the original name.
+   */
+  std::string decode(const std::string& encoded) const;
+
+  /**
+   * @return size_t the number of symbols in the table.
+   */
+  size_t size() const;
+
+private:
+  void appendToken(const std::string& token, std::string& encoded);
+
+  mutable std::mutex lock_;
+  std::unordered_map<std::string, Symbol> symbols_;
+  std::vector<std::string> tokens_;
+};
+
+} // namespace Stats
+} // namespace Envoy
@@ -11,8 +11,8 @@
 namespace Envoy {
 namespace Stats {
 
-ThreadLocalStoreImpl::ThreadLocalStoreImpl(RawStatDataAllocator& alloc)
-    : alloc_(alloc), default_scope_(createScope("")),
+ThreadLocalStoreImpl::ThreadLocalStoreImpl(RawStatDataAllocator& alloc, bool thread_local_counters)
+    : alloc_(alloc), thread_local_counters_(thread_local_counters), default_scope_(createScope("")),
       num_last_resort_stats_(default_scope_->counter("stats.overflow")) {}
 
 ThreadLocalStoreImpl::~ThreadLocalStoreImpl() {
@@ -60,6 +60,22 @@ std::list<GaugeSharedPtr> ThreadLocalStoreImpl::gauges() const {
   return ret;
 }
 
+std::list<ParentHistogramSharedPtr> ThreadLocalStoreImpl::histograms() const {
+  // Handle de-dup due to overlapping scopes.
+  std::list<ParentHistogramSharedPtr> ret;
+  std::unordered_set<std::string> names;
+  std::unique_lock<std::mutex> lock(lock_);
+  for (ScopeImpl* scope : scopes_) {
+    for (auto histogram : scope->central_cache_.histograms_) {
+      if (names.insert(histogram.first).second) {
+        ret.push_back(histogram.second);
+      }
+    }
+  }
+
+  return ret;
+}
+
 void ThreadLocalStoreImpl::initializeThreading(Event::Dispatcher& main_thread_dispatcher,
                                                ThreadLocal::Instance& tls) {
   main_thread_dispatcher_ = &main_thread_dispatcher;
@@ -86,14 +102,34 @@ void ThreadLocalStoreImpl::releaseScopeCrossThread(ScopeImpl* scope) {
   }
 }
 
-std::string ThreadLocalStoreImpl::getTagsForName(const std::string& name, std::vector<Tag>& tags) {
-  std::string tag_extracted_name = name;
-  if (tag_extractors_ != nullptr) {
+void ThreadLocalStoreImpl::setTagExtractors(const std::vector<TagExtractorPtr>& tag_extractors) {
+  std::unique_lock<std::mutex> lock(lock_);
+  tag_extractors_ = &tag_extractors;
+  tag_extraction_cache_.clear();
+}
+
+std::string ThreadLocalStoreImpl::getTagsForName(const std::string& encoded_name,
+                                                 const std::string& name, std::vector<Tag>& tags) {
+  if (tag_extractors_ == nullptr) {
+    return name;
+  }
+
+  auto it = tag_extraction_cache_.find(encoded_name);
+  if (it == tag_extraction_cache_.end()) {
+    if (tag_extraction_cache_.size() >= MAX_TAG_EXTRACTION_CACHE_SIZE) {
+      tag_extraction_cache_.clear();
+    }
+
+    TagExtraction extraction{name, {}};
     for (const TagExtractorPtr& tag_extractor : *tag_extractors_) {
-      tag_extracted_name = tag_extractor->extractTag(tag_extracted_name, tags);
+      extraction.tag_extracted_name_ =
+          tag_extractor->extractTag(extraction.tag_extracted_name_, extraction.tags_);
     }
+    it = tag_extraction_cache_.emplace(encoded_name, std::move(extraction)).first;
   }
-  return tag_extracted_name;
+
+  tags.insert(tags.end(), it->second.tags_.begin(), it->second.tags_.end());
+  return it->second.tag_extracted_name_;
 }
 
 void ThreadLocalStoreImpl::clearScopeFromCaches(ScopeImpl* scope) {
@@ -119,18 +155,73 @@ ThreadLocalStoreImpl::SafeAllocData ThreadLocalStoreImpl::safeAlloc(const std::s
   }
 }
 
+ThreadLocalStoreImpl::ScopeImpl::ScopeImpl(ThreadLocalStoreImpl& parent, const std::string& prefix)
+    : parent_(parent), prefix_(Utility::sanitizeStatsName(prefix)),
+      prefix_encodable_(prefix_.empty() || prefix_.back() == '.'),
+      encoded_prefix_(prefix_encodable_ ? parent_.symbol_table_.encodePrefix(prefix_) : "") {}
+
 ThreadLocalStoreImpl::ScopeImpl::~ScopeImpl() { parent_.releaseScopeCrossThread(this); }
 
+std::string ThreadLocalStoreImpl::ScopeImpl::encodeName(const std::string& name) {
+  if (!prefix_encodable_) {
+    return parent_.symbol_table_.encode(prefix_ + name);
+  }
+
+  if (parent_.shutting_down_ || !parent_.tls_) {
+    return encoded_prefix_ + parent_.symbol_table_.encode(name);
+  }
+
+  // Names are encoded to at least one byte, so an empty entry hasn't been encoded yet.
+  std::string& encoded_name = parent_.tls_->getTyped<TlsCache>().encoded_names_[name];
+  if (encoded_name.empty()) {
+    encoded_name = parent_.symbol_table_.encode(name);
+  }
+  return encoded_prefix_ + encoded_name;
+}
+
+ThreadLocalStoreImpl::TlsCacheEntry& ThreadLocalStoreImpl::ScopeImpl::tlsCache() {
+  TlsCacheEntry& entry = parent_.tls_->getTyped<TlsCache>().scope_cache_[this];
+  if (entry.filled_) {
+    return entry;
+  }
+
+  // This thread hasn't looked up a stat in the scope yet, so fill its cache with the stats created
+  // so far in one go rather than looking each of them up in the central cache as it's first used.
+  entry.filled_ = true;
+  {
+    std::unique_lock<std::mutex> lock(parent_.lock_);
+    if (published_cache_stale_) {
+      publishCentralCache();
+    }
+  }
+  std::shared_ptr<const TlsCacheEntry> published = std::atomic_load(&published_cache_);
+  if (published) {
+    entry.counters_.insert(published->counters_.begin(), published->counters_.end());
+    entry.gauges_.insert(published->gauges_.begin(), published->gauges_.end());
+    entry.histograms_.insert(published->histograms_.begin(), published->histograms_.end());
+  }
+  return entry;
+}
+
+void ThreadLocalStoreImpl::ScopeImpl::publishCentralCache() {
+  std::shared_ptr<TlsCacheEntry> published = std::make_shared<TlsCacheEntry>();
+  published->counters_ = central_cache_.counters_;
+  published->gauges_ = central_cache_.gauges_;
+  published->histograms_ = central_cache_.histograms_;
+  std::atomic_store(&published_cache_, std::shared_ptr<const TlsCacheEntry>(std::move(published)));
+  published_cache_stale_ = false;
+}
+
 Counter& ThreadLocalStoreImpl::ScopeImpl::counter(const std::string& name) {
-  // Determine the final name based on the prefix and the passed name.
-  std::string final_name = prefix_ + name;
+  // Determine the encoded final name based on the prefix and the passed name.
+  const std::string encoded_name = encodeName(name);
 
   // We now try to acquire a *reference* to the TLS cache shared pointer. This might remain null
   // if we don't have TLS initialized currently. The de-referenced pointer might be null if there
   // is no cache entry.
   CounterSharedPtr* tls_ref = nullptr;
   if (!parent_.shutting_down_ && parent_.tls_) {
-    tls_ref = &parent_.tls_->getTyped<TlsCache>().scope_cache_[this].counters_[final_name];
+    tls_ref = &tlsCache().counters_[encoded_name];
   }
 
   // If we have a valid cache entry, return it.
@@ -138,16 +229,40 @@ Counter& ThreadLocalStoreImpl::ScopeImpl::counter(const std::string& name) {
     return **tls_ref;
   }
 
+  // Next we look in the published copy of the central store, which doesn't need the lock.
+  std::shared_ptr<const TlsCacheEntry> published = std::atomic_load(&published_cache_);
+  if (published) {
+    auto published_it = published->counters_.find(encoded_name);
+    if (published_it != published->counters_.end()) {
+      if (tls_ref) {
+        *tls_ref = published_it->second;
+      }
+      return *published_it->second;
+    }
+  }
+
   // We must now look in the central store so we must be locked. We grab a reference to the
-  // central store location. It might contain nothing. In this case, we allocate a new stat.
+  // central store location. It might contain nothing. In this case, we allocate a new stat. If it
+  // contains a stat which wasn't published yet, we republish so that other threads find it
+  // without the lock.
   std::unique_lock<std::mutex> lock(parent_.lock_);
-  CounterSharedPtr& central_ref = central_cache_.counters_[final_name];
+  CounterSharedPtr& central_ref = central_cache_.counters_[encoded_name];
+  if (central_ref && published_cache_stale_) {
+    publishCentralCache();
+  }
   if (!central_ref) {
+    published_cache_stale_ = true;
+    const std::string final_name = prefix_ + name;
     SafeAllocData alloc = parent_.safeAlloc(final_name);
     std::vector<Tag> tags;
-    std::string tag_extracted_name = parent_.getTagsForName(final_name, tags);
-    central_ref.reset(
-        new CounterImpl(alloc.data_, alloc.free_, std::move(tag_extracted_name), std::move(tags)));
+    std::string tag_extracted_name = parent_.getTagsForName(encoded_name, final_name, tags);
+    if (parent_.thread_local_counters_) {
+      central_ref.reset(new ThreadLocalCounterImpl(alloc.data_, alloc.free_, parent_, *this,
+                                                   std::move(tag_extracted_name), std::move(tags)));
+    } else {
+      central_ref.reset(new CounterImpl(alloc.data_, alloc.free_, std::move(tag_extracted_name),
+                                        std::move(tags)));
+    }
   }
 
   // If we have a TLS location to store or allocation into, do it.
@@ -178,22 +293,38 @@ void ThreadLocalStoreImpl::ScopeImpl::deliverHistogramToSinks(const Histogram& h
 Gauge& ThreadLocalStoreImpl::ScopeImpl::gauge(const std::string& name) {
   // See comments in counter(). There is no super clean way (via templates or otherwise) to
   // share this code so I'm leaving it largely duplicated for now.
-  std::string final_name = prefix_ + name;
+  const std::string encoded_name = encodeName(name);
   GaugeSharedPtr* tls_ref = nullptr;
   if (!parent_.shutting_down_ && parent_.tls_) {
-    tls_ref = &parent_.tls_->getTyped<TlsCache>().scope_cache_[this].gauges_[final_name];
+    tls_ref = &tlsCache().gauges_[encoded_name];
   }
 
   if (tls_ref && *tls_ref) {
     return **tls_ref;
   }
 
+  std::shared_ptr<const TlsCacheEntry> published = std::atomic_load(&published_cache_);
+  if (published) {
+    auto published_it = published->gauges_.find(encoded_name);
+    if (published_it != published->gauges_.end()) {
+      if (tls_ref) {
+        *tls_ref = published_it->second;
+      }
+      return *published_it->second;
+    }
+  }
+
   std::unique_lock<std::mutex> lock(parent_.lock_);
-  GaugeSharedPtr& central_ref = central_cache_.gauges_[final_name];
+  GaugeSharedPtr& central_ref = central_cache_.gauges_[encoded_name];
+  if (central_ref && published_cache_stale_) {
+    publishCentralCache();
+  }
   if (!central_ref) {
+    published_cache_stale_ = true;
+    const std::string final_name = prefix_ + name;
     SafeAllocData alloc = parent_.safeAlloc(final_name);
     std::vector<Tag> tags;
-    std::string tag_extracted_name = parent_.getTagsForName(final_name, tags);
+    std::string tag_extracted_name = parent_.getTagsForName(encoded_name, final_name, tags);
     central_ref.reset(
         new GaugeImpl(alloc.data_, alloc.free_, std::move(tag_extracted_name), std::move(tags)));
   }
@@ -208,23 +339,39 @@ Gauge& ThreadLocalStoreImpl::ScopeImpl::gauge(const std::string& name) {
 Histogram& ThreadLocalStoreImpl::ScopeImpl::histogram(const std::string& name) {
   // See comments in counter(). There is no super clean way (via templates or otherwise) to
   // share this code so I'm leaving it largely duplicated for now.
-  std::string final_name = prefix_ + name;
-  HistogramSharedPtr* tls_ref = nullptr;
+  const std::string encoded_name = encodeName(name);
+  ParentHistogramImplSharedPtr* tls_ref = nullptr;
   if (!parent_.shutting_down_ && parent_.tls_) {
-    tls_ref = &parent_.tls_->getTyped<TlsCache>().scope_cache_[this].histograms_[final_name];
+    tls_ref = &tlsCache().histograms_[encoded_name];
   }
 
   if (tls_ref && *tls_ref) {
     return **tls_ref;
   }
 
+  std::shared_ptr<const TlsCacheEntry> published = std::atomic_load(&published_cache_);
+  if (published) {
+    auto published_it = published->histograms_.find(encoded_name);
+    if (published_it != published->histograms_.end()) {
+      if (tls_ref) {
+        *tls_ref = published_it->second;
+      }
+      return *published_it->second;
+    }
+  }
+
   std::unique_lock<std::mutex> lock(parent_.lock_);
-  HistogramSharedPtr& central_ref = central_cache_.histograms_[final_name];
+  ParentHistogramImplSharedPtr& central_ref = central_cache_.histograms_[encoded_name];
+  if (central_ref && published_cache_stale_) {
+    publishCentralCache();
+  }
   if (!central_ref) {
+    published_cache_stale_ = true;
+    const std::string final_name = prefix_ + name;
     std::vector<Tag> tags;
-    std::string tag_extracted_name = parent_.getTagsForName(final_name, tags);
-    central_ref.reset(
-        new HistogramImpl(final_name, parent_, std::move(tag_extracted_name), std::move(tags)));
+    std::string tag_extracted_name = parent_.getTagsForName(encoded_name, final_name, tags);
+    central_ref.reset(new ParentHistogramImpl(final_name, parent_, *this,
+                                              std::move(tag_extracted_name), std::move(tags)));
   }
 
   if (tls_ref) {
@@ -234,5 +381,136 @@ Histogram& ThreadLocalStoreImpl::ScopeImpl::histogram(const std::string& name) {
   return *central_ref;
 }
 
+ThreadLocalStoreImpl::ThreadLocalCounterImpl::ThreadLocalCounterImpl(
+    RawStatData& data, RawStatDataAllocator& alloc, ThreadLocalStoreImpl& parent, ScopeImpl& scope,
+    std::string&& tag_extracted_name, std::vector<Tag>&& tags)
+    : MetricImpl(data.name_, std::move(tag_extracted_name), std::move(tags)), data_(data),
+      alloc_(alloc), parent_(parent), scope_(scope) {}
+
+ThreadLocalStoreImpl::ThreadLocalCounterImpl::~ThreadLocalCounterImpl() {
+  merge();
+  alloc_.free(data_);
+}
+
+void ThreadLocalStoreImpl::ThreadLocalCounterImpl::add(uint64_t amount) {
+  // There are no thread local slots before threading is initialized or once it is shutting down,
+  // so the backing stat is incremented directly.
+  if (parent_.shutting_down_ || !parent_.tls_) {
+    addToData(amount);
+    return;
+  }
+
+  CounterSlotSharedPtr& slot =
+      parent_.tls_->getTyped<TlsCache>().scope_cache_[&scope_].counter_slots_[this];
+  if (!slot) {
+    slot = std::make_shared<CounterSlot>();
+    std::unique_lock<std::mutex> lock(slots_lock_);
+    slots_.push_back(slot);
+  }
+  slot->value_.store(slot->value_.load(std::memory_order_relaxed) + amount,
+                     std::memory_order_relaxed);
+}
+
+uint64_t ThreadLocalStoreImpl::ThreadLocalCounterImpl::latch() {
+  merge();
+  return data_.pending_increment_.exchange(0);
+}
+
+void ThreadLocalStoreImpl::ThreadLocalCounterImpl::reset() {
+  std::unique_lock<std::mutex> lock(slots_lock_);
+  for (const CounterSlotSharedPtr& slot : slots_) {
+    slot->merged_ = slot->value_.load(std::memory_order_relaxed);
+  }
+  data_.value_ = 0;
+}
+
+bool ThreadLocalStoreImpl::ThreadLocalCounterImpl::used() const {
+  return (data_.flags_ & RawStatData::Flags::Used) || unmerged() > 0;
+}
+
+uint64_t ThreadLocalStoreImpl::ThreadLocalCounterImpl::value() const {
+  return data_.value_ + unmerged();
+}
+
+void ThreadLocalStoreImpl::ThreadLocalCounterImpl::addToData(uint64_t amount) {
+  data_.value_ += amount;
+  data_.pending_increment_ += amount;
+  data_.flags_ |= RawStatData::Flags::Used;
+}
+
+void ThreadLocalStoreImpl::ThreadLocalCounterImpl::merge() {
+  uint64_t amount = 0;
+  {
+    std::unique_lock<std::mutex> lock(slots_lock_);
+    for (const CounterSlotSharedPtr& slot : slots_) {
+      const uint64_t value = slot->value_.load(std::memory_order_relaxed);
+      amount += value - slot->merged_;
+      slot->merged_ = value;
+    }
+  }
+
+  if (amount > 0) {
+    addToData(amount);
+  }
+}
+
+uint64_t ThreadLocalStoreImpl::ThreadLocalCounterImpl::unmerged() const {
+  uint64_t amount = 0;
+  std::unique_lock<std::mutex> lock(slots_lock_);
+  for (const CounterSlotSharedPtr& slot : slots_) {
+    amount += slot->value_.load(std::memory_order_relaxed) - slot->merged_;
+  }
+  return amount;
+}
+
+ThreadLocalStoreImpl::ParentHistogramImpl::ParentHistogramImpl(const std::string& name,
+                                                               ThreadLocalStoreImpl& parent,
+                                                               ScopeImpl& scope,
+                                                               std::string&& tag_extracted_name,
+                                                               std::vector<Tag>&& tags)
+    : MetricImpl(name, std::move(tag_extracted_name), std::move(tags)), parent_(parent),
+      scope_(scope), main_thread_histogram_(std::make_shared<ThreadLocalHistogramImpl>()),
+      tls_histograms_({main_thread_histogram_}),
+      cumulative_counts_(HistogramBuckets::NUM_BUCKETS, 0) {}
+
+void ThreadLocalStoreImpl::ParentHistogramImpl::recordValue(uint64_t value) {
+  parent_.deliverHistogramToSinks(*this, value);
+
+  // Values recorded while shutting down are never merged.
+  if (parent_.shutting_down_) {
+    return;
+  }
+
+  if (!parent_.tls_) {
+    main_thread_histogram_->recordValue(value);
+    return;
+  }
+
+  ThreadLocalHistogramImplSharedPtr& tls_histogram =
+      parent_.tls_->getTyped<TlsCache>().scope_cache_[&scope_].tls_histograms_[this];
+  if (!tls_histogram) {
+    tls_histogram = std::make_shared<ThreadLocalHistogramImpl>();
+    std::unique_lock<std::mutex> lock(tls_histograms_lock_);
+    tls_histograms_.push_back(tls_histogram);
+  }
+  tls_histogram->recordValue(value);
+}
+
+void ThreadLocalStoreImpl::ParentHistogramImpl::merge() {
+  std::vector<uint64_t> interval_counts(HistogramBuckets::NUM_BUCKETS, 0);
+  {
+    std::unique_lock<std::mutex> lock(tls_histograms_lock_);
+    for (const ThreadLocalHistogramImplSharedPtr& tls_histogram : tls_histograms_) {
+      tls_histogram->collect(interval_counts);
+    }
+  }
+
+  for (size_t i = 0; i < HistogramBuckets::NUM_BUCKETS; i++) {
+    cumulative_counts_[i] += interval_counts[i];
+  }
+  interval_statistics_ = HistogramStatisticsImpl(interval_counts);
+  cumulative_statistics_ = HistogramStatisticsImpl(cumulative_counts_);
+}
+
 } // namespace Stats
 } // namespace Envoy
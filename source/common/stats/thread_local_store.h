@@ -4,6 +4,7 @@
 #include <chrono>
 #include <cstdint>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -11,7 +12,9 @@
 
 #include "envoy/thread_local/thread_local.h"
 
+#include "common/stats/histogram_impl.h"
 #include "common/stats/stats_impl.h"
+#include "common/stats/symbol_table.h"
 
 namespace Envoy {
 namespace Stats {
@@ -31,6 +34,11 @@ namespace Stats {
  * - Scopes can be deleted from any thread, and they are in practice as scopes are likely to be
  *   shared across all worker threads.
  * - Per thread caches are checked, and if empty, they are populated from the central cache.
+ * - Each scope publishes an immutable copy of its central cache, which is read without taking the
+ *   store lock. A thread's cache of a scope is filled with all of the published stats when the
+ *   thread first uses the scope, so a new scope whose stats were created on the main thread is
+ *   looked up on workers without contending on the lock. The copy is republished when a thread
+ *   finds a stat in the central cache which is missing from it.
  * - Scopes are entirely owned by the caller. The store only keeps weak pointers.
  * - When a scope is destroyed, a cache flush operation is run on all threads to flush any cached
  *   data owned by the destroyed scope.
@@ -40,6 +48,14 @@ namespace Stats {
  *         repopulated on the next access.
  * - Since it's possible to have overlapping scopes, we de-dup stats when counters() or gauges() is
  *   called since these are very uncommon operations.
+ * - The caches are keyed by stat names encoded by a SymbolTable rather than by the full names, so
+ *   each thread's copy of the keys is a few bytes per stat. Scopes encode their prefix once, and
+ *   each thread caches the encodings of the names looked up within scopes.
+ * - Histograms record their values in per thread buckets, which the main thread merges when stats
+ *   are flushed. Each value is also delivered to the sinks as it is recorded.
+ * - Counters can optionally be incremented in per thread slots, so that counters incremented by
+ *   every worker don't bounce a cache line between them. The slots are added to the backing stat
+ *   when the counter is latched at flush, and value() includes the increments not yet added.
  * - Though this implementation is designed to work with a fixed shared memory space, it will fall
  *   back to heap allocated stats if needed. NOTE: In this case, overlapping scopes will not share
  *   the same backing store. This is to keep things simple, it could be done in the future if
@@ -47,7 +63,11 @@ namespace Stats {
  */
 class ThreadLocalStoreImpl : public StoreRoot {
 public:
-  ThreadLocalStoreImpl(RawStatDataAllocator& alloc);
+  /**
+   * @param alloc supplies the allocator of the backing stats.
+   * @param thread_local_counters supplies whether counters are incremented in per thread slots.
+   */
+  ThreadLocalStoreImpl(RawStatDataAllocator& alloc, bool thread_local_counters = false);
   ~ThreadLocalStoreImpl();
 
   // Stats::Scope
@@ -64,26 +84,114 @@ public:
   // Stats::Store
   std::list<CounterSharedPtr> counters() const override;
   std::list<GaugeSharedPtr> gauges() const override;
+  std::list<ParentHistogramSharedPtr> histograms() const override;
 
   // Stats::StoreRoot
   void addSink(Sink& sink) override { timer_sinks_.push_back(sink); }
-  void setTagExtractors(const std::vector<TagExtractorPtr>& tag_extractors) override {
-    tag_extractors_ = &tag_extractors;
-  }
+  void setTagExtractors(const std::vector<TagExtractorPtr>& tag_extractors) override;
   void initializeThreading(Event::Dispatcher& main_thread_dispatcher,
                            ThreadLocal::Instance& tls) override;
   void shutdownThreading() override;
 
 private:
+  struct ScopeImpl;
+
+  /**
+   * Histogram which records the values of each thread in a ThreadLocalHistogramImpl.
+   */
+  class ParentHistogramImpl : public ParentHistogram, public MetricImpl {
+  public:
+    ParentHistogramImpl(const std::string& name, ThreadLocalStoreImpl& parent, ScopeImpl& scope,
+                        std::string&& tag_extracted_name, std::vector<Tag>&& tags);
+
+    // Stats::Histogram
+    void recordValue(uint64_t value) override;
+
+    // Stats::ParentHistogram
+    void merge() override;
+    const HistogramStatistics& intervalStatistics() const override { return interval_statistics_; }
+    const HistogramStatistics& cumulativeStatistics() const override {
+      return cumulative_statistics_;
+    }
+
+  private:
+    ThreadLocalStoreImpl& parent_;
+    ScopeImpl& scope_;
+    // Records the values of the main thread before threading is initialized.
+    const ThreadLocalHistogramImplSharedPtr main_thread_histogram_;
+    std::mutex tls_histograms_lock_;
+    std::vector<ThreadLocalHistogramImplSharedPtr> tls_histograms_;
+    std::vector<uint64_t> cumulative_counts_;
+    HistogramStatisticsImpl interval_statistics_;
+    HistogramStatisticsImpl cumulative_statistics_;
+  };
+
+  typedef std::shared_ptr<ParentHistogramImpl> ParentHistogramImplSharedPtr;
+
+  /**
+   * The increments of a ThreadLocalCounterImpl by one thread. Only that thread writes the value, so
+   * it is incremented without a locked read-modify-write.
+   */
+  struct CounterSlot {
+    std::atomic<uint64_t> value_{};
+    // The value when the slot was last added to the backing stat. Guarded by the counter's
+    // slots_lock_.
+    uint64_t merged_{};
+  };
+
+  typedef std::shared_ptr<CounterSlot> CounterSlotSharedPtr;
+
+  /**
+   * Counter which is incremented in a CounterSlot per thread once threading is initialized. The
+   * slots are added to the backing RawStatData when the counter is latched or destroyed.
+   */
+  class ThreadLocalCounterImpl : public Counter, public MetricImpl {
+  public:
+    ThreadLocalCounterImpl(RawStatData& data, RawStatDataAllocator& alloc,
+                           ThreadLocalStoreImpl& parent, ScopeImpl& scope,
+                           std::string&& tag_extracted_name, std::vector<Tag>&& tags);
+    ~ThreadLocalCounterImpl();
+
+    // Stats::Counter
+    void add(uint64_t amount) override;
+    void inc() override { add(1); }
+    uint64_t latch() override;
+    void reset() override;
+    bool used() const override;
+    uint64_t value() const override;
+
+  private:
+    void addToData(uint64_t amount);
+    void merge();
+    uint64_t unmerged() const;
+
+    RawStatData& data_;
+    RawStatDataAllocator& alloc_;
+    ThreadLocalStoreImpl& parent_;
+    ScopeImpl& scope_;
+    mutable std::mutex slots_lock_;
+    std::vector<CounterSlotSharedPtr> slots_;
+  };
+
+  // Keyed by encoded stat names.
   struct TlsCacheEntry {
     std::unordered_map<std::string, CounterSharedPtr> counters_;
     std::unordered_map<std::string, GaugeSharedPtr> gauges_;
-    std::unordered_map<std::string, HistogramSharedPtr> histograms_;
+    std::unordered_map<std::string, ParentHistogramImplSharedPtr> histograms_;
+    // The values recorded by this thread for each of the scope's histograms. Unused in the central
+    // cache.
+    std::unordered_map<const ParentHistogramImpl*, ThreadLocalHistogramImplSharedPtr>
+        tls_histograms_;
+    // The increments by this thread of each of the scope's thread local counters. Unused in the
+    // central cache.
+    std::unordered_map<const ThreadLocalCounterImpl*, CounterSlotSharedPtr> counter_slots_;
+    // Whether the entry has been filled with the published stats of the scope. Unused in the
+    // central cache.
+    bool filled_{};
   };
 
   struct ScopeImpl : public Scope {
-    ScopeImpl(ThreadLocalStoreImpl& parent, const std::string& prefix)
-        : parent_(parent), prefix_(Utility::sanitizeStatsName(prefix)) {}
+    ScopeImpl(ThreadLocalStoreImpl& parent, const std::string& prefix);
     ~ScopeImpl();
 
     // Stats::Scope
@@ -95,13 +203,44 @@ private:
     Gauge& gauge(const std::string& name) override;
     Histogram& histogram(const std::string& name) override;
 
+    /**
+     * @param name supplies a stat name within the scope.
+     * @return std::string the encoding of the full name of the stat.
+     */
+    std::string encodeName(const std::string& name);
+
+    /**
+     * @return TlsCacheEntry& the calling thread's cache of the scope, which is filled with the
+     *         published stats when the thread first looks up a stat in the scope. Threading must be
+     *         initialized, and the parent's lock_ must not be held.
+     */
+    TlsCacheEntry& tlsCache();
+
+    /**
+     * Publish a copy of central_cache_. The parent's lock_ must be held.
+     */
+    void publishCentralCache();
+
     ThreadLocalStoreImpl& parent_;
     const std::string prefix_;
+    // Only prefixes which are empty or end in '.' can be encoded on their own. Names in other
+    // scopes are encoded in full.
+    const bool prefix_encodable_;
+    const std::string encoded_prefix_;
     TlsCacheEntry central_cache_;
+    // The published copy of the stats in central_cache_. It's replaced with std::atomic_store()
+    // under the parent's lock_ and read with std::atomic_load() without it. Stats are never removed
+    // from central_cache_, so a stat found in any copy outlives the copy.
+    std::shared_ptr<const TlsCacheEntry> published_cache_;
+    // Whether stats have been added to central_cache_ since it was last published. Guarded by the
+    // parent's lock_.
+    bool published_cache_stale_{};
   };
 
   struct TlsCache : public ThreadLocal::ThreadLocalObject {
     std::unordered_map<ScopeImpl*, TlsCacheEntry> scope_cache_;
+    // Encodings of the names looked up within scopes, which are shared by all scopes.
+    std::unordered_map<std::string, std::string> encoded_names_;
   };
 
   struct SafeAllocData {
@@ -109,19 +248,35 @@ private:
     RawStatDataAllocator& free_;
   };
 
-  std::string getTagsForName(const std::string& name, std::vector<Tag>& tags);
+  struct TagExtraction {
+    std::string tag_extracted_name_;
+    std::vector<Tag> tags_;
+  };
+
+  // The number of tag extractions cached before the cache is cleared, which is more than the
+  // number of stats in most configurations.
+  static const size_t MAX_TAG_EXTRACTION_CACHE_SIZE = 64 * 1024;
+
+  std::string getTagsForName(const std::string& encoded_name, const std::string& name,
+                             std::vector<Tag>& tags);
   void clearScopeFromCaches(ScopeImpl* scope);
   void releaseScopeCrossThread(ScopeImpl* scope);
   SafeAllocData safeAlloc(const std::string& name);
 
   RawStatDataAllocator& alloc_;
+  const bool thread_local_counters_;
   Event::Dispatcher* main_thread_dispatcher_{};
   ThreadLocal::SlotPtr tls_;
   mutable std::mutex lock_;
   std::unordered_set<ScopeImpl*> scopes_;
+  SymbolTable symbol_table_;
   ScopePtr default_scope_;
   std::list<std::reference_wrapper<Sink>> timer_sinks_;
   const std::vector<TagExtractorPtr>* tag_extractors_{};
+  // Extractions of the names of stats created before, so that a stat created again in a new scope
+  // (for example when a cluster is updated) doesn't run the tag extractors again. Keyed by encoded
+  // stat names, and guarded by lock_.
+  std::unordered_map<std::string, TagExtraction> tag_extraction_cache_;
   std::atomic<bool> shutting_down_{};
   Counter& num_last_resort_stats_;
   HeapRawStatDataAllocator heap_allocator_;
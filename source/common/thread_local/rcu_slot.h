@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "envoy/thread_local/thread_local.h"
+
+namespace Envoy {
+namespace ThreadLocal {
+
+/**
+ * A read-copy-update slot. The main thread publishes immutable values, and every thread reads the
+ * latest published value without anything being posted to it: each thread keeps the value it last
+ * read in a regular slot, and only loads the published value again once its version changed. So a
+ * read costs a single atomic load unless a new value was published. A value is freed once every
+ * thread which read it has read a newer one, or when the slot is destroyed.
+ */
+template <class T> class RcuSlot {
+public:
+  RcuSlot(SlotAllocator& tls) : slot_(tls.allocateSlot()) {
+    slot_->set([](Event::Dispatcher&) -> ThreadLocalObjectSharedPtr {
+      return std::make_shared<ThreadLocalValue>();
+    });
+  }
+
+  /**
+   * Publish a new value. This must be called on the main thread.
+   * @param value supplies the value to publish.
+   */
+  void publish(std::shared_ptr<const T> value) {
+    std::atomic_store(&value_, std::move(value));
+    version_.fetch_add(1, std::memory_order_release);
+  }
+
+  /**
+   * @return const T* the latest value published, or nullptr if nothing was published yet. The
+   *         value can be freed on the next get() call from the same thread, so it must not be
+   *         kept across calls.
+   */
+  const T* get() {
+    ThreadLocalValue& local = slot_->getTyped<ThreadLocalValue>();
+    const uint64_t version = version_.load(std::memory_order_acquire);
+    if (local.version_ != version) {
+      local.value_ = std::atomic_load(&value_);
+      local.version_ = version;
+    }
+
+    return local.value_.get();
+  }
+
+private:
+  struct ThreadLocalValue : public ThreadLocalObject {
+    uint64_t version_{};
+    std::shared_ptr<const T> value_;
+  };
+
+  SlotPtr slot_;
+  std::shared_ptr<const T> value_;
+  std::atomic<uint64_t> version_{};
+};
+
+} // namespace ThreadLocal
+} // namespace Envoy
@@ -3,6 +3,8 @@
 #include <atomic>
 #include <cstdint>
 #include <list>
+#include <memory>
+#include <vector>
 
 #include "envoy/event/dispatcher.h"
 
@@ -77,13 +79,22 @@ void InstanceImpl::removeSlot(SlotImpl& slot) {
   });
 }
 
+void InstanceImpl::postToThreads(ThreadCb cb) {
+  if (batch_depth_ > 0) {
+    batch_.push_back(cb);
+    return;
+  }
+
+  for (Event::Dispatcher& dispatcher : registered_threads_) {
+    dispatcher.post([cb, &dispatcher]() -> void { cb(dispatcher); });
+  }
+}
+
 void InstanceImpl::runOnAllThreads(Event::PostCb cb) {
   ASSERT(std::this_thread::get_id() == main_thread_id_);
   ASSERT(!shutdown_);
 
-  for (Event::Dispatcher& dispatcher : registered_threads_) {
-    dispatcher.post(cb);
-  }
+  postToThreads([cb](Event::Dispatcher&) -> void { cb(); });
 
   // Handle main thread.
   cb();
@@ -93,15 +104,40 @@ void InstanceImpl::SlotImpl::set(InitializeCb cb) {
   ASSERT(std::this_thread::get_id() == parent_.main_thread_id_);
   ASSERT(!parent_.shutdown_);
 
-  for (Event::Dispatcher& dispatcher : parent_.registered_threads_) {
-    const uint32_t index = index_;
-    dispatcher.post([index, cb, &dispatcher]() -> void { setThreadLocal(index, cb(dispatcher)); });
-  }
+  const uint32_t index = index_;
+  parent_.postToThreads([index, cb](Event::Dispatcher& dispatcher) -> void {
+    setThreadLocal(index, cb(dispatcher));
+  });
 
   // Handle main thread.
   setThreadLocal(index_, cb(*parent_.main_thread_dispatcher_));
 }
 
+void InstanceImpl::startBatch() {
+  ASSERT(std::this_thread::get_id() == main_thread_id_);
+  batch_depth_++;
+}
+
+void InstanceImpl::endBatch() {
+  ASSERT(std::this_thread::get_id() == main_thread_id_);
+  ASSERT(batch_depth_ > 0);
+  if (--batch_depth_ > 0 || batch_.empty()) {
+    return;
+  }
+
+  // The callbacks are shared by all the threads, and freed once the last thread ran them.
+  std::shared_ptr<std::vector<ThreadCb>> batch =
+      std::make_shared<std::vector<ThreadCb>>(std::move(batch_));
+  batch_.clear();
+  for (Event::Dispatcher& dispatcher : registered_threads_) {
+    dispatcher.post([batch, &dispatcher]() -> void {
+      for (const ThreadCb& cb : *batch) {
+        cb(dispatcher);
+      }
+    });
+  }
+}
+
 void InstanceImpl::setThreadLocal(uint32_t index, ThreadLocalObjectSharedPtr object) {
   if (thread_local_data_.data_.size() <= index) {
     thread_local_data_.data_.resize(index + 1);
@@ -113,6 +149,7 @@ void InstanceImpl::setThreadLocal(uint32_t index, ThreadLocalObjectSharedPtr obj
 void InstanceImpl::shutdownGlobalThreading() {
   ASSERT(std::this_thread::get_id() == main_thread_id_);
   ASSERT(!shutdown_);
+  ASSERT(batch_depth_ == 0);
   shutdown_ = true;
 }
 
@@ -2,6 +2,7 @@
 
 #include <atomic>
 #include <cstdint>
+#include <functional>
 #include <list>
 #include <vector>
 
@@ -25,6 +26,8 @@ public:
   void registerThread(Event::Dispatcher& dispatcher, bool main_thread) override;
   void shutdownGlobalThreading() override;
   void shutdownThread() override;
+  void startBatch() override;
+  void endBatch() override;
 
 private:
   struct SlotImpl : public Slot {
@@ -44,12 +47,17 @@ private:
     std::vector<ThreadLocalObjectSharedPtr> data_;
   };
 
+  typedef std::function<void(Event::Dispatcher& dispatcher)> ThreadCb;
+
+  void postToThreads(ThreadCb cb);
   void removeSlot(SlotImpl& slot);
   void runOnAllThreads(Event::PostCb cb);
   static void setThreadLocal(uint32_t index, ThreadLocalObjectSharedPtr object);
 
   static thread_local ThreadLocalData thread_local_data_;
   std::vector<SlotImpl*> slots_;
+  uint32_t batch_depth_{};
+  std::vector<ThreadCb> batch_;
   std::list<std::reference_wrapper<Event::Dispatcher>> registered_threads_;
   std::thread::id main_thread_id_;
   Event::Dispatcher* main_thread_dispatcher_{};
@@ -10,7 +10,9 @@
 #include "common/http/header_map_impl.h"
 #include "common/http/headers.h"
 #include "common/http/utility.h"
+#include "common/runtime/key_registry.h"
 #include "common/runtime/uuid_util.h"
+#include "common/singleton/const_singleton.h"
 
 #include "fmt/format.h"
 
@@ -22,6 +24,17 @@ static std::string buildResponseCode(const AccessLog::RequestInfo& info) {
   return info.responseCode().valid() ? std::to_string(info.responseCode().value()) : "0";
 }
 
+/**
+ * Runtime keys of the tracing decision, which are resolved once rather than for every lookup.
+ */
+struct TracingRuntimeKeyValues {
+  const Runtime::Key ClientEnabled = Runtime::KeyRegistry::registerKey("tracing.client_enabled");
+  const Runtime::Key GlobalEnabled = Runtime::KeyRegistry::registerKey("tracing.global_enabled");
+  const Runtime::Key RandomSampling = Runtime::KeyRegistry::registerKey("tracing.random_sampling");
+};
+
+typedef ConstSingleton<TracingRuntimeKeyValues> TracingRuntimeKeys;
+
 static std::string valueOrDefault(const Http::HeaderEntry* header, const char* default_value) {
   return header ? header->value().c_str() : default_value;
 }
@@ -40,36 +53,48 @@ static std::string buildUrl(const Http::HeaderMap& request_headers) {
 }
 
 void HttpTracerUtility::mutateHeaders(Http::HeaderMap& request_headers, Runtime::Loader& runtime) {
-  if (!request_headers.RequestId()) {
+  Http::HeaderEntry* request_id = request_headers.RequestId();
+  if (!request_id) {
     return;
   }
 
-  // TODO PERF: Avoid copy.
-  std::string x_request_id = request_headers.RequestId()->value().c_str();
+  const char* x_request_id = request_id->value().c_str();
+  const size_t x_request_id_length = request_id->value().size();
 
   uint16_t result;
   // Skip if x-request-id is corrupted.
-  if (!UuidUtils::uuidModBy(x_request_id, result, 10000)) {
+  if (!UuidUtils::uuidModBy(x_request_id, x_request_id_length, result, 10000)) {
     return;
   }
 
+  const Runtime::Snapshot& snapshot = runtime.snapshot();
+  const UuidTraceStatus current_status =
+      UuidUtils::isTraceableUuid(x_request_id, x_request_id_length);
+  UuidTraceStatus trace_status = current_status;
+
   // Do not apply tracing transformations if we are currently tracing.
-  if (UuidTraceStatus::NoTrace == UuidUtils::isTraceableUuid(x_request_id)) {
+  if (UuidTraceStatus::NoTrace == current_status) {
     if (request_headers.ClientTraceId() &&
-        runtime.snapshot().featureEnabled("tracing.client_enabled", 100)) {
-      UuidUtils::setTraceableUuid(x_request_id, UuidTraceStatus::Client);
+        snapshot.featureEnabled(TracingRuntimeKeys::get().ClientEnabled, 100)) {
+      trace_status = UuidTraceStatus::Client;
     } else if (request_headers.EnvoyForceTrace()) {
-      UuidUtils::setTraceableUuid(x_request_id, UuidTraceStatus::Forced);
-    } else if (runtime.snapshot().featureEnabled("tracing.random_sampling", 10000, result, 10000)) {
-      UuidUtils::setTraceableUuid(x_request_id, UuidTraceStatus::Sampled);
+      trace_status = UuidTraceStatus::Forced;
+    } else if (snapshot.featureEnabled(TracingRuntimeKeys::get().RandomSampling, 10000, result,
+                                       10000)) {
+      trace_status = UuidTraceStatus::Sampled;
     }
   }
 
-  if (!runtime.snapshot().featureEnabled("tracing.global_enabled", 100, result)) {
-    UuidUtils::setTraceableUuid(x_request_id, UuidTraceStatus::NoTrace);
+  if (!snapshot.featureEnabled(TracingRuntimeKeys::get().GlobalEnabled, 100, result)) {
+    trace_status = UuidTraceStatus::NoTrace;
   }
 
-  request_headers.RequestId()->value(x_request_id);
+  // The header is only rewritten when the decision changes, so an untraced request costs no copy.
+  if (trace_status != current_status) {
+    std::string new_request_id(x_request_id, x_request_id_length);
+    UuidUtils::setTraceableUuid(new_request_id, trace_status);
+    request_id->value(new_request_id);
+  }
 }
 
 const std::string HttpTracerUtility::INGRESS_OPERATION = "ingress";
@@ -97,9 +122,8 @@ Decision HttpTracerUtility::isTracing(const AccessLog::RequestInfo& request_info
     return {Reason::NotTraceableRequestId, false};
   }
 
-  // TODO PERF: Avoid copy.
-  UuidTraceStatus trace_status =
-      UuidUtils::isTraceableUuid(request_headers.RequestId()->value().c_str());
+  const Http::HeaderString& request_id = request_headers.RequestId()->value();
+  UuidTraceStatus trace_status = UuidUtils::isTraceableUuid(request_id.c_str(), request_id.size());
 
   switch (trace_status) {
   case UuidTraceStatus::Client:
@@ -1,11 +1,14 @@
 #include "common/tracing/lightstep_tracer_impl.h"
 
+#include <array>
 #include <chrono>
 #include <cstdint>
 #include <memory>
 #include <string>
 
+#include "common/common/assert.h"
 #include "common/common/base64.h"
+#include "common/grpc/codec.h"
 #include "common/grpc/common.h"
 #include "common/http/message_impl.h"
 #include "common/tracing/http_tracer_impl.h"
@@ -45,7 +48,15 @@ SpanPtr LightStepSpan::spawnChild(const Config&, const std::string& name, System
 
 LightStepRecorder::LightStepRecorder(const lightstep::TracerImpl& tracer, LightStepDriver& driver,
                                      Event::Dispatcher& dispatcher)
-    : builder_(tracer), driver_(driver) {
+    : driver_(driver) {
+  // The builder fills in the reporter and auth fields of the report along with the first span.
+  lightstep::ReportBuilder builder(tracer);
+  builder.addSpan(lightstep::collector::Span());
+  lightstep::collector::ReportRequest preamble;
+  std::swap(preamble, builder.pending());
+  preamble.clear_spans();
+  report_preamble_ = preamble.SerializeAsString();
+
   flush_timer_ = dispatcher.createTimer([this]() -> void {
     driver_.tracerStats().timer_flushed_.inc();
     flushSpans();
@@ -55,12 +66,32 @@ LightStepRecorder::LightStepRecorder(const lightstep::TracerImpl& tracer, LightS
   enableTimer();
 }
 
+LightStepRecorder::~LightStepRecorder() {
+  if (active_request_ != nullptr) {
+    active_request_->cancel();
+  }
+}
+
 void LightStepRecorder::RecordSpan(lightstep::collector::Span&& span) {
-  builder_.addSpan(std::move(span));
+  Runtime::Snapshot& snapshot = driver_.runtime().snapshot();
+  if (pending_span_count_ >= snapshot.getInteger("tracing.lightstep.max_buffered_spans", 1000U)) {
+    driver_.tracerStats().spans_dropped_.inc();
+    return;
+  }
 
-  uint64_t min_flush_spans =
-      driver_.runtime().snapshot().getInteger("tracing.lightstep.min_flush_spans", 5U);
-  if (builder_.pendingSpans() == min_flush_spans) {
+  span_report_.clear_spans();
+  span_report_.add_spans()->Swap(&span);
+  const uint32_t size = span_report_.ByteSize();
+  Buffer::RawSlice iovec;
+  pending_spans_.reserve(size, &iovec, 1);
+  ASSERT(iovec.len_ >= size);
+  iovec.len_ = size;
+  span_report_.SerializeWithCachedSizesToArray(static_cast<uint8_t*>(iovec.mem_));
+  pending_spans_.commit(&iovec, 1);
+  pending_span_count_++;
+
+  if (pending_span_count_ >= snapshot.getInteger("tracing.lightstep.min_flush_spans", 5U) ||
+      pending_spans_.length() >= snapshot.getInteger("tracing.lightstep.min_flush_bytes", 65536U)) {
     flushSpans();
   }
 }
@@ -84,23 +115,30 @@ void LightStepRecorder::enableTimer() {
 }
 
 void LightStepRecorder::flushSpans() {
-  if (builder_.pendingSpans() != 0) {
-    driver_.tracerStats().spans_sent_.add(builder_.pendingSpans());
-    lightstep::collector::ReportRequest request;
-    std::swap(request, builder_.pending());
-
-    Http::MessagePtr message = Grpc::Common::prepareHeaders(driver_.cluster()->name(),
-                                                            lightstep::CollectorServiceFullName(),
-                                                            lightstep::CollectorMethodName());
-
-    message->body() = Grpc::Common::serializeBody(std::move(request));
-
-    uint64_t timeout =
-        driver_.runtime().snapshot().getInteger("tracing.lightstep.request_timeout", 5000U);
-    driver_.clusterManager()
-        .httpAsyncClientForCluster(driver_.cluster()->name())
-        .send(std::move(message), *this, std::chrono::milliseconds(timeout));
+  // The spans stay buffered while a report is being sent, and are sent once it completes.
+  if (pending_span_count_ == 0 || active_request_ != nullptr) {
+    return;
   }
+
+  driver_.tracerStats().spans_sent_.add(pending_span_count_);
+  Http::MessagePtr message = Grpc::Common::prepareHeaders(driver_.cluster()->name(),
+                                                          lightstep::CollectorServiceFullName(),
+                                                          lightstep::CollectorMethodName());
+
+  std::array<uint8_t, 5> header;
+  Grpc::Encoder().newFrame(Grpc::GRPC_FH_DEFAULT,
+                           report_preamble_.size() + pending_spans_.length(), header);
+  message->body().reset(new Buffer::OwnedImpl(header.data(), header.size()));
+  message->body()->add(report_preamble_);
+  message->body()->move(pending_spans_);
+  pending_span_count_ = 0;
+
+  uint64_t timeout =
+      driver_.runtime().snapshot().getInteger("tracing.lightstep.request_timeout", 5000U);
+  // The request is null if it completed inline, the callbacks having already run.
+  active_request_ = driver_.clusterManager()
+                        .httpAsyncClientForCluster(driver_.cluster()->name())
+                        .send(std::move(message), *this, std::chrono::milliseconds(timeout));
 }
 
 LightStepDriver::TlsLightStepTracer::TlsLightStepTracer(lightstep::Tracer tracer,
@@ -164,11 +202,13 @@ SpanPtr LightStepDriver::startSpan(const Config&, Http::HeaderMap& request_heade
 }
 
 void LightStepRecorder::onFailure(Http::AsyncClient::FailureReason) {
+  active_request_ = nullptr;
   Grpc::Common::chargeStat(*driver_.cluster(), lightstep::CollectorServiceFullName(),
                            lightstep::CollectorMethodName(), false);
 }
 
 void LightStepRecorder::onSuccess(Http::MessagePtr&& msg) {
+  active_request_ = nullptr;
   try {
     Grpc::Common::validateResponse(*msg);
 
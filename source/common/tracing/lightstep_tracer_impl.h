@@ -9,6 +9,7 @@
 #include "envoy/tracing/http_tracer.h"
 #include "envoy/upstream/cluster_manager.h"
 
+#include "common/buffer/buffer_impl.h"
 #include "common/http/header_map_impl.h"
 #include "common/http/message_impl.h"
 #include "common/json/json_loader.h"
@@ -21,6 +22,7 @@ namespace Tracing {
 
 #define LIGHTSTEP_TRACER_STATS(COUNTER)                                                            \
   COUNTER(spans_sent)                                                                              \
+  COUNTER(spans_dropped)                                                                           \
   COUNTER(timer_flushed)
 
 struct LightstepTracerStats {
@@ -84,10 +86,17 @@ private:
   std::unique_ptr<lightstep::TracerOptions> options_;
 };
 
+/**
+ * Recorder of the spans finished on a worker. Each span is serialized into a buffer as it is
+ * recorded, and the buffer is sent as one report once enough spans or bytes are pending, or on
+ * the flush timer. Only one report is sent at a time, and spans recorded while the buffer is full
+ * are dropped.
+ */
 class LightStepRecorder : public lightstep::Recorder, Http::AsyncClient::Callbacks {
 public:
   LightStepRecorder(const lightstep::TracerImpl& tracer, LightStepDriver& driver,
                     Event::Dispatcher& dispatcher);
+  ~LightStepRecorder();
 
   // lightstep::Recorder
   void RecordSpan(lightstep::collector::Span&& span) override;
@@ -105,9 +114,18 @@ private:
   void enableTimer();
   void flushSpans();
 
-  lightstep::ReportBuilder builder_;
   LightStepDriver& driver_;
   Event::TimerPtr flush_timer_;
+  // The serialized fields of the report other than its spans, which are the same for every report.
+  std::string report_preamble_;
+  // A report holding just the span being serialized, reused for every span. Serialized reports
+  // concatenate into one report holding all of their spans.
+  lightstep::collector::ReportRequest span_report_;
+  // The serialized spans recorded since the last flush.
+  Buffer::OwnedImpl pending_spans_;
+  uint64_t pending_span_count_{};
+  // The report being sent, if any.
+  Http::AsyncClient::Request* active_request_{};
 };
 
 } // Tracing
@@ -1,38 +1,55 @@
 #pragma once
 
+#include "common/buffer/buffer_impl.h"
 #include "common/tracing/zipkin/zipkin_core_types.h"
 
 namespace Envoy {
 namespace Zipkin {
 
+/**
+ * Encodings in which spans can be sent to the Zipkin service.
+ */
+enum class SpanEncoding {
+  // A JSON array of spans.
+  Json,
+  // A Thrift list of spans, encoded with the Thrift binary protocol.
+  Thrift
+};
+
 /**
  * This class implements a simple buffer to store Zipkin tracing spans
- * prior to flushing them.
+ * prior to flushing them. Spans are serialized as they are added, so that the buffer holds
+ * the body of the next report rather than copies of the spans.
  */
 class SpanBuffer {
 public:
   /**
    * Constructor that creates an empty buffer. Space needs to be allocated by invoking
    * the method allocateBuffer(size).
+   *
+   * @param encoding The encoding of the buffered spans.
    */
-  SpanBuffer() {}
+  SpanBuffer(SpanEncoding encoding = SpanEncoding::Json) : encoding_(encoding) {}
 
   /**
    * Constructor that initializes a buffer with the given size.
    *
    * @param size The desired buffer size.
+   * @param encoding The encoding of the buffered spans.
    */
-  SpanBuffer(uint64_t size) { allocateBuffer(size); }
+  SpanBuffer(uint64_t size, SpanEncoding encoding = SpanEncoding::Json) : encoding_(encoding) {
+    allocateBuffer(size);
+  }
 
   /**
    * Allocates space for an empty buffer or resizes a previously-allocated one.
    *
    * @param size The desired buffer size.
    */
-  void allocateBuffer(uint64_t size) { span_buffer_.reserve(size); }
+  void allocateBuffer(uint64_t size) { max_spans_ = size; }
 
   /**
-   * Adds the given Zipkin span to the buffer.
+   * Serializes the given Zipkin span into the buffer.
    *
    * @param span The span to be added to the buffer.
    *
@@ -44,22 +61,42 @@ public:
    * Empties the buffer. This method is supposed to be called when all buffered spans
    * have been sent to to the Zipkin service.
    */
-  void clear() { span_buffer_.clear(); }
+  void clear();
 
   /**
    * @return the number of spans currently buffered.
    */
-  uint64_t pendingSpans() { return span_buffer_.size(); }
+  uint64_t pendingSpans() { return pending_spans_; }
+
+  /**
+   * @return the number of bytes of serialized spans currently buffered.
+   */
+  uint64_t pendingBytes() { return serialized_spans_.length(); }
+
+  /**
+   * @return the encoding of the buffered spans.
+   */
+  SpanEncoding encoding() const { return encoding_; }
 
   /**
    * @return the contents of the buffer as a stringified array of JSONs, where
-   * each JSON in the array corresponds to one Zipkin span.
+   * each JSON in the array corresponds to one Zipkin span. Only valid for the JSON encoding.
    */
   std::string toStringifiedJsonArray();
 
+  /**
+   * Moves the buffered spans into the given buffer as a complete report in the buffer's
+   * encoding, and empties the buffer.
+   *
+   * @param output The buffer the report is added to.
+   */
+  void moveSerialized(Buffer::Instance& output);
+
 private:
-  // We use a pre-allocated vector to improve performance
-  std::vector<Span> span_buffer_;
+  const SpanEncoding encoding_;
+  uint64_t max_spans_{};
+  uint64_t pending_spans_{};
+  Buffer::OwnedImpl serialized_spans_;
 };
 } // namespace Zipkin
 } // namespace Envoy
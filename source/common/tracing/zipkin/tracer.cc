@@ -12,12 +12,9 @@ namespace Zipkin {
 
 SpanPtr Tracer::startSpan(const Tracing::Config& config, const std::string& span_name,
                           SystemTime timestamp) {
-  // Build the endpoint
-  Endpoint ep(service_name_, address_);
-
   // Build the CS annotation
   Annotation cs;
-  cs.setEndpoint(std::move(ep));
+  cs.setEndpoint(endpoint_);
   if (config.operationName() == Tracing::OperationName::Egress) {
     cs.setValue(ZipkinCoreConstants::get().CLIENT_SEND);
   } else {
@@ -25,7 +22,7 @@ SpanPtr Tracer::startSpan(const Tracing::Config& config, const std::string& span
   }
 
   // Create an all-new span, with no parent id
-  SpanPtr span_ptr(new Span());
+  SpanPtr span_ptr = newSpan();
   span_ptr->setName(span_name);
   uint64_t random_number = random_generator_.random();
   span_ptr->setId(random_number);
@@ -52,7 +49,7 @@ SpanPtr Tracer::startSpan(const Tracing::Config& config, const std::string& span
 
 SpanPtr Tracer::startSpan(const Tracing::Config& config, const std::string& span_name,
                           SystemTime timestamp, SpanContext& previous_context) {
-  SpanPtr span_ptr(new Span());
+  SpanPtr span_ptr = newSpan();
   Annotation annotation;
   uint64_t timestamp_micro;
 
@@ -91,11 +88,8 @@ SpanPtr Tracer::startSpan(const Tracing::Config& config, const std::string& span
     return span_ptr; // return an empty span
   }
 
-  // Build the endpoint
-  Endpoint ep(service_name_, address_);
-
   // Add the newly-created annotation to the span
-  annotation.setEndpoint(std::move(ep));
+  annotation.setEndpoint(endpoint_);
   annotation.setTimestamp(timestamp_micro);
   span_ptr->addAnnotation(std::move(annotation));
 
@@ -119,6 +113,23 @@ void Tracer::reportSpan(Span&& span) {
   }
 }
 
+void Tracer::releaseSpan(SpanPtr&& span) {
+  if (free_spans_.size() < MAX_FREE_SPANS) {
+    span->reset();
+    free_spans_.push_back(std::move(span));
+  }
+}
+
+SpanPtr Tracer::newSpan() {
+  if (free_spans_.empty()) {
+    return SpanPtr(new Span());
+  }
+
+  SpanPtr span = std::move(free_spans_.back());
+  free_spans_.pop_back();
+  return span;
+}
+
 void Tracer::setReporter(ReporterPtr reporter) { reporter_ = std::move(reporter); }
 
 } // namespace Zipkin
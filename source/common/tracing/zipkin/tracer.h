@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include "envoy/common/pure.h"
 #include "envoy/common/time.h"
 #include "envoy/runtime/runtime.h"
@@ -42,6 +44,10 @@ typedef std::unique_ptr<Reporter> ReporterPtr;
  * This class allows its users to supply a concrete Reporter class whose reportSpan method
  * is called by its own reportSpan method. By doing so, we have cleanly separated the logic
  * of dealing with finished spans from the span-creation and tracing logic.
+ *
+ * A tracer is used by a single worker. All the annotations it creates share a single endpoint,
+ * and spans which are no longer in use can be returned to it with releaseSpan(), so that their
+ * storage is reused by the next spans it starts.
  */
 class Tracer : public TracerInterface {
 public:
@@ -56,7 +62,8 @@ public:
    */
   Tracer(const std::string& service_name, Network::Address::InstanceConstSharedPtr address,
          Runtime::RandomGenerator& random_generator)
-      : service_name_(service_name), address_(address), reporter_(nullptr),
+      : service_name_(service_name), address_(address),
+        endpoint_(std::make_shared<const Endpoint>(service_name, address)), reporter_(nullptr),
         random_generator_(random_generator) {}
 
   /**
@@ -84,6 +91,14 @@ public:
    */
   void reportSpan(Span&& span) override;
 
+  /**
+   * Takes back a span started by this tracer once it is no longer in use. Its storage is reused
+   * by a later call to startSpan().
+   *
+   * @param span The span to be released.
+   */
+  void releaseSpan(SpanPtr&& span);
+
   /**
    * @return the service-name attribute associated with the Tracer.
    */
@@ -105,10 +120,20 @@ public:
   Runtime::RandomGenerator& randomGenerator() { return random_generator_; }
 
 private:
+  /**
+   * @return a recycled span if one is available, or a new span otherwise.
+   */
+  SpanPtr newSpan();
+
+  // Upper bound of the number of released spans kept for reuse.
+  static const size_t MAX_FREE_SPANS = 128;
+
   const std::string service_name_;
   Network::Address::InstanceConstSharedPtr address_;
+  const EndpointConstSharedPtr endpoint_;
   ReporterPtr reporter_;
   Runtime::RandomGenerator& random_generator_;
+  std::vector<SpanPtr> free_spans_;
 };
 
 typedef std::unique_ptr<Tracer> TracerPtr;
@@ -1,5 +1,7 @@
 #include "common/tracing/zipkin/util.h"
 
+#include <arpa/inet.h>
+
 #include <chrono>
 #include <random>
 #include <regex>
@@ -47,6 +49,41 @@ void Util::addArrayToJson(std::string& target, const std::vector<std::string>& j
   mergeJsons(target, stringified_json_array, field_name);
 }
 
+void Util::addThriftFieldHeader(Buffer::Instance& buffer, ThriftType type, int16_t id) {
+  buffer.add(&type, sizeof(type));
+  addThriftI16(buffer, id);
+}
+
+void Util::addThriftFieldStop(Buffer::Instance& buffer) {
+  const uint8_t stop = THRIFT_STOP;
+  buffer.add(&stop, sizeof(stop));
+}
+
+void Util::addThriftListHeader(Buffer::Instance& buffer, ThriftType element_type, uint32_t size) {
+  buffer.add(&element_type, sizeof(element_type));
+  addThriftI32(buffer, size);
+}
+
+void Util::addThriftI16(Buffer::Instance& buffer, int16_t value) {
+  const uint16_t network_value = htons(value);
+  buffer.add(&network_value, sizeof(network_value));
+}
+
+void Util::addThriftI32(Buffer::Instance& buffer, int32_t value) {
+  const uint32_t network_value = htonl(value);
+  buffer.add(&network_value, sizeof(network_value));
+}
+
+void Util::addThriftI64(Buffer::Instance& buffer, int64_t value) {
+  addThriftI32(buffer, static_cast<uint64_t>(value) >> 32);
+  addThriftI32(buffer, static_cast<uint64_t>(value) & 0xffffffff);
+}
+
+void Util::addThriftBinary(Buffer::Instance& buffer, const void* data, uint32_t size) {
+  addThriftI32(buffer, size);
+  buffer.add(data, size);
+}
+
 uint64_t Util::generateRandom64() {
   uint64_t seed = std::chrono::duration_cast<std::chrono::nanoseconds>(
                       ProdSystemTimeSource::instance_.currentTime().time_since_epoch())
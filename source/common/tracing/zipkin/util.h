@@ -1,11 +1,28 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#include "envoy/buffer/buffer.h"
+
 namespace Envoy {
 namespace Zipkin {
 
+/**
+ * Thrift type ids, as written by the binary protocol.
+ */
+enum ThriftType : uint8_t {
+  THRIFT_STOP = 0,
+  THRIFT_BOOL = 2,
+  THRIFT_I16 = 6,
+  THRIFT_I32 = 8,
+  THRIFT_I64 = 10,
+  THRIFT_STRING = 11,
+  THRIFT_STRUCT = 12,
+  THRIFT_LIST = 15,
+};
+
 /**
  * Utility class with a few convenient methods
  */
@@ -36,6 +53,45 @@ public:
   static void addArrayToJson(std::string& target, const std::vector<std::string>& json_array,
                              const std::string& field_name);
 
+  // ====
+  // Thrift binary protocol encoding
+  // ====
+
+  /**
+   * Adds the header of a struct field. Integers are written in network byte order.
+   *
+   * @param buffer The buffer the field is added to.
+   * @param type The type of the field's value.
+   * @param id The id of the field within its struct.
+   */
+  static void addThriftFieldHeader(Buffer::Instance& buffer, ThriftType type, int16_t id);
+
+  /**
+   * Adds the end of a struct.
+   */
+  static void addThriftFieldStop(Buffer::Instance& buffer);
+
+  /**
+   * Adds the header of a list, which is followed by its elements.
+   *
+   * @param buffer The buffer the header is added to.
+   * @param element_type The type of the elements of the list.
+   * @param size The number of elements in the list.
+   */
+  static void addThriftListHeader(Buffer::Instance& buffer, ThriftType element_type, uint32_t size);
+
+  static void addThriftI16(Buffer::Instance& buffer, int16_t value);
+  static void addThriftI32(Buffer::Instance& buffer, int32_t value);
+  static void addThriftI64(Buffer::Instance& buffer, int64_t value);
+
+  /**
+   * Adds a string or binary value: its length followed by its bytes.
+   */
+  static void addThriftBinary(Buffer::Instance& buffer, const void* data, uint32_t size);
+  static void addThriftString(Buffer::Instance& buffer, const std::string& value) {
+    addThriftBinary(buffer, value.data(), value.size());
+  }
+
   // ====
   // Miscellaneous
   // ====
@@ -1,5 +1,7 @@
 #include "common/tracing/zipkin/zipkin_core_types.h"
 
+#include <array>
+
 #include "common/common/utility.h"
 #include "common/tracing/zipkin/span_context.h"
 #include "common/tracing/zipkin/util.h"
@@ -25,7 +27,7 @@ Endpoint& Endpoint::operator=(const Endpoint& ep) {
   return *this;
 }
 
-const std::string Endpoint::toJson() {
+const std::string Endpoint::toJson() const {
   rapidjson::StringBuffer s;
   rapidjson::Writer<rapidjson::StringBuffer> writer(s);
   writer.StartObject();
@@ -54,11 +56,33 @@ const std::string Endpoint::toJson() {
   return json_string;
 }
 
+void Endpoint::toThrift(Buffer::Instance& buffer) const {
+  // struct Endpoint { 1: i32 ipv4, 2: i16 port, 3: string service_name, 4: optional binary ipv6 }
+  Util::addThriftFieldHeader(buffer, THRIFT_I32, 1);
+  if (address_ && address_->ip()->version() == Network::Address::IpVersion::v4) {
+    // The address is already in network byte order.
+    const uint32_t ipv4 = address_->ip()->ipv4()->address();
+    buffer.add(&ipv4, sizeof(ipv4));
+  } else {
+    Util::addThriftI32(buffer, 0);
+  }
+  Util::addThriftFieldHeader(buffer, THRIFT_I16, 2);
+  Util::addThriftI16(buffer, address_ ? address_->ip()->port() : 0);
+  Util::addThriftFieldHeader(buffer, THRIFT_STRING, 3);
+  Util::addThriftString(buffer, service_name_);
+  if (address_ && address_->ip()->version() == Network::Address::IpVersion::v6) {
+    const std::array<uint8_t, 16> ipv6 = address_->ip()->ipv6()->address();
+    Util::addThriftFieldHeader(buffer, THRIFT_STRING, 4);
+    Util::addThriftBinary(buffer, ipv6.data(), ipv6.size());
+  }
+  Util::addThriftFieldStop(buffer);
+}
+
 Annotation::Annotation(const Annotation& ann) {
   timestamp_ = ann.timestamp();
   value_ = ann.value();
   if (ann.isSetEndpoint()) {
-    endpoint_ = ann.endpoint();
+    endpoint_ = ann.sharedEndpoint();
   }
 }
 
@@ -66,19 +90,22 @@ Annotation& Annotation::operator=(const Annotation& ann) {
   timestamp_ = ann.timestamp();
   value_ = ann.value();
   if (ann.isSetEndpoint()) {
-    endpoint_ = ann.endpoint();
+    endpoint_ = ann.sharedEndpoint();
   }
 
   return *this;
 }
 
 void Annotation::changeEndpointServiceName(const std::string& service_name) {
-  if (endpoint_.valid()) {
-    endpoint_.value().setServiceName(service_name);
+  if (endpoint_) {
+    // The endpoint may be shared with other annotations, so it is replaced rather than modified.
+    Endpoint endpoint(*endpoint_);
+    endpoint.setServiceName(service_name);
+    endpoint_ = std::make_shared<const Endpoint>(endpoint);
   }
 }
 
-const std::string Annotation::toJson() {
+const std::string Annotation::toJson() const {
   rapidjson::StringBuffer s;
   rapidjson::Writer<rapidjson::StringBuffer> writer(s);
   writer.StartObject();
@@ -90,20 +117,33 @@ const std::string Annotation::toJson() {
 
   std::string json_string = s.GetString();
 
-  if (endpoint_.valid()) {
-    Util::mergeJsons(json_string, static_cast<Endpoint>(endpoint_.value()).toJson(),
+  if (endpoint_) {
+    Util::mergeJsons(json_string, endpoint_->toJson(),
                      ZipkinJsonFieldNames::get().ANNOTATION_ENDPOINT.c_str());
   }
 
   return json_string;
 }
 
+void Annotation::toThrift(Buffer::Instance& buffer) const {
+  // struct Annotation { 1: i64 timestamp, 2: string value, 3: optional Endpoint host }
+  Util::addThriftFieldHeader(buffer, THRIFT_I64, 1);
+  Util::addThriftI64(buffer, timestamp_);
+  Util::addThriftFieldHeader(buffer, THRIFT_STRING, 2);
+  Util::addThriftString(buffer, value_);
+  if (endpoint_) {
+    Util::addThriftFieldHeader(buffer, THRIFT_STRUCT, 3);
+    endpoint_->toThrift(buffer);
+  }
+  Util::addThriftFieldStop(buffer);
+}
+
 BinaryAnnotation::BinaryAnnotation(const BinaryAnnotation& ann) {
   key_ = ann.key();
   value_ = ann.value();
   annotation_type_ = ann.annotationType();
   if (ann.isSetEndpoint()) {
-    endpoint_ = ann.endpoint();
+    endpoint_ = ann.sharedEndpoint();
   }
 }
 
@@ -112,13 +152,13 @@ BinaryAnnotation& BinaryAnnotation::operator=(const BinaryAnnotation& ann) {
   value_ = ann.value();
   annotation_type_ = ann.annotationType();
   if (ann.isSetEndpoint()) {
-    endpoint_ = ann.endpoint();
+    endpoint_ = ann.sharedEndpoint();
   }
 
   return *this;
 }
 
-const std::string BinaryAnnotation::toJson() {
+const std::string BinaryAnnotation::toJson() const {
   rapidjson::StringBuffer s;
   rapidjson::Writer<rapidjson::StringBuffer> writer(s);
   writer.StartObject();
@@ -130,14 +170,30 @@ const std::string BinaryAnnotation::toJson() {
 
   std::string json_string = s.GetString();
 
-  if (endpoint_.valid()) {
-    Util::mergeJsons(json_string, static_cast<Endpoint>(endpoint_.value()).toJson(),
+  if (endpoint_) {
+    Util::mergeJsons(json_string, endpoint_->toJson(),
                      ZipkinJsonFieldNames::get().BINARY_ANNOTATION_ENDPOINT.c_str());
   }
 
   return json_string;
 }
 
+void BinaryAnnotation::toThrift(Buffer::Instance& buffer) const {
+  // struct BinaryAnnotation { 1: string key, 2: binary value, 3: AnnotationType annotation_type,
+  // 4: optional Endpoint host }, where the Thrift AnnotationType of strings is 6.
+  Util::addThriftFieldHeader(buffer, THRIFT_STRING, 1);
+  Util::addThriftString(buffer, key_);
+  Util::addThriftFieldHeader(buffer, THRIFT_STRING, 2);
+  Util::addThriftString(buffer, value_);
+  Util::addThriftFieldHeader(buffer, THRIFT_I32, 3);
+  Util::addThriftI32(buffer, annotation_type_ == BOOL ? 0 : 6);
+  if (endpoint_) {
+    Util::addThriftFieldHeader(buffer, THRIFT_STRUCT, 4);
+    endpoint_->toThrift(buffer);
+  }
+  Util::addThriftFieldStop(buffer);
+}
+
 const std::string Span::EMPTY_HEX_STRING_ = "0000000000000000";
 
 Span::Span(const Span& span) {
@@ -169,7 +225,7 @@ void Span::setServiceName(const std::string& service_name) {
   }
 }
 
-const std::string Span::toJson() {
+const std::string Span::toJson() const {
   rapidjson::StringBuffer s;
   rapidjson::Writer<rapidjson::StringBuffer> writer(s);
   writer.StartObject();
@@ -217,13 +273,81 @@ const std::string Span::toJson() {
   return json_string;
 }
 
+void Span::toThrift(Buffer::Instance& buffer) const {
+  // struct Span { 1: i64 trace_id, 3: string name, 4: i64 id, 5: optional i64 parent_id,
+  // 6: list<Annotation> annotations, 8: list<BinaryAnnotation> binary_annotations,
+  // 9: optional bool debug, 10: optional i64 timestamp, 11: optional i64 duration,
+  // 12: optional i64 trace_id_high }
+  Util::addThriftFieldHeader(buffer, THRIFT_I64, 1);
+  Util::addThriftI64(buffer, trace_id_);
+  Util::addThriftFieldHeader(buffer, THRIFT_STRING, 3);
+  Util::addThriftString(buffer, name_);
+  Util::addThriftFieldHeader(buffer, THRIFT_I64, 4);
+  Util::addThriftI64(buffer, id_);
+
+  if (parent_id_.valid() && parent_id_.value()) {
+    Util::addThriftFieldHeader(buffer, THRIFT_I64, 5);
+    Util::addThriftI64(buffer, parent_id_.value());
+  }
+
+  Util::addThriftFieldHeader(buffer, THRIFT_LIST, 6);
+  Util::addThriftListHeader(buffer, THRIFT_STRUCT, annotations_.size());
+  for (const Annotation& annotation : annotations_) {
+    annotation.toThrift(buffer);
+  }
+
+  Util::addThriftFieldHeader(buffer, THRIFT_LIST, 8);
+  Util::addThriftListHeader(buffer, THRIFT_STRUCT, binary_annotations_.size());
+  for (const BinaryAnnotation& binary_annotation : binary_annotations_) {
+    binary_annotation.toThrift(buffer);
+  }
+
+  if (debug_) {
+    const uint8_t debug = 1;
+    Util::addThriftFieldHeader(buffer, THRIFT_BOOL, 9);
+    buffer.add(&debug, sizeof(debug));
+  }
+
+  if (timestamp_.valid()) {
+    Util::addThriftFieldHeader(buffer, THRIFT_I64, 10);
+    Util::addThriftI64(buffer, timestamp_.value());
+  }
+
+  if (duration_.valid()) {
+    Util::addThriftFieldHeader(buffer, THRIFT_I64, 11);
+    Util::addThriftI64(buffer, duration_.value());
+  }
+
+  if (trace_id_high_.valid()) {
+    Util::addThriftFieldHeader(buffer, THRIFT_I64, 12);
+    Util::addThriftI64(buffer, trace_id_high_.value());
+  }
+
+  Util::addThriftFieldStop(buffer);
+}
+
+void Span::reset() {
+  trace_id_ = 0;
+  name_.clear();
+  id_ = 0;
+  parent_id_ = Optional<uint64_t>();
+  debug_ = false;
+  annotations_.clear();
+  binary_annotations_.clear();
+  timestamp_ = Optional<int64_t>();
+  duration_ = Optional<int64_t>();
+  trace_id_high_ = Optional<uint64_t>();
+  monotonic_start_time_ = 0;
+  tracer_ = nullptr;
+}
+
 void Span::finish() {
   // Assumption: Span will have only one annotation when this method is called
   SpanContext context(*this);
   if (annotations_[0].value() == ZipkinCoreConstants::get().SERVER_RECV) {
     // Need to set the SS annotation
     Annotation ss;
-    ss.setEndpoint(annotations_[0].endpoint());
+    ss.setEndpoint(annotations_[0].sharedEndpoint());
     ss.setTimestamp(std::chrono::duration_cast<std::chrono::microseconds>(
                         ProdSystemTimeSource::instance_.currentTime().time_since_epoch())
                         .count());
@@ -236,7 +360,7 @@ void Span::finish() {
         std::chrono::duration_cast<std::chrono::microseconds>(
             ProdSystemTimeSource::instance_.currentTime().time_since_epoch())
             .count();
-    cr.setEndpoint(annotations_[0].endpoint());
+    cr.setEndpoint(annotations_[0].sharedEndpoint());
     cr.setTimestamp(stop_timestamp);
     cr.setValue(ZipkinCoreConstants::get().CLIENT_RECV);
     annotations_.push_back(std::move(cr));
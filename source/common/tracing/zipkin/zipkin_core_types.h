@@ -2,6 +2,7 @@
 
 #include <memory>
 
+#include "envoy/buffer/buffer.h"
 #include "envoy/common/optional.h"
 #include "envoy/common/pure.h"
 #include "envoy/network/address.h"
@@ -28,7 +29,14 @@ public:
    * All classes defining Zipkin abstractions need to implement this method to convert
    * the corresponding abstraction to a Zipkin-compliant JSON.
    */
-  virtual const std::string toJson() PURE;
+  virtual const std::string toJson() const PURE;
+
+  /**
+   * All classes defining Zipkin abstractions need to implement this method to append
+   * the corresponding abstraction to a buffer as a Zipkin Thrift struct, encoded with
+   * the Thrift binary protocol.
+   */
+  virtual void toThrift(Buffer::Instance& buffer) const PURE;
 };
 
 /**
@@ -86,13 +94,22 @@ public:
    *
    * @return a stringified JSON.
    */
-  const std::string toJson() override;
+  const std::string toJson() const override;
+
+  /**
+   * Serializes the endpoint as a Zipkin Thrift struct.
+   *
+   * @param buffer The buffer the struct is appended to.
+   */
+  void toThrift(Buffer::Instance& buffer) const override;
 
 private:
   std::string service_name_;
   Network::Address::InstanceConstSharedPtr address_;
 };
 
+typedef std::shared_ptr<const Endpoint> EndpointConstSharedPtr;
+
 /**
  * Represents a Zipkin basic annotation. This class is based on Zipkin's Thrift definition of
  * an annotation.
@@ -123,22 +140,37 @@ public:
    * @param endpoint The endpoint object representing the annotation's endpoint attribute.
    */
   Annotation(uint64_t timestamp, const std::string value, Endpoint& endpoint)
-      : timestamp_(timestamp), value_(value), endpoint_(endpoint) {}
+      : timestamp_(timestamp), value_(value),
+        endpoint_(std::make_shared<const Endpoint>(endpoint)) {}
 
   /**
    * @return the annotation's endpoint attribute.
    */
-  const Endpoint& endpoint() const { return endpoint_.value(); }
+  const Endpoint& endpoint() const { return *endpoint_; }
+
+  /**
+   * @return the annotation's endpoint attribute, which can be shared with other annotations.
+   */
+  const EndpointConstSharedPtr& sharedEndpoint() const { return endpoint_; }
 
   /**
    * Sets the annotation's endpoint attribute (copy semantics).
    */
-  void setEndpoint(const Endpoint& endpoint) { endpoint_.value(endpoint); }
+  void setEndpoint(const Endpoint& endpoint) {
+    endpoint_ = std::make_shared<const Endpoint>(endpoint);
+  }
 
   /**
    * Sets the annotation's endpoint attribute (move semantics).
    */
-  void setEndpoint(const Endpoint&& endpoint) { endpoint_.value(endpoint); }
+  void setEndpoint(const Endpoint&& endpoint) {
+    endpoint_ = std::make_shared<const Endpoint>(endpoint);
+  }
+
+  /**
+   * Sets the annotation's endpoint attribute to an endpoint shared with other annotations.
+   */
+  void setEndpoint(EndpointConstSharedPtr endpoint) { endpoint_ = std::move(endpoint); }
 
   /**
    * Replaces the endpoint's service-name attribute value with the given value.
@@ -171,19 +203,26 @@ public:
   /**
    * @return true if the endpoint attribute is set, or false otherwise.
    */
-  bool isSetEndpoint() const { return endpoint_.valid(); }
+  bool isSetEndpoint() const { return endpoint_ != nullptr; }
 
   /**
    * Serializes the annotation as a Zipkin-compliant JSON representation as a string.
    *
    * @return a stringified JSON.
    */
-  const std::string toJson() override;
+  const std::string toJson() const override;
+
+  /**
+   * Serializes the annotation as a Zipkin Thrift struct.
+   *
+   * @param buffer The buffer the struct is appended to.
+   */
+  void toThrift(Buffer::Instance& buffer) const override;
 
 private:
   uint64_t timestamp_;
   std::string value_;
-  Optional<Endpoint> endpoint_;
+  EndpointConstSharedPtr endpoint_;
 };
 
 /**
@@ -235,22 +274,36 @@ public:
   /**
    * @return the annotation's endpoint attribute.
    */
-  const Endpoint& endpoint() const { return endpoint_.value(); }
+  const Endpoint& endpoint() const { return *endpoint_; }
+
+  /**
+   * @return the annotation's endpoint attribute, which can be shared with other annotations.
+   */
+  const EndpointConstSharedPtr& sharedEndpoint() const { return endpoint_; }
 
   /**
    * Sets the annotation's endpoint attribute (copy semantics).
    */
-  void setEndpoint(const Endpoint& endpoint) { endpoint_.value(endpoint); }
+  void setEndpoint(const Endpoint& endpoint) {
+    endpoint_ = std::make_shared<const Endpoint>(endpoint);
+  }
 
   /**
    * Sets the annotation's endpoint attribute (move semantics).
    */
-  void setEndpoint(const Endpoint&& endpoint) { endpoint_.value(endpoint); }
+  void setEndpoint(const Endpoint&& endpoint) {
+    endpoint_ = std::make_shared<const Endpoint>(endpoint);
+  }
+
+  /**
+   * Sets the annotation's endpoint attribute to an endpoint shared with other annotations.
+   */
+  void setEndpoint(EndpointConstSharedPtr endpoint) { endpoint_ = std::move(endpoint); }
 
   /**
    * @return true of the endpoint attribute has been set, or false otherwise.
    */
-  bool isSetEndpoint() const { return endpoint_.valid(); }
+  bool isSetEndpoint() const { return endpoint_ != nullptr; }
 
   /**
    * @return the key attribute.
@@ -277,12 +330,19 @@ public:
    *
    * @return a stringified JSON.
    */
-  const std::string toJson() override;
+  const std::string toJson() const override;
+
+  /**
+   * Serializes the binary annotation as a Zipkin Thrift struct.
+   *
+   * @param buffer The buffer the struct is appended to.
+   */
+  void toThrift(Buffer::Instance& buffer) const override;
 
 private:
   std::string key_;
   std::string value_;
-  Optional<Endpoint> endpoint_;
+  EndpointConstSharedPtr endpoint_;
   AnnotationType annotation_type_;
 };
 
@@ -494,7 +554,14 @@ public:
    *
    * @return a stringified JSON.
    */
-  const std::string toJson() override;
+  const std::string toJson() const override;
+
+  /**
+   * Serializes the span as a Zipkin Thrift struct.
+   *
+   * @param buffer The buffer the struct is appended to.
+   */
+  void toThrift(Buffer::Instance& buffer) const override;
 
   /**
    * Associates a Tracer object with the span. The tracer's reportSpan() method is invoked
@@ -510,6 +577,12 @@ public:
    */
   TracerInterface* tracer() const { return tracer_; }
 
+  /**
+   * Returns the span to the state of a default-constructed span, keeping the storage of its
+   * name and annotations so that it can be reused by a new span.
+   */
+  void reset();
+
   /**
    * Marks a successful end of the span. This method will:
    *
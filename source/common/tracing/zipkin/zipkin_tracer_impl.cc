@@ -13,39 +13,42 @@
 namespace Envoy {
 namespace Zipkin {
 
-ZipkinSpan::ZipkinSpan(Zipkin::Span& span, Zipkin::Tracer& tracer) : span_(span), tracer_(tracer) {}
+ZipkinSpan::ZipkinSpan(Zipkin::SpanPtr&& span, Zipkin::Tracer& tracer)
+    : span_(std::move(span)), tracer_(tracer) {}
 
-void ZipkinSpan::finishSpan() { span_.finish(); }
+ZipkinSpan::~ZipkinSpan() { tracer_.releaseSpan(std::move(span_)); }
 
-void ZipkinSpan::setOperation(const std::string& operation) { span_.setName(operation); }
+void ZipkinSpan::finishSpan() { span_->finish(); }
+
+void ZipkinSpan::setOperation(const std::string& operation) { span_->setName(operation); }
 
 void ZipkinSpan::setTag(const std::string& name, const std::string& value) {
-  span_.setTag(name, value);
+  span_->setTag(name, value);
 }
 
 void ZipkinSpan::injectContext(Http::HeaderMap& request_headers) {
   // Set the trace-id and span-id headers properly, based on the newly-created span structure.
-  request_headers.insertXB3TraceId().value(span_.traceIdAsHexString());
-  request_headers.insertXB3SpanId().value(span_.idAsHexString());
+  request_headers.insertXB3TraceId().value(span_->traceIdAsHexString());
+  request_headers.insertXB3SpanId().value(span_->idAsHexString());
 
   // Set the parent-span header properly, based on the newly-created span structure.
-  if (span_.isSetParentId()) {
-    request_headers.insertXB3ParentSpanId().value(span_.parentIdAsHexString());
+  if (span_->isSetParentId()) {
+    request_headers.insertXB3ParentSpanId().value(span_->parentIdAsHexString());
   }
 
   // Set the sampled header.
   request_headers.insertXB3Sampled().value().setReference(ZipkinCoreConstants::get().ALWAYS_SAMPLE);
 
   // Set the ot-span-context header with the new context.
-  SpanContext context(span_);
+  SpanContext context(*span_);
   request_headers.insertOtSpanContext().value(context.serializeToString());
 }
 
 Tracing::SpanPtr ZipkinSpan::spawnChild(const Tracing::Config& config, const std::string& name,
                                         SystemTime start_time) {
-  SpanContext context(span_);
+  SpanContext context(*span_);
   return Tracing::SpanPtr{
-      new ZipkinSpan(*tracer_.startSpan(config, name, start_time, context), tracer_)};
+      new ZipkinSpan(tracer_.startSpan(config, name, start_time, context), tracer_)};
 }
 
 Driver::TlsTracer::TlsTracer(TracerPtr&& tracer, Driver& driver)
@@ -68,12 +71,22 @@ Driver::Driver(const Json::Object& config, Upstream::ClusterManager& cluster_man
   const std::string collector_endpoint =
       config.getString("collector_endpoint", ZipkinCoreConstants::get().DEFAULT_COLLECTOR_ENDPOINT);
 
-  tls_->set([this, collector_endpoint, &random_generator](
+  const std::string collector_encoding = config.getString("collector_encoding", "json");
+  SpanEncoding encoding;
+  if (collector_encoding == "json") {
+    encoding = SpanEncoding::Json;
+  } else if (collector_encoding == "thrift") {
+    encoding = SpanEncoding::Thrift;
+  } else {
+    throw EnvoyException(fmt::format("unknown zipkin collector encoding '{}'", collector_encoding));
+  }
+
+  tls_->set([this, collector_endpoint, encoding, &random_generator](
                 Event::Dispatcher& dispatcher) -> ThreadLocal::ThreadLocalObjectSharedPtr {
     TracerPtr tracer(
         new Tracer(local_info_.clusterName(), local_info_.address(), random_generator));
-    tracer->setReporter(
-        ReporterImpl::NewInstance(std::ref(*this), std::ref(dispatcher), collector_endpoint));
+    tracer->setReporter(ReporterImpl::NewInstance(std::ref(*this), std::ref(dispatcher),
+                                                  collector_endpoint, encoding));
     return ThreadLocal::ThreadLocalObjectSharedPtr{new TlsTracer(std::move(tracer), *this)};
   });
 }
@@ -125,13 +138,13 @@ Tracing::SpanPtr Driver::startSpan(const Tracing::Config& config, Http::HeaderMa
     new_zipkin_span = tracer.startSpan(config, request_headers.Host()->value().c_str(), start_time);
   }
 
-  ZipkinSpanPtr active_span(new ZipkinSpan(*new_zipkin_span, tracer));
+  ZipkinSpanPtr active_span(new ZipkinSpan(std::move(new_zipkin_span), tracer));
   return std::move(active_span);
 }
 
 ReporterImpl::ReporterImpl(Driver& driver, Event::Dispatcher& dispatcher,
-                           const std::string& collector_endpoint)
-    : driver_(driver), collector_endpoint_(collector_endpoint) {
+                           const std::string& collector_endpoint, SpanEncoding encoding)
+    : driver_(driver), span_buffer_(encoding), collector_endpoint_(collector_endpoint) {
   flush_timer_ = dispatcher.createTimer([this]() -> void {
     driver_.tracerStats().timer_flushed_.inc();
     flushSpans();
@@ -146,18 +159,21 @@ ReporterImpl::ReporterImpl(Driver& driver, Event::Dispatcher& dispatcher,
 }
 
 ReporterPtr ReporterImpl::NewInstance(Driver& driver, Event::Dispatcher& dispatcher,
-                                      const std::string& collector_endpoint) {
-  return ReporterPtr(new ReporterImpl(driver, dispatcher, collector_endpoint));
+                                      const std::string& collector_endpoint,
+                                      SpanEncoding encoding) {
+  return ReporterPtr(new ReporterImpl(driver, dispatcher, collector_endpoint, encoding));
 }
 
-// TODO(fabolive): Need to avoid the copy to improve performance.
 void ReporterImpl::reportSpan(const Span& span) {
   span_buffer_.addSpan(span);
 
   const uint64_t min_flush_spans =
       driver_.runtime().snapshot().getInteger("tracing.zipkin.min_flush_spans", 5U);
+  const uint64_t max_buffer_bytes =
+      driver_.runtime().snapshot().getInteger("tracing.zipkin.max_buffer_bytes", 65536U);
 
-  if (span_buffer_.pendingSpans() == min_flush_spans) {
+  if (span_buffer_.pendingSpans() == min_flush_spans ||
+      span_buffer_.pendingBytes() >= max_buffer_bytes) {
     flushSpans();
   }
 }
@@ -170,35 +186,52 @@ void ReporterImpl::enableTimer() {
 
 void ReporterImpl::flushSpans() {
   if (span_buffer_.pendingSpans()) {
+    const uint64_t max_pending_reports =
+        driver_.runtime().snapshot().getInteger("tracing.zipkin.max_pending_reports", 16U);
+    if (pending_reports_ >= max_pending_reports) {
+      // The collector isn't keeping up, so shed the spans rather than queueing more reports.
+      driver_.tracerStats().spans_dropped_.add(span_buffer_.pendingSpans());
+      span_buffer_.clear();
+      return;
+    }
+
     driver_.tracerStats().spans_sent_.add(span_buffer_.pendingSpans());
 
-    const std::string request_body = span_buffer_.toStringifiedJsonArray();
     Http::MessagePtr message(new Http::RequestMessageImpl());
     message->headers().insertMethod().value().setReference(Http::Headers::get().MethodValues.Post);
     message->headers().insertPath().value(collector_endpoint_);
     message->headers().insertHost().value(driver_.cluster()->name());
     message->headers().insertContentType().value().setReference(
-        Http::Headers::get().ContentTypeValues.Json);
+        span_buffer_.encoding() == SpanEncoding::Thrift
+            ? ZipkinCoreConstants::get().THRIFT_CONTENT_TYPE
+            : Http::Headers::get().ContentTypeValues.Json);
 
     Buffer::InstancePtr body(new Buffer::OwnedImpl());
-    body->add(request_body);
+    span_buffer_.moveSerialized(*body);
     message->body() = std::move(body);
 
     const uint64_t timeout =
         driver_.runtime().snapshot().getInteger("tracing.zipkin.request_timeout", 5000U);
+    pending_reports_++;
     driver_.clusterManager()
         .httpAsyncClientForCluster(driver_.cluster()->name())
         .send(std::move(message), *this, std::chrono::milliseconds(timeout));
+  }
+}
 
-    span_buffer_.clear();
+void ReporterImpl::onReportDone() {
+  if (pending_reports_ > 0) {
+    pending_reports_--;
   }
 }
 
 void ReporterImpl::onFailure(Http::AsyncClient::FailureReason) {
+  onReportDone();
   driver_.tracerStats().reports_failed_.inc();
 }
 
 void ReporterImpl::onSuccess(Http::MessagePtr&& http_response) {
+  onReportDone();
   if (Http::Utility::getResponseStatus(http_response->headers()) !=
       enumToInt(Http::Code::Accepted)) {
     driver_.tracerStats().reports_dropped_.inc();
@@ -16,6 +16,7 @@ namespace Zipkin {
 
 #define ZIPKIN_TRACER_STATS(COUNTER)                                                               \
   COUNTER(spans_sent)                                                                              \
+  COUNTER(spans_dropped)                                                                           \
   COUNTER(timer_flushed)                                                                           \
   COUNTER(reports_sent)                                                                            \
   COUNTER(reports_dropped)                                                                         \
@@ -34,8 +35,10 @@ public:
    * Constructor. Wraps a Zipkin::Span object.
    *
    * @param span to be wrapped.
+   * @param tracer The tracer which started the span, and to which it is released on destruction.
    */
-  ZipkinSpan(Zipkin::Span& span, Zipkin::Tracer& tracer);
+  ZipkinSpan(Zipkin::SpanPtr&& span, Zipkin::Tracer& tracer);
+  ~ZipkinSpan();
 
   /**
    * Calls Zipkin::Span::finishSpan() to perform all actions needed to finalize the span.
@@ -66,10 +69,10 @@ public:
   /**
    * @return a reference to the Zipkin::Span object.
    */
-  Zipkin::Span& span() { return span_; }
+  Zipkin::Span& span() { return *span_; }
 
 private:
-  Zipkin::Span span_;
+  Zipkin::SpanPtr span_;
   Zipkin::Tracer& tracer_;
 };
 
@@ -128,17 +131,22 @@ private:
 
 /**
  * This class derives from the abstract Zipkin::Reporter.
- * It buffers spans and relies on Http::AsyncClient to send spans to
- * Zipkin using JSON over HTTP.
+ * It serializes spans into a buffer as they finish, and relies on Http::AsyncClient to send
+ * them to Zipkin using either JSON or Thrift over HTTP.
  *
- * Two runtime parameters control the span buffering/flushing behavior, namely:
- * tracing.zipkin.min_flush_spans and tracing.zipkin.flush_interval_ms.
+ * Three runtime parameters control the span buffering/flushing behavior, namely:
+ * tracing.zipkin.min_flush_spans, tracing.zipkin.max_buffer_bytes and
+ * tracing.zipkin.flush_interval_ms.
  *
  * Up to `tracing.zipkin.min_flush_spans` will be buffered. Spans are flushed (sent to Zipkin)
- * either when the buffer is full, or when a timer, set to `tracing.zipkin.flush_interval_ms`,
+ * either when the buffer is full, when the serialized spans reach
+ * `tracing.zipkin.max_buffer_bytes`, or when a timer, set to `tracing.zipkin.flush_interval_ms`,
  * expires, whichever happens first.
  *
- * The default values for the runtime parameters are 5 spans and 5000ms.
+ * The default values for the runtime parameters are 5 spans, 65536 bytes and 5000ms.
+ *
+ * At most `tracing.zipkin.max_pending_reports` (default 16) reports can be in flight. Spans
+ * flushed while that many reports are pending are dropped and counted in spans_dropped.
  */
 class ReporterImpl : public Reporter, Http::AsyncClient::Callbacks {
 public:
@@ -150,9 +158,10 @@ public:
    * @param collector_endpoint String representing the Zipkin endpoint to be used
    * when making HTTP POST requests carrying spans. This value comes from the
    * Zipkin-related tracing configuration.
+   * @param encoding The encoding of the spans sent to Zipkin.
    */
   ReporterImpl(Driver& driver, Event::Dispatcher& dispatcher,
-               const std::string& collector_endpoint);
+               const std::string& collector_endpoint, SpanEncoding encoding);
 
   /**
    * Implementation of Zipkin::Reporter::reportSpan().
@@ -176,11 +185,12 @@ public:
    * @param collector_endpoint String representing the Zipkin endpoint to be used
    * when making HTTP POST requests carrying spans. This value comes from the
    * Zipkin-related tracing configuration.
+   * @param encoding The encoding of the spans sent to Zipkin.
    *
    * @return Pointer to the newly-created ZipkinReporter.
    */
   static ReporterPtr NewInstance(Driver& driver, Event::Dispatcher& dispatcher,
-                                 const std::string& collector_endpoint);
+                                 const std::string& collector_endpoint, SpanEncoding encoding);
 
 private:
   /**
@@ -193,10 +203,16 @@ private:
    */
   void flushSpans();
 
+  /**
+   * Accounts for the completion of a report.
+   */
+  void onReportDone();
+
   Driver& driver_;
   Event::TimerPtr flush_timer_;
   SpanBuffer span_buffer_;
   const std::string collector_endpoint_;
+  uint64_t pending_reports_{};
 };
 } // Zipkin
 } // namespace Envoy
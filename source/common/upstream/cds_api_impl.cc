@@ -1,8 +1,10 @@
 #include "common/upstream/cds_api_impl.h"
 
 #include <string>
+#include <unordered_set>
 
 #include "common/common/cleanup.h"
+#include "common/config/cached_subscription_impl.h"
 #include "common/config/resources.h"
 #include "common/config/subscription_factory.h"
 #include "common/config/utility.h"
@@ -16,18 +18,20 @@ namespace Upstream {
 
 CdsApiPtr CdsApiImpl::create(const envoy::api::v2::ConfigSource& cds_config,
                              const Optional<envoy::api::v2::ConfigSource>& eds_config,
-                             ClusterManager& cm, Event::Dispatcher& dispatcher,
-                             Runtime::RandomGenerator& random,
-                             const LocalInfo::LocalInfo& local_info, Stats::Scope& scope) {
-  return CdsApiPtr{
-      new CdsApiImpl(cds_config, eds_config, cm, dispatcher, random, local_info, scope)};
+                             ClusterManager& cm, ThreadLocal::Instance& tls,
+                             Event::Dispatcher& dispatcher, Runtime::RandomGenerator& random,
+                             const LocalInfo::LocalInfo& local_info, Stats::Scope& scope,
+                             const std::string& cache_path) {
+  return CdsApiPtr{new CdsApiImpl(cds_config, eds_config, cm, tls, dispatcher, random, local_info,
+                                  scope, cache_path)};
 }
 
 CdsApiImpl::CdsApiImpl(const envoy::api::v2::ConfigSource& cds_config,
                        const Optional<envoy::api::v2::ConfigSource>& eds_config, ClusterManager& cm,
-                       Event::Dispatcher& dispatcher, Runtime::RandomGenerator& random,
-                       const LocalInfo::LocalInfo& local_info, Stats::Scope& scope)
-    : cm_(cm), scope_(scope.createScope("cluster_manager.cds.")) {
+                       ThreadLocal::Instance& tls, Event::Dispatcher& dispatcher,
+                       Runtime::RandomGenerator& random, const LocalInfo::LocalInfo& local_info,
+                       Stats::Scope& scope, const std::string& cache_path)
+    : cm_(cm), tls_(tls), scope_(scope.createScope("cluster_manager.cds.")) {
   Config::Utility::checkLocalInfo("cds", local_info);
   subscription_ =
       Config::SubscriptionFactory::subscriptionFromConfigSource<envoy::api::v2::Cluster>(
@@ -39,6 +43,10 @@ CdsApiImpl::CdsApiImpl(const envoy::api::v2::ConfigSource& cds_config,
           },
           "envoy.api.v2.ClusterDiscoveryService.FetchClusters",
           "envoy.api.v2.ClusterDiscoveryService.StreamClusters");
+  if (!cache_path.empty()) {
+    subscription_.reset(new Config::CachedSubscriptionImpl<envoy::api::v2::Cluster>(
+        std::move(subscription_), cache_path + "/cds.pb"));
+  }
 }
 
 void CdsApiImpl::onConfigUpdate(const ResourceVector& resources) {
@@ -47,18 +55,28 @@ void CdsApiImpl::onConfigUpdate(const ResourceVector& resources) {
   for (const auto& cluster : resources) {
     MessageUtil::validate(cluster);
   }
-  // We need to keep track of which clusters we might need to remove.
-  ClusterManager::ClusterInfoMap clusters_to_remove = cm_.clusters();
+  // Every added, updated or removed cluster updates the workers, so send all the updates to each
+  // worker at once.
+  tls_.startBatch();
+  Cleanup end_batch([this] { tls_.endBatch(); });
+  // We need to keep track of which clusters we might need to remove. On-demand clusters which
+  // haven't been created yet aren't in clusters(), so the clusters in the previous update are
+  // removed as well.
+  std::unordered_set<std::string> clusters_to_remove = std::move(cluster_names_);
+  for (const auto& cluster : cm_.clusters()) {
+    clusters_to_remove.insert(cluster.first);
+  }
+  cluster_names_.clear();
   for (auto& cluster : resources) {
     const std::string cluster_name = cluster.name();
     clusters_to_remove.erase(cluster_name);
+    cluster_names_.insert(cluster_name);
     if (cm_.addOrUpdatePrimaryCluster(cluster)) {
       ENVOY_LOG(debug, "cds: add/update cluster '{}'", cluster_name);
     }
   }
 
-  for (auto cluster : clusters_to_remove) {
-    const std::string cluster_name = cluster.first;
+  for (const std::string& cluster_name : clusters_to_remove) {
     if (cm_.removePrimaryCluster(cluster_name)) {
       ENVOY_LOG(debug, "cds: remove cluster '{}'", cluster_name);
     }
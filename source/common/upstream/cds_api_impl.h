@@ -1,10 +1,13 @@
 #pragma once
 
 #include <functional>
+#include <string>
+#include <unordered_set>
 
 #include "envoy/config/subscription.h"
 #include "envoy/event/dispatcher.h"
 #include "envoy/local_info/local_info.h"
+#include "envoy/thread_local/thread_local.h"
 #include "envoy/upstream/cluster_manager.h"
 
 #include "common/common/logger.h"
@@ -23,9 +26,10 @@ class CdsApiImpl : public CdsApi,
 public:
   static CdsApiPtr create(const envoy::api::v2::ConfigSource& cds_config,
                           const Optional<envoy::api::v2::ConfigSource>& eds_config,
-                          ClusterManager& cm, Event::Dispatcher& dispatcher,
-                          Runtime::RandomGenerator& random, const LocalInfo::LocalInfo& local_info,
-                          Stats::Scope& scope);
+                          ClusterManager& cm, ThreadLocal::Instance& tls,
+                          Event::Dispatcher& dispatcher, Runtime::RandomGenerator& random,
+                          const LocalInfo::LocalInfo& local_info, Stats::Scope& scope,
+                          const std::string& cache_path);
 
   // Upstream::CdsApi
   void initialize() override { subscription_->start({}, *this); }
@@ -41,14 +45,18 @@ public:
 private:
   CdsApiImpl(const envoy::api::v2::ConfigSource& cds_config,
              const Optional<envoy::api::v2::ConfigSource>& eds_config, ClusterManager& cm,
-             Event::Dispatcher& dispatcher, Runtime::RandomGenerator& random,
-             const LocalInfo::LocalInfo& local_info, Stats::Scope& scope);
+             ThreadLocal::Instance& tls, Event::Dispatcher& dispatcher,
+             Runtime::RandomGenerator& random, const LocalInfo::LocalInfo& local_info,
+             Stats::Scope& scope, const std::string& cache_path);
   void runInitializeCallbackIfAny();
 
   ClusterManager& cm_;
+  ThreadLocal::Instance& tls_;
   std::unique_ptr<Config::Subscription<envoy::api::v2::Cluster>> subscription_;
   std::function<void()> initialize_callback_;
   Stats::ScopePtr scope_;
+  // The names of the clusters in the last update.
+  std::unordered_set<std::string> cluster_names_;
 };
 
 } // namespace Upstream
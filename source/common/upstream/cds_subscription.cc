@@ -39,10 +39,10 @@ void CdsSubscription::createRequest(Http::Message& request) {
       fmt::format("/v1/clusters/{}/{}", local_info_.clusterName(), local_info_.nodeName()));
 }
 
-void CdsSubscription::parseResponse(const Http::Message& response) {
+void CdsSubscription::parseResponse(Http::Message& response) {
   ENVOY_LOG(debug, "cds: parsing response");
-  const std::string response_body = response.bodyAsString();
-  Json::ObjectSharedPtr response_json = Json::Factory::loadFromString(response_body);
+  const Buffer::Instance& response_body = *response.body();
+  Json::ObjectSharedPtr response_json = Json::Factory::loadFromBuffer(response_body);
   response_json->validateSchema(Json::Schema::CDS_SCHEMA);
   std::vector<Json::ObjectSharedPtr> clusters = response_json->getObjectArray("clusters");
 
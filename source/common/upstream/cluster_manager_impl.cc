@@ -11,9 +11,12 @@
 #include "envoy/network/dns.h"
 #include "envoy/runtime/runtime.h"
 
+#include "common/common/cleanup.h"
 #include "common/common/enum_to_int.h"
 #include "common/common/utility.h"
 #include "common/config/cds_json.h"
+#include "common/config/resources.h"
+#include "common/config/threaded_grpc_mux_impl.h"
 #include "common/config/utility.h"
 #include "common/http/async_client_impl.h"
 #include "common/http/http1/conn_pool.h"
@@ -25,6 +28,7 @@
 #include "common/router/shadow_writer_impl.h"
 #include "common/upstream/cds_api_impl.h"
 #include "common/upstream/load_balancer_impl.h"
+#include "common/upstream/maglev_lb.h"
 #include "common/upstream/original_dst_cluster.h"
 #include "common/upstream/ring_hash_lb.h"
 #include "common/upstream/subset_lb.h"
@@ -34,9 +38,18 @@
 namespace Envoy {
 namespace Upstream {
 
+ClusterManagerInitHelper::ClusterManagerInitHelper(ClusterManager& cm, Runtime::Loader& runtime,
+                                                   MonotonicTimeSource& time_source)
+    : cm_(cm), runtime_(runtime), time_source_(time_source),
+      phase_start_(time_source.currentTime()) {}
+
 void ClusterManagerInitHelper::addCluster(Cluster& cluster) {
   if (state_ == State::AllClustersInitialized) {
-    cluster.initialize([] {});
+    cluster.initialize([&cluster, this] {
+      if (cluster_initialized_callback_) {
+        cluster_initialized_callback_(cluster);
+      }
+    });
     return;
   }
 
@@ -53,13 +66,14 @@ void ClusterManagerInitHelper::addCluster(Cluster& cluster) {
     secondary_init_clusters_.push_back(&cluster);
     if (started_secondary_initialize_) {
       // This can happen if we get a second CDS update that adds new clusters after we have
-      // already started secondary init. In this case, just immediately initialize.
-      cluster.initialize(initialize_cb);
+      // already started secondary init. In this case, initialize as soon as there is room.
+      initializeSecondaryClusters();
     }
   }
 
   ENVOY_LOG(debug, "cm init: adding: cluster={} primary={} secondary={}", cluster.info()->name(),
-            primary_init_clusters_.size(), secondary_init_clusters_.size());
+            primary_init_clusters_.size(),
+            secondary_init_clusters_.size() + secondary_initializing_clusters_.size());
 }
 
 void ClusterManagerInitHelper::removeCluster(Cluster& cluster) {
@@ -69,22 +83,50 @@ void ClusterManagerInitHelper::removeCluster(Cluster& cluster) {
 
   // There is a remote edge case where we can remove a cluster via CDS that has not yet been
   // initialized. When called via the remove cluster API this code catches that case.
-  std::list<Cluster*>* cluster_list;
+  // It is possible that the cluster we are removing has already been initialized, and is not
+  // present in the initializer lists. If so, this is fine.
   if (cluster.initializePhase() == Cluster::InitializePhase::Primary) {
-    cluster_list = &primary_init_clusters_;
+    primary_init_clusters_.remove(&cluster);
   } else {
     ASSERT(cluster.initializePhase() == Cluster::InitializePhase::Secondary);
-    cluster_list = &secondary_init_clusters_;
+    secondary_init_clusters_.remove(&cluster);
+    secondary_initializing_clusters_.remove(&cluster);
   }
 
-  // It is possible that the cluster we are removing has already been initialized, and is not
-  // present in the initializer list. If so, this is fine.
-  cluster_list->remove(&cluster);
   ENVOY_LOG(debug, "cm init: init complete: cluster={} primary={} secondary={}",
-            cluster.info()->name(), primary_init_clusters_.size(), secondary_init_clusters_.size());
+            cluster.info()->name(), primary_init_clusters_.size(),
+            secondary_init_clusters_.size() + secondary_initializing_clusters_.size());
   maybeFinishInitialize();
 }
 
+void ClusterManagerInitHelper::initializeSecondaryClusters() {
+  if (secondary_init_clusters_.empty()) {
+    return;
+  }
+
+  // A limit of 0 initializes all of the secondary clusters at once.
+  const uint64_t max_initializing =
+      runtime_.snapshot().getInteger("upstream.max_concurrent_secondary_cluster_init", 0);
+
+  // Pause EDS so that the clusters started here send a single request between them, rather than
+  // one request per cluster each naming all of the clusters subscribed so far.
+  cm_.adsMux().pause(Config::TypeUrl::get().ClusterLoadAssignment);
+  Cleanup eds_resume([this] { cm_.adsMux().resume(Config::TypeUrl::get().ClusterLoadAssignment); });
+
+  // Cluster::initialize() can complete immediately and remove the cluster, which can start more
+  // clusters from within this loop, so the cluster is moved to the initializing list first.
+  while (!secondary_init_clusters_.empty() &&
+         (max_initializing == 0 || secondary_initializing_clusters_.size() < max_initializing)) {
+    Cluster* cluster = secondary_init_clusters_.front();
+    secondary_init_clusters_.pop_front();
+    secondary_initializing_clusters_.push_back(cluster);
+    cluster->initialize([cluster, this] {
+      ASSERT(state_ != State::AllClustersInitialized);
+      removeCluster(*cluster);
+    });
+  }
+}
+
 void ClusterManagerInitHelper::maybeFinishInitialize() {
   // Do not do anything if we are still doing the initial static load or if we are waiting for
   // CDS initialize.
@@ -98,31 +140,25 @@ void ClusterManagerInitHelper::maybeFinishInitialize() {
     return;
   }
 
-  // If we are still waiting for secondary clusters to initialize, see if we need to first call
-  // initialize on them. This is only done once.
-  if (!secondary_init_clusters_.empty()) {
+  // If we are still waiting for secondary clusters to initialize, initialize any which are
+  // waiting and which fit within the concurrency limit.
+  if (!secondary_init_clusters_.empty() || !secondary_initializing_clusters_.empty()) {
     if (!started_secondary_initialize_) {
       ENVOY_LOG(info, "cm init: initializing secondary clusters");
       started_secondary_initialize_ = true;
-      // Cluster::initialize() method can modify the list of secondary_init_clusters_ to remove
-      // the item currently being initialized, so we eschew range-based-for and do this complicated
-      // dance to increment the iterator before calling initialize.
-      for (auto iter = secondary_init_clusters_.begin(); iter != secondary_init_clusters_.end();) {
-        Cluster* cluster = *iter;
-        ++iter;
-        cluster->initialize([cluster, this] {
-          ASSERT(state_ != State::AllClustersInitialized);
-          removeCluster(*cluster);
-        });
-      }
     }
-
+    initializeSecondaryClusters();
     return;
   }
 
   // At this point, if we are doing static init, and we have CDS, start CDS init. Otherwise, move
   // directly to initialized.
   started_secondary_initialize_ = false;
+  if (state_ == State::WaitingForStaticInitialize) {
+    init_times_.static_clusters_ = finishPhase();
+  } else {
+    init_times_.cds_clusters_ = finishPhase();
+  }
   if (state_ == State::WaitingForStaticInitialize && cds_) {
     ENVOY_LOG(info, "cm init: initializing cds");
     state_ = State::WaitingForCdsInitialize;
@@ -136,6 +172,13 @@ void ClusterManagerInitHelper::maybeFinishInitialize() {
   }
 }
 
+std::chrono::milliseconds ClusterManagerInitHelper::finishPhase() {
+  const MonotonicTime now = time_source_.currentTime();
+  const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - phase_start_);
+  phase_start_ = now;
+  return duration;
+}
+
 void ClusterManagerInitHelper::onStaticLoadComplete() {
   ASSERT(state_ == State::Loading);
   state_ = State::WaitingForStaticInitialize;
@@ -148,6 +191,7 @@ void ClusterManagerInitHelper::setCds(CdsApi* cds) {
   if (cds_) {
     cds_->setInitializedCb([this]() -> void {
       ASSERT(state_ == State::WaitingForCdsInitialize);
+      init_times_.cds_ = finishPhase();
       state_ = State::CdsInitialized;
       maybeFinishInitialize();
     });
@@ -168,9 +212,21 @@ ClusterManagerImpl::ClusterManagerImpl(const envoy::api::v2::Bootstrap& bootstra
                                        Runtime::RandomGenerator& random,
                                        const LocalInfo::LocalInfo& local_info,
                                        AccessLog::AccessLogManager& log_manager,
-                                       Event::Dispatcher& primary_dispatcher)
-    : factory_(factory), runtime_(runtime), stats_(stats), tls_(tls.allocateSlot()),
-      random_(random), local_info_(local_info), cm_stats_(generateStats(stats)) {
+                                       Event::Dispatcher& primary_dispatcher,
+                                       Event::Dispatcher* xds_dispatcher)
+    : factory_(factory), primary_dispatcher_(primary_dispatcher), runtime_(runtime),
+      stats_(stats), tls_(tls.allocateSlot()), random_(random), local_info_(local_info),
+      cm_stats_(generateStats(stats)),
+      init_helper_(*this, runtime, ProdMonotonicTimeSource::instance_) {
+  init_helper_.setClusterInitializedCb([this](Cluster& cluster) -> void {
+    // Callers waiting for an on-demand cluster are notified from a new event, after the cluster
+    // has been posted to the workers. Initialization can complete from within loadCluster().
+    const std::string& cluster_name = cluster.info()->name();
+    if (on_demand_cluster_waiters_.count(cluster_name) > 0) {
+      primary_dispatcher_.post(
+          [this, cluster_name]() -> void { notifyOnDemandClusterWaiters(cluster_name); });
+    }
+  });
   const auto& ads_config = bootstrap.dynamic_resources().ads_config();
   if (ads_config.cluster_name().empty()) {
     ENVOY_LOG(debug, "No ADS clusters defined, ADS will not be initialized.");
@@ -181,10 +237,23 @@ ClusterManagerImpl::ClusterManagerImpl(const envoy::api::v2::Bootstrap& bootstra
       throw EnvoyException(
           "envoy::api::v2::ApiConfigSource must have a singleton cluster name specified");
     }
-    ads_mux_.reset(new Config::GrpcMuxImpl(
-        bootstrap.node(), *this, ads_config.cluster_name()[0], primary_dispatcher,
+    const Protobuf::MethodDescriptor& method =
         *Protobuf::DescriptorPool::generated_pool()->FindMethodByName(
-            "envoy.api.v2.AggregatedDiscoveryService.StreamAggregatedResources")));
+            "envoy.api.v2.AggregatedDiscoveryService.StreamAggregatedResources");
+    if (xds_dispatcher != nullptr) {
+      const envoy::api::v2::Node node = bootstrap.node();
+      const std::string cluster_name = ads_config.cluster_name()[0];
+      Event::Dispatcher& dispatcher = *xds_dispatcher;
+      ads_mux_.reset(new Config::ThreadedGrpcMuxImpl(
+          primary_dispatcher, dispatcher,
+          [this, node, cluster_name, &dispatcher, &method]() -> Config::GrpcMuxPtr {
+            return Config::GrpcMuxPtr{
+                new Config::GrpcMuxImpl(node, *this, cluster_name, dispatcher, method)};
+          }));
+    } else {
+      ads_mux_.reset(new Config::GrpcMuxImpl(bootstrap.node(), *this, ads_config.cluster_name()[0],
+                                             primary_dispatcher, method));
+    }
   }
 
   const auto& cm_config = bootstrap.cluster_manager();
@@ -252,8 +321,9 @@ ClusterManagerImpl::ClusterManagerImpl(const envoy::api::v2::Bootstrap& bootstra
       throw EnvoyException(
           "envoy::api::v2::ApiConfigSource must have a singleton cluster name specified");
     }
-    load_stats_reporter_.reset(new LoadStatsReporter(
-        bootstrap.node(), *this, stats, load_stats_config.cluster_name()[0], primary_dispatcher));
+    load_stats_reporter_.reset(new LoadStatsReporter(bootstrap.node(), *this, runtime, stats,
+                                                     load_stats_config.cluster_name()[0],
+                                                     primary_dispatcher));
   }
 }
 
@@ -274,6 +344,31 @@ void ClusterManagerImpl::postInitializeCluster(Cluster& cluster) {
 }
 
 bool ClusterManagerImpl::addOrUpdatePrimaryCluster(const envoy::api::v2::Cluster& cluster) {
+  const std::string& cluster_name = cluster.name();
+  auto on_demand_cluster = on_demand_clusters_.find(cluster_name);
+  if (primary_clusters_.count(cluster_name) == 0 &&
+      runtime_.snapshot().featureEnabled("upstream.on_demand_cds", 0)) {
+    // Keep only the config of a cluster until it's first used. @see loadOnDemandCluster().
+    const uint64_t config_hash = MessageUtil::hash(cluster);
+    if (on_demand_cluster != on_demand_clusters_.end() &&
+        on_demand_cluster->second.config_hash_ == config_hash) {
+      return false;
+    }
+
+    ENVOY_LOG(debug, "add/update on-demand cluster {}", cluster_name);
+    on_demand_clusters_[cluster_name] = {config_hash, cluster};
+    cm_stats_.on_demand_clusters_.set(on_demand_clusters_.size());
+    return true;
+  }
+
+  if (on_demand_cluster != on_demand_clusters_.end()) {
+    on_demand_clusters_.erase(on_demand_cluster);
+    cm_stats_.on_demand_clusters_.set(on_demand_clusters_.size());
+  }
+  return addOrUpdateLoadedCluster(cluster);
+}
+
+bool ClusterManagerImpl::addOrUpdateLoadedCluster(const envoy::api::v2::Cluster& cluster) {
   // First we need to see if this new config is new or an update to an existing dynamic cluster.
   // We don't allow updates to statically configured clusters in the main configuration.
   const std::string cluster_name = cluster.name();
@@ -291,7 +386,8 @@ bool ClusterManagerImpl::addOrUpdatePrimaryCluster(const envoy::api::v2::Cluster
   loadCluster(cluster, true);
   ClusterInfoConstSharedPtr new_cluster = primary_clusters_.at(cluster_name).cluster_->info();
   ENVOY_LOG(info, "add/update cluster {}", cluster_name);
-  tls_->runOnAllThreads([this, new_cluster]() -> void {
+  const uint32_t handle = primary_clusters_.at(cluster_name).handle_;
+  tls_->runOnAllThreads([this, new_cluster, handle]() -> void {
     ThreadLocalClusterManagerImpl& cluster_manager =
         tls_->getTyped<ThreadLocalClusterManagerImpl>();
 
@@ -301,8 +397,7 @@ bool ClusterManagerImpl::addOrUpdatePrimaryCluster(const envoy::api::v2::Cluster
       ENVOY_LOG(debug, "adding TLS cluster {}", new_cluster->name());
     }
 
-    cluster_manager.thread_local_clusters_[new_cluster->name()].reset(
-        new ThreadLocalClusterManagerImpl::ClusterEntry(cluster_manager, new_cluster));
+    cluster_manager.addCluster(new_cluster->name(), handle, new_cluster);
   });
 
   postInitializeCluster(*primary_clusters_.at(cluster_name).cluster_);
@@ -310,28 +405,89 @@ bool ClusterManagerImpl::addOrUpdatePrimaryCluster(const envoy::api::v2::Cluster
 }
 
 bool ClusterManagerImpl::removePrimaryCluster(const std::string& cluster_name) {
+  if (on_demand_clusters_.erase(cluster_name) > 0) {
+    cm_stats_.on_demand_clusters_.set(on_demand_clusters_.size());
+    ENVOY_LOG(info, "removing on-demand cluster {}", cluster_name);
+    return true;
+  }
+
   auto existing_cluster = primary_clusters_.find(cluster_name);
   if (existing_cluster == primary_clusters_.end() || !existing_cluster->second.added_via_api_) {
     return false;
   }
 
+  // Callers waiting for the cluster to initialize won't find it.
+  if (on_demand_cluster_waiters_.count(cluster_name) > 0) {
+    primary_dispatcher_.post(
+        [this, cluster_name]() -> void { notifyOnDemandClusterWaiters(cluster_name); });
+  }
+
   init_helper_.removeCluster(*existing_cluster->second.cluster_);
+  const uint32_t handle = existing_cluster->second.handle_;
   primary_clusters_.erase(existing_cluster);
   cm_stats_.cluster_removed_.inc();
   cm_stats_.total_clusters_.set(primary_clusters_.size());
   ENVOY_LOG(info, "removing cluster {}", cluster_name);
-  tls_->runOnAllThreads([this, cluster_name]() -> void {
+  tls_->runOnAllThreads([this, cluster_name, handle]() -> void {
     ThreadLocalClusterManagerImpl& cluster_manager =
         tls_->getTyped<ThreadLocalClusterManagerImpl>();
 
     ASSERT(cluster_manager.thread_local_clusters_.count(cluster_name) == 1);
     ENVOY_LOG(debug, "removing TLS cluster {}", cluster_name);
-    cluster_manager.thread_local_clusters_.erase(cluster_name);
+    cluster_manager.removeCluster(cluster_name, handle);
   });
 
   return true;
 }
 
+void ClusterManagerImpl::loadOnDemandCluster(const std::string& cluster,
+                                             Event::Dispatcher& dispatcher,
+                                             std::function<void()> callback) {
+  // The cluster configs live on the main thread.
+  primary_dispatcher_.post([this, cluster, &dispatcher, callback]() -> void {
+    createOnDemandCluster(cluster, dispatcher, callback);
+  });
+}
+
+void ClusterManagerImpl::createOnDemandCluster(const std::string& cluster_name,
+                                               Event::Dispatcher& dispatcher,
+                                               std::function<void()> callback) {
+  auto waiters = on_demand_cluster_waiters_.find(cluster_name);
+  if (waiters != on_demand_cluster_waiters_.end()) {
+    // The cluster is already being created.
+    waiters->second.push_back({dispatcher, callback});
+    return;
+  }
+
+  auto on_demand_cluster = on_demand_clusters_.find(cluster_name);
+  if (on_demand_cluster == on_demand_clusters_.end()) {
+    // The cluster has been created and posted to the workers already, or doesn't exist.
+    dispatcher.post(callback);
+    return;
+  }
+
+  ENVOY_LOG(info, "creating on-demand cluster {}", cluster_name);
+  on_demand_cluster_waiters_[cluster_name].push_back({dispatcher, callback});
+  const envoy::api::v2::Cluster config = std::move(on_demand_cluster->second.config_);
+  on_demand_clusters_.erase(on_demand_cluster);
+  cm_stats_.on_demand_clusters_.set(on_demand_clusters_.size());
+  cm_stats_.on_demand_cluster_created_.inc();
+  addOrUpdateLoadedCluster(config);
+}
+
+void ClusterManagerImpl::notifyOnDemandClusterWaiters(const std::string& cluster_name) {
+  auto waiters = on_demand_cluster_waiters_.find(cluster_name);
+  if (waiters == on_demand_cluster_waiters_.end()) {
+    return;
+  }
+
+  // The cluster was posted to the workers before this, so it's there when the callbacks run.
+  for (const OnDemandClusterWaiter& waiter : waiters->second) {
+    waiter.dispatcher_.post(waiter.callback_);
+  }
+  on_demand_cluster_waiters_.erase(waiters);
+}
+
 void ClusterManagerImpl::loadCluster(const envoy::api::v2::Cluster& cluster, bool added_via_api) {
   ClusterSharedPtr new_cluster =
       factory_.clusterFromProto(cluster, *this, outlier_event_logger_, added_via_api);
@@ -373,10 +529,10 @@ void ClusterManagerImpl::loadCluster(const envoy::api::v2::Cluster& cluster, boo
   }
 
   // emplace() will do nothing if the key already exists. Always erase first.
-  size_t num_erased = primary_clusters_.erase(primary_cluster_reference.info()->name());
-  primary_clusters_.emplace(
-      primary_cluster_reference.info()->name(),
-      PrimaryClusterData{MessageUtil::hash(cluster), added_via_api, std::move(new_cluster)});
+  const std::string& name = primary_cluster_reference.info()->name();
+  size_t num_erased = primary_clusters_.erase(name);
+  primary_clusters_.emplace(name, PrimaryClusterData{MessageUtil::hash(cluster), added_via_api,
+                                                     clusterHandle(name), std::move(new_cluster)});
 
   cm_stats_.total_clusters_.set(primary_clusters_.size());
   if (num_erased) {
@@ -397,6 +553,14 @@ ThreadLocalCluster* ClusterManagerImpl::get(const std::string& cluster) {
   }
 }
 
+uint32_t ClusterManagerImpl::clusterHandle(const std::string& cluster) {
+  return cluster_handles_.emplace(cluster, cluster_handles_.size()).first->second;
+}
+
+ThreadLocalCluster* ClusterManagerImpl::getByHandle(uint32_t handle) {
+  return tls_->getTyped<ThreadLocalClusterManagerImpl>().getByHandle(handle);
+}
+
 Http::ConnectionPool::Instance*
 ClusterManagerImpl::httpConnPoolForCluster(const std::string& cluster, ResourcePriority priority,
                                            LoadBalancerContext* context) {
@@ -411,6 +575,18 @@ ClusterManagerImpl::httpConnPoolForCluster(const std::string& cluster, ResourceP
   return entry->second->connPool(priority, context);
 }
 
+Http::ConnectionPool::Instance*
+ClusterManagerImpl::httpConnPoolForClusterHandle(uint32_t handle, ResourcePriority priority,
+                                                 LoadBalancerContext* context) {
+  ThreadLocalClusterManagerImpl::ClusterEntry* entry =
+      tls_->getTyped<ThreadLocalClusterManagerImpl>().getByHandle(handle);
+  if (entry == nullptr) {
+    return nullptr;
+  }
+
+  return entry->connPool(priority, context);
+}
+
 void ClusterManagerImpl::postThreadLocalClusterUpdate(
     const Cluster& primary_cluster, uint32_t priority,
     const std::vector<HostSharedPtr>& hosts_added,
@@ -430,19 +606,53 @@ void ClusterManagerImpl::postThreadLocalClusterUpdate(
       new std::vector<std::vector<HostSharedPtr>>(host_set->hostsPerLocality()));
   HostListsConstSharedPtr healthy_hosts_per_locality_copy(
       new std::vector<std::vector<HostSharedPtr>>(host_set->healthyHostsPerLocality()));
+  // Locality weights are immutable once set, so the same weights can be shared by every worker.
+  LocalityWeightsConstSharedPtr locality_weights = host_set->localityWeights();
+
+  RingHashLoadBalancer::SharedRingsConstSharedPtr rings =
+      buildSharedRings(primary_cluster, priority);
 
   tls_->runOnAllThreads([
     this, name = primary_cluster.info()->name(), priority, hosts_copy, healthy_hosts_copy,
-    hosts_per_locality_copy, healthy_hosts_per_locality_copy, hosts_added, hosts_removed
+    hosts_per_locality_copy, healthy_hosts_per_locality_copy, locality_weights, hosts_added,
+    hosts_removed, rings
   ]()
                             ->void {
                               ThreadLocalClusterManagerImpl::updateClusterMembership(
                                   name, priority, hosts_copy, healthy_hosts_copy,
                                   hosts_per_locality_copy, healthy_hosts_per_locality_copy,
-                                  hosts_added, hosts_removed, *tls_);
+                                  locality_weights, hosts_added, hosts_removed, rings, *tls_);
                             });
 }
 
+RingHashLoadBalancer::SharedRingsConstSharedPtr
+ClusterManagerImpl::buildSharedRings(const Cluster& primary_cluster, uint32_t priority) {
+  // Ring hash load balancers only use priority 0, and the subset load balancer builds rings per
+  // subset on the workers.
+  const ClusterInfo& info = *primary_cluster.info();
+  if (priority != 0 || info.lbType() != LoadBalancerType::RingHash ||
+      info.lbSubsetInfo().isEnabled() ||
+      !runtime_.snapshot().featureEnabled("upstream.ring_hash.build_on_main_thread", 100)) {
+    return nullptr;
+  }
+
+  // Rings are immutable once built, so build them once here and hand the same rings to every
+  // worker rather than having each worker hash and sort the entire ring itself.
+  auto cluster_data = primary_clusters_.find(info.name());
+  if (cluster_data != primary_clusters_.end() &&
+      cluster_data->second.cluster_.get() != &primary_cluster) {
+    cluster_data = primary_clusters_.end();
+  }
+
+  RingHashLoadBalancer::SharedRingsConstSharedPtr rings = RingHashLoadBalancer::buildRings(
+      *primary_cluster.prioritySet().hostSetsPerPriority()[0], info.lbRingHashConfig(),
+      cluster_data != primary_clusters_.end() ? cluster_data->second.rings_ : nullptr);
+  if (cluster_data != primary_clusters_.end()) {
+    cluster_data->second.rings_ = rings;
+  }
+  return rings;
+}
+
 void ClusterManagerImpl::postThreadLocalHealthFailure(const HostSharedPtr& host) {
   tls_->runOnAllThreads(
       [this, host] { ThreadLocalClusterManagerImpl::onHostHealthFailure(host, *tls_); });
@@ -490,15 +700,12 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ThreadLocalClusterManagerImpl
   // If local cluster is defined then we need to initialize it first.
   if (local_cluster_name.valid()) {
     ENVOY_LOG(debug, "adding TLS local cluster {}", local_cluster_name.value());
-    auto& local_cluster = parent.primary_clusters_.at(local_cluster_name.value()).cluster_;
-    thread_local_clusters_[local_cluster_name.value()].reset(
-        new ClusterEntry(*this, local_cluster->info()));
+    auto& local_cluster = parent.primary_clusters_.at(local_cluster_name.value());
+    ClusterEntry& entry = addCluster(local_cluster_name.value(), local_cluster.handle_,
+                                     local_cluster.cluster_->info());
+    local_priority_set_ = &entry.priority_set_;
   }
 
-  local_priority_set_ = local_cluster_name.valid()
-                            ? &thread_local_clusters_[local_cluster_name.value()]->priority_set_
-                            : nullptr;
-
   for (auto& cluster : parent.primary_clusters_) {
     // If local cluster name is set then we already initialized this cluster.
     if (local_cluster_name.valid() && local_cluster_name.value() == cluster.first) {
@@ -507,8 +714,7 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ThreadLocalClusterManagerImpl
 
     ENVOY_LOG(debug, "adding TLS initial cluster {}", cluster.first);
     ASSERT(thread_local_clusters_.count(cluster.first) == 0);
-    thread_local_clusters_[cluster.first].reset(
-        new ClusterEntry(*this, cluster.second.cluster_->info()));
+    addCluster(cluster.first, cluster.second.handle_, cluster.second.cluster_->info());
   }
 }
 
@@ -520,7 +726,8 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::~ThreadLocalClusterManagerImp
   // TODO(mattklein123): The above is sub-optimal and is related to the TODO in
   //                     redis/conn_pool_impl.cc. Will fix at the same time.
   ENVOY_LOG(debug, "shutting down thread local cluster manager");
-  host_http_conn_pool_map_.clear();
+  host_http_conn_pools_.clear();
+  thread_local_clusters_by_handle_.clear();
   for (auto& cluster : thread_local_clusters_) {
     if (&cluster.second->priority_set_ != local_priority_set_) {
       cluster.second.reset();
@@ -529,12 +736,54 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::~ThreadLocalClusterManagerImp
   thread_local_clusters_.clear();
 }
 
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry&
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::addCluster(const std::string& name,
+                                                              uint32_t handle,
+                                                              ClusterInfoConstSharedPtr cluster) {
+  // The entry being replaced, if any, is destroyed last, as it drains its connection pools.
+  ClusterEntryPtr entry(new ClusterEntry(*this, cluster));
+  if (handle >= thread_local_clusters_by_handle_.size()) {
+    thread_local_clusters_by_handle_.resize(handle + 1);
+  }
+  thread_local_clusters_by_handle_[handle] = entry.get();
+  ClusterEntryPtr& slot = thread_local_clusters_[name];
+  slot.swap(entry);
+  return *slot;
+}
+
+void ClusterManagerImpl::ThreadLocalClusterManagerImpl::removeCluster(const std::string& name,
+                                                                      uint32_t handle) {
+  ASSERT(handle < thread_local_clusters_by_handle_.size());
+  thread_local_clusters_by_handle_[handle] = nullptr;
+  thread_local_clusters_.erase(name);
+}
+
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::ConnPoolsContainer*
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::getHttpConnPoolsContainer(
+    const HostConstSharedPtr& host, bool allocate) {
+  const uint32_t index = host->index();
+  if (index >= host_http_conn_pools_.size()) {
+    if (!allocate) {
+      return nullptr;
+    }
+    host_http_conn_pools_.resize(index + 1);
+  }
+
+  ConnPoolsContainerPtr& container = host_http_conn_pools_[index];
+  if (!container && allocate) {
+    container.reset(new ConnPoolsContainer(host));
+  }
+  // A container keeps its host alive, so no other existing host can have the same index.
+  ASSERT(!container || container->host_ == host);
+  return container.get();
+}
+
 void ClusterManagerImpl::ThreadLocalClusterManagerImpl::drainConnPools(
     const std::vector<HostSharedPtr>& hosts) {
   for (const HostSharedPtr& host : hosts) {
-    auto container = host_http_conn_pool_map_.find(host);
-    if (container != host_http_conn_pool_map_.end()) {
-      drainConnPools(host, container->second);
+    ConnPoolsContainer* container = getHttpConnPoolsContainer(host);
+    if (container != nullptr) {
+      drainConnPools(host, *container);
     }
   }
 }
@@ -553,21 +802,21 @@ void ClusterManagerImpl::ThreadLocalClusterManagerImpl::drainConnPools(
     }
 
     pool->addDrainedCallback([this, old_host]() -> void {
-      ConnPoolsContainer& container = host_http_conn_pool_map_[old_host];
+      ConnPoolsContainer& container = *getHttpConnPoolsContainer(old_host);
       ASSERT(container.drains_remaining_ > 0);
       container.drains_remaining_--;
       if (container.drains_remaining_ == 0) {
         for (Http::ConnectionPool::InstancePtr& pool : container.pools_) {
           thread_local_dispatcher_.deferredDelete(std::move(pool));
         }
-        host_http_conn_pool_map_.erase(old_host);
+        host_http_conn_pools_[old_host->index()].reset();
       }
     });
 
     // The above addDrainedCallback() drain completion callback might execute immediately. This can
     // then effectively nuke 'container', which means we can't continue to loop on its contents
     // (we're done here).
-    if (host_http_conn_pool_map_.count(old_host) == 0) {
+    if (getHttpConnPoolsContainer(old_host) == nullptr) {
       break;
     }
   }
@@ -577,15 +826,22 @@ void ClusterManagerImpl::ThreadLocalClusterManagerImpl::updateClusterMembership(
     const std::string& name, uint32_t priority, HostVectorConstSharedPtr hosts,
     HostVectorConstSharedPtr healthy_hosts, HostListsConstSharedPtr hosts_per_locality,
     HostListsConstSharedPtr healthy_hosts_per_locality,
-    const std::vector<HostSharedPtr>& hosts_added, const std::vector<HostSharedPtr>& hosts_removed,
-    ThreadLocal::Slot& tls) {
+    LocalityWeightsConstSharedPtr locality_weights, const std::vector<HostSharedPtr>& hosts_added,
+    const std::vector<HostSharedPtr>& hosts_removed,
+    RingHashLoadBalancer::SharedRingsConstSharedPtr rings, ThreadLocal::Slot& tls) {
 
   ThreadLocalClusterManagerImpl& config = tls.getTyped<ThreadLocalClusterManagerImpl>();
 
   ASSERT(config.thread_local_clusters_.find(name) != config.thread_local_clusters_.end());
-  config.thread_local_clusters_[name]->priority_set_.getOrCreateHostSet(priority).updateHosts(
+  ClusterEntry& cluster_entry = *config.thread_local_clusters_[name];
+  if (rings != nullptr && cluster_entry.ring_hash_lb_ != nullptr) {
+    // The update below adopts the rings built on the main thread instead of building its own.
+    cluster_entry.ring_hash_lb_->setPendingRings(std::move(rings));
+  }
+  cluster_entry.priority_set_.getOrCreateHostSet(priority).updateHosts(
       std::move(hosts), std::move(healthy_hosts), std::move(hosts_per_locality),
-      std::move(healthy_hosts_per_locality), hosts_added, hosts_removed);
+      std::move(healthy_hosts_per_locality), std::move(locality_weights), hosts_added,
+      hosts_removed);
 }
 
 void ClusterManagerImpl::ThreadLocalClusterManagerImpl::onHostHealthFailure(
@@ -598,9 +854,9 @@ void ClusterManagerImpl::ThreadLocalClusterManagerImpl::onHostHealthFailure(
   // more granular host set changes, we should be able to capture single host changes and make them
   // more targeted.
   ThreadLocalClusterManagerImpl& config = tls.getTyped<ThreadLocalClusterManagerImpl>();
-  const auto& container = config.host_http_conn_pool_map_.find(host);
-  if (container != config.host_http_conn_pool_map_.end()) {
-    for (const Http::ConnectionPool::InstancePtr& pool : container->second.pools_) {
+  const ConnPoolsContainer* container = config.getHttpConnPoolsContainer(host);
+  if (container != nullptr) {
+    for (const Http::ConnectionPool::InstancePtr& pool : container->pools_) {
       if (pool == nullptr) {
         continue;
       }
@@ -632,6 +888,12 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::ClusterEntry(
                                              parent.parent_.random_));
       break;
     }
+    case LoadBalancerType::PeakEwma: {
+      lb_.reset(new PeakEwmaLoadBalancer(priority_set_, parent_.local_priority_set_,
+                                         cluster->stats(), parent.parent_.runtime_,
+                                         parent.parent_.random_));
+      break;
+    }
     case LoadBalancerType::Random: {
       lb_.reset(new RandomLoadBalancer(priority_set_, parent_.local_priority_set_, cluster->stats(),
                                        parent.parent_.runtime_, parent.parent_.random_));
@@ -644,8 +906,15 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::ClusterEntry(
       break;
     }
     case LoadBalancerType::RingHash: {
-      lb_.reset(new RingHashLoadBalancer(priority_set_, cluster->stats(), parent.parent_.runtime_,
-                                         parent.parent_.random_, cluster->lbRingHashConfig()));
+      ring_hash_lb_ =
+          new RingHashLoadBalancer(priority_set_, cluster->stats(), parent.parent_.runtime_,
+                                   parent.parent_.random_, cluster->lbRingHashConfig());
+      lb_.reset(ring_hash_lb_);
+      break;
+    }
+    case LoadBalancerType::Maglev: {
+      lb_.reset(new MaglevLoadBalancer(priority_set_, cluster->stats(), parent.parent_.runtime_,
+                                       parent.parent_.random_));
       break;
     }
     case LoadBalancerType::OriginalDst: {
@@ -687,7 +956,7 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::connPool(
     return nullptr;
   }
 
-  ConnPoolsContainer& container = parent_.host_http_conn_pool_map_[host];
+  ConnPoolsContainer& container = *parent_.getHttpConnPoolsContainer(host, true);
   ASSERT(enumToInt(priority) < container.pools_.size());
   if (!container.pools_[enumToInt(priority)]) {
     container.pools_[enumToInt(priority)] =
@@ -702,7 +971,8 @@ ClusterManagerPtr ProdClusterManagerFactory::clusterManagerFromProto(
     Runtime::Loader& runtime, Runtime::RandomGenerator& random,
     const LocalInfo::LocalInfo& local_info, AccessLog::AccessLogManager& log_manager) {
   return ClusterManagerPtr{new ClusterManagerImpl(bootstrap, *this, stats, tls, runtime, random,
-                                                  local_info, log_manager, primary_dispatcher_)};
+                                                  local_info, log_manager, primary_dispatcher_,
+                                                  xds_dispatcher_)};
 }
 
 Http::ConnectionPool::InstancePtr
@@ -722,16 +992,18 @@ ClusterSharedPtr ProdClusterManagerFactory::clusterFromProto(
     const envoy::api::v2::Cluster& cluster, ClusterManager& cm,
     Outlier::EventLoggerSharedPtr outlier_event_logger, bool added_via_api) {
   return ClusterImplBase::create(cluster, cm, stats_, tls_, dns_resolver_, ssl_context_manager_,
-                                 runtime_, random_, primary_dispatcher_, local_info_,
-                                 outlier_event_logger, added_via_api);
+                                 runtime_, random_, primary_dispatcher_,
+                                 health_check_dispatcher_ != nullptr ? *health_check_dispatcher_
+                                                                     : primary_dispatcher_,
+                                 local_info_, outlier_event_logger, added_via_api);
 }
 
 CdsApiPtr
 ProdClusterManagerFactory::createCds(const envoy::api::v2::ConfigSource& cds_config,
                                      const Optional<envoy::api::v2::ConfigSource>& eds_config,
                                      ClusterManager& cm) {
-  return CdsApiImpl::create(cds_config, eds_config, cm, primary_dispatcher_, random_, local_info_,
-                            stats_);
+  return CdsApiImpl::create(cds_config, eds_config, cm, tls_, primary_dispatcher_, random_,
+                            local_info_, stats_, xds_cache_path_);
 }
 
 } // namespace Upstream
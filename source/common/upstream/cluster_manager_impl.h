@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <chrono>
 #include <cstdint>
 #include <functional>
 #include <list>
@@ -9,6 +10,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "envoy/common/time.h"
 #include "envoy/http/codes.h"
 #include "envoy/local_info/local_info.h"
 #include "envoy/runtime/runtime.h"
@@ -19,6 +21,7 @@
 #include "common/config/grpc_mux_impl.h"
 #include "common/http/async_client_impl.h"
 #include "common/upstream/load_stats_reporter.h"
+#include "common/upstream/ring_hash_lb.h"
 #include "common/upstream/upstream_impl.h"
 
 #include "api/bootstrap.pb.h"
@@ -58,6 +61,29 @@ public:
                       const Optional<envoy::api::v2::ConfigSource>& eds_config,
                       ClusterManager& cm) override;
 
+  /**
+   * Run the health checkers of the clusters created from now on on another thread.
+   * @param dispatcher supplies the dispatcher of the health checking thread, which must outlive
+   *        the clusters.
+   */
+  void setHealthCheckDispatcher(Event::Dispatcher& dispatcher) {
+    health_check_dispatcher_ = &dispatcher;
+  }
+
+  /**
+   * Run the ADS stream of the cluster managers created from now on on another thread.
+   * @param dispatcher supplies the dispatcher of the xDS thread, which must keep running until the
+   *        cluster managers are shut down.
+   */
+  void setXdsDispatcher(Event::Dispatcher& dispatcher) { xds_dispatcher_ = &dispatcher; }
+
+  /**
+   * Keep the last accepted CDS update in a directory, to be applied straight away by the CDS of
+   * the next start.
+   * @param path supplies the directory.
+   */
+  void setXdsCachePath(const std::string& path) { xds_cache_path_ = path; }
+
 protected:
   Event::Dispatcher& primary_dispatcher_;
 
@@ -69,6 +95,9 @@ private:
   Network::DnsResolverSharedPtr dns_resolver_;
   Ssl::ContextManager& ssl_context_manager_;
   const LocalInfo::LocalInfo& local_info_;
+  Event::Dispatcher* health_check_dispatcher_{};
+  Event::Dispatcher* xds_dispatcher_{};
+  std::string xds_cache_path_;
 };
 
 /**
@@ -94,22 +123,51 @@ public:
     AllClustersInitialized
   };
 
+  /**
+   * @param cm supplies the cluster manager, whose ADS mux is paused while secondary clusters are
+   *        started so that their EDS requests are batched.
+   * @param runtime supplies the runtime, which can limit how many secondary clusters initialize
+   *        at once.
+   * @param time_source supplies the time source used to time the phases of initialization.
+   */
+  ClusterManagerInitHelper(ClusterManager& cm, Runtime::Loader& runtime,
+                           MonotonicTimeSource& time_source);
+
   void addCluster(Cluster& cluster);
   void onStaticLoadComplete();
   void removeCluster(Cluster& cluster);
   void setCds(CdsApi* cds);
   void setInitializedCb(std::function<void()> callback);
+  /**
+   * Set a callback invoked when a cluster added after all clusters were initialized finishes
+   * initializing.
+   */
+  void setClusterInitializedCb(std::function<void(Cluster&)> callback) {
+    cluster_initialized_callback_ = callback;
+  }
   State state() const { return state_; }
+  const ClusterManagerInitTimes& initTimes() const { return init_times_; }
 
 private:
+  void initializeSecondaryClusters();
   void maybeFinishInitialize();
+  std::chrono::milliseconds finishPhase();
 
+  ClusterManager& cm_;
+  Runtime::Loader& runtime_;
+  MonotonicTimeSource& time_source_;
   CdsApi* cds_{};
   std::function<void()> initialized_callback_;
+  std::function<void(Cluster&)> cluster_initialized_callback_;
   std::list<Cluster*> primary_init_clusters_;
+  // Secondary clusters which are waiting to be initialized.
   std::list<Cluster*> secondary_init_clusters_;
+  // Secondary clusters which have been initialized, and haven't finished initializing yet.
+  std::list<Cluster*> secondary_initializing_clusters_;
   State state_{State::Loading};
   bool started_secondary_initialize_{};
+  MonotonicTime phase_start_;
+  ClusterManagerInitTimes init_times_;
 };
 
 /**
@@ -120,6 +178,8 @@ private:
   COUNTER(cluster_added)                                                                           \
   COUNTER(cluster_modified)                                                                        \
   COUNTER(cluster_removed)                                                                         \
+  COUNTER(on_demand_cluster_created)                                                               \
+  GAUGE  (on_demand_clusters)                                                                      \
   GAUGE  (total_clusters)
 // clang-format on
 
@@ -140,7 +200,8 @@ public:
                      Stats::Store& stats, ThreadLocal::SlotAllocator& tls, Runtime::Loader& runtime,
                      Runtime::RandomGenerator& random, const LocalInfo::LocalInfo& local_info,
                      AccessLog::AccessLogManager& log_manager,
-                     Event::Dispatcher& primary_dispatcher);
+                     Event::Dispatcher& primary_dispatcher,
+                     Event::Dispatcher* xds_dispatcher = nullptr);
 
   // Upstream::ClusterManager
   bool addOrUpdatePrimaryCluster(const envoy::api::v2::Cluster& cluster) override;
@@ -156,15 +217,22 @@ public:
     return clusters_map;
   }
   ThreadLocalCluster* get(const std::string& cluster) override;
+  uint32_t clusterHandle(const std::string& cluster) override;
+  ThreadLocalCluster* getByHandle(uint32_t handle) override;
   Http::ConnectionPool::Instance* httpConnPoolForCluster(const std::string& cluster,
                                                          ResourcePriority priority,
                                                          LoadBalancerContext* context) override;
+  Http::ConnectionPool::Instance*
+  httpConnPoolForClusterHandle(uint32_t handle, ResourcePriority priority,
+                               LoadBalancerContext* context) override;
   Host::CreateConnectionData tcpConnForCluster(const std::string& cluster,
                                                LoadBalancerContext* context) override;
   Http::AsyncClient& httpAsyncClientForCluster(const std::string& cluster) override;
   bool removePrimaryCluster(const std::string& cluster) override;
   void shutdown() override {
     cds_api_.reset();
+    // An ADS stream on the xDS thread is closed there, before that thread stops.
+    ads_mux_.reset(new Config::NullGrpcMuxImpl());
     primary_clusters_.clear();
   }
 
@@ -176,6 +244,10 @@ public:
 
   const std::string versionInfo() const override;
 
+  const ClusterManagerInitTimes& initTimes() const override { return init_helper_.initTimes(); }
+  void loadOnDemandCluster(const std::string& cluster, Event::Dispatcher& dispatcher,
+                           std::function<void()> callback) override;
+
 private:
   /**
    * Thread local cached cluster data. Each thread local cluster gets updates from the parent
@@ -186,10 +258,16 @@ private:
     struct ConnPoolsContainer {
       typedef std::array<Http::ConnectionPool::InstancePtr, NumResourcePriorities> ConnPools;
 
+      ConnPoolsContainer(HostConstSharedPtr host) : host_(host) {}
+
+      // Keeps the host, and so its index, alive for as long as its pools are.
+      const HostConstSharedPtr host_;
       ConnPools pools_;
       uint64_t drains_remaining_{};
     };
 
+    typedef std::unique_ptr<ConnPoolsContainer> ConnPoolsContainerPtr;
+
     struct ClusterEntry : public ThreadLocalCluster {
       ClusterEntry(ThreadLocalClusterManagerImpl& parent, ClusterInfoConstSharedPtr cluster);
       ~ClusterEntry();
@@ -205,6 +283,8 @@ private:
       ThreadLocalClusterManagerImpl& parent_;
       PrioritySetImpl priority_set_;
       LoadBalancerPtr lb_;
+      // Set if lb_ is a ring hash load balancer that can be handed rings built on the main thread.
+      RingHashLoadBalancer* ring_hash_lb_{};
       ClusterInfoConstSharedPtr cluster_info_;
       Http::AsyncClientImpl http_async_client_;
     };
@@ -214,6 +294,16 @@ private:
     ThreadLocalClusterManagerImpl(ClusterManagerImpl& parent, Event::Dispatcher& dispatcher,
                                   const Optional<std::string>& local_cluster_name);
     ~ThreadLocalClusterManagerImpl();
+    ClusterEntry& addCluster(const std::string& name, uint32_t handle,
+                             ClusterInfoConstSharedPtr cluster);
+    void removeCluster(const std::string& name, uint32_t handle);
+    ClusterEntry* getByHandle(uint32_t handle) {
+      return handle < thread_local_clusters_by_handle_.size()
+                 ? thread_local_clusters_by_handle_[handle]
+                 : nullptr;
+    }
+    ConnPoolsContainer* getHttpConnPoolsContainer(const HostConstSharedPtr& host,
+                                                  bool allocate = false);
     void drainConnPools(const std::vector<HostSharedPtr>& hosts);
     void drainConnPools(HostSharedPtr old_host, ConnPoolsContainer& container);
     static void updateClusterMembership(const std::string& name, uint32_t priority,
@@ -221,41 +311,75 @@ private:
                                         HostVectorConstSharedPtr healthy_hosts,
                                         HostListsConstSharedPtr hosts_per_locality,
                                         HostListsConstSharedPtr healthy_hosts_per_locality,
+                                        LocalityWeightsConstSharedPtr locality_weights,
                                         const std::vector<HostSharedPtr>& hosts_added,
                                         const std::vector<HostSharedPtr>& hosts_removed,
+                                        RingHashLoadBalancer::SharedRingsConstSharedPtr rings,
                                         ThreadLocal::Slot& tls);
     static void onHostHealthFailure(const HostSharedPtr& host, ThreadLocal::Slot& tls);
 
     ClusterManagerImpl& parent_;
     Event::Dispatcher& thread_local_dispatcher_;
     std::unordered_map<std::string, ClusterEntryPtr> thread_local_clusters_;
-    std::unordered_map<HostConstSharedPtr, ConnPoolsContainer> host_http_conn_pool_map_;
+    // The entries of thread_local_clusters_ indexed by cluster handle, null for the handles of
+    // names which have no cluster.
+    std::vector<ClusterEntry*> thread_local_clusters_by_handle_;
+    // The HTTP connection pools of hosts, indexed by host index.
+    std::vector<ConnPoolsContainerPtr> host_http_conn_pools_;
     const PrioritySet* local_priority_set_{};
   };
 
   struct PrimaryClusterData {
-    PrimaryClusterData(uint64_t config_hash, bool added_via_api, ClusterSharedPtr&& cluster)
-        : config_hash_(config_hash), added_via_api_(added_via_api), cluster_(std::move(cluster)) {}
+    PrimaryClusterData(uint64_t config_hash, bool added_via_api, uint32_t handle,
+                       ClusterSharedPtr&& cluster)
+        : config_hash_(config_hash), added_via_api_(added_via_api), handle_(handle),
+          cluster_(std::move(cluster)) {}
 
     const uint64_t config_hash_;
     const bool added_via_api_;
+    const uint32_t handle_;
     ClusterSharedPtr cluster_;
+    // The most recent ring hash rings built for priority 0, to be updated incrementally.
+    RingHashLoadBalancer::SharedRingsConstSharedPtr rings_;
+  };
+
+  // The config of a cluster which hasn't been created yet. @see loadOnDemandCluster().
+  struct OnDemandClusterData {
+    uint64_t config_hash_;
+    envoy::api::v2::Cluster config_;
+  };
+
+  // A caller waiting for an on-demand cluster to be created and initialized.
+  struct OnDemandClusterWaiter {
+    Event::Dispatcher& dispatcher_;
+    std::function<void()> callback_;
   };
 
   static ClusterManagerStats generateStats(Stats::Scope& scope);
+  bool addOrUpdateLoadedCluster(const envoy::api::v2::Cluster& cluster);
+  void createOnDemandCluster(const std::string& cluster_name, Event::Dispatcher& dispatcher,
+                             std::function<void()> callback);
+  void notifyOnDemandClusterWaiters(const std::string& cluster_name);
   void loadCluster(const envoy::api::v2::Cluster& cluster, bool added_via_api);
   void postInitializeCluster(Cluster& cluster);
   void postThreadLocalClusterUpdate(const Cluster& cluster, uint32_t priority,
                                     const std::vector<HostSharedPtr>& hosts_added,
                                     const std::vector<HostSharedPtr>& hosts_removed);
+  RingHashLoadBalancer::SharedRingsConstSharedPtr buildSharedRings(const Cluster& primary_cluster,
+                                                                   uint32_t priority);
   void postThreadLocalHealthFailure(const HostSharedPtr& host);
 
   ClusterManagerFactory& factory_;
+  Event::Dispatcher& primary_dispatcher_;
   Runtime::Loader& runtime_;
   Stats::Store& stats_;
   ThreadLocal::SlotPtr tls_;
   Runtime::RandomGenerator& random_;
   std::unordered_map<std::string, PrimaryClusterData> primary_clusters_;
+  // The handles allocated to cluster names. @see clusterHandle().
+  std::unordered_map<std::string, uint32_t> cluster_handles_;
+  std::unordered_map<std::string, OnDemandClusterData> on_demand_clusters_;
+  std::unordered_map<std::string, std::list<OnDemandClusterWaiter>> on_demand_cluster_waiters_;
   Optional<envoy::api::v2::ConfigSource> eds_config_;
   Network::Address::InstanceConstSharedPtr source_address_;
   Outlier::EventLoggerSharedPtr outlier_event_logger_;
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * Earliest Deadline First (EDF) scheduler
+ * (https://en.wikipedia.org/wiki/Earliest_deadline_first_scheduling) used for weighted round robin.
+ * Each entry has a deadline, initially 1 / weight. A pick returns the entry with the earliest
+ * deadline and moves its deadline 1 / weight further into the future, so over time each entry is
+ * picked in proportion to its weight, and picks of heavy entries are interleaved with picks of
+ * light entries rather than bunched together. Entries with equal deadlines are picked in insertion
+ * order, so equal weights degenerate to plain round robin.
+ *
+ * A pick is O(log n) in the number of entries and does not allocate.
+ */
+template <class C> class EdfScheduler {
+public:
+  /**
+   * Add an entry to the scheduler.
+   * @param weight supplies the weight of the entry, which must be positive.
+   * @param entry supplies the entry.
+   */
+  void add(double weight, C entry) {
+    ASSERT(weight > 0);
+    queue_.push({current_time_ + 1.0 / weight, order_offset_++, weight, entry});
+  }
+
+  /**
+   * Pick the entry with the earliest deadline, and reschedule it.
+   * @return C the picked entry. The scheduler must not be empty.
+   */
+  C pick() {
+    ASSERT(!queue_.empty());
+    EdfEntry edf_entry = queue_.top();
+    queue_.pop();
+    current_time_ = edf_entry.deadline_;
+    edf_entry.deadline_ += 1.0 / edf_entry.weight_;
+    edf_entry.order_offset_ = order_offset_++;
+    queue_.push(edf_entry);
+    return edf_entry.entry_;
+  }
+
+  /**
+   * @return size_t the number of entries in the scheduler.
+   */
+  size_t size() const { return queue_.size(); }
+
+  /**
+   * @return bool whether the scheduler has no entries.
+   */
+  bool empty() const { return queue_.empty(); }
+
+private:
+  struct EdfEntry {
+    double deadline_;
+    // Tie breaker for entries with the same deadline, in order of scheduling.
+    uint64_t order_offset_;
+    double weight_;
+    C entry_;
+
+    // std::priority_queue is a max heap, so the earliest deadline must compare greatest.
+    bool operator<(const EdfEntry& other) const {
+      if (deadline_ != other.deadline_) {
+        return deadline_ > other.deadline_;
+      }
+      return order_offset_ > other.order_offset_;
+    }
+  };
+
+  double current_time_{};
+  uint64_t order_offset_{};
+  std::priority_queue<EdfEntry> queue_;
+};
+
+} // namespace Upstream
+} // namespace Envoy
@@ -46,6 +46,7 @@ void EdsClusterImpl::startPreInit() { subscription_->start({cluster_name_}, *thi
 void EdsClusterImpl::onConfigUpdate(const ResourceVector& resources) {
   typedef std::unique_ptr<std::vector<HostSharedPtr>> HostListPtr;
   std::vector<HostListPtr> new_hosts(1);
+  std::vector<LocalityWeightsMap> new_locality_weights(1);
   if (resources.empty()) {
     ENVOY_LOG(debug, "Missing ClusterLoadAssignment for {} in onConfigUpdate()", cluster_name_);
     info_->stats().update_empty_.inc();
@@ -66,6 +67,7 @@ void EdsClusterImpl::onConfigUpdate(const ResourceVector& resources) {
     const uint32_t priority = locality_lb_endpoint.priority();
     if (new_hosts.size() <= priority) {
       new_hosts.resize(priority + 1);
+      new_locality_weights.resize(priority + 1);
     }
     if (new_hosts[priority] == nullptr) {
       new_hosts[priority] = HostListPtr{new std::vector<HostSharedPtr>};
@@ -76,11 +78,16 @@ void EdsClusterImpl::onConfigUpdate(const ResourceVector& resources) {
           lb_endpoint.metadata(), lb_endpoint.load_balancing_weight().value(),
           locality_lb_endpoint.locality()));
     }
+    if (locality_lb_endpoint.has_load_balancing_weight()) {
+      new_locality_weights[priority][Locality(locality_lb_endpoint.locality())] =
+          locality_lb_endpoint.load_balancing_weight().value();
+    }
   }
 
   for (size_t i = 0; i < new_hosts.size(); ++i) {
     if (new_hosts[i] != nullptr) {
-      updateHostsPerLocality(priority_set_.getOrCreateHostSet(i), *new_hosts[i]);
+      updateHostsPerLocality(priority_set_.getOrCreateHostSet(i), *new_hosts[i],
+                             new_locality_weights[i]);
     }
   }
 
@@ -90,42 +97,67 @@ void EdsClusterImpl::onConfigUpdate(const ResourceVector& resources) {
 }
 
 void EdsClusterImpl::updateHostsPerLocality(HostSet& host_set,
-                                            std::vector<HostSharedPtr>& new_hosts) {
+                                            std::vector<HostSharedPtr>& new_hosts,
+                                            const LocalityWeightsMap& locality_weights_map) {
   HostVectorSharedPtr current_hosts_copy(new std::vector<HostSharedPtr>(host_set.hosts()));
 
   std::vector<HostSharedPtr> hosts_added;
   std::vector<HostSharedPtr> hosts_removed;
-  if (updateDynamicHostList(new_hosts, *current_hosts_copy, hosts_added, hosts_removed,
-                            health_checker_ != nullptr)) {
-    ENVOY_LOG(debug, "EDS hosts changed for cluster: {} ({}) priority {}", info_->name(),
-              host_set.hosts().size(), host_set.priority());
-    HostListsSharedPtr per_locality(new std::vector<std::vector<HostSharedPtr>>());
-
-    // If local locality is not defined then skip populating per locality hosts.
-    const Locality local_locality(local_info_.node().locality());
-    ENVOY_LOG(trace, "Local locality: {}", local_info_.node().locality().DebugString());
-    if (!local_locality.empty()) {
-      std::map<Locality, std::vector<HostSharedPtr>> hosts_per_locality;
+  const bool hosts_changed = updateDynamicHostList(new_hosts, *current_hosts_copy, hosts_added,
+                                                   hosts_removed, health_checker_ != nullptr);
+  HostListsSharedPtr per_locality(new std::vector<std::vector<HostSharedPtr>>());
+  LocalityWeightsSharedPtr locality_weights;
+
+  // If local locality is not defined and the localities are not weighted then skip populating per
+  // locality hosts.
+  const Locality local_locality(local_info_.node().locality());
+  ENVOY_LOG(trace, "Local locality: {}", local_info_.node().locality().DebugString());
+  if (!local_locality.empty() || !locality_weights_map.empty()) {
+    std::map<Locality, std::vector<HostSharedPtr>> hosts_per_locality;
+
+    for (const HostSharedPtr& host : *current_hosts_copy) {
+      hosts_per_locality[Locality(host->locality())].push_back(host);
+    }
 
-      for (const HostSharedPtr& host : *current_hosts_copy) {
-        hosts_per_locality[Locality(host->locality())].push_back(host);
+    // Populate per_locality hosts only if upstream cluster has hosts in the same locality, unless
+    // the localities are weighted. Weighted localities are load balanced by their weights rather
+    // than by which of them is local, so they don't need a local locality at index 0.
+    const bool has_local_locality = !local_locality.empty() &&
+                                    hosts_per_locality.find(local_locality) !=
+                                        hosts_per_locality.end();
+    if (has_local_locality || !locality_weights_map.empty()) {
+      if (!locality_weights_map.empty()) {
+        locality_weights.reset(new std::vector<uint32_t>());
       }
+      auto add_locality = [&](const Locality& locality) -> void {
+        per_locality->push_back(hosts_per_locality[locality]);
+        if (locality_weights != nullptr) {
+          // Localities without a weight get no traffic when the others have one.
+          auto weight = locality_weights_map.find(locality);
+          locality_weights->push_back(weight != locality_weights_map.end() ? weight->second : 0);
+        }
+      };
 
-      // Populate per_locality hosts only if upstream cluster has hosts in the same locality.
-      if (hosts_per_locality.find(local_locality) != hosts_per_locality.end()) {
-        per_locality->push_back(hosts_per_locality[local_locality]);
-
-        for (auto& entry : hosts_per_locality) {
-          if (local_locality != entry.first) {
-            per_locality->push_back(entry.second);
-          }
+      if (has_local_locality) {
+        add_locality(local_locality);
+      }
+      for (auto& entry : hosts_per_locality) {
+        if (!has_local_locality || local_locality != entry.first) {
+          add_locality(entry.first);
         }
       }
     }
+  }
 
+  const bool locality_weights_changed =
+      (host_set.localityWeights() == nullptr) != (locality_weights == nullptr) ||
+      (locality_weights != nullptr && *host_set.localityWeights() != *locality_weights);
+  if (hosts_changed || locality_weights_changed) {
+    ENVOY_LOG(debug, "EDS hosts changed for cluster: {} ({}) priority {}", info_->name(),
+              host_set.hosts().size(), host_set.priority());
     host_set.updateHosts(current_hosts_copy, createHealthyHostList(*current_hosts_copy),
-                         per_locality, createHealthyHostLists(*per_locality), hosts_added,
-                         hosts_removed);
+                         per_locality, createHealthyHostLists(*per_locality), locality_weights,
+                         hosts_added, hosts_removed);
   }
 }
 
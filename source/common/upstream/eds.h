@@ -1,5 +1,7 @@
 #pragma once
 
+#include <map>
+
 #include "envoy/config/subscription.h"
 #include "envoy/local_info/local_info.h"
 
@@ -33,7 +35,10 @@ public:
   void onConfigUpdateFailed(const EnvoyException* e) override;
 
 private:
-  void updateHostsPerLocality(HostSet& host_set, std::vector<HostSharedPtr>& new_hosts);
+  typedef std::map<Locality, uint32_t> LocalityWeightsMap;
+
+  void updateHostsPerLocality(HostSet& host_set, std::vector<HostSharedPtr>& new_hosts,
+                              const LocalityWeightsMap& locality_weights_map);
 
   // ClusterImplBase
   void startPreInit() override;
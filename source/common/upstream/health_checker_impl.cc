@@ -12,10 +12,12 @@
 #include "envoy/stats/stats.h"
 
 #include "common/buffer/buffer_impl.h"
+#include "common/buffer/zero_copy_input_stream_impl.h"
 #include "common/common/empty_string.h"
 #include "common/common/enum_to_int.h"
 #include "common/common/hex.h"
 #include "common/common/utility.h"
+#include "common/grpc/common.h"
 #include "common/http/codec_client.h"
 #include "common/http/header_map_impl.h"
 #include "common/http/headers.h"
@@ -24,6 +26,8 @@
 #include "common/redis/conn_pool_impl.h"
 #include "common/upstream/host_utility.h"
 
+#include "source/common/grpc/health.pb.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -31,20 +35,45 @@ HealthCheckerSharedPtr HealthCheckerFactory::create(const envoy::api::v2::Health
                                                     Upstream::Cluster& cluster,
                                                     Runtime::Loader& runtime,
                                                     Runtime::RandomGenerator& random,
-                                                    Event::Dispatcher& dispatcher) {
+                                                    Event::Dispatcher& dispatcher,
+                                                    Event::Dispatcher& health_check_dispatcher) {
+  std::unique_ptr<HealthCheckerImplBase> health_checker;
   switch (hc_config.health_checker_case()) {
   case envoy::api::v2::HealthCheck::HealthCheckerCase::kHttpHealthCheck:
-    return std::make_shared<ProdHttpHealthCheckerImpl>(cluster, hc_config, dispatcher, runtime,
-                                                       random);
+    if (hc_config.http_health_check().path() == GrpcHealthCheckerImpl::HEALTH_CHECK_PATH) {
+      health_checker.reset(new ProdGrpcHealthCheckerImpl(cluster, hc_config,
+                                                         health_check_dispatcher, runtime, random));
+    } else {
+      health_checker.reset(new ProdHttpHealthCheckerImpl(cluster, hc_config,
+                                                         health_check_dispatcher, runtime, random));
+    }
+    break;
   case envoy::api::v2::HealthCheck::HealthCheckerCase::kTcpHealthCheck:
-    return std::make_shared<TcpHealthCheckerImpl>(cluster, hc_config, dispatcher, runtime, random);
+    health_checker.reset(
+        new TcpHealthCheckerImpl(cluster, hc_config, health_check_dispatcher, runtime, random));
+    break;
   case envoy::api::v2::HealthCheck::HealthCheckerCase::kRedisHealthCheck:
-    return std::make_shared<RedisHealthCheckerImpl>(cluster, hc_config, dispatcher, runtime, random,
-                                                    Redis::ConnPool::ClientFactoryImpl::instance_);
+    health_checker.reset(new RedisHealthCheckerImpl(cluster, hc_config, health_check_dispatcher,
+                                                    runtime, random,
+                                                    Redis::ConnPool::ClientFactoryImpl::instance_));
+    break;
   default:
     // TODO(htuch): This should be subsumed eventually by the constraint checking in #1308.
     throw EnvoyException("Health checker type not set");
   }
+
+  if (&health_check_dispatcher == &dispatcher) {
+    return std::shared_ptr<HealthCheckerImplBase>(std::move(health_checker));
+  }
+
+  // The sessions' timers and connections belong to the health checking thread, so the health
+  // checker is deleted there once the cluster releases it.
+  std::shared_ptr<HealthCheckerImplBase> shared_health_checker(
+      health_checker.release(), [&health_check_dispatcher](HealthCheckerImplBase* to_delete) {
+        health_check_dispatcher.post([to_delete]() -> void { delete to_delete; });
+      });
+  shared_health_checker->setMainThreadDispatcher(dispatcher);
+  return shared_health_checker;
 }
 
 const std::chrono::milliseconds HealthCheckerImplBase::NO_TRAFFIC_INTERVAL{60000};
@@ -54,14 +83,15 @@ HealthCheckerImplBase::HealthCheckerImplBase(const Cluster& cluster,
                                              Event::Dispatcher& dispatcher,
                                              Runtime::Loader& runtime,
                                              Runtime::RandomGenerator& random)
-    : cluster_(cluster), dispatcher_(dispatcher),
+    : cluster_(cluster), cluster_info_(cluster.info()), dispatcher_(dispatcher),
       timeout_(PROTOBUF_GET_MS_REQUIRED(config, timeout)),
       unhealthy_threshold_(PROTOBUF_GET_WRAPPED_REQUIRED(config, unhealthy_threshold)),
       healthy_threshold_(PROTOBUF_GET_WRAPPED_REQUIRED(config, healthy_threshold)),
       stats_(generateStats(cluster.info()->statsScope())), runtime_(runtime), random_(random),
       reuse_connection_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, reuse_connection, true)),
       interval_(PROTOBUF_GET_MS_REQUIRED(config, interval)),
-      interval_jitter_(PROTOBUF_GET_MS_OR_DEFAULT(config, interval_jitter, 0)) {
+      interval_jitter_(PROTOBUF_GET_MS_OR_DEFAULT(config, interval_jitter, 0)),
+      initial_jitter_(runtime.snapshot().getInteger("health_check.initial_jitter_ms", 0)) {
   cluster_.prioritySet().addMemberUpdateCb(
       [this](uint32_t, const std::vector<HostSharedPtr>& hosts_added,
              const std::vector<HostSharedPtr>& hosts_removed) -> void {
@@ -92,7 +122,7 @@ std::chrono::milliseconds HealthCheckerImplBase::interval() const {
   // start sending traffic to this cluster. In general host updates are rare and this should
   // greatly smooth out needless health checking.
   uint64_t base_time_ms;
-  if (cluster_.info()->stats().upstream_cx_total_.used()) {
+  if (cluster_info_->stats().upstream_cx_total_.used()) {
     base_time_ms = interval_.count();
   } else {
     base_time_ms = NO_TRAFFIC_INTERVAL.count();
@@ -122,6 +152,24 @@ void HealthCheckerImplBase::addHosts(const std::vector<HostSharedPtr>& hosts) {
 
 void HealthCheckerImplBase::onClusterMemberUpdate(const std::vector<HostSharedPtr>& hosts_added,
                                                   const std::vector<HostSharedPtr>& hosts_removed) {
+  if (main_thread_dispatcher_ == nullptr) {
+    updateHosts(hosts_added, hosts_removed);
+    return;
+  }
+
+  // Updates are posted in order, so the health checking thread sees the same sequence of hosts
+  // as the cluster.
+  std::weak_ptr<HealthCheckerImplBase> weak_this = weak_this_;
+  dispatcher_.post([weak_this, hosts_added, hosts_removed]() -> void {
+    std::shared_ptr<HealthCheckerImplBase> shared_this = weak_this.lock();
+    if (shared_this != nullptr) {
+      shared_this->updateHosts(hosts_added, hosts_removed);
+    }
+  });
+}
+
+void HealthCheckerImplBase::updateHosts(const std::vector<HostSharedPtr>& hosts_added,
+                                        const std::vector<HostSharedPtr>& hosts_removed) {
   addHosts(hosts_added);
   for (const HostSharedPtr& host : hosts_removed) {
     auto session_iter = active_sessions_.find(host);
@@ -143,11 +191,32 @@ void HealthCheckerImplBase::runCallbacks(HostSharedPtr host, bool changed_state)
   // any HC happens against a host so just refresh the healthy stat here so that it is correct.
   refreshHealthyStat();
 
+  if (main_thread_dispatcher_ == nullptr) {
+    runCallbacksOnMainThread(host, changed_state);
+    return;
+  }
+
+  std::weak_ptr<HealthCheckerImplBase> weak_this = weak_this_;
+  main_thread_dispatcher_->post([weak_this, host, changed_state]() -> void {
+    std::shared_ptr<HealthCheckerImplBase> shared_this = weak_this.lock();
+    if (shared_this != nullptr) {
+      shared_this->runCallbacksOnMainThread(host, changed_state);
+    }
+  });
+}
+
+void HealthCheckerImplBase::runCallbacksOnMainThread(HostSharedPtr host, bool changed_state) {
   for (const HostStatusCb& cb : callbacks_) {
     cb(host, changed_state);
   }
 }
 
+void HealthCheckerImplBase::setMainThreadDispatcher(Event::Dispatcher& main_thread_dispatcher) {
+  ASSERT(&main_thread_dispatcher != &dispatcher_);
+  main_thread_dispatcher_ = &main_thread_dispatcher;
+  weak_this_ = shared_from_this();
+}
+
 void HealthCheckerImplBase::HealthCheckHostMonitorImpl::setUnhealthy() {
   // This is called cross thread. The cluster/health checker might already be gone.
   std::shared_ptr<HealthCheckerImplBase> health_checker = health_checker_.lock();
@@ -181,9 +250,11 @@ void HealthCheckerImplBase::setUnhealthyCrossThread(const HostSharedPtr& host) {
 }
 
 void HealthCheckerImplBase::start() {
+  std::vector<HostSharedPtr> hosts;
   for (auto& host_set : cluster_.prioritySet().hostSetsPerPriority()) {
-    addHosts(host_set->hosts());
+    hosts.insert(hosts.end(), host_set->hosts().begin(), host_set->hosts().end());
   }
+  onClusterMemberUpdate(hosts, {});
 }
 
 HealthCheckerImplBase::ActiveHealthCheckSession::ActiveHealthCheckSession(
@@ -203,6 +274,18 @@ HealthCheckerImplBase::ActiveHealthCheckSession::~ActiveHealthCheckSession() {
   }
 }
 
+void HealthCheckerImplBase::ActiveHealthCheckSession::start() {
+  if (parent_.initial_jitter_.count() > 0) {
+    // Spread the first checks of hosts which are added together, such as all of the hosts of a
+    // large cluster at startup, rather than sending them all at once. Each host's later checks
+    // are timed from its own previous check, so they stay spread.
+    interval_timer_->enableTimer(
+        std::chrono::milliseconds(parent_.random_.random() % parent_.initial_jitter_.count()));
+  } else {
+    onIntervalBase();
+  }
+}
+
 void HealthCheckerImplBase::ActiveHealthCheckSession::handleSuccess() {
   // If we are healthy, reset the # of unhealthy to zero.
   num_unhealthy_ = 0;
@@ -214,6 +297,7 @@ void HealthCheckerImplBase::ActiveHealthCheckSession::handleSuccess() {
     // depending on the HC settings.
     if (first_check_ || ++num_healthy_ == parent_.healthy_threshold_) {
       host_->healthFlagClear(Host::HealthFlag::FAILED_ACTIVE_HC);
+      host_->slowStartTime(ProdMonotonicTimeSource::instance_.currentTime());
       parent_.incHealthy();
       changed_state = true;
     }
@@ -274,6 +358,10 @@ HttpHealthCheckerImpl::HttpHealthCheckerImpl(const Cluster& cluster,
                                              Runtime::Loader& runtime,
                                              Runtime::RandomGenerator& random)
     : HealthCheckerImplBase(cluster, config, dispatcher, runtime, random),
+      codec_client_type_((cluster.info()->features() & ClusterInfo::Features::HTTP2) &&
+                                 runtime.snapshot().featureEnabled("health_check.http2", 0)
+                             ? Http::CodecClient::Type::HTTP2
+                             : Http::CodecClient::Type::HTTP1),
       path_(config.http_health_check().path()) {
   if (!config.http_health_check().service_name().empty()) {
     service_name_.value(config.http_health_check().service_name());
@@ -324,9 +412,14 @@ void HttpHealthCheckerImpl::HttpActiveHealthCheckSession::onInterval() {
 
   Http::HeaderMapImpl request_headers{
       {Http::Headers::get().Method, "GET"},
-      {Http::Headers::get().Host, parent_.cluster_.info()->name()},
+      {Http::Headers::get().Host, parent_.cluster_info_->name()},
       {Http::Headers::get().Path, parent_.path_},
       {Http::Headers::get().UserAgent, Http::Headers::get().UserAgentValues.EnvoyHealthChecker}};
+  if (parent_.codec_client_type_ == Http::CodecClient::Type::HTTP2) {
+    request_headers.insertScheme().value().setReference(
+        parent_.cluster_info_->sslContext() ? Http::Headers::get().SchemeValues.Https
+                                            : Http::Headers::get().SchemeValues.Http);
+  }
 
   request_encoder_->encodeHeaders(request_headers, true);
   request_encoder_ = nullptr;
@@ -394,7 +487,182 @@ void HttpHealthCheckerImpl::HttpActiveHealthCheckSession::onTimeout() {
 
 Http::CodecClient*
 ProdHttpHealthCheckerImpl::createCodecClient(Upstream::Host::CreateConnectionData& data) {
-  return new Http::CodecClientProd(Http::CodecClient::Type::HTTP1, std::move(data.connection_),
+  return new Http::CodecClientProd(codec_client_type_, std::move(data.connection_),
+                                   data.host_description_);
+}
+
+namespace {
+
+const std::string GRPC_HEALTH_SERVICE = "grpc.health.v1.Health";
+const std::string GRPC_HEALTH_CHECK_METHOD = "Check";
+
+} // namespace
+
+const std::string GrpcHealthCheckerImpl::HEALTH_CHECK_PATH =
+    "/" + GRPC_HEALTH_SERVICE + "/" + GRPC_HEALTH_CHECK_METHOD;
+
+GrpcHealthCheckerImpl::GrpcHealthCheckerImpl(const Cluster& cluster,
+                                             const envoy::api::v2::HealthCheck& config,
+                                             Event::Dispatcher& dispatcher,
+                                             Runtime::Loader& runtime,
+                                             Runtime::RandomGenerator& random)
+    : HealthCheckerImplBase(cluster, config, dispatcher, runtime, random),
+      service_name_(config.http_health_check().service_name()) {
+  if (!(cluster.info()->features() & ClusterInfo::Features::HTTP2)) {
+    throw EnvoyException(fmt::format("gRPC health checks of cluster '{}' require it to use HTTP/2",
+                                     cluster.info()->name()));
+  }
+}
+
+GrpcHealthCheckerImpl::GrpcActiveHealthCheckSession::GrpcActiveHealthCheckSession(
+    GrpcHealthCheckerImpl& parent, HostSharedPtr host)
+    : ActiveHealthCheckSession(parent, host), parent_(parent) {}
+
+GrpcHealthCheckerImpl::GrpcActiveHealthCheckSession::~GrpcActiveHealthCheckSession() {
+  if (client_) {
+    // If there is an active request it will get reset, so make sure we ignore the reset.
+    expect_reset_ = true;
+    client_->close();
+  }
+}
+
+void GrpcHealthCheckerImpl::GrpcActiveHealthCheckSession::decodeHeaders(
+    Http::HeaderMapPtr&& headers, bool end_stream) {
+  ASSERT(!response_headers_);
+  response_headers_ = std::move(headers);
+  if (end_stream) {
+    // A trailers only response, which carries the gRPC status in its headers.
+    onRpcComplete(Grpc::Common::getGrpcStatus(*response_headers_));
+  }
+}
+
+void GrpcHealthCheckerImpl::GrpcActiveHealthCheckSession::decodeData(Buffer::Instance& data,
+                                                                     bool end_stream) {
+  if (!decoder_->decode(data, decoded_frames_)) {
+    decode_error_ = true;
+    data.drain(data.length());
+  }
+
+  if (end_stream) {
+    // gRPC responses end with trailers, so the response has no status.
+    onRpcComplete(Optional<Grpc::Status::GrpcStatus>());
+  }
+}
+
+void GrpcHealthCheckerImpl::GrpcActiveHealthCheckSession::decodeTrailers(
+    Http::HeaderMapPtr&& trailers) {
+  onRpcComplete(Grpc::Common::getGrpcStatus(*trailers));
+}
+
+void GrpcHealthCheckerImpl::GrpcActiveHealthCheckSession::onEvent(Network::ConnectionEvent event) {
+  if (event == Network::ConnectionEvent::RemoteClose ||
+      event == Network::ConnectionEvent::LocalClose) {
+    // As with HTTP health checks, a timer is already set up for the next check, so only the
+    // client needs to go.
+    parent_.dispatcher_.deferredDelete(std::move(client_));
+  }
+}
+
+void GrpcHealthCheckerImpl::GrpcActiveHealthCheckSession::onInterval() {
+  if (!client_) {
+    Upstream::Host::CreateConnectionData conn = host_->createConnection(parent_.dispatcher_);
+    client_.reset(parent_.createCodecClient(conn));
+    client_->addConnectionCallbacks(connection_callback_impl_);
+    expect_reset_ = false;
+  }
+
+  response_headers_.reset();
+  decoder_.reset(new Grpc::Decoder());
+  decoded_frames_.clear();
+  decode_error_ = false;
+
+  request_encoder_ = &client_->newStream(*this);
+  request_encoder_->getStream().addCallbacks(*this);
+
+  Http::MessagePtr message = Grpc::Common::prepareHeaders(
+      parent_.cluster_info_->name(), GRPC_HEALTH_SERVICE, GRPC_HEALTH_CHECK_METHOD);
+  message->headers().insertScheme().value().setReference(
+      parent_.cluster_info_->sslContext() ? Http::Headers::get().SchemeValues.Https
+                                          : Http::Headers::get().SchemeValues.Http);
+  message->headers().insertUserAgent().value().setReference(
+      Http::Headers::get().UserAgentValues.EnvoyHealthChecker);
+  request_encoder_->encodeHeaders(message->headers(), false);
+
+  grpc::health::v1::HealthCheckRequest request;
+  request.set_service(parent_.service_name_);
+  request_encoder_->encodeData(*Grpc::Common::serializeBody(request), true);
+  request_encoder_ = nullptr;
+}
+
+void GrpcHealthCheckerImpl::GrpcActiveHealthCheckSession::onResetStream(Http::StreamResetReason) {
+  if (expect_reset_) {
+    return;
+  }
+
+  ENVOY_CONN_LOG(debug, "connection/stream error health_flags={}", *client_,
+                 HostUtility::healthFlagsToString(*host_));
+  handleFailure(FailureType::Network);
+}
+
+bool GrpcHealthCheckerImpl::GrpcActiveHealthCheckSession::isHealthCheckSucceeded(
+    const Optional<Grpc::Status::GrpcStatus>& grpc_status) {
+  if (Http::Utility::getResponseStatus(*response_headers_) != enumToInt(Http::Code::OK) ||
+      !Grpc::Common::hasGrpcContentType(*response_headers_)) {
+    return false;
+  }
+
+  if (!grpc_status.valid() || grpc_status.value() != Grpc::Status::GrpcStatus::Ok) {
+    return false;
+  }
+
+  if (decode_error_ || decoded_frames_.size() != 1 ||
+      decoded_frames_[0].flags_ != GRPC_FH_DEFAULT) {
+    return false;
+  }
+
+  grpc::health::v1::HealthCheckResponse response;
+  if (decoded_frames_[0].length_ > 0) {
+    Buffer::ZeroCopyInputStreamImpl stream(std::move(decoded_frames_[0].data_));
+    if (!response.ParseFromZeroCopyStream(&stream)) {
+      return false;
+    }
+  }
+
+  return response.status() == grpc::health::v1::HealthCheckResponse::SERVING;
+}
+
+void GrpcHealthCheckerImpl::GrpcActiveHealthCheckSession::onRpcComplete(
+    const Optional<Grpc::Status::GrpcStatus>& grpc_status) {
+  ENVOY_CONN_LOG(debug, "hc grpc_status={} health_flags={}", *client_,
+                 grpc_status.valid() ? static_cast<int>(grpc_status.value()) : -1,
+                 HostUtility::healthFlagsToString(*host_));
+
+  if (isHealthCheckSucceeded(grpc_status)) {
+    handleSuccess();
+  } else {
+    handleFailure(FailureType::Active);
+  }
+
+  if (!parent_.reuse_connection_) {
+    client_->close();
+  }
+
+  response_headers_.reset();
+  decoded_frames_.clear();
+}
+
+void GrpcHealthCheckerImpl::GrpcActiveHealthCheckSession::onTimeout() {
+  ENVOY_CONN_LOG(debug, "connection/stream timeout health_flags={}", *client_,
+                 HostUtility::healthFlagsToString(*host_));
+
+  // If there is an active request it will get reset, so make sure we ignore the reset.
+  expect_reset_ = true;
+  client_->close();
+}
+
+Http::CodecClient*
+ProdGrpcHealthCheckerImpl::createCodecClient(Upstream::Host::CreateConnectionData& data) {
+  return new Http::CodecClientProd(Http::CodecClient::Type::HTTP2, std::move(data.connection_),
                                    data.host_description_);
 }
 
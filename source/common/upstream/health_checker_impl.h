@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "envoy/event/timer.h"
+#include "envoy/grpc/status.h"
 #include "envoy/http/codec.h"
 #include "envoy/network/connection.h"
 #include "envoy/network/filter.h"
@@ -17,6 +18,7 @@
 #include "envoy/upstream/health_checker.h"
 
 #include "common/common/logger.h"
+#include "common/grpc/codec.h"
 #include "common/http/codec_client.h"
 #include "common/network/filter_impl.h"
 #include "common/protobuf/protobuf.h"
@@ -38,12 +40,16 @@ public:
    * @param runtime supplies the runtime loader.
    * @param random supplies the random generator.
    * @param dispatcher supplies the dispatcher.
+   * @param health_check_dispatcher supplies the dispatcher which runs the health checks. If this is
+   *        not the main thread dispatcher, the health checker runs on the thread of that
+   *        dispatcher and is destroyed there.
    * @return a health checker.
    */
   static HealthCheckerSharedPtr create(const envoy::api::v2::HealthCheck& hc_config,
                                        Upstream::Cluster& cluster, Runtime::Loader& runtime,
                                        Runtime::RandomGenerator& random,
-                                       Event::Dispatcher& dispatcher);
+                                       Event::Dispatcher& dispatcher,
+                                       Event::Dispatcher& health_check_dispatcher);
 };
 
 /**
@@ -78,6 +84,15 @@ public:
   void addHostCheckCompleteCb(HostStatusCb callback) override { callbacks_.push_back(callback); }
   void start() override;
 
+  /**
+   * Run the health checks on the thread of the dispatcher the health checker was created with,
+   * rather than on the main thread. Host updates and start() are posted from the main thread to
+   * that thread, and host check completion callbacks are posted back to the main thread. The
+   * health checker must be owned by a shared pointer when this is called.
+   * @param main_thread_dispatcher supplies the main thread dispatcher.
+   */
+  void setMainThreadDispatcher(Event::Dispatcher& main_thread_dispatcher);
+
 protected:
   class ActiveHealthCheckSession {
   public:
@@ -85,7 +100,7 @@ protected:
 
     virtual ~ActiveHealthCheckSession();
     void setUnhealthy(FailureType type);
-    void start() { onIntervalBase(); }
+    void start();
 
   protected:
     ActiveHealthCheckSession(HealthCheckerImplBase& parent, HostSharedPtr host);
@@ -118,6 +133,9 @@ protected:
   virtual ActiveHealthCheckSessionPtr makeSession(HostSharedPtr host) PURE;
 
   const Cluster& cluster_;
+  // Used instead of cluster_ by the health checks, which may outlive the cluster when they run on
+  // another thread.
+  const ClusterInfoConstSharedPtr cluster_info_;
   Event::Dispatcher& dispatcher_;
   const std::chrono::milliseconds timeout_;
   const uint32_t unhealthy_threshold_;
@@ -149,19 +167,28 @@ private:
                              const std::vector<HostSharedPtr>& hosts_removed);
   void refreshHealthyStat();
   void runCallbacks(HostSharedPtr host, bool changed_state);
+  void runCallbacksOnMainThread(HostSharedPtr host, bool changed_state);
   void setUnhealthyCrossThread(const HostSharedPtr& host);
+  void updateHosts(const std::vector<HostSharedPtr>& hosts_added,
+                   const std::vector<HostSharedPtr>& hosts_removed);
 
   static const std::chrono::milliseconds NO_TRAFFIC_INTERVAL;
 
   std::list<HostStatusCb> callbacks_;
   const std::chrono::milliseconds interval_;
   const std::chrono::milliseconds interval_jitter_;
+  const std::chrono::milliseconds initial_jitter_;
   std::unordered_map<HostSharedPtr, ActiveHealthCheckSessionPtr> active_sessions_;
   uint64_t local_process_healthy_{};
+  // Set when the health checks run on their own thread.
+  Event::Dispatcher* main_thread_dispatcher_{};
+  std::weak_ptr<HealthCheckerImplBase> weak_this_;
 };
 
 /**
- * HTTP health checker implementation. Connection keep alive is used where possible.
+ * HTTP health checker implementation. Connection keep alive is used where possible. Clusters which
+ * use HTTP/2 are checked over HTTP/2 when the "health_check.http2" runtime key is enabled, in
+ * which case each check is a stream on one long lived connection to the host.
  */
 class HttpHealthCheckerImpl : public HealthCheckerImplBase {
 public:
@@ -169,6 +196,9 @@ public:
                         Event::Dispatcher& dispatcher, Runtime::Loader& runtime,
                         Runtime::RandomGenerator& random);
 
+protected:
+  const Http::CodecClient::Type codec_client_type_;
+
 private:
   struct HttpActiveHealthCheckSession : public ActiveHealthCheckSession,
                                         public Http::StreamDecoder,
@@ -243,6 +273,90 @@ public:
   Http::CodecClient* createCodecClient(Upstream::Host::CreateConnectionData& data) override;
 };
 
+/**
+ * gRPC health checker implementation, which calls the standard grpc.health.v1.Health/Check method
+ * as a stream on a long lived HTTP/2 connection to each host. The pinned v2 API has no gRPC health
+ * check, so this is used for HTTP health checks whose path is HEALTH_CHECK_PATH. Their service
+ * name, if any, is the service the hosts are asked about.
+ */
+class GrpcHealthCheckerImpl : public HealthCheckerImplBase {
+public:
+  GrpcHealthCheckerImpl(const Cluster& cluster, const envoy::api::v2::HealthCheck& config,
+                        Event::Dispatcher& dispatcher, Runtime::Loader& runtime,
+                        Runtime::RandomGenerator& random);
+
+  static const std::string HEALTH_CHECK_PATH;
+
+private:
+  struct GrpcActiveHealthCheckSession : public ActiveHealthCheckSession,
+                                        public Http::StreamDecoder,
+                                        public Http::StreamCallbacks {
+    GrpcActiveHealthCheckSession(GrpcHealthCheckerImpl& parent, HostSharedPtr host);
+    ~GrpcActiveHealthCheckSession();
+
+    void onRpcComplete(const Optional<Grpc::Status::GrpcStatus>& grpc_status);
+    bool isHealthCheckSucceeded(const Optional<Grpc::Status::GrpcStatus>& grpc_status);
+
+    // ActiveHealthCheckSession
+    void onInterval() override;
+    void onTimeout() override;
+
+    // Http::StreamDecoder
+    void decodeHeaders(Http::HeaderMapPtr&& headers, bool end_stream) override;
+    void decodeData(Buffer::Instance& data, bool end_stream) override;
+    void decodeTrailers(Http::HeaderMapPtr&& trailers) override;
+
+    // Http::StreamCallbacks
+    void onResetStream(Http::StreamResetReason reason) override;
+    void onAboveWriteBufferHighWatermark() override {}
+    void onBelowWriteBufferLowWatermark() override {}
+
+    void onEvent(Network::ConnectionEvent event);
+
+    class ConnectionCallbackImpl : public Network::ConnectionCallbacks {
+    public:
+      ConnectionCallbackImpl(GrpcActiveHealthCheckSession& parent) : parent_(parent) {}
+      // Network::ConnectionCallbacks
+      void onEvent(Network::ConnectionEvent event) override { parent_.onEvent(event); }
+      void onAboveWriteBufferHighWatermark() override {}
+      void onBelowWriteBufferLowWatermark() override {}
+
+    private:
+      GrpcActiveHealthCheckSession& parent_;
+    };
+
+    ConnectionCallbackImpl connection_callback_impl_{*this};
+    GrpcHealthCheckerImpl& parent_;
+    Http::CodecClientPtr client_;
+    Http::StreamEncoder* request_encoder_{};
+    Http::HeaderMapPtr response_headers_;
+    std::unique_ptr<Grpc::Decoder> decoder_;
+    std::vector<Grpc::Frame> decoded_frames_;
+    bool decode_error_{};
+    bool expect_reset_{};
+  };
+
+  virtual Http::CodecClient* createCodecClient(Upstream::Host::CreateConnectionData& data) PURE;
+
+  // HealthCheckerImplBase
+  ActiveHealthCheckSessionPtr makeSession(HostSharedPtr host) override {
+    return ActiveHealthCheckSessionPtr{new GrpcActiveHealthCheckSession(*this, host)};
+  }
+
+  const std::string service_name_;
+};
+
+/**
+ * Production implementation of the gRPC health checker that allocates a real codec client.
+ */
+class ProdGrpcHealthCheckerImpl : public GrpcHealthCheckerImpl {
+public:
+  using GrpcHealthCheckerImpl::GrpcHealthCheckerImpl;
+
+  // GrpcHealthCheckerImpl
+  Http::CodecClient* createCodecClient(Upstream::Host::CreateConnectionData& data) override;
+};
+
 /**
  * Utility class for loading a binary health checking config and matching it against a buffer.
  * Split out for ease of testing. The type of matching performed is the following (this is the
@@ -386,6 +500,8 @@ private:
       // Allow the main HC infra to control timeout.
       return parent_.timeout_ * 2;
     }
+    // Write the health check request right away.
+    uint32_t maxBufferSizeBeforeFlush() const override { return 0; }
 
     // Redis::ConnPool::PoolCallbacks
     void onResponse(Redis::RespValuePtr&& value) override;
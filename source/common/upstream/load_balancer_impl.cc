@@ -1,5 +1,7 @@
 #include "common/upstream/load_balancer_impl.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -9,21 +11,44 @@
 #include "envoy/upstream/upstream.h"
 
 #include "common/common/assert.h"
+#include "common/common/utility.h"
+#include "common/runtime/key_registry.h"
 
 namespace Envoy {
 namespace Upstream {
 
-static const std::string RuntimeZoneEnabled = "upstream.zone_routing.enabled";
-static const std::string RuntimeMinClusterSize = "upstream.zone_routing.min_cluster_size";
-static const std::string RuntimePanicThreshold = "upstream.healthy_panic_threshold";
+static const Runtime::Key RuntimeZoneEnabled =
+    Runtime::KeyRegistry::registerKey("upstream.zone_routing.enabled");
+static const Runtime::Key RuntimeMinClusterSize =
+    Runtime::KeyRegistry::registerKey("upstream.zone_routing.min_cluster_size");
+static const Runtime::Key RuntimePanicThreshold =
+    Runtime::KeyRegistry::registerKey("upstream.healthy_panic_threshold");
+static const Runtime::Key RuntimeWeightEnabled =
+    Runtime::KeyRegistry::registerKey("upstream.weight_enabled");
+static const Runtime::Key RuntimeWeightedP2c =
+    Runtime::KeyRegistry::registerKey("upstream.least_request.weighted_p2c");
+static const Runtime::Key RuntimeSlowStartWindow =
+    Runtime::KeyRegistry::registerKey("upstream.slow_start.window_ms");
+static const Runtime::Key RuntimeSlowStartMinWeightPercent =
+    Runtime::KeyRegistry::registerKey("upstream.slow_start.min_weight_percent");
 
 LoadBalancerBase::LoadBalancerBase(const PrioritySet& priority_set,
                                    const PrioritySet* local_priority_set, ClusterStats& stats,
                                    Runtime::Loader& runtime, Runtime::RandomGenerator& random)
-    : stats_(stats), runtime_(runtime), random_(random),
+    : stats_(stats), runtime_(runtime), random_(random), priority_set_(priority_set),
       host_set_(*priority_set.hostSetsPerPriority()[0]),
       local_host_set_(local_priority_set ? local_priority_set->hostSetsPerPriority()[0].get()
                                          : nullptr) {
+  for (size_t priority = 0; priority < priority_set_.hostSetsPerPriority().size(); ++priority) {
+    regenerateLocalityScheduler(priority);
+  }
+  updateLatestSlowStartTime();
+  priority_set_.addMemberUpdateCb([this](uint32_t priority, const std::vector<HostSharedPtr>&,
+                                         const std::vector<HostSharedPtr>&) -> void {
+    regenerateLocalityScheduler(priority);
+    updateLatestSlowStartTime();
+  });
+
   if (local_host_set_) {
     host_set_.addMemberUpdateCb([this](uint32_t, const std::vector<HostSharedPtr>&,
                                        const std::vector<HostSharedPtr>&) -> void {
@@ -110,6 +135,11 @@ void LoadBalancerBase::regenerateLocalityRoutingStructures() {
 };
 
 bool LoadBalancerBase::earlyExitNonLocalityRouting() {
+  // Weighted localities are load balanced by weight, and aren't ordered with the local one first.
+  if (host_set_.localityWeights() != nullptr) {
+    return true;
+  }
+
   if (host_set_.healthyHostsPerLocality().size() < 2) {
     return true;
   }
@@ -212,6 +242,52 @@ const std::vector<HostSharedPtr>& LoadBalancerBase::tryChooseLocalLocalityHosts(
   return host_set_.healthyHostsPerLocality()[i];
 }
 
+void LoadBalancerBase::regenerateLocalityScheduler(uint32_t priority) {
+  if (locality_schedulers_.size() <= priority) {
+    locality_schedulers_.resize(priority + 1);
+  }
+  locality_schedulers_[priority] = nullptr;
+
+  const HostSet& host_set = *priority_set_.hostSetsPerPriority()[priority];
+  const HostSet::LocalityWeightsConstSharedPtr locality_weights = host_set.localityWeights();
+  if (locality_weights == nullptr) {
+    return;
+  }
+
+  const auto& hosts_per_locality = host_set.hostsPerLocality();
+  const auto& healthy_hosts_per_locality = host_set.healthyHostsPerLocality();
+  ASSERT(locality_weights->size() == hosts_per_locality.size());
+  ASSERT(healthy_hosts_per_locality.size() == hosts_per_locality.size());
+  std::unique_ptr<EdfScheduler<uint32_t>> scheduler(new EdfScheduler<uint32_t>());
+  for (uint32_t i = 0; i < hosts_per_locality.size(); ++i) {
+    // A locality whose hosts are failing loses weight with them, so that its remaining healthy
+    // hosts aren't sent the traffic of the failed ones.
+    if (hosts_per_locality[i].empty()) {
+      continue;
+    }
+    const double effective_weight = 1.0 * (*locality_weights)[i] *
+                                    healthy_hosts_per_locality[i].size() /
+                                    hosts_per_locality[i].size();
+    if (effective_weight > 0) {
+      scheduler->add(effective_weight, i);
+    }
+  }
+
+  if (!scheduler->empty()) {
+    locality_schedulers_[priority] = std::move(scheduler);
+  }
+}
+
+const std::vector<HostSharedPtr>*
+LoadBalancerBase::tryChooseWeightedLocalityHosts(uint32_t priority) {
+  if (priority >= locality_schedulers_.size() || locality_schedulers_[priority] == nullptr) {
+    return nullptr;
+  }
+
+  const HostSet& host_set = *priority_set_.hostSetsPerPriority()[priority];
+  return &host_set.healthyHostsPerLocality()[locality_schedulers_[priority]->pick()];
+}
+
 const std::vector<HostSharedPtr>& LoadBalancerBase::hostsToUse() {
   ASSERT(host_set_.healthyHosts().size() <= host_set_.hosts().size());
 
@@ -220,6 +296,11 @@ const std::vector<HostSharedPtr>& LoadBalancerBase::hostsToUse() {
     return host_set_.hosts();
   }
 
+  const std::vector<HostSharedPtr>* locality_hosts = tryChooseWeightedLocalityHosts(0);
+  if (locality_hosts != nullptr) {
+    return *locality_hosts;
+  }
+
   if (locality_routing_state_ == LocalityRoutingState::NoLocalityRouting) {
     return host_set_.healthyHosts();
   }
@@ -236,15 +317,125 @@ const std::vector<HostSharedPtr>& LoadBalancerBase::hostsToUse() {
   return tryChooseLocalLocalityHosts();
 }
 
+const std::vector<HostSharedPtr>& LoadBalancerBase::hostsToUseWithFailover() {
+  if (LoadBalancerUtility::isGlobalPanic(host_set_, runtime_)) {
+    const auto& host_sets = priority_set_.hostSetsPerPriority();
+    for (size_t priority = 1; priority < host_sets.size(); ++priority) {
+      if (!LoadBalancerUtility::isGlobalPanic(*host_sets[priority], runtime_)) {
+        const std::vector<HostSharedPtr>* locality_hosts = tryChooseWeightedLocalityHosts(priority);
+        return locality_hosts != nullptr ? *locality_hosts : host_sets[priority]->healthyHosts();
+      }
+    }
+  }
+
+  return hostsToUse();
+}
+
+void LoadBalancerBase::updateLatestSlowStartTime() {
+  for (const auto& host_set : priority_set_.hostSetsPerPriority()) {
+    for (const HostSharedPtr& host : host_set->hosts()) {
+      latest_slow_start_time_ = std::max(latest_slow_start_time_, host->slowStartTime());
+    }
+  }
+}
+
+bool LoadBalancerBase::inSlowStart(MonotonicTime& now, std::chrono::milliseconds& window) {
+  window = std::chrono::milliseconds(runtime_.snapshot().getInteger(RuntimeSlowStartWindow, 0));
+  if (window.count() == 0) {
+    return false;
+  }
+  now = ProdMonotonicTimeSource::instance_.currentTime();
+  if (now >= latest_slow_start_time_ + window) {
+    return false;
+  }
+  slow_start_min_factor_ =
+      std::max(1UL, std::min(100UL, runtime_.snapshot().getInteger(
+                                        RuntimeSlowStartMinWeightPercent, 10))) /
+      100.0;
+  return true;
+}
+
+double LoadBalancerBase::slowStartFactor(const Host& host, MonotonicTime now,
+                                         std::chrono::milliseconds window) {
+  const auto elapsed = now - host.slowStartTime();
+  if (elapsed >= window) {
+    return 1.0;
+  }
+  const double progress = elapsed.count() > 0 ? std::chrono::duration<double>(elapsed).count() /
+                                                    std::chrono::duration<double>(window).count()
+                                              : 0.0;
+  return slow_start_min_factor_ + (1.0 - slow_start_min_factor_) * progress;
+}
+
+RoundRobinLoadBalancer::RoundRobinLoadBalancer(const PrioritySet& priority_set,
+                                               const PrioritySet* local_priority_set,
+                                               ClusterStats& stats, Runtime::Loader& runtime,
+                                               Runtime::RandomGenerator& random)
+    : LoadBalancerBase(priority_set, local_priority_set, stats, runtime, random) {
+  host_set_.addMemberUpdateCb(
+      [this](uint32_t, const std::vector<HostSharedPtr>&, const std::vector<HostSharedPtr>&)
+          -> void {
+        schedulers_.clear();
+        slow_start_schedulers_.clear();
+      });
+}
+
 HostConstSharedPtr RoundRobinLoadBalancer::chooseHost(LoadBalancerContext*) {
   const std::vector<HostSharedPtr>& hosts_to_use = hostsToUse();
   if (hosts_to_use.empty()) {
     return nullptr;
   }
 
+  MonotonicTime now;
+  std::chrono::milliseconds window;
+  if (inSlowStart(now, window)) {
+    return hosts_to_use[slowStartScheduler(hosts_to_use, now, window).pick()];
+  }
+
+  if (stats_.max_host_weight_.value() > 1 &&
+      runtime_.snapshot().getInteger(RuntimeWeightEnabled, 1UL) != 0) {
+    return hosts_to_use[scheduler(hosts_to_use).pick()];
+  }
+
   return hosts_to_use[rr_index_++ % hosts_to_use.size()];
 }
 
+EdfScheduler<uint32_t>&
+RoundRobinLoadBalancer::scheduler(const std::vector<HostSharedPtr>& hosts) {
+  EdfScheduler<uint32_t>& scheduler = schedulers_[&hosts];
+  // A size mismatch means the list was changed in place without a membership update.
+  if (scheduler.size() != hosts.size()) {
+    scheduler = EdfScheduler<uint32_t>();
+    for (uint32_t i = 0; i < hosts.size(); i++) {
+      scheduler.add(hosts[i]->weight(), i);
+    }
+  }
+  return scheduler;
+}
+
+EdfScheduler<uint32_t>&
+RoundRobinLoadBalancer::slowStartScheduler(const std::vector<HostSharedPtr>& hosts,
+                                           MonotonicTime now, std::chrono::milliseconds window) {
+  // The ramped weights are only refreshed in steps of a tenth of the window, and at most a second,
+  // since the schedule is rebuilt to refresh them.
+  const auto refresh_interval = std::min<std::chrono::steady_clock::duration>(
+      std::chrono::seconds(1), window / 10);
+  SlowStartScheduler& slow_start_scheduler = slow_start_schedulers_[&hosts];
+  if (slow_start_scheduler.size_ != hosts.size() ||
+      now - slow_start_scheduler.built_ >= refresh_interval) {
+    const bool weighted = runtime_.snapshot().getInteger(RuntimeWeightEnabled, 1UL) != 0;
+    slow_start_scheduler.scheduler_ = EdfScheduler<uint32_t>();
+    for (uint32_t i = 0; i < hosts.size(); i++) {
+      slow_start_scheduler.scheduler_.add((weighted ? hosts[i]->weight() : 1) *
+                                              slowStartFactor(*hosts[i], now, window),
+                                          i);
+    }
+    slow_start_scheduler.size_ = hosts.size();
+    slow_start_scheduler.built_ = now;
+  }
+  return slow_start_scheduler.scheduler_;
+}
+
 LeastRequestLoadBalancer::LeastRequestLoadBalancer(const PrioritySet& priority_set,
                                                    const PrioritySet* local_priority_set,
                                                    ClusterStats& stats, Runtime::Loader& runtime,
@@ -267,9 +458,11 @@ LeastRequestLoadBalancer::LeastRequestLoadBalancer(const PrioritySet& priority_s
 
 HostConstSharedPtr LeastRequestLoadBalancer::chooseHost(LoadBalancerContext*) {
   bool is_weight_imbalanced = stats_.max_host_weight_.value() != 1;
-  bool is_weight_enabled = runtime_.snapshot().getInteger("upstream.weight_enabled", 1UL) != 0;
+  bool is_weight_enabled = runtime_.snapshot().getInteger(RuntimeWeightEnabled, 1UL) != 0;
+  bool is_weighted_p2c = runtime_.snapshot().getInteger(RuntimeWeightedP2c, 1UL) != 0;
+  bool use_weighted_random = is_weight_imbalanced && is_weight_enabled && !is_weighted_p2c;
 
-  if (is_weight_imbalanced && hits_left_ > 0 && is_weight_enabled) {
+  if (use_weighted_random && hits_left_ > 0) {
     --hits_left_;
 
     return last_host_;
@@ -279,34 +472,114 @@ HostConstSharedPtr LeastRequestLoadBalancer::chooseHost(LoadBalancerContext*) {
     last_host_.reset();
   }
 
-  const std::vector<HostSharedPtr>& hosts_to_use = hostsToUse();
+  const std::vector<HostSharedPtr>& hosts_to_use = hostsToUseWithFailover();
   if (hosts_to_use.empty()) {
     return nullptr;
   }
 
   // Make weighed random if we have hosts with non 1 weights.
-  if (is_weight_imbalanced & is_weight_enabled) {
+  if (use_weighted_random) {
     last_host_ = hosts_to_use[random_.random() % hosts_to_use.size()];
     hits_left_ = last_host_->weight() - 1;
 
     return last_host_;
+  }
+
+  HostSharedPtr host1 = hosts_to_use[random_.random() % hosts_to_use.size()];
+  HostSharedPtr host2 = hosts_to_use[random_.random() % hosts_to_use.size()];
+  MonotonicTime now;
+  std::chrono::milliseconds window;
+  if (inSlowStart(now, window)) {
+    const bool weighted = is_weight_imbalanced && is_weight_enabled;
+    const double weight1 =
+        (weighted ? host1->weight() : 1) * slowStartFactor(*host1, now, window);
+    const double weight2 =
+        (weighted ? host2->weight() : 1) * slowStartFactor(*host2, now, window);
+    const double load1 = (host1->stats().rq_active_.value() + 1) / weight1;
+    const double load2 = (host2->stats().rq_active_.value() + 1) / weight2;
+    return load1 < load2 ? host1 : host2;
+  }
+
+  if (is_weight_imbalanced && is_weight_enabled) {
+    // Compare (active + 1) / weight across the two hosts, cross multiplied to stay in integers.
+    // The + 1 accounts for the request being placed, so that the heavier host wins when both hosts
+    // are idle.
+    const uint64_t load1 = (host1->stats().rq_active_.value() + 1) * host2->weight();
+    const uint64_t load2 = (host2->stats().rq_active_.value() + 1) * host1->weight();
+    return load1 < load2 ? host1 : host2;
+  }
+
+  if (host1->stats().rq_active_.value() < host2->stats().rq_active_.value()) {
+    return host1;
   } else {
-    HostSharedPtr host1 = hosts_to_use[random_.random() % hosts_to_use.size()];
-    HostSharedPtr host2 = hosts_to_use[random_.random() % hosts_to_use.size()];
-    if (host1->stats().rq_active_.value() < host2->stats().rq_active_.value()) {
-      return host1;
-    } else {
-      return host2;
-    }
+    return host2;
   }
 }
 
+HostConstSharedPtr PeakEwmaLoadBalancer::chooseHost(LoadBalancerContext*) {
+  const std::vector<HostSharedPtr>& hosts_to_use = hostsToUseWithFailover();
+  if (hosts_to_use.empty()) {
+    return nullptr;
+  }
+
+  const bool weighted = stats_.max_host_weight_.value() != 1 &&
+                        runtime_.snapshot().getInteger(RuntimeWeightEnabled, 1UL) != 0;
+  MonotonicTime now;
+  std::chrono::milliseconds window;
+  const bool slow_start = inSlowStart(now, window);
+  if (!slow_start) {
+    now = ProdMonotonicTimeSource::instance_.currentTime();
+  }
+
+  HostSharedPtr host1 = hosts_to_use[random_.random() % hosts_to_use.size()];
+  HostSharedPtr host2 = hosts_to_use[random_.random() % hosts_to_use.size()];
+  if (load(*host1, now, weighted, slow_start, window) <
+      load(*host2, now, weighted, slow_start, window)) {
+    return host1;
+  } else {
+    return host2;
+  }
+}
+
+double PeakEwmaLoadBalancer::load(const Host& host, MonotonicTime now, bool weighted,
+                                  bool slow_start, std::chrono::milliseconds window) {
+  // The latency assumed for a host with active requests which has not responded yet, high enough
+  // for any measured host to be preferred.
+  static constexpr double UnmeasuredLatency = 1e12;
+
+  const uint64_t active = host.stats().rq_active_.value();
+  double latency = host.latencyEstimator().peakEwma(now);
+  if (latency == 0 && active > 0) {
+    latency = UnmeasuredLatency;
+  }
+  double weight = weighted ? host.weight() : 1;
+  if (slow_start) {
+    weight *= slowStartFactor(host, now, window);
+  }
+  return latency * (active + 1) / weight;
+}
+
 HostConstSharedPtr RandomLoadBalancer::chooseHost(LoadBalancerContext*) {
   const std::vector<HostSharedPtr>& hosts_to_use = hostsToUse();
   if (hosts_to_use.empty()) {
     return nullptr;
   }
 
+  MonotonicTime now;
+  std::chrono::milliseconds window;
+  if (inSlowStart(now, window)) {
+    // The number of picks is bounded, so hosts ramping up get slightly more than their share when
+    // most of the hosts are ramping up.
+    HostSharedPtr host;
+    for (uint32_t attempt = 0; attempt < 8; attempt++) {
+      host = hosts_to_use[random_.random() % hosts_to_use.size()];
+      if (random_.random() % 10000 < slowStartFactor(*host, now, window) * 10000) {
+        break;
+      }
+    }
+    return host;
+  }
+
   return hosts_to_use[random_.random() % hosts_to_use.size()];
 }
 
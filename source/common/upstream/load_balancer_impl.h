@@ -1,13 +1,18 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
+#include <memory>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 #include "envoy/runtime/runtime.h"
 #include "envoy/upstream/load_balancer.h"
 #include "envoy/upstream/upstream.h"
 
+#include "common/upstream/edf_scheduler.h"
+
 #include "api/cds.pb.h"
 
 namespace Envoy {
@@ -28,6 +33,16 @@ public:
 
 /**
  * Base class for all LB implementations.
+ *
+ * When the localities of a host set are weighted, requests are spread over its localities in
+ * proportion to their weights, scaled by the fraction of hosts in each locality which are healthy,
+ * instead of being routed by zone. Each pick is made with an EDF schedule of the localities that is
+ * built when the host set changes.
+ *
+ * When the "upstream.slow_start.window_ms" runtime key is set, hosts added or recovered less than
+ * that long ago are given a share of their weight, which ramps linearly from the
+ * "upstream.slow_start.min_weight_percent" runtime value (10 by default) up to their full weight
+ * over the window, so that cold hosts aren't sent a full share of requests at once.
  */
 class LoadBalancerBase {
 protected:
@@ -40,12 +55,34 @@ protected:
    */
   const std::vector<HostSharedPtr>& hostsToUse();
 
+  /**
+   * Pick the host list to use like hostsToUse(), except that if priority 0 is in panic mode the
+   * healthy hosts of the first higher priority level that is not in panic mode are used instead.
+   */
+  const std::vector<HostSharedPtr>& hostsToUseWithFailover();
+
+  /**
+   * Determine whether any host of the priority set may be in its slow start window. The clock is
+   * only read when slow start is enabled.
+   * @param now supplies where to return the current time, for slowStartFactor().
+   * @param window supplies where to return the slow start window, for slowStartFactor().
+   * @return bool whether any host was added or recovered within the slow start window.
+   */
+  bool inSlowStart(MonotonicTime& now, std::chrono::milliseconds& window);
+
+  /**
+   * @return double the fraction of its weight given to a host, which is less than 1 during its
+   *         slow start window. Only valid after inSlowStart() returned true.
+   */
+  double slowStartFactor(const Host& host, MonotonicTime now, std::chrono::milliseconds window);
+
   ClusterStats& stats_;
   Runtime::Loader& runtime_;
   Runtime::RandomGenerator& random_;
 
   // TODO(alyssawilk) make load balancers priority-aware and remove.
 protected:
+  const PrioritySet& priority_set_;
   const HostSet& host_set_;
 
 private:
@@ -62,6 +99,18 @@ private:
    */
   const std::vector<HostSharedPtr>& tryChooseLocalLocalityHosts();
 
+  /**
+   * Pick the healthy hosts of one of the weighted localities of a priority level.
+   * @return the hosts, or nullptr if the localities of the priority level are not weighted or none
+   *         of them has healthy hosts.
+   */
+  const std::vector<HostSharedPtr>* tryChooseWeightedLocalityHosts(uint32_t priority);
+
+  /**
+   * Regenerate the schedule of the weighted localities of a priority level.
+   */
+  void regenerateLocalityScheduler(uint32_t priority);
+
   /**
    * @return (number of hosts in a given locality)/(total number of hosts) in ret param.
    * The result is stored as integer number and scaled by 10000 multiplier for better precision.
@@ -76,42 +125,77 @@ private:
    */
   void regenerateLocalityRoutingStructures();
 
+  /**
+   * Find the latest slow start time of the hosts of the priority set.
+   */
+  void updateLatestSlowStartTime();
+
   const HostSet* local_host_set_;
   uint64_t local_percent_to_route_{};
   LocalityRoutingState locality_routing_state_{LocalityRoutingState::NoLocalityRouting};
   std::vector<uint64_t> residual_capacity_;
   Common::CallbackHandle* local_host_set_member_update_cb_handle_{};
+  // Schedules of indices into healthyHostsPerLocality() per priority level, or nullptr for the
+  // levels to which locality weighted load balancing doesn't apply.
+  std::vector<std::unique_ptr<EdfScheduler<uint32_t>>> locality_schedulers_;
+  // Hosts only start slow starting when they are added or recovered, both of which are followed by
+  // a membership update, so no host is in its slow start window after this plus the window.
+  MonotonicTime latest_slow_start_time_;
+  double slow_start_min_factor_{1.0};
 };
 
 /**
  * Implementation of LoadBalancer that performs RR selection across the hosts in the cluster.
+ * When any of the hosts have non 1 weight, weighted RR is performed with an EDF schedule per host
+ * list, which is built on first use after each membership update. While hosts are in their slow
+ * start window, the schedule uses their ramped weights and is rebuilt as they ramp up.
  */
 class RoundRobinLoadBalancer : public LoadBalancer, LoadBalancerBase {
 public:
   RoundRobinLoadBalancer(const PrioritySet& priority_set, const PrioritySet* local_priority_set,
                          ClusterStats& stats, Runtime::Loader& runtime,
-                         Runtime::RandomGenerator& random)
-      : LoadBalancerBase(priority_set, local_priority_set, stats, runtime, random) {}
+                         Runtime::RandomGenerator& random);
 
   // Upstream::LoadBalancer
   HostConstSharedPtr chooseHost(LoadBalancerContext* context) override;
 
 private:
+  struct SlowStartScheduler {
+    EdfScheduler<uint32_t> scheduler_;
+    size_t size_{};
+    MonotonicTime built_;
+  };
+
+  EdfScheduler<uint32_t>& scheduler(const std::vector<HostSharedPtr>& hosts);
+  EdfScheduler<uint32_t>& slowStartScheduler(const std::vector<HostSharedPtr>& hosts,
+                                             MonotonicTime now, std::chrono::milliseconds window);
+
   size_t rr_index_{};
+  // Schedules of indices into the host lists returned by hostsToUse(), keyed by the list. Cleared
+  // on membership updates, which may replace the lists.
+  std::unordered_map<const std::vector<HostSharedPtr>*, EdfScheduler<uint32_t>> schedulers_;
+  std::unordered_map<const std::vector<HostSharedPtr>*, SlowStartScheduler>
+      slow_start_schedulers_;
 };
 
 /**
  * Weighted Least Request load balancer.
  *
- * In a normal setup when all hosts have the same weight of 1 it randomly picks up two healthy hosts
- * and compares number of active requests.
- * Technique is based on http://www.eecs.harvard.edu/~michaelm/postscripts/mythesis.pdf
+ * It randomly picks up two healthy hosts and compares number of active requests ("power of two
+ * choices"). Technique is based on http://www.eecs.harvard.edu/~michaelm/postscripts/mythesis.pdf
+ * When any of the hosts have non 1 weight, the number of active requests is scaled by the weight
+ * of each host, so that a host of weight 2 is expected to carry twice the active requests of a
+ * host of weight 1.
+ *
+ * Hosts in their slow start window are compared with their ramped weights.
  *
- * When any of the hosts have non 1 weight, apply random weighted balancing.
- * Randomly pickup the host and send 'weight' number of requests to it.
- * This technique is acceptable for load testing but
- * will not work well in situations where requests take a long time.
- * In that case a different algorithm using a full scan will be required.
+ * If the "upstream.least_request.weighted_p2c" runtime key is 0, the legacy behavior for non 1
+ * weights applies instead: randomly pickup the host and send 'weight' number of requests to it.
+ * This technique is acceptable for load testing but will not work well in situations where
+ * requests take a long time.
+ *
+ * Unlike the other load balancers, when priority 0 is in panic mode the healthy hosts of the first
+ * higher priority that is not in panic mode are used.
  */
 class LeastRequestLoadBalancer : public LoadBalancer, LoadBalancerBase {
 public:
@@ -128,7 +212,37 @@ private:
 };
 
 /**
- * Random load balancer that picks a random host out of all hosts.
+ * Peak EWMA load balancer. Like the least request load balancer, it picks the better of two random
+ * healthy hosts, but each host's load is its active requests plus one, multiplied by the peak
+ * sensitive EWMA of its response latency (see PeakEwmaLatencyEstimatorImpl) and divided by its
+ * weight. Slow hosts are thereby avoided as soon as their responses slow down, well before outlier
+ * detection would eject them.
+ *
+ * A host which has not responded yet is preferred while it has no active requests, and avoided
+ * once it has some, until its first response gives it a latency.
+ *
+ * As with the least request load balancer, when priority 0 is in panic mode the healthy hosts of
+ * the first higher priority that is not in panic mode are used.
+ */
+class PeakEwmaLoadBalancer : public LoadBalancer, LoadBalancerBase {
+public:
+  PeakEwmaLoadBalancer(const PrioritySet& priority_set, const PrioritySet* local_priority_set,
+                       ClusterStats& stats, Runtime::Loader& runtime,
+                       Runtime::RandomGenerator& random)
+      : LoadBalancerBase(priority_set, local_priority_set, stats, runtime, random) {}
+
+  // Upstream::LoadBalancer
+  HostConstSharedPtr chooseHost(LoadBalancerContext* context) override;
+
+private:
+  double load(const Host& host, MonotonicTime now, bool weighted, bool slow_start,
+              std::chrono::milliseconds window);
+};
+
+/**
+ * Random load balancer that picks a random host out of all hosts. Hosts in their slow start window
+ * are only kept with a probability of their ramped share of their weight, otherwise another host is
+ * picked.
  */
 class RandomLoadBalancer : public LoadBalancer, LoadBalancerBase {
 public:
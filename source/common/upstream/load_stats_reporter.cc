@@ -6,10 +6,10 @@ namespace Envoy {
 namespace Upstream {
 
 LoadStatsReporter::LoadStatsReporter(const envoy::api::v2::Node& node,
-                                     ClusterManager& cluster_manager, Stats::Scope& scope,
-                                     LoadStatsAsyncClientPtr async_client,
+                                     ClusterManager& cluster_manager, Runtime::Loader& runtime,
+                                     Stats::Scope& scope, LoadStatsAsyncClientPtr async_client,
                                      Event::Dispatcher& dispatcher)
-    : cm_(cluster_manager), stats_{ALL_LOAD_REPORTER_STATS(
+    : cm_(cluster_manager), runtime_(runtime), stats_{ALL_LOAD_REPORTER_STATS(
                                 POOL_COUNTER_PREFIX(scope, "load_reporter."))},
       async_client_(std::move(async_client)),
       service_method_(*Protobuf::DescriptorPool::generated_pool()->FindMethodByName(
@@ -21,11 +21,11 @@ LoadStatsReporter::LoadStatsReporter(const envoy::api::v2::Node& node,
 }
 
 LoadStatsReporter::LoadStatsReporter(const envoy::api::v2::Node& node,
-                                     ClusterManager& cluster_manager, Stats::Scope& scope,
-                                     const std::string& remote_cluster_name,
+                                     ClusterManager& cluster_manager, Runtime::Loader& runtime,
+                                     Stats::Scope& scope, const std::string& remote_cluster_name,
                                      Event::Dispatcher& dispatcher)
     : LoadStatsReporter(
-          node, cluster_manager, scope,
+          node, cluster_manager, runtime, scope,
           LoadStatsAsyncClientPtr(new Grpc::AsyncClientImpl<envoy::api::v2::LoadStatsRequest,
                                                             envoy::api::v2::LoadStatsResponse>(
               cluster_manager, remote_cluster_name)),
@@ -50,8 +50,12 @@ void LoadStatsReporter::establishNewStream() {
 
 void LoadStatsReporter::sendLoadStatsRequest() {
   request_.mutable_cluster_stats()->Clear();
+  // Localities and clusters without any load since the last report can be left out, as the
+  // management server treats a missing locality as one without load.
+  const bool report_zero_load =
+      runtime_.snapshot().getInteger("load_reporter.report_zero_load", 1) != 0;
+  auto cluster_info_map = cm_.clusters();
   for (const std::string& cluster_name : clusters_) {
-    auto cluster_info_map = cm_.clusters();
     auto it = cluster_info_map.find(cluster_name);
     if (it == cluster_info_map.end()) {
       ENVOY_LOG(debug, "Cluster {} does not exist", cluster_name);
@@ -62,10 +66,7 @@ void LoadStatsReporter::sendLoadStatsRequest() {
     cluster_stats->set_cluster_name(cluster_name);
     for (auto& host_set : cluster.prioritySet().hostSetsPerPriority()) {
       for (auto& hosts : host_set->hostsPerLocality()) {
-        auto* locality_stats = cluster_stats->add_upstream_locality_stats();
         ASSERT(hosts.size() > 0);
-        locality_stats->mutable_locality()->MergeFrom(hosts[0]->locality());
-        locality_stats->set_priority(host_set->priority());
         uint64_t rq_success = 0;
         uint64_t rq_error = 0;
         uint64_t rq_active = 0;
@@ -74,6 +75,12 @@ void LoadStatsReporter::sendLoadStatsRequest() {
           rq_error += host->stats().rq_error_.latch();
           rq_active += host->stats().rq_active_.value();
         }
+        if (!report_zero_load && rq_success == 0 && rq_error == 0 && rq_active == 0) {
+          continue;
+        }
+        auto* locality_stats = cluster_stats->add_upstream_locality_stats();
+        locality_stats->mutable_locality()->MergeFrom(hosts[0]->locality());
+        locality_stats->set_priority(host_set->priority());
         locality_stats->set_total_successful_requests(rq_success);
         locality_stats->set_total_error_requests(rq_error);
         locality_stats->set_total_requests_in_progress(rq_active);
@@ -81,6 +88,10 @@ void LoadStatsReporter::sendLoadStatsRequest() {
     }
     cluster_stats->set_total_dropped_requests(
         cluster.info()->loadReportStats().upstream_rq_dropped_.latch());
+    if (!report_zero_load && cluster_stats->upstream_locality_stats_size() == 0 &&
+        cluster_stats->total_dropped_requests() == 0) {
+      request_.mutable_cluster_stats()->RemoveLast();
+    }
   }
 
   ENVOY_LOG(trace, "Sending LoadStatsRequest: {}", request_.DebugString());
@@ -108,9 +119,9 @@ void LoadStatsReporter::onReceiveMessage(
   ENVOY_LOG(debug, "New load report epoch: {}", message->DebugString());
   clusters_.clear();
   // Reset stats for all hosts in clusters we are tracking.
+  auto cluster_info_map = cm_.clusters();
   for (const std::string& cluster_name : message->clusters()) {
     clusters_.emplace_back(cluster_name);
-    auto cluster_info_map = cm_.clusters();
     auto it = cluster_info_map.find(cluster_name);
     if (it == cluster_info_map.end()) {
       continue;
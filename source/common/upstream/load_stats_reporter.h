@@ -1,6 +1,7 @@
 #pragma once
 
 #include "envoy/event/dispatcher.h"
+#include "envoy/runtime/runtime.h"
 #include "envoy/stats/stats_macros.h"
 #include "envoy/upstream/cluster_manager.h"
 
@@ -37,11 +38,11 @@ class LoadStatsReporter : Grpc::AsyncStreamCallbacks<envoy::api::v2::LoadStatsRe
                           Logger::Loggable<Logger::Id::upstream> {
 public:
   LoadStatsReporter(const envoy::api::v2::Node& node, ClusterManager& cluster_manager,
-                    Stats::Scope& scope, LoadStatsAsyncClientPtr async_client,
-                    Event::Dispatcher& dispatcher);
+                    Runtime::Loader& runtime, Stats::Scope& scope,
+                    LoadStatsAsyncClientPtr async_client, Event::Dispatcher& dispatcher);
   LoadStatsReporter(const envoy::api::v2::Node& node, ClusterManager& cluster_manager,
-                    Stats::Scope& scope, const std::string& remote_cluster_name,
-                    Event::Dispatcher& dispatcher);
+                    Runtime::Loader& runtime, Stats::Scope& scope,
+                    const std::string& remote_cluster_name, Event::Dispatcher& dispatcher);
 
   // Grpc::AsyncStreamCallbacks
   void onCreateInitialMetadata(Http::HeaderMap& metadata) override;
@@ -60,6 +61,7 @@ private:
   void handleFailure();
 
   ClusterManager& cm_;
+  Runtime::Loader& runtime_;
   LoadReporterStats stats_;
   LoadStatsAsyncClientPtr async_client_;
   Grpc::AsyncStream<envoy::api::v2::LoadStatsRequest>* stream_{};
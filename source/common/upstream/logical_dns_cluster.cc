@@ -1,5 +1,6 @@
 #include "common/upstream/logical_dns_cluster.h"
 
+#include <algorithm>
 #include <chrono>
 #include <list>
 #include <string>
@@ -16,6 +17,9 @@
 namespace Envoy {
 namespace Upstream {
 
+const uint64_t LogicalDnsCluster::MIN_HAPPY_EYEBALLS_DELAY_MS;
+const uint64_t LogicalDnsCluster::MAX_HAPPY_EYEBALLS_DELAY_MS;
+
 LogicalDnsCluster::LogicalDnsCluster(const envoy::api::v2::Cluster& cluster,
                                      Runtime::Loader& runtime, Stats::Store& stats,
                                      Ssl::ContextManager& ssl_context_manager,
@@ -28,7 +32,9 @@ LogicalDnsCluster::LogicalDnsCluster(const envoy::api::v2::Cluster& cluster,
       dns_refresh_rate_ms_(
           std::chrono::milliseconds(PROTOBUF_GET_MS_OR_DEFAULT(cluster, dns_refresh_rate, 5000))),
       tls_(tls.allocateSlot()),
-      resolve_timer_(dispatcher.createTimer([this]() -> void { startResolve(); })) {
+      resolve_timer_(dispatcher.createTimer([this]() -> void { startResolve(); })),
+      happy_eyeballs_delay_runtime_key_(
+          fmt::format("upstream.happy_eyeballs_delay_ms.{}", cluster.name())) {
   const auto& hosts = cluster.hosts();
   if (hosts.size() != 1) {
     throw EnvoyException("logical_dns clusters must have a single host");
@@ -66,13 +72,28 @@ LogicalDnsCluster::~LogicalDnsCluster() {
   }
 }
 
+std::chrono::milliseconds LogicalDnsCluster::happyEyeballsDelay() const {
+  const uint64_t delay_ms = runtime_.snapshot().getInteger(happy_eyeballs_delay_runtime_key_, 0);
+  if (delay_ms == 0) {
+    return std::chrono::milliseconds(0);
+  }
+  return std::chrono::milliseconds(
+      std::max(MIN_HAPPY_EYEBALLS_DELAY_MS, std::min(delay_ms, MAX_HAPPY_EYEBALLS_DELAY_MS)));
+}
+
 void LogicalDnsCluster::startResolve() {
   std::string dns_address = Network::Utility::hostFromTcpUrl(dns_url_);
   ENVOY_LOG(debug, "starting async DNS resolution for {}", dns_address);
   info_->stats().update_attempt_.inc();
 
+  // Happy eyeballs needs the addresses of both IP versions, the IPv6 ones coming first as they
+  // do with auto.
+  const Network::DnsLookupFamily dns_lookup_family =
+      dns_lookup_family_ == Network::DnsLookupFamily::Auto && happyEyeballsDelay().count() > 0
+          ? Network::DnsLookupFamily::All
+          : dns_lookup_family_;
   active_dns_query_ = dns_resolver_->resolve(
-      dns_address, dns_lookup_family_,
+      dns_address, dns_lookup_family,
       [this,
        dns_address](std::list<Network::Address::InstanceConstSharedPtr>&& address_list) -> void {
         active_dns_query_ = nullptr;
@@ -82,14 +103,27 @@ void LogicalDnsCluster::startResolve() {
         if (!address_list.empty()) {
           // TODO(mattklein123): Move port handling into the DNS interface.
           ASSERT(address_list.front() != nullptr);
+          const uint32_t port = Network::Utility::portFromTcpUrl(dns_url_);
           Network::Address::InstanceConstSharedPtr new_address =
-              Network::Utility::getAddressWithPort(*address_list.front(),
-                                                   Network::Utility::portFromTcpUrl(dns_url_));
-          if (!current_resolved_address_ || !(*new_address == *current_resolved_address_)) {
+              Network::Utility::getAddressWithPort(*address_list.front(), port);
+          // The first address of the other IP version, if any, is the happy eyeballs fallback.
+          Network::Address::InstanceConstSharedPtr new_fallback_address;
+          for (const auto& address : address_list) {
+            if (address->ip()->version() != new_address->ip()->version()) {
+              new_fallback_address = Network::Utility::getAddressWithPort(*address, port);
+              break;
+            }
+          }
+          if (!current_resolved_address_ || !(*new_address == *current_resolved_address_) ||
+              (current_fallback_address_ == nullptr) != (new_fallback_address == nullptr) ||
+              (new_fallback_address && !(*new_fallback_address == *current_fallback_address_))) {
             current_resolved_address_ = new_address;
+            current_fallback_address_ = new_fallback_address;
             // Capture URL to avoid a race with another update.
-            tls_->runOnAllThreads([this, new_address]() -> void {
-              tls_->getTyped<PerThreadCurrentHostData>().current_resolved_address_ = new_address;
+            tls_->runOnAllThreads([this, new_address, new_fallback_address]() -> void {
+              PerThreadCurrentHostData& data = tls_->getTyped<PerThreadCurrentHostData>();
+              data.current_resolved_address_ = new_address;
+              data.current_fallback_address_ = new_fallback_address;
             });
           }
 
@@ -114,7 +148,8 @@ void LogicalDnsCluster::startResolve() {
             ASSERT(priority_set_.hostSetsPerPriority().size() == 1);
             auto& first_host_set = priority_set_.getOrCreateHostSet(0);
             first_host_set.updateHosts(new_hosts, createHealthyHostList(*new_hosts),
-                                       empty_host_lists_, empty_host_lists_, *new_hosts, {});
+                                       empty_host_lists_, empty_host_lists_, nullptr,
+                                       *new_hosts, {});
           }
         }
 
@@ -127,7 +162,15 @@ Upstream::Host::CreateConnectionData
 LogicalDnsCluster::LogicalHost::createConnection(Event::Dispatcher& dispatcher) const {
   PerThreadCurrentHostData& data = parent_.tls_->getTyped<PerThreadCurrentHostData>();
   ASSERT(data.current_resolved_address_);
-  return {HostImpl::createConnection(dispatcher, *parent_.info_, data.current_resolved_address_),
+  Network::ClientConnectionPtr connection =
+      HostImpl::createConnection(dispatcher, *parent_.info_, data.current_resolved_address_);
+  if (data.current_fallback_address_) {
+    const std::chrono::milliseconds delay = parent_.happyEyeballsDelay();
+    if (delay.count() > 0) {
+      connection->setFallbackAddress(data.current_fallback_address_, delay);
+    }
+  }
+  return {std::move(connection),
           HostDescriptionConstSharedPtr{
               new RealHostDescription(data.current_resolved_address_, shared_from_this())}};
 }
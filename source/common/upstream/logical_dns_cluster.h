@@ -25,6 +25,10 @@ namespace Upstream {
  * created that will internally have connections to different backends, while still allowing long
  * connection lengths and keep alive. The cluster type should only be used when an IP address change
  * means that connections using the IP should not drain.
+ *
+ * With the auto DNS lookup family and the upstream.happy_eyeballs_delay_ms.<cluster name> runtime
+ * key set, both IP versions are resolved and connections to an IPv6 address race a connection to
+ * the first IPv4 address, started after that many milliseconds or as soon as the first fails.
  */
 class LogicalDnsCluster : public ClusterImplBase {
 public:
@@ -38,6 +42,11 @@ public:
   // Upstream::Cluster
   InitializePhase initializePhase() const override { return InitializePhase::Primary; }
 
+  // Bounds of the delay before racing a connection to the fallback address, following the
+  // connection attempt delay of RFC 8305.
+  static const uint64_t MIN_HAPPY_EYEBALLS_DELAY_MS = 10;
+  static const uint64_t MAX_HAPPY_EYEBALLS_DELAY_MS = 2000;
+
 private:
   struct LogicalHost : public HostImpl {
     LogicalHost(ClusterInfoConstSharedPtr cluster, const std::string& hostname,
@@ -66,6 +75,9 @@ private:
     HealthCheckHostMonitor& healthChecker() const override {
       return logical_host_->healthChecker();
     }
+    LatencyEstimator& latencyEstimator() const override {
+      return logical_host_->latencyEstimator();
+    }
     Outlier::DetectorHostMonitor& outlierDetector() const override {
       return logical_host_->outlierDetector();
     }
@@ -82,9 +94,11 @@ private:
 
   struct PerThreadCurrentHostData : public ThreadLocal::ThreadLocalObject {
     Network::Address::InstanceConstSharedPtr current_resolved_address_;
+    Network::Address::InstanceConstSharedPtr current_fallback_address_;
   };
 
   void startResolve();
+  std::chrono::milliseconds happyEyeballsDelay() const;
 
   // ClusterImplBase
   void startPreInit() override;
@@ -97,6 +111,8 @@ private:
   std::string dns_url_;
   std::string hostname_;
   Network::Address::InstanceConstSharedPtr current_resolved_address_;
+  Network::Address::InstanceConstSharedPtr current_fallback_address_;
+  const std::string happy_eyeballs_delay_runtime_key_;
   HostSharedPtr logical_host_;
   Network::ActiveDnsQuery* active_dns_query_{};
 };
@@ -0,0 +1,110 @@
+#include "common/upstream/maglev_lb.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "common/common/assert.h"
+#include "common/common/hash.h"
+#include "common/upstream/load_balancer_impl.h"
+
+namespace Envoy {
+namespace Upstream {
+
+const uint64_t MaglevLoadBalancer::DEFAULT_TABLE_SIZE;
+
+MaglevLoadBalancer::MaglevLoadBalancer(PrioritySet& priority_set, ClusterStats& stats,
+                                       Runtime::Loader& runtime, Runtime::RandomGenerator& random,
+                                       uint64_t table_size)
+    : host_set_(*priority_set.hostSetsPerPriority()[0]), stats_(stats), runtime_(runtime),
+      random_(random), table_size_(table_size) {
+  host_set_.addMemberUpdateCb([this](uint32_t, const std::vector<HostSharedPtr>&,
+                                     const std::vector<HostSharedPtr>&) -> void { refresh(); });
+
+  refresh();
+}
+
+HostConstSharedPtr MaglevLoadBalancer::chooseHost(LoadBalancerContext* context) {
+  if (LoadBalancerUtility::isGlobalPanic(host_set_, runtime_)) {
+    stats_.lb_healthy_panic_.inc();
+    return chooseHostFromTable(context, all_hosts_table_);
+  } else {
+    return chooseHostFromTable(context, healthy_hosts_table_);
+  }
+}
+
+HostConstSharedPtr MaglevLoadBalancer::chooseHostFromTable(LoadBalancerContext* context,
+                                                           const TableConstSharedPtr& table) {
+  if (table->size() == 0) {
+    return nullptr;
+  }
+
+  // If there is no hash in the context, just choose a random value (this effectively becomes
+  // the random LB but it won't crash if someone configures it this way).
+  // computeHashKey() may be computed on demand, so get it only once.
+  Optional<uint64_t> hash;
+  if (context) {
+    hash = context->computeHashKey();
+  }
+  return table->chooseHost(hash.valid() ? hash.value() : random_.random());
+}
+
+void MaglevLoadBalancer::refresh() {
+  all_hosts_table_ = std::make_shared<Table>(host_set_.hosts(), table_size_);
+  healthy_hosts_table_ = std::make_shared<Table>(host_set_.healthyHosts(), table_size_);
+}
+
+MaglevLoadBalancer::Table::Table(const std::vector<HostSharedPtr>& hosts, uint64_t table_size) {
+  ASSERT(table_size > 1);
+  if (hosts.empty()) {
+    return;
+  }
+
+  // Fill the table in address order so that the table only depends on the set of hosts, and not on
+  // the order in which they were discovered. Every Envoy with the same hosts builds the same table.
+  host_table_.assign(hosts.begin(), hosts.end());
+  std::sort(host_table_.begin(), host_table_.end(),
+            [](const HostConstSharedPtr& lhs, const HostConstSharedPtr& rhs) -> bool {
+              return lhs->address()->asString() < rhs->address()->asString();
+            });
+
+  // The permutation of a host is offset, offset + skip, offset + 2 * skip, ... modulo the table
+  // size. Since the table size is prime and skip is non-zero, this visits every slot.
+  std::vector<uint64_t> next(host_table_.size());
+  std::vector<uint64_t> skip(host_table_.size());
+  for (size_t i = 0; i < host_table_.size(); i++) {
+    const std::string& address = host_table_[i]->address()->asString();
+    next[i] = HashUtil::xxHash64(address) % table_size;
+    skip[i] = HashUtil::xxHash64(address, 1) % (table_size - 1) + 1;
+  }
+
+  // Hosts take turns claiming the next unclaimed slot of their permutation until the table is full.
+  const uint32_t unclaimed = std::numeric_limits<uint32_t>::max();
+  table_.assign(table_size, unclaimed);
+  uint64_t claimed = 0;
+  while (claimed < table_size) {
+    for (uint32_t i = 0; i < host_table_.size() && claimed < table_size; i++) {
+      while (table_[next[i]] != unclaimed) {
+        next[i] = (next[i] + skip[i]) % table_size;
+      }
+      table_[next[i]] = i;
+      next[i] = (next[i] + skip[i]) % table_size;
+      claimed++;
+    }
+  }
+
+  ENVOY_LOG(debug, "maglev: table_size={} hosts={}", table_size, host_table_.size());
+}
+
+HostConstSharedPtr MaglevLoadBalancer::Table::chooseHost(uint64_t hash) const {
+  if (table_.empty()) {
+    return nullptr;
+  }
+
+  return host_table_[table_[hash % table_.size()]];
+}
+
+} // namespace Upstream
+} // namespace Envoy
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "envoy/runtime/runtime.h"
+#include "envoy/upstream/load_balancer.h"
+
+#include "common/common/logger.h"
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * A consistent hashing load balancer that implements Maglev hashing as described in
+ * https://research.google.com/pubs/pub44824.html. Each host fills slots of a fixed size lookup
+ * table, whose size is prime, in the order given by a host specific permutation of the table.
+ * Looking up a hash is then a single table access, rather than a binary search over a ketama ring,
+ * and the table is considerably smaller than a ring of comparable balance. When hosts are added or
+ * removed, most of the table entries are unaffected. Like the ring hash load balancer, a table is
+ * kept for all hosts as well as a table for healthy hosts, and unless we are in panic mode the
+ * healthy host table is used. Only priority 0 is used and zone aware routing is not supported.
+ */
+class MaglevLoadBalancer : public LoadBalancer, Logger::Loggable<Logger::Id::upstream> {
+public:
+  MaglevLoadBalancer(PrioritySet& priority_set, ClusterStats& stats, Runtime::Loader& runtime,
+                     Runtime::RandomGenerator& random, uint64_t table_size = DEFAULT_TABLE_SIZE);
+
+  // Upstream::LoadBalancer
+  HostConstSharedPtr chooseHost(LoadBalancerContext* context) override;
+
+  // Default lookup table size. The table size must be prime, and should be considerably larger
+  // than the number of hosts for even balance. This is the same default as the Maglev paper.
+  static const uint64_t DEFAULT_TABLE_SIZE = 65537;
+
+  class Table;
+  typedef std::shared_ptr<const Table> TableConstSharedPtr;
+
+  /**
+   * An immutable Maglev lookup table. Each entry is an index into a table of distinct hosts.
+   */
+  class Table : Logger::Loggable<Logger::Id::upstream> {
+  public:
+    /**
+     * Build a lookup table.
+     * @param hosts supplies the hosts to fill the table with.
+     * @param table_size supplies the size of the table, which must be prime.
+     */
+    Table(const std::vector<HostSharedPtr>& hosts, uint64_t table_size);
+
+    /**
+     * @param hash supplies the hash to look up.
+     * @return the host owning the table entry for the hash. nullptr if there are no hosts.
+     */
+    HostConstSharedPtr chooseHost(uint64_t hash) const;
+
+    /**
+     * @return size_t the number of entries in the table. 0 if there are no hosts.
+     */
+    size_t size() const { return table_.size(); }
+
+  private:
+    std::vector<uint32_t> table_;
+    std::vector<HostConstSharedPtr> host_table_;
+  };
+
+private:
+  HostConstSharedPtr chooseHostFromTable(LoadBalancerContext* context,
+                                         const TableConstSharedPtr& table);
+  void refresh();
+
+  HostSet& host_set_;
+  ClusterStats& stats_;
+  Runtime::Loader& runtime_;
+  Runtime::RandomGenerator& random_;
+  const uint64_t table_size_;
+  TableConstSharedPtr all_hosts_table_;
+  TableConstSharedPtr healthy_hosts_table_;
+};
+
+} // namespace Upstream
+} // namespace Envoy
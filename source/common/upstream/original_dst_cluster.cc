@@ -99,19 +99,34 @@ OriginalDstCluster::OriginalDstCluster(const envoy::api::v2::Cluster& config,
                       added_via_api),
       dispatcher_(dispatcher), cleanup_interval_ms_(std::chrono::milliseconds(
                                    PROTOBUF_GET_MS_OR_DEFAULT(config, cleanup_interval, 5000))),
-      cleanup_timer_(dispatcher.createTimer([this]() -> void { cleanup(); })) {
+      cleanup_timer_(dispatcher.createTimer([this]() -> void { cleanup(); })),
+      add_hosts_timer_(dispatcher.createTimer([this]() -> void { addPendingHosts(); })) {
 
   cleanup_timer_->enableTimer(cleanup_interval_ms_);
 }
 
 void OriginalDstCluster::addHost(HostSharedPtr& host) {
+  // Hosts posted by the workers in the same event loop iteration are added together, as every
+  // update copies the host list and is posted to all of the workers.
+  if (pending_hosts_.empty()) {
+    add_hosts_timer_->enableTimer(std::chrono::milliseconds(0));
+  }
+  pending_hosts_.emplace_back(std::move(host));
+}
+
+void OriginalDstCluster::addPendingHosts() {
   // Given the current config, only EDS clusters support multiple priorities.
   ASSERT(priority_set_.hostSetsPerPriority().size() == 1);
   auto& first_host_set = priority_set_.getOrCreateHostSet(0);
-  HostVectorSharedPtr new_hosts(new std::vector<HostSharedPtr>(first_host_set.hosts()));
-  new_hosts->emplace_back(host);
+  HostVectorSharedPtr new_hosts(new std::vector<HostSharedPtr>());
+  new_hosts->reserve(first_host_set.hosts().size() + pending_hosts_.size());
+  new_hosts->insert(new_hosts->end(), first_host_set.hosts().begin(),
+                    first_host_set.hosts().end());
+  new_hosts->insert(new_hosts->end(), pending_hosts_.begin(), pending_hosts_.end());
+  std::vector<HostSharedPtr> hosts_added;
+  hosts_added.swap(pending_hosts_);
   first_host_set.updateHosts(new_hosts, createHealthyHostList(*new_hosts), empty_host_lists_,
-                             empty_host_lists_, {std::move(host)}, {});
+                             empty_host_lists_, nullptr, hosts_added, {});
 }
 
 void OriginalDstCluster::cleanup() {
@@ -120,6 +135,7 @@ void OriginalDstCluster::cleanup() {
   // Given the current config, only EDS clusters support multiple priorities.
   ASSERT(priority_set_.hostSetsPerPriority().size() == 1);
   auto& host_set = priority_set_.getOrCreateHostSet(0);
+  new_hosts->reserve(host_set.hosts().size());
 
   ENVOY_LOG(debug, "Cleaning up stale original dst hosts.");
   for (const HostSharedPtr& host : host_set.hosts()) {
@@ -135,7 +151,7 @@ void OriginalDstCluster::cleanup() {
 
   if (to_be_removed.size() > 0) {
     host_set.updateHosts(new_hosts, createHealthyHostList(*new_hosts), empty_host_lists_,
-                         empty_host_lists_, {}, to_be_removed);
+                         empty_host_lists_, nullptr, {}, to_be_removed);
   }
 
   cleanup_timer_->enableTimer(cleanup_interval_ms_);
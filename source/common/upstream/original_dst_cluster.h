@@ -4,6 +4,7 @@
 #include <functional>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "envoy/thread_local/thread_local.h"
 
@@ -18,7 +19,8 @@ namespace Upstream {
  * The OriginalDstCluster is a dynamic cluster that automatically adds hosts as needed based on the
  * original destination address of the downstream connection. These hosts are also automatically
  * cleaned up after they have not seen traffic for a configurable cleanup interval time
- * ("cleanup_interval_ms").
+ * ("cleanup_interval_ms"). Hosts created by the workers are added to the cluster in batches, so
+ * that a burst of new destinations costs a single host set update rather than one per destination.
  */
 class OriginalDstCluster : public ClusterImplBase {
 public:
@@ -99,6 +101,7 @@ public:
 
 private:
   void addHost(HostSharedPtr&);
+  void addPendingHosts();
   void cleanup();
 
   // ClusterImplBase
@@ -107,6 +110,8 @@ private:
   Event::Dispatcher& dispatcher_;
   const std::chrono::milliseconds cleanup_interval_ms_;
   Event::TimerPtr cleanup_timer_;
+  Event::TimerPtr add_hosts_timer_;
+  std::vector<HostSharedPtr> pending_hosts_;
 };
 
 } // namespace Upstream
@@ -1,6 +1,8 @@
 #include "common/upstream/outlier_detection_impl.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -13,6 +15,7 @@
 #include "common/common/utility.h"
 #include "common/http/codes.h"
 #include "common/protobuf/utility.h"
+#include "common/runtime/key_registry.h"
 
 #include "fmt/format.h"
 
@@ -20,6 +23,12 @@ namespace Envoy {
 namespace Upstream {
 namespace Outlier {
 
+// Checked on every 5xx response, so resolved up front.
+static const Runtime::Key RuntimeConsecutiveGatewayFailure =
+    Runtime::KeyRegistry::registerKey("outlier_detection.consecutive_gateway_failure");
+static const Runtime::Key RuntimeConsecutive5xx =
+    Runtime::KeyRegistry::registerKey("outlier_detection.consecutive_5xx");
+
 DetectorSharedPtr DetectorImplFactory::createForCluster(
     Cluster& cluster, const envoy::api::v2::Cluster& cluster_config, Event::Dispatcher& dispatcher,
     Runtime::Loader& runtime, EventLoggerSharedPtr event_logger) {
@@ -40,6 +49,9 @@ void DetectorHostMonitorImpl::eject(MonotonicTime ejection_time) {
 
 void DetectorHostMonitorImpl::uneject(MonotonicTime unejection_time) {
   last_unejection_time_.value(unejection_time);
+  // Start the moving average over so that the host is judged on the responses it gives after it
+  // has been brought back in.
+  response_time_ = -1;
 }
 
 void DetectorHostMonitorImpl::updateCurrentSuccessRateBucket() {
@@ -55,9 +67,9 @@ void DetectorHostMonitorImpl::putHttpResponseCode(uint64_t response_code) {
       return;
     }
     if (Http::CodeUtility::isGatewayError(response_code)) {
-      if (++consecutive_gateway_failure_ == detector->runtime().snapshot().getInteger(
-                                                "outlier_detection.consecutive_gateway_failure",
-                                                detector->config().consecutiveGatewayFailure())) {
+      if (++consecutive_gateway_failure_ ==
+          detector->runtime().snapshot().getInteger(
+              RuntimeConsecutiveGatewayFailure, detector->config().consecutiveGatewayFailure())) {
         detector->onConsecutiveGatewayFailure(host_.lock());
       }
     } else {
@@ -65,7 +77,7 @@ void DetectorHostMonitorImpl::putHttpResponseCode(uint64_t response_code) {
     }
 
     if (++consecutive_5xx_ ==
-        detector->runtime().snapshot().getInteger("outlier_detection.consecutive_5xx",
+        detector->runtime().snapshot().getInteger(RuntimeConsecutive5xx,
                                                   detector->config().consecutive5xx())) {
       detector->onConsecutive5xx(host_.lock());
     }
@@ -76,6 +88,20 @@ void DetectorHostMonitorImpl::putHttpResponseCode(uint64_t response_code) {
   }
 }
 
+void DetectorHostMonitorImpl::putResponseTime(std::chrono::milliseconds response_time) {
+  SuccessRateAccumulatorBucket* bucket = success_rate_accumulator_bucket_.load();
+  bucket->response_time_counter_++;
+  bucket->total_response_time_ms_ += response_time.count();
+}
+
+void DetectorHostMonitorImpl::updateResponseTime(double response_time, double weight) {
+  if (response_time_ < 0) {
+    response_time_ = response_time;
+  } else {
+    response_time_ = weight * response_time + (1 - weight) * response_time_;
+  }
+}
+
 void DetectorHostMonitorImpl::putResult(Result result) {
   Http::Code http_code = Http::Code::InternalServerError;
 
@@ -130,8 +156,8 @@ DetectorImpl::DetectorImpl(const Cluster& cluster,
     : config_(config), dispatcher_(dispatcher), runtime_(runtime), time_source_(time_source),
       stats_(generateStats(cluster.info()->statsScope())),
       interval_timer_(dispatcher.createTimer([this]() -> void { onIntervalTimer(); })),
-      event_logger_(event_logger), success_rate_average_(-1), success_rate_ejection_threshold_(-1) {
-}
+      event_logger_(event_logger), success_rate_average_(-1), success_rate_ejection_threshold_(-1),
+      response_time_average_(-1) {}
 
 DetectorImpl::~DetectorImpl() {
   for (auto host : host_monitors_) {
@@ -198,6 +224,7 @@ void DetectorImpl::checkHostForUneject(HostSharedPtr host, DetectorHostMonitorIm
     return;
   }
 
+  ASSERT(host_monitors_[host] == monitor);
   std::chrono::milliseconds base_eject_time =
       std::chrono::milliseconds(runtime_.snapshot().getInteger(
           "outlier_detection.base_ejection_time_ms", config_.baseEjectionTimeMs()));
@@ -207,9 +234,10 @@ void DetectorImpl::checkHostForUneject(HostSharedPtr host, DetectorHostMonitorIm
     host->healthFlagClear(Host::HealthFlag::FAILED_OUTLIER_CHECK);
     // Reset the consecutive failure counters to avoid re-ejection on very few new errors due
     // to the non-triggering counter being close to its trigger value.
-    host_monitors_[host]->resetConsecutive5xx();
-    host_monitors_[host]->resetConsecutiveGatewayFailure();
+    monitor->resetConsecutive5xx();
+    monitor->resetConsecutiveGatewayFailure();
     monitor->uneject(now);
+    host->slowStartTime(now);
     runCallbacks(host);
 
     if (event_logger_) {
@@ -230,6 +258,8 @@ bool DetectorImpl::enforceEjection(EjectionType type) {
   case EjectionType::SuccessRate:
     return runtime_.snapshot().featureEnabled("outlier_detection.enforcing_success_rate",
                                               config_.enforcingSuccessRate());
+  case EjectionType::SlowResponse:
+    return runtime_.snapshot().featureEnabled("outlier_detection.enforcing_slow_response", 0);
   }
 
   NOT_REACHED;
@@ -247,6 +277,9 @@ void DetectorImpl::updateEnforcedEjectionStats(EjectionType type) {
   case EjectionType::ConsecutiveGatewayFailure:
     stats_.ejections_enforced_consecutive_gateway_failure_.inc();
     break;
+  case EjectionType::SlowResponse:
+    stats_.ejections_enforced_slow_response_.inc();
+    break;
   }
 }
 
@@ -340,6 +373,7 @@ void DetectorImpl::onConsecutiveErrorWorker(HostSharedPtr host, EjectionType typ
     host_monitors_[host]->resetConsecutiveGatewayFailure();
     break;
   case EjectionType::SuccessRate:
+  case EjectionType::SlowResponse:
     NOT_REACHED;
   }
 }
@@ -362,60 +396,45 @@ Utility::EjectionPair Utility::successRateEjectionThreshold(
   // variance = 400
   // stdev = 20
   // threshold returned = 52
-  double mean = success_rate_sum / valid_success_rate_hosts.size();
-  double variance = 0;
-  std::for_each(valid_success_rate_hosts.begin(), valid_success_rate_hosts.end(),
-                [&variance, mean](HostSuccessRatePair v) {
-                  variance += std::pow(v.success_rate_ - mean, 2);
-                });
-  variance /= valid_success_rate_hosts.size();
+  double success_rate_square_sum = 0;
+  for (const HostSuccessRatePair& v : valid_success_rate_hosts) {
+    success_rate_square_sum += v.success_rate_ * v.success_rate_;
+  }
+
+  return successRateEjectionThreshold(success_rate_sum, success_rate_square_sum,
+                                      valid_success_rate_hosts.size(), success_rate_stdev_factor);
+}
+
+Utility::EjectionPair Utility::successRateEjectionThreshold(double success_rate_sum,
+                                                            double success_rate_square_sum,
+                                                            size_t num_hosts,
+                                                            double success_rate_stdev_factor) {
+  // The variance is the mean of the squares minus the square of the mean, so it doesn't need a
+  // second pass over the data. Success rates are bounded by 100 so the cancellation error is
+  // negligible, but rounding can still make the difference slightly negative.
+  double mean = success_rate_sum / num_hosts;
+  double variance = std::max(0.0, success_rate_square_sum / num_hosts - mean * mean);
   double stdev = std::sqrt(variance);
 
   return {mean, (mean - (success_rate_stdev_factor * stdev))};
 }
 
-void DetectorImpl::processSuccessRateEjections() {
-  uint64_t success_rate_minimum_hosts = runtime_.snapshot().getInteger(
-      "outlier_detection.success_rate_minimum_hosts", config_.successRateMinimumHosts());
-  uint64_t success_rate_request_volume = runtime_.snapshot().getInteger(
-      "outlier_detection.success_rate_request_volume", config_.successRateRequestVolume());
-  std::vector<HostSuccessRatePair> valid_success_rate_hosts;
-  double success_rate_sum = 0;
-
+void DetectorImpl::processSuccessRateEjections(
+    const std::vector<HostSuccessRatePair>& valid_success_rate_hosts, double success_rate_sum,
+    double success_rate_square_sum, uint64_t success_rate_minimum_hosts) {
   // Reset the Detector's success rate mean and stdev.
   success_rate_average_ = -1;
   success_rate_ejection_threshold_ = -1;
 
-  // Exit early if there are not enough hosts.
-  if (host_monitors_.size() < success_rate_minimum_hosts) {
-    return;
-  }
-
-  // reserve upper bound of vector size to avoid reallocation.
-  valid_success_rate_hosts.reserve(host_monitors_.size());
-
-  for (const auto& host : host_monitors_) {
-    // Don't do work if the host is already ejected.
-    if (!host.first->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK)) {
-      Optional<double> host_success_rate =
-          host.second->successRateAccumulator().getSuccessRate(success_rate_request_volume);
-
-      if (host_success_rate.valid()) {
-        valid_success_rate_hosts.emplace_back(
-            HostSuccessRatePair(host.first, host_success_rate.value()));
-        success_rate_sum += host_success_rate.value();
-        host.second->successRate(host_success_rate.value());
-      }
-    }
-  }
-
-  if (valid_success_rate_hosts.size() >= success_rate_minimum_hosts) {
+  if (!valid_success_rate_hosts.empty() &&
+      valid_success_rate_hosts.size() >= success_rate_minimum_hosts) {
     double success_rate_stdev_factor =
         runtime_.snapshot().getInteger("outlier_detection.success_rate_stdev_factor",
                                        config_.successRateStdevFactor()) /
         1000.0;
     Utility::EjectionPair ejection_pair = Utility::successRateEjectionThreshold(
-        success_rate_sum, valid_success_rate_hosts, success_rate_stdev_factor);
+        success_rate_sum, success_rate_square_sum, valid_success_rate_hosts.size(),
+        success_rate_stdev_factor);
     success_rate_average_ = ejection_pair.success_rate_average_;
     success_rate_ejection_threshold_ = ejection_pair.ejection_threshold_;
     for (const auto& host_success_rate_pair : valid_success_rate_hosts) {
@@ -428,20 +447,99 @@ void DetectorImpl::processSuccessRateEjections() {
   }
 }
 
+void DetectorImpl::processSlowResponseEjections(
+    const std::vector<HostResponseTimePair>& valid_response_time_hosts, double response_time_sum,
+    uint64_t success_rate_minimum_hosts) {
+  response_time_average_ = -1;
+
+  if (valid_response_time_hosts.empty() ||
+      valid_response_time_hosts.size() < success_rate_minimum_hosts) {
+    return;
+  }
+
+  // A host is slow if its moving average response time is more than a factor (in thousandths) of
+  // the average across the cluster.
+  response_time_average_ = response_time_sum / valid_response_time_hosts.size();
+  const double slow_response_threshold =
+      response_time_average_ *
+      runtime_.snapshot().getInteger("outlier_detection.slow_response_factor", 3000) / 1000.0;
+  for (const auto& host_response_time_pair : valid_response_time_hosts) {
+    // The host may have just been ejected for its success rate.
+    if (host_response_time_pair.response_time_ > slow_response_threshold &&
+        !host_response_time_pair.host_->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK)) {
+      stats_.ejections_detected_slow_response_.inc();
+      ejectHost(host_response_time_pair.host_, EjectionType::SlowResponse);
+    }
+  }
+}
+
 void DetectorImpl::onIntervalTimer() {
   MonotonicTime now = time_source_.currentTime();
+  const uint64_t success_rate_minimum_hosts = runtime_.snapshot().getInteger(
+      "outlier_detection.success_rate_minimum_hosts", config_.successRateMinimumHosts());
+  const uint64_t success_rate_request_volume = runtime_.snapshot().getInteger(
+      "outlier_detection.success_rate_request_volume", config_.successRateRequestVolume());
+  const double response_time_weight =
+      std::min<uint64_t>(100, runtime_.snapshot().getInteger(
+                                  "outlier_detection.response_time_weight", 30)) /
+      100.0;
+  // Don't do work if there are not enough hosts.
+  const bool enough_hosts = host_monitors_.size() >= success_rate_minimum_hosts;
+
+  // The statistics are accumulated as the hosts are visited, so that the interval does a constant
+  // amount of work per host in a single pass over them.
+  std::vector<HostSuccessRatePair> valid_success_rate_hosts;
+  std::vector<HostResponseTimePair> valid_response_time_hosts;
+  double success_rate_sum = 0;
+  double success_rate_square_sum = 0;
+  double response_time_sum = 0;
+  if (enough_hosts) {
+    // reserve upper bound of vector size to avoid reallocation.
+    valid_success_rate_hosts.reserve(host_monitors_.size());
+    valid_response_time_hosts.reserve(host_monitors_.size());
+  }
 
-  for (auto host : host_monitors_) {
-    checkHostForUneject(host.first, host.second, now);
+  for (const auto& host : host_monitors_) {
+    DetectorHostMonitorImpl* monitor = host.second;
+    checkHostForUneject(host.first, monitor, now);
 
     // Need to update the writer bucket to keep the data valid.
-    host.second->updateCurrentSuccessRateBucket();
+    monitor->updateCurrentSuccessRateBucket();
     // Refresh host success rate stat for the /clusters endpoint. If there is a new valid value, it
-    // will get updated in processSuccessRateEjections().
-    host.second->successRate(-1);
+    // gets updated below.
+    monitor->successRate(-1);
+
+    // Don't do work if the host is already ejected.
+    if (!enough_hosts || host.first->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK)) {
+      continue;
+    }
+
+    Optional<double> host_success_rate =
+        monitor->successRateAccumulator().getSuccessRate(success_rate_request_volume);
+    if (host_success_rate.valid()) {
+      valid_success_rate_hosts.emplace_back(
+          HostSuccessRatePair(host.first, host_success_rate.value()));
+      success_rate_sum += host_success_rate.value();
+      success_rate_square_sum += host_success_rate.value() * host_success_rate.value();
+      monitor->successRate(host_success_rate.value());
+    }
+
+    Optional<double> host_response_time =
+        monitor->successRateAccumulator().getResponseTime(success_rate_request_volume);
+    if (host_response_time.valid()) {
+      monitor->updateResponseTime(host_response_time.value(), response_time_weight);
+    }
+    if (monitor->responseTime() >= 0) {
+      valid_response_time_hosts.emplace_back(
+          HostResponseTimePair(host.first, monitor->responseTime()));
+      response_time_sum += monitor->responseTime();
+    }
   }
 
-  processSuccessRateEjections();
+  processSuccessRateEjections(valid_success_rate_hosts, success_rate_sum, success_rate_square_sum,
+                              success_rate_minimum_hosts);
+  processSlowResponseEjections(valid_response_time_hosts, response_time_sum,
+                               success_rate_minimum_hosts);
 
   armIntervalTimer();
 }
@@ -489,6 +587,7 @@ void EventLoggerImpl::logEject(HostDescriptionConstSharedPtr host, Detector& det
   switch (type) {
   case EjectionType::Consecutive5xx:
   case EjectionType::ConsecutiveGatewayFailure:
+  case EjectionType::SlowResponse:
     file_->write(fmt::format(
         json_5xx, AccessLogDateTimeFormatter::fromTime(now),
         secsSinceLastAction(host->outlierDetector().lastUnejectionTime(), monotonic_now),
@@ -535,6 +634,8 @@ std::string EventLoggerImpl::typeToString(EjectionType type) {
     return "GatewayFailure";
   case EjectionType::SuccessRate:
     return "SuccessRate";
+  case EjectionType::SlowResponse:
+    return "SlowResponse";
   }
 
   NOT_REACHED;
@@ -552,6 +653,8 @@ SuccessRateAccumulatorBucket* SuccessRateAccumulator::updateCurrentWriter() {
   // Right now current is being written to and backup is not. Flush the backup and swap.
   backup_success_rate_bucket_->success_request_counter_ = 0;
   backup_success_rate_bucket_->total_request_counter_ = 0;
+  backup_success_rate_bucket_->response_time_counter_ = 0;
+  backup_success_rate_bucket_->total_response_time_ms_ = 0;
 
   current_success_rate_bucket_.swap(backup_success_rate_bucket_);
 
@@ -567,6 +670,16 @@ Optional<double> SuccessRateAccumulator::getSuccessRate(uint64_t success_rate_re
                           backup_success_rate_bucket_->total_request_counter_);
 }
 
+Optional<double> SuccessRateAccumulator::getResponseTime(uint64_t request_volume) {
+  if (backup_success_rate_bucket_->response_time_counter_ < request_volume ||
+      backup_success_rate_bucket_->response_time_counter_ == 0) {
+    return Optional<double>();
+  }
+
+  return Optional<double>(backup_success_rate_bucket_->total_response_time_ms_ * 1.0 /
+                          backup_success_rate_bucket_->response_time_counter_);
+}
+
 } // namespace Outlier
 } // namespace Upstream
 } // namespace Envoy
@@ -60,9 +60,21 @@ struct HostSuccessRatePair {
   double success_rate_;
 };
 
+/**
+ * Thin struct to facilitate calculations for slow response outlier detection.
+ */
+struct HostResponseTimePair {
+  HostResponseTimePair(HostSharedPtr host, double response_time)
+      : host_(host), response_time_(response_time) {}
+  HostSharedPtr host_;
+  double response_time_;
+};
+
 struct SuccessRateAccumulatorBucket {
   std::atomic<uint64_t> success_request_counter_;
   std::atomic<uint64_t> total_request_counter_;
+  std::atomic<uint64_t> response_time_counter_;
+  std::atomic<uint64_t> total_response_time_ms_;
 };
 
 /**
@@ -92,6 +104,16 @@ public:
    */
   Optional<double> getSuccessRate(uint64_t success_rate_request_volume);
 
+  /**
+   * This function returns the average response time of a host over the same window of time as
+   * getSuccessRate() if enough response times were recorded.
+   * @param request_volume the threshold of response times an accumulator has to have in order to
+   *                       be able to return a significant average.
+   * @return a valid Optional<double> with the average response time in milliseconds. If there
+   *         were not enough response times, an invalid Optional<double> is returned.
+   */
+  Optional<double> getResponseTime(uint64_t request_volume);
+
 private:
   std::unique_ptr<SuccessRateAccumulatorBucket> current_success_rate_bucket_;
   std::unique_ptr<SuccessRateAccumulatorBucket> backup_success_rate_bucket_;
@@ -115,6 +137,18 @@ public:
   void updateCurrentSuccessRateBucket();
   SuccessRateAccumulator& successRateAccumulator() { return success_rate_accumulator_; }
   void successRate(double new_success_rate) { success_rate_ = new_success_rate; }
+  /**
+   * Fold an interval's average response time into the host's exponentially weighted moving
+   * average response time.
+   * @param response_time supplies the average response time of the interval in milliseconds.
+   * @param weight supplies the weight of the new value, in the range 0-1.
+   */
+  void updateResponseTime(double response_time, double weight);
+  /**
+   * @return the moving average response time of the host in milliseconds, or -1 if the host has
+   *         not had enough request volume since it was added or last unejected.
+   */
+  double responseTime() const { return response_time_; }
   void resetConsecutive5xx() { consecutive_5xx_ = 0; }
   void resetConsecutiveGatewayFailure() { consecutive_gateway_failure_ = 0; }
 
@@ -122,7 +156,7 @@ public:
   uint32_t numEjections() override { return num_ejections_; }
   void putHttpResponseCode(uint64_t response_code) override;
   void putResult(Result result) override;
-  void putResponseTime(std::chrono::milliseconds) override {}
+  void putResponseTime(std::chrono::milliseconds response_time) override;
   const Optional<MonotonicTime>& lastEjectionTime() override { return last_ejection_time_; }
   const Optional<MonotonicTime>& lastUnejectionTime() override { return last_unejection_time_; }
   double successRate() const override { return success_rate_; }
@@ -138,6 +172,7 @@ private:
   SuccessRateAccumulator success_rate_accumulator_;
   std::atomic<SuccessRateAccumulatorBucket*> success_rate_accumulator_bucket_;
   double success_rate_;
+  double response_time_{-1};
 };
 
 /**
@@ -156,7 +191,9 @@ private:
   COUNTER(ejections_detected_success_rate)                                                         \
   COUNTER(ejections_enforced_success_rate)                                                         \
   COUNTER(ejections_detected_consecutive_gateway_failure)                                          \
-  COUNTER(ejections_enforced_consecutive_gateway_failure)
+  COUNTER(ejections_enforced_consecutive_gateway_failure)                                         \
+  COUNTER(ejections_detected_slow_response)                                                        \
+  COUNTER(ejections_enforced_slow_response)
 // clang-format on
 
 /**
@@ -222,6 +259,12 @@ public:
   double successRateAverage() const override { return success_rate_average_; }
   double successRateEjectionThreshold() const override { return success_rate_ejection_threshold_; }
 
+  /**
+   * @return the average of the moving average response times of the hosts in the last interval, or
+   *         -1 if there were not enough hosts with enough request volume.
+   */
+  double responseTimeAverage() const { return response_time_average_; }
+
 private:
   DetectorImpl(const Cluster& cluster, const envoy::api::v2::Cluster::OutlierDetection& config,
                Event::Dispatcher& dispatcher, Runtime::Loader& runtime,
@@ -239,7 +282,12 @@ private:
   void runCallbacks(HostSharedPtr host);
   bool enforceEjection(EjectionType type);
   void updateEnforcedEjectionStats(EjectionType type);
-  void processSuccessRateEjections();
+  void processSuccessRateEjections(const std::vector<HostSuccessRatePair>& valid_success_rate_hosts,
+                                   double success_rate_sum, double success_rate_square_sum,
+                                   uint64_t success_rate_minimum_hosts);
+  void
+  processSlowResponseEjections(const std::vector<HostResponseTimePair>& valid_response_time_hosts,
+                               double response_time_sum, uint64_t success_rate_minimum_hosts);
 
   DetectorConfig config_;
   Event::Dispatcher& dispatcher_;
@@ -252,6 +300,7 @@ private:
   EventLoggerSharedPtr event_logger_;
   double success_rate_average_;
   double success_rate_ejection_threshold_;
+  double response_time_average_;
 };
 
 class EventLoggerImpl : public EventLogger {
@@ -298,6 +347,18 @@ public:
   successRateEjectionThreshold(double success_rate_sum,
                                const std::vector<HostSuccessRatePair>& valid_success_rate_hosts,
                                double success_rate_stdev_factor);
+
+  /**
+   * This function returns the same EjectionPair as the function above, from the sum and the sum of
+   * squares of the success rates so that they can be accumulated as the hosts are visited.
+   * @param success_rate_sum is the sum of the success rates.
+   * @param success_rate_square_sum is the sum of the squares of the success rates.
+   * @param num_hosts is the number of success rates that were summed.
+   * @return EjectionPair.
+   */
+  static EjectionPair successRateEjectionThreshold(double success_rate_sum,
+                                                   double success_rate_square_sum, size_t num_hosts,
+                                                   double success_rate_stdev_factor);
 };
 
 } // namespace Outlier
@@ -0,0 +1,59 @@
+#include "common/upstream/resource_manager_impl.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+
+namespace Envoy {
+namespace Upstream {
+
+void ResourceManagerImpl::RequestsImpl::onRequestComplete(std::chrono::microseconds latency) {
+  const uint64_t samples = runtime_.snapshot().getInteger(samples_key_, 0);
+  if (samples == 0) {
+    return;
+  }
+
+  // Requests faster than the clock resolution still count as taking some time, so that the
+  // baseline can't be 0.
+  window_latency_us_ += std::max<int64_t>(1, latency.count());
+  if (++window_requests_ < samples) {
+    return;
+  }
+
+  // Only one thread closes the window. Requests which complete on other threads while it does are
+  // counted in either this window or the next.
+  std::unique_lock<std::mutex> lock(window_lock_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    return;
+  }
+  const uint64_t window_requests = window_requests_.exchange(0);
+  const uint64_t window_latency_us = window_latency_us_.exchange(0);
+  if (window_requests < samples) {
+    // Another thread closed the window between the increment and taking the lock.
+    window_requests_ += window_requests;
+    window_latency_us_ += window_latency_us;
+    return;
+  }
+
+  const double average_latency_us = static_cast<double>(window_latency_us) / window_requests;
+  if (baseline_latency_us_ == 0 || average_latency_us < baseline_latency_us_ ||
+      ++windows_since_baseline_ >= BASELINE_WINDOWS) {
+    baseline_latency_us_ = average_latency_us;
+    windows_since_baseline_ = 0;
+  }
+
+  const double tolerance = 1 + runtime_.snapshot().getInteger(tolerance_key_, 50) / 100.0;
+  const double gradient =
+      std::max(0.5, std::min(2.0, tolerance * baseline_latency_us_ / average_latency_us));
+  const uint64_t max = ResourceImpl::max();
+  const uint64_t current_limit = limit_;
+  const double limit = current_limit == 0 ? max : current_limit;
+  const uint64_t new_limit = static_cast<uint64_t>(limit * gradient + std::sqrt(limit));
+  limit_ = std::max<uint64_t>(std::min(max, new_limit),
+                              runtime_.snapshot().getInteger(min_limit_key_, 3));
+}
+
+} // namespace Upstream
+} // namespace Envoy
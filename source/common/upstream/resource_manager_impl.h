@@ -1,8 +1,11 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 
 #include "envoy/runtime/runtime.h"
@@ -21,6 +24,16 @@ namespace Upstream {
  *    occur during high contention.
  * 2) Though atomics are used, it is possible for resources to temporarily go above the supplied
  *    maximums. This should not effect overall behavior.
+ *
+ * Retries may be limited by a budget instead of an absolute maximum. If the "retry_budget_percent"
+ * runtime key is set, at most that percentage of the active and pending requests may be retries,
+ * and at least "retry_budget_min_concurrency" (default 3) retries are always allowed.
+ *
+ * The maximum number of requests may adapt to the latency of the upstream instead of staying fixed.
+ * If the "adaptive_concurrency_samples" runtime key is set, every that many completed requests the
+ * average latency is compared to the lowest average seen recently, and the limit is scaled by the
+ * ratio of the two. Queueing in the upstream shows up as latency above that baseline, so the limit
+ * shrinks and the excess requests overflow straight away instead of waiting in the queue.
  */
 class ResourceManagerImpl : public ResourceManager {
 public:
@@ -29,14 +42,17 @@ public:
                       uint64_t max_requests, uint64_t max_retries)
       : connections_(max_connections, runtime, runtime_key + "max_connections"),
         pending_requests_(max_pending_requests, runtime, runtime_key + "max_pending_requests"),
-        requests_(max_requests, runtime, runtime_key + "max_requests"),
-        retries_(max_retries, runtime, runtime_key + "max_retries") {}
+        requests_(max_requests, runtime, runtime_key),
+        retries_(max_retries, runtime, runtime_key, requests_, pending_requests_) {}
 
   // Upstream::ResourceManager
   Resource& connections() override { return connections_; }
   Resource& pendingRequests() override { return pending_requests_; }
   Resource& requests() override { return requests_; }
   Resource& retries() override { return retries_; }
+  void onRequestComplete(std::chrono::microseconds latency) override {
+    requests_.onRequestComplete(latency);
+  }
 
 private:
   struct ResourceImpl : public Resource {
@@ -59,10 +75,86 @@ private:
     const std::string runtime_key_;
   };
 
+  /**
+   * Retries, which scale with the load on the cluster when a retry budget is configured. A fixed
+   * maximum is either too tight at peak or too loose at trough, while a budget keeps retries from
+   * multiplying the load on an upstream which is already failing.
+   */
+  struct RetriesImpl : public ResourceImpl {
+    RetriesImpl(uint64_t max, Runtime::Loader& runtime, const std::string& runtime_key,
+                const ResourceImpl& requests, const ResourceImpl& pending_requests)
+        : ResourceImpl(max, runtime, runtime_key + "max_retries"),
+          budget_percent_key_(runtime_key + "retry_budget_percent"),
+          min_concurrency_key_(runtime_key + "retry_budget_min_concurrency"), requests_(requests),
+          pending_requests_(pending_requests) {}
+
+    // Upstream::Resource
+    uint64_t max() override {
+      const uint64_t budget_percent = runtime_.snapshot().getInteger(budget_percent_key_, 0);
+      if (budget_percent == 0) {
+        return ResourceImpl::max();
+      }
+
+      const uint64_t active_requests = requests_.current_ + pending_requests_.current_;
+      return std::max(runtime_.snapshot().getInteger(min_concurrency_key_, 3),
+                      active_requests * budget_percent / 100);
+    }
+
+    const std::string budget_percent_key_;
+    const std::string min_concurrency_key_;
+    const ResourceImpl& requests_;
+    const ResourceImpl& pending_requests_;
+  };
+
+  /**
+   * Requests, whose maximum follows a gradient of the upstream latency when adaptive concurrency
+   * is configured. Each window of "adaptive_concurrency_samples" requests scales the limit by
+   * (1 + "adaptive_concurrency_tolerance_percent" / 100) * baseline / window average, which is
+   * clamped to 0.5-2, and adds the square root of the limit so that it keeps probing for more
+   * concurrency. The baseline is the lowest window average, and is reset every BASELINE_WINDOWS
+   * windows so that it follows an upstream which has become permanently slower. The limit stays
+   * between "adaptive_concurrency_min_limit" (default 3) and "max_requests".
+   */
+  struct RequestsImpl : public ResourceImpl {
+    static const uint64_t BASELINE_WINDOWS = 50;
+
+    RequestsImpl(uint64_t max, Runtime::Loader& runtime, const std::string& runtime_key)
+        : ResourceImpl(max, runtime, runtime_key + "max_requests"),
+          samples_key_(runtime_key + "adaptive_concurrency_samples"),
+          tolerance_key_(runtime_key + "adaptive_concurrency_tolerance_percent"),
+          min_limit_key_(runtime_key + "adaptive_concurrency_min_limit") {}
+
+    // Upstream::Resource
+    uint64_t max() override {
+      const uint64_t max = ResourceImpl::max();
+      const uint64_t limit = limit_;
+      if (limit == 0 || runtime_.snapshot().getInteger(samples_key_, 0) == 0) {
+        return max;
+      }
+      return std::min(max, limit);
+    }
+
+    void onRequestComplete(std::chrono::microseconds latency);
+
+    const std::string samples_key_;
+    const std::string tolerance_key_;
+    const std::string min_limit_key_;
+    // The requests which have completed in the current window, and the sum of their latencies.
+    std::atomic<uint64_t> window_requests_{};
+    std::atomic<uint64_t> window_latency_us_{};
+    // Held by the thread which closes a window. The members below are only used with it held,
+    // except for the limit which is read by max().
+    std::mutex window_lock_;
+    double baseline_latency_us_{};
+    uint64_t windows_since_baseline_{};
+    // 0 until the first window has closed.
+    std::atomic<uint64_t> limit_{};
+  };
+
   ResourceImpl connections_;
   ResourceImpl pending_requests_;
-  ResourceImpl requests_;
-  ResourceImpl retries_;
+  RequestsImpl requests_;
+  RetriesImpl retries_;
 };
 
 typedef std::unique_ptr<ResourceManagerImpl> ResourceManagerImplPtr;
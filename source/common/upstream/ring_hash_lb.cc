@@ -1,7 +1,10 @@
 #include "common/upstream/ring_hash_lb.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <limits>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "common/common/assert.h"
@@ -25,15 +28,15 @@ RingHashLoadBalancer::RingHashLoadBalancer(
 HostConstSharedPtr RingHashLoadBalancer::chooseHost(LoadBalancerContext* context) {
   if (LoadBalancerUtility::isGlobalPanic(host_set_, runtime_)) {
     stats_.lb_healthy_panic_.inc();
-    return all_hosts_ring_.chooseHost(context, random_);
+    return chooseHostFromRing(context, rings_->all_hosts_ring_);
   } else {
-    return healthy_hosts_ring_.chooseHost(context, random_);
+    return chooseHostFromRing(context, rings_->healthy_hosts_ring_);
   }
 }
 
-HostConstSharedPtr RingHashLoadBalancer::Ring::chooseHost(LoadBalancerContext* context,
-                                                          Runtime::RandomGenerator& random) {
-  if (ring_.empty()) {
+HostConstSharedPtr RingHashLoadBalancer::chooseHostFromRing(LoadBalancerContext* context,
+                                                            const RingConstSharedPtr& ring) {
+  if (ring->size() == 0) {
     return nullptr;
   }
 
@@ -44,99 +47,269 @@ HostConstSharedPtr RingHashLoadBalancer::Ring::chooseHost(LoadBalancerContext* c
   if (context) {
     hash = context->computeHashKey();
   }
-  const uint64_t h = hash.valid() ? hash.value() : random.random();
-
-  // Ported from https://github.com/RJ/ketama/blob/master/libketama/ketama.c (ketama_get_server)
-  // I've generally kept the variable names to make the code easier to compare.
-  // NOTE: The algorithm depends on using signed integers for lowp, midp, and highp. Do not
-  //       change them!
-  int64_t lowp = 0;
-  int64_t highp = ring_.size();
-  while (true) {
-    int64_t midp = (lowp + highp) / 2;
+  return ring->chooseHost(hash.valid() ? hash.value() : random_.random());
+}
 
-    if (midp == static_cast<int64_t>(ring_.size())) {
-      return ring_[0].host_;
-    }
+const uint64_t RingHashLoadBalancer::Ring::MIN_BUCKET_INDEX_RING_SIZE;
+const uint32_t RingHashLoadBalancer::Ring::MAX_BUCKET_INDEX_BITS;
 
-    uint64_t midval = ring_[midp].hash_;
-    uint64_t midval1 = midp == 0 ? 0 : ring_[midp - 1].hash_;
+RingHashLoadBalancer::Ring::Ring(const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
+                                 const std::vector<HostSharedPtr>& hosts) {
+  build(config, hosts);
+}
 
-    if (h <= midval && h > midval1) {
-      return ring_[midp].host_;
-    }
+RingHashLoadBalancer::Ring::Ring(const Ring& previous,
+                                 const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
+                                 const std::vector<HostSharedPtr>& hosts) {
+  if (tryIncrementalBuild(previous, config, hosts)) {
+    incrementally_updated_ = true;
+    buildBucketIndex();
+  } else {
+    build(config, hosts);
+  }
+}
 
-    if (midval < h) {
-      lowp = midp + 1;
-    } else {
-      highp = midp - 1;
-    }
+HostConstSharedPtr RingHashLoadBalancer::Ring::chooseHost(uint64_t h) const {
+  if (hashes_.empty()) {
+    return nullptr;
+  }
 
-    if (lowp > highp) {
-      return ring_[0].host_;
-    }
+  // This implements the same selection as ketama_get_server() in
+  // https://github.com/RJ/ketama/blob/master/libketama/ketama.c: the first entry whose hash is
+  // greater than or equal to the hash being looked up, wrapping around to the first entry.
+  auto begin = hashes_.begin();
+  auto end = hashes_.end();
+  if (!bucket_index_.empty()) {
+    const uint64_t bucket = h >> bucket_shift_;
+    begin = hashes_.begin() + bucket_index_[bucket];
+    end = hashes_.begin() + bucket_index_[bucket + 1];
   }
-}
 
-void RingHashLoadBalancer::Ring::create(
-    const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
-    const std::vector<HostSharedPtr>& hosts) {
-  ENVOY_LOG(trace, "ring hash: building ring");
-  ring_.clear();
-  if (hosts.empty()) {
-    return;
+  auto it = std::lower_bound(begin, end, h);
+  if (it == hashes_.end()) {
+    it = hashes_.begin();
   }
+  return host_table_[host_indices_[it - hashes_.begin()]];
+}
 
+uint64_t RingHashLoadBalancer::Ring::hashesPerHost(
+    const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config, size_t num_hosts) {
   // Currently we specify the minimum size of the ring, and determine the replication factor
   // based on the number of hosts. It's possible we might want to support more sophisticated
   // configuration in the future.
-  // NOTE: Currently we keep a ring for healthy hosts and unhealthy hosts, and this is done per
-  //       thread. This is the simplest implementation, but it's expensive from a memory
-  //       standpoint and duplicates the regeneration computation. In the future we might want
-  //       to generate the rings centrally and then just RCU them out to each thread. This is
-  //       sufficient for getting started.
   const uint64_t min_ring_size =
       config.valid() ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.value(), minimum_ring_size, 1024)
                      : 1024;
 
   uint64_t hashes_per_host = 1;
-  if (hosts.size() < min_ring_size) {
-    hashes_per_host = min_ring_size / hosts.size();
-    if ((min_ring_size % hosts.size()) != 0) {
+  if (num_hosts < min_ring_size) {
+    hashes_per_host = min_ring_size / num_hosts;
+    if ((min_ring_size % num_hosts) != 0) {
       hashes_per_host++;
     }
   }
+  return hashes_per_host;
+}
 
-  ENVOY_LOG(info, "ring hash: min_ring_size={} hashes_per_host={}", min_ring_size, hashes_per_host);
-  ring_.reserve(hosts.size() * hashes_per_host);
+bool RingHashLoadBalancer::Ring::useStdHash(
+    const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config) {
+  return config.valid()
+             ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.value().deprecated_v1(), use_std_hash, true)
+             : true;
+}
+
+void RingHashLoadBalancer::Ring::hashHost(
+    const Host& host, uint32_t host_index,
+    std::vector<std::pair<uint64_t, uint32_t>>& entries) const {
+  const std::string& address = host.address()->asString();
+  for (uint64_t i = 0; i < hashes_per_host_; i++) {
+    const std::string hash_key(address + "_" + std::to_string(i));
+    const uint64_t hash =
+        use_std_hash_ ? std::hash<std::string>()(hash_key) : HashUtil::xxHash64(hash_key);
+    ENVOY_LOG(trace, "ring hash: hash_key={} hash={}", hash_key, hash);
+    entries.emplace_back(hash, host_index);
+  }
+}
 
-  const bool use_std_hash =
-      config.valid()
-          ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.value().deprecated_v1(), use_std_hash, true)
-          : true;
+void RingHashLoadBalancer::Ring::build(
+    const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
+    const std::vector<HostSharedPtr>& hosts) {
+  ENVOY_LOG(trace, "ring hash: building ring");
+  hashes_.clear();
+  host_indices_.clear();
+  host_table_.clear();
+  bucket_index_.clear();
+  if (hosts.empty()) {
+    return;
+  }
+
+  hashes_per_host_ = hashesPerHost(config, hosts.size());
+  use_std_hash_ = useStdHash(config);
+  ENVOY_LOG(info, "ring hash: ring_size={} hashes_per_host={}", hosts.size() * hashes_per_host_,
+            hashes_per_host_);
+
+  std::vector<std::pair<uint64_t, uint32_t>> entries;
+  entries.reserve(hosts.size() * hashes_per_host_);
+  host_table_.reserve(hosts.size());
   for (const auto& host : hosts) {
-    for (uint64_t i = 0; i < hashes_per_host; i++) {
-      const std::string hash_key(host->address()->asString() + "_" + std::to_string(i));
-      const uint64_t hash =
-          use_std_hash ? std::hash<std::string>()(hash_key) : HashUtil::xxHash64(hash_key);
-      ENVOY_LOG(trace, "ring hash: hash_key={} hash={}", hash_key, hash);
-      ring_.push_back({hash, host});
-    }
+    hashHost(*host, host_table_.size(), entries);
+    host_table_.push_back(host);
   }
 
-  std::sort(ring_.begin(), ring_.end(), [](const RingEntry& lhs, const RingEntry& rhs) -> bool {
-    return lhs.hash_ < rhs.hash_;
-  });
+  std::sort(entries.begin(), entries.end(),
+            [](const std::pair<uint64_t, uint32_t>& lhs,
+               const std::pair<uint64_t, uint32_t>& rhs) -> bool { return lhs.first < rhs.first; });
+
+  hashes_.reserve(entries.size());
+  host_indices_.reserve(entries.size());
+  for (const auto& entry : entries) {
+    hashes_.push_back(entry.first);
+    host_indices_.push_back(entry.second);
+  }
 #ifndef NVLOG
-  for (auto entry : ring_) {
-    ENVOY_LOG(trace, "ring hash: host={} hash={}", entry.host_->address()->asString(), entry.hash_);
+  for (size_t i = 0; i < hashes_.size(); i++) {
+    ENVOY_LOG(trace, "ring hash: host={} hash={}",
+              host_table_[host_indices_[i]]->address()->asString(), hashes_[i]);
   }
 #endif
+
+  buildBucketIndex();
+}
+
+bool RingHashLoadBalancer::Ring::tryIncrementalBuild(
+    const Ring& previous, const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
+    const std::vector<HostSharedPtr>& hosts) {
+  if (previous.hashes_.empty() || hosts.empty() ||
+      previous.hashes_per_host_ != hashesPerHost(config, hosts.size()) ||
+      previous.use_std_hash_ != useStdHash(config)) {
+    return false;
+  }
+
+  std::unordered_map<const Host*, uint32_t> previous_indices;
+  previous_indices.reserve(previous.host_table_.size());
+  for (uint32_t i = 0; i < previous.host_table_.size(); i++) {
+    previous_indices.emplace(previous.host_table_[i].get(), i);
+  }
+
+  // Map the previous host table onto the new one. Hosts that are kept retain their relative
+  // order, added hosts are appended.
+  static const uint32_t REMOVED = std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> remap(previous.host_table_.size(), REMOVED);
+  std::vector<HostSharedPtr> added;
+  for (const auto& host : hosts) {
+    auto it = previous_indices.find(host.get());
+    if (it == previous_indices.end()) {
+      added.push_back(host);
+    } else {
+      remap[it->second] = 0;
+    }
+  }
+
+  const size_t kept = previous.host_table_.size() - std::count(remap.begin(), remap.end(), REMOVED);
+  const size_t changes = added.size() + (previous.host_table_.size() - kept);
+  // If a large fraction of the ring changes a full rebuild is just as cheap.
+  if (kept + added.size() != hosts.size() || changes * 4 > hosts.size()) {
+    return false;
+  }
+
+  hashes_per_host_ = previous.hashes_per_host_;
+  use_std_hash_ = previous.use_std_hash_;
+  host_table_.reserve(hosts.size());
+  for (uint32_t i = 0; i < previous.host_table_.size(); i++) {
+    if (remap[i] != REMOVED) {
+      remap[i] = host_table_.size();
+      host_table_.push_back(previous.host_table_[i]);
+    }
+  }
+
+  std::vector<std::pair<uint64_t, uint32_t>> added_entries;
+  added_entries.reserve(added.size() * hashes_per_host_);
+  for (const auto& host : added) {
+    hashHost(*host, host_table_.size(), added_entries);
+    host_table_.push_back(host);
+  }
+  std::sort(added_entries.begin(), added_entries.end(),
+            [](const std::pair<uint64_t, uint32_t>& lhs,
+               const std::pair<uint64_t, uint32_t>& rhs) -> bool { return lhs.first < rhs.first; });
+
+  // Merge the surviving entries of the previous ring with the new entries, both already sorted.
+  const size_t ring_size = hosts.size() * hashes_per_host_;
+  hashes_.reserve(ring_size);
+  host_indices_.reserve(ring_size);
+  auto added_it = added_entries.begin();
+  for (size_t i = 0; i < previous.hashes_.size(); i++) {
+    const uint32_t host_index = remap[previous.host_indices_[i]];
+    if (host_index == REMOVED) {
+      continue;
+    }
+    while (added_it != added_entries.end() && added_it->first < previous.hashes_[i]) {
+      hashes_.push_back(added_it->first);
+      host_indices_.push_back(added_it->second);
+      ++added_it;
+    }
+    hashes_.push_back(previous.hashes_[i]);
+    host_indices_.push_back(host_index);
+  }
+  for (; added_it != added_entries.end(); ++added_it) {
+    hashes_.push_back(added_it->first);
+    host_indices_.push_back(added_it->second);
+  }
+
+  ASSERT(hashes_.size() == ring_size);
+  ENVOY_LOG(debug, "ring hash: incrementally updated ring, {} hosts added, {} hosts removed",
+            added.size(), previous.host_table_.size() - kept);
+  return true;
+}
+
+void RingHashLoadBalancer::Ring::buildBucketIndex() {
+  bucket_index_.clear();
+  if (hashes_.size() < MIN_BUCKET_INDEX_RING_SIZE) {
+    return;
+  }
+
+  // Use roughly one bucket per ring entry, so that each bucket contains O(1) entries on average.
+  uint32_t bits = 1;
+  while (bits < MAX_BUCKET_INDEX_BITS && (2ULL << bits) <= hashes_.size()) {
+    bits++;
+  }
+  bucket_shift_ = 64 - bits;
+
+  const uint64_t num_buckets = 1ULL << bits;
+  bucket_index_.reserve(num_buckets + 1);
+  size_t entry = 0;
+  for (uint64_t bucket = 0; bucket < num_buckets; bucket++) {
+    const uint64_t bucket_start = bucket << bucket_shift_;
+    while (entry < hashes_.size() && hashes_[entry] < bucket_start) {
+      entry++;
+    }
+    bucket_index_.push_back(entry);
+  }
+  bucket_index_.push_back(hashes_.size());
+}
+
+RingHashLoadBalancer::SharedRingsConstSharedPtr RingHashLoadBalancer::buildRings(
+    const HostSet& host_set, const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
+    const SharedRingsConstSharedPtr& previous) {
+  std::shared_ptr<SharedRings> rings = std::make_shared<SharedRings>();
+  if (previous == nullptr) {
+    rings->all_hosts_ring_ = std::make_shared<Ring>(config, host_set.hosts());
+    rings->healthy_hosts_ring_ = std::make_shared<Ring>(config, host_set.healthyHosts());
+  } else {
+    rings->all_hosts_ring_ =
+        std::make_shared<Ring>(*previous->all_hosts_ring_, config, host_set.hosts());
+    rings->healthy_hosts_ring_ =
+        std::make_shared<Ring>(*previous->healthy_hosts_ring_, config, host_set.healthyHosts());
+  }
+  return rings;
 }
 
 void RingHashLoadBalancer::refresh() {
-  all_hosts_ring_.create(config_, host_set_.hosts());
-  healthy_hosts_ring_.create(config_, host_set_.healthyHosts());
+  if (pending_rings_ != nullptr) {
+    rings_ = std::move(pending_rings_);
+    pending_rings_.reset();
+  } else {
+    rings_ = buildRings(host_set_, config_, rings_);
+  }
 }
 
 } // namespace Upstream
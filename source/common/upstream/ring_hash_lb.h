@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "envoy/runtime/runtime.h"
@@ -29,20 +30,117 @@ public:
   // Upstream::LoadBalancer
   HostConstSharedPtr chooseHost(LoadBalancerContext* context) override;
 
-private:
-  struct RingEntry {
-    uint64_t hash_;
-    HostConstSharedPtr host_;
-  };
+  class Ring;
+  typedef std::shared_ptr<const Ring> RingConstSharedPtr;
+
+  /**
+   * An immutable hash ring. The ring is stored as parallel arrays of sorted hashes and indices
+   * into a table of distinct hosts, which is considerably more compact than storing a host pointer
+   * per ring entry and avoids reference count traffic on lookup. Large rings additionally carry a
+   * bucket index keyed on the high bits of the hash which narrows the binary search to a small
+   * range.
+   */
+  class Ring : Logger::Loggable<Logger::Id::upstream> {
+  public:
+    /**
+     * Build a ring from scratch.
+     */
+    Ring(const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
+         const std::vector<HostSharedPtr>& hosts);
+
+    /**
+     * Build a ring for hosts, reusing the entries of a previous ring for hosts that are in both
+     * where possible. If only a few hosts have been added or removed and the number of hashes per
+     * host is unchanged this avoids rehashing and resorting the whole ring. Otherwise the ring is
+     * built from scratch. The resulting ring is identical to one built from scratch, modulo the
+     * relative order of entries with colliding hashes.
+     */
+    Ring(const Ring& previous, const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
+         const std::vector<HostSharedPtr>& hosts);
+
+    /**
+     * @param hash supplies the hash to look up.
+     * @return the host owning the first ring entry with a hash greater than or equal to hash,
+     *         wrapping around to the first entry. nullptr if the ring is empty.
+     */
+    HostConstSharedPtr chooseHost(uint64_t hash) const;
+
+    /**
+     * @return size_t the number of entries in the ring.
+     */
+    size_t size() const { return hashes_.size(); }
+
+    /**
+     * @return bool whether the last construction was able to incrementally update a previous ring.
+     */
+    bool incrementallyUpdated() const { return incrementally_updated_; }
 
-  struct Ring {
-    HostConstSharedPtr chooseHost(LoadBalancerContext* context, Runtime::RandomGenerator& random);
-    void create(const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
-                const std::vector<HostSharedPtr>& hosts);
+    // Rings with fewer entries than this do not get a bucket index, a plain binary search is
+    // already cheap.
+    static const uint64_t MIN_BUCKET_INDEX_RING_SIZE = 1024;
+    // Maximum number of bits of the hash used for the bucket index.
+    static const uint32_t MAX_BUCKET_INDEX_BITS = 20;
 
-    std::vector<RingEntry> ring_;
+  private:
+    static uint64_t hashesPerHost(const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
+                                  size_t num_hosts);
+    static bool useStdHash(const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config);
+    void build(const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
+               const std::vector<HostSharedPtr>& hosts);
+    bool tryIncrementalBuild(const Ring& previous,
+                             const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
+                             const std::vector<HostSharedPtr>& hosts);
+    void hashHost(const Host& host, uint32_t host_index,
+                  std::vector<std::pair<uint64_t, uint32_t>>& entries) const;
+    void buildBucketIndex();
+
+    // Sorted ring entry hashes, and the host_table_ index for each entry.
+    std::vector<uint64_t> hashes_;
+    std::vector<uint32_t> host_indices_;
+    std::vector<HostConstSharedPtr> host_table_;
+    uint64_t hashes_per_host_{};
+    bool use_std_hash_{};
+    bool incrementally_updated_{};
+    // bucket_index_[b] is the index of the first entry whose hash is >= (b << bucket_shift_). There
+    // is one extra trailing element equal to the ring size. Empty if the ring is small.
+    std::vector<uint32_t> bucket_index_;
+    uint32_t bucket_shift_{};
+  };
+
+  /**
+   * The pair of rings used for a host set. Once built, rings are immutable and may be shared
+   * between the load balancers of all workers.
+   */
+  struct SharedRings {
+    RingConstSharedPtr all_hosts_ring_;
+    RingConstSharedPtr healthy_hosts_ring_;
   };
+  typedef std::shared_ptr<const SharedRings> SharedRingsConstSharedPtr;
 
+  /**
+   * Build the rings for a host set.
+   * @param host_set supplies the hosts to build the rings for.
+   * @param config supplies the ring hash configuration.
+   * @param previous supplies rings previously built for the same host set, which are updated
+   *        incrementally if possible. May be nullptr.
+   * @return SharedRingsConstSharedPtr the new rings.
+   */
+  static SharedRingsConstSharedPtr
+  buildRings(const HostSet& host_set,
+             const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
+             const SharedRingsConstSharedPtr& previous);
+
+  /**
+   * Supply rings that were built elsewhere (typically once on the main thread) for the next
+   * membership update of the host set. The next update adopts these rings instead of building its
+   * own. The rings must have been built from the same hosts the update is going to contain.
+   * @param rings supplies the rings to use.
+   */
+  void setPendingRings(SharedRingsConstSharedPtr rings) { pending_rings_ = std::move(rings); }
+
+private:
+  HostConstSharedPtr chooseHostFromRing(LoadBalancerContext* context,
+                                        const RingConstSharedPtr& ring);
   void refresh();
 
   HostSet& host_set_;
@@ -50,8 +148,8 @@ private:
   Runtime::Loader& runtime_;
   Runtime::RandomGenerator& random_;
   const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config_;
-  Ring all_hosts_ring_;
-  Ring healthy_hosts_ring_;
+  SharedRingsConstSharedPtr rings_;
+  SharedRingsConstSharedPtr pending_rings_;
 };
 
 } // namespace Upstream
@@ -34,9 +34,9 @@ SdsSubscription::SdsSubscription(ClusterStats& stats,
   ASSERT(api_config_source.has_refresh_delay());
 }
 
-void SdsSubscription::parseResponse(const Http::Message& response) {
-  const std::string response_body = response.bodyAsString();
-  Json::ObjectSharedPtr json = Json::Factory::loadFromString(response_body);
+void SdsSubscription::parseResponse(Http::Message& response) {
+  const Buffer::Instance& response_body = *response.body();
+  Json::ObjectSharedPtr json = Json::Factory::loadFromBuffer(response_body);
   json->validateSchema(Json::Schema::SDS_SCHEMA);
 
   // Since in the v2 EDS API we place all the endpoints for a given zone in the same proto, we first
@@ -1,5 +1,6 @@
 #include "common/upstream/subset_lb.h"
 
+#include <algorithm>
 #include <unordered_set>
 
 #include "envoy/runtime/runtime.h"
@@ -9,6 +10,7 @@
 #include "common/config/well_known_names.h"
 #include "common/protobuf/utility.h"
 #include "common/upstream/load_balancer_impl.h"
+#include "common/upstream/maglev_lb.h"
 #include "common/upstream/ring_hash_lb.h"
 
 #include "api/cds.pb.h"
@@ -71,7 +73,7 @@ HostConstSharedPtr SubsetLoadBalancer::tryChooseHostFromContext(LoadBalancerCont
   }
 
   // Route has metadata match criteria defined, see if we have a matching subset.
-  LbSubsetEntryPtr entry = findSubset(match_criteria->metadataMatchCriteria());
+  LbSubsetEntryPtr entry = findSubset(*match_criteria);
   if (entry == nullptr || !entry->active()) {
     // No matching subset or subset not active: use fallback policy.
     return nullptr;
@@ -82,6 +84,36 @@ HostConstSharedPtr SubsetLoadBalancer::tryChooseHostFromContext(LoadBalancerCont
   return entry->lb_->chooseHost(context);
 }
 
+// Finds the LbSubsetEntryPtr matching the given metadata match criteria, if any. Subsets found
+// before are looked up by the hash of the criteria, and the trie is only searched the first time a
+// route's criteria are used.
+SubsetLoadBalancer::LbSubsetEntryPtr
+SubsetLoadBalancer::findSubset(const Router::MetadataMatchCriteria& match_criteria) {
+  const std::vector<Router::MetadataMatchCriterionConstSharedPtr>& criteria =
+      match_criteria.metadataMatchCriteria();
+  auto bucket = subsets_by_criteria_.find(match_criteria.hash());
+  if (bucket != subsets_by_criteria_.end()) {
+    for (const CriteriaSubset& criteria_subset : bucket->second) {
+      if (std::equal(criteria.begin(), criteria.end(), criteria_subset.criteria_.begin(),
+                     criteria_subset.criteria_.end(),
+                     [](const Router::MetadataMatchCriterionConstSharedPtr& a,
+                        const Router::MetadataMatchCriterionConstSharedPtr& b) -> bool {
+                       // Criteria of the same route are the same objects.
+                       return a == b || (a->name() == b->name() && a->value() == b->value());
+                     })) {
+        return criteria_subset.entry_;
+      }
+    }
+  }
+
+  // Criteria without a subset aren't remembered, as their subset may be created by a later update.
+  LbSubsetEntryPtr entry = findSubset(criteria);
+  if (entry != nullptr) {
+    subsets_by_criteria_[match_criteria.hash()].push_back({criteria, entry});
+  }
+  return entry;
+}
+
 // Iterates over the given metadata match criteria (which must be lexically sorted by key) and find
 // a matching LbSubsetEnryPtr, if any.
 SubsetLoadBalancer::LbSubsetEntryPtr SubsetLoadBalancer::findSubset(
@@ -149,11 +181,14 @@ void SubsetLoadBalancer::updateFallbackSubset(uint32_t priority,
 
 // Iterates over the added and removed hosts, looking up an LbSubsetEntryPtr for each. For every
 // unique LbSubsetEntryPtr found, it invokes cb with the LbSubsetEntryPtr, a HostPredicate that
-// selects hosts in the subset, and a flag indicating whether any hosts are being added.
+// selects hosts in the subset, and a flag indicating whether any hosts are being added. The hosts
+// of each subset are tracked here, so the predicate doesn't compare the metadata of hosts.
 void SubsetLoadBalancer::processSubsets(
     const std::vector<HostSharedPtr>& hosts_added, const std::vector<HostSharedPtr>& hosts_removed,
     std::function<void(LbSubsetEntryPtr, HostPredicate, bool)> cb) {
   std::unordered_set<LbSubsetEntryPtr> subsets_modified;
+  std::vector<std::pair<LbSubsetEntryPtr, bool>> subsets_to_update;
+  std::vector<std::pair<LbSubsetEntry*, const Host*>> hosts_to_forget;
 
   std::pair<const std::vector<HostSharedPtr>&, bool> steps[] = {{hosts_added, true},
                                                                 {hosts_removed, false}};
@@ -169,20 +204,36 @@ void SubsetLoadBalancer::processSubsets(
         if (!kvs.empty()) {
           // The host has metadata for each key, find or create its subset.
           LbSubsetEntryPtr entry = findOrCreateSubset(subsets_, kvs, 0);
-          if (subsets_modified.find(entry) != subsets_modified.end()) {
-            // We've already invoked the callback for this entry.
-            continue;
+          if (adding_hosts) {
+            entry->hosts_.insert(host.get());
+          } else {
+            // Removed hosts stay in the subset until it has been updated, so that the update
+            // removes them.
+            hosts_to_forget.emplace_back(entry.get(), host.get());
           }
-          subsets_modified.emplace(entry);
 
-          HostPredicate predicate =
-              std::bind(&SubsetLoadBalancer::hostMatches, this, kvs, std::placeholders::_1);
-
-          cb(entry, predicate, adding_hosts);
+          if (subsets_modified.emplace(entry).second) {
+            subsets_to_update.emplace_back(entry, adding_hosts);
+          }
         }
       }
     }
   }
+
+  // The subsets are only updated once all of the added hosts are in them, since updating a subset
+  // selects all of its hosts.
+  for (const auto& subset : subsets_to_update) {
+    const LbSubsetEntry* entry = subset.first.get();
+    HostPredicate predicate = [entry](const Host& host) -> bool {
+      return entry->hosts_.count(&host) > 0;
+    };
+
+    cb(subset.first, predicate, subset.second);
+  }
+
+  for (const auto& host : hosts_to_forget) {
+    host.first->hosts_.erase(host.second);
+  }
 }
 
 // Given the addition and/or removal of hosts, update all subsets for this priority level, creating
@@ -231,21 +282,6 @@ bool SubsetLoadBalancer::hostMatchesDefaultSubset(const Host& host) {
   return true;
 }
 
-bool SubsetLoadBalancer::hostMatches(const SubsetMetadata& kvs, const Host& host) {
-  const envoy::api::v2::Metadata& host_metadata = host.metadata();
-
-  for (const auto& kv : kvs) {
-    const ProtobufWkt::Value& host_value = Config::Metadata::metadataValue(
-        host_metadata, Config::MetadataFilters::get().ENVOY_LB, kv.first);
-
-    if (!ValueUtil::equal(host_value, kv.second)) {
-      return false;
-    }
-  }
-
-  return true;
-}
-
 // Iterates over subset_keys looking up values from the given host's metadata. Each key-value pair
 // is appended to kvs. Returns a non-empty value if the host has a value for each key.
 SubsetLoadBalancer::SubsetMetadata
@@ -334,6 +370,11 @@ void SubsetLoadBalancer::LbSubsetEntry::initLoadBalancer(const SubsetLoadBalance
                                            subset_lb.runtime_, subset_lb.random_));
     break;
 
+  case LoadBalancerType::PeakEwma:
+    lb_.reset(new PeakEwmaLoadBalancer(*priority_subset_, subset_lb.original_local_priority_set_,
+                                       subset_lb.stats_, subset_lb.runtime_, subset_lb.random_));
+    break;
+
   case LoadBalancerType::Random:
     lb_.reset(new RandomLoadBalancer(*priority_subset_, subset_lb.original_local_priority_set_,
                                      subset_lb.stats_, subset_lb.runtime_, subset_lb.random_));
@@ -349,6 +390,11 @@ void SubsetLoadBalancer::LbSubsetEntry::initLoadBalancer(const SubsetLoadBalance
                                        subset_lb.random_, subset_lb.lb_ring_hash_config_));
     break;
 
+  case LoadBalancerType::Maglev:
+    lb_.reset(new MaglevLoadBalancer(*priority_subset_, subset_lb.stats_, subset_lb.runtime_,
+                                     subset_lb.random_));
+    break;
+
   case LoadBalancerType::OriginalDst:
     NOT_REACHED;
   }
@@ -410,8 +456,9 @@ void SubsetLoadBalancer::HostSubsetImpl::update(const std::vector<HostSharedPtr>
     healthy_hosts_per_locality->emplace_back(curr_locality_healthy_hosts);
   }
 
+  // The per locality lists parallel the original ones, so the original weights still apply.
   HostSetImpl::updateHosts(hosts, healthy_hosts, hosts_per_locality, healthy_hosts_per_locality,
-                           filtered_added, filtered_removed);
+                           original_host_set_.localityWeights(), filtered_added, filtered_removed);
 }
 
 SubsetLoadBalancer::PrioritySubsetImpl::PrioritySubsetImpl(const PrioritySet& original_priority_set)
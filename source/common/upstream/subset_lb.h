@@ -4,6 +4,9 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "envoy/common/optional.h"
 #include "envoy/runtime/runtime.h"
@@ -97,11 +100,21 @@ private:
 
     LbSubsetMap children_;
 
+    // The hosts whose metadata match the subset, which are tracked as hosts are added and removed
+    // so that the subset's hosts are selected without comparing metadata.
+    std::unordered_set<const Host*> hosts_;
+
     // Only initialized if a match exists at this level.
     PrioritySubsetImplPtr priority_subset_;
     LoadBalancerPtr lb_;
   };
 
+  // A subset which was found for a route's metadata match criteria.
+  struct CriteriaSubset {
+    std::vector<Router::MetadataMatchCriterionConstSharedPtr> criteria_;
+    LbSubsetEntryPtr entry_;
+  };
+
   // Called by HostSet::MemberUpdateCb
   void update(uint32_t priority, const std::vector<HostSharedPtr>& hosts_added,
               const std::vector<HostSharedPtr>& hosts_removed);
@@ -115,8 +128,8 @@ private:
   HostConstSharedPtr tryChooseHostFromContext(LoadBalancerContext* context, bool& host_chosen);
 
   bool hostMatchesDefaultSubset(const Host& host);
-  bool hostMatches(const SubsetMetadata& kvs, const Host& host);
 
+  LbSubsetEntryPtr findSubset(const Router::MetadataMatchCriteria& match_criteria);
   LbSubsetEntryPtr
   findSubset(const std::vector<Router::MetadataMatchCriterionConstSharedPtr>& matches);
 
@@ -142,6 +155,11 @@ private:
 
   // Forms a trie-like structure. Requires lexically sorted Host and Route metadata.
   LbSubsetMap subsets_;
+
+  // The subsets found in subsets_ for match criteria, keyed by the hash of the criteria, so that a
+  // route's subset is found with one lookup. Subsets are never removed from subsets_, so a subset
+  // found for some criteria stays the subset for them.
+  std::unordered_map<std::size_t, std::vector<CriteriaSubset>> subsets_by_criteria_;
 };
 
 } // namespace Upstream
@@ -1,10 +1,14 @@
 #include "common/upstream/upstream_impl.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -48,6 +52,21 @@ getSourceAddress(const envoy::api::v2::Cluster& cluster,
   // If there's no source address in the cluster config, use any default from the bootstrap proto.
   return source_address;
 }
+
+/**
+ * The indices of the hosts which exist. Destroyed hosts push their index on the free list.
+ */
+struct HostIndices {
+  std::mutex lock_;
+  uint32_t next_{};
+  std::vector<uint32_t> free_;
+};
+
+HostIndices& hostIndices() {
+  // Leaked, as hosts may outlive static destruction.
+  static HostIndices* host_indices = new HostIndices();
+  return *host_indices;
+}
 } // namespace
 
 Host::CreateConnectionData HostImpl::createConnection(Event::Dispatcher& dispatcher) const {
@@ -65,8 +84,57 @@ HostImpl::createConnection(Event::Dispatcher& dispatcher, const ClusterInfo& clu
   return connection;
 }
 
+namespace {
+
+// The time over which the weight of past latencies decays by a factor of e.
+constexpr double LatencyDecayTimeSeconds = 10.0;
+
+double latencyDecay(MonotonicTime::duration elapsed) {
+  if (elapsed <= MonotonicTime::duration::zero()) {
+    return 1.0;
+  }
+  return std::exp(-std::chrono::duration<double>(elapsed).count() / LatencyDecayTimeSeconds);
+}
+
+} // namespace
+
+void PeakEwmaLatencyEstimatorImpl::putLatency(std::chrono::microseconds latency,
+                                              MonotonicTime now) {
+  const double value = latency.count();
+  std::unique_lock<std::mutex> lock(lock_);
+  if (value > ewma_) {
+    ewma_ = value;
+  } else {
+    ewma_ = value + (ewma_ - value) * latencyDecay(now - last_time_);
+  }
+  last_time_ = std::max(last_time_, now);
+}
+
+double PeakEwmaLatencyEstimatorImpl::peakEwma(MonotonicTime now) const {
+  std::unique_lock<std::mutex> lock(lock_);
+  return ewma_ * latencyDecay(now - last_time_);
+}
+
 void HostImpl::weight(uint32_t new_weight) { weight_ = std::max(1U, std::min(128U, new_weight)); }
 
+uint32_t HostImpl::allocateIndex() {
+  HostIndices& indices = hostIndices();
+  std::unique_lock<std::mutex> lock(indices.lock_);
+  if (indices.free_.empty()) {
+    return indices.next_++;
+  }
+
+  const uint32_t index = indices.free_.back();
+  indices.free_.pop_back();
+  return index;
+}
+
+void HostImpl::releaseIndex(uint32_t index) {
+  HostIndices& indices = hostIndices();
+  std::unique_lock<std::mutex> lock(indices.lock_);
+  indices.free_.push_back(index);
+}
+
 HostSet& PrioritySetImpl::getOrCreateHostSet(uint32_t priority) {
   if (host_sets_.size() < priority + 1) {
     for (size_t i = host_sets_.size(); i <= priority; ++i) {
@@ -102,12 +170,24 @@ ClusterInfoImpl::ClusterInfoImpl(const envoy::api::v2::Cluster& config,
       per_connection_buffer_limit_bytes_(
           PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, per_connection_buffer_limit_bytes, 1024 * 1024)),
       stats_scope_(stats.createScope(fmt::format("cluster.{}.", name_))),
-      stats_(generateStats(*stats_scope_)),
+      lazy_stats_scope_(runtime.snapshot().featureEnabled("upstream.lazy_cluster_stats", 0)
+                            ? new Stats::LazyScopeImpl(*stats_scope_)
+                            : nullptr),
+      stats_(generateStats(lazy_stats_scope_ ? *lazy_stats_scope_ : *stats_scope_)),
+      code_stats_(*stats_scope_),
       load_report_stats_(generateLoadReportStats(load_report_stats_store_)),
-      features_(parseFeatures(config)),
+      features_(parseFeatures(config, runtime, name_)),
       http2_settings_(Http::Utility::parseHttp2Settings(config.http2_protocol_options())),
       resource_managers_(config, runtime, name_),
       maintenance_mode_runtime_key_(fmt::format("upstream.maintenance_mode.{}", name_)),
+      http2_connections_per_host_runtime_key_(
+          fmt::format("upstream.http2_connections_per_host.{}", name_)),
+      http1_prefetch_percent_runtime_key_(fmt::format("upstream.http1_prefetch_percent.{}", name_)),
+      http1_min_idle_connections_runtime_key_(
+          fmt::format("upstream.http1_min_idle_connections.{}", name_)),
+      http1_idle_timeout_runtime_key_(fmt::format("upstream.http1_idle_timeout_ms.{}", name_)),
+      http1_max_pipelined_requests_runtime_key_(
+          fmt::format("upstream.http1_max_pipelined_requests.{}", name_)),
       source_address_(getSourceAddress(config, source_address)),
       lb_ring_hash_config_(envoy::api::v2::Cluster::RingHashLbConfig(config.ring_hash_lb_config())),
       added_via_api_(added_via_api),
@@ -118,18 +198,33 @@ ClusterInfoImpl::ClusterInfoImpl(const envoy::api::v2::Cluster& config,
     ssl_ctx_ = ssl_context_manager.createSslClientContext(*stats_scope_, context_config);
   }
 
+  // The API has no setting for this (yet), so HTTP/2 window auto-tuning is enabled at load time via
+  // runtime.
+  http2_settings_.window_auto_tuning_ =
+      runtime.snapshot().getInteger(fmt::format("upstream.http2_window_auto_tuning.{}", name_),
+                                    0) != 0;
+
   switch (config.lb_policy()) {
   case envoy::api::v2::Cluster::ROUND_ROBIN:
     lb_type_ = LoadBalancerType::RoundRobin;
     break;
   case envoy::api::v2::Cluster::LEAST_REQUEST:
-    lb_type_ = LoadBalancerType::LeastRequest;
+    // The API has no peak EWMA policy (yet), so a least request cluster can be switched to the peak
+    // EWMA load balancer at load time via runtime.
+    lb_type_ =
+        runtime.snapshot().getInteger(fmt::format("upstream.use_peak_ewma.{}", name_), 0) != 0
+            ? LoadBalancerType::PeakEwma
+            : LoadBalancerType::LeastRequest;
     break;
   case envoy::api::v2::Cluster::RANDOM:
     lb_type_ = LoadBalancerType::Random;
     break;
   case envoy::api::v2::Cluster::RING_HASH:
-    lb_type_ = LoadBalancerType::RingHash;
+    // The API has no Maglev policy (yet), so a ring hash cluster can be switched to the Maglev load
+    // balancer at load time via runtime.
+    lb_type_ = runtime.snapshot().getInteger(fmt::format("upstream.use_maglev.{}", name_), 0) != 0
+                   ? LoadBalancerType::Maglev
+                   : LoadBalancerType::RingHash;
     break;
   case envoy::api::v2::Cluster::ORIGINAL_DST_LB:
     if (config.type() != envoy::api::v2::Cluster::ORIGINAL_DST) {
@@ -152,6 +247,7 @@ ClusterSharedPtr ClusterImplBase::create(const envoy::api::v2::Cluster& cluster,
                                          Ssl::ContextManager& ssl_context_manager,
                                          Runtime::Loader& runtime, Runtime::RandomGenerator& random,
                                          Event::Dispatcher& dispatcher,
+                                         Event::Dispatcher& health_check_dispatcher,
                                          const LocalInfo::LocalInfo& local_info,
                                          Outlier::EventLoggerSharedPtr outlier_event_logger,
                                          bool added_via_api) {
@@ -218,7 +314,8 @@ ClusterSharedPtr ClusterImplBase::create(const envoy::api::v2::Cluster& cluster,
     // TODO(htuch): Need to support multiple health checks in v2.
     ASSERT(cluster.health_checks().size() == 1);
     new_cluster->setHealthChecker(HealthCheckerFactory::create(
-        cluster.health_checks()[0], *new_cluster, runtime, random, dispatcher));
+        cluster.health_checks()[0], *new_cluster, runtime, random, dispatcher,
+        health_check_dispatcher));
   }
 
   new_cluster->setOutlierDetector(Outlier::DetectorImplFactory::createForCluster(
@@ -285,11 +382,51 @@ bool ClusterInfoImpl::maintenanceMode() const {
   return runtime_.snapshot().featureEnabled(maintenance_mode_runtime_key_, 0);
 }
 
-uint64_t ClusterInfoImpl::parseFeatures(const envoy::api::v2::Cluster& config) {
+const uint64_t ClusterInfoImpl::MAX_HTTP2_CONNECTIONS_PER_HOST;
+const uint64_t ClusterInfoImpl::MAX_HTTP1_PREFETCH_PERCENT;
+const uint64_t ClusterInfoImpl::MAX_HTTP1_MIN_IDLE_CONNECTIONS;
+const uint64_t ClusterInfoImpl::MAX_HTTP1_MAX_PIPELINED_REQUESTS;
+
+uint32_t ClusterInfoImpl::http2ConnectionsPerHost() const {
+  // The API has no setting for this (yet), so it is set per cluster via runtime.
+  const uint64_t connections =
+      runtime_.snapshot().getInteger(http2_connections_per_host_runtime_key_, 1);
+  return std::max<uint64_t>(1, std::min(connections, MAX_HTTP2_CONNECTIONS_PER_HOST));
+}
+
+uint32_t ClusterInfoImpl::http1PrefetchPercent() const {
+  const uint64_t percent = runtime_.snapshot().getInteger(http1_prefetch_percent_runtime_key_, 100);
+  return std::max<uint64_t>(100, std::min(percent, MAX_HTTP1_PREFETCH_PERCENT));
+}
+
+uint32_t ClusterInfoImpl::http1MinIdleConnections() const {
+  const uint64_t connections =
+      runtime_.snapshot().getInteger(http1_min_idle_connections_runtime_key_, 0);
+  return std::min(connections, MAX_HTTP1_MIN_IDLE_CONNECTIONS);
+}
+
+std::chrono::milliseconds ClusterInfoImpl::http1IdleTimeout() const {
+  return std::chrono::milliseconds(
+      runtime_.snapshot().getInteger(http1_idle_timeout_runtime_key_, 0));
+}
+
+uint32_t ClusterInfoImpl::http1MaxPipelinedRequests() const {
+  const uint64_t requests =
+      runtime_.snapshot().getInteger(http1_max_pipelined_requests_runtime_key_, 1);
+  return std::max<uint64_t>(1, std::min(requests, MAX_HTTP1_MAX_PIPELINED_REQUESTS));
+}
+
+uint64_t ClusterInfoImpl::parseFeatures(const envoy::api::v2::Cluster& config,
+                                        Runtime::Loader& runtime, const std::string& name) {
   uint64_t features = 0;
   if (config.has_http2_protocol_options()) {
     features |= Features::HTTP2;
   }
+  // The API has no gRPC compression option (yet), so gzip message compression is enabled for a
+  // cluster at load time via runtime.
+  if (runtime.snapshot().getInteger(fmt::format("upstream.grpc_compression.{}", name), 0) != 0) {
+    features |= Features::GRPC_COMPRESSION;
+  }
   return features;
 }
 
@@ -386,7 +523,8 @@ void ClusterImplBase::reloadHealthyHosts() {
         new std::vector<std::vector<HostSharedPtr>>(host_set->hostsPerLocality()));
     host_set->updateHosts(hosts_copy, createHealthyHostList(host_set->hosts()),
                           hosts_per_locality_copy,
-                          createHealthyHostLists(host_set->hostsPerLocality()), {}, {});
+                          createHealthyHostLists(host_set->hostsPerLocality()),
+                          host_set->localityWeights(), {}, {});
   }
 }
 
@@ -469,7 +607,7 @@ void StaticClusterImpl::startPreInit() {
   ASSERT(priority_set_.hostSetsPerPriority().size() == 1);
   auto& first_host_set = priority_set_.getOrCreateHostSet(0);
   first_host_set.updateHosts(initial_hosts_, createHealthyHostList(*initial_hosts_),
-                             empty_host_lists_, empty_host_lists_, *initial_hosts_, {});
+                             empty_host_lists_, empty_host_lists_, nullptr, *initial_hosts_, {});
   initial_hosts_ = nullptr;
 
   onPreInitComplete();
@@ -483,79 +621,75 @@ bool BaseDynamicClusterImpl::updateDynamicHostList(const std::vector<HostSharedP
   uint64_t max_host_weight = 1;
 
   // Go through and see if the list we have is different from what we just got. If it is, we
-  // make a new host list and raise a change notification. This uses an N^2 search given that
-  // this does not happen very often and the list sizes should be small. We also check for
-  // duplicates here. It's possible for DNS to return the same address multiple times, and a bad
-  // SDS implementation could do the same thing.
+  // make a new host list and raise a change notification. Current hosts are matched by address
+  // through a hash map, so an update of a cluster with many hosts which changes a few of them
+  // doesn't compare every pair of hosts. We also check for duplicates here. It's possible for DNS
+  // to return the same address multiple times, and a bad SDS implementation could do the same
+  // thing.
+  std::unordered_map<std::string, size_t> current_host_indexes;
+  current_host_indexes.reserve(current_hosts.size());
+  for (size_t i = 0; i < current_hosts.size(); i++) {
+    current_host_indexes.emplace(current_hosts[i]->address()->asString(), i);
+  }
+
+  std::vector<bool> current_host_kept(current_hosts.size());
   std::unordered_set<std::string> host_addresses;
   std::vector<HostSharedPtr> final_hosts;
+  final_hosts.reserve(new_hosts.size());
   for (const HostSharedPtr& host : new_hosts) {
-    if (host_addresses.count(host->address()->asString())) {
+    const std::string& address = host->address()->asString();
+    if (!host_addresses.emplace(address).second) {
       continue;
     }
-    host_addresses.emplace(host->address()->asString());
-
-    bool found = false;
-    for (auto i = current_hosts.begin(); i != current_hosts.end();) {
-      // If we find a host matched based on address, we keep it. However we do change weight inline
-      // so do that here.
-      if (*(*i)->address() == *host->address()) {
-        if (host->weight() > max_host_weight) {
-          max_host_weight = host->weight();
-        }
 
-        (*i)->weight(host->weight());
-        final_hosts.push_back(*i);
-        i = current_hosts.erase(i);
-        found = true;
-      } else {
-        i++;
-      }
+    if (host->weight() > max_host_weight) {
+      max_host_weight = host->weight();
     }
 
-    if (!found) {
-      if (host->weight() > max_host_weight) {
-        max_host_weight = host->weight();
-      }
+    // If we find a host matched based on address, we keep it. However we do change weight inline
+    // so do that here.
+    auto current_host_index = current_host_indexes.find(address);
+    if (current_host_index != current_host_indexes.end()) {
+      const HostSharedPtr& current_host = current_hosts[current_host_index->second];
+      current_host->weight(host->weight());
+      final_hosts.push_back(current_host);
+      current_host_kept[current_host_index->second] = true;
+      continue;
+    }
 
-      final_hosts.push_back(host);
-      hosts_added.push_back(host);
+    final_hosts.push_back(host);
+    hosts_added.push_back(host);
 
-      // If we are depending on a health checker, we initialize to unhealthy.
-      if (depend_on_hc) {
-        hosts_added.back()->healthFlagSet(Host::HealthFlag::FAILED_ACTIVE_HC);
-      }
+    // If we are depending on a health checker, we initialize to unhealthy.
+    if (depend_on_hc) {
+      hosts_added.back()->healthFlagSet(Host::HealthFlag::FAILED_ACTIVE_HC);
     }
   }
 
   // If there are removed hosts, check to see if we should only delete if unhealthy.
-  if (!current_hosts.empty() && depend_on_hc) {
-    for (auto i = current_hosts.begin(); i != current_hosts.end();) {
-      if (!(*i)->healthFlagGet(Host::HealthFlag::FAILED_ACTIVE_HC)) {
-        if ((*i)->weight() > max_host_weight) {
-          max_host_weight = (*i)->weight();
-        }
+  std::vector<HostSharedPtr> removed_hosts;
+  for (size_t i = 0; i < current_hosts.size(); i++) {
+    if (current_host_kept[i]) {
+      continue;
+    }
 
-        final_hosts.push_back(*i);
-        i = current_hosts.erase(i);
-      } else {
-        i++;
+    if (depend_on_hc && !current_hosts[i]->healthFlagGet(Host::HealthFlag::FAILED_ACTIVE_HC)) {
+      if (current_hosts[i]->weight() > max_host_weight) {
+        max_host_weight = current_hosts[i]->weight();
       }
+
+      final_hosts.push_back(current_hosts[i]);
+    } else {
+      removed_hosts.push_back(current_hosts[i]);
     }
   }
 
   info_->stats().max_host_weight_.set(max_host_weight);
 
-  if (!hosts_added.empty() || !current_hosts.empty()) {
-    hosts_removed = std::move(current_hosts);
-    current_hosts = std::move(final_hosts);
-    return true;
-  } else {
-    // During the search we moved all of the hosts from hosts_ into final_hosts so just
-    // move them back.
-    current_hosts = std::move(final_hosts);
-    return false;
-  }
+  const bool changed = !hosts_added.empty() || !removed_hosts.empty();
+  hosts_removed = std::move(removed_hosts);
+  current_hosts = std::move(final_hosts);
+  return changed;
 }
 
 StrictDnsClusterImpl::StrictDnsClusterImpl(const envoy::api::v2::Cluster& cluster,
@@ -611,7 +745,7 @@ void StrictDnsClusterImpl::updateAllHosts(const std::vector<HostSharedPtr>& host
   ASSERT(priority_set_.hostSetsPerPriority().size() == 1);
   auto& first_host_set = priority_set_.getOrCreateHostSet(0);
   first_host_set.updateHosts(new_hosts, createHealthyHostList(*new_hosts), empty_host_lists_,
-                             empty_host_lists_, hosts_added, hosts_removed);
+                             empty_host_lists_, nullptr, hosts_added, hosts_removed);
 }
 
 StrictDnsClusterImpl::ResolveTarget::ResolveTarget(StrictDnsClusterImpl& parent,
@@ -7,6 +7,7 @@
 #include <functional>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -25,8 +26,11 @@
 #include "common/common/callback_impl.h"
 #include "common/common/enum_to_int.h"
 #include "common/common/logger.h"
+#include "common/common/utility.h"
 #include "common/config/metadata.h"
 #include "common/config/well_known_names.h"
+#include "common/http/codes.h"
+#include "common/stats/lazy_scope.h"
 #include "common/stats/stats_impl.h"
 #include "common/upstream/load_balancer_impl.h"
 #include "common/upstream/outlier_detection_impl.h"
@@ -61,6 +65,23 @@ public:
   void setUnhealthy() override {}
 };
 
+/**
+ * Implementation of LatencyEstimator. A response slower than the average replaces it, so that a
+ * host which slows down is avoided at once, while faster responses are averaged in with a weight
+ * growing with the time since the previous response, over a decay time of 10s.
+ */
+class PeakEwmaLatencyEstimatorImpl : public LatencyEstimator {
+public:
+  // Upstream::LatencyEstimator
+  void putLatency(std::chrono::microseconds latency, MonotonicTime now) override;
+  double peakEwma(MonotonicTime now) const override;
+
+private:
+  mutable std::mutex lock_;
+  double ewma_{};
+  MonotonicTime last_time_;
+};
+
 /**
  * Implementation of Upstream::HostDescription.
  */
@@ -91,6 +112,7 @@ public:
       return *null_health_checker;
     }
   }
+  LatencyEstimator& latencyEstimator() const override { return latency_estimator_; }
   Outlier::DetectorHostMonitor& outlierDetector() const override {
     if (outlier_detector_) {
       return *outlier_detector_;
@@ -116,6 +138,7 @@ protected:
   HostStats stats_;
   Outlier::DetectorHostMonitorPtr outlier_detector_;
   HealthCheckHostMonitorPtr health_checker_;
+  mutable PeakEwmaLatencyEstimatorImpl latency_estimator_;
 };
 
 /**
@@ -129,9 +152,12 @@ public:
            Network::Address::InstanceConstSharedPtr address,
            const envoy::api::v2::Metadata& metadata, uint32_t initial_weight,
            const envoy::api::v2::Locality& locality)
-      : HostDescriptionImpl(cluster, hostname, address, metadata, locality), used_(true) {
+      : HostDescriptionImpl(cluster, hostname, address, metadata, locality), used_(true),
+        index_(allocateIndex()) {
     weight(initial_weight);
+    slowStartTime(ProdMonotonicTimeSource::instance_.currentTime());
   }
+  ~HostImpl() { releaseIndex(index_); }
 
   // Upstream::Host
   std::list<Stats::CounterSharedPtr> counters() const override { return stats_store_.counters(); }
@@ -151,6 +177,13 @@ public:
   void weight(uint32_t new_weight) override;
   bool used() const override { return used_; }
   void used(bool new_used) override { used_ = new_used; }
+  MonotonicTime slowStartTime() const override {
+    return MonotonicTime(MonotonicTime::duration(slow_start_time_));
+  }
+  void slowStartTime(MonotonicTime time) override {
+    slow_start_time_ = time.time_since_epoch().count();
+  }
+  uint32_t index() const override { return index_; }
 
 protected:
   static Network::ClientConnectionPtr
@@ -158,15 +191,28 @@ protected:
                    Network::Address::InstanceConstSharedPtr address);
 
 private:
+  /**
+   * Allocate the index of a new host, reusing the index of a destroyed host if there is one, so
+   * that indices stay below the peak number of hosts. Hosts are created and destroyed on any
+   * thread, so the allocator is synchronized.
+   */
+  static uint32_t allocateIndex();
+  static void releaseIndex(uint32_t index);
+
   std::atomic<uint64_t> health_flags_{};
   std::atomic<uint32_t> weight_;
   std::atomic<bool> used_;
+  // Hosts are shared by the workers, so the time is kept as an atomic count.
+  std::atomic<MonotonicTime::rep> slow_start_time_;
+  const uint32_t index_;
 };
 
 typedef std::shared_ptr<std::vector<HostSharedPtr>> HostVectorSharedPtr;
 typedef std::shared_ptr<const std::vector<HostSharedPtr>> HostVectorConstSharedPtr;
 typedef std::shared_ptr<std::vector<std::vector<HostSharedPtr>>> HostListsSharedPtr;
 typedef std::shared_ptr<const std::vector<std::vector<HostSharedPtr>>> HostListsConstSharedPtr;
+typedef std::shared_ptr<std::vector<uint32_t>> LocalityWeightsSharedPtr;
+typedef std::shared_ptr<const std::vector<uint32_t>> LocalityWeightsConstSharedPtr;
 
 /**
  * A class for management of the set of hosts for a given priority level.
@@ -182,12 +228,14 @@ public:
   void updateHosts(HostVectorConstSharedPtr hosts, HostVectorConstSharedPtr healthy_hosts,
                    HostListsConstSharedPtr hosts_per_locality,
                    HostListsConstSharedPtr healthy_hosts_per_locality,
+                   LocalityWeightsConstSharedPtr locality_weights,
                    const std::vector<HostSharedPtr>& hosts_added,
                    const std::vector<HostSharedPtr>& hosts_removed) override {
     hosts_ = std::move(hosts);
     healthy_hosts_ = std::move(healthy_hosts);
     hosts_per_locality_ = std::move(hosts_per_locality);
     healthy_hosts_per_locality_ = std::move(healthy_hosts_per_locality);
+    locality_weights_ = std::move(locality_weights);
     runUpdateCallbacks(hosts_added, hosts_removed);
   }
 
@@ -200,6 +248,7 @@ public:
   const std::vector<std::vector<HostSharedPtr>>& healthyHostsPerLocality() const override {
     return *healthy_hosts_per_locality_;
   }
+  LocalityWeightsConstSharedPtr localityWeights() const override { return locality_weights_; }
   Common::CallbackHandle* addMemberUpdateCb(MemberUpdateCb callback) const override {
     return member_update_cb_helper_.add(callback);
   }
@@ -217,6 +266,7 @@ private:
   HostVectorConstSharedPtr healthy_hosts_;
   HostListsConstSharedPtr hosts_per_locality_;
   HostListsConstSharedPtr healthy_hosts_per_locality_;
+  LocalityWeightsConstSharedPtr locality_weights_;
   // TODO(mattklein123): Remove mutable.
   mutable Common::CallbackManager<uint32_t, const std::vector<HostSharedPtr>&,
                                   const std::vector<HostSharedPtr>&>
@@ -290,11 +340,17 @@ public:
   }
   bool maintenanceMode() const override;
   uint64_t maxRequestsPerConnection() const override { return max_requests_per_connection_; }
+  uint32_t http2ConnectionsPerHost() const override;
+  uint32_t http1PrefetchPercent() const override;
+  uint32_t http1MinIdleConnections() const override;
+  std::chrono::milliseconds http1IdleTimeout() const override;
+  uint32_t http1MaxPipelinedRequests() const override;
   const std::string& name() const override { return name_; }
   ResourceManager& resourceManager(ResourcePriority priority) const override;
   Ssl::ClientContext* sslContext() const override { return ssl_ctx_.get(); }
   ClusterStats& stats() const override { return stats_; }
   Stats::Scope& statsScope() const override { return *stats_scope_; }
+  Http::CodeStats& codeStats() const override { return code_stats_; }
   ClusterLoadReportStats& loadReportStats() const override { return load_report_stats_; }
   const Network::Address::InstanceConstSharedPtr& sourceAddress() const override {
     return source_address_;
@@ -314,7 +370,13 @@ private:
     Managers managers_;
   };
 
-  static uint64_t parseFeatures(const envoy::api::v2::Cluster& config);
+  static uint64_t parseFeatures(const envoy::api::v2::Cluster& config, Runtime::Loader& runtime,
+                                const std::string& name);
+
+  static const uint64_t MAX_HTTP2_CONNECTIONS_PER_HOST = 64;
+  static const uint64_t MAX_HTTP1_PREFETCH_PERCENT = 1000;
+  static const uint64_t MAX_HTTP1_MIN_IDLE_CONNECTIONS = 1024;
+  static const uint64_t MAX_HTTP1_MAX_PIPELINED_REQUESTS = 16;
 
   Runtime::Loader& runtime_;
   const std::string name_;
@@ -322,14 +384,22 @@ private:
   const std::chrono::milliseconds connect_timeout_;
   const uint32_t per_connection_buffer_limit_bytes_;
   Stats::ScopePtr stats_scope_;
+  // Set when the stats of the cluster are only created once they are first used.
+  std::unique_ptr<Stats::LazyScopeImpl> lazy_stats_scope_;
   mutable ClusterStats stats_;
+  mutable Http::CodeStatsImpl code_stats_;
   Stats::IsolatedStoreImpl load_report_stats_store_;
   mutable ClusterLoadReportStats load_report_stats_;
   Ssl::ClientContextPtr ssl_ctx_;
   const uint64_t features_;
-  const Http::Http2Settings http2_settings_;
+  Http::Http2Settings http2_settings_;
   mutable ResourceManagers resource_managers_;
   const std::string maintenance_mode_runtime_key_;
+  const std::string http2_connections_per_host_runtime_key_;
+  const std::string http1_prefetch_percent_runtime_key_;
+  const std::string http1_min_idle_connections_runtime_key_;
+  const std::string http1_idle_timeout_runtime_key_;
+  const std::string http1_max_pipelined_requests_runtime_key_;
   const Network::Address::InstanceConstSharedPtr source_address_;
   LoadBalancerType lb_type_;
   Optional<envoy::api::v2::Cluster::RingHashLbConfig> lb_ring_hash_config_;
@@ -348,6 +418,7 @@ public:
                                  Network::DnsResolverSharedPtr dns_resolver,
                                  Ssl::ContextManager& ssl_context_manager, Runtime::Loader& runtime,
                                  Runtime::RandomGenerator& random, Event::Dispatcher& dispatcher,
+                                 Event::Dispatcher& health_check_dispatcher,
                                  const LocalInfo::LocalInfo& local_info,
                                  Outlier::EventLoggerSharedPtr outlier_event_logger,
                                  bool added_via_api);
@@ -1,9 +1,15 @@
 #include <iostream>
 #include <memory>
 
+#include "common/buffer/buffer_impl.h"
 #include "common/common/compiler_requirements.h"
+#include "common/common/utility.h"
+#include "common/event/dispatcher_impl.h"
 #include "common/event/libevent.h"
+#include "common/network/connection_impl.h"
 #include "common/network/utility.h"
+#include "common/ssl/connection_impl.h"
+#include "common/ssl/context_config_impl.h"
 #include "common/stats/stats_impl.h"
 #include "common/stats/thread_local_store.h"
 
@@ -31,7 +37,8 @@ public:
         // The global drain manager only triggers on listener modification, which effectively is
         // hot restart at the global level. The per-listener drain managers decide whether to
         // to include /healthcheck/fail status.
-        new DrainManagerImpl(server, envoy::api::v2::Listener_DrainType_MODIFY_ONLY)};
+        new DrainManagerImpl(server, envoy::api::v2::Listener_DrainType_MODIFY_ONLY,
+                             ProdMonotonicTimeSource::instance_)};
   }
 
   Runtime::LoaderPtr createRuntime(Server::Instance& server,
@@ -44,6 +51,13 @@ public:
 
 int main_common(OptionsImpl& options) {
   Stats::RawStatData::configure(options);
+  Buffer::OwnedImpl::useOldImpl(options.libeventBuffersEnabled());
+  Event::DispatcherImpl::useEpollChangelist(options.epollChangelistEnabled());
+  Event::DispatcherImpl::maxDeferredDeletesPerIteration(options.maxDeferredDeletesPerIteration());
+  Network::ConnectionImpl::coalesceWrites(options.coalesceWrites());
+  Network::ConnectionImpl::tcpNotSentLowat(options.tcpNotSentLowat());
+  Ssl::ContextConfigImpl::defaultInitialRecordSize(options.tlsInitialRecordSize());
+  Ssl::SslSocket::kernelTls(options.kernelTlsEnabled());
 
 #ifdef ENVOY_HOT_RESTART
   std::unique_ptr<Server::HotRestartImpl> restarter;
@@ -80,17 +94,22 @@ int main_common(OptionsImpl& options) {
   ares_library_init(ARES_LIB_INIT_ALL);
 
   Logger::Registry::initialize(options.logLevel(), log_lock);
+  if (options.asyncLog()) {
+    Logger::Registry::getSink()->startAsync();
+  }
   DefaultTestHooks default_test_hooks;
   ThreadLocal::InstanceImpl tls;
-  Stats::ThreadLocalStoreImpl stats_store(stats_allocator);
+  Stats::ThreadLocalStoreImpl stats_store(stats_allocator, options.threadLocalCounters());
   try {
     Server::InstanceImpl server(options, local_address, default_test_hooks, *restarter, stats_store,
                                 access_log_lock, component_factory, tls);
     server.run();
   } catch (const EnvoyException& e) {
+    Logger::Registry::getSink()->stopAsync();
     ares_library_cleanup();
     return 1;
   }
+  Logger::Registry::getSink()->stopAsync();
   ares_library_cleanup();
   return 0;
 }
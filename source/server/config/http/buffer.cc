@@ -25,7 +25,8 @@ BufferFilterConfig::createFilter(const envoy::api::v2::filter::http::Buffer& pro
   Http::BufferFilterConfigConstSharedPtr filter_config(new Http::BufferFilterConfig{
       Http::BufferFilter::generateStats(stats_prefix, context.scope()),
       static_cast<uint64_t>(proto_config.max_request_bytes().value()),
-      std::chrono::seconds(PROTOBUF_GET_SECONDS_REQUIRED(proto_config, max_request_time))});
+      std::chrono::seconds(PROTOBUF_GET_SECONDS_REQUIRED(proto_config, max_request_time)),
+      context.runtime()});
   return [filter_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
     callbacks.addStreamDecoderFilter(
         Http::StreamDecoderFilterSharedPtr{new Http::BufferFilter(filter_config)});
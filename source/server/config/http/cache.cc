@@ -0,0 +1,47 @@
+#include "server/config/http/cache.h"
+
+#include <string>
+
+#include "envoy/registry/registry.h"
+
+#include "common/common/utility.h"
+#include "common/http/filter/cache_filter.h"
+#include "common/json/config_schemas.h"
+#include "common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+HttpFilterFactoryCb CacheFilterConfigFactory::createFilterFactory(const Json::Object& json_config,
+                                                                  const std::string& stats_prefix,
+                                                                  FactoryContext& context) {
+  json_config.validateSchema(Json::Schema::CACHE_HTTP_FILTER_SCHEMA);
+
+  Http::CacheFilterConfigSharedPtr filter_config(new Http::CacheFilterConfig(
+      json_config.getInteger("max_bytes", DEFAULT_MAX_BYTES),
+      json_config.getInteger("max_entry_bytes", DEFAULT_MAX_ENTRY_BYTES),
+      json_config.getBoolean("shared", false),
+      json_config.getInteger("num_shards", DEFAULT_NUM_SHARDS), stats_prefix, context.scope(),
+      context.threadLocal(), ProdMonotonicTimeSource::instance_));
+  return [filter_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    callbacks.addStreamFilter(std::make_shared<Http::CacheFilter>(filter_config));
+  };
+}
+
+HttpFilterFactoryCb
+CacheFilterConfigFactory::createFilterFactoryFromProto(const Protobuf::Message& proto_config,
+                                                       const std::string& stats_prefix,
+                                                       FactoryContext& context) {
+  return createFilterFactory(*MessageUtil::getJsonObjectFromMessage(proto_config), stats_prefix,
+                             context);
+}
+
+/**
+ * Static registration for the cache filter. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<CacheFilterConfigFactory, NamedHttpFilterConfigFactory> register_;
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
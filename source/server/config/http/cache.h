@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+
+#include "envoy/server/filter_config.h"
+
+#include "common/config/well_known_names.h"
+#include "common/protobuf/protobuf.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+/**
+ * Config registration for the cache filter. @see NamedHttpFilterConfigFactory.
+ *
+ * There is no v2 API message for the filter yet, so its v2 config is a google.protobuf.Struct
+ * with the same fields as the v1 JSON config.
+ */
+class CacheFilterConfigFactory : public NamedHttpFilterConfigFactory {
+public:
+  HttpFilterFactoryCb createFilterFactory(const Json::Object& json_config,
+                                          const std::string& stats_prefix,
+                                          FactoryContext& context) override;
+  HttpFilterFactoryCb createFilterFactoryFromProto(const Protobuf::Message& proto_config,
+                                                   const std::string& stats_prefix,
+                                                   FactoryContext& context) override;
+
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override {
+    return ProtobufTypes::MessagePtr{new ProtobufWkt::Struct()};
+  }
+
+  std::string name() override { return Config::HttpFilterNames::get().CACHE; }
+
+  static const uint64_t DEFAULT_MAX_BYTES = 64 * 1024 * 1024;
+  static const uint64_t DEFAULT_MAX_ENTRY_BYTES = 1024 * 1024;
+  static const uint32_t DEFAULT_NUM_SHARDS = 16;
+};
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
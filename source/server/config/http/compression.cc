@@ -0,0 +1,109 @@
+#include "server/config/http/compression.h"
+
+#include <string>
+
+#include "envoy/registry/registry.h"
+
+#include "common/compressor/zlib_compressor_impl.h"
+#include "common/http/filter/compression_filter.h"
+#include "common/json/config_schemas.h"
+#include "common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+namespace {
+
+Compressor::ZlibCompressorImpl::CompressionLevel compressionLevel(const std::string& level) {
+  if (level == "best") {
+    return Compressor::ZlibCompressorImpl::CompressionLevel::Best;
+  } else if (level == "speed") {
+    return Compressor::ZlibCompressorImpl::CompressionLevel::Speed;
+  }
+  return Compressor::ZlibCompressorImpl::CompressionLevel::Standard;
+}
+
+Compressor::ZlibCompressorImpl::CompressionStrategy
+compressionStrategy(const std::string& strategy) {
+  if (strategy == "filtered") {
+    return Compressor::ZlibCompressorImpl::CompressionStrategy::Filtered;
+  } else if (strategy == "huffman") {
+    return Compressor::ZlibCompressorImpl::CompressionStrategy::Huffman;
+  } else if (strategy == "rle") {
+    return Compressor::ZlibCompressorImpl::CompressionStrategy::Rle;
+  }
+  return Compressor::ZlibCompressorImpl::CompressionStrategy::Standard;
+}
+
+Http::CompressionUtility::Encoding encoding(const std::string& content_encoding) {
+  if (content_encoding == "gzip") {
+    return Http::CompressionUtility::Encoding::Gzip;
+  } else if (content_encoding == "deflate") {
+    return Http::CompressionUtility::Encoding::Deflate;
+  } else if (content_encoding == "br") {
+    return Http::CompressionUtility::Encoding::Brotli;
+  }
+  return Http::CompressionUtility::Encoding::Zstd;
+}
+
+} // namespace
+
+const std::vector<std::string>& CompressionFilterConfigFactory::defaultContentTypes() {
+  static const std::vector<std::string>* content_types = new std::vector<std::string>{
+      "application/javascript", "application/json", "application/xml", "image/svg+xml",
+      "text/css",               "text/html",        "text/plain",      "text/xml"};
+  return *content_types;
+}
+
+const std::vector<std::string>& CompressionFilterConfigFactory::defaultContentEncodings() {
+  static const std::vector<std::string>* content_encodings =
+      new std::vector<std::string>{"gzip", "deflate"};
+  return *content_encodings;
+}
+
+HttpFilterFactoryCb
+CompressionFilterConfigFactory::createFilterFactory(const Json::Object& json_config,
+                                                    const std::string& stats_prefix,
+                                                    FactoryContext& context) {
+  json_config.validateSchema(Json::Schema::COMPRESSION_HTTP_FILTER_SCHEMA);
+
+  const std::vector<std::string> content_types = json_config.hasObject("content_type")
+                                                     ? json_config.getStringArray("content_type")
+                                                     : defaultContentTypes();
+  std::vector<Http::CompressionUtility::Encoding> encodings;
+  for (const std::string& content_encoding :
+       json_config.hasObject("content_encoding") ? json_config.getStringArray("content_encoding")
+                                                 : defaultContentEncodings()) {
+    encodings.push_back(encoding(content_encoding));
+  }
+  Http::CompressionFilterConfigSharedPtr filter_config(new Http::CompressionFilterConfig(
+      compressionLevel(json_config.getString("compression_level", "default")),
+      compressionStrategy(json_config.getString("compression_strategy", "default")),
+      json_config.getInteger("window_bits", DEFAULT_WINDOW_BITS),
+      json_config.getInteger("memory_level", DEFAULT_MEMORY_LEVEL),
+      json_config.getInteger("brotli_quality", DEFAULT_BROTLI_QUALITY),
+      json_config.getInteger("zstd_level", DEFAULT_ZSTD_LEVEL), encodings,
+      json_config.getInteger("content_length", DEFAULT_MIN_CONTENT_LENGTH), content_types,
+      stats_prefix, context.scope(), context.threadLocal()));
+  return [filter_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    callbacks.addStreamFilter(std::make_shared<Http::CompressionFilter>(filter_config));
+  };
+}
+
+HttpFilterFactoryCb
+CompressionFilterConfigFactory::createFilterFactoryFromProto(const Protobuf::Message& proto_config,
+                                                             const std::string& stats_prefix,
+                                                             FactoryContext& context) {
+  return createFilterFactory(*MessageUtil::getJsonObjectFromMessage(proto_config), stats_prefix,
+                             context);
+}
+
+/**
+ * Static registration for the compression filter. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<CompressionFilterConfigFactory, NamedHttpFilterConfigFactory>
+    register_;
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "envoy/server/filter_config.h"
+
+#include "common/config/well_known_names.h"
+#include "common/protobuf/protobuf.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+/**
+ * Config registration for the compression filter. @see NamedHttpFilterConfigFactory.
+ *
+ * There is no v2 API message for the filter yet, so its v2 config is a google.protobuf.Struct
+ * with the same fields as the v1 JSON config.
+ */
+class CompressionFilterConfigFactory : public NamedHttpFilterConfigFactory {
+public:
+  HttpFilterFactoryCb createFilterFactory(const Json::Object& json_config,
+                                          const std::string& stats_prefix,
+                                          FactoryContext& context) override;
+  HttpFilterFactoryCb createFilterFactoryFromProto(const Protobuf::Message& proto_config,
+                                                   const std::string& stats_prefix,
+                                                   FactoryContext& context) override;
+
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override {
+    return ProtobufTypes::MessagePtr{new ProtobufWkt::Struct()};
+  }
+
+  std::string name() override { return Config::HttpFilterNames::get().COMPRESSION; }
+
+  static const uint64_t DEFAULT_WINDOW_BITS = 15;
+  static const uint64_t DEFAULT_MEMORY_LEVEL = 8;
+  static const uint64_t DEFAULT_BROTLI_QUALITY = 4;
+  static const uint64_t DEFAULT_ZSTD_LEVEL = 3;
+  static const uint64_t DEFAULT_MIN_CONTENT_LENGTH = 30;
+  static const std::vector<std::string>& defaultContentTypes();
+  // Brotli and zstd are only used if configured, in which case they are usually listed first.
+  static const std::vector<std::string>& defaultContentEncodings();
+};
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
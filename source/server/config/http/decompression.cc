@@ -0,0 +1,43 @@
+#include "server/config/http/decompression.h"
+
+#include <string>
+
+#include "envoy/registry/registry.h"
+
+#include "common/http/filter/decompression_filter.h"
+#include "common/json/config_schemas.h"
+#include "common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+HttpFilterFactoryCb
+DecompressionFilterConfigFactory::createFilterFactory(const Json::Object& json_config,
+                                                      const std::string& stats_prefix,
+                                                      FactoryContext& context) {
+  json_config.validateSchema(Json::Schema::DECOMPRESSION_HTTP_FILTER_SCHEMA);
+
+  Http::DecompressionFilterConfigSharedPtr filter_config(new Http::DecompressionFilterConfig(
+      json_config.getInteger("max_decompressed_bytes", 0), stats_prefix, context.scope()));
+  return [filter_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    callbacks.addStreamDecoderFilter(std::make_shared<Http::DecompressionFilter>(filter_config));
+  };
+}
+
+HttpFilterFactoryCb DecompressionFilterConfigFactory::createFilterFactoryFromProto(
+    const Protobuf::Message& proto_config, const std::string& stats_prefix,
+    FactoryContext& context) {
+  return createFilterFactory(*MessageUtil::getJsonObjectFromMessage(proto_config), stats_prefix,
+                             context);
+}
+
+/**
+ * Static registration for the decompression filter. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<DecompressionFilterConfigFactory, NamedHttpFilterConfigFactory>
+    register_;
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+
+#include "envoy/server/filter_config.h"
+
+#include "common/config/well_known_names.h"
+#include "common/protobuf/protobuf.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+/**
+ * Config registration for the decompression filter. @see NamedHttpFilterConfigFactory.
+ *
+ * There is no v2 API message for the filter yet, so its v2 config is a google.protobuf.Struct
+ * with the same fields as the v1 JSON config.
+ */
+class DecompressionFilterConfigFactory : public NamedHttpFilterConfigFactory {
+public:
+  HttpFilterFactoryCb createFilterFactory(const Json::Object& json_config,
+                                          const std::string& stats_prefix,
+                                          FactoryContext& context) override;
+  HttpFilterFactoryCb createFilterFactoryFromProto(const Protobuf::Message& proto_config,
+                                                   const std::string& stats_prefix,
+                                                   FactoryContext& context) override;
+
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override {
+    return ProtobufTypes::MessagePtr{new ProtobufWkt::Struct()};
+  }
+
+  std::string name() override { return Config::HttpFilterNames::get().DECOMPRESSION; }
+};
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
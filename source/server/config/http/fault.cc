@@ -15,7 +15,8 @@ HttpFilterFactoryCb
 FaultFilterConfig::createFilter(const envoy::api::v2::filter::http::HTTPFault& config,
                                 const std::string& stats_prefix, FactoryContext& context) {
   Http::FaultFilterConfigSharedPtr filter_config(
-      new Http::FaultFilterConfig(config, context.runtime(), stats_prefix, context.scope()));
+      new Http::FaultFilterConfig(config, context.runtime(), stats_prefix, context.scope(),
+                                  context.threadLocal()));
   return [filter_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
     callbacks.addStreamDecoderFilter(
         Http::StreamDecoderFilterSharedPtr{new Http::FaultFilter(filter_config)});
@@ -0,0 +1,68 @@
+#include "server/config/http/local_ratelimit.h"
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "envoy/registry/registry.h"
+
+#include "common/http/filter/local_ratelimit_filter.h"
+#include "common/json/config_schemas.h"
+#include "common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+namespace {
+
+RateLimit::TokenBucket tokenBucket(const Json::Object& json_config) {
+  const uint32_t max_tokens = json_config.getInteger("max_tokens");
+  return {max_tokens, static_cast<uint32_t>(json_config.getInteger("tokens_per_fill", max_tokens))};
+}
+
+} // namespace
+
+HttpFilterFactoryCb
+LocalRateLimitFilterConfigFactory::createFilterFactory(const Json::Object& json_config,
+                                                       const std::string& stats_prefix,
+                                                       FactoryContext& context) {
+  json_config.validateSchema(Json::Schema::LOCAL_RATE_LIMIT_HTTP_FILTER_SCHEMA);
+
+  std::vector<std::pair<RateLimit::Descriptor, RateLimit::TokenBucket>> descriptors;
+  for (const Json::ObjectSharedPtr& descriptor_config :
+       json_config.getObjectArray("descriptors", true)) {
+    RateLimit::Descriptor descriptor;
+    for (const Json::ObjectSharedPtr& entry : descriptor_config->getObjectArray("entries")) {
+      descriptor.entries_.push_back({entry->getString("key"), entry->getString("value")});
+    }
+    descriptors.emplace_back(descriptor, tokenBucket(*descriptor_config));
+  }
+
+  Http::LocalRateLimitFilterConfigSharedPtr filter_config(new Http::LocalRateLimitFilterConfig(
+      std::chrono::milliseconds(
+          json_config.getInteger("fill_interval_ms", DEFAULT_FILL_INTERVAL_MS)),
+      tokenBucket(json_config), descriptors, json_config.getInteger("stage", 0), stats_prefix,
+      context.scope(), context.localInfo(), context.threadLocal()));
+  return [filter_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    callbacks.addStreamDecoderFilter(std::make_shared<Http::LocalRateLimitFilter>(filter_config));
+  };
+}
+
+HttpFilterFactoryCb LocalRateLimitFilterConfigFactory::createFilterFactoryFromProto(
+    const Protobuf::Message& proto_config, const std::string& stats_prefix,
+    FactoryContext& context) {
+  return createFilterFactory(*MessageUtil::getJsonObjectFromMessage(proto_config), stats_prefix,
+                             context);
+}
+
+/**
+ * Static registration for the local rate limit filter. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<LocalRateLimitFilterConfigFactory, NamedHttpFilterConfigFactory>
+    register_;
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
@@ -0,0 +1,28 @@
+#include "server/config/http/on_demand.h"
+
+#include <string>
+
+#include "envoy/registry/registry.h"
+
+#include "common/http/filter/on_demand_filter.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+HttpFilterFactoryCb OnDemandFilterConfig::createFilter(const std::string&,
+                                                       FactoryContext& context) {
+  return [&context](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    callbacks.addStreamDecoderFilter(
+        std::make_shared<Http::OnDemandClusterFilter>(context.clusterManager()));
+  };
+}
+
+/**
+ * Static registration for the on-demand cluster filter. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<OnDemandFilterConfig, NamedHttpFilterConfigFactory> register_;
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
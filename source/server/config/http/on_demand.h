@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+#include "envoy/server/filter_config.h"
+
+#include "common/config/well_known_names.h"
+
+#include "server/config/http/empty_http_filter_config.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+/**
+ * Config registration for the on-demand cluster filter. @see NamedHttpFilterConfigFactory.
+ */
+class OnDemandFilterConfig : public EmptyHttpFilterConfig {
+public:
+  HttpFilterFactoryCb createFilter(const std::string&, FactoryContext& context) override;
+
+  std::string name() override { return Config::HttpFilterNames::get().ON_DEMAND; }
+};
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
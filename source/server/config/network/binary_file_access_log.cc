@@ -0,0 +1,47 @@
+#include "server/config/network/binary_file_access_log.h"
+
+#include "envoy/common/exception.h"
+#include "envoy/registry/registry.h"
+#include "envoy/server/filter_config.h"
+
+#include "common/access_log/binary_access_log_impl.h"
+#include "common/config/well_known_names.h"
+#include "common/protobuf/protobuf.h"
+#include "common/protobuf/utility.h"
+
+#include "api/filter/accesslog/accesslog.pb.validate.h"
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+AccessLog::InstanceSharedPtr BinaryFileAccessLogFactory::createAccessLogInstance(
+    const Protobuf::Message& config, AccessLog::FilterPtr&& filter, FactoryContext& context) {
+  // The file access log config is reused for its path; entries have a fixed binary form.
+  const auto& fal_config =
+      MessageUtil::downcastAndValidate<const envoy::api::v2::filter::accesslog::FileAccessLog&>(
+          config);
+  if (!fal_config.format().empty()) {
+    throw EnvoyException(fmt::format("{} does not take a format", name()));
+  }
+  return AccessLog::InstanceSharedPtr{new AccessLog::BinaryFileAccessLog(
+      fal_config.path(), std::move(filter), context.accessLogManager())};
+}
+
+ProtobufTypes::MessagePtr BinaryFileAccessLogFactory::createEmptyConfigProto() {
+  return ProtobufTypes::MessagePtr{new envoy::api::v2::filter::accesslog::FileAccessLog()};
+}
+
+std::string BinaryFileAccessLogFactory::name() const {
+  return Config::AccessLogNames::get().BINARY_FILE;
+}
+
+/**
+ * Static registration for the binary file access log. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<BinaryFileAccessLogFactory, AccessLogInstanceFactory> register_;
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
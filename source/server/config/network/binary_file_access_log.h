@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+#include "envoy/server/access_log_config.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+/**
+ * Config registration for the binary file access log. @see AccessLogInstanceFactory.
+ */
+class BinaryFileAccessLogFactory : public AccessLogInstanceFactory {
+public:
+  AccessLog::InstanceSharedPtr createAccessLogInstance(const Protobuf::Message& config,
+                                                       AccessLog::FilterPtr&& filter,
+                                                       FactoryContext& context) override;
+
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override;
+
+  std::string name() const override;
+};
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
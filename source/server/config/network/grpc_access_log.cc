@@ -0,0 +1,54 @@
+#include "server/config/network/grpc_access_log.h"
+
+#include "envoy/registry/registry.h"
+#include "envoy/server/filter_config.h"
+
+#include "common/access_log/grpc_access_log_impl.h"
+#include "common/common/macros.h"
+#include "common/config/well_known_names.h"
+#include "common/grpc/async_client_impl.h"
+#include "common/protobuf/protobuf.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+AccessLog::InstanceSharedPtr HttpGrpcAccessLogFactory::createAccessLogInstance(
+    const Protobuf::Message& config, AccessLog::FilterPtr&& filter, FactoryContext& context) {
+  const auto& grpc_config =
+      dynamic_cast<const envoy::access_log::HttpGrpcAccessLogConfig&>(config);
+  const std::string cluster_name = grpc_config.cluster_name();
+  if (!context.clusterManager().get(cluster_name)) {
+    throw EnvoyException(fmt::format("unknown access log service cluster '{}'", cluster_name));
+  }
+
+  Upstream::ClusterManager& cm = context.clusterManager();
+  return AccessLog::InstanceSharedPtr{new AccessLog::HttpGrpcAccessLog(
+      std::move(filter), grpc_config, context.threadLocal(),
+      [&cm, cluster_name]() -> AccessLog::AccessLogServiceAsyncClientPtr {
+        return AccessLog::AccessLogServiceAsyncClientPtr{
+            new Grpc::AsyncClientImpl<envoy::access_log::StreamAccessLogsMessage,
+                                      envoy::access_log::StreamAccessLogsResponse>(cm,
+                                                                                   cluster_name)};
+      },
+      context.localInfo(), context.scope())};
+}
+
+ProtobufTypes::MessagePtr HttpGrpcAccessLogFactory::createEmptyConfigProto() {
+  return ProtobufTypes::MessagePtr{new envoy::access_log::HttpGrpcAccessLogConfig()};
+}
+
+std::string HttpGrpcAccessLogFactory::name() const {
+  return Config::AccessLogNames::get().HTTP_GRPC;
+}
+
+/**
+ * Static registration for the HTTP gRPC access log. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<HttpGrpcAccessLogFactory, AccessLogInstanceFactory> register_;
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
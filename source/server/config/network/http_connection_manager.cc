@@ -42,8 +42,7 @@ NetworkFilterFactoryCb HttpConnectionManagerFilterConfigFactory::createFilter(
   std::shared_ptr<Http::TlsCachingDateProviderImpl> date_provider =
       context.singletonManager().getTyped<Http::TlsCachingDateProviderImpl>(
           SINGLETON_MANAGER_REGISTERED_NAME(date_provider), [&context] {
-            return std::make_shared<Http::TlsCachingDateProviderImpl>(context.dispatcher(),
-                                                                      context.threadLocal());
+            return std::make_shared<Http::TlsCachingDateProviderImpl>(context.dispatcher());
           });
 
   std::shared_ptr<Router::RouteConfigProviderManager> route_config_provider_manager =
@@ -64,7 +63,8 @@ NetworkFilterFactoryCb HttpConnectionManagerFilterConfigFactory::createFilter(
           date_provider](Network::FilterManager& filter_manager) -> void {
     filter_manager.addReadFilter(Network::ReadFilterSharedPtr{new Http::ConnectionManagerImpl(
         *filter_config, context.drainDecision(), context.random(), context.httpTracer(),
-        context.runtime(), context.localInfo(), context.clusterManager())});
+        context.runtime(), context.localInfo(), context.clusterManager(),
+        context.overloadManager())});
   };
 }
 
@@ -248,21 +248,28 @@ Http::ServerConnectionPtr
 HttpConnectionManagerConfig::createCodec(Network::Connection& connection,
                                          const Buffer::Instance& data,
                                          Http::ServerConnectionCallbacks& callbacks) {
+  Http::Http1Settings http1_settings = http1_settings_;
+  http1_settings.fast_request_head_parsing_ =
+      context_.runtime().snapshot().featureEnabled("http.http1.fast_request_head_parsing", 100);
+  Http::Http2Settings http2_settings = http2_settings_;
+  http2_settings.window_auto_tuning_ =
+      context_.runtime().snapshot().featureEnabled("http.http2.window_auto_tuning", 0);
+
   switch (codec_type_) {
   case CodecType::HTTP1:
     return Http::ServerConnectionPtr{
-        new Http::Http1::ServerConnectionImpl(connection, callbacks, http1_settings_)};
+        new Http::Http1::ServerConnectionImpl(connection, callbacks, http1_settings)};
   case CodecType::HTTP2:
     return Http::ServerConnectionPtr{new Http::Http2::ServerConnectionImpl(
-        connection, callbacks, context_.scope(), http2_settings_)};
+        connection, callbacks, context_.scope(), http2_settings)};
   case CodecType::AUTO:
     if (HttpConnectionManagerConfigUtility::determineNextProtocol(connection, data) ==
         Http::Http2::ALPN_STRING) {
       return Http::ServerConnectionPtr{new Http::Http2::ServerConnectionImpl(
-          connection, callbacks, context_.scope(), http2_settings_)};
+          connection, callbacks, context_.scope(), http2_settings)};
     } else {
       return Http::ServerConnectionPtr{
-          new Http::Http1::ServerConnectionImpl(connection, callbacks, http1_settings_)};
+          new Http::Http1::ServerConnectionImpl(connection, callbacks, http1_settings)};
     }
   }
 
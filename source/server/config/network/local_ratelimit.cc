@@ -0,0 +1,51 @@
+#include "server/config/network/local_ratelimit.h"
+
+#include <chrono>
+#include <string>
+
+#include "envoy/network/connection.h"
+#include "envoy/registry/registry.h"
+
+#include "common/filter/local_ratelimit.h"
+#include "common/json/config_schemas.h"
+#include "common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+NetworkFilterFactoryCb
+LocalRateLimitConfigFactory::createFilterFactory(const Json::Object& json_config,
+                                                 FactoryContext& context) {
+  json_config.validateSchema(Json::Schema::LOCAL_RATELIMIT_NETWORK_FILTER_SCHEMA);
+
+  const uint32_t max_tokens = json_config.getInteger("max_tokens");
+  const RateLimit::TokenBucket bucket{
+      max_tokens, static_cast<uint32_t>(json_config.getInteger("tokens_per_fill", max_tokens))};
+  RateLimit::TcpFilter::LocalRateLimitConfigSharedPtr filter_config(
+      new RateLimit::TcpFilter::LocalRateLimitConfig(
+          std::chrono::milliseconds(
+              json_config.getInteger("fill_interval_ms", DEFAULT_FILL_INTERVAL_MS)),
+          bucket, json_config.getString("stat_prefix"), context.scope(), context.threadLocal()));
+
+  return [filter_config](Network::FilterManager& filter_manager) -> void {
+    filter_manager.addReadFilter(Network::ReadFilterSharedPtr{
+        new RateLimit::TcpFilter::LocalRateLimitFilter(filter_config)});
+  };
+}
+
+NetworkFilterFactoryCb
+LocalRateLimitConfigFactory::createFilterFactoryFromProto(const Protobuf::Message& proto_config,
+                                                          FactoryContext& context) {
+  return createFilterFactory(*MessageUtil::getJsonObjectFromMessage(proto_config), context);
+}
+
+/**
+ * Static registration for the local rate limit filter. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<LocalRateLimitConfigFactory, NamedNetworkFilterConfigFactory>
+    registered_;
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
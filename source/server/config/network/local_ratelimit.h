@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+
+#include "envoy/server/filter_config.h"
+
+#include "common/config/well_known_names.h"
+#include "common/protobuf/protobuf.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+/**
+ * Config registration for the local rate limit filter. @see NamedNetworkFilterConfigFactory.
+ *
+ * There is no v2 API message for the filter yet, so its v2 config is a google.protobuf.Struct
+ * with the same fields as the v1 JSON config.
+ */
+class LocalRateLimitConfigFactory : public NamedNetworkFilterConfigFactory {
+public:
+  // NamedNetworkFilterConfigFactory
+  NetworkFilterFactoryCb createFilterFactory(const Json::Object& json_config,
+                                             FactoryContext& context) override;
+
+  NetworkFilterFactoryCb createFilterFactoryFromProto(const Protobuf::Message& proto_config,
+                                                      FactoryContext& context) override;
+
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override {
+    return ProtobufTypes::MessagePtr{new ProtobufWkt::Struct()};
+  }
+
+  std::string name() override { return Config::NetworkFilterNames::get().LOCAL_RATE_LIMIT; }
+
+  static const uint64_t DEFAULT_FILL_INTERVAL_MS = 1000;
+};
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
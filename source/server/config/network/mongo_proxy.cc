@@ -36,8 +36,8 @@ NetworkFilterFactoryCb MongoProxyFilterConfigFactory::createFilter(
   return [stat_prefix, &context, access_log,
           fault_config](Network::FilterManager& filter_manager) -> void {
     filter_manager.addFilter(std::make_shared<Mongo::ProdProxyFilter>(
-        stat_prefix, context.scope(), context.runtime(), access_log, fault_config,
-        context.drainDecision()));
+        stat_prefix, context.scope(), context.runtime(), context.random(), access_log,
+        fault_config, context.drainDecision()));
   };
 }
 
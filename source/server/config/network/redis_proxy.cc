@@ -5,10 +5,12 @@
 
 #include "envoy/registry/registry.h"
 
+#include "common/common/utility.h"
 #include "common/config/filter_json.h"
 #include "common/redis/codec_impl.h"
 #include "common/redis/command_splitter_impl.h"
 #include "common/redis/conn_pool_impl.h"
+#include "common/redis/hot_key_cache.h"
 #include "common/redis/proxy_filter.h"
 
 #include "api/filter/network/redis_proxy.pb.validate.h"
@@ -30,10 +32,16 @@ NetworkFilterFactoryCb RedisProxyFilterConfigFactory::createFilter(
   Redis::ConnPool::InstancePtr conn_pool(
       new Redis::ConnPool::InstanceImpl(filter_config->cluster_name_, context.clusterManager(),
                                         Redis::ConnPool::ClientFactoryImpl::instance_,
-                                        context.threadLocal(), proto_config.settings()));
+                                        context.threadLocal(), context.runtime(),
+                                        proto_config.settings()));
+  Redis::HotKeyCachePtr hot_key_cache(
+      new Redis::HotKeyCache(context.threadLocal(), context.runtime(),
+                             ProdMonotonicTimeSource::instance_, context.scope(),
+                             filter_config->stat_prefix_));
   std::shared_ptr<Redis::CommandSplitter::Instance> splitter(
       new Redis::CommandSplitter::InstanceImpl(std::move(conn_pool), context.scope(),
-                                               filter_config->stat_prefix_));
+                                               filter_config->stat_prefix_,
+                                               std::move(hot_key_cache)));
   return [splitter, filter_config](Network::FilterManager& filter_manager) -> void {
     Redis::DecoderFactoryImpl factory;
     filter_manager.addReadFilter(std::make_shared<Redis::ProxyFilter>(
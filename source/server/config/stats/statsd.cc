@@ -25,8 +25,8 @@ Stats::SinkPtr StatsdSinkFactory::createStatsSink(const Protobuf::Message& confi
     Network::Address::InstanceConstSharedPtr address =
         Network::Address::resolveProtoAddress(statsd_sink.address());
     ENVOY_LOG(debug, "statsd UDP ip address: {}", address->asString());
-    return Stats::SinkPtr(
-        new Stats::Statsd::UdpStatsdSink(server.threadLocal(), std::move(address)));
+    return Stats::SinkPtr(new Stats::Statsd::UdpStatsdSink(
+        server.threadLocal(), std::move(address), server.options().statsdUdpMaxDatagramSize()));
     break;
   }
   case envoy::api::v2::StatsdSink::kTcpClusterName:
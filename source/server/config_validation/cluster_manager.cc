@@ -1,5 +1,7 @@
 #include "server/config_validation/cluster_manager.h"
 
+#include <chrono>
+
 namespace Envoy {
 namespace Upstream {
 
@@ -19,6 +21,16 @@ ClusterManagerPtr ValidationClusterManagerFactory::clusterManagerFromProto(
       bootstrap, *this, stats, tls, runtime, random, local_info, log_manager, primary_dispatcher_)};
 }
 
+ClusterSharedPtr ValidationClusterManagerFactory::clusterFromProto(
+    const envoy::api::v2::Cluster& cluster, ClusterManager& cm,
+    Outlier::EventLoggerSharedPtr outlier_event_logger, bool added_via_api) {
+  const auto start = std::chrono::steady_clock::now();
+  ClusterSharedPtr result = ProdClusterManagerFactory::clusterFromProto(
+      cluster, cm, outlier_event_logger, added_via_api);
+  cluster_timing_.add(cluster.name(), std::chrono::steady_clock::now() - start);
+  return result;
+}
+
 CdsApiPtr
 ValidationClusterManagerFactory::createCds(const envoy::api::v2::ConfigSource& cds_config,
                                            const Optional<envoy::api::v2::ConfigSource>& eds_config,
@@ -43,6 +55,12 @@ ValidationClusterManager::httpConnPoolForCluster(const std::string&, ResourcePri
   return nullptr;
 }
 
+Http::ConnectionPool::Instance*
+ValidationClusterManager::httpConnPoolForClusterHandle(uint32_t, ResourcePriority,
+                                                       LoadBalancerContext*) {
+  return nullptr;
+}
+
 Host::CreateConnectionData ValidationClusterManager::tcpConnForCluster(const std::string&,
                                                                        LoadBalancerContext*) {
   return Host::CreateConnectionData{nullptr, nullptr};
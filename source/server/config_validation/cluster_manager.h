@@ -5,13 +5,15 @@
 #include "common/upstream/cluster_manager_impl.h"
 
 #include "server/config_validation/async_client.h"
+#include "server/config_validation/timing.h"
 
 namespace Envoy {
 namespace Upstream {
 
 /**
  * Config-validation-only implementation of ClusterManagerFactory, which creates
- * ValidationClusterManagers. It also creates, but never returns, CdsApiImpls.
+ * ValidationClusterManagers. It also creates, but never returns, CdsApiImpls, and times the loading
+ * of each cluster.
  */
 class ValidationClusterManagerFactory : public ProdClusterManagerFactory {
 public:
@@ -29,11 +31,21 @@ public:
                                             const LocalInfo::LocalInfo& local_info,
                                             AccessLog::AccessLogManager& log_manager) override;
 
+  // Delegates to ProdClusterManagerFactory::clusterFromProto, recording the time it takes.
+  ClusterSharedPtr clusterFromProto(const envoy::api::v2::Cluster& cluster, ClusterManager& cm,
+                                    Outlier::EventLoggerSharedPtr outlier_event_logger,
+                                    bool added_via_api) override;
+
   // Delegates to ProdClusterManagerFactory::createCds, but discards the result and returns nullptr
   // unconditionally.
   CdsApiPtr createCds(const envoy::api::v2::ConfigSource& cds_config,
                       const Optional<envoy::api::v2::ConfigSource>& eds_config,
                       ClusterManager& cm) override;
+
+  const Server::ValidationTiming& clusterTiming() const { return cluster_timing_; }
+
+private:
+  Server::ValidationTiming cluster_timing_;
 };
 
 /**
@@ -49,6 +61,8 @@ public:
 
   Http::ConnectionPool::Instance* httpConnPoolForCluster(const std::string&, ResourcePriority,
                                                          LoadBalancerContext*) override;
+  Http::ConnectionPool::Instance* httpConnPoolForClusterHandle(uint32_t, ResourcePriority,
+                                                               LoadBalancerContext*) override;
   Host::CreateConnectionData tcpConnForCluster(const std::string&, LoadBalancerContext*) override;
   Http::AsyncClient& httpAsyncClientForCluster(const std::string&) override;
 
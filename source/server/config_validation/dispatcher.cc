@@ -38,5 +38,11 @@ ValidationDispatcher::createSslListener(Network::ConnectionHandler&, Ssl::Server
   NOT_IMPLEMENTED;
 }
 
+Network::UdpListenerPtr ValidationDispatcher::createUdpListener(Network::ListenSocket&,
+                                                                Network::UdpListenerCallbacks&,
+                                                                Stats::Scope&) {
+  NOT_IMPLEMENTED;
+}
+
 } // namespace Event
 } // namespace Envoy
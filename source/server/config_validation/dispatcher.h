@@ -28,6 +28,8 @@ public:
   Network::ListenerPtr createSslListener(Network::ConnectionHandler&, Ssl::ServerContext&,
                                          Network::ListenSocket&, Network::ListenerCallbacks&,
                                          Stats::Scope&, const Network::ListenerOptions&) override;
+  Network::UdpListenerPtr createUdpListener(Network::ListenSocket&, Network::UdpListenerCallbacks&,
+                                            Stats::Scope&) override;
 };
 
 } // namespace Event
@@ -1,5 +1,11 @@
 #include "server/config_validation/server.h"
 
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "common/common/thread.h"
 #include "common/common/version.h"
 #include "common/config/bootstrap_json.h"
 #include "common/config/utility.h"
@@ -15,15 +21,27 @@
 namespace Envoy {
 namespace Server {
 
-bool validateConfig(Options& options, Network::Address::InstanceConstSharedPtr local_address,
-                    ComponentFactory& component_factory) {
+namespace {
+
+/**
+ * Validate a config on the calling thread.
+ * @param bootstrap supplies the bootstrap to validate, or nullptr to load it from the config path.
+ * @param cluster_timing supplies the timing to add the clusters of the config to.
+ * @param listener_timing supplies the timing to add the listeners of the config to.
+ * @return bool whether the config is valid.
+ */
+bool validateOnThread(Options& options, Network::Address::InstanceConstSharedPtr local_address,
+                      ComponentFactory& component_factory,
+                      const envoy::api::v2::Bootstrap* bootstrap, ValidationTiming& cluster_timing,
+                      ValidationTiming& listener_timing) {
   Thread::MutexBasicLockable access_log_lock;
   Stats::IsolatedStoreImpl stats_store;
 
   try {
     ValidationInstance server(options, local_address, stats_store, access_log_lock,
-                              component_factory);
-    std::cout << "configuration '" << options.configPath() << "' OK" << std::endl;
+                              component_factory, bootstrap);
+    cluster_timing.merge(server.clusterTiming());
+    listener_timing.merge(server.listenerTiming());
     server.shutdown();
     return true;
   } catch (const EnvoyException& e) {
@@ -31,18 +49,93 @@ bool validateConfig(Options& options, Network::Address::InstanceConstSharedPtr l
   }
 }
 
+/**
+ * Validate a config on several threads. The listeners are independent of each other, so each
+ * thread validates the config with a share of them. The clusters, which the listeners refer to, are
+ * loaded by every thread, but only timed on the first one.
+ */
+bool validateConcurrently(Options& options, Network::Address::InstanceConstSharedPtr local_address,
+                          ComponentFactory& component_factory, ValidationTiming& cluster_timing,
+                          ValidationTiming& listener_timing) {
+  envoy::api::v2::Bootstrap bootstrap;
+  try {
+    ValidationInstance::loadBootstrap(options, bootstrap);
+  } catch (const EnvoyException& e) {
+    ENVOY_LOG_MISC(critical, "error initializing configuration '{}': {}", options.configPath(),
+                   e.what());
+    return false;
+  }
+
+  Protobuf::RepeatedPtrField<envoy::api::v2::Listener> listeners;
+  listeners.Swap(bootstrap.mutable_static_resources()->mutable_listeners());
+  const uint32_t num_threads =
+      std::max(1U, std::min<uint32_t>(options.validationThreads(), listeners.size()));
+  std::vector<envoy::api::v2::Bootstrap> bootstraps(num_threads, bootstrap);
+  for (int i = 0; i < listeners.size(); i++) {
+    bootstraps[i % num_threads].mutable_static_resources()->add_listeners()->Swap(
+        listeners.Mutable(i));
+  }
+
+  std::vector<ValidationTiming> cluster_timings(num_threads);
+  std::vector<ValidationTiming> listener_timings(num_threads);
+  std::unique_ptr<bool[]> valid(new bool[num_threads]());
+  std::vector<Thread::ThreadPtr> threads;
+  for (uint32_t i = 0; i < num_threads; i++) {
+    threads.emplace_back(new Thread::Thread([&, i]() -> void {
+      valid[i] = validateOnThread(options, local_address, component_factory, &bootstraps[i],
+                                  cluster_timings[i], listener_timings[i]);
+    }));
+  }
+
+  bool all_valid = true;
+  for (uint32_t i = 0; i < num_threads; i++) {
+    threads[i]->join();
+    all_valid = all_valid && valid[i];
+    listener_timing.merge(listener_timings[i]);
+  }
+  cluster_timing.merge(cluster_timings[0]);
+  return all_valid;
+}
+
+} // namespace
+
+bool validateConfig(Options& options, Network::Address::InstanceConstSharedPtr local_address,
+                    ComponentFactory& component_factory) {
+  const auto start = std::chrono::steady_clock::now();
+  ValidationTiming cluster_timing;
+  ValidationTiming listener_timing;
+  const bool valid = options.validationThreads() > 1
+                         ? validateConcurrently(options, local_address, component_factory,
+                                                cluster_timing, listener_timing)
+                         : validateOnThread(options, local_address, component_factory, nullptr,
+                                            cluster_timing, listener_timing);
+  if (!valid) {
+    return false;
+  }
+
+  std::cout << "configuration '" << options.configPath() << "' OK" << std::endl;
+  ENVOY_LOG_MISC(info, "validated clusters: {}", cluster_timing.summary());
+  ENVOY_LOG_MISC(info, "validated listeners, including their filters and route configurations: {}",
+                 listener_timing.summary());
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  ENVOY_LOG_MISC(info, "validated configuration in {} ms",
+                 std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+  return true;
+}
+
 ValidationInstance::ValidationInstance(Options& options,
                                        Network::Address::InstanceConstSharedPtr local_address,
                                        Stats::IsolatedStoreImpl& store,
                                        Thread::BasicLockable& access_log_lock,
-                                       ComponentFactory& component_factory)
+                                       ComponentFactory& component_factory,
+                                       const envoy::api::v2::Bootstrap* bootstrap)
     : options_(options), stats_store_(store),
       api_(new Api::ValidationImpl(options.fileFlushIntervalMsec())),
       dispatcher_(api_->allocateDispatcher()), singleton_manager_(new Singleton::ManagerImpl()),
       access_log_manager_(*api_, *dispatcher_, access_log_lock, store),
       listener_manager_(*this, *this, *this) {
   try {
-    initialize(options, local_address, component_factory);
+    initialize(options, local_address, component_factory, bootstrap);
   } catch (const EnvoyException& e) {
     ENVOY_LOG(critical, "error initializing configuration '{}': {}", options.configPath(),
               e.what());
@@ -51,20 +144,7 @@ ValidationInstance::ValidationInstance(Options& options,
   }
 }
 
-void ValidationInstance::initialize(Options& options,
-                                    Network::Address::InstanceConstSharedPtr local_address,
-                                    ComponentFactory& component_factory) {
-  // See comments on InstanceImpl::initialize() for the overall flow here.
-  //
-  // For validation, we only do a subset of normal server initialization: everything that could fail
-  // on a malformed config (e.g. JSON parsing and all the object construction that follows), but
-  // more importantly nothing with observable effects (e.g. binding to ports or shutting down any
-  // other Envoy process).
-  //
-  // If we get all the way through that stripped-down initialization flow, to the point where we'd
-  // be ready to serve, then the config has passed validation.
-  // Handle configuration that needs to take place prior to the main configuration load.
-  envoy::api::v2::Bootstrap bootstrap;
+void ValidationInstance::loadBootstrap(Options& options, envoy::api::v2::Bootstrap& bootstrap) {
   bool v2_config_loaded = false;
   try {
     MessageUtil::loadFromFileAndValidate(options.configPath(), bootstrap);
@@ -81,6 +161,28 @@ void ValidationInstance::initialize(Options& options,
     Json::ObjectSharedPtr config_json = Json::Factory::loadFromFile(options.configPath());
     Config::BootstrapJson::translateBootstrap(*config_json, bootstrap);
   }
+}
+
+void ValidationInstance::initialize(Options& options,
+                                    Network::Address::InstanceConstSharedPtr local_address,
+                                    ComponentFactory& component_factory,
+                                    const envoy::api::v2::Bootstrap* config_bootstrap) {
+  // See comments on InstanceImpl::initialize() for the overall flow here.
+  //
+  // For validation, we only do a subset of normal server initialization: everything that could fail
+  // on a malformed config (e.g. JSON parsing and all the object construction that follows), but
+  // more importantly nothing with observable effects (e.g. binding to ports or shutting down any
+  // other Envoy process).
+  //
+  // If we get all the way through that stripped-down initialization flow, to the point where we'd
+  // be ready to serve, then the config has passed validation.
+  // Handle configuration that needs to take place prior to the main configuration load.
+  envoy::api::v2::Bootstrap bootstrap;
+  if (config_bootstrap != nullptr) {
+    bootstrap = *config_bootstrap;
+  } else {
+    loadBootstrap(options, bootstrap);
+  }
 
   tag_extractors_ = Config::Utility::createTagExtractors(bootstrap);
 
@@ -98,9 +200,17 @@ void ValidationInstance::initialize(Options& options,
       runtime(), stats(), threadLocal(), random(), dnsResolver(), sslContextManager(), dispatcher(),
       localInfo()));
 
+  // The static listeners are added here rather than by the main config, so that each is timed.
+  Protobuf::RepeatedPtrField<envoy::api::v2::Listener> listeners;
+  listeners.Swap(bootstrap.mutable_static_resources()->mutable_listeners());
   Configuration::MainImpl* main_config = new Configuration::MainImpl();
   config_.reset(main_config);
   main_config->initialize(bootstrap, *this, *cluster_manager_factory_);
+  for (const envoy::api::v2::Listener& listener : listeners) {
+    const auto start = std::chrono::steady_clock::now();
+    listener_manager_.addOrUpdateListener(listener);
+    listener_timing_.add(listener.name(), std::chrono::steady_clock::now() - start);
+  }
 
   clusterManager().setInitializedCb(
       [this]() -> void { init_manager_.initialize([]() -> void {}); });
@@ -20,16 +20,21 @@
 #include "server/config_validation/api.h"
 #include "server/config_validation/cluster_manager.h"
 #include "server/config_validation/dns.h"
+#include "server/config_validation/timing.h"
 #include "server/http/admin.h"
 #include "server/listener_manager_impl.h"
 #include "server/server.h"
 
+#include "api/bootstrap.pb.h"
+
 namespace Envoy {
 namespace Server {
 
 /**
  * validateConfig() takes over from main() for a config-validation run of Envoy. It returns true if
- * the config is valid, false if invalid.
+ * the config is valid, false if invalid. With several validation threads, the listeners are split
+ * between threads which each validate the rest of the config along with their share of them. The
+ * time taken to load the clusters and the listeners is logged.
  */
 bool validateConfig(Options& options, Network::Address::InstanceConstSharedPtr local_address,
                     ComponentFactory& component_factory);
@@ -51,9 +56,24 @@ class ValidationInstance : Logger::Loggable<Logger::Id::main>,
                            public ListenerComponentFactory,
                            public WorkerFactory {
 public:
+  /**
+   * @param bootstrap supplies the bootstrap to validate, or nullptr to load it from the config path
+   *        of the options.
+   */
   ValidationInstance(Options& options, Network::Address::InstanceConstSharedPtr local_address,
                      Stats::IsolatedStoreImpl& store, Thread::BasicLockable& access_log_lock,
-                     ComponentFactory& component_factory);
+                     ComponentFactory& component_factory,
+                     const envoy::api::v2::Bootstrap* bootstrap = nullptr);
+
+  /**
+   * Load the bootstrap from the config path of the options, as v2 or else as v1.
+   */
+  static void loadBootstrap(Options& options, envoy::api::v2::Bootstrap& bootstrap);
+
+  const ValidationTiming& clusterTiming() const {
+    return cluster_manager_factory_->clusterTiming();
+  }
+  const ValidationTiming& listenerTiming() const { return listener_timing_; }
 
   // Server::Instance
   Admin& admin() override { return admin_; }
@@ -81,6 +101,7 @@ public:
   Singleton::Manager& singletonManager() override { return *singleton_manager_; }
   bool healthCheckFailed() override { NOT_IMPLEMENTED; }
   Options& options() override { return options_; }
+  OverloadManager& overloadManager() override { NOT_IMPLEMENTED; }
   time_t startTimeCurrentEpoch() override { NOT_IMPLEMENTED; }
   time_t startTimeFirstEpoch() override { NOT_IMPLEMENTED; }
   Stats::Store& stats() override { return stats_store_; }
@@ -95,7 +116,7 @@ public:
     return ProdListenerComponentFactory::createFilterFactoryList_(filters, context);
   }
   Network::ListenSocketSharedPtr createListenSocket(Network::Address::InstanceConstSharedPtr,
-                                                    bool) override {
+                                                    bool, bool, uint32_t) override {
     // Returned sockets are not currently used so we can return nothing here safely vs. a
     // validation mock.
     return nullptr;
@@ -106,7 +127,7 @@ public:
   uint64_t nextListenerTag() override { return 0; }
 
   // Server::WorkerFactory
-  WorkerPtr createWorker() override {
+  WorkerPtr createWorker(uint32_t) override {
     // Returned workers are not currently used so we can return nothing here safely vs. a
     // validation mock.
     return nullptr;
@@ -114,7 +135,7 @@ public:
 
 private:
   void initialize(Options& options, Network::Address::InstanceConstSharedPtr local_address,
-                  ComponentFactory& component_factory);
+                  ComponentFactory& component_factory, const envoy::api::v2::Bootstrap* bootstrap);
 
   Options& options_;
   Stats::IsolatedStoreImpl& stats_store_;
@@ -134,6 +155,7 @@ private:
   std::unique_ptr<Upstream::ValidationClusterManagerFactory> cluster_manager_factory_;
   InitManagerImpl init_manager_;
   ListenerManagerImpl listener_manager_;
+  ValidationTiming listener_timing_;
 };
 
 } // namespace Server
@@ -0,0 +1,39 @@
+#include "server/config_validation/timing.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Server {
+
+void ValidationTiming::add(const std::string& name, std::chrono::steady_clock::duration duration) {
+  count_++;
+  total_ += duration;
+  if (count_ == 1 || duration > slowest_) {
+    slowest_name_ = name;
+    slowest_ = duration;
+  }
+}
+
+void ValidationTiming::merge(const ValidationTiming& other) {
+  if (other.count_ == 0) {
+    return;
+  }
+  if (count_ == 0 || other.slowest_ > slowest_) {
+    slowest_name_ = other.slowest_name_;
+    slowest_ = other.slowest_;
+  }
+  count_ += other.count_;
+  total_ += other.total_;
+}
+
+std::string ValidationTiming::summary() const {
+  typedef std::chrono::duration<double, std::milli> Milliseconds;
+  if (count_ == 0) {
+    return "0";
+  }
+  return fmt::format("{} in {:.1f} ms, slowest '{}' in {:.1f} ms", count_,
+                     Milliseconds(total_).count(), slowest_name_, Milliseconds(slowest_).count());
+}
+
+} // namespace Server
+} // namespace Envoy
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace Envoy {
+namespace Server {
+
+/**
+ * Time taken to load the resources of one type in a config-validation run, which points out the
+ * sections of a config that are slow to load.
+ */
+class ValidationTiming {
+public:
+  /**
+   * Record the loading of a resource.
+   * @param name supplies the name of the resource.
+   * @param duration supplies the time taken to load it.
+   */
+  void add(const std::string& name, std::chrono::steady_clock::duration duration);
+
+  /**
+   * Add the resources recorded by another timing.
+   */
+  void merge(const ValidationTiming& other);
+
+  /**
+   * @return std::string the number of resources, the time taken to load them all and the slowest
+   *         one.
+   */
+  std::string summary() const;
+
+  uint64_t count() const { return count_; }
+
+private:
+  uint64_t count_{};
+  std::chrono::steady_clock::duration total_{};
+  std::string slowest_name_;
+  std::chrono::steady_clock::duration slowest_{};
+};
+
+} // namespace Server
+} // namespace Envoy
@@ -51,7 +51,8 @@ void MainImpl::initialize(const envoy::api::v2::Bootstrap& bootstrap, Instance&
   if (bootstrap.dynamic_resources().has_lds_config()) {
     lds_api_.reset(new LdsApi(bootstrap.dynamic_resources().lds_config(), *cluster_manager_,
                               server.dispatcher(), server.random(), server.initManager(),
-                              server.localInfo(), server.stats(), server.listenerManager()));
+                              server.localInfo(), server.stats(), server.listenerManager(),
+                              server.options().xdsCachePath()));
   }
 
   stats_flush_interval_ =
@@ -70,8 +71,11 @@ void MainImpl::initialize(const envoy::api::v2::Bootstrap& bootstrap, Instance&
   initializeTracers(bootstrap.tracing(), server);
 
   if (bootstrap.has_rate_limit_service()) {
-    ratelimit_client_factory_.reset(
-        new RateLimit::GrpcFactoryImpl(bootstrap.rate_limit_service(), *cluster_manager_));
+    ratelimit_client_factory_.reset(new RateLimit::GrpcFactoryImpl(
+        bootstrap.rate_limit_service(), *cluster_manager_,
+        {server.options().ratelimitLeaseSize(), server.options().ratelimitLeaseDuration(),
+         RateLimit::QuotaLeaseConfig::DEFAULT_MAX_LEASES},
+        server.threadLocal()));
   } else {
     ratelimit_client_factory_.reset(new RateLimit::NullFactoryImpl());
   }
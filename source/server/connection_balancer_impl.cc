@@ -0,0 +1,42 @@
+#include "server/connection_balancer_impl.h"
+
+#include <algorithm>
+
+namespace Envoy {
+namespace Server {
+
+void ConnectionBalancerImpl::registerTarget(Target& target) {
+  std::lock_guard<std::mutex> guard(lock_);
+  targets_.push_back(&target);
+}
+
+void ConnectionBalancerImpl::unregisterTarget(Target& target) {
+  std::lock_guard<std::mutex> guard(lock_);
+  targets_.erase(std::remove(targets_.begin(), targets_.end(), &target), targets_.end());
+}
+
+bool ConnectionBalancerImpl::balanceConnection(
+    Target& current, int fd, Network::Address::InstanceConstSharedPtr remote_address,
+    Network::Address::InstanceConstSharedPtr local_address, bool using_original_dst) {
+  std::lock_guard<std::mutex> guard(lock_);
+  Target* picked = &current;
+  uint64_t min_connections = current.numConnections();
+  for (Target* target : targets_) {
+    const uint64_t num_connections = target->numConnections();
+    if (num_connections < min_connections) {
+      picked = target;
+      min_connections = num_connections;
+    }
+  }
+
+  picked->incNumConnections();
+  if (picked == &current) {
+    return false;
+  }
+
+  picked->post(fd, remote_address, local_address, using_original_dst);
+  return true;
+}
+
+} // namespace Server
+} // namespace Envoy
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include "envoy/network/listener.h"
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Server {
+
+/**
+ * Balancer which hands every accepted connection to the target that owns the fewest connections.
+ * Ties go to the target that accepted the connection, so that it is only posted to another worker
+ * when that actually evens out the load.
+ */
+class ConnectionBalancerImpl : public Network::ConnectionBalancer, NonCopyable {
+public:
+  // Network::ConnectionBalancer
+  void registerTarget(Target& target) override;
+  void unregisterTarget(Target& target) override;
+  bool balanceConnection(Target& current, int fd,
+                         Network::Address::InstanceConstSharedPtr remote_address,
+                         Network::Address::InstanceConstSharedPtr local_address,
+                         bool using_original_dst) override;
+
+private:
+  // Held while posting to a target so that the target can't unregister and be destroyed meanwhile.
+  std::mutex lock_;
+  std::vector<Target*> targets_;
+};
+
+} // namespace Server
+} // namespace Envoy
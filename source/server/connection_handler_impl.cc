@@ -1,5 +1,7 @@
 #include "server/connection_handler_impl.h"
 
+#include <unistd.h>
+
 #include "envoy/event/dispatcher.h"
 #include "envoy/event/timer.h"
 #include "envoy/network/filter.h"
@@ -8,8 +10,9 @@
 namespace Envoy {
 namespace Server {
 
-ConnectionHandlerImpl::ConnectionHandlerImpl(spdlog::logger& logger, Event::Dispatcher& dispatcher)
-    : logger_(logger), dispatcher_(dispatcher) {}
+ConnectionHandlerImpl::ConnectionHandlerImpl(spdlog::logger& logger, Event::Dispatcher& dispatcher,
+                                             const std::string& per_handler_stat_prefix)
+    : logger_(logger), dispatcher_(dispatcher), per_handler_stat_prefix_(per_handler_stat_prefix) {}
 
 void ConnectionHandlerImpl::addListener(Network::FilterChainFactory& factory,
                                         Network::ListenSocket& socket, Stats::Scope& scope,
@@ -40,18 +43,63 @@ void ConnectionHandlerImpl::removeListeners(uint64_t listener_tag) {
   }
 }
 
+void ConnectionHandlerImpl::removeListenersWhenIdle(uint64_t listener_tag,
+                                                    std::function<void()> completion) {
+  bool found = false;
+  for (auto& listener : listeners_) {
+    if (listener.second->listener_tag_ == listener_tag) {
+      listener.second->stop();
+      listener.second->on_idle_ = completion;
+      found = true;
+    }
+  }
+
+  if (!found) {
+    completion();
+    return;
+  }
+  removeIdleListeners(listener_tag);
+}
+
+void ConnectionHandlerImpl::removeIdleListeners(uint64_t listener_tag) {
+  std::list<std::function<void()>> completions;
+  for (auto listener = listeners_.begin(); listener != listeners_.end();) {
+    if (listener->second->listener_tag_ == listener_tag && listener->second->on_idle_ &&
+        listener->second->connections_.empty()) {
+      completions.push_back(listener->second->on_idle_);
+      listener = listeners_.erase(listener);
+    } else {
+      ++listener;
+    }
+  }
+
+  for (const auto& completion : completions) {
+    completion();
+  }
+}
+
 void ConnectionHandlerImpl::stopListeners(uint64_t listener_tag) {
   for (auto& listener : listeners_) {
     if (listener.second->listener_tag_ == listener_tag) {
-      listener.second->listener_.reset();
+      listener.second->stop();
     }
   }
 }
 
 void ConnectionHandlerImpl::stopListeners() {
   for (auto& listener : listeners_) {
-    listener.second->listener_.reset();
+    listener.second->stop();
+  }
+}
+
+ConnectionHandlerImpl::ActiveListener*
+ConnectionHandlerImpl::findActiveListenerByTag(uint64_t listener_tag) {
+  for (auto& listener : listeners_) {
+    if (listener.second->listener_tag_ == listener_tag) {
+      return listener.second.get();
+    }
   }
+  return nullptr;
 }
 
 void ConnectionHandlerImpl::ActiveListener::removeConnection(ActiveConnection& connection) {
@@ -61,6 +109,23 @@ void ConnectionHandlerImpl::ActiveListener::removeConnection(ActiveConnection& c
   parent_.dispatcher_.deferredDelete(std::move(removed));
   ASSERT(parent_.num_connections_ > 0);
   parent_.num_connections_--;
+  decNumConnections();
+
+  if (on_idle_ && connections_.empty()) {
+    // The listener can't be destroyed from within the close of one of its connections, so it is
+    // removed once the dispatcher gets back to its posted callbacks.
+    ConnectionHandlerImpl& parent = parent_;
+    const uint64_t listener_tag = listener_tag_;
+    parent_.dispatcher_.post(
+        [&parent, listener_tag]() -> void { parent.removeIdleListeners(listener_tag); });
+  }
+}
+
+void ConnectionHandlerImpl::ActiveListener::decNumConnections() {
+  if (connection_balancer_) {
+    ASSERT(num_listener_connections_ > 0);
+    num_listener_connections_--;
+  }
 }
 
 ConnectionHandlerImpl::ActiveListener::ActiveListener(
@@ -69,16 +134,30 @@ ConnectionHandlerImpl::ActiveListener::ActiveListener(
     const Network::ListenerOptions& listener_options)
     : ActiveListener(
           parent, parent.dispatcher_.createListener(parent, socket, *this, scope, listener_options),
-          factory, scope, listener_tag) {}
+          factory, scope, listener_tag, listener_options.connection_balancer_) {}
 
-ConnectionHandlerImpl::ActiveListener::ActiveListener(ConnectionHandlerImpl& parent,
-                                                      Network::ListenerPtr&& listener,
-                                                      Network::FilterChainFactory& factory,
-                                                      Stats::Scope& scope, uint64_t listener_tag)
+ConnectionHandlerImpl::ActiveListener::ActiveListener(
+    ConnectionHandlerImpl& parent, Network::ListenerPtr&& listener,
+    Network::FilterChainFactory& factory, Stats::Scope& scope, uint64_t listener_tag,
+    Network::ConnectionBalancerSharedPtr connection_balancer)
     : parent_(parent), factory_(factory), listener_(std::move(listener)),
-      stats_(generateStats(scope)), listener_tag_(listener_tag) {}
+      stats_(generateStats(scope)), listener_tag_(listener_tag),
+      connection_balancer_(connection_balancer) {
+  if (!parent_.per_handler_stat_prefix_.empty()) {
+    const std::string& prefix = parent_.per_handler_stat_prefix_;
+    per_handler_stats_.reset(new PerHandlerListenerStats{ALL_PER_HANDLER_LISTENER_STATS(
+        POOL_COUNTER_PREFIX(scope, prefix), POOL_GAUGE_PREFIX(scope, prefix))});
+  }
+  if (connection_balancer_) {
+    connection_balancer_->registerTarget(*this);
+  }
+}
 
 ConnectionHandlerImpl::ActiveListener::~ActiveListener() {
+  if (connection_balancer_) {
+    connection_balancer_->unregisterTarget(*this);
+  }
+
   while (!connections_.empty()) {
     connections_.front()->connection_->close(Network::ConnectionCloseType::NoFlush);
   }
@@ -93,7 +172,7 @@ ConnectionHandlerImpl::SslActiveListener::SslActiveListener(
     : ActiveListener(parent,
                      parent.dispatcher_.createSslListener(parent, ssl_ctx, socket, *this, scope,
                                                           listener_options),
-                     factory, scope, listener_tag) {}
+                     factory, scope, listener_tag, listener_options.connection_balancer_) {}
 
 Network::Listener*
 ConnectionHandlerImpl::findListenerByAddress(const Network::Address::Instance& address) {
@@ -124,6 +203,45 @@ ConnectionHandlerImpl::findListenerByAddress(const Network::Address::Instance& a
   return (listener != listeners_.end()) ? listener->second->listener_.get() : nullptr;
 }
 
+void ConnectionHandlerImpl::ActiveListener::stop() {
+  // Unregister first so that no more sockets are posted to the listener once it has stopped.
+  if (connection_balancer_) {
+    connection_balancer_->unregisterTarget(*this);
+  }
+  listener_.reset();
+}
+
+bool ConnectionHandlerImpl::ActiveListener::onAccept(
+    int fd, Network::Address::InstanceConstSharedPtr remote_address,
+    Network::Address::InstanceConstSharedPtr local_address, bool using_original_dst) {
+  return connection_balancer_ != nullptr &&
+         connection_balancer_->balanceConnection(*this, fd, remote_address, local_address,
+                                                 using_original_dst);
+}
+
+void ConnectionHandlerImpl::ActiveListener::post(
+    int fd, Network::Address::InstanceConstSharedPtr remote_address,
+    Network::Address::InstanceConstSharedPtr local_address, bool using_original_dst) {
+  // This runs on the thread of the listener that accepted the socket. The listener may be stopped
+  // or removed before the socket reaches this handler's thread, so it is looked up again there.
+  ConnectionHandlerImpl& parent = parent_;
+  const uint64_t listener_tag = listener_tag_;
+  parent_.dispatcher_.post([&parent, listener_tag, fd, remote_address, local_address,
+                            using_original_dst]() -> void {
+    ActiveListener* listener = parent.findActiveListenerByTag(listener_tag);
+    if (listener != nullptr && listener->listener_ != nullptr) {
+      listener->listener_->createConnection(fd, remote_address, local_address,
+                                            using_original_dst);
+      return;
+    }
+
+    if (listener != nullptr) {
+      listener->decNumConnections();
+    }
+    ::close(fd);
+  });
+}
+
 void ConnectionHandlerImpl::ActiveListener::onNewConnection(
     Network::ConnectionPtr&& new_connection) {
   ENVOY_CONN_LOG_TO_LOGGER(parent_.logger_, debug, "new connection", *new_connection);
@@ -141,8 +259,12 @@ void ConnectionHandlerImpl::ActiveListener::onNewConnection(
       ActiveConnectionPtr active_connection(new ActiveConnection(*this, std::move(new_connection)));
       active_connection->moveIntoList(std::move(active_connection), connections_);
       parent_.num_connections_++;
+      return;
     }
   }
+
+  // The balancer counted the connection when it was accepted.
+  decNumConnections();
 }
 
 ConnectionHandlerImpl::ActiveConnection::ActiveConnection(ActiveListener& listener,
@@ -155,9 +277,16 @@ ConnectionHandlerImpl::ActiveConnection::ActiveConnection(ActiveListener& listen
   connection_->addConnectionCallbacks(*this);
   listener_.stats_.downstream_cx_total_.inc();
   listener_.stats_.downstream_cx_active_.inc();
+  if (listener_.per_handler_stats_) {
+    listener_.per_handler_stats_->downstream_cx_total_.inc();
+    listener_.per_handler_stats_->downstream_cx_active_.inc();
+  }
 }
 
 ConnectionHandlerImpl::ActiveConnection::~ActiveConnection() {
+  if (listener_.per_handler_stats_) {
+    listener_.per_handler_stats_->downstream_cx_active_.dec();
+  }
   listener_.stats_.downstream_cx_active_.dec();
   listener_.stats_.downstream_cx_destroy_.inc();
   conn_length_->complete();
@@ -2,8 +2,10 @@
 
 #include <atomic>
 #include <cstdint>
+#include <functional>
 #include <list>
 #include <memory>
+#include <string>
 
 #include "envoy/common/time.h"
 #include "envoy/event/deferred_deletable.h"
@@ -14,6 +16,7 @@
 #include "envoy/network/listener.h"
 #include "envoy/stats/timespan.h"
 
+#include "common/common/empty_string.h"
 #include "common/common/linked_object.h"
 #include "common/common/non_copyable.h"
 
@@ -37,13 +40,33 @@ struct ListenerStats {
   ALL_LISTENER_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT, GENERATE_HISTOGRAM_STRUCT)
 };
 
+// clang-format off
+#define ALL_PER_HANDLER_LISTENER_STATS(COUNTER, GAUGE)                                             \
+  COUNTER(downstream_cx_total)                                                                     \
+  GAUGE  (downstream_cx_active)
+// clang-format on
+
+/**
+ * Wrapper struct for the stats of the copy of a listener owned by one handler. @see stats_macros.h
+ */
+struct PerHandlerListenerStats {
+  ALL_PER_HANDLER_LISTENER_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
 /**
  * Server side connection handler. This is used both by workers as well as the
  * main thread for non-threaded listeners.
  */
 class ConnectionHandlerImpl : public Network::ConnectionHandler, NonCopyable {
 public:
-  ConnectionHandlerImpl(spdlog::logger& logger, Event::Dispatcher& dispatcher);
+  /**
+   * @param logger supplies the logger to use.
+   * @param dispatcher supplies the dispatcher that owns the handler's listeners and connections.
+   * @param per_handler_stat_prefix supplies a prefix, such as "worker_0.", for listener stats that
+   *        are only counted for this handler, or an empty string for no per handler stats.
+   */
+  ConnectionHandlerImpl(spdlog::logger& logger, Event::Dispatcher& dispatcher,
+                        const std::string& per_handler_stat_prefix = EMPTY_STRING);
 
   // Network::ConnectionHandler
   uint64_t numConnections() override { return num_connections_; }
@@ -55,6 +78,7 @@ public:
                       const Network::ListenerOptions& listener_options) override;
   Network::Listener* findListenerByAddress(const Network::Address::Instance& address) override;
   void removeListeners(uint64_t listener_tag) override;
+  void removeListenersWhenIdle(uint64_t listener_tag, std::function<void()> completion) override;
   void stopListeners(uint64_t listener_tag) override;
   void stopListeners() override;
 
@@ -65,35 +89,67 @@ private:
   /**
    * Wrapper for an active listener owned by this handler.
    */
-  struct ActiveListener : public Network::ListenerCallbacks {
+  struct ActiveListener : public Network::ListenerCallbacks,
+                          public Network::ConnectionBalancer::Target {
     ActiveListener(ConnectionHandlerImpl& parent, Network::ListenSocket& socket,
                    Network::FilterChainFactory& factory, Stats::Scope& scope, uint64_t listener_tag,
                    const Network::ListenerOptions& listener_options);
 
     ActiveListener(ConnectionHandlerImpl& parent, Network::ListenerPtr&& listener,
-                   Network::FilterChainFactory& factory, Stats::Scope& scope,
-                   uint64_t listener_tag);
+                   Network::FilterChainFactory& factory, Stats::Scope& scope, uint64_t listener_tag,
+                   Network::ConnectionBalancerSharedPtr connection_balancer);
 
     ~ActiveListener();
 
+    /**
+     * Stop accepting connections, and stop being handed connections by the balancer. Connections
+     * owned by the listener are kept.
+     */
+    void stop();
+
+    /**
+     * Hands the socket to the balancer, if the listener has one.
+     */
+    bool onAccept(int fd, Network::Address::InstanceConstSharedPtr remote_address,
+                  Network::Address::InstanceConstSharedPtr local_address,
+                  bool using_original_dst) override;
+
     /**
      * Fires when a new connection is received from the listener.
      * @param new_connection supplies the connection to take control of.
      */
     void onNewConnection(Network::ConnectionPtr&& new_connection) override;
 
+    // Network::ConnectionBalancer::Target
+    uint64_t numConnections() const override { return num_listener_connections_; }
+    void incNumConnections() override { num_listener_connections_++; }
+    void post(int fd, Network::Address::InstanceConstSharedPtr remote_address,
+              Network::Address::InstanceConstSharedPtr local_address,
+              bool using_original_dst) override;
+
     /**
      * Remove and destroy an active connection.
      * @param connection supplies the connection to remove.
      */
     void removeConnection(ActiveConnection& connection);
 
+    /**
+     * Uncount a connection counted by the balancer, once it is closed or was never created.
+     */
+    void decNumConnections();
+
     ConnectionHandlerImpl& parent_;
     Network::FilterChainFactory& factory_;
     Network::ListenerPtr listener_;
     ListenerStats stats_;
+    std::unique_ptr<PerHandlerListenerStats> per_handler_stats_;
     std::list<ActiveConnectionPtr> connections_;
     const uint64_t listener_tag_;
+    const Network::ConnectionBalancerSharedPtr connection_balancer_;
+    // Read by the balancer on other workers' threads.
+    std::atomic<uint64_t> num_listener_connections_{};
+    // Set once the listener is to be removed when its last connection closes.
+    std::function<void()> on_idle_;
   };
 
   struct SslActiveListener : public ActiveListener {
@@ -132,8 +188,20 @@ private:
 
   static ListenerStats generateStats(Stats::Scope& scope);
 
+  /**
+   * @return ActiveListener* the listener with the given tag, or nullptr if there is none.
+   */
+  ActiveListener* findActiveListenerByTag(uint64_t listener_tag);
+
+  /**
+   * Remove the listeners with the given tag that are waiting for their connections to close, if
+   * they have no connections left, and call their completions.
+   */
+  void removeIdleListeners(uint64_t listener_tag);
+
   spdlog::logger& logger_;
   Event::Dispatcher& dispatcher_;
+  const std::string per_handler_stat_prefix_;
   std::list<std::pair<Network::Address::InstanceConstSharedPtr, ActiveListenerPtr>> listeners_;
   std::atomic<uint64_t> num_connections_{};
 };
@@ -1,5 +1,6 @@
 #include "server/drain_manager_impl.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <functional>
@@ -14,8 +15,17 @@
 namespace Envoy {
 namespace Server {
 
-DrainManagerImpl::DrainManagerImpl(Instance& server, envoy::api::v2::Listener::DrainType drain_type)
-    : server_(server), drain_type_(drain_type) {}
+namespace {
+
+// How far ahead of the rate paced drain closes may run, so that closes requested close together
+// aren't all turned down.
+const int64_t DRAIN_CLOSE_BURST_US = 100000;
+
+} // namespace
+
+DrainManagerImpl::DrainManagerImpl(Instance& server, envoy::api::v2::Listener::DrainType drain_type,
+                                   MonotonicTimeSource& time_source)
+    : server_(server), drain_type_(drain_type), time_source_(time_source) {}
 
 bool DrainManagerImpl::drainClose() const {
   // If we are actively HC failed and the drain type is default, always drain close.
@@ -32,11 +42,40 @@ bool DrainManagerImpl::drainClose() const {
     return false;
   }
 
+  // Once the drain period is over all connections are closed, regardless of pacing.
+  if (drain_time_completed_.load() >= server_.options().drainTime().count()) {
+    return true;
+  }
+
+  const uint64_t close_rate =
+      server_.runtime().snapshot().getInteger("server.drain_close_rate_per_worker", 0);
+  if (close_rate > 0) {
+    return drainCloseAtRate(close_rate * std::max(server_.options().concurrency(), 1U));
+  }
+
   // We use the tick time as in increasing chance that we shutdown connections.
   return static_cast<uint64_t>(drain_time_completed_.load()) >
          (server_.random().random() % server_.options().drainTime().count());
 }
 
+bool DrainManagerImpl::drainCloseAtRate(uint64_t rate) const {
+  // This is the generic cell rate algorithm: each close pushes the earliest time of the next one
+  // back by the interval between closes at the rate. drainClose() is called from all workers, so
+  // the rate is shared between them.
+  const int64_t interval_us = std::max<int64_t>(1000000 / rate, 1);
+  const int64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                             time_source_.currentTime() - drain_start_)
+                             .count();
+  int64_t next_us = next_drain_close_us_.load();
+  do {
+    if (next_us > now_us + DRAIN_CLOSE_BURST_US) {
+      return false;
+    }
+  } while (!next_drain_close_us_.compare_exchange_weak(next_us,
+                                                       std::max(next_us, now_us) + interval_us));
+  return true;
+}
+
 void DrainManagerImpl::drainSequenceTick() {
   ENVOY_LOG(trace, "drain tick #{}", drain_time_completed_.load());
   ASSERT(drain_time_completed_.load() < server_.options().drainTime().count());
@@ -52,6 +91,7 @@ void DrainManagerImpl::drainSequenceTick() {
 void DrainManagerImpl::startDrainSequence(std::function<void()> completion) {
   drain_sequence_completion_ = completion;
   ASSERT(!drain_tick_timer_);
+  drain_start_ = time_source_.currentTime();
   drain_tick_timer_ = server_.dispatcher().createTimer([this]() -> void { drainSequenceTick(); });
   drainSequenceTick();
 }
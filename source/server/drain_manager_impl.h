@@ -1,8 +1,11 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <functional>
 
+#include "envoy/common/time.h"
 #include "envoy/server/drain_manager.h"
 #include "envoy/server/instance.h"
 
@@ -16,10 +19,14 @@ namespace Server {
  * 1) Terminates the parent process after 15 minutes.
  * 2) Drains the parent process over a period of 10 minutes where drain close becomes more
  *    likely each second that passes.
+ * If the server.drain_close_rate_per_worker runtime key is set, drain closes are instead paced to
+ * that many connections per second per worker for the drain period, so that the connections
+ * reconnecting elsewhere (e.g. to the child process during hot restart) arrive at a steady rate.
  */
 class DrainManagerImpl : Logger::Loggable<Logger::Id::main>, public DrainManager {
 public:
-  DrainManagerImpl(Instance& server, envoy::api::v2::Listener::DrainType drain_type);
+  DrainManagerImpl(Instance& server, envoy::api::v2::Listener::DrainType drain_type,
+                   MonotonicTimeSource& time_source);
 
   // Server::DrainManager
   bool drainClose() const override;
@@ -30,10 +37,20 @@ private:
   bool draining() const { return drain_tick_timer_ != nullptr; }
   void drainSequenceTick();
 
+  /**
+   * @return bool whether a drain close fits within the given rate of closes per second, counting
+   *         it against the rate if so.
+   */
+  bool drainCloseAtRate(uint64_t rate) const;
+
   Instance& server_;
   const envoy::api::v2::Listener::DrainType drain_type_;
+  MonotonicTimeSource& time_source_;
   Event::TimerPtr drain_tick_timer_;
   std::atomic<uint32_t> drain_time_completed_{};
+  MonotonicTime drain_start_;
+  // The time since drain_start_, in microseconds, before which no drain close fits within the rate.
+  mutable std::atomic<int64_t> next_drain_close_us_{};
   Event::TimerPtr parent_shutdown_timer_;
   std::function<void()> drain_sequence_completion_;
 };
@@ -4,9 +4,13 @@
 #include <sys/prctl.h>
 #include <sys/types.h>
 #include <sys/un.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <limits>
 #include <string>
+#include <vector>
 
 #include "envoy/event/dispatcher.h"
 #include "envoy/event/file_event.h"
@@ -14,6 +18,7 @@
 #include "envoy/server/options.h"
 
 #include "common/api/os_sys_calls_impl.h"
+#include "common/common/hash.h"
 #include "common/common/utility.h"
 #include "common/network/utility.h"
 
@@ -24,13 +29,182 @@ namespace Server {
 
 // Increment this whenever there is a shared memory / RPC change that will prevent a hot restart
 // from working. Operations code can then cope with this and do a full restart.
-const uint64_t SharedMemory::VERSION = 9;
+const uint64_t SharedMemory::VERSION = 11;
+
+const uint64_t SharedMemory::MAX_STAT_SEGMENTS;
+const uint32_t SharedStatSegment::INDEX_EMPTY;
+const uint32_t SharedStatSegment::INDEX_TOMBSTONE;
+const uint32_t SharedStatSegment::INDEX_SLOT_OFFSET;
+
+namespace {
+
+/**
+ * @return the hash of a stat name in the stat index. Stats are matched on their name truncated to
+ *         the maximum name length, so the hash must be of the truncated name too. The hash must be
+ *         the same in all processes sharing the memory segment, so any change here requires a
+ *         VERSION bump.
+ */
+uint64_t statNameHash(const std::string& name) {
+  return HashUtil::xxHash64(name.size() > Stats::RawStatData::maxNameLength()
+                                ? name.substr(0, Stats::RawStatData::maxNameLength())
+                                : name);
+}
+
+} // namespace
+
+void ProcessSharedMutex::initialize(pthread_mutex_t& mutex) {
+  pthread_mutexattr_t attribute;
+  pthread_mutexattr_init(&attribute);
+  pthread_mutexattr_setpshared(&attribute, PTHREAD_PROCESS_SHARED);
+  pthread_mutexattr_setrobust(&attribute, PTHREAD_MUTEX_ROBUST);
+  pthread_mutex_init(&mutex, &attribute);
+}
+
+uint64_t SharedStatSegment::statIndexSize(uint64_t num_stats) {
+  uint64_t size = 1;
+  while (size < 2 * num_stats) {
+    size <<= 1;
+  }
+  return size;
+}
+
+uint64_t SharedStatSegment::totalSize(uint64_t num_stats, uint64_t entry_size) {
+  return sizeof(SharedStatSegment) + entry_size * num_stats +
+         sizeof(uint32_t) * (statIndexSize(num_stats) + num_stats);
+}
+
+void SharedStatSegment::initialize(uint64_t num_stats, uint64_t entry_size) {
+  size_ = totalSize(num_stats, entry_size);
+  num_stats_ = num_stats;
+  entry_size_ = entry_size;
+  ProcessSharedMutex::initialize(lock_);
+  closed_ = false;
+  stat_index_size_ = statIndexSize(num_stats);
+  stat_index_tombstones_ = 0;
+  next_stat_slot_ = 0;
+  num_free_stat_slots_ = 0;
+  memset(statIndex(), 0, sizeof(uint32_t) * stat_index_size_);
+
+  // Stats::RawStatData must be naturally aligned for atomics to work properly.
+  RELEASE_ASSERT((reinterpret_cast<uintptr_t>(stats_slots_) % alignof(Stats::RawStatData)) == 0);
+}
+
+Stats::RawStatData* SharedStatSegment::alloc(const std::string& name, uint64_t hash,
+                                             bool may_close) {
+  // Try to find the existing slot via the stat index, otherwise allocate a new one.
+  uint32_t* index = statIndex();
+  const uint64_t mask = stat_index_size_ - 1;
+
+  // Probe until an empty entry, remembering the first reusable entry in case we need to insert.
+  uint32_t* insert_at = nullptr;
+  for (uint64_t i = hash & mask, probes = 0; probes < stat_index_size_;
+       i = (i + 1) & mask, probes++) {
+    if (index[i] == INDEX_EMPTY || index[i] == INDEX_TOMBSTONE) {
+      if (insert_at == nullptr) {
+        insert_at = &index[i];
+      }
+      if (index[i] == INDEX_EMPTY) {
+        break;
+      }
+      continue;
+    }
+
+    Stats::RawStatData& data = statSlot(index[i] - INDEX_SLOT_OFFSET);
+    if (data.matches(name)) {
+      data.ref_count_++;
+      return &data;
+    }
+  }
+
+  if (closed_) {
+    return nullptr;
+  }
+
+  uint64_t slot;
+  if (num_free_stat_slots_ > 0) {
+    slot = freeStatSlots()[--num_free_stat_slots_];
+  } else if (next_stat_slot_ < num_stats_) {
+    slot = next_stat_slot_++;
+  } else {
+    closed_ = may_close;
+    return nullptr;
+  }
+
+  // The index has at least twice as many entries as there are stats, so there is always room.
+  ASSERT(insert_at != nullptr);
+  if (*insert_at == INDEX_TOMBSTONE) {
+    stat_index_tombstones_--;
+  }
+  *insert_at = slot + INDEX_SLOT_OFFSET;
+
+  Stats::RawStatData& data = statSlot(slot);
+  data.initialize(name);
+  return &data;
+}
+
+void SharedStatSegment::free(Stats::RawStatData& data) {
+  ASSERT(data.ref_count_ > 0);
+  if (--data.ref_count_ > 0) {
+    return;
+  }
+
+  // Replace the index entry with a tombstone, so that probe sequences running through it still
+  // find the entries after it.
+  uint32_t* index = statIndex();
+  const uint64_t mask = stat_index_size_ - 1;
+  const uint64_t slot = statSlotNumber(data);
+  uint64_t i = statNameHash(data.name_) & mask;
+  while (index[i] != slot + INDEX_SLOT_OFFSET) {
+    ASSERT(index[i] != INDEX_EMPTY);
+    i = (i + 1) & mask;
+  }
+  index[i] = INDEX_TOMBSTONE;
+  freeStatSlots()[num_free_stat_slots_++] = slot;
+
+  memset(&data, 0, Stats::RawStatData::size());
+
+  // Tombstones make lookups of missing stats probe further. Once there are many of them, which
+  // takes a lot of stat churn, drop them all at once.
+  if (++stat_index_tombstones_ > stat_index_size_ / 4) {
+    rebuildStatIndex();
+  }
+}
+
+void SharedStatSegment::rebuildStatIndex() {
+  uint32_t* index = statIndex();
+  const uint64_t mask = stat_index_size_ - 1;
+  memset(index, 0, sizeof(uint32_t) * stat_index_size_);
+  stat_index_tombstones_ = 0;
+  for (uint64_t slot = 0; slot < next_stat_slot_; slot++) {
+    Stats::RawStatData& data = statSlot(slot);
+    if (!data.initialized()) {
+      continue;
+    }
+
+    uint64_t i = statNameHash(data.name_) & mask;
+    while (index[i] != INDEX_EMPTY) {
+      i = (i + 1) & mask;
+    }
+    index[i] = slot + INDEX_SLOT_OFFSET;
+  }
+}
+
+uint64_t SharedMemory::totalSize(uint64_t max_num_stats, uint64_t entry_size) {
+  return sizeof(SharedMemory) + SharedStatSegment::totalSize(max_num_stats, entry_size);
+}
+
+std::string SharedMemory::statSegmentName(uint64_t base_id, uint64_t index) {
+  return fmt::format("/envoy_shared_memory_{}_stats_{}", base_id, index);
+}
 
 SharedMemory& SharedMemory::initialize(Options& options) {
   Api::OsSysCalls& os_sys_calls = Api::OsSysCallsSingleton::get();
 
   const uint64_t entry_size = Stats::RawStatData::size();
-  const uint64_t total_size = sizeof(SharedMemory) + (entry_size * options.maxStats());
+  // Stat index entries hold slot numbers, offset past the reserved entry values.
+  RELEASE_ASSERT(options.maxStats() <=
+                 std::numeric_limits<uint32_t>::max() - SharedStatSegment::INDEX_SLOT_OFFSET);
+  const uint64_t total_size = totalSize(options.maxStats(), entry_size);
 
   int flags = O_RDWR;
   const std::string shmem_name = fmt::format("/envoy_shared_memory_{}", options.baseId());
@@ -38,8 +212,12 @@ SharedMemory& SharedMemory::initialize(Options& options) {
     flags |= O_CREAT | O_EXCL;
 
     // If we are meant to be first, attempt to unlink a previous shared memory instance. If this
-    // is a clean restart this should then allow the shm_open() call below to succeed.
+    // is a clean restart this should then allow the shm_open() call below to succeed. The stat
+    // segments it added are unlinked too, so that they are not mistaken for ours.
     os_sys_calls.shmUnlink(shmem_name.c_str());
+    for (uint64_t i = 1; i < MAX_STAT_SEGMENTS; i++) {
+      os_sys_calls.shmUnlink(statSegmentName(options.baseId(), i).c_str());
+    }
   }
 
   int shmem_fd = os_sys_calls.shmOpen(shmem_name.c_str(), flags, S_IRUSR | S_IWUSR);
@@ -63,21 +241,21 @@ SharedMemory& SharedMemory::initialize(Options& options) {
     shmem->version_ = VERSION;
     shmem->num_stats_ = options.maxStats();
     shmem->entry_size_ = entry_size;
-    shmem->initializeMutex(shmem->log_lock_);
-    shmem->initializeMutex(shmem->access_log_lock_);
-    shmem->initializeMutex(shmem->stat_lock_);
-    shmem->initializeMutex(shmem->init_lock_);
+    ProcessSharedMutex::initialize(shmem->log_lock_);
+    ProcessSharedMutex::initialize(shmem->access_log_lock_);
+    ProcessSharedMutex::initialize(shmem->stat_lock_);
+    ProcessSharedMutex::initialize(shmem->init_lock_);
+    shmem->firstStatSegment().initialize(options.maxStats(), entry_size);
+    shmem->num_stat_segments_ = 1;
   } else {
     RELEASE_ASSERT(shmem->size_ == total_size);
     RELEASE_ASSERT(shmem->version_ == VERSION);
     RELEASE_ASSERT(shmem->num_stats_ == options.maxStats());
     RELEASE_ASSERT(shmem->entry_size_ == entry_size);
+    RELEASE_ASSERT(shmem->firstStatSegment().size() ==
+                   SharedStatSegment::totalSize(options.maxStats(), entry_size));
   }
 
-  // Stats::RawStatData must be naturally aligned for atomics to work properly.
-  RELEASE_ASSERT((reinterpret_cast<uintptr_t>(shmem->stats_slots_) % alignof(Stats::RawStatData)) ==
-                 0);
-
   // Here we catch the case where a new Envoy starts up when the current Envoy has not yet fully
   // initialized. The startup logic is quite complicated, and it's not worth trying to handle this
   // in a finer way. This will cause the startup to fail with an error code early, without
@@ -91,14 +269,6 @@ SharedMemory& SharedMemory::initialize(Options& options) {
   return *shmem;
 }
 
-void SharedMemory::initializeMutex(pthread_mutex_t& mutex) {
-  pthread_mutexattr_t attribute;
-  pthread_mutexattr_init(&attribute);
-  pthread_mutexattr_setpshared(&attribute, PTHREAD_PROCESS_SHARED);
-  pthread_mutexattr_setrobust(&attribute, PTHREAD_MUTEX_ROBUST);
-  pthread_mutex_init(&mutex, &attribute);
-}
-
 std::string SharedMemory::version(size_t max_num_stats, size_t max_stat_name_len) {
   return fmt::format("{}.{}.{}.{}", VERSION, sizeof(SharedMemory), max_num_stats,
                      max_stat_name_len);
@@ -112,6 +282,8 @@ HotRestartImpl::HotRestartImpl(Options& options)
     : options_(options), shmem_(SharedMemory::initialize(options)), log_lock_(shmem_.log_lock_),
       access_log_lock_(shmem_.access_log_lock_), stat_lock_(shmem_.stat_lock_),
       init_lock_(shmem_.init_lock_) {
+  stat_segments_[0] = &shmem_.firstStatSegment();
+
   my_domain_socket_ = bindDomainSocket(options.restartEpoch());
   child_address_ = createDomainSocketAddress((options.restartEpoch() + 1));
   initDomainSocketAddress(&parent_address_);
@@ -127,37 +299,98 @@ HotRestartImpl::HotRestartImpl(Options& options)
 }
 
 Stats::RawStatData* HotRestartImpl::alloc(const std::string& name) {
-  // Try to find the existing slot in shared memory, otherwise allocate a new one.
-  Stats::RawStatData* unused = nullptr;
-  std::unique_lock<Thread::BasicLockable> lock(stat_lock_);
-  for (uint64_t i = 0; i < shmem_.num_stats_; i++) {
-    const size_t offset = shmem_.entry_size_ * i;
-    Stats::RawStatData* data = reinterpret_cast<Stats::RawStatData*>(shmem_.stats_slots_ + offset);
-    if (!data->initialized()) {
-      unused = data;
-    } else if (data->matches(name)) {
-      data->ref_count_++;
+  // Look for the stat in each segment in turn, holding the lock of one segment at a time, until
+  // it is found or added to the first open segment. Once that is full, a segment is added after
+  // it, which all the processes see through the shared memory header.
+  const uint64_t hash = statNameHash(name);
+  for (uint64_t i = 0;; i++) {
+    SharedStatSegment& segment = statSegment(i);
+    ProcessSharedMutex segment_lock(segment.lock_);
+    std::unique_lock<Thread::BasicLockable> lock(segment_lock);
+    // The last possible segment is never closed, so that slots released in it are reused.
+    const bool last = i + 1 == SharedMemory::MAX_STAT_SEGMENTS;
+    Stats::RawStatData* data = segment.alloc(name, hash, !last);
+    if (data != nullptr || last) {
       return data;
     }
+
+    lock.unlock();
+    if (i + 1 >= shmem_.num_stat_segments_) {
+      addStatSegment(i + 1);
+    }
   }
+}
 
-  if (unused != nullptr) {
-    unused->initialize(name);
-    return unused;
+void HotRestartImpl::free(Stats::RawStatData& data) {
+  for (uint64_t i = 0; i < shmem_.num_stat_segments_; i++) {
+    SharedStatSegment& segment = statSegment(i);
+    if (segment.contains(data)) {
+      // We must hold the lock since the reference decrement can race with an initialize above.
+      ProcessSharedMutex segment_lock(segment.lock_);
+      std::unique_lock<Thread::BasicLockable> lock(segment_lock);
+      segment.free(data);
+      return;
+    }
   }
+  NOT_REACHED;
+}
 
-  return nullptr;
+SharedStatSegment& HotRestartImpl::statSegment(uint64_t index) {
+  ASSERT(index < shmem_.num_stat_segments_);
+  SharedStatSegment* segment = stat_segments_[index];
+  if (segment == nullptr) {
+    std::unique_lock<std::mutex> lock(stat_segments_lock_);
+    segment = stat_segments_[index];
+    if (segment == nullptr) {
+      segment = &mapStatSegment(index, false);
+      stat_segments_[index] = segment;
+    }
+  }
+  return *segment;
 }
 
-void HotRestartImpl::free(Stats::RawStatData& data) {
-  // We must hold the lock since the reference decrement can race with an initialize above.
+void HotRestartImpl::addStatSegment(uint64_t index) {
   std::unique_lock<Thread::BasicLockable> lock(stat_lock_);
-  ASSERT(data.ref_count_ > 0);
-  if (--data.ref_count_ > 0) {
+  if (index < shmem_.num_stat_segments_) {
     return;
   }
 
-  memset(&data, 0, Stats::RawStatData::size());
+  ASSERT(index == shmem_.num_stat_segments_);
+  SharedStatSegment& segment = mapStatSegment(index, true);
+  segment.initialize(shmem_.num_stats_, shmem_.entry_size_);
+  {
+    std::unique_lock<std::mutex> segments_lock(stat_segments_lock_);
+    stat_segments_[index] = &segment;
+  }
+  shmem_.num_stat_segments_++;
+  ENVOY_LOG(info, "added shared memory stat segment {} of {} stats", index, shmem_.num_stats_);
+}
+
+SharedStatSegment& HotRestartImpl::mapStatSegment(uint64_t index, bool create) {
+  Api::OsSysCalls& os_sys_calls = Api::OsSysCallsSingleton::get();
+  const std::string name = SharedMemory::statSegmentName(options_.baseId(), index);
+  const uint64_t size = SharedStatSegment::totalSize(shmem_.num_stats_, shmem_.entry_size_);
+
+  // A segment left over by a process which died while adding it is initialized again.
+  int fd = os_sys_calls.shmOpen(name.c_str(), create ? O_RDWR | O_CREAT : O_RDWR,
+                                S_IRUSR | S_IWUSR);
+  if (fd == -1) {
+    PANIC(fmt::format("cannot open shared memory region {} check user permissions", name));
+  }
+
+  if (create) {
+    int rc = os_sys_calls.ftruncate(fd, size);
+    RELEASE_ASSERT(rc != -1);
+    UNREFERENCED_PARAMETER(rc);
+  }
+
+  void* memory = os_sys_calls.mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  RELEASE_ASSERT(memory != MAP_FAILED);
+  os_sys_calls.close(fd);
+
+  SharedStatSegment* segment = reinterpret_cast<SharedStatSegment*>(memory);
+  RELEASE_ASSERT(create || segment->size() == size);
+  return *segment;
 }
 
 int HotRestartImpl::bindDomainSocket(uint64_t id) {
@@ -197,6 +430,9 @@ sockaddr_un HotRestartImpl::createDomainSocketAddress(uint64_t id) {
 }
 
 void HotRestartImpl::drainParentListeners() {
+  // Any parent sockets not claimed by now are not going to be.
+  closeParentListenSockets();
+
   if (options_.restartEpoch() > 0) {
     // No reply expected.
     RpcBase rpc(RpcMessageType::DrainListenersRequest);
@@ -207,20 +443,87 @@ void HotRestartImpl::drainParentListeners() {
   shmem_.flags_ &= ~SharedMemory::Flags::INITIALIZING;
 }
 
-int HotRestartImpl::duplicateParentListenSocket(const std::string& address) {
+int HotRestartImpl::duplicateParentListenSocket(const std::string& address,
+                                                uint32_t worker_index) {
   if (options_.restartEpoch() == 0 || parent_terminated_) {
     return -1;
   }
 
+  // Fetch all the sockets of the parent at once the first time one is asked for, rather than
+  // making a round trip to the parent for each listener and worker.
+  if (parent_listen_sockets_fetched_ || getParentListenSockets()) {
+    auto it = parent_listen_sockets_.find(std::make_pair(address, worker_index));
+    if (it != parent_listen_sockets_.end()) {
+      const int fd = it->second;
+      parent_listen_sockets_.erase(it);
+      return fd;
+    }
+
+    // A socket shared by all workers is duplicated for each one, as it would have been by the
+    // parent, and closed along with any unclaimed sockets.
+    it = parent_listen_sockets_.find(
+        std::make_pair(address, static_cast<uint32_t>(RpcGetListenSocketsReply::ANY_WORKER)));
+    if (it != parent_listen_sockets_.end()) {
+      const int fd = dup(it->second);
+      RELEASE_ASSERT(fd != -1);
+      return fd;
+    }
+    return -1;
+  }
+
   RpcGetListenSocketRequest rpc;
   ASSERT(address.length() < sizeof(rpc.address_));
   StringUtil::strlcpy(rpc.address_, address.c_str(), sizeof(rpc.address_));
+  rpc.worker_index_ = worker_index;
   sendMessage(parent_address_, rpc);
   RpcGetListenSocketReply* reply =
       receiveTypedRpc<RpcGetListenSocketReply, RpcMessageType::GetListenSocketReply>();
   return reply->fd_;
 }
 
+bool HotRestartImpl::getParentListenSockets() {
+  RpcGetListenSocketsRequest rpc;
+  do {
+    sendMessage(parent_address_, rpc);
+    RpcBase* base_message = receiveRpc(true);
+    if (base_message->type_ == RpcMessageType::UnknownRequestReply) {
+      // The parent predates GetListenSocketsRequest.
+      ASSERT(rpc.first_ == 0);
+      return false;
+    }
+    RELEASE_ASSERT(base_message->length_ == sizeof(RpcGetListenSocketsReply));
+    RELEASE_ASSERT(base_message->type_ == RpcMessageType::GetListenSocketsReply);
+    RpcGetListenSocketsReply* reply = reinterpret_cast<RpcGetListenSocketsReply*>(base_message);
+    RELEASE_ASSERT(reply->next_ > rpc.first_ || reply->next_ >= reply->total_);
+
+    for (uint32_t i = 0; i < reply->num_sockets_; i++) {
+      const RpcGetListenSocketsReply::Socket& socket = reply->sockets_[i];
+      const auto key = std::make_pair(std::string(socket.address_), socket.worker_index_);
+      const auto it = parent_listen_sockets_.find(key);
+      if (it != parent_listen_sockets_.end()) {
+        // The parent's listeners changed between batches.
+        ::close(it->second);
+      }
+      parent_listen_sockets_[key] = reply->fds_[i];
+    }
+    rpc.first_ = reply->next_;
+    ENVOY_LOG(debug, "obtained {} of {} listen sockets from parent", rpc.first_, reply->total_);
+    if (rpc.first_ >= reply->total_) {
+      break;
+    }
+  } while (true);
+
+  parent_listen_sockets_fetched_ = true;
+  return true;
+}
+
+void HotRestartImpl::closeParentListenSockets() {
+  for (const auto& socket : parent_listen_sockets_) {
+    ::close(socket.second);
+  }
+  parent_listen_sockets_.clear();
+}
+
 void HotRestartImpl::getParentStats(GetParentStatsInfo& info) {
   // There exists a race condition during hot restart involving fetching parent stats. It looks like
   // this:
@@ -277,16 +580,16 @@ HotRestartImpl::RpcBase* HotRestartImpl::receiveRpc(bool block) {
   iov[0].iov_base = &rpc_buffer_[0];
   iov[0].iov_len = rpc_buffer_.size();
 
-  // We always setup to receive an FD even though most messages do not pass one.
-  uint8_t control_buffer[CMSG_SPACE(sizeof(int))];
-  memset(control_buffer, 0, CMSG_SPACE(sizeof(int)));
+  // We always setup to receive FDs even though most messages do not pass any.
+  uint8_t control_buffer[CMSG_SPACE(sizeof(int) * RpcGetListenSocketsReply::MAX_SOCKETS)];
+  memset(control_buffer, 0, sizeof(control_buffer));
 
   msghdr message;
   memset(&message, 0, sizeof(message));
   message.msg_iov = iov;
   message.msg_iovlen = 1;
   message.msg_control = control_buffer;
-  message.msg_controllen = CMSG_SPACE(sizeof(int));
+  message.msg_controllen = sizeof(control_buffer);
 
   int rc = recvmsg(my_domain_socket_, &message, 0);
   if (!block && rc == -1 && errno == EAGAIN) {
@@ -306,9 +609,9 @@ HotRestartImpl::RpcBase* HotRestartImpl::receiveRpc(bool block) {
   RpcBase* rpc = reinterpret_cast<RpcBase*>(&rpc_buffer_[0]);
   RELEASE_ASSERT(static_cast<uint64_t>(rc) == rpc->length_);
 
-  // We should only get control data in a GetListenSocketReply. If that's the case, pull the
-  // cloned fd out of the control data and stick it into the RPC so that higher level code does
-  // need to deal with any of this.
+  // We should only get control data in a GetListenSocketReply or GetListenSocketsReply. If that's
+  // the case, pull the cloned fds out of the control data and stick them into the RPC so that
+  // higher level code does need to deal with any of this.
   for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr;
        cmsg = CMSG_NXTHDR(&message, cmsg)) {
 
@@ -317,6 +620,12 @@ HotRestartImpl::RpcBase* HotRestartImpl::receiveRpc(bool block) {
 
       reinterpret_cast<RpcGetListenSocketReply*>(rpc)->fd_ =
           *reinterpret_cast<int*>(CMSG_DATA(cmsg));
+    } else if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+               rpc->type_ == RpcMessageType::GetListenSocketsReply) {
+
+      RpcGetListenSocketsReply* reply = reinterpret_cast<RpcGetListenSocketsReply*>(rpc);
+      RELEASE_ASSERT(cmsg->cmsg_len == CMSG_LEN(sizeof(int) * reply->num_sockets_));
+      memcpy(reply->fds_, CMSG_DATA(cmsg), sizeof(int) * reply->num_sockets_);
     } else {
       RELEASE_ASSERT(false);
     }
@@ -345,11 +654,18 @@ void HotRestartImpl::onGetListenSocket(RpcGetListenSocketRequest& rpc) {
   RpcGetListenSocketReply reply;
   reply.fd_ = -1;
 
+  // Requests from a child which doesn't know about worker_index_ end at address_, and are for the
+  // first socket.
+  const uint32_t worker_index =
+      rpc.length_ >= sizeof(RpcGetListenSocketRequest) ? rpc.worker_index_ : 0;
   Network::Address::InstanceConstSharedPtr addr =
       Network::Utility::resolveUrl(std::string(rpc.address_));
   for (const auto& listener : server_->listenerManager().listeners()) {
     if (*listener.get().socket().localAddress() == *addr) {
-      reply.fd_ = listener.get().socket().fd();
+      Network::ListenSocket* socket = listener.get().workerSocket(worker_index);
+      if (socket != nullptr) {
+        reply.fd_ = socket->fd();
+      }
       break;
     }
   }
@@ -386,6 +702,83 @@ void HotRestartImpl::onGetListenSocket(RpcGetListenSocketRequest& rpc) {
   }
 }
 
+void HotRestartImpl::onGetListenSockets(RpcGetListenSocketsRequest& rpc) {
+  struct ListenSocket {
+    std::string address_;
+    uint32_t worker_index_;
+    int fd_;
+  };
+
+  // All the listen sockets, in listener order so that the child can page through them.
+  std::vector<ListenSocket> sockets;
+  for (const auto& listener : server_->listenerManager().listeners()) {
+    Network::ListenSocket* first_socket = listener.get().workerSocket(0);
+    if (first_socket == nullptr) {
+      continue;
+    }
+    const std::string address = fmt::format("tcp://{}", first_socket->localAddress()->asString());
+    if (listener.get().workerSocket(1) == first_socket) {
+      sockets.push_back({address, RpcGetListenSocketsReply::ANY_WORKER, first_socket->fd()});
+      continue;
+    }
+    for (uint32_t worker_index = 0;; worker_index++) {
+      Network::ListenSocket* socket = listener.get().workerSocket(worker_index);
+      if (socket == nullptr) {
+        break;
+      }
+      sockets.push_back({address, worker_index, socket->fd()});
+    }
+  }
+
+  RpcGetListenSocketsReply reply;
+  const uint32_t total = sockets.size();
+  const uint32_t first = rpc.first_;
+  reply.total_ = total;
+  reply.next_ = std::min(first, total);
+  while (reply.next_ < reply.total_ && reply.num_sockets_ < RpcGetListenSocketsReply::MAX_SOCKETS) {
+    const ListenSocket& socket = sockets[reply.next_++];
+    RpcGetListenSocketsReply::Socket& reply_socket = reply.sockets_[reply.num_sockets_];
+    if (socket.address_.length() >= sizeof(reply_socket.address_)) {
+      continue;
+    }
+    StringUtil::strlcpy(reply_socket.address_, socket.address_.c_str(),
+                        sizeof(reply_socket.address_));
+    reply_socket.worker_index_ = socket.worker_index_;
+    reply.fds_[reply.num_sockets_++] = socket.fd_;
+  }
+
+  if (reply.num_sockets_ == 0) {
+    sendMessage(child_address_, reply);
+    return;
+  }
+
+  iovec iov[1];
+  iov[0].iov_base = &reply;
+  iov[0].iov_len = reply.length_;
+
+  uint8_t control_buffer[CMSG_SPACE(sizeof(int) * RpcGetListenSocketsReply::MAX_SOCKETS)];
+  memset(control_buffer, 0, sizeof(control_buffer));
+
+  msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_name = &child_address_;
+  message.msg_namelen = sizeof(child_address_);
+  message.msg_iov = iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control_buffer;
+  message.msg_controllen = CMSG_SPACE(sizeof(int) * reply.num_sockets_);
+
+  cmsghdr* control_message = CMSG_FIRSTHDR(&message);
+  control_message->cmsg_level = SOL_SOCKET;
+  control_message->cmsg_type = SCM_RIGHTS;
+  control_message->cmsg_len = CMSG_LEN(sizeof(int) * reply.num_sockets_);
+  memcpy(CMSG_DATA(control_message), reply.fds_, sizeof(int) * reply.num_sockets_);
+
+  int rc = sendmsg(my_domain_socket_, &message, 0);
+  RELEASE_ASSERT(rc != -1);
+  UNREFERENCED_PARAMETER(rc);
+}
+
 void HotRestartImpl::onSocketEvent() {
   while (true) {
     RpcBase* base_message = receiveRpc(false);
@@ -409,6 +802,13 @@ void HotRestartImpl::onSocketEvent() {
       break;
     }
 
+    case RpcMessageType::GetListenSocketsRequest: {
+      RpcGetListenSocketsRequest* message =
+          reinterpret_cast<RpcGetListenSocketsRequest*>(base_message);
+      onGetListenSockets(*message);
+      break;
+    }
+
     case RpcMessageType::GetStatsRequest: {
       GetParentStatsInfo info;
       server_->getParentStats(info);
@@ -6,7 +6,11 @@
 #include <array>
 #include <atomic>
 #include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
 #include <string>
+#include <utility>
 
 #include "envoy/server/hot_restart.h"
 #include "envoy/server/options.h"
@@ -18,60 +22,16 @@ namespace Envoy {
 namespace Server {
 
 /**
- * Shared memory segment. This structure is laid directly into shared memory and is used amongst
- * all running envoy processes.
+ * Implementation of Thread::BasicLockable that operates on a process shared pthread mutex.
  */
-class SharedMemory {
+class ProcessSharedMutex : public Thread::BasicLockable {
 public:
-  static void configure(size_t max_num_stats, size_t max_stat_name_len);
-  static std::string version(uint64_t max_num_stats, uint64_t max_stat_name_len);
-  std::string version();
-
-private:
-  struct Flags {
-    static const uint64_t INITIALIZING = 0x1;
-  };
-
-  // Due to the flexible-array-length of stats_slots_, c-style allocation
-  // and initialization are neccessary.
-  SharedMemory() = delete;
-  ~SharedMemory() = delete;
-
-  /**
-   * Initialize the shared memory segment, depending on whether we should be the first running
-   * envoy, or a host restarted envoy process.
-   */
-  static SharedMemory& initialize(Options& options);
+  ProcessSharedMutex(pthread_mutex_t& mutex) : mutex_(mutex) {}
 
   /**
    * Initialize a pthread mutex for process shared locking.
    */
-  void initializeMutex(pthread_mutex_t& mutex);
-
-  static const uint64_t VERSION;
-
-  uint64_t size_;
-  uint64_t version_;
-  uint64_t num_stats_;
-  uint64_t entry_size_;
-  std::atomic<uint64_t> flags_;
-  pthread_mutex_t log_lock_;
-  pthread_mutex_t access_log_lock_;
-  pthread_mutex_t stat_lock_;
-  pthread_mutex_t init_lock_;
-  alignas(Stats::RawStatData) uint8_t
-      stats_slots_[]; // array of Stats::RawStatData, which has a flexible-array-length member
-                      // so non-fixed size
-
-  friend class HotRestartImpl;
-};
-
-/**
- * Implementation of Thread::BasicLockable that operates on a process shared pthread mutex.
- */
-class ProcessSharedMutex : public Thread::BasicLockable {
-public:
-  ProcessSharedMutex(pthread_mutex_t& mutex) : mutex_(mutex) {}
+  static void initialize(pthread_mutex_t& mutex);
 
   void lock() override {
     // Deal with robust handling here. If the other process dies without unlocking, we are going
@@ -108,6 +68,173 @@ private:
   pthread_mutex_t& mutex_;
 };
 
+/**
+ * Segment of the shared memory stats region, laid directly into shared memory. It holds a fixed
+ * number of stat slots and an index of them, guarded by a lock of its own. The first segment
+ * follows the SharedMemory header, and further ones are shared memory objects of their own which
+ * are added as stats run out.
+ */
+class SharedStatSegment {
+public:
+  /**
+   * @return the number of entries in the stat index for a given number of stats. This is a power
+   *         of 2, and at least twice the number of stats so that probe sequences stay short.
+   */
+  static uint64_t statIndexSize(uint64_t num_stats);
+
+  /**
+   * @return the total size of a segment.
+   */
+  static uint64_t totalSize(uint64_t num_stats, uint64_t entry_size);
+
+  /**
+   * Initialize a new segment.
+   */
+  void initialize(uint64_t num_stats, uint64_t entry_size);
+
+  /**
+   * Find a stat, or add it if it is missing and the segment is open. A segment which is found to
+   * be full is closed for good. Must be called with the segment lock held.
+   * @param name supplies the name of the stat.
+   * @param hash supplies the hash of the name in the stat index.
+   * @param may_close supplies whether the segment may be closed if it is full.
+   * @return Stats::RawStatData* the stat with a reference added, or nullptr if the stat is not in
+   *         the segment and could not be added to it.
+   */
+  Stats::RawStatData* alloc(const std::string& name, uint64_t hash, bool may_close);
+
+  /**
+   * Release a reference to a stat of the segment. Must be called with the segment lock held.
+   */
+  void free(Stats::RawStatData& data);
+
+  /**
+   * @return whether a stat is in the segment.
+   */
+  bool contains(const Stats::RawStatData& data) const {
+    const uint8_t* address = reinterpret_cast<const uint8_t*>(&data);
+    return address >= stats_slots_ && address < stats_slots_ + entry_size_ * num_stats_;
+  }
+
+  uint64_t size() const { return size_; }
+
+  pthread_mutex_t lock_;
+
+private:
+  // Due to the flexible-array-length of stats_slots_, c-style allocation
+  // and initialization are neccessary.
+  SharedStatSegment() = delete;
+  ~SharedStatSegment() = delete;
+
+  Stats::RawStatData& statSlot(uint64_t slot) {
+    return *reinterpret_cast<Stats::RawStatData*>(stats_slots_ + entry_size_ * slot);
+  }
+  uint64_t statSlotNumber(const Stats::RawStatData& data) const {
+    return (reinterpret_cast<const uint8_t*>(&data) - stats_slots_) / entry_size_;
+  }
+  uint32_t* statIndex() {
+    return reinterpret_cast<uint32_t*>(stats_slots_ + entry_size_ * num_stats_);
+  }
+  uint32_t* freeStatSlots() { return statIndex() + stat_index_size_; }
+
+  /**
+   * Rebuild the stat index from the stat slots, dropping all tombstones. Must be called with the
+   * segment lock held.
+   */
+  void rebuildStatIndex();
+
+  // Stat index entries are either INDEX_EMPTY, INDEX_TOMBSTONE for a removed entry, or a stat slot
+  // number plus INDEX_SLOT_OFFSET.
+  static const uint32_t INDEX_EMPTY = 0;
+  static const uint32_t INDEX_TOMBSTONE = 1;
+  static const uint32_t INDEX_SLOT_OFFSET = 2;
+
+  uint64_t size_;
+  uint64_t num_stats_;
+  uint64_t entry_size_;
+  // The following are protected by lock_.
+  // Set once the segment was found full, after which no stat is added to it, not even in slots
+  // released later. A stat is then only ever added to the first open segment, after looking for
+  // it in all the closed ones, so that no two processes can add it to different segments.
+  bool closed_;
+  uint64_t stat_index_size_;
+  uint64_t stat_index_tombstones_;
+  // Slots at or past this one have never been used.
+  uint64_t next_stat_slot_;
+  uint64_t num_free_stat_slots_;
+  // Array of Stats::RawStatData, which has a flexible-array-length member so non-fixed size. It is
+  // followed by the stat index, an open addressed (linear probing) hash table of stat_index_size_
+  // uint32_t entries keyed on the stat name, and then by a stack of num_free_stat_slots_ uint32_t
+  // slot numbers of released slots, with room for num_stats_ entries.
+  alignas(Stats::RawStatData) uint8_t stats_slots_[];
+
+  friend class SharedMemory;
+};
+
+/**
+ * Shared memory segment. This structure is laid directly into shared memory and is used amongst
+ * all running envoy processes.
+ */
+class SharedMemory {
+public:
+  static void configure(size_t max_num_stats, size_t max_stat_name_len);
+  static std::string version(uint64_t max_num_stats, uint64_t max_stat_name_len);
+  std::string version();
+
+  // The maximum number of stat segments, including the first one.
+  static const uint64_t MAX_STAT_SEGMENTS = 16;
+
+private:
+  struct Flags {
+    static const uint64_t INITIALIZING = 0x1;
+  };
+
+  // Due to the flexible-array-length of first_stat_segment_, c-style allocation
+  // and initialization are neccessary.
+  SharedMemory() = delete;
+  ~SharedMemory() = delete;
+
+  /**
+   * Initialize the shared memory segment, depending on whether we should be the first running
+   * envoy, or a host restarted envoy process.
+   */
+  static SharedMemory& initialize(Options& options);
+
+  /**
+   * @return the name of the shared memory object of a stat segment other than the first one.
+   */
+  static std::string statSegmentName(uint64_t base_id, uint64_t index);
+
+  /**
+   * @return the total size of the shared memory segment.
+   */
+  static uint64_t totalSize(uint64_t max_num_stats, uint64_t entry_size);
+
+  SharedStatSegment& firstStatSegment() {
+    return *reinterpret_cast<SharedStatSegment*>(first_stat_segment_);
+  }
+
+  static const uint64_t VERSION;
+
+  uint64_t size_;
+  uint64_t version_;
+  // The number of stats of each stat segment.
+  uint64_t num_stats_;
+  uint64_t entry_size_;
+  std::atomic<uint64_t> flags_;
+  pthread_mutex_t log_lock_;
+  pthread_mutex_t access_log_lock_;
+  // Held while adding a stat segment.
+  pthread_mutex_t stat_lock_;
+  pthread_mutex_t init_lock_;
+  // The number of stat segments which have been initialized, each process mapping the ones past
+  // the first as it comes across them.
+  std::atomic<uint64_t> num_stat_segments_;
+  alignas(SharedStatSegment) uint8_t first_stat_segment_[];
+
+  friend class HotRestartImpl;
+};
+
 /**
  * Implementation of HotRestart built for Linux.
  */
@@ -122,7 +249,7 @@ public:
 
   // Server::HotRestart
   void drainParentListeners() override;
-  int duplicateParentListenSocket(const std::string& address) override;
+  int duplicateParentListenSocket(const std::string& address, uint32_t worker_index) override;
   void getParentStats(GetParentStatsInfo& info) override;
   void initialize(Event::Dispatcher& dispatcher, Server::Instance& server) override;
   void shutdownParentAdmin(ShutdownParentAdminInfo& info) override;
@@ -144,7 +271,9 @@ private:
     TerminateRequest = 6,
     UnknownRequestReply = 7,
     GetStatsRequest = 8,
-    GetStatsReply = 9
+    GetStatsReply = 9,
+    GetListenSocketsRequest = 10,
+    GetListenSocketsReply = 11
   };
 
   struct RpcBase {
@@ -159,6 +288,10 @@ private:
     RpcGetListenSocketRequest() : RpcBase(RpcMessageType::GetListenSocketRequest, sizeof(*this)) {}
 
     char address_[256]{0};
+    // This comes after address_ so that the request stays compatible across a hot restart with a
+    // process that doesn't know about it. A parent that doesn't know about it ignores it, and
+    // answers every request for an address with the same socket.
+    uint32_t worker_index_{0};
   } __attribute__((packed));
 
   struct RpcGetListenSocketReply : public RpcBase {
@@ -167,6 +300,38 @@ private:
     int fd_{0};
   } __attribute__((packed));
 
+  struct RpcGetListenSocketsRequest : public RpcBase {
+    RpcGetListenSocketsRequest()
+        : RpcBase(RpcMessageType::GetListenSocketsRequest, sizeof(*this)) {}
+
+    // The index of the first socket to return, of all the listen sockets of the parent.
+    uint32_t first_{0};
+  } __attribute__((packed));
+
+  struct RpcGetListenSocketsReply : public RpcBase {
+    RpcGetListenSocketsReply() : RpcBase(RpcMessageType::GetListenSocketsReply, sizeof(*this)) {}
+
+    // Sockets are returned in batches, as the number of fds that can be passed in one message is
+    // limited.
+    static const uint32_t MAX_SOCKETS = 64;
+    // The worker index of a socket which the listener shares between all of its workers.
+    static const uint32_t ANY_WORKER = std::numeric_limits<uint32_t>::max();
+
+    struct Socket {
+      char address_[64];
+      uint32_t worker_index_;
+    } __attribute__((packed));
+
+    // The number of listen sockets of the parent, and the index of the socket after the last one
+    // in this reply.
+    uint32_t total_{0};
+    uint32_t next_{0};
+    uint32_t num_sockets_{0};
+    Socket sockets_[MAX_SOCKETS];
+    // The fds of sockets_, which are filled in from the control data when the reply is received.
+    int fds_[MAX_SOCKETS];
+  } __attribute__((packed));
+
   struct RpcShutdownAdminReply : public RpcBase {
     RpcShutdownAdminReply() : RpcBase(RpcMessageType::ShutdownAdminReply, sizeof(*this)) {}
 
@@ -192,12 +357,43 @@ private:
   void initDomainSocketAddress(sockaddr_un* address);
   sockaddr_un createDomainSocketAddress(uint64_t id);
   void onGetListenSocket(RpcGetListenSocketRequest& rpc);
+  void onGetListenSockets(RpcGetListenSocketsRequest& rpc);
+
+  /**
+   * Fetch all the listen sockets of the parent with GetListenSocketsRequest, into
+   * parent_listen_sockets_.
+   * @return bool false if the parent doesn't support GetListenSocketsRequest, in which case
+   *         sockets must be requested one at a time with GetListenSocketRequest.
+   */
+  bool getParentListenSockets();
+  void closeParentListenSockets();
   void onSocketEvent();
   RpcBase* receiveRpc(bool block);
   void sendMessage(sockaddr_un& address, RpcBase& rpc);
 
+  /**
+   * @return the stat segment with the given index, which must have been initialized, mapping it
+   *         into this process the first time.
+   */
+  SharedStatSegment& statSegment(uint64_t index);
+
+  /**
+   * Add the stat segment with the given index, unless another process already did.
+   */
+  void addStatSegment(uint64_t index);
+
+  /**
+   * Map the shared memory object of a stat segment other than the first one.
+   * @param index supplies the index of the segment.
+   * @param create supplies whether to create the object, rather than open an existing one.
+   */
+  SharedStatSegment& mapStatSegment(uint64_t index, bool create);
+
   Options& options_;
   SharedMemory& shmem_;
+  // The stat segments mapped into this process, set once under stat_segments_lock_.
+  std::array<std::atomic<SharedStatSegment*>, SharedMemory::MAX_STAT_SEGMENTS> stat_segments_{};
+  std::mutex stat_segments_lock_;
   ProcessSharedMutex log_lock_;
   ProcessSharedMutex access_log_lock_;
   ProcessSharedMutex stat_lock_;
@@ -206,9 +402,13 @@ private:
   sockaddr_un parent_address_;
   sockaddr_un child_address_;
   Event::FileEventPtr socket_event_;
-  std::array<uint8_t, 4096> rpc_buffer_;
+  std::array<uint8_t, 8192> rpc_buffer_;
   Server::Instance* server_{};
   bool parent_terminated_{};
+  // Whether the listen sockets of the parent have been fetched with GetListenSocketsRequest, and
+  // the ones which haven't been claimed yet, by address and worker index.
+  bool parent_listen_sockets_fetched_{};
+  std::map<std::pair<std::string, uint32_t>, int> parent_listen_sockets_;
 };
 
 } // namespace Server
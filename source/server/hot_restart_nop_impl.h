@@ -15,7 +15,7 @@ public:
   HotRestartNopImpl(){};
 
   void drainParentListeners() override {}
-  int duplicateParentListenSocket(const std::string&) override { return -1; }
+  int duplicateParentListenSocket(const std::string&, uint32_t) override { return -1; }
   void getParentStats(GetParentStatsInfo& info) override { memset(&info, 0, sizeof(info)); }
   void initialize(Event::Dispatcher&, Server::Instance&) override {}
   void shutdownParentAdmin(ShutdownParentAdminInfo&) override {}
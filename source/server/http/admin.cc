@@ -1,7 +1,9 @@
 #include "server/http/admin.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <fstream>
+#include <regex>
 #include <string>
 #include <unordered_set>
 
@@ -25,6 +27,7 @@
 #include "common/http/headers.h"
 #include "common/http/http1/codec_impl.h"
 #include "common/json/json_loader.h"
+#include "common/memory/stats.h"
 #include "common/network/listen_socket_impl.h"
 #include "common/profiler/profiler.h"
 #include "common/router/config_impl.h"
@@ -40,6 +43,7 @@
 #include "rapidjson/schema.h"
 #include "rapidjson/stream.h"
 #include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
 #include "spdlog/spdlog.h"
 
 using namespace rapidjson;
@@ -47,6 +51,220 @@ using namespace rapidjson;
 namespace Envoy {
 namespace Server {
 
+namespace {
+
+// Prometheus output is added to the response in chunks of about this size.
+const size_t PROMETHEUS_CHUNK_SIZE = 16 * 1024;
+
+// Chunked responses are generated in chunks of about this size.
+const uint64_t RESPONSE_CHUNK_SIZE = 64 * 1024;
+
+/**
+ * Keep the entries of a listing from an offset, up to a limit.
+ */
+template <class T> void paginate(std::vector<T>& entries, uint64_t offset, uint64_t limit) {
+  entries.erase(entries.begin(), entries.begin() + std::min<uint64_t>(offset, entries.size()));
+  if (entries.size() > limit) {
+    entries.resize(limit);
+  }
+}
+
+} // namespace
+
+#define MAKE_CHUNKED_ADMIN_HANDLER(X)                                                              \
+  [this](const std::string& url, Buffer::Instance& data,                                          \
+         ChunkedAdminResponsePtr& chunked_response) -> Http::Code {                                \
+    return X(url, data, chunked_response);                                                         \
+  }
+
+/**
+ * The clusters, as text with a line per setting and host stat, or as JSON. The clusters are looked
+ * up again for each chunk, as they can be removed or updated in between. A cluster removed before
+ * it is reached is skipped.
+ */
+class AdminImpl::ClustersResponse : public ChunkedAdminResponse {
+public:
+  ClustersResponse(AdminImpl& parent, bool json, std::vector<std::string>&& names)
+      : parent_(parent), json_(json), names_(std::move(names)) {}
+
+  // Server::ChunkedAdminResponse
+  bool nextChunk(Buffer::Instance& response) override;
+
+private:
+  /**
+   * Add a cluster from where the previous chunk stopped, until the chunk is full.
+   * @return bool whether the whole cluster was added.
+   */
+  bool addCluster(const Upstream::Cluster& cluster, uint64_t chunk_end,
+                  Buffer::Instance& response);
+
+  AdminImpl& parent_;
+  const bool json_;
+  const std::vector<std::string> names_;
+  bool started_{};
+  size_t next_cluster_{};
+  // The next host to add, as a priority and an index in the hosts of the priority.
+  size_t next_priority_{};
+  size_t next_host_{};
+  // Whether the settings of the cluster being added were added.
+  bool in_cluster_{};
+  uint64_t clusters_added_{};
+  uint64_t hosts_added_{};
+};
+
+bool AdminImpl::ClustersResponse::nextChunk(Buffer::Instance& response) {
+  const uint64_t chunk_end = response.length() + RESPONSE_CHUNK_SIZE;
+  if (!started_) {
+    started_ = true;
+    const std::string version_info = parent_.server_.clusterManager().versionInfo();
+    if (json_) {
+      response.add(fmt::format("{{\"version_info\":{},\"clusters\":[", jsonString(version_info)));
+    } else {
+      response.add(fmt::format("version_info::{}\n", version_info));
+    }
+  }
+
+  const Upstream::ClusterManager::ClusterInfoMap clusters =
+      parent_.server_.clusterManager().clusters();
+  while (next_cluster_ < names_.size() && response.length() < chunk_end) {
+    auto cluster = clusters.find(names_[next_cluster_]);
+    if (cluster != clusters.end()) {
+      if (!addCluster(cluster->second.get(), chunk_end, response)) {
+        return true;
+      }
+    } else if (in_cluster_ && json_) {
+      // The cluster was removed after some of its hosts were added.
+      response.add("]}");
+    }
+
+    next_cluster_++;
+    next_priority_ = 0;
+    next_host_ = 0;
+    in_cluster_ = false;
+    hosts_added_ = 0;
+  }
+
+  if (next_cluster_ < names_.size()) {
+    return true;
+  }
+
+  if (json_) {
+    response.add("]}");
+  }
+  return false;
+}
+
+bool AdminImpl::ClustersResponse::addCluster(const Upstream::Cluster& cluster, uint64_t chunk_end,
+                                             Buffer::Instance& response) {
+  const std::string& name = cluster.info()->name();
+  if (!in_cluster_) {
+    in_cluster_ = true;
+    if (json_) {
+      if (clusters_added_ > 0) {
+        response.add(",");
+      }
+      addClusterJson(cluster, response);
+    } else {
+      parent_.addOutlierInfo(name, cluster.outlierDetector(), response);
+      parent_.addCircuitSettings(
+          name, "default", cluster.info()->resourceManager(Upstream::ResourcePriority::Default),
+          response);
+      parent_.addCircuitSettings(
+          name, "high", cluster.info()->resourceManager(Upstream::ResourcePriority::High),
+          response);
+      response.add(fmt::format("{}::added_via_api::{}\n", name, cluster.info()->addedViaApi()));
+    }
+    clusters_added_++;
+  }
+
+  const std::vector<Upstream::HostSetPtr>& host_sets = cluster.prioritySet().hostSetsPerPriority();
+  for (; next_priority_ < host_sets.size(); next_priority_++, next_host_ = 0) {
+    const std::vector<Upstream::HostSharedPtr>& hosts = host_sets[next_priority_]->hosts();
+    for (; next_host_ < hosts.size(); next_host_++) {
+      if (response.length() >= chunk_end) {
+        return false;
+      }
+
+      if (json_) {
+        if (hosts_added_ > 0) {
+          response.add(",");
+        }
+        addHostJson(*hosts[next_host_], response);
+      } else {
+        parent_.addHostInfo(name, *hosts[next_host_], response);
+      }
+      hosts_added_++;
+    }
+  }
+
+  if (json_) {
+    response.add("]}");
+  }
+  return true;
+}
+
+/**
+ * The counters and gauges, followed by the histograms in text, as of when the request was made.
+ */
+class AdminImpl::StatsResponse : public ChunkedAdminResponse {
+public:
+  StatsResponse(bool json, std::vector<std::pair<std::string, uint64_t>>&& stats,
+                std::vector<Stats::ParentHistogramSharedPtr>&& histograms)
+      : json_(json), stats_(std::move(stats)), histograms_(std::move(histograms)) {}
+
+  // Server::ChunkedAdminResponse
+  bool nextChunk(Buffer::Instance& response) override;
+
+private:
+  const bool json_;
+  const std::vector<std::pair<std::string, uint64_t>> stats_;
+  const std::vector<Stats::ParentHistogramSharedPtr> histograms_;
+  bool started_{};
+  size_t next_stat_{};
+  size_t next_histogram_{};
+};
+
+bool AdminImpl::StatsResponse::nextChunk(Buffer::Instance& response) {
+  const uint64_t chunk_end = response.length() + RESPONSE_CHUNK_SIZE;
+  // The JSON is laid out as it was when the whole document was written by a rapidjson
+  // PrettyWriter.
+  if (!started_) {
+    started_ = true;
+    if (json_) {
+      response.add("{\n    \"stats\": [");
+    }
+  }
+
+  for (; next_stat_ < stats_.size() && response.length() < chunk_end; next_stat_++) {
+    const std::pair<std::string, uint64_t>& stat = stats_[next_stat_];
+    if (json_) {
+      response.add(fmt::format("{}\n        {{\n            \"name\": {},\n            \"value\": "
+                               "{}\n        }}",
+                               next_stat_ > 0 ? "," : "", jsonString(stat.first), stat.second));
+    } else {
+      response.add(fmt::format("{}: {}\n", stat.first, stat.second));
+    }
+  }
+
+  // Histograms are written after the other stats, as the interval and cumulative value of each
+  // quantile.
+  for (; next_stat_ == stats_.size() && next_histogram_ < histograms_.size() &&
+         response.length() < chunk_end;
+       next_histogram_++) {
+    const Stats::ParentHistogram& histogram = *histograms_[next_histogram_];
+    response.add(fmt::format("{}: {}\n", histogram.name(), histogramSummary(histogram)));
+  }
+
+  if (next_stat_ < stats_.size() || next_histogram_ < histograms_.size()) {
+    return true;
+  }
+
+  if (json_) {
+    response.add(stats_.empty() ? "]\n}" : "\n    ]\n}");
+  }
+  return false;
+}
+
 AdminFilter::AdminFilter(AdminImpl& parent) : parent_(parent) {}
 
 Http::FilterHeadersStatus AdminFilter::decodeHeaders(Http::HeaderMap& headers, bool end_stream) {
@@ -71,6 +289,24 @@ Http::FilterTrailersStatus AdminFilter::decodeTrailers(Http::HeaderMap&) {
   return Http::FilterTrailersStatus::StopIteration;
 }
 
+void AdminFilter::onDestroy() {
+  if (chunked_response_) {
+    callbacks_->removeDownstreamWatermarkCallbacks(*this);
+    chunked_response_.reset();
+  }
+  chunk_timer_.reset();
+}
+
+void AdminFilter::onAboveWriteBufferHighWatermark() { high_watermark_count_++; }
+
+void AdminFilter::onBelowWriteBufferLowWatermark() {
+  ASSERT(high_watermark_count_ > 0);
+  if (--high_watermark_count_ == 0 && chunk_pending_) {
+    chunk_pending_ = false;
+    chunk_timer_->enableTimer(std::chrono::milliseconds(0));
+  }
+}
+
 bool AdminImpl::changeLogLevel(const Http::Utility::QueryParams& params) {
   if (params.size() != 1) {
     return false;
@@ -142,59 +378,153 @@ void AdminImpl::addCircuitSettings(const std::string& cluster_name, const std::s
                            resource_manager.retries().max()));
 }
 
-Http::Code AdminImpl::handlerClusters(const std::string&, Buffer::Instance& response) {
-  response.add(fmt::format("version_info::{}\n", server_.clusterManager().versionInfo()));
+void AdminImpl::addHostInfo(const std::string& cluster_name, const Upstream::Host& host,
+                            Buffer::Instance& response) {
+  std::map<std::string, uint64_t> all_stats;
+  for (const Stats::CounterSharedPtr& counter : host.counters()) {
+    all_stats[counter->name()] = counter->value();
+  }
 
-  for (auto& cluster : server_.clusterManager().clusters()) {
-    addOutlierInfo(cluster.second.get().info()->name(), cluster.second.get().outlierDetector(),
-                   response);
-
-    addCircuitSettings(
-        cluster.second.get().info()->name(), "default",
-        cluster.second.get().info()->resourceManager(Upstream::ResourcePriority::Default),
-        response);
-    addCircuitSettings(
-        cluster.second.get().info()->name(), "high",
-        cluster.second.get().info()->resourceManager(Upstream::ResourcePriority::High), response);
-
-    response.add(fmt::format("{}::added_via_api::{}\n", cluster.second.get().info()->name(),
-                             cluster.second.get().info()->addedViaApi()));
-    for (auto& host_set : cluster.second.get().prioritySet().hostSetsPerPriority()) {
-      for (auto& host : host_set->hosts()) {
-        std::map<std::string, uint64_t> all_stats;
-        for (const Stats::CounterSharedPtr& counter : host->counters()) {
-          all_stats[counter->name()] = counter->value();
-        }
+  for (const Stats::GaugeSharedPtr& gauge : host.gauges()) {
+    all_stats[gauge->name()] = gauge->value();
+  }
 
-        for (const Stats::GaugeSharedPtr& gauge : host->gauges()) {
-          all_stats[gauge->name()] = gauge->value();
-        }
+  const std::string address = host.address()->asString();
+  for (auto stat : all_stats) {
+    response.add(fmt::format("{}::{}::{}::{}\n", cluster_name, address, stat.first, stat.second));
+  }
 
-        for (auto stat : all_stats) {
-          response.add(fmt::format("{}::{}::{}::{}\n", cluster.second.get().info()->name(),
-                                   host->address()->asString(), stat.first, stat.second));
-        }
+  response.add(fmt::format("{}::{}::health_flags::{}\n", cluster_name, address,
+                           Upstream::HostUtility::healthFlagsToString(host)));
+  response.add(fmt::format("{}::{}::weight::{}\n", cluster_name, address, host.weight()));
+  response.add(
+      fmt::format("{}::{}::region::{}\n", cluster_name, address, host.locality().region()));
+  response.add(fmt::format("{}::{}::zone::{}\n", cluster_name, address, host.locality().zone()));
+  response.add(
+      fmt::format("{}::{}::sub_zone::{}\n", cluster_name, address, host.locality().sub_zone()));
+  response.add(fmt::format("{}::{}::canary::{}\n", cluster_name, address, host.canary()));
+  response.add(fmt::format("{}::{}::success_rate::{}\n", cluster_name, address,
+                           host.outlierDetector().successRate()));
+}
+
+void AdminImpl::addClusterJson(const Upstream::Cluster& cluster, Buffer::Instance& response) {
+  response.add(fmt::format("{{\"name\":{},\"added_via_api\":{}", jsonString(cluster.info()->name()),
+                           cluster.info()->addedViaApi()));
+
+  const Upstream::Outlier::Detector* outlier_detector = cluster.outlierDetector();
+  if (outlier_detector) {
+    response.add(fmt::format(
+        ",\"outlier\":{{\"success_rate_average\":{},\"success_rate_ejection_threshold\":{}}}",
+        outlier_detector->successRateAverage(), outlier_detector->successRateEjectionThreshold()));
+  }
+
+  const std::vector<std::pair<std::string, Upstream::ResourcePriority>> priorities{
+      {"default", Upstream::ResourcePriority::Default},
+      {"high", Upstream::ResourcePriority::High}};
+  response.add(",\"circuit_breakers\":{");
+  for (size_t i = 0; i < priorities.size(); i++) {
+    Upstream::ResourceManager& resource_manager =
+        cluster.info()->resourceManager(priorities[i].second);
+    response.add(fmt::format("{}\"{}\":{{\"max_connections\":{},\"max_pending_requests\":{},"
+                             "\"max_requests\":{},\"max_retries\":{}}}",
+                             i > 0 ? "," : "", priorities[i].first,
+                             resource_manager.connections().max(),
+                             resource_manager.pendingRequests().max(),
+                             resource_manager.requests().max(), resource_manager.retries().max()));
+  }
+
+  // The hosts follow, and the cluster is closed once they are all added.
+  response.add("},\"hosts\":[");
+}
+
+void AdminImpl::addHostJson(const Upstream::Host& host, Buffer::Instance& response) {
+  std::map<std::string, uint64_t> all_stats;
+  for (const Stats::CounterSharedPtr& counter : host.counters()) {
+    all_stats[counter->name()] = counter->value();
+  }
 
-        response.add(fmt::format("{}::{}::health_flags::{}\n", cluster.second.get().info()->name(),
-                                 host->address()->asString(),
-                                 Upstream::HostUtility::healthFlagsToString(*host)));
-        response.add(fmt::format("{}::{}::weight::{}\n", cluster.second.get().info()->name(),
-                                 host->address()->asString(), host->weight()));
-        response.add(fmt::format("{}::{}::region::{}\n", cluster.second.get().info()->name(),
-                                 host->address()->asString(), host->locality().region()));
-        response.add(fmt::format("{}::{}::zone::{}\n", cluster.second.get().info()->name(),
-                                 host->address()->asString(), host->locality().zone()));
-        response.add(fmt::format("{}::{}::sub_zone::{}\n", cluster.second.get().info()->name(),
-                                 host->address()->asString(), host->locality().sub_zone()));
-        response.add(fmt::format("{}::{}::canary::{}\n", cluster.second.get().info()->name(),
-                                 host->address()->asString(), host->canary()));
-        response.add(fmt::format("{}::{}::success_rate::{}\n", cluster.second.get().info()->name(),
-                                 host->address()->asString(),
-                                 host->outlierDetector().successRate()));
+  for (const Stats::GaugeSharedPtr& gauge : host.gauges()) {
+    all_stats[gauge->name()] = gauge->value();
+  }
+
+  std::vector<std::string> stats;
+  for (auto stat : all_stats) {
+    stats.push_back(fmt::format("{}:{}", jsonString(stat.first), stat.second));
+  }
+
+  response.add(fmt::format(
+      "{{\"address\":{},\"stats\":{{{}}},\"health_flags\":{},\"weight\":{},\"region\":{},"
+      "\"zone\":{},\"sub_zone\":{},\"canary\":{},\"success_rate\":{}}}",
+      jsonString(host.address()->asString()), StringUtil::join(stats, ","),
+      jsonString(Upstream::HostUtility::healthFlagsToString(host)), host.weight(),
+      jsonString(host.locality().region()), jsonString(host.locality().zone()),
+      jsonString(host.locality().sub_zone()), host.canary(),
+      host.outlierDetector().successRate()));
+}
+
+std::string AdminImpl::jsonString(const std::string& value) {
+  rapidjson::StringBuffer strbuf;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(strbuf);
+  writer.String(value.c_str(), value.size());
+  return strbuf.GetString();
+}
+
+bool AdminImpl::ListingParams::matches(const std::string& name) const {
+  return name.compare(0, prefix_.size(), prefix_) == 0 &&
+         (filter_ == nullptr || std::regex_search(name, *filter_));
+}
+
+bool AdminImpl::parseListingParams(const Http::Utility::QueryParams& params,
+                                   const std::vector<std::string>& formats,
+                                   ListingParams& listing) {
+  for (const auto& param : params) {
+    if (param.first == "prefix") {
+      listing.prefix_ = param.second;
+    } else if (param.first == "filter") {
+      try {
+        listing.filter_.reset(new std::regex(param.second));
+      } catch (const std::regex_error&) {
+        return false;
+      }
+    } else if (param.first == "offset") {
+      if (!StringUtil::atoul(param.second.c_str(), listing.offset_)) {
+        return false;
       }
+    } else if (param.first == "limit") {
+      if (!StringUtil::atoul(param.second.c_str(), listing.limit_)) {
+        return false;
+      }
+    } else if (param.first == "format" &&
+               std::find(formats.begin(), formats.end(), param.second) != formats.end()) {
+      listing.format_ = param.second;
+    } else {
+      return false;
     }
   }
 
+  return true;
+}
+
+Http::Code AdminImpl::handlerClusters(const std::string& url, Buffer::Instance& response,
+                                      ChunkedAdminResponsePtr& chunked_response) {
+  ListingParams listing;
+  if (!parseListingParams(Http::Utility::parseQueryString(url), {"json"}, listing)) {
+    response.add("usage: /clusters?format=json&prefix=<prefix>&filter=<regex>&offset=<n>"
+                 "&limit=<n>\n");
+    return Http::Code::BadRequest;
+  }
+
+  // The clusters are listed by name, so that the pages of a paginated listing follow each other.
+  std::vector<std::string> names;
+  for (auto& cluster : server_.clusterManager().clusters()) {
+    if (listing.matches(cluster.first)) {
+      names.push_back(cluster.first);
+    }
+  }
+  std::sort(names.begin(), names.end());
+  paginate(names, listing.offset_, listing.limit_);
+
+  chunked_response.reset(new ClustersResponse(*this, listing.format_ == "json", std::move(names)));
   return Http::Code::OK;
 }
 
@@ -221,6 +551,56 @@ Http::Code AdminImpl::handlerCpuProfiler(const std::string& url, Buffer::Instanc
   return Http::Code::OK;
 }
 
+Http::Code AdminImpl::handlerHeapProfiler(const std::string& url, Buffer::Instance& response) {
+  Http::Utility::QueryParams query_params = Http::Utility::parseQueryString(url);
+  if (query_params.size() != 1 ||
+      !((query_params.begin()->first == "enable" &&
+         (query_params.begin()->second == "y" || query_params.begin()->second == "n")) ||
+        (query_params.begin()->first == "dump" && query_params.begin()->second == "y"))) {
+    response.add("?enable=<y|n>\n");
+    response.add("?dump=y\n");
+    return Http::Code::BadRequest;
+  }
+
+  if (query_params.begin()->first == "dump") {
+    if (!Profiler::Heap::profilerEnabled()) {
+      response.add("the heap profiler is not enabled\n");
+      return Http::Code::BadRequest;
+    }
+
+    Profiler::Heap::dumpProfile("admin");
+    response.add("OK\n");
+    return Http::Code::OK;
+  }
+
+  // The heap profiles are written next to the CPU profile, with a sequence number and a .heap
+  // extension added to its path.
+  bool enable = query_params.begin()->second == "y";
+  if (enable && !Profiler::Heap::profilerEnabled()) {
+    if (!Profiler::Heap::startProfiler(profile_path_)) {
+      response.add("failure to start the heap profiler");
+      return Http::Code::InternalServerError;
+    }
+
+  } else if (!enable && Profiler::Heap::profilerEnabled()) {
+    Profiler::Heap::stopProfiler();
+  }
+
+  response.add("OK\n");
+  return Http::Code::OK;
+}
+
+Http::Code AdminImpl::handlerHeapSample(const std::string&, Buffer::Instance& response) {
+  const std::string sample = Memory::Stats::heapSample();
+  if (sample.empty()) {
+    response.add("heap sampling is not supported\n");
+    return Http::Code::NotImplemented;
+  }
+
+  response.add(sample);
+  return Http::Code::OK;
+}
+
 Http::Code AdminImpl::handlerHealthcheckFail(const std::string&, Buffer::Instance& response) {
   server_.failHealthcheck(true);
   response.add("OK\n");
@@ -263,6 +643,22 @@ Http::Code AdminImpl::handlerLogging(const std::string& url, Buffer::Instance& r
   return rc;
 }
 
+Http::Code AdminImpl::handlerMemory(const std::string&, Buffer::Instance& response) {
+  response.add(fmt::format("allocated: {}\n", Memory::Stats::totalCurrentlyAllocated()));
+  response.add(fmt::format("heap_size: {}\n", Memory::Stats::totalCurrentlyReserved()));
+  response.add(fmt::format("thread_cache: {}\n", Memory::Stats::totalThreadCacheBytes()));
+  response.add(fmt::format("pageheap_free: {}\n", Memory::Stats::totalPageHeapFree()));
+  response.add(fmt::format("pageheap_unmapped: {}\n", Memory::Stats::totalPageHeapUnmapped()));
+
+  // The heap's own report follows, when it has one.
+  const std::string report = Memory::Stats::heapReport();
+  if (!report.empty()) {
+    response.add("\n");
+    response.add(report);
+  }
+  return Http::Code::OK;
+}
+
 Http::Code AdminImpl::handlerResetCounters(const std::string&, Buffer::Instance& response) {
   for (const Stats::CounterSharedPtr& counter : server_.stats().counters()) {
     counter->reset();
@@ -279,42 +675,89 @@ Http::Code AdminImpl::handlerServerInfo(const std::string&, Buffer::Instance& re
                            current_time - server_.startTimeCurrentEpoch(),
                            current_time - server_.startTimeFirstEpoch(),
                            server_.options().restartEpoch()));
+  const Upstream::ClusterManagerInitTimes& init_times = server_.clusterManager().initTimes();
+  response.add(fmt::format("cluster_manager_init static_clusters={}ms cds={}ms cds_clusters={}ms\n",
+                           init_times.static_clusters_.count(), init_times.cds_.count(),
+                           init_times.cds_clusters_.count()));
   return Http::Code::OK;
 }
 
-Http::Code AdminImpl::handlerStats(const std::string& url, Buffer::Instance& response) {
+Http::Code AdminImpl::handlerStats(const std::string& url, Buffer::Instance& response,
+                                   ChunkedAdminResponsePtr& chunked_response) {
+  ListingParams listing;
+  if (!parseListingParams(Http::Utility::parseQueryString(url), {"json", "prometheus"}, listing)) {
+    response.add("usage: /stats?format=<json|prometheus>&prefix=<prefix>&filter=<regex>"
+                 "&offset=<n>&limit=<n>\n");
+    response.add("\n");
+    return Http::Code::NotFound;
+  }
+
+  if (listing.format_ == "prometheus") {
+    AdminImpl::statsAsPrometheus(server_.stats().counters(), server_.stats().gauges(),
+                                 listing.prefix_, response);
+    return Http::Code::OK;
+  }
+
   // We currently don't support timers locally (only via statsd) so just group all the counters
-  // and gauges together, alpha sort them, and spit them out.
-  Http::Code rc = Http::Code::OK;
-  const Http::Utility::QueryParams params = Http::Utility::parseQueryString(url);
+  // and gauges together, alpha sort them, and spit them out. The values are taken now, and only
+  // written out as the response is generated.
   std::map<std::string, uint64_t> all_stats;
   for (const Stats::CounterSharedPtr& counter : server_.stats().counters()) {
-    all_stats.emplace(counter->name(), counter->value());
+    if (listing.matches(counter->name())) {
+      all_stats.emplace(counter->name(), counter->value());
+    }
   }
 
   for (const Stats::GaugeSharedPtr& gauge : server_.stats().gauges()) {
-    all_stats.emplace(gauge->name(), gauge->value());
+    if (listing.matches(gauge->name())) {
+      all_stats.emplace(gauge->name(), gauge->value());
+    }
   }
 
-  if (params.size() == 0) {
-    // No Arguments so use the standard.
-    for (auto stat : all_stats) {
-      response.add(fmt::format("{}: {}\n", stat.first, stat.second));
-    }
-  } else {
-    const std::string format_key = params.begin()->first;
-    const std::string format_value = params.begin()->second;
-    if (format_key == "format" && format_value == "json") {
-      response.add(AdminImpl::statsAsJson(all_stats));
-    } else if (format_key == "format" && format_value == "prometheus") {
-      AdminImpl::statsAsPrometheus(server_.stats().counters(), server_.stats().gauges(), response);
-    } else {
-      response.add("usage: /stats?format=json \n");
-      response.add("\n");
-      rc = Http::Code::NotFound;
+  std::vector<Stats::ParentHistogramSharedPtr> histograms;
+  const bool json = listing.format_ == "json";
+  if (!json) {
+    for (const Stats::ParentHistogramSharedPtr& histogram : server_.stats().histograms()) {
+      if (histogram->cumulativeStatistics().sampleCount() > 0 &&
+          listing.matches(histogram->name())) {
+        histograms.push_back(histogram);
+      }
     }
+    std::sort(histograms.begin(), histograms.end(),
+              [](const Stats::ParentHistogramSharedPtr& lhs,
+                 const Stats::ParentHistogramSharedPtr& rhs) -> bool {
+                return lhs->name() < rhs->name();
+              });
   }
-  return rc;
+
+  // A page spans the stats and then the histograms.
+  std::vector<std::pair<std::string, uint64_t>> stats(all_stats.begin(), all_stats.end());
+  const uint64_t stats_skipped = std::min<uint64_t>(listing.offset_, stats.size());
+  paginate(stats, listing.offset_, listing.limit_);
+  paginate(histograms, listing.offset_ - stats_skipped, listing.limit_ - stats.size());
+
+  chunked_response.reset(new StatsResponse(json, std::move(stats), std::move(histograms)));
+  return Http::Code::OK;
+}
+
+Http::Code AdminImpl::handlerPrometheusStats(const std::string& url, Buffer::Instance& response) {
+  const Http::Utility::QueryParams params = Http::Utility::parseQueryString(url);
+  const auto prefix = params.find("prefix");
+  AdminImpl::statsAsPrometheus(server_.stats().counters(), server_.stats().gauges(),
+                               prefix == params.end() ? "" : prefix->second, response);
+  return Http::Code::OK;
+}
+
+std::string AdminImpl::histogramSummary(const Stats::ParentHistogram& histogram) {
+  const std::vector<double>& quantiles = histogram.intervalStatistics().supportedQuantiles();
+  const std::vector<double>& interval = histogram.intervalStatistics().computedQuantiles();
+  const std::vector<double>& cumulative = histogram.cumulativeStatistics().computedQuantiles();
+  std::vector<std::string> summary;
+  for (size_t i = 0; i < quantiles.size(); i++) {
+    summary.push_back(
+        fmt::format("P{:g}({:g},{:g})", 100 * quantiles[i], interval[i], cumulative[i]));
+  }
+  return StringUtil::join(summary, " ");
 }
 
 std::string AdminImpl::sanitizePrometheusName(const std::string& name) {
@@ -340,43 +783,62 @@ std::string AdminImpl::prometheusMetricName(const std::string& extractedName) {
 
 void AdminImpl::statsAsPrometheus(const std::list<Stats::CounterSharedPtr>& counters,
                                   const std::list<Stats::GaugeSharedPtr>& gauges,
-                                  Buffer::Instance& response) {
-  for (const auto& counter : counters) {
-    const std::string tags = formatTagsForPrometheus(counter->tags());
-    const std::string metric_name = prometheusMetricName(counter->tagExtractedName());
-    response.add(fmt::format("# TYPE {0} counter\n", metric_name));
-    response.add(fmt::format("{0}{{{1}}} {2}\n", metric_name, tags, counter->value()));
+                                  const std::string& name_prefix, Buffer::Instance& response) {
+  std::string chunk;
+  chunk.reserve(PROMETHEUS_CHUNK_SIZE);
+
+  std::vector<PrometheusSample> samples;
+  for (const Stats::CounterSharedPtr& counter : counters) {
+    if (counter->name().compare(0, name_prefix.size(), name_prefix) == 0) {
+      samples.push_back({counter.get(), counter->value()});
+    }
+  }
+  appendPrometheusSamples(samples, "counter", chunk, response);
+
+  samples.clear();
+  for (const Stats::GaugeSharedPtr& gauge : gauges) {
+    if (gauge->name().compare(0, name_prefix.size(), name_prefix) == 0) {
+      samples.push_back({gauge.get(), gauge->value()});
+    }
   }
+  appendPrometheusSamples(samples, "gauge", chunk, response);
 
-  for (const auto& gauge : gauges) {
-    const std::string tags = formatTagsForPrometheus(gauge->tags());
-    const std::string metric_name = prometheusMetricName(gauge->tagExtractedName());
-    response.add(fmt::format("# TYPE {0} gauge\n", metric_name));
-    response.add(fmt::format("{0}{{{1}}} {2}\n", metric_name, tags, gauge->value()));
+  if (!chunk.empty()) {
+    response.add(chunk);
   }
 }
 
-std::string AdminImpl::statsAsJson(const std::map<std::string, uint64_t>& all_stats) {
-  rapidjson::Document document;
-  document.SetObject();
-  rapidjson::Value stats_array(rapidjson::kArrayType);
-  rapidjson::Document::AllocatorType& allocator = document.GetAllocator();
-  for (auto stat : all_stats) {
-    Value stat_obj;
-    stat_obj.SetObject();
-    Value stat_name;
-    stat_name.SetString(stat.first.c_str(), allocator);
-    stat_obj.AddMember("name", stat_name, allocator);
-    Value stat_value;
-    stat_value.SetInt(stat.second);
-    stat_obj.AddMember("value", stat_value, allocator);
-    stats_array.PushBack(stat_obj, allocator);
-  }
-  document.AddMember("stats", stats_array, allocator);
-  rapidjson::StringBuffer strbuf;
-  rapidjson::PrettyWriter<StringBuffer> writer(strbuf);
-  document.Accept(writer);
-  return strbuf.GetString();
+void AdminImpl::appendPrometheusSamples(std::vector<PrometheusSample>& samples,
+                                        const std::string& type, std::string& chunk,
+                                        Buffer::Instance& response) {
+  // A metric family's samples must be written together.
+  std::sort(samples.begin(), samples.end(),
+            [](const PrometheusSample& lhs, const PrometheusSample& rhs) -> bool {
+              const int compare = lhs.metric_->tagExtractedName().compare(
+                  rhs.metric_->tagExtractedName());
+              return compare < 0 || (compare == 0 && lhs.metric_->name() < rhs.metric_->name());
+            });
+
+  const std::string* family = nullptr;
+  std::string metric_name;
+  for (const PrometheusSample& sample : samples) {
+    if (family == nullptr || *family != sample.metric_->tagExtractedName()) {
+      family = &sample.metric_->tagExtractedName();
+      metric_name = prometheusMetricName(*family);
+      chunk.append("# TYPE ").append(metric_name).append(" ").append(type).append("\n");
+    }
+
+    chunk.append(metric_name)
+        .append("{")
+        .append(formatTagsForPrometheus(sample.metric_->tags()))
+        .append("} ")
+        .append(std::to_string(sample.value_))
+        .append("\n");
+    if (chunk.size() >= PROMETHEUS_CHUNK_SIZE) {
+      response.add(chunk);
+      chunk.clear();
+    }
+  }
 }
 
 Http::Code AdminImpl::handlerQuitQuitQuit(const std::string&, Buffer::Instance& response) {
@@ -417,17 +879,46 @@ void AdminFilter::onComplete() {
   ENVOY_STREAM_LOG(debug, "request complete: path: {}", *callbacks_, path);
 
   Buffer::OwnedImpl response;
-  Http::Code code = parent_.runCallback(path, response);
+  Http::Code code = parent_.runCallback(path, response, chunked_response_);
 
   Http::HeaderMapPtr headers{
       new Http::HeaderMapImpl{{Http::Headers::get().Status, std::to_string(enumToInt(code))}}};
-  callbacks_->encodeHeaders(std::move(headers), response.length() == 0);
+  callbacks_->encodeHeaders(std::move(headers), response.length() == 0 && !chunked_response_);
 
-  if (response.length() > 0) {
+  if (chunked_response_) {
+    if (response.length() > 0) {
+      callbacks_->encodeData(response, false);
+    }
+    chunk_timer_ = callbacks_->dispatcher().createTimer([this]() -> void { sendNextChunk(); });
+    callbacks_->addDownstreamWatermarkCallbacks(*this);
+    sendNextChunk();
+  } else if (response.length() > 0) {
     callbacks_->encodeData(response, true);
   }
 }
 
+void AdminFilter::sendNextChunk() {
+  Buffer::OwnedImpl chunk;
+  if (!chunked_response_->nextChunk(chunk)) {
+    // The stream can be destroyed as the last chunk is sent.
+    chunked_response_.reset();
+    callbacks_->removeDownstreamWatermarkCallbacks(*this);
+    callbacks_->encodeData(chunk, true);
+    return;
+  }
+
+  if (chunk.length() > 0) {
+    callbacks_->encodeData(chunk, false);
+  }
+
+  // Go back to the dispatcher before the next chunk, or wait for the downstream to drain.
+  if (high_watermark_count_ > 0) {
+    chunk_pending_ = true;
+  } else {
+    chunk_timer_->enableTimer(std::chrono::milliseconds(0));
+  }
+}
+
 AdminImpl::NullRouteConfigProvider::NullRouteConfigProvider()
     : config_(new Router::NullConfigImpl()) {}
 
@@ -441,25 +932,37 @@ AdminImpl::AdminImpl(const std::string& access_log_path, const std::string& prof
       tracing_stats_(Http::ConnectionManagerImpl::generateTracingStats("http.admin.tracing.",
                                                                        server_.stats())),
       handlers_{
-          {"/certs", "print certs on machine", MAKE_ADMIN_HANDLER(handlerCerts), false},
-          {"/clusters", "upstream cluster status", MAKE_ADMIN_HANDLER(handlerClusters), false},
+          {"/certs", "print certs on machine", MAKE_ADMIN_HANDLER(handlerCerts), false, nullptr},
+          {"/clusters", "upstream cluster status", nullptr, false,
+           MAKE_CHUNKED_ADMIN_HANDLER(handlerClusters)},
           {"/cpuprofiler", "enable/disable the CPU profiler",
-           MAKE_ADMIN_HANDLER(handlerCpuProfiler), false},
+           MAKE_ADMIN_HANDLER(handlerCpuProfiler), false, nullptr},
+          {"/heapprofiler", "enable/disable the heap profiler, or dump a heap profile",
+           MAKE_ADMIN_HANDLER(handlerHeapProfiler), false, nullptr},
+          {"/heap_sample", "print a sample of the live heap allocations in the pprof format",
+           MAKE_ADMIN_HANDLER(handlerHeapSample), false, nullptr},
           {"/healthcheck/fail", "cause the server to fail health checks",
-           MAKE_ADMIN_HANDLER(handlerHealthcheckFail), false},
+           MAKE_ADMIN_HANDLER(handlerHealthcheckFail), false, nullptr},
           {"/healthcheck/ok", "cause the server to pass health checks",
-           MAKE_ADMIN_HANDLER(handlerHealthcheckOk), false},
+           MAKE_ADMIN_HANDLER(handlerHealthcheckOk), false, nullptr},
           {"/hot_restart_version", "print the hot restart compatability version",
-           MAKE_ADMIN_HANDLER(handlerHotRestartVersion), false},
-          {"/logging", "query/change logging levels", MAKE_ADMIN_HANDLER(handlerLogging), false},
-          {"/quitquitquit", "exit the server", MAKE_ADMIN_HANDLER(handlerQuitQuitQuit), false},
+           MAKE_ADMIN_HANDLER(handlerHotRestartVersion), false, nullptr},
+          {"/logging", "query/change logging levels", MAKE_ADMIN_HANDLER(handlerLogging), false,
+           nullptr},
+          {"/memory", "print memory allocation statistics", MAKE_ADMIN_HANDLER(handlerMemory),
+           false, nullptr},
+          {"/quitquitquit", "exit the server", MAKE_ADMIN_HANDLER(handlerQuitQuitQuit), false,
+           nullptr},
           {"/reset_counters", "reset all counters to zero",
-           MAKE_ADMIN_HANDLER(handlerResetCounters), false},
+           MAKE_ADMIN_HANDLER(handlerResetCounters), false, nullptr},
           {"/server_info", "print server version/status information",
-           MAKE_ADMIN_HANDLER(handlerServerInfo), false},
-          {"/stats", "print server stats", MAKE_ADMIN_HANDLER(handlerStats), false},
+           MAKE_ADMIN_HANDLER(handlerServerInfo), false, nullptr},
+          {"/stats/prometheus", "print server stats in the Prometheus text format",
+           MAKE_ADMIN_HANDLER(handlerPrometheusStats), false, nullptr},
+          {"/stats", "print server stats", nullptr, false,
+           MAKE_CHUNKED_ADMIN_HANDLER(handlerStats)},
           {"/listeners", "print listener addresses", MAKE_ADMIN_HANDLER(handlerListenerInfo),
-           false}},
+           false, nullptr}},
       listener_stats_(
           Http::ConnectionManagerImpl::generateListenerStats("http.admin.", listener_scope)) {
 
@@ -488,7 +991,7 @@ Http::ServerConnectionPtr AdminImpl::createCodec(Network::Connection& connection
 bool AdminImpl::createFilterChain(Network::Connection& connection) {
   connection.addReadFilter(Network::ReadFilterSharedPtr{new Http::ConnectionManagerImpl(
       *this, server_.drainManager(), server_.random(), server_.httpTracer(), server_.runtime(),
-      server_.localInfo(), server_.clusterManager())});
+      server_.localInfo(), server_.clusterManager(), overload_manager_)});
   return true;
 }
 
@@ -497,11 +1000,27 @@ void AdminImpl::createFilterChain(Http::FilterChainFactoryCallbacks& callbacks)
 }
 
 Http::Code AdminImpl::runCallback(const std::string& path, Buffer::Instance& response) {
+  ChunkedAdminResponsePtr chunked_response;
+  const Http::Code code = runCallback(path, response, chunked_response);
+  if (chunked_response) {
+    while (chunked_response->nextChunk(response)) {
+    }
+  }
+
+  return code;
+}
+
+Http::Code AdminImpl::runCallback(const std::string& path, Buffer::Instance& response,
+                                  ChunkedAdminResponsePtr& chunked_response) {
   Http::Code code = Http::Code::OK;
   bool found_handler = false;
   for (const UrlHandler& handler : handlers_) {
     if (path.find(handler.prefix_) == 0) {
-      code = handler.handler_(path, response);
+      if (handler.chunked_handler_) {
+        code = handler.chunked_handler_(path, response, chunked_response);
+      } else {
+        code = handler.handler_(path, response);
+      }
       found_handler = true;
       break;
     }
@@ -534,7 +1053,7 @@ bool AdminImpl::addHandler(const std::string& prefix, const std::string& help_te
   auto it = std::find_if(handlers_.cbegin(), handlers_.cend(),
                          [&prefix](const UrlHandler& entry) { return prefix == entry.prefix_; });
   if (it == handlers_.end()) {
-    handlers_.push_back({prefix, help_text, callback, removable});
+    handlers_.push_back({prefix, help_text, callback, removable, nullptr});
     return true;
   }
   return false;
@@ -1,15 +1,23 @@
 #pragma once
 
 #include <chrono>
+#include <functional>
+#include <limits>
 #include <list>
+#include <memory>
+#include <regex>
 #include <string>
+#include <vector>
 
+#include "envoy/event/timer.h"
 #include "envoy/http/filter.h"
 #include "envoy/network/listen_socket.h"
 #include "envoy/server/admin.h"
 #include "envoy/server/instance.h"
+#include "envoy/server/overload_manager.h"
 #include "envoy/upstream/outlier_detection.h"
 #include "envoy/upstream/resource_manager.h"
+#include "envoy/upstream/upstream.h"
 
 #include "common/common/logger.h"
 #include "common/common/macros.h"
@@ -22,6 +30,25 @@
 namespace Envoy {
 namespace Server {
 
+/**
+ * An admin response which is generated a chunk at a time, so that a large response does not stall
+ * the main thread. The admin filter sends each chunk as soon as it is generated, and goes back to
+ * the dispatcher before generating the next one.
+ */
+class ChunkedAdminResponse {
+public:
+  virtual ~ChunkedAdminResponse() {}
+
+  /**
+   * Generate the next chunk of the response.
+   * @param response supplies the buffer to add the chunk to.
+   * @return bool whether there are more chunks to generate.
+   */
+  virtual bool nextChunk(Buffer::Instance& response) PURE;
+};
+
+typedef std::unique_ptr<ChunkedAdminResponse> ChunkedAdminResponsePtr;
+
 /**
  * Implementation of Server::admin.
  */
@@ -36,6 +63,18 @@ public:
             Server::Instance& server, Stats::Scope& listener_scope);
 
   Http::Code runCallback(const std::string& path, Buffer::Instance& response);
+
+  /**
+   * Run the handler of a path, leaving the rest of the response to be generated a chunk at a time
+   * if the handler supports it.
+   * @param path supplies the path of the request.
+   * @param response supplies the buffer to add the start of the response to.
+   * @param chunked_response supplies where to put the generator of the rest of the response. It is
+   *        left empty if the whole response is in the buffer.
+   * @return Http::Code the response code.
+   */
+  Http::Code runCallback(const std::string& path, Buffer::Instance& response,
+                         ChunkedAdminResponsePtr& chunked_response);
   const Network::ListenSocket& socket() override { return *socket_; }
   Network::ListenSocket& mutable_socket() { return *socket_; }
 
@@ -80,15 +119,44 @@ public:
 
 private:
   /**
-   * Individual admin handler including prefix, help text, and callback.
+   * Callback for a handler which generates its response a chunk at a time.
+   */
+  typedef std::function<Http::Code(const std::string& url, Buffer::Instance& response,
+                                   ChunkedAdminResponsePtr& chunked_response)>
+      ChunkedHandlerCb;
+
+  /**
+   * Individual admin handler including prefix, help text, and callback. A handler has either a
+   * callback or a chunked callback.
    */
   struct UrlHandler {
     const std::string prefix_;
     const std::string help_text_;
     const HandlerCb handler_;
     const bool removable_;
+    const ChunkedHandlerCb chunked_handler_;
+  };
+
+  /**
+   * The query params which select the entries of a listing, such as the stats or the clusters, and
+   * its format.
+   */
+  struct ListingParams {
+    /**
+     * @return bool whether an entry is selected by the prefix and the filter.
+     */
+    bool matches(const std::string& name) const;
+
+    std::string prefix_;
+    std::unique_ptr<std::regex> filter_;
+    uint64_t offset_{};
+    uint64_t limit_{std::numeric_limits<uint64_t>::max()};
+    std::string format_;
   };
 
+  class ClustersResponse;
+  class StatsResponse;
+
   /**
    * Implementation of RouteConfigProvider that returns a static null route config.
    */
@@ -102,6 +170,16 @@ private:
     Router::ConfigConstSharedPtr config_;
   };
 
+  /**
+   * Implementation of OverloadManager that never sheds load, so that the admin endpoint stays
+   * usable while the server is overloaded.
+   */
+  struct NullOverloadManager : public OverloadManager {
+    // Server::OverloadManager
+    void start() override {}
+    bool isActive(OverloadActionType) override { return false; }
+  };
+
   /**
    * Attempt to change the log level of a logger or all loggers
    * @param params supplies the incoming endpoint query params.
@@ -113,10 +191,45 @@ private:
   void addOutlierInfo(const std::string& cluster_name,
                       const Upstream::Outlier::Detector* outlier_detector,
                       Buffer::Instance& response);
-  static std::string statsAsJson(const std::map<std::string, uint64_t>& all_stats);
+  void addHostInfo(const std::string& cluster_name, const Upstream::Host& host,
+                   Buffer::Instance& response);
+  static void addClusterJson(const Upstream::Cluster& cluster, Buffer::Instance& response);
+  static void addHostJson(const Upstream::Host& host, Buffer::Instance& response);
+  /**
+   * @return std::string a string as a quoted and escaped JSON string.
+   */
+  static std::string jsonString(const std::string& value);
+  /**
+   * Parse the params of a listing, which are prefix, filter, offset, limit and format, the latter
+   * being one of the supplied formats.
+   * @return bool whether the params are valid.
+   */
+  static bool parseListingParams(const Http::Utility::QueryParams& params,
+                                 const std::vector<std::string>& formats, ListingParams& listing);
+  /**
+   * @return std::string the quantiles of a histogram, as P<quantile>(<interval>,<cumulative>).
+   */
+  static std::string histogramSummary(const Stats::ParentHistogram& histogram);
+  /**
+   * A metric and its value, as written in the Prometheus exposition format.
+   */
+  struct PrometheusSample {
+    const Stats::Metric* metric_;
+    uint64_t value_;
+  };
+
+  /**
+   * Write counters and gauges in the Prometheus text exposition format. The samples of each metric
+   * family, which is the metrics with the same tag extracted name, follow a single TYPE line. The
+   * output is added to the response in chunks as it is written.
+   * @param name_prefix supplies the prefix of the names of the metrics to write.
+   */
   static void statsAsPrometheus(const std::list<Stats::CounterSharedPtr>& counters,
                                 const std::list<Stats::GaugeSharedPtr>& gauges,
-                                Buffer::Instance& response);
+                                const std::string& name_prefix, Buffer::Instance& response);
+  static void appendPrometheusSamples(std::vector<PrometheusSample>& samples,
+                                      const std::string& type, std::string& chunk,
+                                      Buffer::Instance& response);
   static std::string sanitizePrometheusName(const std::string& name);
   static std::string formatTagsForPrometheus(const std::vector<Stats::Tag>& tags);
   static std::string prometheusMetricName(const std::string& extractedName);
@@ -125,15 +238,21 @@ private:
    * URL handlers.
    */
   Http::Code handlerCerts(const std::string& url, Buffer::Instance& response);
-  Http::Code handlerClusters(const std::string& url, Buffer::Instance& response);
+  Http::Code handlerClusters(const std::string& url, Buffer::Instance& response,
+                             ChunkedAdminResponsePtr& chunked_response);
   Http::Code handlerCpuProfiler(const std::string& url, Buffer::Instance& response);
+  Http::Code handlerHeapProfiler(const std::string& url, Buffer::Instance& response);
+  Http::Code handlerHeapSample(const std::string& url, Buffer::Instance& response);
   Http::Code handlerHealthcheckFail(const std::string& url, Buffer::Instance& response);
   Http::Code handlerHealthcheckOk(const std::string& url, Buffer::Instance& response);
   Http::Code handlerHotRestartVersion(const std::string& url, Buffer::Instance& response);
   Http::Code handlerLogging(const std::string& url, Buffer::Instance& response);
+  Http::Code handlerMemory(const std::string& url, Buffer::Instance& response);
   Http::Code handlerResetCounters(const std::string& url, Buffer::Instance& response);
   Http::Code handlerServerInfo(const std::string& url, Buffer::Instance& response);
-  Http::Code handlerStats(const std::string& url, Buffer::Instance& response);
+  Http::Code handlerStats(const std::string& url, Buffer::Instance& response,
+                          ChunkedAdminResponsePtr& chunked_response);
+  Http::Code handlerPrometheusStats(const std::string& url, Buffer::Instance& response);
   Http::Code handlerQuitQuitQuit(const std::string& url, Buffer::Instance& response);
   Http::Code handlerListenerInfo(const std::string& url, Buffer::Instance& response);
 
@@ -144,6 +263,7 @@ private:
   Http::ConnectionManagerStats stats_;
   Http::ConnectionManagerTracingStats tracing_stats_;
   NullRouteConfigProvider route_config_provider_;
+  NullOverloadManager overload_manager_;
   std::list<UrlHandler> handlers_;
   Optional<std::chrono::milliseconds> idle_timeout_;
   Optional<std::string> user_agent_;
@@ -155,12 +275,14 @@ private:
 /**
  * A terminal HTTP filter that implements server admin functionality.
  */
-class AdminFilter : public Http::StreamDecoderFilter, Logger::Loggable<Logger::Id::admin> {
+class AdminFilter : public Http::StreamDecoderFilter,
+                    public Http::DownstreamWatermarkCallbacks,
+                    Logger::Loggable<Logger::Id::admin> {
 public:
   AdminFilter(AdminImpl& parent);
 
   // Http::StreamFilterBase
-  void onDestroy() override {}
+  void onDestroy() override;
 
   // Http::StreamDecoderFilter
   Http::FilterHeadersStatus decodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
@@ -170,15 +292,29 @@ public:
     callbacks_ = &callbacks;
   }
 
+  // Http::DownstreamWatermarkCallbacks
+  void onAboveWriteBufferHighWatermark() override;
+  void onBelowWriteBufferLowWatermark() override;
+
 private:
   /**
    * Called when an admin request has been completely received.
    */
   void onComplete();
 
+  /**
+   * Send the next chunk of a chunked response. The chunk after it is scheduled on the dispatcher,
+   * unless the downstream is backed up, in which case it waits for the downstream to drain.
+   */
+  void sendNextChunk();
+
   AdminImpl& parent_;
   Http::StreamDecoderFilterCallbacks* callbacks_{};
   Http::HeaderMap* request_headers_{};
+  ChunkedAdminResponsePtr chunked_response_;
+  Event::TimerPtr chunk_timer_;
+  uint32_t high_watermark_count_{};
+  bool chunk_pending_{};
 };
 
 } // namespace Server
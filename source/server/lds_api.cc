@@ -1,6 +1,7 @@
 #include "server/lds_api.h"
 
 #include "common/common/cleanup.h"
+#include "common/config/cached_subscription_impl.h"
 #include "common/config/resources.h"
 #include "common/config/subscription_factory.h"
 #include "common/config/utility.h"
@@ -16,7 +17,7 @@ namespace Server {
 LdsApi::LdsApi(const envoy::api::v2::ConfigSource& lds_config, Upstream::ClusterManager& cm,
                Event::Dispatcher& dispatcher, Runtime::RandomGenerator& random,
                Init::Manager& init_manager, const LocalInfo::LocalInfo& local_info,
-               Stats::Scope& scope, ListenerManager& lm)
+               Stats::Scope& scope, ListenerManager& lm, const std::string& cache_path)
     : listener_manager_(lm), scope_(scope.createScope("listener_manager.lds.")), cm_(cm) {
   subscription_ =
       Envoy::Config::SubscriptionFactory::subscriptionFromConfigSource<envoy::api::v2::Listener>(
@@ -28,6 +29,10 @@ LdsApi::LdsApi(const envoy::api::v2::ConfigSource& lds_config, Upstream::Cluster
           },
           "envoy.api.v2.ListenerDiscoveryService.FetchListeners",
           "envoy.api.v2.ListenerDiscoveryService.StreamListeners");
+  if (!cache_path.empty()) {
+    subscription_.reset(new Config::CachedSubscriptionImpl<envoy::api::v2::Listener>(
+        std::move(subscription_), cache_path + "/lds.pb"));
+  }
   Config::Utility::checkLocalInfo("lds", local_info);
   init_manager.registerTarget(*this);
 }
@@ -23,7 +23,7 @@ public:
   LdsApi(const envoy::api::v2::ConfigSource& lds_config, Upstream::ClusterManager& cm,
          Event::Dispatcher& dispatcher, Runtime::RandomGenerator& random,
          Init::Manager& init_manager, const LocalInfo::LocalInfo& local_info, Stats::Scope& scope,
-         ListenerManager& lm);
+         ListenerManager& lm, const std::string& cache_path);
 
   const std::string versionInfo() const { return subscription_->versionInfo(); }
 
@@ -39,10 +39,10 @@ void LdsSubscription::createRequest(Http::Message& request) {
       fmt::format("/v1/listeners/{}/{}", local_info_.clusterName(), local_info_.nodeName()));
 }
 
-void LdsSubscription::parseResponse(const Http::Message& response) {
+void LdsSubscription::parseResponse(Http::Message& response) {
   ENVOY_LOG(debug, "lds: parsing response");
-  const std::string response_body = response.bodyAsString();
-  Json::ObjectSharedPtr response_json = Json::Factory::loadFromString(response_body);
+  const Buffer::Instance& response_body = *response.body();
+  Json::ObjectSharedPtr response_json = Json::Factory::loadFromBuffer(response_body);
   response_json->validateSchema(Json::Schema::LDS_SCHEMA);
   std::vector<Json::ObjectSharedPtr> json_listeners = response_json->getObjectArray("listeners");
 
@@ -46,7 +46,7 @@ private:
 
   // Http::RestApiFetcher
   void createRequest(Http::Message& request) override;
-  void parseResponse(const Http::Message& response) override;
+  void parseResponse(Http::Message& response) override;
   void onFetchComplete() override;
   void onFetchFailure(const EnvoyException* e) override;
 
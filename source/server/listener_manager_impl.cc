@@ -3,6 +3,7 @@
 #include "envoy/registry/registry.h"
 
 #include "common/common/assert.h"
+#include "common/common/utility.h"
 #include "common/config/utility.h"
 #include "common/network/listen_socket_impl.h"
 #include "common/network/utility.h"
@@ -10,6 +11,7 @@
 #include "common/ssl/context_config_impl.h"
 
 #include "server/configuration_impl.h"
+#include "server/connection_balancer_impl.h"
 #include "server/drain_manager_impl.h"
 
 #include "fmt/format.h"
@@ -49,25 +51,29 @@ ProdListenerComponentFactory::createFilterFactoryList_(
 
 Network::ListenSocketSharedPtr
 ProdListenerComponentFactory::createListenSocket(Network::Address::InstanceConstSharedPtr address,
-                                                 bool bind_to_port) {
-  // For each listener config we share a single TcpListenSocket among all threaded listeners.
+                                                 bool bind_to_port, bool reuse_port,
+                                                 uint32_t worker_index) {
+  // For each listener config we share a single TcpListenSocket among all threaded listeners, or
+  // with reuse_port, create one for each worker.
   // UdsListenerSockets are not managed and do not participate in hot restart as they are only
-  // used for testing. First we try to get the socket from our parent if applicable.
+  // used for testing. First we try to get the socket from our parent if applicable. A parent
+  // which shares a single socket between its workers returns that socket for every worker.
   // TODO(mattklein123): UDS support.
   ASSERT(address->type() == Network::Address::Type::Ip);
   const std::string addr = fmt::format("tcp://{}", address->asString());
-  const int fd = server_.hotRestart().duplicateParentListenSocket(addr);
+  const int fd = server_.hotRestart().duplicateParentListenSocket(addr, worker_index);
   if (fd != -1) {
-    ENVOY_LOG(debug, "obtained socket for address {} from parent", addr);
+    ENVOY_LOG(debug, "obtained socket for address {} worker {} from parent", addr, worker_index);
     return std::make_shared<Network::TcpListenSocket>(fd, address);
   } else {
-    return std::make_shared<Network::TcpListenSocket>(address, bind_to_port);
+    return std::make_shared<Network::TcpListenSocket>(address, bind_to_port, reuse_port);
   }
 }
 
 DrainManagerPtr
 ProdListenerComponentFactory::createDrainManager(envoy::api::v2::Listener::DrainType drain_type) {
-  return DrainManagerPtr{new DrainManagerImpl(server_, drain_type)};
+  return DrainManagerPtr{
+      new DrainManagerImpl(server_, drain_type, ProdMonotonicTimeSource::instance_)};
 }
 
 ListenerImpl::ListenerImpl(const envoy::api::v2::Listener& config, ListenerManagerImpl& parent,
@@ -81,13 +87,22 @@ ListenerImpl::ListenerImpl(const envoy::api::v2::Listener& config, ListenerManag
       listener_scope_(
           parent_.server_.stats().createScope(fmt::format("listener.{}.", address_->asString()))),
       bind_to_port_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.deprecated_v1(), bind_to_port, true)),
+      // Listeners which don't bind never accept connections, so they don't need a socket for each
+      // worker.
+      reuse_port_(bind_to_port_ && parent_.server_.options().reusePort()),
       use_proxy_proto_(
           PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.filter_chains()[0], use_proxy_proto, false)),
       use_original_dst_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, use_original_dst, false)),
       per_connection_buffer_limit_bytes_(
           PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, per_connection_buffer_limit_bytes, 1024 * 1024)),
+      connection_balancer_(bind_to_port_ && parent_.server_.options().balanceConnections()
+                               ? std::make_shared<ConnectionBalancerImpl>()
+                               : nullptr),
+      max_accepts_per_wakeup_(parent_.server_.options().maxAcceptsPerWakeup()),
+      max_accepts_per_second_(parent_.server_.options().maxAcceptsPerSecond()),
       listener_tag_(parent_.factory_.nextListenerTag()), name_(name),
       workers_started_(workers_started), hash_(hash),
+      non_filter_chains_hash_(hashWithoutFilterChains(config)),
       local_drain_manager_(parent.factory_.createDrainManager(config.drain_type())) {
   // TODO(htuch): Support multiple filter chains #1280, add constraint to ensure we have at least on
   // filter chain #1308.
@@ -147,6 +162,21 @@ ListenerImpl::~ListenerImpl() {
 }
 
 bool ListenerImpl::createFilterChain(Network::Connection& connection) {
+  // Without filters the connection handler closes the connection right away.
+  if (parent_.server_.overloadManager().isActive(OverloadActionType::StopAcceptingConnections)) {
+    listener_scope_->counter("downstream_cx_overload_reject").inc();
+    return false;
+  }
+
+  // Unlike the overload actions, the limit on buffered bytes only applies to the listener which
+  // holds them, so that one listener cannot take the memory of the others.
+  const uint64_t max_buffered_bytes =
+      parent_.server_.runtime().snapshot().getInteger("overload.max_listener_buffered_bytes", 0);
+  if (max_buffered_bytes > 0 && buffer_account_->balance() >= max_buffered_bytes) {
+    listener_scope_->counter("downstream_cx_buffer_overload_reject").inc();
+    return false;
+  }
+
   return Configuration::FilterChainUtility::buildFilterChain(connection, filter_factories_);
 }
 
@@ -184,9 +214,23 @@ Init::Manager& ListenerImpl::initManager() {
   }
 }
 
-void ListenerImpl::setSocket(const Network::ListenSocketSharedPtr& socket) {
-  ASSERT(!socket_);
-  socket_ = socket;
+uint64_t ListenerImpl::hashWithoutFilterChains(const envoy::api::v2::Listener& config) {
+  envoy::api::v2::Listener listener_config(config);
+  listener_config.clear_filter_chains();
+  return MessageUtil::hash(listener_config);
+}
+
+void ListenerImpl::setSockets(const std::vector<Network::ListenSocketSharedPtr>& sockets) {
+  ASSERT(sockets_.empty());
+  ASSERT(!sockets.empty());
+  sockets_ = sockets;
+}
+
+Network::ListenSocket* ListenerImpl::workerSocket(uint32_t worker_index) {
+  if (!reuse_port_) {
+    return sockets_[0].get();
+  }
+  return worker_index < sockets_.size() ? sockets_[worker_index].get() : nullptr;
 }
 
 ListenerManagerImpl::ListenerManagerImpl(Instance& server,
@@ -194,7 +238,7 @@ ListenerManagerImpl::ListenerManagerImpl(Instance& server,
                                          WorkerFactory& worker_factory)
     : server_(server), factory_(listener_factory), stats_(generateStats(server.stats())) {
   for (uint32_t i = 0; i < std::max(1U, server.options().concurrency()); i++) {
-    workers_.emplace_back(worker_factory.createWorker());
+    workers_.emplace_back(worker_factory.createWorker(i));
   }
 }
 
@@ -246,17 +290,30 @@ bool ListenerManagerImpl::addOrUpdateListener(const envoy::api::v2::Listener& co
     throw EnvoyException(message);
   }
 
+  // The sockets of the existing listener are used as is, so the new listener must also share a
+  // single socket between workers, or use a socket per worker, like the existing one.
+  if ((existing_warming_listener != warming_listeners_.end() &&
+       (*existing_warming_listener)->reusePort() != new_listener->reusePort()) ||
+      (existing_active_listener != active_listeners_.end() &&
+       (*existing_active_listener)->reusePort() != new_listener->reusePort())) {
+    const std::string message =
+        fmt::format("error updating listener: '{}' can't change bind_to_port with --reuse-port",
+                    name);
+    ENVOY_LOG(warn, "{}", message);
+    throw EnvoyException(message);
+  }
+
   bool added = false;
   if (existing_warming_listener != warming_listeners_.end()) {
     // In this case we can just replace inline.
     ASSERT(workers_started_);
     new_listener->debugLog("update warming listener");
-    new_listener->setSocket((*existing_warming_listener)->getSocket());
+    new_listener->setSockets((*existing_warming_listener)->getSockets());
     *existing_warming_listener = std::move(new_listener);
   } else if (existing_active_listener != active_listeners_.end()) {
     // In this case we have no warming listener, so what we do depends on whether workers
     // have been started or not. Either way we get the socket from the existing listener.
-    new_listener->setSocket((*existing_active_listener)->getSocket());
+    new_listener->setSockets((*existing_active_listener)->getSockets());
     if (workers_started_) {
       new_listener->debugLog("add warming listener");
       warming_listeners_.emplace_back(std::move(new_listener));
@@ -285,20 +342,17 @@ bool ListenerManagerImpl::addOrUpdateListener(const envoy::api::v2::Listener& co
     // to see if there is a listener that has a socket bound to the address we are configured for.
     // This is an edge case, but may happen if a listener is removed and then added back with a same
     // or different name and intended to listen on the same address. This should work and not fail.
-    Network::ListenSocketSharedPtr draining_listener_socket;
     auto existing_draining_listener = std::find_if(
         draining_listeners_.cbegin(), draining_listeners_.cend(),
         [&new_listener](const DrainingListener& listener) {
           return *new_listener->address() == *listener.listener_->socket().localAddress();
         });
-    if (existing_draining_listener != draining_listeners_.cend()) {
-      draining_listener_socket = existing_draining_listener->listener_->getSocket();
+    if (existing_draining_listener != draining_listeners_.cend() &&
+        existing_draining_listener->listener_->reusePort() == new_listener->reusePort()) {
+      new_listener->setSockets(existing_draining_listener->listener_->getSockets());
+    } else {
+      new_listener->setSockets(createListenSockets(*new_listener));
     }
-
-    new_listener->setSocket(
-        draining_listener_socket
-            ? draining_listener_socket
-            : factory_.createListenSocket(new_listener->address(), new_listener->bindToPort()));
     if (workers_started_) {
       new_listener->debugLog("add warming listener");
       warming_listeners_.emplace_back(std::move(new_listener));
@@ -354,16 +408,7 @@ void ListenerManagerImpl::drainListener(ListenerImplPtr&& listener) {
       // Once the drain time has completed via the drain manager's timer, we tell the workers to
       // remove the listener.
       worker->removeListener(*draining_it->listener_, [this, draining_it]() -> void {
-        // The remove listener completion is called on the worker thread. We post back to the main
-        // thread to avoid locking. This makes sure that we don't destroy the listener while filters
-        // might still be using its context (stats, etc.).
-        server_.dispatcher().post([this, draining_it]() -> void {
-          if (--draining_it->workers_pending_removal_ == 0) {
-            draining_it->listener_->debugLog("listener removal complete");
-            draining_listeners_.erase(draining_it);
-            stats_.total_listeners_draining_.set(draining_listeners_.size());
-          }
-        });
+        onWorkerListenerRemoved(draining_it);
       });
     }
   });
@@ -371,6 +416,37 @@ void ListenerManagerImpl::drainListener(ListenerImplPtr&& listener) {
   updateWarmingActiveGauges();
 }
 
+void ListenerManagerImpl::removeListenerWhenIdle(ListenerImplPtr&& listener) {
+  // The listener is kept in the draining list, without starting its drain sequence, until all
+  // workers have removed it.
+  std::list<DrainingListener>::iterator draining_it = draining_listeners_.emplace(
+      draining_listeners_.begin(), std::move(listener), workers_.size());
+  stats_.total_listeners_draining_.set(draining_listeners_.size());
+
+  draining_it->listener_->debugLog("removing listener once its connections have closed");
+  for (const auto& worker : workers_) {
+    worker->removeListenerWhenIdle(
+        *draining_it->listener_,
+        [this, draining_it]() -> void { onWorkerListenerRemoved(draining_it); });
+  }
+
+  updateWarmingActiveGauges();
+}
+
+void ListenerManagerImpl::onWorkerListenerRemoved(
+    std::list<DrainingListener>::iterator draining_it) {
+  // The remove listener completion is called on the worker thread. We post back to the main
+  // thread to avoid locking. This makes sure that we don't destroy the listener while filters
+  // might still be using its context (stats, etc.).
+  server_.dispatcher().post([this, draining_it]() -> void {
+    if (--draining_it->workers_pending_removal_ == 0) {
+      draining_it->listener_->debugLog("listener removal complete");
+      draining_listeners_.erase(draining_it);
+      stats_.total_listeners_draining_.set(draining_listeners_.size());
+    }
+  });
+}
+
 ListenerManagerImpl::ListenerList::iterator
 ListenerManagerImpl::getListenerByName(ListenerList& listeners, const std::string& name) {
   auto ret = listeners.end();
@@ -420,6 +496,25 @@ void ListenerManagerImpl::addListenerToWorker(Worker& worker, ListenerImpl& list
   });
 }
 
+std::vector<Network::ListenSocketSharedPtr>
+ListenerManagerImpl::createListenSockets(const ListenerImpl& listener) {
+  if (!listener.reusePort()) {
+    return {factory_.createListenSocket(listener.address(), listener.bindToPort(), false, 0)};
+  }
+
+  std::vector<Network::ListenSocketSharedPtr> sockets;
+  Network::Address::InstanceConstSharedPtr address = listener.address();
+  for (uint32_t i = 0; i < workers_.size(); i++) {
+    sockets.push_back(factory_.createListenSocket(address, true, true, i));
+    // When binding to port zero, the other workers bind to the port picked for the first one. The
+    // validation server doesn't create sockets.
+    if (i == 0 && sockets[0] != nullptr) {
+      address = sockets[0]->localAddress();
+    }
+  }
+  return sockets;
+}
+
 void ListenerManagerImpl::onListenerWarmed(ListenerImpl& listener) {
   // The warmed listener should be added first so that the worker will accept new connections
   // when it stops listening on the old listener.
@@ -431,7 +526,18 @@ void ListenerManagerImpl::onListenerWarmed(ListenerImpl& listener) {
   auto existing_warming_listener = getListenerByName(warming_listeners_, listener.name());
   (*existing_warming_listener)->debugLog("warm complete. updating active listener");
   if (existing_active_listener != active_listeners_.end()) {
-    drainListener(std::move(*existing_active_listener));
+    // When only the filter chains changed, the connections of the existing listener keep their
+    // filter chains until they close on their own, rather than being drained, and only new
+    // connections get the new filter chains.
+    if ((*existing_active_listener)->nonFilterChainsHash() ==
+            (*existing_warming_listener)->nonFilterChainsHash() &&
+        server_.runtime().snapshot().featureEnabled(
+            "listener_manager.in_place_filter_chain_update", 0)) {
+      stats_.listener_modified_in_place_.inc();
+      removeListenerWhenIdle(std::move(*existing_active_listener));
+    } else {
+      drainListener(std::move(*existing_active_listener));
+    }
     *existing_active_listener = std::move(*existing_warming_listener);
   } else {
     active_listeners_.emplace_back(std::move(*existing_warming_listener));
@@ -5,6 +5,7 @@
 #include "envoy/server/listener_manager.h"
 #include "envoy/server/worker.h"
 
+#include "common/buffer/buffer_impl.h"
 #include "common/common/logger.h"
 
 #include "server/init_manager_impl.h"
@@ -38,7 +39,8 @@ public:
     return createFilterFactoryList_(filters, context);
   }
   Network::ListenSocketSharedPtr
-  createListenSocket(Network::Address::InstanceConstSharedPtr address, bool bind_to_port) override;
+  createListenSocket(Network::Address::InstanceConstSharedPtr address, bool bind_to_port,
+                     bool reuse_port, uint32_t worker_index) override;
   DrainManagerPtr createDrainManager(envoy::api::v2::Listener::DrainType drain_type) override;
   uint64_t nextListenerTag() override { return next_listener_tag_++; }
 
@@ -57,6 +59,7 @@ typedef std::unique_ptr<ListenerImpl> ListenerImplPtr;
 #define ALL_LISTENER_MANAGER_STATS(COUNTER, GAUGE)                                                 \
   COUNTER(listener_added)                                                                          \
   COUNTER(listener_modified)                                                                       \
+  COUNTER(listener_modified_in_place)                                                              \
   COUNTER(listener_removed)                                                                        \
   COUNTER(listener_create_success)                                                                 \
   COUNTER(listener_create_failure)                                                                 \
@@ -106,6 +109,13 @@ private:
   };
 
   void addListenerToWorker(Worker& worker, ListenerImpl& listener);
+
+  /**
+   * Create the listen sockets for a new listener. This is a single socket shared by all workers,
+   * or with the reuse port option, one SO_REUSEPORT socket for each worker.
+   * @param listener supplies the listener to create sockets for.
+   */
+  std::vector<Network::ListenSocketSharedPtr> createListenSockets(const ListenerImpl& listener);
   static ListenerManagerStats generateStats(Stats::Scope& scope);
   static bool hasListenerWithAddress(const ListenerList& list,
                                      const Network::Address::Instance& address);
@@ -123,6 +133,21 @@ private:
    */
   void drainListener(ListenerImplPtr&& listener);
 
+  /**
+   * Mark a listener for removal once its connections have closed on their own. The listener will
+   * no longer be considered active and stops accepting connections, but its connections are not
+   * drained.
+   * @param listener supplies the listener to remove.
+   */
+  void removeListenerWhenIdle(ListenerImplPtr&& listener);
+
+  /**
+   * Called on a worker thread when a worker has removed a draining listener. The listener is
+   * destroyed once all workers have removed it.
+   * @param draining_it supplies the draining listener.
+   */
+  void onWorkerListenerRemoved(std::list<DrainingListener>::iterator draining_it);
+
   /**
    * Get a listener by name. This routine is used because listeners have inherent order in static
    * configuration and especially for tests. Thus, we can't use a map.
@@ -183,16 +208,23 @@ public:
   }
 
   Network::Address::InstanceConstSharedPtr address() const { return address_; }
-  const Network::ListenSocketSharedPtr& getSocket() const { return socket_; }
+  const std::vector<Network::ListenSocketSharedPtr>& getSockets() const { return sockets_; }
   uint64_t hash() const { return hash_; }
+  /**
+   * @return uint64_t the hash of the configuration without its filter chains. Listeners with the
+   *         same name and hash only differ in the filter chains given to new connections.
+   */
+  uint64_t nonFilterChainsHash() const { return non_filter_chains_hash_; }
   void debugLog(const std::string& message);
   void initialize();
   DrainManager& localDrainManager() const { return *local_drain_manager_; }
-  void setSocket(const Network::ListenSocketSharedPtr& socket);
+  bool reusePort() const { return reuse_port_; }
+  void setSockets(const std::vector<Network::ListenSocketSharedPtr>& sockets);
 
   // Server::Listener
   Network::FilterChainFactory& filterChainFactory() override { return *this; }
-  Network::ListenSocket& socket() override { return *socket_; }
+  Network::ListenSocket& socket() override { return *sockets_[0]; }
+  Network::ListenSocket* workerSocket(uint32_t worker_index) override;
   bool bindToPort() override { return bind_to_port_; }
   Ssl::ServerContext* defaultSslContext() override {
     return tls_contexts_.empty() ? nullptr : tls_contexts_[0].get();
@@ -200,6 +232,12 @@ public:
   bool useProxyProto() override { return use_proxy_proto_; }
   bool useOriginalDst() override { return use_original_dst_; }
   uint32_t perConnectionBufferLimitBytes() override { return per_connection_buffer_limit_bytes_; }
+  Network::ConnectionBalancerSharedPtr connectionBalancer() override {
+    return connection_balancer_;
+  }
+  const Buffer::AccountSharedPtr& bufferAccount() override { return buffer_account_; }
+  uint32_t maxAcceptsPerWakeup() override { return max_accepts_per_wakeup_; }
+  uint32_t maxAcceptsPerSecond() override { return max_accepts_per_second_; }
   Stats::Scope& listenerScope() override { return *listener_scope_; }
   uint64_t listenerTag() override { return listener_tag_; }
   const std::string& name() const override { return name_; }
@@ -216,6 +254,7 @@ public:
   Init::Manager& initManager() override;
   const LocalInfo::LocalInfo& localInfo() override { return parent_.server_.localInfo(); }
   Envoy::Runtime::RandomGenerator& random() override { return parent_.server_.random(); }
+  OverloadManager& overloadManager() override { return parent_.server_.overloadManager(); }
   RateLimit::ClientPtr
   rateLimitClient(const Optional<std::chrono::milliseconds>& timeout) override {
     return parent_.server_.rateLimitClient(timeout);
@@ -233,20 +272,31 @@ public:
   bool createFilterChain(Network::Connection& connection) override;
 
 private:
+  static uint64_t hashWithoutFilterChains(const envoy::api::v2::Listener& config);
+
   ListenerManagerImpl& parent_;
   Network::Address::InstanceConstSharedPtr address_;
-  Network::ListenSocketSharedPtr socket_;
+  // Either a single socket shared by all workers, or one socket for each worker when reuse_port_
+  // is set.
+  std::vector<Network::ListenSocketSharedPtr> sockets_;
   Stats::ScopePtr global_scope_;   // Stats with global named scope, but needed for LDS cleanup.
   Stats::ScopePtr listener_scope_; // Stats with listener named scope.
   std::vector<Ssl::ServerContextPtr> tls_contexts_;
   const bool bind_to_port_;
+  const bool reuse_port_;
   const bool use_proxy_proto_;
   const bool use_original_dst_;
   const uint32_t per_connection_buffer_limit_bytes_;
+  // Shared by the workers' copies of the listener when --balance-connections is set.
+  const Network::ConnectionBalancerSharedPtr connection_balancer_;
+  const Buffer::AccountSharedPtr buffer_account_{std::make_shared<Buffer::AccountImpl>()};
+  const uint32_t max_accepts_per_wakeup_;
+  const uint32_t max_accepts_per_second_;
   const uint64_t listener_tag_;
   const std::string name_;
   const bool workers_started_;
   const uint64_t hash_;
+  const uint64_t non_filter_chains_hash_;
   InitManagerImpl dynamic_init_manager_;
   bool initialize_canceled_{};
   std::vector<Configuration::NetworkFilterFactoryCb> filter_factories_;
@@ -1,11 +1,14 @@
 #include "server/options_impl.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <iostream>
+#include <limits>
 #include <string>
 
 #include "common/common/macros.h"
+#include "common/common/utility.h"
 #include "common/common/version.h"
 #include "common/stats/stats_impl.h"
 
@@ -25,6 +28,11 @@
 #define ENVOY_DEFAULT_MAX_OBJ_NAME_LENGTH 60
 #endif
 
+// Can be overridden at compile time
+#ifndef ENVOY_DEFAULT_USE_LIBEVENT_BUFFERS
+#define ENVOY_DEFAULT_USE_LIBEVENT_BUFFERS true
+#endif
+
 #if ENVOY_DEFAULT_MAX_OBJ_NAME_LENGTH < 60
 #error "ENVOY_DEFAULT_MAX_OBJ_NAME_LENGTH must be >= 60"
 #endif
@@ -60,6 +68,9 @@ OptionsImpl::OptionsImpl(int argc, char** argv, const HotRestartVersionCb& hot_r
                                          cmd);
   TCLAP::ValueArg<std::string> log_path("", "log-path", "Path to logfile", false, "", "string",
                                         cmd);
+  TCLAP::SwitchArg async_log("", "async-log",
+                             "Queue log lines in per thread buffers written by a background thread",
+                             cmd, false);
   TCLAP::ValueArg<uint32_t> restart_epoch("", "restart-epoch", "hot restart epoch #", false, 0,
                                           "uint32_t", cmd);
   TCLAP::SwitchArg hot_restart_version_option("", "hot-restart-version",
@@ -83,8 +94,9 @@ OptionsImpl::OptionsImpl(int argc, char** argv, const HotRestartVersionCb& hot_r
                                     "traffic normally) or 'validate' (validate configs and exit).",
                                     false, "serve", "string", cmd);
   TCLAP::ValueArg<uint64_t> max_stats("", "max-stats",
-                                      "Maximum number of stats guages and counters "
-                                      "that can be allocated in shared memory.",
+                                      "Number of stats guages and counters in each "
+                                      "segment of shared memory, segments being "
+                                      "added as stats run out.",
                                       false, ENVOY_DEFAULT_MAX_STATS, "uint64_t", cmd);
   TCLAP::ValueArg<uint64_t> max_obj_name_len("", "max-obj-name-len",
                                              "Maximum name length for a field in the config "
@@ -92,6 +104,118 @@ OptionsImpl::OptionsImpl(int argc, char** argv, const HotRestartVersionCb& hot_r
                                              " the cluster name)",
                                              false, ENVOY_DEFAULT_MAX_OBJ_NAME_LENGTH, "uint64_t",
                                              cmd);
+  TCLAP::ValueArg<bool> use_libevent_buffers("", "use-libevent-buffers",
+                                             "Use the original libevent buffer implementation "
+                                             "(1) or the native slice based implementation (0)",
+                                             false, ENVOY_DEFAULT_USE_LIBEVENT_BUFFERS, "bool",
+                                             cmd);
+  TCLAP::SwitchArg reuse_port("", "reuse-port",
+                              "Give each worker its own SO_REUSEPORT listen socket per listener",
+                              cmd, false);
+  TCLAP::SwitchArg balance_connections(
+      "", "balance-connections",
+      "Hand new connections to the worker with the fewest connections of the listener", cmd, false);
+  TCLAP::ValueArg<uint32_t> max_accepts_per_wakeup(
+      "", "max-accepts-per-wakeup",
+      "Maximum number of connections a listener accepts on a worker each time its socket is ready "
+      "(0 for no limit)",
+      false, 0, "uint32_t", cmd);
+  TCLAP::ValueArg<uint32_t> max_accepts_per_second(
+      "", "max-accepts-per-second",
+      "Maximum number of connections a listener accepts per second on a worker (0 for no limit)",
+      false, 0, "uint32_t", cmd);
+  TCLAP::SwitchArg use_epoll_changelist(
+      "", "use-epoll-changelist",
+      "Batch event registration changes into epoll_wait() with libevent's epoll changelist", cmd,
+      false);
+  TCLAP::ValueArg<uint32_t> max_deferred_deletes_per_iteration(
+      "", "max-deferred-deletes-per-iteration",
+      "Maximum number of deferred deletions run per event loop iteration (0 for no limit)", false,
+      0, "uint32_t", cmd);
+  TCLAP::SwitchArg coalesce_writes(
+      "", "coalesce-writes",
+      "Flush connection writes at the end of the event loop iteration to coalesce small writes",
+      cmd, false);
+  TCLAP::ValueArg<uint32_t> tcp_notsent_lowat("", "tcp-notsent-lowat",
+                                              "TCP_NOTSENT_LOWAT for TCP connections in bytes "
+                                              "(0 leaves the system default)",
+                                              false, 0, "uint32_t", cmd);
+  TCLAP::ValueArg<uint32_t> private_key_threads("", "private-key-threads",
+                                                "Number of threads for the private key operations "
+                                                "of TLS handshakes (0 runs them on the workers)",
+                                                false, 0, "uint32_t", cmd);
+  TCLAP::ValueArg<uint64_t> ssl_session_cache_size(
+      "", "ssl-session-cache-size",
+      "Maximum number of TLS sessions in a session cache shared by all listeners "
+      "(0 gives each TLS context its own cache)",
+      false, 0, "uint64_t", cmd);
+  TCLAP::ValueArg<uint32_t> tls_initial_record_size(
+      "", "tls-initial-record-size",
+      "Maximum size of the TLS records written at the start of a connection and after it has "
+      "been idle (0 always writes full records)",
+      false, 0, "uint32_t", cmd);
+  TCLAP::SwitchArg kernel_tls_enabled("", "kernel-tls",
+                                      "Encrypt the TLS records written to connections in "
+                                      "the kernel where supported",
+                                      cmd, false);
+  TCLAP::SwitchArg lazy_tls_certificates(
+      "", "lazy-tls-certificates",
+      "Load the certificates and keys of TLS contexts selected by SNI on first use", cmd, false);
+  TCLAP::SwitchArg tls_early_data(
+      "", "tls-early-data",
+      "Accept TLS 1.3 early data on resumed connections, for idempotent requests only", cmd, false);
+  TCLAP::SwitchArg thread_local_counters(
+      "", "thread-local-counters",
+      "Increment counters in per worker slots which are added to the shared values at stats flush",
+      cmd, false);
+  TCLAP::ValueArg<uint32_t> statsd_udp_max_datagram_size(
+      "", "statsd-udp-max-datagram-size",
+      "Maximum size of the datagrams which UDP statsd sinks batch counters and gauges into "
+      "(0 sends each of them in its own datagram)",
+      false, 0, "uint32_t", cmd);
+  TCLAP::ValueArg<uint32_t> stats_full_flush_every(
+      "", "stats-full-flush-every",
+      "Flush the unchanged counters and gauges to the sinks which only need changed stats, such as "
+      "statsd, on one stats flush in this many (0 flushes them every time)",
+      false, 0, "uint32_t", cmd);
+  TCLAP::ValueArg<uint32_t> dns_cache_duration_ms(
+      "", "dns-cache-duration-ms",
+      "Milliseconds for which resolved DNS cluster addresses are reused by other resolutions of "
+      "the same name (0 resolves each time)",
+      false, 0, "uint32_t", cmd);
+  TCLAP::ValueArg<uint32_t> ratelimit_lease_size(
+      "", "ratelimit-lease-size",
+      "Number of hits each worker leases from the rate limit service for the descriptors of a "
+      "request, to spend on later requests with the same descriptors (0 disables leases)",
+      false, 0, "uint32_t", cmd);
+  TCLAP::ValueArg<uint32_t> ratelimit_lease_duration_ms(
+      "", "ratelimit-lease-duration-ms",
+      "Milliseconds for which the hits leased from the rate limit service may be spent", false,
+      1000, "uint32_t", cmd);
+  TCLAP::SwitchArg dedicated_health_check_thread(
+      "", "dedicated-health-check-thread",
+      "Run cluster health checks on a thread of their own rather than on the main thread", cmd,
+      false);
+  TCLAP::SwitchArg dedicated_xds_thread(
+      "", "dedicated-xds-thread",
+      "Run the ADS stream and the decoding of its responses on a thread of their own, the main "
+      "thread only applying the updates",
+      cmd, false);
+  TCLAP::ValueArg<std::string> worker_cpus(
+      "", "worker-cpus",
+      "Comma separated CPUs and CPU ranges to pin the workers to, e.g. 0-3,8-11, worker i being "
+      "pinned to the i-th CPU modulo their number (Linux only)",
+      false, "", "string", cmd);
+  TCLAP::ValueArg<std::string> xds_cache_path(
+      "", "xds-cache-path",
+      "Directory in which to keep the last accepted LDS and CDS updates, which are applied on the "
+      "next start before the management server responds",
+      false, "", "string", cmd);
+  TCLAP::ValueArg<uint32_t> validation_threads(
+      "", "validation-threads",
+      "Number of threads validating the listeners of the config concurrently in validate mode, "
+      "each loading all the clusters",
+      false, 1, "uint32_t", cmd);
 
   cmd.setExceptionHandling(false);
   try {
@@ -153,6 +277,22 @@ OptionsImpl::OptionsImpl(int argc, char** argv, const HotRestartVersionCb& hot_r
     throw MalformedArgvException(message);
   }
 
+  for (const std::string& cpu_range : StringUtil::split(worker_cpus.getValue(), ',')) {
+    const std::vector<std::string> bounds = StringUtil::split(cpu_range, '-');
+    uint64_t first = 0;
+    uint64_t last = 0;
+    if (bounds.empty() || bounds.size() > 2 || !StringUtil::atoul(bounds[0].c_str(), first) ||
+        !StringUtil::atoul(bounds.back().c_str(), last) || first > last ||
+        last >= std::numeric_limits<uint32_t>::max()) {
+      const std::string message = fmt::format("error: invalid worker CPUs '{}'", cpu_range);
+      std::cerr << message << std::endl;
+      throw MalformedArgvException(message);
+    }
+    for (uint64_t cpu = first; cpu <= last; cpu++) {
+      worker_cpus_.push_back(cpu);
+    }
+  }
+
   // For base ID, scale what the user inputs by 10 so that we have spread for domain sockets.
   base_id_ = base_id.getValue() * 10;
   concurrency_ = concurrency.getValue();
@@ -160,6 +300,7 @@ OptionsImpl::OptionsImpl(int argc, char** argv, const HotRestartVersionCb& hot_r
   v2_config_only_ = v2_config_only.getValue();
   admin_address_path_ = admin_address_path.getValue();
   log_path_ = log_path.getValue();
+  async_log_ = async_log.getValue();
   restart_epoch_ = restart_epoch.getValue();
   service_cluster_ = service_cluster.getValue();
   service_node_ = service_node.getValue();
@@ -169,5 +310,30 @@ OptionsImpl::OptionsImpl(int argc, char** argv, const HotRestartVersionCb& hot_r
   parent_shutdown_time_ = std::chrono::seconds(parent_shutdown_time_s.getValue());
   max_stats_ = max_stats.getValue();
   max_obj_name_length_ = max_obj_name_len.getValue();
+  libevent_buffers_enabled_ = use_libevent_buffers.getValue();
+  reuse_port_ = reuse_port.getValue();
+  balance_connections_ = balance_connections.getValue();
+  max_accepts_per_wakeup_ = max_accepts_per_wakeup.getValue();
+  max_accepts_per_second_ = max_accepts_per_second.getValue();
+  epoll_changelist_enabled_ = use_epoll_changelist.getValue();
+  max_deferred_deletes_per_iteration_ = max_deferred_deletes_per_iteration.getValue();
+  coalesce_writes_ = coalesce_writes.getValue();
+  tcp_notsent_lowat_ = tcp_notsent_lowat.getValue();
+  private_key_threads_ = private_key_threads.getValue();
+  ssl_session_cache_size_ = ssl_session_cache_size.getValue();
+  tls_initial_record_size_ = tls_initial_record_size.getValue();
+  kernel_tls_enabled_ = kernel_tls_enabled.getValue();
+  lazy_tls_certificates_ = lazy_tls_certificates.getValue();
+  tls_early_data_ = tls_early_data.getValue();
+  thread_local_counters_ = thread_local_counters.getValue();
+  statsd_udp_max_datagram_size_ = statsd_udp_max_datagram_size.getValue();
+  stats_full_flush_every_ = stats_full_flush_every.getValue();
+  dns_cache_duration_ = std::chrono::milliseconds(dns_cache_duration_ms.getValue());
+  ratelimit_lease_size_ = ratelimit_lease_size.getValue();
+  ratelimit_lease_duration_ = std::chrono::milliseconds(ratelimit_lease_duration_ms.getValue());
+  dedicated_health_check_thread_ = dedicated_health_check_thread.getValue();
+  dedicated_xds_thread_ = dedicated_xds_thread.getValue();
+  xds_cache_path_ = xds_cache_path.getValue();
+  validation_threads_ = std::max(1U, validation_threads.getValue());
 }
 } // namespace Envoy
@@ -3,6 +3,7 @@
 #include <chrono>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "envoy/common/exception.h"
 #include "envoy/server/options.h"
@@ -37,6 +38,7 @@ public:
   std::chrono::seconds drainTime() override { return drain_time_; }
   spdlog::level::level_enum logLevel() override { return log_level_; }
   const std::string& logPath() override { return log_path_; }
+  bool asyncLog() override { return async_log_; }
   std::chrono::seconds parentShutdownTime() override { return parent_shutdown_time_; }
   uint64_t restartEpoch() override { return restart_epoch_; }
   Server::Mode mode() const override { return mode_; }
@@ -46,6 +48,34 @@ public:
   const std::string& serviceZone() override { return service_zone_; }
   uint64_t maxStats() override { return max_stats_; }
   uint64_t maxObjNameLength() override { return max_obj_name_length_; }
+  bool libeventBuffersEnabled() override { return libevent_buffers_enabled_; }
+  bool reusePort() override { return reuse_port_; }
+  bool balanceConnections() override { return balance_connections_; }
+  uint32_t maxAcceptsPerWakeup() override { return max_accepts_per_wakeup_; }
+  uint32_t maxAcceptsPerSecond() override { return max_accepts_per_second_; }
+  bool epollChangelistEnabled() override { return epoll_changelist_enabled_; }
+  uint32_t maxDeferredDeletesPerIteration() override {
+    return max_deferred_deletes_per_iteration_;
+  }
+  bool coalesceWrites() override { return coalesce_writes_; }
+  uint32_t tcpNotSentLowat() override { return tcp_notsent_lowat_; }
+  uint32_t privateKeyThreads() override { return private_key_threads_; }
+  uint64_t sslSessionCacheSize() override { return ssl_session_cache_size_; }
+  uint32_t tlsInitialRecordSize() override { return tls_initial_record_size_; }
+  bool kernelTlsEnabled() override { return kernel_tls_enabled_; }
+  bool lazyTlsCertificates() override { return lazy_tls_certificates_; }
+  bool tlsEarlyData() override { return tls_early_data_; }
+  bool threadLocalCounters() override { return thread_local_counters_; }
+  uint32_t statsdUdpMaxDatagramSize() override { return statsd_udp_max_datagram_size_; }
+  uint32_t statsFullFlushEvery() override { return stats_full_flush_every_; }
+  std::chrono::milliseconds dnsCacheDuration() override { return dns_cache_duration_; }
+  uint32_t ratelimitLeaseSize() override { return ratelimit_lease_size_; }
+  std::chrono::milliseconds ratelimitLeaseDuration() override { return ratelimit_lease_duration_; }
+  bool dedicatedHealthCheckThread() override { return dedicated_health_check_thread_; }
+  bool dedicatedXdsThread() override { return dedicated_xds_thread_; }
+  const std::vector<uint32_t>& workerCpus() override { return worker_cpus_; }
+  const std::string& xdsCachePath() override { return xds_cache_path_; }
+  uint32_t validationThreads() override { return validation_threads_; }
 
 private:
   uint64_t base_id_;
@@ -56,6 +86,7 @@ private:
   Network::Address::IpVersion local_address_ip_version_;
   spdlog::level::level_enum log_level_;
   std::string log_path_;
+  bool async_log_;
   uint64_t restart_epoch_;
   std::string service_cluster_;
   std::string service_node_;
@@ -66,6 +97,32 @@ private:
   Server::Mode mode_;
   uint64_t max_stats_;
   uint64_t max_obj_name_length_;
+  bool libevent_buffers_enabled_;
+  bool reuse_port_;
+  bool balance_connections_;
+  uint32_t max_accepts_per_wakeup_;
+  uint32_t max_accepts_per_second_;
+  bool epoll_changelist_enabled_;
+  uint32_t max_deferred_deletes_per_iteration_;
+  bool coalesce_writes_;
+  uint32_t tcp_notsent_lowat_;
+  uint32_t private_key_threads_;
+  uint64_t ssl_session_cache_size_;
+  uint32_t tls_initial_record_size_;
+  bool kernel_tls_enabled_;
+  bool lazy_tls_certificates_;
+  bool tls_early_data_;
+  bool thread_local_counters_;
+  uint32_t statsd_udp_max_datagram_size_;
+  uint32_t stats_full_flush_every_;
+  std::chrono::milliseconds dns_cache_duration_;
+  uint32_t ratelimit_lease_size_;
+  std::chrono::milliseconds ratelimit_lease_duration_;
+  bool dedicated_health_check_thread_;
+  bool dedicated_xds_thread_;
+  std::vector<uint32_t> worker_cpus_;
+  std::string xds_cache_path_;
+  uint32_t validation_threads_;
 };
 
 /**
@@ -0,0 +1,109 @@
+#include "server/overload_manager_impl.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+#include "envoy/event/dispatcher.h"
+#include "envoy/runtime/runtime.h"
+
+#include "common/common/assert.h"
+#include "common/memory/stats.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Server {
+
+namespace {
+
+struct ActionConfig {
+  OverloadActionType type_;
+  const char* name_;
+  uint64_t default_threshold_percent_;
+};
+
+// Indexed by OverloadActionType. Each threshold can be overridden with the
+// "overload.<name>_percent" runtime key, and a threshold of 0 disables the action.
+const ActionConfig ACTIONS[] = {
+    {OverloadActionType::DisableHttpKeepAlive, "disable_http_keepalive", 90},
+    {OverloadActionType::StopAcceptingConnections, "stop_accepting_connections", 95},
+    {OverloadActionType::StopAcceptingRequests, "stop_accepting_requests", 98},
+};
+
+} // namespace
+
+OverloadManagerImpl::OverloadManagerImpl(Instance& server)
+    : server_(server), stats_{ALL_OVERLOAD_STATS(POOL_GAUGE_PREFIX(server.stats(), "overload."))} {
+  static_assert(sizeof(ACTIONS) / sizeof(ACTIONS[0]) == NUM_ACTIONS, "missing overload action");
+}
+
+void OverloadManagerImpl::start() {
+  ASSERT(!tls_);
+  tls_.reset(new ThreadLocal::RcuSlot<ActionStates>(server_.threadLocal()));
+  tls_->publish(std::make_shared<const ActionStates>(active_));
+  refresh_timer_ = server_.dispatcher().createTimer([this]() -> void { refresh(); });
+  refresh();
+}
+
+bool OverloadManagerImpl::isActive(OverloadActionType action) {
+  return tls_ && (*tls_->get())[static_cast<size_t>(action)];
+}
+
+uint64_t OverloadManagerImpl::pressurePercent() {
+  Runtime::Snapshot& snapshot = server_.runtime().snapshot();
+  uint64_t pressure = 0;
+
+  // A limit of 0 means that the resource is not monitored.
+  const uint64_t max_heap_bytes = snapshot.getInteger("overload.max_heap_bytes", 0);
+  if (max_heap_bytes > 0) {
+    pressure =
+        std::max(pressure, Memory::Stats::totalCurrentlyAllocated() * 100 / max_heap_bytes);
+  }
+
+  const uint64_t max_active_connections =
+      snapshot.getInteger("overload.max_active_connections", 0);
+  if (max_active_connections > 0) {
+    pressure = std::max(pressure,
+                        server_.listenerManager().numConnections() * 100 / max_active_connections);
+  }
+
+  return pressure;
+}
+
+void OverloadManagerImpl::refresh() {
+  const uint64_t pressure = pressurePercent();
+  stats_.pressure_percent_.set(pressure);
+
+  Runtime::Snapshot& snapshot = server_.runtime().snapshot();
+  ActionStates active;
+  for (const ActionConfig& action : ACTIONS) {
+    const uint64_t threshold = snapshot.getInteger(
+        fmt::format("overload.{}_percent", action.name_), action.default_threshold_percent_);
+    const size_t index = static_cast<size_t>(action.type_);
+    active[index] = threshold > 0 && pressure >= threshold;
+    if (active[index] != active_[index]) {
+      ENVOY_LOG(warn, "overload action {} {} at {}% pressure", action.name_,
+                active[index] ? "activated" : "deactivated", pressure);
+    }
+  }
+
+  stats_.disable_http_keepalive_active_.set(
+      active[static_cast<size_t>(OverloadActionType::DisableHttpKeepAlive)]);
+  stats_.stop_accepting_connections_active_.set(
+      active[static_cast<size_t>(OverloadActionType::StopAcceptingConnections)]);
+  stats_.stop_accepting_requests_active_.set(
+      active[static_cast<size_t>(OverloadActionType::StopAcceptingRequests)]);
+
+  // Only publish when something changed, so that the workers keep reading their cached states.
+  if (active != active_) {
+    active_ = active;
+    tls_->publish(std::make_shared<const ActionStates>(active));
+  }
+
+  refresh_timer_->enableTimer(
+      std::chrono::milliseconds(snapshot.getInteger("overload.refresh_interval_ms", 1000)));
+}
+
+} // namespace Server
+} // namespace Envoy
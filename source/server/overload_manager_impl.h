@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+#include "envoy/event/timer.h"
+#include "envoy/server/instance.h"
+#include "envoy/server/overload_manager.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/common/logger.h"
+#include "common/thread_local/rcu_slot.h"
+
+namespace Envoy {
+namespace Server {
+
+/**
+ * All overload manager stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_OVERLOAD_STATS(GAUGE)                                                                  \
+  GAUGE(pressure_percent)                                                                          \
+  GAUGE(disable_http_keepalive_active)                                                             \
+  GAUGE(stop_accepting_connections_active)                                                         \
+  GAUGE(stop_accepting_requests_active)
+// clang-format on
+
+/**
+ * Struct definition for all overload manager stats. @see stats_macros.h
+ */
+struct OverloadStats {
+  ALL_OVERLOAD_STATS(GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * Overload manager which periodically samples the heap size and the number of active downstream
+ * connections against their runtime limits. The pressure is the highest of the usage percentages,
+ * and an action is active while the pressure is at or above the action's runtime threshold. Action
+ * changes are published through a RCU slot, so that checking an action is cheap on the workers and
+ * nothing is posted to them.
+ */
+class OverloadManagerImpl : Logger::Loggable<Logger::Id::main>, public OverloadManager {
+public:
+  OverloadManagerImpl(Instance& server);
+
+  // Server::OverloadManager
+  void start() override;
+  bool isActive(OverloadActionType action) override;
+
+private:
+  static const size_t NUM_ACTIONS = 3;
+  typedef std::array<bool, NUM_ACTIONS> ActionStates;
+
+  uint64_t pressurePercent();
+  void refresh();
+
+  Instance& server_;
+  OverloadStats stats_;
+  std::unique_ptr<ThreadLocal::RcuSlot<ActionStates>> tls_;
+  Event::TimerPtr refresh_timer_;
+  ActionStates active_{};
+};
+
+} // namespace Server
+} // namespace Envoy
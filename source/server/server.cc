@@ -6,6 +6,7 @@
 #include <functional>
 #include <string>
 #include <unordered_set>
+#include <vector>
 
 #include "envoy/event/dispatcher.h"
 #include "envoy/event/signal.h"
@@ -23,6 +24,7 @@
 #include "common/local_info/local_info_impl.h"
 #include "common/memory/stats.h"
 #include "common/network/address_impl.h"
+#include "common/network/caching_dns_resolver_impl.h"
 #include "common/protobuf/utility.h"
 #include "common/router/rds_impl.h"
 #include "common/runtime/runtime_impl.h"
@@ -50,8 +52,11 @@ InstanceImpl::InstanceImpl(Options& options, Network::Address::InstanceConstShar
       api_(new Api::Impl(options.fileFlushIntervalMsec())), dispatcher_(api_->allocateDispatcher()),
       singleton_manager_(new Singleton::ManagerImpl()),
       handler_(new ConnectionHandlerImpl(ENVOY_LOGGER(), *dispatcher_)),
-      listener_component_factory_(*this), worker_factory_(thread_local_, *api_, hooks),
-      dns_resolver_(dispatcher_->createDnsResolver({})),
+      listener_component_factory_(*this),
+      worker_factory_(thread_local_, *api_, hooks, store, options.workerCpus()),
+      dns_resolver_(new Network::CachingDnsResolverImpl(dispatcher_->createDnsResolver({}),
+                                                        options.dnsCacheDuration(),
+                                                        ProdMonotonicTimeSource::instance_)),
       access_log_manager_(*api_, *dispatcher_, access_log_lock, store) {
 
   try {
@@ -70,7 +75,10 @@ InstanceImpl::InstanceImpl(Options& options, Network::Address::InstanceConstShar
   } catch (const EnvoyException& e) {
     ENVOY_LOG(critical, "error initializing configuration '{}': {}", options.configPath(),
               e.what());
+    api_->shutdownThreadPool();
     thread_local_.shutdownGlobalThreading();
+    stopHealthCheckThread();
+    stopXdsThread();
     thread_local_.shutdownThread();
     throw;
   }
@@ -99,25 +107,55 @@ void InstanceImpl::failHealthcheck(bool fail) {
   server_stats_->live_.set(!fail);
 }
 
-void InstanceUtil::flushCountersAndGaugesToSinks(const std::list<Stats::SinkPtr>& sinks,
-                                                 Stats::Store& store) {
+void InstanceUtil::flushMetricsToSinks(const std::list<Stats::SinkPtr>& sinks,
+                                                 Stats::Store& store, bool full_flush) {
+  // The sinks which get every used counter and gauge, and those which only get the changed ones.
+  std::vector<Stats::Sink*> all_stats_sinks;
+  std::vector<Stats::Sink*> changed_stats_sinks;
   for (const auto& sink : sinks) {
     sink->beginFlush();
+    if (!full_flush && sink->changedStatsOnly()) {
+      changed_stats_sinks.push_back(sink.get());
+    } else {
+      all_stats_sinks.push_back(sink.get());
+    }
   }
 
   for (const Stats::CounterSharedPtr& counter : store.counters()) {
     uint64_t delta = counter->latch();
     if (counter->used()) {
-      for (const auto& sink : sinks) {
+      for (Stats::Sink* sink : all_stats_sinks) {
         sink->flushCounter(*counter, delta);
       }
+      if (delta > 0) {
+        for (Stats::Sink* sink : changed_stats_sinks) {
+          sink->flushCounter(*counter, delta);
+        }
+      }
     }
   }
 
   for (const Stats::GaugeSharedPtr& gauge : store.gauges()) {
+    // Latched on every flush, so that it tells whether the gauge changed since the previous one.
+    const bool changed = gauge->latchChanged();
     if (gauge->used()) {
+      const uint64_t value = gauge->value();
+      for (Stats::Sink* sink : all_stats_sinks) {
+        sink->flushGauge(*gauge, value);
+      }
+      if (changed) {
+        for (Stats::Sink* sink : changed_stats_sinks) {
+          sink->flushGauge(*gauge, value);
+        }
+      }
+    }
+  }
+
+  for (const Stats::ParentHistogramSharedPtr& histogram : store.histograms()) {
+    histogram->merge();
+    if (histogram->cumulativeStatistics().sampleCount() > 0) {
       for (const auto& sink : sinks) {
-        sink->flushGauge(*gauge, gauge->value());
+        sink->flushHistogram(*histogram);
       }
     }
   }
@@ -135,12 +173,23 @@ void InstanceImpl::flushStats() {
   server_stats_->memory_allocated_.set(Memory::Stats::totalCurrentlyAllocated() +
                                        info.memory_allocated_);
   server_stats_->memory_heap_size_.set(Memory::Stats::totalCurrentlyReserved());
+  server_stats_->memory_thread_cache_.set(Memory::Stats::totalThreadCacheBytes());
+  server_stats_->memory_pageheap_free_.set(Memory::Stats::totalPageHeapFree());
+  server_stats_->memory_pageheap_unmapped_.set(Memory::Stats::totalPageHeapUnmapped());
   server_stats_->parent_connections_.set(info.num_connections_);
   server_stats_->total_connections_.set(numConnections() + info.num_connections_);
   server_stats_->days_until_first_cert_expiring_.set(
       sslContextManager().daysUntilFirstCertExpires());
+  for (Listener& listener : listener_manager_->listeners()) {
+    listener.listenerScope()
+        .gauge("downstream_buffered_bytes")
+        .set(listener.bufferAccount()->balance());
+  }
 
-  InstanceUtil::flushCountersAndGaugesToSinks(config_->statsSinks(), stats_store_);
+  const uint32_t full_flush_every = options_.statsFullFlushEvery();
+  InstanceUtil::flushMetricsToSinks(config_->statsSinks(), stats_store_,
+                                    full_flush_every == 0 ||
+                                        stat_flushes_++ % full_flush_every == 0);
   stat_flush_timer_->enableTimer(config_->statsFlushInterval());
 }
 
@@ -219,6 +268,30 @@ void InstanceImpl::initialize(Options& options,
   listener_manager_.reset(
       new ListenerManagerImpl(*this, listener_component_factory_, worker_factory_));
 
+  // The health checking thread also registers for thread local updates, as health checks read
+  // runtime.
+  if (options.dedicatedHealthCheckThread()) {
+    health_check_dispatcher_ = api_->allocateDispatcher();
+    thread_local_.registerThread(*health_check_dispatcher_, false);
+    health_check_thread_.reset(new Thread::Thread([this]() -> void {
+      health_check_dispatcher_->run(Event::Dispatcher::RunType::RunUntilExit);
+      // Close the connections of the deleted health checkers while their thread is still alive.
+      health_check_dispatcher_->clearDeferredDeleteList();
+      thread_local_.shutdownThread();
+    }));
+  }
+
+  // So does the xDS thread, as the ADS stream is opened through the thread local cluster manager.
+  if (options.dedicatedXdsThread()) {
+    xds_dispatcher_ = api_->allocateDispatcher();
+    thread_local_.registerThread(*xds_dispatcher_, false);
+    xds_thread_.reset(new Thread::Thread([this]() -> void {
+      xds_dispatcher_->run(Event::Dispatcher::RunType::RunUntilExit);
+      xds_dispatcher_->clearDeferredDeleteList();
+      thread_local_.shutdownThread();
+    }));
+  }
+
   // The main thread is also registered for thread local updates so that code that does not care
   // whether it runs on the main thread or on workers can still use TLS.
   thread_local_.registerThread(*dispatcher_, true);
@@ -230,12 +303,36 @@ void InstanceImpl::initialize(Options& options,
   // load things may grab a reference to the loader for later use.
   runtime_loader_ = component_factory.createRuntime(*this, initial_config);
 
+  // The overload manager samples resources against runtime limits, and pushes its decisions to the
+  // workers through thread local storage.
+  overload_manager_.reset(new OverloadManagerImpl(*this));
+  overload_manager_->start();
+
   // Once we have runtime we can initialize the SSL context manager.
   ssl_context_manager_.reset(new Ssl::ContextManagerImpl(*runtime_loader_));
-
-  cluster_manager_factory_.reset(new Upstream::ProdClusterManagerFactory(
-      runtime(), stats(), threadLocal(), random(), dnsResolver(), sslContextManager(), dispatcher(),
-      localInfo()));
+  if (options.privateKeyThreads() > 0) {
+    ssl_context_manager_->setPrivateKeyMethodProvider(
+        std::make_shared<Ssl::ThreadPoolPrivateKeyMethodProvider>(options.privateKeyThreads()));
+  }
+  if (options.sslSessionCacheSize() > 0) {
+    ssl_context_manager_->setSessionCache(
+        std::make_shared<Ssl::SessionCacheImpl>(options.sslSessionCacheSize()));
+  }
+  ssl_context_manager_->setLazyCertificateLoading(options.lazyTlsCertificates());
+  ssl_context_manager_->setEarlyData(options.tlsEarlyData());
+
+  Upstream::ProdClusterManagerFactory* cluster_manager_factory =
+      new Upstream::ProdClusterManagerFactory(runtime(), stats(), threadLocal(), random(),
+                                              dnsResolver(), sslContextManager(), dispatcher(),
+                                              localInfo());
+  cluster_manager_factory_.reset(cluster_manager_factory);
+  if (health_check_dispatcher_) {
+    cluster_manager_factory->setHealthCheckDispatcher(*health_check_dispatcher_);
+  }
+  if (xds_dispatcher_) {
+    cluster_manager_factory->setXdsDispatcher(*xds_dispatcher_);
+  }
+  cluster_manager_factory->setXdsCachePath(options.xdsCachePath());
 
   // Now the configuration gets parsed. The configuration may start setting thread local data
   // per above. See MainImpl::initialize() for why we do this pointer dance.
@@ -258,6 +355,26 @@ void InstanceImpl::initialize(Options& options,
       new Server::GuardDogImpl(stats_store_, *config_, ProdMonotonicTimeSource::instance_));
 }
 
+void InstanceImpl::stopHealthCheckThread() {
+  if (health_check_thread_) {
+    // The health checkers of the clusters which have been destroyed are deleted by callbacks
+    // posted before this one, so they are gone by the time the thread exits.
+    health_check_dispatcher_->post([this]() -> void { health_check_dispatcher_->exit(); });
+    health_check_thread_->join();
+    health_check_thread_.reset();
+  }
+}
+
+void InstanceImpl::stopXdsThread() {
+  if (xds_thread_) {
+    // The ADS mux of the cluster manager which has been shut down is deleted by a callback posted
+    // before this one.
+    xds_dispatcher_->post([this]() -> void { xds_dispatcher_->exit(); });
+    xds_thread_->join();
+    xds_thread_.reset();
+  }
+}
+
 void InstanceImpl::startWorkers() {
   listener_manager_->startWorkers(*guard_dog_);
 
@@ -279,7 +396,7 @@ Runtime::LoaderPtr InstanceUtil::createRuntime(Instance& server,
 
     Api::OsSysCallsPtr os_sys_calls(new Api::OsSysCallsImpl);
     return Runtime::LoaderPtr{new Runtime::LoaderImpl(
-        server.dispatcher(), server.threadLocal(), config.runtime()->symlinkRoot(),
+        server.dispatcher(), server.threadLocal(), server.api(), config.runtime()->symlinkRoot(),
         config.runtime()->subdirectory(), override_subdirectory, server.stats(), server.random(),
         std::move(os_sys_calls))};
   } else {
@@ -356,6 +473,9 @@ void InstanceImpl::run() {
   guard_dog_->stopWatching(watchdog);
   watchdog.reset();
 
+  // Nothing can be posted back to the main dispatcher from the thread pool once it stopped.
+  api_->shutdownThreadPool();
+
   // Before starting to shutdown anything else, stop slot destruction updates.
   thread_local_.shutdownGlobalThreading();
 
@@ -371,6 +491,8 @@ void InstanceImpl::run() {
   }
 
   config_->clusterManager().shutdown();
+  stopHealthCheckThread();
+  stopXdsThread();
   handler_.reset();
   thread_local_.shutdownThread();
   ENVOY_LOG(info, "exiting");
@@ -18,12 +18,14 @@
 #include "envoy/tracing/http_tracer.h"
 
 #include "common/access_log/access_log_manager_impl.h"
+#include "common/common/thread.h"
 #include "common/runtime/runtime_impl.h"
 #include "common/ssl/context_manager_impl.h"
 
 #include "server/http/admin.h"
 #include "server/init_manager_impl.h"
 #include "server/listener_manager_impl.h"
+#include "server/overload_manager_impl.h"
 #include "server/test_hooks.h"
 #include "server/worker_impl.h"
 
@@ -38,6 +40,9 @@ namespace Server {
   GAUGE(uptime)                                                                                    \
   GAUGE(memory_allocated)                                                                          \
   GAUGE(memory_heap_size)                                                                          \
+  GAUGE(memory_thread_cache)                                                                       \
+  GAUGE(memory_pageheap_free)                                                                      \
+  GAUGE(memory_pageheap_unmapped)                                                                  \
   GAUGE(live)                                                                                      \
   GAUGE(parent_connections)                                                                        \
   GAUGE(total_connections)                                                                         \
@@ -79,13 +84,16 @@ public:
   static Runtime::LoaderPtr createRuntime(Instance& server, Server::Configuration::Initial& config);
 
   /**
-   * Helper for flushing counters and gauges to sinks. This takes care of calling beginFlush(),
-   * latching of counters and flushing, flushing of gauges, and calling endFlush(), on each sink.
+   * Helper for flushing stats to sinks. This takes care of calling beginFlush(), latching of
+   * counters and flushing, flushing of gauges, merging and flushing of histograms, and calling
+   * endFlush(), on each sink.
    * @param sinks supplies the list of sinks.
    * @param store supplies the store to flush.
+   * @param full_flush supplies whether every used counter and gauge is flushed to every sink, or
+   *        only the changed ones to the sinks which only need those.
    */
-  static void flushCountersAndGaugesToSinks(const std::list<Stats::SinkPtr>& sinks,
-                                            Stats::Store& store);
+  static void flushMetricsToSinks(const std::list<Stats::SinkPtr>& sinks, Stats::Store& store,
+                                  bool full_flush);
 };
 
 /**
@@ -148,6 +156,7 @@ public:
   Singleton::Manager& singletonManager() override { return *singleton_manager_; }
   bool healthCheckFailed() override;
   Options& options() override { return options_; }
+  OverloadManager& overloadManager() override { return *overload_manager_; }
   time_t startTimeCurrentEpoch() override { return start_time_; }
   time_t startTimeFirstEpoch() override { return original_start_time_; }
   Stats::Store& stats() override { return stats_store_; }
@@ -162,6 +171,8 @@ private:
   void loadServerFlags(const Optional<std::string>& flags_path);
   uint64_t numConnections();
   void startWorkers();
+  void stopHealthCheckThread();
+  void stopXdsThread();
 
   Options& options_;
   HotRestart& restarter_;
@@ -178,14 +189,22 @@ private:
   Network::ConnectionHandlerPtr handler_;
   Runtime::RandomGeneratorImpl random_generator_;
   Runtime::LoaderPtr runtime_loader_;
+  std::unique_ptr<OverloadManagerImpl> overload_manager_;
   std::unique_ptr<Ssl::ContextManagerImpl> ssl_context_manager_;
   ProdListenerComponentFactory listener_component_factory_;
   ProdWorkerFactory worker_factory_;
   std::unique_ptr<ListenerManager> listener_manager_;
+  // Declared before config_ so that it outlives the clusters whose health checkers it runs.
+  Event::DispatcherPtr health_check_dispatcher_;
+  Thread::ThreadPtr health_check_thread_;
+  // Declared before config_ so that it outlives the cluster manager whose ADS stream it runs.
+  Event::DispatcherPtr xds_dispatcher_;
+  Thread::ThreadPtr xds_thread_;
   std::unique_ptr<Configuration::Main> config_;
   Stats::ScopePtr admin_scope_;
   Network::DnsResolverSharedPtr dns_resolver_;
   Event::TimerPtr stat_flush_timer_;
+  uint64_t stat_flushes_{};
   LocalInfo::LocalInfoPtr local_info_;
   DrainManagerPtr drain_manager_;
   AccessLog::AccessLogManagerImpl access_log_manager_;
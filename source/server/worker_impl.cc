@@ -11,19 +11,30 @@
 
 #include "server/connection_handler_impl.h"
 
+#include "fmt/format.h"
+
 namespace Envoy {
 namespace Server {
 
-WorkerPtr ProdWorkerFactory::createWorker() {
+WorkerPtr ProdWorkerFactory::createWorker(uint32_t index) {
   Event::DispatcherPtr dispatcher(api_.allocateDispatcher());
+  dispatcher->initializeStats(scope_, fmt::format("server.worker_{}.", index));
+  Optional<uint32_t> cpu;
+  if (!cpus_.empty()) {
+    cpu.value(cpus_[index % cpus_.size()]);
+  }
   return WorkerPtr{new WorkerImpl(
       tls_, hooks_, std::move(dispatcher),
-      Network::ConnectionHandlerPtr{new ConnectionHandlerImpl(ENVOY_LOGGER(), *dispatcher)})};
+      Network::ConnectionHandlerPtr{
+          new ConnectionHandlerImpl(ENVOY_LOGGER(), *dispatcher, fmt::format("worker_{}.", index))},
+      index, cpu)};
 }
 
 WorkerImpl::WorkerImpl(ThreadLocal::Instance& tls, TestHooks& hooks,
-                       Event::DispatcherPtr&& dispatcher, Network::ConnectionHandlerPtr handler)
-    : tls_(tls), hooks_(hooks), dispatcher_(std::move(dispatcher)), handler_(std::move(handler)) {
+                       Event::DispatcherPtr&& dispatcher, Network::ConnectionHandlerPtr handler,
+                       uint32_t index, Optional<uint32_t> cpu)
+    : tls_(tls), hooks_(hooks), dispatcher_(std::move(dispatcher)), handler_(std::move(handler)),
+      index_(index), cpu_(cpu) {
   tls_.registerThread(*dispatcher_, false);
 }
 
@@ -43,18 +54,28 @@ void WorkerImpl::addListener(Listener& listener, AddListenerCompletion completio
 }
 
 void WorkerImpl::addListenerWorker(Listener& listener) {
+  Network::ListenSocket* socket = listener.workerSocket(index_);
+  // The listener manager creates a socket for every worker.
+  ASSERT(socket != nullptr);
   const Network::ListenerOptions listener_options = {.bind_to_port_ = listener.bindToPort(),
                                                      .use_proxy_proto_ = listener.useProxyProto(),
                                                      .use_original_dst_ = listener.useOriginalDst(),
                                                      .per_connection_buffer_limit_bytes_ =
-                                                         listener.perConnectionBufferLimitBytes()};
+                                                         listener.perConnectionBufferLimitBytes(),
+                                                     .connection_balancer_ =
+                                                         listener.connectionBalancer(),
+                                                     .buffer_account_ = listener.bufferAccount(),
+                                                     .max_accepts_per_wakeup_ =
+                                                         listener.maxAcceptsPerWakeup(),
+                                                     .max_accepts_per_second_ =
+                                                         listener.maxAcceptsPerSecond()};
   if (listener.defaultSslContext()) {
     handler_->addSslListener(listener.filterChainFactory(), *listener.defaultSslContext(),
-                             listener.socket(), listener.listenerScope(), listener.listenerTag(),
+                             *socket, listener.listenerScope(), listener.listenerTag(),
                              listener_options);
   } else {
-    handler_->addListener(listener.filterChainFactory(), listener.socket(),
-                          listener.listenerScope(), listener.listenerTag(), listener_options);
+    handler_->addListener(listener.filterChainFactory(), *socket, listener.listenerScope(),
+                          listener.listenerTag(), listener_options);
   }
 
   hooks_.onWorkerListenerAdded();
@@ -78,6 +99,17 @@ void WorkerImpl::removeListener(Listener& listener, std::function<void()> comple
   });
 }
 
+void WorkerImpl::removeListenerWhenIdle(Listener& listener, std::function<void()> completion) {
+  ASSERT(thread_);
+  const uint64_t listener_tag = listener.listenerTag();
+  dispatcher_->post([this, listener_tag, completion]() -> void {
+    handler_->removeListenersWhenIdle(listener_tag, [this, completion]() -> void {
+      completion();
+      hooks_.onWorkerListenerRemoved();
+    });
+  });
+}
+
 void WorkerImpl::start(GuardDog& guard_dog) {
   ASSERT(!thread_);
   thread_.reset(new Thread::Thread([this, &guard_dog]() -> void { threadRoutine(guard_dog); }));
@@ -104,6 +136,14 @@ void WorkerImpl::stopListeners() {
 }
 
 void WorkerImpl::threadRoutine(GuardDog& guard_dog) {
+  if (cpu_.valid()) {
+    if (Thread::Thread::pinCurrentThread(cpu_.value())) {
+      ENVOY_LOG(debug, "worker {} pinned to CPU {}", index_, cpu_.value());
+    } else {
+      ENVOY_LOG(warn, "unable to pin worker {} to CPU {}", index_, cpu_.value());
+    }
+  }
+
   ENVOY_LOG(debug, "worker entering dispatch loop");
   auto watchdog = guard_dog.createWatchDog(Thread::Thread::currentThreadId());
   watchdog->startWatchdog(*dispatcher_);
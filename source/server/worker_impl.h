@@ -2,12 +2,15 @@
 
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "envoy/api/api.h"
+#include "envoy/common/optional.h"
 #include "envoy/network/connection_handler.h"
 #include "envoy/server/guarddog.h"
 #include "envoy/server/listener_manager.h"
 #include "envoy/server/worker.h"
+#include "envoy/stats/stats.h"
 #include "envoy/thread_local/thread_local.h"
 
 #include "common/common/logger.h"
@@ -20,16 +23,19 @@ namespace Server {
 
 class ProdWorkerFactory : public WorkerFactory, Logger::Loggable<Logger::Id::main> {
 public:
-  ProdWorkerFactory(ThreadLocal::Instance& tls, Api::Api& api, TestHooks& hooks)
-      : tls_(tls), api_(api), hooks_(hooks) {}
+  ProdWorkerFactory(ThreadLocal::Instance& tls, Api::Api& api, TestHooks& hooks,
+                    Stats::Scope& scope, const std::vector<uint32_t>& cpus)
+      : tls_(tls), api_(api), hooks_(hooks), scope_(scope), cpus_(cpus) {}
 
   // Server::WorkerFactory
-  WorkerPtr createWorker() override;
+  WorkerPtr createWorker(uint32_t index) override;
 
 private:
   ThreadLocal::Instance& tls_;
   Api::Api& api_;
   TestHooks& hooks_;
+  Stats::Scope& scope_;
+  const std::vector<uint32_t> cpus_;
 };
 
 /**
@@ -37,13 +43,17 @@ private:
  */
 class WorkerImpl : public Worker, Logger::Loggable<Logger::Id::main> {
 public:
+  /**
+   * @param cpu supplies the CPU to pin the worker thread to, if any.
+   */
   WorkerImpl(ThreadLocal::Instance& tls, TestHooks& hooks, Event::DispatcherPtr&& dispatcher,
-             Network::ConnectionHandlerPtr handler);
+             Network::ConnectionHandlerPtr handler, uint32_t index, Optional<uint32_t> cpu);
 
   // Server::Worker
   void addListener(Listener& listener, AddListenerCompletion completion) override;
   uint64_t numConnections() override;
   void removeListener(Listener& listener, std::function<void()> completion) override;
+  void removeListenerWhenIdle(Listener& listener, std::function<void()> completion) override;
   void start(GuardDog& guard_dog) override;
   void stop() override;
   void stopListener(Listener& listener) override;
@@ -58,6 +68,8 @@ private:
   Event::DispatcherPtr dispatcher_;
   Network::ConnectionHandlerPtr handler_;
   Thread::ThreadPtr thread_;
+  const uint32_t index_;
+  const Optional<uint32_t> cpu_;
 };
 
 } // namespace Server
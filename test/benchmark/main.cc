@@ -0,0 +1,23 @@
+// NOLINT(namespace-envoy)
+// This is an Envoy driver for benchmarks.
+
+#include "common/common/logger.h"
+#include "common/common/thread.h"
+#include "common/event/libevent.h"
+
+#include "benchmark/benchmark.h"
+
+// Boilerplate main(), which discovers benchmarks and runs them. Logging is restricted to critical
+// messages so that log output does not skew the measurements.
+int main(int argc, char** argv) {
+  Envoy::Event::Libevent::Global::initialize();
+  Envoy::Thread::MutexBasicLockable lock;
+  Envoy::Logger::Registry::initialize(spdlog::level::critical, lock);
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -12,6 +12,7 @@
 #include "test/test_common/printers.h"
 #include "test/test_common/utility.h"
 
+#include "fmt/format.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -189,6 +190,13 @@ TEST(AccessLogFormatterTest, requestInfoFormatter) {
     EXPECT_CALL(request_info, upstreamHost()).WillOnce(Return(nullptr));
     EXPECT_EQ("-", upstream_format.format(header, header, request_info));
   }
+
+  {
+    RequestInfoFormatter filter_timings_format("FILTER_TIMINGS");
+    EXPECT_EQ("-", filter_timings_format.format(header, header, request_info));
+    request_info.filter_timings_ = "d0:12:0,e1:3:150";
+    EXPECT_EQ("d0:12:0,e1:3:150", filter_timings_format.format(header, header, request_info));
+  }
 }
 
 TEST(AccessLogFormatterTest, requestHeaderFormatter) {
@@ -276,6 +284,29 @@ TEST(AccessLogFormatterTest, CompositeFormatterSuccess) {
   }
 }
 
+// Formatting into a string appends to it, and matches the formatted string.
+TEST(AccessLogFormatterTest, CompositeFormatterInto) {
+  NiceMock<MockRequestInfo> request_info;
+  Http::TestHeaderMapImpl request_header{{"first", "GET"}, {":path", "/"}};
+  Http::TestHeaderMapImpl response_header{{"second", "PUT"}};
+  FormatterImpl formatter("[%START_TIME%] %REQ(first)% %RESP(second):2% %BYTES_SENT% "
+                          "%RESPONSE_FLAGS%");
+
+  // The second start time is in the same second as the first one, and the third is not.
+  for (uint64_t milliseconds : {1522796769123UL, 1522796769007UL, 1522796770040UL}) {
+    SystemTime time{std::chrono::milliseconds(milliseconds)};
+    EXPECT_CALL(request_info, startTime()).WillRepeatedly(Return(time));
+    EXPECT_CALL(request_info, bytesSent()).WillRepeatedly(Return(1024));
+
+    const std::string expected =
+        fmt::format("[{}] GET PU 1024 -", AccessLogDateTimeFormatter::fromTime(time));
+    EXPECT_EQ(expected, formatter.format(request_header, response_header, request_info));
+    std::string output = "prefix ";
+    formatter.formatInto(request_header, response_header, request_info, output);
+    EXPECT_EQ("prefix " + expected, output);
+  }
+}
+
 TEST(AccessLogFormatterTest, ParserFailures) {
   AccessLogFormatParser parser;
 
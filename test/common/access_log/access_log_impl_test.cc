@@ -92,6 +92,7 @@ public:
   bool healthCheck() const override { return hc_request_; }
   void healthCheck(bool is_hc) override { hc_request_ = is_hc; }
   const std::string& getDownstreamAddress() const override { return downstream_address_; }
+  const std::string& filterTimings() const override { return filter_timings_; }
 
   SystemTime start_time_;
   Optional<std::chrono::microseconds> request_received_duration_{std::chrono::microseconds(1000)};
@@ -104,6 +105,7 @@ public:
   Optional<std::string> upstream_local_address_{};
   bool hc_request_{};
   std::string downstream_address_;
+  std::string filter_timings_;
 };
 
 class AccessLogImplTest : public testing::Test {
@@ -278,6 +280,42 @@ TEST_F(AccessLogImplTest, RuntimeFilter) {
   log->log(&request_headers_, &response_headers_, request_info_);
 }
 
+TEST_F(AccessLogImplTest, RuntimeFilterKeep) {
+  const std::string json = R"EOF(
+  {
+    "path": "/dev/null",
+    "filter": {"type": "runtime", "key": "access_log.test_key"}
+  }
+  )EOF";
+
+  InstanceSharedPtr log = AccessLogFactory::fromProto(parseAccessLogFromJson(json), context_);
+  ON_CALL(runtime_.snapshot_, getInteger("access_log.test_key.keep_errors", 0))
+      .WillByDefault(Return(1));
+  ON_CALL(runtime_.snapshot_, getInteger("access_log.test_key.keep_duration_ms", 0))
+      .WillByDefault(Return(100));
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("access_log.test_key", 0))
+      .WillRepeatedly(Return(false));
+
+  // A successful fast request is sampled out.
+  request_info_.response_code_.value(200);
+  EXPECT_CALL(*file_, write(_)).Times(0);
+  log->log(&request_headers_, &response_headers_, request_info_);
+
+  // Errors and slow requests are always kept.
+  request_info_.response_code_.value(503);
+  EXPECT_CALL(*file_, write(_));
+  log->log(&request_headers_, &response_headers_, request_info_);
+
+  request_info_.response_code_ = Optional<uint32_t>();
+  EXPECT_CALL(*file_, write(_));
+  log->log(&request_headers_, &response_headers_, request_info_);
+
+  request_info_.response_code_.value(200);
+  request_info_.duration_ = 100000;
+  EXPECT_CALL(*file_, write(_));
+  log->log(&request_headers_, &response_headers_, request_info_);
+}
+
 TEST_F(AccessLogImplTest, PathRewrite) {
   request_headers_ = {{":method", "GET"}, {":path", "/foo"}, {"x-envoy-original-path", "/bar"}};
 
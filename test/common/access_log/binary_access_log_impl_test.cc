@@ -0,0 +1,81 @@
+#include <string>
+
+#include "common/access_log/binary_access_log_impl.h"
+#include "common/http/header_map_impl.h"
+
+#include "test/mocks/access_log/mocks.h"
+#include "test/mocks/filesystem/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::ReturnRef;
+using testing::SaveArg;
+using testing::_;
+
+namespace Envoy {
+namespace AccessLog {
+
+// Entries are read back one after the other, and a truncated entry is an error.
+TEST(BinaryAccessLogFormatTest, AppendAndRead) {
+  envoy::access_log::HTTPAccessLogEntry entry;
+  std::string log;
+  entry.set_method("GET");
+  entry.set_path(std::string(200, 'a'));
+  BinaryAccessLogFormat::append(entry, log);
+  entry.set_method("POST");
+  entry.set_response_code(503);
+  BinaryAccessLogFormat::append(entry, log);
+
+  Protobuf::io::CodedInputStream input(reinterpret_cast<const uint8_t*>(log.data()), log.size());
+  envoy::access_log::HTTPAccessLogEntry read_entry;
+  EXPECT_TRUE(BinaryAccessLogFormat::read(input, read_entry));
+  EXPECT_EQ("GET", read_entry.method());
+  EXPECT_EQ(0U, read_entry.response_code());
+  EXPECT_EQ(std::string(200, 'a'), read_entry.path());
+  EXPECT_TRUE(BinaryAccessLogFormat::read(input, read_entry));
+  EXPECT_EQ("POST", read_entry.method());
+  EXPECT_EQ(503U, read_entry.response_code());
+  EXPECT_FALSE(BinaryAccessLogFormat::read(input, read_entry));
+
+  Protobuf::io::CodedInputStream truncated(reinterpret_cast<const uint8_t*>(log.data()),
+                                           log.size() - 1);
+  EXPECT_TRUE(BinaryAccessLogFormat::read(truncated, read_entry));
+  EXPECT_FALSE(BinaryAccessLogFormat::read(truncated, read_entry));
+}
+
+// Each request is written to the file as one entry.
+TEST(BinaryFileAccessLogTest, Log) {
+  NiceMock<MockAccessLogManager> log_manager;
+  EXPECT_CALL(log_manager, createAccessLog("/dev/null"));
+  BinaryFileAccessLog access_log("/dev/null", nullptr, log_manager);
+
+  NiceMock<MockRequestInfo> request_info;
+  Optional<Http::Protocol> protocol(Http::Protocol::Http2);
+  ON_CALL(request_info, protocol()).WillByDefault(ReturnRef(protocol));
+  Optional<uint32_t> response_code(200);
+  ON_CALL(request_info, responseCode()).WillByDefault(ReturnRef(response_code));
+  const std::string downstream_address = "127.0.0.2";
+  ON_CALL(request_info, getDownstreamAddress()).WillByDefault(ReturnRef(downstream_address));
+  Http::TestHeaderMapImpl request_headers{{":method", "GET"}, {":path", "/"}};
+
+  std::string record;
+  EXPECT_CALL(*log_manager.file_, write(_)).WillOnce(SaveArg<0>(&record));
+  access_log.log(&request_headers, nullptr, request_info);
+
+  Protobuf::io::CodedInputStream input(reinterpret_cast<const uint8_t*>(record.data()),
+                                       record.size());
+  envoy::access_log::HTTPAccessLogEntry entry;
+  EXPECT_TRUE(BinaryAccessLogFormat::read(input, entry));
+  EXPECT_EQ("GET", entry.method());
+  EXPECT_EQ("/", entry.path());
+  EXPECT_EQ("HTTP/2", entry.protocol());
+  EXPECT_EQ(200U, entry.response_code());
+  EXPECT_EQ("127.0.0.2", entry.downstream_address());
+  EXPECT_EQ(static_cast<int>(record.size()), input.CurrentPosition());
+}
+
+} // namespace AccessLog
+} // namespace Envoy
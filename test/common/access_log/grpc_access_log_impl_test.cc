@@ -0,0 +1,232 @@
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "common/access_log/grpc_access_log_impl.h"
+#include "common/http/header_map_impl.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/access_log/mocks.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/grpc/mocks.h"
+#include "test/mocks/local_info/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::ReturnRef;
+using testing::_;
+
+namespace Envoy {
+namespace AccessLog {
+
+typedef Grpc::MockAsyncClient<envoy::access_log::StreamAccessLogsMessage,
+                              envoy::access_log::StreamAccessLogsResponse>
+    AccessLogServiceMockAsyncClient;
+
+class GrpcAccessLogStreamerTest : public testing::Test {
+public:
+  GrpcAccessLogStreamerTest()
+      : stats_{ALL_GRPC_ACCESS_LOG_STATS(POOL_COUNTER_PREFIX(stats_store_, "access_log.grpc."))},
+        async_client_(new AccessLogServiceMockAsyncClient()),
+        flush_timer_(new Event::MockTimer(&dispatcher_)) {
+    EXPECT_CALL(*flush_timer_, enableTimer(std::chrono::milliseconds(1000)));
+    streamer_.reset(new GrpcAccessLogStreamer(AccessLogServiceAsyncClientPtr{async_client_},
+                                              "test_log", local_info_, dispatcher_,
+                                              std::chrono::milliseconds(1000), 100, stats_));
+  }
+
+  envoy::access_log::HTTPAccessLogEntry entry(const std::string& path) {
+    envoy::access_log::HTTPAccessLogEntry entry;
+    entry.set_path(path);
+    return entry;
+  }
+
+  void expectSendMessage(envoy::access_log::StreamAccessLogsMessage& message) {
+    EXPECT_CALL(async_stream_, sendMessage(_, false))
+        .WillOnce(Invoke([&message](const envoy::access_log::StreamAccessLogsMessage& request,
+                                    bool) -> void { message = request; }));
+  }
+
+  Stats::IsolatedStoreImpl stats_store_;
+  GrpcAccessLogStats stats_;
+  NiceMock<LocalInfo::MockLocalInfo> local_info_;
+  Event::MockDispatcher dispatcher_;
+  AccessLogServiceMockAsyncClient* async_client_;
+  Event::MockTimer* flush_timer_;
+  Grpc::MockAsyncStream<envoy::access_log::StreamAccessLogsMessage> async_stream_;
+  std::unique_ptr<GrpcAccessLogStreamer> streamer_;
+};
+
+// Entries are buffered until the flush timer fires, and only the first message of a stream carries
+// the identifier.
+TEST_F(GrpcAccessLogStreamerTest, TimerFlush) {
+  streamer_->log(entry("/a"));
+  streamer_->log(entry("/b"));
+
+  envoy::access_log::StreamAccessLogsMessage message;
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  expectSendMessage(message);
+  EXPECT_CALL(*flush_timer_, enableTimer(std::chrono::milliseconds(1000)));
+  flush_timer_->callback_();
+  EXPECT_EQ("node_name", message.identifier().node());
+  EXPECT_EQ("cluster_name", message.identifier().cluster());
+  EXPECT_EQ("test_log", message.identifier().log_name());
+  ASSERT_EQ(2, message.http_logs_size());
+  EXPECT_EQ("/a", message.http_logs(0).path());
+  EXPECT_EQ("/b", message.http_logs(1).path());
+
+  // Nothing is sent when there is nothing buffered.
+  EXPECT_CALL(*flush_timer_, enableTimer(std::chrono::milliseconds(1000)));
+  flush_timer_->callback_();
+
+  streamer_->log(entry("/c"));
+  expectSendMessage(message);
+  EXPECT_CALL(*flush_timer_, enableTimer(std::chrono::milliseconds(1000)));
+  flush_timer_->callback_();
+  EXPECT_FALSE(message.has_identifier());
+  ASSERT_EQ(1, message.http_logs_size());
+  EXPECT_EQ("/c", message.http_logs(0).path());
+
+  EXPECT_EQ(3U, stats_store_.counter("access_log.grpc.logs_sent").value());
+  EXPECT_EQ(2U, stats_store_.counter("access_log.grpc.batches_sent").value());
+  EXPECT_CALL(async_stream_, resetStream());
+}
+
+// A batch is sent as soon as its size reaches the buffer size.
+TEST_F(GrpcAccessLogStreamerTest, SizeFlush) {
+  envoy::access_log::StreamAccessLogsMessage message;
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  expectSendMessage(message);
+  streamer_->log(entry(std::string(100, 'a')));
+  ASSERT_EQ(1, message.http_logs_size());
+  EXPECT_CALL(async_stream_, resetStream());
+}
+
+// A closed stream is reopened by the next batch, which carries the identifier again.
+TEST_F(GrpcAccessLogStreamerTest, RemoteClose) {
+  envoy::access_log::StreamAccessLogsMessage message;
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  expectSendMessage(message);
+  streamer_->log(entry("/a"));
+  streamer_->flush();
+
+  streamer_->onRemoteClose(Grpc::Status::GrpcStatus::Unavailable, "");
+  EXPECT_EQ(1U, stats_store_.counter("access_log.grpc.streams_closed").value());
+
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  expectSendMessage(message);
+  streamer_->log(entry("/b"));
+  streamer_->flush();
+  EXPECT_EQ("test_log", message.identifier().log_name());
+  EXPECT_CALL(async_stream_, resetStream());
+}
+
+// The batch is dropped when the stream can't be started.
+TEST_F(GrpcAccessLogStreamerTest, StreamCreationFailure) {
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(nullptr));
+  streamer_->log(entry("/a"));
+  streamer_->flush();
+  EXPECT_EQ(1U, stats_store_.counter("access_log.grpc.logs_dropped").value());
+
+  envoy::access_log::StreamAccessLogsMessage message;
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  expectSendMessage(message);
+  streamer_->log(entry("/b"));
+  streamer_->flush();
+  ASSERT_EQ(1, message.http_logs_size());
+  EXPECT_EQ("/b", message.http_logs(0).path());
+  EXPECT_CALL(async_stream_, resetStream());
+}
+
+TEST(HttpGrpcAccessLogTest, PopulateEntry) {
+  NiceMock<MockRequestInfo> request_info;
+  request_info.start_time_ = SystemTime(std::chrono::microseconds(1500000));
+  ON_CALL(request_info, startTime()).WillByDefault(Return(request_info.start_time_));
+  ON_CALL(request_info, duration()).WillByDefault(Return(std::chrono::microseconds(2000)));
+  Optional<Http::Protocol> protocol(Http::Protocol::Http11);
+  ON_CALL(request_info, protocol()).WillByDefault(ReturnRef(protocol));
+  Optional<uint32_t> response_code(200);
+  ON_CALL(request_info, responseCode()).WillByDefault(ReturnRef(response_code));
+  ON_CALL(request_info, bytesReceived()).WillByDefault(Return(10));
+  ON_CALL(request_info, bytesSent()).WillByDefault(Return(20));
+  const std::string downstream_address = "127.0.0.2";
+  ON_CALL(request_info, getDownstreamAddress()).WillByDefault(ReturnRef(downstream_address));
+
+  Http::TestHeaderMapImpl request_headers{{":method", "GET"},
+                                          {":path", "/rewritten"},
+                                          {"x-envoy-original-path", "/original"},
+                                          {":authority", "host"},
+                                          {"user-agent", "agent"},
+                                          {"x-forwarded-for", "10.0.0.2"},
+                                          {"x-request-id", "id"}};
+
+  envoy::access_log::HTTPAccessLogEntry entry;
+  HttpGrpcAccessLog::populateEntry(request_headers, request_info, entry);
+  EXPECT_EQ(1500000U, entry.start_time_unix_us());
+  EXPECT_EQ(2000U, entry.duration_us());
+  EXPECT_EQ("HTTP/1.1", entry.protocol());
+  EXPECT_EQ("GET", entry.method());
+  EXPECT_EQ("/original", entry.path());
+  EXPECT_EQ("host", entry.authority());
+  EXPECT_EQ("agent", entry.user_agent());
+  EXPECT_EQ("10.0.0.2", entry.forwarded_for());
+  EXPECT_EQ("id", entry.request_id());
+  EXPECT_EQ(200U, entry.response_code());
+  EXPECT_EQ("-", entry.response_flags());
+  EXPECT_EQ(10U, entry.bytes_received());
+  EXPECT_EQ(20U, entry.bytes_sent());
+  EXPECT_EQ("10.0.0.1:443", entry.upstream_host());
+  EXPECT_EQ("fake_cluster", entry.upstream_cluster());
+  EXPECT_EQ("127.0.0.2", entry.downstream_address());
+}
+
+// Each worker logs through its own streamer, created from the client factory.
+TEST(HttpGrpcAccessLogTest, Log) {
+  NiceMock<ThreadLocal::MockInstance> tls;
+  NiceMock<LocalInfo::MockLocalInfo> local_info;
+  Stats::IsolatedStoreImpl stats_store;
+  AccessLogServiceMockAsyncClient* async_client = new AccessLogServiceMockAsyncClient();
+  Grpc::MockAsyncStream<envoy::access_log::StreamAccessLogsMessage> async_stream;
+
+  envoy::access_log::HttpGrpcAccessLogConfig config;
+  config.set_log_name("test_log");
+  config.set_buffer_size_bytes(1);
+  std::unique_ptr<HttpGrpcAccessLog> access_log(new HttpGrpcAccessLog(
+      nullptr, config, tls,
+      [async_client]() -> AccessLogServiceAsyncClientPtr {
+        return AccessLogServiceAsyncClientPtr{async_client};
+      },
+      local_info, stats_store));
+
+  NiceMock<MockRequestInfo> request_info;
+  Optional<Http::Protocol> protocol;
+  ON_CALL(request_info, protocol()).WillByDefault(ReturnRef(protocol));
+  Optional<uint32_t> response_code;
+  ON_CALL(request_info, responseCode()).WillByDefault(ReturnRef(response_code));
+  const std::string downstream_address = "127.0.0.2";
+  ON_CALL(request_info, getDownstreamAddress()).WillByDefault(ReturnRef(downstream_address));
+  Http::TestHeaderMapImpl request_headers{{":method", "GET"}, {":path", "/"}};
+
+  envoy::access_log::StreamAccessLogsMessage message;
+  EXPECT_CALL(*async_client, start(_, _)).WillOnce(Return(&async_stream));
+  EXPECT_CALL(async_stream, sendMessage(_, false))
+      .WillOnce(Invoke([&message](const envoy::access_log::StreamAccessLogsMessage& request,
+                                  bool) -> void { message = request; }));
+  access_log->log(&request_headers, nullptr, request_info);
+  EXPECT_EQ("test_log", message.identifier().log_name());
+  ASSERT_EQ(1, message.http_logs_size());
+  EXPECT_EQ("GET", message.http_logs(0).method());
+  EXPECT_EQ(1U, stats_store.counter("access_log.grpc.logs_sent").value());
+
+  EXPECT_CALL(async_stream, resetStream());
+  access_log.reset();
+}
+
+} // namespace AccessLog
+} // namespace Envoy
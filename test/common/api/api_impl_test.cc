@@ -1,7 +1,9 @@
 #include <chrono>
 #include <string>
+#include <thread>
 
 #include "common/api/api_impl.h"
+#include "common/event/dispatcher_impl.h"
 
 #include "test/test_common/environment.h"
 
@@ -26,5 +28,26 @@ TEST(ApiImplTest, fileExists) {
   EXPECT_FALSE(api.fileExists("/dev/blahblahblah"));
 }
 
+// Work runs on a pool thread, and its completion is posted back to the dispatcher.
+TEST(ApiImplTest, runOnThreadPool) {
+  Impl api(std::chrono::milliseconds(10000));
+  Event::DispatcherImpl dispatcher;
+
+  std::thread::id work_thread;
+  bool completed = false;
+  api.runOnThreadPool([&]() -> void { work_thread = std::this_thread::get_id(); }, dispatcher,
+                      [&]() -> void {
+                        EXPECT_NE(std::this_thread::get_id(), work_thread);
+                        completed = true;
+                        dispatcher.exit();
+                      });
+  dispatcher.run(Event::Dispatcher::RunType::RunUntilExit);
+  EXPECT_TRUE(completed);
+
+  // Work queued after shutdown is dropped.
+  api.shutdownThreadPool();
+  api.runOnThreadPool([]() -> void { FAIL(); }, dispatcher, []() -> void { FAIL(); });
+}
+
 } // namespace Api
 } // namespace Envoy
@@ -0,0 +1,332 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Buffer {
+
+// Runs each test against both the libevent and the native implementation.
+class OwnedImplTest : public testing::TestWithParam<bool> {
+public:
+  OwnedImplTest() { OwnedImpl::useOldImpl(GetParam()); }
+  ~OwnedImplTest() { OwnedImpl::useOldImpl(true); }
+
+  static std::string toString(const Instance& buffer) {
+    std::string output(buffer.length(), 0);
+    buffer.copyOut(0, buffer.length(), &output[0]);
+    return output;
+  }
+};
+
+INSTANTIATE_TEST_CASE_P(Impl, OwnedImplTest, testing::Bool());
+
+TEST_P(OwnedImplTest, AddDrainCopyOut) {
+  OwnedImpl buffer;
+  EXPECT_EQ(GetParam(), buffer.usesOldImpl());
+  EXPECT_EQ(0U, buffer.length());
+
+  buffer.add("hello");
+  buffer.add(std::string(" world"));
+  OwnedImpl other("!");
+  buffer.add(other);
+  EXPECT_EQ(12U, buffer.length());
+  EXPECT_EQ("hello world!", toString(buffer));
+  EXPECT_EQ("!", toString(other));
+
+  char out[5];
+  buffer.copyOut(6, 5, out);
+  EXPECT_EQ("world", std::string(out, 5));
+
+  buffer.drain(6);
+  EXPECT_EQ("world!", toString(buffer));
+  buffer.drain(6);
+  EXPECT_EQ(0U, buffer.length());
+}
+
+// Data larger than a slice is split over several slices, in order.
+TEST_P(OwnedImplTest, AddLarge) {
+  std::string data;
+  for (size_t i = 0; i < 3 * OwnedSlice::DEFAULT_SIZE; i++) {
+    data.push_back('a' + i % 26);
+  }
+
+  OwnedImpl buffer;
+  buffer.add("x");
+  buffer.add(data);
+  EXPECT_EQ("x" + data, toString(buffer));
+
+  const uint64_t num_slices = buffer.getRawSlices(nullptr, 0);
+  RawSlice slices[num_slices];
+  EXPECT_EQ(num_slices, buffer.getRawSlices(slices, num_slices));
+  std::string joined;
+  for (const RawSlice& slice : slices) {
+    joined.append(static_cast<const char*>(slice.mem_), slice.len_);
+  }
+  EXPECT_EQ("x" + data, joined);
+
+  buffer.drain(OwnedSlice::DEFAULT_SIZE + 1);
+  EXPECT_EQ(data.substr(OwnedSlice::DEFAULT_SIZE), toString(buffer));
+}
+
+TEST_P(OwnedImplTest, ReserveCommit) {
+  OwnedImpl buffer("a");
+
+  // A single reservation is contiguous and holds at least the requested length.
+  RawSlice slice;
+  EXPECT_EQ(1U, buffer.reserve(20000, &slice, 1));
+  EXPECT_LE(20000U, slice.len_);
+  memset(slice.mem_, 'b', 20000);
+  slice.len_ = 20000;
+  buffer.commit(&slice, 1);
+  EXPECT_EQ(20001U, buffer.length());
+  EXPECT_EQ("a" + std::string(20000, 'b'), toString(buffer));
+
+  // Reservations over several slices may be partially committed.
+  RawSlice slices[2];
+  const uint64_t num_slices = buffer.reserve(10000, slices, 2);
+  ASSERT_LE(1U, num_slices);
+  EXPECT_LE(10000U, slices[0].len_ + (num_slices == 2 ? slices[1].len_ : 0));
+  memset(slices[0].mem_, 'c', 1);
+  slices[0].len_ = 1;
+  buffer.commit(slices, 1);
+  EXPECT_EQ(20002U, buffer.length());
+  EXPECT_EQ("a" + std::string(20000, 'b') + "c", toString(buffer));
+
+  // Uncommitted reservations do not change the buffer.
+  buffer.reserve(100, slices, 2);
+  buffer.add("d");
+  EXPECT_EQ("a" + std::string(20000, 'b') + "cd", toString(buffer));
+}
+
+TEST_P(OwnedImplTest, Move) {
+  OwnedImpl source("hello ");
+  source.add(std::string(2 * OwnedSlice::DEFAULT_SIZE, 'a'));
+  OwnedImpl destination("start ");
+
+  destination.move(source, 8);
+  EXPECT_EQ("start hello aa", toString(destination));
+  EXPECT_EQ(2 * OwnedSlice::DEFAULT_SIZE - 2, source.length());
+
+  destination.move(source);
+  EXPECT_EQ(0U, source.length());
+  EXPECT_EQ("start hello " + std::string(2 * OwnedSlice::DEFAULT_SIZE, 'a'),
+            toString(destination));
+
+  // Both buffers are still usable.
+  source.add("x");
+  destination.add("y");
+  EXPECT_EQ("x", toString(source));
+  EXPECT_EQ('y', toString(destination).back());
+}
+
+TEST_P(OwnedImplTest, MoveManySmall) {
+  OwnedImpl buffer;
+  std::string expected;
+  for (int i = 0; i < 100; i++) {
+    const std::string data = std::to_string(i);
+    OwnedImpl fragment(data);
+    buffer.move(fragment);
+    expected += data;
+  }
+  EXPECT_EQ(expected, toString(buffer));
+  EXPECT_EQ(expected, std::string(static_cast<char*>(buffer.linearize(buffer.length())),
+                                  buffer.length()));
+}
+
+TEST_P(OwnedImplTest, Linearize) {
+  OwnedImpl buffer;
+  for (int i = 0; i < 4; i++) {
+    OwnedImpl fragment(std::string(OwnedSlice::DEFAULT_SIZE, 'a' + i));
+    buffer.move(fragment);
+  }
+
+  const uint64_t size = OwnedSlice::DEFAULT_SIZE + 10;
+  const char* data = static_cast<const char*>(buffer.linearize(size));
+  EXPECT_EQ(std::string(OwnedSlice::DEFAULT_SIZE, 'a') + std::string(10, 'b'),
+            std::string(data, size));
+  EXPECT_EQ(4 * OwnedSlice::DEFAULT_SIZE, buffer.length());
+  std::string expected;
+  for (int i = 0; i < 4; i++) {
+    expected += std::string(OwnedSlice::DEFAULT_SIZE, 'a' + i);
+  }
+  EXPECT_EQ(expected, toString(buffer));
+}
+
+TEST_P(OwnedImplTest, Search) {
+  OwnedImpl buffer;
+  EXPECT_EQ(-1, buffer.search("a", 1, 0));
+
+  // Fill whole slices so that matches span slice boundaries.
+  const uint64_t size = OwnedSlice::DEFAULT_SIZE;
+  const std::string fragments[] = {std::string(size - 3, '-') + "abc",
+                                   "d" + std::string(size - 3, '-') + "ab", "cdx"};
+  for (const std::string& fragment : fragments) {
+    OwnedImpl other(fragment);
+    buffer.move(other);
+  }
+
+  EXPECT_EQ(static_cast<ssize_t>(size - 3), buffer.search("abc", 3, 0));
+  EXPECT_EQ(static_cast<ssize_t>(size - 3), buffer.search("abcd", 4, 0));
+  EXPECT_EQ(static_cast<ssize_t>(size - 1), buffer.search("cd", 2, 0));
+  EXPECT_EQ(static_cast<ssize_t>(2 * size - 2), buffer.search("abcd", 4, size - 2));
+  EXPECT_EQ(static_cast<ssize_t>(2 * size + 2), buffer.search("x", 1, 0));
+  EXPECT_EQ(static_cast<ssize_t>(2 * size + 2), buffer.search("x", 1, 2 * size + 2));
+  EXPECT_EQ(-1, buffer.search("xy", 2, 0));
+  EXPECT_EQ(-1, buffer.search("abcx", 4, 0));
+  EXPECT_EQ(-1, buffer.search("abc", 3, 2 * size - 1));
+  EXPECT_EQ(-1, buffer.search("a", 1, buffer.length() + 1));
+}
+
+TEST_P(OwnedImplTest, AddBufferFragment) {
+  const std::string data(2 * OwnedImpl::COPY_THRESHOLD, 'a');
+  uint32_t releases = 0;
+  BufferFragmentImpl fragment(data.c_str(), data.size(),
+                              [&](const void* released, size_t size, const BufferFragmentImpl*) {
+                                EXPECT_EQ(data.c_str(), released);
+                                EXPECT_EQ(data.size(), size);
+                                releases++;
+                              });
+
+  {
+    OwnedImpl buffer("x");
+    buffer.addBufferFragment(fragment);
+    buffer.add("y");
+    EXPECT_EQ("x" + data + "y", toString(buffer));
+
+    // The data is referenced, not copied.
+    RawSlice slices[3];
+    ASSERT_EQ(3U, buffer.getRawSlices(slices, 3));
+    EXPECT_EQ(data.c_str(), slices[1].mem_);
+
+    // The fragment follows the data when moved to another buffer, and is released once fully
+    // drained.
+    OwnedImpl destination;
+    destination.move(buffer);
+    destination.drain(data.size());
+    EXPECT_EQ(0U, releases);
+    destination.drain(1);
+    EXPECT_EQ(1U, releases);
+    EXPECT_EQ("y", toString(destination));
+
+    // Fragments which are still in a buffer are released when it is destroyed.
+    buffer.addBufferFragment(fragment);
+  }
+  EXPECT_EQ(2U, releases);
+
+  // Empty fragments are released immediately.
+  BufferFragmentImpl empty(nullptr, 0, [&](const void*, size_t, const BufferFragmentImpl*) {
+    releases++;
+  });
+  OwnedImpl buffer;
+  buffer.addBufferFragment(empty);
+  EXPECT_EQ(3U, releases);
+  EXPECT_EQ(0U, buffer.length());
+}
+
+// Fragments are written without being copied into the buffer first.
+TEST_P(OwnedImplTest, WriteBufferFragment) {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+
+  const std::string data(3 * OwnedSlice::DEFAULT_SIZE, 'a');
+  bool released = false;
+  BufferFragmentImpl fragment(data.c_str(), data.size(),
+                              [&](const void*, size_t, const BufferFragmentImpl*) {
+                                released = true;
+                              });
+  OwnedImpl buffer("x");
+  buffer.addBufferFragment(fragment);
+  while (buffer.length() > 0) {
+    ASSERT_LT(0, buffer.write(fds[1]));
+  }
+  EXPECT_TRUE(released);
+  close(fds[1]);
+
+  OwnedImpl destination;
+  while (destination.read(fds[0], 16384) > 0) {
+  }
+  EXPECT_EQ("x" + data, toString(destination));
+  close(fds[0]);
+}
+
+TEST_P(OwnedImplTest, ReadWrite) {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  ASSERT_EQ(0, fcntl(fds[0], F_SETFL, O_NONBLOCK));
+
+  const std::string data(3 * OwnedSlice::DEFAULT_SIZE + 7, 'a');
+  OwnedImpl source(data);
+  OwnedImpl destination("x");
+  while (source.length() > 0) {
+    ASSERT_LT(0, source.write(fds[1]));
+  }
+
+  uint64_t total = 0;
+  while (total < data.size()) {
+    const int rc = destination.read(fds[0], 4096);
+    ASSERT_LT(0, rc);
+    ASSERT_GE(4096, rc);
+    total += rc;
+  }
+  EXPECT_EQ(-1, destination.read(fds[0], 4096));
+  EXPECT_EQ(EAGAIN, errno);
+  EXPECT_EQ("x" + data, toString(destination));
+
+  close(fds[1]);
+  EXPECT_EQ(0, destination.read(fds[0], 4096));
+  close(fds[0]);
+}
+
+TEST_P(OwnedImplTest, Account) {
+  auto account = std::make_shared<AccountImpl>();
+  std::unique_ptr<OwnedImpl> buffer(new OwnedImpl("0123456789"));
+  buffer->setAccount(account);
+  EXPECT_EQ(10, account->balance());
+
+  buffer->add("abc");
+  buffer->drain(4);
+  EXPECT_EQ(9, account->balance());
+
+  RawSlice iovecs[2];
+  const uint64_t num_iovecs = buffer->reserve(100, iovecs, 2);
+  EXPECT_EQ(9, account->balance());
+  iovecs[0].len_ = 5;
+  buffer->commit(iovecs, std::min<uint64_t>(num_iovecs, 1));
+  EXPECT_EQ(14, account->balance());
+
+  // Moves credit the source buffer and charge the destination.
+  auto other_account = std::make_shared<AccountImpl>();
+  OwnedImpl other;
+  other.setAccount(other_account);
+  other.move(*buffer, 4);
+  EXPECT_EQ(10, account->balance());
+  EXPECT_EQ(4, other_account->balance());
+  other.move(*buffer);
+  EXPECT_EQ(0, account->balance());
+  EXPECT_EQ(14, other_account->balance());
+
+  // Moving to a buffer without an account only credits.
+  buffer->move(other, 6);
+  EXPECT_EQ(6, account->balance());
+  OwnedImpl unaccounted;
+  unaccounted.move(*buffer);
+  EXPECT_EQ(0, account->balance());
+
+  // Changing the account moves the balance, and destruction credits what is left.
+  buffer->add("abcdef");
+  buffer->setAccount(other_account);
+  EXPECT_EQ(0, account->balance());
+  EXPECT_EQ(14, other_account->balance());
+  buffer.reset();
+  EXPECT_EQ(8, other_account->balance());
+  other.setAccount(nullptr);
+  EXPECT_EQ(0, other_account->balance());
+}
+
+} // namespace Buffer
+} // namespace Envoy
@@ -0,0 +1,149 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <algorithm>
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Buffer {
+
+// The second argument of each benchmark selects the libevent (1) or the native (0) buffer
+// implementation.
+
+// Append a fixed size chunk and then drain it, as done by codecs for small frames.
+static void BufferAddDrain(benchmark::State& state) {
+  OwnedImpl::useOldImpl(state.range(1));
+  const std::string data(state.range(0), 'a');
+  OwnedImpl buffer;
+  while (state.KeepRunning()) {
+    buffer.add(data);
+    buffer.drain(buffer.length());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BufferAddDrain)
+    ->Args({16, 1})
+    ->Args({16, 0})
+    ->Args({1024, 1})
+    ->Args({1024, 0})
+    ->Args({16384, 1})
+    ->Args({16384, 0});
+
+// Move the entire contents of one buffer into another, as done when proxying data between a
+// downstream and an upstream connection.
+static void BufferMove(benchmark::State& state) {
+  OwnedImpl::useOldImpl(state.range(1));
+  const std::string data(state.range(0), 'a');
+  OwnedImpl source;
+  OwnedImpl destination;
+  while (state.KeepRunning()) {
+    source.add(data);
+    destination.move(source);
+    destination.drain(destination.length());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BufferMove)
+    ->Args({16, 1})
+    ->Args({16, 0})
+    ->Args({1024, 1})
+    ->Args({1024, 0})
+    ->Args({16384, 1})
+    ->Args({16384, 0});
+
+// Move a partial length, which requires splitting the tail chunk.
+static void BufferMovePartial(benchmark::State& state) {
+  OwnedImpl::useOldImpl(state.range(1));
+  const std::string data(state.range(0), 'a');
+  OwnedImpl source;
+  OwnedImpl destination;
+  while (state.KeepRunning()) {
+    source.add(data);
+    destination.move(source, data.size() / 2);
+    source.drain(source.length());
+    destination.drain(destination.length());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0) / 2);
+}
+BENCHMARK(BufferMovePartial)
+    ->Args({16, 1})
+    ->Args({16, 0})
+    ->Args({1024, 1})
+    ->Args({1024, 0})
+    ->Args({16384, 1})
+    ->Args({16384, 0});
+
+// Incrementally drain a large buffer in small pieces, as done by parsers.
+static void BufferIncrementalDrain(benchmark::State& state) {
+  OwnedImpl::useOldImpl(state.range(1));
+  const std::string data(state.range(0), 'a');
+  const uint64_t step = 64;
+  OwnedImpl buffer;
+  while (state.KeepRunning()) {
+    buffer.add(data);
+    while (buffer.length() > 0) {
+      buffer.drain(std::min(step, buffer.length()));
+    }
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BufferIncrementalDrain)
+    ->Args({1024, 1})
+    ->Args({1024, 0})
+    ->Args({16384, 1})
+    ->Args({16384, 0})
+    ->Args({65536, 1})
+    ->Args({65536, 0});
+
+// Reserve/commit round trip, used by socket reads.
+static void BufferReserveCommit(benchmark::State& state) {
+  OwnedImpl::useOldImpl(state.range(1));
+  const uint64_t size = state.range(0);
+  OwnedImpl buffer;
+  while (state.KeepRunning()) {
+    RawSlice slices[2];
+    const uint64_t num_slices = buffer.reserve(size, slices, 2);
+    for (uint64_t i = 0; i < num_slices; i++) {
+      slices[i].len_ = std::min<uint64_t>(slices[i].len_, size);
+    }
+    buffer.commit(slices, num_slices);
+    buffer.drain(buffer.length());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BufferReserveCommit)
+    ->Args({1024, 1})
+    ->Args({1024, 0})
+    ->Args({16384, 1})
+    ->Args({16384, 0});
+
+// Linearize a buffer made up of many small chunks.
+static void BufferLinearize(benchmark::State& state) {
+  OwnedImpl::useOldImpl(state.range(1));
+  const std::string chunk(64, 'a');
+  const size_t num_chunks = state.range(0);
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    OwnedImpl buffer;
+    for (size_t i = 0; i < num_chunks; i++) {
+      OwnedImpl fragment(chunk);
+      buffer.move(fragment);
+    }
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(buffer.linearize(buffer.length()));
+  }
+}
+BENCHMARK(BufferLinearize)
+    ->Args({1, 1})
+    ->Args({1, 0})
+    ->Args({16, 1})
+    ->Args({16, 0})
+    ->Args({256, 1})
+    ->Args({256, 0});
+
+} // namespace Buffer
+} // namespace Envoy
@@ -62,6 +62,20 @@ TEST_F(WatermarkBufferTest, AddBuffer) {
   EXPECT_EQ(11, buffer_.length());
 }
 
+TEST_F(WatermarkBufferTest, AddBufferFragment) {
+  BufferFragmentImpl fragment(TEN_BYTES, 10, nullptr);
+  buffer_.addBufferFragment(fragment);
+  EXPECT_EQ(0, times_high_watermark_called_);
+  BufferFragmentImpl second("a", 1, nullptr);
+  buffer_.addBufferFragment(second);
+  EXPECT_EQ(1, times_high_watermark_called_);
+  EXPECT_EQ(11, buffer_.length());
+
+  // Release the fragments before they go out of scope.
+  buffer_.drain(11);
+  EXPECT_EQ(1, times_low_watermark_called_);
+}
+
 TEST_F(WatermarkBufferTest, Commit) {
   buffer_.add(TEN_BYTES, 10);
   EXPECT_EQ(0, times_high_watermark_called_);
@@ -1,4 +1,6 @@
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "common/buffer/buffer_impl.h"
 #include "common/common/base64.h"
@@ -108,4 +110,55 @@ TEST(Base64Test, BinaryBufferEncode) {
   EXPECT_EQ("AAECAwgKCQCqvA==", Base64::encode(buffer, 10));
   EXPECT_EQ("AAECAwgKCQCqvN4=", Base64::encode(buffer, 30));
 }
+TEST(Base64Test, MultiSlicesBufferDecode) {
+  const std::vector<std::string> slices{"Zm", "9vYm", "F", "yYm", "F6", "Zg=", "="};
+  // The fragments must outlive the buffer.
+  std::vector<std::unique_ptr<Buffer::BufferFragmentImpl>> fragments;
+  Buffer::OwnedImpl buffer;
+  for (const std::string& slice : slices) {
+    fragments.emplace_back(new Buffer::BufferFragmentImpl(slice.data(), slice.size(), nullptr));
+    buffer.addBufferFragment(*fragments.back());
+  }
+  EXPECT_EQ("foobarbazf", Base64::decode(buffer));
+  EXPECT_EQ(Base64::decode("Zm9vYmFyYmF6Zg=="), Base64::decode(buffer));
+}
+
+TEST(Base64Test, BufferDecodeFailure) {
+  {
+    Buffer::OwnedImpl buffer;
+    EXPECT_EQ("", Base64::decode(buffer));
+  }
+
+  for (const std::string input : {"Zm9vZm=8", "Zm9vZh==", "Zm9vZg..", "Zm==Zm9v", "Zm9vZm9"}) {
+    Buffer::OwnedImpl buffer(input);
+    EXPECT_EQ("", Base64::decode(buffer)) << input;
+  }
+}
+
+TEST(Base64Test, BufferRoundTrip) {
+  std::string input;
+  for (uint32_t i = 0; i < 1000; ++i) {
+    input.push_back(static_cast<char>(i * 7));
+  }
+
+  // Split the input at every position so that groups straddle slices in every possible way.
+  for (uint64_t split = 1; split <= 8; ++split) {
+    Buffer::BufferFragmentImpl first(input.data(), split, nullptr);
+    Buffer::BufferFragmentImpl second(input.data() + split, input.size() - split, nullptr);
+    Buffer::OwnedImpl buffer;
+    buffer.addBufferFragment(first);
+    buffer.addBufferFragment(second);
+
+    const std::string encoded = Base64::encode(buffer, buffer.length());
+    EXPECT_EQ(Base64::encode(input.data(), input.size()), encoded);
+
+    Buffer::BufferFragmentImpl encoded_first(encoded.data(), split, nullptr);
+    Buffer::BufferFragmentImpl encoded_second(encoded.data() + split, encoded.size() - split,
+                                              nullptr);
+    Buffer::OwnedImpl encoded_buffer;
+    encoded_buffer.addBufferFragment(encoded_first);
+    encoded_buffer.addBufferFragment(encoded_second);
+    EXPECT_EQ(input, Base64::decode(encoded_buffer));
+  }
+}
 } // namespace Envoy
@@ -0,0 +1,134 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/common/chunked_list.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+
+typedef ChunkedList<std::string, 2> TestList;
+
+static std::vector<std::string> forward(const TestList& list) {
+  return std::vector<std::string>(list.begin(), list.end());
+}
+
+static std::vector<std::string> reverse(const TestList& list) {
+  return std::vector<std::string>(list.rbegin(), list.rend());
+}
+
+TEST(ChunkedListTest, Empty) {
+  TestList list;
+  EXPECT_TRUE(list.empty());
+  EXPECT_EQ(0U, list.size());
+  EXPECT_TRUE(list.begin() == list.end());
+  EXPECT_TRUE(list.rbegin() == list.rend());
+}
+
+TEST(ChunkedListTest, EmplaceAndIterate) {
+  TestList list;
+  list.emplace_back("a");
+  list.emplace_back(1, 'b');
+  list.emplace_back("c");
+  EXPECT_FALSE(list.empty());
+  EXPECT_EQ(3U, list.size());
+  EXPECT_EQ((std::vector<std::string>{"a", "b", "c"}), forward(list));
+  EXPECT_EQ((std::vector<std::string>{"c", "b", "a"}), reverse(list));
+}
+
+// Elements never move, even when the list grows past a chunk.
+TEST(ChunkedListTest, StableAddresses) {
+  TestList list;
+  std::vector<const std::string*> elements;
+  for (size_t i = 0; i < 10; i++) {
+    elements.push_back(&list.emplace_back(std::to_string(i)));
+  }
+
+  size_t i = 0;
+  for (const std::string& element : list) {
+    EXPECT_EQ(elements[i], &element);
+    EXPECT_EQ(std::to_string(i), element);
+    i++;
+  }
+}
+
+TEST(ChunkedListTest, Erase) {
+  TestList list;
+  list.emplace_back("a");
+  const std::string& b = list.emplace_back("b");
+  list.emplace_back("c");
+  list.emplace_back("d");
+
+  list.erase(b);
+  EXPECT_EQ((std::vector<std::string>{"a", "c", "d"}), forward(list));
+
+  for (auto i = list.begin(); i != list.end();) {
+    if (*i != "c") {
+      i = list.erase(i);
+    } else {
+      ++i;
+    }
+  }
+  EXPECT_EQ((std::vector<std::string>{"c"}), forward(list));
+  EXPECT_EQ((std::vector<std::string>{"c"}), reverse(list));
+
+  list.erase(list.begin());
+  EXPECT_TRUE(list.empty());
+  EXPECT_TRUE(list.begin() == list.end());
+}
+
+// Slots of erased elements are reused rather than allocating new chunks.
+TEST(ChunkedListTest, ReuseErased) {
+  TestList list;
+  const std::string* a = &list.emplace_back("a");
+  list.emplace_back("b");
+  list.erase(*a);
+
+  EXPECT_EQ(a, &list.emplace_back("c"));
+  EXPECT_EQ((std::vector<std::string>{"b", "c"}), forward(list));
+}
+
+// Moving a list keeps its elements in place.
+TEST(ChunkedListTest, Move) {
+  TestList list;
+  const std::string* a = &list.emplace_back("a");
+  list.emplace_back("b");
+  list.emplace_back("c");
+
+  TestList moved(std::move(list));
+  EXPECT_TRUE(list.empty());
+  EXPECT_EQ(a, &*moved.begin());
+  EXPECT_EQ((std::vector<std::string>{"a", "b", "c"}), forward(moved));
+  EXPECT_EQ((std::vector<std::string>{"c", "b", "a"}), reverse(moved));
+
+  TestList assigned;
+  assigned.emplace_back("d");
+  assigned = std::move(moved);
+  EXPECT_TRUE(moved.empty());
+  EXPECT_EQ((std::vector<std::string>{"a", "b", "c"}), forward(assigned));
+  assigned.emplace_back("e");
+  EXPECT_EQ((std::vector<std::string>{"e", "c", "b", "a"}), reverse(assigned));
+
+  // Both moved from lists are still usable.
+  list.emplace_back("f");
+  moved.emplace_back("g");
+  EXPECT_EQ((std::vector<std::string>{"f"}), forward(list));
+  EXPECT_EQ((std::vector<std::string>{"g"}), forward(moved));
+}
+
+// Remaining elements are destroyed with the list.
+TEST(ChunkedListTest, DestroyElements) {
+  std::shared_ptr<int> value = std::make_shared<int>(1);
+  {
+    ChunkedList<std::shared_ptr<int>, 2> list;
+    list.emplace_back(value);
+    list.emplace_back(value);
+    list.emplace_back(value);
+    list.erase(list.begin());
+    EXPECT_EQ(3, value.use_count());
+  }
+  EXPECT_EQ(1, value.use_count());
+}
+
+} // namespace Envoy
@@ -1,3 +1,4 @@
+#include "common/buffer/buffer_impl.h"
 #include "common/common/hash.h"
 
 #include "gtest/gtest.h"
@@ -10,4 +11,12 @@ TEST(Hash, xxHash) {
   EXPECT_EQ(4400747396090729504U, HashUtil::xxHash64("lyft"));
   EXPECT_EQ(17241709254077376921U, HashUtil::xxHash64(""));
 }
+
+TEST(Hash, xxHashBuffer) {
+  Buffer::OwnedImpl buffer("foo\n");
+  Buffer::OwnedImpl bar("bar");
+  buffer.move(bar);
+  EXPECT_EQ(8917841378505826757U, HashUtil::xxHash64(buffer));
+  EXPECT_EQ(17241709254077376921U, HashUtil::xxHash64(Buffer::OwnedImpl()));
+}
 } // namespace Envoy
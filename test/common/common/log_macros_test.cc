@@ -1,5 +1,6 @@
 #include <iostream>
 #include <string>
+#include <thread>
 
 #include "common/common/logger.h"
 
@@ -9,6 +10,8 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::HasSubstr;
+
 namespace Envoy {
 
 class TestFilterLog : public Logger::Loggable<Logger::Id::filter> {
@@ -37,4 +40,40 @@ TEST(Logger, All) {
   // Misc logging with no facility.
   ENVOY_LOG_MISC(info, "fake message");
 }
+
+TEST(AsyncLogBuffer, PushAndDrain) {
+  Logger::AsyncLogBuffer buffer(2);
+  EXPECT_TRUE(buffer.push("a\n", 2));
+  EXPECT_TRUE(buffer.push("b\n", 2));
+  EXPECT_FALSE(buffer.push("c\n", 2));
+
+  std::string output;
+  buffer.drain(output);
+  EXPECT_EQ("a\nb\n", output);
+
+  EXPECT_TRUE(buffer.push("d\n", 2));
+  output.clear();
+  buffer.drain(output);
+  EXPECT_EQ("d\n", output);
+}
+
+// Lines logged by any thread are written by flush() once the sink is async.
+TEST(Logger, AsyncSink) {
+  spdlog::logger& logger = Logger::Registry::getLog(Logger::Id::misc);
+  const spdlog::level::level_enum level = logger.level();
+  logger.set_level(spdlog::level::info);
+  std::shared_ptr<Logger::LockingStderrOrFileSink> sink = Logger::Registry::getSink();
+  sink->startAsync();
+
+  testing::internal::CaptureStderr();
+  std::thread thread([]() -> void { ENVOY_LOG_MISC(info, "async message"); });
+  thread.join();
+  sink->flush();
+  const std::string output = testing::internal::GetCapturedStderr();
+
+  sink->stopAsync();
+  logger.set_level(level);
+  EXPECT_THAT(output, HasSubstr("async message"));
+  EXPECT_EQ(0U, sink->droppedLines());
+}
 } // namespace Envoy
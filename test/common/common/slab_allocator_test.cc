@@ -0,0 +1,75 @@
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "common/common/slab_allocator.h"
+#include "common/common/thread.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+
+TEST(SlabAllocatorTest, ReuseFreedBlocks) {
+  const size_t cached = SlabAllocator::cachedBlocks(200);
+  void* block = SlabAllocator::allocate(200);
+  SlabAllocator::deallocate(block, 200);
+  EXPECT_EQ(cached + 1, SlabAllocator::cachedBlocks(200));
+
+  // Any size in the same size class reuses the block.
+  EXPECT_EQ(block, SlabAllocator::allocate(193));
+  EXPECT_EQ(cached, SlabAllocator::cachedBlocks(200));
+  SlabAllocator::deallocate(block, 193);
+  void* other_block = SlabAllocator::allocate(100);
+  EXPECT_NE(block, other_block);
+  EXPECT_EQ(block, SlabAllocator::allocate(256));
+  SlabAllocator::deallocate(block, 256);
+  SlabAllocator::deallocate(other_block, 100);
+}
+
+TEST(SlabAllocatorTest, CacheLimit) {
+  std::vector<void*> blocks;
+  for (size_t i = 0; i < SlabAllocator::MAX_CACHED_BLOCKS_PER_CLASS * 2; i++) {
+    blocks.push_back(SlabAllocator::allocate(1000));
+  }
+  for (void* block : blocks) {
+    SlabAllocator::deallocate(block, 1000);
+  }
+  EXPECT_EQ(SlabAllocator::MAX_CACHED_BLOCKS_PER_CLASS, SlabAllocator::cachedBlocks(1000));
+}
+
+TEST(SlabAllocatorTest, LargeBlocks) {
+  void* block = SlabAllocator::allocate(SlabAllocator::MAX_BLOCK_SIZE + 1);
+  SlabAllocator::deallocate(block, SlabAllocator::MAX_BLOCK_SIZE + 1);
+  EXPECT_EQ(0U, SlabAllocator::cachedBlocks(SlabAllocator::MAX_BLOCK_SIZE + 1));
+}
+
+// Blocks freed on another thread are cached by that thread.
+TEST(SlabAllocatorTest, CrossThread) {
+  void* block = SlabAllocator::allocate(3000);
+  const size_t cached = SlabAllocator::cachedBlocks(3000);
+  Thread::Thread thread([block]() -> void {
+    SlabAllocator::deallocate(block, 3000);
+    EXPECT_EQ(1U, SlabAllocator::cachedBlocks(3000));
+  });
+  thread.join();
+  EXPECT_EQ(cached, SlabAllocator::cachedBlocks(3000));
+}
+
+class SlabAllocatedBase : public SlabAllocated {
+public:
+  virtual ~SlabAllocatedBase() {}
+};
+
+class SlabAllocatedDerived : public SlabAllocatedBase {
+public:
+  char data_[500];
+};
+
+TEST(SlabAllocatedTest, DeleteThroughBase) {
+  const size_t cached = SlabAllocator::cachedBlocks(sizeof(SlabAllocatedDerived));
+  std::unique_ptr<SlabAllocatedBase> object(new SlabAllocatedDerived());
+  object.reset();
+  EXPECT_EQ(cached + 1, SlabAllocator::cachedBlocks(sizeof(SlabAllocatedDerived)));
+}
+
+} // namespace Envoy
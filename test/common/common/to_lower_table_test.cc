@@ -26,5 +26,17 @@ TEST(ToLowerTableTest, All) {
     table.toLowerCase(input);
     EXPECT_EQ(input, "\x90hello\x90");
   }
+  {
+    // Every byte value, at every offset within the words converted at once.
+    std::string input;
+    std::string expected;
+    for (size_t i = 0; i < 256 * 9; i++) {
+      const char c = static_cast<char>(i % 256);
+      input.push_back(c);
+      expected.push_back(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+    }
+    table.toLowerCase(input);
+    EXPECT_EQ(expected, input);
+  }
 }
 } // namespace Envoy
@@ -188,4 +188,18 @@ TEST(StringUtil, toUpper) {
   EXPECT_EQ(StringUtil::toUpper("X asdf aAf"), "X ASDF AAF");
 }
 
+TEST(RegexUtil, literalPrefix) {
+  EXPECT_EQ(RegexUtil::literalPrefix(""), "");
+  EXPECT_EQ(RegexUtil::literalPrefix("/api/v1"), "/api/v1");
+  EXPECT_EQ(RegexUtil::literalPrefix("^/api/v[0-9]+/.*"), "/api/v");
+  EXPECT_EQ(RegexUtil::literalPrefix("/foo\\.bar/.*"), "/foo.bar/");
+  EXPECT_EQ(RegexUtil::literalPrefix("/users/\\d+"), "/users/");
+  EXPECT_EQ(RegexUtil::literalPrefix("/items?"), "/item");
+  EXPECT_EQ(RegexUtil::literalPrefix("/a{2}"), "/");
+  EXPECT_EQ(RegexUtil::literalPrefix("/(a|b)/c"), "/");
+  EXPECT_EQ(RegexUtil::literalPrefix("/a/[|]"), "/a/");
+  EXPECT_EQ(RegexUtil::literalPrefix("/a|/b"), "");
+  EXPECT_EQ(RegexUtil::literalPrefix(".*/foo"), "");
+}
+
 } // namespace Envoy
@@ -281,6 +281,65 @@ TEST_F(ZlibCompressorImplTest, CompressWithNotCommonParams) {
   EXPECT_EQ("0000ffff", footer_hex_str.substr(footer_hex_str.size() - 8, 10));
 }
 
+/**
+ * Exercises finishing a gzip stream, and then reusing the compressor for another stream after a
+ * reset.
+ */
+TEST_F(ZlibCompressorImplTest, FinishAndReset) {
+  Buffer::OwnedImpl input_buffer;
+  Buffer::OwnedImpl output_buffer;
+
+  ZlibCompressorImpl compressor;
+  compressor.init(ZlibCompressorImpl::CompressionLevel::Standard,
+                  ZlibCompressorImpl::CompressionStrategy::Standard, gzip_window_bits,
+                  memory_level);
+
+  TestUtility::feedBufferWithRandomCharacters(input_buffer, default_input_size);
+  compressor.compress(input_buffer, output_buffer);
+  compressor.finish(output_buffer);
+  const std::string first_stream = TestUtility::bufferToString(output_buffer);
+
+  const std::string header_hex_str = Hex::encode(
+      reinterpret_cast<const unsigned char*>(first_stream.data()), first_stream.size());
+  // HEADER 0x1f = 31 (window_bits)
+  EXPECT_EQ("1f8b", header_hex_str.substr(0, 4));
+  // FOOTER ISIZE, the little endian input size (796 = 0x031c)
+  EXPECT_EQ("1c030000", header_hex_str.substr(header_hex_str.size() - 8));
+
+  // Finishing again outputs nothing.
+  output_buffer.drain(output_buffer.length());
+  compressor.finish(output_buffer);
+  EXPECT_EQ(0, output_buffer.length());
+
+  // A reset compressor writes the same stream for the same input.
+  compressor.reset();
+  compressor.compress(input_buffer, output_buffer);
+  compressor.finish(output_buffer);
+  EXPECT_EQ(first_stream, TestUtility::bufferToString(output_buffer));
+}
+
+/**
+ * Exercises finishing a stream whose compressed output is larger than the output chunk.
+ */
+TEST_F(ZlibCompressorImplTest, FinishWithSmallOutputChunk) {
+  Buffer::OwnedImpl input_buffer;
+  Buffer::OwnedImpl output_buffer;
+
+  ZlibCompressorImpl compressor(16);
+  compressor.init(ZlibCompressorImpl::CompressionLevel::Standard,
+                  ZlibCompressorImpl::CompressionStrategy::Standard, gzip_window_bits,
+                  memory_level);
+
+  TestUtility::feedBufferWithRandomCharacters(input_buffer, default_input_size);
+  compressor.compress(input_buffer, output_buffer);
+  compressor.finish(output_buffer);
+
+  const std::string output = TestUtility::bufferToString(output_buffer);
+  const std::string footer_hex_str = Hex::encode(
+      reinterpret_cast<const unsigned char*>(output.data()) + output.size() - 4, 4);
+  EXPECT_EQ("1c030000", footer_hex_str);
+}
+
 } // namespace
 } // namespace Compressor
 } // namespace Envoy
@@ -0,0 +1,88 @@
+#include <cstdio>
+#include <memory>
+
+#include "common/config/cached_subscription_impl.h"
+#include "common/filesystem/filesystem_impl.h"
+
+#include "test/mocks/config/mocks.h"
+#include "test/test_common/environment.h"
+
+#include "api/eds.pb.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::SaveArg;
+using testing::Throw;
+using testing::_;
+
+namespace Envoy {
+namespace Config {
+namespace {
+
+typedef Protobuf::RepeatedPtrField<envoy::api::v2::ClusterLoadAssignment> ResourceVector;
+
+class CachedSubscriptionImplTest : public testing::Test {
+public:
+  CachedSubscriptionImplTest() : path_(TestEnvironment::temporaryPath("cached_subscription.pb")) {
+    std::remove(path_.c_str());
+  }
+
+  // Create a cached subscription, and start it with the cache already applied, if any.
+  void startSubscription() {
+    auto* subscription = new MockSubscription<envoy::api::v2::ClusterLoadAssignment>();
+    EXPECT_CALL(*subscription, start(_, _)).WillOnce(SaveArg<1>(&subscription_callbacks_));
+    cached_subscription_.reset(new CachedSubscriptionImpl<envoy::api::v2::ClusterLoadAssignment>(
+        std::unique_ptr<Subscription<envoy::api::v2::ClusterLoadAssignment>>(subscription),
+        path_));
+    cached_subscription_->start({"cluster0"}, callbacks_);
+  }
+
+  ResourceVector resources(const std::string& cluster_name) {
+    ResourceVector resources;
+    resources.Add()->set_cluster_name(cluster_name);
+    return resources;
+  }
+
+  const std::string path_;
+  MockSubscriptionCallbacks<envoy::api::v2::ClusterLoadAssignment> callbacks_;
+  SubscriptionCallbacks<envoy::api::v2::ClusterLoadAssignment>* subscription_callbacks_{};
+  std::unique_ptr<CachedSubscriptionImpl<envoy::api::v2::ClusterLoadAssignment>>
+      cached_subscription_;
+};
+
+// Validate that the last accepted update is applied when the next subscription starts.
+TEST_F(CachedSubscriptionImplTest, ApplyCachedUpdate) {
+  EXPECT_CALL(callbacks_, onConfigUpdate(_)).Times(0);
+  startSubscription();
+  EXPECT_FALSE(Filesystem::fileExists(path_));
+
+  ResourceVector received;
+  EXPECT_CALL(callbacks_, onConfigUpdate(_)).WillOnce(SaveArg<0>(&received));
+  subscription_callbacks_->onConfigUpdate(resources("cluster0"));
+  EXPECT_EQ("cluster0", received[0].cluster_name());
+  EXPECT_TRUE(Filesystem::fileExists(path_));
+
+  // A rejected update is not cached.
+  EXPECT_CALL(callbacks_, onConfigUpdate(_)).WillOnce(Throw(EnvoyException("bad config")));
+  EXPECT_THROW(subscription_callbacks_->onConfigUpdate(resources("cluster1")), EnvoyException);
+
+  received.Clear();
+  EXPECT_CALL(callbacks_, onConfigUpdate(_)).WillOnce(SaveArg<0>(&received));
+  startSubscription();
+  ASSERT_EQ(1, received.size());
+  EXPECT_EQ("cluster0", received[0].cluster_name());
+}
+
+// Validate that a rejected cached update still lets the subscription start.
+TEST_F(CachedSubscriptionImplTest, RejectedCachedUpdate) {
+  TestEnvironment::writeStringToFileForTest("cached_subscription.pb", "not a proto");
+  startSubscription();
+  EXPECT_NE(nullptr, subscription_callbacks_);
+
+  EXPECT_CALL(callbacks_, onConfigUpdateFailed(nullptr));
+  subscription_callbacks_->onConfigUpdateFailed(nullptr);
+}
+
+} // namespace
+} // namespace Config
+} // namespace Envoy
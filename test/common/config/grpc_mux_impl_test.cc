@@ -17,6 +17,7 @@ using testing::Invoke;
 using testing::IsSubstring;
 using testing::NiceMock;
 using testing::Return;
+using testing::Throw;
 using testing::_;
 
 namespace Envoy {
@@ -135,6 +136,24 @@ TEST_F(GrpcMuxImplTest, PauseResume) {
   grpc_mux_->pause("foo");
 }
 
+// Validate that pauses nest.
+TEST_F(GrpcMuxImplTest, NestedPauseResume) {
+  InSequence s;
+  auto foo_sub = grpc_mux_->subscribe("foo", {"x"}, callbacks_);
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  expectSendMessage("foo", {"x"}, "");
+  grpc_mux_->start();
+
+  grpc_mux_->pause("foo");
+  grpc_mux_->pause("foo");
+  auto foo_y_sub = grpc_mux_->subscribe("foo", {"y"}, callbacks_);
+  grpc_mux_->resume("foo");
+  auto foo_z_sub = grpc_mux_->subscribe("foo", {"z"}, callbacks_);
+  expectSendMessage("foo", {"z", "y", "x"}, "");
+  grpc_mux_->resume("foo");
+  grpc_mux_->pause("foo");
+}
+
 // Validate behavior when type URL mismatches occur.
 TEST_F(GrpcMuxImplTest, TypeUrlMismatch) {
   InSequence s;
@@ -280,6 +299,81 @@ TEST_F(GrpcMuxImplTest, WatchDemux) {
   expectSendMessage(type_url, {}, "2");
 }
 
+// Validate that incremental responses only update the watches on the resources they carry.
+TEST_F(GrpcMuxImplTest, IncrementalWatchDemux) {
+  InSequence s;
+  const std::string& type_url = Config::TypeUrl::get().ClusterLoadAssignment;
+  MockGrpcMuxCallbacks foo_callbacks;
+  auto foo_sub = grpc_mux_->subscribe(type_url, {"x", "y"}, foo_callbacks);
+  MockGrpcMuxCallbacks bar_callbacks;
+  auto bar_sub = grpc_mux_->subscribe(type_url, {"z", "w"}, bar_callbacks);
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  expectSendMessage(type_url, {"z", "w", "x", "y"}, "");
+  grpc_mux_->start();
+
+  Http::TestHeaderMapImpl request_headers;
+  grpc_mux_->onCreateInitialMetadata(request_headers);
+  EXPECT_EQ("true", request_headers.get_("x-envoy-incremental-xds"));
+  grpc_mux_->onReceiveInitialMetadata(
+      Http::HeaderMapPtr{new Http::TestHeaderMapImpl{{"x-envoy-incremental-xds", "true"}}});
+
+  auto response_with = [&type_url](const std::string& version,
+                                   const std::vector<std::pair<std::string, uint32_t>>& resources) {
+    std::unique_ptr<envoy::api::v2::DiscoveryResponse> response(
+        new envoy::api::v2::DiscoveryResponse());
+    response->set_type_url(type_url);
+    response->set_version_info(version);
+    for (const auto& resource : resources) {
+      envoy::api::v2::ClusterLoadAssignment load_assignment;
+      load_assignment.set_cluster_name(resource.first);
+      for (uint32_t i = 0; i < resource.second; i++) {
+        load_assignment.add_endpoints();
+      }
+      response->add_resources()->PackFrom(load_assignment);
+    }
+    return response;
+  };
+  // Expects an update with the given resources, identified by name and number of endpoints.
+  auto expect_update = [](MockGrpcMuxCallbacks& callbacks, const std::string& version,
+                          const std::vector<std::pair<std::string, uint32_t>>& expected) {
+    EXPECT_CALL(callbacks, onConfigUpdate(_, version))
+        .WillOnce(Invoke([expected](const Protobuf::RepeatedPtrField<ProtobufWkt::Any>& resources,
+                                    const std::string&) {
+          ASSERT_EQ(static_cast<int>(expected.size()), resources.size());
+          for (int i = 0; i < resources.size(); i++) {
+            envoy::api::v2::ClusterLoadAssignment load_assignment;
+            resources[i].UnpackTo(&load_assignment);
+            EXPECT_EQ(expected[i].first, load_assignment.cluster_name());
+            EXPECT_EQ(static_cast<int>(expected[i].second), load_assignment.endpoints_size());
+          }
+        }));
+  };
+
+  expect_update(bar_callbacks, "1", {{"z", 1}, {"w", 1}});
+  expect_update(foo_callbacks, "1", {{"x", 1}, {"y", 1}});
+  expectSendMessage(type_url, {"z", "w", "x", "y"}, "1");
+  grpc_mux_->onReceiveMessage(response_with("1", {{"x", 1}, {"y", 1}, {"z", 1}, {"w", 1}}));
+
+  // Only foo is updated, with the cached version of x.
+  expect_update(foo_callbacks, "2", {{"x", 1}, {"y", 2}});
+  expectSendMessage(type_url, {"z", "w", "x", "y"}, "2");
+  grpc_mux_->onReceiveMessage(response_with("2", {{"y", 2}}));
+
+  // A rejected update of z is not kept.
+  EXPECT_CALL(bar_callbacks, onConfigUpdate(_, "3")).WillOnce(Throw(EnvoyException("bad z")));
+  EXPECT_CALL(bar_callbacks, onConfigUpdateFailed(_));
+  EXPECT_CALL(foo_callbacks, onConfigUpdateFailed(_));
+  expectSendMessage(type_url, {"z", "w", "x", "y"}, "2");
+  grpc_mux_->onReceiveMessage(response_with("3", {{"z", 3}}));
+
+  expect_update(bar_callbacks, "4", {{"z", 1}, {"w", 4}});
+  expectSendMessage(type_url, {"z", "w", "x", "y"}, "4");
+  grpc_mux_->onReceiveMessage(response_with("4", {{"w", 4}}));
+
+  expectSendMessage(type_url, {"x", "y"}, "4");
+  expectSendMessage(type_url, {}, "4");
+}
+
 } // namespace
 } // namespace Config
 } // namespace Envoy
@@ -66,8 +66,8 @@ public:
     last_cluster_names_ = cluster_names;
     expectSendMessage(last_cluster_names_, "");
     subscription_->start(cluster_names, callbacks_);
-    // These are just there to add coverage to the null implementations of these
-    // callbacks.
+    // The management server doesn't accept the incremental protocol, so the stream stays state of
+    // the world.
     Http::HeaderMapPtr response_headers{new Http::TestHeaderMapImpl{}};
     subscription_->grpcMux().onReceiveInitialMetadata(std::move(response_headers));
     Http::TestHeaderMapImpl request_headers;
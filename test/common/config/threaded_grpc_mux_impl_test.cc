@@ -0,0 +1,186 @@
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "common/common/thread.h"
+#include "common/config/threaded_grpc_mux_impl.h"
+#include "common/event/dispatcher_impl.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/config/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Throw;
+using testing::_;
+
+namespace Envoy {
+namespace Config {
+namespace {
+
+class TestWatch : public GrpcMuxWatch {
+public:
+  TestWatch(ReadyWatcher& deleted) : deleted_(deleted) {}
+  ~TestWatch() { deleted_.ready(); }
+
+private:
+  ReadyWatcher& deleted_;
+};
+
+class ThreadedGrpcMuxImplTest : public testing::Test {
+public:
+  ThreadedGrpcMuxImplTest() {
+    mux_thread_.reset(new Thread::Thread([this]() -> void {
+      mux_dispatcher_.run(Event::Dispatcher::RunType::RunUntilExit);
+    }));
+    threaded_mux_.reset(
+        new ThreadedGrpcMuxImpl(main_dispatcher_, mux_dispatcher_, [this]() -> GrpcMuxPtr {
+          mux_ = new NiceMock<MockGrpcMux>();
+          return GrpcMuxPtr{mux_};
+        }));
+    runOnMuxThread([]() -> void {});
+    resources_.Add()->set_type_url("foo");
+  }
+
+  ~ThreadedGrpcMuxImplTest() {
+    threaded_mux_.reset();
+    mux_dispatcher_.post([this]() -> void { mux_dispatcher_.exit(); });
+    mux_thread_->join();
+  }
+
+  // Run a function on the mux thread after what was posted there before, running the main
+  // dispatcher until it is done.
+  void runOnMuxThread(std::function<void()> function) {
+    std::atomic<bool> done{false};
+    mux_dispatcher_.post([function, &done]() -> void {
+      function();
+      done = true;
+    });
+    while (!done) {
+      main_dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+    }
+  }
+
+  GrpcMuxWatchPtr subscribe() {
+    EXPECT_CALL(*mux_, subscribe_("foo", std::vector<std::string>({"x"}), _))
+        .WillOnce(Invoke([this](const std::string&, const std::vector<std::string>&,
+                                GrpcMuxCallbacks& callbacks) -> GrpcMuxWatch* {
+          mux_callbacks_ = &callbacks;
+          return new TestWatch(watch_deleted_);
+        }));
+    GrpcMuxWatchPtr watch = threaded_mux_->subscribe("foo", {"x"}, callbacks_);
+    runOnMuxThread([]() -> void {});
+    return watch;
+  }
+
+  Event::DispatcherImpl main_dispatcher_;
+  Event::DispatcherImpl mux_dispatcher_;
+  Thread::ThreadPtr mux_thread_;
+  NiceMock<MockGrpcMux>* mux_{};
+  std::unique_ptr<ThreadedGrpcMuxImpl> threaded_mux_;
+  MockGrpcMuxCallbacks callbacks_;
+  GrpcMuxCallbacks* mux_callbacks_{};
+  ReadyWatcher watch_deleted_;
+  Protobuf::RepeatedPtrField<ProtobufWkt::Any> resources_;
+};
+
+// Starting, pauses and resumes are posted to the wrapped mux, in order.
+TEST_F(ThreadedGrpcMuxImplTest, Forwarding) {
+  testing::InSequence s;
+  EXPECT_CALL(*mux_, start());
+  EXPECT_CALL(*mux_, pause("foo"));
+  EXPECT_CALL(*mux_, resume("foo"));
+  threaded_mux_->start();
+  threaded_mux_->pause("foo");
+  threaded_mux_->resume("foo");
+  runOnMuxThread([]() -> void {});
+}
+
+// Updates are applied on the main thread while the mux thread waits, and rejections are thrown
+// back to the wrapped mux.
+TEST_F(ThreadedGrpcMuxImplTest, ConfigUpdate) {
+  GrpcMuxWatchPtr watch = subscribe();
+  const Thread::ThreadId main_thread_id = Thread::Thread::currentThreadId();
+
+  EXPECT_CALL(callbacks_, onConfigUpdate(RepeatedProtoEq(resources_), "1"))
+      .WillOnce(Invoke([main_thread_id](const Protobuf::RepeatedPtrField<ProtobufWkt::Any>&,
+                                        const std::string&) -> void {
+        EXPECT_EQ(main_thread_id, Thread::Thread::currentThreadId());
+      }));
+  runOnMuxThread([this]() -> void { mux_callbacks_->onConfigUpdate(resources_, "1"); });
+
+  EXPECT_CALL(callbacks_, onConfigUpdate(_, "2")).WillOnce(Throw(EnvoyException("bad config")));
+  runOnMuxThread([this]() -> void {
+    EXPECT_THROW_WITH_MESSAGE(mux_callbacks_->onConfigUpdate(resources_, "2"), EnvoyException,
+                              "bad config");
+  });
+
+  EXPECT_CALL(watch_deleted_, ready());
+  watch.reset();
+  runOnMuxThread([]() -> void {});
+}
+
+TEST_F(ThreadedGrpcMuxImplTest, ConfigUpdateFailed) {
+  GrpcMuxWatchPtr watch = subscribe();
+
+  EXPECT_CALL(callbacks_, onConfigUpdateFailed(nullptr));
+  runOnMuxThread([this]() -> void { mux_callbacks_->onConfigUpdateFailed(nullptr); });
+  main_dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+
+  EXPECT_CALL(callbacks_, onConfigUpdateFailed(_))
+      .WillOnce(
+          Invoke([](const EnvoyException* e) -> void { EXPECT_STREQ("failed", e->what()); }));
+  runOnMuxThread([this]() -> void {
+    EnvoyException e("failed");
+    mux_callbacks_->onConfigUpdateFailed(&e);
+  });
+  main_dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+
+  EXPECT_CALL(watch_deleted_, ready());
+}
+
+// The callbacks of a deleted watch are not called.
+TEST_F(ThreadedGrpcMuxImplTest, DeletedWatch) {
+  GrpcMuxWatchPtr watch = subscribe();
+  EXPECT_CALL(callbacks_, onConfigUpdate(_, _)).Times(0);
+  EXPECT_CALL(callbacks_, onConfigUpdateFailed(_)).Times(0);
+
+  std::atomic<bool> failed{false};
+  mux_dispatcher_.post([this, &failed]() -> void {
+    mux_callbacks_->onConfigUpdateFailed(nullptr);
+    failed = true;
+    mux_callbacks_->onConfigUpdate(resources_, "1");
+  });
+  while (!failed) {
+  }
+  // Deleted while the failure, and possibly the update, are queued for the main thread. The watch
+  // of the wrapped mux is deleted on its thread, after the update.
+  EXPECT_CALL(watch_deleted_, ready());
+  watch.reset();
+  runOnMuxThread([]() -> void {});
+}
+
+// Deleting the mux stops the mux thread waiting for an update which the main thread did not apply.
+TEST_F(ThreadedGrpcMuxImplTest, DeletedMux) {
+  GrpcMuxWatchPtr watch = subscribe();
+  EXPECT_CALL(callbacks_, onConfigUpdate(_, _)).Times(0);
+
+  std::atomic<bool> done{false};
+  mux_dispatcher_.post([this, &done]() -> void {
+    mux_callbacks_->onConfigUpdate(resources_, "1");
+    done = true;
+  });
+  EXPECT_CALL(watch_deleted_, ready());
+  threaded_mux_.reset();
+  while (!done) {
+  }
+  main_dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+}
+
+} // namespace
+} // namespace Config
+} // namespace Envoy
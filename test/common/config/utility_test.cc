@@ -1,3 +1,4 @@
+#include "common/buffer/buffer_impl.h"
 #include "common/config/cds_json.h"
 #include "common/config/lds_json.h"
 #include "common/config/rds_json.h"
@@ -41,6 +42,7 @@ TEST(UtilityTest, GetTypedResources) {
 TEST(UtilityTest, ComputeHashedVersion) {
   EXPECT_EQ("hash_2e1472b57af294d1", Utility::computeHashedVersion("{}").first);
   EXPECT_EQ("hash_33bf00a859c4ba3f", Utility::computeHashedVersion("foo").first);
+  EXPECT_EQ("hash_33bf00a859c4ba3f", Utility::computeHashedVersion(Buffer::OwnedImpl("foo")).first);
 }
 
 TEST(UtilityTest, ApiConfigSourceRefreshDelay) {
@@ -0,0 +1,92 @@
+#include "common/buffer/buffer_impl.h"
+#include "common/compressor/brotli_compressor_impl.h"
+#include "common/decompressor/brotli_decompressor_impl.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Decompressor {
+namespace {
+
+class BrotliDecompressorImplTest : public testing::Test {
+protected:
+  static const uint32_t quality{4};
+  static const uint32_t window_bits{22};
+};
+
+/**
+ * Exercises compression and decompression by compressing some data in several flushed parts,
+ * decompressing it in small chunks and then comparing compressor's input with decompressor's
+ * output.
+ */
+TEST_F(BrotliDecompressorImplTest, CompressAndDecompress) {
+  Buffer::OwnedImpl buffer;
+  Buffer::OwnedImpl original_text;
+  Buffer::OwnedImpl compressed;
+
+  Compressor::BrotliCompressorImpl compressor;
+  compressor.init(quality, window_bits);
+  for (uint64_t i = 0; i < 20; ++i) {
+    TestUtility::feedBufferWithRandomCharacters(buffer, 1024, i);
+    original_text.add(buffer);
+    compressor.compress(buffer, compressed);
+    buffer.drain(buffer.length());
+    if (i % 5 == 0) {
+      compressor.flush(compressed);
+    }
+  }
+  compressor.finish(compressed);
+
+  BrotliDecompressorImpl decompressor(64);
+  Buffer::OwnedImpl decompressed;
+  const std::string compressed_str = TestUtility::bufferToString(compressed);
+  for (size_t i = 0; i < compressed_str.size(); i += 100) {
+    Buffer::OwnedImpl chunk(compressed_str.substr(i, 100));
+    decompressor.decompress(chunk, decompressed);
+    EXPECT_FALSE(decompressor.failed());
+  }
+  EXPECT_TRUE(decompressor.finished());
+  EXPECT_EQ(TestUtility::bufferToString(original_text), TestUtility::bufferToString(decompressed));
+}
+
+/**
+ * Exercises a compressor which is reset after finishing a stream, as the compression filter does
+ * when it reuses one for another response.
+ */
+TEST_F(BrotliDecompressorImplTest, CompressorReset) {
+  Compressor::BrotliCompressorImpl compressor;
+  compressor.init(quality, window_bits);
+  for (const std::string body : {std::string(1000, 'a'), std::string(2000, 'b')}) {
+    Buffer::OwnedImpl input(body);
+    Buffer::OwnedImpl compressed;
+    compressor.compress(input, compressed);
+    compressor.finish(compressed);
+    EXPECT_GT(body.size(), compressed.length());
+
+    BrotliDecompressorImpl decompressor;
+    Buffer::OwnedImpl decompressed;
+    decompressor.decompress(compressed, decompressed);
+    EXPECT_TRUE(decompressor.finished());
+    EXPECT_EQ(body, TestUtility::bufferToString(decompressed));
+    compressor.reset();
+  }
+}
+
+/**
+ * Exercises decompression of data which is not a Brotli stream, its first byte encoding a reserved
+ * window size.
+ */
+TEST_F(BrotliDecompressorImplTest, CorruptInput) {
+  BrotliDecompressorImpl decompressor;
+  Buffer::OwnedImpl input(std::string(100, '\x11'));
+  Buffer::OwnedImpl output;
+  decompressor.decompress(input, output);
+  EXPECT_TRUE(decompressor.failed());
+  EXPECT_FALSE(decompressor.finished());
+}
+
+} // namespace
+} // namespace Decompressor
+} // namespace Envoy
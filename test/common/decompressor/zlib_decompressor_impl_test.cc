@@ -177,6 +177,84 @@ TEST_F(ZlibDecompressorImplTest, CompressDecompressWithUncommonParams) {
   EXPECT_EQ(original_text, decompressed_text);
 }
 
+/**
+ * Exercises decompression of a finished stream, which ends with a gzip trailer.
+ */
+TEST_F(ZlibDecompressorImplTest, DecompressFinishedStream) {
+  Buffer::OwnedImpl input_buffer;
+  Buffer::OwnedImpl output_buffer;
+
+  Envoy::Compressor::ZlibCompressorImpl compressor;
+  compressor.init(Envoy::Compressor::ZlibCompressorImpl::CompressionLevel::Standard,
+                  Envoy::Compressor::ZlibCompressorImpl::CompressionStrategy::Standard,
+                  gzip_window_bits, memory_level);
+
+  TestUtility::feedBufferWithRandomCharacters(input_buffer, default_input_size);
+  const std::string original_text{TestUtility::bufferToString(input_buffer)};
+  compressor.compress(input_buffer, output_buffer);
+  compressor.finish(output_buffer);
+  input_buffer.drain(default_input_size);
+
+  ZlibDecompressorImpl decompressor;
+  decompressor.init(gzip_window_bits);
+  decompressor.decompress(output_buffer, input_buffer);
+
+  ASSERT_EQ(compressor.checksum(), decompressor.checksum());
+  EXPECT_EQ(original_text, TestUtility::bufferToString(input_buffer));
+  EXPECT_TRUE(decompressor.finished());
+  EXPECT_FALSE(decompressor.failed());
+
+  // Input after the end of the stream is ignored.
+  Buffer::OwnedImpl trailing_input("trailing");
+  decompressor.decompress(trailing_input, input_buffer);
+  EXPECT_EQ(original_text, TestUtility::bufferToString(input_buffer));
+}
+
+/**
+ * Exercises decompression of a stream which is fed to the decompressor a few bytes at a time.
+ */
+TEST_F(ZlibDecompressorImplTest, DecompressInPieces) {
+  Buffer::OwnedImpl input_buffer;
+  Buffer::OwnedImpl output_buffer;
+
+  Envoy::Compressor::ZlibCompressorImpl compressor;
+  compressor.init(Envoy::Compressor::ZlibCompressorImpl::CompressionLevel::Standard,
+                  Envoy::Compressor::ZlibCompressorImpl::CompressionStrategy::Standard, 15,
+                  memory_level);
+
+  TestUtility::feedBufferWithRandomCharacters(input_buffer, default_input_size * 10);
+  const std::string original_text{TestUtility::bufferToString(input_buffer)};
+  compressor.compress(input_buffer, output_buffer);
+  compressor.finish(output_buffer);
+  input_buffer.drain(input_buffer.length());
+
+  ZlibDecompressorImpl decompressor(64);
+  decompressor.init(15);
+  const std::string compressed{TestUtility::bufferToString(output_buffer)};
+  for (size_t i = 0; i < compressed.size(); i += 7) {
+    Buffer::OwnedImpl piece(compressed.substr(i, 7));
+    decompressor.decompress(piece, input_buffer);
+  }
+
+  EXPECT_TRUE(decompressor.finished());
+  EXPECT_EQ(original_text, TestUtility::bufferToString(input_buffer));
+}
+
+/**
+ * Exercises decompression of input which isn't a compressed stream.
+ */
+TEST_F(ZlibDecompressorImplTest, DecompressInvalidInput) {
+  Buffer::OwnedImpl input_buffer("this is not a gzip stream");
+  Buffer::OwnedImpl output_buffer;
+
+  ZlibDecompressorImpl decompressor;
+  decompressor.init(gzip_window_bits);
+  decompressor.decompress(input_buffer, output_buffer);
+  EXPECT_TRUE(decompressor.failed());
+  EXPECT_FALSE(decompressor.finished());
+  EXPECT_EQ(0, output_buffer.length());
+}
+
 } // namespace
 } // namespace Decompressor
 } // namespace Envoy
@@ -0,0 +1,90 @@
+#include "common/buffer/buffer_impl.h"
+#include "common/compressor/zstd_compressor_impl.h"
+#include "common/decompressor/zstd_decompressor_impl.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Decompressor {
+namespace {
+
+class ZstdDecompressorImplTest : public testing::Test {
+protected:
+  static const int32_t level{3};
+};
+
+/**
+ * Exercises compression and decompression by compressing some data in several flushed parts,
+ * decompressing it in small chunks and then comparing compressor's input with decompressor's
+ * output.
+ */
+TEST_F(ZstdDecompressorImplTest, CompressAndDecompress) {
+  Buffer::OwnedImpl buffer;
+  Buffer::OwnedImpl original_text;
+  Buffer::OwnedImpl compressed;
+
+  Compressor::ZstdCompressorImpl compressor;
+  compressor.init(level);
+  for (uint64_t i = 0; i < 20; ++i) {
+    TestUtility::feedBufferWithRandomCharacters(buffer, 1024, i);
+    original_text.add(buffer);
+    compressor.compress(buffer, compressed);
+    buffer.drain(buffer.length());
+    if (i % 5 == 0) {
+      compressor.flush(compressed);
+    }
+  }
+  compressor.finish(compressed);
+
+  ZstdDecompressorImpl decompressor(64);
+  Buffer::OwnedImpl decompressed;
+  const std::string compressed_str = TestUtility::bufferToString(compressed);
+  for (size_t i = 0; i < compressed_str.size(); i += 100) {
+    Buffer::OwnedImpl chunk(compressed_str.substr(i, 100));
+    decompressor.decompress(chunk, decompressed);
+    EXPECT_FALSE(decompressor.failed());
+  }
+  EXPECT_TRUE(decompressor.finished());
+  EXPECT_EQ(TestUtility::bufferToString(original_text), TestUtility::bufferToString(decompressed));
+}
+
+/**
+ * Exercises a compressor which is reset after finishing a stream, as the compression filter does
+ * when it reuses one for another response.
+ */
+TEST_F(ZstdDecompressorImplTest, CompressorReset) {
+  Compressor::ZstdCompressorImpl compressor;
+  compressor.init(level);
+  for (const std::string body : {std::string(1000, 'a'), std::string(2000, 'b')}) {
+    Buffer::OwnedImpl input(body);
+    Buffer::OwnedImpl compressed;
+    compressor.compress(input, compressed);
+    compressor.finish(compressed);
+    EXPECT_GT(body.size(), compressed.length());
+
+    ZstdDecompressorImpl decompressor;
+    Buffer::OwnedImpl decompressed;
+    decompressor.decompress(compressed, decompressed);
+    EXPECT_TRUE(decompressor.finished());
+    EXPECT_EQ(body, TestUtility::bufferToString(decompressed));
+    compressor.reset();
+  }
+}
+
+/**
+ * Exercises decompression of data which is not a zstd stream.
+ */
+TEST_F(ZstdDecompressorImplTest, CorruptInput) {
+  ZstdDecompressorImpl decompressor;
+  Buffer::OwnedImpl input(std::string(100, '\xff'));
+  Buffer::OwnedImpl output;
+  decompressor.decompress(input, output);
+  EXPECT_TRUE(decompressor.failed());
+  EXPECT_FALSE(decompressor.finished());
+}
+
+} // namespace
+} // namespace Decompressor
+} // namespace Envoy
@@ -51,8 +51,7 @@ TEST_F(DynamoFilterTest, operatorPresent) {
 
   Http::TestHeaderMapImpl request_headers{{"x-amz-target", "version.Get"}, {"random", "random"}};
 
-  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
-            filter_->decodeHeaders(request_headers, true));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, true));
   Http::TestHeaderMapImpl response_headers{{":status", "200"}};
   EXPECT_CALL(stats_, counter("prefix.dynamodb.operation_missing")).Times(0);
   EXPECT_CALL(stats_, counter("prefix.dynamodb.table_missing"));
@@ -85,8 +84,7 @@ TEST_F(DynamoFilterTest, jsonBodyNotWellFormed) {
 
   Http::TestHeaderMapImpl request_headers{{"x-amz-target", "version.GetItem"},
                                           {"random", "random"}};
-  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
-            filter_->decodeHeaders(request_headers, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
 
   Buffer::OwnedImpl buffer;
   buffer.add("test", 4);
@@ -100,8 +98,7 @@ TEST_F(DynamoFilterTest, bothOperationAndTableIncorrect) {
   setup(true);
 
   Http::TestHeaderMapImpl request_headers{{"x-amz-target", "version"}, {"random", "random"}};
-  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
-            filter_->decodeHeaders(request_headers, true));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, true));
 
   EXPECT_CALL(stats_, counter("prefix.dynamodb.operation_missing"));
   EXPECT_CALL(stats_, counter("prefix.dynamodb.table_missing"));
@@ -114,15 +111,13 @@ TEST_F(DynamoFilterTest, handleErrorTypeTableMissing) {
   setup(true);
 
   Http::TestHeaderMapImpl request_headers{{"x-amz-target", "version"}, {"random", "random"}};
-  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
-            filter_->decodeHeaders(request_headers, true));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, true));
 
   EXPECT_CALL(stats_, counter("prefix.dynamodb.operation_missing"));
   EXPECT_CALL(stats_, counter("prefix.dynamodb.table_missing"));
 
   Http::TestHeaderMapImpl response_headers{{":status", "400"}};
-  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
-            filter_->encodeHeaders(response_headers, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
 
   Buffer::InstancePtr error_data(new Buffer::OwnedImpl());
   std::string internal_error =
@@ -131,10 +126,9 @@ TEST_F(DynamoFilterTest, handleErrorTypeTableMissing) {
   EXPECT_CALL(stats_, counter("prefix.dynamodb.error.no_table.ValidationException"));
   EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(*error_data, true));
 
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
   error_data->add("}", 1);
-  EXPECT_EQ(Http::FilterDataStatus::StopIterationAndBuffer,
-            filter_->encodeData(*error_data, false));
-  EXPECT_CALL(encoder_callbacks_, encodingBuffer()).WillRepeatedly(Return(error_data.get()));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(*error_data, false));
   EXPECT_CALL(stats_, counter("prefix.dynamodb.invalid_resp_body"));
   EXPECT_CALL(stats_, counter("prefix.dynamodb.operation_missing"));
   EXPECT_CALL(stats_, counter("prefix.dynamodb.table_missing"));
@@ -146,8 +140,7 @@ TEST_F(DynamoFilterTest, HandleErrorTypeTablePresent) {
 
   Http::TestHeaderMapImpl request_headers{{"x-amz-target", "version.GetItem"},
                                           {"random", "random"}};
-  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
-            filter_->decodeHeaders(request_headers, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
 
   Buffer::OwnedImpl buffer;
   std::string buffer_content = "{\"TableName\":\"locations\"}";
@@ -155,8 +148,7 @@ TEST_F(DynamoFilterTest, HandleErrorTypeTablePresent) {
   EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->decodeData(buffer, true));
 
   Http::TestHeaderMapImpl response_headers{{":status", "400"}};
-  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
-            filter_->encodeHeaders(response_headers, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
 
   Buffer::OwnedImpl error_data;
   std::string internal_error =
@@ -207,13 +199,82 @@ TEST_F(DynamoFilterTest, HandleErrorTypeTablePresent) {
   EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(error_data, true));
 }
 
+TEST_F(DynamoFilterTest, BodiesParsedInChunks) {
+  setup(true);
+
+  // The bodies are parsed as they go through, and never buffered.
+  EXPECT_CALL(decoder_callbacks_, decodingBuffer()).Times(0);
+  EXPECT_CALL(encoder_callbacks_, encodingBuffer()).Times(0);
+
+  Http::TestHeaderMapImpl request_headers{{"x-amz-target", "version.GetItem"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
+  for (const std::string& chunk :
+       {"{\"Key\": {\"TableName\": \"x\"}, \"Table", "Name\": \"loca", "tions\"", "}"}) {
+    Buffer::OwnedImpl data(chunk);
+    EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->decodeData(data, false));
+  }
+  EXPECT_EQ(Http::FilterTrailersStatus::Continue, filter_->decodeTrailers(request_headers));
+
+  Http::TestHeaderMapImpl response_headers{{":status", "400"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
+  for (const std::string& chunk :
+       {"{\"__ty", "pe\":\"com.amazonaws.dynamodb.v20120810#Validation", "Exception\""}) {
+    Buffer::OwnedImpl data(chunk);
+    EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(data, false));
+  }
+
+  EXPECT_CALL(stats_, counter("prefix.dynamodb.error.locations.ValidationException"));
+
+  EXPECT_CALL(stats_, counter("prefix.dynamodb.operation.GetItem.upstream_rq_total"));
+  EXPECT_CALL(stats_, counter("prefix.dynamodb.operation.GetItem.upstream_rq_total_4xx"));
+  EXPECT_CALL(stats_, counter("prefix.dynamodb.operation.GetItem.upstream_rq_total_400"));
+
+  EXPECT_CALL(stats_, histogram("prefix.dynamodb.operation.GetItem.upstream_rq_time"));
+  EXPECT_CALL(stats_, histogram("prefix.dynamodb.operation.GetItem.upstream_rq_time_4xx"));
+  EXPECT_CALL(stats_, histogram("prefix.dynamodb.operation.GetItem.upstream_rq_time_400"));
+  EXPECT_CALL(stats_, deliverHistogramToSinks(
+                          Property(&Stats::Metric::name,
+                                   "prefix.dynamodb.operation.GetItem.upstream_rq_time_4xx"),
+                          _));
+  EXPECT_CALL(stats_, deliverHistogramToSinks(
+                          Property(&Stats::Metric::name,
+                                   "prefix.dynamodb.operation.GetItem.upstream_rq_time_400"),
+                          _));
+  EXPECT_CALL(
+      stats_,
+      deliverHistogramToSinks(
+          Property(&Stats::Metric::name, "prefix.dynamodb.operation.GetItem.upstream_rq_time"), _));
+
+  EXPECT_CALL(stats_, counter("prefix.dynamodb.table.locations.upstream_rq_total_4xx"));
+  EXPECT_CALL(stats_, counter("prefix.dynamodb.table.locations.upstream_rq_total_400"));
+  EXPECT_CALL(stats_, counter("prefix.dynamodb.table.locations.upstream_rq_total"));
+
+  EXPECT_CALL(stats_, histogram("prefix.dynamodb.table.locations.upstream_rq_time_4xx"));
+  EXPECT_CALL(stats_, histogram("prefix.dynamodb.table.locations.upstream_rq_time_400"));
+  EXPECT_CALL(stats_, histogram("prefix.dynamodb.table.locations.upstream_rq_time"));
+  EXPECT_CALL(stats_, deliverHistogramToSinks(
+                          Property(&Stats::Metric::name,
+                                   "prefix.dynamodb.table.locations.upstream_rq_time_4xx"),
+                          _));
+  EXPECT_CALL(stats_, deliverHistogramToSinks(
+                          Property(&Stats::Metric::name,
+                                   "prefix.dynamodb.table.locations.upstream_rq_time_400"),
+                          _));
+  EXPECT_CALL(
+      stats_,
+      deliverHistogramToSinks(
+          Property(&Stats::Metric::name, "prefix.dynamodb.table.locations.upstream_rq_time"), _));
+
+  Buffer::OwnedImpl data("}");
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(data, true));
+}
+
 TEST_F(DynamoFilterTest, BatchMultipleTables) {
   setup(true);
 
   Http::TestHeaderMapImpl request_headers{{"x-amz-target", "version.BatchGetItem"},
                                           {"random", "random"}};
-  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
-            filter_->decodeHeaders(request_headers, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
 
   Buffer::InstancePtr buffer(new Buffer::OwnedImpl());
   std::string buffer_content = R"EOF(
@@ -226,8 +287,7 @@ TEST_F(DynamoFilterTest, BatchMultipleTables) {
 )EOF";
   buffer->add(buffer_content);
 
-  EXPECT_EQ(Http::FilterDataStatus::StopIterationAndBuffer, filter_->decodeData(*buffer, false));
-  EXPECT_CALL(decoder_callbacks_, decodingBuffer()).WillRepeatedly(Return(buffer.get()));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->decodeData(*buffer, false));
   EXPECT_EQ(Http::FilterTrailersStatus::Continue, filter_->decodeTrailers(request_headers));
 
   Http::TestHeaderMapImpl response_headers{{":status", "200"}};
@@ -261,8 +321,7 @@ TEST_F(DynamoFilterTest, BatchMultipleTablesUnprocessedKeys) {
 
   Http::TestHeaderMapImpl request_headers{{"x-amz-target", "version.BatchGetItem"},
                                           {"random", "random"}};
-  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
-            filter_->decodeHeaders(request_headers, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
 
   Buffer::InstancePtr buffer(new Buffer::OwnedImpl());
   std::string buffer_content = R"EOF(
@@ -275,8 +334,7 @@ TEST_F(DynamoFilterTest, BatchMultipleTablesUnprocessedKeys) {
 )EOF";
   buffer->add(buffer_content);
 
-  EXPECT_EQ(Http::FilterDataStatus::StopIterationAndBuffer, filter_->decodeData(*buffer, false));
-  EXPECT_CALL(decoder_callbacks_, decodingBuffer()).WillRepeatedly(Return(buffer.get()));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->decodeData(*buffer, false));
   EXPECT_EQ(Http::FilterTrailersStatus::Continue, filter_->decodeTrailers(request_headers));
 
   Http::TestHeaderMapImpl response_headers{{":status", "200"}};
@@ -302,10 +360,8 @@ TEST_F(DynamoFilterTest, BatchMultipleTablesUnprocessedKeys) {
                                    "prefix.dynamodb.operation.BatchGetItem.upstream_rq_time"),
                           _));
 
-  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
-            filter_->encodeHeaders(response_headers, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
 
-  Buffer::OwnedImpl empty_data;
   Buffer::InstancePtr response_data(new Buffer::OwnedImpl());
   std::string response_content = R"EOF(
 {
@@ -319,8 +375,7 @@ TEST_F(DynamoFilterTest, BatchMultipleTablesUnprocessedKeys) {
 
   EXPECT_CALL(stats_, counter("prefix.dynamodb.error.table_1.BatchFailureUnprocessedKeys"));
   EXPECT_CALL(stats_, counter("prefix.dynamodb.error.table_2.BatchFailureUnprocessedKeys"));
-  EXPECT_CALL(encoder_callbacks_, encodingBuffer()).WillRepeatedly(Return(response_data.get()));
-  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(empty_data, true));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(*response_data, true));
 }
 
 TEST_F(DynamoFilterTest, BatchMultipleTablesNoUnprocessedKeys) {
@@ -328,8 +383,7 @@ TEST_F(DynamoFilterTest, BatchMultipleTablesNoUnprocessedKeys) {
 
   Http::TestHeaderMapImpl request_headers{{"x-amz-target", "version.BatchGetItem"},
                                           {"random", "random"}};
-  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
-            filter_->decodeHeaders(request_headers, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
 
   Buffer::InstancePtr buffer(new Buffer::OwnedImpl());
   std::string buffer_content = R"EOF(
@@ -342,8 +396,7 @@ TEST_F(DynamoFilterTest, BatchMultipleTablesNoUnprocessedKeys) {
 )EOF";
   buffer->add(buffer_content);
 
-  EXPECT_EQ(Http::FilterDataStatus::StopIterationAndBuffer, filter_->decodeData(*buffer, false));
-  EXPECT_CALL(decoder_callbacks_, decodingBuffer()).WillRepeatedly(Return(buffer.get()));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->decodeData(*buffer, false));
   EXPECT_EQ(Http::FilterTrailersStatus::Continue, filter_->decodeTrailers(request_headers));
 
   Http::TestHeaderMapImpl response_headers{{":status", "200"}};
@@ -369,10 +422,8 @@ TEST_F(DynamoFilterTest, BatchMultipleTablesNoUnprocessedKeys) {
                                    "prefix.dynamodb.operation.BatchGetItem.upstream_rq_time"),
                           _));
 
-  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
-            filter_->encodeHeaders(response_headers, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
 
-  Buffer::OwnedImpl empty_data;
   Buffer::InstancePtr response_data(new Buffer::OwnedImpl());
   std::string response_content = R"EOF(
 {
@@ -382,8 +433,7 @@ TEST_F(DynamoFilterTest, BatchMultipleTablesNoUnprocessedKeys) {
 )EOF";
   response_data->add(response_content);
 
-  EXPECT_CALL(encoder_callbacks_, encodingBuffer()).WillOnce(Return(response_data.get()));
-  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(empty_data, true));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(*response_data, true));
 }
 
 TEST_F(DynamoFilterTest, BatchMultipleTablesInvalidResponseBody) {
@@ -391,8 +441,7 @@ TEST_F(DynamoFilterTest, BatchMultipleTablesInvalidResponseBody) {
 
   Http::TestHeaderMapImpl request_headers{{"x-amz-target", "version.BatchGetItem"},
                                           {"random", "random"}};
-  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
-            filter_->decodeHeaders(request_headers, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
 
   Buffer::InstancePtr buffer(new Buffer::OwnedImpl());
   std::string buffer_content = R"EOF(
@@ -405,8 +454,7 @@ TEST_F(DynamoFilterTest, BatchMultipleTablesInvalidResponseBody) {
 )EOF";
   buffer->add(buffer_content);
 
-  EXPECT_EQ(Http::FilterDataStatus::StopIterationAndBuffer, filter_->decodeData(*buffer, false));
-  EXPECT_CALL(decoder_callbacks_, decodingBuffer()).WillRepeatedly(Return(buffer.get()));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->decodeData(*buffer, false));
   EXPECT_EQ(Http::FilterTrailersStatus::Continue, filter_->decodeTrailers(request_headers));
 
   Http::TestHeaderMapImpl response_headers{{":status", "200"}};
@@ -432,10 +480,8 @@ TEST_F(DynamoFilterTest, BatchMultipleTablesInvalidResponseBody) {
                                    "prefix.dynamodb.operation.BatchGetItem.upstream_rq_time"),
                           _));
 
-  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
-            filter_->encodeHeaders(response_headers, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
 
-  Buffer::OwnedImpl empty_data;
   Buffer::InstancePtr response_data(new Buffer::OwnedImpl());
   std::string response_content = R"EOF(
 {
@@ -449,8 +495,7 @@ TEST_F(DynamoFilterTest, BatchMultipleTablesInvalidResponseBody) {
   response_data->add("}", 1);
 
   EXPECT_CALL(stats_, counter("prefix.dynamodb.invalid_resp_body"));
-  EXPECT_CALL(encoder_callbacks_, encodingBuffer()).WillOnce(Return(response_data.get()));
-  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(empty_data, true));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(*response_data, true));
 }
 
 TEST_F(DynamoFilterTest, bothOperationAndTableCorrect) {
@@ -460,13 +505,11 @@ TEST_F(DynamoFilterTest, bothOperationAndTableCorrect) {
   Buffer::InstancePtr buffer(new Buffer::OwnedImpl());
   std::string buffer_content = "{\"TableName\":\"locations\"";
   buffer->add(buffer_content);
-  EXPECT_CALL(decoder_callbacks_, decodingBuffer()).WillRepeatedly(Return(buffer.get()));
   Buffer::OwnedImpl data;
   data.add("}", 1);
 
-  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
-            filter_->decodeHeaders(request_headers, false));
-  EXPECT_EQ(Http::FilterDataStatus::StopIterationAndBuffer, filter_->decodeData(data, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->decodeData(*buffer, false));
   EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->decodeData(data, true));
 
   EXPECT_CALL(stats_, counter("prefix.dynamodb.operation.GetItem.upstream_rq_total_2xx"));
@@ -535,13 +578,11 @@ TEST_F(DynamoFilterTest, PartitionIdStats) {
   Buffer::InstancePtr buffer(new Buffer::OwnedImpl());
   std::string buffer_content = "{\"TableName\":\"locations\"";
   buffer->add(buffer_content);
-  ON_CALL(decoder_callbacks_, decodingBuffer()).WillByDefault(Return(buffer.get()));
   Buffer::OwnedImpl data;
   data.add("}", 1);
 
-  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
-            filter_->decodeHeaders(request_headers, false));
-  EXPECT_EQ(Http::FilterDataStatus::StopIterationAndBuffer, filter_->decodeData(data, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->decodeData(*buffer, false));
   EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->decodeData(data, true));
 
   EXPECT_CALL(stats_, counter("prefix.dynamodb.operation.GetItem.upstream_rq_total_2xx"));
@@ -592,10 +633,8 @@ TEST_F(DynamoFilterTest, PartitionIdStats) {
       .Times(1);
 
   Http::TestHeaderMapImpl response_headers{{":status", "200"}};
-  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
-            filter_->encodeHeaders(response_headers, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
 
-  Buffer::OwnedImpl empty_data;
   Buffer::InstancePtr response_data(new Buffer::OwnedImpl());
   std::string response_content = R"EOF(
     {
@@ -610,8 +649,7 @@ TEST_F(DynamoFilterTest, PartitionIdStats) {
 
   response_data->add(response_content);
 
-  EXPECT_CALL(encoder_callbacks_, encodingBuffer()).WillOnce(Return(response_data.get()));
-  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(empty_data, true));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(*response_data, true));
 }
 
 TEST_F(DynamoFilterTest, NoPartitionIdStatsForMultipleTables) {
@@ -628,11 +666,9 @@ TEST_F(DynamoFilterTest, NoPartitionIdStatsForMultipleTables) {
 }
 )EOF";
   buffer->add(buffer_content);
-  ON_CALL(decoder_callbacks_, decodingBuffer()).WillByDefault(Return(buffer.get()));
 
-  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
-            filter_->decodeHeaders(request_headers, false));
-  EXPECT_EQ(Http::FilterDataStatus::StopIterationAndBuffer, filter_->decodeData(*buffer, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->decodeData(*buffer, false));
   EXPECT_EQ(Http::FilterTrailersStatus::Continue, filter_->decodeTrailers(request_headers));
 
   EXPECT_CALL(stats_, counter("prefix.dynamodb.multiple_tables"));
@@ -667,10 +703,8 @@ TEST_F(DynamoFilterTest, NoPartitionIdStatsForMultipleTables) {
       .Times(0);
 
   Http::TestHeaderMapImpl response_headers{{":status", "200"}};
-  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
-            filter_->encodeHeaders(response_headers, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
 
-  Buffer::OwnedImpl empty_data;
   Buffer::InstancePtr response_data(new Buffer::OwnedImpl());
   std::string response_content = R"EOF(
     {
@@ -685,8 +719,7 @@ TEST_F(DynamoFilterTest, NoPartitionIdStatsForMultipleTables) {
 
   response_data->add(response_content);
 
-  EXPECT_CALL(encoder_callbacks_, encodingBuffer()).WillOnce(Return(response_data.get()));
-  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(empty_data, true));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(*response_data, true));
 }
 
 TEST_F(DynamoFilterTest, PartitionIdStatsForSingleTableBatchOperation) {
@@ -702,11 +735,9 @@ TEST_F(DynamoFilterTest, PartitionIdStatsForSingleTableBatchOperation) {
 }
 )EOF";
   buffer->add(buffer_content);
-  ON_CALL(decoder_callbacks_, decodingBuffer()).WillByDefault(Return(buffer.get()));
 
-  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
-            filter_->decodeHeaders(request_headers, false));
-  EXPECT_EQ(Http::FilterDataStatus::StopIterationAndBuffer, filter_->decodeData(*buffer, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->decodeData(*buffer, false));
   EXPECT_EQ(Http::FilterTrailersStatus::Continue, filter_->decodeTrailers(request_headers));
 
   EXPECT_CALL(stats_, counter("prefix.dynamodb.multiple_tables")).Times(0);
@@ -761,10 +792,8 @@ TEST_F(DynamoFilterTest, PartitionIdStatsForSingleTableBatchOperation) {
       .Times(1);
 
   Http::TestHeaderMapImpl response_headers{{":status", "200"}};
-  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
-            filter_->encodeHeaders(response_headers, false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
 
-  Buffer::OwnedImpl empty_data;
   Buffer::InstancePtr response_data(new Buffer::OwnedImpl());
   std::string response_content = R"EOF(
     {
@@ -779,8 +808,7 @@ TEST_F(DynamoFilterTest, PartitionIdStatsForSingleTableBatchOperation) {
 
   response_data->add(response_content);
 
-  EXPECT_CALL(encoder_callbacks_, encodingBuffer()).WillOnce(Return(response_data.get()));
-  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(empty_data, true));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(*response_data, true));
 }
 
 } // namespace Dynamo
@@ -1,9 +1,10 @@
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "common/buffer/buffer_impl.h"
 #include "common/dynamo/dynamo_request_parser.h"
 #include "common/http/header_map_impl.h"
-#include "common/json/json_loader.h"
 
 #include "test/test_common/printers.h"
 #include "test/test_common/utility.h"
@@ -39,6 +40,22 @@ TEST(DynamoRequestParser, parseOperation) {
   }
 }
 
+RequestParser::TableDescriptor parseTable(const std::string& operation, const std::string& body) {
+  RequestBodyParser parser(operation);
+  Buffer::OwnedImpl buffer(body);
+  EXPECT_TRUE(parser.parse(buffer));
+  EXPECT_TRUE(parser.finish());
+  return parser.table();
+}
+
+std::unique_ptr<ResponseBodyParser> parseResponse(const std::string& body) {
+  std::unique_ptr<ResponseBodyParser> parser(new ResponseBodyParser());
+  Buffer::OwnedImpl buffer(body);
+  EXPECT_TRUE(parser->parse(buffer));
+  EXPECT_TRUE(parser->finish());
+  return parser;
+}
+
 TEST(DynamoRequestParser, parseTableNameSingleOperation) {
   std::vector<std::string> supported_single_operations{"GetItem", "Query",      "Scan",
                                                        "PutItem", "UpdateItem", "DeleteItem"};
@@ -53,40 +70,79 @@ TEST(DynamoRequestParser, parseTableNameSingleOperation) {
       }
     }
     )EOF";
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString(json_string);
 
     // Supported operation
     for (const std::string& operation : supported_single_operations) {
-      EXPECT_EQ("Pets", RequestParser::parseTable(operation, *json_data).table_name);
+      EXPECT_EQ("Pets", parseTable(operation, json_string).table_name);
     }
 
     // Not supported operation
-    EXPECT_EQ("", RequestParser::parseTable("NotSupportedOperation", *json_data).table_name);
+    EXPECT_EQ("", parseTable("NotSupportedOperation", json_string).table_name);
   }
 
+  { EXPECT_EQ("Pets", parseTable("GetItem", "{\"TableName\":\"Pets\"}").table_name); }
+
+  // Only the top level field is the table name.
   {
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString("{\"TableName\":\"Pets\"}");
-    EXPECT_EQ("Pets", RequestParser::parseTable("GetItem", *json_data).table_name);
+    EXPECT_EQ("", parseTable("GetItem", "{\"Key\":{\"TableName\":\"Pets\"}}").table_name);
+    EXPECT_EQ("", parseTable("GetItem", "[{\"TableName\":\"Pets\"}]").table_name);
+    EXPECT_EQ("", parseTable("GetItem", "{\"TableName\":[\"Pets\"]}").table_name);
+  }
+}
+
+TEST(DynamoRequestParser, parseTableNameInChunks) {
+  std::string json_string = R"EOF({"Key": {"Name": {"S": "TableName"}}, "TableName": "Pets"})EOF";
+
+  // Feed the body a byte at a time, in separate buffers.
+  RequestBodyParser parser("GetItem");
+  for (char c : json_string) {
+    Buffer::OwnedImpl buffer(&c, 1);
+    EXPECT_TRUE(parser.parse(buffer));
+  }
+  EXPECT_TRUE(parser.finish());
+  EXPECT_EQ("Pets", parser.table().table_name);
+}
+
+TEST(DynamoRequestParser, parseInvalidBody) {
+  {
+    RequestBodyParser parser("GetItem");
+    Buffer::OwnedImpl buffer("{\"TableName\":\"Pets\"");
+    EXPECT_TRUE(parser.parse(buffer));
+    EXPECT_FALSE(parser.finish());
+  }
+
+  {
+    ResponseBodyParser parser;
+    Buffer::OwnedImpl buffer("{\"__type\":}");
+    EXPECT_FALSE(parser.parse(buffer));
+    EXPECT_FALSE(parser.finish());
   }
 }
 
 TEST(DynamoRequestParser, parseErrorType) {
   {
     EXPECT_EQ("ResourceNotFoundException",
-              RequestParser::parseErrorType(*Json::Factory::loadFromString(
-                  "{\"__type\":\"com.amazonaws.dynamodb.v20120810#ResourceNotFoundException\"}")));
+              parseResponse(
+                  "{\"__type\":\"com.amazonaws.dynamodb.v20120810#ResourceNotFoundException\"}")
+                  ->errorType());
   }
 
   {
     EXPECT_EQ("ResourceNotFoundException",
-              RequestParser::parseErrorType(*Json::Factory::loadFromString(
+              parseResponse(
                   "{\"__type\":\"com.amazonaws.dynamodb.v20120810#ResourceNotFoundException\","
-                  "\"message\":\"Requested resource not found: Table: tablename not found\"}")));
+                  "\"message\":\"Requested resource not found: Table: tablename not found\"}")
+                  ->errorType());
   }
 
+  { EXPECT_EQ("", parseResponse("{\"__type\":\"UnKnownError\"}")->errorType()); }
+
+  { EXPECT_EQ("", parseResponse("{}")->errorType()); }
+
   {
-    EXPECT_EQ("", RequestParser::parseErrorType(
-                      *Json::Factory::loadFromString("{\"__type\":\"UnKnownError\"}")));
+    EXPECT_EQ("ValidationException", RequestParser::parseErrorType(
+                                         "com.amazonaws.dynamodb.v20120810#ValidationException"));
+    EXPECT_EQ("", RequestParser::parseErrorType(""));
   }
 }
 
@@ -100,9 +156,8 @@ TEST(DynamoRequestParser, parseTableNameBatchOperation) {
       }
     }
     )EOF";
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString(json_string);
 
-    RequestParser::TableDescriptor table = RequestParser::parseTable("BatchGetItem", *json_data);
+    RequestParser::TableDescriptor table = parseTable("BatchGetItem", json_string);
     EXPECT_EQ("", table.table_name);
     EXPECT_FALSE(table.is_single_table);
   }
@@ -116,9 +171,8 @@ TEST(DynamoRequestParser, parseTableNameBatchOperation) {
       }
     }
     )EOF";
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString(json_string);
 
-    RequestParser::TableDescriptor table = RequestParser::parseTable("BatchGetItem", *json_data);
+    RequestParser::TableDescriptor table = parseTable("BatchGetItem", json_string);
     EXPECT_EQ("table_2", table.table_name);
     EXPECT_TRUE(table.is_single_table);
   }
@@ -133,9 +187,8 @@ TEST(DynamoRequestParser, parseTableNameBatchOperation) {
       }
     }
     )EOF";
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString(json_string);
 
-    RequestParser::TableDescriptor table = RequestParser::parseTable("BatchGetItem", *json_data);
+    RequestParser::TableDescriptor table = parseTable("BatchGetItem", json_string);
     EXPECT_EQ("", table.table_name);
     EXPECT_FALSE(table.is_single_table);
   }
@@ -149,53 +202,42 @@ TEST(DynamoRequestParser, parseTableNameBatchOperation) {
       }
     }
     )EOF";
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString(json_string);
 
-    RequestParser::TableDescriptor table = RequestParser::parseTable("BatchWriteItem", *json_data);
+    RequestParser::TableDescriptor table = parseTable("BatchWriteItem", json_string);
     EXPECT_EQ("table_2", table.table_name);
     EXPECT_TRUE(table.is_single_table);
   }
 
   {
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString("{}");
-    RequestParser::TableDescriptor table =
-        RequestParser::parseTable("BatchWriteItem", *Json::Factory::loadFromString("{}"));
+    RequestParser::TableDescriptor table = parseTable("BatchWriteItem", "{}");
     EXPECT_EQ("", table.table_name);
     EXPECT_TRUE(table.is_single_table);
   }
 
   {
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString("{\"RequestItems\":{}}");
-    RequestParser::TableDescriptor table = RequestParser::parseTable("BatchWriteItem", *json_data);
+    RequestParser::TableDescriptor table = parseTable("BatchWriteItem", "{\"RequestItems\":{}}");
     EXPECT_EQ("", table.table_name);
     EXPECT_TRUE(table.is_single_table);
   }
 
   {
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString("{}");
-    RequestParser::TableDescriptor table = RequestParser::parseTable("BatchGetItem", *json_data);
+    RequestParser::TableDescriptor table = parseTable("BatchGetItem", "{}");
     EXPECT_EQ("", table.table_name);
     EXPECT_TRUE(table.is_single_table);
   }
 }
+
 TEST(DynamoRequestParser, parseBatchUnProcessedKeys) {
-  {
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString("{}");
-    std::vector<std::string> unprocessed_tables =
-        RequestParser::parseBatchUnProcessedKeys(*json_data);
-    EXPECT_EQ(0u, unprocessed_tables.size());
-  }
-  {
-    std::vector<std::string> unprocessed_tables = RequestParser::parseBatchUnProcessedKeys(
-        *Json::Factory::loadFromString("{\"UnprocessedKeys\":{}}"));
-    EXPECT_EQ(0u, unprocessed_tables.size());
-  }
+  { EXPECT_EQ(0u, parseResponse("{}")->unprocessedTables().size()); }
+
+  { EXPECT_EQ(0u, parseResponse("{\"UnprocessedKeys\":{}}")->unprocessedTables().size()); }
 
   {
-    std::vector<std::string> unprocessed_tables = RequestParser::parseBatchUnProcessedKeys(
-        *Json::Factory::loadFromString("{\"UnprocessedKeys\":{\"table_1\" :{}}}"));
-    EXPECT_EQ("table_1", unprocessed_tables[0]);
+    std::unique_ptr<ResponseBodyParser> parser =
+        parseResponse("{\"UnprocessedKeys\":{\"table_1\" :{}}}");
+    const std::vector<std::string>& unprocessed_tables = parser->unprocessedTables();
     EXPECT_EQ(1u, unprocessed_tables.size());
+    EXPECT_EQ("table_1", unprocessed_tables[0]);
   }
 
   {
@@ -207,10 +249,9 @@ TEST(DynamoRequestParser, parseBatchUnProcessedKeys) {
       }
     }
     )EOF";
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString(json_string);
 
-    std::vector<std::string> unprocessed_tables =
-        RequestParser::parseBatchUnProcessedKeys(*json_data);
+    std::unique_ptr<ResponseBodyParser> parser = parseResponse(json_string);
+    const std::vector<std::string>& unprocessed_tables = parser->unprocessedTables();
     EXPECT_TRUE(find(unprocessed_tables.begin(), unprocessed_tables.end(), "table_1") !=
                 unprocessed_tables.end());
     EXPECT_TRUE(find(unprocessed_tables.begin(), unprocessed_tables.end(), "table_2") !=
@@ -220,21 +261,15 @@ TEST(DynamoRequestParser, parseBatchUnProcessedKeys) {
 }
 
 TEST(DynamoRequestParser, parsePartitionIds) {
+  { EXPECT_EQ(0u, parseResponse("{}")->partitions().size()); }
+
+  { EXPECT_EQ(0u, parseResponse("{\"ConsumedCapacity\":{}}")->partitions().size()); }
+
   {
-    std::vector<RequestParser::PartitionDescriptor> partitions =
-        RequestParser::parsePartitions(*Json::Factory::loadFromString("{}"));
-    EXPECT_EQ(0u, partitions.size());
-  }
-  {
-    std::vector<RequestParser::PartitionDescriptor> partitions =
-        RequestParser::parsePartitions(*Json::Factory::loadFromString("{\"ConsumedCapacity\":{}}"));
-    EXPECT_EQ(0u, partitions.size());
-  }
-  {
-    std::vector<RequestParser::PartitionDescriptor> partitions = RequestParser::parsePartitions(
-        *Json::Factory::loadFromString("{\"ConsumedCapacity\":{ \"Partitions\":{}}}"));
-    EXPECT_EQ(0u, partitions.size());
+    EXPECT_EQ(0u,
+              parseResponse("{\"ConsumedCapacity\":{ \"Partitions\":{}}}")->partitions().size());
   }
+
   {
     std::string json_string = R"EOF(
     {
@@ -246,10 +281,9 @@ TEST(DynamoRequestParser, parsePartitionIds) {
       }
     }
     )EOF";
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString(json_string);
 
-    std::vector<RequestParser::PartitionDescriptor> partitions =
-        RequestParser::parsePartitions(*json_data);
+    std::unique_ptr<ResponseBodyParser> parser = parseResponse(json_string);
+    const std::vector<RequestParser::PartitionDescriptor>& partitions = parser->partitions();
     for (const RequestParser::PartitionDescriptor& partition : partitions) {
       if (partition.partition_id_ == "partition_1") {
         EXPECT_EQ(1u, partition.capacity_);
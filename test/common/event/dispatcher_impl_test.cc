@@ -1,13 +1,26 @@
+#include <unistd.h>
+
+#include <chrono>
 #include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "common/common/thread.h"
 #include "common/event/dispatcher_impl.h"
 
 #include "test/mocks/common.h"
+#include "test/mocks/stats/mocks.h"
 
+#include "event2/event.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
 using testing::InSequence;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::_;
 
 namespace Envoy {
 namespace Event {
@@ -51,5 +64,165 @@ TEST(DispatcherImplTest, DeferredDelete) {
   dispatcher.clearDeferredDeleteList();
 }
 
+// With a limit, deferred deletions are spread over loop iterations in FIFO order, while explicit
+// clears still destroy everything.
+TEST(DispatcherImplTest, LimitedDeferredDelete) {
+  DispatcherImpl::maxDeferredDeletesPerIteration(2);
+  DispatcherImpl dispatcher;
+  DispatcherImpl::maxDeferredDeletesPerIteration(0);
+  NiceMock<Stats::MockIsolatedStatsStore> store;
+  std::vector<uint64_t> depths;
+  ON_CALL(store, deliverHistogramToSinks(_, _))
+      .WillByDefault(Invoke([&](const Stats::Histogram& histogram, uint64_t value) -> void {
+        if (histogram.name() == "test.deferred_delete_queue_depth") {
+          depths.push_back(value);
+        }
+      }));
+  dispatcher.initializeStats(store, "test.");
+
+  std::vector<uint32_t> order;
+  for (uint32_t i = 0; i < 5; i++) {
+    dispatcher.deferredDelete(DeferredDeletablePtr{
+        new TestDeferredDeletable([&order, i]() -> void { order.push_back(i); })});
+  }
+  dispatcher.run(Dispatcher::RunType::Block);
+  EXPECT_EQ(std::vector<uint32_t>({0, 1, 2, 3, 4}), order);
+  EXPECT_EQ(std::vector<uint64_t>({5, 3, 1}), depths);
+
+  order.clear();
+  for (uint32_t i = 0; i < 3; i++) {
+    dispatcher.deferredDelete(DeferredDeletablePtr{
+        new TestDeferredDeletable([&order, i]() -> void { order.push_back(i); })});
+  }
+  dispatcher.clearDeferredDeleteList();
+  EXPECT_EQ(std::vector<uint32_t>({0, 1, 2}), order);
+}
+
+TEST(DispatcherImplTest, EpollChangelist) {
+  DispatcherImpl::useEpollChangelist(true);
+  DispatcherImpl dispatcher;
+  DispatcherImpl::useEpollChangelist(false);
+
+  const std::string method = event_base_get_method(&dispatcher.base());
+  if (method.find("epoll") == 0) {
+    EXPECT_EQ("epoll (with changelist)", method);
+  }
+
+  // Events registered through the changelist still fire.
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  ReadyWatcher watcher;
+  FileEventPtr file_event = dispatcher.createFileEvent(
+      fds[0], [&](uint32_t events) -> void {
+        EXPECT_EQ(FileReadyType::Read, events);
+        watcher.ready();
+      },
+      FileTriggerType::Edge, FileReadyType::Read);
+  ASSERT_EQ(1, write(fds[1], "a", 1));
+  EXPECT_CALL(watcher, ready());
+  dispatcher.run(Dispatcher::RunType::NonBlock);
+
+  file_event.reset();
+  close(fds[0]);
+  close(fds[1]);
+}
+
+// Coarse timers are driven by a single dispatcher timer, which is disarmed once no timers are
+// pending so that the event loop can exit.
+TEST(DispatcherImplTest, CoarseTimer) {
+  DispatcherImpl dispatcher;
+  ReadyWatcher watcher;
+  TimerPtr timer = dispatcher.createCoarseTimer([&]() -> void { watcher.ready(); });
+  TimerPtr disabled = dispatcher.createCoarseTimer([&]() -> void { FAIL(); });
+  disabled->enableTimer(std::chrono::milliseconds(5));
+  disabled->disableTimer();
+
+  const MonotonicTime start = std::chrono::steady_clock::now();
+  timer->enableTimer(std::chrono::milliseconds(20));
+  EXPECT_CALL(watcher, ready());
+  dispatcher.run(Dispatcher::RunType::Block);
+  EXPECT_LE(std::chrono::milliseconds(20), std::chrono::steady_clock::now() - start);
+}
+
+// A dispatcher run until exit waits for work posted from another thread even when it has no
+// events to wait for.
+TEST(DispatcherImplTest, RunUntilExit) {
+  DispatcherImpl dispatcher;
+  ReadyWatcher watcher;
+  Thread::Thread thread([&]() -> void {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    dispatcher.post([&]() -> void {
+      watcher.ready();
+      dispatcher.exit();
+    });
+  });
+
+  EXPECT_CALL(watcher, ready());
+  dispatcher.run(Dispatcher::RunType::RunUntilExit);
+  thread.join();
+}
+
+// Posted callbacks run in order, including the ones posted by other posted callbacks.
+TEST(DispatcherImplTest, PostOrdering) {
+  DispatcherImpl dispatcher;
+  std::vector<uint32_t> order;
+  dispatcher.post([&]() -> void {
+    order.push_back(1);
+    dispatcher.post([&]() -> void { order.push_back(3); });
+  });
+  dispatcher.post([&]() -> void { order.push_back(2); });
+
+  dispatcher.run(Dispatcher::RunType::NonBlock);
+  EXPECT_EQ(std::vector<uint32_t>({1, 2, 3}), order);
+}
+
+// Once stats are initialized, every iteration of the loop which runs events is recorded.
+TEST(DispatcherImplTest, LoopStats) {
+  DispatcherImpl dispatcher;
+  NiceMock<Stats::MockIsolatedStatsStore> store;
+  std::map<std::string, std::vector<uint64_t>> values;
+  ON_CALL(store, deliverHistogramToSinks(_, _))
+      .WillByDefault(Invoke([&](const Stats::Histogram& histogram, uint64_t value) -> void {
+        values[histogram.name()].push_back(value);
+      }));
+  dispatcher.initializeStats(store, "test.");
+
+  ReadyWatcher watcher;
+  TimerPtr timer = dispatcher.createTimer([&]() -> void { watcher.ready(); });
+  timer->enableTimer(std::chrono::milliseconds(10));
+  EXPECT_CALL(watcher, ready());
+  dispatcher.run(Dispatcher::RunType::Block);
+
+  // The loop waited for the timer, and then ran it in a single iteration.
+  ASSERT_EQ(1U, values["test.events_per_iteration"].size());
+  EXPECT_EQ(1U, values["test.events_per_iteration"][0]);
+  ASSERT_EQ(1U, values["test.poll_delay_us"].size());
+  EXPECT_LE(5000U, values["test.poll_delay_us"][0]);
+  EXPECT_EQ(1U, values["test.loop_duration_us"].size());
+}
+
+// The approximate times are read once per event callback, and are precise outside of them.
+TEST(DispatcherImplTest, ApproximateTime) {
+  DispatcherImpl dispatcher;
+  std::vector<MonotonicTime> times;
+  TimerPtr second_timer;
+  TimerPtr timer = dispatcher.createTimer([&]() -> void {
+    times.push_back(dispatcher.approximateMonotonicTime());
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    times.push_back(dispatcher.approximateMonotonicTime());
+    EXPECT_EQ(dispatcher.approximateSystemTime(), dispatcher.approximateSystemTime());
+    second_timer->enableTimer(std::chrono::milliseconds(1));
+  });
+  second_timer = dispatcher.createTimer(
+      [&]() -> void { times.push_back(dispatcher.approximateMonotonicTime()); });
+  timer->enableTimer(std::chrono::milliseconds(0));
+  dispatcher.run(Dispatcher::RunType::Block);
+
+  ASSERT_EQ(3U, times.size());
+  EXPECT_EQ(times[0], times[1]);
+  EXPECT_LT(times[1], times[2]);
+  EXPECT_LE(times[2], dispatcher.approximateMonotonicTime());
+}
+
 } // namespace Event
 } // namespace Envoy
@@ -0,0 +1,223 @@
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include "common/event/timer_wheel.h"
+
+#include "test/mocks/common.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Event {
+
+/**
+ * Stand in for the dispatcher timer that drives the wheel. Records when the timer is due.
+ */
+class TestTickTimer : public Timer {
+public:
+  TestTickTimer(const MonotonicTime& now, bool& enabled, std::chrono::milliseconds& delay,
+                MonotonicTime& due)
+      : now_(now), enabled_(enabled), delay_(delay), due_(due) {}
+
+  // Event::Timer
+  void disableTimer() override { enabled_ = false; }
+  void enableTimer(const std::chrono::milliseconds& d) override {
+    enabled_ = true;
+    delay_ = d;
+    due_ = now_ + d;
+  }
+
+private:
+  const MonotonicTime& now_;
+  bool& enabled_;
+  std::chrono::milliseconds& delay_;
+  MonotonicTime& due_;
+};
+
+class TimerWheelTest : public testing::Test {
+public:
+  TimerWheelTest() {
+    ON_CALL(time_source_, currentTime()).WillByDefault(Invoke([this]() -> MonotonicTime {
+      return now_;
+    }));
+    wheel_.reset(new TimerWheel(
+        [this](TimerCb cb) -> TimerPtr {
+          tick_cb_ = cb;
+          return TimerPtr{new TestTickTimer(now_, tick_enabled_, tick_delay_, tick_due_)};
+        },
+        time_source_));
+  }
+
+  // Advance time to when the tick timer is due, and fire it.
+  void runTick() {
+    ASSERT_TRUE(tick_enabled_);
+    now_ = tick_due_;
+    tick_enabled_ = false;
+    tick_cb_();
+  }
+
+  // Advance time by d, firing the tick timer whenever it is due.
+  void advance(std::chrono::milliseconds d) {
+    const MonotonicTime end = now_ + d;
+    while (tick_enabled_ && tick_due_ <= end) {
+      runTick();
+    }
+    now_ = end;
+  }
+
+  std::chrono::milliseconds sinceStart() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now_ - start_);
+  }
+
+  NiceMock<MockMonotonicTimeSource> time_source_;
+  const MonotonicTime start_{std::chrono::hours(1)};
+  MonotonicTime now_{start_};
+  TimerCb tick_cb_;
+  bool tick_enabled_{};
+  std::chrono::milliseconds tick_delay_{};
+  MonotonicTime tick_due_;
+  std::unique_ptr<TimerWheel> wheel_;
+};
+
+TEST_F(TimerWheelTest, EnableDisable) {
+  ReadyWatcher watcher;
+  TimerPtr timer = wheel_->createTimer([&]() -> void { watcher.ready(); });
+  EXPECT_FALSE(tick_enabled_);
+
+  timer->enableTimer(std::chrono::milliseconds(25));
+  EXPECT_EQ(1U, wheel_->numPendingTimers());
+  EXPECT_TRUE(tick_enabled_);
+  EXPECT_EQ(std::chrono::milliseconds(30), tick_delay_);
+
+  // Re-enabling resets the timeout.
+  advance(std::chrono::milliseconds(20));
+  timer->enableTimer(std::chrono::milliseconds(25));
+  EXPECT_EQ(1U, wheel_->numPendingTimers());
+  advance(std::chrono::milliseconds(20));
+
+  EXPECT_CALL(watcher, ready());
+  advance(std::chrono::milliseconds(10));
+  EXPECT_EQ(0U, wheel_->numPendingTimers());
+  EXPECT_FALSE(tick_enabled_);
+
+  // Disabled and destroyed timers do not fire.
+  timer->enableTimer(std::chrono::milliseconds(100));
+  timer->disableTimer();
+  EXPECT_EQ(0U, wheel_->numPendingTimers());
+  timer->enableTimer(std::chrono::milliseconds(100));
+  timer.reset();
+  EXPECT_EQ(0U, wheel_->numPendingTimers());
+  advance(std::chrono::seconds(1));
+  EXPECT_FALSE(tick_enabled_);
+}
+
+// Timers fire at the first tick at or after their timeout, across all levels of the wheel.
+TEST_F(TimerWheelTest, NeverEarlyAtMostATickLate) {
+  const std::vector<std::chrono::milliseconds> timeouts = {
+      std::chrono::milliseconds(0),     std::chrono::milliseconds(1),
+      std::chrono::milliseconds(10),    std::chrono::milliseconds(639),
+      std::chrono::milliseconds(641),   std::chrono::milliseconds(15000),
+      std::chrono::milliseconds(40959), std::chrono::milliseconds(40961),
+      std::chrono::minutes(5),          std::chrono::hours(12)};
+
+  // Start off tick boundaries and offset from the wheel's start, so that all levels have wrapped
+  // at different points.
+  advance(std::chrono::milliseconds(123457));
+  std::vector<std::chrono::milliseconds> fired(timeouts.size());
+  std::vector<TimerPtr> timers;
+  for (size_t i = 0; i < timeouts.size(); i++) {
+    timers.emplace_back(
+        wheel_->createTimer([this, i, &fired]() -> void { fired[i] = sinceStart(); }));
+  }
+  const std::chrono::milliseconds enabled_at = sinceStart();
+  for (size_t i = 0; i < timeouts.size(); i++) {
+    timers[i]->enableTimer(timeouts[i]);
+  }
+
+  while (tick_enabled_) {
+    runTick();
+  }
+  for (size_t i = 0; i < timeouts.size(); i++) {
+    const std::chrono::milliseconds latency = fired[i] - enabled_at - timeouts[i];
+    EXPECT_LE(0, latency.count()) << timeouts[i].count();
+    EXPECT_GT(static_cast<int64_t>(TimerWheel::TICK_MS), latency.count()) << timeouts[i].count();
+  }
+}
+
+// Timeouts beyond the range of the wheel are cascaded through the top level until they are due.
+TEST_F(TimerWheelTest, BeyondRange) {
+  ReadyWatcher watcher;
+  TimerPtr timer = wheel_->createTimer([&]() -> void { watcher.ready(); });
+  const uint64_t range_ms = TimerWheel::TICK_MS << (TimerWheel::SLOT_BITS * TimerWheel::LEVELS);
+  timer->enableTimer(std::chrono::milliseconds(3 * range_ms));
+
+  advance(std::chrono::milliseconds(3 * range_ms - 1));
+  EXPECT_CALL(watcher, ready());
+  advance(std::chrono::milliseconds(TimerWheel::TICK_MS));
+}
+
+// Callbacks may enable, disable and destroy timers, including timers expiring in the same tick.
+TEST_F(TimerWheelTest, ChangeTimersFromCallbacks) {
+  ReadyWatcher watcher;
+  TimerPtr timer2;
+  TimerPtr timer3;
+  uint32_t rearms = 0;
+  TimerPtr timer1 = wheel_->createTimer([&]() -> void {
+    watcher.ready();
+    timer2->disableTimer();
+    timer3.reset();
+    if (++rearms < 3) {
+      timer1->enableTimer(std::chrono::milliseconds(0));
+    }
+  });
+  timer2 = wheel_->createTimer([&]() -> void { FAIL(); });
+  timer3 = wheel_->createTimer([&]() -> void { FAIL(); });
+  timer1->enableTimer(std::chrono::milliseconds(50));
+  timer2->enableTimer(std::chrono::milliseconds(50));
+  timer3->enableTimer(std::chrono::milliseconds(50));
+
+  // Re-enabling from the callback with no timeout fires at the next tick, not in a loop.
+  EXPECT_CALL(watcher, ready()).Times(3);
+  advance(std::chrono::milliseconds(50));
+  EXPECT_EQ(1U, wheel_->numPendingTimers());
+  advance(std::chrono::milliseconds(20));
+  EXPECT_EQ(0U, wheel_->numPendingTimers());
+}
+
+// Short timers enabled while only long timers are pending rearm the tick timer.
+TEST_F(TimerWheelTest, Rearm) {
+  ReadyWatcher watcher;
+  TimerPtr long_timer = wheel_->createTimer([&]() -> void { watcher.ready(); });
+  TimerPtr short_timer = wheel_->createTimer([&]() -> void { watcher.ready(); });
+  advance(std::chrono::milliseconds(15));
+
+  // The long timer is in an upper level, so the wheel doesn't wake up before the lowest level
+  // wraps.
+  long_timer->enableTimer(std::chrono::minutes(10));
+  EXPECT_LT(std::chrono::milliseconds(TimerWheel::SLOTS * TimerWheel::TICK_MS), tick_delay_);
+  short_timer->enableTimer(std::chrono::milliseconds(5));
+  EXPECT_EQ(std::chrono::milliseconds(5), tick_delay_);
+
+  EXPECT_CALL(watcher, ready());
+  runTick();
+  EXPECT_TRUE(tick_enabled_);
+
+  uint32_t wakeups = 0;
+  while (sinceStart() < std::chrono::minutes(10) - std::chrono::seconds(1)) {
+    runTick();
+    wakeups++;
+  }
+  EXPECT_GT(1000U, wakeups);
+
+  EXPECT_CALL(watcher, ready());
+  advance(std::chrono::seconds(2));
+  EXPECT_FALSE(tick_enabled_);
+}
+
+} // namespace Event
+} // namespace Envoy
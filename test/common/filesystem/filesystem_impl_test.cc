@@ -1,4 +1,6 @@
 #include <chrono>
+#include <map>
+#include <memory>
 #include <string>
 
 #include "common/api/os_sys_calls_impl.h"
@@ -312,6 +314,46 @@ TEST(FilesystemImpl, reopenThrows) {
   timer->callback_();
 }
 
+// All files are flushed by a single shared flush thread.
+TEST(FilesystemImpl, sharedFlushThread) {
+  NiceMock<Event::MockDispatcher> dispatcher;
+  NiceMock<Event::MockTimer>* timer1 = new NiceMock<Event::MockTimer>(&dispatcher);
+  Thread::MutexBasicLockable mutex;
+  Stats::IsolatedStoreImpl stats_store;
+  NiceMock<Api::MockOsSysCalls> os_sys_calls;
+  TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
+
+  EXPECT_CALL(os_sys_calls, open_(_, _, _)).WillOnce(Return(5)).WillOnce(Return(6));
+  Filesystem::FileImpl file1("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40));
+  NiceMock<Event::MockTimer>* timer2 = new NiceMock<Event::MockTimer>(&dispatcher);
+  Filesystem::FileImpl file2("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40));
+
+  std::map<int, std::string> written;
+  EXPECT_CALL(os_sys_calls, write_(_, _, _))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](int fd, const void* buffer, size_t num_bytes) -> ssize_t {
+        written[fd] = std::string(reinterpret_cast<const char*>(buffer), num_bytes);
+        return num_bytes;
+      }));
+
+  file1.write("one");
+  file2.write("two");
+  std::shared_ptr<Filesystem::FileFlusher> flusher = Filesystem::FileFlusher::get();
+  EXPECT_EQ(flusher, Filesystem::FileFlusher::get());
+  timer1->callback_();
+  timer2->callback_();
+
+  {
+    std::unique_lock<Thread::BasicLockable> lock(os_sys_calls.write_mutex_);
+    while (os_sys_calls.num_writes_ != 2) {
+      os_sys_calls.write_event_.wait(os_sys_calls.write_mutex_);
+    }
+  }
+
+  EXPECT_EQ("one", written[5]);
+  EXPECT_EQ("two", written[6]);
+}
+
 TEST(FilesystemImpl, bigDataChunkShouldBeFlushedWithoutTimer) {
   NiceMock<Event::MockDispatcher> dispatcher;
   Thread::MutexBasicLockable mutex;
@@ -0,0 +1,65 @@
+#include <chrono>
+#include <memory>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/filter/local_ratelimit.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/network/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::_;
+
+namespace Envoy {
+namespace RateLimit {
+namespace TcpFilter {
+
+class LocalRateLimitFilterTest : public testing::Test {
+public:
+  LocalRateLimitFilterTest() {
+    fill_timer_ = new NiceMock<Event::MockTimer>(&tls_.dispatcher_);
+    config_.reset(new LocalRateLimitConfig(std::chrono::milliseconds(1000), {2, 1}, "name",
+                                           stats_store_, tls_));
+  }
+
+  Network::FilterStatus newConnection() {
+    LocalRateLimitFilter filter(config_);
+    filter.initializeReadFilterCallbacks(filter_callbacks_);
+    return filter.onNewConnection();
+  }
+
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  Event::MockTimer* fill_timer_{};
+  Stats::IsolatedStoreImpl stats_store_;
+  LocalRateLimitConfigSharedPtr config_;
+  NiceMock<Network::MockReadFilterCallbacks> filter_callbacks_;
+};
+
+TEST_F(LocalRateLimitFilterTest, Limit) {
+  EXPECT_CALL(filter_callbacks_.connection_, close(_)).Times(0);
+  EXPECT_EQ(Network::FilterStatus::Continue, newConnection());
+  EXPECT_EQ(Network::FilterStatus::Continue, newConnection());
+
+  EXPECT_CALL(filter_callbacks_.connection_, close(Network::ConnectionCloseType::NoFlush));
+  EXPECT_EQ(Network::FilterStatus::StopIteration, newConnection());
+
+  fill_timer_->callback_();
+  EXPECT_CALL(filter_callbacks_.connection_, close(_)).Times(0);
+  EXPECT_EQ(Network::FilterStatus::Continue, newConnection());
+
+  Buffer::OwnedImpl data("hello");
+  LocalRateLimitFilter filter(config_);
+  EXPECT_EQ(Network::FilterStatus::Continue, filter.onData(data));
+
+  EXPECT_EQ(3U, stats_store_.counter("local_ratelimit.name.ok").value());
+  EXPECT_EQ(1U, stats_store_.counter("local_ratelimit.name.rate_limited").value());
+}
+
+} // namespace TcpFilter
+} // namespace RateLimit
+} // namespace Envoy
@@ -1,4 +1,6 @@
+#include <chrono>
 #include <cstdint>
+#include <list>
 #include <memory>
 #include <string>
 
@@ -11,6 +13,7 @@
 
 #include "test/common/upstream/utility.h"
 #include "test/mocks/buffer/mocks.h"
+#include "test/mocks/event/mocks.h"
 #include "test/mocks/network/mocks.h"
 #include "test/mocks/runtime/mocks.h"
 #include "test/mocks/server/mocks.h"
@@ -21,8 +24,10 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::DoAll;
 using testing::MatchesRegex;
 using testing::NiceMock;
+using testing::Ref;
 using testing::Return;
 using testing::ReturnPointee;
 using testing::ReturnRef;
@@ -499,9 +504,9 @@ public:
     upstream_connections_.at(conn_index)->raiseEvent(Network::ConnectionEvent::Connected);
   }
 
-  TcpProxyConfigSharedPtr config_;
   NiceMock<Network::MockReadFilterCallbacks> filter_callbacks_;
   NiceMock<Server::Configuration::MockFactoryContext> factory_context_;
+  TcpProxyConfigSharedPtr config_;
   std::vector<std::shared_ptr<NiceMock<Upstream::MockHost>>> upstream_hosts_{};
   std::vector<NiceMock<Network::MockClientConnection>*> upstream_connections_{};
   std::vector<Upstream::MockHost::MockCreateConnectionData> conn_infos_;
@@ -787,6 +792,223 @@ TEST_F(TcpProxyTest, AccessLogBytesRxTxDuration) {
                   "bytesreceived=1 bytessent=2 datetime=[0-9-]+T[0-9:.]+Z nonzeronum=[1-9][0-9]*"));
 }
 
+// With splicing enabled at runtime, both directions are spliced once upstream is connected, and
+// the spliced bytes are logged.
+TEST_F(TcpProxyTest, Splice) {
+  ON_CALL(factory_context_.runtime_loader_.snapshot_,
+          featureEnabled("tcp_proxy.splice_enabled", 0))
+      .WillByDefault(Return(true));
+  setup(1, accessLogConfig("bytesreceived=%BYTES_RECEIVED% bytessent=%BYTES_SENT%"));
+
+  Network::SpliceCb downstream_cb;
+  Network::SpliceCb upstream_cb;
+  EXPECT_CALL(filter_callbacks_.connection_, spliceTo(Ref(*upstream_connections_.at(0)), _))
+      .WillOnce(DoAll(SaveArg<1>(&downstream_cb), Return(true)));
+  EXPECT_CALL(*upstream_connections_.at(0), spliceTo(Ref(filter_callbacks_.connection_), _))
+      .WillOnce(DoAll(SaveArg<1>(&upstream_cb), Return(true)));
+  raiseEventUpstreamConnected(0);
+  EXPECT_EQ(1U, factory_context_.scope_.counter("tcp.name.downstream_cx_splice_total").value());
+
+  downstream_cb(10);
+  upstream_cb(20);
+  upstream_connections_.at(0)->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  filter_.reset();
+  EXPECT_EQ("bytesreceived=10 bytessent=20", access_log_data_);
+}
+
+// Splicing is off by default.
+TEST_F(TcpProxyTest, SpliceDisabled) {
+  setup(1);
+  EXPECT_CALL(filter_callbacks_.connection_, spliceTo(_, _)).Times(0);
+  EXPECT_CALL(*upstream_connections_.at(0), spliceTo(_, _)).Times(0);
+  raiseEventUpstreamConnected(0);
+  EXPECT_EQ(0U, factory_context_.scope_.counter("tcp.name.downstream_cx_splice_total").value());
+}
+
+// A connection pre-warmed by the pool is claimed without connecting, and data flows right away.
+TEST_F(TcpProxyTest, PrewarmedUpstreamConnection) {
+  ON_CALL(factory_context_.runtime_loader_.snapshot_, getInteger("tcp_proxy.upstream_pool_size", 0))
+      .WillByDefault(Return(1));
+  configure(defaultConfig());
+
+  NiceMock<Network::MockClientConnection>* upstream_connection =
+      new NiceMock<Network::MockClientConnection>();
+  Network::ReadFilterSharedPtr pool_read_filter;
+  EXPECT_CALL(*upstream_connection, addReadFilter(_))
+      .WillOnce(SaveArg<0>(&pool_read_filter))
+      .WillOnce(SaveArg<0>(&upstream_read_filter_));
+  std::shared_ptr<NiceMock<Upstream::MockHost>> upstream_host(
+      new NiceMock<Upstream::MockHost>());
+  Upstream::MockHost::MockCreateConnectionData conn_info;
+  conn_info.connection_ = upstream_connection;
+  conn_info.host_description_ = upstream_host;
+  EXPECT_CALL(factory_context_.cluster_manager_, tcpConnForCluster_("fake_cluster", _))
+      .WillOnce(Return(conn_info))
+      .WillRepeatedly(Return(Upstream::MockHost::MockCreateConnectionData()));
+  new NiceMock<Event::MockTimer>(&factory_context_.thread_local_.dispatcher_);
+
+  // Nothing is established yet when the pool is first used.
+  EXPECT_EQ(nullptr, config_->upstreamPool().claim("fake_cluster").connection_);
+  EXPECT_CALL(*upstream_connection, readDisable(true));
+  upstream_connection->raiseEvent(Network::ConnectionEvent::Connected);
+
+  filter_.reset(new TcpProxy(config_, factory_context_.cluster_manager_));
+  filter_->initializeReadFilterCallbacks(filter_callbacks_);
+  EXPECT_CALL(*upstream_connection, readDisable(false));
+  EXPECT_CALL(filter_callbacks_.connection_, readDisable(false));
+  EXPECT_EQ(Network::FilterStatus::Continue, filter_->onNewConnection());
+  EXPECT_EQ(1U, factory_context_.scope_.counter("tcp.name.upstream_cx_prewarm_claimed").value());
+  // The pool already counted the connection.
+  EXPECT_EQ(1U, upstream_host->stats_.cx_total_.value());
+  EXPECT_EQ(1U, upstream_host->stats_.cx_active_.value());
+
+  Buffer::OwnedImpl buffer("hello");
+  EXPECT_CALL(*upstream_connection, write(BufferEqual(&buffer)));
+  filter_->onData(buffer);
+
+  Buffer::OwnedImpl response("world");
+  EXPECT_CALL(filter_callbacks_.connection_, write(BufferEqual(&response)));
+  EXPECT_EQ(Network::FilterStatus::Continue, pool_read_filter->onData(response));
+  upstream_read_filter_->onData(response);
+
+  EXPECT_CALL(*upstream_connection, close(Network::ConnectionCloseType::NoFlush));
+  filter_callbacks_.connection_.raiseEvent(Network::ConnectionEvent::RemoteClose);
+}
+
+class TcpProxyUpstreamPoolTest : public testing::Test {
+public:
+  TcpProxyUpstreamPoolTest() {
+    ON_CALL(runtime_.snapshot_, getInteger("tcp_proxy.upstream_pool_size", 0))
+        .WillByDefault(Return(1));
+    ON_CALL(runtime_.snapshot_, getInteger("tcp_proxy.upstream_pool_max_idle_ms", 60000))
+        .WillByDefault(Return(1000));
+    pool_.reset(new TcpProxyUpstreamPool(cluster_manager_, runtime_, dispatcher_, stats_));
+  }
+
+  // Expect the pool to open one more connection.
+  void expectPrewarm() {
+    connections_.push_back(new NiceMock<Network::MockClientConnection>());
+    hosts_.push_back(std::make_shared<NiceMock<Upstream::MockHost>>());
+    timers_.push_back(new NiceMock<Event::MockTimer>(&dispatcher_));
+    read_filters_.emplace_back();
+
+    Upstream::MockHost::MockCreateConnectionData conn_info;
+    conn_info.connection_ = connections_.back();
+    conn_info.host_description_ = hosts_.back();
+    EXPECT_CALL(cluster_manager_, tcpConnForCluster_("fake_cluster", _))
+        .WillOnce(Return(conn_info))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*connections_.back(), addReadFilter(_))
+        .WillOnce(SaveArg<0>(&read_filters_.back()));
+    EXPECT_CALL(*connections_.back(), connect());
+    EXPECT_CALL(*timers_.back(), enableTimer(std::chrono::milliseconds(1)));
+  }
+
+  void raiseConnected(uint32_t index) {
+    EXPECT_CALL(*connections_.at(index), readDisable(true));
+    EXPECT_CALL(*timers_.at(index), enableTimer(std::chrono::milliseconds(1000)));
+    EXPECT_CALL(hosts_.at(index)->outlier_detector_,
+                putResult(Upstream::Outlier::Result::SUCCESS));
+    connections_.at(index)->raiseEvent(Network::ConnectionEvent::Connected);
+  }
+
+  Stats::IsolatedStoreImpl store_;
+  TcpProxyStats stats_{ALL_TCP_PROXY_STATS(POOL_COUNTER_PREFIX(store_, "tcp.name."),
+                                           POOL_GAUGE_PREFIX(store_, "tcp.name."))};
+  NiceMock<Upstream::MockClusterManager> cluster_manager_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  std::vector<NiceMock<Network::MockClientConnection>*> connections_;
+  std::vector<std::shared_ptr<NiceMock<Upstream::MockHost>>> hosts_;
+  std::vector<NiceMock<Event::MockTimer>*> timers_;
+  std::list<Network::ReadFilterSharedPtr> read_filters_;
+  std::unique_ptr<TcpProxyUpstreamPool> pool_;
+};
+
+TEST_F(TcpProxyUpstreamPoolTest, Disabled) {
+  ON_CALL(runtime_.snapshot_, getInteger("tcp_proxy.upstream_pool_size", 0))
+      .WillByDefault(Return(0));
+  EXPECT_CALL(cluster_manager_, tcpConnForCluster_(_, _)).Times(0);
+  EXPECT_EQ(nullptr, pool_->claim("fake_cluster").connection_);
+}
+
+TEST_F(TcpProxyUpstreamPoolTest, OriginalDstCluster) {
+  cluster_manager_.thread_local_cluster_.cluster_.info_->lb_type_ =
+      Upstream::LoadBalancerType::OriginalDst;
+  EXPECT_CALL(cluster_manager_, tcpConnForCluster_(_, _)).Times(0);
+  EXPECT_EQ(nullptr, pool_->claim("fake_cluster").connection_);
+}
+
+// Only established connections are claimed, and each claim tops the pool up.
+TEST_F(TcpProxyUpstreamPoolTest, Claim) {
+  expectPrewarm();
+  EXPECT_EQ(nullptr, pool_->claim("fake_cluster").connection_);
+  EXPECT_EQ(nullptr, pool_->claim("fake_cluster").connection_);
+  EXPECT_EQ(1U, hosts_.at(0)->stats_.cx_active_.value());
+
+  raiseConnected(0);
+  expectPrewarm();
+  Upstream::Host::CreateConnectionData conn_info = pool_->claim("fake_cluster");
+  EXPECT_EQ(connections_.at(0), conn_info.connection_.get());
+  EXPECT_EQ(hosts_.at(0), conn_info.host_description_);
+  EXPECT_EQ(1U, store_.counter("tcp.name.upstream_cx_prewarm_claimed").value());
+  EXPECT_EQ(2U, store_.counter("tcp.name.upstream_cx_prewarm_total").value());
+
+  // Events of a claimed connection are no concern of the pool.
+  connections_.at(0)->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  EXPECT_EQ(0U, hosts_.at(0)->cluster_.stats_store_.counter("upstream_cx_destroy").value());
+
+  EXPECT_CALL(*connections_.at(1), close(Network::ConnectionCloseType::NoFlush));
+  pool_.reset();
+  EXPECT_EQ(0U, hosts_.at(1)->stats_.cx_active_.value());
+}
+
+TEST_F(TcpProxyUpstreamPoolTest, IdleTimeout) {
+  expectPrewarm();
+  pool_->claim("fake_cluster");
+  raiseConnected(0);
+
+  EXPECT_CALL(*connections_.at(0), close(Network::ConnectionCloseType::NoFlush));
+  EXPECT_CALL(dispatcher_, deferredDelete_(_));
+  timers_.at(0)->callback_();
+  EXPECT_EQ(1U, store_.counter("tcp.name.upstream_cx_prewarm_idle_timeout").value());
+  EXPECT_EQ(1U, hosts_.at(0)->cluster_.stats_store_.counter("upstream_cx_destroy_local").value());
+  EXPECT_EQ(0U, hosts_.at(0)->stats_.cx_active_.value());
+
+  // The pool is only topped up when it's used.
+  expectPrewarm();
+  EXPECT_EQ(nullptr, pool_->claim("fake_cluster").connection_);
+}
+
+TEST_F(TcpProxyUpstreamPoolTest, ConnectTimeout) {
+  expectPrewarm();
+  pool_->claim("fake_cluster");
+
+  EXPECT_CALL(hosts_.at(0)->outlier_detector_, putResult(Upstream::Outlier::Result::TIMEOUT));
+  EXPECT_CALL(*connections_.at(0), close(Network::ConnectionCloseType::NoFlush));
+  timers_.at(0)->callback_();
+  EXPECT_EQ(1U, hosts_.at(0)->cluster_.stats_store_.counter("upstream_cx_connect_timeout").value());
+}
+
+TEST_F(TcpProxyUpstreamPoolTest, RemoteClose) {
+  expectPrewarm();
+  pool_->claim("fake_cluster");
+
+  EXPECT_CALL(hosts_.at(0)->outlier_detector_,
+              putResult(Upstream::Outlier::Result::CONNECT_FAILED));
+  connections_.at(0)->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  EXPECT_EQ(1U, hosts_.at(0)->cluster_.stats_store_.counter("upstream_cx_connect_fail").value());
+  EXPECT_EQ(1U, hosts_.at(0)->stats_.cx_connect_fail_.value());
+
+  expectPrewarm();
+  pool_->claim("fake_cluster");
+  raiseConnected(1);
+  connections_.at(1)->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  EXPECT_EQ(1U, hosts_.at(1)->cluster_.stats_store_.counter("upstream_cx_destroy_remote").value());
+  EXPECT_EQ(0U, hosts_.at(1)->stats_.cx_connect_fail_.value());
+  EXPECT_EQ(0U, hosts_.at(1)->stats_.cx_active_.value());
+}
+
 class TcpProxyRoutingTest : public testing::Test {
 public:
   TcpProxyRoutingTest() {
@@ -815,10 +1037,10 @@ public:
     filter_->initializeReadFilterCallbacks(filter_callbacks_);
   }
 
-  TcpProxyConfigSharedPtr config_;
   NiceMock<Network::MockConnection> connection_;
   NiceMock<Network::MockReadFilterCallbacks> filter_callbacks_;
   NiceMock<Server::Configuration::MockFactoryContext> factory_context_;
+  TcpProxyConfigSharedPtr config_;
   std::unique_ptr<TcpProxy> filter_;
 };
 
@@ -644,6 +644,65 @@ TEST_F(GrpcAsyncClientImplTest, CancelRequest) {
   request->grpc_request_->cancel();
 }
 
+// Validate that a stream to a cluster supporting gRPC compression sends its large messages
+// compressed, and decompresses the messages of a server which compresses them.
+TEST_F(GrpcAsyncClientImplTest, CompressedStream) {
+  ON_CALL(*cm_.thread_local_cluster_.cluster_.info_, features())
+      .WillByDefault(Return(Upstream::ClusterInfo::Features::GRPC_COMPRESSION));
+  Http::MockAsyncClientStream http_stream;
+  Http::AsyncClient::StreamCallbacks* http_callbacks{};
+  NiceMock<MockAsyncStreamCallbacks<helloworld::HelloReply>> callbacks;
+  EXPECT_CALL(http_client_, start(_, _, false))
+      .WillOnce(Invoke([&](Http::AsyncClient::StreamCallbacks& stream_callbacks,
+                           const Optional<std::chrono::milliseconds>&, bool) {
+        http_callbacks = &stream_callbacks;
+        return &http_stream;
+      }));
+  EXPECT_CALL(http_stream, sendHeaders(_, false))
+      .WillOnce(Invoke([](Http::HeaderMap& headers, bool) {
+        EXPECT_STREQ("gzip", headers.get(Http::Headers::get().GrpcEncoding)->value().c_str());
+        EXPECT_STREQ("identity,gzip", headers.GrpcAcceptEncoding()->value().c_str());
+      }));
+  AsyncStream<helloworld::HelloRequest>* grpc_stream =
+      grpc_client_->start(*method_descriptor_, callbacks);
+  ASSERT_NE(nullptr, grpc_stream);
+
+  helloworld::HelloRequest request;
+  request.set_name(HELLO_REQUEST);
+  EXPECT_CALL(http_stream, sendData(BufferStringEqual(std::string(HELLO_REQUEST_DATA,
+                                                                   HELLO_REQUEST_SIZE)),
+                                    false));
+  grpc_stream->sendMessage(request, false);
+
+  request.set_name(std::string(2000, 'a'));
+  EXPECT_CALL(http_stream, sendData(_, false))
+      .WillOnce(Invoke([](Buffer::Instance& data, bool) {
+        std::vector<Frame> frames;
+        EXPECT_TRUE(Decoder().decode(data, frames));
+        ASSERT_EQ(1U, frames.size());
+        EXPECT_EQ(GRPC_FH_COMPRESSED, frames[0].flags_);
+        EXPECT_GT(100U, frames[0].length_);
+        helloworld::HelloRequest decompressed;
+        EXPECT_TRUE(decompressed.ParseFromString(
+            TestUtility::bufferToString(*Common::decompressBody(*frames[0].data_))));
+        EXPECT_EQ(std::string(2000, 'a'), decompressed.name());
+      }));
+  grpc_stream->sendMessage(request, false);
+
+  EXPECT_CALL(callbacks, onReceiveInitialMetadata_(_));
+  http_callbacks->onHeaders(Http::HeaderMapPtr{new Http::TestHeaderMapImpl{
+                                {":status", "200"}, {"grpc-encoding", "gzip"}}},
+                            false);
+  helloworld::HelloReply reply;
+  reply.set_message(std::string(2000, 'b'));
+  Buffer::InstancePtr reply_buffer = Common::serializeBody(reply, *Common::createGzipCompressor());
+  EXPECT_CALL(callbacks, onReceiveMessage_(HelloworldReplyEq(std::string(2000, 'b'))));
+  http_callbacks->onData(*reply_buffer, false);
+
+  EXPECT_CALL(http_stream, reset());
+  grpc_stream->resetStream();
+}
+
 } // namespace
 } // namespace Grpc
 } // namespace Envoy
@@ -8,6 +8,7 @@
 
 #include "test/proto/helloworld.pb.h"
 #include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
 
 #include "gtest/gtest.h"
 
@@ -166,5 +167,78 @@ TEST(GrpcCodecTest, decodeMultipleFrame) {
   }
 }
 
+TEST(GrpcCodecTest, decodeFramesSplitAcrossSlices) {
+  helloworld::HelloRequest request;
+  request.set_name("hello");
+
+  std::string wire;
+  std::array<uint8_t, 5> header;
+  Encoder encoder;
+  encoder.newFrame(GRPC_FH_DEFAULT, request.ByteSize(), header);
+  for (int i = 0; i < 3; i++) {
+    wire.append(reinterpret_cast<const char*>(header.data()), header.size());
+    wire.append(request.SerializeAsString());
+  }
+
+  // Split the input at every position so that headers and data straddle slices in every possible
+  // way, and feed each slice to the decoder separately as well as all of them at once.
+  for (size_t split = 1; split < wire.size(); split++) {
+    // The fragments must outlive the buffers and the frames.
+    Buffer::BufferFragmentImpl first(wire.data(), split, nullptr);
+    Buffer::BufferFragmentImpl second(wire.data() + split, wire.size() - split, nullptr);
+    Buffer::BufferFragmentImpl separate_first(wire.data(), split, nullptr);
+    Buffer::BufferFragmentImpl separate_second(wire.data() + split, wire.size() - split, nullptr);
+
+    std::vector<Frame> frames;
+    Decoder decoder;
+    Buffer::OwnedImpl buffer;
+    buffer.addBufferFragment(first);
+    buffer.addBufferFragment(second);
+    EXPECT_TRUE(decoder.decode(buffer, frames));
+    EXPECT_EQ(0, buffer.length());
+
+    Decoder separate_decoder;
+    Buffer::OwnedImpl separate_buffer;
+    separate_buffer.addBufferFragment(separate_first);
+    EXPECT_TRUE(separate_decoder.decode(separate_buffer, frames));
+    EXPECT_EQ(0, separate_buffer.length());
+    separate_buffer.addBufferFragment(separate_second);
+    EXPECT_TRUE(separate_decoder.decode(separate_buffer, frames));
+    EXPECT_EQ(0, separate_buffer.length());
+
+    ASSERT_EQ(6, frames.size());
+    for (Frame& frame : frames) {
+      EXPECT_EQ(GRPC_FH_DEFAULT, frame.flags_);
+      EXPECT_EQ(static_cast<uint64_t>(request.ByteSize()), frame.length_);
+      EXPECT_EQ(request.SerializeAsString(), TestUtility::bufferToString(*frame.data_));
+    }
+  }
+}
+
+TEST(GrpcCodecTest, decodeInvalidFrameAfterValidFrame) {
+  helloworld::HelloRequest request;
+  request.set_name("hello");
+
+  Buffer::OwnedImpl buffer;
+  std::array<uint8_t, 5> header;
+  Encoder encoder;
+  encoder.newFrame(GRPC_FH_DEFAULT, request.ByteSize(), header);
+  buffer.add(header.data(), 5);
+  buffer.add(request.SerializeAsString());
+  encoder.newFrame(0b10u, request.ByteSize(), header);
+  buffer.add(header.data(), 5);
+  buffer.add(request.SerializeAsString());
+
+  std::vector<Frame> frames;
+  Decoder decoder;
+  EXPECT_FALSE(decoder.decode(buffer, frames));
+  // The valid frame is decoded and the invalid one is left in the input.
+  EXPECT_EQ(1, frames.size());
+  EXPECT_EQ(5 + request.ByteSize(), buffer.length());
+  uint8_t flags;
+  buffer.copyOut(0, 1, &flags);
+  EXPECT_EQ(0b10u, flags);
+}
+
 } // namespace Grpc
 } // namespace Envoy
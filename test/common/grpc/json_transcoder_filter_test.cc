@@ -320,6 +320,83 @@ TEST_F(GrpcJsonTranscoderFilterTest, TranscodingUnaryError) {
   EXPECT_EQ(0, request_data.length());
 }
 
+TEST_F(GrpcJsonTranscoderFilterTest, TranscodingServerStreaming) {
+  Http::TestHeaderMapImpl request_headers{
+      {"content-type", "application/json"}, {":method", "GET"}, {":path", "/shelves/1/books"}};
+
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.decodeHeaders(request_headers, true));
+  EXPECT_EQ("/bookstore.Bookstore/ListBooks", request_headers.get_(":path"));
+
+  Http::TestHeaderMapImpl response_headers{{"content-type", "application/grpc"},
+                                           {":status", "200"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.encodeHeaders(response_headers, false));
+  EXPECT_EQ("application/json", response_headers.get_("content-type"));
+
+  bookstore::Book book;
+  book.set_id(1);
+  book.set_title("Hamlet");
+  auto response_data = Common::serializeBody(book);
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.encodeData(*response_data, false));
+  EXPECT_EQ("[{\"id\":\"1\",\"title\":\"Hamlet\"}", TestUtility::bufferToString(*response_data));
+
+  // A message is only output once its whole frame is received.
+  book.set_id(2);
+  book.set_title("Othello");
+  response_data = Common::serializeBody(book);
+  Buffer::OwnedImpl first_part;
+  first_part.move(*response_data, 3);
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.encodeData(first_part, false));
+  EXPECT_EQ(0, first_part.length());
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.encodeData(*response_data, false));
+  EXPECT_EQ(",{\"id\":\"2\",\"title\":\"Othello\"}",
+            TestUtility::bufferToString(*response_data));
+
+  EXPECT_CALL(encoder_callbacks_, addEncodedData(_, true))
+      .WillOnce(Invoke([](Buffer::Instance& data, bool) {
+        EXPECT_EQ("]", TestUtility::bufferToString(data));
+      }));
+  Http::TestHeaderMapImpl response_trailers{{"grpc-status", "0"}};
+  EXPECT_EQ(Http::FilterTrailersStatus::Continue, filter_.encodeTrailers(response_trailers));
+}
+
+TEST_F(GrpcJsonTranscoderFilterTest, RequestOverBufferLimit) {
+  Http::TestHeaderMapImpl request_headers{
+      {"content-type", "application/json"}, {":method", "POST"}, {":path", "/shelf"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.decodeHeaders(request_headers, false));
+
+  ON_CALL(decoder_callbacks_, decoderBufferLimit()).WillByDefault(Return(8));
+  Buffer::OwnedImpl request_data{"{\"theme\": \"Chil"};
+
+  EXPECT_CALL(decoder_callbacks_, encodeHeaders_(_, false))
+      .WillOnce(Invoke([](Http::HeaderMap& headers, bool) {
+        EXPECT_STREQ("413", headers.Status()->value().c_str());
+      }));
+  EXPECT_CALL(decoder_callbacks_, encodeData(_, true));
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer,
+            filter_.decodeData(request_data, false));
+}
+
+TEST_F(GrpcJsonTranscoderFilterTest, ResponseOverBufferLimit) {
+  Http::TestHeaderMapImpl request_headers{
+      {"content-type", "application/json"}, {":method", "GET"}, {":path", "/shelves/1/books"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.decodeHeaders(request_headers, true));
+
+  Http::TestHeaderMapImpl response_headers{{"content-type", "application/grpc"},
+                                           {":status", "200"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.encodeHeaders(response_headers, false));
+
+  ON_CALL(encoder_callbacks_, encoderBufferLimit()).WillByDefault(Return(8));
+  bookstore::Book book;
+  book.set_title("A title which is longer than the buffer limit");
+  auto response_data = Common::serializeBody(book);
+  Buffer::OwnedImpl first_part;
+  first_part.move(*response_data, 16);
+
+  EXPECT_CALL(encoder_callbacks_, resetStream());
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer,
+            filter_.encodeData(first_part, false));
+}
+
 struct GrpcJsonTranscoderFilterPrintTestParam {
   std::string config_json_;
   std::string expected_response_;
@@ -858,7 +858,9 @@ TEST_F(AsyncClientImplTest, WatermarkCallbacks) {
   stream->sendHeaders(headers, false);
   Http::StreamDecoderFilterCallbacks* filter_callbacks =
       static_cast<Http::AsyncStreamImpl*>(stream);
+  EXPECT_CALL(stream_callbacks_, onAboveWriteBufferHighWatermark());
   filter_callbacks->onDecoderFilterAboveWriteBufferHighWatermark();
+  EXPECT_CALL(stream_callbacks_, onBelowWriteBufferLowWatermark());
   filter_callbacks->onDecoderFilterBelowWriteBufferLowWatermark();
   EXPECT_CALL(stream_callbacks_, onReset());
 }
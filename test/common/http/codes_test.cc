@@ -30,7 +30,8 @@ public:
                    const std::string& to_az = EMPTY_STRING) {
     CodeUtility::ResponseStatInfo info{
         global_store_,      cluster_scope_,        "prefix.", code,  internal_request,
-        request_vhost_name, request_vcluster_name, from_az,   to_az, canary};
+        request_vhost_name, request_vcluster_name, from_az,   to_az, canary,
+        nullptr};
 
     CodeUtility::chargeResponseStat(info);
   }
@@ -90,6 +91,41 @@ TEST_F(CodeUtilityTest, Canary) {
   EXPECT_EQ(16U, cluster_scope_.counters().size());
 }
 
+TEST_F(CodeUtilityTest, CodeStats) {
+  CodeStatsImpl code_stats(cluster_scope_);
+  for (uint64_t code : {200, 200, 503, 100, 600}) {
+    CodeUtility::ResponseStatInfo info{global_store_, cluster_scope_, EMPTY_STRING,
+                                       code,          code == 503,    EMPTY_STRING,
+                                       EMPTY_STRING,  "from_az",      "to_az",
+                                       code == 200,   &code_stats};
+    CodeUtility::chargeResponseStat(info);
+  }
+  CodeUtility::chargeBasicResponseStat(code_stats, CodeStats::Prefix::Retry,
+                                       Code::ServiceUnavailable);
+
+  EXPECT_EQ(2U, cluster_scope_.counter("upstream_rq_2xx").value());
+  EXPECT_EQ(2U, cluster_scope_.counter("upstream_rq_200").value());
+  EXPECT_EQ(2U, cluster_scope_.counter("canary.upstream_rq_2xx").value());
+  EXPECT_EQ(2U, cluster_scope_.counter("canary.upstream_rq_200").value());
+  EXPECT_EQ(2U, cluster_scope_.counter("external.upstream_rq_200").value());
+  EXPECT_EQ(2U, cluster_scope_.counter("zone.from_az.to_az.upstream_rq_200").value());
+  EXPECT_EQ(1U, cluster_scope_.counter("upstream_rq_5xx").value());
+  EXPECT_EQ(1U, cluster_scope_.counter("upstream_rq_503").value());
+  EXPECT_EQ(1U, cluster_scope_.counter("internal.upstream_rq_5xx").value());
+  EXPECT_EQ(1U, cluster_scope_.counter("internal.upstream_rq_503").value());
+  EXPECT_EQ(1U, cluster_scope_.counter("retry.upstream_rq_5xx").value());
+  EXPECT_EQ(1U, cluster_scope_.counter("retry.upstream_rq_503").value());
+  EXPECT_EQ(1U, cluster_scope_.counter("upstream_rq_100").value());
+  EXPECT_EQ(1U, cluster_scope_.counter("upstream_rq_600").value());
+  EXPECT_EQ(2U, cluster_scope_.counter("upstream_rq_").value());
+
+  // The counters are the ones of the scope.
+  EXPECT_EQ(&cluster_scope_.counter("upstream_rq_503"),
+            &code_stats.codeCounter(CodeStats::Prefix::None, Code::ServiceUnavailable));
+  EXPECT_EQ(&cluster_scope_.counter("retry.upstream_rq_5xx"),
+            &code_stats.groupCounter(CodeStats::Prefix::Retry, Code::ServiceUnavailable));
+}
+
 TEST_F(CodeUtilityTest, All) {
   const std::vector<std::pair<Code, std::string>> test_set = {
       std::make_pair(Code::Continue, "Continue"),
@@ -133,6 +169,7 @@ TEST_F(CodeUtilityTest, All) {
       std::make_pair(Code::UnprocessableEntity, "Unprocessable Entity"),
       std::make_pair(Code::Locked, "Locked"),
       std::make_pair(Code::FailedDependency, "Failed Dependency"),
+      std::make_pair(Code::TooEarly, "Too Early"),
       std::make_pair(Code::UpgradeRequired, "Upgrade Required"),
       std::make_pair(Code::PreconditionRequired, "Precondition Required"),
       std::make_pair(Code::TooManyRequests, "Too Many Requests"),
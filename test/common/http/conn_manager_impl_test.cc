@@ -29,6 +29,7 @@
 #include "test/mocks/local_info/mocks.h"
 #include "test/mocks/network/mocks.h"
 #include "test/mocks/runtime/mocks.h"
+#include "test/mocks/server/mocks.h"
 #include "test/mocks/ssl/mocks.h"
 #include "test/mocks/tracing/mocks.h"
 #include "test/mocks/upstream/mocks.h"
@@ -43,6 +44,7 @@ using testing::DoAll;
 using testing::InSequence;
 using testing::Invoke;
 using testing::InvokeWithoutArgs;
+using testing::MatchesRegex;
 using testing::NiceMock;
 using testing::Ref;
 using testing::Return;
@@ -80,6 +82,10 @@ public:
     // response_encoder_ is not a NiceMock on purpose. This prevents complaining about this
     // method only.
     EXPECT_CALL(response_encoder_, getStream()).Times(AtLeast(0));
+    // Every stream checks whether to time its filters, which tests expecting other runtime
+    // features must allow.
+    EXPECT_CALL(runtime_.snapshot_, featureEnabled("http.filter_timing.enabled", 0))
+        .Times(AnyNumber());
   }
 
   ~HttpConnectionManagerImplTest() {
@@ -98,7 +104,8 @@ public:
     ON_CALL(filter_callbacks_.connection_, remoteAddress())
         .WillByDefault(ReturnRef(remote_address_));
     conn_manager_.reset(new ConnectionManagerImpl(*this, drain_close_, random_, tracer_, runtime_,
-                                                  local_info_, cluster_manager_));
+                                                  local_info_, cluster_manager_,
+                                                  overload_manager_));
     conn_manager_->initializeReadFilterCallbacks(filter_callbacks_);
 
     if (tracing) {
@@ -272,6 +279,7 @@ public:
   MockStream stream_;
   Http::StreamCallbacks* stream_callbacks_{nullptr};
   NiceMock<Upstream::MockClusterManager> cluster_manager_;
+  NiceMock<Server::MockOverloadManager> overload_manager_;
   uint32_t initial_buffer_limit_{};
   bool streaming_filter_{false};
   Stats::IsolatedStoreImpl fake_listener_stats_;
@@ -345,6 +353,28 @@ TEST_F(HttpConnectionManagerImplTest, HeaderOnlyRequestAndResponse) {
   EXPECT_EQ(1U, listener_stats_.downstream_rq_2xx_.value());
 }
 
+TEST_F(HttpConnectionManagerImplTest, EarlyDataNonIdempotentRequest) {
+  setup(true, "");
+  ON_CALL(*ssl_connection_, lastReadEarlyData()).WillByDefault(Return(true));
+
+  EXPECT_CALL(*codec_, dispatch(_)).WillOnce(Invoke([&](Buffer::Instance& data) -> void {
+    StreamDecoder* decoder = &conn_manager_->newStream(response_encoder_);
+    HeaderMapPtr headers{new TestHeaderMapImpl{
+        {":authority", "host"}, {":path", "/"}, {":method", "POST"}}};
+    decoder->decodeHeaders(std::move(headers), true);
+    data.drain(4);
+  }));
+
+  EXPECT_CALL(response_encoder_, encodeHeaders(_, true))
+      .WillOnce(Invoke([](const HeaderMap& headers, bool) -> void {
+        EXPECT_STREQ("425", headers.Status()->value().c_str());
+      }));
+
+  Buffer::OwnedImpl fake_input("1234");
+  conn_manager_->onData(fake_input);
+  EXPECT_EQ(1U, stats_.named_.downstream_rq_too_early_.value());
+}
+
 TEST_F(HttpConnectionManagerImplTest, InvalidPathWithDualFilter) {
   InSequence s;
   setup(false, "");
@@ -410,7 +440,7 @@ TEST_F(HttpConnectionManagerImplTest, StartAndFinishSpanNormalFlow) {
 
   // Treat request as internal, otherwise x-request-id header will be overwritten.
   use_remote_address_ = false;
-  EXPECT_CALL(random_, uuid()).Times(0);
+  EXPECT_CALL(random_, uuid(_)).Times(0);
 
   StreamDecoder* decoder = nullptr;
   NiceMock<MockStreamEncoder> encoder;
@@ -474,7 +504,7 @@ TEST_F(HttpConnectionManagerImplTest, StartAndFinishSpanNormalFlowIngressDecorat
 
   // Treat request as internal, otherwise x-request-id header will be overwritten.
   use_remote_address_ = false;
-  EXPECT_CALL(random_, uuid()).Times(0);
+  EXPECT_CALL(random_, uuid(_)).Times(0);
 
   StreamDecoder* decoder = nullptr;
   NiceMock<MockStreamEncoder> encoder;
@@ -535,7 +565,7 @@ TEST_F(HttpConnectionManagerImplTest, StartAndFinishSpanNormalFlowIngressDecorat
 
   // Treat request as internal, otherwise x-request-id header will be overwritten.
   use_remote_address_ = false;
-  EXPECT_CALL(random_, uuid()).Times(0);
+  EXPECT_CALL(random_, uuid(_)).Times(0);
 
   StreamDecoder* decoder = nullptr;
   NiceMock<MockStreamEncoder> encoder;
@@ -601,7 +631,7 @@ TEST_F(HttpConnectionManagerImplTest, StartAndFinishSpanNormalFlowEgressDecorato
 
   // Treat request as internal, otherwise x-request-id header will be overwritten.
   use_remote_address_ = false;
-  EXPECT_CALL(random_, uuid()).Times(0);
+  EXPECT_CALL(random_, uuid(_)).Times(0);
 
   StreamDecoder* decoder = nullptr;
   NiceMock<MockStreamEncoder> encoder;
@@ -668,7 +698,7 @@ TEST_F(HttpConnectionManagerImplTest, StartAndFinishSpanNormalFlowEgressDecorato
 
   // Treat request as internal, otherwise x-request-id header will be overwritten.
   use_remote_address_ = false;
-  EXPECT_CALL(random_, uuid()).Times(0);
+  EXPECT_CALL(random_, uuid(_)).Times(0);
 
   StreamDecoder* decoder = nullptr;
   NiceMock<MockStreamEncoder> encoder;
@@ -735,6 +765,49 @@ TEST_F(HttpConnectionManagerImplTest, TestAccessLog) {
   conn_manager_->onData(fake_input);
 }
 
+TEST_F(HttpConnectionManagerImplTest, FilterTimings) {
+  setup(false, "", false);
+  ON_CALL(runtime_.snapshot_, featureEnabled("http.filter_timing.enabled", 0))
+      .WillByDefault(Return(true));
+
+  std::shared_ptr<MockStreamFilter> dual_filter(new NiceMock<MockStreamFilter>());
+  std::shared_ptr<MockStreamDecoderFilter> filter(new NiceMock<MockStreamDecoderFilter>());
+  std::shared_ptr<AccessLog::MockInstance> handler(new NiceMock<AccessLog::MockInstance>());
+
+  EXPECT_CALL(filter_factory_, createFilterChain(_))
+      .WillOnce(Invoke([&](FilterChainFactoryCallbacks& callbacks) -> void {
+        callbacks.addStreamFilter(dual_filter);
+        callbacks.addStreamDecoderFilter(filter);
+        callbacks.addAccessLogHandler(handler);
+      }));
+
+  EXPECT_CALL(*filter, decodeHeaders(_, true))
+      .WillOnce(Return(FilterHeadersStatus::StopIteration));
+
+  EXPECT_CALL(*handler, log(_, _, _))
+      .WillOnce(Invoke(
+          [](const HeaderMap*, const HeaderMap*, const AccessLog::RequestInfo& request_info) {
+            EXPECT_THAT(request_info.filterTimings(),
+                        MatchesRegex("d0:[0-9]+:0,d1:[0-9]+:[0-9]+,e0:[0-9]+:0"));
+          }));
+
+  NiceMock<MockStreamEncoder> encoder;
+  EXPECT_CALL(*codec_, dispatch(_)).WillRepeatedly(Invoke([&](Buffer::Instance& data) -> void {
+    StreamDecoder* decoder = &conn_manager_->newStream(encoder);
+    HeaderMapPtr headers{
+        new TestHeaderMapImpl{{":method", "GET"}, {":authority", "host"}, {":path", "/"}}};
+    decoder->decodeHeaders(std::move(headers), true);
+
+    HeaderMapPtr response_headers{new TestHeaderMapImpl{{":status", "200"}}};
+    filter->callbacks_->encodeHeaders(std::move(response_headers), true);
+
+    data.drain(4);
+  }));
+
+  Buffer::OwnedImpl fake_input("1234");
+  conn_manager_->onData(fake_input);
+}
+
 TEST_F(HttpConnectionManagerImplTest, DoNotStartSpanIfTracingIsNotEnabled) {
   setup(false, "");
 
@@ -800,7 +873,7 @@ TEST_F(HttpConnectionManagerImplTest, StartSpanOnlyHealthCheckRequest) {
 
   // Treat request as internal, otherwise x-request-id header will be overwritten.
   use_remote_address_ = false;
-  EXPECT_CALL(random_, uuid()).Times(0);
+  EXPECT_CALL(random_, uuid(_)).Times(0);
 
   StreamDecoder* decoder = nullptr;
   NiceMock<MockStreamEncoder> encoder;
@@ -853,6 +926,74 @@ TEST_F(HttpConnectionManagerImplTest, NoPath) {
   conn_manager_->onData(fake_input);
 }
 
+TEST_F(HttpConnectionManagerImplTest, OverloadRejectsRequests) {
+  setup(false, "");
+  ON_CALL(overload_manager_, isActive(Server::OverloadActionType::StopAcceptingRequests))
+      .WillByDefault(Return(true));
+
+  StreamDecoder* decoder = nullptr;
+  NiceMock<MockStreamEncoder> encoder;
+  EXPECT_CALL(*codec_, dispatch(_)).WillOnce(Invoke([&](Buffer::Instance& data) -> void {
+    decoder = &conn_manager_->newStream(encoder);
+    HeaderMapPtr headers{new TestHeaderMapImpl{{":authority", "host"}, {":path", "/"}}};
+    decoder->decodeHeaders(std::move(headers), true);
+    data.drain(4);
+  }));
+
+  // The filter chain is never created for a rejected request.
+  EXPECT_CALL(filter_factory_, createFilterChain(_)).Times(0);
+  EXPECT_CALL(encoder, encodeHeaders(_, true))
+      .WillOnce(Invoke([](const HeaderMap& headers, bool) -> void {
+        EXPECT_STREQ("503", headers.Status()->value().c_str());
+      }));
+
+  Buffer::OwnedImpl fake_input("1234");
+  conn_manager_->onData(fake_input);
+
+  EXPECT_EQ(1U, stats_.named_.downstream_rq_overload_reject_.value());
+}
+
+// Requests with the same host, path and route key headers as a previous request on the connection
+// are given its route.
+TEST_F(HttpConnectionManagerImplTest, RouteCache) {
+  EXPECT_CALL(runtime_.snapshot_, getInteger("http.route_cache_size", 0)).WillOnce(Return(2));
+  setup(false, "");
+  const std::vector<LowerCaseString> route_key_headers{LowerCaseString("x-canary")};
+  ON_CALL(*route_config_provider_.route_config_, routeKeyHeaders())
+      .WillByDefault(Return(&route_key_headers));
+
+  const std::vector<std::vector<std::pair<std::string, std::string>>> requests{
+      {{":authority", "host"}, {":path", "/a"}, {"x-canary", "1"}},
+      {{":authority", "host"}, {":path", "/a"}, {"x-canary", "1"}},
+      {{":authority", "host"}, {":path", "/a"}, {"x-canary", ""}},
+      {{":authority", "host"}, {":path", "/a"}},
+      {{":authority", "host"}, {":path", "/a"}, {"x-canary", ""}},
+      {{":authority", "host"}, {":path", "/a"}, {"x-canary", "1"}}};
+  size_t request = 0;
+  NiceMock<MockStreamEncoder> encoder;
+  EXPECT_CALL(*codec_, dispatch(_))
+      .Times(requests.size())
+      .WillRepeatedly(Invoke([&](Buffer::Instance& data) -> void {
+        StreamDecoder& decoder = conn_manager_->newStream(encoder);
+        HeaderMapPtr headers{new TestHeaderMapImpl()};
+        for (const auto& header : requests[request++]) {
+          headers->addCopy(LowerCaseString(header.first), header.second);
+        }
+        decoder.decodeHeaders(std::move(headers), true);
+        data.drain(4);
+      }));
+  // The route of the first request is replaced in the cache by that of the request without a
+  // canary header, so the last request misses.
+  EXPECT_CALL(*route_config_provider_.route_config_, route(_, _)).Times(4);
+
+  for (size_t i = 0; i < requests.size(); i++) {
+    Buffer::OwnedImpl fake_input("1234");
+    conn_manager_->onData(fake_input);
+  }
+
+  EXPECT_EQ(2U, stats_.named_.downstream_rq_route_cache_hit_.value());
+}
+
 TEST_F(HttpConnectionManagerImplTest, RejectWebSocketOnNonWebSocketRoute) {
   setup(false, "");
 
@@ -1086,6 +1227,54 @@ TEST_F(HttpConnectionManagerImplTest, WebSocketPrefixAndAutoHostRewrite) {
   EXPECT_EQ(0U, stats_.named_.downstream_cx_websocket_active_.value());
 }
 
+TEST_F(HttpConnectionManagerImplTest, WebSocketSplice) {
+  setup(false, "");
+
+  StreamDecoder* decoder = nullptr;
+  NiceMock<MockStreamEncoder> encoder;
+  NiceMock<Network::MockClientConnection>* upstream_connection =
+      new NiceMock<Network::MockClientConnection>();
+  Upstream::MockHost::MockCreateConnectionData conn_info;
+
+  conn_info.connection_ = upstream_connection;
+  conn_info.host_description_.reset(
+      new Upstream::HostImpl(cluster_manager_.thread_local_cluster_.cluster_.info_, "newhost",
+                             Network::Utility::resolveUrl("tcp://127.0.0.1:80"),
+                             envoy::api::v2::Metadata::default_instance(), 1,
+                             envoy::api::v2::Locality().default_instance()));
+  EXPECT_CALL(cluster_manager_, tcpConnForCluster_("fake_cluster", _)).WillOnce(Return(conn_info));
+
+  ON_CALL(route_config_provider_.route_config_->route_->route_entry_, useWebSocket())
+      .WillByDefault(Return(true));
+  EXPECT_CALL(runtime_.snapshot_,
+              featureEnabled("http_connection_manager.websocket_splice_enabled", 0))
+      .WillOnce(Return(true));
+
+  EXPECT_CALL(*codec_, dispatch(_)).WillOnce(Invoke([&](Buffer::Instance& data) -> void {
+    decoder = &conn_manager_->newStream(encoder);
+    HeaderMapPtr headers{new TestHeaderMapImpl{{":authority", "host"},
+                                               {":method", "GET"},
+                                               {":path", "/"},
+                                               {"connection", "Upgrade"},
+                                               {"upgrade", "websocket"}}};
+    decoder->decodeHeaders(std::move(headers), true);
+    data.drain(4);
+  }));
+
+  Buffer::OwnedImpl fake_input("1234");
+  conn_manager_->onData(fake_input);
+
+  // Once the upstream connection is established, both directions are handed to the sockets.
+  EXPECT_CALL(filter_callbacks_.connection_, spliceTo(Ref(*upstream_connection), _))
+      .WillOnce(Return(true));
+  EXPECT_CALL(*upstream_connection, spliceTo(Ref(filter_callbacks_.connection_), _))
+      .WillOnce(Return(true));
+  upstream_connection->raiseEvent(Network::ConnectionEvent::Connected);
+
+  filter_callbacks_.connection_.dispatcher_.clearDeferredDeleteList();
+  conn_manager_.reset();
+}
+
 TEST_F(HttpConnectionManagerImplTest, DrainClose) {
   setup(true, "");
 
@@ -1131,6 +1320,41 @@ TEST_F(HttpConnectionManagerImplTest, DrainClose) {
   EXPECT_EQ(1U, listener_stats_.downstream_rq_3xx_.value());
 }
 
+// Keep alive is disabled under overload by drain closing the connection after the response.
+TEST_F(HttpConnectionManagerImplTest, OverloadDisablesKeepAlive) {
+  setup(false, "");
+  ON_CALL(overload_manager_, isActive(Server::OverloadActionType::DisableHttpKeepAlive))
+      .WillByDefault(Return(true));
+
+  StreamDecoder* decoder = nullptr;
+  NiceMock<MockStreamEncoder> encoder;
+  EXPECT_CALL(*codec_, dispatch(_)).WillOnce(Invoke([&](Buffer::Instance&) -> void {
+    decoder = &conn_manager_->newStream(encoder);
+    HeaderMapPtr headers{new TestHeaderMapImpl{{":authority", "host"}, {":path", "/"}}};
+    decoder->decodeHeaders(std::move(headers), true);
+  }));
+
+  setupFilterChain(1, 0);
+  EXPECT_CALL(*decoder_filters_[0], decodeHeaders(_, true))
+      .WillOnce(Return(FilterHeadersStatus::StopIteration));
+
+  Buffer::OwnedImpl fake_input;
+  conn_manager_->onData(fake_input);
+
+  HeaderMapPtr response_headers{new TestHeaderMapImpl{{":status", "200"}}};
+  Event::MockTimer* drain_timer = new Event::MockTimer(&filter_callbacks_.connection_.dispatcher_);
+  EXPECT_CALL(*drain_timer, enableTimer(_));
+  EXPECT_CALL(*codec_, shutdownNotice());
+  decoder_filters_[0]->callbacks_->encodeHeaders(std::move(response_headers), true);
+
+  EXPECT_CALL(*codec_, goAway());
+  EXPECT_CALL(filter_callbacks_.connection_, close(Network::ConnectionCloseType::FlushWrite));
+  EXPECT_CALL(*drain_timer, disableTimer());
+  drain_timer->callback_();
+
+  EXPECT_EQ(1U, stats_.named_.downstream_cx_drain_close_.value());
+}
+
 TEST_F(HttpConnectionManagerImplTest, ResponseBeforeRequestComplete) {
   InSequence s;
   setup(false, "envoy-server-test");
@@ -1319,6 +1543,48 @@ TEST_F(HttpConnectionManagerImplTest, IdleTimeout) {
   EXPECT_EQ(1U, stats_.named_.downstream_cx_idle_timeout_.value());
 }
 
+TEST_F(HttpConnectionManagerImplTest, ReleaseIdleCodec) {
+  setup(false, "");
+
+  MockStreamDecoderFilter* filter = new NiceMock<MockStreamDecoderFilter>();
+  EXPECT_CALL(filter_factory_, createFilterChain(_))
+      .WillOnce(Invoke([&](FilterChainFactoryCallbacks& callbacks) -> void {
+        callbacks.addStreamDecoderFilter(StreamDecoderFilterSharedPtr{filter});
+      }));
+
+  NiceMock<MockStreamEncoder> encoder;
+  EXPECT_CALL(*codec_, dispatch(_)).WillOnce(Invoke([&](Buffer::Instance& data) -> void {
+    StreamDecoder* decoder = &conn_manager_->newStream(encoder);
+    HeaderMapPtr headers{new TestHeaderMapImpl{{":authority", "host"}, {":path", "/"}}};
+    decoder->decodeHeaders(std::move(headers), true);
+    data.drain(4);
+  }));
+  EXPECT_CALL(*filter, decodeHeaders(_, true))
+      .WillOnce(Return(FilterHeadersStatus::StopIteration));
+
+  Buffer::OwnedImpl fake_input("1234");
+  conn_manager_->onData(fake_input);
+
+  // The codec is released once the response completes and it has no state left.
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("http.http1.release_idle_codec", 0))
+      .WillOnce(Return(true));
+  EXPECT_CALL(*codec_, idle()).WillOnce(Return(true));
+  HeaderMapPtr response_headers{new TestHeaderMapImpl{{":status", "200"}}};
+  filter->callbacks_->encodeHeaders(std::move(response_headers), true);
+  EXPECT_EQ(1U, stats_.named_.downstream_cx_idle_codec_released_.value());
+
+  // The next data creates a new codec, without counting the connection again.
+  codec_ = new NiceMock<MockServerConnection>();
+  EXPECT_CALL(*codec_, dispatch(_));
+  Buffer::OwnedImpl more_input("5678");
+  conn_manager_->onData(more_input);
+  EXPECT_EQ(1U, stats_.named_.downstream_cx_http1_total_.value());
+  EXPECT_EQ(1U, stats_.named_.downstream_cx_http1_active_.value());
+
+  conn_manager_.reset();
+  EXPECT_EQ(0U, stats_.named_.downstream_cx_http1_active_.value());
+}
+
 TEST_F(HttpConnectionManagerImplTest, IntermediateBufferingEarlyResponse) {
   InSequence s;
   setup(false, "");
@@ -1,37 +1,49 @@
 #include <chrono>
+#include <string>
 
 #include "common/http/date_provider_impl.h"
 #include "common/http/header_map_impl.h"
 
 #include "test/mocks/event/mocks.h"
-#include "test/mocks/thread_local/mocks.h"
 #include "test/test_common/printers.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
-using testing::NiceMock;
+using testing::Invoke;
+using testing::_;
 
 namespace Envoy {
 namespace Http {
 
 TEST(DateProviderImplTest, All) {
   Event::MockDispatcher dispatcher;
-  NiceMock<ThreadLocal::MockInstance> tls;
   Event::MockTimer* timer = new Event::MockTimer(&dispatcher);
-  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(500)));
-
-  TlsCachingDateProviderImpl provider(dispatcher, tls);
+  // The refresh is timed for the next second boundary.
+  auto expect_refresh = [timer]() -> void {
+    EXPECT_CALL(*timer, enableTimer(_))
+        .WillOnce(Invoke([](const std::chrono::milliseconds& delay) -> void {
+          EXPECT_LT(std::chrono::milliseconds(0), delay);
+          EXPECT_GE(std::chrono::milliseconds(1000), delay);
+        }));
+  };
+  expect_refresh();
+
+  TlsCachingDateProviderImpl provider(dispatcher);
   HeaderMapImpl headers;
   provider.setDateHeader(headers);
-  EXPECT_NE(nullptr, headers.Date());
+  ASSERT_NE(nullptr, headers.Date());
+  EXPECT_EQ(HeaderString::Type::Reference, headers.Date()->value().type());
+  EXPECT_EQ(29U, headers.Date()->value().size());
+  EXPECT_EQ(" GMT", std::string(headers.Date()->value().c_str() + 25));
 
-  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(500)));
+  expect_refresh();
   timer->callback_();
 
   headers.removeDate();
   provider.setDateHeader(headers);
-  EXPECT_NE(nullptr, headers.Date());
+  ASSERT_NE(nullptr, headers.Date());
+  EXPECT_EQ(29U, headers.Date()->value().size());
 }
 
 } // namespace Http
@@ -9,15 +9,20 @@
 
 #include "test/mocks/buffer/mocks.h"
 #include "test/mocks/http/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/test_common/environment.h"
 #include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
 using testing::DoAll;
 using testing::InSequence;
+using testing::Invoke;
 using testing::NiceMock;
 using testing::Return;
+using testing::ReturnRef;
 using testing::SaveArg;
 using testing::_;
 
@@ -28,14 +33,22 @@ class BufferFilterTest : public testing::Test {
 public:
   BufferFilterTest()
       : config_{new BufferFilterConfig{BufferFilter::generateStats("", store_), 1024 * 1024,
-                                       std::chrono::seconds(0)}},
+                                       std::chrono::seconds(0), runtime_}},
         filter_(config_) {
     filter_.setDecoderFilterCallbacks(callbacks_);
   }
 
   void expectTimerCreate() { timer_ = new NiceMock<Event::MockTimer>(&callbacks_.dispatcher_); }
 
+  void enableSpill(uint64_t threshold) {
+    ON_CALL(runtime_.snapshot_, getInteger("buffer.spill_threshold_bytes", 0))
+        .WillByDefault(Return(threshold));
+    ON_CALL(runtime_.snapshot_, get("buffer.spill_path"))
+        .WillByDefault(ReturnRef(TestEnvironment::temporaryDirectory()));
+  }
+
   NiceMock<MockStreamDecoderFilterCallbacks> callbacks_;
+  NiceMock<Runtime::MockLoader> runtime_;
   Stats::IsolatedStoreImpl store_;
   std::shared_ptr<BufferFilterConfig> config_;
   BufferFilter filter_;
@@ -99,5 +112,45 @@ TEST_F(BufferFilterTest, TxResetAfterEndStream) {
   filter_.onDestroy();
 }
 
+TEST_F(BufferFilterTest, SpillToDisk) {
+  enableSpill(4);
+  expectTimerCreate();
+
+  TestHeaderMapImpl headers;
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, filter_.decodeHeaders(headers, false));
+
+  Buffer::OwnedImpl data1("hello");
+  EXPECT_EQ(FilterDataStatus::StopIterationNoBuffer, filter_.decodeData(data1, false));
+  EXPECT_EQ(0U, data1.length());
+  EXPECT_EQ(1U, config_->stats_.rq_spilled_.value());
+
+  Buffer::OwnedImpl data2(" world");
+  EXPECT_CALL(callbacks_, addDecodedData(_, false))
+      .WillOnce(Invoke([](Buffer::Instance& data, bool) -> void {
+        EXPECT_EQ("hello world", TestUtility::bufferToString(data));
+      }));
+  EXPECT_EQ(FilterDataStatus::Continue, filter_.decodeData(data2, true));
+
+  filter_.onDestroy();
+}
+
+TEST_F(BufferFilterTest, SpillTooLarge) {
+  enableSpill(4);
+  expectTimerCreate();
+
+  TestHeaderMapImpl headers;
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, filter_.decodeHeaders(headers, false));
+
+  Buffer::OwnedImpl data1(std::string(1024 * 1024 + 1, 'a'));
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, false))
+      .WillOnce(Invoke([](HeaderMap& headers, bool) -> void {
+        EXPECT_STREQ("413", headers.Status()->value().c_str());
+      }));
+  EXPECT_CALL(callbacks_, encodeData(_, true));
+  EXPECT_EQ(FilterDataStatus::StopIterationNoBuffer, filter_.decodeData(data1, false));
+
+  filter_.onDestroy();
+}
+
 } // namespace Http
 } // namespace Envoy
@@ -0,0 +1,297 @@
+#include <chrono>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/filter/cache_filter.h"
+#include "common/http/header_map_impl.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::ReturnPointee;
+using testing::_;
+
+namespace Envoy {
+namespace Http {
+
+typedef std::initializer_list<std::pair<std::string, std::string>> HeaderList;
+
+class CacheFilterTest : public testing::Test {
+public:
+  CacheFilterTest() { ON_CALL(time_source_, currentTime()).WillByDefault(ReturnPointee(&now_)); }
+
+  void setup(bool shared = false, uint64_t max_entry_bytes = 1024) {
+    config_.reset(
+        new CacheFilterConfig(1024 * 1024, max_entry_bytes, shared, 4, "", store_, tls_,
+                              time_source_));
+  }
+
+  // Send a request for path through a new filter, and return whether the filter served it.
+  bool request(const std::string& path, HeaderList extra_headers = {}) {
+    TestHeaderMapImpl headers(extra_headers);
+    headers.addCopy(":method", "GET");
+    headers.addCopy(":authority", "host");
+    headers.addCopy(":path", path);
+
+    NiceMock<MockStreamDecoderFilterCallbacks> callbacks;
+    CacheFilter filter(config_);
+    filter.setDecoderFilterCallbacks(callbacks);
+    served_headers_.reset();
+    served_body_.clear();
+    ON_CALL(callbacks, encodeHeaders_(_, _))
+        .WillByDefault(Invoke([this](HeaderMap& headers, bool) -> void {
+          served_headers_.reset(new TestHeaderMapImpl(headers));
+        }));
+    ON_CALL(callbacks, encodeData(_, _))
+        .WillByDefault(Invoke([this](Buffer::Instance& data, bool) -> void {
+          Buffer::RawSlice slice;
+          data.getRawSlices(&slice, 1);
+          served_body_mem_ = slice.mem_;
+          served_body_ = TestUtility::bufferToString(data);
+        }));
+    return filter.decodeHeaders(headers, true) == FilterHeadersStatus::StopIteration;
+  }
+
+  // Send a request through a new filter, and encode a response for it.
+  void requestAndRespond(const std::string& path, HeaderList response_headers,
+                         const std::string& body, HeaderList request_headers = {}) {
+    TestHeaderMapImpl headers(request_headers);
+    headers.addCopy(":method", "GET");
+    headers.addCopy(":authority", "host");
+    headers.addCopy(":path", path);
+
+    NiceMock<MockStreamDecoderFilterCallbacks> callbacks;
+    CacheFilter filter(config_);
+    filter.setDecoderFilterCallbacks(callbacks);
+    EXPECT_EQ(FilterHeadersStatus::Continue, filter.decodeHeaders(headers, true));
+
+    TestHeaderMapImpl response(response_headers);
+    EXPECT_EQ(FilterHeadersStatus::Continue, filter.encodeHeaders(response, body.empty()));
+    if (!body.empty()) {
+      Buffer::OwnedImpl data(body);
+      EXPECT_EQ(FilterDataStatus::Continue, filter.encodeData(data, true));
+      EXPECT_EQ(body, TestUtility::bufferToString(data));
+    }
+    filter.onDestroy();
+  }
+
+  uint64_t counter(const std::string& name) { return store_.counter("cache." + name).value(); }
+
+  Stats::IsolatedStoreImpl store_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  NiceMock<MockMonotonicTimeSource> time_source_;
+  MonotonicTime now_{std::chrono::seconds(1000)};
+  CacheFilterConfigSharedPtr config_;
+  std::unique_ptr<TestHeaderMapImpl> served_headers_;
+  std::string served_body_;
+  const void* served_body_mem_{};
+};
+
+TEST_F(CacheFilterTest, MissThenHit) {
+  setup();
+  requestAndRespond("/a", {{":status", "200"}, {"cache-control", "public, max-age=60"}}, "hello");
+  EXPECT_EQ(1UL, counter("miss"));
+  EXPECT_EQ(1UL, counter("insert"));
+  EXPECT_LT(0UL, store_.gauge("cache.size_bytes").value());
+
+  now_ += std::chrono::seconds(10);
+  EXPECT_TRUE(request("/a"));
+  EXPECT_EQ(1UL, counter("hit"));
+  EXPECT_STREQ("200", served_headers_->get_(":status").c_str());
+  EXPECT_EQ("10", served_headers_->get_("age"));
+  EXPECT_EQ("hello", served_body_);
+
+  // The body is added to the response by reference.
+  const void* first_body_mem = served_body_mem_;
+  EXPECT_TRUE(request("/a"));
+  EXPECT_EQ(first_body_mem, served_body_mem_);
+
+  EXPECT_FALSE(request("/b"));
+  EXPECT_EQ(2UL, counter("miss"));
+}
+
+TEST_F(CacheFilterTest, HeadersOnlyResponse) {
+  setup();
+  requestAndRespond("/a", {{":status", "200"}, {"cache-control", "max-age=60"}}, "");
+  EXPECT_TRUE(request("/a"));
+  EXPECT_TRUE(served_body_.empty());
+}
+
+TEST_F(CacheFilterTest, Expiry) {
+  setup();
+  requestAndRespond("/a", {{":status", "200"}, {"cache-control", "max-age=60"}, {"age", "20"}},
+                    "hello");
+  now_ += std::chrono::seconds(39);
+  EXPECT_TRUE(request("/a"));
+  now_ += std::chrono::seconds(1);
+  EXPECT_FALSE(request("/a"));
+  EXPECT_EQ(0UL, config_->cache().size());
+  EXPECT_EQ(0UL, store_.gauge("cache.size_bytes").value());
+}
+
+TEST_F(CacheFilterTest, SMaxAgeOverridesMaxAge) {
+  setup();
+  requestAndRespond("/a", {{":status", "200"}, {"cache-control", "max-age=60, s-maxage=5"}},
+                    "hello");
+  now_ += std::chrono::seconds(5);
+  EXPECT_FALSE(request("/a"));
+}
+
+TEST_F(CacheFilterTest, UncacheableResponses) {
+  setup();
+  requestAndRespond("/a", {{":status", "200"}}, "hello");
+  requestAndRespond("/b", {{":status", "404"}, {"cache-control", "max-age=60"}}, "hello");
+  requestAndRespond("/c", {{":status", "200"}, {"cache-control", "max-age=60, no-store"}}, "hello");
+  requestAndRespond("/d", {{":status", "200"}, {"cache-control", "private, max-age=60"}}, "hello");
+  requestAndRespond("/e", {{":status", "200"}, {"cache-control", "max-age=0"}}, "hello");
+  requestAndRespond("/f",
+                    {{":status", "200"}, {"cache-control", "max-age=60"}, {"set-cookie", "a=b"}},
+                    "hello");
+  requestAndRespond("/g", {{":status", "200"}, {"cache-control", "max-age=60"}, {"vary", "*"}},
+                    "hello");
+  EXPECT_EQ(0UL, counter("insert"));
+}
+
+TEST_F(CacheFilterTest, UncacheableRequests) {
+  setup();
+  requestAndRespond("/a", {{":status", "200"}, {"cache-control", "max-age=60"}}, "hello");
+
+  EXPECT_FALSE(request("/a", {{"authorization", "secret"}}));
+  EXPECT_FALSE(request("/a", {{"cache-control", "no-store"}}));
+  EXPECT_EQ(1UL, counter("miss"));
+
+  // no-cache skips the lookup, but the response may still be stored.
+  EXPECT_FALSE(request("/a", {{"cache-control", "no-cache"}}));
+  EXPECT_EQ(2UL, counter("miss"));
+
+  NiceMock<MockStreamDecoderFilterCallbacks> callbacks;
+  CacheFilter filter(config_);
+  filter.setDecoderFilterCallbacks(callbacks);
+  TestHeaderMapImpl headers{{":method", "POST"}, {":authority", "host"}, {":path", "/a"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter.decodeHeaders(headers, true));
+  EXPECT_EQ(0UL, counter("hit"));
+}
+
+TEST_F(CacheFilterTest, Vary) {
+  setup();
+  requestAndRespond("/a",
+                    {{":status", "200"}, {"cache-control", "max-age=60"}, {"vary", "Accept"}},
+                    "hello", {{"accept", "text/html"}});
+  EXPECT_TRUE(request("/a", {{"accept", "text/html"}}));
+  EXPECT_FALSE(request("/a", {{"accept", "application/json"}}));
+  EXPECT_FALSE(request("/a"));
+}
+
+TEST_F(CacheFilterTest, LargeBodyNotCached) {
+  setup(false, 4);
+  requestAndRespond("/a", {{":status", "200"}, {"cache-control", "max-age=60"}}, "hello");
+  EXPECT_EQ(0UL, counter("insert"));
+}
+
+TEST_F(CacheFilterTest, TrailersNotCached) {
+  setup();
+  TestHeaderMapImpl headers{{":method", "GET"}, {":authority", "host"}, {":path", "/a"}};
+  NiceMock<MockStreamDecoderFilterCallbacks> callbacks;
+  CacheFilter filter(config_);
+  filter.setDecoderFilterCallbacks(callbacks);
+  filter.decodeHeaders(headers, true);
+
+  TestHeaderMapImpl response{{":status", "200"}, {"cache-control", "max-age=60"}};
+  filter.encodeHeaders(response, false);
+  Buffer::OwnedImpl data("hello");
+  filter.encodeData(data, false);
+  TestHeaderMapImpl trailers{{"grpc-status", "0"}};
+  EXPECT_EQ(FilterTrailersStatus::Continue, filter.encodeTrailers(trailers));
+  EXPECT_EQ(0UL, counter("insert"));
+}
+
+TEST_F(CacheFilterTest, SharedCache) {
+  setup(true);
+  requestAndRespond("/a", {{":status", "200"}, {"cache-control", "max-age=60"}}, "hello");
+  requestAndRespond("/b", {{":status", "200"}, {"cache-control", "max-age=60"}}, "world");
+  EXPECT_TRUE(request("/a"));
+  EXPECT_EQ("hello", served_body_);
+  EXPECT_TRUE(request("/b"));
+  EXPECT_EQ("world", served_body_);
+  EXPECT_EQ(2UL, config_->cache().size());
+}
+
+TEST(HttpCacheTest, LeastRecentlyUsedEviction) {
+  Stats::IsolatedStoreImpl store;
+  CacheFilterStats stats{ALL_CACHE_FILTER_STATS(POOL_COUNTER(store), POOL_GAUGE(store))};
+
+  auto makeResponse = [](const std::string& body) -> CachedResponseConstSharedPtr {
+    std::shared_ptr<CachedResponse> response =
+        std::make_shared<CachedResponse>(TestHeaderMapImpl{{":status", "200"}});
+    response->body_ = body;
+    response->expiry_time_ = MonotonicTime::max();
+    return response;
+  };
+
+  const uint64_t entry_size = 1 + makeResponse(std::string(100, 'a'))->byteSize();
+  HttpCache cache(entry_size * 2, 1, stats);
+  TestHeaderMapImpl request_headers;
+  const MonotonicTime now;
+
+  cache.insert("a", makeResponse(std::string(100, 'a')));
+  cache.insert("b", makeResponse(std::string(100, 'b')));
+  EXPECT_NE(nullptr, cache.lookup("a", request_headers, now));
+  cache.insert("c", makeResponse(std::string(100, 'c')));
+
+  EXPECT_EQ(2UL, cache.size());
+  EXPECT_EQ(1UL, stats.evict_.value());
+  EXPECT_NE(nullptr, cache.lookup("a", request_headers, now));
+  EXPECT_EQ(nullptr, cache.lookup("b", request_headers, now));
+  EXPECT_NE(nullptr, cache.lookup("c", request_headers, now));
+  EXPECT_EQ(entry_size * 2, stats.size_bytes_.value());
+
+  // Replacing a response isn't an eviction.
+  cache.insert("c", makeResponse(std::string(100, 'd')));
+  EXPECT_EQ(1UL, stats.evict_.value());
+  EXPECT_EQ("d", cache.lookup("c", request_headers, now)->body_.substr(0, 1));
+
+  // Responses larger than the cache are never stored.
+  cache.insert("e", makeResponse(std::string(entry_size * 2, 'e')));
+  EXPECT_EQ(nullptr, cache.lookup("e", request_headers, now));
+  EXPECT_EQ(2UL, cache.size());
+}
+
+TEST(CacheUtilityTest, ParseCacheControl) {
+  {
+    TestHeaderMapImpl headers;
+    CacheUtility::CacheControl cache_control = CacheUtility::parseCacheControl(headers);
+    EXPECT_FALSE(cache_control.no_cache_);
+    EXPECT_FALSE(cache_control.max_age_.valid());
+  }
+  {
+    TestHeaderMapImpl headers{{"cache-control", "No-Cache, max-age=\"30\""},
+                              {"cache-control", "s-maxage=10,private"}};
+    CacheUtility::CacheControl cache_control = CacheUtility::parseCacheControl(headers);
+    EXPECT_TRUE(cache_control.no_cache_);
+    EXPECT_FALSE(cache_control.no_store_);
+    EXPECT_TRUE(cache_control.private_);
+    EXPECT_EQ(std::chrono::seconds(30), cache_control.max_age_.value());
+    EXPECT_EQ(std::chrono::seconds(10), cache_control.s_maxage_.value());
+  }
+  {
+    TestHeaderMapImpl headers{{"cache-control", "max-age=bad, no-store"}};
+    CacheUtility::CacheControl cache_control = CacheUtility::parseCacheControl(headers);
+    EXPECT_TRUE(cache_control.no_store_);
+    EXPECT_FALSE(cache_control.max_age_.valid());
+  }
+}
+
+} // namespace Http
+} // namespace Envoy
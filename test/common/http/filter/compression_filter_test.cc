@@ -0,0 +1,291 @@
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/compressor/zlib_compressor_impl.h"
+#include "common/decompressor/brotli_decompressor_impl.h"
+#include "common/decompressor/zlib_decompressor_impl.h"
+#include "common/decompressor/zstd_decompressor_impl.h"
+#include "common/http/filter/compression_filter.h"
+#include "common/http/header_map_impl.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::_;
+
+namespace Envoy {
+namespace Http {
+
+typedef std::initializer_list<std::pair<std::string, std::string>> HeaderList;
+
+TEST(CompressionUtilityTest, SelectEncoding) {
+  auto select = [](HeaderList headers) -> CompressionUtility::Encoding {
+    return CompressionUtility::selectEncoding(
+        TestHeaderMapImpl(headers),
+        {CompressionUtility::Encoding::Gzip, CompressionUtility::Encoding::Deflate});
+  };
+
+  EXPECT_EQ(CompressionUtility::Encoding::Identity, select({}));
+  EXPECT_EQ(CompressionUtility::Encoding::Identity, select({{"accept-encoding", "br, identity"}}));
+  EXPECT_EQ(CompressionUtility::Encoding::Gzip, select({{"accept-encoding", "gzip"}}));
+  EXPECT_EQ(CompressionUtility::Encoding::Gzip, select({{"accept-encoding", "x-gzip"}}));
+  EXPECT_EQ(CompressionUtility::Encoding::Gzip, select({{"accept-encoding", "GZIP, deflate"}}));
+  EXPECT_EQ(CompressionUtility::Encoding::Gzip, select({{"accept-encoding", "deflate, gzip"}}));
+  EXPECT_EQ(CompressionUtility::Encoding::Deflate, select({{"accept-encoding", "deflate"}}));
+  EXPECT_EQ(CompressionUtility::Encoding::Deflate,
+            select({{"accept-encoding", "gzip;q=0.5, deflate ; Q=0.8"}}));
+  EXPECT_EQ(CompressionUtility::Encoding::Deflate,
+            select({{"accept-encoding", "gzip;q=0"}, {"accept-encoding", "deflate"}}));
+  EXPECT_EQ(CompressionUtility::Encoding::Identity, select({{"accept-encoding", "gzip;q=0"}}));
+  EXPECT_EQ(CompressionUtility::Encoding::Identity, select({{"accept-encoding", "gzip;q=2"}}));
+  EXPECT_EQ(CompressionUtility::Encoding::Identity, select({{"accept-encoding", "gzip;q=x"}}));
+  EXPECT_EQ(CompressionUtility::Encoding::Gzip, select({{"accept-encoding", "*"}}));
+  EXPECT_EQ(CompressionUtility::Encoding::Deflate,
+            select({{"accept-encoding", "gzip;q=0, *;q=0.1"}}));
+  EXPECT_EQ(CompressionUtility::Encoding::Identity, select({{"accept-encoding", "*;q=0"}}));
+
+  auto select_all = [](const std::string& accept_encoding) -> CompressionUtility::Encoding {
+    return CompressionUtility::selectEncoding(
+        TestHeaderMapImpl{{"accept-encoding", accept_encoding}},
+        {CompressionUtility::Encoding::Brotli, CompressionUtility::Encoding::Zstd,
+         CompressionUtility::Encoding::Gzip, CompressionUtility::Encoding::Deflate});
+  };
+
+  EXPECT_EQ(CompressionUtility::Encoding::Brotli, select_all("gzip, deflate, br"));
+  EXPECT_EQ(CompressionUtility::Encoding::Brotli, select_all("*"));
+  EXPECT_EQ(CompressionUtility::Encoding::Zstd, select_all("gzip, zstd"));
+  EXPECT_EQ(CompressionUtility::Encoding::Gzip, select_all("br;q=0.5, gzip"));
+  EXPECT_EQ(CompressionUtility::Encoding::Zstd, select_all("br;q=0, *;q=0.5"));
+}
+
+class CompressionFilterTest : public testing::Test {
+public:
+  CompressionFilterTest() {
+    config_.reset(new CompressionFilterConfig(
+        Compressor::ZlibCompressorImpl::CompressionLevel::Standard,
+        Compressor::ZlibCompressorImpl::CompressionStrategy::Standard, 15, 8, 4, 3,
+        {CompressionUtility::Encoding::Brotli, CompressionUtility::Encoding::Zstd,
+         CompressionUtility::Encoding::Gzip, CompressionUtility::Encoding::Deflate},
+        30, {"text/plain", "Application/JSON"}, "", store_, tls_));
+    newFilter();
+  }
+
+  void newFilter() {
+    if (filter_) {
+      filter_->onDestroy();
+    }
+    filter_.reset(new CompressionFilter(config_));
+    filter_->setDecoderFilterCallbacks(decoder_callbacks_);
+    filter_->setEncoderFilterCallbacks(encoder_callbacks_);
+  }
+
+  void request(HeaderList headers) {
+    TestHeaderMapImpl request_headers(headers);
+    EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, true));
+  }
+
+  // Encode a response body in chunks, and return the encoded body.
+  std::string encodeBody(const std::vector<std::string>& chunks, bool end_stream = true) {
+    std::string encoded;
+    for (size_t i = 0; i < chunks.size(); i++) {
+      Buffer::OwnedImpl data(chunks[i]);
+      EXPECT_EQ(FilterDataStatus::Continue,
+                filter_->encodeData(data, end_stream && i == chunks.size() - 1));
+      encoded += TestUtility::bufferToString(data);
+    }
+    return encoded;
+  }
+
+  std::string decompress(const std::string& compressed, int64_t window_bits) {
+    Decompressor::ZlibDecompressorImpl decompressor;
+    decompressor.init(window_bits);
+    Buffer::OwnedImpl input(compressed);
+    Buffer::OwnedImpl output;
+    decompressor.decompress(input, output);
+    return TestUtility::bufferToString(output);
+  }
+
+  std::string decompress(const std::string& compressed, Decompressor::Decompressor&& decompressor) {
+    Buffer::OwnedImpl input(compressed);
+    Buffer::OwnedImpl output;
+    decompressor.decompress(input, output);
+    EXPECT_TRUE(decompressor.finished());
+    return TestUtility::bufferToString(output);
+  }
+
+  uint64_t counter(const std::string& name) {
+    return store_.counter("compression." + name).value();
+  }
+
+  Stats::IsolatedStoreImpl store_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  CompressionFilterConfigSharedPtr config_;
+  std::unique_ptr<CompressionFilter> filter_;
+  NiceMock<MockStreamDecoderFilterCallbacks> decoder_callbacks_;
+  NiceMock<MockStreamEncoderFilterCallbacks> encoder_callbacks_;
+  const std::string body_ = std::string(1000, 'a') + std::string(1000, 'b');
+};
+
+TEST_F(CompressionFilterTest, Gzip) {
+  request({{"accept-encoding", "gzip, deflate"}});
+  TestHeaderMapImpl response_headers{{":status", "200"},
+                                     {"content-type", "text/plain; charset=utf-8"},
+                                     {"content-length", "2000"},
+                                     {"etag", "\"abc\""}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
+  EXPECT_EQ("gzip", response_headers.get_("content-encoding"));
+  EXPECT_FALSE(response_headers.has("content-length"));
+  EXPECT_EQ("accept-encoding", response_headers.get_("vary"));
+  EXPECT_EQ("W/\"abc\"", response_headers.get_("etag"));
+
+  const std::string compressed = encodeBody({body_.substr(0, 700), body_.substr(700)});
+  EXPECT_GT(body_.size(), compressed.size());
+  EXPECT_EQ(body_, decompress(compressed, 31));
+
+  EXPECT_EQ(1U, counter("compressed"));
+  EXPECT_EQ(0U, counter("not_compressed"));
+  EXPECT_EQ(2000U, counter("total_uncompressed_bytes"));
+  EXPECT_EQ(compressed.size(), counter("total_compressed_bytes"));
+}
+
+TEST_F(CompressionFilterTest, DeflateWithTrailers) {
+  request({{"accept-encoding", "deflate"}});
+  TestHeaderMapImpl response_headers{{":status", "200"}, {"content-type", "application/json"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
+  EXPECT_EQ("deflate", response_headers.get_("content-encoding"));
+
+  std::string compressed = encodeBody({body_}, false);
+  EXPECT_CALL(encoder_callbacks_, addEncodedData(_, true))
+      .WillOnce(Invoke([&](Buffer::Instance& data, bool) -> void {
+        compressed += TestUtility::bufferToString(data);
+      }));
+  TestHeaderMapImpl trailers{{"grpc-status", "0"}};
+  EXPECT_EQ(FilterTrailersStatus::Continue, filter_->encodeTrailers(trailers));
+  EXPECT_EQ(body_, decompress(compressed, 15));
+}
+
+TEST_F(CompressionFilterTest, Brotli) {
+  request({{"accept-encoding", "gzip, deflate, br"}});
+  TestHeaderMapImpl response_headers{{":status", "200"}, {"content-type", "text/plain"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
+  EXPECT_EQ("br", response_headers.get_("content-encoding"));
+
+  const std::string compressed = encodeBody({body_.substr(0, 700), body_.substr(700)});
+  EXPECT_GT(body_.size(), compressed.size());
+  EXPECT_EQ(body_, decompress(compressed, Decompressor::BrotliDecompressorImpl()));
+  EXPECT_EQ(1U, counter("compressed"));
+}
+
+TEST_F(CompressionFilterTest, Zstd) {
+  request({{"accept-encoding", "gzip;q=0.5, zstd"}});
+  TestHeaderMapImpl response_headers{{":status", "200"}, {"content-type", "text/plain"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
+  EXPECT_EQ("zstd", response_headers.get_("content-encoding"));
+
+  const std::string compressed = encodeBody({body_.substr(0, 700), body_.substr(700)});
+  EXPECT_GT(body_.size(), compressed.size());
+  EXPECT_EQ(body_, decompress(compressed, Decompressor::ZstdDecompressorImpl()));
+}
+
+TEST_F(CompressionFilterTest, NoAcceptEncoding) {
+  request({{"accept-encoding", "compress"}});
+  TestHeaderMapImpl response_headers{{":status", "200"}, {"content-type", "text/plain"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
+  EXPECT_FALSE(response_headers.has("content-encoding"));
+  // Caches still need to know that other clients may get a compressed response.
+  EXPECT_EQ("accept-encoding", response_headers.get_("vary"));
+  EXPECT_EQ(body_, encodeBody({body_}));
+  EXPECT_EQ(1U, counter("no_accept_header"));
+  EXPECT_EQ(0U, counter("compressed"));
+}
+
+TEST_F(CompressionFilterTest, ExistingVary) {
+  request({{"accept-encoding", "gzip"}});
+  TestHeaderMapImpl response_headers{
+      {":status", "200"}, {"content-type", "text/plain"}, {"vary", "Origin, Accept-Encoding"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
+  EXPECT_EQ("Origin, Accept-Encoding", response_headers.get_("vary"));
+  EXPECT_EQ("gzip", response_headers.get_("content-encoding"));
+}
+
+TEST_F(CompressionFilterTest, NotCompressible) {
+  auto expect_not_compressed = [this](HeaderList headers) -> void {
+    newFilter();
+    request({{"accept-encoding", "gzip"}});
+    TestHeaderMapImpl response_headers(headers);
+    EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
+    EXPECT_FALSE(response_headers.has("vary"));
+    EXPECT_EQ(body_, encodeBody({body_}));
+  };
+
+  expect_not_compressed({{":status", "200"}});
+  expect_not_compressed({{":status", "200"}, {"content-type", "image/png"}});
+  expect_not_compressed(
+      {{":status", "200"}, {"content-type", "text/plain"}, {"content-length", "29"}});
+  expect_not_compressed(
+      {{":status", "200"}, {"content-type", "text/plain"}, {"content-encoding", "br"}});
+  expect_not_compressed({{":status", "200"},
+                         {"content-type", "text/plain"},
+                         {"cache-control", "public, No-Transform"}});
+  EXPECT_EQ(5U, counter("not_compressed"));
+  EXPECT_EQ(0U, counter("compressed"));
+}
+
+TEST_F(CompressionFilterTest, HeadersOnly) {
+  request({{"accept-encoding", "gzip"}});
+  TestHeaderMapImpl response_headers{{":status", "200"}, {"content-type", "text/plain"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, true));
+  EXPECT_FALSE(response_headers.has("content-encoding"));
+  EXPECT_EQ(1U, counter("not_compressed"));
+}
+
+TEST_F(CompressionFilterTest, ReuseCompressor) {
+  std::vector<std::string> outputs;
+  for (int i = 0; i < 3; i++) {
+    newFilter();
+    request({{"accept-encoding", "gzip"}});
+    TestHeaderMapImpl response_headers{{":status", "200"}, {"content-type", "text/plain"}};
+    filter_->encodeHeaders(response_headers, false);
+    if (i == 1) {
+      // A stream which is destroyed part way through the body returns its compressor too.
+      encodeBody({body_}, false);
+      continue;
+    }
+    outputs.push_back(encodeBody({body_}));
+  }
+
+  // The reused compressor writes the same stream as a new one.
+  ASSERT_EQ(2U, outputs.size());
+  EXPECT_EQ(outputs[0], outputs[1]);
+  EXPECT_EQ(body_, decompress(outputs[1], 31));
+}
+
+TEST_F(CompressionFilterTest, ReuseBrotliCompressor) {
+  std::vector<std::string> outputs;
+  for (int i = 0; i < 2; i++) {
+    newFilter();
+    request({{"accept-encoding", "br"}});
+    TestHeaderMapImpl response_headers{{":status", "200"}, {"content-type", "text/plain"}};
+    filter_->encodeHeaders(response_headers, false);
+    outputs.push_back(encodeBody({body_}));
+  }
+
+  // Resetting a Brotli compressor starts a new stream.
+  EXPECT_EQ(outputs[0], outputs[1]);
+  EXPECT_EQ(body_, decompress(outputs[1], Decompressor::BrotliDecompressorImpl()));
+}
+
+} // namespace Http
+} // namespace Envoy
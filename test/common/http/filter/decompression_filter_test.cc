@@ -0,0 +1,193 @@
+#include <memory>
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/compressor/brotli_compressor_impl.h"
+#include "common/compressor/zlib_compressor_impl.h"
+#include "common/compressor/zstd_compressor_impl.h"
+#include "common/http/filter/decompression_filter.h"
+#include "common/http/header_map_impl.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/http/mocks.h"
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Http {
+
+class DecompressionFilterTest : public testing::Test {
+public:
+  DecompressionFilterTest() { setup(0); }
+
+  void setup(uint64_t max_decompressed_bytes) {
+    config_.reset(new DecompressionFilterConfig(max_decompressed_bytes, "", store_));
+    filter_.reset(new DecompressionFilter(config_));
+    filter_->setDecoderFilterCallbacks(callbacks_);
+  }
+
+  std::string compress(const std::string& body, int64_t window_bits) {
+    Compressor::ZlibCompressorImpl compressor;
+    compressor.init(Compressor::ZlibCompressorImpl::CompressionLevel::Standard,
+                    Compressor::ZlibCompressorImpl::CompressionStrategy::Standard, window_bits, 8);
+    Buffer::OwnedImpl input(body);
+    Buffer::OwnedImpl output;
+    compressor.compress(input, output);
+    compressor.finish(output);
+    return TestUtility::bufferToString(output);
+  }
+
+  std::string compress(const std::string& body, Compressor::Compressor& compressor) {
+    Buffer::OwnedImpl input(body);
+    Buffer::OwnedImpl output;
+    compressor.compress(input, output);
+    compressor.finish(output);
+    return TestUtility::bufferToString(output);
+  }
+
+  // Decode a request body in chunks of chunk_size bytes, and return the decoded body.
+  std::string decodeBody(const std::string& body, size_t chunk_size, bool end_stream = true) {
+    std::string decoded;
+    for (size_t i = 0; i < body.size(); i += chunk_size) {
+      Buffer::OwnedImpl data(body.substr(i, chunk_size));
+      EXPECT_EQ(FilterDataStatus::Continue,
+                filter_->decodeData(data, end_stream && i + chunk_size >= body.size()));
+      decoded += TestUtility::bufferToString(data);
+    }
+    return decoded;
+  }
+
+  uint64_t counter(const std::string& name) {
+    return store_.counter("decompression." + name).value();
+  }
+
+  Stats::IsolatedStoreImpl store_;
+  DecompressionFilterConfigSharedPtr config_;
+  std::unique_ptr<DecompressionFilter> filter_;
+  NiceMock<MockStreamDecoderFilterCallbacks> callbacks_;
+  const std::string body_ = std::string(5000, 'a') + std::string(5000, 'b');
+};
+
+TEST_F(DecompressionFilterTest, Gzip) {
+  TestHeaderMapImpl headers{
+      {":method", "POST"}, {"content-encoding", "gzip"}, {"content-length", "100"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+  EXPECT_FALSE(headers.has("content-encoding"));
+  EXPECT_FALSE(headers.has("content-length"));
+
+  const std::string compressed = compress(body_, 31);
+  EXPECT_EQ(body_, decodeBody(compressed, 10));
+  EXPECT_EQ(1U, counter("decompressed"));
+  EXPECT_EQ(compressed.size(), counter("total_compressed_bytes"));
+  EXPECT_EQ(body_.size(), counter("total_decompressed_bytes"));
+}
+
+TEST_F(DecompressionFilterTest, DeflateWithTrailers) {
+  TestHeaderMapImpl headers{{":method", "POST"}, {"content-encoding", "Deflate"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+  EXPECT_EQ(body_, decodeBody(compress(body_, 15), 1000, false));
+  TestHeaderMapImpl trailers{{"foo", "bar"}};
+  EXPECT_EQ(FilterTrailersStatus::Continue, filter_->decodeTrailers(trailers));
+}
+
+TEST_F(DecompressionFilterTest, Brotli) {
+  TestHeaderMapImpl headers{{":method", "POST"}, {"content-encoding", "br"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+  EXPECT_FALSE(headers.has("content-encoding"));
+
+  Compressor::BrotliCompressorImpl compressor;
+  compressor.init(4, 22);
+  EXPECT_EQ(body_, decodeBody(compress(body_, compressor), 10));
+  EXPECT_EQ(1U, counter("decompressed"));
+}
+
+TEST_F(DecompressionFilterTest, Zstd) {
+  TestHeaderMapImpl headers{{":method", "POST"}, {"content-encoding", "zstd"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+  EXPECT_FALSE(headers.has("content-encoding"));
+
+  Compressor::ZstdCompressorImpl compressor;
+  compressor.init(3);
+  EXPECT_EQ(body_, decodeBody(compress(body_, compressor), 10));
+  EXPECT_EQ(1U, counter("decompressed"));
+}
+
+TEST_F(DecompressionFilterTest, PassThrough) {
+  TestHeaderMapImpl identity_headers{{":method", "POST"}, {"content-length", "10000"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(identity_headers, false));
+  EXPECT_EQ(body_, decodeBody(body_, 1000));
+
+  setup(0);
+  TestHeaderMapImpl headers{{":method", "POST"}, {"content-encoding", "compress"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+  EXPECT_EQ("compress", headers.get_("content-encoding"));
+  EXPECT_EQ(body_, decodeBody(body_, 1000));
+
+  setup(0);
+  TestHeaderMapImpl multiple_headers{{":method", "POST"}, {"content-encoding", "gzip, br"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(multiple_headers, false));
+  EXPECT_EQ("gzip, br", multiple_headers.get_("content-encoding"));
+  EXPECT_EQ(2U, counter("not_decompressed"));
+  EXPECT_EQ(0U, counter("decompressed"));
+}
+
+TEST_F(DecompressionFilterTest, CorruptBody) {
+  TestHeaderMapImpl headers{{":method", "POST"}, {"content-encoding", "gzip"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+
+  EXPECT_CALL(callbacks_, resetStream());
+  Buffer::OwnedImpl data("not gzip");
+  EXPECT_EQ(FilterDataStatus::StopIterationNoBuffer, filter_->decodeData(data, false));
+  EXPECT_EQ(0U, data.length());
+  EXPECT_EQ(1U, counter("decompression_error"));
+}
+
+TEST_F(DecompressionFilterTest, TruncatedBody) {
+  TestHeaderMapImpl headers{{":method", "POST"}, {"content-encoding", "gzip"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+
+  const std::string compressed = compress(body_, 31);
+  EXPECT_CALL(callbacks_, resetStream());
+  Buffer::OwnedImpl data(compressed.substr(0, compressed.size() - 4));
+  EXPECT_EQ(FilterDataStatus::StopIterationNoBuffer, filter_->decodeData(data, true));
+  EXPECT_EQ(1U, counter("decompression_error"));
+}
+
+TEST_F(DecompressionFilterTest, TruncatedBodyWithTrailers) {
+  TestHeaderMapImpl headers{{":method", "POST"}, {"content-encoding", "gzip"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+
+  const std::string compressed = compress(body_, 31);
+  decodeBody(compressed.substr(0, compressed.size() - 4), 1000, false);
+  EXPECT_CALL(callbacks_, resetStream());
+  TestHeaderMapImpl trailers{{"foo", "bar"}};
+  EXPECT_EQ(FilterTrailersStatus::StopIteration, filter_->decodeTrailers(trailers));
+  EXPECT_EQ(1U, counter("decompression_error"));
+}
+
+TEST_F(DecompressionFilterTest, TooLarge) {
+  setup(body_.size() - 1);
+  TestHeaderMapImpl headers{{":method", "POST"}, {"content-encoding", "gzip"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+
+  EXPECT_CALL(callbacks_, resetStream());
+  Buffer::OwnedImpl data(compress(body_, 31));
+  EXPECT_EQ(FilterDataStatus::StopIterationNoBuffer, filter_->decodeData(data, true));
+  EXPECT_EQ(0U, data.length());
+  EXPECT_EQ(1U, counter("too_large"));
+}
+
+TEST_F(DecompressionFilterTest, HeadersOnly) {
+  TestHeaderMapImpl headers{{":method", "POST"}, {"content-encoding", "gzip"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, true));
+  EXPECT_EQ("gzip", headers.get_("content-encoding"));
+  EXPECT_EQ(0U, counter("decompressed"));
+}
+
+} // namespace Http
+} // namespace Envoy
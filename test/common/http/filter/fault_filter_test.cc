@@ -16,13 +16,16 @@
 #include "test/common/http/common.h"
 #include "test/mocks/http/mocks.h"
 #include "test/mocks/runtime/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
 #include "test/test_common/printers.h"
 #include "test/test_common/utility.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::AnyNumber;
 using testing::DoAll;
+using testing::EndsWith;
 using testing::Invoke;
 using testing::NiceMock;
 using testing::Return;
@@ -117,7 +120,10 @@ public:
     envoy::api::v2::filter::http::HTTPFault fault;
 
     Config::FilterJson::translateFaultFilter(*config, fault);
-    config_.reset(new FaultFilterConfig(fault, runtime_, "prefix.", stats_));
+    // The fault percentages are looked up once per runtime snapshot to find out whether any fault
+    // can apply at all.
+    EXPECT_CALL(runtime_.snapshot_, getInteger(EndsWith("_percent"), _)).Times(AnyNumber());
+    config_.reset(new FaultFilterConfig(fault, runtime_, "prefix.", stats_, tls_));
     filter_.reset(new FaultFilter(config_));
     filter_->setDecoderFilterCallbacks(filter_callbacks_);
   }
@@ -128,6 +134,7 @@ public:
     EXPECT_CALL(*timer_, disableTimer());
   }
 
+  NiceMock<ThreadLocal::MockInstance> tls_;
   FaultFilterConfigSharedPtr config_;
   std::unique_ptr<FaultFilter> filter_;
   NiceMock<MockStreamDecoderFilterCallbacks> filter_callbacks_;
@@ -725,5 +732,40 @@ TEST_F(FaultFilterTest, FaultWithTargetClusterNullRoute) {
   EXPECT_EQ(0UL, config_->stats().aborts_injected_.value());
 }
 
+TEST_F(FaultFilterTest, InactiveWhenPercentagesAreZero) {
+  SetUpTest(fixed_delay_only_json);
+
+  // The percentages are only looked up again once the runtime snapshot changes.
+  EXPECT_CALL(runtime_.snapshot_, version()).WillRepeatedly(Return(1));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("fault.http.delay.fixed_delay_percent", 100))
+      .WillOnce(Return(0));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("fault.http.abort.abort_percent", 0))
+      .WillOnce(Return(0));
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled(_, _)).Times(0);
+  EXPECT_CALL(runtime_.snapshot_, getInteger("fault.http.delay.fixed_duration_ms", _)).Times(0);
+
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  FaultFilter second_filter(config_);
+  second_filter.setDecoderFilterCallbacks(filter_callbacks_);
+  EXPECT_EQ(FilterHeadersStatus::Continue, second_filter.decodeHeaders(request_headers_, false));
+
+  // A downstream cluster may have a fault of its own.
+  request_headers_.addCopy("x-envoy-downstream-service-cluster", "cluster");
+  EXPECT_CALL(runtime_.snapshot_, getInteger("fault.http.delay.fixed_delay_percent", 100))
+      .WillOnce(Return(0));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("fault.http.abort.abort_percent", 0))
+      .WillOnce(Return(0));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("fault.http.cluster.delay.fixed_delay_percent", 100))
+      .WillOnce(Return(0));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("fault.http.cluster.abort.abort_percent", 0))
+      .WillOnce(Return(0));
+  FaultFilter third_filter(config_);
+  third_filter.setDecoderFilterCallbacks(filter_callbacks_);
+  EXPECT_EQ(FilterHeadersStatus::Continue, third_filter.decodeHeaders(request_headers_, false));
+
+  EXPECT_EQ(0UL, config_->stats().delays_injected_.value());
+  EXPECT_EQ(0UL, config_->stats().aborts_injected_.value());
+}
+
 } // namespace Http
 } // namespace Envoy
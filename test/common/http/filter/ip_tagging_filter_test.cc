@@ -71,26 +71,98 @@ public:
 
 TEST_F(IpTaggingFilterTest, InternalRequest) {
   SetUpTest(internal_request_json);
+  filter_callbacks_.downstream_address_ = "1.2.3.4";
+  request_headers_.addCopy(Headers::get().EnvoyInternalRequest, "true");
 
   EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_EQ("test_internal", request_headers_.get_(Headers::get().EnvoyIpTags));
   EXPECT_EQ(FilterDataStatus::Continue, filter_->decodeData(data_, false));
   EXPECT_EQ(FilterTrailersStatus::Continue, filter_->decodeTrailers(request_headers_));
+
+  // External requests are not tagged.
+  TestHeaderMapImpl external_headers;
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(external_headers, false));
+  EXPECT_FALSE(external_headers.has(Headers::get().EnvoyIpTags));
 }
 
 TEST_F(IpTaggingFilterTest, ExternalRequest) {
   SetUpTest(external_request_json);
+  filter_callbacks_.downstream_address_ = "1.2.3.4";
 
   EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_EQ("test_external", request_headers_.get_(Headers::get().EnvoyIpTags));
   EXPECT_EQ(FilterDataStatus::Continue, filter_->decodeData(data_, false));
   EXPECT_EQ(FilterTrailersStatus::Continue, filter_->decodeTrailers(request_headers_));
+
+  // Internal requests are not tagged.
+  TestHeaderMapImpl internal_headers{{"x-envoy-internal", "true"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(internal_headers, false));
+  EXPECT_FALSE(internal_headers.has(Headers::get().EnvoyIpTags));
 }
 
 TEST_F(IpTaggingFilterTest, BothRequest) {
   SetUpTest(both_request_json);
+  filter_callbacks_.downstream_address_ = "1.2.3.4";
 
   EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_EQ("test_both", request_headers_.get_(Headers::get().EnvoyIpTags));
   EXPECT_EQ(FilterDataStatus::Continue, filter_->decodeData(data_, false));
   EXPECT_EQ(FilterTrailersStatus::Continue, filter_->decodeTrailers(request_headers_));
+
+  TestHeaderMapImpl internal_headers{{"x-envoy-internal", "true"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(internal_headers, false));
+  EXPECT_EQ("test_both", internal_headers.get_(Headers::get().EnvoyIpTags));
+}
+
+TEST_F(IpTaggingFilterTest, NestedTags) {
+  const std::string json = R"EOF(
+    {
+      "ip_tags" : [
+        {
+          "ip_tag_name" : "private",
+          "ip_list" : ["10.0.0.0/8", "2001:db8::/32"]
+        },
+        {
+          "ip_tag_name" : "subnet",
+          "ip_list" : ["10.1.0.0/16"]
+        }
+      ]
+    }
+  )EOF";
+  SetUpTest(json);
+
+  filter_callbacks_.downstream_address_ = "10.1.2.3";
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_EQ("private,subnet", request_headers_.get_(Headers::get().EnvoyIpTags));
+
+  filter_callbacks_.downstream_address_ = "2001:db8::1";
+  TestHeaderMapImpl ipv6_headers;
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(ipv6_headers, false));
+  EXPECT_EQ("private", ipv6_headers.get_(Headers::get().EnvoyIpTags));
+}
+
+TEST_F(IpTaggingFilterTest, NoMatch) {
+  SetUpTest(both_request_json);
+  filter_callbacks_.downstream_address_ = "1.2.3.5";
+
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_FALSE(request_headers_.has(Headers::get().EnvoyIpTags));
+}
+
+TEST(IpTaggingFilterConfigTest, InvalidIpList) {
+  const std::string json = R"EOF(
+    {
+      "ip_tags" : [
+        {
+          "ip_tag_name" : "bad",
+          "ip_list" : ["1.2.3.4/33"]
+        }
+      ]
+    }
+  )EOF";
+  Json::ObjectSharedPtr config = Json::Factory::loadFromString(json);
+  EXPECT_THROW_WITH_MESSAGE(IpTaggingFilterConfig{*config}, EnvoyException,
+                            "invalid ip/mask combo '1.2.3.4/33' (format is <ip>/<# mask bits>)");
 }
 
 } // namespace Http
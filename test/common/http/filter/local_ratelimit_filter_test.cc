@@ -0,0 +1,94 @@
+#include <chrono>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "common/http/filter/local_ratelimit_filter.h"
+#include "common/http/header_map_impl.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/local_info/mocks.h"
+#include "test/mocks/router/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::WithArgs;
+using testing::_;
+
+namespace Envoy {
+namespace Http {
+
+class LocalRateLimitFilterTest : public testing::Test {
+public:
+  void setup(const std::vector<std::pair<RateLimit::Descriptor, RateLimit::TokenBucket>>&
+                 descriptors = {}) {
+    config_.reset(new LocalRateLimitFilterConfig(std::chrono::milliseconds(1000), {1, 1},
+                                                 descriptors, 0, "test.", stats_store_,
+                                                 local_info_, tls_));
+    filter_callbacks_.route_->route_entry_.rate_limit_policy_.rate_limit_policy_entry_.clear();
+    filter_callbacks_.route_->route_entry_.rate_limit_policy_.rate_limit_policy_entry_.emplace_back(
+        route_rate_limit_);
+  }
+
+  FilterHeadersStatus request() {
+    LocalRateLimitFilter filter(config_);
+    filter.setDecoderFilterCallbacks(filter_callbacks_);
+    TestHeaderMapImpl request_headers;
+    return filter.decodeHeaders(request_headers, false);
+  }
+
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  Stats::IsolatedStoreImpl stats_store_;
+  NiceMock<LocalInfo::MockLocalInfo> local_info_;
+  NiceMock<MockStreamDecoderFilterCallbacks> filter_callbacks_;
+  NiceMock<Router::MockRateLimitPolicyEntry> route_rate_limit_;
+  LocalRateLimitFilterConfigSharedPtr config_;
+  const RateLimit::Descriptor descriptor_{{{"destination_cluster", "fake_cluster"}}};
+};
+
+TEST_F(LocalRateLimitFilterTest, DefaultBucket) {
+  setup();
+
+  EXPECT_CALL(route_rate_limit_, populateDescriptors(_, _, _, _, _)).Times(0);
+  EXPECT_EQ(FilterHeadersStatus::Continue, request());
+
+  TestHeaderMapImpl response_headers{{":status", "429"}};
+  EXPECT_CALL(filter_callbacks_, encodeHeaders_(HeaderMapEqualRef(&response_headers), true));
+  EXPECT_CALL(filter_callbacks_.request_info_,
+              setResponseFlag(AccessLog::ResponseFlag::RateLimited));
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, request());
+
+  EXPECT_EQ(1U, stats_store_.counter("test.local_rate_limit.ok").value());
+  EXPECT_EQ(1U, stats_store_.counter("test.local_rate_limit.rate_limited").value());
+}
+
+TEST_F(LocalRateLimitFilterTest, DescriptorBucket) {
+  setup({{descriptor_, {2, 2}}});
+
+  EXPECT_CALL(route_rate_limit_, populateDescriptors(_, _, _, _, _))
+      .Times(3)
+      .WillRepeatedly(WithArgs<1>(Invoke([this](std::vector<RateLimit::Descriptor>& descriptors)
+                                             -> void { descriptors.push_back(descriptor_); })));
+  EXPECT_EQ(FilterHeadersStatus::Continue, request());
+  EXPECT_EQ(FilterHeadersStatus::Continue, request());
+  EXPECT_CALL(filter_callbacks_, encodeHeaders_(_, true));
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, request());
+
+  // A request without a route uses the default bucket.
+  EXPECT_CALL(*filter_callbacks_.route_, routeEntry()).WillOnce(Return(nullptr));
+  EXPECT_EQ(FilterHeadersStatus::Continue, request());
+
+  EXPECT_EQ(3U, stats_store_.counter("test.local_rate_limit.ok").value());
+  EXPECT_EQ(1U, stats_store_.counter("test.local_rate_limit.rate_limited").value());
+}
+
+} // namespace Http
+} // namespace Envoy
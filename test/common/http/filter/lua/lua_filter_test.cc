@@ -131,6 +131,19 @@ public:
     end
   )EOF"};
 
+  const std::string BODY_PREFIX_SCRIPT{R"EOF(
+    function envoy_on_request(request_handle)
+      request_handle:logTrace(request_handle:headers():get(":path"))
+
+      local prefix = request_handle:bodyPrefix(8)
+      if prefix ~= nil then
+        request_handle:logTrace(prefix:length())
+      else
+        request_handle:logTrace("no body")
+      end
+    end
+  )EOF"};
+
   const std::string BODY_TRAILERS_SCRIPT{R"EOF(
     function envoy_on_request(request_handle)
       request_handle:logTrace(request_handle:headers():get(":path"))
@@ -1337,6 +1350,132 @@ TEST_F(LuaHttpFilterTest, BodyAfterStreamingHasStarted) {
   EXPECT_EQ(FilterDataStatus::Continue, filter_->decodeData(data, false));
 }
 
+// Script asking for a body prefix, request that is headers only.
+TEST_F(LuaHttpFilterTest, ScriptBodyPrefixRequestHeadersOnly) {
+  InSequence s;
+  setup(BODY_PREFIX_SCRIPT);
+
+  TestHeaderMapImpl request_headers{{":path", "/"}};
+  EXPECT_CALL(*filter_, scriptLog(spdlog::level::trace, StrEq("/")));
+  EXPECT_CALL(*filter_, scriptLog(spdlog::level::trace, StrEq("no body")));
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, true));
+}
+
+// Script asking for a body prefix, request whose first frame holds the prefix. The rest of the
+// body is streamed.
+TEST_F(LuaHttpFilterTest, ScriptBodyPrefixRequestBody) {
+  InSequence s;
+  setup(BODY_PREFIX_SCRIPT);
+
+  TestHeaderMapImpl request_headers{{":path", "/"}};
+  EXPECT_CALL(*filter_, scriptLog(spdlog::level::trace, StrEq("/")));
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, filter_->decodeHeaders(request_headers, false));
+
+  Buffer::OwnedImpl data("hello world");
+  EXPECT_CALL(*filter_, scriptLog(spdlog::level::trace, StrEq("11")));
+  EXPECT_EQ(FilterDataStatus::Continue, filter_->decodeData(data, false));
+
+  Buffer::OwnedImpl data2("more");
+  EXPECT_EQ(FilterDataStatus::Continue, filter_->decodeData(data2, false));
+  EXPECT_EQ(4U, data2.length());
+  EXPECT_EQ(11U, decoder_callbacks_.buffer_->length());
+}
+
+// Script asking for a body prefix, request whose prefix spans two frames.
+TEST_F(LuaHttpFilterTest, ScriptBodyPrefixRequestBodyTwoFrames) {
+  InSequence s;
+  setup(BODY_PREFIX_SCRIPT);
+
+  TestHeaderMapImpl request_headers{{":path", "/"}};
+  EXPECT_CALL(*filter_, scriptLog(spdlog::level::trace, StrEq("/")));
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, filter_->decodeHeaders(request_headers, false));
+
+  Buffer::OwnedImpl data("hello");
+  EXPECT_EQ(FilterDataStatus::StopIterationAndBuffer, filter_->decodeData(data, false));
+  decoder_callbacks_.addDecodedData(data, false);
+
+  Buffer::OwnedImpl data2("world");
+  EXPECT_CALL(*filter_, scriptLog(spdlog::level::trace, StrEq("10")));
+  EXPECT_EQ(FilterDataStatus::Continue, filter_->decodeData(data2, false));
+
+  Buffer::OwnedImpl data3("more");
+  EXPECT_EQ(FilterDataStatus::Continue, filter_->decodeData(data3, true));
+}
+
+// Script asking for a body prefix, request whose body is shorter than the prefix.
+TEST_F(LuaHttpFilterTest, ScriptBodyPrefixRequestShortBody) {
+  InSequence s;
+  setup(BODY_PREFIX_SCRIPT);
+
+  TestHeaderMapImpl request_headers{{":path", "/"}};
+  EXPECT_CALL(*filter_, scriptLog(spdlog::level::trace, StrEq("/")));
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, filter_->decodeHeaders(request_headers, false));
+
+  Buffer::OwnedImpl data("hello");
+  EXPECT_CALL(*filter_, scriptLog(spdlog::level::trace, StrEq("5")));
+  EXPECT_EQ(FilterDataStatus::Continue, filter_->decodeData(data, true));
+}
+
+// Script asking for a body prefix, request whose body is shorter than the prefix and is followed
+// by trailers.
+TEST_F(LuaHttpFilterTest, ScriptBodyPrefixRequestShortBodyTrailers) {
+  InSequence s;
+  setup(BODY_PREFIX_SCRIPT);
+
+  TestHeaderMapImpl request_headers{{":path", "/"}};
+  EXPECT_CALL(*filter_, scriptLog(spdlog::level::trace, StrEq("/")));
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, filter_->decodeHeaders(request_headers, false));
+
+  Buffer::OwnedImpl data("hello");
+  EXPECT_EQ(FilterDataStatus::StopIterationAndBuffer, filter_->decodeData(data, false));
+  decoder_callbacks_.addDecodedData(data, false);
+
+  TestHeaderMapImpl request_trailers{{"foo", "bar"}};
+  EXPECT_CALL(*filter_, scriptLog(spdlog::level::trace, StrEq("5")));
+  EXPECT_EQ(FilterTrailersStatus::Continue, filter_->decodeTrailers(request_trailers));
+}
+
+// body() after the rest of the body has been streamed past a prefix.
+TEST_F(LuaHttpFilterTest, BodyAfterBodyPrefix) {
+  const std::string SCRIPT{R"EOF(
+    function envoy_on_request(request_handle)
+      request_handle:bodyPrefix(1)
+      request_handle:body()
+    end
+  )EOF"};
+
+  InSequence s;
+  setup(SCRIPT);
+
+  TestHeaderMapImpl request_headers{{":path", "/"}};
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, filter_->decodeHeaders(request_headers, false));
+
+  Buffer::OwnedImpl data("hello");
+  EXPECT_CALL(
+      *filter_,
+      scriptLog(spdlog::level::err,
+                StrEq("[string \"...\"]:4: cannot call body() after body streaming has started")));
+  EXPECT_EQ(FilterDataStatus::Continue, filter_->decodeData(data, false));
+}
+
+// bodyPrefix() with a bad size.
+TEST_F(LuaHttpFilterTest, BodyPrefixBadSize) {
+  const std::string SCRIPT{R"EOF(
+    function envoy_on_request(request_handle)
+      request_handle:bodyPrefix(0)
+    end
+  )EOF"};
+
+  InSequence s;
+  setup(SCRIPT);
+
+  TestHeaderMapImpl request_headers{{":path", "/"}};
+  EXPECT_CALL(*filter_,
+              scriptLog(spdlog::level::err,
+                        StrEq("[string \"...\"]:3: bodyPrefix() size must be greater than 0")));
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
+}
+
 } // namespace Lua
 } // namespace Filter
 } // namespace Http
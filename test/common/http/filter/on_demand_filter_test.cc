@@ -0,0 +1,76 @@
+#include <functional>
+#include <memory>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/filter/on_demand_filter.h"
+
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+using testing::SaveArg;
+using testing::_;
+
+namespace Envoy {
+namespace Http {
+
+class OnDemandClusterFilterTest : public testing::Test {
+public:
+  OnDemandClusterFilterTest() : filter_(cm_) { filter_.setDecoderFilterCallbacks(callbacks_); }
+
+  // Start a request for a cluster which hasn't been created, and return the load callback.
+  std::function<void()> startLoad() {
+    std::function<void()> callback;
+    EXPECT_CALL(cm_, get("fake_cluster")).WillOnce(Return(nullptr));
+    EXPECT_CALL(cm_, loadOnDemandCluster("fake_cluster", _, _)).WillOnce(SaveArg<2>(&callback));
+    EXPECT_EQ(FilterHeadersStatus::StopIteration, filter_.decodeHeaders(headers_, false));
+    return callback;
+  }
+
+  NiceMock<Upstream::MockClusterManager> cm_;
+  OnDemandClusterFilter filter_;
+  NiceMock<MockStreamDecoderFilterCallbacks> callbacks_;
+  TestHeaderMapImpl headers_{{":method", "GET"}, {":path", "/"}};
+};
+
+TEST_F(OnDemandClusterFilterTest, ClusterExists) {
+  EXPECT_CALL(cm_, loadOnDemandCluster(_, _, _)).Times(0);
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_.decodeHeaders(headers_, false));
+  Buffer::OwnedImpl data("hello");
+  EXPECT_EQ(FilterDataStatus::Continue, filter_.decodeData(data, false));
+  EXPECT_EQ(FilterTrailersStatus::Continue, filter_.decodeTrailers(headers_));
+}
+
+TEST_F(OnDemandClusterFilterTest, NoRoute) {
+  EXPECT_CALL(callbacks_, route()).WillOnce(Return(nullptr));
+  EXPECT_CALL(cm_, loadOnDemandCluster(_, _, _)).Times(0);
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_.decodeHeaders(headers_, true));
+}
+
+TEST_F(OnDemandClusterFilterTest, LoadCluster) {
+  std::function<void()> callback = startLoad();
+  Buffer::OwnedImpl data("hello");
+  EXPECT_EQ(FilterDataStatus::StopIterationAndWatermark, filter_.decodeData(data, false));
+  EXPECT_EQ(FilterTrailersStatus::StopIteration, filter_.decodeTrailers(headers_));
+
+  EXPECT_CALL(callbacks_, continueDecoding());
+  callback();
+  EXPECT_EQ(FilterDataStatus::Continue, filter_.decodeData(data, false));
+}
+
+TEST_F(OnDemandClusterFilterTest, DestroyedBeforeLoad) {
+  std::function<void()> callback = startLoad();
+  filter_.onDestroy();
+
+  EXPECT_CALL(callbacks_, continueDecoding()).Times(0);
+  callback();
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,201 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "common/common/chunked_list.h"
+#include "common/common/to_lower_table.h"
+#include "common/http/header_map_impl.h"
+#include "common/http/headers.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * Populate a request header map the way a codec does: a handful of O(1) inline headers followed by
+ * a number of custom headers.
+ */
+static void addDummyHeaders(HeaderMapImpl& headers, size_t num_custom,
+                            const std::vector<std::string>& custom_keys) {
+  headers.insertMethod().value(Headers::get().MethodValues.Get);
+  headers.insertPath().value(std::string("/some/path/to/a/resource?with=query"));
+  headers.insertHost().value(std::string("www.example.com"));
+  headers.insertUserAgent().value(std::string("benchmark/1.0"));
+  headers.insertRequestId().value(std::string("3b8e9a4d-4b1f-4d1e-9d7b-0e1e5c0a2f3a"));
+  for (size_t i = 0; i < num_custom; i++) {
+    HeaderString key;
+    key.setCopy(custom_keys[i].c_str(), custom_keys[i].size());
+    HeaderString value;
+    value.setCopy("value", 5);
+    headers.addViaMove(std::move(key), std::move(value));
+  }
+}
+
+static std::vector<std::string> makeCustomKeys(size_t num_custom) {
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < num_custom; i++) {
+    keys.push_back("x-custom-header-" + std::to_string(i));
+  }
+  return keys;
+}
+
+// Build a header map from scratch via the codec (addViaMove) path.
+static void HeaderMapImplPopulate(benchmark::State& state) {
+  const size_t num_custom = state.range(0);
+  const std::vector<std::string> keys = makeCustomKeys(num_custom);
+  while (state.KeepRunning()) {
+    HeaderMapImpl headers;
+    addDummyHeaders(headers, num_custom, keys);
+    benchmark::DoNotOptimize(headers.size());
+  }
+}
+BENCHMARK(HeaderMapImplPopulate)->Arg(0)->Arg(10)->Arg(50);
+
+// O(1) inline header access.
+static void HeaderMapImplGetInline(benchmark::State& state) {
+  const size_t num_custom = state.range(0);
+  const std::vector<std::string> keys = makeCustomKeys(num_custom);
+  HeaderMapImpl headers;
+  addDummyHeaders(headers, num_custom, keys);
+  size_t size = 0;
+  while (state.KeepRunning()) {
+    size += headers.Path()->value().size();
+    size += headers.Host()->value().size();
+  }
+  benchmark::DoNotOptimize(size);
+}
+BENCHMARK(HeaderMapImplGetInline)->Arg(0)->Arg(10)->Arg(50);
+
+// Lookup by name of a custom (non-inline) header, which requires a scan of the map.
+static void HeaderMapImplGetCustom(benchmark::State& state) {
+  const size_t num_custom = state.range(0);
+  const std::vector<std::string> keys = makeCustomKeys(num_custom);
+  HeaderMapImpl headers;
+  addDummyHeaders(headers, num_custom, keys);
+  const LowerCaseString last_key(keys.back());
+  size_t found = 0;
+  while (state.KeepRunning()) {
+    found += headers.get(last_key) != nullptr;
+  }
+  benchmark::DoNotOptimize(found);
+}
+BENCHMARK(HeaderMapImplGetCustom)->Arg(1)->Arg(10)->Arg(50);
+
+// Adding and then removing a custom header by name.
+static void HeaderMapImplAddRemove(benchmark::State& state) {
+  const size_t num_custom = state.range(0);
+  const std::vector<std::string> keys = makeCustomKeys(num_custom);
+  HeaderMapImpl headers;
+  addDummyHeaders(headers, num_custom, keys);
+  const LowerCaseString key("x-benchmark-added");
+  const std::string value("some value");
+  while (state.KeepRunning()) {
+    headers.addReference(key, value);
+    headers.remove(key);
+  }
+  benchmark::DoNotOptimize(headers.size());
+}
+BENCHMARK(HeaderMapImplAddRemove)->Arg(0)->Arg(10)->Arg(50);
+
+// Full iteration over all headers, as done by codecs when encoding.
+static void HeaderMapImplIterate(benchmark::State& state) {
+  const size_t num_custom = state.range(0);
+  const std::vector<std::string> keys = makeCustomKeys(num_custom);
+  HeaderMapImpl headers;
+  addDummyHeaders(headers, num_custom, keys);
+  size_t total = 0;
+  while (state.KeepRunning()) {
+    headers.iterate(
+        [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
+          *static_cast<size_t*>(context) += header.key().size() + header.value().size();
+          return HeaderMap::Iterate::Continue;
+        },
+        &total);
+  }
+  benchmark::DoNotOptimize(total);
+}
+BENCHMARK(HeaderMapImplIterate)->Arg(0)->Arg(10)->Arg(50);
+
+// Copy construction, as done when e.g. shadowing or retrying a request.
+static void HeaderMapImplCopy(benchmark::State& state) {
+  const size_t num_custom = state.range(0);
+  const std::vector<std::string> keys = makeCustomKeys(num_custom);
+  HeaderMapImpl headers;
+  addDummyHeaders(headers, num_custom, keys);
+  while (state.KeepRunning()) {
+    HeaderMapImpl copy(static_cast<const HeaderMap&>(headers));
+    benchmark::DoNotOptimize(copy.size());
+  }
+}
+BENCHMARK(HeaderMapImplCopy)->Arg(0)->Arg(10)->Arg(50);
+
+// Header names received by a codec, lowered and then resolved to their inline slot, or to none for
+// the custom ones.
+static void HeaderMapImplLowerAndLookup(benchmark::State& state) {
+  const std::vector<std::string> keys{"Host", "User-Agent", "Accept", "Content-Type",
+                                      "Content-Length", "X-Request-Id", "X-Forwarded-For",
+                                      "Accept-Encoding", "Cookie",
+                                      "X-Envoy-Upstream-Rq-Timeout-Ms"};
+  ToLowerTable table;
+  while (state.KeepRunning()) {
+    HeaderMapImpl headers;
+    for (const std::string& key : keys) {
+      HeaderString lowered_key;
+      lowered_key.setCopy(key.c_str(), key.size());
+      table.toLowerCase(lowered_key.buffer(), lowered_key.size());
+      HeaderString value;
+      value.setCopy("value", 5);
+      headers.addViaMove(std::move(lowered_key), std::move(value));
+    }
+    benchmark::DoNotOptimize(headers.size());
+  }
+}
+BENCHMARK(HeaderMapImplLowerAndLookup);
+
+/**
+ * A header entry without the map around it, to compare the backing storage of HeaderMapImpl
+ * (ChunkedList) against the std::list it replaced.
+ */
+struct StorageEntry {
+  StorageEntry(HeaderString&& key, HeaderString&& value)
+      : key_(std::move(key)), value_(std::move(value)) {}
+
+  HeaderString key_;
+  HeaderString value_;
+};
+
+// Populate, iterate and destroy the backing storage of a header map.
+template <class List> static void HeaderStoragePopulateIterate(benchmark::State& state) {
+  const size_t num_headers = state.range(0);
+  const std::vector<std::string> keys = makeCustomKeys(num_headers);
+  size_t total = 0;
+  while (state.KeepRunning()) {
+    List list;
+    for (const std::string& key : keys) {
+      HeaderString key_string;
+      key_string.setCopy(key.c_str(), key.size());
+      HeaderString value_string;
+      value_string.setCopy("value", 5);
+      list.emplace_back(std::move(key_string), std::move(value_string));
+    }
+    for (const StorageEntry& entry : list) {
+      total += entry.key_.size() + entry.value_.size();
+    }
+  }
+  benchmark::DoNotOptimize(total);
+}
+BENCHMARK_TEMPLATE(HeaderStoragePopulateIterate, std::list<StorageEntry>)
+    ->Arg(5)
+    ->Arg(15)
+    ->Arg(50);
+BENCHMARK_TEMPLATE(HeaderStoragePopulateIterate, ChunkedList<StorageEntry>)
+    ->Arg(5)
+    ->Arg(15)
+    ->Arg(50);
+
+} // namespace Http
+} // namespace Envoy
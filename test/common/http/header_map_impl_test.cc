@@ -294,6 +294,33 @@ TEST(HeaderMapImplTest, InlineInsert) {
   EXPECT_STREQ("hello", headers.get(Headers::get().Host)->value().c_str());
 }
 
+#define CHECK_STATIC_LOOKUP(name)                                                                  \
+  {                                                                                                \
+    HeaderMapImpl headers;                                                                         \
+    headers.addCopy(Headers::get().name, "value");                                                 \
+    EXPECT_NE(nullptr, headers.name()) << Headers::get().name.get();                               \
+  }
+
+TEST(HeaderMapImplTest, StaticLookup) {
+  ALL_INLINE_HEADERS(CHECK_STATIC_LOOKUP)
+
+  HeaderMapImpl headers;
+  headers.addCopy(Headers::get().HostLegacy, "legacy");
+  EXPECT_STREQ("legacy", headers.Host()->value().c_str());
+
+  // Keys which share a prefix, a suffix or the length of inline headers are not inline.
+  headers.addCopy(LowerCaseString("content-lengt"), "value");
+  headers.addCopy(LowerCaseString("content-lengths"), "value");
+  headers.addCopy(LowerCaseString("x-envoy-upstream-rq-timeout-mx"), "value");
+  headers.addCopy(LowerCaseString("x-envoy-upstream-rq-per-try-timeout"), "value");
+  headers.addCopy(LowerCaseString("tf"), "value");
+  EXPECT_EQ(nullptr, headers.ContentLength());
+  EXPECT_EQ(nullptr, headers.EnvoyUpstreamRequestTimeoutMs());
+  EXPECT_EQ(nullptr, headers.EnvoyUpstreamRequestPerTryTimeoutMs());
+  EXPECT_EQ(nullptr, headers.TE());
+  EXPECT_EQ(6UL, headers.size());
+}
+
 TEST(HeaderMapImplTest, MoveIntoInline) {
   HeaderMapImpl headers;
   HeaderString key;
@@ -305,6 +332,33 @@ TEST(HeaderMapImplTest, MoveIntoInline) {
   EXPECT_STREQ("hello", headers.Host()->value().c_str());
 }
 
+// Inline headers stay valid as the map grows, has headers removed and is moved.
+TEST(HeaderMapImplTest, InlineStableAcrossGrowthAndMove) {
+  HeaderMapImpl headers;
+  HeaderEntry& host = headers.insertHost();
+  host.value(std::string("hello"));
+  for (int i = 0; i < 20; i++) {
+    headers.addCopy(LowerCaseString("x-custom-" + std::to_string(i)), i);
+  }
+  headers.insertPath().value(std::string("/"));
+  for (int i = 0; i < 20; i += 2) {
+    headers.remove(LowerCaseString("x-custom-" + std::to_string(i)));
+  }
+  headers.insertContentLength().value(5);
+  EXPECT_EQ(&host, headers.Host());
+  EXPECT_STREQ("hello", headers.Host()->value().c_str());
+  EXPECT_EQ(13UL, headers.size());
+
+  HeaderMapImpl moved(std::move(headers));
+  EXPECT_EQ(&host, moved.Host());
+  EXPECT_STREQ("/", moved.Path()->value().c_str());
+  EXPECT_STREQ("5", moved.ContentLength()->value().c_str());
+  EXPECT_STREQ("19", moved.get(LowerCaseString("x-custom-19"))->value().c_str());
+  EXPECT_EQ(13UL, moved.size());
+  moved.removeHost();
+  EXPECT_EQ(12UL, moved.size());
+}
+
 TEST(HeaderMapImplTest, Remove) {
   HeaderMapImpl headers;
 
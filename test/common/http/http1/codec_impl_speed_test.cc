@@ -0,0 +1,178 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <algorithm>
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/header_map_impl.h"
+#include "common/http/http1/codec_impl.h"
+
+#include "test/mocks/network/mocks.h"
+
+#include "benchmark/benchmark.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+/**
+ * Minimal hand rolled callbacks. Mocks are avoided in the measured path since their bookkeeping
+ * would dominate the cost of the code under test.
+ */
+class BenchmarkStreamDecoder : public StreamDecoder {
+public:
+  // Http::StreamDecoder
+  void decodeHeaders(HeaderMapPtr&& headers, bool end_stream) override {
+    headers_ = std::move(headers);
+    complete_ = end_stream;
+  }
+  void decodeData(Buffer::Instance& data, bool end_stream) override {
+    data.drain(data.length());
+    complete_ = end_stream;
+  }
+  void decodeTrailers(HeaderMapPtr&&) override { complete_ = true; }
+
+  HeaderMapPtr headers_;
+  bool complete_{};
+};
+
+class BenchmarkServerCallbacks : public ServerConnectionCallbacks {
+public:
+  // Http::ConnectionCallbacks
+  void onGoAway() override {}
+
+  // Http::ServerConnectionCallbacks
+  StreamDecoder& newStream(StreamEncoder& response_encoder) override {
+    response_encoder_ = &response_encoder;
+    return decoder_;
+  }
+
+  BenchmarkStreamDecoder decoder_;
+  StreamEncoder* response_encoder_{};
+};
+
+static std::string makeRequest(size_t num_headers, size_t body_size) {
+  std::string request = "POST /some/path/to/a/resource?with=query HTTP/1.1\r\n"
+                        "host: www.example.com\r\n"
+                        "user-agent: benchmark/1.0\r\n"
+                        "content-type: application/json\r\n";
+  for (size_t i = 0; i < num_headers; i++) {
+    request += "x-custom-header-" + std::to_string(i) + ": some_header_value\r\n";
+  }
+  request += "content-length: " + std::to_string(body_size) + "\r\n\r\n";
+  request += std::string(body_size, 'a');
+  return request;
+}
+
+// Dispatch a full request through the server codec and respond to it, so that each iteration
+// covers the complete per-request parse/encode cycle on a keep-alive connection.
+static void Http1ServerDispatch(benchmark::State& state) {
+  const std::string request = makeRequest(state.range(0), state.range(1));
+  NiceMock<Network::MockConnection> connection;
+  BenchmarkServerCallbacks callbacks;
+  Http1Settings settings;
+  ServerConnectionImpl codec(connection, callbacks, settings);
+  const HeaderMapImpl response_headers{{Headers::get().Status, "200"}};
+
+  while (state.KeepRunning()) {
+    Buffer::OwnedImpl buffer(request);
+    codec.dispatch(buffer);
+    callbacks.response_encoder_->encodeHeaders(response_headers, true);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * request.size());
+}
+BENCHMARK(Http1ServerDispatch)->Args({0, 0})->Args({10, 0})->Args({10, 4096})->Args({50, 0});
+
+// As above, but the request arrives in small fragments, exercising the parser's reentry path.
+static void Http1ServerDispatchFragmented(benchmark::State& state) {
+  const std::string request = makeRequest(10, 0);
+  const size_t fragment_size = state.range(0);
+  NiceMock<Network::MockConnection> connection;
+  BenchmarkServerCallbacks callbacks;
+  Http1Settings settings;
+  ServerConnectionImpl codec(connection, callbacks, settings);
+  const HeaderMapImpl response_headers{{Headers::get().Status, "200"}};
+
+  while (state.KeepRunning()) {
+    for (size_t offset = 0; offset < request.size(); offset += fragment_size) {
+      Buffer::OwnedImpl buffer(request.data() + offset,
+                               std::min(fragment_size, request.size() - offset));
+      codec.dispatch(buffer);
+    }
+    callbacks.response_encoder_->encodeHeaders(response_headers, true);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * request.size());
+}
+BENCHMARK(Http1ServerDispatchFragmented)->Arg(16)->Arg(128);
+
+static std::string makeGetRequest(size_t num_headers) {
+  std::string request = "GET /some/path/to/a/resource?with=query HTTP/1.1\r\n"
+                        "host: www.example.com\r\n"
+                        "user-agent: benchmark/1.0\r\n"
+                        "accept: */*\r\n";
+  for (size_t i = 0; i < num_headers; i++) {
+    request += "x-custom-header-" + std::to_string(i) + ": some_header_value\r\n";
+  }
+  request += "\r\n";
+  return request;
+}
+
+// Dispatch a bodyless GET, with (range(1) != 0) and without the request head fast path.
+static void Http1ServerDispatchGet(benchmark::State& state) {
+  const std::string request = makeGetRequest(state.range(0));
+  NiceMock<Network::MockConnection> connection;
+  BenchmarkServerCallbacks callbacks;
+  Http1Settings settings;
+  settings.fast_request_head_parsing_ = state.range(1) != 0;
+  ServerConnectionImpl codec(connection, callbacks, settings);
+  const HeaderMapImpl response_headers{{Headers::get().Status, "200"}};
+
+  while (state.KeepRunning()) {
+    Buffer::OwnedImpl buffer(request);
+    codec.dispatch(buffer);
+    callbacks.response_encoder_->encodeHeaders(response_headers, true);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * request.size());
+}
+BENCHMARK(Http1ServerDispatchGet)
+    ->Args({0, 0})
+    ->Args({0, 1})
+    ->Args({10, 0})
+    ->Args({10, 1})
+    ->Args({50, 0})
+    ->Args({50, 1});
+
+// Report the memory held by the codec of an idle keep-alive connection which has served one
+// request, with (range(0) != 0) and without the codec being released while idle, as the
+// connection manager does with the http.http1.release_idle_codec runtime key. Only the codec
+// object itself is counted, as the buffers it uses are drained once the request completes.
+static void Http1ServerIdleConnectionMemory(benchmark::State& state) {
+  const bool release_idle_codec = state.range(0) != 0;
+  const std::string request = makeGetRequest(10);
+  NiceMock<Network::MockConnection> connection;
+  BenchmarkServerCallbacks callbacks;
+  Http1Settings settings;
+  const HeaderMapImpl response_headers{{Headers::get().Status, "200"}};
+  size_t idle_bytes = 0;
+
+  while (state.KeepRunning()) {
+    ServerConnectionPtr codec{new ServerConnectionImpl(connection, callbacks, settings)};
+    Buffer::OwnedImpl buffer(request);
+    codec->dispatch(buffer);
+    callbacks.response_encoder_->encodeHeaders(response_headers, true);
+    callbacks.decoder_.headers_.reset();
+    if (release_idle_codec && codec->idle()) {
+      codec.reset();
+    }
+    idle_bytes = codec ? sizeof(ServerConnectionImpl) : 0;
+  }
+  state.counters["bytes_per_idle_connection"] = idle_bytes;
+}
+BENCHMARK(Http1ServerIdleConnectionMemory)->Arg(0)->Arg(1);
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
@@ -347,6 +347,39 @@ TEST_F(Http1ServerConnectionImplTest, HeaderOnlyResponse) {
   EXPECT_EQ("HTTP/1.1 200 OK\r\ncontent-length: 0\r\n\r\n", output);
 }
 
+TEST_F(Http1ServerConnectionImplTest, Idle) {
+  initialize();
+  EXPECT_TRUE(codec_->idle());
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  Http::StreamEncoder* response_encoder = nullptr;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .WillRepeatedly(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoder = &encoder;
+        return decoder;
+      }));
+
+  // Not idle in the middle of a request.
+  Buffer::OwnedImpl buffer("GET / HTTP/1.1\r\n");
+  codec_->dispatch(buffer);
+  EXPECT_FALSE(codec_->idle());
+
+  // Or until it has been responded to.
+  buffer.add("\r\n");
+  codec_->dispatch(buffer);
+  EXPECT_FALSE(codec_->idle());
+
+  TestHeaderMapImpl headers{{":status", "200"}};
+  response_encoder->encodeHeaders(headers, true);
+  EXPECT_TRUE(codec_->idle());
+
+  // A request which closes the connection leaves it unusable for the next one.
+  buffer.add("GET / HTTP/1.1\r\nconnection: close\r\n\r\n");
+  codec_->dispatch(buffer);
+  response_encoder->encodeHeaders(headers, true);
+  EXPECT_FALSE(codec_->idle());
+}
+
 TEST_F(Http1ServerConnectionImplTest, ChunkedResponse) {
   initialize();
 
@@ -374,6 +407,40 @@ TEST_F(Http1ServerConnectionImplTest, ChunkedResponse) {
             output);
 }
 
+// Externally owned data is passed through the encoder to the connection, and released once the
+// connection has written it out.
+TEST_F(Http1ServerConnectionImplTest, BufferFragmentResponse) {
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  Http::StreamEncoder* response_encoder = nullptr;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .WillOnce(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoder = &encoder;
+        return decoder;
+      }));
+
+  Buffer::OwnedImpl buffer("GET / HTTP/1.1\r\n\r\n");
+  codec_->dispatch(buffer);
+
+  std::string output;
+  ON_CALL(connection_, write(_)).WillByDefault(AddBufferToString(&output));
+
+  TestHeaderMapImpl headers{{":status", "200"}, {"content-length", "11"}};
+  response_encoder->encodeHeaders(headers, false);
+
+  static const char BODY[] = "Hello World";
+  bool released = false;
+  Buffer::BufferFragmentImpl fragment(
+      BODY, sizeof(BODY) - 1,
+      [&](const void*, size_t, const Buffer::BufferFragmentImpl*) { released = true; });
+  Buffer::OwnedImpl data;
+  data.addBufferFragment(fragment);
+  response_encoder->encodeData(data, true);
+  EXPECT_EQ("HTTP/1.1 200 OK\r\ncontent-length: 11\r\n\r\nHello World", output);
+  EXPECT_TRUE(released);
+}
+
 TEST_F(Http1ServerConnectionImplTest, ContentLengthResponse) {
   initialize();
 
@@ -473,6 +540,113 @@ TEST_F(Http1ServerConnectionImplTest, DoubleRequest) {
   EXPECT_EQ(0U, buffer.length());
 }
 
+TEST_F(Http1ServerConnectionImplTest, FastPathGet) {
+  codec_settings_.fast_request_head_parsing_ = true;
+  initialize();
+
+  InSequence sequence;
+
+  Http::MockStreamDecoder decoder;
+  EXPECT_CALL(callbacks_, newStream(_)).WillOnce(ReturnRef(decoder));
+
+  TestHeaderMapImpl expected_headers{{":authority", "hello"},
+                                     {"x-foo", "bar baz"},
+                                     {"connection", "Keep-Alive"},
+                                     {":path", "/path?query=1"},
+                                     {":method", "HEAD"}};
+  EXPECT_CALL(decoder, decodeHeaders_(HeaderMapEqual(&expected_headers), true)).Times(1);
+
+  Buffer::OwnedImpl buffer("HEAD /path?query=1 HTTP/1.1\r\nHOST: hello\r\nX-Foo:\tbar baz\r\n"
+                           "Connection: Keep-Alive\r\n\r\n");
+  codec_->dispatch(buffer);
+  EXPECT_EQ(0U, buffer.length());
+}
+
+// The fast path only dispatches one request at a time, like http_parser.
+TEST_F(Http1ServerConnectionImplTest, FastPathDoubleRequest) {
+  codec_settings_.fast_request_head_parsing_ = true;
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  Http::StreamEncoder* response_encoder = nullptr;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoder = &encoder;
+        return decoder;
+      }));
+
+  std::string request("GET / HTTP/1.1\r\nhost: hello\r\n\r\n");
+  Buffer::OwnedImpl buffer(request);
+  buffer.add(request);
+
+  codec_->dispatch(buffer);
+  EXPECT_EQ(request.size(), buffer.length());
+
+  response_encoder->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, true);
+
+  codec_->dispatch(buffer);
+  EXPECT_EQ(0U, buffer.length());
+}
+
+// Requests which the fast path declines are parsed by http_parser, and the fast path picks up
+// again for the following request.
+TEST_F(Http1ServerConnectionImplTest, FastPathFallback) {
+  codec_settings_.fast_request_head_parsing_ = true;
+  initialize();
+
+  InSequence sequence;
+
+  Http::MockStreamDecoder decoder;
+  Http::StreamEncoder* response_encoder = nullptr;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .WillOnce(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoder = &encoder;
+        return decoder;
+      }));
+  TestHeaderMapImpl expected_post{{"content-length", "5"}, {":path", "/"}, {":method", "POST"}};
+  EXPECT_CALL(decoder, decodeHeaders_(HeaderMapEqual(&expected_post), false)).Times(1);
+  Buffer::OwnedImpl expected_data("12345");
+  EXPECT_CALL(decoder, decodeData(BufferEqual(&expected_data), false)).Times(1);
+  EXPECT_CALL(decoder, decodeData(_, true)).Times(1);
+
+  Buffer::OwnedImpl buffer("POST / HTTP/1.1\r\ncontent-length: 5\r\n\r\n12345");
+  codec_->dispatch(buffer);
+  EXPECT_EQ(0U, buffer.length());
+  response_encoder->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, true);
+
+  EXPECT_CALL(callbacks_, newStream(_)).WillOnce(ReturnRef(decoder));
+  TestHeaderMapImpl expected_get{{":path", "/"}, {":method", "GET"}};
+  EXPECT_CALL(decoder, decodeHeaders_(HeaderMapEqual(&expected_get), true)).Times(1);
+
+  Buffer::OwnedImpl buffer2("GET / HTTP/1.1\r\n\r\n");
+  codec_->dispatch(buffer2);
+  EXPECT_EQ(0U, buffer2.length());
+}
+
+// After a request which closes the connection, further requests are rejected by http_parser
+// rather than parsed by the fast path.
+TEST_F(Http1ServerConnectionImplTest, FastPathAfterConnectionClose) {
+  codec_settings_.fast_request_head_parsing_ = true;
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  Http::StreamEncoder* response_encoder = nullptr;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .WillOnce(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoder = &encoder;
+        return decoder;
+      }));
+
+  Buffer::OwnedImpl buffer("GET / HTTP/1.1\r\nconnection: close\r\n\r\n");
+  codec_->dispatch(buffer);
+  EXPECT_EQ(0U, buffer.length());
+  response_encoder->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, true);
+
+  Buffer::OwnedImpl buffer2("GET / HTTP/1.1\r\n\r\n");
+  EXPECT_THROW(codec_->dispatch(buffer2), CodecProtocolException);
+}
+
 TEST_F(Http1ServerConnectionImplTest, RequestWithTrailers) {
   initialize();
 
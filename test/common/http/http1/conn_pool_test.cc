@@ -126,7 +126,8 @@ public:
 struct ActiveTestRequest {
   enum class Type { Pending, CreateConnection, Immediate };
 
-  ActiveTestRequest(Http1ConnPoolImplTest& parent, size_t client_index, Type type)
+  ActiveTestRequest(Http1ConnPoolImplTest& parent, size_t client_index, Type type,
+                    bool pipelinable = false)
       : parent_(parent), client_index_(client_index) {
 
     if (type == Type::CreateConnection) {
@@ -137,7 +138,8 @@ struct ActiveTestRequest {
       expectNewStream();
     }
 
-    handle_ = parent.conn_pool_.newStream(outer_decoder_, callbacks_);
+    handle_ = pipelinable ? parent.conn_pool_.newPipelinableStream(outer_decoder_, callbacks_)
+                          : parent.conn_pool_.newStream(outer_decoder_, callbacks_);
 
     if (type == Type::Immediate) {
       EXPECT_EQ(nullptr, handle_);
@@ -545,6 +547,212 @@ TEST_F(Http1ConnPoolImplTest, ConcurrentConnections) {
   dispatcher_.clearDeferredDeleteList();
 }
 
+/**
+ * Test that requests are pipelined behind pipelinable requests once no more connections may be
+ * opened, and only on a connection which has kept alive across a response.
+ */
+TEST_F(Http1ConnPoolImplTest, PipelineRequests) {
+  InSequence s;
+
+  cluster_->http1_max_pipelined_requests_ = 2;
+  ActiveTestRequest r1(*this, 0, ActiveTestRequest::Type::CreateConnection, true);
+  r1.startRequest();
+
+  // The connection has yet to keep alive.
+  ActiveTestRequest r2(*this, 0, ActiveTestRequest::Type::Pending, true);
+  r2.expectNewStream();
+  r1.completeResponse(false);
+  r2.startRequest();
+
+  // r3 is pipelined behind r2, while r4 would go over the pipelined requests allowed.
+  ActiveTestRequest r3(*this, 0, ActiveTestRequest::Type::Immediate, true);
+  r3.startRequest();
+  EXPECT_EQ(1U, cluster_->stats_.upstream_rq_pipelined_.value());
+  ActiveTestRequest r4(*this, 0, ActiveTestRequest::Type::Pending, true);
+
+  // The connection serves r3 once r2 completes, and r4 once idle again.
+  r2.completeResponse(false);
+  r4.expectNewStream();
+  r3.completeResponse(true);
+  r4.startRequest();
+
+  // A request which is not pipelinable is not pipelined behind.
+  ActiveTestRequest r5(*this, 0, ActiveTestRequest::Type::Pending);
+  r5.expectNewStream();
+  r4.completeResponse(false);
+  r5.startRequest();
+  ActiveTestRequest r6(*this, 0, ActiveTestRequest::Type::Pending, true);
+  EXPECT_EQ(1U, cluster_->stats_.upstream_rq_pipelined_.value());
+  r6.expectNewStream();
+  r5.completeResponse(false);
+  r6.startRequest();
+  r6.completeResponse(false);
+
+  EXPECT_CALL(conn_pool_, onClientDestroy());
+  conn_pool_.test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  dispatcher_.clearDeferredDeleteList();
+}
+
+/**
+ * Test that requests pipelined behind a response closing the connection are reset.
+ */
+TEST_F(Http1ConnPoolImplTest, PipelinedRequestsResetOnConnectionClose) {
+  InSequence s;
+
+  cluster_->http1_max_pipelined_requests_ = 2;
+  ActiveTestRequest r1(*this, 0, ActiveTestRequest::Type::CreateConnection, true);
+  r1.startRequest();
+  r1.completeResponse(false);
+
+  ActiveTestRequest r2(*this, 0, ActiveTestRequest::Type::Immediate, true);
+  r2.startRequest();
+  ActiveTestRequest r3(*this, 0, ActiveTestRequest::Type::Immediate, true);
+  r3.startRequest();
+
+  Http::MockStreamCallbacks stream_callbacks;
+  EXPECT_CALL(stream_callbacks, onResetStream(StreamResetReason::ConnectionTermination));
+  r3.request_encoder_.getStream().addCallbacks(stream_callbacks);
+
+  EXPECT_CALL(conn_pool_, onClientDestroy());
+  r2.inner_decoder_->decodeHeaders(
+      HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}, {"Connection", "Close"}}}, true);
+  dispatcher_.clearDeferredDeleteList();
+
+  EXPECT_EQ(1U, cluster_->stats_.upstream_cx_destroy_with_active_rq_.value());
+}
+
+/**
+ * Test that idle connections are opened ahead of demand.
+ */
+TEST_F(Http1ConnPoolImplTest, PrefetchMinIdleConnections) {
+  cluster_->http1_min_idle_connections_ = 1;
+  cluster_->resource_manager_.reset(
+      new Upstream::ResourceManagerImpl(runtime_, "fake_key", 3, 1024, 1024, 1));
+
+  // The request waits for the first connection, and a second one is opened to be idle.
+  {
+    InSequence s;
+    conn_pool_.expectClientCreate();
+    conn_pool_.expectClientCreate();
+  }
+  ActiveTestRequest r1(*this, 0, ActiveTestRequest::Type::Pending);
+  EXPECT_EQ(2U, cluster_->stats_.upstream_cx_total_.value());
+  EXPECT_EQ(1U, cluster_->stats_.upstream_cx_prefetched_.value());
+
+  r1.expectNewStream();
+  conn_pool_.test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  r1.startRequest();
+  conn_pool_.test_clients_[1].connection_->raiseEvent(Network::ConnectionEvent::Connected);
+
+  // The next request uses the idle connection straight away, and another one is opened.
+  conn_pool_.expectClientCreate();
+  ActiveTestRequest r2(*this, 1, ActiveTestRequest::Type::Immediate);
+  r2.startRequest();
+  EXPECT_EQ(3U, cluster_->stats_.upstream_cx_total_.value());
+  EXPECT_EQ(2U, cluster_->stats_.upstream_cx_prefetched_.value());
+  conn_pool_.test_clients_[2].connection_->raiseEvent(Network::ConnectionEvent::Connected);
+
+  r1.completeResponse(false);
+  r2.completeResponse(false);
+
+  EXPECT_CALL(conn_pool_, onClientDestroy()).Times(3);
+  conn_pool_.test_clients_[2].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  conn_pool_.test_clients_[1].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  conn_pool_.test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  dispatcher_.clearDeferredDeleteList();
+}
+
+/**
+ * Test that connections are opened in proportion to the requests.
+ */
+TEST_F(Http1ConnPoolImplTest, PrefetchPercent) {
+  cluster_->http1_prefetch_percent_ = 200;
+  cluster_->resource_manager_.reset(
+      new Upstream::ResourceManagerImpl(runtime_, "fake_key", 3, 1024, 1024, 1));
+
+  {
+    InSequence s;
+    conn_pool_.expectClientCreate();
+    conn_pool_.expectClientCreate();
+  }
+  ActiveTestRequest r1(*this, 0, ActiveTestRequest::Type::Pending);
+  EXPECT_EQ(1U, cluster_->stats_.upstream_cx_prefetched_.value());
+
+  // No more connections are opened beyond the connection limit.
+  conn_pool_.expectClientCreate();
+  ActiveTestRequest r2(*this, 0, ActiveTestRequest::Type::Pending);
+  EXPECT_EQ(3U, cluster_->stats_.upstream_cx_total_.value());
+  EXPECT_EQ(1U, cluster_->stats_.upstream_cx_prefetched_.value());
+
+  r1.handle_->cancel();
+  r2.handle_->cancel();
+  EXPECT_CALL(conn_pool_, onClientDestroy()).Times(3);
+  conn_pool_.test_clients_[2].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  conn_pool_.test_clients_[1].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  conn_pool_.test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  dispatcher_.clearDeferredDeleteList();
+}
+
+/**
+ * Test that idle connections are reused most recently used first.
+ */
+TEST_F(Http1ConnPoolImplTest, MostRecentlyUsedFirst) {
+  InSequence s;
+
+  cluster_->resource_manager_.reset(
+      new Upstream::ResourceManagerImpl(runtime_, "fake_key", 2, 1024, 1024, 1));
+  ActiveTestRequest r1(*this, 0, ActiveTestRequest::Type::CreateConnection);
+  r1.startRequest();
+  ActiveTestRequest r2(*this, 1, ActiveTestRequest::Type::CreateConnection);
+  r2.startRequest();
+
+  r1.completeResponse(false);
+  r2.completeResponse(false);
+
+  // The second connection became idle last, so it is used first.
+  ActiveTestRequest r3(*this, 1, ActiveTestRequest::Type::Immediate);
+  r3.startRequest();
+  r3.completeResponse(false);
+
+  EXPECT_CALL(conn_pool_, onClientDestroy()).Times(2);
+  conn_pool_.test_clients_[1].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  conn_pool_.test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  dispatcher_.clearDeferredDeleteList();
+}
+
+/**
+ * Test that idle connections are closed after the idle timeout.
+ */
+TEST_F(Http1ConnPoolImplTest, IdleTimeout) {
+  InSequence s;
+  cluster_->http1_idle_timeout_ = std::chrono::milliseconds(1000);
+
+  ActiveTestRequest r1(*this, 0, ActiveTestRequest::Type::CreateConnection);
+  r1.startRequest();
+  Event::MockTimer* idle_timer = new Event::MockTimer(&dispatcher_);
+  EXPECT_CALL(*idle_timer, enableTimer(std::chrono::milliseconds(1000)));
+  r1.completeResponse(false);
+
+  // Reusing the connection disarms the timer until it is idle again.
+  EXPECT_CALL(*idle_timer, disableTimer());
+  ActiveTestRequest r2(*this, 0, ActiveTestRequest::Type::Immediate);
+  r2.startRequest();
+  EXPECT_CALL(*idle_timer, enableTimer(std::chrono::milliseconds(1000)));
+  r2.completeResponse(false);
+
+  // The connection is kept while it is the only idle one wanted.
+  cluster_->http1_min_idle_connections_ = 1;
+  idle_timer->callback_();
+  EXPECT_EQ(0U, cluster_->stats_.upstream_cx_idle_timeout_.value());
+
+  cluster_->http1_min_idle_connections_ = 0;
+  EXPECT_CALL(*idle_timer, disableTimer());
+  EXPECT_CALL(conn_pool_, onClientDestroy());
+  idle_timer->callback_();
+  dispatcher_.clearDeferredDeleteList();
+  EXPECT_EQ(1U, cluster_->stats_.upstream_cx_idle_timeout_.value());
+}
+
 TEST_F(Http1ConnPoolImplTest, DrainCallback) {
   InSequence s;
   ReadyWatcher drained;
@@ -0,0 +1,122 @@
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/http/http1/request_head_parser.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+class RequestHeadParserTest : public testing::Test {
+public:
+  size_t parse(const std::string& input) { return parser_.parse(input.c_str(), input.size()); }
+
+  std::string url() const { return std::string(parser_.url().data_, parser_.url().length_); }
+
+  std::vector<std::pair<std::string, std::string>> headers() const {
+    std::vector<std::pair<std::string, std::string>> headers;
+    for (const RequestHeadParser::Header& header : parser_.headers()) {
+      headers.emplace_back(std::string(header.name_.data_, header.name_.length_),
+                           std::string(header.value_.data_, header.value_.length_));
+    }
+    return headers;
+  }
+
+  void expectDeclined(const std::string& input) { EXPECT_EQ(0U, parse(input)) << input; }
+
+  RequestHeadParser parser_;
+};
+
+TEST_F(RequestHeadParserTest, NoHeaders) {
+  const std::string head = "GET / HTTP/1.1\r\n\r\n";
+  EXPECT_EQ(head.size(), parse(head));
+  EXPECT_EQ(HTTP_GET, parser_.method());
+  EXPECT_EQ("/", url());
+  EXPECT_TRUE(parser_.headers().empty());
+}
+
+TEST_F(RequestHeadParserTest, Headers) {
+  const std::string head = "HEAD /some/path?a=b&c=%20 HTTP/1.1\r\n"
+                           "Host: example.com\r\n"
+                           "x-leading-ws:   \tvalue with spaces\r\n"
+                           "Connection: keep-alive\r\n"
+                           "user-agent:no-space\r\n"
+                           "\r\n";
+  // Spans point into the input, which must outlive them.
+  const std::string input = head + "GET / HTTP/1.1\r\n\r\n";
+  EXPECT_EQ(head.size(), parse(input));
+  EXPECT_EQ(HTTP_HEAD, parser_.method());
+  EXPECT_EQ("/some/path?a=b&c=%20", url());
+  EXPECT_EQ((std::vector<std::pair<std::string, std::string>>{
+                {"Host", "example.com"},
+                {"x-leading-ws", "value with spaces"},
+                {"Connection", "keep-alive"},
+                {"user-agent", "no-space"}}),
+            headers());
+
+  // Headers of a previous parse are not kept.
+  EXPECT_NE(0U, parse("DELETE /a HTTP/1.1\r\n\r\n"));
+  EXPECT_EQ(HTTP_DELETE, parser_.method());
+  EXPECT_TRUE(parser_.headers().empty());
+  EXPECT_NE(0U, parse("OPTIONS /a HTTP/1.1\r\n\r\n"));
+  EXPECT_EQ(HTTP_OPTIONS, parser_.method());
+}
+
+TEST_F(RequestHeadParserTest, Incomplete) {
+  const std::string head = "GET / HTTP/1.1\r\nhost: example.com\r\n\r\n";
+  for (size_t i = 0; i < head.size(); i++) {
+    expectDeclined(head.substr(0, i));
+  }
+}
+
+TEST_F(RequestHeadParserTest, DeclinedRequestLine) {
+  expectDeclined("POST / HTTP/1.1\r\n\r\n");
+  expectDeclined("PUT / HTTP/1.1\r\n\r\n");
+  expectDeclined("CONNECT example.com:443 HTTP/1.1\r\n\r\n");
+  expectDeclined("get / HTTP/1.1\r\n\r\n");
+  expectDeclined("GET  / HTTP/1.1\r\n\r\n");
+  expectDeclined("GET http://example.com/ HTTP/1.1\r\n\r\n");
+  expectDeclined("OPTIONS * HTTP/1.1\r\n\r\n");
+  expectDeclined("GET /#fragment HTTP/1.1\r\n\r\n");
+  expectDeclined("GET /\x7f HTTP/1.1\r\n\r\n");
+  expectDeclined("GET /\x80 HTTP/1.1\r\n\r\n");
+  expectDeclined("GET / HTTP/1.0\r\n\r\n");
+  expectDeclined("GET / HTTP/1.1 \r\n\r\n");
+  expectDeclined("GET / HTTP/1.1\n\n");
+  expectDeclined("GET /\r\n\r\n");
+}
+
+TEST_F(RequestHeadParserTest, DeclinedHeaders) {
+  const std::string request_line = "GET / HTTP/1.1\r\n";
+  expectDeclined(request_line + "content-length: 0\r\n\r\n");
+  expectDeclined(request_line + "Transfer-Encoding: chunked\r\n\r\n");
+  expectDeclined(request_line + "connection: close\r\n\r\n");
+  expectDeclined(request_line + "connection: keep-alive, upgrade\r\n\r\n");
+  expectDeclined(request_line + "upgrade: websocket\r\n\r\n");
+  expectDeclined(request_line + "proxy-connection: keep-alive\r\n\r\n");
+  expectDeclined(request_line + "host: a\r\n continued\r\n\r\n");
+  expectDeclined(request_line + "host : a\r\n\r\n");
+  expectDeclined(request_line + ": a\r\n\r\n");
+  expectDeclined(request_line + "host\r\n\r\n");
+  expectDeclined(request_line + "host:\r\n\r\n");
+  expectDeclined(request_line + "host: \r\n\r\n");
+  expectDeclined(request_line + "host: a \r\n\r\n");
+  expectDeclined(request_line + "host: a\n\r\n");
+  expectDeclined(request_line + "host: a\rb\r\n\r\n");
+  expectDeclined(request_line + std::string("host: a\0b\r\n\r\n", 13));
+  expectDeclined(request_line + "host: a\x7f\r\n\r\n");
+}
+
+// Heads larger than http_parser accepts are left to http_parser to reject.
+TEST_F(RequestHeadParserTest, TooLarge) {
+  const std::string head = "GET / HTTP/1.1\r\nx-large: " + std::string(HTTP_MAX_HEADER_SIZE, 'a') +
+                           "\r\n\r\n";
+  expectDeclined(head);
+}
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,148 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/header_map_impl.h"
+#include "common/http/http2/codec_impl.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/network/mocks.h"
+
+#include "benchmark/benchmark.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::_;
+
+namespace Envoy {
+namespace Http {
+namespace Http2 {
+
+/**
+ * Minimal hand rolled callbacks. Mocks are avoided in the measured path (other than the network
+ * connection, whose write() is used only to shuttle frames between the two codecs).
+ */
+class BenchmarkStreamDecoder : public StreamDecoder {
+public:
+  // Http::StreamDecoder
+  void decodeHeaders(HeaderMapPtr&& headers, bool end_stream) override {
+    headers_ = std::move(headers);
+    complete_ = end_stream;
+  }
+  void decodeData(Buffer::Instance& data, bool end_stream) override {
+    bytes_ += data.length();
+    complete_ = end_stream;
+  }
+  void decodeTrailers(HeaderMapPtr&&) override { complete_ = true; }
+
+  HeaderMapPtr headers_;
+  uint64_t bytes_{};
+  bool complete_{};
+};
+
+class BenchmarkConnectionCallbacks : public ServerConnectionCallbacks {
+public:
+  // Http::ConnectionCallbacks
+  void onGoAway() override {}
+
+  // Http::ServerConnectionCallbacks
+  StreamDecoder& newStream(StreamEncoder& response_encoder) override {
+    response_encoder_ = &response_encoder;
+    return request_decoder_;
+  }
+
+  BenchmarkStreamDecoder request_decoder_;
+  StreamEncoder* response_encoder_{};
+};
+
+/**
+ * A connected client/server codec pair. Frames written by one side are dispatched into the other
+ * synchronously.
+ */
+class CodecPair {
+public:
+  CodecPair()
+      : client_(client_connection_, callbacks_, stats_store_, settings_),
+        server_(server_connection_, callbacks_, stats_store_, settings_) {
+    ON_CALL(client_connection_, write(_)).WillByDefault(Invoke([&](Buffer::Instance& data) {
+      dispatch(data, server_buffer_, server_, server_dispatching_);
+    }));
+    ON_CALL(server_connection_, write(_)).WillByDefault(Invoke([&](Buffer::Instance& data) {
+      dispatch(data, client_buffer_, client_, client_dispatching_);
+    }));
+  }
+
+  static void dispatch(Buffer::Instance& data, Buffer::OwnedImpl& buffer, ConnectionImpl& codec,
+                       bool& dispatching) {
+    buffer.move(data);
+    if (!dispatching) {
+      dispatching = true;
+      while (buffer.length() > 0) {
+        codec.dispatch(buffer);
+      }
+      dispatching = false;
+    }
+  }
+
+  void cleanup() {
+    client_connection_.dispatcher_.to_delete_.clear();
+    server_connection_.dispatcher_.to_delete_.clear();
+  }
+
+  Stats::IsolatedStoreImpl stats_store_;
+  Http2Settings settings_;
+  BenchmarkConnectionCallbacks callbacks_;
+  NiceMock<Network::MockConnection> client_connection_;
+  NiceMock<Network::MockConnection> server_connection_;
+  ClientConnectionImpl client_;
+  ServerConnectionImpl server_;
+  Buffer::OwnedImpl client_buffer_;
+  Buffer::OwnedImpl server_buffer_;
+  bool client_dispatching_{};
+  bool server_dispatching_{};
+};
+
+static HeaderMapImpl makeRequestHeaders(size_t num_headers) {
+  HeaderMapImpl headers{{Headers::get().Method, "POST"},
+                        {Headers::get().Path, "/some/path/to/a/resource?with=query"},
+                        {Headers::get().Scheme, "http"},
+                        {Headers::get().Host, "www.example.com"}};
+  for (size_t i = 0; i < num_headers; i++) {
+    headers.addCopy(LowerCaseString("x-custom-header-" + std::to_string(i)), "some_header_value");
+  }
+  return headers;
+}
+
+// A full request/response exchange on a single multiplexed connection: HEADERS (+ DATA) in both
+// directions, including HPACK encode/decode and nghttp2 frame processing on both codecs.
+static void Http2RequestResponse(benchmark::State& state) {
+  CodecPair codecs;
+  const HeaderMapImpl request_headers = makeRequestHeaders(state.range(0));
+  const HeaderMapImpl response_headers{{Headers::get().Status, "200"}};
+  const std::string body(state.range(1), 'a');
+
+  while (state.KeepRunning()) {
+    BenchmarkStreamDecoder response_decoder;
+    StreamEncoder& request_encoder = codecs.client_.newStream(response_decoder);
+    if (body.empty()) {
+      request_encoder.encodeHeaders(request_headers, true);
+      codecs.callbacks_.response_encoder_->encodeHeaders(response_headers, true);
+    } else {
+      request_encoder.encodeHeaders(request_headers, false);
+      Buffer::OwnedImpl request_body(body);
+      request_encoder.encodeData(request_body, true);
+      codecs.callbacks_.response_encoder_->encodeHeaders(response_headers, false);
+      Buffer::OwnedImpl response_body(body);
+      codecs.callbacks_.response_encoder_->encodeData(response_body, true);
+    }
+    codecs.cleanup();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(Http2RequestResponse)->Args({0, 0})->Args({10, 0})->Args({10, 4096})->Args({10, 65536});
+
+} // namespace Http2
+} // namespace Http
+} // namespace Envoy
@@ -270,6 +270,88 @@ TEST_P(Http2CodecImplTest, TrailingHeadersLargeBody) {
   response_encoder_->encodeTrailers(TestHeaderMapImpl{{"trailing", "header"}});
 }
 
+TEST_P(Http2CodecImplTest, SingleWritePerSend) {
+  initialize();
+
+  TestHeaderMapImpl request_headers;
+  HttpTestUtility::addDefaultHeaders(request_headers);
+  EXPECT_CALL(request_decoder_, decodeHeaders_(_, false));
+  request_encoder_->encodeHeaders(request_headers, false);
+
+  // The body spans several DATA frames, which are all written to the connection at once.
+  EXPECT_CALL(client_connection_, write(_));
+  EXPECT_CALL(request_decoder_, decodeData(_, _)).Times(AtLeast(2));
+  Buffer::OwnedImpl body(std::string(32 * 1024, 'a'));
+  request_encoder_->encodeData(body, true);
+}
+
+TEST_P(Http2CodecImplTest, PseudoHeadersFirst) {
+  initialize();
+
+  TestHeaderMapImpl request_headers{{"foo", "bar"}};
+  HttpTestUtility::addDefaultHeaders(request_headers);
+  EXPECT_CALL(request_decoder_, decodeHeaders_(_, true));
+  request_encoder_->encodeHeaders(request_headers, true);
+
+  // The ':' header follows another one in the map, and the headers are sent before encodeHeaders()
+  // returns, as nghttp2 references them.
+  EXPECT_CALL(response_decoder_, decodeHeaders_(_, true))
+      .WillOnce(Invoke([](HeaderMapPtr& headers, bool) -> void {
+        EXPECT_STREQ("200", headers->Status()->value().c_str());
+        EXPECT_STREQ("world", headers->get(LowerCaseString("hello"))->value().c_str());
+      }));
+  TestHeaderMapImpl response_headers{{"hello", "world"}, {":status", "200"}};
+  response_encoder_->encodeHeaders(response_headers, true);
+  EXPECT_EQ(0, nghttp2_session_want_write(server_.session()));
+}
+
+// With auto-tuning, the server's windows start at the spec initial size and grow with the
+// bandwidth-delay product, which in memory is the whole window over each round trip.
+TEST(Http2CodecImplWindowAutoTuningTest, WindowsGrow) {
+  Stats::IsolatedStoreImpl stats_store;
+  NiceMock<Network::MockConnection> client_connection;
+  MockConnectionCallbacks client_callbacks;
+  TestClientConnectionImpl client(client_connection, client_callbacks, stats_store,
+                                  Http2Settings());
+  Http2CodecImplTest::ConnectionWrapper client_wrapper;
+  Http2Settings server_settings;
+  server_settings.initial_stream_window_size_ = 1024 * 1024;
+  server_settings.window_auto_tuning_ = true;
+  NiceMock<Network::MockConnection> server_connection;
+  MockServerConnectionCallbacks server_callbacks;
+  TestServerConnectionImpl server(server_connection, server_callbacks, stats_store,
+                                  server_settings);
+  Http2CodecImplTest::ConnectionWrapper server_wrapper;
+  ON_CALL(client_connection, write(_)).WillByDefault(Invoke([&](Buffer::Instance& data) -> void {
+    server_wrapper.dispatch(data, server);
+  }));
+  ON_CALL(server_connection, write(_)).WillByDefault(Invoke([&](Buffer::Instance& data) -> void {
+    client_wrapper.dispatch(data, client);
+  }));
+
+  MockStreamDecoder response_decoder;
+  StreamEncoder& request_encoder = client.newStream(response_decoder);
+  MockStreamDecoder request_decoder;
+  EXPECT_CALL(server_callbacks, newStream(_))
+      .WillOnce(Invoke([&](StreamEncoder&) -> StreamDecoder& { return request_decoder; }));
+  TestHeaderMapImpl request_headers;
+  HttpTestUtility::addDefaultHeaders(request_headers);
+  EXPECT_CALL(request_decoder, decodeHeaders_(_, false));
+  request_encoder.encodeHeaders(request_headers, false);
+  EXPECT_EQ(static_cast<uint32_t>(NGHTTP2_INITIAL_WINDOW_SIZE),
+            nghttp2_session_get_remote_settings(client.session(),
+                                                NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE));
+
+  EXPECT_CALL(request_decoder, decodeData(_, _)).Times(AtLeast(1));
+  Buffer::OwnedImpl body(std::string(4 * 1024 * 1024, 'a'));
+  request_encoder.encodeData(body, true);
+  EXPECT_LT(0U, stats_store.counter("http2.window_size_increased").value());
+  const uint32_t stream_window_size = nghttp2_session_get_remote_settings(
+      client.session(), NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE);
+  EXPECT_LT(static_cast<uint32_t>(NGHTTP2_INITIAL_WINDOW_SIZE), stream_window_size);
+  EXPECT_GE(1024U * 1024U, stream_window_size);
+}
+
 class Http2CodecImplDeferredResetTest : public Http2CodecImplTest {};
 
 TEST_P(Http2CodecImplDeferredResetTest, DeferredResetClient) {
@@ -354,6 +354,55 @@ TEST_F(Http2ConnPoolImplTest, DrainPrimaryNoActiveRequest) {
   dispatcher_.clearDeferredDeleteList();
 }
 
+/**
+ * Verify that streams are spread over several connections, going to the least loaded one.
+ */
+TEST_F(Http2ConnPoolImplTest, MultipleConnections) {
+  InSequence s;
+  cluster_->http2_connections_per_host_ = 2;
+
+  expectClientCreate();
+  ActiveTestRequest r1(*this, 0);
+  EXPECT_CALL(r1.inner_encoder_, encodeHeaders(_, true));
+  r1.callbacks_.outer_encoder_->encodeHeaders(HeaderMapImpl{}, true);
+  expectClientConnect(0);
+
+  // The first connection is busy, so a second one is opened.
+  expectClientCreate();
+  ActiveTestRequest r2(*this, 1);
+  EXPECT_CALL(r2.inner_encoder_, encodeHeaders(_, true));
+  r2.callbacks_.outer_encoder_->encodeHeaders(HeaderMapImpl{}, true);
+  expectClientConnect(1);
+
+  EXPECT_CALL(r1.decoder_, decodeHeaders_(_, true));
+  r1.inner_decoder_->decodeHeaders(HeaderMapPtr{new HeaderMapImpl{}}, true);
+
+  // The first connection now has the fewest streams.
+  ActiveTestRequest r3(*this, 0);
+  EXPECT_CALL(r3.inner_encoder_, encodeHeaders(_, true));
+  r3.callbacks_.outer_encoder_->encodeHeaders(HeaderMapImpl{}, true);
+
+  // Both connections are busy, but no more than two are opened.
+  ActiveTestRequest r4(*this, 1);
+  EXPECT_CALL(r4.inner_encoder_, encodeHeaders(_, true));
+  r4.callbacks_.outer_encoder_->encodeHeaders(HeaderMapImpl{}, true);
+
+  EXPECT_CALL(r2.decoder_, decodeHeaders_(_, true));
+  r2.inner_decoder_->decodeHeaders(HeaderMapPtr{new HeaderMapImpl{}}, true);
+  EXPECT_CALL(r3.decoder_, decodeHeaders_(_, true));
+  r3.inner_decoder_->decodeHeaders(HeaderMapPtr{new HeaderMapImpl{}}, true);
+  EXPECT_CALL(r4.decoder_, decodeHeaders_(_, true));
+  r4.inner_decoder_->decodeHeaders(HeaderMapPtr{new HeaderMapImpl{}}, true);
+
+  EXPECT_EQ(2U, cluster_->stats_.upstream_cx_total_.value());
+  EXPECT_EQ(4U, cluster_->stats_.upstream_rq_total_.value());
+
+  test_clients_[1].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  EXPECT_CALL(*this, onClientDestroy()).Times(2);
+  dispatcher_.clearDeferredDeleteList();
+}
+
 TEST_F(Http2ConnPoolImplTest, ConnectTimeout) {
   InSequence s;
 
@@ -1,9 +1,11 @@
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "common/config/protocol_json.h"
 #include "common/http/exception.h"
 #include "common/http/header_map_impl.h"
+#include "common/http/headers.h"
 #include "common/http/utility.h"
 #include "common/network/address_impl.h"
 
@@ -77,6 +79,18 @@ TEST(HttpUtility, isWebSocketUpgradeRequest) {
       TestHeaderMapImpl{{"connection", "Upgrade"}, {"upgrade", "WebSocket"}}));
 }
 
+TEST(HttpUtility, isIdempotentRequest) {
+  EXPECT_FALSE(Utility::isIdempotentRequest(TestHeaderMapImpl{}));
+  EXPECT_FALSE(Utility::isIdempotentRequest(TestHeaderMapImpl{{":method", "POST"}}));
+  EXPECT_FALSE(Utility::isIdempotentRequest(TestHeaderMapImpl{{":method", "PATCH"}}));
+  EXPECT_FALSE(Utility::isIdempotentRequest(TestHeaderMapImpl{{":method", "get"}}));
+
+  EXPECT_TRUE(Utility::isIdempotentRequest(TestHeaderMapImpl{{":method", "GET"}}));
+  EXPECT_TRUE(Utility::isIdempotentRequest(TestHeaderMapImpl{{":method", "HEAD"}}));
+  EXPECT_TRUE(Utility::isIdempotentRequest(TestHeaderMapImpl{{":method", "PUT"}}));
+  EXPECT_TRUE(Utility::isIdempotentRequest(TestHeaderMapImpl{{":method", "DELETE"}}));
+}
+
 TEST(HttpUtility, appendXff) {
   {
     TestHeaderMapImpl headers;
@@ -167,6 +181,14 @@ TEST(HttpUtility, EmptyXFF) {
   }
 }
 
+TEST(HttpUtility, EmptyAddressesInXFF) {
+  TestHeaderMapImpl request_headers{{"x-forwarded-for", "34.0.0.1, 10.0.0.1, , "}};
+  EXPECT_EQ("10.0.0.1", Utility::getLastAddressFromXFF(request_headers));
+
+  TestHeaderMapImpl separators_only{{"x-forwarded-for", ", , "}};
+  EXPECT_EQ("", Utility::getLastAddressFromXFF(separators_only));
+}
+
 TEST(HttpUtility, OneAddressInXFF) {
   const std::string first_address = "34.0.0.1";
   TestHeaderMapImpl request_headers{{"x-forwarded-for", first_address}};
@@ -231,6 +253,17 @@ TEST(HttpUtility, TestHasSetCookieBadValues) {
   EXPECT_TRUE(Utility::hasSetCookie(headers, "key2"));
 }
 
+TEST(HttpUtility, ForEachHeaderElement) {
+  TestHeaderMapImpl headers{{"accept-encoding", " gzip;q=0.5 ,, deflate"},
+                            {"other", "br"},
+                            {"accept-encoding", "\tidentity\t"}};
+
+  std::vector<std::string> elements;
+  Utility::forEachHeaderElement(headers, Headers::get().AcceptEncoding,
+                                [&](const std::string& element) { elements.push_back(element); });
+  EXPECT_EQ((std::vector<std::string>{"gzip;q=0.5", "deflate", "identity"}), elements);
+}
+
 TEST(HttpUtility, SendLocalReply) {
   MockStreamDecoderFilterCallbacks callbacks;
   bool is_reset = false;
@@ -1,6 +1,7 @@
 #include <string>
 #include <vector>
 
+#include "common/buffer/buffer_impl.h"
 #include "common/json/json_loader.h"
 
 #include "test/test_common/utility.h"
@@ -199,6 +200,37 @@ TEST(JsonLoaderTest, Basic) {
   }
 }
 
+// A document split over several slices is parsed as the same document in a string, and its
+// errors have the same offset and line.
+TEST(JsonLoaderTest, LoadFromBuffer) {
+  {
+    Buffer::OwnedImpl json("{\"hello\": \"wo");
+    Buffer::OwnedImpl rest("rld\",\n \"count\": 3}");
+    json.move(rest);
+    ObjectSharedPtr object = Factory::loadFromBuffer(json);
+    EXPECT_EQ("world", object->getString("hello"));
+    EXPECT_EQ(3, object->getInteger("count"));
+  }
+
+  {
+    const std::string invalid = "{\"a\": 1,\n\"b\": 2\n\"c\": 3}";
+    std::string expected;
+    try {
+      Factory::loadFromString(invalid);
+    } catch (const Exception& e) {
+      expected = e.what();
+    }
+    EXPECT_NE("", expected);
+
+    Buffer::OwnedImpl json(invalid.substr(0, 12));
+    Buffer::OwnedImpl rest(invalid.substr(12));
+    json.move(rest);
+    EXPECT_THROW_WITH_MESSAGE(Factory::loadFromBuffer(json), Exception, expected);
+  }
+
+  EXPECT_THROW(Factory::loadFromBuffer(Buffer::OwnedImpl()), Exception);
+}
+
 TEST(JsonLoaderTest, Integer) {
   {
     ObjectSharedPtr json =
@@ -306,6 +338,46 @@ TEST(JsonLoaderTest, Schema) {
   }
 }
 
+TEST(JsonLoaderTest, SchemaReuse) {
+  std::string schema = R"EOF(
+  {
+    "properties": {
+      "value1": {
+        "type": "array",
+        "items": {
+          "type": "object",
+          "properties": {
+            "value2": {"type": "integer", "minimum": 0}
+          },
+          "required": ["value2"]
+        }
+      },
+      "value3": {"type": ["null", "boolean"]}
+    },
+    "additionalProperties": false
+  }
+  )EOF";
+
+  // The schema is compiled once and then shared by every validation.
+  for (int i = 0; i < 2; i++) {
+    EXPECT_NO_THROW(Factory::loadFromString(R"EOF({"value1": [{"value2": 1}], "value3": null})EOF")
+                        ->validateSchema(schema));
+    EXPECT_NO_THROW(Factory::loadFromString(R"EOF({"value1": [], "value3": true})EOF")
+                        ->validateSchema(schema));
+    EXPECT_THROW_WITH_MESSAGE(
+        Factory::loadFromString(R"EOF({"value1": [{"value2": 1}, {"value2": -1}]})EOF")
+            ->validateSchema(schema),
+        Exception,
+        "JSON at lines 1-1 does not conform to schema.\n Invalid schema: "
+        "#/properties/value1/items/properties/value2\n Schema violation: minimum\n Offending "
+        "document key: #/value1/1/value2");
+    EXPECT_THROW(Factory::loadFromString(R"EOF({"value1": [{}]})EOF")->validateSchema(schema),
+                 Exception);
+    EXPECT_THROW(Factory::loadFromString(R"EOF({"value3": 1.5})EOF")->validateSchema(schema),
+                 Exception);
+  }
+}
+
 TEST(JsonLoaderTest, NestedSchema) {
 
   std::string schema = R"EOF(
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <string>
+
+#include "common/json/streaming_parser.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Json {
+
+/**
+ * Records the events of the parser as a compact string.
+ */
+class TestCallbacks : public StreamingParser::Callbacks {
+public:
+  void onStartObject() override { events_ += "{"; }
+  void onEndObject() override { events_ += "}"; }
+  void onStartArray() override { events_ += "["; }
+  void onEndArray() override { events_ += "]"; }
+  void onKey(const std::string& key) override { events_ += "k:" + key + " "; }
+  bool captureString() override { return capture_; }
+  void onString(const std::string& value) override { events_ += "s:" + value + " "; }
+  void onNumber(double value) override { events_ += "n:" + std::to_string(value) + " "; }
+  void onBool(bool value) override { events_ += value ? "true " : "false "; }
+  void onNull() override { events_ += "null "; }
+
+  bool capture_{true};
+  std::string events_;
+};
+
+class StreamingParserTest : public testing::Test {
+public:
+  // Parse the document in chunks of the given size.
+  bool parse(const std::string& json, size_t chunk_size) {
+    callbacks_.events_.clear();
+    StreamingParser parser(callbacks_);
+    for (size_t i = 0; i < json.size(); i += chunk_size) {
+      if (!parser.parse(json.data() + i, std::min(chunk_size, json.size() - i))) {
+        return false;
+      }
+    }
+    return parser.finish();
+  }
+
+  // Expect the same events whatever the chunk size.
+  void expectEvents(const std::string& json, const std::string& events) {
+    for (size_t chunk_size = 1; chunk_size <= json.size(); chunk_size++) {
+      EXPECT_TRUE(parse(json, chunk_size)) << json << " " << chunk_size;
+      EXPECT_EQ(events, callbacks_.events_) << json << " " << chunk_size;
+    }
+  }
+
+  void expectInvalid(const std::string& json) {
+    for (size_t chunk_size = 1; chunk_size <= std::max<size_t>(json.size(), 1); chunk_size++) {
+      EXPECT_FALSE(parse(json, chunk_size)) << json << " " << chunk_size;
+    }
+  }
+
+  TestCallbacks callbacks_;
+};
+
+TEST_F(StreamingParserTest, Values) {
+  expectEvents("{}", "{}");
+  expectEvents("[]", "[]");
+  expectEvents(" 12 ", "n:12.000000 ");
+  expectEvents("-0.5e1", "n:-5.000000 ");
+  expectEvents("\"hello\"", "s:hello ");
+  expectEvents("true", "true ");
+  expectEvents("false", "false ");
+  expectEvents("null", "null ");
+  expectEvents("{\"a\": [1, {\"b\": null}, [], \"c\"], \"d\": {}}",
+               "{k:a [n:1.000000 {k:b null }[]s:c ]k:d {}}");
+}
+
+TEST_F(StreamingParserTest, Escapes) {
+  expectEvents(R"EOF("\"\\\/\b\f\n\r\t")EOF", "s:\"\\/\b\f\n\r\t ");
+  expectEvents(R"EOF({"\u0041\u00e9\u20AC\ud83d\ude00": 1})EOF",
+               "{k:A\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80 n:1.000000 }");
+}
+
+TEST_F(StreamingParserTest, NotCaptured) {
+  callbacks_.capture_ = false;
+  // Keys are always captured.
+  expectEvents(R"EOF({"key": "value \u0041"})EOF", "{k:key s: }");
+}
+
+TEST_F(StreamingParserTest, Invalid) {
+  expectInvalid("");
+  expectInvalid(" ");
+  expectInvalid("{");
+  expectInvalid("{\"a\"}");
+  expectInvalid("{\"a\":}");
+  expectInvalid("{\"a\":1,}");
+  expectInvalid("{1:1}");
+  expectInvalid("[1,]");
+  expectInvalid("[1}");
+  expectInvalid("{}}");
+  expectInvalid("{} {}");
+  expectInvalid("tru");
+  expectInvalid("nul1");
+  expectInvalid("01");
+  expectInvalid("-");
+  expectInvalid("1.");
+  expectInvalid("1e");
+  expectInvalid("1e+");
+  expectInvalid("\"abc");
+  expectInvalid("\"\x01\"");
+  expectInvalid("\"\\x\"");
+  expectInvalid("\"\\u12g4\"");
+  expectInvalid("\"\\ud83d\"");
+  expectInvalid("\"\\ud83d\\n\"");
+  expectInvalid("\"\\ude00\"");
+}
+
+TEST_F(StreamingParserTest, FailsAfterError) {
+  StreamingParser parser(callbacks_);
+  EXPECT_TRUE(parser.parse("[1", 2));
+  EXPECT_FALSE(parser.parse("]]", 2));
+  EXPECT_FALSE(parser.parse("", 0));
+  EXPECT_FALSE(parser.finish());
+  EXPECT_EQ("[n:1.000000 ]", callbacks_.events_);
+}
+
+} // namespace Json
+} // namespace Envoy
@@ -149,5 +149,73 @@ TEST_F(LuaTest, MarkDead) {
   lua_gc(cr1->luaState(), LUA_GCCOLLECT, 0);
 }
 
+// Threads of coroutines which finished are reused, others are not.
+TEST_F(LuaTest, CoroutineReuse) {
+  const std::string SCRIPT{R"EOF(
+    function callMe()
+    end
+
+    function yieldMe()
+      coroutine.yield()
+    end
+
+    function failMe()
+      error("failed")
+    end
+  )EOF"};
+
+  setup(SCRIPT);
+  const uint64_t call_me = state_->registerGlobal("callMe");
+  const uint64_t yield_me = state_->registerGlobal("yieldMe");
+  const uint64_t fail_me = state_->registerGlobal("failMe");
+
+  CoroutinePtr cr(state_->createCoroutine());
+  lua_State* finished_thread = cr->luaState();
+  cr->start(state_->getGlobalRef(call_me), 0, yield_callback_);
+  EXPECT_EQ(cr->state(), Coroutine::State::Finished);
+  cr.reset();
+
+  cr = state_->createCoroutine();
+  EXPECT_EQ(finished_thread, cr->luaState());
+  EXPECT_CALL(on_yield_, ready());
+  cr->start(state_->getGlobalRef(yield_me), 0, yield_callback_);
+  EXPECT_EQ(cr->state(), Coroutine::State::Yielded);
+  cr.reset();
+
+  cr = state_->createCoroutine();
+  EXPECT_NE(finished_thread, cr->luaState());
+  lua_State* failed_thread = cr->luaState();
+  EXPECT_THROW_WITH_MESSAGE(cr->start(state_->getGlobalRef(fail_me), 0, yield_callback_),
+                            LuaException, "[string \"...\"]:10: failed");
+  EXPECT_EQ(cr->state(), Coroutine::State::Finished);
+  cr.reset();
+
+  cr = state_->createCoroutine();
+  EXPECT_NE(failed_thread, cr->luaState());
+  cr->start(state_->getGlobalRef(call_me), 0, yield_callback_);
+  EXPECT_EQ(cr->state(), Coroutine::State::Finished);
+}
+
+// Only objects of the expected type are accepted as "this".
+TEST_F(LuaTest, CheckUserdata) {
+  const std::string SCRIPT{R"EOF(
+    function callMe(object)
+      object.testCall({})
+    end
+  )EOF"};
+
+  setup(SCRIPT);
+  EXPECT_NE(LUA_REFNIL, state_->getGlobalRef(state_->registerGlobal("callMe")));
+
+  CoroutinePtr cr(state_->createCoroutine());
+  TestObject::create(cr->luaState());
+  try {
+    cr->start(state_->getGlobalRef(0), 1, yield_callback_);
+    FAIL();
+  } catch (const LuaException& e) {
+    EXPECT_THAT(e.what(), testing::HasSubstr(" expected, got table"));
+  }
+}
+
 } // namespace Lua
 } // namespace Envoy
@@ -1,9 +1,11 @@
+#include <memory>
 #include <string>
 
 #include "common/buffer/buffer_impl.h"
 #include "common/mongo/bson_impl.h"
 
 #include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
 
 #include "gtest/gtest.h"
 
@@ -48,6 +50,122 @@ TEST(BsonImplTest, InvalodDocumentTermination) {
   EXPECT_THROW(DocumentImpl::create(buffer), EnvoyException);
 }
 
+class BsonLazyDocumentTest : public testing::Test {
+public:
+  BsonLazyDocumentTest() {
+    document_ =
+        DocumentImpl::create()
+            ->addString("string", "string")
+            ->addDouble("double", 2.1)
+            ->addDocument("document", DocumentImpl::create()->addString("hello", "world"))
+            ->addArray("array", DocumentImpl::create()->addString("0", "foo"))
+            ->addBinary("binary", "binary_value")
+            ->addObjectId("object_id", Field::ObjectId())
+            ->addBoolean("true", true)
+            ->addDatetime("datetime", 1)
+            ->addNull("null")
+            ->addRegex("regex", {"hello", "i"})
+            ->addInt32("int32", 1)
+            ->addTimestamp("timestamp", 1000)
+            ->addInt64("int64", 2);
+  }
+
+  DocumentSharedPtr createLazy(const DocumentSharedPtr& document) {
+    Buffer::OwnedImpl buffer;
+    document->encode(buffer);
+    std::shared_ptr<std::string> data =
+        std::make_shared<std::string>(TestUtility::bufferToString(buffer));
+    uint64_t offset = 0;
+    DocumentSharedPtr lazy_document = DocumentImpl::createLazy(data, offset);
+    EXPECT_EQ(data->size(), offset);
+    return lazy_document;
+  }
+
+  DocumentSharedPtr document_;
+};
+
+TEST_F(BsonLazyDocumentTest, Find) {
+  DocumentSharedPtr lazy_document = createLazy(document_);
+  EXPECT_EQ(document_->byteSize(), lazy_document->byteSize());
+
+  EXPECT_EQ("string", lazy_document->find("string", Field::Type::STRING)->asString());
+  EXPECT_EQ(nullptr, lazy_document->find("string", Field::Type::DOCUMENT));
+  EXPECT_EQ(nullptr, lazy_document->find("missing"));
+  EXPECT_EQ(
+      "world",
+      lazy_document->find("document")->asDocument().find("hello", Field::Type::STRING)->asString());
+  EXPECT_EQ(2, lazy_document->find("int64")->asInt64());
+  EXPECT_EQ("i", lazy_document->find("regex")->asRegex().options_);
+
+  // Found fields stay valid once all of them are decoded.
+  const Field* field = lazy_document->find("double");
+  EXPECT_EQ(*document_, *lazy_document);
+  EXPECT_EQ(field, lazy_document->find("double"));
+  EXPECT_EQ(document_->toString(), lazy_document->toString());
+}
+
+TEST_F(BsonLazyDocumentTest, Encode) {
+  DocumentSharedPtr lazy_document = createLazy(document_);
+  Buffer::OwnedImpl expected;
+  document_->encode(expected);
+  Buffer::OwnedImpl buffer;
+  lazy_document->encode(buffer);
+  EXPECT_TRUE(TestUtility::buffersEqual(expected, buffer));
+
+  // Once modified the document is encoded from its fields.
+  document_->addInt32("added", 3);
+  lazy_document->addInt32("added", 3);
+  EXPECT_EQ(document_->byteSize(), lazy_document->byteSize());
+  expected.drain(expected.length());
+  document_->encode(expected);
+  buffer.drain(buffer.length());
+  lazy_document->encode(buffer);
+  EXPECT_TRUE(TestUtility::buffersEqual(expected, buffer));
+}
+
+TEST_F(BsonLazyDocumentTest, Invalid) {
+  std::shared_ptr<std::string> data = std::make_shared<std::string>();
+  uint64_t offset = 0;
+  EXPECT_THROW(DocumentImpl::createLazy(data, offset), EnvoyException);
+
+  // Too long.
+  Buffer::OwnedImpl buffer;
+  BufferHelper::writeInt32(buffer, 100);
+  data = std::make_shared<std::string>(TestUtility::bufferToString(buffer) + '\0');
+  EXPECT_THROW(DocumentImpl::createLazy(data, offset), EnvoyException);
+
+  // Not terminated.
+  buffer.drain(buffer.length());
+  BufferHelper::writeInt32(buffer, 5);
+  data = std::make_shared<std::string>(TestUtility::bufferToString(buffer) + '\1');
+  EXPECT_THROW(DocumentImpl::createLazy(data, offset), EnvoyException);
+
+  // Invalid fields are only found on access.
+  buffer.drain(buffer.length());
+  BufferHelper::writeInt32(buffer, 4 + 1 + 6 + 1);
+  uint8_t invalid_element_type = 0x20;
+  buffer.add(&invalid_element_type, sizeof(invalid_element_type));
+  BufferHelper::writeCString(buffer, "hello");
+  buffer.add("\0", 1);
+  data = std::make_shared<std::string>(TestUtility::bufferToString(buffer));
+  DocumentSharedPtr document = DocumentImpl::createLazy(data, offset);
+  EXPECT_THROW(document->find("hello"), EnvoyException);
+  EXPECT_THROW(document->values(), EnvoyException);
+
+  // A string which runs past the end of the document.
+  offset = 0;
+  buffer.drain(buffer.length());
+  BufferHelper::writeInt32(buffer, 4 + 1 + 6 + 4 + 1);
+  uint8_t string_type = 0x02;
+  buffer.add(&string_type, sizeof(string_type));
+  BufferHelper::writeCString(buffer, "hello");
+  BufferHelper::writeInt32(buffer, 10);
+  buffer.add("\0", 1);
+  data = std::make_shared<std::string>(TestUtility::bufferToString(buffer));
+  document = DocumentImpl::createLazy(data, offset);
+  EXPECT_THROW(document->find("hello"), EnvoyException);
+}
+
 TEST(BufferHelperTest, InvalidSize) {
   Buffer::OwnedImpl buffer;
   EXPECT_THROW(BufferHelper::peakInt32(buffer), EnvoyException);
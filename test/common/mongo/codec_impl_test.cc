@@ -156,6 +156,15 @@ TEST_F(MongoCodecImplTest, Reply) {
   decoder_.onData(output_);
 }
 
+TEST_F(MongoCodecImplTest, ReplyMissingDocuments) {
+  ReplyMessageImpl reply(2, 2);
+  reply.numberReturned(2);
+  reply.documents().push_back(Bson::DocumentImpl::create()->addString("hello", "world"));
+
+  encoder_.encodeReply(reply);
+  EXPECT_THROW(decoder_.onData(output_), EnvoyException);
+}
+
 TEST_F(MongoCodecImplTest, GetMoreEqual) {
   {
     GetMoreMessageImpl g1(0, 0);
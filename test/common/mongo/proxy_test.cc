@@ -1,5 +1,6 @@
 #include <chrono>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -14,6 +15,7 @@
 #include "test/mocks/network/mocks.h"
 #include "test/mocks/runtime/mocks.h"
 #include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
 
 #include "api/filter/fault.pb.h"
 #include "gmock/gmock.h"
@@ -71,8 +73,8 @@ public:
   }
 
   void initializeFilter() {
-    filter_.reset(new TestProxyFilter("test.", store_, runtime_, access_log_, fault_config_,
-                                      drain_decision_));
+    filter_.reset(new TestProxyFilter("test.", store_, runtime_, random_, access_log_,
+                                      fault_config_, drain_decision_));
     filter_->initializeReadFilterCallbacks(read_filter_callbacks_);
     filter_->onNewConnection();
   }
@@ -87,6 +89,7 @@ public:
     EXPECT_CALL(runtime_.snapshot_, featureEnabled(_, _)).Times(AnyNumber());
     EXPECT_CALL(runtime_.snapshot_, featureEnabled("mongo.fault.fixed_delay.percent", 50))
         .WillOnce(Return(enable_fault));
+    EXPECT_CALL(runtime_.snapshot_, getInteger(_, _)).Times(AnyNumber());
 
     if (enable_fault) {
       EXPECT_CALL(runtime_.snapshot_, getInteger("mongo.fault.fixed_delay.duration_ms", 10))
@@ -97,6 +100,7 @@ public:
   Buffer::OwnedImpl fake_data_;
   NiceMock<TestStatStore> store_;
   NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<Runtime::MockRandomGenerator> random_;
   NiceMock<Event::MockDispatcher> dispatcher_;
   std::shared_ptr<Filesystem::MockFile> file_{new NiceMock<Filesystem::MockFile>()};
   AccessLogSharedPtr access_log_;
@@ -520,5 +524,108 @@ TEST_F(MongoProxyFilterTest, ConnectionDestroyRemote) {
   EXPECT_EQ(0U, store_.counter("test.cx_destroy_local_with_active_rq").value());
 }
 
+class MongoProxyFilterPassthroughTest : public MongoProxyFilterTest {
+public:
+  MongoProxyFilterPassthroughTest() {
+    ON_CALL(runtime_.snapshot_, getInteger("mongo.decode_sample_rate", 1))
+        .WillByDefault(Return(2));
+    initializeFilter();
+  }
+
+  void encodeQuery(int32_t request_id, Buffer::Instance& output) {
+    QueryMessageImpl message(request_id, 0);
+    message.fullCollectionName("db.test");
+    message.query(Bson::DocumentImpl::create()->addString("hello", "world"));
+    EncoderImpl(output).encodeQuery(message);
+  }
+
+  void encodeReply(int32_t response_to, Buffer::Instance& output) {
+    ReplyMessageImpl message(0, response_to);
+    message.numberReturned(1);
+    message.documents().push_back(Bson::DocumentImpl::create()->addString("hello", "world"));
+    EncoderImpl(output).encodeReply(message);
+  }
+
+  // Expect one sampled message, of the given length, to be decoded.
+  void expectDecode(uint64_t length, std::function<void()> decode) {
+    EXPECT_CALL(*filter_->decoder_, onData(_))
+        .WillOnce(Invoke([length, decode](Buffer::Instance& data) -> void {
+          EXPECT_EQ(length, data.length());
+          data.drain(data.length());
+          decode();
+        }));
+  }
+};
+
+TEST_F(MongoProxyFilterPassthroughTest, SampledQueryAndReply) {
+  EXPECT_CALL(random_, random()).WillOnce(Return(1)).WillOnce(Return(2));
+  Buffer::OwnedImpl data;
+  encodeQuery(1, data);
+  encodeQuery(2, data);
+  const uint64_t length = data.length();
+
+  expectDecode(length / 2, [&]() -> void {
+    QueryMessagePtr message(new QueryMessageImpl(2, 0));
+    message->fullCollectionName("db.test");
+    message->query(Bson::DocumentImpl::create());
+    filter_->callbacks_->decodeQuery(std::move(message));
+  });
+  EXPECT_EQ(Network::FilterStatus::Continue, filter_->onData(data));
+  EXPECT_EQ(length, data.length());
+  EXPECT_EQ(2U, store_.counter("test.op_query").value());
+  EXPECT_EQ(2U, store_.counter("test.collection.test.query.total").value());
+
+  // Only the reply to the sampled query is decoded.
+  Buffer::OwnedImpl reply;
+  encodeReply(1, reply);
+  encodeReply(2, reply);
+  expectDecode(reply.length() / 2, [&]() -> void {
+    ReplyMessagePtr message(new ReplyMessageImpl(0, 2));
+    filter_->callbacks_->decodeReply(std::move(message));
+  });
+  EXPECT_EQ(Network::FilterStatus::Continue, filter_->onWrite(reply));
+  EXPECT_EQ(2U, store_.counter("test.op_reply").value());
+  EXPECT_EQ(0U, store_.gauge("test.op_query_active").value());
+}
+
+TEST_F(MongoProxyFilterPassthroughTest, MessageSplitAcrossReads) {
+  EXPECT_CALL(random_, random()).WillOnce(Return(0));
+  Buffer::OwnedImpl data;
+  encodeQuery(1, data);
+  const std::string bytes = TestUtility::bufferToString(data);
+
+  // Feed the message one byte at a time, it is only decoded once all of it has been seen.
+  EXPECT_CALL(*filter_->decoder_, onData(_)).Times(0);
+  for (uint64_t i = 0; i < bytes.size() - 1; i++) {
+    Buffer::OwnedImpl byte(&bytes[i], 1);
+    filter_->onData(byte);
+  }
+
+  testing::Mock::VerifyAndClearExpectations(filter_->decoder_);
+  expectDecode(bytes.size(), [&]() -> void {
+    QueryMessagePtr message(new QueryMessageImpl(1, 0));
+    message->fullCollectionName("db.test");
+    message->query(Bson::DocumentImpl::create());
+    filter_->callbacks_->decodeQuery(std::move(message));
+  });
+  Buffer::OwnedImpl last(&bytes.back(), 1);
+  filter_->onData(last);
+  EXPECT_EQ(2U, store_.counter("test.op_query").value());
+}
+
+TEST_F(MongoProxyFilterPassthroughTest, InvalidMessageLength) {
+  Buffer::OwnedImpl data;
+  Bson::BufferHelper::writeInt32(data, 4);
+  Bson::BufferHelper::writeInt32(data, 0);
+  Bson::BufferHelper::writeInt32(data, 0);
+  Bson::BufferHelper::writeInt32(data, 2004);
+  encodeQuery(1, data);
+
+  EXPECT_CALL(random_, random()).Times(0);
+  EXPECT_CALL(*filter_->decoder_, onData(_)).Times(0);
+  filter_->onData(data);
+  EXPECT_EQ(1U, store_.counter("test.decoding_error").value());
+}
+
 } // namespace Mongo
 } // namespace Envoy
@@ -0,0 +1,128 @@
+#include <chrono>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "common/network/address_impl.h"
+#include "common/network/caching_dns_resolver_impl.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/network/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::DoAll;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::SaveArg;
+using testing::_;
+
+namespace Envoy {
+namespace Network {
+
+class CachingDnsResolverImplTest : public testing::Test {
+public:
+  CachingDnsResolverImplTest() : resolver_(new NiceMock<MockDnsResolver>()) {}
+
+  void setup(std::chrono::milliseconds cache_duration) {
+    ON_CALL(time_source_, currentTime()).WillByDefault(Return(MonotonicTime()));
+    caching_resolver_.reset(new CachingDnsResolverImpl(resolver_, cache_duration, time_source_));
+  }
+
+  ActiveDnsQuery* resolve(const std::string& dns_name, std::list<std::string>& resolved) {
+    return caching_resolver_->resolve(
+        dns_name, DnsLookupFamily::V4Only,
+        [&resolved](std::list<Address::InstanceConstSharedPtr>&& address_list) -> void {
+          for (const Address::InstanceConstSharedPtr& address : address_list) {
+            resolved.push_back(address->asString());
+          }
+        });
+  }
+
+  std::shared_ptr<NiceMock<MockDnsResolver>> resolver_;
+  NiceMock<MockMonotonicTimeSource> time_source_;
+  std::unique_ptr<CachingDnsResolverImpl> caching_resolver_;
+  const std::list<Address::InstanceConstSharedPtr> addresses_{
+      std::make_shared<Address::Ipv4Instance>("10.0.0.1")};
+};
+
+TEST_F(CachingDnsResolverImplTest, ConcurrentResolutionsShared) {
+  setup(std::chrono::milliseconds(0));
+
+  DnsResolver::ResolveCb callback;
+  EXPECT_CALL(*resolver_, resolve("foo.com", DnsLookupFamily::V4Only, _))
+      .WillOnce(DoAll(SaveArg<2>(&callback), Return(&resolver_->active_query_)));
+  std::list<std::string> resolved1;
+  std::list<std::string> resolved2;
+  std::list<std::string> resolved3;
+  EXPECT_NE(nullptr, resolve("foo.com", resolved1));
+  EXPECT_NE(nullptr, resolve("foo.com", resolved2));
+  resolve("foo.com", resolved3)->cancel();
+
+  std::list<Address::InstanceConstSharedPtr> address_list = addresses_;
+  callback(std::move(address_list));
+  EXPECT_EQ(std::list<std::string>({"10.0.0.1:0"}), resolved1);
+  EXPECT_EQ(std::list<std::string>({"10.0.0.1:0"}), resolved2);
+  EXPECT_TRUE(resolved3.empty());
+
+  // Without a cache duration, the next resolution goes to the resolver again.
+  EXPECT_CALL(*resolver_, resolve("foo.com", DnsLookupFamily::V4Only, _))
+      .WillOnce(Return(&resolver_->active_query_));
+  EXPECT_NE(nullptr, resolve("foo.com", resolved1));
+
+  EXPECT_CALL(resolver_->active_query_, cancel());
+  caching_resolver_.reset();
+}
+
+TEST_F(CachingDnsResolverImplTest, CachedAddressesExpire) {
+  setup(std::chrono::milliseconds(5000));
+
+  DnsResolver::ResolveCb callback;
+  EXPECT_CALL(*resolver_, resolve("foo.com", DnsLookupFamily::V4Only, _))
+      .WillOnce(DoAll(SaveArg<2>(&callback), Return(&resolver_->active_query_)));
+  std::list<std::string> resolved;
+  resolve("foo.com", resolved);
+  std::list<Address::InstanceConstSharedPtr> address_list = addresses_;
+  callback(std::move(address_list));
+
+  EXPECT_CALL(time_source_, currentTime())
+      .WillOnce(Return(MonotonicTime(std::chrono::milliseconds(4999))));
+  EXPECT_EQ(nullptr, resolve("foo.com", resolved));
+  EXPECT_EQ(std::list<std::string>({"10.0.0.1:0", "10.0.0.1:0"}), resolved);
+
+  EXPECT_CALL(time_source_, currentTime())
+      .WillOnce(Return(MonotonicTime(std::chrono::milliseconds(5000))));
+  EXPECT_CALL(*resolver_, resolve("foo.com", DnsLookupFamily::V4Only, _))
+      .WillOnce(DoAll(SaveArg<2>(&callback), Return(&resolver_->active_query_)));
+  EXPECT_NE(nullptr, resolve("foo.com", resolved));
+
+  // Failed resolutions aren't cached.
+  callback({});
+  EXPECT_CALL(*resolver_, resolve("foo.com", DnsLookupFamily::V4Only, _))
+      .WillOnce(Return(&resolver_->active_query_));
+  EXPECT_NE(nullptr, resolve("foo.com", resolved));
+  EXPECT_EQ(2U, resolved.size());
+
+  EXPECT_CALL(resolver_->active_query_, cancel());
+  caching_resolver_.reset();
+}
+
+TEST_F(CachingDnsResolverImplTest, ImmediateResolution) {
+  setup(std::chrono::milliseconds(0));
+
+  EXPECT_CALL(*resolver_, resolve("localhost", DnsLookupFamily::V4Only, _))
+      .WillOnce(Invoke([this](const std::string&, DnsLookupFamily,
+                              DnsResolver::ResolveCb callback) -> ActiveDnsQuery* {
+        std::list<Address::InstanceConstSharedPtr> address_list = addresses_;
+        callback(std::move(address_list));
+        return nullptr;
+      }));
+  std::list<std::string> resolved;
+  EXPECT_EQ(nullptr, resolve("localhost", resolved));
+  EXPECT_EQ(std::list<std::string>({"10.0.0.1:0"}), resolved);
+}
+
+} // namespace Network
+} // namespace Envoy
@@ -571,6 +571,53 @@ TEST(IpListTest, MatchAnyAll) {
   EXPECT_FALSE(wl.contains(Address::PipeInstance("foo")));
 }
 
+TEST(IpListTest, Empty) {
+  IpList wl(std::vector<std::string>{});
+  EXPECT_TRUE(wl.empty());
+  EXPECT_FALSE(wl.contains(Address::Ipv4Instance("1.1.1.1")));
+  EXPECT_FALSE(IpList().contains(Address::Ipv6Instance("::1")));
+}
+
+// A list of many nested and overlapping ranges agrees with the ranges themselves, and so do its
+// copies.
+TEST(IpListTest, ManyRanges) {
+  std::vector<std::string> subnets;
+  for (uint32_t i = 0; i < 256; i++) {
+    subnets.push_back(fmt::format("10.{}.{}.0/24", i % 16, i));
+    subnets.push_back(fmt::format("2001:db8:{:x}::/{}", i * 7, 40 + i % 24));
+  }
+  subnets.push_back("10.3.0.0/16");
+  subnets.push_back("10.3.5.7/32");
+  subnets.push_back("2001:db8::/48");
+  const IpList list(subnets);
+  const IpList wl = list;
+
+  std::vector<CidrRange> ranges;
+  for (const std::string& subnet : subnets) {
+    ranges.push_back(CidrRange::create(subnet));
+  }
+  const auto in_ranges = [&ranges](const Instance& address) -> bool {
+    for (const CidrRange& range : ranges) {
+      if (range.isInRange(address)) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  for (uint32_t i = 0; i < 20; i++) {
+    for (uint32_t j = 0; j < 256; j += 3) {
+      const Address::Ipv4Instance ipv4(fmt::format("10.{}.{}.{}", i, j, (i * j) % 256));
+      EXPECT_EQ(in_ranges(ipv4), wl.contains(ipv4)) << ipv4.asString();
+      const Address::Ipv6Instance ipv6(fmt::format("2001:db8:{:x}:{:x}::1", j * 7 + i, i));
+      EXPECT_EQ(in_ranges(ipv6), wl.contains(ipv6)) << ipv6.asString();
+    }
+  }
+  EXPECT_TRUE(wl.contains(Address::Ipv4Instance("10.3.200.1")));
+  EXPECT_TRUE(wl.contains(Address::Ipv6Instance("2001:db8:0:ffff::")));
+  EXPECT_FALSE(wl.contains(Address::Ipv4Instance("10.16.0.1")));
+}
+
 } // namespace Address
 } // namespace Network
 } // namespace Envoy
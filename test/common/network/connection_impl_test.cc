@@ -1,3 +1,7 @@
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -30,6 +34,7 @@ using testing::DoAll;
 using testing::InSequence;
 using testing::Invoke;
 using testing::InvokeWithoutArgs;
+using testing::NiceMock;
 using testing::Return;
 using testing::Sequence;
 using testing::StrictMock;
@@ -201,7 +206,8 @@ TEST_P(ConnectionImplTest, CloseDuringConnectCallback) {
 
 struct MockConnectionStats {
   Connection::ConnectionStats toBufferStats() {
-    return {rx_total_, rx_current_, tx_total_, tx_current_, &bind_errors_};
+    return {rx_total_,     rx_current_,   tx_total_,    tx_current_,
+            &bind_errors_, &rx_syscalls_, &tx_syscalls_};
   }
 
   StrictMock<Stats::MockCounter> rx_total_;
@@ -209,6 +215,8 @@ struct MockConnectionStats {
   StrictMock<Stats::MockCounter> tx_total_;
   StrictMock<Stats::MockGauge> tx_current_;
   StrictMock<Stats::MockCounter> bind_errors_;
+  StrictMock<Stats::MockCounter> rx_syscalls_;
+  StrictMock<Stats::MockCounter> tx_syscalls_;
 };
 
 TEST_P(ConnectionImplTest, ConnectionStats) {
@@ -231,6 +239,9 @@ TEST_P(ConnectionImplTest, ConnectionStats) {
   EXPECT_CALL(*filter, onWrite(_)).InSequence(s1).WillOnce(Return(FilterStatus::Continue));
   EXPECT_CALL(client_callbacks_, onEvent(ConnectionEvent::Connected)).InSequence(s1);
   EXPECT_CALL(client_connection_stats.tx_total_, add(4)).InSequence(s1);
+  EXPECT_CALL(client_connection_stats.tx_syscalls_, add(1)).InSequence(s1);
+  // The client reads once, when the server closes the connection.
+  EXPECT_CALL(client_connection_stats.rx_syscalls_, add(1));
 
   read_filter_.reset(new NiceMock<MockReadFilter>());
   MockConnectionStats server_connection_stats;
@@ -246,6 +257,8 @@ TEST_P(ConnectionImplTest, ConnectionStats) {
   Sequence s2;
   EXPECT_CALL(server_connection_stats.rx_total_, add(4)).InSequence(s2);
   EXPECT_CALL(server_connection_stats.rx_current_, add(4)).InSequence(s2);
+  // One read returns the data and the next one finds the socket drained.
+  EXPECT_CALL(server_connection_stats.rx_syscalls_, add(2)).InSequence(s2);
   EXPECT_CALL(server_connection_stats.rx_current_, sub(4)).InSequence(s2);
   EXPECT_CALL(server_callbacks_, onEvent(ConnectionEvent::LocalClose)).InSequence(s2);
 
@@ -402,6 +415,55 @@ TEST_P(ConnectionImplTest, BasicWrite) {
   disconnect(true);
 }
 
+// With write coalescing, data written from separate events is flushed with a single write().
+TEST_P(ConnectionImplTest, CoalescedWrite) {
+  ConnectionImpl::coalesceWrites(true);
+  useMockBuffer();
+
+  setUpBasicConnection();
+
+  connect();
+
+  std::string data_written;
+  EXPECT_CALL(*client_write_buffer_, move(_))
+      .WillRepeatedly(DoAll(AddBufferToStringWithoutDraining(&data_written),
+                            Invoke(client_write_buffer_, &MockWatermarkBuffer::baseMove)));
+  EXPECT_CALL(*client_write_buffer_, write(_))
+      .WillOnce(Invoke(client_write_buffer_, &MockWatermarkBuffer::trackWrites));
+
+  Buffer::OwnedImpl hello("hello");
+  Buffer::OwnedImpl world(" world");
+  Event::TimerPtr hello_timer =
+      dispatcher_->createTimer([&]() -> void { client_connection_->write(hello); });
+  Event::TimerPtr world_timer =
+      dispatcher_->createTimer([&]() -> void { client_connection_->write(world); });
+  hello_timer->enableTimer(std::chrono::milliseconds(0));
+  world_timer->enableTimer(std::chrono::milliseconds(0));
+  dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+  dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+  EXPECT_EQ("hello world", data_written);
+
+  disconnect(true);
+  ConnectionImpl::coalesceWrites(false);
+}
+
+#ifdef TCP_NOTSENT_LOWAT
+TEST_P(ConnectionImplTest, TcpNotSentLowat) {
+  ConnectionImpl::tcpNotSentLowat(16384);
+  setUpBasicConnection();
+  ConnectionImpl::tcpNotSentLowat(0);
+
+  int value = 0;
+  socklen_t value_size = sizeof(value);
+  EXPECT_EQ(0, getsockopt(dynamic_cast<ConnectionImpl&>(*client_connection_).fd(), IPPROTO_TCP,
+                          TCP_NOTSENT_LOWAT, &value, &value_size));
+  EXPECT_EQ(16384, value);
+
+  EXPECT_CALL(client_callbacks_, onEvent(ConnectionEvent::LocalClose));
+  client_connection_->close(ConnectionCloseType::NoFlush);
+}
+#endif
+
 // Similar to BasicWrite, only with watermarks set.
 TEST_P(ConnectionImplTest, WriteWithWatermarks) {
   useMockBuffer();
@@ -530,6 +592,68 @@ TEST_P(ConnectionImplTest, WatermarkFuzzing) {
   disconnect(true);
 }
 
+// Data read by a splicing connection goes straight to the socket of its peer, bypassing its read
+// filters, with more data than fits in the pipe between them.
+TEST_P(ConnectionImplTest, Splice) {
+  setUpBasicConnection();
+  connect();
+
+  // Connect a second client, which the server connection splices the data it reads to.
+  ClientConnectionPtr peer = dispatcher_->createClientConnection(socket_.localAddress(), nullptr);
+  NiceMock<MockConnectionCallbacks> peer_callbacks;
+  peer->addConnectionCallbacks(peer_callbacks);
+  ConnectionPtr peer_server;
+  std::shared_ptr<MockReadFilter> peer_read_filter(new NiceMock<MockReadFilter>());
+  int expected_callbacks = 2;
+  EXPECT_CALL(listener_callbacks_, onNewConnection_(_))
+      .WillOnce(Invoke([&](Network::ConnectionPtr& conn) -> void {
+        peer_server = std::move(conn);
+        peer_server->addReadFilter(peer_read_filter);
+        if (--expected_callbacks == 0) {
+          dispatcher_->exit();
+        }
+      }));
+  EXPECT_CALL(peer_callbacks, onEvent(ConnectionEvent::Connected))
+      .WillOnce(InvokeWithoutArgs([&]() -> void {
+        if (--expected_callbacks == 0) {
+          dispatcher_->exit();
+        }
+      }));
+  peer->connect();
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+
+  uint64_t bytes_spliced = 0;
+  const bool spliced = server_connection_->spliceTo(
+      *peer, [&](uint64_t bytes) -> void { bytes_spliced += bytes; });
+  EXPECT_EQ(SplicePipe::create() != nullptr, spliced);
+  if (spliced) {
+    EXPECT_FALSE(server_connection_->spliceTo(*peer, [](uint64_t) -> void {}));
+    EXPECT_FALSE(peer->spliceTo(*peer, [](uint64_t) -> void {}));
+
+    const std::string data(1024 * 1024, 'a');
+    std::string received;
+    EXPECT_CALL(*read_filter_, onData(_)).Times(0);
+    EXPECT_CALL(*peer_read_filter, onData(_))
+        .WillRepeatedly(Invoke([&](Buffer::Instance& buffer) -> FilterStatus {
+          received += TestUtility::bufferToString(buffer);
+          buffer.drain(buffer.length());
+          if (received.size() == data.size()) {
+            dispatcher_->exit();
+          }
+          return FilterStatus::StopIteration;
+        }));
+    Buffer::OwnedImpl buffer(data);
+    client_connection_->write(buffer);
+    dispatcher_->run(Event::Dispatcher::RunType::Block);
+    EXPECT_EQ(data, received);
+    EXPECT_EQ(data.size(), bytes_spliced);
+  }
+
+  peer->close(ConnectionCloseType::NoFlush);
+  peer_server->close(ConnectionCloseType::NoFlush);
+  disconnect(true);
+}
+
 TEST_P(ConnectionImplTest, BindTest) {
   std::string address_string = TestUtility::getIpv4Loopback();
   if (GetParam() == Network::Address::IpVersion::v4) {
@@ -547,6 +671,25 @@ TEST_P(ConnectionImplTest, BindTest) {
   disconnect(true);
 }
 
+// Validate that a connection continues with its fallback address as soon as connecting to its
+// remote address fails, without waiting for the fallback delay.
+TEST_P(ConnectionImplTest, FallbackOnConnectError) {
+  setUpBasicConnection();
+  EXPECT_CALL(client_callbacks_, onEvent(ConnectionEvent::LocalClose));
+  client_connection_->close(ConnectionCloseType::NoFlush);
+
+  client_connection_ = dispatcher_->createClientConnection(
+      Utility::resolveUrl(
+          fmt::format("tcp://{}:1", Network::Test::getLoopbackAddressUrlString(GetParam()))),
+      source_address_);
+  client_connection_->addConnectionCallbacks(client_callbacks_);
+  client_connection_->setFallbackAddress(socket_.localAddress(), std::chrono::milliseconds(10000));
+  connect();
+  EXPECT_EQ(socket_.localAddress()->asString(), client_connection_->remoteAddress().asString());
+
+  disconnect(true);
+}
+
 TEST_P(ConnectionImplTest, BindFailureTest) {
   // Swap the constraints from BindTest to create an address family mismatch.
   if (GetParam() == Network::Address::IpVersion::v6) {
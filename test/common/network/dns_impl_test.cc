@@ -198,6 +198,11 @@ private:
 
 class TestDnsServer : public ListenerCallbacks {
 public:
+  bool onAccept(int, Address::InstanceConstSharedPtr, Address::InstanceConstSharedPtr,
+                bool) override {
+    return false;
+  }
+
   void onNewConnection(ConnectionPtr&& new_connection) override {
     TestDnsServerQuery* query =
         new TestDnsServerQuery(std::move(new_connection), hosts_A_, hosts_AAAA_);
@@ -539,6 +544,34 @@ TEST_P(DnsImplTest, MultiARecordLookupWithV6) {
   EXPECT_TRUE(hasAddress(address_list, "1::2"));
   EXPECT_TRUE(hasAddress(address_list, "1::2:3"));
   EXPECT_TRUE(hasAddress(address_list, "1::2:3:4"));
+
+  EXPECT_NE(nullptr,
+            resolver_->resolve("some.good.domain", DnsLookupFamily::All,
+                               [&](std::list<Address::InstanceConstSharedPtr>&& results) -> void {
+                                 address_list = results;
+                                 dispatcher_.exit();
+                               }));
+
+  dispatcher_.run(Event::Dispatcher::RunType::Block);
+  ASSERT_EQ(6U, address_list.size());
+  EXPECT_EQ("1::2", address_list.front()->ip()->addressAsString());
+  EXPECT_EQ("6.5.4.3", address_list.back()->ip()->addressAsString());
+}
+
+// Validate that All returns the addresses of either IP version when the other has none.
+TEST_P(DnsImplTest, DnsIpAddressVersionAll) {
+  std::list<Address::InstanceConstSharedPtr> address_list;
+  server_->addHosts("some.good.domain", {"1.2.3.4"}, A);
+  EXPECT_NE(nullptr,
+            resolver_->resolve("some.good.domain", DnsLookupFamily::All,
+                               [&](std::list<Address::InstanceConstSharedPtr>&& results) -> void {
+                                 address_list = results;
+                                 dispatcher_.exit();
+                               }));
+
+  dispatcher_.run(Event::Dispatcher::RunType::Block);
+  ASSERT_EQ(1U, address_list.size());
+  EXPECT_TRUE(hasAddress(address_list, "1.2.3.4"));
 }
 
 // Validate working of cancellation provided by ActiveDnsQuery return.
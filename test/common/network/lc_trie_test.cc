@@ -0,0 +1,137 @@
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/network/address_impl.h"
+#include "common/network/cidr_range.h"
+#include "common/network/lc_trie.h"
+
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Network {
+
+class LcTrieTest : public testing::Test {
+public:
+  void setup(const std::vector<std::pair<std::string, std::vector<std::string>>>& tag_data) {
+    std::vector<std::pair<std::string, std::vector<Address::CidrRange>>> ranges;
+    for (const auto& tag : tag_data) {
+      std::vector<Address::CidrRange> tag_ranges;
+      for (const std::string& range : tag.second) {
+        tag_ranges.push_back(Address::CidrRange::create(range));
+      }
+      ranges.emplace_back(tag.first, std::move(tag_ranges));
+    }
+    trie_.reset(new LcTrie(ranges));
+  }
+
+  const std::vector<std::string>& tags(const std::string& address) {
+    return trie_->getTags(address);
+  }
+
+  const std::vector<std::string> no_tags_;
+  LcTriePtr trie_;
+};
+
+TEST_F(LcTrieTest, Empty) {
+  setup({});
+  EXPECT_EQ(no_tags_, tags("1.2.3.4"));
+  EXPECT_EQ(no_tags_, tags("::1"));
+}
+
+TEST_F(LcTrieTest, Ipv4) {
+  setup({{"tag_1", {"10.0.0.0/8", "192.168.1.0/24"}}, {"tag_2", {"172.16.0.1/32"}}});
+
+  EXPECT_EQ(std::vector<std::string>{"tag_1"}, tags("10.0.0.0"));
+  EXPECT_EQ(std::vector<std::string>{"tag_1"}, tags("10.255.255.255"));
+  EXPECT_EQ(std::vector<std::string>{"tag_1"}, tags("192.168.1.37"));
+  EXPECT_EQ(std::vector<std::string>{"tag_2"}, tags("172.16.0.1"));
+  EXPECT_EQ(no_tags_, tags("11.0.0.0"));
+  EXPECT_EQ(no_tags_, tags("192.168.2.1"));
+  EXPECT_EQ(no_tags_, tags("172.16.0.2"));
+  EXPECT_EQ(no_tags_, tags("::ffff:10.0.0.1"));
+}
+
+TEST_F(LcTrieTest, Ipv6) {
+  setup({{"tag_1", {"2001:db8::/32"}}, {"tag_2", {"::1/128", "fe80::/10"}}});
+
+  EXPECT_EQ(std::vector<std::string>{"tag_1"}, tags("2001:db8::1"));
+  EXPECT_EQ(std::vector<std::string>{"tag_1"}, tags("2001:db8:ffff:ffff:ffff:ffff:ffff:ffff"));
+  EXPECT_EQ(std::vector<std::string>{"tag_2"}, tags("::1"));
+  EXPECT_EQ(std::vector<std::string>{"tag_2"}, tags("febf::1"));
+  EXPECT_EQ(no_tags_, tags("2001:db9::1"));
+  EXPECT_EQ(no_tags_, tags("::2"));
+  EXPECT_EQ(no_tags_, tags("10.0.0.1"));
+}
+
+TEST_F(LcTrieTest, NestedRanges) {
+  setup({{"all", {"0.0.0.0/0", "::/0"}},
+         {"private", {"10.0.0.0/8"}},
+         {"subnet", {"10.1.0.0/16"}},
+         {"host", {"10.1.2.3/32"}}});
+
+  EXPECT_EQ((std::vector<std::string>{"all", "private", "subnet", "host"}), tags("10.1.2.3"));
+  EXPECT_EQ((std::vector<std::string>{"all", "private", "subnet"}), tags("10.1.2.4"));
+  EXPECT_EQ((std::vector<std::string>{"all", "private"}), tags("10.2.0.0"));
+  EXPECT_EQ(std::vector<std::string>{"all"}, tags("11.0.0.0"));
+  EXPECT_EQ(std::vector<std::string>{"all"}, tags("2001:db8::1"));
+}
+
+TEST_F(LcTrieTest, SharedTags) {
+  // A tag which is supplied more than once applies to the ranges of all of its entries.
+  setup({{"tag_1", {"1.2.3.0/24"}}, {"tag_2", {"1.2.0.0/16"}}, {"tag_1", {"5.6.7.8/32"}}});
+
+  EXPECT_EQ((std::vector<std::string>{"tag_1", "tag_2"}), tags("1.2.3.4"));
+  EXPECT_EQ(std::vector<std::string>{"tag_2"}, tags("1.2.4.4"));
+  EXPECT_EQ(std::vector<std::string>{"tag_1"}, tags("5.6.7.8"));
+}
+
+TEST_F(LcTrieTest, DuplicateRanges) {
+  setup({{"tag_1", {"1.2.3.0/24", "1.2.3.0/24"}}, {"tag_2", {"1.2.3.0/24"}}});
+  EXPECT_EQ((std::vector<std::string>{"tag_1", "tag_2"}), tags("1.2.3.4"));
+}
+
+TEST_F(LcTrieTest, InvalidAddresses) {
+  setup({{"all", {"0.0.0.0/0", "::/0"}}});
+
+  EXPECT_EQ(no_tags_, tags(""));
+  EXPECT_EQ(no_tags_, tags("foo"));
+  EXPECT_EQ(no_tags_, tags("1.2.3.4:80"));
+  EXPECT_EQ(no_tags_, trie_->getTags(Address::PipeInstance("/foo")));
+}
+
+TEST_F(LcTrieTest, AddressInstance) {
+  setup({{"tag_1", {"1.2.3.0/24"}}, {"tag_2", {"2001:db8::/32"}}});
+
+  EXPECT_EQ(std::vector<std::string>{"tag_1"}, trie_->getTags(Address::Ipv4Instance("1.2.3.4")));
+  EXPECT_EQ(no_tags_, trie_->getTags(Address::Ipv4Instance("1.2.4.4")));
+  EXPECT_EQ(std::vector<std::string>{"tag_2"},
+            trie_->getTags(Address::Ipv6Instance("2001:db8::1")));
+  EXPECT_EQ(no_tags_, trie_->getTags(Address::Ipv6Instance("2001:db9::1")));
+}
+
+TEST_F(LcTrieTest, ManyRanges) {
+  // Every other /24 of 10.0.0.0/16, and a /16 over half of them.
+  std::vector<std::string> even;
+  for (uint32_t i = 0; i < 256; i += 2) {
+    even.push_back(fmt::format("10.0.{}.0/24", i));
+  }
+  setup({{"even", even}, {"upper", {"10.0.128.0/17"}}});
+
+  for (uint32_t i = 0; i < 256; i++) {
+    std::vector<std::string> expected;
+    if (i % 2 == 0) {
+      expected.push_back("even");
+    }
+    if (i >= 128) {
+      expected.push_back("upper");
+    }
+    EXPECT_EQ(expected, tags(fmt::format("10.0.{}.1", i)));
+  }
+  EXPECT_EQ(no_tags_, tags("10.1.0.1"));
+  EXPECT_EQ(no_tags_, tags("9.255.255.255"));
+}
+
+} // namespace Network
+} // namespace Envoy
@@ -59,5 +59,18 @@ TEST_P(ListenSocketImplTest, BindPortZero) {
   EXPECT_GT(socket.localAddress()->ip()->port(), 0U);
 }
 
+// Sockets with SO_REUSEPORT set can all bind to the same address, and all listen on it.
+TEST_P(ListenSocketImplTest, ReusePort) {
+  auto loopback = Network::Test::getCanonicalLoopbackAddress(version_);
+  TcpListenSocket socket1(loopback, true, true);
+  TcpListenSocket socket2(socket1.localAddress(), true, true);
+  EXPECT_EQ(socket1.localAddress()->asString(), socket2.localAddress()->asString());
+  EXPECT_EQ(0, listen(socket1.fd(), 0));
+  EXPECT_EQ(0, listen(socket2.fd(), 0));
+
+  // A socket without SO_REUSEPORT can't join them.
+  EXPECT_THROW(TcpListenSocket socket3(socket1.localAddress(), true), EnvoyException);
+}
+
 } // namespace Network
 } // namespace Envoy
@@ -74,6 +74,10 @@ public:
             ));
   }
 
+  Address::InstanceConstSharedPtr listenerGetLocalAddress(int fd) {
+    return ListenerImpl::getLocalAddress(fd);
+  }
+
   MOCK_METHOD1(getLocalAddress, Address::InstanceConstSharedPtr(int fd));
   MOCK_METHOD1(getOriginalDst, Address::InstanceConstSharedPtr(int fd));
   MOCK_METHOD4(newConnection,
@@ -251,6 +255,50 @@ TEST_P(ListenerImplTest, WildcardListenerNoOriginalDst) {
   dispatcher.run(Event::Dispatcher::RunType::Block);
 }
 
+// Connections accepted on the same local address by a wildcard listener share its address.
+TEST_P(ListenerImplTest, WildcardListenerSharesLocalAddress) {
+  Stats::IsolatedStoreImpl stats_store;
+  Event::DispatcherImpl dispatcher;
+  Network::TcpListenSocket socket(Network::Test::getAnyAddress(version_), true);
+  Network::MockListenerCallbacks listener_callbacks;
+  Network::MockConnectionHandler connection_handler;
+  Network::TestListenerImpl listener(connection_handler, dispatcher, socket, listener_callbacks,
+                                     stats_store, Network::ListenerOptions());
+
+  auto local_dst_address = Network::Utility::getAddressWithPort(
+      *Network::Test::getCanonicalLoopbackAddress(version_), socket.localAddress()->ip()->port());
+  std::vector<Network::ClientConnectionPtr> client_connections;
+  for (int i = 0; i < 2; i++) {
+    client_connections.emplace_back(dispatcher.createClientConnection(
+        local_dst_address, Network::Address::InstanceConstSharedPtr()));
+    client_connections.back()->connect();
+  }
+
+  EXPECT_CALL(listener, getLocalAddress(_))
+      .Times(2)
+      .WillRepeatedly(Invoke(&listener, &TestListenerImpl::listenerGetLocalAddress));
+  EXPECT_CALL(listener, newConnection(_, _, _, _)).Times(2);
+  std::vector<Network::ConnectionPtr> server_connections;
+  EXPECT_CALL(listener_callbacks, onNewConnection_(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](Network::ConnectionPtr& conn) -> void {
+        EXPECT_EQ(conn->localAddress(), *local_dst_address);
+        server_connections.emplace_back(std::move(conn));
+        if (server_connections.size() == 2) {
+          dispatcher.exit();
+        }
+      }));
+
+  dispatcher.run(Event::Dispatcher::RunType::Block);
+  EXPECT_EQ(&server_connections[0]->localAddress(), &server_connections[1]->localAddress());
+  for (auto& connection : client_connections) {
+    connection->close(ConnectionCloseType::NoFlush);
+  }
+  for (auto& connection : server_connections) {
+    connection->close(ConnectionCloseType::NoFlush);
+  }
+}
+
 TEST_P(ListenerImplTest, UseActualDst) {
   Stats::IsolatedStoreImpl stats_store;
   Event::DispatcherImpl dispatcher;
@@ -327,5 +375,48 @@ TEST_P(ListenerImplTest, WildcardListenerUseActualDst) {
   dispatcher.run(Event::Dispatcher::RunType::Block);
 }
 
+// Connections are accepted one at a time per wakeup, and at most two per second, all of them being
+// eventually accepted.
+TEST_P(ListenerImplTest, BoundedAccepts) {
+  Stats::IsolatedStoreImpl stats_store;
+  Event::DispatcherImpl dispatcher;
+  Network::TcpListenSocket socket(Network::Test::getCanonicalLoopbackAddress(version_), true);
+  Network::MockListenerCallbacks listener_callbacks;
+  Network::MockConnectionHandler connection_handler;
+  Network::ListenerOptions listener_options =
+      Network::ListenerOptions::listenerOptionsWithBindToPort();
+  listener_options.max_accepts_per_wakeup_ = 1;
+  listener_options.max_accepts_per_second_ = 2;
+  Network::ListenerImpl listener(connection_handler, dispatcher, socket, listener_callbacks,
+                                 stats_store, listener_options);
+
+  std::vector<Network::ClientConnectionPtr> client_connections;
+  for (int i = 0; i < 3; i++) {
+    client_connections.emplace_back(dispatcher.createClientConnection(
+        socket.localAddress(), Network::Address::InstanceConstSharedPtr()));
+    client_connections.back()->connect();
+  }
+
+  std::vector<Network::ConnectionPtr> server_connections;
+  EXPECT_CALL(listener_callbacks, onNewConnection_(_))
+      .Times(3)
+      .WillRepeatedly(Invoke([&](Network::ConnectionPtr& conn) -> void {
+        server_connections.emplace_back(std::move(conn));
+        if (server_connections.size() == 3) {
+          dispatcher.exit();
+        }
+      }));
+
+  dispatcher.run(Event::Dispatcher::RunType::Block);
+  EXPECT_LE(1UL, stats_store.counter("downstream_cx_accept_batch_limited").value());
+  EXPECT_LE(1UL, stats_store.counter("downstream_cx_accept_rate_limited").value());
+  for (auto& connection : client_connections) {
+    connection->close(ConnectionCloseType::NoFlush);
+  }
+  for (auto& connection : server_connections) {
+    connection->close(ConnectionCloseType::NoFlush);
+  }
+}
+
 } // namespace Network
 } // namespace Envoy
@@ -282,6 +282,110 @@ TEST_P(ProxyProtocolTest, ClosedEmpty) {
   dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
 }
 
+TEST_P(ProxyProtocolTest, V2Basic) {
+  // A V2 PROXY TCP4 header for 1.2.3.4:65535 -> 254.254.254.254:1234.
+  const uint8_t header[] = {0x0d, 0x0a, 0x0d, 0x0a, 0x00, 0x0d, 0x0a, 0x51, 0x55, 0x49,
+                         0x54, 0x0a, 0x21, 0x11, 0x00, 0x0c, 0x01, 0x02, 0x03, 0x04,
+                         0xfe, 0xfe, 0xfe, 0xfe, 0xff, 0xff, 0x04, 0xd2};
+  connect();
+  write(std::string(reinterpret_cast<const char*>(header), sizeof(header)) + "more data");
+
+  EXPECT_CALL(*read_filter_, onNewConnection());
+  EXPECT_CALL(*read_filter_, onData(BufferStringEqual("more data")))
+      .WillOnce(Invoke([&](Buffer::Instance&) -> FilterStatus {
+        EXPECT_EQ(server_connection_->remoteAddress().ip()->addressAsString(), "1.2.3.4");
+        EXPECT_EQ(server_connection_->remoteAddress().ip()->port(), 65535);
+        EXPECT_EQ(server_connection_->localAddress().ip()->addressAsString(), "254.254.254.254");
+        EXPECT_EQ(server_connection_->localAddress().ip()->port(), 1234);
+        dispatcher_.exit();
+        return Network::FilterStatus::Continue;
+      }));
+
+  dispatcher_.run(Event::Dispatcher::RunType::Block);
+
+  disconnect();
+}
+
+TEST_P(ProxyProtocolTest, V2BasicV6WithTlvs) {
+  // A V2 PROXY TCP6 header for [1:2:3::4]:65535 -> [5:6::7:8]:1234, followed by two TLVs.
+  const uint8_t header[] = {0x0d, 0x0a, 0x0d, 0x0a, 0x00, 0x0d, 0x0a, 0x51, 0x55, 0x49, 0x54, 0x0a,
+                         0x21, 0x21, 0x00, 0x2d, 0x00, 0x01, 0x00, 0x02, 0x00, 0x03, 0x00, 0x00,
+                         0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x05, 0x00, 0x06,
+                         0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x00, 0x08,
+                         0xff, 0xff, 0x04, 0xd2, 0x01, 0x00, 0x02, 0x68, 0x32, 0x04, 0x00, 0x01,
+                         0x00};
+  connect();
+  write(std::string(reinterpret_cast<const char*>(header), sizeof(header)) + "more data");
+
+  EXPECT_CALL(*read_filter_, onNewConnection());
+  EXPECT_CALL(*read_filter_, onData(BufferStringEqual("more data")))
+      .WillOnce(Invoke([&](Buffer::Instance&) -> FilterStatus {
+        EXPECT_EQ(server_connection_->remoteAddress().ip()->addressAsString(), "1:2:3::4");
+        EXPECT_EQ(server_connection_->localAddress().ip()->addressAsString(), "5:6::7:8");
+        dispatcher_.exit();
+        return Network::FilterStatus::Continue;
+      }));
+
+  dispatcher_.run(Event::Dispatcher::RunType::Block);
+
+  disconnect();
+}
+
+TEST_P(ProxyProtocolTest, V2Fragmented) {
+  const uint8_t header[] = {0x0d, 0x0a, 0x0d, 0x0a, 0x00, 0x0d, 0x0a, 0x51, 0x55, 0x49,
+                         0x54, 0x0a, 0x21, 0x11, 0x00, 0x0c, 0x01, 0x02, 0x03, 0x04,
+                         0xfe, 0xfe, 0xfe, 0xfe, 0xff, 0xff, 0x04, 0xd2};
+  connect();
+  write(std::string(reinterpret_cast<const char*>(header), 10));
+  dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+  write(std::string(reinterpret_cast<const char*>(header) + 10, 10));
+  dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+  write(std::string(reinterpret_cast<const char*>(header) + 20, sizeof(header) - 20));
+
+  dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+
+  disconnect();
+
+  EXPECT_EQ(server_connection_->remoteAddress().ip()->addressAsString(), "1.2.3.4");
+}
+
+TEST_P(ProxyProtocolTest, V2BadSignature) {
+  const uint8_t header[] = {0x0d, 0x0a, 0x0d, 0x0a, 0x00, 0x0d, 0x0a, 0x51, 0x55, 0x49,
+                         0x54, 0x0b, 0x21, 0x11, 0x00, 0x0c, 0x01, 0x02, 0x03, 0x04,
+                         0xfe, 0xfe, 0xfe, 0xfe, 0xff, 0xff, 0x04, 0xd2};
+  connectNoRead();
+  write(std::string(reinterpret_cast<const char*>(header), sizeof(header)) + "more data");
+  expectProxyProtoError();
+}
+
+TEST_P(ProxyProtocolTest, V2BadVersion) {
+  const uint8_t header[] = {0x0d, 0x0a, 0x0d, 0x0a, 0x00, 0x0d, 0x0a, 0x51, 0x55, 0x49,
+                         0x54, 0x0a, 0x31, 0x11, 0x00, 0x0c, 0x01, 0x02, 0x03, 0x04,
+                         0xfe, 0xfe, 0xfe, 0xfe, 0xff, 0xff, 0x04, 0xd2};
+  connectNoRead();
+  write(std::string(reinterpret_cast<const char*>(header), sizeof(header)) + "more data");
+  expectProxyProtoError();
+}
+
+TEST_P(ProxyProtocolTest, V2ShortAddresses) {
+  const uint8_t header[] = {0x0d, 0x0a, 0x0d, 0x0a, 0x00, 0x0d, 0x0a, 0x51, 0x55, 0x49,
+                         0x54, 0x0a, 0x21, 0x11, 0x00, 0x08, 0x01, 0x02, 0x03, 0x04,
+                         0xfe, 0xfe, 0xfe, 0xfe};
+  connectNoRead();
+  write(std::string(reinterpret_cast<const char*>(header), sizeof(header)) + "more data");
+  expectProxyProtoError();
+}
+
+TEST_P(ProxyProtocolTest, V2TruncatedTlv) {
+  const uint8_t header[] = {0x0d, 0x0a, 0x0d, 0x0a, 0x00, 0x0d, 0x0a, 0x51, 0x55, 0x49,
+                         0x54, 0x0a, 0x21, 0x11, 0x00, 0x10, 0x01, 0x02, 0x03, 0x04,
+                         0xfe, 0xfe, 0xfe, 0xfe, 0xff, 0xff, 0x04, 0xd2, 0x01, 0x00,
+                         0x05, 0x68};
+  connectNoRead();
+  write(std::string(reinterpret_cast<const char*>(header), sizeof(header)) + "more data");
+  expectProxyProtoError();
+}
+
 class WildcardProxyProtocolTest : public testing::TestWithParam<Address::IpVersion> {
 public:
   WildcardProxyProtocolTest()
@@ -0,0 +1,123 @@
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/network/raw_buffer_socket.h"
+
+#include "test/mocks/network/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Return;
+
+namespace Envoy {
+namespace Network {
+
+class RawBufferSocketTest : public testing::Test {
+public:
+  RawBufferSocketTest() {
+    EXPECT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds_));
+    EXPECT_EQ(0, fcntl(fds_[0], F_SETFL, O_NONBLOCK));
+    ON_CALL(callbacks_, fd()).WillByDefault(Return(fds_[0]));
+    ON_CALL(callbacks_.connection_, bufferLimit()).WillByDefault(Return(0));
+  }
+
+  ~RawBufferSocketTest() {
+    close(fds_[0]);
+    if (fds_[1] != -1) {
+      close(fds_[1]);
+    }
+  }
+
+  void writePeer(uint64_t size) {
+    const std::string data(size, 'a');
+    ASSERT_EQ(static_cast<ssize_t>(size), ::write(fds_[1], data.c_str(), size));
+  }
+
+  int fds_[2];
+  testing::NiceMock<MockTransportSocketCallbacks> callbacks_;
+  Buffer::OwnedImpl buffer_;
+};
+
+// Reads which fill the space offered double the read size, and reads which return much less than
+// it halve it again.
+TEST_F(RawBufferSocketTest, AdaptiveReadSize) {
+  RawBufferSocket socket;
+  socket.setTransportSocketCallbacks(callbacks_);
+  EXPECT_EQ(RawBufferSocket::MIN_READ_SIZE, socket.readSize());
+
+  writePeer(3 * RawBufferSocket::MIN_READ_SIZE);
+  IoResult result = socket.doRead(buffer_);
+  EXPECT_EQ(PostIoAction::KeepOpen, result.action_);
+  EXPECT_EQ(3 * RawBufferSocket::MIN_READ_SIZE, result.bytes_processed_);
+  // 16K, 32K and then EAGAIN.
+  EXPECT_EQ(3U, result.num_syscalls_);
+  EXPECT_EQ(4 * RawBufferSocket::MIN_READ_SIZE, socket.readSize());
+  EXPECT_EQ(3 * RawBufferSocket::MIN_READ_SIZE, buffer_.length());
+
+  writePeer(100);
+  result = socket.doRead(buffer_);
+  EXPECT_EQ(100U, result.bytes_processed_);
+  EXPECT_EQ(2U, result.num_syscalls_);
+  EXPECT_EQ(2 * RawBufferSocket::MIN_READ_SIZE, socket.readSize());
+
+  close(fds_[1]);
+  fds_[1] = -1;
+  result = socket.doRead(buffer_);
+  EXPECT_EQ(PostIoAction::Close, result.action_);
+  EXPECT_EQ(0U, result.bytes_processed_);
+  EXPECT_EQ(1U, result.num_syscalls_);
+  EXPECT_EQ(3 * RawBufferSocket::MIN_READ_SIZE + 100, buffer_.length());
+}
+
+// The read size does not grow beyond the configured maximum.
+TEST_F(RawBufferSocketTest, MaxReadSize) {
+  RawBufferSocket socket(1);
+  socket.setTransportSocketCallbacks(callbacks_);
+
+  writePeer(3 * RawBufferSocket::MIN_READ_SIZE);
+  IoResult result = socket.doRead(buffer_);
+  EXPECT_EQ(3 * RawBufferSocket::MIN_READ_SIZE, result.bytes_processed_);
+  EXPECT_EQ(4U, result.num_syscalls_);
+  EXPECT_EQ(RawBufferSocket::MIN_READ_SIZE, socket.readSize());
+}
+
+// Reads stop at the connection's buffer limit.
+TEST_F(RawBufferSocketTest, BufferLimit) {
+  RawBufferSocket socket;
+  socket.setTransportSocketCallbacks(callbacks_);
+  ON_CALL(callbacks_.connection_, bufferLimit()).WillByDefault(Return(10000));
+  EXPECT_CALL(callbacks_, shouldDrainReadBuffer()).WillOnce(Return(true));
+  EXPECT_CALL(callbacks_, setReadBufferReady());
+
+  writePeer(3 * RawBufferSocket::MIN_READ_SIZE);
+  IoResult result = socket.doRead(buffer_);
+  EXPECT_EQ(PostIoAction::KeepOpen, result.action_);
+  EXPECT_EQ(10000U, result.bytes_processed_);
+  EXPECT_EQ(1U, result.num_syscalls_);
+  EXPECT_EQ(10000U, buffer_.length());
+  EXPECT_EQ(RawBufferSocket::MIN_READ_SIZE, socket.readSize());
+}
+
+TEST_F(RawBufferSocketTest, Write) {
+  RawBufferSocket socket;
+  socket.setTransportSocketCallbacks(callbacks_);
+
+  Buffer::OwnedImpl data("hello");
+  IoResult result = socket.doWrite(data);
+  EXPECT_EQ(PostIoAction::KeepOpen, result.action_);
+  EXPECT_EQ(5U, result.bytes_processed_);
+  EXPECT_EQ(1U, result.num_syscalls_);
+  EXPECT_EQ(0U, data.length());
+
+  char out[5];
+  EXPECT_EQ(5, ::read(fds_[1], out, 5));
+  EXPECT_EQ("hello", std::string(out, 5));
+}
+
+} // namespace Network
+} // namespace Envoy
@@ -0,0 +1,126 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/event/dispatcher_impl.h"
+#include "common/network/address_impl.h"
+#include "common/network/listen_socket_impl.h"
+#include "common/network/udp_listener_impl.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/network/mocks.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/network_utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Invoke;
+using testing::_;
+
+namespace Envoy {
+namespace Network {
+
+class UdpListenerImplTest : public testing::TestWithParam<Address::IpVersion> {
+protected:
+  UdpListenerImplTest()
+      : socket_(Network::Test::getCanonicalLoopbackAddress(GetParam()), false),
+        client_socket_(Network::Test::getCanonicalLoopbackAddress(GetParam()), false),
+        listener_(dispatcher_.createUdpListener(socket_, callbacks_, stats_store_)) {
+    ON_CALL(callbacks_, onData(_)).WillByDefault(Invoke([this](UdpRecvData& data) -> void {
+      peer_addresses_.push_back(data.peer_address_);
+      received_.push_back(TestUtility::bufferToString(*data.buffer_));
+    }));
+  }
+
+  void clientSend(const std::string& payload) {
+    sockaddr_storage ss;
+    socklen_t ss_len = sizeof(ss);
+    ASSERT_EQ(0, ::getsockname(socket_.fd(), reinterpret_cast<sockaddr*>(&ss), &ss_len));
+    ASSERT_EQ(static_cast<ssize_t>(payload.size()),
+              ::sendto(client_socket_.fd(), payload.data(), payload.size(), 0,
+                       reinterpret_cast<sockaddr*>(&ss), ss_len));
+  }
+
+  std::string clientRecv() {
+    char datagram[2048];
+    const ssize_t rc = ::recv(client_socket_.fd(), datagram, sizeof(datagram), MSG_DONTWAIT);
+    return rc < 0 ? "" : std::string(datagram, rc);
+  }
+
+  Stats::IsolatedStoreImpl stats_store_;
+  Event::DispatcherImpl dispatcher_;
+  UdpListenSocket socket_;
+  UdpListenSocket client_socket_;
+  testing::NiceMock<MockUdpListenerCallbacks> callbacks_;
+  UdpListenerPtr listener_;
+  std::vector<Address::InstanceConstSharedPtr> peer_addresses_;
+  std::vector<std::string> received_;
+};
+
+INSTANTIATE_TEST_CASE_P(IpVersions, UdpListenerImplTest,
+                        testing::ValuesIn(TestEnvironment::getIpVersionsForTest()));
+
+// More datagrams than a single read takes are all read when the socket is ready, and share the
+// address of their peer.
+TEST_P(UdpListenerImplTest, ReceiveDatagrams) {
+  const uint64_t count = UdpListenerImpl::MAX_DATAGRAMS_PER_READ * 2 + 1;
+  for (uint64_t i = 0; i < count; i++) {
+    clientSend("datagram " + std::to_string(i));
+  }
+  dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+
+  ASSERT_EQ(count, received_.size());
+  for (uint64_t i = 0; i < count; i++) {
+    EXPECT_EQ("datagram " + std::to_string(i), received_[i]);
+    EXPECT_EQ(peer_addresses_[0], peer_addresses_[i]);
+  }
+  EXPECT_EQ(*client_socket_.localAddress(), *peer_addresses_[0]);
+}
+
+// Datagrams larger than the receive size are dropped.
+TEST_P(UdpListenerImplTest, DropTruncatedDatagram) {
+  clientSend(std::string(UdpListenerImpl::MAX_RECV_DATAGRAM_SIZE + 1, 'a'));
+  clientSend(std::string(UdpListenerImpl::MAX_RECV_DATAGRAM_SIZE, 'b'));
+  dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+
+  ASSERT_EQ(1U, received_.size());
+  EXPECT_EQ(std::string(UdpListenerImpl::MAX_RECV_DATAGRAM_SIZE, 'b'), received_[0]);
+  EXPECT_EQ(1U, stats_store_.counter("downstream_rx_datagram_truncated").value());
+}
+
+// Datagrams keep their boundaries and order whether or not they are sent as segments of one
+// message, including a shorter last one and ones to another peer.
+TEST_P(UdpListenerImplTest, SendDatagrams) {
+  UdpListenSocket other_socket(Network::Test::getCanonicalLoopbackAddress(GetParam()), false);
+  Buffer::OwnedImpl first(std::string(1000, 'a'));
+  Buffer::OwnedImpl second(std::string(1000, 'b'));
+  Buffer::OwnedImpl third(std::string(500, 'c'));
+  Buffer::OwnedImpl fourth("other");
+  Buffer::OwnedImpl fifth(std::string(1000, 'd'));
+  // A buffer of several slices.
+  fifth.add(std::string(1000, 'e'));
+
+  std::vector<UdpSendData> datagrams{{client_socket_.localAddress(), first},
+                                     {client_socket_.localAddress(), second},
+                                     {client_socket_.localAddress(), third},
+                                     {other_socket.localAddress(), fourth},
+                                     {client_socket_.localAddress(), fifth}};
+  EXPECT_EQ(5U, listener_->send(datagrams));
+
+  EXPECT_EQ(std::string(1000, 'a'), clientRecv());
+  EXPECT_EQ(std::string(1000, 'b'), clientRecv());
+  EXPECT_EQ(std::string(500, 'c'), clientRecv());
+  EXPECT_EQ(std::string(1000, 'd') + std::string(1000, 'e'), clientRecv());
+  EXPECT_EQ("", clientRecv());
+
+  char datagram[16];
+  EXPECT_EQ(5, ::recv(other_socket.fd(), datagram, sizeof(datagram), MSG_DONTWAIT));
+  EXPECT_EQ(0U, stats_store_.counter("downstream_tx_datagram_unsent").value());
+}
+
+} // namespace Network
+} // namespace Envoy
@@ -1,5 +1,7 @@
 #include <unordered_set>
 
+#include "common/buffer/buffer_impl.h"
+#include "common/protobuf/message_loader.h"
 #include "common/protobuf/protobuf.h"
 #include "common/protobuf/utility.h"
 
@@ -61,6 +63,91 @@ TEST(UtilityTest, LoadTextProtoFromFile_Failure) {
                                 "\" as a text protobuf (type envoy.api.v2.Bootstrap)");
 }
 
+TEST(UtilityTest, MessageLoaderMatchesJsonMapping) {
+  const std::string json = R"EOF(
+  {
+    "node": {
+      "id": "node_id",
+      "metadata": {"a": {"b": [1, "two", true, null]}, "c": 1.5}
+    },
+    "statsFlushInterval": "1.5s",
+    "static_resources": {
+      "clusters": [{
+        "name": "cluster_0",
+        "connect_timeout": "0.25s",
+        "type": "STATIC",
+        "lb_policy": 1,
+        "per_connection_buffer_limit_bytes": 1024,
+        "hosts": {"socket_address": {"address": "127.0.0.1", "port_value": 80}}
+      }]
+    },
+    "admin": {"access_log_path": "/dev/null", "address": null}
+  }
+  )EOF";
+
+  envoy::api::v2::Bootstrap expected;
+  ASSERT_TRUE(Protobuf::util::JsonStringToMessage(json, &expected).ok());
+  envoy::api::v2::Bootstrap bootstrap;
+  EXPECT_TRUE(MessageLoader::loadFromJson(json, bootstrap));
+  EXPECT_TRUE(TestUtility::protoEqual(expected, bootstrap));
+  EXPECT_EQ(250, Protobuf::util::TimeUtil::DurationToMilliseconds(
+                     bootstrap.static_resources().clusters(0).connect_timeout()));
+
+  const std::string yaml = R"EOF(
+  node:
+    id: node_id
+    metadata: {a: {b: [1, two, true, null]}, c: 1.5}
+  stats_flush_interval: 1.5s
+  static_resources:
+    clusters:
+      name: cluster_0
+      connect_timeout: 0.25s
+      type: STATIC
+      lb_policy: 1
+      per_connection_buffer_limit_bytes: 1024
+      hosts:
+      - socket_address: {address: 127.0.0.1, port_value: 80}
+  admin:
+    access_log_path: /dev/null
+    address:
+  )EOF";
+
+  bootstrap.Clear();
+  EXPECT_TRUE(MessageLoader::loadFromYaml(yaml, bootstrap));
+  EXPECT_TRUE(TestUtility::protoEqual(expected, bootstrap));
+}
+
+TEST(UtilityTest, LoadFromJsonBuffer) {
+  Buffer::OwnedImpl json(R"EOF({"node": {"id": "node)EOF");
+  Buffer::OwnedImpl rest(R"EOF(_id"}, "stats_flush_interval": "1.5s"})EOF");
+  json.move(rest);
+  envoy::api::v2::Bootstrap bootstrap;
+  MessageUtil::loadFromJson(json, bootstrap);
+  EXPECT_EQ("node_id", bootstrap.node().id());
+  EXPECT_EQ(1500,
+            Protobuf::util::TimeUtil::DurationToMilliseconds(bootstrap.stats_flush_interval()));
+
+  Buffer::OwnedImpl invalid(R"EOF({"node": {"unknown_field": 1}})EOF");
+  EXPECT_THROW(MessageUtil::loadFromJson(invalid, bootstrap), EnvoyException);
+}
+
+TEST(UtilityTest, MessageLoaderUnsupported) {
+  envoy::api::v2::Bootstrap bootstrap;
+  // Durations given as messages rather than strings.
+  const std::string json = R"EOF({"stats_flush_interval": {"seconds": 5}})EOF";
+  EXPECT_FALSE(MessageLoader::loadFromJson(json, bootstrap));
+  MessageUtil::loadFromJson(json, bootstrap);
+  EXPECT_EQ(5, bootstrap.stats_flush_interval().seconds());
+
+  EXPECT_FALSE(MessageLoader::loadFromJson(R"EOF({"admin": {"foo": 1}})EOF", bootstrap));
+  EXPECT_FALSE(MessageLoader::loadFromJson(R"EOF({"admin": )EOF", bootstrap));
+  EXPECT_FALSE(MessageLoader::loadFromJson(R"EOF({"node": {"id": 1}})EOF", bootstrap));
+  EXPECT_FALSE(MessageLoader::loadFromJson(R"EOF({"node": {}, "node": {}})EOF", bootstrap));
+  EXPECT_FALSE(MessageLoader::loadFromYaml("admin: [", bootstrap));
+  EXPECT_THROW(MessageUtil::loadFromJson(R"EOF({"admin": {"foo": 1}})EOF", bootstrap),
+               EnvoyException);
+}
+
 TEST(UtilityTest, ValueUtilEqual_NullValues) {
   ProtobufWkt::Value v1, v2;
   v1.set_null_value(ProtobufWkt::NULL_VALUE);
@@ -0,0 +1,94 @@
+#include <chrono>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "common/ratelimit/local_ratelimit_impl.h"
+
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::_;
+
+namespace Envoy {
+namespace RateLimit {
+
+class LocalRateLimiterImplTest : public testing::Test {
+public:
+  void initialize(const TokenBucket& default_bucket,
+                  const std::vector<std::pair<Descriptor, TokenBucket>>& descriptors = {}) {
+    fill_timer_ = new Event::MockTimer(&tls_.dispatcher_);
+    EXPECT_CALL(*fill_timer_, enableTimer(std::chrono::milliseconds(100)));
+    rate_limiter_.reset(new LocalRateLimiterImpl(std::chrono::milliseconds(100), default_bucket,
+                                                 descriptors, tls_));
+  }
+
+  void refill() {
+    EXPECT_CALL(*fill_timer_, enableTimer(std::chrono::milliseconds(100)));
+    fill_timer_->callback_();
+  }
+
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  Event::MockTimer* fill_timer_{};
+  std::unique_ptr<LocalRateLimiterImpl> rate_limiter_;
+  const Descriptor descriptor_{{{"foo", "bar"}}};
+  const Descriptor other_descriptor_{{{"foo", "baz"}}};
+};
+
+TEST_F(LocalRateLimiterImplTest, DefaultBucket) {
+  initialize({2, 1});
+  EXPECT_FALSE(rate_limiter_->hasDescriptors());
+
+  EXPECT_TRUE(rate_limiter_->requestAllowed({}));
+  EXPECT_TRUE(rate_limiter_->requestAllowed({descriptor_}));
+  EXPECT_FALSE(rate_limiter_->requestAllowed({}));
+
+  refill();
+  EXPECT_TRUE(rate_limiter_->requestAllowed({}));
+  EXPECT_FALSE(rate_limiter_->requestAllowed({}));
+}
+
+TEST_F(LocalRateLimiterImplTest, RefillCapsAtMaxTokens) {
+  initialize({2, 5});
+
+  EXPECT_TRUE(rate_limiter_->requestAllowed({}));
+  refill();
+  refill();
+  EXPECT_TRUE(rate_limiter_->requestAllowed({}));
+  EXPECT_TRUE(rate_limiter_->requestAllowed({}));
+  EXPECT_FALSE(rate_limiter_->requestAllowed({}));
+}
+
+TEST_F(LocalRateLimiterImplTest, DescriptorBuckets) {
+  initialize({1, 1}, {{descriptor_, {2, 2}}});
+  EXPECT_TRUE(rate_limiter_->hasDescriptors());
+
+  EXPECT_TRUE(rate_limiter_->requestAllowed({other_descriptor_, descriptor_}));
+  EXPECT_TRUE(rate_limiter_->requestAllowed({descriptor_}));
+  EXPECT_FALSE(rate_limiter_->requestAllowed({descriptor_}));
+
+  // Requests without a configured descriptor use the default bucket.
+  EXPECT_TRUE(rate_limiter_->requestAllowed({other_descriptor_}));
+  EXPECT_FALSE(rate_limiter_->requestAllowed({}));
+
+  refill();
+  EXPECT_TRUE(rate_limiter_->requestAllowed({descriptor_}));
+  EXPECT_TRUE(rate_limiter_->requestAllowed({descriptor_}));
+  EXPECT_TRUE(rate_limiter_->requestAllowed({}));
+}
+
+TEST(LocalRateLimiterImplDescriptorTest, DescriptorsEqual) {
+  EXPECT_TRUE(LocalRateLimiterImpl::descriptorsEqual({{{"a", "b"}, {"c", "d"}}},
+                                                     {{{"a", "b"}, {"c", "d"}}}));
+  EXPECT_FALSE(LocalRateLimiterImpl::descriptorsEqual({{{"a", "b"}, {"c", "d"}}},
+                                                      {{{"a", "b"}}}));
+  EXPECT_FALSE(LocalRateLimiterImpl::descriptorsEqual({{{"a", "b"}}}, {{{"a", "c"}}}));
+  EXPECT_FALSE(LocalRateLimiterImpl::descriptorsEqual({{{"a", "b"}}}, {{{"c", "b"}}}));
+}
+
+} // namespace RateLimit
+} // namespace Envoy
@@ -6,7 +6,9 @@
 #include "common/http/headers.h"
 #include "common/ratelimit/ratelimit_impl.h"
 
+#include "test/mocks/common.h"
 #include "test/mocks/grpc/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
 #include "test/mocks/upstream/mocks.h"
 #include "test/test_common/printers.h"
 #include "test/test_common/utility.h"
@@ -18,6 +20,7 @@ using testing::AtLeast;
 using testing::Invoke;
 using testing::Ref;
 using testing::Return;
+using testing::ReturnPointee;
 using testing::WithArg;
 using testing::_;
 
@@ -123,6 +126,130 @@ TEST_F(RateLimitGrpcClientTest, Cancel) {
   client_.cancel();
 }
 
+class RateLimitQuotaLeaseTest : public testing::Test {
+public:
+  RateLimitQuotaLeaseTest()
+      : lease_async_client_(new Grpc::MockAsyncClient<pb::lyft::ratelimit::RateLimitRequest,
+                                                      pb::lyft::ratelimit::RateLimitResponse>()),
+        lease_cache_({4, std::chrono::milliseconds(1000), 2},
+                     RateLimitAsyncClientPtr{lease_async_client_}, time_source_),
+        async_client_(new Grpc::MockAsyncClient<pb::lyft::ratelimit::RateLimitRequest,
+                                                pb::lyft::ratelimit::RateLimitResponse>()),
+        client_(RateLimitAsyncClientPtr{async_client_}, Optional<std::chrono::milliseconds>(),
+                &lease_cache_) {
+    ON_CALL(time_source_, currentTime()).WillByDefault(ReturnPointee(&now_));
+  }
+
+  // Send a limit request which is not served by a lease, and complete it with code.
+  void fetch(const std::vector<Descriptor>& descriptors, uint32_t hits_addend,
+             pb::lyft::ratelimit::RateLimitResponse::Code code) {
+    pb::lyft::ratelimit::RateLimitRequest request;
+    GrpcClientImpl::createRequest(request, "foo", descriptors);
+    request.set_hits_addend(hits_addend);
+    EXPECT_CALL(*async_client_, send(_, ProtoEq(request), Ref(client_), _, _))
+        .WillOnce(Return(&async_request_));
+    client_.limit(request_callbacks_, "foo", descriptors, Tracing::NullSpan::instance());
+
+    std::unique_ptr<pb::lyft::ratelimit::RateLimitResponse> response(
+        new pb::lyft::ratelimit::RateLimitResponse());
+    response->set_overall_code(code);
+    EXPECT_CALL(request_callbacks_,
+                complete(code == pb::lyft::ratelimit::RateLimitResponse_Code_OK
+                             ? LimitStatus::OK
+                             : LimitStatus::OverLimit));
+    client_.onSuccess(std::move(response), span_);
+  }
+
+  // Send a limit request which is served by a lease.
+  void spend(const std::vector<Descriptor>& descriptors) {
+    EXPECT_CALL(*async_client_, send(_, _, _, _, _)).Times(0);
+    EXPECT_CALL(request_callbacks_, complete(LimitStatus::OK));
+    client_.limit(request_callbacks_, "foo", descriptors, Tracing::NullSpan::instance());
+  }
+
+  Grpc::MockAsyncClient<pb::lyft::ratelimit::RateLimitRequest,
+                        pb::lyft::ratelimit::RateLimitResponse>* lease_async_client_;
+  testing::NiceMock<MockMonotonicTimeSource> time_source_;
+  MonotonicTime now_{std::chrono::seconds(1000)};
+  QuotaLeaseCache lease_cache_;
+  Grpc::MockAsyncClient<pb::lyft::ratelimit::RateLimitRequest,
+                        pb::lyft::ratelimit::RateLimitResponse>* async_client_;
+  Grpc::MockAsyncRequest async_request_;
+  Grpc::MockAsyncRequest refresh_request_;
+  GrpcClientImpl client_;
+  MockRequestCallbacks request_callbacks_;
+  testing::NiceMock<Tracing::MockSpan> span_;
+  const std::vector<Descriptor> descriptors_{{{{"foo", "bar"}}}};
+};
+
+TEST_F(RateLimitQuotaLeaseTest, SpendAndRefresh) {
+  fetch(descriptors_, 5, pb::lyft::ratelimit::RateLimitResponse_Code_OK);
+  spend(descriptors_);
+
+  // Spending half of the lease refreshes it in the background.
+  pb::lyft::ratelimit::RateLimitRequest refresh;
+  GrpcClientImpl::createRequest(refresh, "foo", descriptors_);
+  refresh.set_hits_addend(4);
+  RateLimitAsyncCallbacks* refresh_callbacks{};
+  EXPECT_CALL(*lease_async_client_, send(_, ProtoEq(refresh), _, _, _))
+      .WillOnce(Invoke([&](const Protobuf::MethodDescriptor&,
+                           const pb::lyft::ratelimit::RateLimitRequest&,
+                           RateLimitAsyncCallbacks& callbacks, Tracing::Span&,
+                           const Optional<std::chrono::milliseconds>&) -> Grpc::AsyncRequest* {
+        refresh_callbacks = &callbacks;
+        return &refresh_request_;
+      }));
+  spend(descriptors_);
+  spend(descriptors_);
+  spend(descriptors_);
+
+  std::unique_ptr<pb::lyft::ratelimit::RateLimitResponse> response(
+      new pb::lyft::ratelimit::RateLimitResponse());
+  response->set_overall_code(pb::lyft::ratelimit::RateLimitResponse_Code_OK);
+  refresh_callbacks->onSuccess(std::move(response), span_);
+  for (uint32_t i = 0; i < 2; i++) {
+    spend(descriptors_);
+  }
+
+  // Other descriptors have their own lease.
+  fetch({{{{"foo", "baz"}}}}, 5, pb::lyft::ratelimit::RateLimitResponse_Code_OK);
+}
+
+TEST_F(RateLimitQuotaLeaseTest, OverLimit) {
+  fetch(descriptors_, 5, pb::lyft::ratelimit::RateLimitResponse_Code_OVER_LIMIT);
+  fetch(descriptors_, 5, pb::lyft::ratelimit::RateLimitResponse_Code_OVER_LIMIT);
+}
+
+TEST_F(RateLimitQuotaLeaseTest, Expiry) {
+  fetch(descriptors_, 5, pb::lyft::ratelimit::RateLimitResponse_Code_OK);
+  spend(descriptors_);
+
+  now_ += std::chrono::milliseconds(1000);
+  fetch(descriptors_, 5, pb::lyft::ratelimit::RateLimitResponse_Code_OK);
+  spend(descriptors_);
+}
+
+TEST_F(RateLimitQuotaLeaseTest, MaxLeases) {
+  fetch({{{{"foo", "1"}}}}, 5, pb::lyft::ratelimit::RateLimitResponse_Code_OK);
+  fetch({{{{"foo", "2"}}}}, 5, pb::lyft::ratelimit::RateLimitResponse_Code_OK);
+
+  // The cache is full, so further descriptors are not leased.
+  fetch({{{{"foo", "3"}}}}, 0, pb::lyft::ratelimit::RateLimitResponse_Code_OK);
+  fetch({{{{"foo", "3"}}}}, 0, pb::lyft::ratelimit::RateLimitResponse_Code_OK);
+  spend({{{{"foo", "1"}}}});
+}
+
+TEST_F(RateLimitQuotaLeaseTest, LeaseKey) {
+  EXPECT_EQ(QuotaLeaseCache::leaseKey("foo", {{{{"a", "b"}}}}),
+            QuotaLeaseCache::leaseKey("foo", {{{{"a", "b"}}}}));
+  EXPECT_NE(QuotaLeaseCache::leaseKey("foo", {{{{"a", "b"}}}}),
+            QuotaLeaseCache::leaseKey("bar", {{{{"a", "b"}}}}));
+  EXPECT_NE(QuotaLeaseCache::leaseKey("foo", {{{{"a", "b"}, {"c", "d"}}}}),
+            QuotaLeaseCache::leaseKey("foo", {{{{"a", "b"}}}, {{{"c", "d"}}}}));
+  EXPECT_NE(QuotaLeaseCache::leaseKey("foo", {{{{"ab", ""}}}}),
+            QuotaLeaseCache::leaseKey("foo", {{{{"a", "b"}}}}));
+}
+
 TEST(RateLimitGrpcFactoryTest, NoCluster) {
   envoy::api::v2::RateLimitServiceConfig config;
   config.set_cluster_name("foo");
@@ -142,6 +269,18 @@ TEST(RateLimitGrpcFactoryTest, Create) {
   factory.create(Optional<std::chrono::milliseconds>());
 }
 
+TEST(RateLimitGrpcFactoryTest, CreateWithLeases) {
+  envoy::api::v2::RateLimitServiceConfig config;
+  config.set_cluster_name("foo");
+  Upstream::MockClusterManager cm;
+  testing::NiceMock<ThreadLocal::MockInstance> tls;
+
+  EXPECT_CALL(cm, get("foo")).Times(AtLeast(1));
+  EXPECT_CALL(tls, allocateSlot());
+  GrpcFactoryImpl factory(config, cm, {10, std::chrono::milliseconds(1000), 16}, tls);
+  factory.create(Optional<std::chrono::milliseconds>());
+}
+
 TEST(RateLimitNullFactoryTest, Basic) {
   NullFactoryImpl factory;
   ClientPtr client = factory.create(Optional<std::chrono::milliseconds>());
@@ -0,0 +1,130 @@
+#include <string>
+#include <vector>
+
+#include "common/redis/cluster_slots.h"
+
+#include "test/mocks/redis/mocks.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Redis {
+
+class RedisClusterSlotsTest : public testing::Test {
+public:
+  static RespValue makeRange(int64_t start, int64_t end, const std::string& host, int64_t port) {
+    std::vector<RespValue> master(3);
+    master[0].type(RespType::BulkString);
+    master[0].asString() = host;
+    master[1].type(RespType::Integer);
+    master[1].asInteger() = port;
+    master[2].type(RespType::BulkString);
+    master[2].asString() = "node id";
+
+    std::vector<RespValue> values(4);
+    values[0].type(RespType::Integer);
+    values[0].asInteger() = start;
+    values[1].type(RespType::Integer);
+    values[1].asInteger() = end;
+    values[2].type(RespType::Array);
+    values[2].asArray().swap(master);
+    // A replica, which is ignored.
+    values[3] = values[2];
+
+    RespValue range;
+    range.type(RespType::Array);
+    range.asArray().swap(values);
+    return range;
+  }
+
+  static RespValue makeError(const std::string& message) {
+    RespValue error;
+    error.type(RespType::Error);
+    error.asString() = message;
+    return error;
+  }
+};
+
+TEST_F(RedisClusterSlotsTest, KeySlot) {
+  // The CRC16 of "123456789" is 0x31C3.
+  EXPECT_EQ(0x31C3, ClusterSlots::keySlot("123456789"));
+  EXPECT_EQ(12182, ClusterSlots::keySlot("foo"));
+  EXPECT_EQ(5061, ClusterSlots::keySlot("bar"));
+  EXPECT_EQ(0, ClusterSlots::keySlot(""));
+
+  // Only the hash tag is hashed.
+  EXPECT_EQ(ClusterSlots::keySlot("user1000"), ClusterSlots::keySlot("{user1000}.following"));
+  EXPECT_EQ(ClusterSlots::keySlot("bar"), ClusterSlots::keySlot("foo{bar}{zap}"));
+  EXPECT_EQ(ClusterSlots::keySlot("{bar"), ClusterSlots::keySlot("foo{{bar}}zap"));
+  // Empty or unterminated tags are not hash tags.
+  EXPECT_NE(ClusterSlots::keySlot(""), ClusterSlots::keySlot("foo{}{bar}"));
+  EXPECT_NE(ClusterSlots::keySlot("bar"), ClusterSlots::keySlot("foo{}{bar}"));
+  EXPECT_NE(ClusterSlots::keySlot("bar"), ClusterSlots::keySlot("foo{bar"));
+}
+
+TEST_F(RedisClusterSlotsTest, ParseSlots) {
+  std::vector<RespValue> values;
+  values.push_back(makeRange(0, 8191, "10.0.0.1", 6379));
+  values.push_back(makeRange(8192, 16383, "::1", 6380));
+  RespValue value;
+  value.type(RespType::Array);
+  value.asArray().swap(values);
+
+  std::vector<ClusterSlots::SlotRange> ranges;
+  EXPECT_TRUE(ClusterSlots::parseSlots(value, ranges));
+  ASSERT_EQ(2UL, ranges.size());
+  EXPECT_EQ(0, ranges[0].start_);
+  EXPECT_EQ(8191, ranges[0].end_);
+  EXPECT_EQ("10.0.0.1:6379", ranges[0].address_);
+  EXPECT_EQ(8192, ranges[1].start_);
+  EXPECT_EQ(16383, ranges[1].end_);
+  EXPECT_EQ("[::1]:6380", ranges[1].address_);
+}
+
+TEST_F(RedisClusterSlotsTest, ParseInvalidSlots) {
+  std::vector<ClusterSlots::SlotRange> ranges;
+  EXPECT_FALSE(ClusterSlots::parseSlots(makeError("ERR This instance has cluster support disabled"),
+                                        ranges));
+
+  for (const RespValue& range :
+       {makeRange(5, 4, "10.0.0.1", 6379), makeRange(0, 16384, "10.0.0.1", 6379),
+        makeRange(-1, 5, "10.0.0.1", 6379), makeRange(0, 5, "", 6379),
+        makeRange(0, 5, "10.0.0.1", 65536), makeError("ERR")}) {
+    RespValue value;
+    value.type(RespType::Array);
+    value.asArray().push_back(range);
+    EXPECT_FALSE(ClusterSlots::parseSlots(value, ranges));
+  }
+}
+
+TEST_F(RedisClusterSlotsTest, ParseRedirection) {
+  ClusterSlots::Redirection redirection;
+  EXPECT_TRUE(ClusterSlots::parseRedirection(makeError("MOVED 3999 127.0.0.1:6381"), redirection));
+  EXPECT_FALSE(redirection.ask_);
+  EXPECT_EQ(3999, redirection.slot_);
+  EXPECT_EQ("127.0.0.1:6381", redirection.address_);
+
+  EXPECT_TRUE(ClusterSlots::parseRedirection(makeError("ASK 12 ::1:6379"), redirection));
+  EXPECT_TRUE(redirection.ask_);
+  EXPECT_EQ(12, redirection.slot_);
+  EXPECT_EQ("[::1]:6379", redirection.address_);
+
+  EXPECT_FALSE(ClusterSlots::parseRedirection(makeError("ERR unknown command"), redirection));
+  EXPECT_FALSE(ClusterSlots::parseRedirection(makeError("MOVED 16384 127.0.0.1:6381"),
+                                              redirection));
+  EXPECT_FALSE(ClusterSlots::parseRedirection(makeError("MOVED 1 127.0.0.1"), redirection));
+  EXPECT_FALSE(ClusterSlots::parseRedirection(makeError("MOVED 1"), redirection));
+
+  RespValue not_error;
+  not_error.type(RespType::SimpleString);
+  not_error.asString() = "MOVED 3999 127.0.0.1:6381";
+  EXPECT_FALSE(ClusterSlots::parseRedirection(not_error, redirection));
+}
+
+TEST_F(RedisClusterSlotsTest, Requests) {
+  EXPECT_EQ("[\"CLUSTER\", \"SLOTS\"]", ClusterSlots::slotsRequest().toString());
+  EXPECT_EQ("[\"ASKING\"]", ClusterSlots::askingRequest().toString());
+}
+
+} // namespace Redis
+} // namespace Envoy
@@ -1,3 +1,4 @@
+#include <string>
 #include <vector>
 
 #include "common/buffer/buffer_impl.h"
@@ -8,6 +9,7 @@
 #include "test/test_common/printers.h"
 #include "test/test_common/utility.h"
 
+#include "fmt/format.h"
 #include "gtest/gtest.h"
 
 namespace Envoy {
@@ -155,6 +157,76 @@ TEST_F(RedisEncoderDecoderImplTest, NestedArray) {
   EXPECT_EQ(value, *decoded_values_[0]);
 }
 
+TEST_F(RedisEncoderDecoderImplTest, LargeBulkString) {
+  const std::string large(DecoderImpl::MIN_BUFFERED_BULK_STRING_SIZE * 2 + 1, 'a');
+  std::vector<RespValue> values(2);
+  values[0].type(RespType::BulkString);
+  values[0].asString() = large;
+  values[1].type(RespType::BulkString);
+  values[1].asString() = "small";
+
+  RespValue value;
+  value.type(RespType::Array);
+  value.asArray().swap(values);
+  encoder_.encode(value, buffer_);
+  const std::string encoded = TestUtility::bufferToString(buffer_);
+  EXPECT_EQ(fmt::format("*2\r\n${}\r\n{}\r\n$5\r\nsmall\r\n", large.size(), large), encoded);
+
+  // Decode the value in pieces which don't line up with its parts.
+  for (uint64_t i = 0; i < encoded.size(); i += 1000) {
+    Buffer::OwnedImpl temp_buffer(encoded.substr(i, 1000));
+    decoder_.decode(temp_buffer);
+    EXPECT_EQ(0UL, temp_buffer.length());
+  }
+  ASSERT_EQ(1UL, decoded_values_.size());
+  RespValue& decoded = *decoded_values_[0];
+  ASSERT_NE(nullptr, decoded.asArray()[0].asBuffer());
+  EXPECT_EQ(large.size(), decoded.asArray()[0].asBuffer()->length());
+  EXPECT_EQ(nullptr, decoded.asArray()[1].asBuffer());
+
+  // The buffered value is encoded by reference, and stays valid after the value is destroyed.
+  Buffer::OwnedImpl reencoded;
+  encoder_.encode(decoded, reencoded);
+  const RespValue& const_decoded = decoded;
+  EXPECT_EQ(large, const_decoded.asArray()[0].asString());
+  EXPECT_NE(nullptr, decoded.asArray()[0].asBuffer());
+  decoded_values_.clear();
+  EXPECT_EQ(encoded, TestUtility::bufferToString(reencoded));
+}
+
+TEST_F(RedisEncoderDecoderImplTest, LargeBulkStringModified) {
+  const std::string large(DecoderImpl::MIN_BUFFERED_BULK_STRING_SIZE, 'a');
+  buffer_.add(fmt::format("${}\r\n{}\r\n", large.size(), large));
+  decoder_.decode(buffer_);
+  EXPECT_EQ(0UL, buffer_.length());
+  ASSERT_NE(nullptr, decoded_values_[0]->asBuffer());
+
+  // Modifying the string releases the buffer.
+  decoded_values_[0]->asString().append("b");
+  EXPECT_EQ(nullptr, decoded_values_[0]->asBuffer());
+  encoder_.encode(*decoded_values_[0], buffer_);
+  EXPECT_EQ(fmt::format("${}\r\n{}b\r\n", large.size() + 1, large),
+            TestUtility::bufferToString(buffer_));
+}
+
+TEST_F(RedisEncoderDecoderImplTest, Copy) {
+  const std::string large(DecoderImpl::MIN_BUFFERED_BULK_STRING_SIZE, 'a');
+  buffer_.add(fmt::format("*3\r\n${}\r\n{}\r\n:5\r\n+OK\r\n", large.size(), large));
+  decoder_.decode(buffer_);
+  const RespValue& decoded = *decoded_values_[0];
+
+  RespValue copy(decoded);
+  EXPECT_EQ(decoded, copy);
+  // The buffered bulk string is shared rather than copied.
+  EXPECT_EQ(decoded.asArray()[0].asBuffer(), copy.asArray()[0].asBuffer());
+
+  RespValue assigned;
+  assigned.type(RespType::Integer);
+  assigned = copy.asArray()[2];
+  EXPECT_EQ(RespType::SimpleString, assigned.type());
+  EXPECT_EQ("OK", assigned.asString());
+}
+
 TEST_F(RedisEncoderDecoderImplTest, NullArray) {
   buffer_.add("*-1\r\n");
   decoder_.decode(buffer_);
@@ -1,14 +1,19 @@
+#include <algorithm>
 #include <cstdint>
 #include <list>
 #include <string>
 #include <vector>
 
 #include "common/redis/command_splitter_impl.h"
+#include "common/redis/hot_key_cache.h"
 #include "common/redis/supported_commands.h"
 #include "common/stats/stats_impl.h"
 
 #include "test/mocks/common.h"
 #include "test/mocks/redis/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/mocks/upstream/mocks.h"
 #include "test/test_common/printers.h"
 
 #include "fmt/format.h"
@@ -19,8 +24,10 @@ using testing::ByRef;
 using testing::DoAll;
 using testing::Eq;
 using testing::InSequence;
+using testing::NiceMock;
 using testing::Ref;
 using testing::Return;
+using testing::ReturnRef;
 using testing::WithArg;
 using testing::_;
 
@@ -267,41 +274,101 @@ TEST_F(RedisSingleServerRequestTest, EvalNoUpstream) {
   EXPECT_EQ(nullptr, handle_);
 };
 
-class RedisMGETCommandHandlerTest : public RedisCommandSplitterImplTest {
+class RedisFragmentedRequestTest : public RedisCommandSplitterImplTest {
 public:
-  void setup(uint32_t num_gets, const std::list<uint64_t>& null_handle_indexes) {
-    std::vector<std::string> request_strings = {"mget"};
-    for (uint32_t i = 0; i < num_gets; i++) {
-      request_strings.push_back(std::to_string(i));
+  /**
+   * Make a request whose keys are each followed by args_per_key - 1 other arguments, and expect the
+   * arguments of the keys to be sent to their hosts in one request per host. Key i hashes to host
+   * key_hosts[i], or to a host of its own if key_hosts is empty. If key_slots_ is set the upstream
+   * is a Redis Cluster, key i is in slot key_slots_[i] and there is one request per host and slot.
+   * null_handle_indexes are the indexes of the per host requests which can't be made.
+   */
+  void makeFragmentedRequest(const std::vector<std::string>& request_strings,
+                             uint32_t args_per_key, std::vector<uint32_t> key_hosts,
+                             const std::list<uint64_t>& null_handle_indexes) {
+    const uint32_t num_keys = (request_strings.size() - 1) / args_per_key;
+    for (uint32_t i = key_hosts.size(); i < num_keys; i++) {
+      key_hosts.push_back(i);
     }
 
-    RespValue request;
-    makeBulkStringArray(request, request_strings);
+    // The requests are made in the order in which the hosts and slots are first used.
+    std::vector<std::pair<uint32_t, int32_t>> fragments;
+    std::vector<std::vector<std::string>> fragment_strings;
+    for (uint32_t i = 0; i < num_keys; i++) {
+      const auto key_fragment =
+          std::make_pair(key_hosts[i], key_slots_.empty() ? -1 : key_slots_[i]);
+      auto fragment = std::find(fragments.begin(), fragments.end(), key_fragment);
+      if (fragment == fragments.end()) {
+        fragment = fragments.insert(fragment, key_fragment);
+        fragment_strings.push_back({request_strings[0]});
+      }
+      std::vector<std::string>& strings = fragment_strings[fragment - fragments.begin()];
+      strings.insert(strings.end(), request_strings.begin() + 1 + i * args_per_key,
+                     request_strings.begin() + 1 + (i + 1) * args_per_key);
+    }
+
+    while (hosts_.size() <= *std::max_element(key_hosts.begin(), key_hosts.end())) {
+      hosts_.emplace_back(new Upstream::MockHost());
+    }
+    for (uint32_t i = 0; i < num_keys; i++) {
+      EXPECT_CALL(*conn_pool_, chooseHost(request_strings[1 + i * args_per_key]))
+          .WillOnce(Return(hosts_[key_hosts[i]]));
+      Optional<uint16_t> slot;
+      if (!key_slots_.empty()) {
+        slot = key_slots_[i];
+      }
+      EXPECT_CALL(*conn_pool_, hashSlot(request_strings[1 + i * args_per_key]))
+          .WillOnce(Return(slot));
+    }
 
-    std::vector<RespValue> tmp_expected_requests(num_gets);
+    std::vector<RespValue> tmp_expected_requests(fragments.size());
     expected_requests_.swap(tmp_expected_requests);
-    pool_callbacks_.resize(num_gets);
-    std::vector<ConnPool::MockPoolRequest> tmp_pool_requests(num_gets);
+    pool_callbacks_.resize(fragments.size());
+    std::vector<ConnPool::MockPoolRequest> tmp_pool_requests(fragments.size());
     pool_requests_.swap(tmp_pool_requests);
-    for (uint32_t i = 0; i < num_gets; i++) {
-      makeBulkStringArray(expected_requests_[i], {"get", std::to_string(i)});
+    for (uint32_t i = 0; i < fragments.size(); i++) {
+      makeBulkStringArray(expected_requests_[i], fragment_strings[i]);
       ConnPool::PoolRequest* request_to_use = nullptr;
       if (std::find(null_handle_indexes.begin(), null_handle_indexes.end(), i) ==
           null_handle_indexes.end()) {
         request_to_use = &pool_requests_[i];
       }
-      EXPECT_CALL(*conn_pool_, makeRequest(std::to_string(i), Eq(ByRef(expected_requests_[i])), _))
+      EXPECT_CALL(*conn_pool_, makeRequestToHost(Eq(hosts_[fragments[i].first]),
+                                                 Eq(ByRef(expected_requests_[i])), _))
           .WillOnce(DoAll(WithArg<2>(SaveArgAddress(&pool_callbacks_[i])), Return(request_to_use)));
     }
 
+    RespValue request;
+    makeBulkStringArray(request, request_strings);
     handle_ = splitter_.makeRequest(request, callbacks_);
   }
 
+  std::vector<int32_t> key_slots_;
+  std::vector<Upstream::HostConstSharedPtr> hosts_;
   std::vector<RespValue> expected_requests_;
   std::vector<ConnPool::PoolCallbacks*> pool_callbacks_;
   std::vector<ConnPool::MockPoolRequest> pool_requests_;
 };
 
+class RedisMGETCommandHandlerTest : public RedisFragmentedRequestTest {
+public:
+  void setup(uint32_t num_gets, const std::list<uint64_t>& null_handle_indexes,
+             const std::vector<uint32_t>& key_hosts = {}) {
+    std::vector<std::string> request_strings = {"mget"};
+    for (uint32_t i = 0; i < num_gets; i++) {
+      request_strings.push_back(std::to_string(i));
+    }
+
+    makeFragmentedRequest(request_strings, 1, key_hosts, null_handle_indexes);
+  }
+
+  RespValuePtr makeResponse(const std::vector<std::string>& values) {
+    RespValuePtr response(new RespValue());
+    makeBulkStringArray(*response, values);
+    return response;
+  }
+};
+
 TEST_F(RedisMGETCommandHandlerTest, Normal) {
   InSequence s;
 
@@ -317,16 +384,10 @@ TEST_F(RedisMGETCommandHandlerTest, Normal) {
   elements[1].asString() = "5";
   expected_response.asArray().swap(elements);
 
-  RespValuePtr response2(new RespValue());
-  response2->type(RespType::BulkString);
-  response2->asString() = "5";
-  pool_callbacks_[1]->onResponse(std::move(response2));
+  pool_callbacks_[1]->onResponse(makeResponse({"5"}));
 
-  RespValuePtr response1(new RespValue());
-  response1->type(RespType::BulkString);
-  response1->asString() = "response";
   EXPECT_CALL(callbacks_, onResponse_(PointeesEq(&expected_response)));
-  pool_callbacks_[0]->onResponse(std::move(response1));
+  pool_callbacks_[0]->onResponse(makeResponse({"response"}));
 
   EXPECT_EQ(1UL, store_.counter("redis.foo.command.mget.total").value());
 };
@@ -345,13 +406,13 @@ TEST_F(RedisMGETCommandHandlerTest, NormalWithNull) {
   expected_response.asArray().swap(elements);
 
   RespValuePtr response2(new RespValue());
+  response2->type(RespType::Array);
+  std::vector<RespValue> values(1);
+  response2->asArray().swap(values);
   pool_callbacks_[1]->onResponse(std::move(response2));
 
-  RespValuePtr response1(new RespValue());
-  response1->type(RespType::BulkString);
-  response1->asString() = "response";
   EXPECT_CALL(callbacks_, onResponse_(PointeesEq(&expected_response)));
-  pool_callbacks_[0]->onResponse(std::move(response1));
+  pool_callbacks_[0]->onResponse(makeResponse({"response"}));
 };
 
 TEST_F(RedisMGETCommandHandlerTest, NoUpstreamHostForAll) {
@@ -407,11 +468,8 @@ TEST_F(RedisMGETCommandHandlerTest, Failure) {
 
   pool_callbacks_[1]->onFailure();
 
-  RespValuePtr response1(new RespValue());
-  response1->type(RespType::BulkString);
-  response1->asString() = "response";
   EXPECT_CALL(callbacks_, onResponse_(PointeesEq(&expected_response)));
-  pool_callbacks_[0]->onResponse(std::move(response1));
+  pool_callbacks_[0]->onResponse(makeResponse({"response"}));
 };
 
 TEST_F(RedisMGETCommandHandlerTest, InvalidUpstreamResponse) {
@@ -438,6 +496,103 @@ TEST_F(RedisMGETCommandHandlerTest, InvalidUpstreamResponse) {
   pool_callbacks_[0]->onResponse(std::move(response1));
 };
 
+TEST_F(RedisMGETCommandHandlerTest, KeysGroupedByHost) {
+  InSequence s;
+
+  // Keys 0 and 2 hash to the same host, so "mget 0 2" and "mget 1" are sent.
+  setup(3, {}, {0, 1, 0});
+  EXPECT_NE(nullptr, handle_);
+  EXPECT_EQ(2UL, expected_requests_.size());
+
+  RespValue expected_response;
+  expected_response.type(RespType::Array);
+  std::vector<RespValue> elements(3);
+  elements[0].type(RespType::BulkString);
+  elements[0].asString() = "zero";
+  elements[1].type(RespType::BulkString);
+  elements[1].asString() = "one";
+  expected_response.asArray().swap(elements);
+
+  pool_callbacks_[1]->onResponse(makeResponse({"one"}));
+
+  RespValuePtr response1 = makeResponse({"zero", ""});
+  response1->asArray()[1].type(RespType::Null);
+  EXPECT_CALL(callbacks_, onResponse_(PointeesEq(&expected_response)));
+  pool_callbacks_[0]->onResponse(std::move(response1));
+};
+
+TEST_F(RedisMGETCommandHandlerTest, KeysGroupedBySlot) {
+  InSequence s;
+
+  // All the keys hash to the same host of a Redis Cluster, which only serves keys in the same slot
+  // together, so "mget 0 2" and "mget 1" are sent.
+  key_slots_ = {7, 8, 7};
+  setup(3, {}, {0, 0, 0});
+  EXPECT_NE(nullptr, handle_);
+  EXPECT_EQ(2UL, expected_requests_.size());
+
+  RespValue expected_response;
+  expected_response.type(RespType::Array);
+  std::vector<RespValue> elements(3);
+  elements[0].type(RespType::BulkString);
+  elements[0].asString() = "zero";
+  elements[1].type(RespType::BulkString);
+  elements[1].asString() = "one";
+  elements[2].type(RespType::BulkString);
+  elements[2].asString() = "two";
+  expected_response.asArray().swap(elements);
+
+  pool_callbacks_[0]->onResponse(makeResponse({"zero", "two"}));
+  EXPECT_CALL(callbacks_, onResponse_(PointeesEq(&expected_response)));
+  pool_callbacks_[1]->onResponse(makeResponse({"one"}));
+};
+
+TEST_F(RedisMGETCommandHandlerTest, UpstreamErrorForHost) {
+  InSequence s;
+
+  setup(3, {}, {0, 1, 0});
+  EXPECT_NE(nullptr, handle_);
+
+  RespValue expected_response;
+  expected_response.type(RespType::Array);
+  std::vector<RespValue> elements(3);
+  elements[0].type(RespType::Error);
+  elements[0].asString() = "error";
+  elements[1].type(RespType::Error);
+  elements[1].asString() = "upstream protocol error";
+  elements[2].type(RespType::Error);
+  elements[2].asString() = "error";
+  expected_response.asArray().swap(elements);
+
+  // A response with the wrong number of values is a protocol error for all of its keys.
+  pool_callbacks_[1]->onResponse(makeResponse({"one", "two"}));
+
+  RespValuePtr response1(new RespValue());
+  response1->type(RespType::Error);
+  response1->asString() = "error";
+  EXPECT_CALL(callbacks_, onResponse_(PointeesEq(&expected_response)));
+  pool_callbacks_[0]->onResponse(std::move(response1));
+};
+
+TEST_F(RedisMGETCommandHandlerTest, NoHostForKey) {
+  InSequence s;
+
+  RespValue expected_response;
+  expected_response.type(RespType::Array);
+  std::vector<RespValue> elements(1);
+  elements[0].type(RespType::Error);
+  elements[0].asString() = "no upstream host";
+  expected_response.asArray().swap(elements);
+
+  EXPECT_CALL(*conn_pool_, chooseHost("foo")).WillOnce(Return(nullptr));
+  EXPECT_CALL(*conn_pool_, hashSlot("foo")).WillOnce(Return(Optional<uint16_t>()));
+  EXPECT_CALL(*conn_pool_, makeRequestToHost(_, _, _)).Times(0);
+  EXPECT_CALL(callbacks_, onResponse_(PointeesEq(&expected_response)));
+  RespValue request;
+  makeBulkStringArray(request, {"mget", "foo"});
+  EXPECT_EQ(nullptr, splitter_.makeRequest(request, callbacks_));
+};
+
 TEST_F(RedisMGETCommandHandlerTest, Cancel) {
   InSequence s;
 
@@ -449,9 +604,10 @@ TEST_F(RedisMGETCommandHandlerTest, Cancel) {
   handle_->cancel();
 };
 
-class RedisMSETCommandHandlerTest : public RedisCommandSplitterImplTest {
+class RedisMSETCommandHandlerTest : public RedisFragmentedRequestTest {
 public:
-  void setup(uint32_t num_sets, const std::list<uint64_t>& null_handle_indexes) {
+  void setup(uint32_t num_sets, const std::list<uint64_t>& null_handle_indexes,
+             const std::vector<uint32_t>& key_hosts = {}) {
     std::vector<std::string> request_strings = {"mset"};
     for (uint32_t i = 0; i < num_sets; i++) {
       // key
@@ -460,31 +616,8 @@ public:
       request_strings.push_back(std::to_string(i));
     }
 
-    RespValue request;
-    makeBulkStringArray(request, request_strings);
-
-    std::vector<RespValue> tmp_expected_requests(num_sets);
-    expected_requests_.swap(tmp_expected_requests);
-    pool_callbacks_.resize(num_sets);
-    std::vector<ConnPool::MockPoolRequest> tmp_pool_requests(num_sets);
-    pool_requests_.swap(tmp_pool_requests);
-    for (uint32_t i = 0; i < num_sets; i++) {
-      makeBulkStringArray(expected_requests_[i], {"set", std::to_string(i), std::to_string(i)});
-      ConnPool::PoolRequest* request_to_use = nullptr;
-      if (std::find(null_handle_indexes.begin(), null_handle_indexes.end(), i) ==
-          null_handle_indexes.end()) {
-        request_to_use = &pool_requests_[i];
-      }
-      EXPECT_CALL(*conn_pool_, makeRequest(std::to_string(i), Eq(ByRef(expected_requests_[i])), _))
-          .WillOnce(DoAll(WithArg<2>(SaveArgAddress(&pool_callbacks_[i])), Return(request_to_use)));
-    }
-
-    handle_ = splitter_.makeRequest(request, callbacks_);
+    makeFragmentedRequest(request_strings, 2, key_hosts, null_handle_indexes);
   }
-
-  std::vector<RespValue> expected_requests_;
-  std::vector<ConnPool::PoolCallbacks*> pool_callbacks_;
-  std::vector<ConnPool::MockPoolRequest> pool_requests_;
 };
 
 TEST_F(RedisMSETCommandHandlerTest, Normal) {
@@ -540,6 +673,27 @@ TEST_F(RedisMSETCommandHandlerTest, NoUpstreamHostForOne) {
   pool_callbacks_[1]->onResponse(std::move(response2));
 };
 
+TEST_F(RedisMSETCommandHandlerTest, KeysGroupedByHost) {
+  InSequence s;
+
+  // "mset 0 0 1 1" and "mset 2 2" are sent.
+  setup(3, {}, {0, 0, 1});
+  EXPECT_NE(nullptr, handle_);
+  EXPECT_EQ(2UL, expected_requests_.size());
+
+  RespValue expected_response;
+  expected_response.type(RespType::Error);
+  expected_response.asString() = "finished with 1 error(s)";
+
+  RespValuePtr response2(new RespValue());
+  response2->type(RespType::SimpleString);
+  response2->asString() = "OK";
+  pool_callbacks_[1]->onResponse(std::move(response2));
+
+  EXPECT_CALL(callbacks_, onResponse_(PointeesEq(&expected_response)));
+  pool_callbacks_[0]->onFailure();
+};
+
 TEST_F(RedisMSETCommandHandlerTest, Cancel) {
   InSequence s;
 
@@ -563,40 +717,18 @@ TEST_F(RedisMSETCommandHandlerTest, WrongNumberOfArgs) {
   EXPECT_EQ(nullptr, splitter_.makeRequest(request, callbacks_));
 };
 
-class RedisSplitKeysSumResultHandlerTest : public RedisCommandSplitterImplTest,
+class RedisSplitKeysSumResultHandlerTest : public RedisFragmentedRequestTest,
                                            public testing::WithParamInterface<std::string> {
 public:
-  void setup(uint32_t num_commands, const std::list<uint64_t>& null_handle_indexes) {
+  void setup(uint32_t num_commands, const std::list<uint64_t>& null_handle_indexes,
+             const std::vector<uint32_t>& key_hosts = {}) {
     std::vector<std::string> request_strings = {GetParam()};
     for (uint32_t i = 0; i < num_commands; i++) {
       request_strings.push_back(std::to_string(i));
     }
 
-    RespValue request;
-    makeBulkStringArray(request, request_strings);
-
-    std::vector<RespValue> tmp_expected_requests(num_commands);
-    expected_requests_.swap(tmp_expected_requests);
-    pool_callbacks_.resize(num_commands);
-    std::vector<ConnPool::MockPoolRequest> tmp_pool_requests(num_commands);
-    pool_requests_.swap(tmp_pool_requests);
-    for (uint32_t i = 0; i < num_commands; i++) {
-      makeBulkStringArray(expected_requests_[i], {GetParam(), std::to_string(i)});
-      ConnPool::PoolRequest* request_to_use = nullptr;
-      if (std::find(null_handle_indexes.begin(), null_handle_indexes.end(), i) ==
-          null_handle_indexes.end()) {
-        request_to_use = &pool_requests_[i];
-      }
-      EXPECT_CALL(*conn_pool_, makeRequest(std::to_string(i), Eq(ByRef(expected_requests_[i])), _))
-          .WillOnce(DoAll(WithArg<2>(SaveArgAddress(&pool_callbacks_[i])), Return(request_to_use)));
-    }
-
-    handle_ = splitter_.makeRequest(request, callbacks_);
+    makeFragmentedRequest(request_strings, 1, key_hosts, null_handle_indexes);
   }
-
-  std::vector<RespValue> expected_requests_;
-  std::vector<ConnPool::PoolCallbacks*> pool_callbacks_;
-  std::vector<ConnPool::MockPoolRequest> pool_requests_;
 };
 
 TEST_P(RedisSplitKeysSumResultHandlerTest, Normal) {
@@ -647,6 +779,29 @@ TEST_P(RedisSplitKeysSumResultHandlerTest, NormalOneZero) {
   EXPECT_EQ(1UL, store_.counter("redis.foo.command." + GetParam() + ".total").value());
 };
 
+TEST_P(RedisSplitKeysSumResultHandlerTest, KeysGroupedByHost) {
+  InSequence s;
+
+  setup(3, {}, {0, 1, 0});
+  EXPECT_NE(nullptr, handle_);
+  EXPECT_EQ(2UL, expected_requests_.size());
+
+  RespValue expected_response;
+  expected_response.type(RespType::Integer);
+  expected_response.asInteger() = 3;
+
+  RespValuePtr response2(new RespValue());
+  response2->type(RespType::Integer);
+  response2->asInteger() = 1;
+  pool_callbacks_[1]->onResponse(std::move(response2));
+
+  RespValuePtr response1(new RespValue());
+  response1->type(RespType::Integer);
+  response1->asInteger() = 2;
+  EXPECT_CALL(callbacks_, onResponse_(PointeesEq(&expected_response)));
+  pool_callbacks_[0]->onResponse(std::move(response1));
+};
+
 TEST_P(RedisSplitKeysSumResultHandlerTest, NoUpstreamHostForAll) {
   // No InSequence to avoid making setup() more complicated.
 
@@ -662,6 +817,78 @@ TEST_P(RedisSplitKeysSumResultHandlerTest, NoUpstreamHostForAll) {
 INSTANTIATE_TEST_CASE_P(RedisSplitKeysSumResultHandlerTest, RedisSplitKeysSumResultHandlerTest,
                         testing::ValuesIn(SupportedCommands::hashMultipleSumResultCommands()));
 
+class RedisHotKeyCacheSplitterTest : public RedisCommandSplitterImplTest {
+public:
+  RedisHotKeyCacheSplitterTest() {
+    ON_CALL(runtime_.snapshot_, get("redis.hot_key_cache.prefixes"))
+        .WillByDefault(ReturnRef(prefixes_));
+  }
+
+  void get(const std::string& key) {
+    RespValue request;
+    makeBulkStringArray(request, {"get", key});
+    EXPECT_CALL(*cached_conn_pool_, makeRequest(key, Ref(request), _))
+        .WillOnce(DoAll(WithArg<2>(SaveArgAddress(&pool_callbacks_)), Return(&pool_request_)));
+    handle_ = cached_splitter_.makeRequest(request, callbacks_);
+    EXPECT_NE(nullptr, handle_);
+
+    RespValuePtr response(new RespValue());
+    response->type(RespType::BulkString);
+    response->asString() = "value";
+    EXPECT_CALL(callbacks_, onResponse_(PointeesEq(response.get())));
+    pool_callbacks_->onResponse(std::move(response));
+  }
+
+  void getCached(const std::string& key) {
+    RespValue request;
+    makeBulkStringArray(request, {"get", key});
+    RespValue response;
+    response.type(RespType::BulkString);
+    response.asString() = "value";
+    EXPECT_CALL(callbacks_, onResponse_(PointeesEq(&response)));
+    EXPECT_EQ(nullptr, cached_splitter_.makeRequest(request, callbacks_));
+  }
+
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<MockMonotonicTimeSource> time_source_;
+  std::string prefixes_{"hot:"};
+  ConnPool::MockInstance* cached_conn_pool_{new ConnPool::MockInstance()};
+  InstanceImpl cached_splitter_{
+      ConnPool::InstancePtr{cached_conn_pool_}, store_, "redis.foo.",
+      HotKeyCachePtr{new HotKeyCache(tls_, runtime_, time_source_, store_, "redis.foo.")}};
+  ConnPool::PoolCallbacks* pool_callbacks_;
+  ConnPool::MockPoolRequest pool_request_;
+};
+
+TEST_F(RedisHotKeyCacheSplitterTest, GetServedFromCache) {
+  get("hot:1");
+  getCached("hot:1");
+  EXPECT_EQ(2UL, store_.counter("redis.foo.command.get.total").value());
+  EXPECT_EQ(1UL, store_.counter("redis.foo.hot_keys.cache_hit").value());
+}
+
+TEST_F(RedisHotKeyCacheSplitterTest, KeyNotCacheable) {
+  get("cold:1");
+  get("cold:1");
+  EXPECT_EQ(0UL, store_.counter("redis.foo.hot_keys.cache_miss").value());
+}
+
+TEST_F(RedisHotKeyCacheSplitterTest, WriteInvalidates) {
+  get("hot:1");
+
+  RespValue request;
+  makeBulkStringArray(request, {"set", "hot:1", "other"});
+  EXPECT_CALL(*cached_conn_pool_, makeRequest("hot:1", Ref(request), _))
+      .WillOnce(Return(&pool_request_));
+  handle_ = cached_splitter_.makeRequest(request, callbacks_);
+  EXPECT_EQ(1UL, store_.counter("redis.foo.hot_keys.cache_invalidation").value());
+
+  EXPECT_CALL(pool_request_, cancel());
+  handle_->cancel();
+  get("hot:1");
+}
+
 } // namespace CommandSplitter
 } // namespace Redis
 } // namespace Envoy
@@ -7,20 +7,29 @@
 
 #include "test/mocks/network/mocks.h"
 #include "test/mocks/redis/mocks.h"
+#include "test/mocks/runtime/mocks.h"
 #include "test/mocks/thread_local/mocks.h"
 #include "test/mocks/upstream/mocks.h"
 #include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
 
+#include "fmt/format.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::ByRef;
+using testing::DoAll;
 using testing::Eq;
 using testing::InSequence;
 using testing::Invoke;
+using testing::NiceMock;
+using testing::Pointee;
+using testing::Property;
 using testing::Ref;
 using testing::Return;
 using testing::ReturnRef;
 using testing::SaveArg;
+using testing::WithArg;
 using testing::_;
 
 namespace Envoy {
@@ -87,6 +96,8 @@ public:
   const std::string cluster_name_{"foo"};
   std::shared_ptr<Upstream::MockHost> host_{new NiceMock<Upstream::MockHost>()};
   Event::MockDispatcher dispatcher_;
+  // The flush timer is created after the connect timer, so its expectation must be set first.
+  NiceMock<Event::MockTimer>* flush_timer_{new NiceMock<Event::MockTimer>(&dispatcher_)};
   Event::MockTimer* connect_or_op_timer_{new Event::MockTimer(&dispatcher_)};
   MockEncoder* encoder_{new MockEncoder()};
   MockDecoder* decoder_{new MockDecoder()};
@@ -120,6 +131,7 @@ TEST_F(RedisClientImplTest, Basic) {
   EXPECT_EQ(2UL, host_->cluster_.stats_.upstream_rq_active_.value());
   EXPECT_EQ(2UL, host_->stats_.rq_total_.value());
   EXPECT_EQ(2UL, host_->stats_.rq_active_.value());
+  EXPECT_EQ(2UL, client_->outstandingRequests());
 
   Buffer::OwnedImpl fake_data;
   EXPECT_CALL(*decoder_, decode(Ref(fake_data))).WillOnce(Invoke([&](Buffer::Instance&) -> void {
@@ -291,6 +303,7 @@ TEST_F(RedisClientImplTest, ConnectFail) {
 class ConfigOutlierDisabled : public Config {
   bool disableOutlierEvents() const override { return true; }
   std::chrono::milliseconds opTimeout() const override { return std::chrono::milliseconds(25); }
+  uint32_t maxBufferSizeBeforeFlush() const override { return 0; }
 };
 
 TEST_F(RedisClientImplTest, OutlierDisabled) {
@@ -355,6 +368,95 @@ TEST_F(RedisClientImplTest, OpTimeout) {
   EXPECT_EQ(1UL, host_->cluster_.stats_.upstream_rq_timeout_.value());
 }
 
+TEST_F(RedisClientImplTest, BatchWrites) {
+  InSequence s;
+
+  setup();
+
+  // Requests made in the same iteration of the event loop are written together.
+  RespValue request1;
+  MockPoolCallbacks callbacks1;
+  EXPECT_CALL(*encoder_, encode(Ref(request1), _))
+      .WillOnce(Invoke([](const RespValue&, Buffer::Instance& out) -> void { out.add("a"); }));
+  EXPECT_CALL(*flush_timer_, enableTimer(std::chrono::milliseconds(0)));
+  client_->makeRequest(request1, callbacks1);
+
+  onConnected();
+
+  RespValue request2;
+  MockPoolCallbacks callbacks2;
+  EXPECT_CALL(*encoder_, encode(Ref(request2), _))
+      .WillOnce(Invoke([](const RespValue&, Buffer::Instance& out) -> void { out.add("b"); }));
+  client_->makeRequest(request2, callbacks2);
+
+  EXPECT_CALL(host_->cluster_.stats_store_,
+              deliverHistogramToSinks(
+                  Property(&Stats::Metric::name, "upstream_redis_commands_per_write"), 2));
+  EXPECT_CALL(*upstream_connection_, write(_)).WillOnce(Invoke([](Buffer::Instance& data) -> void {
+    EXPECT_EQ("ab", TestUtility::bufferToString(data));
+    data.drain(data.length());
+  }));
+  flush_timer_->callback_();
+
+  EXPECT_CALL(*upstream_connection_, close(Network::ConnectionCloseType::NoFlush));
+  EXPECT_CALL(callbacks1, onFailure());
+  EXPECT_CALL(callbacks2, onFailure());
+  EXPECT_CALL(*connect_or_op_timer_, disableTimer());
+  client_->close();
+}
+
+class ConfigSmallBuffer : public Config {
+  bool disableOutlierEvents() const override { return false; }
+  std::chrono::milliseconds opTimeout() const override { return std::chrono::milliseconds(25); }
+  uint32_t maxBufferSizeBeforeFlush() const override { return 3; }
+};
+
+TEST_F(RedisClientImplTest, FlushOnBufferSize) {
+  InSequence s;
+
+  setup(std::make_unique<ConfigSmallBuffer>());
+
+  RespValue request1;
+  MockPoolCallbacks callbacks1;
+  EXPECT_CALL(*encoder_, encode(Ref(request1), _))
+      .WillOnce(Invoke([](const RespValue&, Buffer::Instance& out) -> void { out.add("ab"); }));
+  EXPECT_CALL(*flush_timer_, enableTimer(std::chrono::milliseconds(0)));
+  client_->makeRequest(request1, callbacks1);
+
+  onConnected();
+
+  // Reaching the buffer size writes the requests right away.
+  RespValue request2;
+  MockPoolCallbacks callbacks2;
+  EXPECT_CALL(*encoder_, encode(Ref(request2), _))
+      .WillOnce(Invoke([](const RespValue&, Buffer::Instance& out) -> void { out.add("cd"); }));
+  EXPECT_CALL(*flush_timer_, disableTimer());
+  EXPECT_CALL(host_->cluster_.stats_store_,
+              deliverHistogramToSinks(
+                  Property(&Stats::Metric::name, "upstream_redis_commands_per_write"), 2));
+  EXPECT_CALL(*upstream_connection_, write(_)).WillOnce(Invoke([](Buffer::Instance& data) -> void {
+    EXPECT_EQ("abcd", TestUtility::bufferToString(data));
+    data.drain(data.length());
+  }));
+  client_->makeRequest(request2, callbacks2);
+
+  // Requests which have not been written when the connection closes are dropped.
+  RespValue request3;
+  MockPoolCallbacks callbacks3;
+  EXPECT_CALL(*encoder_, encode(Ref(request3), _))
+      .WillOnce(Invoke([](const RespValue&, Buffer::Instance& out) -> void { out.add("e"); }));
+  EXPECT_CALL(*flush_timer_, enableTimer(std::chrono::milliseconds(0)));
+  client_->makeRequest(request3, callbacks3);
+
+  EXPECT_CALL(*upstream_connection_, close(Network::ConnectionCloseType::NoFlush));
+  EXPECT_CALL(callbacks1, onFailure());
+  EXPECT_CALL(callbacks2, onFailure());
+  EXPECT_CALL(callbacks3, onFailure());
+  EXPECT_CALL(*connect_or_op_timer_, disableTimer());
+  EXPECT_CALL(*flush_timer_, disableTimer());
+  client_->close();
+}
+
 TEST(RedisClientFactoryImplTest, Basic) {
   ClientFactoryImpl factory;
   Upstream::MockHost::MockCreateConnectionData conn_info;
@@ -369,8 +471,11 @@ TEST(RedisClientFactoryImplTest, Basic) {
 
 class RedisConnPoolImplTest : public testing::Test, public ClientFactory {
 public:
-  RedisConnPoolImplTest() {
-    conn_pool_.reset(new InstanceImpl(cluster_name_, cm_, *this, tls_, createConnPoolSettings()));
+  RedisConnPoolImplTest() { createConnPool(); }
+
+  void createConnPool() {
+    conn_pool_.reset(
+        new InstanceImpl(cluster_name_, cm_, *this, tls_, runtime_, createConnPoolSettings()));
   }
 
   // Redis::ConnPool::ClientFactory
@@ -380,10 +485,21 @@ public:
 
   MOCK_METHOD1(create_, Client*(Upstream::HostConstSharedPtr host));
 
+  // The first request is preceded by CLUSTER SLOTS, to find out whether the upstream is a Redis
+  // Cluster.
+  void expectClusterSlots(MockClient* client) {
+    EXPECT_CALL(*client, makeRequest(Eq(ByRef(ClusterSlots::slotsRequest())), _))
+        .WillOnce(DoAll(WithArg<1>(SaveArgAddress(&cluster_slots_callbacks_)),
+                        Return(&cluster_slots_request_)));
+  }
+
   const std::string cluster_name_{"foo"};
   NiceMock<Upstream::MockClusterManager> cm_;
   NiceMock<ThreadLocal::MockInstance> tls_;
+  NiceMock<Runtime::MockLoader> runtime_;
   InstancePtr conn_pool_;
+  MockPoolRequest cluster_slots_request_;
+  PoolCallbacks* cluster_slots_callbacks_{};
 };
 
 TEST_F(RedisConnPoolImplTest, Basic) {
@@ -400,6 +516,7 @@ TEST_F(RedisConnPoolImplTest, Basic) {
         return cm_.thread_local_cluster_.lb_.host_;
       }));
   EXPECT_CALL(*this, create_(_)).WillOnce(Return(client));
+  expectClusterSlots(client);
   EXPECT_CALL(*client, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
   PoolRequest* request = conn_pool_->makeRequest("foo", value, callbacks);
   EXPECT_EQ(&active_request, request);
@@ -408,6 +525,34 @@ TEST_F(RedisConnPoolImplTest, Basic) {
   tls_.shutdownThread();
 };
 
+TEST_F(RedisConnPoolImplTest, ChooseHostAndMakeRequestToHost) {
+  InSequence s;
+
+  RespValue value;
+  MockPoolRequest active_request;
+  MockPoolCallbacks callbacks;
+  MockClient* client = new NiceMock<MockClient>();
+
+  EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_))
+      .WillOnce(Invoke([&](Upstream::LoadBalancerContext* context) -> Upstream::HostConstSharedPtr {
+        EXPECT_EQ(context->computeHashKey().value(), std::hash<std::string>()("foo"));
+        return cm_.thread_local_cluster_.lb_.host_;
+      }));
+  Upstream::HostConstSharedPtr host = conn_pool_->chooseHost("foo");
+  EXPECT_EQ(cm_.thread_local_cluster_.lb_.host_, host);
+
+  // Requests to the same host share its client.
+  EXPECT_CALL(*this, create_(Eq(host))).WillOnce(Return(client));
+  expectClusterSlots(client);
+  EXPECT_CALL(*client, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeRequestToHost(host, value, callbacks));
+  EXPECT_CALL(*client, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeRequestToHost(host, value, callbacks));
+
+  EXPECT_CALL(*client, close());
+  tls_.shutdownThread();
+};
+
 TEST_F(RedisConnPoolImplTest, HostRemove) {
   InSequence s;
   MockPoolCallbacks callbacks;
@@ -420,6 +565,7 @@ TEST_F(RedisConnPoolImplTest, HostRemove) {
 
   EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_)).WillOnce(Return(host1));
   EXPECT_CALL(*this, create_(Eq(host1))).WillOnce(Return(client1));
+  expectClusterSlots(client1);
 
   MockPoolRequest active_request1;
   EXPECT_CALL(*client1, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request1));
@@ -441,6 +587,89 @@ TEST_F(RedisConnPoolImplTest, HostRemove) {
   tls_.shutdownThread();
 }
 
+// Requests go to the connections of a host in turn, the first ones opening them. All of them are
+// closed when the host is removed.
+TEST_F(RedisConnPoolImplTest, ConnectionsPerHost) {
+  ON_CALL(runtime_.snapshot_, getInteger("redis.connections_per_host", 1)).WillByDefault(Return(2));
+  createConnPool();
+  InSequence s;
+
+  RespValue value;
+  MockPoolCallbacks callbacks;
+  MockPoolRequest active_request;
+  std::shared_ptr<Upstream::Host> host(new Upstream::MockHost());
+  MockClient* client1 = new NiceMock<MockClient>();
+  MockClient* client2 = new NiceMock<MockClient>();
+
+  // CLUSTER SLOTS opens the first connection, and the request itself the second one.
+  EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_)).WillOnce(Return(host));
+  EXPECT_CALL(*this, create_(Eq(host))).WillOnce(Return(client1));
+  expectClusterSlots(client1);
+  EXPECT_CALL(*this, create_(Eq(host))).WillOnce(Return(client2));
+  EXPECT_CALL(*client2, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeRequest("foo", value, callbacks));
+
+  for (MockClient* client : {client1, client2, client1}) {
+    EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_)).WillOnce(Return(host));
+    EXPECT_CALL(*client, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+    EXPECT_EQ(&active_request, conn_pool_->makeRequest("foo", value, callbacks));
+  }
+
+  EXPECT_CALL(*client1, close());
+  EXPECT_CALL(*client2, close());
+  cm_.thread_local_cluster_.cluster_.prioritySet().getMockHostSet(0)->runCallbacks({}, {host});
+
+  tls_.shutdownThread();
+}
+
+// With least outstanding requests selection, a connection is only opened when all the others have
+// outstanding requests, and requests go to the least loaded one.
+TEST_F(RedisConnPoolImplTest, LeastOutstandingRequests) {
+  ON_CALL(runtime_.snapshot_, getInteger("redis.connections_per_host", 1)).WillByDefault(Return(2));
+  ON_CALL(runtime_.snapshot_, getInteger("redis.least_outstanding_requests", 0))
+      .WillByDefault(Return(1));
+  createConnPool();
+
+  RespValue value;
+  MockPoolCallbacks callbacks;
+  MockPoolRequest active_request;
+  std::shared_ptr<Upstream::Host> host(new Upstream::MockHost());
+  MockClient* client1 = new NiceMock<MockClient>();
+  MockClient* client2 = new NiceMock<MockClient>();
+  ON_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_)).WillByDefault(Return(host));
+
+  EXPECT_CALL(*this, create_(Eq(host))).WillOnce(Return(client1));
+  expectClusterSlots(client1);
+  EXPECT_CALL(*client1, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeRequest("foo", value, callbacks));
+
+  // The first connection is busy, so the second one is opened.
+  EXPECT_CALL(*client1, outstandingRequests()).WillRepeatedly(Return(2));
+  EXPECT_CALL(*this, create_(Eq(host))).WillOnce(Return(client2));
+  EXPECT_CALL(*client2, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeRequest("foo", value, callbacks));
+
+  EXPECT_CALL(*client2, outstandingRequests()).WillRepeatedly(Return(3));
+  EXPECT_CALL(*client1, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeRequest("foo", value, callbacks));
+
+  EXPECT_CALL(*client2, outstandingRequests()).WillRepeatedly(Return(1));
+  EXPECT_CALL(*client2, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeRequest("foo", value, callbacks));
+
+  // A closed connection is removed, and opened again by the next request.
+  EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+  client1->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  MockClient* client3 = new NiceMock<MockClient>();
+  EXPECT_CALL(*this, create_(Eq(host))).WillOnce(Return(client3));
+  EXPECT_CALL(*client3, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeRequest("foo", value, callbacks));
+
+  EXPECT_CALL(*client2, close());
+  EXPECT_CALL(*client3, close());
+  tls_.shutdownThread();
+}
+
 TEST_F(RedisConnPoolImplTest, DeleteFollowedByClusterUpdateCallback) {
   conn_pool_.reset();
 
@@ -470,6 +699,7 @@ TEST_F(RedisConnPoolImplTest, RemoteClose) {
 
   EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_));
   EXPECT_CALL(*this, create_(_)).WillOnce(Return(client));
+  expectClusterSlots(client);
   EXPECT_CALL(*client, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
   conn_pool_->makeRequest("foo", value, callbacks);
 
@@ -479,6 +709,247 @@ TEST_F(RedisConnPoolImplTest, RemoteClose) {
   tls_.shutdownThread();
 }
 
+TEST_F(RedisConnPoolImplTest, NotRedisCluster) {
+  InSequence s;
+
+  RespValue value;
+  MockPoolRequest active_request;
+  MockPoolCallbacks callbacks;
+  MockClient* client = new NiceMock<MockClient>();
+
+  EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_));
+  EXPECT_CALL(*this, create_(_)).WillOnce(Return(client));
+  expectClusterSlots(client);
+  EXPECT_CALL(*client, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  conn_pool_->makeRequest("foo", value, callbacks);
+
+  RespValuePtr error(new RespValue());
+  error->type(RespType::Error);
+  error->asString() = "ERR This instance has cluster support disabled";
+  cluster_slots_callbacks_->onResponse(std::move(error));
+  EXPECT_FALSE(conn_pool_->hashSlot("foo").valid());
+
+  // Requests are sent as they are from now on.
+  EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_));
+  EXPECT_CALL(*client, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeRequest("foo", value, callbacks));
+
+  EXPECT_CALL(*client, close());
+  tls_.shutdownThread();
+}
+
+class RedisConnPoolClusterTest : public RedisConnPoolImplTest {
+public:
+  RedisConnPoolClusterTest() {
+    for (const std::string address : {"10.0.0.1:6379", "10.0.0.2:6379"}) {
+      std::shared_ptr<Upstream::MockHost> host(new NiceMock<Upstream::MockHost>());
+      ON_CALL(*host, address())
+          .WillByDefault(Return(Network::Utility::resolveUrl("tcp://" + address)));
+      hosts_.push_back(host);
+    }
+    cm_.thread_local_cluster_.cluster_.prioritySet().getMockHostSet(0)->hosts_ = {hosts_[0],
+                                                                                hosts_[1]};
+
+    value_.type(RespType::Array);
+    std::vector<RespValue> values(2);
+    values[0].type(RespType::BulkString);
+    values[0].asString() = "get";
+    values[1].type(RespType::BulkString);
+    values[1].asString() = "foo";
+    value_.asArray().swap(values);
+  }
+
+  MockClient* expectCreate(uint32_t host_index) {
+    clients_[host_index] = new NiceMock<MockClient>();
+    EXPECT_CALL(*this, create_(Eq(hosts_[host_index]))).WillOnce(Return(clients_[host_index]));
+    return clients_[host_index];
+  }
+
+  void expectRequest(uint32_t host_index) {
+    EXPECT_CALL(*clients_[host_index], makeRequest(Eq(ByRef(value_)), _))
+        .WillOnce(DoAll(WithArg<1>(SaveArgAddress(&client_callbacks_)), Return(&client_request_)));
+  }
+
+  /**
+   * Make the first request, which finds out that the upstream is a Redis Cluster whose first node
+   * serves slots 0-8191 and whose second node serves slots 8192-16383.
+   */
+  void discoverSlots() {
+    EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_)).WillOnce(Return(hosts_[0]));
+    expectCreate(0);
+    expectClusterSlots(clients_[0]);
+    EXPECT_CALL(*clients_[0], makeRequest(Ref(value_), Ref(callbacks_)))
+        .WillOnce(Return(&client_request_));
+    EXPECT_EQ(&client_request_, conn_pool_->makeRequest("foo", value_, callbacks_));
+
+    RespValuePtr slots(new RespValue());
+    slots->type(RespType::Array);
+    std::vector<RespValue> ranges(2);
+    for (uint32_t i = 0; i < ranges.size(); i++) {
+      std::vector<RespValue> range(3);
+      range[0].type(RespType::Integer);
+      range[0].asInteger() = i * 8192;
+      range[1].type(RespType::Integer);
+      range[1].asInteger() = i * 8192 + 8191;
+      std::vector<RespValue> master(2);
+      master[0].type(RespType::BulkString);
+      master[0].asString() = fmt::format("10.0.0.{}", i + 1);
+      master[1].type(RespType::Integer);
+      master[1].asInteger() = 6379;
+      range[2].type(RespType::Array);
+      range[2].asArray().swap(master);
+      ranges[i].type(RespType::Array);
+      ranges[i].asArray().swap(range);
+    }
+    slots->asArray().swap(ranges);
+    cluster_slots_callbacks_->onResponse(std::move(slots));
+  }
+
+  static RespValuePtr makeError(const std::string& message) {
+    RespValuePtr error(new RespValue());
+    error->type(RespType::Error);
+    error->asString() = message;
+    return error;
+  }
+
+  void shutdown(uint32_t num_clients) {
+    EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_)).Times(num_clients);
+    tls_.shutdownThread();
+  }
+
+  std::vector<Upstream::HostSharedPtr> hosts_;
+  MockClient* clients_[2]{};
+  RespValue value_;
+  MockPoolCallbacks callbacks_;
+  MockPoolRequest client_request_;
+  PoolCallbacks* client_callbacks_{};
+};
+
+TEST_F(RedisConnPoolClusterTest, RouteBySlot) {
+  InSequence s;
+
+  discoverSlots();
+  // "foo" is in slot 12182 and "bar" in slot 5061.
+  EXPECT_EQ(12182, conn_pool_->hashSlot("foo").value());
+  EXPECT_EQ(hosts_[1], conn_pool_->chooseHost("foo"));
+  EXPECT_EQ(hosts_[0], conn_pool_->chooseHost("bar"));
+
+  // Requests are made through a handle of their own, so that they can be redirected.
+  expectCreate(1);
+  expectRequest(1);
+  PoolRequest* request = conn_pool_->makeRequest("foo", value_, callbacks_);
+  EXPECT_NE(nullptr, request);
+  EXPECT_NE(&client_request_, request);
+
+  RespValue response;
+  response.type(RespType::SimpleString);
+  response.asString() = "OK";
+  EXPECT_CALL(callbacks_, onResponse_(Pointee(Eq(ByRef(response)))));
+  EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+  RespValuePtr response_ptr(new RespValue(response));
+  client_callbacks_->onResponse(std::move(response_ptr));
+
+  // The keys of a removed master are routed by consistent hashing, and the slot map is refreshed
+  // with the next request.
+  EXPECT_CALL(*clients_[1], close());
+  EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+  cm_.thread_local_cluster_.cluster_.prioritySet().getMockHostSet(0)->runCallbacks({},
+                                                                                   {hosts_[1]});
+  EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_)).WillOnce(Return(hosts_[0]));
+  expectClusterSlots(clients_[0]);
+  expectRequest(0);
+  conn_pool_->makeRequest("foo", value_, callbacks_);
+
+  shutdown(1);
+}
+
+TEST_F(RedisConnPoolClusterTest, Moved) {
+  InSequence s;
+
+  discoverSlots();
+  expectCreate(1);
+  expectRequest(1);
+  conn_pool_->makeRequest("foo", value_, callbacks_);
+
+  // The slot moves at once, the slot map is refreshed and the request is sent again.
+  expectClusterSlots(clients_[0]);
+  expectRequest(0);
+  client_callbacks_->onResponse(makeError("MOVED 12182 10.0.0.1:6379"));
+  EXPECT_EQ(hosts_[0], conn_pool_->chooseHost("foo"));
+
+  RespValue response;
+  EXPECT_CALL(callbacks_, onResponse_(Pointee(Eq(ByRef(response)))));
+  EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+  client_callbacks_->onResponse(RespValuePtr{new RespValue()});
+
+  shutdown(2);
+}
+
+TEST_F(RedisConnPoolClusterTest, Ask) {
+  InSequence s;
+
+  discoverSlots();
+  expectRequest(0);
+  conn_pool_->makeRequest("bar", value_, callbacks_);
+
+  // The request is sent again after ASKING, without changing the slot map.
+  expectCreate(1);
+  EXPECT_CALL(*clients_[1], makeRequest(Eq(ByRef(ClusterSlots::askingRequest())), _));
+  expectRequest(1);
+  client_callbacks_->onResponse(makeError("ASK 5061 10.0.0.2:6379"));
+  EXPECT_EQ(hosts_[0], conn_pool_->chooseHost("bar"));
+
+  // Only one redirection is followed.
+  RespValuePtr redirection = makeError("ASK 5061 10.0.0.1:6379");
+  EXPECT_CALL(callbacks_, onResponse_(Pointee(Eq(ByRef(*redirection)))));
+  EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+  client_callbacks_->onResponse(makeError("ASK 5061 10.0.0.1:6379"));
+
+  shutdown(2);
+}
+
+TEST_F(RedisConnPoolClusterTest, RedirectionToUnknownNode) {
+  InSequence s;
+
+  discoverSlots();
+  expectRequest(0);
+  conn_pool_->makeRequest("bar", value_, callbacks_);
+
+  EXPECT_CALL(callbacks_, onResponse_(_));
+  EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+  client_callbacks_->onResponse(makeError("MOVED 5061 10.0.0.3:6379"));
+
+  shutdown(1);
+}
+
+TEST_F(RedisConnPoolClusterTest, Failure) {
+  InSequence s;
+
+  discoverSlots();
+  expectRequest(0);
+  conn_pool_->makeRequest("bar", value_, callbacks_);
+
+  EXPECT_CALL(callbacks_, onFailure());
+  EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+  client_callbacks_->onFailure();
+
+  shutdown(1);
+}
+
+TEST_F(RedisConnPoolClusterTest, Cancel) {
+  InSequence s;
+
+  discoverSlots();
+  expectRequest(0);
+  PoolRequest* request = conn_pool_->makeRequest("bar", value_, callbacks_);
+
+  EXPECT_CALL(client_request_, cancel());
+  EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+  request->cancel();
+
+  shutdown(1);
+}
+
 } // namespace ConnPool
 } // namespace Redis
 } // namespace Envoy
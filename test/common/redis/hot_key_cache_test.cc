@@ -0,0 +1,196 @@
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "common/redis/hot_key_cache.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/redis/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+using testing::ReturnPointee;
+using testing::ReturnRef;
+using testing::_;
+
+namespace Envoy {
+namespace Redis {
+
+TEST(RedisCountMinSketchTest, Estimates) {
+  CountMinSketch sketch(64, 4);
+  for (uint32_t i = 1; i <= 10; i++) {
+    EXPECT_LE(i, sketch.add("hot"));
+  }
+  for (uint32_t i = 0; i < 100; i++) {
+    sketch.add(std::to_string(i));
+  }
+
+  // Estimates are never too low, and the key which occurs most stands out.
+  EXPECT_LE(10U, sketch.estimate("hot"));
+  EXPECT_LE(1U, sketch.estimate("5"));
+  EXPECT_GT(sketch.estimate("hot"), sketch.estimate("5"));
+
+  sketch.clear();
+  EXPECT_EQ(0U, sketch.estimate("hot"));
+  EXPECT_EQ(1U, sketch.add("hot"));
+}
+
+class RedisHotKeyCacheTest : public testing::Test {
+public:
+  RedisHotKeyCacheTest() {
+    ON_CALL(runtime_.snapshot_, get("redis.hot_key_cache.prefixes"))
+        .WillByDefault(ReturnRef(prefixes_));
+    ON_CALL(time_source_, currentTime()).WillByDefault(ReturnPointee(&now_));
+    cache_.reset(new HotKeyCache(tls_, runtime_, time_source_, store_, "redis.foo."));
+  }
+
+  static RespValue makeBulkString(const std::string& string) {
+    RespValue value;
+    value.type(RespType::BulkString);
+    value.asString() = string;
+    return value;
+  }
+
+  static RespValue makeRequest(const std::vector<std::string>& strings) {
+    RespValue value;
+    value.type(RespType::Array);
+    for (const std::string& string : strings) {
+      value.asArray().push_back(makeBulkString(string));
+    }
+    return value;
+  }
+
+  // Update the runtime snapshot, so that the settings are read again.
+  void setRuntimeVersion(uint64_t version) {
+    ON_CALL(runtime_.snapshot_, version()).WillByDefault(Return(version));
+  }
+
+  uint64_t counter(const std::string& name) {
+    return store_.counter("redis.foo.hot_keys." + name).value();
+  }
+
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<MockMonotonicTimeSource> time_source_;
+  Stats::IsolatedStoreImpl store_;
+  std::string prefixes_{"hot:,warm:"};
+  MonotonicTime now_;
+  HotKeyCachePtr cache_;
+};
+
+TEST_F(RedisHotKeyCacheTest, HitAndExpiry) {
+  HotKeyCache::Lookup lookup = cache_->lookup("hot:1");
+  EXPECT_EQ(nullptr, lookup.response_);
+  EXPECT_TRUE(lookup.cacheable_);
+  cache_->insert("hot:1", makeBulkString("value"), lookup.generation_);
+
+  lookup = cache_->lookup("hot:1");
+  ASSERT_NE(nullptr, lookup.response_);
+  EXPECT_EQ(makeBulkString("value"), *lookup.response_);
+  EXPECT_EQ(1UL, counter("cache_hit"));
+  EXPECT_EQ(1UL, counter("cache_miss"));
+
+  // The response expires after the default TTL of 100ms.
+  now_ += std::chrono::milliseconds(99);
+  EXPECT_NE(nullptr, cache_->lookup("hot:1").response_);
+  now_ += std::chrono::milliseconds(1);
+  EXPECT_EQ(nullptr, cache_->lookup("hot:1").response_);
+  EXPECT_EQ(2UL, counter("cache_miss"));
+}
+
+TEST_F(RedisHotKeyCacheTest, NotCacheable) {
+  HotKeyCache::Lookup lookup = cache_->lookup("cold:1");
+  EXPECT_EQ(nullptr, lookup.response_);
+  EXPECT_FALSE(lookup.cacheable_);
+  cache_->insert("cold:1", makeBulkString("value"), lookup.generation_);
+  EXPECT_EQ(nullptr, cache_->lookup("cold:1").response_);
+  EXPECT_EQ(0UL, counter("cache_miss"));
+
+  // Only bulk strings and nulls are cached.
+  RespValue error;
+  error.type(RespType::Error);
+  error.asString() = "error";
+  cache_->insert("hot:1", error, lookup.generation_);
+  EXPECT_EQ(nullptr, cache_->lookup("hot:1").response_);
+  cache_->insert("warm:1", RespValue(), lookup.generation_);
+  EXPECT_EQ(RespValue(), *cache_->lookup("warm:1").response_);
+}
+
+TEST_F(RedisHotKeyCacheTest, Invalidation) {
+  HotKeyCache::Lookup lookup = cache_->lookup("hot:1");
+  cache_->insert("hot:1", makeBulkString("value"), lookup.generation_);
+  cache_->invalidate(makeRequest({"set", "hot:1", "other"}));
+  EXPECT_EQ(1UL, counter("cache_invalidation"));
+  lookup = cache_->lookup("hot:1");
+  EXPECT_EQ(nullptr, lookup.response_);
+
+  // A response to a GET which was outstanding when the key was written isn't cached.
+  cache_->invalidate(makeRequest({"del", "cold:1", "hot:1"}));
+  cache_->insert("hot:1", makeBulkString("value"), lookup.generation_);
+  EXPECT_EQ(nullptr, cache_->lookup("hot:1").response_);
+
+  // Writes to keys which aren't cached don't get in the way.
+  lookup = cache_->lookup("hot:1");
+  cache_->invalidate(makeRequest({"set", "cold:1", "other"}));
+  cache_->insert("hot:1", makeBulkString("value"), lookup.generation_);
+  EXPECT_NE(nullptr, cache_->lookup("hot:1").response_);
+  EXPECT_EQ(1UL, counter("cache_invalidation"));
+}
+
+TEST_F(RedisHotKeyCacheTest, LeastRecentlyUsedEvicted) {
+  ON_CALL(runtime_.snapshot_, getInteger("redis.hot_key_cache.max_entries", 1024))
+      .WillByDefault(Return(2));
+  for (const std::string key : {"hot:1", "hot:2"}) {
+    cache_->insert(key, makeBulkString(key), cache_->lookup(key).generation_);
+  }
+  EXPECT_NE(nullptr, cache_->lookup("hot:1").response_);
+
+  cache_->insert("hot:3", makeBulkString("hot:3"), cache_->lookup("hot:3").generation_);
+  EXPECT_EQ(1UL, counter("cache_eviction"));
+  EXPECT_NE(nullptr, cache_->lookup("hot:1").response_);
+  EXPECT_EQ(nullptr, cache_->lookup("hot:2").response_);
+  EXPECT_NE(nullptr, cache_->lookup("hot:3").response_);
+}
+
+TEST_F(RedisHotKeyCacheTest, RuntimeUpdate) {
+  cache_->insert("hot:1", makeBulkString("value"), cache_->lookup("hot:1").generation_);
+  cache_->insert("warm:1", makeBulkString("value"), cache_->lookup("warm:1").generation_);
+
+  // Responses for keys which are no longer cacheable are dropped.
+  prefixes_ = "warm:";
+  setRuntimeVersion(1);
+  EXPECT_FALSE(cache_->lookup("hot:1").cacheable_);
+  EXPECT_NE(nullptr, cache_->lookup("warm:1").response_);
+
+  prefixes_ = "";
+  setRuntimeVersion(2);
+  EXPECT_EQ(nullptr, cache_->lookup("warm:1").response_);
+  EXPECT_FALSE(cache_->lookup("warm:1").cacheable_);
+}
+
+TEST_F(RedisHotKeyCacheTest, Detection) {
+  ON_CALL(runtime_.snapshot_, getInteger("redis.hot_key_detection.threshold", 0))
+      .WillByDefault(Return(3));
+  for (uint32_t i = 0; i < 5; i++) {
+    cache_->lookup("cold:1");
+  }
+  cache_->lookup("cold:2");
+  EXPECT_EQ(1UL, counter("detected"));
+
+  // Counts start over each second.
+  now_ += std::chrono::seconds(1);
+  cache_->lookup("cold:1");
+  cache_->lookup("cold:1");
+  EXPECT_EQ(1UL, counter("detected"));
+  cache_->lookup("cold:1");
+  EXPECT_EQ(2UL, counter("detected"));
+}
+
+} // namespace Redis
+} // namespace Envoy
@@ -0,0 +1,133 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "common/http/header_map_impl.h"
+#include "common/router/config_impl.h"
+
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+
+#include "benchmark/benchmark.h"
+#include "fmt/format.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Router {
+
+/**
+ * Generate a route configuration with a single virtual host containing num_routes routes. Even
+ * routes are prefix routes and odd routes are exact path routes so both matchers are exercised.
+ */
+static envoy::api::v2::RouteConfiguration makeRouteConfig(size_t num_routes) {
+  envoy::api::v2::RouteConfiguration route_config;
+  auto* virtual_host = route_config.add_virtual_hosts();
+  virtual_host->set_name("benchmark");
+  virtual_host->add_domains("*");
+  for (size_t i = 0; i < num_routes; i++) {
+    auto* route = virtual_host->add_routes();
+    if (i % 2 == 0) {
+      route->mutable_match()->set_prefix(fmt::format("/prefix/{}/", i));
+    } else {
+      route->mutable_match()->set_path(fmt::format("/path/{}", i));
+    }
+    route->mutable_route()->set_cluster(fmt::format("cluster_{}", i));
+  }
+  return route_config;
+}
+
+// Matching a request against the last route in the table, which is the worst case for the linear
+// route scan.
+static void RouteMatcherLastRoute(benchmark::State& state) {
+  const size_t num_routes = state.range(0);
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  ConfigImpl config(makeRouteConfig(num_routes), runtime, cm, false);
+  const size_t last_prefix_route = (num_routes - 1) / 2 * 2;
+  Http::HeaderMapImpl headers{
+      {Http::Headers::get().Host, "www.example.com"},
+      {Http::Headers::get().Path, fmt::format("/prefix/{}/some/resource", last_prefix_route)},
+      {Http::Headers::get().Method, "GET"}};
+
+  size_t matched = 0;
+  while (state.KeepRunning()) {
+    matched += config.route(headers, 0) != nullptr;
+  }
+  benchmark::DoNotOptimize(matched);
+}
+BENCHMARK(RouteMatcherLastRoute)->Arg(1)->Arg(10)->Arg(100)->Arg(1000)->Arg(5000);
+
+// A request which matches no route at all.
+static void RouteMatcherNoMatch(benchmark::State& state) {
+  const size_t num_routes = state.range(0);
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  ConfigImpl config(makeRouteConfig(num_routes), runtime, cm, false);
+  Http::HeaderMapImpl headers{{Http::Headers::get().Host, "www.example.com"},
+                              {Http::Headers::get().Path, "/does/not/exist"},
+                              {Http::Headers::get().Method, "GET"}};
+
+  size_t matched = 0;
+  while (state.KeepRunning()) {
+    matched += config.route(headers, 0) != nullptr;
+  }
+  benchmark::DoNotOptimize(matched);
+}
+BENCHMARK(RouteMatcherNoMatch)->Arg(1)->Arg(10)->Arg(100)->Arg(1000)->Arg(5000);
+
+// Header matchers as used by header-based canary routes, range(0) selecting an exact value, a
+// regex compiled into a prefix comparison, and a regex which is run.
+static envoy::api::v2::HeaderMatcher makeHeaderMatcher(int64_t type) {
+  envoy::api::v2::HeaderMatcher header_matcher;
+  header_matcher.set_name("x-canary-group");
+  header_matcher.set_value(type == 0 ? "beta-testers" : type == 1 ? "beta-.*" : "beta-[a-z]+");
+  header_matcher.mutable_regex()->set_value(type != 0);
+  return header_matcher;
+}
+
+static void HeaderMatcher(benchmark::State& state) {
+  const std::vector<ConfigUtility::HeaderData> header_data{
+      ConfigUtility::HeaderData(makeHeaderMatcher(state.range(0)))};
+  Http::HeaderMapImpl headers{{Http::Headers::get().Host, "www.example.com"},
+                              {Http::Headers::get().Path, "/some/resource"},
+                              {Http::Headers::get().Method, "GET"},
+                              {Http::Headers::get().UserAgent, "benchmark"},
+                              {Http::LowerCaseString("x-canary-group"), "beta-testers"}};
+
+  size_t matched = 0;
+  while (state.KeepRunning()) {
+    matched += ConfigUtility::matchHeaders(headers, header_data);
+  }
+  benchmark::DoNotOptimize(matched);
+}
+BENCHMARK(HeaderMatcher)->Arg(0)->Arg(1)->Arg(2);
+
+// The same matches as HeaderMatcher, always running the regex as header matchers used to.
+static void HeaderMatcherStdRegex(benchmark::State& state) {
+  const envoy::api::v2::HeaderMatcher header_matcher = makeHeaderMatcher(state.range(0));
+  const Http::LowerCaseString name(header_matcher.name());
+  const std::string value = header_matcher.value();
+  const std::regex regex(value, std::regex::optimize);
+  const bool is_regex = header_matcher.regex().value();
+  Http::HeaderMapImpl headers{{Http::Headers::get().Host, "www.example.com"},
+                              {Http::Headers::get().Path, "/some/resource"},
+                              {Http::Headers::get().Method, "GET"},
+                              {Http::Headers::get().UserAgent, "benchmark"},
+                              {Http::LowerCaseString("x-canary-group"), "beta-testers"}};
+
+  size_t matched = 0;
+  while (state.KeepRunning()) {
+    const Http::HeaderEntry* header = headers.get(name);
+    matched += header != nullptr && (is_regex ? std::regex_match(header->value().c_str(), regex)
+                                              : header->value() == value.c_str());
+  }
+  benchmark::DoNotOptimize(matched);
+}
+BENCHMARK(HeaderMatcherStdRegex)->Arg(0)->Arg(1)->Arg(2);
+
+} // namespace Router
+} // namespace Envoy
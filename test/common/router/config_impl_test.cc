@@ -2,7 +2,9 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <regex>
 #include <string>
+#include <tuple>
 
 #include "common/config/metadata.h"
 #include "common/config/rds_json.h"
@@ -1296,6 +1298,91 @@ TEST_F(RouterMatcherHashPolicyTest, InvalidHashPolicies) {
   }
 }
 
+// Indexed (path only) routes and unindexed (header, regex, case insensitive) routes must still be
+// matched in configuration order.
+TEST(RouteMatcherTest, IndexedAndUnindexedRouteOrdering) {
+  std::string json = R"EOF(
+{
+  "virtual_hosts": [
+    {
+      "name": "local_service",
+      "domains": ["*"],
+      "routes": [
+        {
+          "path": "/exact",
+          "cluster": "exact"
+        },
+        {
+          "prefix": "/foo",
+          "cluster": "foo_with_header",
+          "headers" : [
+            {"name": "test_header", "value": "test"}
+          ]
+        },
+        {
+          "prefix": "/foo/bar",
+          "cluster": "foo_bar"
+        },
+        {
+          "regex": "/foo/.*",
+          "cluster": "foo_regex"
+        },
+        {
+          "prefix": "/FOO",
+          "case_sensitive": false,
+          "cluster": "foo_case_insensitive"
+        },
+        {
+          "prefix": "/foo",
+          "cluster": "foo"
+        },
+        {
+          "prefix": "/exact",
+          "cluster": "exact_prefix"
+        },
+        {
+          "prefix": "/",
+          "cluster": "default"
+        }
+      ]
+    }
+  ]
+}
+  )EOF";
+
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  ConfigImpl config(parseRouteConfigurationFromJson(json), runtime, cm, true);
+
+  EXPECT_EQ("exact", config.route(genHeaders("www.lyft.com", "/exact", "GET"), 0)
+                         ->routeEntry()
+                         ->clusterName());
+  EXPECT_EQ("exact", config.route(genHeaders("www.lyft.com", "/exact?a=b", "GET"), 0)
+                         ->routeEntry()
+                         ->clusterName());
+  EXPECT_EQ("exact_prefix", config.route(genHeaders("www.lyft.com", "/exact/more", "GET"), 0)
+                                ->routeEntry()
+                                ->clusterName());
+  EXPECT_EQ("foo_bar", config.route(genHeaders("www.lyft.com", "/foo/bar/baz", "GET"), 0)
+                           ->routeEntry()
+                           ->clusterName());
+  EXPECT_EQ("foo_regex", config.route(genHeaders("www.lyft.com", "/foo/baz", "GET"), 0)
+                             ->routeEntry()
+                             ->clusterName());
+  EXPECT_EQ("foo_case_insensitive", config.route(genHeaders("www.lyft.com", "/foo", "GET"), 0)
+                                        ->routeEntry()
+                                        ->clusterName());
+  EXPECT_EQ("default", config.route(genHeaders("www.lyft.com", "/bar", "GET"), 0)
+                           ->routeEntry()
+                           ->clusterName());
+
+  {
+    Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo/bar", "GET");
+    headers.addCopy("test_header", "test");
+    EXPECT_EQ("foo_with_header", config.route(headers, 0)->routeEntry()->clusterName());
+  }
+}
+
 TEST(RouteMatcherTest, ClusterHeader) {
   std::string json = R"EOF(
 {
@@ -2113,6 +2200,62 @@ TEST(RouteMatcherTest, ExclusiveWeightedClustersEntryOrRedirectEntry) {
   }
 }
 
+TEST(RouteMatcherTest, ClusterHandles) {
+  std::string json = R"EOF(
+{
+  "virtual_hosts": [
+    {
+      "name": "www2",
+      "domains": ["www.lyft.com"],
+      "routes": [
+        {
+          "prefix": "/foo",
+          "cluster": "foo"
+        },
+        {
+          "prefix": "/bar",
+          "cluster_header": ":authority"
+        },
+        {
+          "prefix": "/",
+          "weighted_clusters": {
+            "clusters" : [
+              { "name" : "cluster1", "weight" : 50 },
+              { "name" : "cluster2", "weight" : 50 }
+            ]
+          }
+        }
+      ]
+    }
+  ]
+}
+  )EOF";
+
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  EXPECT_CALL(cm, clusterHandle("foo")).WillOnce(Return(3));
+  EXPECT_CALL(cm, clusterHandle("cluster1")).WillOnce(Return(4));
+  EXPECT_CALL(cm, clusterHandle("cluster2")).WillOnce(Return(5));
+  ConfigImpl config(parseRouteConfigurationFromJson(json), runtime, cm, true);
+
+  EXPECT_EQ(3U, config.route(genHeaders("www.lyft.com", "/foo", "GET"), 0)
+                    ->routeEntry()
+                    ->clusterHandle()
+                    .value());
+  EXPECT_FALSE(config.route(genHeaders("www.lyft.com", "/bar", "GET"), 0)
+                   ->routeEntry()
+                   ->clusterHandle()
+                   .valid());
+  EXPECT_EQ(4U, config.route(genHeaders("www.lyft.com", "/", "GET"), 0)
+                    ->routeEntry()
+                    ->clusterHandle()
+                    .value());
+  EXPECT_EQ(5U, config.route(genHeaders("www.lyft.com", "/", "GET"), 99)
+                    ->routeEntry()
+                    ->clusterHandle()
+                    .value());
+}
+
 TEST(RouteMatcherTest, WeightedClusters) {
   std::string json = R"EOF(
 {
@@ -2158,6 +2301,18 @@ TEST(RouteMatcherTest, WeightedClusters) {
   NiceMock<Upstream::MockClusterManager> cm;
   ConfigImpl config(parseRouteConfigurationFromJson(json), runtime, cm, true);
 
+  // Count the clusters selected by each random value in [0, 3 * total_weight), which selects each
+  // cluster exactly 3 * weight times.
+  auto count_clusters = [&config](const std::string& host,
+                                  uint64_t total_weight) -> std::map<std::string, uint64_t> {
+    Http::TestHeaderMapImpl headers = genHeaders(host, "/foo", "GET");
+    std::map<std::string, uint64_t> counts;
+    for (uint64_t random_value = 0; random_value < 3 * total_weight; random_value++) {
+      counts[config.route(headers, random_value)->routeEntry()->clusterName()]++;
+    }
+    return counts;
+  };
+
   {
     Http::TestHeaderMapImpl headers = genRedirectHeaders("www1.lyft.com", "/foo", true, true);
     EXPECT_EQ(nullptr, config.route(headers, 0)->redirectEntry());
@@ -2166,9 +2321,21 @@ TEST(RouteMatcherTest, WeightedClusters) {
   // Weighted Cluster with no runtime
   {
     Http::TestHeaderMapImpl headers = genHeaders("www1.lyft.com", "/foo", "GET");
-    EXPECT_EQ("cluster1", config.route(headers, 115)->routeEntry()->clusterName());
-    EXPECT_EQ("cluster2", config.route(headers, 445)->routeEntry()->clusterName());
-    EXPECT_EQ("cluster3", config.route(headers, 560)->routeEntry()->clusterName());
+    EXPECT_EQ("cluster1", config.route(headers, 0)->routeEntry()->clusterName());
+    EXPECT_EQ("cluster2", config.route(headers, 1)->routeEntry()->clusterName());
+    EXPECT_EQ("cluster3", config.route(headers, 2)->routeEntry()->clusterName());
+    // The top of the first column is aliased to the cluster with the largest weight.
+    EXPECT_EQ("cluster3", config.route(headers, 3 * 95)->routeEntry()->clusterName());
+
+    std::map<std::string, uint64_t> expected{{"cluster1", 90}, {"cluster2", 90}, {"cluster3", 120}};
+    EXPECT_EQ(expected, count_clusters("www1.lyft.com", 100));
+  }
+
+  // Runtime weights are only read again when the runtime snapshot changes.
+  {
+    EXPECT_CALL(runtime.snapshot_, getInteger("www2_weights.cluster1", 30)).Times(0);
+    std::map<std::string, uint64_t> expected{{"cluster1", 90}, {"cluster2", 90}, {"cluster3", 120}};
+    EXPECT_EQ(expected, count_clusters("www2.lyft.com", 100));
   }
 
   // Make sure weighted cluster entries call through to the parent when needed.
@@ -2186,35 +2353,49 @@ TEST(RouteMatcherTest, WeightedClusters) {
   {
     Http::TestHeaderMapImpl headers = genHeaders("www2.lyft.com", "/foo", "GET");
     EXPECT_CALL(runtime.snapshot_, featureEnabled("www2", 100, _)).WillRepeatedly(Return(true));
-    EXPECT_CALL(runtime.snapshot_, getInteger("www2_weights.cluster1", 30))
-        .WillRepeatedly(Return(80));
-    EXPECT_CALL(runtime.snapshot_, getInteger("www2_weights.cluster2", 30))
-        .WillRepeatedly(Return(10));
-    EXPECT_CALL(runtime.snapshot_, getInteger("www2_weights.cluster3", 40))
-        .WillRepeatedly(Return(10));
+    ON_CALL(runtime.snapshot_, version()).WillByDefault(Return(1));
+    EXPECT_CALL(runtime.snapshot_, getInteger("www2_weights.cluster1", 30)).WillOnce(Return(80));
+    EXPECT_CALL(runtime.snapshot_, getInteger("www2_weights.cluster2", 30)).WillOnce(Return(10));
+    EXPECT_CALL(runtime.snapshot_, getInteger("www2_weights.cluster3", 40)).WillOnce(Return(10));
+
+    EXPECT_EQ("cluster1", config.route(headers, 0)->routeEntry()->clusterName());
+    EXPECT_EQ("cluster2", config.route(headers, 1)->routeEntry()->clusterName());
+    EXPECT_EQ("cluster1", config.route(headers, 1 + 3 * 30)->routeEntry()->clusterName());
+    EXPECT_EQ("cluster3", config.route(headers, 2)->routeEntry()->clusterName());
 
-    EXPECT_EQ("cluster1", config.route(headers, 45)->routeEntry()->clusterName());
-    EXPECT_EQ("cluster2", config.route(headers, 82)->routeEntry()->clusterName());
-    EXPECT_EQ("cluster3", config.route(headers, 92)->routeEntry()->clusterName());
+    std::map<std::string, uint64_t> expected{{"cluster1", 240}, {"cluster2", 30}, {"cluster3", 30}};
+    EXPECT_EQ(expected, count_clusters("www2.lyft.com", 100));
   }
 
   // Weighted Cluster with invalid runtime values
   {
     Http::TestHeaderMapImpl headers = genHeaders("www2.lyft.com", "/foo", "GET");
     EXPECT_CALL(runtime.snapshot_, featureEnabled("www2", 100, _)).WillRepeatedly(Return(true));
-    EXPECT_CALL(runtime.snapshot_, getInteger("www2_weights.cluster1", 30))
-        .WillRepeatedly(Return(10));
+    ON_CALL(runtime.snapshot_, version()).WillByDefault(Return(2));
+    EXPECT_CALL(runtime.snapshot_, getInteger("www2_weights.cluster1", 30)).WillOnce(Return(10));
 
-    // We return an invalid value here, one that is greater than 100
-    // Expect any random value > 10 to always land in cluster2.
-    EXPECT_CALL(runtime.snapshot_, getInteger("www2_weights.cluster2", 30))
-        .WillRepeatedly(Return(120));
-    EXPECT_CALL(runtime.snapshot_, getInteger("www2_weights.cluster3", 40))
-        .WillRepeatedly(Return(10));
+    // We return an invalid value here, one that is greater than 100. The weights are then
+    // proportions of their sum rather than percentages.
+    EXPECT_CALL(runtime.snapshot_, getInteger("www2_weights.cluster2", 30)).WillOnce(Return(120));
+    EXPECT_CALL(runtime.snapshot_, getInteger("www2_weights.cluster3", 40)).WillOnce(Return(10));
 
-    EXPECT_EQ("cluster1", config.route(headers, 1005)->routeEntry()->clusterName());
-    EXPECT_EQ("cluster2", config.route(headers, 82)->routeEntry()->clusterName());
-    EXPECT_EQ("cluster2", config.route(headers, 92)->routeEntry()->clusterName());
+    EXPECT_EQ("cluster1", config.route(headers, 0)->routeEntry()->clusterName());
+    EXPECT_EQ("cluster2", config.route(headers, 1)->routeEntry()->clusterName());
+    EXPECT_EQ("cluster2", config.route(headers, 3 * 30)->routeEntry()->clusterName());
+
+    std::map<std::string, uint64_t> expected{{"cluster1", 30}, {"cluster2", 360}, {"cluster3", 30}};
+    EXPECT_EQ(expected, count_clusters("www2.lyft.com", 140));
+  }
+
+  // Runtime weights which are all 0 select the clusters uniformly.
+  {
+    ON_CALL(runtime.snapshot_, version()).WillByDefault(Return(3));
+    EXPECT_CALL(runtime.snapshot_, getInteger("www2_weights.cluster1", 30)).WillOnce(Return(0));
+    EXPECT_CALL(runtime.snapshot_, getInteger("www2_weights.cluster2", 30)).WillOnce(Return(0));
+    EXPECT_CALL(runtime.snapshot_, getInteger("www2_weights.cluster3", 40)).WillOnce(Return(0));
+
+    std::map<std::string, uint64_t> expected{{"cluster1", 3}, {"cluster2", 3}, {"cluster3", 3}};
+    EXPECT_EQ(expected, count_clusters("www2.lyft.com", 3));
   }
 }
 
@@ -2844,6 +3025,70 @@ TEST(RoutePropertyTest, TestRouteCorsConfig) {
   EXPECT_EQ(cors_policy->allowCredentials(), true);
 }
 
+TEST(RoutePropertyTest, TestMergedCorsConfig) {
+  std::string json = R"EOF(
+{
+  "virtual_hosts": [
+    {
+      "name": "default",
+      "domains": ["*"],
+      "cors" : {
+          "allow_origin": ["*"],
+          "allow_methods": "vhost-methods",
+          "max_age": "vhost-max-age",
+          "allow_credentials": true
+      },
+      "routes": [
+        {
+          "prefix": "/api",
+          "cluster": "ats",
+          "cors" : {
+              "allow_origin": ["test-origin", "other-origin"],
+              "allow_headers": "test-headers"
+          }
+        },
+        {
+          "prefix": "/",
+          "cluster": "ats"
+        }
+      ]
+    }
+  ]
+}
+)EOF";
+
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  ConfigImpl config(parseRouteConfigurationFromJson(json), runtime, cm, true);
+
+  const Router::CorsPolicy* cors_policy =
+      config.route(genHeaders("api.lyft.com", "/api", "GET"), 0)->routeEntry()->corsPolicy();
+
+  EXPECT_THAT(cors_policy->allowOrigins(), ElementsAreArray({"test-origin", "other-origin"}));
+  EXPECT_EQ(cors_policy->allowMethods(), "vhost-methods");
+  EXPECT_EQ(cors_policy->allowHeaders(), "test-headers");
+  EXPECT_EQ(cors_policy->exposeHeaders(), "");
+  EXPECT_EQ(cors_policy->maxAge(), "vhost-max-age");
+  EXPECT_EQ(cors_policy->allowCredentials(), true);
+  const std::string other_origin = "other-origin";
+  const std::string vhost_origin = "vhost-origin";
+  EXPECT_TRUE(cors_policy->allowsOrigin(Http::HeaderString(other_origin)));
+  EXPECT_FALSE(cors_policy->allowsOrigin(Http::HeaderString(vhost_origin)));
+
+  Http::TestHeaderMapImpl preflight_headers{{":status", "200"},
+                                            {"access-control-allow-origin", ""},
+                                            {"access-control-allow-credentials", "true"},
+                                            {"access-control-allow-methods", "vhost-methods"},
+                                            {"access-control-allow-headers", "test-headers"},
+                                            {"access-control-max-age", "vhost-max-age"}};
+  EXPECT_EQ(preflight_headers, Http::HeaderMapImpl(cors_policy->preflightHeaders()));
+
+  const Router::RouteEntry* route_entry =
+      config.route(genHeaders("api.lyft.com", "/", "GET"), 0)->routeEntry();
+  const Router::CorsPolicy* vhost_cors_policy = route_entry->virtualHost().corsPolicy();
+  EXPECT_TRUE(vhost_cors_policy->allowsOrigin(Http::HeaderString(vhost_origin)));
+}
+
 TEST(RoutePropertyTest, TestBadCorsConfig) {
   std::string json = R"EOF(
 {
@@ -3100,6 +3345,34 @@ TEST(MetadataMatchCriteriaImpl, Merge) {
   EXPECT_EQ((*it)->value().value().string_value(), "override3");
 }
 
+TEST(MetadataMatchCriteriaImpl, Hash) {
+  auto v1 = ProtobufWkt::Value();
+  v1.set_string_value("v1");
+  auto v2 = ProtobufWkt::Value();
+  v2.set_string_value("v2");
+
+  auto struct1 = ProtobufWkt::Struct();
+  struct1.mutable_fields()->insert({"a", v1});
+  struct1.mutable_fields()->insert({"b", v2});
+  auto struct2 = ProtobufWkt::Struct();
+  struct2.mutable_fields()->insert({"b", v2});
+  struct2.mutable_fields()->insert({"a", v1});
+  auto struct3 = ProtobufWkt::Struct();
+  struct3.mutable_fields()->insert({"a", v2});
+  struct3.mutable_fields()->insert({"b", v1});
+
+  EXPECT_EQ(MetadataMatchCriteriaImpl(struct1).hash(), MetadataMatchCriteriaImpl(struct2).hash());
+  EXPECT_NE(MetadataMatchCriteriaImpl(struct1).hash(), MetadataMatchCriteriaImpl(struct3).hash());
+
+  // Merged criteria hash like criteria created with the same names and values.
+  auto parent_struct = ProtobufWkt::Struct();
+  parent_struct.mutable_fields()->insert({"a", v1});
+  auto child_struct = ProtobufWkt::Struct();
+  child_struct.mutable_fields()->insert({"b", v2});
+  EXPECT_EQ(MetadataMatchCriteriaImpl(struct1).hash(),
+            MetadataMatchCriteriaImpl(parent_struct).mergeMatchCriteria(child_struct)->hash());
+}
+
 TEST(RouteEntryMetadataMatchTest, ParsesMetadata) {
   auto route_config = envoy::api::v2::RouteConfiguration();
   auto* vhost = route_config.add_virtual_hosts();
@@ -3227,6 +3500,93 @@ TEST(ConfigUtility, ParseResponseCode) {
   }
 }
 
+// Regexes matching literals, prefixes and suffixes are compiled into comparisons which match the
+// same values as the regex.
+TEST(ConfigUtility, HeaderMatchers) {
+  auto header_data = [](const std::string& name, const std::string& value,
+                        bool regex) -> ConfigUtility::HeaderData {
+    envoy::api::v2::HeaderMatcher config;
+    config.set_name(name);
+    config.set_value(value);
+    config.mutable_regex()->set_value(regex);
+    return ConfigUtility::HeaderData(config);
+  };
+  const std::vector<std::tuple<std::string, bool, ConfigUtility::HeaderData::MatchType>> test_set =
+      {std::make_tuple("", false, ConfigUtility::HeaderData::MatchType::Present),
+       std::make_tuple("a.b", false, ConfigUtility::HeaderData::MatchType::Exact),
+       std::make_tuple("a\\.b", true, ConfigUtility::HeaderData::MatchType::Exact),
+       std::make_tuple("a\\..*", true, ConfigUtility::HeaderData::MatchType::Prefix),
+       std::make_tuple(".*\\.b", true, ConfigUtility::HeaderData::MatchType::Suffix),
+       std::make_tuple("a\\.*", true, ConfigUtility::HeaderData::MatchType::Regex),
+       std::make_tuple("a.b", true, ConfigUtility::HeaderData::MatchType::Regex),
+       std::make_tuple("\\d+", true, ConfigUtility::HeaderData::MatchType::Regex)};
+  const std::vector<std::string> values = {"", "a", "a.b", "axb", "a.", "a..", "a.bc", ".b", "x.b",
+                                           "12", "b"};
+
+  for (const auto& test_case : test_set) {
+    const std::string& pattern = std::get<0>(test_case);
+    const bool regex = std::get<1>(test_case);
+    for (const std::string& name : {"x-foo", "content-type"}) {
+      const ConfigUtility::HeaderData data = header_data(name, pattern, regex);
+      EXPECT_EQ(std::get<2>(test_case), data.match_type_) << pattern;
+      EXPECT_EQ(name == "content-type", data.inline_header_ != nullptr);
+      EXPECT_FALSE(data.matches(Http::TestHeaderMapImpl{{"x-bar", "a.b"}}));
+      for (const std::string& value : values) {
+        const bool expected =
+            pattern.empty() ||
+            (regex ? std::regex_match(value, std::regex(pattern)) : value == pattern);
+        EXPECT_EQ(expected, data.matches(Http::TestHeaderMapImpl{{name, value}}))
+            << pattern << " " << value;
+      }
+    }
+  }
+}
+
+// The route key headers are those of the header matchers, cluster headers and SSL requirements,
+// unless a route depends on runtime values or on the random value.
+TEST(RouteConfigurationV2, RouteKeyHeaders) {
+  std::string yaml = R"EOF(
+name: foo
+virtual_hosts:
+  - name: canary
+    domains: [canary.lyft.com]
+    require_tls: ALL
+    routes:
+      - match: { prefix: "/", headers: [{ name: x-canary, value: "1" }] }
+        route: { cluster: canary }
+      - match: { prefix: "/" }
+        route: { cluster_header: x-cluster }
+  - name: www
+    domains: ["*"]
+    routes:
+      - match: { prefix: "/", headers: [{ name: x-canary }] }
+        route: { cluster: www }
+  )EOF";
+
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  {
+    ConfigImpl config(parseRouteConfigurationFromV2Yaml(yaml), runtime, cm, false);
+    ASSERT_NE(nullptr, config.routeKeyHeaders());
+    std::vector<std::string> headers;
+    for (const Http::LowerCaseString& header : *config.routeKeyHeaders()) {
+      headers.push_back(header.get());
+    }
+    EXPECT_EQ(std::vector<std::string>({"x-canary", "x-cluster", "x-envoy-internal",
+                                        "x-forwarded-proto"}),
+              headers);
+  }
+
+  yaml += R"EOF(
+      - match: { prefix: "/", runtime: { runtime_key: www.enabled, default_value: 50 } }
+        route: { cluster: www }
+  )EOF";
+  {
+    ConfigImpl config(parseRouteConfigurationFromV2Yaml(yaml), runtime, cm, false);
+    EXPECT_EQ(nullptr, config.routeKeyHeaders());
+  }
+}
+
 TEST(RouteConfigurationV2, RedirectCode) {
   std::string yaml = R"EOF(
 name: foo
@@ -3254,6 +3614,61 @@ virtual_hosts:
   }
 }
 
+TEST(RouteConfigurationV2, ReuseUnchangedVirtualHosts) {
+  auto config_proto = [](const std::string& api_cluster, const std::string& global_header) {
+    return parseRouteConfigurationFromV2Yaml(R"EOF(
+name: foo
+virtual_hosts:
+  - name: www
+    domains: [www.lyft.com]
+    routes:
+      - match: { prefix: "/" }
+        route: { cluster: www }
+  - name: api
+    domains: [api.lyft.com]
+    routes:
+      - match: { prefix: "/" }
+        route: { cluster: )EOF" + api_cluster + R"EOF( }
+response_headers_to_add:
+  - header: { key: x-global, value: ")EOF" + global_header + R"EOF(" }
+  )EOF");
+  };
+
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  NiceMock<Envoy::AccessLog::MockRequestInfo> request_info;
+  ConfigImpl config(config_proto("api", "1"), runtime, cm, false);
+  RouteConstSharedPtr www_route = config.route(genHeaders("www.lyft.com", "/", "GET"), 0);
+  RouteConstSharedPtr api_route = config.route(genHeaders("api.lyft.com", "/", "GET"), 0);
+
+  // Only the changed virtual host is built again.
+  ConfigImpl new_config(config_proto("api2", "1"), runtime, cm, false, &config);
+  EXPECT_EQ(www_route.get(), new_config.route(genHeaders("www.lyft.com", "/", "GET"), 0).get());
+  RouteConstSharedPtr new_api_route = new_config.route(genHeaders("api.lyft.com", "/", "GET"), 0);
+  EXPECT_NE(api_route.get(), new_api_route.get());
+  EXPECT_EQ("api2", new_api_route->routeEntry()->clusterName());
+
+  // Virtual hosts are built again if the global headers change.
+  ConfigImpl global_config(config_proto("api2", "2"), runtime, cm, false, &new_config);
+  RouteConstSharedPtr global_www_route =
+      global_config.route(genHeaders("www.lyft.com", "/", "GET"), 0);
+  EXPECT_NE(www_route.get(), global_www_route.get());
+  Http::TestHeaderMapImpl response_headers;
+  global_www_route->routeEntry()->finalizeResponseHeaders(response_headers, request_info);
+  EXPECT_EQ("2", response_headers.get_("x-global"));
+
+  // Reused virtual hosts outlive the configuration they were built for.
+  std::unique_ptr<ConfigImpl> old_config(new ConfigImpl(config_proto("api", "3"), runtime, cm,
+                                                        false));
+  ConfigImpl reused_config(config_proto("api", "3"), runtime, cm, false, old_config.get());
+  old_config.reset();
+  Http::TestHeaderMapImpl reused_headers;
+  reused_config.route(genHeaders("www.lyft.com", "/", "GET"), 0)
+      ->routeEntry()
+      ->finalizeResponseHeaders(reused_headers, request_info);
+  EXPECT_EQ("3", reused_headers.get_("x-global"));
+}
+
 } // namespace
 } // namespace Router
 } // namespace Envoy
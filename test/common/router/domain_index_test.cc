@@ -0,0 +1,73 @@
+#include <string>
+
+#include "common/router/domain_index.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Router {
+namespace {
+
+uint32_t find(const DomainIndex& index, const std::string& host) {
+  return index.find(host.c_str(), host.size());
+}
+
+TEST(DomainIndexTest, Empty) {
+  DomainIndex index;
+  EXPECT_TRUE(index.empty());
+  EXPECT_EQ(DomainIndex::NO_MATCH, find(index, "foo.com"));
+  EXPECT_EQ(DomainIndex::NO_MATCH, find(index, ""));
+}
+
+TEST(DomainIndexTest, Domains) {
+  DomainIndex index;
+  EXPECT_TRUE(index.addDomain("foo.com", 0));
+  EXPECT_TRUE(index.addDomain("bar.foo.com", 1));
+  EXPECT_TRUE(index.addDomain("boo.com", 2));
+  EXPECT_FALSE(index.addDomain("foo.com", 3));
+  EXPECT_FALSE(index.empty());
+
+  EXPECT_EQ(0U, find(index, "foo.com"));
+  EXPECT_EQ(1U, find(index, "bar.foo.com"));
+  EXPECT_EQ(2U, find(index, "boo.com"));
+  EXPECT_EQ(DomainIndex::NO_MATCH, find(index, "oo.com"));
+  EXPECT_EQ(DomainIndex::NO_MATCH, find(index, "ar.foo.com"));
+  EXPECT_EQ(DomainIndex::NO_MATCH, find(index, "baz.foo.com"));
+  EXPECT_EQ(DomainIndex::NO_MATCH, find(index, "foo.co"));
+  EXPECT_EQ(DomainIndex::NO_MATCH, find(index, ""));
+}
+
+TEST(DomainIndexTest, WildcardSuffixes) {
+  DomainIndex index;
+  index.addWildcardSuffix(".foo.com", 0);
+  index.addWildcardSuffix("-bar.foo.com", 1);
+  index.addWildcardSuffix(".baz.foo.com", 2);
+  index.addWildcardSuffix(".foo.com", 3);
+
+  EXPECT_EQ(0U, find(index, "a.foo.com"));
+  EXPECT_EQ(0U, find(index, "bar.foo.com"));
+  EXPECT_EQ(1U, find(index, "a-bar.foo.com"));
+  EXPECT_EQ(2U, find(index, "a.baz.foo.com"));
+  EXPECT_EQ(0U, find(index, "baz.foo.com"));
+  // A wildcard does not match its own suffix.
+  EXPECT_EQ(DomainIndex::NO_MATCH, find(index, ".foo.com"));
+  EXPECT_EQ(0U, find(index, "-bar.foo.com"));
+  EXPECT_EQ(DomainIndex::NO_MATCH, find(index, "foo.com"));
+  EXPECT_EQ(DomainIndex::NO_MATCH, find(index, "a.foo.co"));
+}
+
+TEST(DomainIndexTest, DomainsBeforeWildcards) {
+  DomainIndex index;
+  index.addWildcardSuffix(".foo.com", 0);
+  EXPECT_TRUE(index.addDomain("bar.foo.com", 1));
+  EXPECT_TRUE(index.addDomain(".foo.com", 2));
+
+  EXPECT_EQ(1U, find(index, "bar.foo.com"));
+  EXPECT_EQ(2U, find(index, ".foo.com"));
+  EXPECT_EQ(0U, find(index, "baz.foo.com"));
+  EXPECT_EQ(0U, find(index, "a.bar.foo.com"));
+}
+
+} // namespace
+} // namespace Router
+} // namespace Envoy
@@ -54,6 +54,17 @@ TEST(RequestInfoHeaderFormatterTest, TestFormatWithProtocolVariable) {
   EXPECT_EQ("HTTP/1.1", formatted_string);
 }
 
+TEST(RequestInfoHeaderFormatterTest, TestFormatReturnsHeldValues) {
+  NiceMock<Envoy::AccessLog::MockRequestInfo> request_info;
+  const std::string downstream_addr = "127.0.0.1";
+  ON_CALL(request_info, getDownstreamAddress()).WillByDefault(ReturnRef(downstream_addr));
+  RequestInfoHeaderFormatter client_ip_formatter("CLIENT_IP", false);
+  EXPECT_EQ(&downstream_addr, &client_ip_formatter.format(request_info));
+
+  PlainHeaderFormatter plain_formatter("value", false);
+  EXPECT_EQ(&plain_formatter.format(request_info), &plain_formatter.format(request_info));
+}
+
 TEST(RequestInfoHeaderFormatterTest, WrongVariableToFormat) {
   NiceMock<Envoy::AccessLog::MockRequestInfo> request_info;
   const std::string downstream_addr = "127.0.0.1";
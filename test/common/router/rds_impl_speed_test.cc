@@ -0,0 +1,95 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <memory>
+#include <string>
+
+#include "common/router/rds_impl.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/init/mocks.h"
+#include "test/mocks/local_info/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/server/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+
+#include "benchmark/benchmark.h"
+#include "fmt/format.h"
+
+using testing::NiceMock;
+using testing::Return;
+using testing::_;
+
+namespace Envoy {
+namespace Router {
+
+/**
+ * Generate a route configuration of num_virtual_hosts virtual hosts of 10 routes each. The
+ * cluster of the first route of the last virtual host is named after the version, so that two
+ * versions differ by one virtual host only, as with most updates.
+ */
+static envoy::api::v2::RouteConfiguration makeRouteConfig(size_t num_virtual_hosts,
+                                                          size_t version) {
+  envoy::api::v2::RouteConfiguration route_config;
+  route_config.set_name("foo_route_config");
+  for (size_t i = 0; i < num_virtual_hosts; i++) {
+    auto* virtual_host = route_config.add_virtual_hosts();
+    virtual_host->set_name(fmt::format("virtual_host_{}", i));
+    virtual_host->add_domains(fmt::format("host{}.example.com", i));
+    for (size_t j = 0; j < 10; j++) {
+      auto* route = virtual_host->add_routes();
+      route->mutable_match()->set_prefix(fmt::format("/prefix/{}/", j));
+      route->mutable_route()->set_cluster(fmt::format("cluster_{}", j));
+    }
+  }
+  route_config.mutable_virtual_hosts(num_virtual_hosts - 1)
+      ->mutable_routes(0)
+      ->mutable_route()
+      ->set_cluster(fmt::format("version_{}", version));
+  return route_config;
+}
+
+// RDS updates of a route configuration of range(0) virtual hosts, alternating between two
+// versions which differ by one virtual host.
+static void RdsUpdate(benchmark::State& state) {
+  const size_t num_virtual_hosts = state.range(0);
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  NiceMock<Event::MockDispatcher> dispatcher;
+  NiceMock<Runtime::MockRandomGenerator> random;
+  NiceMock<LocalInfo::MockLocalInfo> local_info;
+  Stats::IsolatedStoreImpl store;
+  NiceMock<ThreadLocal::MockInstance> tls;
+  NiceMock<Init::MockManager> init_manager;
+  NiceMock<Server::MockAdmin> admin;
+  ON_CALL(admin, addHandler(_, _, _, _)).WillByDefault(Return(true));
+
+  RouteConfigProviderManagerImpl route_config_provider_manager(runtime, dispatcher, random,
+                                                               local_info, tls, admin);
+  envoy::api::v2::filter::network::Rds rds;
+  rds.set_route_config_name("foo_route_config");
+  rds.mutable_config_source()->mutable_ads();
+  RouteConfigProviderSharedPtr provider = route_config_provider_manager.getRouteConfigProvider(
+      rds, cm, store, "foo.", init_manager);
+  RdsRouteConfigProviderImpl& rds_provider = dynamic_cast<RdsRouteConfigProviderImpl&>(*provider);
+
+  Protobuf::RepeatedPtrField<envoy::api::v2::RouteConfiguration> resources[2];
+  resources[0].Add()->MergeFrom(makeRouteConfig(num_virtual_hosts, 0));
+  resources[1].Add()->MergeFrom(makeRouteConfig(num_virtual_hosts, 1));
+  rds_provider.onConfigUpdate(resources[0]);
+
+  size_t update = 0;
+  while (state.KeepRunning()) {
+    rds_provider.onConfigUpdate(resources[++update % 2]);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * num_virtual_hosts);
+
+  provider.reset();
+  tls.shutdownThread();
+}
+BENCHMARK(RdsUpdate)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+} // namespace Router
+} // namespace Envoy
@@ -0,0 +1,110 @@
+#include <string>
+
+#include "common/router/route_index.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Router {
+namespace {
+
+uint32_t find(const RouteIndex& index, const std::string& path) {
+  const size_t query_start = path.find('?');
+  return index.find(path.c_str(), path.size(),
+                    query_start == std::string::npos ? path.size() : query_start);
+}
+
+TEST(RouteIndexTest, Empty) {
+  RouteIndex index;
+  EXPECT_TRUE(index.empty());
+  EXPECT_EQ(RouteIndex::NO_MATCH, find(index, "/foo"));
+  EXPECT_EQ(RouteIndex::NO_MATCH, find(index, ""));
+}
+
+TEST(RouteIndexTest, Prefixes) {
+  RouteIndex index;
+  index.addPrefix("/foo/bar", 0);
+  index.addPrefix("/foo", 1);
+  index.addPrefix("/fob", 2);
+  index.addPrefix("/", 3);
+  EXPECT_FALSE(index.empty());
+
+  EXPECT_EQ(0U, find(index, "/foo/bar"));
+  EXPECT_EQ(0U, find(index, "/foo/bar/baz"));
+  EXPECT_EQ(1U, find(index, "/foo/ba"));
+  EXPECT_EQ(1U, find(index, "/foo"));
+  EXPECT_EQ(2U, find(index, "/fob"));
+  EXPECT_EQ(3U, find(index, "/fo"));
+  EXPECT_EQ(3U, find(index, "/"));
+  EXPECT_EQ(RouteIndex::NO_MATCH, find(index, "foo"));
+  EXPECT_EQ(RouteIndex::NO_MATCH, find(index, ""));
+}
+
+TEST(RouteIndexTest, FirstMatchWins) {
+  RouteIndex index;
+  index.addPrefix("/", 0);
+  index.addPrefix("/foo", 1);
+  EXPECT_EQ(0U, find(index, "/foo"));
+  EXPECT_EQ(0U, find(index, "/bar"));
+}
+
+TEST(RouteIndexTest, DuplicateKeys) {
+  RouteIndex index;
+  index.addPrefix("/foo", 3);
+  index.addPrefix("/foo", 1);
+  index.addPath("/foo", 2);
+  EXPECT_EQ(1U, find(index, "/foo"));
+}
+
+TEST(RouteIndexTest, EmptyPrefix) {
+  RouteIndex index;
+  index.addPrefix("", 5);
+  index.addPrefix("/foo", 6);
+  EXPECT_EQ(5U, find(index, ""));
+  EXPECT_EQ(5U, find(index, "/foo"));
+}
+
+TEST(RouteIndexTest, ExactPaths) {
+  RouteIndex index;
+  index.addPath("/foo", 0);
+  index.addPath("/foo/bar", 1);
+  index.addPrefix("/foo/", 2);
+
+  EXPECT_EQ(0U, find(index, "/foo"));
+  EXPECT_EQ(0U, find(index, "/foo?a=b"));
+  EXPECT_EQ(1U, find(index, "/foo/bar"));
+  EXPECT_EQ(1U, find(index, "/foo/bar?a=b"));
+  EXPECT_EQ(2U, find(index, "/foo/bar/"));
+  EXPECT_EQ(2U, find(index, "/foo/baz"));
+  EXPECT_EQ(RouteIndex::NO_MATCH, find(index, "/fo"));
+  EXPECT_EQ(RouteIndex::NO_MATCH, find(index, "/foobar"));
+}
+
+// Prefixes are matched against the full path including the query string.
+TEST(RouteIndexTest, PrefixIncludesQueryString) {
+  RouteIndex index;
+  index.addPrefix("/foo?bar", 0);
+  index.addPath("/foo", 1);
+  EXPECT_EQ(0U, find(index, "/foo?bar=baz"));
+  EXPECT_EQ(1U, find(index, "/foo?baz"));
+}
+
+// Keys which force splits of existing edges in the middle of their labels.
+TEST(RouteIndexTest, EdgeSplits) {
+  RouteIndex index;
+  index.addPrefix("/abcdef", 0);
+  index.addPrefix("/abcxyz", 1);
+  index.addPath("/abc", 2);
+  index.addPrefix("/ab", 3);
+
+  EXPECT_EQ(0U, find(index, "/abcdefg"));
+  EXPECT_EQ(1U, find(index, "/abcxyz"));
+  EXPECT_EQ(2U, find(index, "/abc"));
+  EXPECT_EQ(3U, find(index, "/abcd"));
+  EXPECT_EQ(3U, find(index, "/ab"));
+  EXPECT_EQ(RouteIndex::NO_MATCH, find(index, "/a"));
+}
+
+} // namespace
+} // namespace Router
+} // namespace Envoy
@@ -8,12 +8,14 @@
 #include "common/upstream/upstream_impl.h"
 
 #include "test/common/http/common.h"
+#include "test/mocks/buffer/mocks.h"
 #include "test/mocks/http/mocks.h"
 #include "test/mocks/local_info/mocks.h"
 #include "test/mocks/network/mocks.h"
 #include "test/mocks/router/mocks.h"
 #include "test/mocks/runtime/mocks.h"
 #include "test/mocks/ssl/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
 #include "test/mocks/upstream/mocks.h"
 #include "test/test_common/printers.h"
 #include "test/test_common/utility.h"
@@ -24,7 +26,6 @@
 using testing::AssertionFailure;
 using testing::AssertionResult;
 using testing::AssertionSuccess;
-using testing::AtLeast;
 using testing::Invoke;
 using testing::MockFunction;
 using testing::NiceMock;
@@ -110,6 +111,7 @@ public:
   NiceMock<Http::MockStreamDecoderFilterCallbacks> callbacks_;
   MockShadowWriter* shadow_writer_;
   NiceMock<LocalInfo::MockLocalInfo> local_info_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
   FilterConfig config_;
   TestFilter router_;
   Event::MockTimer* response_timeout_{};
@@ -149,6 +151,48 @@ TEST_F(RouterTest, ClusterNotFound) {
   EXPECT_TRUE(verifyHostUpstreamStats(0, 0));
 }
 
+TEST_F(RouterTest, EarlyDataNotAllowed) {
+  callbacks_.route_->route_entry_.opaque_config_.emplace("allow_early_data", "false");
+  EXPECT_CALL(cm_, httpConnPoolForCluster(_, _, _)).Times(0);
+  Http::TestHeaderMapImpl response_headers{{":status", "425"}};
+  EXPECT_CALL(callbacks_, encodeHeaders_(HeaderMapEqualRef(&response_headers), true));
+
+  Http::TestHeaderMapImpl headers{{"early-data", "1"}};
+  HttpTestUtility::addDefaultHeaders(headers);
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration, router_.decodeHeaders(headers, true));
+  EXPECT_EQ(1UL, stats_store_.counter("test.rq_too_early").value());
+  EXPECT_TRUE(verifyHostUpstreamStats(0, 0));
+}
+
+TEST_F(RouterTest, ClusterHandle) {
+  ON_CALL(callbacks_.route_->route_entry_, clusterHandle())
+      .WillByDefault(Return(Optional<uint32_t>(7)));
+  EXPECT_CALL(cm_, get(_)).Times(0);
+  EXPECT_CALL(cm_, getByHandle(7));
+  EXPECT_CALL(cm_, httpConnPoolForCluster(_, _, _)).Times(0);
+  EXPECT_CALL(cm_, httpConnPoolForClusterHandle(7, Upstream::ResourcePriority::Default, &router_))
+      .WillOnce(Return(nullptr));
+  EXPECT_CALL(callbacks_.request_info_,
+              setResponseFlag(AccessLog::ResponseFlag::NoHealthyUpstream));
+
+  Http::TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+  EXPECT_TRUE(verifyHostUpstreamStats(0, 0));
+}
+
+TEST_F(RouterTest, ClusterHandleNotFound) {
+  ON_CALL(callbacks_.route_->route_entry_, clusterHandle())
+      .WillByDefault(Return(Optional<uint32_t>(7)));
+  EXPECT_CALL(cm_, getByHandle(7)).WillOnce(Return(nullptr));
+  EXPECT_CALL(callbacks_.request_info_, setResponseFlag(AccessLog::ResponseFlag::NoRouteFound));
+
+  Http::TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+  EXPECT_EQ(1UL, stats_store_.counter("test.no_cluster").value());
+}
+
 TEST_F(RouterTest, PoolFailureWithPriority) {
   ON_CALL(callbacks_.route_->route_entry_, priority())
       .WillByDefault(Return(Upstream::ResourcePriority::High));
@@ -1260,7 +1304,7 @@ TEST_F(RouterTest, RetryUpstream5xxNotComplete) {
 
   Buffer::InstancePtr body_data(new Buffer::OwnedImpl("hello"));
   EXPECT_CALL(*router_.retry_state_, enabled()).WillOnce(Return(true));
-  EXPECT_EQ(Http::FilterDataStatus::StopIterationAndBuffer, router_.decodeData(*body_data, false));
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, router_.decodeData(*body_data, false));
 
   Http::TestHeaderMapImpl trailers{{"some", "trailer"}};
   router_.decodeTrailers(trailers);
@@ -1282,9 +1326,8 @@ TEST_F(RouterTest, RetryUpstream5xxNotComplete) {
         callbacks.onPoolReady(encoder2, cm_.conn_pool_.host_);
         return nullptr;
       }));
-  ON_CALL(callbacks_, decodingBuffer()).WillByDefault(Return(body_data.get()));
   EXPECT_CALL(encoder2, encodeHeaders(_, false));
-  EXPECT_CALL(encoder2, encodeData(_, false));
+  EXPECT_CALL(encoder2, encodeData(BufferStringEqual("hello"), false));
   EXPECT_CALL(encoder2, encodeTrailers(_));
   router_.retry_state_->callback_();
 
@@ -1292,6 +1335,7 @@ TEST_F(RouterTest, RetryUpstream5xxNotComplete) {
   EXPECT_CALL(*router_.retry_state_, shouldRetry(_, _, _)).WillOnce(Return(RetryStatus::No));
   EXPECT_CALL(cm_.conn_pool_.host_->outlier_detector_, putHttpResponseCode(200));
   EXPECT_CALL(cm_.conn_pool_.host_->outlier_detector_, putResponseTime(_));
+  EXPECT_CALL(cm_.conn_pool_.host_->latency_estimator_, putLatency(_, _));
   EXPECT_CALL(cm_.conn_pool_.host_->health_checker_, setUnhealthy());
   Http::HeaderMapPtr response_headers2(new Http::TestHeaderMapImpl{
       {":status", "200"}, {"x-envoy-immediate-health-check-fail", "true"}});
@@ -1382,16 +1426,13 @@ TEST_F(RouterTest, Shadow) {
   router_.decodeHeaders(headers, false);
 
   Buffer::InstancePtr body_data(new Buffer::OwnedImpl("hello"));
-  EXPECT_EQ(Http::FilterDataStatus::StopIterationAndBuffer, router_.decodeData(*body_data, false));
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, router_.decodeData(*body_data, false));
 
   Http::TestHeaderMapImpl trailers{{"some", "trailer"}};
-  EXPECT_CALL(callbacks_, decodingBuffer())
-      .Times(AtLeast(1))
-      .WillRepeatedly(Return(body_data.get()));
   EXPECT_CALL(*shadow_writer_, shadow_("foo", _, std::chrono::milliseconds(10)))
       .WillOnce(Invoke(
           [](const std::string&, Http::MessagePtr& request, std::chrono::milliseconds) -> void {
-            EXPECT_NE(nullptr, request->body());
+            EXPECT_EQ("hello", TestUtility::bufferToString(*request->body()));
             EXPECT_NE(nullptr, request->trailers());
           }));
   router_.decodeTrailers(trailers);
@@ -1401,6 +1442,79 @@ TEST_F(RouterTest, Shadow) {
   EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
 }
 
+TEST_F(RouterTest, StreamingShadow) {
+  callbacks_.route_->route_entry_.shadow_policy_.cluster_ = "foo";
+  callbacks_.route_->route_entry_.shadow_policy_.runtime_key_ = "bar";
+  ON_CALL(callbacks_, streamId()).WillByDefault(Return(43));
+
+  NiceMock<Http::MockStreamEncoder> encoder;
+  Http::StreamDecoder* response_decoder = nullptr;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder& decoder, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        response_decoder = &decoder;
+        callbacks.onPoolReady(encoder, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+  expectResponseTimerCreate();
+
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("bar", 0, 43, 10000)).WillOnce(Return(true));
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("router.streaming_shadow", 100))
+      .WillOnce(Return(true));
+
+  MockShadowStream shadow_stream;
+  Http::TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  EXPECT_CALL(*shadow_writer_, streamShadow("foo", _, std::chrono::milliseconds(10), _))
+      .WillOnce(Return(&shadow_stream));
+  router_.decodeHeaders(headers, false);
+
+  // The body is not buffered for the shadow, which gets each chunk as it arrives.
+  Buffer::OwnedImpl body_data("hello");
+  EXPECT_CALL(shadow_stream, sendData(BufferStringEqual("hello"), false));
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, router_.decodeData(body_data, false));
+
+  Http::TestHeaderMapImpl trailers{{"some", "trailer"}};
+  EXPECT_CALL(shadow_stream, sendTrailers(_));
+  EXPECT_CALL(*shadow_writer_, shadow_(_, _, _)).Times(0);
+  router_.decodeTrailers(trailers);
+
+  Http::HeaderMapPtr response_headers(new Http::TestHeaderMapImpl{{":status", "200"}});
+  response_decoder->decodeHeaders(std::move(response_headers), true);
+  EXPECT_CALL(shadow_stream, reset()).Times(0);
+  router_.onDestroy();
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
+}
+
+TEST_F(RouterTest, StreamingShadowIncompleteRequest) {
+  callbacks_.route_->route_entry_.shadow_policy_.cluster_ = "foo";
+  callbacks_.route_->route_entry_.shadow_policy_.runtime_key_ = "bar";
+  ON_CALL(callbacks_, streamId()).WillByDefault(Return(43));
+
+  NiceMock<Http::MockStreamEncoder> encoder;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder&, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        callbacks.onPoolReady(encoder, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("bar", 0, 43, 10000)).WillOnce(Return(true));
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("router.streaming_shadow", 100))
+      .WillOnce(Return(true));
+
+  MockShadowStream shadow_stream;
+  Http::TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  EXPECT_CALL(*shadow_writer_, streamShadow("foo", _, _, _)).WillOnce(Return(&shadow_stream));
+  router_.decodeHeaders(headers, false);
+
+  // The downstream request is reset before it completes, and so is the shadow.
+  EXPECT_CALL(shadow_stream, reset());
+  EXPECT_CALL(encoder.stream_, resetStream(Http::StreamResetReason::LocalReset));
+  router_.onDestroy();
+}
+
 TEST_F(RouterTest, AltStatName) {
   // Also test no upstream timeout here.
   EXPECT_CALL(callbacks_.route_->route_entry_, timeout())
@@ -1477,6 +1591,250 @@ TEST_F(RouterTest, RedirectFound) {
   EXPECT_TRUE(verifyHostUpstreamStats(0, 0));
 }
 
+class RouterCollapsingTest : public RouterTest {
+public:
+  RouterCollapsingTest() : follower_(config_) {
+    config_.enableRequestCollapsing(tls_);
+    callbacks_.route_->route_entry_.opaque_config_.emplace("collapse_requests", "true");
+    ON_CALL(callbacks_.route_->route_entry_, timeout())
+        .WillByDefault(Return(std::chrono::milliseconds(0)));
+    ON_CALL(follower_callbacks_, route()).WillByDefault(Return(callbacks_.route_));
+    follower_.setDecoderFilterCallbacks(follower_callbacks_);
+  }
+
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> follower_callbacks_;
+  TestFilter follower_;
+};
+
+TEST_F(RouterCollapsingTest, ShareResponse) {
+  NiceMock<Http::MockStreamEncoder> encoder;
+  Http::StreamDecoder* response_decoder = nullptr;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder& decoder, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        response_decoder = &decoder;
+        callbacks.onPoolReady(encoder, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+
+  Http::TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+  Http::TestHeaderMapImpl follower_headers;
+  HttpTestUtility::addDefaultHeaders(follower_headers);
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            follower_.decodeHeaders(follower_headers, true));
+  EXPECT_EQ(1UL, stats_store_.counter("test.rq_collapsed").value());
+
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, false));
+  EXPECT_CALL(follower_callbacks_, encodeHeaders_(_, false))
+      .WillOnce(Invoke([](Http::HeaderMap& headers, bool) -> void {
+        EXPECT_STREQ("200", headers.Status()->value().c_str());
+      }));
+  Http::HeaderMapPtr response_headers(new Http::TestHeaderMapImpl{{":status", "200"}});
+  response_decoder->decodeHeaders(std::move(response_headers), false);
+
+  EXPECT_CALL(callbacks_, encodeData(_, true));
+  EXPECT_CALL(follower_callbacks_, encodeData(_, true))
+      .WillOnce(Invoke([](Buffer::Instance& data, bool) -> void {
+        EXPECT_EQ("hello", TestUtility::bufferToString(data));
+      }));
+  Buffer::OwnedImpl data("hello");
+  response_decoder->decodeData(data, true);
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
+
+  // The response has started, so new requests aren't collapsed into it anymore.
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _)).WillOnce(Return(&cancellable_));
+  TestFilter late_router(config_);
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> late_callbacks;
+  ON_CALL(late_callbacks, route()).WillByDefault(Return(callbacks_.route_));
+  late_router.setDecoderFilterCallbacks(late_callbacks);
+  Http::TestHeaderMapImpl late_headers;
+  HttpTestUtility::addDefaultHeaders(late_headers);
+  late_router.decodeHeaders(late_headers, true);
+  EXPECT_CALL(cancellable_, cancel());
+  late_router.onDestroy();
+  EXPECT_EQ(1UL, stats_store_.counter("test.rq_collapsed").value());
+}
+
+TEST_F(RouterCollapsingTest, LeaderFailsBeforeHeaders) {
+  Http::ConnectionPool::Callbacks* pool_callbacks = nullptr;
+  NiceMock<Http::MockStreamEncoder> encoder;
+  Http::StreamDecoder* response_decoder = nullptr;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder&, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        pool_callbacks = &callbacks;
+        return &cancellable_;
+      }))
+      .WillOnce(Invoke([&](Http::StreamDecoder& decoder, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        response_decoder = &decoder;
+        callbacks.onPoolReady(encoder, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+
+  Http::TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+  Http::TestHeaderMapImpl follower_headers;
+  HttpTestUtility::addDefaultHeaders(follower_headers);
+  follower_.decodeHeaders(follower_headers, true);
+
+  // The follower sends its own request once the leader has failed.
+  Http::TestHeaderMapImpl error_headers{
+      {":status", "503"}, {"content-length", "57"}, {"content-type", "text/plain"}};
+  EXPECT_CALL(callbacks_, encodeHeaders_(HeaderMapEqualRef(&error_headers), false));
+  EXPECT_CALL(callbacks_, encodeData(_, true));
+  EXPECT_CALL(follower_callbacks_, encodeHeaders_(_, _)).Times(0);
+  pool_callbacks->onPoolFailure(Http::ConnectionPool::PoolFailureReason::ConnectionFailure,
+                                cm_.conn_pool_.host_);
+  ASSERT_NE(nullptr, response_decoder);
+
+  EXPECT_CALL(follower_callbacks_, encodeHeaders_(_, true));
+  Http::HeaderMapPtr response_headers(new Http::TestHeaderMapImpl{{":status", "200"}});
+  response_decoder->decodeHeaders(std::move(response_headers), true);
+}
+
+TEST_F(RouterCollapsingTest, DifferentRequestsNotCollapsed) {
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _)).Times(2).WillRepeatedly(Return(&cancellable_));
+
+  Http::TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+  Http::TestHeaderMapImpl follower_headers;
+  HttpTestUtility::addDefaultHeaders(follower_headers);
+  follower_headers.insertPath().value(std::string("/other"));
+  follower_.decodeHeaders(follower_headers, true);
+  EXPECT_EQ(0UL, stats_store_.counter("test.rq_collapsed").value());
+
+  EXPECT_CALL(cancellable_, cancel()).Times(2);
+  router_.onDestroy();
+  follower_.onDestroy();
+}
+
+class RouterHedgingTest : public RouterTest {
+public:
+  RouterHedgingTest() {
+    callbacks_.route_->route_entry_.opaque_config_.emplace("hedge_delay_ms", "10");
+    ON_CALL(callbacks_.route_->route_entry_, timeout())
+        .WillByDefault(Return(std::chrono::milliseconds(0)));
+    ON_CALL(*hedge_pool_.host_, locality()).WillByDefault(ReturnRef(upstream_locality_));
+  }
+
+  // Send a request which waits for a connection from the first pool, and arm the hedge timer.
+  void sendRequest(bool with_body = false) {
+    EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+        .WillOnce(Invoke(
+            [&](Http::StreamDecoder& decoder, Http::ConnectionPool::Callbacks& callbacks)
+                -> Http::ConnectionPool::Cancellable* {
+              response_decoder_ = &decoder;
+              pool_callbacks_ = &callbacks;
+              return &cancellable_;
+            }));
+    hedge_timer_ = new Event::MockTimer(&callbacks_.dispatcher_);
+    EXPECT_CALL(*hedge_timer_, enableTimer(std::chrono::milliseconds(10)));
+
+    HttpTestUtility::addDefaultHeaders(headers_);
+    if (!with_body) {
+      router_.decodeHeaders(headers_, true);
+      return;
+    }
+
+    router_.decodeHeaders(headers_, false);
+    Buffer::OwnedImpl data("hello");
+    EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, router_.decodeData(data, true));
+  }
+
+  // Fire the hedge timer, which sends the request again through hedge_pool_.
+  void sendHedgedRequest() {
+    EXPECT_CALL(cm_, httpConnPoolForCluster(_, _, _)).WillOnce(Return(&hedge_pool_));
+    EXPECT_CALL(hedge_pool_, newStream(_, _))
+        .WillOnce(Invoke(
+            [&](Http::StreamDecoder& decoder, Http::ConnectionPool::Callbacks& callbacks)
+                -> Http::ConnectionPool::Cancellable* {
+              hedge_decoder_ = &decoder;
+              callbacks.onPoolReady(hedge_encoder_, hedge_pool_.host_);
+              return nullptr;
+            }));
+    hedge_timer_->callback_();
+    EXPECT_EQ(1UL, stats_store_.counter("test.rq_hedged").value());
+  }
+
+  Http::TestHeaderMapImpl headers_;
+  NiceMock<Http::ConnectionPool::MockInstance> hedge_pool_;
+  NiceMock<Http::MockStreamEncoder> hedge_encoder_;
+  Http::StreamDecoder* response_decoder_{};
+  Http::StreamDecoder* hedge_decoder_{};
+  Http::ConnectionPool::Callbacks* pool_callbacks_{};
+  Event::MockTimer* hedge_timer_{};
+};
+
+TEST_F(RouterHedgingTest, HedgedRequestWins) {
+  sendRequest();
+  sendHedgedRequest();
+
+  EXPECT_CALL(cancellable_, cancel());
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, true));
+  EXPECT_CALL(hedge_pool_.host_->outlier_detector_, putHttpResponseCode(200));
+  Http::HeaderMapPtr response_headers(new Http::TestHeaderMapImpl{{":status", "200"}});
+  hedge_decoder_->decodeHeaders(std::move(response_headers), true);
+  EXPECT_EQ(1UL, stats_store_.counter("test.rq_hedge_won").value());
+  EXPECT_EQ(1UL, hedge_pool_.host_->stats().rq_success_.value());
+}
+
+TEST_F(RouterHedgingTest, FirstRequestWins) {
+  sendRequest();
+  sendHedgedRequest();
+
+  NiceMock<Http::MockStreamEncoder> encoder;
+  pool_callbacks_->onPoolReady(encoder, cm_.conn_pool_.host_);
+  EXPECT_CALL(hedge_encoder_.stream_, resetStream(Http::StreamResetReason::LocalReset));
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, true));
+  Http::HeaderMapPtr response_headers(new Http::TestHeaderMapImpl{{":status", "200"}});
+  response_decoder_->decodeHeaders(std::move(response_headers), true);
+  EXPECT_EQ(0UL, stats_store_.counter("test.rq_hedge_won").value());
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
+}
+
+TEST_F(RouterHedgingTest, FailedAttemptIsAbandoned) {
+  sendRequest();
+  sendHedgedRequest();
+
+  // The first request fails, but the downstream request carries on with the hedged one.
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, _)).Times(0);
+  EXPECT_CALL(cm_.conn_pool_.host_->outlier_detector_, putHttpResponseCode(503));
+  pool_callbacks_->onPoolFailure(Http::ConnectionPool::PoolFailureReason::ConnectionFailure,
+                                 cm_.conn_pool_.host_);
+  testing::Mock::VerifyAndClearExpectations(&callbacks_);
+
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, true));
+  Http::HeaderMapPtr response_headers(new Http::TestHeaderMapImpl{{":status", "200"}});
+  hedge_decoder_->decodeHeaders(std::move(response_headers), true);
+  EXPECT_EQ(0UL, stats_store_.counter("test.rq_hedge_won").value());
+}
+
+TEST_F(RouterHedgingTest, HedgedRequestReplaysBody) {
+  sendRequest(true);
+  EXPECT_CALL(hedge_encoder_, encodeHeaders(_, false));
+  EXPECT_CALL(hedge_encoder_, encodeData(BufferStringEqual("hello"), true));
+  sendHedgedRequest();
+
+  EXPECT_CALL(hedge_encoder_.stream_, resetStream(Http::StreamResetReason::LocalReset));
+  EXPECT_CALL(cancellable_, cancel());
+  router_.onDestroy();
+}
+
+TEST_F(RouterHedgingTest, SameHostNotHedged) {
+  sendRequest();
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _)).Times(0);
+  hedge_timer_->callback_();
+  EXPECT_EQ(0UL, stats_store_.counter("test.rq_hedged").value());
+
+  EXPECT_CALL(cancellable_, cancel());
+  router_.onDestroy();
+}
+
 TEST(RouterFilterUtilityTest, finalTimeout) {
   {
     NiceMock<MockRouteEntry> route;
@@ -1608,6 +1966,132 @@ TEST(RouterFilterUtilityTest, shouldShadow) {
   }
 }
 
+TEST(RouterFilterUtilityTest, collapsingKey) {
+  NiceMock<MockRouteEntry> route;
+  std::string key;
+  {
+    Http::TestHeaderMapImpl headers;
+    HttpTestUtility::addDefaultHeaders(headers);
+    EXPECT_FALSE(FilterUtility::collapsingKey(route, headers, true, key));
+  }
+
+  route.opaque_config_.emplace("collapse_requests", "true");
+  {
+    Http::TestHeaderMapImpl headers;
+    HttpTestUtility::addDefaultHeaders(headers);
+    EXPECT_TRUE(FilterUtility::collapsingKey(route, headers, true, key));
+    EXPECT_FALSE(FilterUtility::collapsingKey(route, headers, false, key));
+  }
+  {
+    Http::TestHeaderMapImpl headers{{":method", "POST"}, {":path", "/"}, {":authority", "host"}};
+    EXPECT_FALSE(FilterUtility::collapsingKey(route, headers, true, key));
+  }
+  {
+    Http::TestHeaderMapImpl headers{{"cookie", "a=b"}};
+    HttpTestUtility::addDefaultHeaders(headers);
+    EXPECT_FALSE(FilterUtility::collapsingKey(route, headers, true, key));
+  }
+
+  route.opaque_config_.emplace("collapse_key_headers", "Cookie,x-tenant");
+  {
+    Http::TestHeaderMapImpl headers1{{"cookie", "a=b"}, {"x-tenant", "1"}};
+    HttpTestUtility::addDefaultHeaders(headers1);
+    std::string key1;
+    EXPECT_TRUE(FilterUtility::collapsingKey(route, headers1, true, key1));
+
+    Http::TestHeaderMapImpl headers2{{"cookie", "a=c"}, {"x-tenant", "1"}};
+    HttpTestUtility::addDefaultHeaders(headers2);
+    std::string key2;
+    EXPECT_TRUE(FilterUtility::collapsingKey(route, headers2, true, key2));
+    EXPECT_NE(key1, key2);
+
+    Http::TestHeaderMapImpl headers3{{"cookie", "a=b"}, {"x-tenant", "1"}};
+    HttpTestUtility::addDefaultHeaders(headers3);
+    std::string key3;
+    EXPECT_TRUE(FilterUtility::collapsingKey(route, headers3, true, key3));
+    EXPECT_EQ(key1, key3);
+  }
+  {
+    Http::TestHeaderMapImpl headers{{"authorization", "secret"}};
+    HttpTestUtility::addDefaultHeaders(headers);
+    EXPECT_FALSE(FilterUtility::collapsingKey(route, headers, true, key));
+  }
+}
+
+TEST(RouterFilterUtilityTest, hedgeDelay) {
+  NiceMock<MockRouteEntry> route;
+  EXPECT_EQ(std::chrono::milliseconds(0), FilterUtility::hedgeDelay(route));
+
+  route.opaque_config_.emplace("hedge_delay_ms", "25");
+  EXPECT_EQ(std::chrono::milliseconds(25), FilterUtility::hedgeDelay(route));
+
+  EXPECT_CALL(route, hashPolicy()).WillOnce(Return(&route.hash_policy_));
+  EXPECT_EQ(std::chrono::milliseconds(0), FilterUtility::hedgeDelay(route));
+
+  route.opaque_config_.clear();
+  route.opaque_config_.emplace("hedge_delay_ms", "soon");
+  EXPECT_EQ(std::chrono::milliseconds(0), FilterUtility::hedgeDelay(route));
+}
+
+TEST(RouterFilterUtilityTest, retryBufferLimit) {
+  NiceMock<MockRouteEntry> route;
+  EXPECT_EQ(1024U, FilterUtility::retryBufferLimit(route, 1024));
+  EXPECT_EQ(0U, FilterUtility::retryBufferLimit(route, 0));
+
+  route.opaque_config_.emplace("retry_buffer_limit_bytes", "4096");
+  EXPECT_EQ(4096U, FilterUtility::retryBufferLimit(route, 1024));
+
+  route.opaque_config_.clear();
+  route.opaque_config_.emplace("retry_buffer_limit_bytes", "lots");
+  EXPECT_EQ(1024U, FilterUtility::retryBufferLimit(route, 1024));
+}
+
+TEST(RouterFilterUtilityTest, allowEarlyData) {
+  NiceMock<MockRouteEntry> route;
+  EXPECT_TRUE(FilterUtility::allowEarlyData(route));
+
+  route.opaque_config_.emplace("allow_early_data", "true");
+  EXPECT_TRUE(FilterUtility::allowEarlyData(route));
+
+  route.opaque_config_.clear();
+  route.opaque_config_.emplace("allow_early_data", "false");
+  EXPECT_FALSE(FilterUtility::allowEarlyData(route));
+}
+
+TEST_F(RouterTest, RetryBufferLimitExceeded) {
+  callbacks_.route_->route_entry_.opaque_config_.emplace("retry_buffer_limit_bytes", "8");
+  NiceMock<Http::MockStreamEncoder> encoder;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder&, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        callbacks.onPoolReady(encoder, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+
+  Http::TestHeaderMapImpl headers{{"x-envoy-retry-on", "5xx"}, {"x-envoy-internal", "true"}};
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, false);
+
+  // The first chunk is retained and referenced by the upstream request.
+  EXPECT_CALL(*router_.retry_state_, enabled()).WillOnce(Return(true));
+  Buffer::OwnedImpl data1("hello");
+  EXPECT_CALL(encoder, encodeData(BufferStringEqual("hello"), false));
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, router_.decodeData(data1, false));
+  EXPECT_EQ(0U, data1.length());
+
+  // The second one takes the body over the route's limit, so retries are given up on.
+  EXPECT_CALL(*router_.retry_state_, enabled()).WillOnce(Return(true));
+  Buffer::OwnedImpl data2("world");
+  EXPECT_CALL(encoder, encodeData(BufferStringEqual("world"), false));
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, router_.decodeData(data2, false));
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("retry_or_shadow_abandoned")
+                    .value());
+
+  EXPECT_CALL(encoder.stream_, resetStream(Http::StreamResetReason::LocalReset));
+  router_.onDestroy();
+}
+
 TEST_F(RouterTest, CanaryStatusTrue) {
   EXPECT_CALL(callbacks_.route_->route_entry_, timeout())
       .WillOnce(Return(std::chrono::milliseconds(0)));
@@ -5,12 +5,20 @@
 #include "common/http/message_impl.h"
 #include "common/router/shadow_writer_impl.h"
 
+#include "test/mocks/buffer/mocks.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/http/mocks.h"
 #include "test/mocks/upstream/mocks.h"
+#include "test/test_common/utility.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::DoAll;
 using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::SaveArg;
 using testing::_;
 
 namespace Envoy {
@@ -59,5 +67,124 @@ TEST(ShadowWriterImplTest, All) {
   callback->onFailure(Http::AsyncClient::FailureReason::Reset);
 }
 
+class ShadowStreamImplTest : public testing::Test {
+public:
+  ShadowStreamImplTest() { headers_.insertHost().value(std::string("cluster1")); }
+
+  ShadowStream* start(uint32_t buffer_limit) {
+    flush_timer_ = new Event::MockTimer(&cm_.async_client_.dispatcher_);
+    EXPECT_CALL(cm_, httpAsyncClientForCluster("foo"));
+    EXPECT_CALL(cm_.async_client_,
+                start(_, Optional<std::chrono::milliseconds>(std::chrono::milliseconds(5)), false))
+        .WillOnce(DoAll(SaveArg<0>(&callbacks_), Return(&stream_)));
+    EXPECT_CALL(stream_, sendHeaders(_, false))
+        .WillOnce(Invoke([](Http::HeaderMap& headers, bool) -> void {
+          EXPECT_STREQ("cluster1-shadow", headers.Host()->value().c_str());
+        }));
+    ON_CALL(stream_, reset()).WillByDefault(Invoke([this]() -> void { callbacks_->onReset(); }));
+    return writer_.streamShadow("foo", headers_, std::chrono::milliseconds(5), buffer_limit);
+  }
+
+  uint64_t overflows() {
+    return cm_.thread_local_cluster_.cluster_.info_->stats_.upstream_rq_shadow_overflow_.value();
+  }
+
+  bool deleted() { return cm_.async_client_.dispatcher_.to_delete_.size() == 1; }
+
+  NiceMock<Upstream::MockClusterManager> cm_;
+  ShadowWriterImpl writer_{cm_};
+  Http::TestHeaderMapImpl headers_;
+  Event::MockTimer* flush_timer_{};
+  Http::MockAsyncClientStream stream_;
+  Http::AsyncClient::StreamCallbacks* callbacks_{};
+};
+
+TEST_F(ShadowStreamImplTest, Streaming) {
+  ShadowStream* shadow = start(0);
+
+  Buffer::OwnedImpl data("hello");
+  EXPECT_CALL(stream_, sendData(BufferStringEqual("hello"), false));
+  shadow->sendData(data, false);
+  EXPECT_EQ(5U, data.length());
+
+  EXPECT_CALL(stream_, sendData(BufferStringEqual("hello"), true));
+  shadow->sendData(data, true);
+
+  EXPECT_FALSE(deleted());
+  callbacks_->onHeaders(Http::HeaderMapPtr{new Http::TestHeaderMapImpl{{":status", "200"}}},
+                        true);
+  EXPECT_TRUE(deleted());
+}
+
+TEST_F(ShadowStreamImplTest, BackedUp) {
+  ShadowStream* shadow = start(16);
+
+  callbacks_->onAboveWriteBufferHighWatermark();
+  Buffer::OwnedImpl data("hello");
+  EXPECT_CALL(stream_, sendData(_, _)).Times(0);
+  shadow->sendData(data, false);
+  shadow->sendData(data, false);
+  shadow->sendTrailers(Http::TestHeaderMapImpl{{"some", "trailer"}});
+
+  // The held body and the trailers are sent once the shadow upstream drains.
+  EXPECT_CALL(*flush_timer_, enableTimer(std::chrono::milliseconds(0)));
+  callbacks_->onBelowWriteBufferLowWatermark();
+  EXPECT_CALL(stream_, sendData(BufferStringEqual("hellohello"), false));
+  EXPECT_CALL(stream_, sendTrailers(_));
+  flush_timer_->callback_();
+
+  callbacks_->onData(data, true);
+  EXPECT_TRUE(deleted());
+  EXPECT_EQ(0U, overflows());
+}
+
+TEST_F(ShadowStreamImplTest, Overflow) {
+  ShadowStream* shadow = start(8);
+
+  callbacks_->onAboveWriteBufferHighWatermark();
+  Buffer::OwnedImpl data("hello");
+  EXPECT_CALL(stream_, sendData(_, _)).Times(0);
+  shadow->sendData(data, false);
+  EXPECT_CALL(stream_, reset());
+  shadow->sendData(data, false);
+  EXPECT_EQ(1U, overflows());
+
+  // The rest of the request is dropped.
+  shadow->sendData(data, false);
+  EXPECT_FALSE(deleted());
+  shadow->sendData(data, true);
+  EXPECT_TRUE(deleted());
+}
+
+TEST_F(ShadowStreamImplTest, EarlyResponse) {
+  ShadowStream* shadow = start(0);
+
+  // The shadow upstream responds before the request is complete, so the stream is reset outside of
+  // its callbacks.
+  EXPECT_CALL(*flush_timer_, enableTimer(std::chrono::milliseconds(0)));
+  callbacks_->onHeaders(Http::HeaderMapPtr{new Http::TestHeaderMapImpl{{":status", "400"}}},
+                        true);
+  EXPECT_CALL(stream_, reset());
+  flush_timer_->callback_();
+
+  Buffer::OwnedImpl data("hello");
+  EXPECT_CALL(stream_, sendData(_, _)).Times(0);
+  shadow->sendData(data, true);
+  EXPECT_TRUE(deleted());
+}
+
+TEST_F(ShadowStreamImplTest, Reset) {
+  ShadowStream* shadow = start(0);
+
+  EXPECT_CALL(stream_, reset());
+  shadow->reset();
+  EXPECT_TRUE(deleted());
+}
+
+TEST_F(ShadowStreamImplTest, NoCluster) {
+  EXPECT_CALL(cm_, get("foo")).WillOnce(Return(nullptr));
+  EXPECT_EQ(nullptr, writer_.streamShadow("foo", headers_, std::chrono::milliseconds(5), 0));
+}
+
 } // namespace Router
 } // namespace Envoy
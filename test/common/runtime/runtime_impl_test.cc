@@ -14,10 +14,12 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::DoAll;
 using testing::Invoke;
 using testing::NiceMock;
+using testing::Ref;
 using testing::Return;
-using testing::ReturnNew;
+using testing::SaveArg;
 using testing::_;
 
 namespace Envoy {
@@ -52,6 +54,21 @@ TEST(UUID, checkLengthOfUUID) {
   EXPECT_EQ(expected_length, result.length());
 }
 
+TEST(UUID, inPlace) {
+  RandomGeneratorImpl random;
+
+  char buffer[RandomGenerator::UUID_LENGTH + 1];
+  buffer[RandomGenerator::UUID_LENGTH] = 'x';
+  random.uuid(buffer);
+
+  // Only the uuid is written, and it is formatted like the allocated ones.
+  EXPECT_EQ('x', buffer[RandomGenerator::UUID_LENGTH]);
+  const std::string uuid(buffer, RandomGenerator::UUID_LENGTH);
+  EXPECT_EQ('-', uuid[8]);
+  EXPECT_EQ('4', uuid[14]);
+  EXPECT_NE(uuid, random.uuid());
+}
+
 TEST(UUID, sanityCheckOfUniqueness) {
   std::set<std::string> uuids;
   const size_t num_of_uuids = 100000;
@@ -73,7 +90,11 @@ public:
 
   void setup() {
     EXPECT_CALL(dispatcher, createFilesystemWatcher_())
-        .WillOnce(ReturnNew<NiceMock<Filesystem::MockWatcher>>());
+        .WillOnce(Invoke([this]() -> Filesystem::Watcher* {
+          Filesystem::MockWatcher* watcher = new NiceMock<Filesystem::MockWatcher>();
+          EXPECT_CALL(*watcher, addWatch(_, _, _)).WillOnce(SaveArg<2>(&on_changed_cb_));
+          return watcher;
+        }));
 
     os_sys_calls_ = new NiceMock<Api::MockOsSysCalls>;
     ON_CALL(*os_sys_calls_, stat(_, _))
@@ -83,12 +104,15 @@ public:
 
   void run(const std::string& primary_dir, const std::string& override_dir) {
     Api::OsSysCallsPtr os_sys_calls(os_sys_calls_);
-    loader.reset(new LoaderImpl(dispatcher, tls, TestEnvironment::temporaryPath(primary_dir),
-                                "envoy", override_dir, store, generator, std::move(os_sys_calls)));
+    loader.reset(new LoaderImpl(dispatcher, tls, api,
+                                TestEnvironment::temporaryPath(primary_dir), "envoy", override_dir,
+                                store, generator, std::move(os_sys_calls)));
   }
 
   Event::MockDispatcher dispatcher;
   NiceMock<ThreadLocal::MockInstance> tls;
+  NiceMock<Api::MockApi> api;
+  Filesystem::Watcher::OnChangedCb on_changed_cb_;
   NiceMock<Api::MockOsSysCalls>* os_sys_calls_{};
 
   Stats::IsolatedStoreImpl store;
@@ -132,6 +156,9 @@ TEST_F(RuntimeImplTest, All) {
 
   // Overrides from override dir
   EXPECT_EQ("hello override", loader->snapshot().get("file1"));
+
+  // The first snapshot has version 1, and each later one increments it.
+  EXPECT_EQ(1UL, loader->snapshot().version());
 }
 
 TEST_F(RuntimeImplTest, BadDirectory) {
@@ -153,6 +180,96 @@ TEST_F(RuntimeImplTest, OverrideFolderDoesNotExist) {
   EXPECT_EQ("hello", loader->snapshot().get("file1"));
 }
 
+// Snapshots are reloaded on the thread pool when the symlink is swapped, and only the latest one
+// is kept.
+TEST_F(RuntimeImplTest, SymlinkSwap) {
+  setup();
+  run("test/common/runtime/test_data/current", "envoy_override");
+  EXPECT_EQ(1U, loader->snapshot().version());
+
+  std::function<void()> work1, on_complete1, work2, on_complete2;
+  EXPECT_CALL(api, runOnThreadPool(_, Ref(dispatcher), _))
+      .WillOnce(DoAll(SaveArg<0>(&work1), SaveArg<2>(&on_complete1)))
+      .WillOnce(DoAll(SaveArg<0>(&work2), SaveArg<2>(&on_complete2)));
+  on_changed_cb_(Filesystem::Watcher::Events::MovedTo);
+  on_changed_cb_(Filesystem::Watcher::Events::MovedTo);
+
+  work1();
+  work2();
+  EXPECT_EQ(1U, loader->snapshot().version());
+  on_complete2();
+  EXPECT_EQ(3U, loader->snapshot().version());
+  EXPECT_EQ("world", loader->snapshot().get("file2"));
+  on_complete1();
+  EXPECT_EQ(3U, loader->snapshot().version());
+}
+
+// A reload shares the entries of the files which haven't changed since the previous snapshot.
+TEST_F(RuntimeImplTest, IncrementalReload) {
+  setup();
+  time_t age = 10;
+  ON_CALL(*os_sys_calls_, stat(_, _))
+      .WillByDefault(Invoke([&age](const char* filename, struct stat* stat) {
+        const int rc = ::stat(filename, stat);
+        stat->st_mtime -= age;
+        return rc;
+      }));
+  run("test/common/runtime/test_data/current", "envoy_override");
+  const uint64_t files = store.counter("runtime.files_read").value();
+  EXPECT_LT(0U, files);
+  EXPECT_EQ(0U, store.counter("runtime.files_reused").value());
+
+  std::function<void()> work, on_complete;
+  EXPECT_CALL(api, runOnThreadPool(_, Ref(dispatcher), _))
+      .WillRepeatedly(DoAll(SaveArg<0>(&work), SaveArg<2>(&on_complete)));
+  on_changed_cb_(Filesystem::Watcher::Events::MovedTo);
+  work();
+  on_complete();
+
+  // Only the files shadowed by the override directory are read again.
+  const uint64_t reused = store.counter("runtime.files_reused").value();
+  EXPECT_LT(0U, reused);
+  EXPECT_EQ(files * 2, store.counter("runtime.files_read").value() + reused);
+  EXPECT_EQ("world", loader->snapshot().get("file2"));
+  EXPECT_EQ(123UL, loader->snapshot().getInteger("file4", 1));
+  EXPECT_EQ("hello override", loader->snapshot().get("file1"));
+
+  // Files whose modification time changed are read again.
+  age = 5;
+  on_changed_cb_(Filesystem::Watcher::Events::MovedTo);
+  work();
+  on_complete();
+  EXPECT_EQ(reused, store.counter("runtime.files_reused").value());
+  EXPECT_EQ(files * 3, store.counter("runtime.files_read").value() + reused);
+  EXPECT_EQ("world", loader->snapshot().get("file2"));
+  EXPECT_EQ(3U, loader->snapshot().version());
+}
+
+// Resolved keys find the same values as their names, whether they were registered before or after
+// the snapshot was loaded.
+TEST_F(RuntimeImplTest, ResolvedKeys) {
+  const Key file3 = KeyRegistry::registerKey("file3");
+  setup();
+  run("test/common/runtime/test_data/current", "envoy_override");
+  const Key file4 = KeyRegistry::registerKey("file4");
+  const Key invalid = KeyRegistry::registerKey("resolved_keys.invalid");
+
+  EXPECT_EQ(file3.index(), KeyRegistry::registerKey("file3").index());
+  EXPECT_NE(file3.index(), file4.index());
+
+  EXPECT_EQ(2UL, loader->snapshot().getInteger(file3, 1));
+  EXPECT_EQ(123UL, loader->snapshot().getInteger(file4, 1));
+  EXPECT_EQ(1UL, loader->snapshot().getInteger(invalid, 1));
+  EXPECT_EQ(1UL, loader->snapshot().getInteger(KeyRegistry::registerKey("file2"), 1));
+
+  EXPECT_CALL(generator, random()).WillOnce(Return(1));
+  EXPECT_TRUE(loader->snapshot().featureEnabled(file3, 1));
+  EXPECT_TRUE(loader->snapshot().featureEnabled(file3, 1, 1));
+  EXPECT_FALSE(loader->snapshot().featureEnabled(file3, 1, 3));
+  EXPECT_FALSE(loader->snapshot().featureEnabled(file4, 1, 200, 300));
+  EXPECT_TRUE(loader->snapshot().featureEnabled(file4, 1, 122, 300));
+}
+
 TEST(NullRuntimeImplTest, All) {
   MockRandomGenerator generator;
   NullLoaderImpl loader(generator);
@@ -160,6 +277,7 @@ TEST(NullRuntimeImplTest, All) {
   EXPECT_EQ(1UL, loader.snapshot().getInteger("foo", 1));
   EXPECT_CALL(generator, random()).WillOnce(Return(49));
   EXPECT_TRUE(loader.snapshot().featureEnabled("foo", 50));
+  EXPECT_EQ(1UL, loader.snapshot().getInteger(KeyRegistry::registerKey("foo"), 1));
 }
 
 } // namespace Runtime
@@ -1,5 +1,7 @@
 #include <string>
 
+#include "envoy/http/header_map.h"
+
 #include "common/runtime/runtime_impl.h"
 #include "common/runtime/uuid_util.h"
 
@@ -33,6 +35,17 @@ TEST(UUIDUtilsTest, mod) {
 
   EXPECT_TRUE(UuidUtils::uuidModBy("ffffffff-0012-0110-00ff-0c00400600ff", result, 10000));
   EXPECT_EQ(7295, result);
+
+  EXPECT_TRUE(UuidUtils::uuidModBy("FFFFFFFF-0012-0110-00FF-0C00400600FF", result, 10000));
+  EXPECT_EQ(7295, result);
+
+  EXPECT_FALSE(UuidUtils::uuidModBy("0000000g-0000-0000-0000-000000000000", result, 100));
+  EXPECT_FALSE(UuidUtils::uuidModBy("0000000", result, 100));
+
+  const char* uuid = "000000ff-0000-0000-0000-000000000000";
+  EXPECT_TRUE(UuidUtils::uuidModBy(uuid, 8, result, 10000));
+  EXPECT_EQ(255, result);
+  EXPECT_FALSE(UuidUtils::uuidModBy(uuid, 7, result, 10000));
 }
 
 TEST(UUIDUtilsTest, checkDistribution) {
@@ -70,6 +83,29 @@ TEST(UUIDUtilsTest, DISABLED_benchmark) {
   }
 }
 
+// Compares setting x-request-id from an allocated uuid with writing the uuid in place, as the
+// connection manager does.
+TEST(UUIDUtilsTest, DISABLED_benchmarkHeaderCopy) {
+  Runtime::RandomGeneratorImpl random;
+  Http::HeaderString value;
+
+  for (int i = 0; i < 100000000; ++i) {
+    const std::string uuid = random.uuid();
+    value.setCopy(uuid.c_str(), uuid.size());
+  }
+}
+
+TEST(UUIDUtilsTest, DISABLED_benchmarkHeaderInPlace) {
+  Runtime::RandomGeneratorImpl random;
+  Http::HeaderString value;
+
+  for (int i = 0; i < 100000000; ++i) {
+    char uuid[Runtime::RandomGenerator::UUID_LENGTH];
+    random.uuid(uuid);
+    value.setCopy(uuid, Runtime::RandomGenerator::UUID_LENGTH);
+  }
+}
+
 TEST(UUIDUtilsTest, setAndCheckTraceable) {
   Runtime::RandomGeneratorImpl random;
 
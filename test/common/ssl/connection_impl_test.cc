@@ -40,13 +40,15 @@ namespace {
 void testUtil(const std::string& client_ctx_json, const std::string& server_ctx_json,
               const std::string& expected_digest, const std::string& expected_uri,
               const std::string& expected_stats, bool expect_success,
-              const Network::Address::IpVersion version) {
+              const Network::Address::IpVersion version,
+              PrivateKeyMethodProviderSharedPtr private_key_method_provider = nullptr) {
   Stats::IsolatedStoreImpl stats_store;
   Runtime::MockLoader runtime;
 
   Json::ObjectSharedPtr server_ctx_loader = TestEnvironment::jsonLoadFromString(server_ctx_json);
   ServerContextConfigImpl server_ctx_config(*server_ctx_loader);
   ContextManagerImpl manager(runtime);
+  manager.setPrivateKeyMethodProvider(private_key_method_provider);
   ServerContextPtr server_ctx(
       manager.createSslServerContext("", {}, stats_store, server_ctx_config, true));
 
@@ -77,6 +79,7 @@ void testUtil(const std::string& client_ctx_json, const std::string& server_ctx_
     EXPECT_CALL(server_connection_callbacks, onEvent(Network::ConnectionEvent::Connected))
         .WillOnce(Invoke([&](Network::ConnectionEvent) -> void {
           if (!expected_digest.empty()) {
+            EXPECT_TRUE(server_connection->ssl()->peerCertificatePresented());
             EXPECT_EQ(expected_digest, server_connection->ssl()->sha256PeerCertificateDigest());
           }
           EXPECT_EQ(expected_uri, server_connection->ssl()->uriSanPeerCertificate());
@@ -108,10 +111,12 @@ const std::string testUtilV2(const envoy::api::v2::Listener& server_proto,
                              const std::string& expected_client_cert_uri,
                              const std::string& expected_alpn_protocol,
                              const std::string& expected_stats, unsigned expected_stats_value,
-                             const Network::Address::IpVersion version) {
+                             const Network::Address::IpVersion version,
+                             bool lazy_certificate_loading = false) {
   Stats::IsolatedStoreImpl stats_store;
   Runtime::MockLoader runtime;
   ContextManagerImpl manager(runtime);
+  manager.setLazyCertificateLoading(lazy_certificate_loading);
   std::string new_session = EMPTY_STRING;
 
   std::vector<ServerContextPtr> server_contexts;
@@ -249,6 +254,52 @@ TEST_P(SslConnectionImplTest, GetCertDigest) {
            true, GetParam());
 }
 
+TEST_P(SslConnectionImplTest, PrivateKeyOperationOffloaded) {
+  std::string client_ctx_json = R"EOF(
+  {
+    "cert_chain_file": "{{ test_rundir }}/test/common/ssl/test_data/no_san_cert.pem",
+    "private_key_file": "{{ test_rundir }}/test/common/ssl/test_data/no_san_key.pem"
+  }
+  )EOF";
+
+  std::string server_ctx_json = R"EOF(
+  {
+    "cert_chain_file": "{{ test_tmpdir }}/unittestcert.pem",
+    "private_key_file": "{{ test_tmpdir }}/unittestkey.pem",
+    "ca_cert_file": "{{ test_rundir }}/test/common/ssl/test_data/ca_cert.pem"
+  }
+  )EOF";
+
+  testUtil(client_ctx_json, server_ctx_json,
+           "4444fbca965d916475f04fb4dd234dd556adb028ceb4300fa8ad6f2983c6aaa3", "",
+           "ssl.private_key_operation_offloaded", true, GetParam(),
+           std::make_shared<ThreadPoolPrivateKeyMethodProvider>(1));
+}
+
+// With RSA key exchange the offloaded operation is a decryption rather than a signature.
+TEST_P(SslConnectionImplTest, PrivateKeyOperationOffloadedRsaKeyExchange) {
+  std::string client_ctx_json = R"EOF(
+  {
+    "cert_chain_file": "{{ test_rundir }}/test/common/ssl/test_data/no_san_cert.pem",
+    "private_key_file": "{{ test_rundir }}/test/common/ssl/test_data/no_san_key.pem"
+  }
+  )EOF";
+
+  std::string server_ctx_json = R"EOF(
+  {
+    "cert_chain_file": "{{ test_tmpdir }}/unittestcert.pem",
+    "private_key_file": "{{ test_tmpdir }}/unittestkey.pem",
+    "ca_cert_file": "{{ test_rundir }}/test/common/ssl/test_data/ca_cert.pem",
+    "cipher_suites": "AES128-SHA"
+  }
+  )EOF";
+
+  testUtil(client_ctx_json, server_ctx_json,
+           "4444fbca965d916475f04fb4dd234dd556adb028ceb4300fa8ad6f2983c6aaa3", "",
+           "ssl.private_key_operation_offloaded", true, GetParam(),
+           std::make_shared<ThreadPoolPrivateKeyMethodProvider>(1));
+}
+
 TEST_P(SslConnectionImplTest, GetCertDigestServerCertWithoutCommonName) {
   std::string client_ctx_json = R"EOF(
   {
@@ -958,6 +1009,151 @@ TEST_P(SslConnectionImplTest, ClientAuthCrossListenerSessionResumption) {
   EXPECT_EQ(0UL, stats_store.counter("ssl.session_reused").value());
 }
 
+// Sessions are cached per upstream by the client context, and resumed by its next connection to
+// the same upstream.
+TEST_P(SslConnectionImplTest, UpstreamSessionResumption) {
+  Stats::IsolatedStoreImpl stats_store;
+  Runtime::MockLoader runtime;
+
+  std::string server_ctx_json = R"EOF(
+  {
+    "cert_chain_file": "{{ test_tmpdir }}/unittestcert.pem",
+    "private_key_file": "{{ test_tmpdir }}/unittestkey.pem",
+    "session_ticket_key_paths": ["{{ test_rundir }}/test/common/ssl/test_data/ticket_key_a"]
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr server_ctx_loader = TestEnvironment::jsonLoadFromString(server_ctx_json);
+  ServerContextConfigImpl server_ctx_config(*server_ctx_loader);
+  ContextManagerImpl manager(runtime);
+  ServerContextPtr server_ctx(
+      manager.createSslServerContext("", {}, stats_store, server_ctx_config, true));
+
+  Event::DispatcherImpl dispatcher;
+  Network::TcpListenSocket socket(Network::Test::getCanonicalLoopbackAddress(GetParam()), true);
+  NiceMock<Network::MockListenerCallbacks> callbacks;
+  Network::MockConnectionHandler connection_handler;
+  Network::ListenerPtr listener =
+      dispatcher.createSslListener(connection_handler, *server_ctx, socket, callbacks, stats_store,
+                                   Network::ListenerOptions::listenerOptionsWithBindToPort());
+
+  Json::ObjectSharedPtr client_ctx_loader = TestEnvironment::jsonLoadFromString("{}");
+  ClientContextConfigImpl client_ctx_config(*client_ctx_loader);
+  ClientContextPtr client_ctx(manager.createSslClientContext(stats_store, client_ctx_config));
+  ClientContextImpl& client_ctx_impl = dynamic_cast<ClientContextImpl&>(*client_ctx);
+
+  for (uint64_t i = 0; i < 2; i++) {
+    Network::ClientConnectionPtr client_connection = dispatcher.createSslClientConnection(
+        *client_ctx, socket.localAddress(), Network::Address::InstanceConstSharedPtr());
+    Network::MockConnectionCallbacks client_connection_callbacks;
+    client_connection->addConnectionCallbacks(client_connection_callbacks);
+    client_connection->connect();
+
+    Network::ConnectionPtr server_connection;
+    Network::MockConnectionCallbacks server_connection_callbacks;
+    EXPECT_CALL(callbacks, onNewConnection_(_))
+        .WillOnce(Invoke([&](Network::ConnectionPtr& conn) -> void {
+          server_connection = std::move(conn);
+          server_connection->addConnectionCallbacks(server_connection_callbacks);
+        }));
+
+    // Wait until both sides are connected, so that the client has received its session.
+    unsigned connect_count = 0;
+    auto stopSecondTime = [&]() {
+      connect_count++;
+      if (connect_count == 2) {
+        client_connection->close(Network::ConnectionCloseType::NoFlush);
+        server_connection->close(Network::ConnectionCloseType::NoFlush);
+        dispatcher.exit();
+      }
+    };
+
+    EXPECT_CALL(server_connection_callbacks, onEvent(Network::ConnectionEvent::Connected))
+        .WillOnce(Invoke([&](Network::ConnectionEvent) -> void { stopSecondTime(); }));
+    EXPECT_CALL(client_connection_callbacks, onEvent(Network::ConnectionEvent::Connected))
+        .WillOnce(Invoke([&](Network::ConnectionEvent) -> void { stopSecondTime(); }));
+    EXPECT_CALL(client_connection_callbacks, onEvent(Network::ConnectionEvent::LocalClose));
+    EXPECT_CALL(server_connection_callbacks, onEvent(Network::ConnectionEvent::LocalClose));
+
+    dispatcher.run(Event::Dispatcher::RunType::Block);
+
+    EXPECT_EQ(1UL, client_ctx_impl.cachedSessions());
+    // One for client, one for server, on the second connection only.
+    EXPECT_EQ(2UL * i, stats_store.counter("ssl.session_reused").value());
+  }
+}
+
+TEST_P(SslConnectionImplTest, ClientAuthVerificationCache) {
+  Stats::IsolatedStoreImpl stats_store;
+  Runtime::MockLoader runtime;
+
+  std::string server_ctx_json = R"EOF(
+  {
+    "cert_chain_file": "{{ test_tmpdir }}/unittestcert.pem",
+    "private_key_file": "{{ test_tmpdir }}/unittestkey.pem",
+    "ca_cert_file": "{{ test_rundir }}/test/common/ssl/test_data/ca_cert.pem",
+    "verify_subject_alt_name": [ "spiffe://lyft.com/test-team" ]
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr server_ctx_loader = TestEnvironment::jsonLoadFromString(server_ctx_json);
+  ServerContextConfigImpl server_ctx_config(*server_ctx_loader);
+  ContextManagerImpl manager(runtime);
+  ServerContextPtr server_ctx(
+      manager.createSslServerContext("", {}, stats_store, server_ctx_config, true));
+  ContextImpl& server_ctx_impl = dynamic_cast<ContextImpl&>(*server_ctx);
+
+  Event::DispatcherImpl dispatcher;
+  Network::TcpListenSocket socket(Network::Test::getCanonicalLoopbackAddress(GetParam()), true);
+  NiceMock<Network::MockListenerCallbacks> callbacks;
+  Network::MockConnectionHandler connection_handler;
+  Network::ListenerPtr listener =
+      dispatcher.createSslListener(connection_handler, *server_ctx, socket, callbacks, stats_store,
+                                   Network::ListenerOptions::listenerOptionsWithBindToPort());
+
+  std::string client_ctx_json = R"EOF(
+  {
+    "cert_chain_file": "{{ test_rundir }}/test/common/ssl/test_data/san_uri_cert.pem",
+    "private_key_file": "{{ test_rundir }}/test/common/ssl/test_data/san_uri_key.pem"
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr client_ctx_loader = TestEnvironment::jsonLoadFromString(client_ctx_json);
+  ClientContextConfigImpl client_ctx_config(*client_ctx_loader);
+  ClientContextPtr client_ctx(manager.createSslClientContext(stats_store, client_ctx_config));
+
+  for (uint64_t i = 0; i < 2; i++) {
+    Network::ClientConnectionPtr client_connection = dispatcher.createSslClientConnection(
+        *client_ctx, socket.localAddress(), Network::Address::InstanceConstSharedPtr());
+    client_connection->connect();
+
+    Network::ConnectionPtr server_connection;
+    Network::MockConnectionCallbacks server_connection_callbacks;
+    EXPECT_CALL(callbacks, onNewConnection_(_))
+        .WillOnce(Invoke([&](Network::ConnectionPtr& conn) -> void {
+          server_connection = std::move(conn);
+          server_connection->addConnectionCallbacks(server_connection_callbacks);
+        }));
+
+    EXPECT_CALL(server_connection_callbacks, onEvent(Network::ConnectionEvent::Connected))
+        .WillOnce(Invoke([&](Network::ConnectionEvent) -> void {
+          EXPECT_EQ("spiffe://lyft.com/test-team",
+                    server_connection->ssl()->uriSanPeerCertificate());
+          client_connection->close(Network::ConnectionCloseType::NoFlush);
+          server_connection->close(Network::ConnectionCloseType::NoFlush);
+          dispatcher.exit();
+        }));
+    EXPECT_CALL(server_connection_callbacks, onEvent(Network::ConnectionEvent::LocalClose));
+
+    dispatcher.run(Event::Dispatcher::RunType::Block);
+
+    // The second connection presents the same certificate, which is trusted without verifying it.
+    EXPECT_EQ(1UL, server_ctx_impl.cachedVerifications());
+    EXPECT_EQ(i, stats_store.counter("ssl.verify_cache_hit").value());
+    EXPECT_EQ(0UL, stats_store.counter("ssl.session_reused").value());
+  }
+}
+
 TEST_P(SslConnectionImplTest, SslError) {
   Stats::IsolatedStoreImpl stats_store;
   Runtime::MockLoader runtime;
@@ -1092,6 +1288,50 @@ TEST_P(SslConnectionImplTest, ProtocolVersions) {
   testUtilV2(listener, client_ctx, "", true, "TLSv1.3", "", "", "", "ssl.handshake", 2, GetParam());
 }
 
+TEST_P(SslConnectionImplTest, EcdsaAndRsaCertificates) {
+  envoy::api::v2::Listener listener;
+  envoy::api::v2::FilterChain* filter_chain = listener.add_filter_chains();
+  envoy::api::v2::CommonTlsContext* server_ctx =
+      filter_chain->mutable_tls_context()->mutable_common_tls_context();
+
+  // san_dns_cert.pem: RSA, server1.example.com
+  envoy::api::v2::TlsCertificate* rsa_cert = server_ctx->add_tls_certificates();
+  rsa_cert->mutable_certificate_chain()->set_filename(
+      TestEnvironment::substitute("{{ test_rundir }}/test/common/ssl/test_data/san_dns_cert.pem"));
+  rsa_cert->mutable_private_key()->set_filename(
+      TestEnvironment::substitute("{{ test_rundir }}/test/common/ssl/test_data/san_dns_key.pem"));
+
+  // san_dns_ecdsa_cert.pem: ECDSA P-256, server1.example.com
+  envoy::api::v2::TlsCertificate* ecdsa_cert = server_ctx->add_tls_certificates();
+  ecdsa_cert->mutable_certificate_chain()->set_filename(TestEnvironment::substitute(
+      "{{ test_rundir }}/test/common/ssl/test_data/san_dns_ecdsa_cert.pem"));
+  ecdsa_cert->mutable_private_key()->set_filename(TestEnvironment::substitute(
+      "{{ test_rundir }}/test/common/ssl/test_data/san_dns_ecdsa_key.pem"));
+
+  envoy::api::v2::UpstreamTlsContext client_ctx;
+  envoy::api::v2::TlsParameters* client_params =
+      client_ctx.mutable_common_tls_context()->mutable_tls_params();
+
+  // Client with the default cipher suites supports ECDSA, and receives san_dns_ecdsa_cert.pem.
+  testUtilV2(listener, client_ctx, "", true, "",
+             "81fa0d437a78cf4b25399d60aa60aab0cab25feb6a8afb9ec7ae7b092d22b085", "", "",
+             "ssl.handshake", 2, GetParam());
+
+  // Client only offering RSA cipher suites receives san_dns_cert.pem.
+  client_params->add_cipher_suites("ECDHE-RSA-AES128-GCM-SHA256");
+  testUtilV2(listener, client_ctx, "", true, "",
+             "1406294e80c818158697d65d2aaca16748ff132442ab0e2f28bc1109f1d47a2e", "", "",
+             "ssl.handshake", 2, GetParam());
+
+  // With TLSv1.3, the cipher suites don't matter and the client receives san_dns_ecdsa_cert.pem.
+  client_params->set_tls_maximum_protocol_version(envoy::api::v2::TlsParameters::TLSv1_3);
+  server_ctx->mutable_tls_params()->set_tls_maximum_protocol_version(
+      envoy::api::v2::TlsParameters::TLSv1_3);
+  testUtilV2(listener, client_ctx, "", true, "TLSv1.3",
+             "81fa0d437a78cf4b25399d60aa60aab0cab25feb6a8afb9ec7ae7b092d22b085", "", "",
+             "ssl.handshake", 2, GetParam());
+}
+
 TEST_P(SslConnectionImplTest, SniCertificate) {
   envoy::api::v2::Listener listener;
 
@@ -1167,6 +1407,62 @@ TEST_P(SslConnectionImplTest, SniCertificate) {
              "ssl.handshake", 2, GetParam());
 }
 
+TEST_P(SslConnectionImplTest, LazySniCertificate) {
+  envoy::api::v2::Listener listener;
+
+  // san_dns_cert.pem: server1.example.com
+  envoy::api::v2::FilterChain* filter_chain1 = listener.add_filter_chains();
+  filter_chain1->mutable_filter_chain_match()->add_sni_domains("server1.example.com");
+  envoy::api::v2::TlsCertificate* server_cert1 =
+      filter_chain1->mutable_tls_context()->mutable_common_tls_context()->add_tls_certificates();
+  server_cert1->mutable_certificate_chain()->set_filename(
+      TestEnvironment::substitute("{{ test_rundir }}/test/common/ssl/test_data/san_dns_cert.pem"));
+  server_cert1->mutable_private_key()->set_filename(
+      TestEnvironment::substitute("{{ test_rundir }}/test/common/ssl/test_data/san_dns_key.pem"));
+
+  // san_multiple_dns_cert.pem: server2.example.com, *.example.com
+  envoy::api::v2::FilterChain* filter_chain2 = listener.add_filter_chains();
+  filter_chain2->mutable_filter_chain_match()->add_sni_domains("server2.example.com");
+  filter_chain2->mutable_filter_chain_match()->add_sni_domains("*.example.com");
+  envoy::api::v2::TlsCertificate* server_cert2 =
+      filter_chain2->mutable_tls_context()->mutable_common_tls_context()->add_tls_certificates();
+  server_cert2->mutable_certificate_chain()->set_filename(TestEnvironment::substitute(
+      "{{ test_rundir }}/test/common/ssl/test_data/san_multiple_dns_cert.pem"));
+  server_cert2->mutable_private_key()->set_filename(TestEnvironment::substitute(
+      "{{ test_rundir }}/test/common/ssl/test_data/san_multiple_dns_key.pem"));
+
+  // no_san_cert.pem: protected.example.com, with a private key that doesn't exist. This is only
+  // noticed once the context is selected.
+  envoy::api::v2::FilterChain* filter_chain3 = listener.add_filter_chains();
+  filter_chain3->mutable_filter_chain_match()->add_sni_domains("protected.example.com");
+  envoy::api::v2::TlsCertificate* server_cert3 =
+      filter_chain3->mutable_tls_context()->mutable_common_tls_context()->add_tls_certificates();
+  server_cert3->mutable_certificate_chain()->set_filename(
+      TestEnvironment::substitute("{{ test_rundir }}/test/common/ssl/test_data/no_san_cert.pem"));
+  server_cert3->mutable_private_key()->set_filename(
+      TestEnvironment::substitute("{{ test_rundir }}/test/common/ssl/test_data/missing_key.pem"));
+
+  envoy::api::v2::UpstreamTlsContext client_ctx;
+
+  // Connection to server1.example.com succeeds, client receives san_dns_cert.pem (exact match).
+  client_ctx.set_sni("server1.example.com");
+  testUtilV2(listener, client_ctx, "", true, "",
+             "1406294e80c818158697d65d2aaca16748ff132442ab0e2f28bc1109f1d47a2e", "", "",
+             "ssl.handshake", 2, GetParam(), true);
+
+  // Connection to www.example.com succeeds, client receives san_multiple_dns_cert.pem
+  // (wildcard match).
+  client_ctx.set_sni("www.example.com");
+  testUtilV2(listener, client_ctx, "", true, "",
+             "77b3c289abbded6ad508d9853ba0bd36a1f6a9680eaba01e0f32774c0676ebe8", "", "",
+             "ssl.handshake", 2, GetParam(), true);
+
+  // Connection to protected.example.com fails, since its private key can't be loaded.
+  client_ctx.set_sni("protected.example.com");
+  testUtilV2(listener, client_ctx, "", false, "", "", "", "", "ssl.fail_load_certificate", 1,
+             GetParam(), true);
+}
+
 TEST_P(SslConnectionImplTest, SniSessionResumption) {
   envoy::api::v2::Listener listener;
 
@@ -1773,6 +2069,70 @@ TEST_P(SslReadBufferLimitTest, WritesSmallerThanBufferLimit) { singleWriteTest(5
 
 TEST_P(SslReadBufferLimitTest, WritesLargerThanBufferLimit) { singleWriteTest(1024, 5 * 1024); }
 
+// Kernel TLS falls back to BoringSSL where it isn't supported, so the data arrives either way.
+TEST_P(SslReadBufferLimitTest, KernelTls) {
+  SslSocket::kernelTls(true);
+  readBufferLimitTest(0, 256 * 1024, 256 * 1024, 1, false);
+  SslSocket::kernelTls(false);
+  EXPECT_GE(2UL, stats_store_.counter("ssl.kernel_tls_tx").value());
+}
+
+// The client writes small records first, then ramps up to full size records.
+TEST_P(SslReadBufferLimitTest, DynamicRecordSizing) {
+  ContextConfigImpl::defaultInitialRecordSize(1000);
+  initialize(0);
+  ContextConfigImpl::defaultInitialRecordSize(0);
+
+  std::vector<uint32_t> record_sizes;
+  SSL* client_ssl = dynamic_cast<SslSocket*>(client_connection_->ssl())->rawSslForTest();
+  SSL_set_msg_callback_arg(client_ssl, &record_sizes);
+  SSL_set_msg_callback(client_ssl, [](int write_p, int, int content_type, const void* buf,
+                                      size_t len, SSL*, void* arg) -> void {
+    const uint8_t* header = static_cast<const uint8_t*>(buf);
+    if (write_p && content_type == SSL3_RT_HEADER && len == SSL3_RT_HEADER_LENGTH &&
+        header[0] == SSL3_RT_APPLICATION_DATA) {
+      static_cast<std::vector<uint32_t>*>(arg)->push_back((header[3] << 8) | header[4]);
+    }
+  });
+
+  EXPECT_CALL(listener_callbacks_, onNewConnection_(_))
+      .WillOnce(Invoke([&](Network::ConnectionPtr& conn) -> void {
+        server_connection_ = std::move(conn);
+        server_connection_->addConnectionCallbacks(server_callbacks_);
+        server_connection_->addReadFilter(read_filter_);
+      }));
+  EXPECT_CALL(client_callbacks_, onEvent(Network::ConnectionEvent::Connected))
+      .WillOnce(Invoke([&](Network::ConnectionEvent) -> void { dispatcher_->exit(); }));
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+
+  const uint32_t write_size = SslSocket::SMALL_RECORDS_BEFORE_RAMP * 1000 + 20000;
+  uint32_t filter_seen = 0;
+  EXPECT_CALL(*read_filter_, onNewConnection());
+  EXPECT_CALL(*read_filter_, onData(_))
+      .WillRepeatedly(Invoke([&](Buffer::Instance& data) -> Network::FilterStatus {
+        filter_seen += data.length();
+        data.drain(data.length());
+        if (filter_seen == write_size) {
+          server_connection_->close(Network::ConnectionCloseType::FlushWrite);
+        }
+        return Network::FilterStatus::StopIteration;
+      }));
+  EXPECT_CALL(client_callbacks_, onEvent(Network::ConnectionEvent::RemoteClose))
+      .WillOnce(Invoke([&](Network::ConnectionEvent) -> void { dispatcher_->exit(); }));
+
+  Buffer::OwnedImpl data(std::string(write_size, 'a'));
+  client_connection_->write(data);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+
+  EXPECT_EQ(write_size, filter_seen);
+  // The records also carry the cipher overhead.
+  ASSERT_EQ(SslSocket::SMALL_RECORDS_BEFORE_RAMP + 2, record_sizes.size());
+  for (uint32_t i = 0; i < SslSocket::SMALL_RECORDS_BEFORE_RAMP; i++) {
+    EXPECT_GE(1100U, record_sizes[i]);
+  }
+  EXPECT_LT(16384U, record_sizes[SslSocket::SMALL_RECORDS_BEFORE_RAMP]);
+}
+
 TEST_P(SslReadBufferLimitTest, TestBind) {
   std::string address_string = TestUtility::getIpv4Loopback();
   if (GetParam() == Network::Address::IpVersion::v4) {
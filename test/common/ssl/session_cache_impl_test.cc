@@ -0,0 +1,81 @@
+#include <string>
+
+#include "common/ssl/session_cache_impl.h"
+
+#include "gtest/gtest.h"
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Ssl {
+
+class SessionCacheImplTest : public testing::Test {
+public:
+  SessionCacheImplTest() : ctx_(SSL_CTX_new(TLS_method())) {}
+
+  bssl::UniquePtr<SSL_SESSION> newSession(const std::string& id) {
+    bssl::UniquePtr<SSL_SESSION> session(SSL_SESSION_new(ctx_.get()));
+    SSL_SESSION_set1_id(session.get(), reinterpret_cast<const uint8_t*>(id.data()), id.size());
+    return session;
+  }
+
+  bssl::UniquePtr<SSL_SESSION> lookup(SessionCacheImpl& cache, const std::string& id) {
+    return cache.lookup(reinterpret_cast<const uint8_t*>(id.data()), id.size());
+  }
+
+  bssl::UniquePtr<SSL_CTX> ctx_;
+};
+
+TEST_F(SessionCacheImplTest, InsertLookupRemove) {
+  SessionCacheImpl cache(100);
+  bssl::UniquePtr<SSL_SESSION> session = newSession("session1");
+  cache.insert(session.get());
+  EXPECT_EQ(1U, cache.size());
+
+  EXPECT_EQ(session.get(), lookup(cache, "session1").get());
+  EXPECT_EQ(nullptr, lookup(cache, "session2"));
+
+  cache.remove(session.get());
+  EXPECT_EQ(0U, cache.size());
+  EXPECT_EQ(nullptr, lookup(cache, "session1"));
+}
+
+TEST_F(SessionCacheImplTest, Replace) {
+  SessionCacheImpl cache(100);
+  bssl::UniquePtr<SSL_SESSION> old_session = newSession("session1");
+  bssl::UniquePtr<SSL_SESSION> new_session = newSession("session1");
+  cache.insert(old_session.get());
+  cache.insert(new_session.get());
+  EXPECT_EQ(1U, cache.size());
+  EXPECT_EQ(new_session.get(), lookup(cache, "session1").get());
+
+  // Removing the replaced session leaves the new one in place.
+  cache.remove(old_session.get());
+  EXPECT_EQ(new_session.get(), lookup(cache, "session1").get());
+}
+
+TEST_F(SessionCacheImplTest, EvictLeastRecentlyUsed) {
+  SessionCacheImpl cache(2, 1);
+  bssl::UniquePtr<SSL_SESSION> session1 = newSession("session1");
+  bssl::UniquePtr<SSL_SESSION> session2 = newSession("session2");
+  bssl::UniquePtr<SSL_SESSION> session3 = newSession("session3");
+  cache.insert(session1.get());
+  cache.insert(session2.get());
+
+  // Looking session1 up makes session2 the least recently used.
+  EXPECT_NE(nullptr, lookup(cache, "session1"));
+  cache.insert(session3.get());
+  EXPECT_EQ(2U, cache.size());
+  EXPECT_NE(nullptr, lookup(cache, "session1"));
+  EXPECT_EQ(nullptr, lookup(cache, "session2"));
+  EXPECT_NE(nullptr, lookup(cache, "session3"));
+}
+
+TEST_F(SessionCacheImplTest, EmptyIdNotCached) {
+  SessionCacheImpl cache(100);
+  bssl::UniquePtr<SSL_SESSION> session(SSL_SESSION_new(ctx_.get()));
+  cache.insert(session.get());
+  EXPECT_EQ(0U, cache.size());
+}
+
+} // namespace Ssl
+} // namespace Envoy
@@ -0,0 +1,93 @@
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "common/stats/histogram_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Stats {
+
+TEST(HistogramBucketsTest, Layout) {
+  for (uint64_t value = 0; value < 16; value++) {
+    EXPECT_EQ(value, HistogramBuckets::index(value));
+  }
+  EXPECT_EQ(16U, HistogramBuckets::index(16));
+  EXPECT_EQ(16U, HistogramBuckets::index(17));
+  EXPECT_EQ(17U, HistogramBuckets::index(18));
+  EXPECT_EQ(24U, HistogramBuckets::index(32));
+  EXPECT_EQ(HistogramBuckets::NUM_BUCKETS - 1, HistogramBuckets::index(UINT32_MAX));
+  EXPECT_EQ(HistogramBuckets::NUM_BUCKETS - 1, HistogramBuckets::index(UINT64_MAX));
+
+  // The buckets cover all values up to 2^32 without gaps, and each bound is in its own bucket.
+  EXPECT_EQ(0U, HistogramBuckets::lowerBound(0));
+  for (size_t i = 0; i < HistogramBuckets::NUM_BUCKETS; i++) {
+    EXPECT_EQ(i, HistogramBuckets::index(HistogramBuckets::lowerBound(i)));
+    EXPECT_EQ(i, HistogramBuckets::index(HistogramBuckets::upperBound(i)));
+    if (i > 0) {
+      EXPECT_EQ(HistogramBuckets::upperBound(i - 1) + 1, HistogramBuckets::lowerBound(i));
+    }
+  }
+  EXPECT_EQ(UINT32_MAX, HistogramBuckets::upperBound(HistogramBuckets::NUM_BUCKETS - 1));
+}
+
+TEST(HistogramStatisticsImplTest, Empty) {
+  HistogramStatisticsImpl statistics;
+  EXPECT_EQ(0U, statistics.sampleCount());
+  ASSERT_EQ(statistics.supportedQuantiles().size(), statistics.computedQuantiles().size());
+  for (double value : statistics.computedQuantiles()) {
+    EXPECT_TRUE(std::isnan(value));
+  }
+  EXPECT_EQ("P0: nan, P25: nan, P50: nan, P75: nan, P90: nan, P95: nan, P99: nan, P99.9: nan, "
+            "P100: nan",
+            statistics.quantileSummary());
+}
+
+TEST(HistogramStatisticsImplTest, Quantiles) {
+  // One value each of 1 to 10, which have exact buckets.
+  std::vector<uint64_t> counts(HistogramBuckets::NUM_BUCKETS, 0);
+  for (uint64_t value = 1; value <= 10; value++) {
+    counts[HistogramBuckets::index(value)]++;
+  }
+
+  HistogramStatisticsImpl statistics(counts);
+  EXPECT_EQ(10U, statistics.sampleCount());
+  EXPECT_EQ((std::vector<double>{1, 3, 5, 8, 9, 10, 10, 10, 10}), statistics.computedQuantiles());
+  EXPECT_EQ("P0: 1, P25: 3, P50: 5, P75: 8, P90: 9, P95: 10, P99: 10, P99.9: 10, P100: 10",
+            statistics.quantileSummary());
+}
+
+TEST(HistogramStatisticsImplTest, Interpolation) {
+  // 100 values spread over the bucket of [1024, 1151].
+  std::vector<uint64_t> counts(HistogramBuckets::NUM_BUCKETS, 0);
+  counts[HistogramBuckets::index(1024)] = 100;
+
+  HistogramStatisticsImpl statistics(counts);
+  const std::vector<double>& quantiles = statistics.computedQuantiles();
+  EXPECT_DOUBLE_EQ(1024, quantiles[0]);
+  EXPECT_DOUBLE_EQ(1024 + 128 * 0.5, quantiles[2]);
+  EXPECT_DOUBLE_EQ(1024 + 128 * 0.9, quantiles[4]);
+  EXPECT_DOUBLE_EQ(1151, quantiles[8]);
+}
+
+TEST(ThreadLocalHistogramImplTest, Collect) {
+  ThreadLocalHistogramImpl histogram;
+  histogram.recordValue(1);
+  histogram.recordValue(1);
+  histogram.recordValue(100);
+
+  std::vector<uint64_t> counts(HistogramBuckets::NUM_BUCKETS, 0);
+  histogram.collect(counts);
+  EXPECT_EQ(2U, counts[1]);
+  EXPECT_EQ(1U, counts[HistogramBuckets::index(100)]);
+
+  // Only the values recorded since the last collection are added.
+  histogram.recordValue(1);
+  histogram.collect(counts);
+  EXPECT_EQ(3U, counts[1]);
+  EXPECT_EQ(1U, counts[HistogramBuckets::index(100)]);
+}
+
+} // namespace Stats
+} // namespace Envoy
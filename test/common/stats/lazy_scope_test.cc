@@ -0,0 +1,64 @@
+#include <string>
+
+#include "common/stats/lazy_scope.h"
+#include "common/stats/stats_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Stats {
+
+TEST(LazyScopeTest, CounterCreatedOnFirstUse) {
+  IsolatedStoreImpl store;
+  LazyScopeImpl scope(store);
+
+  Counter& counter = scope.counter("c");
+  EXPECT_EQ(&counter, &scope.counter("c"));
+  EXPECT_EQ(0UL, store.counters().size());
+  EXPECT_EQ(0UL, counter.value());
+  EXPECT_EQ(0UL, counter.latch());
+  EXPECT_FALSE(counter.used());
+  counter.reset();
+  EXPECT_EQ(0UL, store.counters().size());
+
+  counter.inc();
+  counter.add(2);
+  EXPECT_EQ(1UL, store.counters().size());
+  EXPECT_EQ(3UL, store.counter("c").value());
+  EXPECT_EQ(3UL, counter.value());
+  EXPECT_TRUE(counter.used());
+  EXPECT_EQ("c", counter.name());
+}
+
+TEST(LazyScopeTest, GaugeCreatedOnFirstUse) {
+  IsolatedStoreImpl store;
+  LazyScopeImpl scope(store);
+
+  Gauge& gauge = scope.gauge("g");
+  EXPECT_EQ(0UL, store.gauges().size());
+  EXPECT_EQ(0UL, gauge.value());
+  EXPECT_FALSE(gauge.used());
+
+  gauge.set(5);
+  gauge.dec();
+  EXPECT_EQ(1UL, store.gauges().size());
+  EXPECT_EQ(4UL, store.gauge("g").value());
+  EXPECT_EQ(4UL, gauge.value());
+}
+
+TEST(LazyScopeTest, NameCreates) {
+  IsolatedStoreImpl store;
+  LazyScopeImpl scope(store);
+
+  Counter& counter = scope.counter("c");
+  EXPECT_EQ("c", counter.name());
+  EXPECT_EQ("c", counter.tagExtractedName());
+  EXPECT_EQ(1UL, store.counters().size());
+
+  Histogram& histogram = scope.histogram("h");
+  histogram.recordValue(1);
+  EXPECT_EQ("h", histogram.name());
+}
+
+} // namespace Stats
+} // namespace Envoy
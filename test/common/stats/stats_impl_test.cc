@@ -105,6 +105,41 @@ TEST(TagExtractorTest, SingleSubexpression) {
   EXPECT_EQ("listner_port", tags.at(0).name_);
 }
 
+TEST(TagExtractorTest, RegexPrefix) {
+  bool anchored;
+  EXPECT_EQ("cluster.", TagExtractorImpl::extractRegexPrefix("^cluster\\.((.*?)\\.)", anchored));
+  EXPECT_TRUE(anchored);
+  EXPECT_EQ("http", TagExtractorImpl::extractRegexPrefix("^http(?=\\.).*?\\.fault", anchored));
+  EXPECT_TRUE(anchored);
+  EXPECT_EQ("_rq_", TagExtractorImpl::extractRegexPrefix("_rq_(\\d)xx$", anchored));
+  EXPECT_FALSE(anchored);
+
+  // Characters which are optional or are character classes end the prefix.
+  EXPECT_EQ("ab", TagExtractorImpl::extractRegexPrefix("^abc?", anchored));
+  EXPECT_EQ("abc", TagExtractorImpl::extractRegexPrefix("^abc+", anchored));
+  EXPECT_EQ("a", TagExtractorImpl::extractRegexPrefix("^a\\d", anchored));
+  EXPECT_EQ("", TagExtractorImpl::extractRegexPrefix("^(?:|listener)", anchored));
+
+  // Alternatives outside of a group don't share a prefix.
+  EXPECT_EQ("", TagExtractorImpl::extractRegexPrefix("^abc|def", anchored));
+  EXPECT_EQ("a", TagExtractorImpl::extractRegexPrefix("^a(b|c)", anchored));
+}
+
+TEST(TagExtractorTest, PrefixMismatch) {
+  TagExtractorImpl tag_extractor("cluster_name", "^cluster\\.((.+?)\\.)");
+  std::vector<Tag> tags;
+  EXPECT_EQ("listener.cluster.foo.bar", tag_extractor.extractTag("listener.cluster.foo.bar", tags));
+  EXPECT_TRUE(tags.empty());
+
+  TagExtractorImpl unanchored_tag_extractor("response_code", "_rq(_(\\d{3}))$");
+  EXPECT_EQ("cluster.foo.upstream_rq",
+            unanchored_tag_extractor.extractTag("cluster.foo.upstream_rq_200", tags));
+  EXPECT_EQ("cluster.foo.upstream_cx_200",
+            unanchored_tag_extractor.extractTag("cluster.foo.upstream_cx_200", tags));
+  ASSERT_EQ(1U, tags.size());
+  EXPECT_EQ("200", tags[0].value_);
+}
+
 TEST(TagExtractorTest, EmptyName) {
   EXPECT_THROW_WITH_MESSAGE(TagExtractorImpl::createTagExtractor("", "^listener\\.(\\d+?\\.)"),
                             EnvoyException, "tag_name cannot be empty");
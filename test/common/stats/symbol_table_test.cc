@@ -0,0 +1,55 @@
+#include <string>
+
+#include "common/stats/symbol_table.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Stats {
+
+TEST(SymbolTableTest, EncodeDecode) {
+  SymbolTable table;
+  for (const std::string name : {"", "a", "cluster.foo.upstream_rq_200", "a..b", ".a.", "."}) {
+    EXPECT_EQ(name, table.decode(table.encode(name)));
+  }
+
+  // One byte per token.
+  EXPECT_EQ(3UL, table.encode("cluster.foo.upstream_rq_200").size());
+  EXPECT_EQ(table.encode("cluster.bar"), table.encode("cluster.bar"));
+  EXPECT_NE(table.encode("cluster.bar"), table.encode("cluster.foo"));
+  EXPECT_NE(table.encode("a.b"), table.encode("a"));
+}
+
+TEST(SymbolTableTest, SharedTokens) {
+  SymbolTable table;
+  table.encode("cluster.foo.upstream_rq_200");
+  table.encode("cluster.bar.upstream_rq_200");
+  table.encode("cluster.foo.upstream_rq_503");
+  EXPECT_EQ(5UL, table.size());
+}
+
+TEST(SymbolTableTest, Prefix) {
+  SymbolTable table;
+  EXPECT_EQ("", table.encodePrefix(""));
+  EXPECT_EQ(table.encode("cluster.foo.upstream_rq_200"),
+            table.encodePrefix("cluster.foo.") + table.encode("upstream_rq_200"));
+  EXPECT_EQ(table.encode("cluster.foo..x"),
+            table.encodePrefix("cluster.foo..") + table.encode("x"));
+}
+
+TEST(SymbolTableTest, MultiByteSymbols) {
+  SymbolTable table;
+  for (uint32_t i = 0; i < 20000; i++) {
+    table.encode(std::to_string(i));
+  }
+
+  // Symbols from 128 take two bytes, and from 16384 three.
+  EXPECT_EQ(1UL, table.encode("127").size());
+  EXPECT_EQ(2UL, table.encode("128").size());
+  EXPECT_EQ(3UL, table.encode("16384").size());
+  EXPECT_EQ("16384.0.19999", table.decode(table.encode("16384.0.19999")));
+  EXPECT_EQ(20000UL, table.size());
+}
+
+} // namespace Stats
+} // namespace Envoy
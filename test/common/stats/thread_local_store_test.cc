@@ -302,6 +302,195 @@ TEST_F(StatsThreadLocalStoreTest, OverlappingScopes) {
   EXPECT_CALL(*this, free(_)).Times(3);
 }
 
+TEST_F(StatsThreadLocalStoreTest, PublishedCentralCache) {
+  InSequence s;
+
+  // Stats created before threading is initialized are only in the central cache.
+  ScopePtr scope1 = store_->createScope("scope1.");
+  EXPECT_CALL(*this, alloc(_)).Times(2);
+  Counter& c1 = scope1->counter("c1");
+  Gauge& g1 = scope1->gauge("g1");
+  EXPECT_EQ(2L, TestUtility::findCounter(*store_, "scope1.c1").use_count());
+
+  // The first lookup in the scope publishes the central cache and fills the thread's cache with
+  // all of its stats.
+  store_->initializeThreading(main_thread_dispatcher_, tls_);
+  EXPECT_EQ(&c1, &scope1->counter("c1"));
+  EXPECT_EQ(4L, TestUtility::findCounter(*store_, "scope1.c1").use_count());
+  EXPECT_EQ(4L, TestUtility::findGauge(*store_, "scope1.g1").use_count());
+  EXPECT_EQ(&g1, &scope1->gauge("g1"));
+
+  // Stats created afterwards aren't published until another thread looks them up.
+  EXPECT_CALL(*this, alloc(_));
+  Counter& c2 = scope1->counter("c2");
+  EXPECT_EQ(&c2, &scope1->counter("c2"));
+  EXPECT_EQ(3L, TestUtility::findCounter(*store_, "scope1.c2").use_count());
+
+  store_->shutdownThreading();
+  tls_.shutdownThread();
+
+  // Includes overflow stat.
+  EXPECT_CALL(*this, free(_)).Times(4);
+}
+
+TEST_F(StatsThreadLocalStoreTest, HistogramMerge) {
+  InSequence s;
+  store_->initializeThreading(main_thread_dispatcher_, tls_);
+
+  ScopePtr scope1 = store_->createScope("scope1.");
+  Histogram& h1 = scope1->histogram("h1");
+  EXPECT_CALL(sink_, onHistogramComplete(Ref(h1), _)).Times(3);
+  h1.recordValue(1);
+  h1.recordValue(2);
+  h1.recordValue(10);
+
+  std::list<ParentHistogramSharedPtr> histograms = store_->histograms();
+  ASSERT_EQ(1UL, histograms.size());
+  ParentHistogram& parent = *histograms.front();
+  EXPECT_EQ(&h1, static_cast<Histogram*>(&parent));
+  EXPECT_EQ(0U, parent.cumulativeStatistics().sampleCount());
+
+  parent.merge();
+  EXPECT_EQ(3U, parent.intervalStatistics().sampleCount());
+  EXPECT_EQ(3U, parent.cumulativeStatistics().sampleCount());
+  EXPECT_EQ(1, parent.intervalStatistics().computedQuantiles().front());
+  EXPECT_EQ(10, parent.intervalStatistics().computedQuantiles().back());
+
+  // The interval only has the values recorded since the last merge.
+  EXPECT_CALL(sink_, onHistogramComplete(Ref(h1), 5));
+  h1.recordValue(5);
+  parent.merge();
+  EXPECT_EQ(1U, parent.intervalStatistics().sampleCount());
+  EXPECT_EQ(5, parent.intervalStatistics().computedQuantiles().front());
+  EXPECT_EQ(4U, parent.cumulativeStatistics().sampleCount());
+  EXPECT_EQ(1, parent.cumulativeStatistics().computedQuantiles().front());
+
+  store_->shutdownThreading();
+  tls_.shutdownThread();
+
+  // Includes overflow stat.
+  EXPECT_CALL(*this, free(_));
+}
+
+TEST_F(StatsThreadLocalStoreTest, ThreadLocalCounters) {
+  InSequence s;
+  store_->shutdownThreading();
+  EXPECT_CALL(*this, alloc("stats.overflow"));
+  EXPECT_CALL(*this, free(_));
+  store_.reset(new ThreadLocalStoreImpl(*this, true));
+  store_->initializeThreading(main_thread_dispatcher_, tls_);
+
+  // Overlapping scopes have their own counters which share the backing stat.
+  ScopePtr scope1 = store_->createScope("scope1.");
+  ScopePtr scope2 = store_->createScope("scope1.");
+  EXPECT_CALL(*this, alloc(_)).Times(2);
+  Counter& c1 = scope1->counter("c");
+  Counter& c2 = scope2->counter("c");
+  EXPECT_NE(&c1, &c2);
+
+  c1.inc();
+  c1.add(2);
+  EXPECT_TRUE(c1.used());
+  EXPECT_EQ(3U, c1.value());
+  EXPECT_FALSE(c2.used());
+  EXPECT_EQ(0U, c2.value());
+
+  // Latching adds the thread local increments to the backing stat.
+  EXPECT_EQ(3U, c1.latch());
+  EXPECT_TRUE(c2.used());
+  EXPECT_EQ(3U, c2.value());
+  EXPECT_EQ(0U, c1.latch());
+
+  c2.inc();
+  EXPECT_EQ(3U, c1.value());
+  EXPECT_EQ(4U, c2.value());
+  c2.reset();
+  EXPECT_EQ(0U, c1.value());
+  EXPECT_EQ(0U, c2.value());
+  EXPECT_EQ(0U, c2.latch());
+
+  // Once shutting down counters are incremented directly.
+  store_->shutdownThreading();
+  c1.inc();
+  EXPECT_EQ(1U, c2.value());
+  tls_.shutdownThread();
+
+  // Includes overflow stat.
+  EXPECT_CALL(*this, free(_)).Times(3);
+}
+
+// Counts its calls, and tags every name it's called with.
+class CountingTagExtractor : public TagExtractor {
+public:
+  // Stats::TagExtractor
+  std::string name() const override { return "counted"; }
+  std::string extractTag(const std::string& tag_extracted_name,
+                         std::vector<Tag>& tags) const override {
+    calls_++;
+    tags.push_back({"counted", "true"});
+    return tag_extracted_name;
+  }
+
+  mutable uint32_t calls_{};
+};
+
+TEST_F(StatsThreadLocalStoreTest, TagExtractionCache) {
+  InSequence s;
+  store_->initializeThreading(main_thread_dispatcher_, tls_);
+
+  std::vector<TagExtractorPtr> tag_extractors;
+  tag_extractors.emplace_back(TagExtractorImpl::createTagExtractor("cluster_name", ""));
+  CountingTagExtractor* counting_tag_extractor = new CountingTagExtractor();
+  tag_extractors.emplace_back(counting_tag_extractor);
+  store_->setTagExtractors(tag_extractors);
+
+  ScopePtr scope1 = store_->createScope("cluster.foo.");
+  ScopePtr scope2 = store_->createScope("cluster.foo.");
+  EXPECT_CALL(*this, alloc(_)).Times(2);
+  Counter& c1 = scope1->counter("upstream_rq_total");
+  EXPECT_EQ(1U, counting_tag_extractor->calls_);
+
+  // The same name in another scope reuses the tags extracted for the first one.
+  Gauge& g2 = scope2->gauge("upstream_rq_total");
+  EXPECT_EQ(1U, counting_tag_extractor->calls_);
+  for (const Metric* metric : std::vector<const Metric*>{&c1, &g2}) {
+    EXPECT_EQ("cluster.upstream_rq_total", metric->tagExtractedName());
+    ASSERT_EQ(2U, metric->tags().size());
+    EXPECT_EQ("cluster_name", metric->tags()[0].name_);
+    EXPECT_EQ("foo", metric->tags()[0].value_);
+    EXPECT_EQ("counted", metric->tags()[1].name_);
+  }
+
+  store_->shutdownThreading();
+  tls_.shutdownThread();
+
+  // Includes overflow stat.
+  EXPECT_CALL(*this, free(_)).Times(3);
+}
+
+TEST_F(StatsThreadLocalStoreTest, PrefixWithoutSeparator) {
+  InSequence s;
+  store_->initializeThreading(main_thread_dispatcher_, tls_);
+
+  // Names in a scope whose prefix doesn't end in '.' are encoded in full, so they are the same
+  // stats as in other scopes.
+  ScopePtr scope1 = store_->createScope("scope1");
+  EXPECT_CALL(*this, alloc(_)).Times(2);
+  Counter& c1 = scope1->counter("c.d");
+  Counter& c2 = store_->counter("scope1c.d");
+  EXPECT_EQ("scope1c.d", c1.name());
+  EXPECT_EQ(&c1, &scope1->counter("c.d"));
+  c1.inc();
+  EXPECT_EQ(1UL, c2.value());
+  EXPECT_EQ(2UL, store_->counters().size());
+
+  store_->shutdownThreading();
+  tls_.shutdownThread();
+
+  // Includes overflow stat.
+  EXPECT_CALL(*this, free(_)).Times(3);
+}
+
 TEST_F(StatsThreadLocalStoreTest, AllocFailed) {
   InSequence s;
   store_->initializeThreading(main_thread_dispatcher_, tls_);
@@ -1,4 +1,8 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include <chrono>
+#include <string>
 
 #include "common/network/address_impl.h"
 #include "common/network/utility.h"
@@ -29,7 +33,7 @@ TEST_P(UdpStatsdSinkTest, InitWithIpAddress) {
   Network::Address::InstanceConstSharedPtr server_address =
       Network::Utility::parseInternetAddressAndPort(
           fmt::format("{}:8125", Network::Test::getLoopbackAddressUrlString(GetParam())));
-  UdpStatsdSink sink(tls_, server_address);
+  UdpStatsdSink sink(tls_, server_address, 0);
   int fd = sink.getFdForTests();
   EXPECT_NE(fd, -1);
 
@@ -56,6 +60,52 @@ TEST_P(UdpStatsdSinkTest, InitWithIpAddress) {
   tls_.shutdownThread();
 }
 
+TEST_P(UdpStatsdSinkTest, BatchedDatagrams) {
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  std::pair<Network::Address::InstanceConstSharedPtr, int> server =
+      Network::Test::bindFreeLoopbackPort(GetParam(), Network::Address::SocketType::Datagram);
+  auto receive = [&server]() -> std::string {
+    char buffer[1024];
+    const ssize_t rc = ::recv(server.second, buffer, sizeof(buffer), MSG_DONTWAIT);
+    return rc < 0 ? "" : std::string(buffer, rc);
+  };
+
+  NiceMock<MockCounter> counter;
+  counter.name_ = "c";
+  NiceMock<MockGauge> gauge;
+  gauge.name_ = "g";
+  NiceMock<MockHistogram> timer;
+  timer.name_ = "t";
+
+  // Counters and gauges are sent at the end of the flush, in datagrams of up to 40 bytes.
+  UdpStatsdSink sink(tls_, server.first, 40);
+  sink.beginFlush();
+  sink.flushCounter(counter, 1);
+  sink.flushGauge(gauge, 2);
+  sink.flushCounter(counter, 3);
+  sink.flushGauge(gauge, 4);
+  sink.onHistogramComplete(timer, 5);
+  EXPECT_EQ("envoy.t:5|ms", receive());
+  EXPECT_EQ("", receive());
+  sink.endFlush();
+  EXPECT_EQ("envoy.c:1|c\nenvoy.g:2|g\nenvoy.c:3|c", receive());
+  EXPECT_EQ("envoy.g:4|g", receive());
+  EXPECT_EQ("", receive());
+
+  // Without a maximum datagram size each metric has its own datagram.
+  UdpStatsdSink unbatched_sink(tls_, server.first, 0);
+  unbatched_sink.beginFlush();
+  unbatched_sink.flushCounter(counter, 1);
+  unbatched_sink.flushGauge(gauge, 2);
+  unbatched_sink.endFlush();
+  EXPECT_EQ("envoy.c:1|c", receive());
+  EXPECT_EQ("envoy.g:2|g", receive());
+  EXPECT_EQ("", receive());
+
+  tls_.shutdownThread();
+  ::close(server.second);
+}
+
 } // namespace Statsd
 } // namespace Stats
 } // namespace Envoy
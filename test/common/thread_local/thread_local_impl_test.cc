@@ -1,3 +1,7 @@
+#include <string>
+#include <vector>
+
+#include "common/thread_local/rcu_slot.h"
 #include "common/thread_local/thread_local_impl.h"
 
 #include "test/mocks/event/mocks.h"
@@ -5,6 +9,7 @@
 #include "gmock/gmock.h"
 
 using testing::InSequence;
+using testing::Invoke;
 using testing::Ref;
 using testing::ReturnPointee;
 using testing::_;
@@ -79,5 +84,66 @@ TEST_F(ThreadLocalInstanceImplTest, All) {
   tls_.shutdownThread();
 }
 
+// Updates made during a batch run right away on the main thread, and are posted to the other
+// threads as a single callback once the outermost batch ends.
+TEST_F(ThreadLocalInstanceImplTest, Batch) {
+  SlotPtr slot = tls_.allocateSlot();
+  std::vector<Event::PostCb> posted;
+  EXPECT_CALL(thread_dispatcher_, post(_)).WillRepeatedly(Invoke([&](Event::PostCb cb) -> void {
+    posted.push_back(cb);
+  }));
+
+  std::vector<Event::Dispatcher*> set_dispatchers;
+  uint32_t runs = 0;
+  tls_.startBatch();
+  tls_.startBatch();
+  slot->set([&](Event::Dispatcher& dispatcher) -> ThreadLocalObjectSharedPtr {
+    set_dispatchers.push_back(&dispatcher);
+    return nullptr;
+  });
+  slot->runOnAllThreads([&]() -> void { runs++; });
+  EXPECT_EQ(std::vector<Event::Dispatcher*>({&main_dispatcher_}), set_dispatchers);
+  EXPECT_EQ(1U, runs);
+  tls_.endBatch();
+  EXPECT_TRUE(posted.empty());
+
+  tls_.endBatch();
+  ASSERT_EQ(1U, posted.size());
+  posted[0]();
+  EXPECT_EQ(std::vector<Event::Dispatcher*>({&main_dispatcher_, &thread_dispatcher_}),
+            set_dispatchers);
+  EXPECT_EQ(2U, runs);
+
+  // Outside of a batch, every update is posted again.
+  slot->runOnAllThreads([&]() -> void { runs++; });
+  EXPECT_EQ(2U, posted.size());
+
+  tls_.shutdownGlobalThreading();
+  slot.reset();
+  tls_.shutdownThread();
+}
+
+// Values published to a RCU slot are read without any post.
+TEST_F(ThreadLocalInstanceImplTest, RcuSlot) {
+  EXPECT_CALL(thread_dispatcher_, post(_));
+  std::unique_ptr<RcuSlot<std::string>> slot(new RcuSlot<std::string>(tls_));
+  EXPECT_EQ(nullptr, slot->get());
+
+  std::shared_ptr<const std::string> value = std::make_shared<const std::string>("a");
+  std::weak_ptr<const std::string> weak_value = value;
+  slot->publish(std::move(value));
+  EXPECT_EQ("a", *slot->get());
+
+  // The previous value is freed once the thread read the new one.
+  slot->publish(std::make_shared<const std::string>("b"));
+  EXPECT_FALSE(weak_value.expired());
+  EXPECT_EQ("b", *slot->get());
+  EXPECT_TRUE(weak_value.expired());
+
+  tls_.shutdownGlobalThreading();
+  slot.reset();
+  tls_.shutdownThread();
+}
+
 } // namespace ThreadLocal
 } // namespace Envoy
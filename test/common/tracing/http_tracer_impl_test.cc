@@ -155,6 +155,21 @@ TEST(HttpTracerUtilityTest, mutateHeaders) {
     EXPECT_EQ(UuidTraceStatus::NoTrace,
               UuidUtils::isTraceableUuid(request_headers.get_("x-request-id")));
   }
+
+  // Not sampled, global on, the request id is left as is.
+  {
+    NiceMock<Runtime::MockLoader> runtime;
+    EXPECT_CALL(runtime.snapshot_, featureEnabled("tracing.random_sampling", 10000, _, 10000))
+        .WillOnce(Return(false));
+    EXPECT_CALL(runtime.snapshot_, featureEnabled("tracing.global_enabled", 100, _))
+        .WillOnce(Return(true));
+
+    Http::TestHeaderMapImpl request_headers{
+        {"x-request-id", "125a4afb-6f55-44ba-ad80-413f09f48a28"}};
+    HttpTracerUtility::mutateHeaders(request_headers, runtime);
+
+    EXPECT_EQ("125a4afb-6f55-44ba-ad80-413f09f48a28", request_headers.get_("x-request-id"));
+  }
 }
 
 TEST(HttpTracerUtilityTest, IsTracing) {
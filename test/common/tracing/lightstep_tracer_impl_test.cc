@@ -24,6 +24,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::AnyNumber;
 using testing::Invoke;
 using testing::NiceMock;
 using testing::Return;
@@ -43,6 +44,8 @@ public:
 
     ON_CALL(cm_, httpAsyncClientForCluster("fake_cluster"))
         .WillByDefault(ReturnRef(cm_.async_client_));
+    // Runtime values not expected by a test take their defaults.
+    EXPECT_CALL(runtime_.snapshot_, getInteger(_, _)).Times(AnyNumber());
 
     if (init_timer) {
       timer_ = new NiceMock<Event::MockTimer>(&tls_.dispatcher_);
@@ -267,6 +270,62 @@ TEST_F(LightStepDriverTest, FlushOneSpanGrpcFailure) {
   EXPECT_EQ(1U, stats_.counter("tracing.lightstep.spans_sent").value());
 }
 
+TEST_F(LightStepDriverTest, MaxBufferedSpans) {
+  setupValidDriver();
+
+  Http::MockAsyncClientRequest request(&cm_.async_client_);
+  Http::AsyncClient::Callbacks* callback;
+  std::string body;
+  EXPECT_CALL(cm_.async_client_, send_(_, _, _))
+      .Times(2)
+      .WillRepeatedly(
+          Invoke([&](Http::MessagePtr& message, Http::AsyncClient::Callbacks& callbacks,
+                     const Optional<std::chrono::milliseconds>&) -> Http::AsyncClient::Request* {
+            callback = &callbacks;
+            body = TestUtility::bufferToString(*message->body());
+            return &request;
+          }));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("tracing.lightstep.min_flush_spans", 5))
+      .WillRepeatedly(Return(2));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("tracing.lightstep.max_buffered_spans", 1000))
+      .WillRepeatedly(Return(2));
+
+  for (int i = 0; i < 5; i++) {
+    driver_->startSpan(config_, request_headers_, operation_name_, start_time_)->finishSpan();
+  }
+
+  // The first two spans are sent, and the next two are buffered while their report is outstanding.
+  EXPECT_EQ(2U, stats_.counter("tracing.lightstep.spans_sent").value());
+  EXPECT_EQ(1U, stats_.counter("tracing.lightstep.spans_dropped").value());
+
+  lightstep::collector::ReportRequest report;
+  EXPECT_EQ(0, body[0]);
+  EXPECT_TRUE(report.ParseFromString(body.substr(5)));
+  EXPECT_EQ(2, report.spans_size());
+  EXPECT_EQ("sample_token", report.auth().access_token());
+
+  callback->onFailure(Http::AsyncClient::FailureReason::Reset);
+  EXPECT_CALL(*timer_, enableTimer(_));
+  timer_->callback_();
+  EXPECT_EQ(4U, stats_.counter("tracing.lightstep.spans_sent").value());
+  EXPECT_TRUE(report.ParseFromString(body.substr(5)));
+  EXPECT_EQ(2, report.spans_size());
+
+  callback->onFailure(Http::AsyncClient::FailureReason::Reset);
+}
+
+TEST_F(LightStepDriverTest, FlushSpansBySize) {
+  setupValidDriver();
+
+  EXPECT_CALL(cm_.async_client_, send_(_, _, _));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("tracing.lightstep.min_flush_bytes", 65536))
+      .WillOnce(Return(1));
+
+  driver_->startSpan(config_, request_headers_, operation_name_, start_time_)->finishSpan();
+
+  EXPECT_EQ(1U, stats_.counter("tracing.lightstep.spans_sent").value());
+}
+
 TEST_F(LightStepDriverTest, SerializeAndDeserializeContext) {
   setupValidDriver();
 
@@ -1,5 +1,9 @@
+#include "common/buffer/buffer_impl.h"
+#include "common/common/hex.h"
 #include "common/tracing/zipkin/span_buffer.h"
 
+#include "test/test_common/utility.h"
+
 #include "gtest/gtest.h"
 
 namespace Envoy {
@@ -101,5 +105,44 @@ TEST(ZipkinSpanBufferTest, sizeConstructorEndtoEnd) {
   EXPECT_EQ(0ULL, buffer.pendingSpans());
   EXPECT_EQ("[]", buffer.toStringifiedJsonArray());
 }
+
+TEST(ZipkinSpanBufferTest, serializeJson) {
+  SpanBuffer buffer(2);
+
+  buffer.addSpan(Span());
+  buffer.addSpan(Span());
+  EXPECT_FALSE(buffer.addSpan(Span()));
+  EXPECT_EQ(2ULL, buffer.pendingSpans());
+  const std::string expected_json_array_string = buffer.toStringifiedJsonArray();
+  EXPECT_EQ(expected_json_array_string.size() - 2, buffer.pendingBytes());
+
+  Buffer::OwnedImpl output;
+  buffer.moveSerialized(output);
+  EXPECT_EQ(expected_json_array_string, TestUtility::bufferToString(output));
+  EXPECT_EQ(0ULL, buffer.pendingSpans());
+  EXPECT_EQ(0ULL, buffer.pendingBytes());
+  EXPECT_EQ("[]", buffer.toStringifiedJsonArray());
+}
+
+TEST(ZipkinSpanBufferTest, serializeThrift) {
+  SpanBuffer buffer(2, SpanEncoding::Thrift);
+  EXPECT_EQ(SpanEncoding::Thrift, buffer.encoding());
+
+  buffer.addSpan(Span());
+  buffer.addSpan(Span());
+  EXPECT_EQ(2ULL, buffer.pendingSpans());
+  EXPECT_EQ(92ULL, buffer.pendingBytes());
+
+  // The spans are sent as a list of structs.
+  Buffer::OwnedImpl output;
+  buffer.moveSerialized(output);
+  const std::string serialized = TestUtility::bufferToString(output);
+  const std::string empty_span = "0a000100000000000000000b0003000000000a00040000000000000000"
+                                 "0f00060c000000000f00080c0000000000";
+  EXPECT_EQ("0c00000002" + empty_span + empty_span,
+            Hex::encode(reinterpret_cast<const uint8_t*>(serialized.data()), serialized.size()));
+  EXPECT_EQ(0ULL, buffer.pendingSpans());
+  EXPECT_EQ(0ULL, buffer.pendingBytes());
+}
 } // namespace Zipkin
 } // namespace Envoy
@@ -297,5 +297,43 @@ TEST(ZipkinTracerTest, finishSpan) {
   endpoint = ann.endpoint();
   EXPECT_EQ("my_service_name", endpoint.serviceName());
 }
+
+// Released spans are reset and reused by the next spans, and all annotations share the tracer's
+// endpoint.
+TEST(ZipkinTracerTest, releaseSpan) {
+  Network::Address::InstanceConstSharedPtr addr =
+      Network::Utility::parseInternetAddressAndPort("127.0.0.1:9000");
+  NiceMock<Runtime::MockRandomGenerator> random_generator;
+  Tracer tracer("my_service_name", addr, random_generator);
+  NiceMock<MockSystemTimeSource> mock_start_time;
+  SystemTime timestamp = mock_start_time.currentTime();
+
+  NiceMock<Tracing::MockConfig> config;
+  ON_CALL(config, operationName()).WillByDefault(Return(Tracing::OperationName::Egress));
+  ON_CALL(random_generator, random()).WillByDefault(Return(1000));
+
+  SpanPtr span = tracer.startSpan(config, "my_span", timestamp);
+  span->setTag("key", "value");
+  SpanPtr other_span = tracer.startSpan(config, "my_other_span", timestamp);
+  EXPECT_EQ(span->annotations()[0].sharedEndpoint(),
+            other_span->annotations()[0].sharedEndpoint());
+
+  const Span* released = span.get();
+  tracer.releaseSpan(std::move(span));
+
+  SpanContext context(*other_span);
+  SpanPtr child_span = tracer.startSpan(config, "my_child_span", timestamp, context);
+  EXPECT_EQ(released, child_span.get());
+  EXPECT_EQ("my_child_span", child_span->name());
+  EXPECT_EQ(other_span->id(), child_span->parentId());
+  EXPECT_EQ(1ULL, child_span->annotations().size());
+  EXPECT_EQ(0ULL, child_span->binaryAnnotations().size());
+  EXPECT_FALSE(child_span->isSetDuration());
+  EXPECT_EQ(&tracer, child_span->tracer());
+
+  // Once the free list is empty, spans are allocated again.
+  SpanPtr new_span = tracer.startSpan(config, "my_span", timestamp);
+  EXPECT_NE(released, new_span.get());
+}
 } // namespace Zipkin
 } // namespace Envoy
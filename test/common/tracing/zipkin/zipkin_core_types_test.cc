@@ -1,14 +1,29 @@
+#include "common/buffer/buffer_impl.h"
+#include "common/common/hex.h"
 #include "common/common/utility.h"
 #include "common/network/address_impl.h"
 #include "common/network/utility.h"
 #include "common/tracing/zipkin/zipkin_core_constants.h"
 #include "common/tracing/zipkin/zipkin_core_types.h"
 
+#include "test/test_common/utility.h"
+
 #include "gtest/gtest.h"
 
 namespace Envoy {
 namespace Zipkin {
 
+namespace {
+
+std::string toThriftHex(const ZipkinBase& zipkin_object) {
+  Buffer::OwnedImpl buffer;
+  zipkin_object.toThrift(buffer);
+  const std::string serialized = TestUtility::bufferToString(buffer);
+  return Hex::encode(reinterpret_cast<const uint8_t*>(serialized.data()), serialized.size());
+}
+
+} // namespace
+
 TEST(ZipkinCoreTypesEndpointTest, defaultConstructor) {
   Endpoint ep;
 
@@ -50,6 +65,31 @@ TEST(ZipkinCoreTypesEndpointTest, customConstructor) {
       ep.toJson());
 }
 
+TEST(ZipkinCoreTypesEndpointTest, toThrift) {
+  Network::Address::InstanceConstSharedPtr addr =
+      Network::Utility::parseInternetAddressAndPort("127.0.0.1:3306");
+  Endpoint ep(std::string("my_service"), addr);
+
+  // ipv4, port, service_name and the struct end.
+  EXPECT_EQ("0800017f000001"
+            "0600020cea"
+            "0b00030000000a6d795f73657276696365"
+            "00",
+            toThriftHex(ep));
+
+  addr = Network::Utility::parseInternetAddressAndPort(
+      "[2001:0db8:85a3:0000:0000:8a2e:0370:4444]:7334");
+  ep.setAddress(addr);
+
+  // An IPv6 endpoint has a zero ipv4 and an ipv6 field.
+  EXPECT_EQ("08000100000000"
+            "0600021ca6"
+            "0b00030000000a6d795f73657276696365"
+            "0b00040000001020010db885a3000000008a2e03704444"
+            "00",
+            toThriftHex(ep));
+}
+
 TEST(ZipkinCoreTypesEndpointTest, copyOperator) {
   Network::Address::InstanceConstSharedPtr addr =
       Network::Utility::parseInternetAddressAndPort("127.0.0.1:3306");
@@ -551,6 +591,74 @@ TEST(ZipkinCoreTypesSpanTest, assignmentOperator) {
   EXPECT_EQ(span.isSetTraceIdHigh(), span2.isSetTraceIdHigh());
 }
 
+TEST(ZipkinCoreTypesSpanTest, toThrift) {
+  Span span;
+  EXPECT_EQ("0a00010000000000000000"
+            "0b000300000000"
+            "0a00040000000000000000"
+            "0f00060c00000000"
+            "0f00080c00000000"
+            "00",
+            toThriftHex(span));
+
+  Network::Address::InstanceConstSharedPtr addr =
+      Network::Utility::parseInternetAddressAndPort("127.0.0.1:3306");
+  Endpoint ep(std::string("my_service"), addr);
+  span.setTraceId(1);
+  span.setName("n");
+  span.setId(2);
+  span.setParentId(3);
+  span.addAnnotation(Annotation(1, ZipkinCoreConstants::get().CLIENT_SEND, ep));
+  span.setTag("k", "v");
+  span.setTimestamp(4);
+  span.setDuration(5);
+
+  EXPECT_EQ("0a00010000000000000001"
+            "0b0003000000016e"
+            "0a00040000000000000002"
+            "0a00050000000000000003"
+            // The annotation and its endpoint.
+            "0f00060c00000001"
+            "0a00010000000000000001"
+            "0b0002000000026373"
+            "0c0003"
+            "0800017f0000010600020cea0b00030000000a6d795f7365727669636500"
+            "00"
+            // The binary annotation, whose Thrift type is STRING (6).
+            "0f00080c00000001"
+            "0b0001000000016b"
+            "0b00020000000176"
+            "08000300000006"
+            "00"
+            "0a000a0000000000000004"
+            "0a000b0000000000000005"
+            "00",
+            toThriftHex(span));
+}
+
+TEST(ZipkinCoreTypesSpanTest, reset) {
+  Span span;
+  span.setTraceId(1);
+  span.setName("my_span");
+  span.setId(2);
+  span.setParentId(3);
+  span.setDebug();
+  span.setTag("key", "value");
+  span.setTimestamp(4);
+  span.setDuration(5);
+  span.setTraceIdHigh(6);
+  span.setStartTime(7);
+
+  span.reset();
+  EXPECT_EQ(Span().toJson(), span.toJson());
+  EXPECT_FALSE(span.isSetParentId());
+  EXPECT_FALSE(span.debug());
+  EXPECT_FALSE(span.isSetTimestamp());
+  EXPECT_FALSE(span.isSetDuration());
+  EXPECT_FALSE(span.isSetTraceIdHigh());
+  EXPECT_EQ(0LL, span.startTime());
+  EXPECT_EQ(nullptr, span.tracer());
+}
 TEST(ZipkinCoreTypesSpanTest, setTag) {
   Span span;
 
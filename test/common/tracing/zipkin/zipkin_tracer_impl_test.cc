@@ -23,6 +23,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::AnyNumber;
 using testing::Invoke;
 using testing::NiceMock;
 using testing::Return;
@@ -38,6 +39,8 @@ public:
   void setup(Json::Object& config, bool init_timer) {
     ON_CALL(cm_, httpAsyncClientForCluster("fake_cluster"))
         .WillByDefault(ReturnRef(cm_.async_client_));
+    // Runtime values which a test doesn't expect take their defaults.
+    EXPECT_CALL(runtime_.snapshot_, getInteger(_, _)).Times(AnyNumber());
 
     if (init_timer) {
       timer_ = new NiceMock<Event::MockTimer>(&tls_.dispatcher_);
@@ -47,13 +50,15 @@ public:
     driver_.reset(new Driver(config, cm_, stats_, tls_, runtime_, local_info_, random_));
   }
 
-  void setupValidDriver() {
+  void setupValidDriver(const std::string& collector_encoding = "json") {
     EXPECT_CALL(cm_, get("fake_cluster")).WillRepeatedly(Return(&cm_.thread_local_cluster_));
 
     std::string valid_config = R"EOF(
       {
        "collector_cluster": "fake_cluster",
-       "collector_endpoint": "/api/v1/spans"
+       "collector_endpoint": "/api/v1/spans",
+       "collector_encoding": ")EOF" +
+                               collector_encoding + R"EOF("
        }
     )EOF";
     Json::ObjectSharedPtr loader = Json::Factory::loadFromString(valid_config);
@@ -126,6 +131,22 @@ TEST_F(ZipkinDriverTest, InitializeDriver) {
 
     setup(*loader, true);
   }
+
+  {
+    // Unknown encoding.
+    EXPECT_CALL(cm_, get("fake_cluster")).WillRepeatedly(Return(&cm_.thread_local_cluster_));
+
+    std::string invalid_encoding_config = R"EOF(
+      {
+       "collector_cluster": "fake_cluster",
+       "collector_encoding": "xml"
+       }
+    )EOF";
+    Json::ObjectSharedPtr loader = Json::Factory::loadFromString(invalid_encoding_config);
+
+    EXPECT_THROW_WITH_MESSAGE(setup(*loader, false), EnvoyException,
+                              "unknown zipkin collector encoding 'xml'");
+  }
 }
 
 TEST_F(ZipkinDriverTest, FlushSeveralSpans) {
@@ -243,6 +264,87 @@ TEST_F(ZipkinDriverTest, FlushSpansTimer) {
   EXPECT_EQ(1U, stats_.counter("tracing.zipkin.spans_sent").value());
 }
 
+TEST_F(ZipkinDriverTest, FlushSpansThrift) {
+  setupValidDriver("thrift");
+
+  Http::MockAsyncClientRequest request(&cm_.async_client_);
+  EXPECT_CALL(cm_.async_client_, send_(_, _, _))
+      .WillOnce(
+          Invoke([&](Http::MessagePtr& message, Http::AsyncClient::Callbacks&,
+                     const Optional<std::chrono::milliseconds>&) -> Http::AsyncClient::Request* {
+            EXPECT_STREQ("/api/v1/spans", message->headers().Path()->value().c_str());
+            EXPECT_STREQ("application/x-thrift",
+                         message->headers().ContentType()->value().c_str());
+
+            // A list of one struct.
+            const std::string body = TestUtility::bufferToString(*message->body());
+            EXPECT_EQ(std::string("\x0c\x00\x00\x00\x01", 5), body.substr(0, 5));
+
+            return &request;
+          }));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("tracing.zipkin.min_flush_spans", 5))
+      .WillOnce(Return(1));
+
+  Tracing::SpanPtr span =
+      driver_->startSpan(config_, request_headers_, operation_name_, start_time_);
+  span->finishSpan();
+
+  EXPECT_EQ(1U, stats_.counter("tracing.zipkin.spans_sent").value());
+}
+
+TEST_F(ZipkinDriverTest, FlushSpansBufferSize) {
+  setupValidDriver();
+
+  // The buffer is flushed by the size of the first span rather than by the span count.
+  EXPECT_CALL(cm_.async_client_, send_(_, _, _));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("tracing.zipkin.max_buffer_bytes", 65536U))
+      .WillOnce(Return(1));
+
+  Tracing::SpanPtr span =
+      driver_->startSpan(config_, request_headers_, operation_name_, start_time_);
+  span->finishSpan();
+
+  EXPECT_EQ(1U, stats_.counter("tracing.zipkin.spans_sent").value());
+}
+
+TEST_F(ZipkinDriverTest, DropSpansWhenReportsPending) {
+  setupValidDriver();
+
+  Http::MockAsyncClientRequest request(&cm_.async_client_);
+  Http::AsyncClient::Callbacks* callback;
+  EXPECT_CALL(runtime_.snapshot_, getInteger("tracing.zipkin.min_flush_spans", 5))
+      .WillRepeatedly(Return(1));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("tracing.zipkin.max_pending_reports", 16U))
+      .WillRepeatedly(Return(1));
+  EXPECT_CALL(cm_.async_client_, send_(_, _, _))
+      .WillOnce(
+          Invoke([&](Http::MessagePtr&, Http::AsyncClient::Callbacks& callbacks,
+                     const Optional<std::chrono::milliseconds>&) -> Http::AsyncClient::Request* {
+            callback = &callbacks;
+            return &request;
+          }));
+
+  Tracing::SpanPtr first_span =
+      driver_->startSpan(config_, request_headers_, operation_name_, start_time_);
+  first_span->finishSpan();
+
+  // The first report is still pending, so the second span is dropped.
+  Tracing::SpanPtr second_span =
+      driver_->startSpan(config_, request_headers_, operation_name_, start_time_);
+  second_span->finishSpan();
+  EXPECT_EQ(1U, stats_.counter("tracing.zipkin.spans_sent").value());
+  EXPECT_EQ(1U, stats_.counter("tracing.zipkin.spans_dropped").value());
+
+  // Once it completes, spans are sent again.
+  callback->onFailure(Http::AsyncClient::FailureReason::Reset);
+  EXPECT_CALL(cm_.async_client_, send_(_, _, _)).WillOnce(Return(&request));
+  Tracing::SpanPtr third_span =
+      driver_->startSpan(config_, request_headers_, operation_name_, start_time_);
+  third_span->finishSpan();
+  EXPECT_EQ(2U, stats_.counter("tracing.zipkin.spans_sent").value());
+  EXPECT_EQ(1U, stats_.counter("tracing.zipkin.spans_dropped").value());
+}
+
 TEST_F(ZipkinDriverTest, SerializeAndDeserializeContext) {
   setupValidDriver();
 
@@ -9,6 +9,7 @@
 
 #include "test/common/upstream/utility.h"
 #include "test/mocks/local_info/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
 #include "test/mocks/upstream/mocks.h"
 #include "test/test_common/printers.h"
 #include "test/test_common/utility.h"
@@ -45,8 +46,8 @@ public:
     if (v2_rest) {
       cds_config.mutable_api_config_source()->set_api_type(envoy::api::v2::ApiConfigSource::REST);
     }
-    cds_ =
-        CdsApiImpl::create(cds_config, eds_config_, cm_, dispatcher_, random_, local_info_, store_);
+    cds_ = CdsApiImpl::create(cds_config, eds_config_, cm_, tls_, dispatcher_, random_, local_info_,
+                              store_, "");
     cds_->setInitializedCb([this]() -> void { initialized_.ready(); });
 
     expectRequest();
@@ -88,6 +89,7 @@ public:
 
   bool v2_rest_{};
   NiceMock<MockClusterManager> cm_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
   NiceMock<Event::MockDispatcher> dispatcher_;
   NiceMock<Runtime::MockRandomGenerator> random_;
   NiceMock<LocalInfo::MockLocalInfo> local_info_;
@@ -128,9 +130,9 @@ TEST_F(CdsApiImplTest, InvalidOptions) {
   local_info_.node_.set_id("");
   envoy::api::v2::ConfigSource cds_config;
   Config::Utility::translateCdsConfig(*config, cds_config);
-  EXPECT_THROW(
-      CdsApiImpl::create(cds_config, eds_config_, cm_, dispatcher_, random_, local_info_, store_),
-      EnvoyException);
+  EXPECT_THROW(CdsApiImpl::create(cds_config, eds_config_, cm_, tls_, dispatcher_, random_,
+                                  local_info_, store_, ""),
+               EnvoyException);
 }
 
 TEST_F(CdsApiImplTest, Basic) {
@@ -147,10 +149,13 @@ TEST_F(CdsApiImplTest, Basic) {
       Http::HeaderMapPtr{new Http::TestHeaderMapImpl{{":status", "200"}}}));
   message->body().reset(new Buffer::OwnedImpl(response1_json));
 
+  // All the cluster updates are sent to the workers in one batch.
+  EXPECT_CALL(tls_, startBatch());
   EXPECT_CALL(cm_, clusters()).WillOnce(Return(ClusterManager::ClusterInfoMap{}));
   expectAdd("cluster1");
   expectAdd("cluster2");
   EXPECT_CALL(initialized_, ready());
+  EXPECT_CALL(tls_, endBatch());
   EXPECT_CALL(*interval_timer_, enableTimer(_));
   EXPECT_EQ("", cds_->versionInfo());
   EXPECT_EQ(0UL, store_.gauge("cluster_manager.cds.version").value());
@@ -182,6 +187,42 @@ TEST_F(CdsApiImplTest, Basic) {
   EXPECT_EQ(1872764556139482420U, store_.gauge("cluster_manager.cds.version").value());
 }
 
+// Clusters which are only kept as config by the cluster manager aren't in clusters(), but are
+// still removed when they leave CDS.
+TEST_F(CdsApiImplTest, RemoveOnDemandCluster) {
+  interval_timer_ = new Event::MockTimer(&dispatcher_);
+  InSequence s;
+
+  setup();
+
+  Http::MessagePtr message(new Http::ResponseMessageImpl(
+      Http::HeaderMapPtr{new Http::TestHeaderMapImpl{{":status", "200"}}}));
+  message->body().reset(new Buffer::OwnedImpl(fmt::sprintf(
+      "{%s}",
+      clustersJson({defaultStaticClusterJson("cluster1"), defaultStaticClusterJson("cluster2")}))));
+
+  EXPECT_CALL(cm_, clusters()).WillOnce(Return(ClusterManager::ClusterInfoMap{}));
+  expectAdd("cluster1");
+  expectAdd("cluster2");
+  EXPECT_CALL(initialized_, ready());
+  EXPECT_CALL(*interval_timer_, enableTimer(_));
+  callbacks_->onSuccess(std::move(message));
+
+  expectRequest();
+  interval_timer_->callback_();
+
+  message.reset(new Http::ResponseMessageImpl(
+      Http::HeaderMapPtr{new Http::TestHeaderMapImpl{{":status", "200"}}}));
+  message->body().reset(new Buffer::OwnedImpl(
+      fmt::sprintf("{%s}", clustersJson({defaultStaticClusterJson("cluster1")}))));
+
+  EXPECT_CALL(cm_, clusters()).WillOnce(Return(ClusterManager::ClusterInfoMap{}));
+  expectAdd("cluster1");
+  EXPECT_CALL(cm_, removePrimaryCluster("cluster2"));
+  EXPECT_CALL(*interval_timer_, enableTimer(_));
+  callbacks_->onSuccess(std::move(message));
+}
+
 TEST_F(CdsApiImplTest, Failure) {
   interval_timer_ = new Event::MockTimer(&dispatcher_);
   InSequence s;
@@ -0,0 +1,128 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <memory>
+#include <string>
+
+#include "common/event/dispatcher_impl.h"
+#include "common/runtime/runtime_impl.h"
+#include "common/ssl/context_manager_impl.h"
+#include "common/stats/stats_impl.h"
+#include "common/thread_local/thread_local_impl.h"
+#include "common/upstream/cluster_manager_impl.h"
+
+#include "test/mocks/access_log/mocks.h"
+#include "test/mocks/local_info/mocks.h"
+#include "test/mocks/network/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+
+#include "benchmark/benchmark.h"
+#include "fmt/format.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * A cluster manager with no static clusters, built from the production factory, dispatcher and
+ * thread local store, the main thread being the only one.
+ */
+class BenchmarkClusterManager {
+public:
+  BenchmarkClusterManager()
+      : factory_(runtime_, stats_, tls_, random_, dns_resolver_, ssl_context_manager_, dispatcher_,
+                 local_info_) {
+    tls_.registerThread(dispatcher_, true);
+    cluster_manager_.reset(new ClusterManagerImpl(envoy::api::v2::Bootstrap(), factory_, stats_,
+                                                  tls_, runtime_, random_, local_info_,
+                                                  log_manager_, dispatcher_));
+  }
+
+  ~BenchmarkClusterManager() {
+    tls_.shutdownGlobalThreading();
+    cluster_manager_->shutdown();
+    tls_.shutdownThread();
+  }
+
+  /**
+   * Add or update clusters, as CDS does with an update, and apply the changes posted to the
+   * dispatcher.
+   */
+  void update(const std::vector<envoy::api::v2::Cluster>& clusters) {
+    for (const auto& cluster : clusters) {
+      cluster_manager_->addOrUpdatePrimaryCluster(cluster);
+    }
+    dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+  }
+
+private:
+  Event::DispatcherImpl dispatcher_;
+  ThreadLocal::InstanceImpl tls_;
+  Stats::IsolatedStoreImpl stats_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  Runtime::RandomGeneratorImpl random_;
+  Ssl::ContextManagerImpl ssl_context_manager_{runtime_};
+  NiceMock<LocalInfo::MockLocalInfo> local_info_;
+  NiceMock<AccessLog::MockAccessLogManager> log_manager_;
+  std::shared_ptr<Network::MockDnsResolver> dns_resolver_{
+      new NiceMock<Network::MockDnsResolver>()};
+  ProdClusterManagerFactory factory_;
+  std::unique_ptr<ClusterManagerImpl> cluster_manager_;
+};
+
+/**
+ * Generate num_clusters static clusters of a single host each, with a connect timeout which can
+ * be varied to make an update of every cluster.
+ */
+static std::vector<envoy::api::v2::Cluster> makeClusters(size_t num_clusters,
+                                                         uint64_t connect_timeout_s) {
+  std::vector<envoy::api::v2::Cluster> clusters(num_clusters);
+  for (size_t i = 0; i < num_clusters; i++) {
+    auto& cluster = clusters[i];
+    cluster.set_name(fmt::format("cluster_{}", i));
+    cluster.set_type(envoy::api::v2::Cluster::STATIC);
+    cluster.mutable_connect_timeout()->set_seconds(connect_timeout_s);
+    auto* address = cluster.add_hosts()->mutable_socket_address();
+    address->set_address("127.0.0.1");
+    address->set_port_value(10000 + i % 50000);
+  }
+  return clusters;
+}
+
+// A CDS update which adds all the clusters to an empty cluster manager, as the first update after
+// a start does.
+static void CdsAddClusters(benchmark::State& state) {
+  const std::vector<envoy::api::v2::Cluster> clusters = makeClusters(state.range(0), 1);
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    std::unique_ptr<BenchmarkClusterManager> cluster_manager(new BenchmarkClusterManager());
+    state.ResumeTiming();
+
+    cluster_manager->update(clusters);
+
+    state.PauseTiming();
+    cluster_manager.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * clusters.size());
+}
+BENCHMARK(CdsAddClusters)->Arg(100)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+// A CDS update which changes all the clusters of the cluster manager.
+static void CdsUpdateClusters(benchmark::State& state) {
+  const std::vector<envoy::api::v2::Cluster> clusters[] = {makeClusters(state.range(0), 1),
+                                                           makeClusters(state.range(0), 2)};
+  BenchmarkClusterManager cluster_manager;
+  cluster_manager.update(clusters[0]);
+
+  size_t update = 0;
+  while (state.KeepRunning()) {
+    cluster_manager.update(clusters[++update % 2]);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * clusters[0].size());
+}
+BENCHMARK(CdsUpdateClusters)->Arg(100)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+} // namespace Upstream
+} // namespace Envoy
@@ -4,6 +4,7 @@
 #include "envoy/upstream/upstream.h"
 
 #include "common/config/bootstrap_json.h"
+#include "common/config/resources.h"
 #include "common/config/utility.h"
 #include "common/network/utility.h"
 #include "common/ssl/context_manager_impl.h"
@@ -12,6 +13,7 @@
 
 #include "test/common/upstream/utility.h"
 #include "test/mocks/access_log/mocks.h"
+#include "test/mocks/common.h"
 #include "test/mocks/http/mocks.h"
 #include "test/mocks/local_info/mocks.h"
 #include "test/mocks/network/mocks.h"
@@ -50,7 +52,8 @@ public:
                                   bool added_via_api) -> ClusterSharedPtr {
           return ClusterImplBase::create(cluster, cm, stats_, tls_, dns_resolver_,
                                          ssl_context_manager_, runtime_, random_, dispatcher_,
-                                         local_info_, outlier_event_logger, added_via_api);
+                                         dispatcher_, local_info_, outlier_event_logger,
+                                         added_via_api);
         }));
   }
 
@@ -429,6 +432,55 @@ TEST_F(ClusterManagerImplTest, RingHashLoadBalancerV2Initialization) {
   create(parseBootstrapFromV2Yaml(yaml));
 }
 
+// With the ring hash rings built on the main thread, the worker load balancers follow membership
+// changes of the primary cluster.
+TEST_F(ClusterManagerImplTest, RingHashLoadBalancerSharedRings) {
+  const std::string json = R"EOF(
+  {
+    "clusters": [
+    {
+      "name": "cluster_1",
+      "connect_timeout_ms": 250,
+      "type": "strict_dns",
+      "dns_resolvers": [ "1.2.3.4:80" ],
+      "lb_type": "ring_hash",
+      "hosts": [{"url": "tcp://localhost:11001"}]
+    }]
+  }
+  )EOF";
+
+  ON_CALL(factory_.runtime_.snapshot_,
+          featureEnabled("upstream.ring_hash.build_on_main_thread", 100))
+      .WillByDefault(Return(true));
+
+  std::shared_ptr<Network::MockDnsResolver> dns_resolver(new Network::MockDnsResolver());
+  EXPECT_CALL(factory_.dispatcher_, createDnsResolver(_)).WillOnce(Return(dns_resolver));
+
+  Network::DnsResolver::ResolveCb dns_callback;
+  Event::MockTimer* dns_timer_ = new NiceMock<Event::MockTimer>(&factory_.dispatcher_);
+  Network::MockActiveDnsQuery active_dns_query;
+  EXPECT_CALL(*dns_resolver, resolve(_, _, _))
+      .WillRepeatedly(DoAll(SaveArg<2>(&dns_callback), Return(&active_dns_query)));
+  create(parseBootstrapFromJson(json));
+  EXPECT_EQ(nullptr, cluster_manager_->get("cluster_1")->loadBalancer().chooseHost(nullptr));
+
+  dns_callback(TestUtility::makeDnsResponse({"127.0.0.1", "127.0.0.2"}));
+  EXPECT_NE(nullptr, cluster_manager_->get("cluster_1")->loadBalancer().chooseHost(nullptr));
+
+  dns_timer_->callback_();
+  dns_callback(TestUtility::makeDnsResponse({"127.0.0.2"}));
+  for (uint64_t i = 0; i < 10; i++) {
+    EXPECT_CALL(factory_.random_, random()).WillOnce(Return(i * 0x1000000000000000ULL));
+    EXPECT_EQ("127.0.0.2:11001", cluster_manager_->get("cluster_1")
+                                     ->loadBalancer()
+                                     .chooseHost(nullptr)
+                                     ->address()
+                                     ->asString());
+  }
+
+  factory_.tls_.shutdownThread();
+}
+
 TEST_F(ClusterManagerImplTest, TcpHealthChecker) {
   const std::string json = R"EOF(
   {
@@ -765,6 +817,56 @@ TEST_F(ClusterManagerImplTest, DynamicAddRemove) {
   EXPECT_TRUE(Mock::VerifyAndClearExpectations(cluster2.get()));
 }
 
+TEST_F(ClusterManagerImplTest, ClusterHandles) {
+  const std::string json = R"EOF(
+  {
+    "clusters": []
+  }
+  )EOF";
+
+  create(parseBootstrapFromJson(json));
+
+  // Handles can be resolved before their clusters exist.
+  const uint32_t handle = cluster_manager_->clusterHandle("fake_cluster");
+  EXPECT_EQ(handle, cluster_manager_->clusterHandle("fake_cluster"));
+  EXPECT_NE(handle, cluster_manager_->clusterHandle("other_cluster"));
+  EXPECT_EQ(nullptr, cluster_manager_->getByHandle(handle));
+  EXPECT_EQ(nullptr, cluster_manager_->httpConnPoolForClusterHandle(
+                         handle, ResourcePriority::Default, nullptr));
+
+  std::shared_ptr<MockCluster> cluster(new NiceMock<MockCluster>());
+  cluster->prioritySet().getMockHostSet(0)->hosts_ = {
+      makeTestHost(cluster->info_, "tcp://127.0.0.1:80")};
+  EXPECT_CALL(factory_, clusterFromProto_(_, _, _, _)).WillOnce(Return(cluster));
+  EXPECT_CALL(*cluster, initialize(_));
+  EXPECT_TRUE(cluster_manager_->addOrUpdatePrimaryCluster(defaultStaticCluster("fake_cluster")));
+
+  EXPECT_EQ(cluster_manager_->get("fake_cluster"), cluster_manager_->getByHandle(handle));
+  EXPECT_EQ(cluster->info_, cluster_manager_->getByHandle(handle)->info());
+  EXPECT_EQ(nullptr, cluster_manager_->getByHandle(cluster_manager_->clusterHandle("foo")));
+
+  // The pool found by handle is the one found by name.
+  Http::ConnectionPool::MockInstance* cp = new Http::ConnectionPool::MockInstance();
+  EXPECT_CALL(factory_, allocateConnPool_(_)).WillOnce(Return(cp));
+  EXPECT_EQ(cp, cluster_manager_->httpConnPoolForClusterHandle(handle, ResourcePriority::Default,
+                                                               nullptr));
+  EXPECT_EQ(cp, cluster_manager_->httpConnPoolForCluster("fake_cluster", ResourcePriority::Default,
+                                                         nullptr));
+
+  // Once the cluster is removed its handle finds nothing, until a cluster of that name is added.
+  Http::ConnectionPool::Instance::DrainedCb drained_cb;
+  EXPECT_CALL(*cp, addDrainedCallback(_)).WillOnce(SaveArg<0>(&drained_cb));
+  EXPECT_TRUE(cluster_manager_->removePrimaryCluster("fake_cluster"));
+  EXPECT_EQ(nullptr, cluster_manager_->getByHandle(handle));
+  EXPECT_EQ(nullptr, cluster_manager_->httpConnPoolForClusterHandle(
+                         handle, ResourcePriority::Default, nullptr));
+  EXPECT_EQ(handle, cluster_manager_->clusterHandle("fake_cluster"));
+
+  drained_cb();
+
+  EXPECT_TRUE(Mock::VerifyAndClearExpectations(cluster.get()));
+}
+
 TEST_F(ClusterManagerImplTest, AddOrUpdatePrimaryClusterStaticExists) {
   const std::string json =
       fmt::sprintf("{%s}", clustersJson({defaultStaticClusterJson("some_cluster")}));
@@ -792,6 +894,57 @@ TEST_F(ClusterManagerImplTest, AddOrUpdatePrimaryClusterStaticExists) {
   EXPECT_TRUE(Mock::VerifyAndClearExpectations(cluster1.get()));
 }
 
+TEST_F(ClusterManagerImplTest, OnDemandCluster) {
+  const std::string json = R"EOF(
+  {
+    "clusters": []
+  }
+  )EOF";
+
+  create(parseBootstrapFromJson(json));
+  ON_CALL(factory_.runtime_.snapshot_, featureEnabled("upstream.on_demand_cds", 0))
+      .WillByDefault(Return(true));
+
+  // Only the config of the cluster is kept until it's used.
+  EXPECT_CALL(factory_, clusterFromProto_(_, _, _, _)).Times(0);
+  EXPECT_TRUE(cluster_manager_->addOrUpdatePrimaryCluster(defaultStaticCluster("fake_cluster")));
+  EXPECT_FALSE(cluster_manager_->addOrUpdatePrimaryCluster(defaultStaticCluster("fake_cluster")));
+  EXPECT_EQ(nullptr, cluster_manager_->get("fake_cluster"));
+  EXPECT_EQ(0UL, cluster_manager_->clusters().size());
+  EXPECT_EQ(1UL, factory_.stats_.gauge("cluster_manager.on_demand_clusters").value());
+
+  // The first request creates the cluster, and the callers are notified once it has initialized.
+  std::shared_ptr<MockCluster> cluster1(new NiceMock<MockCluster>());
+  EXPECT_CALL(factory_, clusterFromProto_(_, _, _, _)).WillOnce(Return(cluster1));
+  EXPECT_CALL(*cluster1, initialize(_));
+  NiceMock<Event::MockDispatcher> worker_dispatcher;
+  ReadyWatcher loaded;
+  cluster_manager_->loadOnDemandCluster("fake_cluster", worker_dispatcher,
+                                        [&]() -> void { loaded.ready(); });
+  cluster_manager_->loadOnDemandCluster("fake_cluster", worker_dispatcher,
+                                        [&]() -> void { loaded.ready(); });
+  EXPECT_EQ(cluster1->info_, cluster_manager_->get("fake_cluster")->info());
+
+  EXPECT_CALL(loaded, ready()).Times(2);
+  cluster1->initialize_callback_();
+  EXPECT_EQ(0UL, factory_.stats_.gauge("cluster_manager.on_demand_clusters").value());
+  EXPECT_EQ(1UL, factory_.stats_.counter("cluster_manager.on_demand_cluster_created").value());
+
+  // Callers are notified straight away once the cluster exists, or if there is no such cluster.
+  EXPECT_CALL(loaded, ready()).Times(2);
+  cluster_manager_->loadOnDemandCluster("fake_cluster", worker_dispatcher,
+                                        [&]() -> void { loaded.ready(); });
+  cluster_manager_->loadOnDemandCluster("unknown_cluster", worker_dispatcher,
+                                        [&]() -> void { loaded.ready(); });
+
+  // A cluster which hasn't been created can be removed.
+  EXPECT_TRUE(cluster_manager_->addOrUpdatePrimaryCluster(defaultStaticCluster("other_cluster")));
+  EXPECT_TRUE(cluster_manager_->removePrimaryCluster("other_cluster"));
+  EXPECT_EQ(0UL, factory_.stats_.gauge("cluster_manager.on_demand_clusters").value());
+
+  EXPECT_TRUE(Mock::VerifyAndClearExpectations(cluster1.get()));
+}
+
 // Test that we close all HTTP connection pool connections when there is a host health failure.
 TEST_F(ClusterManagerImplTest, CloseConnectionsOnHealthFailure) {
   const std::string json =
@@ -1019,90 +1172,96 @@ TEST_F(ClusterManagerImplTest, OriginalDstInitialization) {
   factory_.tls_.shutdownThread();
 }
 
-TEST(ClusterManagerInitHelper, ImmediateInitialize) {
+class ClusterManagerInitHelperTest : public testing::Test {
+public:
+  ClusterManagerInitHelperTest() : init_helper_(cm_, runtime_, time_source_) {}
+
+  NiceMock<MockClusterManager> cm_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<MockMonotonicTimeSource> time_source_;
+  ClusterManagerInitHelper init_helper_;
+};
+
+TEST_F(ClusterManagerInitHelperTest, ImmediateInitialize) {
   InSequence s;
-  ClusterManagerInitHelper init_helper;
 
   NiceMock<MockCluster> cluster1;
   ON_CALL(cluster1, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Primary));
   EXPECT_CALL(cluster1, initialize(_));
-  init_helper.addCluster(cluster1);
+  init_helper_.addCluster(cluster1);
   cluster1.initialize_callback_();
 
-  init_helper.onStaticLoadComplete();
+  init_helper_.onStaticLoadComplete();
 
   ReadyWatcher cm_initialized;
   EXPECT_CALL(cm_initialized, ready());
-  init_helper.setInitializedCb([&]() -> void { cm_initialized.ready(); });
+  init_helper_.setInitializedCb([&]() -> void { cm_initialized.ready(); });
 }
 
-TEST(ClusterManagerInitHelper, StaticSdsInitialize) {
+TEST_F(ClusterManagerInitHelperTest, StaticSdsInitialize) {
   InSequence s;
-  ClusterManagerInitHelper init_helper;
 
   NiceMock<MockCluster> sds;
   ON_CALL(sds, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Primary));
   EXPECT_CALL(sds, initialize(_));
-  init_helper.addCluster(sds);
+  init_helper_.addCluster(sds);
   sds.initialize_callback_();
 
   NiceMock<MockCluster> cluster1;
   ON_CALL(cluster1, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Secondary));
-  init_helper.addCluster(cluster1);
+  init_helper_.addCluster(cluster1);
 
   EXPECT_CALL(cluster1, initialize(_));
-  init_helper.onStaticLoadComplete();
+  init_helper_.onStaticLoadComplete();
 
   ReadyWatcher cm_initialized;
-  init_helper.setInitializedCb([&]() -> void { cm_initialized.ready(); });
+  init_helper_.setInitializedCb([&]() -> void { cm_initialized.ready(); });
 
   EXPECT_CALL(cm_initialized, ready());
   cluster1.initialize_callback_();
 }
 
-TEST(ClusterManagerInitHelper, UpdateAlreadyInitialized) {
+TEST_F(ClusterManagerInitHelperTest, UpdateAlreadyInitialized) {
   InSequence s;
-  ClusterManagerInitHelper init_helper;
 
   ReadyWatcher cm_initialized;
-  init_helper.setInitializedCb([&]() -> void { cm_initialized.ready(); });
+  init_helper_.setInitializedCb([&]() -> void { cm_initialized.ready(); });
 
   NiceMock<MockCluster> cluster1;
   ON_CALL(cluster1, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Primary));
   EXPECT_CALL(cluster1, initialize(_));
-  init_helper.addCluster(cluster1);
+  init_helper_.addCluster(cluster1);
 
   NiceMock<MockCluster> cluster2;
   ON_CALL(cluster2, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Primary));
   EXPECT_CALL(cluster2, initialize(_));
-  init_helper.addCluster(cluster2);
+  init_helper_.addCluster(cluster2);
 
-  init_helper.onStaticLoadComplete();
+  init_helper_.onStaticLoadComplete();
 
   cluster1.initialize_callback_();
-  init_helper.removeCluster(cluster1);
+  init_helper_.removeCluster(cluster1);
 
   EXPECT_CALL(cm_initialized, ready());
   cluster2.initialize_callback_();
 }
 
-TEST(ClusterManagerInitHelper, AddSecondaryAfterSecondaryInit) {
+TEST_F(ClusterManagerInitHelperTest, AddSecondaryAfterSecondaryInit) {
   InSequence s;
-  ClusterManagerInitHelper init_helper;
 
   ReadyWatcher cm_initialized;
-  init_helper.setInitializedCb([&]() -> void { cm_initialized.ready(); });
+  init_helper_.setInitializedCb([&]() -> void { cm_initialized.ready(); });
 
   NiceMock<MockCluster> cluster1;
   ON_CALL(cluster1, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Primary));
   EXPECT_CALL(cluster1, initialize(_));
-  init_helper.addCluster(cluster1);
+  init_helper_.addCluster(cluster1);
 
   NiceMock<MockCluster> cluster2;
   ON_CALL(cluster2, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Secondary));
-  init_helper.addCluster(cluster2);
+  init_helper_.addCluster(cluster2);
 
-  init_helper.onStaticLoadComplete();
+  init_helper_.onStaticLoadComplete();
 
   EXPECT_CALL(cluster2, initialize(_));
   cluster1.initialize_callback_();
@@ -1110,33 +1269,97 @@ TEST(ClusterManagerInitHelper, AddSecondaryAfterSecondaryInit) {
   NiceMock<MockCluster> cluster3;
   ON_CALL(cluster3, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Secondary));
   EXPECT_CALL(cluster3, initialize(_));
-  init_helper.addCluster(cluster3);
+  init_helper_.addCluster(cluster3);
 
   cluster3.initialize_callback_();
   EXPECT_CALL(cm_initialized, ready());
   cluster2.initialize_callback_();
 }
 
-TEST(ClusterManagerInitHelper, RemoveClusterWithinInitLoop) {
+TEST_F(ClusterManagerInitHelperTest, RemoveClusterWithinInitLoop) {
   // Tests the scenario encountered in Issue 903: The cluster was removed from
   // the secondary init list while traversing the list.
 
   InSequence s;
-  ClusterManagerInitHelper init_helper;
   NiceMock<MockCluster> cluster;
   ON_CALL(cluster, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Secondary));
-  init_helper.addCluster(cluster);
+  init_helper_.addCluster(cluster);
 
   // Set up the scenario seen in Issue 903 where initialize() ultimately results
   // in the removeCluster() call. In the real bug this was a long and complex call
   // chain.
   EXPECT_CALL(cluster, initialize(_)).WillOnce(Invoke([&](std::function<void()>) -> void {
-    init_helper.removeCluster(cluster);
+    init_helper_.removeCluster(cluster);
   }));
 
   // Now call onStaticLoadComplete which will exercise maybeFinishInitialize()
   // which calls initialize() on the members of the secondary init list.
-  init_helper.onStaticLoadComplete();
+  init_helper_.onStaticLoadComplete();
+}
+
+TEST_F(ClusterManagerInitHelperTest, MaxConcurrentSecondaryInit) {
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.max_concurrent_secondary_cluster_init", 0))
+      .WillByDefault(Return(2));
+
+  NiceMock<MockCluster> cluster1;
+  NiceMock<MockCluster> cluster2;
+  NiceMock<MockCluster> cluster3;
+  for (MockCluster* cluster : {&cluster1, &cluster2, &cluster3}) {
+    ON_CALL(*cluster, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Secondary));
+    init_helper_.addCluster(*cluster);
+  }
+
+  // The EDS requests of the clusters started together are batched.
+  EXPECT_CALL(cm_.ads_mux_, pause(Config::TypeUrl::get().ClusterLoadAssignment));
+  EXPECT_CALL(cluster1, initialize(_));
+  EXPECT_CALL(cluster2, initialize(_));
+  EXPECT_CALL(cluster3, initialize(_)).Times(0);
+  EXPECT_CALL(cm_.ads_mux_, resume(Config::TypeUrl::get().ClusterLoadAssignment));
+  init_helper_.onStaticLoadComplete();
+
+  EXPECT_CALL(cm_.ads_mux_, pause(Config::TypeUrl::get().ClusterLoadAssignment));
+  EXPECT_CALL(cluster3, initialize(_));
+  EXPECT_CALL(cm_.ads_mux_, resume(Config::TypeUrl::get().ClusterLoadAssignment));
+  cluster1.initialize_callback_();
+
+  ReadyWatcher cm_initialized;
+  init_helper_.setInitializedCb([&]() -> void { cm_initialized.ready(); });
+  cluster2.initialize_callback_();
+  EXPECT_CALL(cm_initialized, ready());
+  cluster3.initialize_callback_();
+}
+
+TEST_F(ClusterManagerInitHelperTest, InitTimes) {
+  InSequence s;
+  NiceMock<MockCdsApi> cds;
+  init_helper_.setCds(&cds);
+
+  NiceMock<MockCluster> cluster1;
+  ON_CALL(cluster1, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Primary));
+  init_helper_.addCluster(cluster1);
+  init_helper_.onStaticLoadComplete();
+
+  EXPECT_CALL(time_source_, currentTime())
+      .WillOnce(Return(MonotonicTime(std::chrono::milliseconds(100))));
+  EXPECT_CALL(cds, initialize());
+  cluster1.initialize_callback_();
+  EXPECT_EQ(std::chrono::milliseconds(100), init_helper_.initTimes().static_clusters_);
+  EXPECT_EQ(std::chrono::milliseconds(0), init_helper_.initTimes().cds_);
+
+  EXPECT_CALL(time_source_, currentTime())
+      .WillOnce(Return(MonotonicTime(std::chrono::milliseconds(300))));
+  NiceMock<MockCluster> cluster2;
+  ON_CALL(cluster2, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Secondary));
+  init_helper_.addCluster(cluster2);
+  EXPECT_CALL(cluster2, initialize(_));
+  cds.initialized_callback_();
+  EXPECT_EQ(std::chrono::milliseconds(200), init_helper_.initTimes().cds_);
+
+  EXPECT_CALL(time_source_, currentTime())
+      .WillOnce(Return(MonotonicTime(std::chrono::milliseconds(350))));
+  cluster2.initialize_callback_();
+  EXPECT_EQ(std::chrono::milliseconds(50), init_helper_.initTimes().cds_clusters_);
+  EXPECT_EQ(ClusterManagerInitHelper::State::AllClustersInitialized, init_helper_.state());
 }
 
 } // namespace
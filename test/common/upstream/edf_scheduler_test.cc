@@ -0,0 +1,65 @@
+#include <cstdint>
+#include <vector>
+
+#include "common/upstream/edf_scheduler.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Upstream {
+
+TEST(EdfSchedulerTest, Empty) {
+  EdfScheduler<uint32_t> sched;
+  EXPECT_TRUE(sched.empty());
+  EXPECT_EQ(0U, sched.size());
+}
+
+// Equal weights are picked in insertion order, i.e. plain round robin.
+TEST(EdfSchedulerTest, Unweighted) {
+  EdfScheduler<uint32_t> sched;
+  for (uint32_t i = 0; i < 5; ++i) {
+    sched.add(1, i);
+  }
+  EXPECT_FALSE(sched.empty());
+  EXPECT_EQ(5U, sched.size());
+
+  for (uint32_t rounds = 0; rounds < 3; ++rounds) {
+    for (uint32_t i = 0; i < 5; ++i) {
+      EXPECT_EQ(i, sched.pick());
+    }
+  }
+}
+
+// Each entry is picked in proportion to its weight over a full cycle.
+TEST(EdfSchedulerTest, Weighted) {
+  EdfScheduler<uint32_t> sched;
+  const std::vector<uint32_t> weights = {1, 2, 5, 10};
+  for (uint32_t i = 0; i < weights.size(); ++i) {
+    sched.add(weights[i], i);
+  }
+
+  std::vector<uint32_t> picks(weights.size());
+  for (uint32_t i = 0; i < 18 * 10; ++i) {
+    picks[sched.pick()]++;
+  }
+  for (uint32_t i = 0; i < weights.size(); ++i) {
+    EXPECT_EQ(weights[i] * 10, picks[i]);
+  }
+}
+
+// Picks of the heavy entry are interleaved with picks of the light entries.
+TEST(EdfSchedulerTest, Interleaved) {
+  EdfScheduler<uint32_t> sched;
+  sched.add(1, 0);
+  sched.add(1, 1);
+  sched.add(2, 2);
+
+  // Deadlines: 0 -> 1, 2, ... 1 -> 1, 2, ... 2 -> 0.5, 1, 1.5, 2, ...
+  const std::vector<uint32_t> expected = {2, 0, 1, 2, 2, 0, 1, 2};
+  for (uint32_t expected_pick : expected) {
+    EXPECT_EQ(expected_pick, sched.pick());
+  }
+}
+
+} // namespace Upstream
+} // namespace Envoy
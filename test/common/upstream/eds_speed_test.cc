@@ -0,0 +1,90 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <memory>
+#include <string>
+
+#include "common/stats/stats_impl.h"
+#include "common/upstream/eds.h"
+
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/local_info/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/ssl/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+
+#include "api/eds.pb.h"
+#include "benchmark/benchmark.h"
+#include "fmt/format.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * Generate an assignment of num_hosts hosts in a single locality, starting from the first_host-th
+ * address of 10.0.0.0/8, so that assignments with a different first host differ by that many
+ * hosts at each end.
+ */
+static envoy::api::v2::ClusterLoadAssignment makeAssignment(size_t num_hosts, size_t first_host) {
+  envoy::api::v2::ClusterLoadAssignment assignment;
+  assignment.set_cluster_name("fare");
+  auto* endpoints = assignment.add_endpoints();
+  endpoints->mutable_locality()->set_zone("us-east-1a");
+  for (size_t i = first_host; i < first_host + num_hosts; i++) {
+    auto* address = endpoints->add_lb_endpoints()
+                        ->mutable_endpoint()
+                        ->mutable_address()
+                        ->mutable_socket_address();
+    address->set_address(fmt::format("10.{}.{}.{}", (i >> 16) & 0xff, (i >> 8) & 0xff, i & 0xff));
+    address->set_port_value(80);
+  }
+  return assignment;
+}
+
+// EDS updates of a cluster of range(0) hosts, each replacing range(1) of them, i.e. an unchanged
+// assignment when 0, a rolling change of a few hosts, or all the hosts when equal to range(0).
+static void EdsUpdate(benchmark::State& state) {
+  const size_t num_hosts = state.range(0);
+  const size_t hosts_changed = state.range(1);
+  Stats::IsolatedStoreImpl stats;
+  Ssl::MockContextManager ssl_context_manager;
+  NiceMock<Upstream::MockClusterManager> cm;
+  NiceMock<Event::MockDispatcher> dispatcher;
+  NiceMock<Runtime::MockRandomGenerator> random;
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<LocalInfo::MockLocalInfo> local_info;
+
+  envoy::api::v2::Cluster config;
+  config.set_name("name");
+  config.set_type(envoy::api::v2::Cluster::EDS);
+  config.mutable_connect_timeout()->set_seconds(1);
+  config.mutable_eds_cluster_config()->set_service_name("fare");
+  config.mutable_eds_cluster_config()->mutable_eds_config()->mutable_ads();
+  EdsClusterImpl cluster(config, runtime, stats, ssl_context_manager, local_info, cm, dispatcher,
+                         random, false);
+  cluster.initialize([] {});
+
+  Protobuf::RepeatedPtrField<envoy::api::v2::ClusterLoadAssignment> resources[2];
+  resources[0].Add()->MergeFrom(makeAssignment(num_hosts, 0));
+  resources[1].Add()->MergeFrom(makeAssignment(num_hosts, hosts_changed));
+  cluster.onConfigUpdate(resources[0]);
+
+  size_t update = 0;
+  while (state.KeepRunning()) {
+    cluster.onConfigUpdate(resources[++update % 2]);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * num_hosts);
+}
+BENCHMARK(EdsUpdate)
+    ->Args({1000, 0})
+    ->Args({1000, 10})
+    ->Args({1000, 1000})
+    ->Args({10000, 0})
+    ->Args({10000, 100})
+    ->Args({10000, 10000})
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace Upstream
+} // namespace Envoy
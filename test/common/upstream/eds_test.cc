@@ -436,5 +436,63 @@ TEST_F(EdsTest, PriorityAndLocality) {
   }
 }
 
+// Validate that an update which changes a few endpoints of a large cluster keeps the other hosts
+// and only reports the changed ones.
+TEST_F(EdsTest, EndpointsChanged) {
+  Protobuf::RepeatedPtrField<envoy::api::v2::ClusterLoadAssignment> resources;
+  auto* cluster_load_assignment = resources.Add();
+  cluster_load_assignment->set_cluster_name("fare");
+  auto* endpoints = cluster_load_assignment->add_endpoints();
+  auto add_endpoint = [endpoints](uint32_t port) {
+    auto* socket_address = endpoints->add_lb_endpoints()
+                               ->mutable_endpoint()
+                               ->mutable_address()
+                               ->mutable_socket_address();
+    socket_address->set_address("1.2.3.4");
+    socket_address->set_port_value(port);
+  };
+  for (uint32_t port = 1000; port < 1100; ++port) {
+    add_endpoint(port);
+  }
+
+  bool initialized = false;
+  cluster_->initialize([&initialized] { initialized = true; });
+  EXPECT_NO_THROW(cluster_->onConfigUpdate(resources));
+  EXPECT_TRUE(initialized);
+  const std::vector<HostSharedPtr> hosts =
+      cluster_->prioritySet().hostSetsPerPriority()[0]->hosts();
+  EXPECT_EQ(100UL, hosts.size());
+
+  std::vector<HostSharedPtr> hosts_added;
+  std::vector<HostSharedPtr> hosts_removed;
+  cluster_->prioritySet().addMemberUpdateCb(
+      [&](uint32_t, const std::vector<HostSharedPtr>& added,
+          const std::vector<HostSharedPtr>& removed) -> void {
+        hosts_added = added;
+        hosts_removed = removed;
+      });
+
+  // Remove the first endpoint, add a new one, add a duplicate and change a weight.
+  endpoints->mutable_lb_endpoints()->DeleteSubrange(0, 1);
+  add_endpoint(2000);
+  endpoints->add_lb_endpoints()->CopyFrom(endpoints->lb_endpoints(0));
+  endpoints->mutable_lb_endpoints(1)->mutable_load_balancing_weight()->set_value(5);
+  EXPECT_NO_THROW(cluster_->onConfigUpdate(resources));
+
+  EXPECT_EQ(1UL, hosts_added.size());
+  EXPECT_EQ("1.2.3.4:2000", hosts_added[0]->address()->asString());
+  EXPECT_EQ(1UL, hosts_removed.size());
+  EXPECT_EQ(hosts[0], hosts_removed[0]);
+
+  const std::vector<HostSharedPtr>& new_hosts =
+      cluster_->prioritySet().hostSetsPerPriority()[0]->hosts();
+  EXPECT_EQ(100UL, new_hosts.size());
+  for (size_t i = 0; i < 99; ++i) {
+    EXPECT_EQ(hosts[i + 1], new_hosts[i]);
+  }
+  EXPECT_EQ(5U, new_hosts[1]->weight());
+  EXPECT_EQ(5UL, stats_.gauge("cluster.name.max_host_weight").value());
+}
+
 } // namespace Upstream
 } // namespace Envoy
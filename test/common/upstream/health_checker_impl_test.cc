@@ -4,7 +4,11 @@
 #include <vector>
 
 #include "common/buffer/buffer_impl.h"
+#include "common/buffer/zero_copy_input_stream_impl.h"
+#include "common/common/enum_to_int.h"
 #include "common/config/cds_json.h"
+#include "common/grpc/codec.h"
+#include "common/grpc/common.h"
 #include "common/http/headers.h"
 #include "common/json/json_loader.h"
 #include "common/network/utility.h"
@@ -23,6 +27,7 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "source/common/grpc/health.pb.h"
 
 using testing::DoAll;
 using testing::InSequence;
@@ -64,7 +69,7 @@ TEST(HealthCheckerFactoryTest, createRedis) {
   Event::MockDispatcher dispatcher;
   EXPECT_NE(nullptr, dynamic_cast<RedisHealthCheckerImpl*>(
                          HealthCheckerFactory::create(parseHealthCheckFromJson(json), cluster,
-                                                      runtime, random, dispatcher)
+                                                      runtime, random, dispatcher, dispatcher)
                              .get()));
 }
 
@@ -78,12 +83,14 @@ TEST(HealthCheckerFactoryTest, MissingFieldiException) {
   Event::MockDispatcher dispatcher;
   envoy::api::v2::HealthCheck health_check;
   // No health checker type set
-  EXPECT_THROW(HealthCheckerFactory::create(health_check, cluster, runtime, random, dispatcher),
-               EnvoyException);
+  EXPECT_THROW(
+      HealthCheckerFactory::create(health_check, cluster, runtime, random, dispatcher, dispatcher),
+      EnvoyException);
   health_check.mutable_http_health_check();
   // No timeout field set.
-  EXPECT_THROW(HealthCheckerFactory::create(health_check, cluster, runtime, random, dispatcher),
-               MissingFieldException);
+  EXPECT_THROW(
+      HealthCheckerFactory::create(health_check, cluster, runtime, random, dispatcher, dispatcher),
+      MissingFieldException);
 }
 
 class TestHttpHealthCheckerImpl : public HttpHealthCheckerImpl {
@@ -816,6 +823,297 @@ TEST_F(HttpHealthCheckerImplTest, ConnectionReachesWatermarkDuringCheck) {
   EXPECT_TRUE(cluster_->prioritySet().getMockHostSet(0)->hosts_[0]->healthy());
 }
 
+TEST_F(HttpHealthCheckerImplTest, Http2) {
+  ON_CALL(*cluster_->info_, features()).WillByDefault(Return(ClusterInfo::Features::HTTP2));
+  ON_CALL(runtime_.snapshot_, featureEnabled("health_check.http2", 0)).WillByDefault(Return(true));
+  setupNoServiceValidationHC();
+  EXPECT_CALL(*this, onHostStatus(_, false));
+
+  cluster_->prioritySet().getMockHostSet(0)->hosts_ = {
+      makeTestHost(cluster_->info_, "tcp://127.0.0.1:80")};
+  expectSessionCreate();
+  expectStreamCreate(0);
+  EXPECT_CALL(test_sessions_[0]->request_encoder_, encodeHeaders(_, true))
+      .WillOnce(Invoke([](const Http::HeaderMap& headers, bool) -> void {
+        EXPECT_STREQ("http", headers.Scheme()->value().c_str());
+      }));
+  EXPECT_CALL(*test_sessions_[0]->timeout_timer_, enableTimer(_));
+  health_checker_->start();
+
+  EXPECT_CALL(*test_sessions_[0]->interval_timer_, enableTimer(_));
+  EXPECT_CALL(*test_sessions_[0]->timeout_timer_, disableTimer());
+  respond(0, "200", false);
+  EXPECT_TRUE(cluster_->prioritySet().getMockHostSet(0)->hosts_[0]->healthy());
+}
+
+TEST_F(HttpHealthCheckerImplTest, InitialJitter) {
+  ON_CALL(runtime_.snapshot_, getInteger("health_check.initial_jitter_ms", 0))
+      .WillByDefault(Return(1000));
+  setupNoServiceValidationHC();
+  EXPECT_CALL(*this, onHostStatus(_, false));
+
+  cluster_->prioritySet().getMockHostSet(0)->hosts_ = {
+      makeTestHost(cluster_->info_, "tcp://127.0.0.1:80")};
+  expectSessionCreate();
+  EXPECT_CALL(random_, random()).WillOnce(Return(1234)).WillRepeatedly(Return(0));
+  EXPECT_CALL(*test_sessions_[0]->interval_timer_, enableTimer(std::chrono::milliseconds(234)));
+  health_checker_->start();
+
+  expectStreamCreate(0);
+  EXPECT_CALL(*test_sessions_[0]->timeout_timer_, enableTimer(_));
+  test_sessions_[0]->interval_timer_->callback_();
+
+  EXPECT_CALL(*test_sessions_[0]->interval_timer_, enableTimer(_));
+  EXPECT_CALL(*test_sessions_[0]->timeout_timer_, disableTimer());
+  respond(0, "200", false);
+}
+
+// Host updates are posted to the health checking dispatcher and results are posted back to the
+// main thread dispatcher.
+TEST_F(HttpHealthCheckerImplTest, MainThreadDispatcher) {
+  setupNoServiceValidationHC();
+  NiceMock<Event::MockDispatcher> main_thread_dispatcher;
+  health_checker_->setMainThreadDispatcher(main_thread_dispatcher);
+
+  cluster_->prioritySet().getMockHostSet(0)->hosts_ = {
+      makeTestHost(cluster_->info_, "tcp://127.0.0.1:80")};
+  expectSessionCreate();
+  expectStreamCreate(0);
+  EXPECT_CALL(dispatcher_, post(_));
+  EXPECT_CALL(*test_sessions_[0]->timeout_timer_, enableTimer(_));
+  health_checker_->start();
+
+  std::function<void()> post_cb;
+  EXPECT_CALL(main_thread_dispatcher, post(_)).WillOnce(SaveArg<0>(&post_cb));
+  EXPECT_CALL(*test_sessions_[0]->interval_timer_, enableTimer(_));
+  EXPECT_CALL(*test_sessions_[0]->timeout_timer_, disableTimer());
+  respond(0, "200", false);
+
+  EXPECT_CALL(*this, onHostStatus(_, false));
+  post_cb();
+
+  std::vector<HostSharedPtr> removed{cluster_->prioritySet().getMockHostSet(0)->hosts_.back()};
+  cluster_->prioritySet().getMockHostSet(0)->hosts_.clear();
+  EXPECT_CALL(dispatcher_, post(_));
+  EXPECT_CALL(*test_sessions_[0]->client_connection_, close(_));
+  cluster_->prioritySet().getMockHostSet(0)->runCallbacks({}, removed);
+
+  // Results of checks which completed before the health checker went away are dropped.
+  health_checker_.reset();
+  post_cb();
+}
+
+class TestGrpcHealthCheckerImpl : public GrpcHealthCheckerImpl {
+public:
+  using GrpcHealthCheckerImpl::GrpcHealthCheckerImpl;
+
+  Http::CodecClient* createCodecClient(Upstream::Host::CreateConnectionData& conn_data) override {
+    return createCodecClient_(conn_data);
+  };
+
+  // GrpcHealthCheckerImpl
+  MOCK_METHOD1(createCodecClient_, Http::CodecClient*(Upstream::Host::CreateConnectionData&));
+};
+
+class GrpcHealthCheckerImplTest : public testing::Test {
+public:
+  GrpcHealthCheckerImplTest() : cluster_(new NiceMock<MockCluster>()) {
+    ON_CALL(*cluster_->info_, features()).WillByDefault(Return(ClusterInfo::Features::HTTP2));
+  }
+
+  static envoy::api::v2::HealthCheck healthCheckConfig() {
+    std::string json = R"EOF(
+    {
+      "type": "http",
+      "timeout_ms": 1000,
+      "interval_ms": 1000,
+      "unhealthy_threshold": 2,
+      "healthy_threshold": 2,
+      "service_name": "locations",
+      "path": "/grpc.health.v1.Health/Check"
+    }
+    )EOF";
+    return parseHealthCheckFromJson(json);
+  }
+
+  void setup() {
+    health_checker_.reset(new TestGrpcHealthCheckerImpl(*cluster_, healthCheckConfig(), dispatcher_,
+                                                        runtime_, random_));
+    health_checker_->addHostCheckCompleteCb([this](HostSharedPtr host, bool changed_state) -> void {
+      onHostStatus(host, changed_state);
+    });
+
+    cluster_->prioritySet().getMockHostSet(0)->hosts_ = {
+        makeTestHost(cluster_->info_, "tcp://127.0.0.1:80")};
+    // Expectations are in LIFO order.
+    timeout_timer_ = new Event::MockTimer(&dispatcher_);
+    interval_timer_ = new Event::MockTimer(&dispatcher_);
+    codec_ = new NiceMock<Http::MockClientConnection>();
+    client_connection_ = new NiceMock<Network::MockClientConnection>();
+    EXPECT_CALL(dispatcher_, createClientConnection_(_, _)).WillOnce(Return(client_connection_));
+    EXPECT_CALL(*health_checker_, createCodecClient_(_))
+        .WillOnce(
+            Invoke([&](Upstream::Host::CreateConnectionData& conn_data) -> Http::CodecClient* {
+              return new CodecClientForTest(std::move(conn_data.connection_), codec_, nullptr,
+                                            nullptr);
+            }));
+  }
+
+  void expectStreamCreate() {
+    EXPECT_CALL(*codec_, newStream(_))
+        .WillOnce(DoAll(SaveArgAddress(&response_decoder_), ReturnRef(request_encoder_)));
+    EXPECT_CALL(*timeout_timer_, enableTimer(_));
+  }
+
+  void respondHeaders() {
+    response_decoder_->decodeHeaders(
+        Http::HeaderMapPtr{new Http::TestHeaderMapImpl{{":status", "200"},
+                                                       {"content-type", "application/grpc"}}},
+        false);
+  }
+
+  void respondTrailersOnly(Grpc::Status::GrpcStatus grpc_status) {
+    response_decoder_->decodeHeaders(
+        Http::HeaderMapPtr{new Http::TestHeaderMapImpl{
+            {":status", "200"},
+            {"content-type", "application/grpc"},
+            {"grpc-status", std::to_string(enumToInt(grpc_status))}}},
+        true);
+  }
+
+  void respond(grpc::health::v1::HealthCheckResponse::ServingStatus serving_status,
+               Grpc::Status::GrpcStatus grpc_status = Grpc::Status::GrpcStatus::Ok) {
+    respondHeaders();
+    grpc::health::v1::HealthCheckResponse response;
+    response.set_status(serving_status);
+    response_decoder_->decodeData(*Grpc::Common::serializeBody(response), false);
+    response_decoder_->decodeTrailers(Http::HeaderMapPtr{new Http::TestHeaderMapImpl{
+        {"grpc-status", std::to_string(enumToInt(grpc_status))}}});
+  }
+
+  HostSharedPtr host() { return cluster_->prioritySet().getMockHostSet(0)->hosts_[0]; }
+
+  MOCK_METHOD2(onHostStatus, void(HostSharedPtr host, bool changed_state));
+
+  std::shared_ptr<MockCluster> cluster_;
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  std::shared_ptr<TestGrpcHealthCheckerImpl> health_checker_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<Runtime::MockRandomGenerator> random_;
+  Event::MockTimer* interval_timer_{};
+  Event::MockTimer* timeout_timer_{};
+  Http::MockClientConnection* codec_{};
+  Network::MockClientConnection* client_connection_{};
+  NiceMock<Http::MockStreamEncoder> request_encoder_;
+  Http::StreamDecoder* response_decoder_{};
+};
+
+TEST_F(GrpcHealthCheckerImplTest, Success) {
+  setup();
+  expectStreamCreate();
+  EXPECT_CALL(request_encoder_, encodeHeaders(_, false))
+      .Times(2)
+      .WillRepeatedly(Invoke([](const Http::HeaderMap& headers, bool) -> void {
+        EXPECT_STREQ("POST", headers.Method()->value().c_str());
+        EXPECT_STREQ("/grpc.health.v1.Health/Check", headers.Path()->value().c_str());
+        EXPECT_STREQ("application/grpc", headers.ContentType()->value().c_str());
+        EXPECT_STREQ("http", headers.Scheme()->value().c_str());
+      }));
+  EXPECT_CALL(request_encoder_, encodeData(_, true))
+      .Times(2)
+      .WillRepeatedly(Invoke([](Buffer::Instance& data, bool) -> void {
+        std::vector<Grpc::Frame> frames;
+        ASSERT_TRUE(Grpc::Decoder().decode(data, frames));
+        ASSERT_EQ(1U, frames.size());
+        grpc::health::v1::HealthCheckRequest request;
+        Buffer::ZeroCopyInputStreamImpl stream(std::move(frames[0].data_));
+        EXPECT_TRUE(request.ParseFromZeroCopyStream(&stream));
+        EXPECT_EQ("locations", request.service());
+      }));
+  health_checker_->start();
+
+  EXPECT_CALL(*this, onHostStatus(_, false));
+  EXPECT_CALL(*interval_timer_, enableTimer(_));
+  EXPECT_CALL(*timeout_timer_, disableTimer());
+  respond(grpc::health::v1::HealthCheckResponse::SERVING);
+  EXPECT_TRUE(host()->healthy());
+
+  // The next check is a new stream on the same connection.
+  expectStreamCreate();
+  interval_timer_->callback_();
+  EXPECT_CALL(*this, onHostStatus(_, false));
+  EXPECT_CALL(*interval_timer_, enableTimer(_));
+  EXPECT_CALL(*timeout_timer_, disableTimer());
+  respond(grpc::health::v1::HealthCheckResponse::SERVING);
+  EXPECT_EQ(2UL, cluster_->info_->stats_store_.counter("health_check.success").value());
+}
+
+TEST_F(GrpcHealthCheckerImplTest, NotServing) {
+  setup();
+  expectStreamCreate();
+  health_checker_->start();
+
+  EXPECT_CALL(*this, onHostStatus(_, true));
+  EXPECT_CALL(*interval_timer_, enableTimer(_));
+  EXPECT_CALL(*timeout_timer_, disableTimer());
+  respond(grpc::health::v1::HealthCheckResponse::NOT_SERVING);
+  EXPECT_TRUE(host()->healthFlagGet(Host::HealthFlag::FAILED_ACTIVE_HC));
+}
+
+TEST_F(GrpcHealthCheckerImplTest, GrpcError) {
+  setup();
+  expectStreamCreate();
+  health_checker_->start();
+
+  EXPECT_CALL(*this, onHostStatus(_, true));
+  EXPECT_CALL(*interval_timer_, enableTimer(_));
+  EXPECT_CALL(*timeout_timer_, disableTimer());
+  respond(grpc::health::v1::HealthCheckResponse::SERVING, Grpc::Status::GrpcStatus::Unavailable);
+  EXPECT_FALSE(host()->healthy());
+}
+
+TEST_F(GrpcHealthCheckerImplTest, TrailersOnlyError) {
+  setup();
+  expectStreamCreate();
+  health_checker_->start();
+
+  EXPECT_CALL(*this, onHostStatus(_, true));
+  EXPECT_CALL(*interval_timer_, enableTimer(_));
+  EXPECT_CALL(*timeout_timer_, disableTimer());
+  respondTrailersOnly(Grpc::Status::GrpcStatus::Unimplemented);
+  EXPECT_FALSE(host()->healthy());
+}
+
+TEST_F(GrpcHealthCheckerImplTest, MissingTrailers) {
+  setup();
+  expectStreamCreate();
+  health_checker_->start();
+
+  EXPECT_CALL(*this, onHostStatus(_, true));
+  EXPECT_CALL(*interval_timer_, enableTimer(_));
+  EXPECT_CALL(*timeout_timer_, disableTimer());
+  respondHeaders();
+  grpc::health::v1::HealthCheckResponse response;
+  response.set_status(grpc::health::v1::HealthCheckResponse::SERVING);
+  response_decoder_->decodeData(*Grpc::Common::serializeBody(response), true);
+  EXPECT_FALSE(host()->healthy());
+}
+
+TEST_F(GrpcHealthCheckerImplTest, Factory) {
+  Event::MockDispatcher dispatcher;
+  EXPECT_NE(nullptr, dynamic_cast<ProdGrpcHealthCheckerImpl*>(
+                         HealthCheckerFactory::create(healthCheckConfig(), *cluster_, runtime_,
+                                                      random_, dispatcher, dispatcher)
+                             .get()));
+
+  ON_CALL(*cluster_->info_, features()).WillByDefault(Return(0));
+  EXPECT_THROW_WITH_MESSAGE(HealthCheckerFactory::create(healthCheckConfig(), *cluster_, runtime_,
+                                                         random_, dispatcher, dispatcher),
+                            EnvoyException,
+                            "gRPC health checks of cluster 'fake_cluster' require it to use "
+                            "HTTP/2");
+}
+
 TEST(TcpHealthCheckMatcher, loadJsonBytes) {
   {
     Protobuf::RepeatedPtrField<envoy::api::v2::HealthCheck::Payload> repeated_payload;
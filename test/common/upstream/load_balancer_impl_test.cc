@@ -1,3 +1,4 @@
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <set>
@@ -71,6 +72,108 @@ TEST_F(RoundRobinLoadBalancerTest, Normal) {
   EXPECT_EQ(host_set_.healthy_hosts_[0], lb_->chooseHost(nullptr));
 }
 
+// Hosts with non 1 weights are picked in proportion to their weight, interleaved.
+TEST_F(RoundRobinLoadBalancerTest, Weighted) {
+  init(false);
+  host_set_.healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80", 1),
+                              makeTestHost(info_, "tcp://127.0.0.1:81", 2)};
+  host_set_.hosts_ = host_set_.healthy_hosts_;
+  stats_.max_host_weight_.set(2UL);
+
+  // Deadlines: 80 -> 1, 2, ... 81 -> 0.5, 1, 1.5, 2, ...
+  for (uint32_t i = 0; i < 2; ++i) {
+    EXPECT_EQ(host_set_.healthy_hosts_[1], lb_->chooseHost(nullptr));
+    EXPECT_EQ(host_set_.healthy_hosts_[0], lb_->chooseHost(nullptr));
+    EXPECT_EQ(host_set_.healthy_hosts_[1], lb_->chooseHost(nullptr));
+  }
+
+  // A membership update rebuilds the schedule.
+  host_set_.healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:82", 3),
+                              makeTestHost(info_, "tcp://127.0.0.1:83", 1)};
+  host_set_.hosts_ = host_set_.healthy_hosts_;
+  stats_.max_host_weight_.set(3UL);
+  host_set_.runCallbacks({}, {});
+  std::vector<uint32_t> picks(2);
+  for (uint32_t i = 0; i < 40; ++i) {
+    picks[lb_->chooseHost(nullptr) == host_set_.healthy_hosts_[0] ? 0 : 1]++;
+  }
+  EXPECT_EQ(30U, picks[0]);
+  EXPECT_EQ(10U, picks[1]);
+
+  // Weights are ignored if disabled by runtime.
+  EXPECT_CALL(runtime_.snapshot_, getInteger("upstream.weight_enabled", 1))
+      .WillRepeatedly(Return(0));
+  EXPECT_EQ(host_set_.healthy_hosts_[0], lb_->chooseHost(nullptr));
+  EXPECT_EQ(host_set_.healthy_hosts_[1], lb_->chooseHost(nullptr));
+  EXPECT_EQ(host_set_.healthy_hosts_[0], lb_->chooseHost(nullptr));
+}
+
+// Hosts in their slow start window are picked in proportion to their ramped weight.
+TEST_F(RoundRobinLoadBalancerTest, SlowStart) {
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.slow_start.window_ms", 0))
+      .WillByDefault(Return(60000));
+  host_set_.healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80"),
+                              makeTestHost(info_, "tcp://127.0.0.1:81")};
+  host_set_.hosts_ = host_set_.healthy_hosts_;
+  host_set_.healthy_hosts_[1]->slowStartTime(MonotonicTime());
+  init(false);
+
+  // The new host starts from 10% of its weight.
+  std::vector<uint32_t> picks(2);
+  for (uint32_t i = 0; i < 110; ++i) {
+    picks[lb_->chooseHost(nullptr) == host_set_.healthy_hosts_[0] ? 0 : 1]++;
+  }
+  EXPECT_NEAR(10, picks[0], 1);
+  EXPECT_NEAR(100, picks[1], 1);
+
+  // Once disabled, plain round robin applies again.
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.slow_start.window_ms", 0))
+      .WillByDefault(Return(0));
+  HostConstSharedPtr host = lb_->chooseHost(nullptr);
+  EXPECT_NE(host, lb_->chooseHost(nullptr));
+}
+
+// Weighted localities are picked in proportion to their weight scaled by their healthy hosts.
+TEST_F(RoundRobinLoadBalancerTest, WeightedLocalities) {
+  HostSharedPtr host_a = makeTestHost(info_, "tcp://127.0.0.1:80");
+  HostSharedPtr host_b = makeTestHost(info_, "tcp://127.0.0.1:81");
+  HostSharedPtr host_c = makeTestHost(info_, "tcp://127.0.0.1:82");
+  host_set_.hosts_ = {host_a, host_b};
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.hosts_per_locality_ = {{host_a}, {host_b}};
+  host_set_.healthy_hosts_per_locality_ = host_set_.hosts_per_locality_;
+  host_set_.locality_weights_.reset(new std::vector<uint32_t>{1, 2});
+  init(false);
+
+  std::vector<uint32_t> picks(2);
+  for (uint32_t i = 0; i < 30; ++i) {
+    picks[lb_->chooseHost(nullptr) == host_a ? 0 : 1]++;
+  }
+  EXPECT_EQ(10U, picks[0]);
+  EXPECT_EQ(20U, picks[1]);
+
+  // Half of the second locality is unhealthy, which halves its weight.
+  host_set_.hosts_ = {host_a, host_b, host_c};
+  host_set_.healthy_hosts_ = {host_a, host_b};
+  host_set_.hosts_per_locality_ = {{host_a}, {host_b, host_c}};
+  host_set_.healthy_hosts_per_locality_ = {{host_a}, {host_b}};
+  host_set_.runCallbacks({host_c}, {});
+  picks = {0, 0};
+  for (uint32_t i = 0; i < 30; ++i) {
+    picks[lb_->chooseHost(nullptr) == host_a ? 0 : 1]++;
+  }
+  EXPECT_EQ(15U, picks[0]);
+  EXPECT_EQ(15U, picks[1]);
+
+  // A locality without healthy hosts isn't picked.
+  host_set_.healthy_hosts_ = {host_b, host_c};
+  host_set_.healthy_hosts_per_locality_ = {{}, {host_b, host_c}};
+  host_set_.runCallbacks({}, {});
+  for (uint32_t i = 0; i < 10; ++i) {
+    EXPECT_NE(host_a, lb_->chooseHost(nullptr));
+  }
+}
+
 TEST_F(RoundRobinLoadBalancerTest, MaxUnhealthyPanic) {
   init(false);
   host_set_.healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80"),
@@ -108,7 +211,7 @@ TEST_F(RoundRobinLoadBalancerTest, ZoneAwareSmallCluster) {
   host_set_.hosts_ = *hosts;
   host_set_.healthy_hosts_ = *hosts;
   host_set_.healthy_hosts_per_locality_ = *hosts_per_locality;
-  local_host_set_->updateHosts(hosts, hosts, hosts_per_locality, hosts_per_locality,
+  local_host_set_->updateHosts(hosts, hosts, hosts_per_locality, hosts_per_locality, nullptr,
                                empty_host_vector_, empty_host_vector_);
 
   EXPECT_CALL(runtime_.snapshot_, getInteger("upstream.healthy_panic_threshold", 50))
@@ -128,7 +231,7 @@ TEST_F(RoundRobinLoadBalancerTest, ZoneAwareSmallCluster) {
   EXPECT_CALL(runtime_.snapshot_, getInteger("upstream.zone_routing.min_cluster_size", 6))
       .WillRepeatedly(Return(1));
   // Trigger reload.
-  local_host_set_->updateHosts(hosts, hosts, hosts_per_locality, hosts_per_locality,
+  local_host_set_->updateHosts(hosts, hosts, hosts_per_locality, hosts_per_locality, nullptr,
                                empty_host_vector_, empty_host_vector_);
   EXPECT_EQ(host_set_.healthy_hosts_per_locality_[0][0], lb_->chooseHost(nullptr));
 }
@@ -149,7 +252,7 @@ TEST_F(RoundRobinLoadBalancerTest, NoZoneAwareDifferentZoneSize) {
   host_set_.hosts_ = *hosts;
   host_set_.healthy_hosts_per_locality_ = *upstream_hosts_per_locality;
   local_host_set_->updateHosts(hosts, hosts, local_hosts_per_locality, local_hosts_per_locality,
-                               empty_host_vector_, empty_host_vector_);
+                               nullptr, empty_host_vector_, empty_host_vector_);
 
   EXPECT_CALL(runtime_.snapshot_, getInteger("upstream.healthy_panic_threshold", 50))
       .WillRepeatedly(Return(50));
@@ -180,7 +283,7 @@ TEST_F(RoundRobinLoadBalancerTest, ZoneAwareRoutingLargeZoneSwitchOnOff) {
   host_set_.healthy_hosts_ = *hosts;
   host_set_.hosts_ = *hosts;
   host_set_.healthy_hosts_per_locality_ = *hosts_per_locality;
-  local_host_set_->updateHosts(hosts, hosts, hosts_per_locality, hosts_per_locality,
+  local_host_set_->updateHosts(hosts, hosts, hosts_per_locality, hosts_per_locality, nullptr,
                                empty_host_vector_, empty_host_vector_);
 
   // There is only one host in the given zone for zone aware routing.
@@ -226,7 +329,8 @@ TEST_F(RoundRobinLoadBalancerTest, ZoneAwareRoutingSmallZone) {
   host_set_.hosts_ = *upstream_hosts;
   host_set_.healthy_hosts_per_locality_ = *upstream_hosts_per_locality;
   local_host_set_->updateHosts(local_hosts, local_hosts, local_hosts_per_locality,
-                               local_hosts_per_locality, empty_host_vector_, empty_host_vector_);
+                               local_hosts_per_locality, nullptr, empty_host_vector_,
+                               empty_host_vector_);
 
   // There is only one host in the given zone for zone aware routing.
   EXPECT_CALL(random_, random()).WillOnce(Return(100));
@@ -294,7 +398,8 @@ TEST_F(RoundRobinLoadBalancerTest, LowPrecisionForDistribution) {
 
   // To trigger update callback.
   local_host_set_->updateHosts(local_hosts, local_hosts, local_hosts_per_locality,
-                               local_hosts_per_locality, empty_host_vector_, empty_host_vector_);
+                               local_hosts_per_locality, nullptr, empty_host_vector_,
+                               empty_host_vector_);
 
   // Force request out of small zone and to randomly select zone.
   EXPECT_CALL(random_, random()).WillOnce(Return(9999)).WillOnce(Return(2));
@@ -312,7 +417,7 @@ TEST_F(RoundRobinLoadBalancerTest, NoZoneAwareRoutingOneZone) {
   host_set_.healthy_hosts_ = *hosts;
   host_set_.hosts_ = *hosts;
   host_set_.healthy_hosts_per_locality_ = *hosts_per_locality;
-  local_host_set_->updateHosts(hosts, hosts, hosts_per_locality, hosts_per_locality,
+  local_host_set_->updateHosts(hosts, hosts, hosts_per_locality, hosts_per_locality, nullptr,
                                empty_host_vector_, empty_host_vector_);
   EXPECT_EQ(host_set_.healthy_hosts_[0], lb_->chooseHost(nullptr));
 }
@@ -328,7 +433,7 @@ TEST_F(RoundRobinLoadBalancerTest, NoZoneAwareRoutingNotHealthy) {
   host_set_.healthy_hosts_ = *hosts;
   host_set_.hosts_ = *hosts;
   host_set_.healthy_hosts_per_locality_ = *hosts_per_locality;
-  local_host_set_->updateHosts(hosts, hosts, hosts_per_locality, hosts_per_locality,
+  local_host_set_->updateHosts(hosts, hosts, hosts_per_locality, hosts_per_locality, nullptr,
                                empty_host_vector_, empty_host_vector_);
 
   // local zone has no healthy hosts, take from the all healthy hosts.
@@ -359,7 +464,8 @@ TEST_F(RoundRobinLoadBalancerTest, NoZoneAwareRoutingLocalEmpty) {
   host_set_.hosts_ = *upstream_hosts;
   host_set_.healthy_hosts_per_locality_ = *upstream_hosts_per_locality;
   local_host_set_->updateHosts(local_hosts, local_hosts, local_hosts_per_locality,
-                               local_hosts_per_locality, empty_host_vector_, empty_host_vector_);
+                               local_hosts_per_locality, nullptr, empty_host_vector_,
+                               empty_host_vector_);
 
   // Local cluster is not OK, we'll do regular routing.
   EXPECT_EQ(host_set_.healthy_hosts_[0], lb_->chooseHost(nullptr));
@@ -375,6 +481,9 @@ public:
 TEST_F(LeastRequestLoadBalancerTest, NoHosts) { EXPECT_EQ(nullptr, lb_.chooseHost(nullptr)); }
 
 TEST_F(LeastRequestLoadBalancerTest, SingleHost) {
+  // Use the legacy weighted random selection for non 1 weights.
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.least_request.weighted_p2c", 1))
+      .WillByDefault(Return(0));
   host_set_.healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80")};
   host_set_.hosts_ = host_set_.healthy_hosts_;
 
@@ -452,6 +561,9 @@ TEST_F(LeastRequestLoadBalancerTest, WeightImbalanceRuntimeOff) {
 }
 
 TEST_F(LeastRequestLoadBalancerTest, WeightImbalance) {
+  // Use the legacy weighted random selection for non 1 weights.
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.least_request.weighted_p2c", 1))
+      .WillByDefault(Return(0));
   host_set_.healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80", 1),
                               makeTestHost(info_, "tcp://127.0.0.1:81", 3)};
   stats_.max_host_weight_.set(3UL);
@@ -497,6 +609,9 @@ TEST_F(LeastRequestLoadBalancerTest, WeightImbalance) {
 }
 
 TEST_F(LeastRequestLoadBalancerTest, WeightImbalanceCallbacks) {
+  // Use the legacy weighted random selection for non 1 weights.
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.least_request.weighted_p2c", 1))
+      .WillByDefault(Return(0));
   host_set_.healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80", 1),
                               makeTestHost(info_, "tcp://127.0.0.1:81", 3)};
   stats_.max_host_weight_.set(3UL);
@@ -518,6 +633,129 @@ TEST_F(LeastRequestLoadBalancerTest, WeightImbalanceCallbacks) {
   EXPECT_EQ(host_set_.healthy_hosts_[0], lb_.chooseHost(nullptr));
 }
 
+// With weighted P2C, the two randomly chosen hosts are compared by active requests per weight.
+TEST_F(LeastRequestLoadBalancerTest, WeightedP2C) {
+  host_set_.healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80", 1),
+                              makeTestHost(info_, "tcp://127.0.0.1:81", 3)};
+  stats_.max_host_weight_.set(3UL);
+  host_set_.hosts_ = host_set_.healthy_hosts_;
+
+  // Both idle, the heavier host wins either way round.
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(host_set_.healthy_hosts_[1], lb_.chooseHost(nullptr));
+  EXPECT_CALL(random_, random()).WillOnce(Return(1)).WillOnce(Return(0));
+  EXPECT_EQ(host_set_.healthy_hosts_[1], lb_.chooseHost(nullptr));
+
+  // (1 + 1) / 1 < (5 + 1) / 3 is false, the heavier host still wins.
+  host_set_.healthy_hosts_[0]->stats().rq_active_.set(1);
+  host_set_.healthy_hosts_[1]->stats().rq_active_.set(5);
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(host_set_.healthy_hosts_[1], lb_.chooseHost(nullptr));
+
+  // (1 + 1) / 1 < (6 + 1) / 3, so the lighter host wins.
+  host_set_.healthy_hosts_[1]->stats().rq_active_.set(6);
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(host_set_.healthy_hosts_[0], lb_.chooseHost(nullptr));
+  EXPECT_CALL(random_, random()).WillOnce(Return(1)).WillOnce(Return(0));
+  EXPECT_EQ(host_set_.healthy_hosts_[0], lb_.chooseHost(nullptr));
+
+  // Weights are ignored if disabled by runtime.
+  EXPECT_CALL(runtime_.snapshot_, getInteger("upstream.weight_enabled", 1))
+      .WillRepeatedly(Return(0));
+  host_set_.healthy_hosts_[1]->stats().rq_active_.set(2);
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(host_set_.healthy_hosts_[0], lb_.chooseHost(nullptr));
+}
+
+// If priority 0 is in panic mode, the healthy hosts of the first higher priority that is not in
+// panic mode are used.
+TEST_F(LeastRequestLoadBalancerTest, PriorityFailover) {
+  MockHostSet& failover_host_set = *priority_set_.getMockHostSet(1);
+  MockHostSet& second_failover_host_set = *priority_set_.getMockHostSet(2);
+  second_failover_host_set.hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:90")};
+  second_failover_host_set.healthy_hosts_ = second_failover_host_set.hosts_;
+  stats_.max_host_weight_.set(1UL);
+
+  // No hosts at priority 0 or 1.
+  EXPECT_CALL(random_, random()).WillRepeatedly(Return(0));
+  EXPECT_EQ(second_failover_host_set.hosts_[0], lb_.chooseHost(nullptr));
+
+  failover_host_set.hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:85"),
+                              makeTestHost(info_, "tcp://127.0.0.1:86")};
+  failover_host_set.healthy_hosts_ = {failover_host_set.hosts_[1]};
+  EXPECT_EQ(failover_host_set.hosts_[1], lb_.chooseHost(nullptr));
+
+  // Priority 0 is in panic mode, priority 1 is used.
+  host_set_.hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80"),
+                      makeTestHost(info_, "tcp://127.0.0.1:81"),
+                      makeTestHost(info_, "tcp://127.0.0.1:82")};
+  host_set_.healthy_hosts_ = {host_set_.hosts_[2]};
+  EXPECT_EQ(failover_host_set.hosts_[1], lb_.chooseHost(nullptr));
+  EXPECT_EQ(0UL, stats_.lb_healthy_panic_.value());
+
+  // Priority 0 is healthy enough again.
+  host_set_.healthy_hosts_ = {host_set_.hosts_[1], host_set_.hosts_[2]};
+  EXPECT_EQ(host_set_.hosts_[1], lb_.chooseHost(nullptr));
+
+  // Everything is in panic mode, use all hosts at priority 0.
+  host_set_.healthy_hosts_ = {};
+  failover_host_set.healthy_hosts_ = {};
+  second_failover_host_set.healthy_hosts_ = {};
+  EXPECT_EQ(host_set_.hosts_[0], lb_.chooseHost(nullptr));
+  EXPECT_EQ(1UL, stats_.lb_healthy_panic_.value());
+}
+
+class PeakEwmaLoadBalancerTest : public LoadBalancerTestBase {
+public:
+  PeakEwmaLoadBalancer lb_{priority_set_, nullptr, stats_, runtime_, random_};
+};
+
+TEST_F(PeakEwmaLoadBalancerTest, NoHosts) { EXPECT_EQ(nullptr, lb_.chooseHost(nullptr)); }
+
+// The host with the lower latency times active requests is picked.
+TEST_F(PeakEwmaLoadBalancerTest, Latency) {
+  host_set_.healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80"),
+                              makeTestHost(info_, "tcp://127.0.0.1:81")};
+  host_set_.hosts_ = host_set_.healthy_hosts_;
+  const MonotonicTime now = ProdMonotonicTimeSource::instance_.currentTime();
+  host_set_.healthy_hosts_[0]->latencyEstimator().putLatency(std::chrono::milliseconds(10), now);
+  host_set_.healthy_hosts_[1]->latencyEstimator().putLatency(std::chrono::milliseconds(1), now);
+
+  // Both idle, the faster host wins either way round.
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(host_set_.healthy_hosts_[1], lb_.chooseHost(nullptr));
+  EXPECT_CALL(random_, random()).WillOnce(Return(1)).WillOnce(Return(0));
+  EXPECT_EQ(host_set_.healthy_hosts_[1], lb_.chooseHost(nullptr));
+
+  // 1ms * (20 + 1) > 10ms * (0 + 1), so the slower host wins.
+  host_set_.healthy_hosts_[1]->stats().rq_active_.set(20);
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(host_set_.healthy_hosts_[0], lb_.chooseHost(nullptr));
+
+  // Weights divide the load.
+  host_set_.healthy_hosts_[1]->weight(3);
+  stats_.max_host_weight_.set(3UL);
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(host_set_.healthy_hosts_[1], lb_.chooseHost(nullptr));
+}
+
+// A host which has not responded yet is only picked while it has no active requests.
+TEST_F(PeakEwmaLoadBalancerTest, Unmeasured) {
+  host_set_.healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80"),
+                              makeTestHost(info_, "tcp://127.0.0.1:81")};
+  host_set_.hosts_ = host_set_.healthy_hosts_;
+  host_set_.healthy_hosts_[0]->latencyEstimator().putLatency(
+      std::chrono::seconds(1), ProdMonotonicTimeSource::instance_.currentTime());
+  host_set_.healthy_hosts_[0]->stats().rq_active_.set(100);
+
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(host_set_.healthy_hosts_[1], lb_.chooseHost(nullptr));
+
+  host_set_.healthy_hosts_[1]->stats().rq_active_.set(1);
+  EXPECT_CALL(random_, random()).WillOnce(Return(1)).WillOnce(Return(0));
+  EXPECT_EQ(host_set_.healthy_hosts_[0], lb_.chooseHost(nullptr));
+}
+
 class RandomLoadBalancerTest : public LoadBalancerTestBase {
 public:
   RandomLoadBalancer lb_{priority_set_, nullptr, stats_, runtime_, random_};
@@ -534,6 +772,27 @@ TEST_F(RandomLoadBalancerTest, Normal) {
   EXPECT_EQ(host_set_.healthy_hosts_[1], lb_.chooseHost(nullptr));
 }
 
+// Hosts in their slow start window are only kept with a probability of their ramped weight.
+TEST_F(RandomLoadBalancerTest, SlowStart) {
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.slow_start.window_ms", 0))
+      .WillByDefault(Return(60000));
+  host_set_.healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80"),
+                              makeTestHost(info_, "tcp://127.0.0.1:81")};
+  host_set_.hosts_ = host_set_.healthy_hosts_;
+  host_set_.healthy_hosts_[1]->slowStartTime(MonotonicTime());
+  host_set_.runCallbacks({}, {});
+
+  // The new host is rejected above 10%, the other host is always kept.
+  EXPECT_CALL(random_, random())
+      .WillOnce(Return(0))
+      .WillOnce(Return(5000))
+      .WillOnce(Return(1))
+      .WillOnce(Return(9999));
+  EXPECT_EQ(host_set_.healthy_hosts_[1], lb_.chooseHost(nullptr));
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(500));
+  EXPECT_EQ(host_set_.healthy_hosts_[0], lb_.chooseHost(nullptr));
+}
+
 TEST(LoadBalancerSubsetInfoImplTest, DefaultConfigIsDiabled) {
   auto subset_info =
       LoadBalancerSubsetInfoImpl(envoy::api::v2::Cluster::LbSubsetConfig::default_instance());
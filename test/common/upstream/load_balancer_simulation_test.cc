@@ -97,7 +97,7 @@ public:
       }
       local_priority_set_->getOrCreateHostSet(0).updateHosts(originating_hosts, originating_hosts,
                                                              per_zone_local, per_zone_local,
-                                                             empty_vector_, empty_vector_);
+                                                             nullptr, empty_vector_, empty_vector_);
 
       HostConstSharedPtr selected = lb.chooseHost(nullptr);
       hits[selected->address()->asString()]++;
@@ -1,8 +1,10 @@
 #include "common/stats/stats_impl.h"
 #include "common/upstream/load_stats_reporter.h"
 
+#include "test/common/upstream/utility.h"
 #include "test/mocks/event/mocks.h"
 #include "test/mocks/grpc/mocks.h"
+#include "test/mocks/runtime/mocks.h"
 #include "test/mocks/upstream/mocks.h"
 #include "test/test_common/utility.h"
 
@@ -43,7 +45,7 @@ public:
       return response_timer_;
     }));
     load_stats_reporter_.reset(new LoadStatsReporter(
-        node_, cm_, stats_store_, LoadStatsAsyncClientPtr(async_client_), dispatcher_));
+        node_, cm_, runtime_, stats_store_, LoadStatsAsyncClientPtr(async_client_), dispatcher_));
   }
 
   void expectSendMessage(const std::vector<envoy::api::v2::ClusterStats>& expected_cluster_stats) {
@@ -67,6 +69,7 @@ public:
 
   envoy::api::v2::Node node_;
   NiceMock<Upstream::MockClusterManager> cm_;
+  NiceMock<Runtime::MockLoader> runtime_;
   Event::MockDispatcher dispatcher_;
   Stats::IsolatedStoreImpl stats_store_;
   std::unique_ptr<LoadStatsReporter> load_stats_reporter_;
@@ -101,5 +104,37 @@ TEST_F(LoadStatsReporterTest, RemoteStreamClose) {
   retry_timer_cb_();
 }
 
+// Validate that localities and clusters without load are left out when configured by runtime.
+TEST_F(LoadStatsReporterTest, SkipZeroLoad) {
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  expectSendMessage({});
+  createLoadStatsReporter();
+
+  NiceMock<MockCluster> cluster;
+  MockHostSet& host_set = *cluster.prioritySet().getMockHostSet(0);
+  HostSharedPtr host_a = makeTestHost(cluster.info_, "tcp://127.0.0.1:80");
+  HostSharedPtr host_b = makeTestHost(cluster.info_, "tcp://127.0.0.1:81");
+  host_set.hosts_ = {host_a, host_b};
+  host_set.hosts_per_locality_ = {{host_a}, {host_b}};
+  ON_CALL(cm_, clusters())
+      .WillByDefault(Return(ClusterManager::ClusterInfoMap{{"foo", std::cref<Cluster>(cluster)}}));
+  ON_CALL(runtime_.snapshot_, getInteger("load_reporter.report_zero_load", 1))
+      .WillByDefault(Return(0));
+  deliverLoadStatsResponse({"foo"});
+
+  host_a->stats().rq_success_.inc();
+  host_a->stats().rq_success_.inc();
+  envoy::api::v2::ClusterStats cluster_stats;
+  cluster_stats.set_cluster_name("foo");
+  auto* locality_stats = cluster_stats.add_upstream_locality_stats();
+  locality_stats->mutable_locality()->MergeFrom(host_a->locality());
+  locality_stats->set_total_successful_requests(2);
+  expectSendMessage({cluster_stats});
+  response_timer_cb_();
+
+  expectSendMessage({});
+  response_timer_cb_();
+}
+
 } // namespace Upstream
 } // namespace Envoy
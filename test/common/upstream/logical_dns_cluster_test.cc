@@ -21,6 +21,7 @@
 
 using testing::Invoke;
 using testing::NiceMock;
+using testing::Return;
 using testing::_;
 
 namespace Envoy {
@@ -243,5 +244,60 @@ TEST_F(LogicalDnsClusterTest, Basic) {
   tls_.shutdownThread();
 }
 
+// Validate that with happy eyeballs, both IP versions are resolved and connections to the first
+// address race the first address of the other IP version.
+TEST_F(LogicalDnsClusterTest, HappyEyeballs) {
+  const std::string json = R"EOF(
+  {
+    "name": "name",
+    "connect_timeout_ms": 250,
+    "type": "logical_dns",
+    "lb_type": "round_robin",
+    "dns_lookup_family": "auto",
+    "hosts": [{"url": "tcp://foo.bar.com:443"}]
+  }
+  )EOF";
+
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.happy_eyeballs_delay_ms.name", 0))
+      .WillByDefault(Return(100));
+  expectResolve(Network::DnsLookupFamily::All);
+  setup(json);
+
+  EXPECT_CALL(membership_updated_, ready());
+  EXPECT_CALL(initialized_, ready());
+  EXPECT_CALL(*resolve_timer_, enableTimer(_));
+  dns_callback_(TestUtility::makeDnsResponse({"::1", "::2", "127.0.0.1"}));
+  HostSharedPtr logical_host = cluster_->prioritySet().hostSetsPerPriority()[0]->hosts()[0];
+
+  NiceMock<Network::MockClientConnection>* connection =
+      new NiceMock<Network::MockClientConnection>();
+  EXPECT_CALL(dispatcher_, createClientConnection_(
+                               PointeesEq(Network::Utility::resolveUrl("tcp://[::1]:443")), _))
+      .WillOnce(Return(connection));
+  EXPECT_CALL(*connection,
+              setFallbackAddress(PointeesEq(Network::Utility::resolveUrl("tcp://127.0.0.1:443")),
+                                 std::chrono::milliseconds(100)));
+  logical_host->createConnection(dispatcher_);
+
+  // Without a fallback address, or once disabled, connections don't race.
+  expectResolve(Network::DnsLookupFamily::All);
+  resolve_timer_->callback_();
+  EXPECT_CALL(*resolve_timer_, enableTimer(_));
+  dns_callback_(TestUtility::makeDnsResponse({"::1"}));
+
+  connection = new NiceMock<Network::MockClientConnection>();
+  EXPECT_CALL(dispatcher_, createClientConnection_(_, _)).WillOnce(Return(connection));
+  EXPECT_CALL(*connection, setFallbackAddress(_, _)).Times(0);
+  logical_host->createConnection(dispatcher_);
+
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.happy_eyeballs_delay_ms.name", 0))
+      .WillByDefault(Return(0));
+  EXPECT_CALL(active_dns_query_, cancel());
+  expectResolve(Network::DnsLookupFamily::Auto);
+  resolve_timer_->callback_();
+
+  tls_.shutdownThread();
+}
+
 } // namespace Upstream
 } // namespace Envoy
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/upstream/maglev_lb.h"
+#include "common/upstream/upstream_impl.h"
+
+#include "test/common/upstream/utility.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Upstream {
+
+class TestLoadBalancerContext : public LoadBalancerContext {
+public:
+  TestLoadBalancerContext(uint64_t hash_key) : hash_key_(hash_key) {}
+
+  // Upstream::LoadBalancerContext
+  Optional<uint64_t> computeHashKey() override { return hash_key_; }
+  const Router::MetadataMatchCriteria* metadataMatchCriteria() const override { return nullptr; }
+  const Network::Connection* downstreamConnection() const override { return nullptr; }
+
+  Optional<uint64_t> hash_key_;
+};
+
+class MaglevLoadBalancerTest : public testing::Test {
+public:
+  MaglevLoadBalancerTest() : stats_(ClusterInfoImpl::generateStats(stats_store_)) {}
+
+  void init(uint64_t table_size) {
+    lb_.reset(new MaglevLoadBalancer(priority_set_, stats_, runtime_, random_, table_size));
+  }
+
+  std::vector<HostSharedPtr> makeHosts(uint32_t count) {
+    std::vector<HostSharedPtr> hosts;
+    for (uint32_t i = 0; i < count; i++) {
+      hosts.push_back(makeTestHost(info_, fmt::format("tcp://10.0.{}.{}:80", i / 256, i % 256)));
+    }
+    return hosts;
+  }
+
+  NiceMock<MockPrioritySet> priority_set_;
+  MockHostSet& host_set_ = *priority_set_.getMockHostSet(0);
+  std::shared_ptr<MockClusterInfo> info_{new NiceMock<MockClusterInfo>()};
+  Stats::IsolatedStoreImpl stats_store_;
+  ClusterStats stats_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<Runtime::MockRandomGenerator> random_;
+  std::unique_ptr<MaglevLoadBalancer> lb_;
+};
+
+TEST_F(MaglevLoadBalancerTest, NoHost) {
+  init(7);
+  EXPECT_EQ(nullptr, lb_->chooseHost(nullptr));
+};
+
+TEST_F(MaglevLoadBalancerTest, Basic) {
+  host_set_.hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:90"),
+                      makeTestHost(info_, "tcp://127.0.0.1:91"),
+                      makeTestHost(info_, "tcp://127.0.0.1:92")};
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {});
+  init(7);
+
+  // maglev table:
+  // 0: 127.0.0.1:92
+  // 1: 127.0.0.1:91
+  // 2: 127.0.0.1:90
+  // 3: 127.0.0.1:91
+  // 4: 127.0.0.1:92
+  // 5: 127.0.0.1:90
+  // 6: 127.0.0.1:90
+  const std::vector<uint32_t> expected = {2, 1, 0, 1, 2, 0, 0};
+  for (uint64_t i = 0; i < 2 * expected.size(); i++) {
+    TestLoadBalancerContext context(i);
+    EXPECT_EQ(host_set_.hosts_[expected[i % expected.size()]], lb_->chooseHost(&context));
+  }
+
+  // No hash generated in the context, so the random value is used.
+  EXPECT_CALL(random_, random()).WillOnce(Return(4));
+  EXPECT_EQ(host_set_.hosts_[2], lb_->chooseHost(nullptr));
+
+  // The table for healthy hosts is used unless we are in panic mode.
+  host_set_.healthy_hosts_ = {host_set_.hosts_[0], host_set_.hosts_[1]};
+  host_set_.runCallbacks({}, {});
+  for (uint64_t i = 0; i < expected.size(); i++) {
+    TestLoadBalancerContext context(i);
+    EXPECT_NE(host_set_.hosts_[2], lb_->chooseHost(&context));
+  }
+  EXPECT_EQ(0UL, stats_.lb_healthy_panic_.value());
+
+  host_set_.healthy_hosts_ = {};
+  host_set_.runCallbacks({}, {});
+  TestLoadBalancerContext context(4);
+  EXPECT_EQ(host_set_.hosts_[2], lb_->chooseHost(&context));
+  EXPECT_EQ(1UL, stats_.lb_healthy_panic_.value());
+}
+
+// Every host owns either floor(table_size / hosts) or ceil(table_size / hosts) table entries.
+TEST_F(MaglevLoadBalancerTest, Balance) {
+  const std::vector<HostSharedPtr> hosts = makeHosts(100);
+  MaglevLoadBalancer::Table table(hosts, MaglevLoadBalancer::DEFAULT_TABLE_SIZE);
+  EXPECT_EQ(MaglevLoadBalancer::DEFAULT_TABLE_SIZE, table.size());
+
+  std::unordered_map<HostConstSharedPtr, uint64_t> entries;
+  for (uint64_t i = 0; i < table.size(); i++) {
+    entries[table.chooseHost(i)]++;
+  }
+  EXPECT_EQ(100U, entries.size());
+  for (const auto& entry : entries) {
+    EXPECT_GE(entry.second, MaglevLoadBalancer::DEFAULT_TABLE_SIZE / 100);
+    EXPECT_LE(entry.second, MaglevLoadBalancer::DEFAULT_TABLE_SIZE / 100 + 1);
+  }
+}
+
+// The table does not depend on the order of the hosts.
+TEST_F(MaglevLoadBalancerTest, HostOrder) {
+  std::vector<HostSharedPtr> hosts = makeHosts(20);
+  MaglevLoadBalancer::Table table(hosts, 251);
+  std::reverse(hosts.begin(), hosts.end());
+  MaglevLoadBalancer::Table reversed_table(hosts, 251);
+  for (uint64_t i = 0; i < table.size(); i++) {
+    EXPECT_EQ(table.chooseHost(i), reversed_table.chooseHost(i));
+  }
+}
+
+// Removing a host mostly reassigns the entries of that host, and leaves the rest of the table
+// alone.
+TEST_F(MaglevLoadBalancerTest, MinimalDisruption) {
+  std::vector<HostSharedPtr> hosts = makeHosts(100);
+  MaglevLoadBalancer::Table table(hosts, MaglevLoadBalancer::DEFAULT_TABLE_SIZE);
+  const HostSharedPtr removed_host = hosts[50];
+  hosts.erase(hosts.begin() + 50);
+  MaglevLoadBalancer::Table updated_table(hosts, MaglevLoadBalancer::DEFAULT_TABLE_SIZE);
+
+  uint64_t moved = 0;
+  for (uint64_t i = 0; i < table.size(); i++) {
+    EXPECT_NE(removed_host, updated_table.chooseHost(i));
+    if (table.chooseHost(i) != removed_host && table.chooseHost(i) != updated_table.chooseHost(i)) {
+      moved++;
+    }
+  }
+  EXPECT_LT(moved, table.size() / 100);
+}
+
+} // namespace Upstream
+} // namespace Envoy
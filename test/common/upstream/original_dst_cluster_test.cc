@@ -46,10 +46,12 @@ public:
 
 class OriginalDstClusterTest : public testing::Test {
 public:
-  // cleanup timer must be created before the cluster (in setup()), so that we can set expectations
-  // on it. Ownership is transferred to the cluster at the cluster constructor, so the cluster will
-  // take care of destructing it!
-  OriginalDstClusterTest() : cleanup_timer_(new Event::MockTimer(&dispatcher_)) {}
+  // Timers must be created before the cluster (in setup()), so that we can set expectations on
+  // them. Ownership is transferred to the cluster at the cluster constructor, so the cluster will
+  // take care of destructing them! The most recently created mock timer is returned first.
+  OriginalDstClusterTest()
+      : add_hosts_timer_(new Event::MockTimer(&dispatcher_)),
+        cleanup_timer_(new Event::MockTimer(&dispatcher_)) {}
 
   void setup(const std::string& json) {
     NiceMock<MockClusterManager> cm;
@@ -68,6 +70,7 @@ public:
   ReadyWatcher initialized_;
   NiceMock<Runtime::MockLoader> runtime_;
   NiceMock<Event::MockDispatcher> dispatcher_;
+  Event::MockTimer* add_hosts_timer_;
   Event::MockTimer* cleanup_timer_;
 };
 
@@ -214,6 +217,7 @@ TEST_F(OriginalDstClusterTest, Membership) {
   EXPECT_CALL(dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
   HostConstSharedPtr host = lb.chooseHost(&lb_context);
   post_cb();
+  add_hosts_timer_->callback_();
   auto cluster_hosts = cluster_->prioritySet().hostSetsPerPriority()[0]->hosts();
 
   ASSERT_NE(host, nullptr);
@@ -260,6 +264,7 @@ TEST_F(OriginalDstClusterTest, Membership) {
   EXPECT_CALL(dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
   HostConstSharedPtr host3 = lb.chooseHost(&lb_context);
   post_cb();
+  add_hosts_timer_->callback_();
   EXPECT_NE(host3, nullptr);
   EXPECT_NE(host3, host);
   EXPECT_NE(cluster_hosts,
@@ -310,6 +315,7 @@ TEST_F(OriginalDstClusterTest, Membership2) {
   EXPECT_CALL(dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
   HostConstSharedPtr host1 = lb.chooseHost(&lb_context1);
   post_cb();
+  add_hosts_timer_->callback_();
   ASSERT_NE(host1, nullptr);
   EXPECT_EQ(local_address1, *host1->address());
 
@@ -317,6 +323,7 @@ TEST_F(OriginalDstClusterTest, Membership2) {
   EXPECT_CALL(dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
   HostConstSharedPtr host2 = lb.chooseHost(&lb_context2);
   post_cb();
+  add_hosts_timer_->callback_();
   ASSERT_NE(host2, nullptr);
   EXPECT_EQ(local_address2, *host2->address());
 
@@ -360,6 +367,62 @@ TEST_F(OriginalDstClusterTest, Membership2) {
   EXPECT_EQ(0UL, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts().size());
 }
 
+// Hosts posted before the cluster gets to add them are added in a single membership update.
+TEST_F(OriginalDstClusterTest, BatchedAdd) {
+  std::string json = R"EOF(
+  {
+    "name": "name",
+    "connect_timeout_ms": 1250,
+    "type": "original_dst",
+    "lb_type": "original_dst_lb"
+  }
+  )EOF";
+
+  EXPECT_CALL(initialized_, ready());
+  EXPECT_CALL(*cleanup_timer_, enableTimer(_));
+  setup(json);
+
+  NiceMock<Network::MockConnection> connection1;
+  TestLoadBalancerContext lb_context1(&connection1);
+  Network::Address::Ipv4Instance local_address1("10.10.11.11");
+  EXPECT_CALL(connection1, localAddress()).WillRepeatedly(ReturnRef(local_address1));
+  EXPECT_CALL(connection1, usingOriginalDst()).WillRepeatedly(Return(true));
+
+  NiceMock<Network::MockConnection> connection2;
+  TestLoadBalancerContext lb_context2(&connection2);
+  Network::Address::Ipv4Instance local_address2("10.10.11.12");
+  EXPECT_CALL(connection2, localAddress()).WillRepeatedly(ReturnRef(local_address2));
+  EXPECT_CALL(connection2, usingOriginalDst()).WillRepeatedly(Return(true));
+
+  OriginalDstCluster::LoadBalancer lb1(cluster_->prioritySet(), cluster_);
+  OriginalDstCluster::LoadBalancer lb2(cluster_->prioritySet(), cluster_);
+
+  Event::PostCb post_cb1;
+  Event::PostCb post_cb2;
+  EXPECT_CALL(dispatcher_, post(_))
+      .WillOnce(SaveArg<0>(&post_cb1))
+      .WillOnce(SaveArg<0>(&post_cb2));
+  HostConstSharedPtr host1 = lb1.chooseHost(&lb_context1);
+  HostConstSharedPtr host2 = lb2.chooseHost(&lb_context2);
+
+  // The timer is only enabled by the first pending host.
+  EXPECT_CALL(*add_hosts_timer_, enableTimer(std::chrono::milliseconds(0)));
+  post_cb1();
+  post_cb2();
+  EXPECT_EQ(0UL, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts().size());
+
+  EXPECT_CALL(membership_updated_, ready());
+  add_hosts_timer_->callback_();
+  ASSERT_EQ(2UL, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts().size());
+  EXPECT_EQ(2UL, cluster_->prioritySet().hostSetsPerPriority()[0]->healthyHosts().size());
+  EXPECT_EQ(host1, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts()[0]);
+  EXPECT_EQ(host2, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts()[1]);
+
+  // Each load balancer now knows about the host created by the other one.
+  EXPECT_EQ(host2, lb1.chooseHost(&lb_context2));
+  EXPECT_EQ(host1, lb2.chooseHost(&lb_context1));
+}
+
 TEST_F(OriginalDstClusterTest, Connection) {
   std::string json = R"EOF(
   {
@@ -394,6 +457,7 @@ TEST_F(OriginalDstClusterTest, Connection) {
   EXPECT_CALL(dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
   HostConstSharedPtr host = lb.chooseHost(&lb_context);
   post_cb();
+  add_hosts_timer_->callback_();
   ASSERT_NE(host, nullptr);
   EXPECT_EQ(local_address, *host->address());
 
@@ -429,7 +493,7 @@ TEST_F(OriginalDstClusterTest, MultipleClusters) {
             new std::vector<std::vector<HostSharedPtr>>()};
 
         second.getOrCreateHostSet(0).updateHosts(new_hosts, healthy_hosts, empty_host_lists,
-                                                 empty_host_lists, added, removed);
+                                                 empty_host_lists, nullptr, added, removed);
       });
 
   EXPECT_CALL(membership_updated_, ready());
@@ -447,6 +511,7 @@ TEST_F(OriginalDstClusterTest, MultipleClusters) {
   EXPECT_CALL(dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
   HostConstSharedPtr host = lb1.chooseHost(&lb_context);
   post_cb();
+  add_hosts_timer_->callback_();
   ASSERT_NE(host, nullptr);
   EXPECT_EQ(local_address, *host->address());
 
@@ -83,6 +83,12 @@ public:
     }
   }
 
+  void loadResponseTime(HostSharedPtr host, int num_rq, uint64_t response_time_ms) {
+    for (int i = 0; i < num_rq; i++) {
+      host->outlierDetector().putResponseTime(std::chrono::milliseconds(response_time_ms));
+    }
+  }
+
   NiceMock<MockCluster> cluster_;
   std::vector<HostSharedPtr>& hosts_ = cluster_.prioritySet().getMockHostSet(0)->hosts_;
   std::vector<HostSharedPtr>& failover_hosts_ = cluster_.prioritySet().getMockHostSet(1)->hosts_;
@@ -535,6 +541,76 @@ TEST_F(OutlierDetectorImplTest, BasicFlowSuccessRate) {
   EXPECT_EQ(-1, detector->successRateEjectionThreshold());
 }
 
+TEST_F(OutlierDetectorImplTest, BasicFlowSlowResponse) {
+  EXPECT_CALL(cluster_.prioritySet(), addMemberUpdateCb(_));
+  addHosts({
+      "tcp://127.0.0.1:80",
+      "tcp://127.0.0.1:81",
+      "tcp://127.0.0.1:82",
+      "tcp://127.0.0.1:83",
+      "tcp://127.0.0.1:84",
+  });
+
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000)));
+  std::shared_ptr<DetectorImpl> detector(DetectorImpl::create(
+      cluster_, empty_outlier_detection_, dispatcher_, runtime_, time_source_, event_logger_));
+  detector->addChangedStateCb([&](HostSharedPtr host) -> void { checker_.check(host); });
+  ON_CALL(runtime_.snapshot_, featureEnabled("outlier_detection.enforcing_slow_response", 0))
+      .WillByDefault(Return(true));
+
+  // One host is ten times slower than the others.
+  for (uint64_t i = 0; i < 4; i++) {
+    loadResponseTime(hosts_[i], 100, 10);
+  }
+  loadResponseTime(hosts_[4], 100, 100);
+
+  EXPECT_CALL(time_source_, currentTime())
+      .Times(2)
+      .WillRepeatedly(Return(MonotonicTime(std::chrono::milliseconds(10000))));
+  EXPECT_CALL(checker_, check(hosts_[4]));
+  EXPECT_CALL(*event_logger_, logEject(std::static_pointer_cast<const HostDescription>(hosts_[4]),
+                                       _, EjectionType::SlowResponse, true));
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000)));
+  interval_timer_->callback_();
+  EXPECT_EQ(28, detector->responseTimeAverage());
+  EXPECT_EQ(-1, detector->successRateAverage());
+  EXPECT_TRUE(hosts_[4]->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK));
+  EXPECT_EQ(1UL, cluster_.info_->stats_store_
+                     .counter("outlier_detection.ejections_detected_slow_response")
+                     .value());
+  EXPECT_EQ(1UL, cluster_.info_->stats_store_
+                     .counter("outlier_detection.ejections_enforced_slow_response")
+                     .value());
+
+  // The moving averages are kept through an interval without enough volume, and the new values
+  // are weighted by 30%.
+  EXPECT_CALL(time_source_, currentTime())
+      .WillOnce(Return(MonotonicTime(std::chrono::milliseconds(20000))));
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000)));
+  interval_timer_->callback_();
+  EXPECT_EQ(10, detector->responseTimeAverage());
+
+  loadResponseTime(hosts_[0], 100, 20);
+  EXPECT_CALL(time_source_, currentTime())
+      .WillOnce(Return(MonotonicTime(std::chrono::milliseconds(30000))));
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000)));
+  interval_timer_->callback_();
+  EXPECT_DOUBLE_EQ(13, dynamic_cast<DetectorHostMonitorImpl&>(hosts_[0]->outlierDetector())
+                           .responseTime());
+
+  // The host is brought back in without its old moving average.
+  EXPECT_CALL(time_source_, currentTime())
+      .WillOnce(Return(MonotonicTime(std::chrono::milliseconds(40000))));
+  EXPECT_CALL(checker_, check(hosts_[4]));
+  EXPECT_CALL(*event_logger_,
+              logUneject(std::static_pointer_cast<const HostDescription>(hosts_[4])));
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000)));
+  interval_timer_->callback_();
+  EXPECT_FALSE(hosts_[4]->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK));
+  EXPECT_EQ(-1, dynamic_cast<DetectorHostMonitorImpl&>(hosts_[4]->outlierDetector())
+                    .responseTime());
+}
+
 TEST_F(OutlierDetectorImplTest, RemoveWhileEjected) {
   EXPECT_CALL(cluster_.prioritySet(), addMemberUpdateCb(_));
   addHosts({"tcp://127.0.0.1:80"});
@@ -820,6 +896,10 @@ TEST(OutlierUtility, SRThreshold) {
   Utility::EjectionPair ejection_pair = Utility::successRateEjectionThreshold(sum, data, 1.9);
   EXPECT_EQ(52.0, ejection_pair.ejection_threshold_);
   EXPECT_EQ(90.0, ejection_pair.success_rate_average_);
+
+  ejection_pair = Utility::successRateEjectionThreshold(sum, 42500, data.size(), 1.9);
+  EXPECT_EQ(52.0, ejection_pair.ejection_threshold_);
+  EXPECT_EQ(90.0, ejection_pair.success_rate_average_);
 }
 
 } // namespace Outlier
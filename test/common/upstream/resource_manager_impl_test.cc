@@ -39,6 +39,11 @@ TEST(ResourceManagerImplTest, RuntimeResourceManager) {
   EXPECT_EQ(3U, resource_manager.requests().max());
   EXPECT_TRUE(resource_manager.requests().canCreate());
 
+  EXPECT_CALL(
+      runtime.snapshot_,
+      getInteger("circuit_breakers.runtime_resource_manager_test.default.retry_budget_percent", 0U))
+      .Times(2)
+      .WillRepeatedly(Return(0U));
   EXPECT_CALL(runtime.snapshot_,
               getInteger("circuit_breakers.runtime_resource_manager_test.default.max_retries", 1U))
       .Times(2)
@@ -47,5 +52,109 @@ TEST(ResourceManagerImplTest, RuntimeResourceManager) {
   EXPECT_FALSE(resource_manager.retries().canCreate());
 }
 
+TEST(ResourceManagerImplTest, RetryBudget) {
+  NiceMock<Runtime::MockLoader> runtime;
+  ResourceManagerImpl resource_manager(runtime, "circuit_breakers.retry_budget_test.default.", 0,
+                                       100, 100, 1);
+  ON_CALL(runtime.snapshot_,
+          getInteger("circuit_breakers.retry_budget_test.default.retry_budget_percent", 0U))
+      .WillByDefault(Return(20U));
+  ON_CALL(runtime.snapshot_,
+          getInteger("circuit_breakers.retry_budget_test.default.retry_budget_min_concurrency", 3U))
+      .WillByDefault(Return(3U));
+
+  // The minimum applies while the cluster is idle, regardless of max_retries.
+  EXPECT_EQ(3U, resource_manager.retries().max());
+
+  for (int i = 0; i < 20; i++) {
+    resource_manager.requests().inc();
+  }
+  for (int i = 0; i < 5; i++) {
+    resource_manager.pendingRequests().inc();
+  }
+  EXPECT_EQ(5U, resource_manager.retries().max());
+
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(resource_manager.retries().canCreate());
+    resource_manager.retries().inc();
+  }
+  EXPECT_FALSE(resource_manager.retries().canCreate());
+
+  for (int i = 0; i < 5; i++) {
+    resource_manager.retries().dec();
+    resource_manager.pendingRequests().dec();
+  }
+  for (int i = 0; i < 20; i++) {
+    resource_manager.requests().dec();
+  }
+}
+
+TEST(ResourceManagerImplTest, AdaptiveConcurrency) {
+  NiceMock<Runtime::MockLoader> runtime;
+  ResourceManagerImpl resource_manager(runtime, "circuit_breakers.adaptive_test.default.", 0, 0,
+                                       100, 1);
+
+  // Without the runtime key the latencies are ignored.
+  for (int i = 0; i < 10; i++) {
+    resource_manager.onRequestComplete(std::chrono::microseconds(1000));
+  }
+  EXPECT_EQ(100U, resource_manager.requests().max());
+
+  ON_CALL(runtime.snapshot_,
+          getInteger("circuit_breakers.adaptive_test.default.adaptive_concurrency_samples", 0U))
+      .WillByDefault(Return(10U));
+  ON_CALL(runtime.snapshot_,
+          getInteger("circuit_breakers.adaptive_test.default.adaptive_concurrency_min_limit", 3U))
+      .WillByDefault(Return(5U));
+  auto complete_window = [&](uint64_t latency_us) -> void {
+    for (int i = 0; i < 10; i++) {
+      resource_manager.onRequestComplete(std::chrono::microseconds(latency_us));
+    }
+  };
+
+  // The first window sets the baseline, and the limit can't grow above max_requests.
+  complete_window(1000);
+  EXPECT_EQ(100U, resource_manager.requests().max());
+
+  // Latency within the tolerance of the baseline keeps the limit at max_requests.
+  complete_window(1400);
+  EXPECT_EQ(100U, resource_manager.requests().max());
+
+  // Latency of three times the baseline halves the limit, and latency at the tolerance keeps it,
+  // but the square root of the limit is always added.
+  complete_window(3000);
+  EXPECT_EQ(60U, resource_manager.requests().max());
+  complete_window(1500);
+  EXPECT_EQ(67U, resource_manager.requests().max());
+
+  // An incomplete window doesn't change the limit.
+  resource_manager.onRequestComplete(std::chrono::microseconds(100000));
+  EXPECT_EQ(67U, resource_manager.requests().max());
+  for (int i = 0; i < 9; i++) {
+    resource_manager.onRequestComplete(std::chrono::microseconds(100000));
+  }
+  EXPECT_EQ(41U, resource_manager.requests().max());
+
+  // The limit stops at the minimum.
+  for (int i = 0; i < 10; i++) {
+    complete_window(100000);
+  }
+  EXPECT_EQ(5U, resource_manager.requests().max());
+  EXPECT_TRUE(resource_manager.requests().canCreate());
+  for (int i = 0; i < 5; i++) {
+    resource_manager.requests().inc();
+  }
+  EXPECT_FALSE(resource_manager.requests().canCreate());
+  for (int i = 0; i < 5; i++) {
+    resource_manager.requests().dec();
+  }
+
+  // Once latency comes back down the limit recovers.
+  for (int i = 0; i < 10; i++) {
+    complete_window(1000);
+  }
+  EXPECT_EQ(100U, resource_manager.requests().max());
+}
+
 } // namespace Upstream
 } // namespace Envoy
@@ -1,8 +1,12 @@
+#include <algorithm>
 #include <cstdint>
+#include <limits>
 #include <string>
+#include <vector>
 
 #include "envoy/router/router.h"
 
+#include "common/common/hash.h"
 #include "common/network/utility.h"
 #include "common/upstream/ring_hash_lb.h"
 #include "common/upstream/upstream_impl.h"
@@ -213,6 +217,165 @@ TEST_F(RingHashLoadBalancerTest, UnevenHosts) {
   }
 }
 
+// Rings supplied via setPendingRings() are adopted by the next membership update instead of
+// building new ones. Later updates build their own rings again.
+TEST_F(RingHashLoadBalancerTest, PendingRings) {
+  host_set_.hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:90")};
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  init();
+
+  NiceMock<MockPrioritySet> other_priority_set;
+  MockHostSet& other_host_set = *other_priority_set.getMockHostSet(0);
+  other_host_set.hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:91")};
+  other_host_set.healthy_hosts_ = other_host_set.hosts_;
+  RingHashLoadBalancer::SharedRingsConstSharedPtr rings =
+      RingHashLoadBalancer::buildRings(other_host_set, config_, nullptr);
+
+  lb_->setPendingRings(rings);
+  EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(nullptr));
+  host_set_.runCallbacks({}, {});
+  EXPECT_EQ(other_host_set.hosts_[0], lb_->chooseHost(nullptr));
+
+  host_set_.runCallbacks({}, {});
+  EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(nullptr));
+}
+
+// Building rings from previous rings gives the same results as building them from scratch.
+TEST_F(RingHashLoadBalancerTest, BuildRingsFromPrevious) {
+  config_.value(envoy::api::v2::Cluster::RingHashLbConfig());
+  config_.value().mutable_minimum_ring_size()->set_value(8);
+  for (uint32_t i = 0; i < 10; i++) {
+    host_set_.hosts_.push_back(makeTestHost(info_, fmt::format("tcp://127.0.0.1:{}", 90 + i)));
+  }
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  RingHashLoadBalancer::SharedRingsConstSharedPtr previous =
+      RingHashLoadBalancer::buildRings(host_set_, config_, nullptr);
+
+  host_set_.healthy_hosts_.pop_back();
+  RingHashLoadBalancer::SharedRingsConstSharedPtr updated =
+      RingHashLoadBalancer::buildRings(host_set_, config_, previous);
+  RingHashLoadBalancer::SharedRingsConstSharedPtr rebuilt =
+      RingHashLoadBalancer::buildRings(host_set_, config_, nullptr);
+  EXPECT_TRUE(updated->healthy_hosts_ring_->incrementallyUpdated());
+  for (uint64_t i = 0; i < 1000; i++) {
+    const uint64_t hash = HashUtil::xxHash64(std::to_string(i));
+    EXPECT_EQ(rebuilt->all_hosts_ring_->chooseHost(hash),
+              updated->all_hosts_ring_->chooseHost(hash));
+    EXPECT_EQ(rebuilt->healthy_hosts_ring_->chooseHost(hash),
+              updated->healthy_hosts_ring_->chooseHost(hash));
+  }
+}
+
+class RingHashRingTest : public testing::Test {
+public:
+  RingHashRingTest() {
+    config_.value(envoy::api::v2::Cluster::RingHashLbConfig());
+    config_.value().mutable_deprecated_v1()->mutable_use_std_hash()->set_value(false);
+  }
+
+  std::vector<HostSharedPtr> makeHosts(uint64_t first, uint64_t count) {
+    std::vector<HostSharedPtr> hosts;
+    for (uint64_t i = first; i < first + count; i++) {
+      hosts.push_back(makeTestHost(info_, fmt::format("tcp://10.0.{}.{}:6379", i / 256, i % 256)));
+    }
+    return hosts;
+  }
+
+  // Reference lookup doing a full binary search over independently computed hashes.
+  HostConstSharedPtr referenceChooseHost(const std::vector<HostSharedPtr>& hosts,
+                                         uint64_t hashes_per_host, uint64_t hash) {
+    std::vector<std::pair<uint64_t, HostConstSharedPtr>> ring;
+    for (const auto& host : hosts) {
+      for (uint64_t i = 0; i < hashes_per_host; i++) {
+        ring.emplace_back(HashUtil::xxHash64(host->address()->asString() + "_" + std::to_string(i)),
+                          host);
+      }
+    }
+    std::sort(ring.begin(), ring.end(),
+              [](const std::pair<uint64_t, HostConstSharedPtr>& lhs,
+                 const std::pair<uint64_t, HostConstSharedPtr>& rhs) -> bool {
+                return lhs.first < rhs.first;
+              });
+    auto it = std::lower_bound(ring.begin(), ring.end(), hash,
+                               [](const std::pair<uint64_t, HostConstSharedPtr>& entry,
+                                  uint64_t value) -> bool { return entry.first < value; });
+    return it == ring.end() ? ring.front().second : it->second;
+  }
+
+  std::shared_ptr<MockClusterInfo> info_{new NiceMock<MockClusterInfo>()};
+  Optional<envoy::api::v2::Cluster::RingHashLbConfig> config_;
+};
+
+// Large rings use the bucket index, which must agree with a full binary search.
+TEST_F(RingHashRingTest, BucketIndex) {
+  config_.value().mutable_minimum_ring_size()->set_value(4096);
+  const std::vector<HostSharedPtr> hosts = makeHosts(0, 16);
+  RingHashLoadBalancer::Ring ring(config_, hosts);
+  EXPECT_EQ(4096U, ring.size());
+
+  std::vector<uint64_t> hashes{0, 1, std::numeric_limits<uint64_t>::max(),
+                               std::numeric_limits<uint64_t>::max() - 1};
+  for (uint64_t i = 0; i < 1000; i++) {
+    hashes.push_back(HashUtil::xxHash64(std::to_string(i)));
+  }
+  for (const uint64_t hash : hashes) {
+    EXPECT_EQ(referenceChooseHost(hosts, 256, hash), ring.chooseHost(hash));
+  }
+}
+
+// Adding and removing a few hosts updates the previous ring in place, and gives the same results
+// as building the ring from scratch.
+TEST_F(RingHashRingTest, IncrementalUpdate) {
+  config_.value().mutable_minimum_ring_size()->set_value(16);
+  std::vector<HostSharedPtr> hosts = makeHosts(0, 2000);
+  RingHashLoadBalancer::Ring initial(config_, hosts);
+  EXPECT_FALSE(initial.incrementallyUpdated());
+  EXPECT_EQ(2000U, initial.size());
+
+  // Remove 10 hosts from the middle and add 10 new ones.
+  hosts.erase(hosts.begin() + 500, hosts.begin() + 510);
+  const std::vector<HostSharedPtr> added = makeHosts(5000, 10);
+  hosts.insert(hosts.begin() + 1000, added.begin(), added.end());
+
+  RingHashLoadBalancer::Ring updated(initial, config_, hosts);
+  EXPECT_TRUE(updated.incrementallyUpdated());
+  EXPECT_EQ(2000U, updated.size());
+
+  RingHashLoadBalancer::Ring rebuilt(config_, hosts);
+  for (uint64_t i = 0; i < 10000; i++) {
+    const uint64_t hash = HashUtil::xxHash64(std::to_string(i));
+    EXPECT_EQ(rebuilt.chooseHost(hash), updated.chooseHost(hash));
+  }
+}
+
+// A change in the number of hashes per host, or a large change in membership, forces a full
+// rebuild.
+TEST_F(RingHashRingTest, IncrementalUpdateFallback) {
+  config_.value().mutable_minimum_ring_size()->set_value(1024);
+  std::vector<HostSharedPtr> hosts = makeHosts(0, 100);
+  RingHashLoadBalancer::Ring initial(config_, hosts);
+  EXPECT_EQ(1100U, initial.size());
+
+  // Both 100 and 99 hosts require 11 hashes per host, while 93 hosts require 12.
+  hosts.pop_back();
+  RingHashLoadBalancer::Ring small_change(initial, config_, hosts);
+  EXPECT_TRUE(small_change.incrementallyUpdated());
+  EXPECT_EQ(1089U, small_change.size());
+
+  std::vector<HostSharedPtr> fewer_hosts(hosts.begin(), hosts.begin() + 93);
+  RingHashLoadBalancer::Ring hashes_per_host_change(small_change, config_, fewer_hosts);
+  EXPECT_FALSE(hashes_per_host_change.incrementallyUpdated());
+  EXPECT_EQ(93U * 12, hashes_per_host_change.size());
+
+  const std::vector<HostSharedPtr> replaced = makeHosts(1000, 93);
+  RingHashLoadBalancer::Ring large_change(hashes_per_host_change, config_, replaced);
+  EXPECT_FALSE(large_change.incrementallyUpdated());
+
+  RingHashLoadBalancer::Ring empty(large_change, config_, {});
+  EXPECT_FALSE(empty.incrementallyUpdated());
+  EXPECT_EQ(nullptr, empty.chooseHost(0));
+}
+
 /**
  * This test is for simulation only and should not be run as part of unit tests. In order to run the
  * simulation remove the DISABLED_ prefix from the TEST_F invocation. Run bazel with
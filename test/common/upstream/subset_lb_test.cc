@@ -56,6 +56,9 @@ public:
   metadataMatchCriteria() const override {
     return matches_;
   }
+  // All criteria have the same hash, so that the load balancer has to tell apart criteria whose
+  // hashes are equal.
+  std::size_t hash() const override { return 0; }
 
 private:
   std::vector<Router::MetadataMatchCriterionConstSharedPtr> matches_;
@@ -160,7 +163,8 @@ public:
     }
 
     local_priority_set_.getOrCreateHostSet(0).updateHosts(
-        local_hosts_, local_hosts_, local_hosts_per_locality_, local_hosts_per_locality_, {}, {});
+        local_hosts_, local_hosts_, local_hosts_per_locality_, local_hosts_per_locality_, nullptr,
+        {}, {});
 
     lb_.reset(new SubsetLoadBalancer(lb_type_, priority_set_, &local_priority_set_, stats_,
                                      runtime_, random_, subset_info_, ring_hash_lb_config_));
@@ -250,7 +254,8 @@ public:
     if (GetParam() == REMOVES_FIRST && !remove.empty()) {
       local_priority_set_.getOrCreateHostSet(0).updateHosts(local_hosts_, local_hosts_,
                                                             local_hosts_per_locality_,
-                                                            local_hosts_per_locality_, {}, remove);
+                                                            local_hosts_per_locality_, nullptr, {},
+                                                            remove);
     }
 
     for (const auto& host : add) {
@@ -262,12 +267,14 @@ public:
       if (!add.empty()) {
         local_priority_set_.getOrCreateHostSet(0).updateHosts(local_hosts_, local_hosts_,
                                                               local_hosts_per_locality_,
-                                                              local_hosts_per_locality_, add, {});
+                                                              local_hosts_per_locality_, nullptr,
+                                                              add, {});
       }
     } else if (!add.empty() || !remove.empty()) {
       local_priority_set_.getOrCreateHostSet(0).updateHosts(local_hosts_, local_hosts_,
                                                             local_hosts_per_locality_,
-                                                            local_hosts_per_locality_, add, remove);
+                                                            local_hosts_per_locality_, nullptr, add,
+                                                            remove);
     }
   }
 
@@ -547,6 +554,38 @@ TEST_P(SubsetLoadBalancerTest, UpdateRemovingUnknownHost) {
   EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(&context));
 }
 
+// Test that criteria which had no subset find the subset once an update creates it.
+TEST_P(SubsetLoadBalancerTest, UpdateCreatingSubsetAfterLookup) {
+  EXPECT_CALL(subset_info_, fallbackPolicy())
+      .WillRepeatedly(Return(envoy::api::v2::Cluster::LbSubsetConfig::NO_FALLBACK));
+
+  std::vector<std::set<std::string>> subset_keys = {{"version"}};
+  EXPECT_CALL(subset_info_, subsetKeys()).WillRepeatedly(ReturnRef(subset_keys));
+
+  init({
+      {"tcp://127.0.0.1:80", {{"version", "1.0"}}},
+  });
+
+  TestLoadBalancerContext context_10({{"version", "1.0"}});
+  TestLoadBalancerContext context_11({{"version", "1.1"}});
+
+  EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(&context_10));
+  EXPECT_EQ(nullptr, lb_->chooseHost(&context_11));
+
+  modifyHosts({makeHost("tcp://127.0.0.1:81", {{"version", "1.1"}})}, {});
+
+  EXPECT_EQ(host_set_.hosts_[1], lb_->chooseHost(&context_11));
+  EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(&context_10));
+  EXPECT_EQ(2U, stats_.lb_subsets_active_.value());
+
+  // Replacing the host of a subset updates the subset found for the criteria.
+  modifyHosts({makeHost("tcp://127.0.0.1:82", {{"version", "1.1"}})}, {host_set_.hosts_[1]});
+
+  EXPECT_EQ(host_set_.hosts_[1], lb_->chooseHost(&context_11));
+  EXPECT_EQ(host_set_.hosts_[1], lb_->chooseHost(&context_11));
+  EXPECT_EQ(2U, stats_.lb_subsets_active_.value());
+}
+
 TEST_F(SubsetLoadBalancerTest, BalancesDisjointSubsets) {
   EXPECT_CALL(subset_info_, fallbackPolicy())
       .WillRepeatedly(Return(envoy::api::v2::Cluster::LbSubsetConfig::NO_FALLBACK));
@@ -697,7 +736,8 @@ TEST_F(SubsetLoadBalancerTest, LoadBalancerTypes) {
 
   auto types =
       std::vector<LoadBalancerType>({LoadBalancerType::RoundRobin, LoadBalancerType::LeastRequest,
-                                     LoadBalancerType::Random, LoadBalancerType::RingHash});
+                                     LoadBalancerType::Random, LoadBalancerType::RingHash,
+                                     LoadBalancerType::Maglev, LoadBalancerType::PeakEwma});
 
   for (const auto& it : types) {
     lb_type_ = it;
@@ -1,4 +1,5 @@
 #include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <list>
 #include <string>
@@ -28,6 +29,7 @@
 using testing::ContainerEq;
 using testing::Invoke;
 using testing::NiceMock;
+using testing::Return;
 using testing::_;
 
 namespace Envoy {
@@ -333,6 +335,45 @@ TEST(HostImplTest, Weight) {
   EXPECT_EQ(128U, host->weight());
 }
 
+TEST(HostImplTest, Index) {
+  MockCluster cluster;
+
+  HostSharedPtr host1 = makeTestHost(cluster.info_, "tcp://10.0.0.1:1234");
+  HostSharedPtr host2 = makeTestHost(cluster.info_, "tcp://10.0.0.1:1234");
+  EXPECT_NE(host1->index(), host2->index());
+
+  // The index of a destroyed host is reused.
+  const uint32_t index = host1->index();
+  host1.reset();
+  HostSharedPtr host3 = makeTestHost(cluster.info_, "tcp://10.0.0.2:1234");
+  EXPECT_EQ(index, host3->index());
+  EXPECT_NE(host2->index(), host3->index());
+}
+
+// Slower responses replace the latency at once, faster ones are averaged in over the decay time.
+TEST(PeakEwmaLatencyEstimatorImplTest, PeakEwma) {
+  PeakEwmaLatencyEstimatorImpl estimator;
+  const MonotonicTime start = MonotonicTime() + std::chrono::hours(1);
+  EXPECT_EQ(0, estimator.peakEwma(start));
+
+  estimator.putLatency(std::chrono::microseconds(100), start);
+  EXPECT_DOUBLE_EQ(100, estimator.peakEwma(start));
+  estimator.putLatency(std::chrono::microseconds(200), start);
+  EXPECT_DOUBLE_EQ(200, estimator.peakEwma(start));
+
+  // After the decay time, the previous latency is given a weight of 1 / e.
+  estimator.putLatency(std::chrono::microseconds(100), start + std::chrono::seconds(10));
+  const double ewma = 100 + 100 / M_E;
+  EXPECT_NEAR(ewma, estimator.peakEwma(start + std::chrono::seconds(10)), 1e-9);
+
+  // Without responses, the latency decays towards 0.
+  EXPECT_NEAR(ewma / M_E, estimator.peakEwma(start + std::chrono::seconds(20)), 1e-9);
+
+  // Late responses don't move the time of the last response back.
+  estimator.putLatency(std::chrono::microseconds(100), start);
+  EXPECT_NEAR(ewma / M_E, estimator.peakEwma(start + std::chrono::seconds(20)), 1e-9);
+}
+
 TEST(HostImplTest, HostnameCanaryAndLocality) {
   MockCluster cluster;
   envoy::api::v2::Metadata metadata;
@@ -377,6 +418,38 @@ TEST(StaticClusterImplTest, EmptyHostname) {
   EXPECT_FALSE(cluster.info()->addedViaApi());
 }
 
+TEST(StaticClusterImplTest, LazyStats) {
+  Stats::IsolatedStoreImpl stats;
+  Ssl::MockContextManager ssl_context_manager;
+  NiceMock<Runtime::MockLoader> runtime;
+  const std::string json = R"EOF(
+  {
+    "name": "staticcluster",
+    "connect_timeout_ms": 250,
+    "type": "static",
+    "lb_type": "random",
+    "hosts": [{"url": "tcp://10.0.0.1:11001"}]
+  }
+  )EOF";
+
+  EXPECT_CALL(runtime.snapshot_, featureEnabled("upstream.lazy_cluster_stats", 0))
+      .WillOnce(Return(true));
+  NiceMock<MockClusterManager> cm;
+  StaticClusterImpl cluster(parseClusterFromJson(json), runtime, stats, ssl_context_manager, cm,
+                            false);
+  cluster.initialize([] {});
+
+  EXPECT_EQ(1UL, stats.gauge("cluster.staticcluster.membership_total").value());
+  for (const Stats::CounterSharedPtr& counter : stats.counters()) {
+    EXPECT_NE("cluster.staticcluster.upstream_rq_total", counter->name());
+  }
+  EXPECT_EQ(0UL, cluster.info()->stats().upstream_rq_total_.value());
+
+  cluster.info()->stats().upstream_rq_total_.inc();
+  EXPECT_EQ(1UL, stats.counter("cluster.staticcluster.upstream_rq_total").value());
+  EXPECT_EQ(1UL, cluster.info()->stats().upstream_rq_total_.value());
+}
+
 TEST(StaticClusterImplTest, RingHash) {
   Stats::IsolatedStoreImpl stats;
   Ssl::MockContextManager ssl_context_manager;
@@ -401,6 +474,142 @@ TEST(StaticClusterImplTest, RingHash) {
   EXPECT_TRUE(cluster.info()->addedViaApi());
 }
 
+TEST(StaticClusterImplTest, Maglev) {
+  Stats::IsolatedStoreImpl stats;
+  Ssl::MockContextManager ssl_context_manager;
+  NiceMock<Runtime::MockLoader> runtime;
+  const std::string json = R"EOF(
+  {
+    "name": "staticcluster",
+    "connect_timeout_ms": 250,
+    "type": "static",
+    "lb_type": "ring_hash",
+    "hosts": [{"url": "tcp://10.0.0.1:11001"}]
+  }
+  )EOF";
+
+  EXPECT_CALL(runtime.snapshot_, getInteger("upstream.use_maglev.staticcluster", 0))
+      .WillOnce(Return(1));
+  NiceMock<MockClusterManager> cm;
+  StaticClusterImpl cluster(parseClusterFromJson(json), runtime, stats, ssl_context_manager, cm,
+                            false);
+  EXPECT_EQ(LoadBalancerType::Maglev, cluster.info()->lbType());
+}
+
+TEST(StaticClusterImplTest, PeakEwma) {
+  Stats::IsolatedStoreImpl stats;
+  Ssl::MockContextManager ssl_context_manager;
+  NiceMock<Runtime::MockLoader> runtime;
+  const std::string json = R"EOF(
+  {
+    "name": "staticcluster",
+    "connect_timeout_ms": 250,
+    "type": "static",
+    "lb_type": "least_request",
+    "hosts": [{"url": "tcp://10.0.0.1:11001"}]
+  }
+  )EOF";
+
+  EXPECT_CALL(runtime.snapshot_, getInteger("upstream.use_peak_ewma.staticcluster", 0))
+      .WillOnce(Return(1));
+  NiceMock<MockClusterManager> cm;
+  StaticClusterImpl cluster(parseClusterFromJson(json), runtime, stats, ssl_context_manager, cm,
+                            false);
+  EXPECT_EQ(LoadBalancerType::PeakEwma, cluster.info()->lbType());
+}
+
+TEST(StaticClusterImplTest, GrpcCompression) {
+  Stats::IsolatedStoreImpl stats;
+  Ssl::MockContextManager ssl_context_manager;
+  NiceMock<Runtime::MockLoader> runtime;
+  const std::string json = R"EOF(
+  {
+    "name": "staticcluster",
+    "connect_timeout_ms": 250,
+    "type": "static",
+    "lb_type": "round_robin",
+    "features": "http2",
+    "hosts": [{"url": "tcp://10.0.0.1:11001"}]
+  }
+  )EOF";
+
+  EXPECT_CALL(runtime.snapshot_, getInteger("upstream.grpc_compression.staticcluster", 0))
+      .WillOnce(Return(1));
+  NiceMock<MockClusterManager> cm;
+  StaticClusterImpl cluster(parseClusterFromJson(json), runtime, stats, ssl_context_manager, cm,
+                            false);
+  EXPECT_EQ(ClusterInfo::Features::HTTP2 | ClusterInfo::Features::GRPC_COMPRESSION,
+            cluster.info()->features());
+}
+
+TEST(StaticClusterImplTest, Http2ConnectionsPerHost) {
+  Stats::IsolatedStoreImpl stats;
+  Ssl::MockContextManager ssl_context_manager;
+  NiceMock<Runtime::MockLoader> runtime;
+  const std::string json = R"EOF(
+  {
+    "name": "staticcluster",
+    "connect_timeout_ms": 250,
+    "type": "static",
+    "lb_type": "round_robin",
+    "hosts": [{"url": "tcp://10.0.0.1:11001"}]
+  }
+  )EOF";
+
+  NiceMock<MockClusterManager> cm;
+  StaticClusterImpl cluster(parseClusterFromJson(json), runtime, stats, ssl_context_manager, cm,
+                            false);
+  EXPECT_CALL(runtime.snapshot_, getInteger("upstream.http2_connections_per_host.staticcluster", 1))
+      .WillOnce(Return(1))
+      .WillOnce(Return(0))
+      .WillOnce(Return(4))
+      .WillOnce(Return(1000));
+  EXPECT_EQ(1U, cluster.info()->http2ConnectionsPerHost());
+  EXPECT_EQ(1U, cluster.info()->http2ConnectionsPerHost());
+  EXPECT_EQ(4U, cluster.info()->http2ConnectionsPerHost());
+  EXPECT_EQ(64U, cluster.info()->http2ConnectionsPerHost());
+}
+
+TEST(StaticClusterImplTest, Http1ConnPoolSettings) {
+  Stats::IsolatedStoreImpl stats;
+  Ssl::MockContextManager ssl_context_manager;
+  NiceMock<Runtime::MockLoader> runtime;
+  const std::string json = R"EOF(
+  {
+    "name": "staticcluster",
+    "connect_timeout_ms": 250,
+    "type": "static",
+    "lb_type": "round_robin",
+    "hosts": [{"url": "tcp://10.0.0.1:11001"}]
+  }
+  )EOF";
+
+  NiceMock<MockClusterManager> cm;
+  StaticClusterImpl cluster(parseClusterFromJson(json), runtime, stats, ssl_context_manager, cm,
+                            false);
+  EXPECT_CALL(runtime.snapshot_, getInteger("upstream.http1_prefetch_percent.staticcluster", 100))
+      .WillOnce(Return(50))
+      .WillOnce(Return(150))
+      .WillOnce(Return(5000));
+  EXPECT_EQ(100U, cluster.info()->http1PrefetchPercent());
+  EXPECT_EQ(150U, cluster.info()->http1PrefetchPercent());
+  EXPECT_EQ(1000U, cluster.info()->http1PrefetchPercent());
+  EXPECT_CALL(runtime.snapshot_, getInteger("upstream.http1_min_idle_connections.staticcluster", 0))
+      .WillOnce(Return(2));
+  EXPECT_EQ(2U, cluster.info()->http1MinIdleConnections());
+  EXPECT_CALL(runtime.snapshot_, getInteger("upstream.http1_idle_timeout_ms.staticcluster", 0))
+      .WillOnce(Return(30000));
+  EXPECT_EQ(std::chrono::milliseconds(30000), cluster.info()->http1IdleTimeout());
+  EXPECT_CALL(runtime.snapshot_,
+              getInteger("upstream.http1_max_pipelined_requests.staticcluster", 1))
+      .WillOnce(Return(0))
+      .WillOnce(Return(4))
+      .WillOnce(Return(100));
+  EXPECT_EQ(1U, cluster.info()->http1MaxPipelinedRequests());
+  EXPECT_EQ(4U, cluster.info()->http1MaxPipelinedRequests());
+  EXPECT_EQ(16U, cluster.info()->http1MaxPipelinedRequests());
+}
+
 TEST(StaticClusterImplTest, OutlierDetector) {
   Stats::IsolatedStoreImpl stats;
   Ssl::MockContextManager ssl_context_manager;
@@ -693,7 +902,7 @@ TEST(PrioritySet, Extend) {
   std::vector<HostSharedPtr> hosts_removed{};
 
   priority_set.hostSetsPerPriority()[1]->updateHosts(
-      hosts, hosts, hosts_per_locality, hosts_per_locality, hosts_added, hosts_removed);
+      hosts, hosts, hosts_per_locality, hosts_per_locality, nullptr, hosts_added, hosts_removed);
   EXPECT_EQ(3, changes);
   EXPECT_EQ(last_priority, 1);
   EXPECT_EQ(1, priority_set.hostSetsPerPriority()[1]->hosts().size());
@@ -0,0 +1,343 @@
+// Note: this should be run with --compilation_mode=opt, on a machine which allows the process
+// enough file descriptors, as each connection uses two, or four once it has an upstream
+// connection. Connection counts beyond those allowed are skipped. The counts run can be set with
+// the ENVOY_SCALE_TEST_CONNECTIONS environment variable, as a comma separated list.
+//
+// The server is in process, and its heap is shared with the benchmark, so the connections to and
+// from it are plain sockets which hold no memory in the heap, and only the server's memory is
+// counted.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/common/assert.h"
+#include "common/common/utility.h"
+#include "common/memory/stats.h"
+#include "common/protobuf/utility.h"
+
+#include "test/integration/http_integration.h"
+
+#include "api/filter/network/tcp_proxy.pb.h"
+#include "benchmark/benchmark.h"
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace {
+
+enum class Proxy { Http1, Http2, Tcp };
+
+// Connections from each loopback address, which is well within the ephemeral port range.
+const uint32_t CONNECTIONS_PER_ADDRESS = 20000;
+
+uint64_t residentBytes() {
+  std::ifstream statm("/proc/self/statm");
+  uint64_t size = 0;
+  uint64_t resident = 0;
+  statm >> size >> resident;
+  return resident * ::sysconf(_SC_PAGESIZE);
+}
+
+// The i-th loopback address used for a group of connections. Both the downstream connections to
+// the server and its upstream connections are spread over a number of addresses, so that they are
+// not limited to the ephemeral ports of a single one.
+std::string loopbackAddress(uint32_t first, uint32_t index) {
+  return fmt::format("127.{}.{}.{}", first, index / 250, index % 250 + 1);
+}
+
+sockaddr_in socketAddress(const std::string& address, uint32_t port) {
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  RELEASE_ASSERT(::inet_pton(AF_INET, address.c_str(), &addr.sin_addr) == 1);
+  return addr;
+}
+
+/**
+ * An upstream which accepts connections on every loopback address and holds them open without
+ * ever reading or answering, so that each request proxied to it stays in flight.
+ */
+class SilentUpstream {
+public:
+  SilentUpstream(uint32_t max_connections) {
+    fds_.reserve(max_connections);
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    RELEASE_ASSERT(listen_fd_ >= 0);
+    sockaddr_in addr = socketAddress("0.0.0.0", 0);
+    RELEASE_ASSERT(::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    RELEASE_ASSERT(::listen(listen_fd_, SOMAXCONN) == 0);
+    socklen_t len = sizeof(addr);
+    RELEASE_ASSERT(::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) == 0);
+    port_ = ntohs(addr.sin_port);
+    thread_ = std::thread([this]() -> void { acceptLoop(); });
+  }
+
+  ~SilentUpstream() {
+    stopping_ = true;
+    thread_.join();
+    for (int fd : fds_) {
+      ::close(fd);
+    }
+    ::close(listen_fd_);
+  }
+
+  uint32_t port() const { return port_; }
+  uint64_t accepted() const { return accepted_; }
+
+private:
+  void acceptLoop() {
+    pollfd poll_fd{listen_fd_, POLLIN, 0};
+    while (!stopping_) {
+      if (::poll(&poll_fd, 1, 100) <= 0) {
+        continue;
+      }
+      int fd;
+      while ((fd = ::accept(listen_fd_, nullptr, nullptr)) >= 0) {
+        fds_.push_back(fd);
+        accepted_++;
+      }
+    }
+  }
+
+  int listen_fd_;
+  uint32_t port_;
+  std::vector<int> fds_;
+  std::atomic<uint64_t> accepted_{};
+  std::atomic<bool> stopping_{};
+  std::thread thread_;
+};
+
+/**
+ * A server proxying to the silent upstream over HTTP/1, HTTP/2 or TCP, with no limit on the
+ * number of connections or requests in flight.
+ */
+class ScaleTestServer : public HttpIntegrationTest {
+public:
+  ScaleTestServer(Proxy proxy, uint32_t upstream_port, uint32_t upstream_addresses)
+      : HttpIntegrationTest(proxy == Proxy::Http2 ? Http::CodecClient::Type::HTTP2
+                                                  : Http::CodecClient::Type::HTTP1,
+                            Network::Address::IpVersion::v4),
+        upstream_port_(upstream_port), upstream_addresses_(upstream_addresses) {
+    SetUp();
+
+    config_helper_.addConfigModifier([this](envoy::api::v2::Bootstrap& bootstrap) -> void {
+      auto* cluster = bootstrap.mutable_static_resources()->mutable_clusters(0);
+      cluster->mutable_hosts(0)->mutable_socket_address()->set_address(loopbackAddress(0, 1));
+      for (uint32_t i = 1; i < upstream_addresses_; i++) {
+        cluster->add_hosts()->MergeFrom(cluster->hosts(0));
+        cluster->mutable_hosts(i)->mutable_socket_address()->set_address(
+            loopbackAddress(0, i + 1));
+      }
+      auto* thresholds = cluster->mutable_circuit_breakers()->add_thresholds();
+      thresholds->mutable_max_connections()->set_value(std::numeric_limits<uint32_t>::max());
+      thresholds->mutable_max_pending_requests()->set_value(std::numeric_limits<uint32_t>::max());
+      thresholds->mutable_max_requests()->set_value(std::numeric_limits<uint32_t>::max());
+    });
+    if (proxy == Proxy::Tcp) {
+      config_helper_.addConfigModifier([](envoy::api::v2::Bootstrap& bootstrap) -> void {
+        envoy::api::v2::filter::network::TcpProxy tcp_proxy;
+        tcp_proxy.set_stat_prefix("tcp_stats");
+        tcp_proxy.set_cluster("cluster_0");
+        auto* filter = bootstrap.mutable_static_resources()
+                           ->mutable_listeners(0)
+                           ->mutable_filter_chains(0)
+                           ->mutable_filters(0);
+        filter->set_name("envoy.tcp_proxy");
+        MessageUtil::jsonConvert(tcp_proxy, *filter->mutable_config());
+      });
+    } else {
+      // Requests are held in flight for as long as it takes to open all the connections.
+      config_helper_.addConfigModifier(
+          [](envoy::api::v2::filter::network::HttpConnectionManager& hcm) -> void {
+            hcm.mutable_route_config()
+                ->mutable_virtual_hosts(0)
+                ->mutable_routes(0)
+                ->mutable_route()
+                ->mutable_timeout()
+                ->set_seconds(0);
+          });
+    }
+    initialize();
+  }
+
+  ~ScaleTestServer() { test_server_.reset(); }
+
+  void createUpstreams() override { ports_.assign(upstream_addresses_, upstream_port_); }
+
+  IntegrationTestServer& server() { return *test_server_; }
+
+private:
+  const uint32_t upstream_port_;
+  const uint32_t upstream_addresses_;
+};
+
+/**
+ * Plain downstream connections to the server, each from the next port of a loopback address.
+ */
+class Clients {
+public:
+  Clients(uint32_t count) { fds_.reserve(count); }
+
+  ~Clients() {
+    for (int fd : fds_) {
+      ::close(fd);
+    }
+  }
+
+  void connect(uint32_t port) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    RELEASE_ASSERT(fd >= 0);
+    sockaddr_in source =
+        socketAddress(loopbackAddress(1, fds_.size() / CONNECTIONS_PER_ADDRESS), 0);
+    RELEASE_ASSERT(::bind(fd, reinterpret_cast<sockaddr*>(&source), sizeof(source)) == 0);
+    sockaddr_in server = socketAddress("127.0.0.1", port);
+    RELEASE_ASSERT(::connect(fd, reinterpret_cast<sockaddr*>(&server), sizeof(server)) == 0);
+    fds_.push_back(fd);
+  }
+
+  void send(const std::string& data) {
+    for (int fd : fds_) {
+      RELEASE_ASSERT(::send(fd, data.data(), data.size(), 0) == static_cast<ssize_t>(data.size()));
+    }
+  }
+
+private:
+  std::vector<int> fds_;
+};
+
+// The first bytes a client sends, which for HTTP are a complete request.
+std::string firstBytes(Proxy proxy) {
+  switch (proxy) {
+  case Proxy::Http1:
+    return "GET / HTTP/1.1\r\nhost: host\r\n\r\n";
+  case Proxy::Http2: {
+    // The connection preface, an empty SETTINGS frame and a HEADERS frame ending stream 1, with
+    // the :method GET, :scheme http and :path / static table entries and an :authority of host.
+    static const char request[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+                                  "\x00\x00\x00\x04\x00\x00\x00\x00\x00"
+                                  "\x00\x00\x09\x01\x05\x00\x00\x00\x01"
+                                  "\x82\x86\x84\x41\x04host";
+    return std::string(request, sizeof(request) - 1);
+  }
+  case Proxy::Tcp:
+    return "ping";
+  }
+  NOT_REACHED;
+}
+
+uint64_t fileDescriptorLimit() {
+  rlimit limit;
+  RELEASE_ASSERT(::getrlimit(RLIMIT_NOFILE, &limit) == 0);
+  if (limit.rlim_cur < limit.rlim_max) {
+    limit.rlim_cur = limit.rlim_max;
+    ::setrlimit(RLIMIT_NOFILE, &limit);
+  }
+  return limit.rlim_cur;
+}
+
+// Open a number of connections to a server, idle (range(2) == 0) or each with a request or, for
+// TCP, some bytes in flight to the upstream (range(2) != 0), and report the memory of the server
+// per connection. As the heap does not track which subsystem allocates what, the heap bytes are
+// broken down by the stage of the connection: cx_heap_bytes for an accepted connection, which has
+// its filter chain and, for TCP, its upstream connection, and rq_heap_bytes for what a request in
+// flight adds to it, which is the codec, the stream and its filters, and the upstream connection.
+static void ConnectionScale(benchmark::State& state) {
+  TestEnvironment::initializeStandalone("connection_scale_test");
+  const Proxy proxy = static_cast<Proxy>(state.range(0));
+  const uint32_t connections = state.range(1);
+  const bool active = state.range(2) != 0;
+  const bool upstream_connections = active || proxy == Proxy::Tcp;
+
+  // Each connection has a client and a server socket, and once it has an upstream connection, a
+  // socket at each end of that too.
+  const uint64_t fds_needed = connections * (upstream_connections ? 4 : 2) + 1024;
+  if (fileDescriptorLimit() < fds_needed) {
+    state.SkipWithError("file descriptor limit too low for the number of connections");
+    return;
+  }
+
+  const uint32_t addresses = (connections + CONNECTIONS_PER_ADDRESS - 1) / CONNECTIONS_PER_ADDRESS;
+  SilentUpstream upstream(upstream_connections ? connections : 0);
+  ScaleTestServer server(proxy, upstream.port(), addresses);
+  const uint32_t port = server.lookupPort("http");
+  const std::string listener_prefix = "listener.127.0.0.1_0.";
+
+  while (state.KeepRunning()) {
+    Clients clients(connections);
+    const uint64_t heap_start = Memory::Stats::totalCurrentlyAllocated();
+    const uint64_t resident_start = residentBytes();
+
+    // Connect in batches no larger than the listen backlog, waiting for each to be accepted.
+    const uint32_t batch = 100;
+    for (uint32_t i = 0; i < connections; i++) {
+      clients.connect(port);
+      if ((i + 1) % batch == 0 || i + 1 == connections) {
+        server.server().waitForCounterGe(listener_prefix + "downstream_cx_total", i + 1);
+      }
+    }
+    if (proxy == Proxy::Tcp) {
+      server.server().waitForCounterGe("cluster.cluster_0.upstream_cx_total", connections);
+    }
+    const uint64_t heap_idle = Memory::Stats::totalCurrentlyAllocated();
+
+    if (active) {
+      const std::string bytes = firstBytes(proxy);
+      clients.send(bytes);
+      if (proxy == Proxy::Tcp) {
+        server.server().waitForCounterGe("cluster.cluster_0.upstream_cx_tx_bytes_total",
+                                         static_cast<uint64_t>(connections) * bytes.size());
+      } else {
+        server.server().waitForCounterGe("cluster.cluster_0.upstream_rq_total", connections);
+      }
+    }
+    while (upstream.accepted() < (upstream_connections ? connections : 0)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    const uint64_t heap_end = Memory::Stats::totalCurrentlyAllocated();
+    const uint64_t resident_end = residentBytes();
+
+    // The heap can shrink a little between stages, as caches such as those of the stats are
+    // trimmed, so the differences are signed.
+    const auto perConnection = [connections](uint64_t end, uint64_t start) -> double {
+      return (static_cast<double>(end) - static_cast<double>(start)) / connections;
+    };
+    state.counters["heap_bytes_per_cx"] = perConnection(heap_end, heap_start);
+    state.counters["rss_bytes_per_cx"] = perConnection(resident_end, resident_start);
+    state.counters["cx_heap_bytes"] = perConnection(heap_idle, heap_start);
+    state.counters["rq_heap_bytes"] = perConnection(heap_end, heap_idle);
+  }
+}
+
+static void ConnectionScaleArgs(benchmark::internal::Benchmark* b) {
+  std::vector<int> counts{10000, 100000, 1000000};
+  const char* counts_env = ::getenv("ENVOY_SCALE_TEST_CONNECTIONS");
+  if (counts_env != nullptr) {
+    counts.clear();
+    for (const std::string& count : StringUtil::split(counts_env, ',')) {
+      counts.push_back(std::stoi(count));
+    }
+  }
+  for (const Proxy proxy : {Proxy::Http1, Proxy::Http2, Proxy::Tcp}) {
+    for (const int count : counts) {
+      for (const int active : {0, 1}) {
+        b->Args({static_cast<int>(proxy), count, active});
+      }
+    }
+  }
+}
+BENCHMARK(ConnectionScale)->Apply(ConnectionScaleArgs)->Iterations(1)->Unit(benchmark::kSecond);
+
+} // namespace
+} // namespace Envoy
@@ -0,0 +1,194 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management. The load is set by the
+// ENVOY_LOAD_TEST_DURATION_MS, ENVOY_LOAD_TEST_THREADS, ENVOY_LOAD_TEST_CONNECTIONS and
+// ENVOY_LOAD_TEST_STREAMS environment variables, the last only applying to HTTP/2.
+
+#include <stdlib.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "common/network/utility.h"
+#include "common/ssl/context_manager_impl.h"
+
+#include "test/integration/http_integration.h"
+#include "test/integration/load_generator.h"
+#include "test/integration/ssl_utility.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/test_common/network_utility.h"
+
+#include "benchmark/benchmark.h"
+#include "fmt/format.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace {
+
+enum class Scenario { Plain, Tls, Retries, Lua, GrpcWeb };
+
+uint64_t envOrDefault(const char* name, uint64_t default_value) {
+  const char* value = ::getenv(name);
+  return value != nullptr ? std::stoull(value) : default_value;
+}
+
+std::chrono::microseconds processCpuTime() {
+  rusage usage;
+  RELEASE_ASSERT(getrusage(RUSAGE_SELF, &usage) == 0);
+  return std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+         std::chrono::microseconds(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+/**
+ * A server configured for a scenario, proxying to an upstream which answers every request.
+ */
+class LoadTestServer : public HttpIntegrationTest {
+public:
+  LoadTestServer(Http::CodecClient::Type type, Scenario scenario)
+      : HttpIntegrationTest(type, Network::Address::IpVersion::v4), scenario_(scenario) {
+    autonomous_upstream_ = true;
+    SetUp();
+
+    switch (scenario_) {
+    case Scenario::Tls:
+      config_helper_.addSslConfig();
+      break;
+    case Scenario::Lua:
+      config_helper_.addFilter(R"EOF(
+name: envoy.lua
+config:
+  inline_code: |
+    function envoy_on_request(request_handle)
+      request_handle:headers():add("x-lua", "request")
+    end
+    function envoy_on_response(response_handle)
+      response_handle:headers():add("x-lua", "response")
+    end
+)EOF");
+      break;
+    case Scenario::GrpcWeb:
+      config_helper_.addFilter("name: envoy.grpc_web\nconfig: {}");
+      break;
+    case Scenario::Plain:
+    case Scenario::Retries:
+      break;
+    }
+    initialize();
+
+    if (scenario_ == Scenario::Tls) {
+      context_manager_.reset(new Ssl::ContextManagerImpl(runtime_));
+      client_ssl_ctx_ =
+          Ssl::createClientSslContext(type == Http::CodecClient::Type::HTTP2, false,
+                                      *context_manager_);
+    }
+  }
+
+  ~LoadTestServer() {
+    test_server_.reset();
+    fake_upstreams_.clear();
+    client_ssl_ctx_.reset();
+  }
+
+  LoadGenerator::ConnectionFactory connectionFactory() {
+    const uint32_t port = lookupPort("http");
+    if (scenario_ == Scenario::Tls) {
+      return [this, port](Event::Dispatcher& dispatcher) -> Network::ClientConnectionPtr {
+        return dispatcher.createSslClientConnection(
+            *client_ssl_ctx_, Ssl::getSslAddress(version_, port), nullptr);
+      };
+    }
+    const Network::Address::InstanceConstSharedPtr address = Network::Utility::resolveUrl(
+        fmt::format("tcp://{}:{}", Network::Test::getLoopbackAddressUrlString(version_), port));
+    return [address](Event::Dispatcher& dispatcher) -> Network::ClientConnectionPtr {
+      return dispatcher.createClientConnection(address, nullptr);
+    };
+  }
+
+  void addRequestHeaders(Http::TestHeaderMapImpl& headers) const {
+    headers.addCopy(":method", scenario_ == Scenario::GrpcWeb ? "POST" : "GET");
+    headers.addCopy(":path", "/");
+    headers.addCopy(":scheme", "http");
+    headers.addCopy(":authority", "host");
+    switch (scenario_) {
+    case Scenario::Retries:
+      headers.addCopy("x-envoy-retry-on", "5xx,connect-failure");
+      headers.addCopy("x-envoy-max-retries", "3");
+      break;
+    case Scenario::GrpcWeb:
+      headers.addCopy("content-type", "application/grpc-web");
+      break;
+    case Scenario::Plain:
+    case Scenario::Tls:
+    case Scenario::Lua:
+      break;
+    }
+  }
+
+  std::string requestBody() const {
+    // A gRPC frame holding an empty message.
+    return scenario_ == Scenario::GrpcWeb ? std::string("\0\0\0\0\0", 5) : "";
+  }
+
+private:
+  const Scenario scenario_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  std::unique_ptr<Ssl::ContextManager> context_manager_;
+  Ssl::ClientContextPtr client_ssl_ctx_;
+};
+
+// Apply a closed loop load to a server for each scenario and protocol, reporting the throughput,
+// the latency percentiles and the CPU time per request.
+static void HttpLoad(benchmark::State& state) {
+  TestEnvironment::initializeStandalone("http_load_test");
+  const Scenario scenario = static_cast<Scenario>(state.range(0));
+  const Http::CodecClient::Type type = static_cast<Http::CodecClient::Type>(state.range(1));
+
+  LoadTestServer server(type, scenario);
+  LoadGenerator::Options options;
+  options.type_ = type;
+  options.threads_ = envOrDefault("ENVOY_LOAD_TEST_THREADS", 2);
+  options.connections_per_thread_ = envOrDefault("ENVOY_LOAD_TEST_CONNECTIONS", 4);
+  options.streams_per_connection_ =
+      type == Http::CodecClient::Type::HTTP2 ? envOrDefault("ENVOY_LOAD_TEST_STREAMS", 4) : 1;
+  options.duration_ = std::chrono::milliseconds(envOrDefault("ENVOY_LOAD_TEST_DURATION_MS", 1000));
+  server.addRequestHeaders(options.request_headers_);
+  options.request_body_ = server.requestBody();
+
+  while (state.KeepRunning()) {
+    const std::chrono::microseconds cpu_start = processCpuTime();
+    LoadGenerator::Result result = LoadGenerator(options, server.connectionFactory()).run();
+    const std::chrono::microseconds cpu_time = processCpuTime() - cpu_start;
+
+    const double requests = std::max<uint64_t>(result.requests_, 1);
+    state.SetIterationTime(std::chrono::duration<double>(result.duration_).count());
+    state.SetItemsProcessed(result.requests_);
+    state.counters["p50_us"] = result.latencyPercentile(0.5);
+    state.counters["p99_us"] = result.latencyPercentile(0.99);
+    state.counters["p999_us"] = result.latencyPercentile(0.999);
+    state.counters["cpu_us_per_rq"] = cpu_time.count() / requests;
+    state.counters["client_cpu_us_per_rq"] =
+        std::chrono::duration_cast<std::chrono::microseconds>(result.cpu_time_).count() / requests;
+    state.counters["errors"] = result.errors_;
+  }
+}
+
+static void HttpLoadArgs(benchmark::internal::Benchmark* b) {
+  for (const Scenario scenario :
+       {Scenario::Plain, Scenario::Tls, Scenario::Retries, Scenario::Lua, Scenario::GrpcWeb}) {
+    for (const Http::CodecClient::Type type :
+         {Http::CodecClient::Type::HTTP1, Http::CodecClient::Type::HTTP2}) {
+      b->Args({static_cast<int>(scenario), static_cast<int>(type)});
+    }
+  }
+}
+BENCHMARK(HttpLoad)
+    ->Apply(HttpLoadArgs)
+    ->UseManualTime()
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace Envoy
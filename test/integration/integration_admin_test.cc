@@ -137,6 +137,17 @@ TEST_P(IntegrationAdminTest, Admin) {
   EXPECT_THAT(
       response->body(),
       testing::HasSubstr("envoy_cluster_upstream_cx_active{envoy_cluster_name=\"cds\"} 0\n"));
+
+  response = IntegrationUtil::makeSingleRequest(lookupPort("admin"), "GET",
+                                                "/stats/prometheus?prefix=cluster.", "",
+                                                downstreamProtocol(), version_);
+  EXPECT_TRUE(response->complete());
+  EXPECT_STREQ("200", response->headers().Status()->value().c_str());
+  EXPECT_THAT(
+      response->body(),
+      testing::HasSubstr("envoy_cluster_upstream_cx_active{envoy_cluster_name=\"cds\"} 0\n"));
+  EXPECT_THAT(response->body(), testing::Not(testing::HasSubstr("envoy_http_downstream_rq_xx")));
+
   response = IntegrationUtil::makeSingleRequest(lookupPort("admin"), "GET", "/clusters", "",
                                                 downstreamProtocol(), version_);
   EXPECT_TRUE(response->complete());
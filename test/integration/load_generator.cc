@@ -0,0 +1,261 @@
+#include "test/integration/load_generator.h"
+
+#include <time.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/assert.h"
+#include "common/common/thread.h"
+#include "common/common/utility.h"
+#include "common/event/dispatcher_impl.h"
+#include "common/http/utility.h"
+
+#include "test/common/upstream/utility.h"
+#include "test/mocks/upstream/mocks.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace {
+
+std::chrono::nanoseconds threadCpuTime() {
+  timespec now;
+  RELEASE_ASSERT(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) == 0);
+  return std::chrono::seconds(now.tv_sec) + std::chrono::nanoseconds(now.tv_nsec);
+}
+
+} // namespace
+
+/**
+ * A thread of the load generator, with its own dispatcher and connections.
+ */
+class LoadGenerator::Worker {
+public:
+  Worker(const LoadGenerator& parent) : parent_(parent) {}
+
+  void run();
+
+  uint64_t errors_{};
+  std::vector<uint64_t> latencies_us_;
+  MonotonicTime start_;
+  MonotonicTime end_;
+  std::chrono::nanoseconds cpu_time_{};
+
+private:
+  class Connection;
+
+  /**
+   * A request slot of a connection, which sends a new request each time the previous one
+   * completes.
+   */
+  class Stream : public Http::StreamDecoder, public Http::StreamCallbacks {
+  public:
+    Stream(Connection& parent) : parent_(parent) {}
+
+    void send();
+
+    // Http::StreamDecoder
+    void decodeHeaders(Http::HeaderMapPtr&& headers, bool end_stream) override {
+      const uint64_t status = Http::Utility::getResponseStatus(*headers);
+      success_ = status >= 200 && status < 300;
+      if (end_stream) {
+        parent_.parent_.onStreamComplete(*this, success_);
+      }
+    }
+    void decodeData(Buffer::Instance&, bool end_stream) override {
+      if (end_stream) {
+        parent_.parent_.onStreamComplete(*this, success_);
+      }
+    }
+    void decodeTrailers(Http::HeaderMapPtr&&) override {
+      parent_.parent_.onStreamComplete(*this, success_);
+    }
+
+    // Http::StreamCallbacks
+    void onResetStream(Http::StreamResetReason) override {
+      parent_.parent_.onStreamComplete(*this, false);
+    }
+    void onAboveWriteBufferHighWatermark() override {}
+    void onBelowWriteBufferLowWatermark() override {}
+
+    Connection& parent_;
+    MonotonicTime start_;
+    bool success_{};
+  };
+
+  /**
+   * A connection to the server. A closed connection is kept until the end of the run, as posted
+   * sends can still refer to its streams, and a new one takes its place.
+   */
+  class Connection : public Network::ConnectionCallbacks {
+  public:
+    Connection(Worker& parent);
+
+    // Network::ConnectionCallbacks
+    void onEvent(Network::ConnectionEvent event) override;
+    void onAboveWriteBufferHighWatermark() override {}
+    void onBelowWriteBufferLowWatermark() override {}
+
+    Worker& parent_;
+    std::unique_ptr<Http::CodecClient> codec_;
+    std::vector<std::unique_ptr<Stream>> streams_;
+    bool closed_{};
+  };
+
+  void addConnection();
+  void onStreamComplete(Stream& stream, bool success);
+  void stop();
+
+  const LoadGenerator& parent_;
+  Event::DispatcherPtr dispatcher_;
+  Upstream::HostDescriptionConstSharedPtr host_;
+  std::list<std::unique_ptr<Connection>> connections_;
+  uint64_t outstanding_{};
+  bool stopping_{};
+};
+
+void LoadGenerator::Worker::Stream::send() {
+  if (parent_.closed_) {
+    return;
+  }
+
+  const Options& options = parent_.parent_.parent_.options_;
+  start_ = ProdMonotonicTimeSource::instance_.currentTime();
+  success_ = false;
+  parent_.parent_.outstanding_++;
+  Http::StreamEncoder& encoder = parent_.codec_->newStream(*this);
+  encoder.getStream().addCallbacks(*this);
+  encoder.encodeHeaders(options.request_headers_, options.request_body_.empty());
+  if (!options.request_body_.empty()) {
+    Buffer::OwnedImpl body(options.request_body_);
+    encoder.encodeData(body, true);
+  }
+}
+
+LoadGenerator::Worker::Connection::Connection(Worker& parent) : parent_(parent) {
+  const Options& options = parent_.parent_.options_;
+  codec_.reset(new Http::CodecClientProd(
+      options.type_, parent_.parent_.connection_factory_(*parent_.dispatcher_), parent_.host_));
+  codec_->addConnectionCallbacks(*this);
+  for (uint32_t i = 0; i < options.streams_per_connection_; i++) {
+    streams_.emplace_back(new Stream(*this));
+  }
+}
+
+void LoadGenerator::Worker::Connection::onEvent(Network::ConnectionEvent event) {
+  if (event == Network::ConnectionEvent::RemoteClose ||
+      event == Network::ConnectionEvent::LocalClose) {
+    closed_ = true;
+    if (!parent_.stopping_) {
+      parent_.dispatcher_->post([this]() -> void { parent_.addConnection(); });
+    }
+  }
+}
+
+void LoadGenerator::Worker::addConnection() {
+  connections_.emplace_back(new Connection(*this));
+  for (auto& stream : connections_.back()->streams_) {
+    stream->send();
+  }
+}
+
+void LoadGenerator::Worker::onStreamComplete(Stream& stream, bool success) {
+  ASSERT(outstanding_ > 0);
+  outstanding_--;
+  end_ = ProdMonotonicTimeSource::instance_.currentTime();
+  if (success) {
+    latencies_us_.push_back(
+        std::chrono::duration_cast<std::chrono::microseconds>(end_ - stream.start_).count());
+  } else {
+    errors_++;
+  }
+
+  if (stopping_) {
+    if (outstanding_ == 0) {
+      dispatcher_->exit();
+    }
+    return;
+  }
+
+  // The codec is still dispatching the response, so the next request is sent once it is done.
+  dispatcher_->post([&stream]() -> void { stream.send(); });
+}
+
+void LoadGenerator::Worker::stop() {
+  stopping_ = true;
+  if (outstanding_ == 0) {
+    dispatcher_->exit();
+  }
+}
+
+void LoadGenerator::Worker::run() {
+  const std::chrono::nanoseconds cpu_start = threadCpuTime();
+  dispatcher_.reset(new Event::DispatcherImpl());
+  std::shared_ptr<Upstream::MockClusterInfo> cluster{new NiceMock<Upstream::MockClusterInfo>()};
+  host_ = Upstream::makeTestHostDescription(cluster, "tcp://127.0.0.1:80");
+
+  start_ = end_ = ProdMonotonicTimeSource::instance_.currentTime();
+  for (uint32_t i = 0; i < parent_.options_.connections_per_thread_; i++) {
+    addConnection();
+  }
+  Event::TimerPtr deadline_timer = dispatcher_->createTimer([this]() -> void { stop(); });
+  deadline_timer->enableTimer(parent_.options_.duration_);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+
+  deadline_timer.reset();
+  for (auto& connection : connections_) {
+    connection->codec_->close();
+  }
+  dispatcher_->clearDeferredDeleteList();
+  connections_.clear();
+  dispatcher_.reset();
+  cpu_time_ = threadCpuTime() - cpu_start;
+}
+
+LoadGenerator::LoadGenerator(const Options& options, ConnectionFactory connection_factory)
+    : options_(options), connection_factory_(connection_factory) {
+  RELEASE_ASSERT(options_.type_ == Http::CodecClient::Type::HTTP2 ||
+                 options_.streams_per_connection_ == 1);
+}
+
+LoadGenerator::Result LoadGenerator::run() {
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::vector<std::unique_ptr<Thread::Thread>> threads;
+  for (uint32_t i = 0; i < options_.threads_; i++) {
+    workers.emplace_back(new Worker(*this));
+    Worker& worker = *workers.back();
+    threads.emplace_back(new Thread::Thread([&worker]() -> void { worker.run(); }));
+  }
+  for (auto& thread : threads) {
+    thread->join();
+  }
+
+  Result result;
+  MonotonicTime start = workers.front()->start_;
+  MonotonicTime end = workers.front()->end_;
+  for (auto& worker : workers) {
+    start = std::min(start, worker->start_);
+    end = std::max(end, worker->end_);
+    result.errors_ += worker->errors_;
+    result.cpu_time_ += worker->cpu_time_;
+    result.latencies_us_.insert(result.latencies_us_.end(), worker->latencies_us_.begin(),
+                                worker->latencies_us_.end());
+  }
+  result.requests_ = result.latencies_us_.size();
+  result.duration_ = end - start;
+  std::sort(result.latencies_us_.begin(), result.latencies_us_.end());
+  return result;
+}
+
+uint64_t LoadGenerator::Result::latencyPercentile(double quantile) const {
+  if (latencies_us_.empty()) {
+    return 0;
+  }
+
+  const size_t index = static_cast<size_t>(std::ceil(quantile * latencies_us_.size()));
+  return latencies_us_[std::min(std::max<size_t>(index, 1), latencies_us_.size()) - 1];
+}
+
+} // namespace Envoy
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/common/time.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/http/codec.h"
+#include "envoy/network/connection.h"
+#include "envoy/upstream/upstream.h"
+
+#include "common/http/codec_client.h"
+
+#include "test/test_common/utility.h"
+
+namespace Envoy {
+
+/**
+ * A closed loop HTTP load generator. Each of its threads runs its own dispatcher and connections,
+ * and each connection keeps a fixed number of requests outstanding, sending the next one as soon
+ * as a response completes. The latency of every request is recorded.
+ */
+class LoadGenerator {
+public:
+  typedef std::function<Network::ClientConnectionPtr(Event::Dispatcher& dispatcher)>
+      ConnectionFactory;
+
+  struct Options {
+    Http::CodecClient::Type type_{Http::CodecClient::Type::HTTP1};
+    uint32_t threads_{1};
+    uint32_t connections_per_thread_{1};
+    // Only HTTP/2 connections can have more than one request outstanding.
+    uint32_t streams_per_connection_{1};
+    std::chrono::milliseconds duration_{1000};
+    Http::TestHeaderMapImpl request_headers_;
+    std::string request_body_;
+  };
+
+  struct Result {
+    /**
+     * @return uint64_t the latency of the successful requests at a quantile, in microseconds.
+     */
+    uint64_t latencyPercentile(double quantile) const;
+
+    // The successful requests, which are those with a 2xx response.
+    uint64_t requests_{};
+    uint64_t errors_{};
+    // The time from the start of the load to the last response.
+    std::chrono::nanoseconds duration_{};
+    // The CPU time used by the threads of the load generator.
+    std::chrono::nanoseconds cpu_time_{};
+    // The latencies of the successful requests in microseconds, sorted.
+    std::vector<uint64_t> latencies_us_;
+  };
+
+  /**
+   * @param options supplies the shape of the load, which must outlive the load generator.
+   * @param connection_factory supplies how to make a connection to the server. It is called on
+   *        the threads of the load generator.
+   */
+  LoadGenerator(const Options& options, ConnectionFactory connection_factory);
+
+  /**
+   * Apply the load for its duration, and then wait for the outstanding requests to complete.
+   * @return Result the requests made and their latencies.
+   */
+  Result run();
+
+private:
+  class Worker;
+
+  const Options& options_;
+  const ConnectionFactory connection_factory_;
+};
+
+} // namespace Envoy
@@ -43,6 +43,7 @@ public:
   spdlog::level::level_enum logLevel() override { NOT_IMPLEMENTED; }
   std::chrono::seconds parentShutdownTime() override { return std::chrono::seconds(2); }
   const std::string& logPath() override { return log_path_; }
+  bool asyncLog() override { return false; }
   uint64_t restartEpoch() override { return 0; }
   std::chrono::milliseconds fileFlushIntervalMsec() override {
     return std::chrono::milliseconds(50);
@@ -53,6 +54,34 @@ public:
   const std::string& serviceZone() override { return service_zone_; }
   uint64_t maxStats() override { return 16384; }
   uint64_t maxObjNameLength() override { return 60; }
+  bool libeventBuffersEnabled() override { return true; }
+  bool reusePort() override { return false; }
+  bool balanceConnections() override { return false; }
+  uint32_t maxAcceptsPerWakeup() override { return 0; }
+  uint32_t maxAcceptsPerSecond() override { return 0; }
+  bool epollChangelistEnabled() override { return false; }
+  uint32_t maxDeferredDeletesPerIteration() override { return 0; }
+  bool coalesceWrites() override { return false; }
+  uint32_t tcpNotSentLowat() override { return 0; }
+  uint32_t privateKeyThreads() override { return 0; }
+  uint64_t sslSessionCacheSize() override { return 0; }
+  uint32_t tlsInitialRecordSize() override { return 0; }
+  bool kernelTlsEnabled() override { return false; }
+  bool lazyTlsCertificates() override { return false; }
+  bool tlsEarlyData() override { return false; }
+  bool threadLocalCounters() override { return false; }
+  uint32_t statsdUdpMaxDatagramSize() override { return 0; }
+  uint32_t statsFullFlushEvery() override { return 0; }
+  std::chrono::milliseconds dnsCacheDuration() override { return std::chrono::milliseconds(0); }
+  uint32_t ratelimitLeaseSize() override { return 0; }
+  std::chrono::milliseconds ratelimitLeaseDuration() override {
+    return std::chrono::milliseconds(1000);
+  }
+  bool dedicatedHealthCheckThread() override { return false; }
+  bool dedicatedXdsThread() override { return false; }
+  const std::vector<uint32_t>& workerCpus() override { return worker_cpus_; }
+  const std::string& xdsCachePath() override { return xds_cache_path_; }
+  uint32_t validationThreads() override { return 1; }
 
 private:
   const std::string config_path_;
@@ -62,6 +91,8 @@ private:
   const std::string service_node_name_;
   const std::string service_zone_;
   const std::string log_path_;
+  const std::vector<uint32_t> worker_cpus_;
+  const std::string xds_cache_path_;
 };
 
 class TestDrainManager : public DrainManager {
@@ -162,6 +193,10 @@ public:
     std::unique_lock<std::mutex> lock(lock_);
     return store_.gauges();
   }
+  std::list<ParentHistogramSharedPtr> histograms() const override {
+    std::unique_lock<std::mutex> lock(lock_);
+    return store_.histograms();
+  }
 
   // Stats::StoreRoot
   void addSink(Sink&) override {}
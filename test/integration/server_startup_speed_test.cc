@@ -0,0 +1,98 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "common/protobuf/utility.h"
+
+#include "test/integration/http_integration.h"
+
+#include "benchmark/benchmark.h"
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace {
+
+/**
+ * A server whose bootstrap has a number of static clusters, listeners and routes, the first
+ * route table being shared by all the listeners. The clusters are never connected to.
+ */
+class StartupServer : public HttpIntegrationTest {
+public:
+  StartupServer(uint32_t clusters, uint32_t listeners, uint32_t routes)
+      : HttpIntegrationTest(Http::CodecClient::Type::HTTP1, Network::Address::IpVersion::v4),
+        clusters_(clusters), listeners_(listeners) {
+    SetUp();
+    config_helper_.addConfigModifier(
+        [clusters, routes](envoy::api::v2::filter::network::HttpConnectionManager& hcm) -> void {
+          auto* virtual_host = hcm.mutable_route_config()->mutable_virtual_hosts(0);
+          for (uint32_t i = 1; i < routes; i++) {
+            auto* route = virtual_host->add_routes();
+            route->mutable_match()->set_prefix(fmt::format("/route/{}/", i));
+            route->mutable_route()->set_cluster(fmt::format("cluster_{}", i % clusters));
+          }
+        });
+    config_helper_.addConfigModifier(
+        [clusters, listeners](envoy::api::v2::Bootstrap& bootstrap) -> void {
+          auto* static_resources = bootstrap.mutable_static_resources();
+          for (uint32_t i = 1; i < clusters; i++) {
+            auto* cluster = static_resources->add_clusters();
+            cluster->MergeFrom(static_resources->clusters(0));
+            cluster->set_name(fmt::format("cluster_{}", i));
+          }
+          for (uint32_t i = 1; i < listeners; i++) {
+            auto* listener = static_resources->add_listeners();
+            listener->MergeFrom(static_resources->listeners(0));
+            listener->set_name(fmt::format("listener_{}", i));
+          }
+        });
+  }
+
+  ~StartupServer() { test_server_.reset(); }
+
+  /**
+   * Start the server and wait for all of its listeners.
+   * @return std::chrono::duration<double> the time taken from the start of the server, which
+   *         excludes writing its bootstrap.
+   */
+  std::chrono::duration<double> start() {
+    BaseIntegrationTest::initialize();
+    config_helper_.finalize(std::vector<uint32_t>(clusters_, 10000));
+    const std::string bootstrap_path = TestEnvironment::writeStringToFileForTest(
+        "bootstrap.json", MessageUtil::getJsonStringFromMessage(config_helper_.bootstrap()));
+
+    const auto start = std::chrono::steady_clock::now();
+    createGeneratedApiTestServer(bootstrap_path, {"http"});
+    test_server_->waitForCounterGe("listener_manager.listener_create_success", listeners_);
+    return std::chrono::steady_clock::now() - start;
+  }
+
+private:
+  const uint32_t clusters_;
+  const uint32_t listeners_;
+};
+
+// The time for a server to load its bootstrap of range(0) clusters, range(1) listeners and
+// range(2) routes, and to start all of its listeners.
+static void ServerStartup(benchmark::State& state) {
+  TestEnvironment::initializeStandalone("server_startup_speed_test");
+  while (state.KeepRunning()) {
+    StartupServer server(state.range(0), state.range(1), state.range(2));
+    state.SetIterationTime(server.start().count());
+  }
+}
+BENCHMARK(ServerStartup)
+    ->Args({1, 1, 1})
+    ->Args({1000, 1, 1})
+    ->Args({10000, 1, 1})
+    ->Args({1, 10, 1})
+    ->Args({1, 100, 1})
+    ->Args({1, 1, 1000})
+    ->Args({1, 1, 10000})
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace Envoy
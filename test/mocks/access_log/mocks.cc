@@ -24,6 +24,7 @@ MockRequestInfo::MockRequestInfo() {
   ON_CALL(*this, startTime()).WillByDefault(Return(start_time_));
   ON_CALL(*this, requestReceivedDuration()).WillByDefault(ReturnRef(request_received_duration_));
   ON_CALL(*this, responseReceivedDuration()).WillByDefault(ReturnRef(response_received_duration_));
+  ON_CALL(*this, filterTimings()).WillByDefault(ReturnRef(filter_timings_));
 }
 
 MockRequestInfo::~MockRequestInfo() {}
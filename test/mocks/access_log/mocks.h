@@ -60,12 +60,14 @@ public:
   MOCK_CONST_METHOD0(healthCheck, bool());
   MOCK_METHOD1(healthCheck, void(bool is_hc));
   MOCK_CONST_METHOD0(getDownstreamAddress, const std::string&());
+  MOCK_CONST_METHOD0(filterTimings, const std::string&());
 
   std::shared_ptr<testing::NiceMock<Upstream::MockHostDescription>> host_{
       new testing::NiceMock<Upstream::MockHostDescription>()};
   SystemTime start_time_;
   Optional<std::chrono::microseconds> request_received_duration_;
   Optional<std::chrono::microseconds> response_received_duration_;
+  std::string filter_timings_;
 };
 
 } // namespace AccessLog
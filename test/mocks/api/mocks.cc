@@ -3,13 +3,25 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::Invoke;
 using testing::Return;
 using testing::_;
 
 namespace Envoy {
 namespace Api {
 
-MockApi::MockApi() { ON_CALL(*this, createFile(_, _, _, _)).WillByDefault(Return(file_)); }
+MockApi::MockApi() {
+  ON_CALL(*this, createFile(_, _, _, _)).WillByDefault(Return(file_));
+  // Run the work and its completion inline.
+  ON_CALL(*this, runOnThreadPool(_, _, _))
+      .WillByDefault(Invoke([](std::function<void()> work, Event::Dispatcher&,
+                               std::function<void()> on_complete) -> void {
+        work();
+        if (on_complete) {
+          on_complete();
+        }
+      }));
+}
 
 MockApi::~MockApi() {}
 
@@ -37,5 +49,15 @@ ssize_t MockOsSysCalls::write(int fd, const void* buffer, size_t num_bytes) {
   return result;
 }
 
+ssize_t MockOsSysCalls::writev(int fd, const iovec* iov, int iovcnt) {
+  // Gathered writes are seen by the expectations as a single write of all of the data.
+  std::string data;
+  for (int i = 0; i < iovcnt; i++) {
+    data.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+  }
+
+  return write(fd, data.data(), data.size());
+}
+
 } // namespace Api
 } // namespace Envoy
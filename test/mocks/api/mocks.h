@@ -32,6 +32,9 @@ public:
                                          Thread::BasicLockable& lock, Stats::Store& stats_store));
   MOCK_METHOD1(fileExists, bool(const std::string& path));
   MOCK_METHOD1(fileReadToEnd, std::string(const std::string& path));
+  MOCK_METHOD3(runOnThreadPool, void(std::function<void()> work, Event::Dispatcher& dispatcher,
+                                     std::function<void()> on_complete));
+  MOCK_METHOD0(shutdownThreadPool, void());
 
   std::shared_ptr<Filesystem::MockFile> file_{new Filesystem::MockFile()};
 };
@@ -43,6 +46,7 @@ public:
 
   // Api::OsSysCalls
   ssize_t write(int fd, const void* buffer, size_t num_bytes) override;
+  ssize_t writev(int fd, const iovec* iov, int iovcnt) override;
   int open(const std::string& full_path, int flags, int mode) override;
   MOCK_METHOD3(bind, int(int sockfd, const sockaddr* addr, socklen_t addrlen));
   MOCK_METHOD1(close, int(int));
@@ -65,7 +65,14 @@ public:
         createSslListener_(conn_handler, ssl_ctx, socket, cb, scope, listener_options)};
   }
 
+  Network::UdpListenerPtr createUdpListener(Network::ListenSocket& socket,
+                                            Network::UdpListenerCallbacks& cb,
+                                            Stats::Scope& scope) override {
+    return Network::UdpListenerPtr{createUdpListener_(socket, cb, scope)};
+  }
+
   TimerPtr createTimer(TimerCb cb) override { return TimerPtr{createTimer_(cb)}; }
+  TimerPtr createCoarseTimer(TimerCb cb) override { return TimerPtr{createTimer_(cb)}; }
 
   void deferredDelete(DeferredDeletablePtr&& to_delete) override {
     deferredDelete_(to_delete);
@@ -103,13 +110,19 @@ public:
                                   Ssl::ServerContext& ssl_ctx, Network::ListenSocket& socket,
                                   Network::ListenerCallbacks& cb, Stats::Scope& scope,
                                   const Network::ListenerOptions& listener_options));
+  MOCK_METHOD3(createUdpListener_,
+               Network::UdpListener*(Network::ListenSocket& socket,
+                                     Network::UdpListenerCallbacks& cb, Stats::Scope& scope));
   MOCK_METHOD1(createTimer_, Timer*(TimerCb cb));
   MOCK_METHOD1(deferredDelete_, void(DeferredDeletablePtr& to_delete));
   MOCK_METHOD0(exit, void());
   MOCK_METHOD2(listenForSignal_, SignalEvent*(int signal_num, SignalCb cb));
   MOCK_METHOD1(post, void(std::function<void()> callback));
   MOCK_METHOD1(run, void(RunType type));
+  MOCK_METHOD2(initializeStats, void(Stats::Scope& scope, const std::string& prefix));
   Buffer::WatermarkFactory& getWatermarkFactory() override { return *buffer_factory_; }
+  MonotonicTime approximateMonotonicTime() override { return std::chrono::steady_clock::now(); }
+  SystemTime approximateSystemTime() override { return std::chrono::system_clock::now(); }
 
 private:
   std::list<DeferredDeletablePtr> to_delete_;
@@ -163,7 +163,13 @@ namespace ConnectionPool {
 MockCancellable::MockCancellable() {}
 MockCancellable::~MockCancellable() {}
 
-MockInstance::MockInstance() {}
+MockInstance::MockInstance() {
+  ON_CALL(*this, newPipelinableStream(_, _))
+      .WillByDefault(Invoke([this](Http::StreamDecoder& response_decoder,
+                                   Http::ConnectionPool::Callbacks& callbacks) -> Cancellable* {
+        return newStream(response_decoder, callbacks);
+      }));
+}
 MockInstance::~MockInstance() {}
 
 } // namespace ConnectionPool
@@ -164,6 +164,9 @@ public:
   MOCK_METHOD0(onUnderlyingConnectionAboveWriteBufferHighWatermark, void());
   MOCK_METHOD0(onUnderlyingConnectionBelowWriteBufferLowWatermark, void());
 
+  // Http::ServerConnection
+  MOCK_METHOD0(idle, bool());
+
   Protocol protocol_{Protocol::Http11};
 };
 
@@ -386,6 +389,8 @@ public:
   MOCK_METHOD2(onData, void(Buffer::Instance& data, bool end_stream));
   MOCK_METHOD1(onTrailers_, void(HeaderMap& headers));
   MOCK_METHOD0(onReset, void());
+  MOCK_METHOD0(onAboveWriteBufferHighWatermark, void());
+  MOCK_METHOD0(onBelowWriteBufferLowWatermark, void());
 };
 
 class MockAsyncClientRequest : public AsyncClient::Request {
@@ -451,6 +456,8 @@ public:
   MOCK_METHOD0(closeConnections, void());
   MOCK_METHOD2(newStream, Cancellable*(Http::StreamDecoder& response_decoder,
                                        Http::ConnectionPool::Callbacks& callbacks));
+  MOCK_METHOD2(newPipelinableStream, Cancellable*(Http::StreamDecoder& response_decoder,
+                                                  Http::ConnectionPool::Callbacks& callbacks));
 
   std::shared_ptr<testing::NiceMock<Upstream::MockHostDescription>> host_{
       new testing::NiceMock<Upstream::MockHostDescription>()};
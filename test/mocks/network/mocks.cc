@@ -68,6 +68,7 @@ template <class T> static void initializeMockConnection(T& connection) {
   ON_CALL(connection, localAddress()).WillByDefault(ReturnPointee(connection.local_address_));
   ON_CALL(connection, id()).WillByDefault(Return(connection.next_id_));
   ON_CALL(connection, state()).WillByDefault(ReturnPointee(&connection.state_));
+  ON_CALL(connection, bufferAccount()).WillByDefault(ReturnRef(connection.buffer_account_));
 
   // The real implementation will move the buffer data into the socket.
   ON_CALL(connection, write(_)).WillByDefault(Invoke([](Buffer::Instance& buffer) -> void {
@@ -129,6 +130,9 @@ MockFilter::~MockFilter() {}
 MockListenerCallbacks::MockListenerCallbacks() {}
 MockListenerCallbacks::~MockListenerCallbacks() {}
 
+MockUdpListenerCallbacks::MockUdpListenerCallbacks() {}
+MockUdpListenerCallbacks::~MockUdpListenerCallbacks() {}
+
 MockDrainDecision::MockDrainDecision() {}
 MockDrainDecision::~MockDrainDecision() {}
 
@@ -147,5 +151,10 @@ MockListener::~MockListener() { onDestroy(); }
 MockConnectionHandler::MockConnectionHandler() {}
 MockConnectionHandler::~MockConnectionHandler() {}
 
+MockTransportSocketCallbacks::MockTransportSocketCallbacks() {
+  ON_CALL(*this, connection()).WillByDefault(ReturnRef(connection_));
+}
+MockTransportSocketCallbacks::~MockTransportSocketCallbacks() {}
+
 } // namespace Network
 } // namespace Envoy
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <list>
 #include <string>
@@ -7,6 +8,7 @@
 #include "envoy/network/connection.h"
 #include "envoy/network/drain_decision.h"
 #include "envoy/network/filter.h"
+#include "envoy/network/transport_socket.h"
 
 #include "test/mocks/event/mocks.h"
 #include "test/test_common/printers.h"
@@ -42,6 +44,7 @@ public:
   Address::InstanceConstSharedPtr local_address_;
   bool read_enabled_{true};
   Connection::State state_{Connection::State::Open};
+  Buffer::AccountSharedPtr buffer_account_;
 };
 
 class MockConnection : public Connection, public MockConnectionBase {
@@ -72,8 +75,11 @@ public:
   MOCK_METHOD1(write, void(Buffer::Instance& data));
   MOCK_METHOD1(setBufferLimits, void(uint32_t limit));
   MOCK_CONST_METHOD0(bufferLimit, uint32_t());
+  MOCK_METHOD1(setBufferAccount, void(Buffer::AccountSharedPtr account));
+  MOCK_CONST_METHOD0(bufferAccount, const Buffer::AccountSharedPtr&());
   MOCK_CONST_METHOD0(usingOriginalDst, bool());
   MOCK_CONST_METHOD0(aboveHighWatermark, bool());
+  MOCK_METHOD2(spliceTo, bool(Connection& peer, SpliceCb cb));
 };
 
 /**
@@ -108,11 +114,16 @@ public:
   MOCK_METHOD1(write, void(Buffer::Instance& data));
   MOCK_METHOD1(setBufferLimits, void(uint32_t limit));
   MOCK_CONST_METHOD0(bufferLimit, uint32_t());
+  MOCK_METHOD1(setBufferAccount, void(Buffer::AccountSharedPtr account));
+  MOCK_CONST_METHOD0(bufferAccount, const Buffer::AccountSharedPtr&());
   MOCK_CONST_METHOD0(usingOriginalDst, bool());
   MOCK_CONST_METHOD0(aboveHighWatermark, bool());
+  MOCK_METHOD2(spliceTo, bool(Connection& peer, SpliceCb cb));
 
   // Network::ClientConnection
   MOCK_METHOD0(connect, void());
+  MOCK_METHOD2(setFallbackAddress,
+               void(Address::InstanceConstSharedPtr address, std::chrono::milliseconds delay));
 };
 
 class MockActiveDnsQuery : public ActiveDnsQuery {
@@ -190,9 +201,20 @@ public:
 
   void onNewConnection(ConnectionPtr&& conn) override { onNewConnection_(conn); }
 
+  MOCK_METHOD4(onAccept,
+               bool(int fd, Address::InstanceConstSharedPtr remote_address,
+                    Address::InstanceConstSharedPtr local_address, bool using_original_dst));
   MOCK_METHOD1(onNewConnection_, void(ConnectionPtr& conn));
 };
 
+class MockUdpListenerCallbacks : public UdpListenerCallbacks {
+public:
+  MockUdpListenerCallbacks();
+  ~MockUdpListenerCallbacks();
+
+  MOCK_METHOD1(onData, void(UdpRecvData& data));
+};
+
 class MockDrainDecision : public DrainDecision {
 public:
   MockDrainDecision();
@@ -226,6 +248,9 @@ public:
   MockListener();
   ~MockListener();
 
+  MOCK_METHOD4(createConnection,
+               void(int fd, Address::InstanceConstSharedPtr remote_address,
+                    Address::InstanceConstSharedPtr local_address, bool using_original_dst));
   MOCK_METHOD0(onDestroy, void());
 };
 
@@ -246,10 +271,26 @@ public:
   MOCK_METHOD1(findListenerByAddress,
                Network::Listener*(const Network::Address::Instance& address));
   MOCK_METHOD1(removeListeners, void(uint64_t listener_tag));
+  MOCK_METHOD2(removeListenersWhenIdle,
+               void(uint64_t listener_tag, std::function<void()> completion));
   MOCK_METHOD1(stopListeners, void(uint64_t listener_tag));
   MOCK_METHOD0(stopListeners, void());
 };
 
+class MockTransportSocketCallbacks : public TransportSocketCallbacks {
+public:
+  MockTransportSocketCallbacks();
+  ~MockTransportSocketCallbacks();
+
+  MOCK_METHOD0(fd, int());
+  MOCK_METHOD0(connection, Network::Connection&());
+  MOCK_METHOD0(shouldDrainReadBuffer, bool());
+  MOCK_METHOD0(setReadBufferReady, void());
+  MOCK_METHOD1(raiseEvent, void(ConnectionEvent event));
+
+  testing::NiceMock<MockConnection> connection_;
+};
+
 class MockResolvedAddress : public Address::Instance {
 public:
   MockResolvedAddress(const std::string& logical, const std::string& physical)
@@ -53,6 +53,7 @@ public:
   MOCK_METHOD1(addConnectionCallbacks, void(Network::ConnectionCallbacks& callbacks));
   MOCK_METHOD0(close, void());
   MOCK_METHOD2(makeRequest, PoolRequest*(const RespValue& request, PoolCallbacks& callbacks));
+  MOCK_CONST_METHOD0(outstandingRequests, uint64_t());
 
   std::list<Network::ConnectionCallbacks*> callbacks_;
 };
@@ -83,6 +84,11 @@ public:
 
   MOCK_METHOD3(makeRequest, PoolRequest*(const std::string& hash_key, const RespValue& request,
                                          PoolCallbacks& callbacks));
+  MOCK_METHOD1(chooseHost, Upstream::HostConstSharedPtr(const std::string& hash_key));
+  MOCK_METHOD1(hashSlot, Optional<uint16_t>(const std::string& hash_key));
+  MOCK_METHOD3(makeRequestToHost,
+               PoolRequest*(const Upstream::HostConstSharedPtr& host, const RespValue& request,
+                            PoolCallbacks& callbacks));
 };
 
 } // namespace ConnPool
@@ -2,6 +2,8 @@
 
 #include <chrono>
 
+#include "common/http/header_map_impl.h"
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -17,6 +19,37 @@ namespace Router {
 MockRedirectEntry::MockRedirectEntry() {}
 MockRedirectEntry::~MockRedirectEntry() {}
 
+bool TestCorsPolicy::allowsOrigin(const Http::HeaderString& origin) const {
+  for (const auto& o : allow_origin_) {
+    if (o == "*" || origin == o.c_str()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+const Http::HeaderMap& TestCorsPolicy::preflightHeaders() const {
+  preflight_headers_.reset(new Http::HeaderMapImpl());
+  preflight_headers_->insertStatus().value(200);
+  preflight_headers_->insertAccessControlAllowOrigin();
+  if (allow_credentials_.valid() && allow_credentials_.value()) {
+    preflight_headers_->insertAccessControlAllowCredentials().value(std::string("true"));
+  }
+  if (!allow_methods_.empty()) {
+    preflight_headers_->insertAccessControlAllowMethods().value(allow_methods_);
+  }
+  if (!allow_headers_.empty()) {
+    preflight_headers_->insertAccessControlAllowHeaders().value(allow_headers_);
+  }
+  if (!expose_headers_.empty()) {
+    preflight_headers_->insertAccessControlExposeHeaders().value(expose_headers_);
+  }
+  if (!max_age_.empty()) {
+    preflight_headers_->insertAccessControlMaxAge().value(max_age_);
+  }
+  return *preflight_headers_;
+}
+
 MockRetryState::MockRetryState() {}
 
 void MockRetryState::expectRetry() {
@@ -39,6 +72,9 @@ MockRateLimitPolicy::MockRateLimitPolicy() {
 
 MockRateLimitPolicy::~MockRateLimitPolicy() {}
 
+MockShadowStream::MockShadowStream() {}
+MockShadowStream::~MockShadowStream() {}
+
 MockShadowWriter::MockShadowWriter() {}
 MockShadowWriter::~MockShadowWriter() {}
 
@@ -57,6 +93,7 @@ MockMetadataMatchCriteria::~MockMetadataMatchCriteria() {}
 
 MockRouteEntry::MockRouteEntry() {
   ON_CALL(*this, clusterName()).WillByDefault(ReturnRef(cluster_name_));
+  ON_CALL(*this, clusterHandle()).WillByDefault(Return(Optional<uint32_t>()));
   ON_CALL(*this, opaqueConfig()).WillByDefault(ReturnRef(opaque_config_));
   ON_CALL(*this, rateLimitPolicy()).WillByDefault(ReturnRef(rate_limit_policy_));
   ON_CALL(*this, retryPolicy()).WillByDefault(ReturnRef(retry_policy_));
@@ -72,6 +109,7 @@ MockRouteEntry::~MockRouteEntry() {}
 MockConfig::MockConfig() : route_(new NiceMock<MockRoute>()) {
   ON_CALL(*this, route(_, _)).WillByDefault(Return(route_));
   ON_CALL(*this, internalOnlyHeaders()).WillByDefault(ReturnRef(internal_only_headers_));
+  ON_CALL(*this, routeKeyHeaders()).WillByDefault(Return(nullptr));
 }
 
 MockConfig::~MockConfig() {}
@@ -47,6 +47,8 @@ public:
   const std::string& maxAge() const override { return max_age_; };
   const Optional<bool>& allowCredentials() const override { return allow_credentials_; };
   bool enabled() const override { return enabled_; };
+  bool allowsOrigin(const Http::HeaderString& origin) const override;
+  const Http::HeaderMap& preflightHeaders() const override;
 
   std::list<std::string> allow_origin_{};
   std::string allow_methods_{};
@@ -55,6 +57,8 @@ public:
   std::string max_age_{};
   Optional<bool> allow_credentials_{};
   bool enabled_{false};
+  // Rebuilt from the fields above on each call, as tests change them at will.
+  mutable Http::HeaderMapPtr preflight_headers_;
 };
 
 class TestRetryPolicy : public RetryPolicy {
@@ -126,6 +130,17 @@ public:
   std::string runtime_key_;
 };
 
+class MockShadowStream : public ShadowStream {
+public:
+  MockShadowStream();
+  ~MockShadowStream();
+
+  // Router::ShadowStream
+  MOCK_METHOD2(sendData, void(const Buffer::Instance& data, bool end_stream));
+  MOCK_METHOD1(sendTrailers, void(const Http::HeaderMap& trailers));
+  MOCK_METHOD0(reset, void());
+};
+
 class MockShadowWriter : public ShadowWriter {
 public:
   MockShadowWriter();
@@ -139,6 +154,9 @@ public:
 
   MOCK_METHOD3(shadow_, void(const std::string& cluster, Http::MessagePtr& request,
                              std::chrono::milliseconds timeout));
+  MOCK_METHOD4(streamShadow,
+               ShadowStream*(const std::string& cluster, const Http::HeaderMap& headers,
+                             std::chrono::milliseconds timeout, uint32_t buffer_limit));
 };
 
 class TestVirtualCluster : public VirtualCluster {
@@ -183,6 +201,7 @@ public:
   // Router::MetadataMatchCriteria
   MOCK_CONST_METHOD0(metadataMatchCriteria,
                      const std::vector<MetadataMatchCriterionConstSharedPtr>&());
+  MOCK_CONST_METHOD0(hash, std::size_t());
 };
 
 class MockRouteEntry : public RouteEntry {
@@ -192,6 +211,7 @@ public:
 
   // Router::Config
   MOCK_CONST_METHOD0(clusterName, const std::string&());
+  MOCK_CONST_METHOD0(clusterHandle, Optional<uint32_t>());
   MOCK_CONST_METHOD0(clusterNotFoundResponseCode, Http::Code());
   MOCK_CONST_METHOD2(finalizeRequestHeaders,
                      void(Http::HeaderMap& headers, const AccessLog::RequestInfo& request_info));
@@ -259,6 +279,7 @@ public:
   // Router::Config
   MOCK_CONST_METHOD2(route, RouteConstSharedPtr(const Http::HeaderMap&, uint64_t random_value));
   MOCK_CONST_METHOD0(internalOnlyHeaders, const std::list<Http::LowerCaseString>&());
+  MOCK_CONST_METHOD0(routeKeyHeaders, const std::vector<Http::LowerCaseString>*());
 
   std::shared_ptr<MockRoute> route_;
   std::list<Http::LowerCaseString> internal_only_headers_;
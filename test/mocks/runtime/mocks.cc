@@ -3,6 +3,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::Invoke;
 using testing::Return;
 using testing::ReturnArg;
 using testing::_;
@@ -10,7 +11,12 @@ using testing::_;
 namespace Envoy {
 namespace Runtime {
 
-MockRandomGenerator::MockRandomGenerator() { ON_CALL(*this, uuid()).WillByDefault(Return(uuid_)); }
+MockRandomGenerator::MockRandomGenerator() {
+  ON_CALL(*this, uuid()).WillByDefault(Return(uuid_));
+  ON_CALL(*this, uuid(_)).WillByDefault(Invoke([this](char* buffer) -> void {
+    uuid_.copy(buffer, UUID_LENGTH);
+  }));
+}
 
 MockRandomGenerator::~MockRandomGenerator() {}
 
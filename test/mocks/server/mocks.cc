@@ -26,8 +26,35 @@ MockOptions::MockOptions(const std::string& config_path)
   ON_CALL(*this, serviceNodeName()).WillByDefault(ReturnRef(service_node_name_));
   ON_CALL(*this, serviceZone()).WillByDefault(ReturnRef(service_zone_name_));
   ON_CALL(*this, logPath()).WillByDefault(ReturnRef(log_path_));
+  ON_CALL(*this, asyncLog()).WillByDefault(Return(false));
   ON_CALL(*this, maxStats()).WillByDefault(Return(1000));
   ON_CALL(*this, maxObjNameLength()).WillByDefault(Return(150));
+  ON_CALL(*this, libeventBuffersEnabled()).WillByDefault(Return(true));
+  ON_CALL(*this, reusePort()).WillByDefault(Return(false));
+  ON_CALL(*this, balanceConnections()).WillByDefault(Return(false));
+  ON_CALL(*this, maxAcceptsPerWakeup()).WillByDefault(Return(0));
+  ON_CALL(*this, maxAcceptsPerSecond()).WillByDefault(Return(0));
+  ON_CALL(*this, epollChangelistEnabled()).WillByDefault(Return(false));
+  ON_CALL(*this, maxDeferredDeletesPerIteration()).WillByDefault(Return(0));
+  ON_CALL(*this, coalesceWrites()).WillByDefault(Return(false));
+  ON_CALL(*this, tcpNotSentLowat()).WillByDefault(Return(0));
+  ON_CALL(*this, privateKeyThreads()).WillByDefault(Return(0));
+  ON_CALL(*this, sslSessionCacheSize()).WillByDefault(Return(0));
+  ON_CALL(*this, tlsInitialRecordSize()).WillByDefault(Return(0));
+  ON_CALL(*this, kernelTlsEnabled()).WillByDefault(Return(false));
+  ON_CALL(*this, lazyTlsCertificates()).WillByDefault(Return(false));
+  ON_CALL(*this, tlsEarlyData()).WillByDefault(Return(false));
+  ON_CALL(*this, threadLocalCounters()).WillByDefault(Return(false));
+  ON_CALL(*this, statsdUdpMaxDatagramSize()).WillByDefault(Return(0));
+  ON_CALL(*this, statsFullFlushEvery()).WillByDefault(Return(0));
+  ON_CALL(*this, dnsCacheDuration()).WillByDefault(Return(std::chrono::milliseconds(0)));
+  ON_CALL(*this, ratelimitLeaseSize()).WillByDefault(Return(0));
+  ON_CALL(*this, ratelimitLeaseDuration()).WillByDefault(Return(std::chrono::milliseconds(1000)));
+  ON_CALL(*this, dedicatedHealthCheckThread()).WillByDefault(Return(false));
+  ON_CALL(*this, dedicatedXdsThread()).WillByDefault(Return(false));
+  ON_CALL(*this, workerCpus()).WillByDefault(ReturnRef(worker_cpus_));
+  ON_CALL(*this, xdsCachePath()).WillByDefault(ReturnRef(xds_cache_path_));
+  ON_CALL(*this, validationThreads()).WillByDefault(Return(1));
 }
 MockOptions::~MockOptions() {}
 
@@ -39,6 +66,9 @@ MockDrainManager::MockDrainManager() {
 }
 MockDrainManager::~MockDrainManager() {}
 
+MockOverloadManager::MockOverloadManager() {}
+MockOverloadManager::~MockOverloadManager() {}
+
 MockWatchDog::MockWatchDog() {}
 MockWatchDog::~MockWatchDog() {}
 
@@ -52,7 +82,7 @@ MockHotRestart::~MockHotRestart() {}
 
 MockListenerComponentFactory::MockListenerComponentFactory()
     : socket_(std::make_shared<NiceMock<Network::MockListenSocket>>()) {
-  ON_CALL(*this, createListenSocket(_, _)).WillByDefault(Return(socket_));
+  ON_CALL(*this, createListenSocket(_, _, _, _)).WillByDefault(Return(socket_));
 }
 MockListenerComponentFactory::~MockListenerComponentFactory() {}
 
@@ -62,6 +92,8 @@ MockListenerManager::~MockListenerManager() {}
 MockListener::MockListener() {
   ON_CALL(*this, filterChainFactory()).WillByDefault(ReturnRef(filter_chain_factory_));
   ON_CALL(*this, socket()).WillByDefault(ReturnRef(socket_));
+  ON_CALL(*this, workerSocket(_)).WillByDefault(Return(&socket_));
+  ON_CALL(*this, bufferAccount()).WillByDefault(ReturnRef(buffer_account_));
   ON_CALL(*this, listenerScope()).WillByDefault(ReturnRef(scope_));
   ON_CALL(*this, name()).WillByDefault(ReturnRef(name_));
 }
@@ -82,6 +114,12 @@ MockWorker::MockWorker() {
         EXPECT_EQ(nullptr, remove_listener_completion_);
         remove_listener_completion_ = completion;
       }));
+
+  ON_CALL(*this, removeListenerWhenIdle(_, _))
+      .WillByDefault(Invoke([this](Listener&, std::function<void()> completion) -> void {
+        EXPECT_EQ(nullptr, remove_listener_completion_);
+        remove_listener_completion_ = completion;
+      }));
 }
 MockWorker::~MockWorker() {}
 
@@ -102,6 +140,7 @@ MockInstance::MockInstance()
   ON_CALL(*this, random()).WillByDefault(ReturnRef(random_));
   ON_CALL(*this, localInfo()).WillByDefault(ReturnRef(local_info_));
   ON_CALL(*this, options()).WillByDefault(ReturnRef(options_));
+  ON_CALL(*this, overloadManager()).WillByDefault(ReturnRef(overload_manager_));
   ON_CALL(*this, drainManager()).WillByDefault(ReturnRef(drain_manager_));
   ON_CALL(*this, initManager()).WillByDefault(ReturnRef(init_manager_));
   ON_CALL(*this, listenerManager()).WillByDefault(ReturnRef(listener_manager_));
@@ -129,6 +168,7 @@ MockFactoryContext::MockFactoryContext() : singleton_manager_(new Singleton::Man
   ON_CALL(*this, initManager()).WillByDefault(ReturnRef(init_manager_));
   ON_CALL(*this, localInfo()).WillByDefault(ReturnRef(local_info_));
   ON_CALL(*this, random()).WillByDefault(ReturnRef(random_));
+  ON_CALL(*this, overloadManager()).WillByDefault(ReturnRef(overload_manager_));
   ON_CALL(*this, runtime()).WillByDefault(ReturnRef(runtime_loader_));
   ON_CALL(*this, scope()).WillByDefault(ReturnRef(scope_));
   ON_CALL(*this, singletonManager()).WillByDefault(ReturnRef(*singleton_manager_));
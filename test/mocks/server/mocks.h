@@ -11,6 +11,7 @@
 #include "envoy/server/filter_config.h"
 #include "envoy/server/instance.h"
 #include "envoy/server/options.h"
+#include "envoy/server/overload_manager.h"
 #include "envoy/server/worker.h"
 #include "envoy/ssl/context_manager.h"
 
@@ -52,6 +53,7 @@ public:
   MOCK_METHOD0(drainTime, std::chrono::seconds());
   MOCK_METHOD0(logLevel, spdlog::level::level_enum());
   MOCK_METHOD0(logPath, const std::string&());
+  MOCK_METHOD0(asyncLog, bool());
   MOCK_METHOD0(parentShutdownTime, std::chrono::seconds());
   MOCK_METHOD0(restartEpoch, uint64_t());
   MOCK_METHOD0(fileFlushIntervalMsec, std::chrono::milliseconds());
@@ -61,6 +63,32 @@ public:
   MOCK_METHOD0(serviceZone, const std::string&());
   MOCK_METHOD0(maxStats, uint64_t());
   MOCK_METHOD0(maxObjNameLength, uint64_t());
+  MOCK_METHOD0(libeventBuffersEnabled, bool());
+  MOCK_METHOD0(reusePort, bool());
+  MOCK_METHOD0(balanceConnections, bool());
+  MOCK_METHOD0(maxAcceptsPerWakeup, uint32_t());
+  MOCK_METHOD0(maxAcceptsPerSecond, uint32_t());
+  MOCK_METHOD0(epollChangelistEnabled, bool());
+  MOCK_METHOD0(maxDeferredDeletesPerIteration, uint32_t());
+  MOCK_METHOD0(coalesceWrites, bool());
+  MOCK_METHOD0(tcpNotSentLowat, uint32_t());
+  MOCK_METHOD0(privateKeyThreads, uint32_t());
+  MOCK_METHOD0(sslSessionCacheSize, uint64_t());
+  MOCK_METHOD0(tlsInitialRecordSize, uint32_t());
+  MOCK_METHOD0(kernelTlsEnabled, bool());
+  MOCK_METHOD0(lazyTlsCertificates, bool());
+  MOCK_METHOD0(tlsEarlyData, bool());
+  MOCK_METHOD0(threadLocalCounters, bool());
+  MOCK_METHOD0(statsdUdpMaxDatagramSize, uint32_t());
+  MOCK_METHOD0(statsFullFlushEvery, uint32_t());
+  MOCK_METHOD0(dnsCacheDuration, std::chrono::milliseconds());
+  MOCK_METHOD0(ratelimitLeaseSize, uint32_t());
+  MOCK_METHOD0(ratelimitLeaseDuration, std::chrono::milliseconds());
+  MOCK_METHOD0(dedicatedHealthCheckThread, bool());
+  MOCK_METHOD0(dedicatedXdsThread, bool());
+  MOCK_METHOD0(workerCpus, const std::vector<uint32_t>&());
+  MOCK_METHOD0(xdsCachePath, const std::string&());
+  MOCK_METHOD0(validationThreads, uint32_t());
 
   std::string config_path_;
   bool v2_config_only_{};
@@ -69,6 +97,8 @@ public:
   std::string service_node_name_;
   std::string service_zone_name_;
   std::string log_path_;
+  std::vector<uint32_t> worker_cpus_;
+  std::string xds_cache_path_;
 };
 
 class MockAdmin : public Admin {
@@ -96,6 +126,16 @@ public:
   std::function<void()> drain_sequence_completion_;
 };
 
+class MockOverloadManager : public OverloadManager {
+public:
+  MockOverloadManager();
+  ~MockOverloadManager();
+
+  // Server::OverloadManager
+  MOCK_METHOD0(start, void());
+  MOCK_METHOD1(isActive, bool(OverloadActionType action));
+};
+
 class MockWatchDog : public WatchDog {
 public:
   MockWatchDog();
@@ -127,7 +167,8 @@ public:
 
   // Server::HotRestart
   MOCK_METHOD0(drainParentListeners, void());
-  MOCK_METHOD1(duplicateParentListenSocket, int(const std::string& address));
+  MOCK_METHOD2(duplicateParentListenSocket,
+               int(const std::string& address, uint32_t worker_index));
   MOCK_METHOD1(getParentStats, void(GetParentStatsInfo& info));
   MOCK_METHOD2(initialize, void(Event::Dispatcher& dispatcher, Server::Instance& server));
   MOCK_METHOD1(shutdownParentAdmin, void(ShutdownParentAdminInfo& info));
@@ -149,9 +190,10 @@ public:
                std::vector<Configuration::NetworkFilterFactoryCb>(
                    const Protobuf::RepeatedPtrField<envoy::api::v2::Filter>& filters,
                    Configuration::FactoryContext& context));
-  MOCK_METHOD2(createListenSocket,
+  MOCK_METHOD4(createListenSocket,
                Network::ListenSocketSharedPtr(Network::Address::InstanceConstSharedPtr address,
-                                              bool bind_to_port));
+                                              bool bind_to_port, bool reuse_port,
+                                              uint32_t worker_index));
   MOCK_METHOD1(createDrainManager_, DrainManager*(envoy::api::v2::Listener::DrainType drain_type));
   MOCK_METHOD0(nextListenerTag, uint64_t());
 
@@ -179,17 +221,23 @@ public:
 
   MOCK_METHOD0(filterChainFactory, Network::FilterChainFactory&());
   MOCK_METHOD0(socket, Network::ListenSocket&());
+  MOCK_METHOD1(workerSocket, Network::ListenSocket*(uint32_t worker_index));
   MOCK_METHOD0(defaultSslContext, Ssl::ServerContext*());
   MOCK_METHOD0(useProxyProto, bool());
   MOCK_METHOD0(bindToPort, bool());
   MOCK_METHOD0(useOriginalDst, bool());
   MOCK_METHOD0(perConnectionBufferLimitBytes, uint32_t());
+  MOCK_METHOD0(connectionBalancer, Network::ConnectionBalancerSharedPtr());
+  MOCK_METHOD0(bufferAccount, const Buffer::AccountSharedPtr&());
+  MOCK_METHOD0(maxAcceptsPerWakeup, uint32_t());
+  MOCK_METHOD0(maxAcceptsPerSecond, uint32_t());
   MOCK_METHOD0(listenerScope, Stats::Scope&());
   MOCK_METHOD0(listenerTag, uint64_t());
   MOCK_CONST_METHOD0(name, const std::string&());
 
   testing::NiceMock<Network::MockFilterChainFactory> filter_chain_factory_;
   testing::NiceMock<Network::MockListenSocket> socket_;
+  Buffer::AccountSharedPtr buffer_account_;
   Stats::IsolatedStoreImpl scope_;
   std::string name_;
 };
@@ -200,7 +248,7 @@ public:
   ~MockWorkerFactory();
 
   // Server::WorkerFactory
-  WorkerPtr createWorker() override { return WorkerPtr{createWorker_()}; }
+  WorkerPtr createWorker(uint32_t) override { return WorkerPtr{createWorker_()}; }
 
   MOCK_METHOD0(createWorker_, Worker*());
 };
@@ -226,6 +274,8 @@ public:
   MOCK_METHOD2(addListener, void(Listener& listener, AddListenerCompletion completion));
   MOCK_METHOD0(numConnections, uint64_t());
   MOCK_METHOD2(removeListener, void(Listener& listener, std::function<void()> completion));
+  MOCK_METHOD2(removeListenerWhenIdle,
+               void(Listener& listener, std::function<void()> completion));
   MOCK_METHOD1(start, void(GuardDog& guard_dog));
   MOCK_METHOD0(stop, void());
   MOCK_METHOD1(stopListener, void(Listener& listener));
@@ -261,6 +311,7 @@ public:
   MOCK_METHOD0(initManager, Init::Manager&());
   MOCK_METHOD0(listenerManager, ListenerManager&());
   MOCK_METHOD0(options, Options&());
+  MOCK_METHOD0(overloadManager, OverloadManager&());
   MOCK_METHOD0(random, Runtime::RandomGenerator&());
   MOCK_METHOD0(rateLimitClient_, RateLimit::Client*());
   MOCK_METHOD0(runtime, Runtime::Loader&());
@@ -290,6 +341,7 @@ public:
   testing::NiceMock<AccessLog::MockAccessLogManager> access_log_manager_;
   testing::NiceMock<MockHotRestart> hot_restart_;
   testing::NiceMock<MockOptions> options_;
+  testing::NiceMock<MockOverloadManager> overload_manager_;
   testing::NiceMock<Runtime::MockRandomGenerator> random_;
   testing::NiceMock<LocalInfo::MockLocalInfo> local_info_;
   testing::NiceMock<Init::MockManager> init_manager_;
@@ -338,6 +390,7 @@ public:
   MOCK_METHOD0(initManager, Init::Manager&());
   MOCK_METHOD0(localInfo, const LocalInfo::LocalInfo&());
   MOCK_METHOD0(random, Envoy::Runtime::RandomGenerator&());
+  MOCK_METHOD0(overloadManager, Server::OverloadManager&());
   MOCK_METHOD0(rateLimitClient_, RateLimit::Client*());
   MOCK_METHOD0(runtime, Envoy::Runtime::Loader&());
   MOCK_METHOD0(scope, Stats::Scope&());
@@ -354,6 +407,7 @@ public:
   testing::NiceMock<Init::MockManager> init_manager_;
   testing::NiceMock<LocalInfo::MockLocalInfo> local_info_;
   testing::NiceMock<Envoy::Runtime::MockRandomGenerator> random_;
+  testing::NiceMock<MockOverloadManager> overload_manager_;
   testing::NiceMock<Envoy::Runtime::MockLoader> runtime_loader_;
   Stats::IsolatedStoreImpl scope_;
   testing::NiceMock<ThreadLocal::MockInstance> thread_local_;
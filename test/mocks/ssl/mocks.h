@@ -53,6 +53,7 @@ public:
   MOCK_METHOD0(sha256PeerCertificateDigest, std::string());
   MOCK_CONST_METHOD0(subjectPeerCertificate, std::string());
   MOCK_METHOD0(uriSanPeerCertificate, std::string());
+  MOCK_CONST_METHOD0(lastReadEarlyData, bool());
 };
 
 class MockClientContext : public ClientContext {
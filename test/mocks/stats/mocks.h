@@ -43,6 +43,7 @@ public:
   MOCK_METHOD1(add, void(uint64_t amount));
   MOCK_METHOD0(dec, void());
   MOCK_METHOD0(inc, void());
+  MOCK_METHOD0(latchChanged, bool());
   MOCK_CONST_METHOD0(name, const std::string&());
   MOCK_CONST_METHOD0(tagExtractedName, const std::string&());
   MOCK_CONST_METHOD0(tags, const std::vector<Tag>&());
@@ -77,8 +78,10 @@ public:
   ~MockSink();
 
   MOCK_METHOD0(beginFlush, void());
+  MOCK_CONST_METHOD0(changedStatsOnly, bool());
   MOCK_METHOD2(flushCounter, void(const Counter& counter, uint64_t delta));
   MOCK_METHOD2(flushGauge, void(const Gauge& gauge, uint64_t value));
+  MOCK_METHOD1(flushHistogram, void(const ParentHistogram& histogram));
   MOCK_METHOD0(endFlush, void());
   MOCK_METHOD2(onHistogramComplete, void(const Histogram& histogram, uint64_t value));
 };
@@ -97,6 +100,7 @@ public:
   MOCK_METHOD1(gauge, Gauge&(const std::string&));
   MOCK_CONST_METHOD0(gauges, std::list<GaugeSharedPtr>());
   MOCK_METHOD1(histogram, Histogram&(const std::string& name));
+  MOCK_CONST_METHOD0(histograms, std::list<ParentHistogramSharedPtr>());
 
   testing::NiceMock<MockCounter> counter_;
   std::vector<std::unique_ptr<MockHistogram>> histograms_;
@@ -31,8 +31,17 @@ MockClusterInfo::MockClusterInfo()
   ON_CALL(*this, http2Settings()).WillByDefault(ReturnRef(http2_settings_));
   ON_CALL(*this, maxRequestsPerConnection())
       .WillByDefault(ReturnPointee(&max_requests_per_connection_));
+  ON_CALL(*this, http2ConnectionsPerHost())
+      .WillByDefault(ReturnPointee(&http2_connections_per_host_));
+  ON_CALL(*this, http1PrefetchPercent()).WillByDefault(ReturnPointee(&http1_prefetch_percent_));
+  ON_CALL(*this, http1MinIdleConnections())
+      .WillByDefault(ReturnPointee(&http1_min_idle_connections_));
+  ON_CALL(*this, http1IdleTimeout()).WillByDefault(ReturnPointee(&http1_idle_timeout_));
+  ON_CALL(*this, http1MaxPipelinedRequests())
+      .WillByDefault(ReturnPointee(&http1_max_pipelined_requests_));
   ON_CALL(*this, stats()).WillByDefault(ReturnRef(stats_));
   ON_CALL(*this, statsScope()).WillByDefault(ReturnRef(stats_store_));
+  ON_CALL(*this, codeStats()).WillByDefault(ReturnRef(code_stats_));
   ON_CALL(*this, loadReportStats()).WillByDefault(ReturnRef(load_report_stats_));
   ON_CALL(*this, sourceAddress()).WillByDefault(ReturnRef(source_address_));
   ON_CALL(*this, resourceManager(_))
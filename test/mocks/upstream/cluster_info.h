@@ -8,6 +8,8 @@
 #include "envoy/upstream/cluster_manager.h"
 #include "envoy/upstream/upstream.h"
 
+#include "common/http/codes.h"
+
 #include "test/mocks/runtime/mocks.h"
 #include "test/mocks/stats/mocks.h"
 
@@ -50,11 +52,17 @@ public:
                      const Optional<envoy::api::v2::Cluster::RingHashLbConfig>&());
   MOCK_CONST_METHOD0(maintenanceMode, bool());
   MOCK_CONST_METHOD0(maxRequestsPerConnection, uint64_t());
+  MOCK_CONST_METHOD0(http2ConnectionsPerHost, uint32_t());
+  MOCK_CONST_METHOD0(http1PrefetchPercent, uint32_t());
+  MOCK_CONST_METHOD0(http1MinIdleConnections, uint32_t());
+  MOCK_CONST_METHOD0(http1IdleTimeout, std::chrono::milliseconds());
+  MOCK_CONST_METHOD0(http1MaxPipelinedRequests, uint32_t());
   MOCK_CONST_METHOD0(name, const std::string&());
   MOCK_CONST_METHOD1(resourceManager, ResourceManager&(ResourcePriority priority));
   MOCK_CONST_METHOD0(sslContext, Ssl::ClientContext*());
   MOCK_CONST_METHOD0(stats, ClusterStats&());
   MOCK_CONST_METHOD0(statsScope, Stats::Scope&());
+  MOCK_CONST_METHOD0(codeStats, Http::CodeStats&());
   MOCK_CONST_METHOD0(loadReportStats, ClusterLoadReportStats&());
   MOCK_CONST_METHOD0(sourceAddress, const Network::Address::InstanceConstSharedPtr&());
   MOCK_CONST_METHOD0(lbSubsetInfo, const LoadBalancerSubsetInfo&());
@@ -62,8 +70,14 @@ public:
   std::string name_{"fake_cluster"};
   Http::Http2Settings http2_settings_{};
   uint64_t max_requests_per_connection_{};
+  uint32_t http2_connections_per_host_{1};
+  uint32_t http1_prefetch_percent_{100};
+  uint32_t http1_min_idle_connections_{};
+  std::chrono::milliseconds http1_idle_timeout_{};
+  uint32_t http1_max_pipelined_requests_{1};
   NiceMock<Stats::MockIsolatedStatsStore> stats_store_;
   ClusterStats stats_;
+  Http::CodeStatsImpl code_stats_{stats_store_};
   NiceMock<Stats::MockIsolatedStatsStore> load_report_stats_store_;
   ClusterLoadReportStats load_report_stats_;
   NiceMock<Runtime::MockLoader> runtime_;
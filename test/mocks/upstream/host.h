@@ -70,6 +70,15 @@ public:
   MOCK_METHOD0(setUnhealthy, void());
 };
 
+class MockLatencyEstimator : public LatencyEstimator {
+public:
+  MockLatencyEstimator();
+  ~MockLatencyEstimator();
+
+  MOCK_METHOD2(putLatency, void(std::chrono::microseconds latency, MonotonicTime now));
+  MOCK_CONST_METHOD1(peakEwma, double(MonotonicTime now));
+};
+
 class MockHostDescription : public HostDescription {
 public:
   MockHostDescription();
@@ -81,6 +90,7 @@ public:
   MOCK_CONST_METHOD0(cluster, const ClusterInfo&());
   MOCK_CONST_METHOD0(outlierDetector, Outlier::DetectorHostMonitor&());
   MOCK_CONST_METHOD0(healthChecker, HealthCheckHostMonitor&());
+  MOCK_CONST_METHOD0(latencyEstimator, LatencyEstimator&());
   MOCK_CONST_METHOD0(hostname, const std::string&());
   MOCK_CONST_METHOD0(stats, HostStats&());
   MOCK_CONST_METHOD0(locality, const envoy::api::v2::Locality&());
@@ -89,6 +99,7 @@ public:
   Network::Address::InstanceConstSharedPtr address_;
   testing::NiceMock<Outlier::MockDetectorHostMonitor> outlier_detector_;
   testing::NiceMock<MockHealthCheckHostMonitor> health_checker_;
+  testing::NiceMock<MockLatencyEstimator> latency_estimator_;
   testing::NiceMock<MockClusterInfo> cluster_;
   Stats::IsolatedStoreImpl stats_store_;
   HostStats stats_{ALL_HOST_STATS(POOL_COUNTER(stats_store_), POOL_GAUGE(stats_store_))};
@@ -130,6 +141,7 @@ public:
   MOCK_METHOD1(healthFlagSet, void(HealthFlag flag));
   MOCK_CONST_METHOD0(healthy, bool());
   MOCK_CONST_METHOD0(hostname, const std::string&());
+  MOCK_CONST_METHOD0(latencyEstimator, LatencyEstimator&());
   MOCK_CONST_METHOD0(outlierDetector, Outlier::DetectorHostMonitor&());
   MOCK_METHOD1(setHealthChecker_, void(HealthCheckHostMonitorPtr& health_checker));
   MOCK_METHOD1(setOutlierDetector_, void(Outlier::DetectorHostMonitorPtr& outlier_detector));
@@ -138,10 +150,14 @@ public:
   MOCK_METHOD1(weight, void(uint32_t new_weight));
   MOCK_CONST_METHOD0(used, bool());
   MOCK_METHOD1(used, void(bool new_used));
+  MOCK_CONST_METHOD0(slowStartTime, MonotonicTime());
+  MOCK_METHOD1(slowStartTime, void(MonotonicTime time));
+  MOCK_CONST_METHOD0(index, uint32_t());
   MOCK_CONST_METHOD0(locality, const envoy::api::v2::Locality&());
 
   testing::NiceMock<MockClusterInfo> cluster_;
   testing::NiceMock<Outlier::MockDetectorHostMonitor> outlier_detector_;
+  testing::NiceMock<MockLatencyEstimator> latency_estimator_;
   Stats::IsolatedStoreImpl stats_store_;
   HostStats stats_{ALL_HOST_STATS(POOL_COUNTER(stats_store_), POOL_GAUGE(stats_store_))};
 };
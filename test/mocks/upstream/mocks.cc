@@ -27,6 +27,7 @@ MockHostSet::MockHostSet() {
   ON_CALL(*this, healthyHosts()).WillByDefault(ReturnRef(healthy_hosts_));
   ON_CALL(*this, hostsPerLocality()).WillByDefault(ReturnRef(hosts_per_locality_));
   ON_CALL(*this, healthyHostsPerLocality()).WillByDefault(ReturnRef(healthy_hosts_per_locality_));
+  ON_CALL(*this, localityWeights()).WillByDefault(ReturnPointee(&locality_weights_));
 }
 
 MockPrioritySet::MockPrioritySet() {
@@ -84,14 +85,17 @@ MockThreadLocalCluster::~MockThreadLocalCluster() {}
 
 MockClusterManager::MockClusterManager() {
   ON_CALL(*this, httpConnPoolForCluster(_, _, _)).WillByDefault(Return(&conn_pool_));
+  ON_CALL(*this, httpConnPoolForClusterHandle(_, _, _)).WillByDefault(Return(&conn_pool_));
   ON_CALL(*this, httpAsyncClientForCluster(_)).WillByDefault(ReturnRef(async_client_));
   ON_CALL(*this, httpAsyncClientForCluster(_)).WillByDefault((ReturnRef(async_client_)));
   ON_CALL(*this, sourceAddress()).WillByDefault(ReturnRef(source_address_));
   ON_CALL(*this, adsMux()).WillByDefault(ReturnRef(ads_mux_));
+  ON_CALL(*this, initTimes()).WillByDefault(ReturnRef(init_times_));
 
   // Matches are LIFO so "" will match first.
   ON_CALL(*this, get(_)).WillByDefault(Return(&thread_local_cluster_));
   ON_CALL(*this, get("")).WillByDefault(Return(nullptr));
+  ON_CALL(*this, getByHandle(_)).WillByDefault(Return(&thread_local_cluster_));
 }
 
 MockClusterManager::~MockClusterManager() {}
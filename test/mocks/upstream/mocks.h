@@ -42,13 +42,15 @@ public:
   MOCK_CONST_METHOD0(healthyHosts, const std::vector<HostSharedPtr>&());
   MOCK_CONST_METHOD0(hostsPerLocality, const std::vector<std::vector<HostSharedPtr>>&());
   MOCK_CONST_METHOD0(healthyHostsPerLocality, const std::vector<std::vector<HostSharedPtr>>&());
-  MOCK_METHOD6(
+  MOCK_CONST_METHOD0(localityWeights, LocalityWeightsConstSharedPtr());
+  MOCK_METHOD7(
       updateHosts,
       void(
           std::shared_ptr<const std::vector<HostSharedPtr>> hosts,
           std::shared_ptr<const std::vector<HostSharedPtr>> healthy_hosts,
           std::shared_ptr<const std::vector<std::vector<HostSharedPtr>>> hosts_per_locality,
           std::shared_ptr<const std::vector<std::vector<HostSharedPtr>>> healthy_hosts_per_locality,
+          LocalityWeightsConstSharedPtr locality_weights,
           const std::vector<HostSharedPtr>& hosts_added,
           const std::vector<HostSharedPtr>& hosts_removed));
   MOCK_CONST_METHOD0(priority, uint32_t());
@@ -57,6 +59,7 @@ public:
   std::vector<HostSharedPtr> healthy_hosts_;
   std::vector<std::vector<HostSharedPtr>> hosts_per_locality_;
   std::vector<std::vector<HostSharedPtr>> healthy_hosts_per_locality_;
+  LocalityWeightsConstSharedPtr locality_weights_;
   Common::CallbackManager<uint32_t, const std::vector<HostSharedPtr>&,
                           const std::vector<HostSharedPtr>&>
       member_update_cb_helper_;
@@ -149,10 +152,15 @@ public:
   MOCK_METHOD1(setInitializedCb, void(std::function<void()>));
   MOCK_METHOD0(clusters, ClusterInfoMap());
   MOCK_METHOD1(get, ThreadLocalCluster*(const std::string& cluster));
+  MOCK_METHOD1(clusterHandle, uint32_t(const std::string& cluster));
+  MOCK_METHOD1(getByHandle, ThreadLocalCluster*(uint32_t handle));
   MOCK_METHOD3(httpConnPoolForCluster,
                Http::ConnectionPool::Instance*(const std::string& cluster,
                                                ResourcePriority priority,
                                                LoadBalancerContext* context));
+  MOCK_METHOD3(httpConnPoolForClusterHandle,
+               Http::ConnectionPool::Instance*(uint32_t handle, ResourcePriority priority,
+                                               LoadBalancerContext* context));
   MOCK_METHOD2(tcpConnForCluster_,
                MockHost::MockCreateConnectionData(const std::string& cluster,
                                                   LoadBalancerContext* context));
@@ -162,12 +170,16 @@ public:
   MOCK_CONST_METHOD0(sourceAddress, const Network::Address::InstanceConstSharedPtr&());
   MOCK_METHOD0(adsMux, Config::GrpcMux&());
   MOCK_CONST_METHOD0(versionInfo, const std::string());
+  MOCK_CONST_METHOD0(initTimes, const ClusterManagerInitTimes&());
+  MOCK_METHOD3(loadOnDemandCluster, void(const std::string& cluster, Event::Dispatcher& dispatcher,
+                                         std::function<void()> callback));
 
   NiceMock<Http::ConnectionPool::MockInstance> conn_pool_;
   NiceMock<Http::MockAsyncClient> async_client_;
   NiceMock<MockThreadLocalCluster> thread_local_cluster_;
   Network::Address::InstanceConstSharedPtr source_address_;
   NiceMock<Config::MockGrpcMux> ads_mux_;
+  ClusterManagerInitTimes init_times_;
 };
 
 class MockHealthChecker : public HealthChecker {
@@ -10,13 +10,18 @@
 #include "common/router/router.h"
 
 #include "server/config/http/buffer.h"
+#include "server/config/http/cache.h"
+#include "server/config/http/compression.h"
+#include "server/config/http/decompression.h"
 #include "server/config/http/dynamo.h"
 #include "server/config/http/fault.h"
 #include "server/config/http/grpc_http1_bridge.h"
 #include "server/config/http/grpc_json_transcoder.h"
 #include "server/config/http/grpc_web.h"
 #include "server/config/http/ip_tagging.h"
+#include "server/config/http/local_ratelimit.h"
 #include "server/config/http/lua.h"
+#include "server/config/http/on_demand.h"
 #include "server/config/http/ratelimit.h"
 #include "server/config/http/router.h"
 #include "server/config/http/zipkin_http_tracer.h"
@@ -343,6 +348,200 @@ TEST(HttpFilterConfigTest, LuaFilterInJson) {
   cb(filter_callback);
 }
 
+TEST(HttpFilterConfigTest, CacheFilterInJson) {
+  std::string json_string = R"EOF(
+  {
+    "max_bytes" : 1048576,
+    "max_entry_bytes" : 4096
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  CacheFilterConfigFactory factory;
+  HttpFilterFactoryCb cb = factory.createFilterFactory(*json_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamFilter(_));
+  cb(filter_callback);
+}
+
+TEST(HttpFilterConfigTest, CacheFilterIncorrectJson) {
+  std::string json_string = R"EOF(
+  {
+    "max_bytes" : "1048576"
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  CacheFilterConfigFactory factory;
+  EXPECT_THROW(factory.createFilterFactory(*json_config, "stats", context), Json::Exception);
+}
+
+TEST(HttpFilterConfigTest, CacheFilterProto) {
+  CacheFilterConfigFactory factory;
+  ProtobufTypes::MessagePtr config = factory.createEmptyConfigProto();
+  ProtobufWkt::Struct& fields = dynamic_cast<ProtobufWkt::Struct&>(*config);
+  (*fields.mutable_fields())["shared"].set_bool_value(true);
+  (*fields.mutable_fields())["num_shards"].set_number_value(4);
+
+  NiceMock<MockFactoryContext> context;
+  HttpFilterFactoryCb cb = factory.createFilterFactoryFromProto(*config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamFilter(_));
+  cb(filter_callback);
+}
+
+TEST(HttpFilterConfigTest, LocalRateLimitFilterInJson) {
+  std::string json_string = R"EOF(
+  {
+    "max_tokens" : 100,
+    "tokens_per_fill" : 10,
+    "fill_interval_ms" : 100,
+    "descriptors" : [
+      {
+        "entries" : [{"key" : "destination_cluster", "value" : "fake_cluster"}],
+        "max_tokens" : 5
+      }
+    ]
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  LocalRateLimitFilterConfigFactory factory;
+  HttpFilterFactoryCb cb = factory.createFilterFactory(*json_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamDecoderFilter(_));
+  cb(filter_callback);
+}
+
+TEST(HttpFilterConfigTest, LocalRateLimitFilterIncorrectJson) {
+  std::string json_string = R"EOF(
+  {
+    "max_tokens" : 0
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  LocalRateLimitFilterConfigFactory factory;
+  EXPECT_THROW(factory.createFilterFactory(*json_config, "stats", context), Json::Exception);
+}
+
+TEST(HttpFilterConfigTest, LocalRateLimitFilterProto) {
+  LocalRateLimitFilterConfigFactory factory;
+  ProtobufTypes::MessagePtr config = factory.createEmptyConfigProto();
+  ProtobufWkt::Struct& fields = dynamic_cast<ProtobufWkt::Struct&>(*config);
+  (*fields.mutable_fields())["max_tokens"].set_number_value(10);
+
+  NiceMock<MockFactoryContext> context;
+  HttpFilterFactoryCb cb = factory.createFilterFactoryFromProto(*config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamDecoderFilter(_));
+  cb(filter_callback);
+}
+
+TEST(HttpFilterConfigTest, CompressionFilterInJson) {
+  std::string json_string = R"EOF(
+  {
+    "compression_level" : "speed",
+    "compression_strategy" : "rle",
+    "window_bits" : 12,
+    "memory_level" : 4,
+    "brotli_quality" : 5,
+    "zstd_level" : 6,
+    "content_encoding" : ["br", "zstd", "gzip"],
+    "content_length" : 100,
+    "content_type" : ["text/html"]
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  CompressionFilterConfigFactory factory;
+  HttpFilterFactoryCb cb = factory.createFilterFactory(*json_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamFilter(_));
+  cb(filter_callback);
+}
+
+TEST(HttpFilterConfigTest, CompressionFilterIncorrectJson) {
+  std::string json_string = R"EOF(
+  {
+    "compression_level" : "fastest"
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  CompressionFilterConfigFactory factory;
+  EXPECT_THROW(factory.createFilterFactory(*json_config, "stats", context), Json::Exception);
+}
+
+TEST(HttpFilterConfigTest, CompressionFilterProto) {
+  CompressionFilterConfigFactory factory;
+  ProtobufTypes::MessagePtr config = factory.createEmptyConfigProto();
+  ProtobufWkt::Struct& fields = dynamic_cast<ProtobufWkt::Struct&>(*config);
+  (*fields.mutable_fields())["window_bits"].set_number_value(15);
+
+  NiceMock<MockFactoryContext> context;
+  HttpFilterFactoryCb cb = factory.createFilterFactoryFromProto(*config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamFilter(_));
+  cb(filter_callback);
+}
+
+TEST(HttpFilterConfigTest, OnDemandFilter) {
+  NiceMock<MockFactoryContext> context;
+  OnDemandFilterConfig factory;
+  HttpFilterFactoryCb cb =
+      factory.createFilterFactoryFromProto(*factory.createEmptyConfigProto(), "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamDecoderFilter(_));
+  cb(filter_callback);
+}
+
+TEST(HttpFilterConfigTest, DecompressionFilterInJson) {
+  std::string json_string = R"EOF(
+  {
+    "max_decompressed_bytes" : 1048576
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  DecompressionFilterConfigFactory factory;
+  HttpFilterFactoryCb cb = factory.createFilterFactory(*json_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamDecoderFilter(_));
+  cb(filter_callback);
+}
+
+TEST(HttpFilterConfigTest, DecompressionFilterIncorrectJson) {
+  std::string json_string = R"EOF(
+  {
+    "max_decompressed_bytes" : -1
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  DecompressionFilterConfigFactory factory;
+  EXPECT_THROW(factory.createFilterFactory(*json_config, "stats", context), Json::Exception);
+}
+
+TEST(HttpFilterConfigTest, DecompressionFilterProto) {
+  DecompressionFilterConfigFactory factory;
+  ProtobufTypes::MessagePtr config = factory.createEmptyConfigProto();
+
+  NiceMock<MockFactoryContext> context;
+  HttpFilterFactoryCb cb = factory.createFilterFactoryFromProto(*config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamDecoderFilter(_));
+  cb(filter_callback);
+}
+
 TEST(HttpFilterConfigTest, RouterFilterInJson) {
   std::string json_string = R"EOF(
   {
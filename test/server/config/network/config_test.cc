@@ -3,13 +3,18 @@
 #include "envoy/registry/registry.h"
 
 #include "common/access_log/access_log_impl.h"
+#include "common/access_log/binary_access_log_impl.h"
+#include "common/access_log/grpc_access_log_impl.h"
 #include "common/config/filter_json.h"
 #include "common/config/well_known_names.h"
 #include "common/dynamo/dynamo_filter.h"
 
+#include "server/config/network/binary_file_access_log.h"
 #include "server/config/network/client_ssl_auth.h"
 #include "server/config/network/file_access_log.h"
+#include "server/config/network/grpc_access_log.h"
 #include "server/config/network/http_connection_manager.h"
+#include "server/config/network/local_ratelimit.h"
 #include "server/config/network/mongo_proxy.h"
 #include "server/config/network/ratelimit.h"
 #include "server/config/network/redis_proxy.h"
@@ -22,6 +27,7 @@
 #include "gtest/gtest.h"
 
 using testing::NiceMock;
+using testing::Return;
 using testing::_;
 
 namespace Envoy {
@@ -320,6 +326,52 @@ TEST(NetworkFilterConfigTest, RatelimitEmptyProto) {
   cb(connection);
 }
 
+TEST(NetworkFilterConfigTest, LocalRatelimitCorrectJson) {
+  std::string json_string = R"EOF(
+  {
+    "stat_prefix": "my_stat_prefix",
+    "max_tokens": 100,
+    "tokens_per_fill": 10,
+    "fill_interval_ms": 100
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  LocalRateLimitConfigFactory factory;
+  NetworkFilterFactoryCb cb = factory.createFilterFactory(*json_config, context);
+  Network::MockConnection connection;
+  EXPECT_CALL(connection, addReadFilter(_));
+  cb(connection);
+}
+
+TEST(NetworkFilterConfigTest, LocalRatelimitIncorrectJson) {
+  std::string json_string = R"EOF(
+  {
+    "max_tokens": 100
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  LocalRateLimitConfigFactory factory;
+  EXPECT_THROW(factory.createFilterFactory(*json_config, context), Json::Exception);
+}
+
+TEST(NetworkFilterConfigTest, LocalRatelimitCorrectProto) {
+  LocalRateLimitConfigFactory factory;
+  ProtobufTypes::MessagePtr config = factory.createEmptyConfigProto();
+  ProtobufWkt::Struct& fields = dynamic_cast<ProtobufWkt::Struct&>(*config);
+  (*fields.mutable_fields())["stat_prefix"].set_string_value("my_stat_prefix");
+  (*fields.mutable_fields())["max_tokens"].set_number_value(10);
+
+  NiceMock<MockFactoryContext> context;
+  NetworkFilterFactoryCb cb = factory.createFilterFactoryFromProto(*config, context);
+  Network::MockConnection connection;
+  EXPECT_CALL(connection, addReadFilter(_));
+  cb(connection);
+}
+
 TEST(NetworkFilterConfigTest, BadHttpConnectionMangerConfig) {
   std::string json_string = R"EOF(
   {
@@ -516,6 +568,57 @@ TEST(AccessLogConfigTest, FileAccessLogTest) {
   EXPECT_NE(nullptr, dynamic_cast<AccessLog::FileAccessLog*>(instance.get()));
 }
 
+TEST(AccessLogConfigTest, BinaryFileAccessLogTest) {
+  auto factory = Registry::FactoryRegistry<AccessLogInstanceFactory>::getFactory(
+      Config::AccessLogNames::get().BINARY_FILE);
+  ASSERT_NE(nullptr, factory);
+
+  ProtobufTypes::MessagePtr message = factory->createEmptyConfigProto();
+  ASSERT_NE(nullptr, message);
+
+  envoy::api::v2::filter::accesslog::FileAccessLog file_access_log;
+  file_access_log.set_path("/dev/null");
+  MessageUtil::jsonConvert(file_access_log, *message);
+
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  AccessLog::InstanceSharedPtr instance =
+      factory->createAccessLogInstance(*message, nullptr, context);
+  EXPECT_NE(nullptr, dynamic_cast<AccessLog::BinaryFileAccessLog*>(instance.get()));
+
+  file_access_log.set_format("%START_TIME%");
+  MessageUtil::jsonConvert(file_access_log, *message);
+  EXPECT_THROW_WITH_MESSAGE(factory->createAccessLogInstance(*message, nullptr, context),
+                            EnvoyException,
+                            "envoy.binary_file_access_log does not take a format");
+}
+
+TEST(AccessLogConfigTest, HttpGrpcAccessLogTest) {
+  auto factory = Registry::FactoryRegistry<AccessLogInstanceFactory>::getFactory(
+      Config::AccessLogNames::get().HTTP_GRPC);
+  ASSERT_NE(nullptr, factory);
+
+  ProtobufTypes::MessagePtr message = factory->createEmptyConfigProto();
+  ASSERT_NE(nullptr, message);
+
+  envoy::access_log::HttpGrpcAccessLogConfig grpc_access_log;
+  grpc_access_log.set_log_name("foo");
+  grpc_access_log.set_cluster_name("access_log_service");
+  MessageUtil::jsonConvert(grpc_access_log, *message);
+
+  AccessLog::FilterPtr filter;
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+
+  AccessLog::InstanceSharedPtr instance =
+      factory->createAccessLogInstance(*message, std::move(filter), context);
+  EXPECT_NE(nullptr, instance);
+  EXPECT_NE(nullptr, dynamic_cast<AccessLog::HttpGrpcAccessLog*>(instance.get()));
+
+  EXPECT_CALL(context.cluster_manager_, get("access_log_service")).WillOnce(Return(nullptr));
+  EXPECT_THROW_WITH_MESSAGE(factory->createAccessLogInstance(*message, nullptr, context),
+                            EnvoyException,
+                            "unknown access log service cluster 'access_log_service'");
+}
+
 // Test that a minimal TcpProxy v2 config works.
 TEST(TcpProxyConfigTest, TcpProxyConfigTest) {
   NiceMock<MockFactoryContext> context;
@@ -5,6 +5,8 @@
 #include "test/mocks/stats/mocks.h"
 #include "test/test_common/environment.h"
 
+using testing::Return;
+
 namespace Envoy {
 namespace Server {
 
@@ -33,6 +35,13 @@ TEST_P(ValidationServerTest, Validate) {
       validateConfig(options_, Network::Address::InstanceConstSharedPtr(), component_factory_));
 }
 
+// The listeners are split between two validation servers, each loading all of the clusters.
+TEST_P(ValidationServerTest, ValidateConcurrently) {
+  ON_CALL(options_, validationThreads()).WillByDefault(Return(2));
+  EXPECT_TRUE(
+      validateConfig(options_, Network::Address::InstanceConstSharedPtr(), component_factory_));
+}
+
 // TODO(rlazarus): We'd like use this setup to replace //test/config_test (that is, run it against
 // all the example configs) but can't until light validation is implemented, mocking out access to
 // the filesystem for TLS certs, etc. In the meantime, these are the example configs that work
@@ -0,0 +1,41 @@
+#include <chrono>
+
+#include "server/config_validation/timing.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Server {
+
+TEST(ValidationTimingTest, Summary) {
+  ValidationTiming timing;
+  EXPECT_EQ("0", timing.summary());
+
+  timing.add("a", std::chrono::milliseconds(2));
+  timing.add("b", std::chrono::milliseconds(5));
+  timing.add("c", std::chrono::milliseconds(1));
+  EXPECT_EQ(3U, timing.count());
+  EXPECT_EQ("3 in 8.0 ms, slowest 'b' in 5.0 ms", timing.summary());
+}
+
+TEST(ValidationTimingTest, Merge) {
+  ValidationTiming timing;
+  ValidationTiming other;
+  timing.merge(other);
+  EXPECT_EQ("0", timing.summary());
+
+  other.add("a", std::chrono::milliseconds(3));
+  timing.merge(other);
+  EXPECT_EQ("1 in 3.0 ms, slowest 'a' in 3.0 ms", timing.summary());
+
+  ValidationTiming slower;
+  slower.add("b", std::chrono::milliseconds(4));
+  slower.add("c", std::chrono::milliseconds(1));
+  timing.merge(slower);
+  timing.merge(ValidationTiming());
+  EXPECT_EQ(3U, timing.count());
+  EXPECT_EQ("3 in 8.0 ms, slowest 'b' in 4.0 ms", timing.summary());
+}
+
+} // namespace Server
+} // namespace Envoy
@@ -1,7 +1,11 @@
+#include <fcntl.h>
+#include <unistd.h>
+
 #include "common/common/utility.h"
 #include "common/network/address_impl.h"
 #include "common/stats/stats_impl.h"
 
+#include "server/connection_balancer_impl.h"
 #include "server/connection_handler_impl.h"
 
 #include "test/mocks/network/mocks.h"
@@ -15,6 +19,7 @@ using testing::InSequence;
 using testing::Invoke;
 using testing::NiceMock;
 using testing::Return;
+using testing::SaveArg;
 using testing::_;
 
 namespace Envoy {
@@ -69,6 +74,55 @@ TEST_F(ConnectionHandlerTest, RemoveListener) {
   handler_->removeListeners(0);
 }
 
+TEST_F(ConnectionHandlerTest, RemoveListenerWhenIdle) {
+  InSequence s;
+
+  Network::MockListener* listener = new NiceMock<Network::MockListener>();
+  Network::ListenerCallbacks* listener_callbacks;
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _, _))
+      .WillOnce(Invoke([&](Network::ConnectionHandler&, Network::ListenSocket&,
+                           Network::ListenerCallbacks& cb, Stats::Scope&,
+                           const Network::ListenerOptions&) -> Network::Listener* {
+        listener_callbacks = &cb;
+        return listener;
+
+      }));
+  handler_->addListener(factory_, socket_, stats_store_, 1,
+                        Network::ListenerOptions::listenerOptionsWithBindToPort());
+
+  Network::MockConnection* connection = new NiceMock<Network::MockConnection>();
+  EXPECT_CALL(factory_, createFilterChain(_)).WillOnce(Return(true));
+  listener_callbacks->onNewConnection(Network::ConnectionPtr{connection});
+  EXPECT_EQ(1UL, handler_->numConnections());
+
+  // A listener that doesn't exist is removed right away.
+  uint32_t removed = 0;
+  handler_->removeListenersWhenIdle(0, [&removed]() -> void { removed++; });
+  EXPECT_EQ(1UL, removed);
+
+  // The listener stops, but its connection is not closed.
+  EXPECT_CALL(*listener, onDestroy());
+  EXPECT_CALL(*connection, close(_)).Times(0);
+  handler_->removeListenersWhenIdle(1, [&removed]() -> void { removed++; });
+  EXPECT_EQ(1UL, removed);
+  EXPECT_EQ(1UL, handler_->numConnections());
+
+  // The listener is removed once its last connection closes.
+  std::function<void()> post_cb;
+  EXPECT_CALL(dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
+  connection->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  EXPECT_EQ(0UL, handler_->numConnections());
+  EXPECT_EQ(1UL, removed);
+
+  EXPECT_CALL(dispatcher_, clearDeferredDeleteList());
+  post_cb();
+  EXPECT_EQ(2UL, removed);
+
+  // The listener is gone.
+  handler_->removeListenersWhenIdle(1, [&removed]() -> void { removed++; });
+  EXPECT_EQ(3UL, removed);
+}
+
 TEST_F(ConnectionHandlerTest, DestroyCloseConnections) {
   InSequence s;
 
@@ -215,5 +269,83 @@ TEST_F(ConnectionHandlerTest, FindListenerByAddress) {
   EXPECT_CALL(*listener3, onDestroy());
 }
 
+// Accepted sockets are handed to the handler whose copy of the listener owns the fewest
+// connections, and connections are counted in per handler stats.
+TEST_F(ConnectionHandlerTest, BalanceConnections) {
+  NiceMock<Event::MockDispatcher> dispatcher1;
+  ConnectionHandlerImpl handler0(ENVOY_LOGGER(), dispatcher_, "worker_0.");
+  ConnectionHandlerImpl handler1(ENVOY_LOGGER(), dispatcher1, "worker_1.");
+  Network::ListenerOptions listener_options =
+      Network::ListenerOptions::listenerOptionsWithBindToPort();
+  listener_options.connection_balancer_ = std::make_shared<ConnectionBalancerImpl>();
+
+  Network::MockListener* listener0 = new NiceMock<Network::MockListener>();
+  Network::ListenerCallbacks* listener_callbacks0;
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _, _))
+      .WillOnce(Invoke([&](Network::ConnectionHandler&, Network::ListenSocket&,
+                           Network::ListenerCallbacks& cb, Stats::Scope&,
+                           const Network::ListenerOptions&) -> Network::Listener* {
+        listener_callbacks0 = &cb;
+        return listener0;
+      }));
+  handler0.addListener(factory_, socket_, stats_store_, 1, listener_options);
+
+  Network::MockListener* listener1 = new NiceMock<Network::MockListener>();
+  Network::ListenerCallbacks* listener_callbacks1;
+  EXPECT_CALL(dispatcher1, createListener_(_, _, _, _, _))
+      .WillOnce(Invoke([&](Network::ConnectionHandler&, Network::ListenSocket&,
+                           Network::ListenerCallbacks& cb, Stats::Scope&,
+                           const Network::ListenerOptions&) -> Network::Listener* {
+        listener_callbacks1 = &cb;
+        return listener1;
+      }));
+  handler1.addListener(factory_, socket_, stats_store_, 1, listener_options);
+
+  Network::Address::InstanceConstSharedPtr address(
+      new Network::Address::Ipv4Instance("127.0.0.1", 10001));
+  EXPECT_CALL(factory_, createFilterChain(_)).WillRepeatedly(Return(true));
+
+  // Both listeners are idle, so the accepting listener keeps the socket.
+  EXPECT_FALSE(listener_callbacks0->onAccept(10, address, address, false));
+  listener_callbacks0->onNewConnection(
+      Network::ConnectionPtr{new NiceMock<Network::MockConnection>()});
+
+  // The next socket is posted to the other listener.
+  EXPECT_CALL(*listener1, createConnection(11, address, address, false))
+      .WillOnce(Invoke([&](int, Network::Address::InstanceConstSharedPtr,
+                           Network::Address::InstanceConstSharedPtr, bool) -> void {
+        listener_callbacks1->onNewConnection(
+            Network::ConnectionPtr{new NiceMock<Network::MockConnection>()});
+      }));
+  EXPECT_TRUE(listener_callbacks0->onAccept(11, address, address, false));
+  EXPECT_EQ(1UL, handler0.numConnections());
+  EXPECT_EQ(1UL, handler1.numConnections());
+  EXPECT_EQ(1UL, stats_store_.gauge("worker_0.downstream_cx_active").value());
+  EXPECT_EQ(1UL, stats_store_.gauge("worker_1.downstream_cx_active").value());
+  EXPECT_EQ(1UL, stats_store_.counter("worker_1.downstream_cx_total").value());
+  EXPECT_EQ(2UL, stats_store_.gauge("downstream_cx_active").value());
+
+  // A tie keeps the socket on the accepting listener.
+  EXPECT_FALSE(listener_callbacks1->onAccept(12, address, address, false));
+  listener_callbacks1->onNewConnection(
+      Network::ConnectionPtr{new NiceMock<Network::MockConnection>()});
+  EXPECT_EQ(2UL, handler1.numConnections());
+
+  // A socket which arrives after the target listener stopped is closed.
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  std::function<void()> posted;
+  EXPECT_CALL(dispatcher_, post(_)).WillOnce(SaveArg<0>(&posted));
+  EXPECT_TRUE(listener_callbacks1->onAccept(fds[0], address, address, false));
+  handler0.stopListeners(1);
+  EXPECT_CALL(*listener0, createConnection(_, _, _, _)).Times(0);
+  posted();
+  EXPECT_EQ(-1, fcntl(fds[0], F_GETFD));
+  close(fds[1]);
+
+  // Stopped listeners are not handed any more sockets.
+  EXPECT_FALSE(listener_callbacks1->onAccept(13, address, address, false));
+}
+
 } // namespace Server
 } // namespace Envoy
@@ -2,6 +2,7 @@
 
 #include "server/drain_manager_impl.h"
 
+#include "test/mocks/common.h"
 #include "test/mocks/server/mocks.h"
 
 #include "gmock/gmock.h"
@@ -9,6 +10,7 @@
 
 using testing::InSequence;
 using testing::Return;
+using testing::ReturnPointee;
 using testing::SaveArg;
 using testing::_;
 
@@ -24,11 +26,12 @@ public:
   }
 
   NiceMock<MockInstance> server_;
+  NiceMock<MockMonotonicTimeSource> time_source_;
 };
 
 TEST_F(DrainManagerImplTest, Default) {
   InSequence s;
-  DrainManagerImpl drain_manager(server_, envoy::api::v2::Listener_DrainType_DEFAULT);
+  DrainManagerImpl drain_manager(server_, envoy::api::v2::Listener_DrainType_DEFAULT, time_source_);
 
   // Test parent shutdown.
   Event::MockTimer* shutdown_timer = new Event::MockTimer(&server_.dispatcher_);
@@ -66,11 +69,49 @@ TEST_F(DrainManagerImplTest, Default) {
 
 TEST_F(DrainManagerImplTest, ModifyOnly) {
   InSequence s;
-  DrainManagerImpl drain_manager(server_, envoy::api::v2::Listener_DrainType_MODIFY_ONLY);
+  DrainManagerImpl drain_manager(server_, envoy::api::v2::Listener_DrainType_MODIFY_ONLY,
+                                 time_source_);
 
   EXPECT_CALL(server_, healthCheckFailed()).Times(0);
   EXPECT_FALSE(drain_manager.drainClose());
 }
 
+TEST_F(DrainManagerImplTest, CloseRate) {
+  DrainManagerImpl drain_manager(server_, envoy::api::v2::Listener_DrainType_MODIFY_ONLY,
+                                 time_source_);
+  ON_CALL(server_.runtime_loader_.snapshot_, getInteger("server.drain_close_rate_per_worker", 0))
+      .WillByDefault(Return(5));
+  ON_CALL(server_.options_, concurrency()).WillByDefault(Return(2));
+
+  // 10 closes per second across both workers, so one every 100ms, with up to 100ms of closes
+  // allowed to run ahead.
+  MonotonicTime now;
+  ON_CALL(time_source_, currentTime()).WillByDefault(ReturnPointee(&now));
+  Event::MockTimer* drain_timer = new Event::MockTimer(&server_.dispatcher_);
+  EXPECT_CALL(*drain_timer, enableTimer(_)).Times(599);
+  drain_manager.startDrainSequence(nullptr);
+
+  EXPECT_TRUE(drain_manager.drainClose());
+  EXPECT_TRUE(drain_manager.drainClose());
+  EXPECT_FALSE(drain_manager.drainClose());
+
+  now += std::chrono::milliseconds(100);
+  EXPECT_TRUE(drain_manager.drainClose());
+  EXPECT_FALSE(drain_manager.drainClose());
+
+  // Closes not asked for don't accumulate beyond the burst.
+  now += std::chrono::seconds(10);
+  EXPECT_TRUE(drain_manager.drainClose());
+  EXPECT_TRUE(drain_manager.drainClose());
+  EXPECT_FALSE(drain_manager.drainClose());
+
+  // At the end of the drain period all connections are closed.
+  for (size_t i = 0; i < 599; i++) {
+    drain_timer->callback_();
+  }
+  EXPECT_TRUE(drain_manager.drainClose());
+  EXPECT_TRUE(drain_manager.drainClose());
+}
+
 } // namespace Server
 } // namespace Envoy
@@ -10,7 +10,6 @@
 #include "gtest/gtest.h"
 
 using testing::Invoke;
-using testing::InvokeWithoutArgs;
 using testing::Return;
 using testing::WithArg;
 using testing::_;
@@ -21,15 +20,19 @@ namespace Server {
 class HotRestartImplTest : public testing::Test {
 public:
   void setup() {
-    EXPECT_CALL(os_sys_calls_, shmUnlink(_));
-    EXPECT_CALL(os_sys_calls_, shmOpen(_, _, _));
-    EXPECT_CALL(os_sys_calls_, ftruncate(_, _)).WillOnce(WithArg<1>(Invoke([this](off_t size) {
-      buffer_.resize(size);
+    // Each shared memory object is a buffer, keyed by the fd it is opened with.
+    EXPECT_CALL(os_sys_calls_, shmUnlink(_)).Times(SharedMemory::MAX_STAT_SEGMENTS);
+    EXPECT_CALL(os_sys_calls_, shmOpen(_, _, _))
+        .WillRepeatedly(WithArg<0>(Invoke([this](const char* name) {
+          return fds_.emplace(name, fds_.size()).first->second;
+        })));
+    EXPECT_CALL(os_sys_calls_, ftruncate(_, _)).WillRepeatedly(Invoke([this](int fd, off_t size) {
+      buffers_[fd].resize(size);
       return 0;
-    })));
-    EXPECT_CALL(os_sys_calls_, mmap(_, _, _, _, _, _)).WillOnce(InvokeWithoutArgs([this]() {
-      return buffer_.data();
     }));
+    EXPECT_CALL(os_sys_calls_, mmap(_, _, _, _, _, _))
+        .WillRepeatedly(WithArg<4>(Invoke([this](int fd) { return buffers_[fd].data(); })));
+    EXPECT_CALL(os_sys_calls_, close(_)).WillRepeatedly(Return(0));
     EXPECT_CALL(os_sys_calls_, bind(_, _, _));
 
     Stats::RawStatData::configureForTestsOnly(options_);
@@ -49,7 +52,8 @@ public:
   Api::MockOsSysCalls os_sys_calls_;
   TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls{&os_sys_calls_};
   NiceMock<MockOptions> options_;
-  std::vector<uint8_t> buffer_;
+  std::map<std::string, int> fds_;
+  std::map<int, std::vector<uint8_t>> buffers_;
   std::unique_ptr<HotRestartImpl> hot_restart_;
 };
 
@@ -75,8 +79,6 @@ TEST_F(HotRestartImplTest, crossAlloc) {
   stat4 = nullptr;
 
   EXPECT_CALL(options_, restartEpoch()).WillRepeatedly(Return(1));
-  EXPECT_CALL(os_sys_calls_, shmOpen(_, _, _));
-  EXPECT_CALL(os_sys_calls_, mmap(_, _, _, _, _, _)).WillOnce(Return(buffer_.data()));
   EXPECT_CALL(os_sys_calls_, bind(_, _, _));
   HotRestartImpl hot_restart2(options_);
   Stats::RawStatData* stat1_prime = hot_restart2.alloc("stat1");
@@ -87,16 +89,118 @@ TEST_F(HotRestartImplTest, crossAlloc) {
   EXPECT_EQ(stat5, stat5_prime);
 }
 
+// Stats are added to new segments as the earlier ones fill up, until the last segment is full.
 TEST_F(HotRestartImplTest, allocFail) {
   EXPECT_CALL(options_, maxStats()).WillRepeatedly(Return(2));
   setup();
 
-  Stats::RawStatData* s1 = hot_restart_->alloc("1");
-  Stats::RawStatData* s2 = hot_restart_->alloc("2");
-  Stats::RawStatData* s3 = hot_restart_->alloc("3");
-  EXPECT_NE(s1, nullptr);
-  EXPECT_NE(s2, nullptr);
-  EXPECT_EQ(s3, nullptr);
+  std::vector<Stats::RawStatData*> stats;
+  for (uint64_t i = 0; i < 2 * SharedMemory::MAX_STAT_SEGMENTS; i++) {
+    stats.push_back(hot_restart_->alloc(fmt::format("{}", i)));
+    EXPECT_NE(nullptr, stats.back());
+  }
+  EXPECT_EQ(SharedMemory::MAX_STAT_SEGMENTS, buffers_.size());
+  EXPECT_EQ(nullptr, hot_restart_->alloc("full"));
+
+  // The last segment is never closed, so its released slots are reused.
+  hot_restart_->free(*stats.back());
+  EXPECT_EQ(stats.back(), hot_restart_->alloc("full"));
+}
+
+// Once a segment is full, stats are added to a new one, which a hot restarted process maps as it
+// looks for the stats in it. Slots released in a full segment are not reused.
+TEST_F(HotRestartImplTest, addSegments) {
+  EXPECT_CALL(options_, maxStats()).WillRepeatedly(Return(2));
+  setup();
+
+  Stats::RawStatData* stat1 = hot_restart_->alloc("stat1");
+  Stats::RawStatData* stat2 = hot_restart_->alloc("stat2");
+  EXPECT_EQ(1U, buffers_.size());
+  Stats::RawStatData* stat3 = hot_restart_->alloc("stat3");
+  EXPECT_EQ(2U, buffers_.size());
+
+  hot_restart_->free(*stat1);
+  Stats::RawStatData* stat4 = hot_restart_->alloc("stat4");
+  EXPECT_NE(stat1, stat4);
+  EXPECT_EQ(2U, buffers_.size());
+  EXPECT_EQ(stat2, hot_restart_->alloc("stat2"));
+  EXPECT_EQ(stat3, hot_restart_->alloc("stat3"));
+
+  EXPECT_CALL(options_, restartEpoch()).WillRepeatedly(Return(1));
+  EXPECT_CALL(os_sys_calls_, bind(_, _, _));
+  HotRestartImpl hot_restart2(options_);
+  EXPECT_EQ(stat3, hot_restart2.alloc("stat3"));
+  EXPECT_EQ(stat4, hot_restart2.alloc("stat4"));
+  EXPECT_EQ(stat2, hot_restart2.alloc("stat2"));
+  EXPECT_EQ(3U, stat3->ref_count_);
+}
+
+TEST_F(HotRestartImplTest, allocRefCount) {
+  setup();
+
+  Stats::RawStatData* stat1 = hot_restart_->alloc("stat1");
+  EXPECT_EQ(stat1, hot_restart_->alloc("stat1"));
+  EXPECT_EQ(2U, stat1->ref_count_);
+
+  hot_restart_->free(*stat1);
+  EXPECT_TRUE(stat1->matches("stat1"));
+  EXPECT_EQ(stat1, hot_restart_->alloc("stat1"));
+  hot_restart_->free(*stat1);
+  hot_restart_->free(*stat1);
+  EXPECT_FALSE(stat1->initialized());
+}
+
+// Released slots are reused, and stats stay findable across allocations and releases of other
+// stats.
+TEST_F(HotRestartImplTest, freeAndReuse) {
+  EXPECT_CALL(options_, maxStats()).WillRepeatedly(Return(4));
+  setup();
+
+  Stats::RawStatData* stat1 = hot_restart_->alloc("stat1");
+  Stats::RawStatData* stat2 = hot_restart_->alloc("stat2");
+  Stats::RawStatData* stat3 = hot_restart_->alloc("stat3");
+  Stats::RawStatData* stat4 = hot_restart_->alloc("stat4");
+
+  hot_restart_->free(*stat2);
+  Stats::RawStatData* stat5 = hot_restart_->alloc("stat5");
+  EXPECT_EQ(stat2, stat5);
+  EXPECT_TRUE(stat5->matches("stat5"));
+  EXPECT_EQ(1U, buffers_.size());
+
+  EXPECT_EQ(stat1, hot_restart_->alloc("stat1"));
+  EXPECT_EQ(stat3, hot_restart_->alloc("stat3"));
+  EXPECT_EQ(stat4, hot_restart_->alloc("stat4"));
+  EXPECT_EQ(stat5, hot_restart_->alloc("stat5"));
+}
+
+// Many allocations and releases leave tombstones in the stat index, which are periodically
+// cleaned up without losing any of the live stats.
+TEST_F(HotRestartImplTest, churn) {
+  EXPECT_CALL(options_, maxStats()).WillRepeatedly(Return(8));
+  setup();
+
+  std::vector<Stats::RawStatData*> live;
+  for (uint64_t i = 0; i < 4; i++) {
+    live.push_back(hot_restart_->alloc(fmt::format("live{}", i)));
+  }
+
+  for (uint64_t i = 0; i < 100; i++) {
+    std::vector<Stats::RawStatData*> churned;
+    for (uint64_t j = 0; j < 4; j++) {
+      Stats::RawStatData* stat = hot_restart_->alloc(fmt::format("churn{}_{}", i, j));
+      ASSERT_NE(nullptr, stat);
+      churned.push_back(stat);
+    }
+    for (Stats::RawStatData* stat : churned) {
+      hot_restart_->free(*stat);
+    }
+
+    for (uint64_t j = 0; j < live.size(); j++) {
+      Stats::RawStatData* stat = hot_restart_->alloc(fmt::format("live{}", j));
+      EXPECT_EQ(live[j], stat);
+      hot_restart_->free(*stat);
+    }
+  }
 }
 
 // Because the shared memory is managed manually, make sure it meets
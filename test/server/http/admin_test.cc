@@ -1,7 +1,9 @@
 #include <fstream>
 
 #include "common/http/message_impl.h"
+#include "common/json/json_loader.h"
 #include "common/profiler/profiler.h"
+#include "common/stats/thread_local_store.h"
 
 #include "server/http/admin.h"
 
@@ -14,7 +16,13 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::HasSubstr;
+using testing::Invoke;
 using testing::NiceMock;
+using testing::Not;
+using testing::Return;
+using testing::ReturnRef;
+using testing::StartsWith;
 using testing::_;
 
 namespace Envoy {
@@ -62,6 +70,46 @@ TEST_P(AdminFilterTest, Trailers) {
   filter_.decodeTrailers(request_headers_);
 }
 
+TEST_P(AdminFilterTest, ChunkedResponse) {
+  // Enough stats for the response to take a few chunks.
+  for (uint32_t i = 0; i < 10000; i++) {
+    server_.stats_store_.counter(fmt::format("test.counter_{}", i)).inc();
+  }
+  Buffer::OwnedImpl expected;
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/stats?prefix=test.", expected));
+
+  Event::MockTimer* timer = new Event::MockTimer(&callbacks_.dispatcher_);
+  std::string body;
+  bool end_stream = false;
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, false));
+  EXPECT_CALL(callbacks_, encodeData(_, _))
+      .WillRepeatedly(Invoke([&](Buffer::Instance& data, bool end) -> void {
+        body += TestUtility::bufferToString(data);
+        end_stream = end;
+      }));
+  EXPECT_CALL(callbacks_, addDownstreamWatermarkCallbacks(_));
+  EXPECT_CALL(*timer, enableTimer(_));
+  Http::TestHeaderMapImpl request_headers{{":path", "/stats?prefix=test."}};
+  filter_.decodeHeaders(request_headers, true);
+  EXPECT_FALSE(end_stream);
+
+  // The chunk after the next one waits for the backed up downstream to drain.
+  filter_.onAboveWriteBufferHighWatermark();
+  EXPECT_CALL(*timer, enableTimer(_)).Times(0);
+  timer->callback_();
+  EXPECT_CALL(*timer, enableTimer(_));
+  filter_.onBelowWriteBufferLowWatermark();
+
+  EXPECT_CALL(*timer, enableTimer(_));
+  timer->callback_();
+  EXPECT_FALSE(end_stream);
+
+  EXPECT_CALL(callbacks_, removeDownstreamWatermarkCallbacks(_));
+  timer->callback_();
+  EXPECT_TRUE(end_stream);
+  EXPECT_EQ(TestUtility::bufferToString(expected), body);
+}
+
 class AdminInstanceTest : public testing::TestWithParam<Network::Address::IpVersion> {
 public:
   AdminInstanceTest()
@@ -95,6 +143,15 @@ TEST_P(AdminInstanceTest, AdminProfiler) {
   EXPECT_FALSE(Profiler::Cpu::profilerEnabled());
 }
 
+TEST_P(AdminInstanceTest, AdminHeapProfiler) {
+  Buffer::OwnedImpl data;
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/heapprofiler?enable=y", data));
+  EXPECT_TRUE(Profiler::Heap::profilerEnabled());
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/heapprofiler?dump=y", data));
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/heapprofiler?enable=n", data));
+  EXPECT_FALSE(Profiler::Heap::profilerEnabled());
+}
+
 #endif
 
 TEST_P(AdminInstanceTest, AdminBadProfiler) {
@@ -106,6 +163,22 @@ TEST_P(AdminInstanceTest, AdminBadProfiler) {
   EXPECT_FALSE(Profiler::Cpu::profilerEnabled());
 }
 
+TEST_P(AdminInstanceTest, AdminHeapProfilerBadRequest) {
+  Buffer::OwnedImpl data;
+  EXPECT_EQ(Http::Code::BadRequest, admin_.runCallback("/heapprofiler?enable=maybe", data));
+  EXPECT_EQ(Http::Code::BadRequest, admin_.runCallback("/heapprofiler?enable=y&dump=y", data));
+  // A profile can only be dumped while the profiler is enabled.
+  EXPECT_EQ(Http::Code::BadRequest, admin_.runCallback("/heapprofiler?dump=y", data));
+  EXPECT_FALSE(Profiler::Heap::profilerEnabled());
+}
+
+TEST_P(AdminInstanceTest, Memory) {
+  Buffer::OwnedImpl response;
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/memory", response));
+  EXPECT_THAT(TestUtility::bufferToString(response), StartsWith("allocated: "));
+  EXPECT_THAT(TestUtility::bufferToString(response), HasSubstr("\npageheap_unmapped: "));
+}
+
 TEST_P(AdminInstanceTest, WriteAddressToFile) {
   std::ifstream address_file(address_out_path_);
   std::string address_from_file;
@@ -148,5 +221,113 @@ TEST_P(AdminInstanceTest, CustomHandler) {
   EXPECT_EQ(Http::Code::Accepted, admin_.runCallback("/foo/bar", response));
 }
 
+TEST_P(AdminInstanceTest, ServerInfo) {
+  server_.cluster_manager_.init_times_.static_clusters_ = std::chrono::milliseconds(120);
+  server_.cluster_manager_.init_times_.cds_ = std::chrono::milliseconds(30);
+
+  Buffer::OwnedImpl response;
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/server_info", response));
+  EXPECT_THAT(TestUtility::bufferToString(response),
+              testing::HasSubstr("\ncluster_manager_init static_clusters=120ms cds=30ms "
+                                 "cds_clusters=0ms\n"));
+}
+
+TEST_P(AdminInstanceTest, StatsListing) {
+  server_.stats_store_.counter("cluster.b.upstream_rq").add(2);
+  server_.stats_store_.counter("cluster.a.upstream_rq").inc();
+  server_.stats_store_.gauge("cluster.a.active").set(3);
+  server_.stats_store_.counter("listener.downstream_cx").inc();
+
+  Buffer::OwnedImpl response;
+  EXPECT_EQ(Http::Code::OK,
+            admin_.runCallback("/stats?prefix=cluster.&filter=upstream_rq$", response));
+  EXPECT_EQ("cluster.a.upstream_rq: 1\ncluster.b.upstream_rq: 2\n",
+            TestUtility::bufferToString(response));
+
+  response.drain(response.length());
+  EXPECT_EQ(Http::Code::OK,
+            admin_.runCallback("/stats?prefix=cluster.&offset=1&limit=1", response));
+  EXPECT_EQ("cluster.a.upstream_rq: 1\n", TestUtility::bufferToString(response));
+
+  response.drain(response.length());
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/stats?format=json&filter=^listener", response));
+  EXPECT_EQ("{\n    \"stats\": [\n        {\n            \"name\": \"listener.downstream_cx\",\n"
+            "            \"value\": 1\n        }\n    ]\n}",
+            TestUtility::bufferToString(response));
+
+  response.drain(response.length());
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/stats?format=json&prefix=none.", response));
+  EXPECT_EQ("{\n    \"stats\": []\n}", TestUtility::bufferToString(response));
+
+  response.drain(response.length());
+  EXPECT_EQ(Http::Code::NotFound, admin_.runCallback("/stats?filter=(", response));
+  EXPECT_EQ(Http::Code::NotFound, admin_.runCallback("/stats?limit=all", response));
+}
+
+TEST_P(AdminInstanceTest, ClustersListing) {
+  NiceMock<Upstream::MockCluster> cluster_a;
+  cluster_a.info_->name_ = "a";
+  NiceMock<Upstream::MockCluster> cluster_b;
+  cluster_b.info_->name_ = "b";
+  ON_CALL(server_.cluster_manager_, clusters())
+      .WillByDefault(Return(Upstream::ClusterManager::ClusterInfoMap{{"a", cluster_a},
+                                                                     {"b", cluster_b}}));
+  ON_CALL(server_.cluster_manager_, versionInfo()).WillByDefault(Return("v1"));
+
+  Buffer::OwnedImpl response;
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/clusters?filter=^b", response));
+  EXPECT_THAT(TestUtility::bufferToString(response),
+              StartsWith("version_info::v1\nb::default_priority::max_connections::"));
+  EXPECT_THAT(TestUtility::bufferToString(response), HasSubstr("\nb::added_via_api::false\n"));
+  EXPECT_THAT(TestUtility::bufferToString(response), Not(HasSubstr("\na::")));
+
+  response.drain(response.length());
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/clusters?format=json&offset=1", response));
+  Json::ObjectSharedPtr json = Json::Factory::loadFromString(TestUtility::bufferToString(response));
+  EXPECT_EQ("v1", json->getString("version_info"));
+  std::vector<Json::ObjectSharedPtr> clusters = json->getObjectArray("clusters");
+  ASSERT_EQ(1U, clusters.size());
+  EXPECT_EQ("b", clusters[0]->getString("name"));
+  EXPECT_FALSE(clusters[0]->getBoolean("added_via_api"));
+  EXPECT_TRUE(clusters[0]->getObject("circuit_breakers")->hasObject("high"));
+  EXPECT_TRUE(clusters[0]->getObjectArray("hosts").empty());
+
+  response.drain(response.length());
+  EXPECT_EQ(Http::Code::BadRequest, admin_.runCallback("/clusters?format=yaml", response));
+}
+
+TEST_P(AdminInstanceTest, PrometheusStats) {
+  Stats::HeapRawStatDataAllocator alloc;
+  Stats::ThreadLocalStoreImpl store(alloc);
+  std::vector<Stats::TagExtractorPtr> tag_extractors;
+  tag_extractors.emplace_back(
+      Stats::TagExtractorImpl::createTagExtractor("cluster_name", "^cluster\\.((.*?)\\.)"));
+  store.setTagExtractors(tag_extractors);
+  store.counter("cluster.b.upstream_rq").add(2);
+  store.counter("cluster.a.upstream_rq").inc();
+  store.gauge("cluster.a.active").set(3);
+  store.counter("listener.downstream_cx").inc();
+  ON_CALL(server_, stats()).WillByDefault(ReturnRef(store));
+
+  // The samples of a family follow a single TYPE line, and only the stats with the prefix are
+  // written.
+  Buffer::OwnedImpl response;
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/stats/prometheus?prefix=cluster.", response));
+  EXPECT_EQ("# TYPE envoy_cluster_upstream_rq counter\n"
+            "envoy_cluster_upstream_rq{cluster_name=\"a\"} 1\n"
+            "envoy_cluster_upstream_rq{cluster_name=\"b\"} 2\n"
+            "# TYPE envoy_cluster_active gauge\n"
+            "envoy_cluster_active{cluster_name=\"a\"} 3\n",
+            TestUtility::bufferToString(response));
+
+  response.drain(response.length());
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/stats/prometheus", response));
+  EXPECT_THAT(TestUtility::bufferToString(response),
+              testing::HasSubstr("# TYPE envoy_listener_downstream_cx counter\n"
+                                 "envoy_listener_downstream_cx{} 1\n"));
+
+  store.shutdownThreading();
+}
+
 } // namespace Server
 } // namespace Envoy
@@ -37,7 +37,7 @@ public:
     }
     EXPECT_CALL(init_, registerTarget(_));
     lds_.reset(new LdsApi(lds_config, cluster_manager_, dispatcher_, random_, init_, local_info_,
-                          store_, listener_manager_));
+                          store_, listener_manager_, ""));
 
     expectRequest();
     init_.initialize();
@@ -122,7 +122,7 @@ TEST_F(LdsApiTest, UnknownCluster) {
   Config::Utility::translateLdsConfig(*config, lds_config);
   ON_CALL(cluster_manager_, get("foo_cluster")).WillByDefault(Return(nullptr));
   EXPECT_THROW_WITH_MESSAGE(LdsApi(lds_config, cluster_manager_, dispatcher_, random_, init_,
-                                   local_info_, store_, listener_manager_),
+                                   local_info_, store_, listener_manager_, ""),
                             EnvoyException, "lds: unknown cluster 'foo_cluster'");
 }
 
@@ -139,7 +139,7 @@ TEST_F(LdsApiTest, BadLocalInfo) {
   Config::Utility::translateLdsConfig(*config, lds_config);
   ON_CALL(local_info_, clusterName()).WillByDefault(Return(std::string()));
   EXPECT_THROW_WITH_MESSAGE(LdsApi(lds_config, cluster_manager_, dispatcher_, random_, init_,
-                                   local_info_, store_, listener_manager_),
+                                   local_info_, store_, listener_manager_, ""),
                             EnvoyException,
                             "lds: setting --service-cluster and --service-node is required");
 }
@@ -113,7 +113,7 @@ TEST_F(ListenerManagerImplWithRealFiltersTest, EmptyFilter) {
   )EOF";
 
   EXPECT_CALL(server_.random_, uuid());
-  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true, false, 0));
   manager_->addOrUpdateListener(parseListenerFromJson(json));
   EXPECT_EQ(1U, manager_->listeners().size());
 }
@@ -126,7 +126,7 @@ TEST_F(ListenerManagerImplWithRealFiltersTest, DefaultListenerPerConnectionBuffe
   }
   )EOF";
 
-  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true, false, 0));
   manager_->addOrUpdateListener(parseListenerFromJson(json));
   EXPECT_EQ(1024 * 1024U, manager_->listeners().back().get().perConnectionBufferLimitBytes());
 }
@@ -140,7 +140,7 @@ TEST_F(ListenerManagerImplWithRealFiltersTest, SetListenerPerConnectionBufferLim
   }
   )EOF";
 
-  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true, false, 0));
   manager_->addOrUpdateListener(parseListenerFromJson(json));
   EXPECT_EQ(8192U, manager_->listeners().back().get().perConnectionBufferLimitBytes());
 }
@@ -162,7 +162,7 @@ TEST_F(ListenerManagerImplWithRealFiltersTest, SslContext) {
   )EOF",
                                                        Network::Address::IpVersion::v4);
 
-  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true, false, 0));
   manager_->addOrUpdateListener(parseListenerFromJson(json));
   EXPECT_NE(nullptr, manager_->listeners().back().get().defaultSslContext());
 }
@@ -244,7 +244,7 @@ TEST_F(ListenerManagerImplWithRealFiltersTest, StatsScopeTest) {
   }
   )EOF";
 
-  EXPECT_CALL(listener_factory_, createListenSocket(_, false));
+  EXPECT_CALL(listener_factory_, createListenSocket(_, false, false, 0));
   manager_->addOrUpdateListener(parseListenerFromJson(json));
   manager_->listeners().front().get().listenerScope().counter("foo").inc();
 
@@ -267,7 +267,7 @@ TEST_F(ListenerManagerImplTest, ModifyOnlyDrainType) {
 
   ListenerHandle* listener_foo =
       expectListenerCreate(false, envoy::api::v2::Listener_DrainType_MODIFY_ONLY);
-  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true, false, 0));
   EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromV2Yaml(listener_foo_yaml)));
   checkStats(1, 0, 0, 0, 1, 0);
 
@@ -288,7 +288,7 @@ TEST_F(ListenerManagerImplTest, AddListenerAddressNotMatching) {
   )EOF";
 
   ListenerHandle* listener_foo = expectListenerCreate(false);
-  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true, false, 0));
   EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_foo_json)));
   checkStats(1, 0, 0, 0, 1, 0);
 
@@ -327,7 +327,7 @@ TEST_F(ListenerManagerImplTest, AddOrUpdateListener) {
   )EOF";
 
   ListenerHandle* listener_foo = expectListenerCreate(false);
-  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true, false, 0));
   EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_foo_json)));
   checkStats(1, 0, 0, 0, 1, 0);
 
@@ -388,7 +388,7 @@ TEST_F(ListenerManagerImplTest, AddOrUpdateListener) {
   )EOF";
 
   ListenerHandle* listener_bar = expectListenerCreate(false);
-  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true, false, 0));
   EXPECT_CALL(*worker_, addListener(_, _));
   EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_bar_json)));
   EXPECT_EQ(2UL, manager_->listeners().size());
@@ -405,7 +405,7 @@ TEST_F(ListenerManagerImplTest, AddOrUpdateListener) {
   )EOF";
 
   ListenerHandle* listener_baz = expectListenerCreate(true);
-  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true, false, 0));
   EXPECT_CALL(listener_baz->target_, initialize(_));
   EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_baz_json)));
   EXPECT_EQ(2UL, manager_->listeners().size());
@@ -448,6 +448,90 @@ TEST_F(ListenerManagerImplTest, AddOrUpdateListener) {
   EXPECT_CALL(*listener_baz_update1, onDestroy());
 }
 
+TEST_F(ListenerManagerImplTest, UpdateFilterChainsInPlace) {
+  InSequence s;
+
+  EXPECT_CALL(*worker_, start(_));
+  manager_->startWorkers(guard_dog_);
+
+  // Add foo listener.
+  const std::string listener_foo_json = R"EOF(
+  {
+    "name": "foo",
+    "address": "tcp://127.0.0.1:1234",
+    "filters": []
+  }
+  )EOF";
+
+  ListenerHandle* listener_foo = expectListenerCreate(false);
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true, false, 0));
+  EXPECT_CALL(*worker_, addListener(_, _));
+  EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_foo_json)));
+  worker_->callAddCompletion(true);
+  checkStats(1, 0, 0, 0, 1, 0);
+
+  ON_CALL(server_.runtime_loader_.snapshot_,
+          featureEnabled("listener_manager.in_place_filter_chain_update", 0))
+      .WillByDefault(Return(true));
+
+  // Only the filter chains change, so the connections of foo are not drained, and foo is removed
+  // once the worker has no connections left on it.
+  const std::string listener_foo_update1_json = R"EOF(
+  {
+    "name": "foo",
+    "address": "tcp://127.0.0.1:1234",
+    "filters": [
+      { "type" : "read", "name" : "fake", "config" : {} }
+    ]
+  }
+  )EOF";
+
+  ListenerHandle* listener_foo_update1 = expectListenerCreate(false);
+  EXPECT_CALL(*worker_, addListener(_, _));
+  EXPECT_CALL(*worker_, stopListener(_)).Times(0);
+  EXPECT_CALL(*listener_foo->drain_manager_, startDrainSequence(_)).Times(0);
+  EXPECT_CALL(*worker_, removeListenerWhenIdle(_, _));
+  EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_foo_update1_json)));
+  worker_->callAddCompletion(true);
+  checkStats(1, 1, 0, 0, 1, 1);
+  EXPECT_EQ(1UL,
+            server_.stats_store_.counter("listener_manager.listener_modified_in_place").value());
+
+  EXPECT_CALL(*listener_foo, onDestroy());
+  worker_->callRemovalCompletion();
+  checkStats(1, 1, 0, 0, 1, 0);
+
+  // Other changes still drain the existing listener.
+  const std::string listener_foo_update2_json = R"EOF(
+  {
+    "name": "foo",
+    "address": "tcp://127.0.0.1:1234",
+    "filters": [
+      { "type" : "read", "name" : "fake", "config" : {} }
+    ],
+    "per_connection_buffer_limit_bytes": 8192
+  }
+  )EOF";
+
+  ListenerHandle* listener_foo_update2 = expectListenerCreate(false);
+  EXPECT_CALL(*worker_, addListener(_, _));
+  EXPECT_CALL(*worker_, stopListener(_));
+  EXPECT_CALL(*listener_foo_update1->drain_manager_, startDrainSequence(_));
+  EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_foo_update2_json)));
+  worker_->callAddCompletion(true);
+  checkStats(1, 2, 0, 0, 1, 1);
+  EXPECT_EQ(1UL,
+            server_.stats_store_.counter("listener_manager.listener_modified_in_place").value());
+
+  EXPECT_CALL(*worker_, removeListener(_, _));
+  listener_foo_update1->drain_manager_->drain_sequence_completion_();
+  EXPECT_CALL(*listener_foo_update1, onDestroy());
+  worker_->callRemovalCompletion();
+  checkStats(1, 2, 0, 0, 1, 0);
+
+  EXPECT_CALL(*listener_foo_update2, onDestroy());
+}
+
 TEST_F(ListenerManagerImplTest, AddDrainingListener) {
   InSequence s;
 
@@ -468,7 +552,7 @@ TEST_F(ListenerManagerImplTest, AddDrainingListener) {
   ON_CALL(*listener_factory_.socket_, localAddress()).WillByDefault(Return(local_address));
 
   ListenerHandle* listener_foo = expectListenerCreate(false);
-  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true, false, 0));
   EXPECT_CALL(*worker_, addListener(_, _));
   EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_foo_json)));
   worker_->callAddCompletion(true);
@@ -512,7 +596,7 @@ TEST_F(ListenerManagerImplTest, CantBindSocket) {
   )EOF";
 
   ListenerHandle* listener_foo = expectListenerCreate(true);
-  EXPECT_CALL(listener_factory_, createListenSocket(_, true))
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true, false, 0))
       .WillOnce(Throw(EnvoyException("can't bind")));
   EXPECT_CALL(*listener_foo, onDestroy());
   EXPECT_THROW(manager_->addOrUpdateListener(parseListenerFromJson(listener_foo_json)),
@@ -534,7 +618,7 @@ TEST_F(ListenerManagerImplTest, ListenerDraining) {
   )EOF";
 
   ListenerHandle* listener_foo = expectListenerCreate(false);
-  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true, false, 0));
   EXPECT_CALL(*worker_, addListener(_, _));
   EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_foo_json)));
   worker_->callAddCompletion(true);
@@ -586,7 +670,7 @@ TEST_F(ListenerManagerImplTest, RemoveListener) {
   )EOF";
 
   ListenerHandle* listener_foo = expectListenerCreate(true);
-  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true, false, 0));
   EXPECT_CALL(listener_foo->target_, initialize(_));
   EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_foo_json)));
   EXPECT_EQ(0UL, manager_->listeners().size());
@@ -600,7 +684,7 @@ TEST_F(ListenerManagerImplTest, RemoveListener) {
 
   // Add foo again and initialize it.
   listener_foo = expectListenerCreate(true);
-  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true, false, 0));
   EXPECT_CALL(listener_foo->target_, initialize(_));
   EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_foo_json)));
   checkStats(2, 0, 1, 1, 0, 0);
@@ -658,7 +742,7 @@ TEST_F(ListenerManagerImplTest, AddListenerFailure) {
   )EOF";
 
   ListenerHandle* listener_foo = expectListenerCreate(false);
-  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true, false, 0));
   EXPECT_CALL(*worker_, addListener(_, _));
   EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_foo_json)));
 
@@ -707,7 +791,7 @@ TEST_F(ListenerManagerImplTest, DuplicateAddressDontBind) {
   )EOF";
 
   ListenerHandle* listener_foo = expectListenerCreate(true);
-  EXPECT_CALL(listener_factory_, createListenSocket(_, false));
+  EXPECT_CALL(listener_factory_, createListenSocket(_, false, false, 0));
   EXPECT_CALL(listener_foo->target_, initialize(_));
   EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_foo_json)));
 
@@ -776,7 +860,7 @@ TEST_F(ListenerManagerImplWithRealFiltersTest, SniWithSingleFilterChain) {
                                                        Network::Address::IpVersion::v4);
 
   EXPECT_CALL(server_.random_, uuid());
-  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true, false, 0));
   manager_->addOrUpdateListener(parseListenerFromV2Yaml(yaml));
   EXPECT_EQ(1U, manager_->listeners().size());
 }
@@ -832,7 +916,7 @@ TEST_F(ListenerManagerImplWithRealFiltersTest, SniWithTwoEqualFilterChains) {
                                                        Network::Address::IpVersion::v4);
 
   EXPECT_CALL(server_.random_, uuid());
-  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true, false, 0));
   manager_->addOrUpdateListener(parseListenerFromV2Yaml(yaml));
   EXPECT_EQ(1U, manager_->listeners().size());
 }
@@ -889,7 +973,7 @@ TEST_F(ListenerManagerImplWithRealFiltersTest,
                                                        Network::Address::IpVersion::v4);
 
   EXPECT_CALL(server_.random_, uuid());
-  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true, false, 0));
   manager_->addOrUpdateListener(parseListenerFromV2Yaml(yaml));
   EXPECT_EQ(1U, manager_->listeners().size());
 }
@@ -998,5 +1082,108 @@ TEST_F(ListenerManagerImplWithRealFiltersTest, SniWithTwoDifferentFilterChains)
                             "chains is currently not supported");
 }
 
+// With --reuse-port each worker gets its own socket, and later workers bind to the port picked for
+// the first one.
+TEST_F(ListenerManagerImplTest, ReusePort) {
+  ON_CALL(server_.options_, reusePort()).WillByDefault(Return(true));
+  ON_CALL(server_.options_, concurrency()).WillByDefault(Return(2));
+  EXPECT_CALL(worker_factory_, createWorker_())
+      .WillOnce(Return(new MockWorker()))
+      .WillOnce(Return(new MockWorker()));
+  manager_.reset(new ListenerManagerImpl(server_, listener_factory_, worker_factory_));
+
+  const std::string listener_foo_json = R"EOF(
+  {
+    "name": "foo",
+    "address": "tcp://127.0.0.1:0",
+    "filters": []
+  }
+  )EOF";
+
+  auto socket0 = std::make_shared<NiceMock<Network::MockListenSocket>>();
+  auto socket1 = std::make_shared<NiceMock<Network::MockListenSocket>>();
+  ListenerHandle* listener_foo = expectListenerCreate(false);
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true, true, 0)).WillOnce(Return(socket0));
+  EXPECT_CALL(listener_factory_, createListenSocket(socket0->local_address_, true, true, 1))
+      .WillOnce(Return(socket1));
+  EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_foo_json)));
+
+  Listener& foo = manager_->listeners()[0].get();
+  EXPECT_EQ(socket0.get(), &foo.socket());
+  EXPECT_EQ(socket0.get(), foo.workerSocket(0));
+  EXPECT_EQ(socket1.get(), foo.workerSocket(1));
+  EXPECT_EQ(nullptr, foo.workerSocket(2));
+
+  // A listener which doesn't bind shares a single socket between workers.
+  const std::string listener_bar_json = R"EOF(
+  {
+    "name": "bar",
+    "address": "tcp://127.0.0.1:1234",
+    "filters": [],
+    "bind_to_port": false
+  }
+  )EOF";
+
+  ListenerHandle* listener_bar = expectListenerCreate(false);
+  EXPECT_CALL(listener_factory_, createListenSocket(_, false, false, 0));
+  EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_bar_json)));
+  Listener& bar = manager_->listeners()[1].get();
+  EXPECT_EQ(&bar.socket(), bar.workerSocket(0));
+  EXPECT_EQ(&bar.socket(), bar.workerSocket(1));
+
+  // The sockets of an existing listener can't be reused if it starts binding.
+  const std::string listener_bar_update_json = R"EOF(
+  {
+    "name": "bar",
+    "address": "tcp://127.0.0.1:1234",
+    "filters": []
+  }
+  )EOF";
+
+  ListenerHandle* listener_bar_update = expectListenerCreate(false);
+  EXPECT_CALL(*listener_bar_update, onDestroy());
+  EXPECT_THROW_WITH_MESSAGE(
+      manager_->addOrUpdateListener(parseListenerFromJson(listener_bar_update_json)),
+      EnvoyException, "error updating listener: 'bar' can't change bind_to_port with --reuse-port");
+
+  EXPECT_CALL(*listener_foo, onDestroy());
+  EXPECT_CALL(*listener_bar, onDestroy());
+}
+
+// New connections are rejected by a listener whose connections buffer more than the runtime limit.
+TEST_F(ListenerManagerImplTest, BufferedBytesLimit) {
+  const std::string listener_foo_json = R"EOF(
+  {
+    "name": "foo",
+    "address": "tcp://127.0.0.1:1234",
+    "filters": []
+  }
+  )EOF";
+
+  ListenerHandle* listener_foo = expectListenerCreate(false);
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true, false, 0));
+  EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_foo_json)));
+  Listener& foo = manager_->listeners()[0].get();
+
+  NiceMock<Network::MockConnection> connection;
+  ON_CALL(connection, initializeReadFilters()).WillByDefault(Return(true));
+  foo.bufferAccount()->charge(100);
+  EXPECT_TRUE(foo.filterChainFactory().createFilterChain(connection));
+
+  ON_CALL(server_.runtime_loader_.snapshot_,
+          getInteger("overload.max_listener_buffered_bytes", 0))
+      .WillByDefault(Return(100));
+  EXPECT_FALSE(foo.filterChainFactory().createFilterChain(connection));
+  EXPECT_EQ(1UL, server_.stats_store_
+                     .counter("listener.127.0.0.1_1234.downstream_cx_buffer_overload_reject")
+                     .value());
+
+  foo.bufferAccount()->credit(1);
+  EXPECT_TRUE(foo.filterChainFactory().createFilterChain(connection));
+  foo.bufferAccount()->credit(99);
+
+  EXPECT_CALL(*listener_foo, onDestroy());
+}
+
 } // namespace Server
 } // namespace Envoy
@@ -61,7 +61,16 @@ TEST(OptionsImplTest, All) {
       "envoy --mode validate --concurrency 2 -c hello --admin-address-path path --restart-epoch 1 "
       "--local-address-ip-version v6 -l info --service-cluster cluster --service-node node "
       "--service-zone zone --file-flush-interval-msec 9000 --drain-time-s 60 "
-      "--parent-shutdown-time-s 90 --log-path /foo/bar --v2-config-only");
+      "--parent-shutdown-time-s 90 --log-path /foo/bar --async-log --v2-config-only "
+      "--use-libevent-buffers 0 --reuse-port --balance-connections --max-accepts-per-wakeup 16 "
+      "--max-accepts-per-second 1000 --use-epoll-changelist "
+      "--max-deferred-deletes-per-iteration 100 --coalesce-writes "
+      "--tcp-notsent-lowat 16384 --private-key-threads 4 --ssl-session-cache-size 1000 "
+      "--tls-initial-record-size 1400 --kernel-tls --lazy-tls-certificates --tls-early-data "
+      "--thread-local-counters --statsd-udp-max-datagram-size 1432 --stats-full-flush-every 10 "
+      "--dns-cache-duration-ms 5000 --dedicated-health-check-thread --dedicated-xds-thread "
+      "--worker-cpus 0-2,8 --ratelimit-lease-size 50 --ratelimit-lease-duration-ms 500 "
+      "--xds-cache-path /var/cache/envoy --validation-threads 4");
   EXPECT_EQ(Server::Mode::Validate, options->mode());
   EXPECT_EQ(2U, options->concurrency());
   EXPECT_EQ("hello", options->configPath());
@@ -71,12 +80,39 @@ TEST(OptionsImplTest, All) {
   EXPECT_EQ(1U, options->restartEpoch());
   EXPECT_EQ(spdlog::level::info, options->logLevel());
   EXPECT_EQ("/foo/bar", options->logPath());
+  EXPECT_TRUE(options->asyncLog());
   EXPECT_EQ("cluster", options->serviceClusterName());
   EXPECT_EQ("node", options->serviceNodeName());
   EXPECT_EQ("zone", options->serviceZone());
   EXPECT_EQ(std::chrono::milliseconds(9000), options->fileFlushIntervalMsec());
   EXPECT_EQ(std::chrono::seconds(60), options->drainTime());
   EXPECT_EQ(std::chrono::seconds(90), options->parentShutdownTime());
+  EXPECT_FALSE(options->libeventBuffersEnabled());
+  EXPECT_TRUE(options->reusePort());
+  EXPECT_TRUE(options->balanceConnections());
+  EXPECT_EQ(16U, options->maxAcceptsPerWakeup());
+  EXPECT_EQ(1000U, options->maxAcceptsPerSecond());
+  EXPECT_TRUE(options->epollChangelistEnabled());
+  EXPECT_EQ(100U, options->maxDeferredDeletesPerIteration());
+  EXPECT_TRUE(options->coalesceWrites());
+  EXPECT_EQ(16384U, options->tcpNotSentLowat());
+  EXPECT_EQ(4U, options->privateKeyThreads());
+  EXPECT_EQ(1000U, options->sslSessionCacheSize());
+  EXPECT_EQ(1400U, options->tlsInitialRecordSize());
+  EXPECT_TRUE(options->kernelTlsEnabled());
+  EXPECT_TRUE(options->lazyTlsCertificates());
+  EXPECT_TRUE(options->tlsEarlyData());
+  EXPECT_TRUE(options->threadLocalCounters());
+  EXPECT_EQ(1432U, options->statsdUdpMaxDatagramSize());
+  EXPECT_EQ(10U, options->statsFullFlushEvery());
+  EXPECT_EQ(std::chrono::milliseconds(5000), options->dnsCacheDuration());
+  EXPECT_TRUE(options->dedicatedHealthCheckThread());
+  EXPECT_TRUE(options->dedicatedXdsThread());
+  EXPECT_EQ(std::vector<uint32_t>({0, 1, 2, 8}), options->workerCpus());
+  EXPECT_EQ(50U, options->ratelimitLeaseSize());
+  EXPECT_EQ(std::chrono::milliseconds(500), options->ratelimitLeaseDuration());
+  EXPECT_EQ("/var/cache/envoy", options->xdsCachePath());
+  EXPECT_EQ(4U, options->validationThreads());
 }
 
 TEST(OptionsImplTest, DefaultParams) {
@@ -86,6 +122,33 @@ TEST(OptionsImplTest, DefaultParams) {
   EXPECT_EQ("", options->adminAddressPath());
   EXPECT_EQ(Network::Address::IpVersion::v4, options->localAddressIpVersion());
   EXPECT_EQ(Server::Mode::Serve, options->mode());
+  EXPECT_FALSE(options->asyncLog());
+  EXPECT_TRUE(options->libeventBuffersEnabled());
+  EXPECT_FALSE(options->reusePort());
+  EXPECT_FALSE(options->balanceConnections());
+  EXPECT_EQ(0U, options->maxAcceptsPerWakeup());
+  EXPECT_EQ(0U, options->maxAcceptsPerSecond());
+  EXPECT_FALSE(options->epollChangelistEnabled());
+  EXPECT_EQ(0U, options->maxDeferredDeletesPerIteration());
+  EXPECT_FALSE(options->coalesceWrites());
+  EXPECT_EQ(0U, options->tcpNotSentLowat());
+  EXPECT_EQ(0U, options->privateKeyThreads());
+  EXPECT_EQ(0U, options->sslSessionCacheSize());
+  EXPECT_EQ(0U, options->tlsInitialRecordSize());
+  EXPECT_FALSE(options->kernelTlsEnabled());
+  EXPECT_FALSE(options->lazyTlsCertificates());
+  EXPECT_FALSE(options->tlsEarlyData());
+  EXPECT_FALSE(options->threadLocalCounters());
+  EXPECT_EQ(0U, options->statsdUdpMaxDatagramSize());
+  EXPECT_EQ(0U, options->statsFullFlushEvery());
+  EXPECT_EQ(std::chrono::milliseconds(0), options->dnsCacheDuration());
+  EXPECT_FALSE(options->dedicatedHealthCheckThread());
+  EXPECT_FALSE(options->dedicatedXdsThread());
+  EXPECT_TRUE(options->workerCpus().empty());
+  EXPECT_EQ(0U, options->ratelimitLeaseSize());
+  EXPECT_EQ(std::chrono::milliseconds(1000), options->ratelimitLeaseDuration());
+  EXPECT_EQ("", options->xdsCachePath());
+  EXPECT_EQ(1U, options->validationThreads());
 }
 
 TEST(OptionsImplTest, BadCliOption) {
@@ -97,6 +160,15 @@ TEST(OptionsImplTest, BadCliOption) {
   }
 }
 
+TEST(OptionsImplTest, BadWorkerCpusOption) {
+  try {
+    createOptionsImpl("envoy --worker-cpus 0-3,5-4");
+    FAIL();
+  } catch (const MalformedArgvException& e) {
+    EXPECT_THAT(e.what(), HasSubstr("error: invalid worker CPUs '5-4'"));
+  }
+}
+
 TEST(OptionsImplTest, BadObjNameLenOption) {
   try {
     createOptionsImpl("envoy --max-obj-name-len 1");
@@ -0,0 +1,125 @@
+#include <chrono>
+
+#include "server/overload_manager_impl.h"
+
+#include "test/mocks/server/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+using testing::_;
+
+namespace Envoy {
+namespace Server {
+
+class OverloadManagerImplTest : public testing::Test {
+public:
+  OverloadManagerImplTest() {
+    ON_CALL(server_.runtime_loader_.snapshot_, getInteger("overload.max_active_connections", _))
+        .WillByDefault(Return(100));
+  }
+
+  void setConnections(uint64_t connections) {
+    ON_CALL(server_.listener_manager_, numConnections()).WillByDefault(Return(connections));
+  }
+
+  uint64_t gauge(const std::string& name) {
+    return server_.stats_store_.gauge("overload." + name).value();
+  }
+
+  NiceMock<MockInstance> server_;
+};
+
+TEST_F(OverloadManagerImplTest, NotStarted) {
+  OverloadManagerImpl overload_manager(server_);
+  EXPECT_FALSE(overload_manager.isActive(OverloadActionType::DisableHttpKeepAlive));
+  EXPECT_FALSE(overload_manager.isActive(OverloadActionType::StopAcceptingConnections));
+  EXPECT_FALSE(overload_manager.isActive(OverloadActionType::StopAcceptingRequests));
+}
+
+// Actions activate in order as the pressure rises past their thresholds, and deactivate as it
+// falls back.
+TEST_F(OverloadManagerImplTest, ActionThresholds) {
+  OverloadManagerImpl overload_manager(server_);
+  Event::MockTimer* refresh_timer = new Event::MockTimer(&server_.dispatcher_);
+  setConnections(50);
+  EXPECT_CALL(*refresh_timer, enableTimer(std::chrono::milliseconds(1000)));
+  overload_manager.start();
+  EXPECT_EQ(50U, gauge("pressure_percent"));
+  EXPECT_FALSE(overload_manager.isActive(OverloadActionType::DisableHttpKeepAlive));
+
+  setConnections(90);
+  EXPECT_CALL(*refresh_timer, enableTimer(_));
+  refresh_timer->callback_();
+  EXPECT_TRUE(overload_manager.isActive(OverloadActionType::DisableHttpKeepAlive));
+  EXPECT_FALSE(overload_manager.isActive(OverloadActionType::StopAcceptingConnections));
+  EXPECT_EQ(1U, gauge("disable_http_keepalive_active"));
+
+  setConnections(97);
+  EXPECT_CALL(*refresh_timer, enableTimer(_));
+  refresh_timer->callback_();
+  EXPECT_TRUE(overload_manager.isActive(OverloadActionType::StopAcceptingConnections));
+  EXPECT_FALSE(overload_manager.isActive(OverloadActionType::StopAcceptingRequests));
+
+  setConnections(150);
+  EXPECT_CALL(*refresh_timer, enableTimer(_));
+  refresh_timer->callback_();
+  EXPECT_EQ(150U, gauge("pressure_percent"));
+  EXPECT_TRUE(overload_manager.isActive(OverloadActionType::StopAcceptingRequests));
+  EXPECT_EQ(1U, gauge("stop_accepting_requests_active"));
+
+  setConnections(10);
+  EXPECT_CALL(*refresh_timer, enableTimer(_));
+  refresh_timer->callback_();
+  EXPECT_FALSE(overload_manager.isActive(OverloadActionType::DisableHttpKeepAlive));
+  EXPECT_FALSE(overload_manager.isActive(OverloadActionType::StopAcceptingConnections));
+  EXPECT_FALSE(overload_manager.isActive(OverloadActionType::StopAcceptingRequests));
+  EXPECT_EQ(0U, gauge("stop_accepting_requests_active"));
+}
+
+// Action changes are published to the workers without posting anything to them.
+TEST_F(OverloadManagerImplTest, NoPostOnChange) {
+  OverloadManagerImpl overload_manager(server_);
+  Event::MockTimer* refresh_timer = new Event::MockTimer(&server_.dispatcher_);
+  EXPECT_CALL(server_.thread_local_, runOnAllThreads(_)).Times(0);
+  setConnections(10);
+  overload_manager.start();
+
+  setConnections(96);
+  refresh_timer->callback_();
+  EXPECT_TRUE(overload_manager.isActive(OverloadActionType::StopAcceptingConnections));
+}
+
+// Thresholds come from runtime, and a threshold of 0 disables an action.
+TEST_F(OverloadManagerImplTest, RuntimeThresholds) {
+  ON_CALL(server_.runtime_loader_.snapshot_,
+          getInteger("overload.disable_http_keepalive_percent", _))
+      .WillByDefault(Return(0));
+  ON_CALL(server_.runtime_loader_.snapshot_,
+          getInteger("overload.stop_accepting_requests_percent", _))
+      .WillByDefault(Return(50));
+  OverloadManagerImpl overload_manager(server_);
+  new NiceMock<Event::MockTimer>(&server_.dispatcher_);
+  setConnections(60);
+  overload_manager.start();
+  EXPECT_FALSE(overload_manager.isActive(OverloadActionType::DisableHttpKeepAlive));
+  EXPECT_FALSE(overload_manager.isActive(OverloadActionType::StopAcceptingConnections));
+  EXPECT_TRUE(overload_manager.isActive(OverloadActionType::StopAcceptingRequests));
+}
+
+// No resource is monitored without a limit.
+TEST_F(OverloadManagerImplTest, NoLimits) {
+  ON_CALL(server_.runtime_loader_.snapshot_, getInteger("overload.max_active_connections", _))
+      .WillByDefault(Return(0));
+  OverloadManagerImpl overload_manager(server_);
+  new NiceMock<Event::MockTimer>(&server_.dispatcher_);
+  setConnections(1000);
+  overload_manager.start();
+  EXPECT_EQ(0U, gauge("pressure_percent"));
+  EXPECT_FALSE(overload_manager.isActive(OverloadActionType::DisableHttpKeepAlive));
+}
+
+} // namespace Server
+} // namespace Envoy
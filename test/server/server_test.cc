@@ -1,5 +1,6 @@
 #include "common/common/version.h"
 #include "common/network/address_impl.h"
+#include "common/stats/thread_local_store.h"
 #include "common/thread_local/thread_local_impl.h"
 
 #include "server/server.h"
@@ -13,7 +14,10 @@
 
 using testing::HasSubstr;
 using testing::InSequence;
+using testing::Invoke;
+using testing::NiceMock;
 using testing::Property;
+using testing::Return;
 using testing::SaveArg;
 using testing::StrictMock;
 using testing::_;
@@ -35,7 +39,63 @@ TEST(ServerInstanceUtil, flushHelper) {
 
   std::list<Stats::SinkPtr> sinks;
   sinks.emplace_back(std::move(sink));
-  InstanceUtil::flushCountersAndGaugesToSinks(sinks, store);
+  InstanceUtil::flushMetricsToSinks(sinks, store, true);
+}
+
+TEST(ServerInstanceUtil, flushHistograms) {
+  InSequence s;
+
+  Stats::HeapRawStatDataAllocator alloc;
+  Stats::ThreadLocalStoreImpl store(alloc);
+  store.histogram("hello").recordValue(5);
+  store.histogram("world");
+  std::unique_ptr<Stats::MockSink> sink(new StrictMock<Stats::MockSink>());
+  EXPECT_CALL(*sink, beginFlush());
+  // Only histograms with values are flushed, after they are merged.
+  EXPECT_CALL(*sink, flushHistogram(Property(&Stats::Metric::name, "hello")))
+      .WillOnce(Invoke([](const Stats::ParentHistogram& histogram) -> void {
+        EXPECT_EQ(1U, histogram.intervalStatistics().sampleCount());
+      }));
+  EXPECT_CALL(*sink, endFlush());
+
+  std::list<Stats::SinkPtr> sinks;
+  sinks.emplace_back(std::move(sink));
+  InstanceUtil::flushMetricsToSinks(sinks, store, true);
+  store.shutdownThreading();
+}
+
+TEST(ServerInstanceUtil, flushChangedStats) {
+  Stats::IsolatedStoreImpl store;
+  store.counter("hello").inc();
+  store.gauge("world").set(5);
+  std::unique_ptr<Stats::MockSink> sink(new NiceMock<Stats::MockSink>());
+  Stats::MockSink& changed_stats_sink = *sink;
+  ON_CALL(changed_stats_sink, changedStatsOnly()).WillByDefault(Return(true));
+  std::list<Stats::SinkPtr> sinks;
+  sinks.emplace_back(std::move(sink));
+
+  EXPECT_CALL(changed_stats_sink, flushCounter(Property(&Stats::Metric::name, "hello"), 1));
+  EXPECT_CALL(changed_stats_sink, flushGauge(Property(&Stats::Metric::name, "world"), 5));
+  InstanceUtil::flushMetricsToSinks(sinks, store, false);
+  testing::Mock::VerifyAndClearExpectations(&changed_stats_sink);
+
+  // Nothing changed since the previous flush.
+  EXPECT_CALL(changed_stats_sink, flushCounter(_, _)).Times(0);
+  EXPECT_CALL(changed_stats_sink, flushGauge(_, _)).Times(0);
+  InstanceUtil::flushMetricsToSinks(sinks, store, false);
+  testing::Mock::VerifyAndClearExpectations(&changed_stats_sink);
+
+  // Setting a gauge to its current value still changes it.
+  store.gauge("world").set(5);
+  EXPECT_CALL(changed_stats_sink, flushCounter(_, _)).Times(0);
+  EXPECT_CALL(changed_stats_sink, flushGauge(Property(&Stats::Metric::name, "world"), 5));
+  InstanceUtil::flushMetricsToSinks(sinks, store, false);
+  testing::Mock::VerifyAndClearExpectations(&changed_stats_sink);
+
+  // A full flush has the unchanged stats too.
+  EXPECT_CALL(changed_stats_sink, flushCounter(Property(&Stats::Metric::name, "hello"), 0));
+  EXPECT_CALL(changed_stats_sink, flushGauge(Property(&Stats::Metric::name, "world"), 5));
+  InstanceUtil::flushMetricsToSinks(sinks, store, true);
 }
 
 class RunHelperTest : public testing::Test {
@@ -3,6 +3,7 @@
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <climits>
 #include <fstream>
 #include <iostream>
 #include <regex>
@@ -57,6 +58,29 @@ void TestEnvironment::initializeOptions(int argc, char** argv) {
   argv_ = argv;
 }
 
+void TestEnvironment::initializeStandalone(const char* program_name) {
+  static char* argv[2];
+  argv[0] = const_cast<char*>(program_name);
+  initializeOptions(1, argv);
+
+  if (::getenv("TEST_TMPDIR") == nullptr) {
+    char tmpdir[] = "/tmp/envoy_test_tmp.XXXXXX";
+    RELEASE_ASSERT(::mkdtemp(tmpdir) != nullptr);
+    ::setenv("TEST_TMPDIR", tmpdir, 1);
+  }
+  if (::getenv("TEST_RUNDIR") == nullptr) {
+    const char* srcdir = ::getenv("TEST_SRCDIR");
+    const char* workspace = ::getenv("TEST_WORKSPACE");
+    if (srcdir != nullptr && workspace != nullptr) {
+      ::setenv("TEST_RUNDIR", (std::string(srcdir) + "/" + workspace).c_str(), 1);
+    } else {
+      char cwd[PATH_MAX];
+      RELEASE_ASSERT(::getcwd(cwd, sizeof(cwd)) != nullptr);
+      ::setenv("TEST_RUNDIR", cwd, 1);
+    }
+  }
+}
+
 bool TestEnvironment::shouldRunTestForIpVersion(Network::Address::IpVersion type) {
   const char* value = ::getenv("ENVOY_IP_TEST_VERSIONS");
   std::string option(value ? value : "");
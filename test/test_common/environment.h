@@ -24,6 +24,15 @@ public:
    */
   static void initializeOptions(int argc, char** argv);
 
+  /**
+   * Initialize the options and the TEST_TMPDIR and TEST_RUNDIR environment variables, if not
+   * already set, for a binary which is not run by the test runner, such as a benchmark run by hand.
+   * TEST_TMPDIR is then a new directory under /tmp, and TEST_RUNDIR the runfiles of the binary if
+   * known, or else the working directory.
+   * @param program_name supplies the name of the binary, used as the first command-line arg.
+   */
+  static void initializeStandalone(const char* program_name);
+
   /**
    * Check whether testing with IP version type {v4 or v6} is enabled via
    * setting the environment variable ENVOY_IP_TEST_VERSIONS.
@@ -0,0 +1,53 @@
+// NOLINT(namespace-envoy)
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "common/access_log/binary_access_log_impl.h"
+#include "common/protobuf/protobuf.h"
+#include "common/protobuf/utility.h"
+
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+
+// Print the entries of a binary access log as JSON, one per line.
+int main(int argc, char* argv[]) {
+  if (argc != 2) {
+    std::cerr << "Usage: access_log_decoder PATH\n"
+                 "\nPrint the entries of a binary access log (envoy.binary_file_access_log) as"
+                 " JSON, one entry per line.\n"
+                 "\n\tPATH - the access log file, or - for the standard input."
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const std::string path(argv[1]);
+  std::ifstream file;
+  if (path != "-") {
+    file.open(path, std::ios::binary);
+    if (!file) {
+      std::cerr << "Unable to open " << path << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  Envoy::Protobuf::io::IstreamInputStream stream(path == "-" ? &std::cin : &file);
+
+  envoy::access_log::HTTPAccessLogEntry entry;
+  uint64_t entries = 0;
+  while (true) {
+    // A coded stream limits the bytes it reads, so each entry is read with a new one, which gives
+    // back what it has buffered beyond the entry when destroyed.
+    Envoy::Protobuf::io::CodedInputStream input(&stream);
+    const void* data;
+    int size;
+    if (!input.GetDirectBufferPointer(&data, &size)) {
+      break;
+    }
+    if (!Envoy::AccessLog::BinaryAccessLogFormat::read(input, entry)) {
+      std::cerr << "Truncated or corrupt entry after " << entries << " entries" << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::cout << Envoy::MessageUtil::getJsonStringFromMessage(entry) << "\n";
+    entries++;
+  }
+  return EXIT_SUCCESS;
+}